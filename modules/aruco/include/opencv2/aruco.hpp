@@ -120,6 +120,12 @@ namespace aruco {
  *   than 128 or not) (default 5.0)
  * - errorCorrectionRate error correction rate respect to the maximun error correction capability
  *   for each dictionary. (default 0.6).
+ * - detectionImageScale: scale of the image where the candidates are searched. The candidate
+ *   corners are then refined in the full resolution image. Values lower than 1 speed up the
+ *   detection in high resolution images, but the markers smaller than the minimum perimeter in
+ *   the downscaled image are lost (default 1.0, i.e. no downscaling).
+ * - trackingRoiMarginRate: margin of the search region around each previous marker in
+ *   trackMarkers(), relative to the marker size (default 0.5).
  */
 struct CV_EXPORTS_W DetectorParameters {
 
@@ -147,6 +153,8 @@ struct CV_EXPORTS_W DetectorParameters {
     CV_PROP_RW double maxErroneousBitsInBorderRate;
     CV_PROP_RW double minOtsuStdDev;
     CV_PROP_RW double errorCorrectionRate;
+    CV_PROP_RW double detectionImageScale;
+    CV_PROP_RW double trackingRoiMarginRate;
 };
 
 
@@ -170,6 +178,9 @@ struct CV_EXPORTS_W DetectorParameters {
  * are searched. For each detected marker, it returns the 2D position of its corner in the image
  * and its corresponding identifier.
  * Note that this function does not perform pose estimation.
+ * If image is a UMat and OpenCL is available, the grey conversion and the adaptive thresholding
+ * run on the device, and only the grey and thresholded images are downloaded for the contour
+ * search and the identification.
  * @sa estimatePoseSingleMarkers,  estimatePoseBoard
  *
  */
@@ -179,6 +190,51 @@ CV_EXPORTS_W void detectMarkers(InputArray image, Ptr<Dictionary> &dictionary, O
 
 
 
+/**
+ * @brief Marker detection around the markers detected in a previous frame
+ *
+ * @param image input image
+ * @param dictionary indicates the type of markers that will be searched
+ * @param previousCorners corners of the markers detected in the previous frame, as returned by
+ * detectMarkers() or trackMarkers().
+ * @param corners vector of detected marker corners, same format than in detectMarkers().
+ * @param ids vector of identifiers of the detected markers.
+ * @param parameters marker detection parameters
+ * @param rejectedImgPoints contains the imgPoints of those squares whose inner code has not a
+ * correct codification. Useful for debugging purposes.
+ *
+ * Same as detectMarkers(), but the thresholding and the contour search are done only inside the
+ * bounding boxes of the previous markers, enlarged by DetectorParameters::trackingRoiMarginRate.
+ * The overlapping regions are merged. It is much faster than detectMarkers() for high resolution
+ * images, but new markers are not found, so a full detection should be done from time to time.
+ * If previousCorners is empty, the whole image is searched as in detectMarkers().
+ * @sa detectMarkers
+ */
+CV_EXPORTS_W void trackMarkers(InputArray image, Ptr<Dictionary> &dictionary,
+                               InputArrayOfArrays previousCorners, OutputArrayOfArrays corners,
+                               OutputArray ids,
+                               const Ptr<DetectorParameters> &parameters = DetectorParameters::create(),
+                               OutputArrayOfArrays rejectedImgPoints = noArray());
+
+
+
+/**
+ * @brief Flags of estimatePoseSingleMarkers()
+ * - POSE_USE_EXTRINSIC_GUESS: rvecs and tvecs contain the poses of the markers in the previous
+ *   frame (in the same order than corners), they are used as initial guess. The markers whose
+ *   tvec is zero, e.g. the ones not seen in the previous frame, are estimated without a guess.
+ * - POSE_PLANAR_CLOSED_FORM: closed-form planar pose (IPPE) from the homography of the marker,
+ *   instead of the iterative solvePnP. Of the two solutions of the planar ambiguity, the one with
+ *   the lowest reprojection error is returned, or the one closest to the guess with
+ *   POSE_USE_EXTRINSIC_GUESS, so that the pose does not flip between frames.
+ */
+enum CV_EXPORTS_W_SIMPLE PoseEstimationFlags {
+    POSE_USE_EXTRINSIC_GUESS = 1,
+    POSE_PLANAR_CLOSED_FORM = 2
+};
+
+
+
 /**
  * @brief Pose estimation for single markers
  *
@@ -196,6 +252,7 @@ CV_EXPORTS_W void detectMarkers(InputArray image, Ptr<Dictionary> &dictionary, O
  * Each element in rvecs corresponds to the specific marker in imgPoints.
  * @param tvecs array of output translation vectors (e.g. std::vector<cv::Vec3d>).
  * Each element in tvecs corresponds to the specific marker in imgPoints.
+ * @param flags combination of PoseEstimationFlags
  *
  * This function receives the detected markers and returns their pose estimation respect to
  * the camera individually. So for each marker, one rotation and translation vector is returned.
@@ -209,7 +266,8 @@ CV_EXPORTS_W void detectMarkers(InputArray image, Ptr<Dictionary> &dictionary, O
  */
 CV_EXPORTS_W void estimatePoseSingleMarkers(InputArrayOfArrays corners, float markerLength,
                                             InputArray cameraMatrix, InputArray distCoeffs,
-                                            OutputArray rvecs, OutputArray tvecs);
+                                            InputOutputArray rvecs, InputOutputArray tvecs,
+                                            int flags = 0);
 
 
 
@@ -175,6 +175,8 @@ CV_EXPORTS_W int interpolateCornersCharuco(InputArrayOfArrays markerCorners, Inp
  * @param rvec Output vector (e.g. cv::Mat) corresponding to the rotation vector of the board
  * (@sa Rodrigues).
  * @param tvec Output vector (e.g. cv::Mat) corresponding to the translation vector of the board.
+ * @param useExtrinsicGuess if true, rvec and tvec contain the previous pose of the board (e.g. in
+ * the previous frame), which is used as initial guess.
  *
  * This function estimates a Charuco board pose from some detected corners.
  * The function checks if the input corners are enough and valid to perform pose estimation.
@@ -182,7 +184,8 @@ CV_EXPORTS_W int interpolateCornersCharuco(InputArrayOfArrays markerCorners, Inp
  */
 CV_EXPORTS_W bool estimatePoseCharucoBoard(InputArray charucoCorners, InputArray charucoIds,
                                            Ptr<CharucoBoard> &board, InputArray cameraMatrix,
-                                           InputArray distCoeffs, OutputArray rvec, OutputArray tvec);
+                                           InputArray distCoeffs, InputOutputArray rvec,
+                                           InputOutputArray tvec, bool useExtrinsicGuess = false);
 
 
 
@@ -256,6 +259,89 @@ CV_EXPORTS_W double calibrateCameraCharuco(
 
 
 
+/**
+ * @brief Incremental camera calibration from the views of a ChArUco board
+ *
+ * The captured frames are queued by addFrame(), which only copies them. The queued frames are
+ * processed in batches: the marker detection and the corner interpolation of all the frames of a
+ * batch run in parallel, when batchSize frames are queued or when processFrames() or calibrate()
+ * are called. After the first calibration, the interpolation uses the estimated camera parameters.
+ *
+ * At most maxViews views are kept, so that the cost of calibrate() is bounded. When the store is
+ * full, a new view replaces the stored view that contributes less to the coverage of the image
+ * (the corners in cells of the image already covered by many views contribute less), if the new
+ * view contributes more.
+ */
+class CV_EXPORTS_W CharucoCalibrator {
+
+    public:
+    CharucoCalibrator(const Ptr<CharucoBoard> &board, const Ptr<DetectorParameters> &params,
+                      int maxViews, int batchSize);
+
+    /**
+     * @brief Create a CharucoCalibrator object
+     *
+     * @param board layout of ChArUco board.
+     * @param params marker detection parameters
+     * @param maxViews maximum number of views kept for the calibration
+     * @param batchSize number of queued frames that triggers their processing
+     */
+    CV_WRAP static Ptr<CharucoCalibrator> create(const Ptr<CharucoBoard> &board,
+                                                 const Ptr<DetectorParameters> &params =
+                                                     DetectorParameters::create(),
+                                                 int maxViews = 40, int batchSize = 8);
+
+    /**
+     * @brief Queue a frame, all the frames must have the same size
+     */
+    CV_WRAP void addFrame(InputArray image);
+
+    /**
+     * @brief Process the queued frames, returns the number of views added to the store
+     */
+    CV_WRAP int processFrames();
+
+    /**
+     * @brief Calibrate the camera with the stored views, after processing the queued frames.
+     * The parameters are the same than in calibrateCameraCharuco(), the re-projection error is
+     * returned.
+     */
+    CV_WRAP double calibrate(InputOutputArray cameraMatrix, InputOutputArray distCoeffs,
+                             int flags = 0,
+                             TermCriteria criteria = TermCriteria(TermCriteria::COUNT +
+                                                                  TermCriteria::EPS, 30,
+                                                                  DBL_EPSILON));
+
+    /**
+     * @brief Number of stored views
+     */
+    CV_WRAP int getViewsNumber() const { return (int)viewCorners.size(); }
+
+    /**
+     * @brief Charuco corners and identifiers of the stored views
+     */
+    CV_WRAP void getViews(OutputArrayOfArrays charucoCorners, OutputArrayOfArrays charucoIds) const;
+
+    private:
+    bool addView(const Mat &corners, const Mat &ids);
+    int getCoverageCell(const Point2f &corner) const;
+    double getViewContribution(const Mat &corners, int extraCount) const;
+
+    Ptr<CharucoBoard> board;
+    Ptr<DetectorParameters> params;
+    int maxViews, batchSize;
+    Size imageSize;
+
+    std::vector< Mat > pendingFrames;
+    std::vector< Mat > viewCorners, viewIds;
+    std::vector< int > coverage; // number of stored corners in each cell of the image grid
+
+    // latest calibration, used for the corner interpolation
+    Mat cameraMatrix, distCoeffs;
+};
+
+
+
 /**
  * @brief Detect ChArUco Diamond markers
  *
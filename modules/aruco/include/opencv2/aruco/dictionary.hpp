@@ -47,6 +47,7 @@ namespace aruco {
 //! @addtogroup aruco
 //! @{
 
+struct DictionaryIndex;
 
 /**
  * @brief Dictionary/Set of markers. It contains the inner codification
@@ -101,6 +102,10 @@ class CV_EXPORTS_W Dictionary {
     /**
      * @brief Given a matrix of bits. Returns whether if marker is identified or not.
      * It returns by reference the correct id (if any) and the correct rotation
+     *
+     * The markers are looked up in multi-index tables of bytesList instead of comparing the bits
+     * to every marker. The tables are built on the first call for each correction rate and rebuilt
+     * if bytesList is reallocated or resized, in-place modifications of bytesList are not detected.
      */
     bool identify(const Mat &onlyBits, int &idx, int &rotation, double maxCorrectionRate) const;
 
@@ -127,6 +132,12 @@ class CV_EXPORTS_W Dictionary {
       * @brief Transform list of bytes to matrix of bits
       */
     static Mat getBitsFromByteList(const Mat &byteList, int markerSize);
+
+    private:
+    Ptr<DictionaryIndex> getIndex(int nChunks) const;
+
+    // lookup tables used by identify(), indexed by their number of chunks
+    mutable std::vector< Ptr<DictionaryIndex> > indexes;
 };
 
 
@@ -0,0 +1,57 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+
+// Marker detection in synthetic frames of a grid of markers, with and without the corner refinement
+
+typedef std::tr1::tuple<Size, int, bool> Aruco_Detect_t;
+typedef perf::TestBaseWithParam<Aruco_Detect_t> aruco_detect;
+
+// gridSize x gridSize markers of the dictionary, in a white frame
+static Mat drawMarkerGrid(Ptr<aruco::Dictionary>& dictionary, Size size, int gridSize)
+{
+    Mat frame(size, CV_8UC1, Scalar::all(255));
+    int cell = std::min(size.width, size.height) / gridSize;
+    int side = cell * 2 / 3;
+    for (int y = 0; y < gridSize; y++)
+    {
+        for (int x = 0; x < gridSize; x++)
+        {
+            Mat marker;
+            aruco::drawMarker(dictionary, y * gridSize + x, side, marker);
+            marker.copyTo(frame(Rect(x * cell + (cell - side) / 2, y * cell + (cell - side) / 2, side, side)));
+        }
+    }
+    return frame;
+}
+
+PERF_TEST_P(aruco_detect, detectMarkers,
+            testing::Combine(
+                testing::Values(szVGA, sz720p, sz1080p),
+                testing::Values(1, 4, 8),
+                testing::Bool()))
+{
+    Size size = std::tr1::get<0>(GetParam());
+    int gridSize = std::tr1::get<1>(GetParam());
+    bool refine = std::tr1::get<2>(GetParam());
+
+    Ptr<aruco::Dictionary> dictionary = aruco::getPredefinedDictionary(aruco::DICT_6X6_250);
+    Ptr<aruco::DetectorParameters> params = aruco::DetectorParameters::create();
+    params->doCornerRefinement = refine;
+    Mat frame = drawMarkerGrid(dictionary, size, gridSize);
+
+    vector< vector<Point2f> > corners;
+    vector<int> ids;
+    declare.in(frame);
+
+    TEST_CYCLE() aruco::detectMarkers(frame, dictionary, corners, ids, params);
+
+    EXPECT_EQ(gridSize * gridSize, (int)ids.size());
+    SANITY_CHECK_NOTHING();
+}
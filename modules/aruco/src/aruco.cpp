@@ -40,6 +40,8 @@ the use of this software, even if advised of the possibility of such damage.
 #include "opencv2/aruco.hpp"
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
+#include <opencv2/core/ocl.hpp>
+#include <climits>
 
 namespace cv {
 namespace aruco {
@@ -72,7 +74,9 @@ DetectorParameters::DetectorParameters()
       perspectiveRemoveIgnoredMarginPerCell(0.13),
       maxErroneousBitsInBorderRate(0.35),
       minOtsuStdDev(5.0),
-      errorCorrectionRate(0.6) {}
+      errorCorrectionRate(0.6),
+      detectionImageScale(1.),
+      trackingRoiMarginRate(0.5) {}
 
 
 /**
@@ -110,24 +114,36 @@ static void _threshold(InputArray _in, OutputArray _out, int winSize, double con
 }
 
 
+/**
+  * @brief Same as _threshold, composed of T-API calls so that it runs with OpenCL on a UMat.
+  * As in adaptiveThreshold, a pixel is set if it is not higher than its local mean minus the constant
+  */
+static void _thresholdUMat(const UMat &_in, UMat &_out, int winSize, double constant) {
+
+    CV_Assert(winSize >= 3);
+    if(winSize % 2 == 0) winSize++; // win size must be odd
+    UMat mean, in16, mean16;
+    boxFilter(_in, mean, _in.type(), Size(winSize, winSize), Point(-1, -1), true,
+              BORDER_REPLICATE | BORDER_ISOLATED);
+    _in.convertTo(in16, CV_16S, 1, cvFloor(constant));
+    mean.convertTo(mean16, CV_16S);
+    compare(in16, mean16, _out, CMP_LE);
+}
+
+
 /**
   * @brief Given a tresholded image, find the contours, calculate their polygonal approximation
   * and take those that accomplish some conditions
   */
 static void _findMarkerContours(InputArray _in, vector< vector< Point2f > > &candidates,
-                                vector< vector< Point > > &contoursOut, double minPerimeterRate,
-                                double maxPerimeterRate, double accuracyRate,
-                                double minCornerDistanceRate, int minDistanceToBorder) {
+                                vector< vector< Point > > &contoursOut,
+                                unsigned int minPerimeterPixels, unsigned int maxPerimeterPixels,
+                                double accuracyRate, double minCornerDistanceRate,
+                                int minDistanceToBorder) {
 
-    CV_Assert(minPerimeterRate > 0 && maxPerimeterRate > 0 && accuracyRate > 0 &&
+    CV_Assert(minPerimeterPixels > 0 && maxPerimeterPixels > 0 && accuracyRate > 0 &&
               minCornerDistanceRate >= 0 && minDistanceToBorder >= 0);
 
-    // calculate maximum and minimum sizes in pixels
-    unsigned int minPerimeterPixels =
-        (unsigned int)(minPerimeterRate * max(_in.getMat().cols, _in.getMat().rows));
-    unsigned int maxPerimeterPixels =
-        (unsigned int)(maxPerimeterRate * max(_in.getMat().cols, _in.getMat().rows));
-
     Mat contoursImg;
     _in.getMat().copyTo(contoursImg);
     vector< vector< Point > > contours;
@@ -268,33 +284,64 @@ static void _filterTooCloseCandidates(const vector< vector< Point2f > > &candida
 
 /**
   * ParallelLoopBody class for the parallelization of the basic candidate detections using
-  * different threhold window sizes. Called from function _detectInitialCandidates()
+  * different threhold window sizes. Each job is a pair of a region of the image and a window size.
+  * If thresholds is not empty, it contains the whole image already thresholded at each window size.
+  * Called from function _detectInitialCandidates()
   */
 class DetectInitialCandidatesParallel : public ParallelLoopBody {
     public:
-    DetectInitialCandidatesParallel(const Mat *_grey,
+    DetectInitialCandidatesParallel(const Mat *_grey, const vector< Mat > *_thresholds,
+                                    const vector< Rect > *_rois, int _nScales, double _scale,
                                     vector< vector< vector< Point2f > > > *_candidatesArrays,
                                     vector< vector< vector< Point > > > *_contoursArrays,
                                     const Ptr<DetectorParameters> &_params)
-        : grey(_grey), candidatesArrays(_candidatesArrays), contoursArrays(_contoursArrays),
-          params(_params) {}
+        : grey(_grey), thresholds(_thresholds), rois(_rois), nScales(_nScales), scale(_scale),
+          candidatesArrays(_candidatesArrays), contoursArrays(_contoursArrays), params(_params) {
+
+        // the perimeter limits are relative to the whole image, also when only some regions
+        // are thresholded
+        Size imageSize = thresholds->empty() ? grey->size() : (*thresholds)[0].size();
+        int maxDim = max(imageSize.width, imageSize.height);
+        CV_Assert(params->minMarkerPerimeterRate > 0 && params->maxMarkerPerimeterRate > 0);
+        minPerimeterPixels = max(1u, (unsigned int)(params->minMarkerPerimeterRate * maxDim));
+        maxPerimeterPixels = max(1u, (unsigned int)(params->maxMarkerPerimeterRate * maxDim));
+    }
 
     void operator()(const Range &range) const {
         const int begin = range.start;
         const int end = range.end;
 
         for(int i = begin; i < end; i++) {
+            const Rect &roi = (*rois)[i / nScales];
             int currScale =
-                params->adaptiveThreshWinSizeMin + i * params->adaptiveThreshWinSizeStep;
+                params->adaptiveThreshWinSizeMin + (i % nScales) * params->adaptiveThreshWinSizeStep;
+            // the window sizes are given for the full resolution image
+            if(scale != 1.) currScale = max(3, cvRound(currScale * scale));
+            int minDistanceToBorder = cvRound(params->minDistanceToBorder * scale);
+
             // threshold
             Mat thresh;
-            _threshold(*grey, thresh, currScale, params->adaptiveThreshConstant);
+            if(thresholds->empty())
+                _threshold((*grey)(roi), thresh, currScale, params->adaptiveThreshConstant);
+            else
+                thresh = (*thresholds)[i];
 
             // detect rectangles
             _findMarkerContours(thresh, (*candidatesArrays)[i], (*contoursArrays)[i],
-                                params->minMarkerPerimeterRate, params->maxMarkerPerimeterRate,
+                                minPerimeterPixels, maxPerimeterPixels,
                                 params->polygonalApproxAccuracyRate, params->minCornerDistanceRate,
-                                params->minDistanceToBorder);
+                                minDistanceToBorder);
+
+            // back to image coordinates
+            if(roi.x != 0 || roi.y != 0) {
+                Point2f offset((float)roi.x, (float)roi.y);
+                for(unsigned int j = 0; j < (*candidatesArrays)[i].size(); j++) {
+                    for(int c = 0; c < 4; c++)
+                        (*candidatesArrays)[i][j][c] += offset;
+                    for(unsigned int k = 0; k < (*contoursArrays)[i][j].size(); k++)
+                        (*contoursArrays)[i][j][k] += roi.tl();
+                }
+            }
         }
     }
 
@@ -302,6 +349,11 @@ class DetectInitialCandidatesParallel : public ParallelLoopBody {
     DetectInitialCandidatesParallel &operator=(const DetectInitialCandidatesParallel &);
 
     const Mat *grey;
+    const vector< Mat > *thresholds;
+    const vector< Rect > *rois;
+    int nScales;
+    double scale;
+    unsigned int minPerimeterPixels, maxPerimeterPixels;
     vector< vector< vector< Point2f > > > *candidatesArrays;
     vector< vector< vector< Point > > > *contoursArrays;
     const Ptr<DetectorParameters> &params;
@@ -309,11 +361,16 @@ class DetectInitialCandidatesParallel : public ParallelLoopBody {
 
 
 /**
- * @brief Initial steps on finding square candidates
+ * @brief Initial steps on finding square candidates. Only the regions rois of the image are
+ * thresholded. scale is the scale of grey respect to the original image.
+ * If ugrey is not empty, the whole image is thresholded from it instead of grey, and only the
+ * thresholded images are downloaded for the contour search.
  */
-static void _detectInitialCandidates(const Mat &grey, vector< vector< Point2f > > &candidates,
+static void _detectInitialCandidates(const Mat &grey, const UMat &ugrey,
+                                     vector< vector< Point2f > > &candidates,
                                      vector< vector< Point > > &contours,
-                                     const Ptr<DetectorParameters> &params) {
+                                     const Ptr<DetectorParameters> &params,
+                                     const vector< Rect > &rois, double scale) {
 
     CV_Assert(params->adaptiveThreshWinSizeMin >= 3 && params->adaptiveThreshWinSizeMax >= 3);
     CV_Assert(params->adaptiveThreshWinSizeMax >= params->adaptiveThreshWinSizeMin);
@@ -322,29 +379,33 @@ static void _detectInitialCandidates(const Mat &grey, vector< vector< Point2f >
     // number of window sizes (scales) to apply adaptive thresholding
     int nScales =  (params->adaptiveThreshWinSizeMax - params->adaptiveThreshWinSizeMin) /
                       params->adaptiveThreshWinSizeStep + 1;
+    int nJobs = nScales * (int)rois.size();
+
+    vector< vector< vector< Point2f > > > candidatesArrays((size_t) nJobs);
+    vector< vector< vector< Point > > > contoursArrays((size_t) nJobs);
+
+    // the device queues the thresholds one after the other
+    vector< Mat > thresholds;
+    if(!ugrey.empty()) {
+        CV_Assert(rois.size() == 1 && rois[0] == Rect(Point(0, 0), ugrey.size()));
+        thresholds.resize(nScales);
+        UMat uthresh;
+        for(int i = 0; i < nScales; i++) {
+            int currScale = params->adaptiveThreshWinSizeMin + i * params->adaptiveThreshWinSizeStep;
+            if(scale != 1.) currScale = max(3, cvRound(currScale * scale));
+            _thresholdUMat(ugrey, uthresh, currScale, params->adaptiveThreshConstant);
+            uthresh.copyTo(thresholds[i]);
+        }
+    }
 
-    vector< vector< vector< Point2f > > > candidatesArrays((size_t) nScales);
-    vector< vector< vector< Point > > > contoursArrays((size_t) nScales);
-
-    ////for each value in the interval of thresholding window sizes
-    // for(int i = 0; i < nScales; i++) {
-    //    int currScale = params.adaptiveThreshWinSizeMin + i*params.adaptiveThreshWinSizeStep;
-    //    // treshold
-    //    Mat thresh;
-    //    _threshold(grey, thresh, currScale, params.adaptiveThreshConstant);
-    //    // detect rectangles
-    //    _findMarkerContours(thresh, candidatesArrays[i], contoursArrays[i],
-    // params.minMarkerPerimeterRate,
-    //                        params.maxMarkerPerimeterRate, params.polygonalApproxAccuracyRate,
-    //                        params.minCornerDistance, params.minDistanceToBorder);
-    //}
-
-    // this is the parallel call for the previous commented loop (result is equivalent)
-    parallel_for_(Range(0, nScales), DetectInitialCandidatesParallel(&grey, &candidatesArrays,
-                                                                     &contoursArrays, params));
+    // every window size on every region is thresholded in parallel
+    parallel_for_(Range(0, nJobs), DetectInitialCandidatesParallel(&grey, &thresholds, &rois,
+                                                                   nScales, scale,
+                                                                   &candidatesArrays,
+                                                                   &contoursArrays, params));
 
     // join candidates
-    for(int i = 0; i < nScales; i++) {
+    for(int i = 0; i < nJobs; i++) {
         for(unsigned int j = 0; j < candidatesArrays[i].size(); j++) {
             candidates.push_back(candidatesArrays[i][j]);
             contours.push_back(contoursArrays[i][j]);
@@ -354,22 +415,75 @@ static void _detectInitialCandidates(const Mat &grey, vector< vector< Point2f >
 
 
 /**
- * @brief Detect square candidates in the input image
+  * ParallelLoopBody class for the parallelization of the marker corner subpixel refinement
+  * Called from functions detectMarkers() and _detectCandidates()
+  */
+class MarkerSubpixelParallel : public ParallelLoopBody {
+    public:
+    MarkerSubpixelParallel(const Mat *_grey, OutputArrayOfArrays _corners, int _winSize,
+                           const Ptr<DetectorParameters> &_params)
+        : grey(_grey), corners(_corners), winSize(_winSize), params(_params) {}
+
+    void operator()(const Range &range) const {
+        const int begin = range.start;
+        const int end = range.end;
+
+        for(int i = begin; i < end; i++) {
+            cornerSubPix(*grey, corners.getMat(i), Size(winSize, winSize), Size(-1, -1),
+                         TermCriteria(TermCriteria::MAX_ITER | TermCriteria::EPS,
+                                      params->cornerRefinementMaxIterations,
+                                      params->cornerRefinementMinAccuracy));
+        }
+    }
+
+    private:
+    MarkerSubpixelParallel &operator=(const MarkerSubpixelParallel &); // to quiet MSVC
+
+    const Mat *grey;
+    OutputArrayOfArrays corners;
+    int winSize;
+    const Ptr<DetectorParameters> &params;
+};
+
+
+/**
+ * @brief Detect square candidates in the input image. If ugrey is not empty, it is the grey
+ * image on the device, used for the thresholding of the whole image
  */
 static void _detectCandidates(InputArray _image, OutputArrayOfArrays _candidates,
-                              OutputArrayOfArrays _contours, const Ptr<DetectorParameters> &_params) {
+                              OutputArrayOfArrays _contours, const Ptr<DetectorParameters> &_params,
+                              const vector< Rect > &rois = vector< Rect >(),
+                              const UMat &ugrey = UMat()) {
 
     Mat image = _image.getMat();
     CV_Assert(image.total() != 0);
+    CV_Assert(_params->detectionImageScale > 0 && _params->detectionImageScale <= 1);
 
     /// 1. CONVERT TO GRAY
     Mat grey;
     _convertToGrey(image, grey);
 
+    // the regions are searched at full resolution, the whole image at detectionImageScale
+    double scale = rois.empty() ? _params->detectionImageScale : 1.;
+    bool useDevice = !ugrey.empty() && rois.empty();
+    Mat scaledGrey = grey;
+    UMat scaledUGrey;
+    if(useDevice) {
+        scaledUGrey = ugrey;
+        if(scale < 1.)
+            resize(ugrey, scaledUGrey, Size(), scale, scale, INTER_AREA);
+    }
+    else if(scale < 1.)
+        resize(grey, scaledGrey, Size(), scale, scale, INTER_AREA);
+    Size scaledSize = useDevice ? scaledUGrey.size() : scaledGrey.size();
+    vector< Rect > searchRois = rois;
+    if(searchRois.empty()) searchRois.push_back(Rect(Point(0, 0), scaledSize));
+
     vector< vector< Point2f > > candidates;
     vector< vector< Point > > contours;
     /// 2. DETECT FIRST SET OF CANDIDATES
-    _detectInitialCandidates(grey, candidates, contours, _params);
+    _detectInitialCandidates(scaledGrey, scaledUGrey, candidates, contours, _params, searchRois,
+                             scale);
 
     /// 3. SORT CORNERS
     _reorderCandidatesCorners(candidates);
@@ -380,6 +494,23 @@ static void _detectCandidates(InputArray _image, OutputArrayOfArrays _candidates
     _filterTooCloseCandidates(candidates, candidatesOut, contours, contoursOut,
                               _params->minMarkerDistanceRate);
 
+    /// 5. REFINE THE DOWNSCALED CANDIDATES AT FULL RESOLUTION
+    if(scale < 1.) {
+        float invScale = (float)(1. / scale);
+        for(unsigned int i = 0; i < candidatesOut.size(); i++) {
+            for(int c = 0; c < 4; c++)
+                candidatesOut[i][c] = (candidatesOut[i][c] + Point2f(0.5f, 0.5f)) * invScale -
+                                      Point2f(0.5f, 0.5f);
+            for(unsigned int j = 0; j < contoursOut[i].size(); j++)
+                contoursOut[i][j] = Point(cvRound(contoursOut[i][j].x * invScale),
+                                          cvRound(contoursOut[i][j].y * invScale));
+        }
+        // the window covers the error of the downscaled corners
+        int winSize = max(_params->cornerRefinementWinSize, cvCeil(invScale) + 1);
+        parallel_for_(Range(0, (int)candidatesOut.size()),
+                      MarkerSubpixelParallel(&grey, candidatesOut, winSize, _params));
+    }
+
     // parse output
     _candidates.create((int)candidatesOut.size(), 1, CV_32FC2);
     _contours.create((int)contoursOut.size(), 1, CV_32SC2);
@@ -397,16 +528,54 @@ static void _detectCandidates(InputArray _image, OutputArrayOfArrays _candidates
 }
 
 
+/**
+  * @brief Sample the marker image without perspective, with nearest neighbour interpolation and
+  * a black border, the same as warpPerspective does but without intermediate buffers
+  */
+static void _removePerspective(const Mat &image, InputArray _corners, int resultImgSize,
+                               Mat &resultImg) {
+
+    Point2f resultImgCorners[4];
+    resultImgCorners[0] = Point2f(0, 0);
+    resultImgCorners[1] = Point2f((float)resultImgSize - 1, 0);
+    resultImgCorners[2] = Point2f((float)resultImgSize - 1, (float)resultImgSize - 1);
+    resultImgCorners[3] = Point2f(0, (float)resultImgSize - 1);
+
+    // transformation from the marker image to the input image
+    Mat transformation = getPerspectiveTransform(_corners.getMat().ptr< Point2f >(),
+                                                 resultImgCorners);
+    invert(transformation, transformation);
+    const double *M = transformation.ptr< double >();
+
+    resultImg.create(resultImgSize, resultImgSize, CV_8UC1);
+    for(int y = 0; y < resultImgSize; y++) {
+        double X0 = M[1] * y + M[2], Y0 = M[4] * y + M[5], W0 = M[7] * y + M[8];
+        uchar *dst = resultImg.ptr< uchar >(y);
+        for(int x = 0; x < resultImgSize; x++) {
+            double W = W0 + M[6] * x;
+            W = W ? 1. / W : 0;
+            double fX = max((double)INT_MIN, min((double)INT_MAX, (X0 + M[0] * x) * W));
+            double fY = max((double)INT_MIN, min((double)INT_MAX, (Y0 + M[3] * x) * W));
+            int X = saturate_cast< int >(fX), Y = saturate_cast< int >(fY);
+            dst[x] = ((unsigned)X < (unsigned)image.cols && (unsigned)Y < (unsigned)image.rows)
+                         ? image.ptr< uchar >(Y)[X]
+                         : 0;
+        }
+    }
+}
+
+
 /**
   * @brief Given an input image and candidate corners, extract the bits of the candidate, including
-  * the border bits
+  * the border bits. resultImg is the buffer of the marker image, so that it can be reused for
+  * several candidates
   */
-static Mat _extractBits(InputArray _image, InputArray _corners, int markerSize,
-                        int markerBorderBits, int cellSize, double cellMarginRate,
-                        double minStdDevOtsu) {
+static void _extractBits(InputArray _image, InputArray _corners, int markerSize,
+                         int markerBorderBits, int cellSize, double cellMarginRate,
+                         double minStdDevOtsu, Mat &bits, Mat &resultImg) {
 
-    CV_Assert(_image.getMat().channels() == 1);
-    CV_Assert(_corners.total() == 4);
+    CV_Assert(_image.type() == CV_8UC1);
+    CV_Assert(_corners.total() == 4 && _corners.type() == CV_32FC2);
     CV_Assert(markerBorderBits > 0 && cellSize > 0 && cellMarginRate >= 0 && cellMarginRate <= 1);
     CV_Assert(minStdDevOtsu >= 0);
 
@@ -414,37 +583,28 @@ static Mat _extractBits(InputArray _image, InputArray _corners, int markerSize,
     int markerSizeWithBorders = markerSize + 2 * markerBorderBits;
     int cellMarginPixels = int(cellMarginRate * cellSize);
 
-    Mat resultImg; // marker image after removing perspective
+    // marker image after removing perspective
     int resultImgSize = markerSizeWithBorders * cellSize;
-    Mat resultImgCorners(4, 1, CV_32FC2);
-    resultImgCorners.ptr< Point2f >(0)[0] = Point2f(0, 0);
-    resultImgCorners.ptr< Point2f >(0)[1] = Point2f((float)resultImgSize - 1, 0);
-    resultImgCorners.ptr< Point2f >(0)[2] =
-        Point2f((float)resultImgSize - 1, (float)resultImgSize - 1);
-    resultImgCorners.ptr< Point2f >(0)[3] = Point2f(0, (float)resultImgSize - 1);
-
-    // remove perspective
-    Mat transformation = getPerspectiveTransform(_corners, resultImgCorners);
-    warpPerspective(_image, resultImg, transformation, Size(resultImgSize, resultImgSize),
-                    INTER_NEAREST);
+    _removePerspective(_image.getMat(), _corners, resultImgSize, resultImg);
 
     // output image containing the bits
-    Mat bits(markerSizeWithBorders, markerSizeWithBorders, CV_8UC1, Scalar::all(0));
+    bits.create(markerSizeWithBorders, markerSizeWithBorders, CV_8UC1);
+    bits.setTo(0);
 
     // check if standard deviation is enough to apply Otsu
     // if not enough, it probably means all bits are the same color (black or white)
-    Mat mean, stddev;
+    Scalar mean, stddev;
     // Remove some border just to avoid border noise from perspective transformation
     Mat innerRegion = resultImg.colRange(cellSize / 2, resultImg.cols - cellSize / 2)
                           .rowRange(cellSize / 2, resultImg.rows - cellSize / 2);
     meanStdDev(innerRegion, mean, stddev);
-    if(stddev.ptr< double >(0)[0] < minStdDevOtsu) {
+    if(stddev[0] < minStdDevOtsu) {
         // all black or all white, depending on mean value
-        if(mean.ptr< double >(0)[0] > 127)
+        if(mean[0] > 127)
             bits.setTo(1);
         else
             bits.setTo(0);
-        return bits;
+        return;
     }
 
     // now extract code, first threshold using Otsu
@@ -462,8 +622,6 @@ static Mat _extractBits(InputArray _image, InputArray _corners, int markerSize,
             if(nZ > square.total() / 2) bits.at< unsigned char >(y, x) = 1;
         }
     }
-
-    return bits;
 }
 
 
@@ -498,17 +656,18 @@ static int _getBorderErrors(const Mat &bits, int markerSize, int borderSize) {
  * @brief Tries to identify one candidate given the dictionary
  */
 static bool _identifyOneCandidate(Ptr<Dictionary> &dictionary, InputArray _image,
-                                  InputOutputArray _corners, int &idx, const Ptr<DetectorParameters> &params) {
+                                  InputOutputArray _corners, int &idx, const Ptr<DetectorParameters> &params,
+                                  Mat &candidateBits, Mat &markerImg) {
 
     CV_Assert(_corners.total() == 4);
     CV_Assert(_image.getMat().total() != 0);
     CV_Assert(params->markerBorderBits > 0);
 
     // get bits
-    Mat candidateBits =
-        _extractBits(_image, _corners, dictionary->markerSize, params->markerBorderBits,
-                     params->perspectiveRemovePixelPerCell,
-                     params->perspectiveRemoveIgnoredMarginPerCell, params->minOtsuStdDev);
+    _extractBits(_image, _corners, dictionary->markerSize, params->markerBorderBits,
+                 params->perspectiveRemovePixelPerCell,
+                 params->perspectiveRemoveIgnoredMarginPerCell, params->minOtsuStdDev,
+                 candidateBits, markerImg);
 
     // analyze border bits
     int maximumErrorsInBorder =
@@ -557,10 +716,14 @@ class IdentifyCandidatesParallel : public ParallelLoopBody {
         const int begin = range.start;
         const int end = range.end;
 
+        // buffers shared by the candidates of the range
+        Mat bits, markerImg;
+
         for(int i = begin; i < end; i++) {
             int currId;
             Mat currentCandidate = candidates.getMat(i);
-            if(_identifyOneCandidate(dictionary, *grey, currentCandidate, currId, params)) {
+            if(_identifyOneCandidate(dictionary, *grey, currentCandidate, currId, params, bits,
+                                     markerImg)) {
                 (*validCandidates)[i] = 1;
                 (*idsTmp)[i] = currId;
             }
@@ -780,53 +943,33 @@ static void _getSingleMarkerObjectPoints(float markerLength, OutputArray _objPoi
 
 
 /**
-  * ParallelLoopBody class for the parallelization of the marker corner subpixel refinement
-  * Called from function detectMarkers()
   */
-class MarkerSubpixelParallel : public ParallelLoopBody {
-    public:
-    MarkerSubpixelParallel(const Mat *_grey, OutputArrayOfArrays _corners,
-                           const Ptr<DetectorParameters> &_params)
-        : grey(_grey), corners(_corners), params(_params) {}
-
-    void operator()(const Range &range) const {
-        const int begin = range.start;
-        const int end = range.end;
+static void _detectMarkers(InputArray _image, Ptr<Dictionary> &_dictionary,
+                           OutputArrayOfArrays _corners, OutputArray _ids,
+                           const Ptr<DetectorParameters> &_params,
+                           OutputArrayOfArrays _rejectedImgPoints, const vector< Rect > &rois) {
 
-        for(int i = begin; i < end; i++) {
-            cornerSubPix(*grey, corners.getMat(i),
-                         Size(params->cornerRefinementWinSize, params->cornerRefinementWinSize),
-                         Size(-1, -1), TermCriteria(TermCriteria::MAX_ITER | TermCriteria::EPS,
-                                                    params->cornerRefinementMaxIterations,
-                                                    params->cornerRefinementMinAccuracy));
-        }
-    }
-
-    private:
-    MarkerSubpixelParallel &operator=(const MarkerSubpixelParallel &); // to quiet MSVC
-
-    const Mat *grey;
-    OutputArrayOfArrays corners;
-    const Ptr<DetectorParameters> &params;
-};
-
-
-
-/**
-  */
-void detectMarkers(InputArray _image, Ptr<Dictionary> &_dictionary, OutputArrayOfArrays _corners,
-                   OutputArray _ids, const Ptr<DetectorParameters> &_params,
-                   OutputArrayOfArrays _rejectedImgPoints) {
-
-    CV_Assert(_image.getMat().total() != 0);
+    CV_Assert(_image.total() != 0);
 
+    // a UMat input is converted and thresholded with OpenCL, the grey image is downloaded once
+    // for the contours refinement and the identification
     Mat grey;
-    _convertToGrey(_image.getMat(), grey);
+    UMat ugrey;
+    if(_image.isUMat() && ocl::useOpenCL() && rois.empty()) {
+        CV_Assert(_image.channels() == 1 || _image.channels() == 3);
+        if(_image.type() == CV_8UC3)
+            cvtColor(_image, ugrey, COLOR_BGR2GRAY);
+        else
+            ugrey = _image.getUMat();
+        ugrey.copyTo(grey);
+    }
+    else
+        _convertToGrey(_image.getMat(), grey);
 
     /// STEP 1: Detect marker candidates
     vector< vector< Point2f > > candidates;
     vector< vector< Point > > contours;
-    _detectCandidates(grey, candidates, contours, _params);
+    _detectCandidates(grey, candidates, contours, _params, rois, ugrey);
 
     /// STEP 2: Check candidate codification (identify markers)
     _identifyCandidates(grey, candidates, contours, _dictionary, _corners, _ids, _params,
@@ -851,11 +994,226 @@ void detectMarkers(InputArray _image, Ptr<Dictionary> &_dictionary, OutputArrayO
 
         // this is the parallel call for the previous commented loop (result is equivalent)
         parallel_for_(Range(0, (int)_corners.total()),
-                      MarkerSubpixelParallel(&grey, _corners, _params));
+                      MarkerSubpixelParallel(&grey, _corners, _params->cornerRefinementWinSize,
+                                             _params));
+    }
+}
+
+
+
+/**
+  */
+void detectMarkers(InputArray _image, Ptr<Dictionary> &_dictionary, OutputArrayOfArrays _corners,
+                   OutputArray _ids, const Ptr<DetectorParameters> &_params,
+                   OutputArrayOfArrays _rejectedImgPoints) {
+
+    _detectMarkers(_image, _dictionary, _corners, _ids, _params, _rejectedImgPoints,
+                   vector< Rect >());
+}
+
+
+
+/**
+  */
+void trackMarkers(InputArray _image, Ptr<Dictionary> &_dictionary,
+                  InputArrayOfArrays _previousCorners, OutputArrayOfArrays _corners,
+                  OutputArray _ids, const Ptr<DetectorParameters> &_params,
+                  OutputArrayOfArrays _rejectedImgPoints) {
+
+    CV_Assert(_image.getMat().total() != 0);
+    CV_Assert(_params->trackingRoiMarginRate >= 0);
+
+    Rect imageRect(Point(0, 0), _image.getMat().size());
+
+    // search region of each previous marker
+    vector< Rect > rois;
+    for(unsigned int i = 0; i < _previousCorners.total(); i++) {
+        Rect r = boundingRect(_previousCorners.getMat(i));
+        int margin = cvCeil(_params->trackingRoiMarginRate * max(r.width, r.height));
+        r = Rect(r.x - margin, r.y - margin, r.width + 2 * margin, r.height + 2 * margin) & imageRect;
+        if(r.area() > 0) rois.push_back(r);
+    }
+
+    // no marker to track, detect in the whole image
+    if(rois.empty()) {
+        _detectMarkers(_image, _dictionary, _corners, _ids, _params, _rejectedImgPoints,
+                       vector< Rect >());
+        return;
+    }
+
+    // merge the overlapping regions, so that each marker is searched inside a single region
+    bool merged = true;
+    while(merged) {
+        merged = false;
+        for(unsigned int i = 0; i < rois.size() && !merged; i++) {
+            for(unsigned int j = i + 1; j < rois.size(); j++) {
+                if((rois[i] & rois[j]).area() > 0) {
+                    rois[i] |= rois[j];
+                    rois.erase(rois.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    _detectMarkers(_image, _dictionary, _corners, _ids, _params, _rejectedImgPoints, rois);
+}
+
+
+
+/**
+  * @brief Rotation that takes the direction of v to the Z axis
+  */
+static Matx33d _rotationToZAxis(const Vec3d &v) {
+
+    Vec3d a = v * (1. / norm(v));
+    Matx33d R = Matx33d::eye();
+    if(fabs(1. + a[2]) < DBL_EPSILON) {
+        R(1, 1) = R(2, 2) = -1.;
+        return R;
     }
+    double d = 1. / (1. + a[2]);
+    R(0, 0) = 1. - a[0] * a[0] * d;
+    R(0, 1) = R(1, 0) = -a[0] * a[1] * d;
+    R(0, 2) = -a[0];
+    R(1, 1) = 1. - a[1] * a[1] * d;
+    R(1, 2) = -a[1];
+    R(2, 0) = a[0];
+    R(2, 1) = a[1];
+    R(2, 2) = 1. - (a[0] * a[0] + a[1] * a[1]) * d;
+    return R;
 }
 
 
+/**
+  * @brief The two rotations of IPPE (Collins and Bartoli, Infinitesimal Plane-based Pose
+  * Estimation) from the jacobian J of the homography at the origin of the plane, which is
+  * projected to the normalized point (p, q). Returns false if the jacobian is degenerated
+  */
+static bool _ippeRotations(const Matx22d &J, double p, double q, Matx33d &R1, Matx33d &R2) {
+
+    // rotate the camera so that its Z axis points to the projection of the origin
+    Matx33d Rv = _rotationToZAxis(Vec3d(p, q, 1.)).t();
+    Matx22d B(Rv(0, 0) - p * Rv(2, 0), Rv(0, 1) - p * Rv(2, 1),
+              Rv(1, 0) - q * Rv(2, 0), Rv(1, 1) - q * Rv(2, 1));
+    double det = B(0, 0) * B(1, 1) - B(0, 1) * B(1, 0);
+    if(fabs(det) < DBL_EPSILON) return false;
+    Matx22d A = B.inv() * J;
+
+    // largest singular value of A
+    Matx22d AAt = A * A.t();
+    double gamma2 = 0.5 * (AAt(0, 0) + AAt(1, 1) +
+                           sqrt((AAt(0, 0) - AAt(1, 1)) * (AAt(0, 0) - AAt(1, 1)) +
+                                4. * AAt(0, 1) * AAt(0, 1)));
+    if(gamma2 < FLT_EPSILON) return false;
+    Matx22d Rt = A * (1. / sqrt(gamma2));
+
+    // complete the first two columns of the rotation, the two signs give the two solutions
+    double b0 = sqrt(max(0., 1. - Rt(0, 0) * Rt(0, 0) - Rt(1, 0) * Rt(1, 0)));
+    double b1 = sqrt(max(0., 1. - Rt(0, 1) * Rt(0, 1) - Rt(1, 1) * Rt(1, 1)));
+    if(-Rt(0, 0) * Rt(0, 1) - Rt(1, 0) * Rt(1, 1) < 0) b1 = -b1;
+
+    for(int s = 0; s < 2; s++) {
+        double sign = s == 0 ? 1. : -1.;
+        Vec3d c0(Rt(0, 0), Rt(1, 0), sign * b0), c1(Rt(0, 1), Rt(1, 1), sign * b1);
+        Vec3d c2 = c0.cross(c1);
+        Matx33d R(c0[0], c1[0], c2[0], c0[1], c1[1], c2[1], c0[2], c1[2], c2[2]);
+        (s == 0 ? R1 : R2) = Rv * R;
+    }
+    return true;
+}
+
+
+/**
+  * @brief Linear least squares translation of the plane points (x, y, 0) projected to the
+  * normalized points imgPoints, given the rotation. Returns the squared reprojection error
+  */
+static double _planarTranslation(const Vec3f *objPoints, const Point2f *imgPoints, int nPoints,
+                                 const Matx33d &R, Vec3d &t) {
+
+    Matx33d AtA = Matx33d::zeros();
+    Vec3d Atb(0, 0, 0);
+    for(int i = 0; i < nPoints; i++) {
+        double u = imgPoints[i].x, v = imgPoints[i].y;
+        Vec3d r = R * Vec3d(objPoints[i][0], objPoints[i][1], 0.);
+        double bu = u * r[2] - r[0], bv = v * r[2] - r[1];
+        AtA(0, 0) += 1.;
+        AtA(1, 1) += 1.;
+        AtA(0, 2) -= u;
+        AtA(1, 2) -= v;
+        AtA(2, 2) += u * u + v * v;
+        Atb += Vec3d(bu, bv, -u * bu - v * bv);
+    }
+    AtA(2, 0) = AtA(0, 2);
+    AtA(2, 1) = AtA(1, 2);
+    t = AtA.solve(Atb, DECOMP_CHOLESKY);
+
+    double error = 0;
+    for(int i = 0; i < nPoints; i++) {
+        Vec3d X = R * Vec3d(objPoints[i][0], objPoints[i][1], 0.) + t;
+        if(X[2] <= 0) return DBL_MAX;
+        double du = X[0] / X[2] - imgPoints[i].x, dv = X[1] / X[2] - imgPoints[i].y;
+        error += du * du + dv * dv;
+    }
+    return error;
+}
+
+
+/**
+  * @brief Closed-form pose of a planar set of 4 points centered in the origin, given their
+  * normalized projections. If useGuess, the solution closest to the rotation in rvec is
+  * chosen, else the one with the lowest reprojection error. Returns false if it fails
+  */
+static bool _solvePlanarPose(const Mat &objPoints, const Point2f *imgPoints, bool useGuess,
+                             Vec3d &rvec, Vec3d &tvec) {
+
+    CV_Assert(objPoints.total() == 4 && objPoints.type() == CV_32FC3);
+    const Vec3f *obj = objPoints.ptr< Vec3f >();
+
+    // homography from the plane to the normalized image
+    Matx< double, 8, 8 > M = Matx< double, 8, 8 >::zeros();
+    Matx< double, 8, 1 > b;
+    for(int i = 0; i < 4; i++) {
+        double x = obj[i][0], y = obj[i][1], u = imgPoints[i].x, v = imgPoints[i].y;
+        double r0[8] = { x, y, 1., 0., 0., 0., -u * x, -u * y };
+        double r1[8] = { 0., 0., 0., x, y, 1., -v * x, -v * y };
+        for(int j = 0; j < 8; j++) {
+            M(2 * i, j) = r0[j];
+            M(2 * i + 1, j) = r1[j];
+        }
+        b(2 * i) = u;
+        b(2 * i + 1) = v;
+    }
+    Matx< double, 8, 1 > h;
+    if(!solve(M, b, h, DECOMP_LU)) return false;
+
+    // jacobian of the homography at the origin
+    double p = h(2), q = h(5);
+    Matx22d J(h(0) - h(6) * p, h(1) - h(7) * p, h(3) - h(6) * q, h(4) - h(7) * q);
+
+    Matx33d R[2];
+    if(!_ippeRotations(J, p, q, R[0], R[1])) return false;
+    Vec3d t[2];
+    double error[2];
+    for(int s = 0; s < 2; s++)
+        error[s] = _planarTranslation(obj, imgPoints, 4, R[s], t[s]);
+
+    int best = error[1] < error[0] ? 1 : 0;
+    if(useGuess) {
+        // the closest rotation has the largest trace of R^t * Rguess
+        Matx33d Rguess;
+        Rodrigues(rvec, Rguess);
+        if(error[0] != DBL_MAX && error[1] != DBL_MAX)
+            best = trace(R[1].t() * Rguess) > trace(R[0].t() * Rguess) ? 1 : 0;
+    }
+    if(error[best] == DBL_MAX) return false;
+
+    Rodrigues(R[best], rvec);
+    tvec = t[best];
+    return true;
+}
+
 
 /**
   * ParallelLoopBody class for the parallelization of the single markers pose estimation
@@ -865,17 +1223,27 @@ class SinglePoseEstimationParallel : public ParallelLoopBody {
     public:
     SinglePoseEstimationParallel(Mat& _markerObjPoints, InputArrayOfArrays _corners,
                                  InputArray _cameraMatrix, InputArray _distCoeffs,
-                                 Mat& _rvecs, Mat& _tvecs)
+                                 Mat& _rvecs, Mat& _tvecs, const Mat &_normalizedCorners,
+                                 int _flags)
         : markerObjPoints(_markerObjPoints), corners(_corners), cameraMatrix(_cameraMatrix),
-          distCoeffs(_distCoeffs), rvecs(_rvecs), tvecs(_tvecs) {}
+          distCoeffs(_distCoeffs), rvecs(_rvecs), tvecs(_tvecs),
+          normalizedCorners(_normalizedCorners), flags(_flags) {}
 
     void operator()(const Range &range) const {
         const int begin = range.start;
         const int end = range.end;
 
         for(int i = begin; i < end; i++) {
-            solvePnP(markerObjPoints, corners.getMat(i), cameraMatrix, distCoeffs,
-                    rvecs.at<Vec3d>(i), tvecs.at<Vec3d>(i));
+            Vec3d &rvec = rvecs.at< Vec3d >(i), &tvec = tvecs.at< Vec3d >(i);
+            bool useGuess = (flags & POSE_USE_EXTRINSIC_GUESS) && tvec != Vec3d(0, 0, 0);
+
+            if((flags & POSE_PLANAR_CLOSED_FORM) &&
+               _solvePlanarPose(markerObjPoints, normalizedCorners.ptr< Point2f >() + 4 * i,
+                                useGuess, rvec, tvec))
+                continue;
+
+            solvePnP(markerObjPoints, corners.getMat(i), cameraMatrix, distCoeffs, rvec, tvec,
+                     useGuess);
         }
     }
 
@@ -886,6 +1254,8 @@ class SinglePoseEstimationParallel : public ParallelLoopBody {
     InputArrayOfArrays corners;
     InputArray cameraMatrix, distCoeffs;
     Mat& rvecs, tvecs;
+    const Mat &normalizedCorners;
+    int flags;
 };
 
 
@@ -895,18 +1265,35 @@ class SinglePoseEstimationParallel : public ParallelLoopBody {
   */
 void estimatePoseSingleMarkers(InputArrayOfArrays _corners, float markerLength,
                                InputArray _cameraMatrix, InputArray _distCoeffs,
-                               OutputArray _rvecs, OutputArray _tvecs) {
+                               InputOutputArray _rvecs, InputOutputArray _tvecs, int flags) {
 
     CV_Assert(markerLength > 0);
 
     Mat markerObjPoints;
     _getSingleMarkerObjectPoints(markerLength, markerObjPoints);
     int nMarkers = (int)_corners.total();
+
+    if(flags & POSE_USE_EXTRINSIC_GUESS) {
+        CV_Assert((int)_rvecs.total() == nMarkers && (int)_tvecs.total() == nMarkers);
+        CV_Assert(_rvecs.type() == CV_64FC3 && _tvecs.type() == CV_64FC3);
+    }
     _rvecs.create(nMarkers, 1, CV_64FC3);
     _tvecs.create(nMarkers, 1, CV_64FC3);
 
     Mat rvecs = _rvecs.getMat(), tvecs = _tvecs.getMat();
 
+    // the corners of all the markers are undistorted at once for the closed-form solution
+    Mat normalizedCorners;
+    if((flags & POSE_PLANAR_CLOSED_FORM) && nMarkers > 0) {
+        Mat allCorners(nMarkers * 4, 1, CV_32FC2);
+        for(int i = 0; i < nMarkers; i++) {
+            Mat markerCorners = _corners.getMat(i);
+            CV_Assert(markerCorners.total() == 4 && markerCorners.channels() == 2);
+            markerCorners.reshape(2, 4).convertTo(allCorners.rowRange(i * 4, i * 4 + 4), CV_32F);
+        }
+        undistortPoints(allCorners, normalizedCorners, _cameraMatrix, _distCoeffs);
+    }
+
     //// for each marker, calculate its pose
     // for (int i = 0; i < nMarkers; i++) {
     //    solvePnP(markerObjPoints, _corners.getMat(i), _cameraMatrix, _distCoeffs,
@@ -916,7 +1303,8 @@ void estimatePoseSingleMarkers(InputArrayOfArrays _corners, float markerLength,
     // this is the parallel call for the previous commented loop (result is equivalent)
     parallel_for_(Range(0, nMarkers),
                   SinglePoseEstimationParallel(markerObjPoints, _corners, _cameraMatrix,
-                                               _distCoeffs, rvecs, tvecs));
+                                               _distCoeffs, rvecs, tvecs, normalizedCorners,
+                                               flags));
 }
 
 
@@ -1196,10 +1584,11 @@ void refineDetectedMarkers(InputArray _image, Ptr<Board> &_board,
             if(errorCorrectionRate >= 0) {
 
                 // extract bits
-                Mat bits = _extractBits(
-                    grey, rotatedMarker, dictionary.markerSize, params.markerBorderBits,
-                    params.perspectiveRemovePixelPerCell,
-                    params.perspectiveRemoveIgnoredMarginPerCell, params.minOtsuStdDev);
+                Mat bits, markerImg;
+                _extractBits(grey, rotatedMarker, dictionary.markerSize, params.markerBorderBits,
+                             params.perspectiveRemovePixelPerCell,
+                             params.perspectiveRemoveIgnoredMarginPerCell, params.minOtsuStdDev,
+                             bits, markerImg);
 
                 Mat onlyBits =
                     bits.rowRange(params.markerBorderBits, bits.rows - params.markerBorderBits)
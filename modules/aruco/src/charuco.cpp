@@ -682,7 +682,7 @@ static bool _arePointsEnoughForPoseEstimation(const vector< Point3f > &points) {
   */
 bool estimatePoseCharucoBoard(InputArray _charucoCorners, InputArray _charucoIds,
                               Ptr<CharucoBoard> &_board, InputArray _cameraMatrix, InputArray _distCoeffs,
-                              OutputArray _rvec, OutputArray _tvec) {
+                              InputOutputArray _rvec, InputOutputArray _tvec, bool useExtrinsicGuess) {
 
     CV_Assert((_charucoCorners.getMat().total() == _charucoIds.getMat().total()));
 
@@ -700,7 +700,8 @@ bool estimatePoseCharucoBoard(InputArray _charucoCorners, InputArray _charucoIds
     // points need to be in different lines, check if detected points are enough
     if(!_arePointsEnoughForPoseEstimation(objPoints)) return false;
 
-    solvePnP(objPoints, _charucoCorners, _cameraMatrix, _distCoeffs, _rvec, _tvec);
+    solvePnP(objPoints, _charucoCorners, _cameraMatrix, _distCoeffs, _rvec, _tvec,
+             useExtrinsicGuess);
 
     return true;
 }
@@ -755,6 +756,201 @@ double calibrateCameraCharuco(InputArrayOfArrays _charucoCorners, InputArrayOfAr
 }
 
 
+
+/**
+  * ParallelLoopBody class for the parallelization of the marker detection and the corner
+  * interpolation of the frames queued in a CharucoCalibrator
+  */
+class CharucoFramesParallel : public ParallelLoopBody {
+    public:
+    CharucoFramesParallel(const vector< Mat > *_frames, const Ptr<CharucoBoard> &_board,
+                          const Ptr<DetectorParameters> &_params, const Mat &_cameraMatrix,
+                          const Mat &_distCoeffs, vector< Mat > *_charucoCorners,
+                          vector< Mat > *_charucoIds)
+        : frames(_frames), board(_board), params(_params), cameraMatrix(_cameraMatrix),
+          distCoeffs(_distCoeffs), charucoCorners(_charucoCorners), charucoIds(_charucoIds) {}
+
+    void operator()(const Range &range) const {
+        Ptr<CharucoBoard> currentBoard = board;
+        Ptr<Dictionary> dictionary = board->dictionary;
+
+        for(int i = range.start; i < range.end; i++) {
+            vector< vector< Point2f > > markerCorners;
+            vector< int > markerIds;
+            detectMarkers((*frames)[i], dictionary, markerCorners, markerIds, params);
+            if(markerIds.empty()) continue;
+            interpolateCornersCharuco(markerCorners, markerIds, (*frames)[i], currentBoard,
+                                      (*charucoCorners)[i], (*charucoIds)[i], cameraMatrix,
+                                      distCoeffs);
+        }
+    }
+
+    private:
+    CharucoFramesParallel &operator=(const CharucoFramesParallel &); // to quiet MSVC
+
+    const vector< Mat > *frames;
+    const Ptr<CharucoBoard> &board;
+    const Ptr<DetectorParameters> &params;
+    const Mat &cameraMatrix, &distCoeffs;
+    vector< Mat > *charucoCorners, *charucoIds;
+};
+
+
+// cells of the image grid used to measure the coverage of the views
+static const int COVERAGE_GRID_SIZE = 8;
+
+// minimum number of charuco corners of a view used for calibration
+static const int MIN_VIEW_CORNERS = 4;
+
+
+/**
+ */
+CharucoCalibrator::CharucoCalibrator(const Ptr<CharucoBoard> &_board,
+                                     const Ptr<DetectorParameters> &_params, int _maxViews,
+                                     int _batchSize)
+    : board(_board), params(_params), maxViews(_maxViews), batchSize(_batchSize),
+      coverage(COVERAGE_GRID_SIZE * COVERAGE_GRID_SIZE, 0) {
+
+    CV_Assert(!board.empty() && !params.empty());
+    CV_Assert(maxViews > 0 && batchSize > 0);
+}
+
+
+/**
+ */
+Ptr<CharucoCalibrator> CharucoCalibrator::create(const Ptr<CharucoBoard> &board,
+                                                 const Ptr<DetectorParameters> &params,
+                                                 int maxViews, int batchSize) {
+    return makePtr<CharucoCalibrator>(board, params, maxViews, batchSize);
+}
+
+
+/**
+ */
+void CharucoCalibrator::addFrame(InputArray image) {
+
+    CV_Assert(image.total() != 0);
+    if(imageSize == Size()) imageSize = image.size();
+    CV_Assert(image.size() == imageSize);
+
+    pendingFrames.push_back(image.getMat().clone());
+    if((int)pendingFrames.size() >= batchSize) processFrames();
+}
+
+
+/**
+ */
+int CharucoCalibrator::processFrames() {
+
+    int nFrames = (int)pendingFrames.size();
+    vector< Mat > charucoCorners(nFrames), charucoIds(nFrames);
+    parallel_for_(Range(0, nFrames),
+                  CharucoFramesParallel(&pendingFrames, board, params, cameraMatrix, distCoeffs,
+                                        &charucoCorners, &charucoIds));
+    pendingFrames.clear();
+
+    // the views are stored in the capture order, so the result does not depend on the threads
+    int added = 0;
+    for(int i = 0; i < nFrames; i++) {
+        if((int)charucoIds[i].total() < MIN_VIEW_CORNERS) continue;
+        if(addView(charucoCorners[i].reshape(2, (int)charucoCorners[i].total()),
+                   charucoIds[i].reshape(1, (int)charucoIds[i].total())))
+            added++;
+    }
+    return added;
+}
+
+
+/**
+ * @brief Cell of the coverage grid of a corner
+ */
+int CharucoCalibrator::getCoverageCell(const Point2f &corner) const {
+
+    int x = (int)(corner.x * COVERAGE_GRID_SIZE / imageSize.width);
+    int y = (int)(corner.y * COVERAGE_GRID_SIZE / imageSize.height);
+    x = min(max(x, 0), COVERAGE_GRID_SIZE - 1);
+    y = min(max(y, 0), COVERAGE_GRID_SIZE - 1);
+    return y * COVERAGE_GRID_SIZE + x;
+}
+
+
+/**
+ * @brief Coverage contribution of a view, each corner counts inversely to the number of stored
+ * corners in its cell. extraCount is added to the counts, 1 for a view not stored yet
+ */
+double CharucoCalibrator::getViewContribution(const Mat &corners, int extraCount) const {
+
+    double contribution = 0;
+    for(int i = 0; i < (int)corners.total(); i++)
+        contribution += 1. / (coverage[getCoverageCell(corners.at< Point2f >(i))] + extraCount);
+    return contribution;
+}
+
+
+/**
+ * @brief Store a view, replacing the least informative one if the store is full. Returns false
+ * if the view is discarded
+ */
+bool CharucoCalibrator::addView(const Mat &corners, const Mat &ids) {
+
+    if(getViewsNumber() == maxViews) {
+        int worstView = -1;
+        double worstContribution = DBL_MAX;
+        for(int v = 0; v < getViewsNumber(); v++) {
+            double contribution = getViewContribution(viewCorners[v], 0);
+            if(contribution < worstContribution) {
+                worstContribution = contribution;
+                worstView = v;
+            }
+        }
+        if(getViewContribution(corners, 1) <= worstContribution) return false;
+
+        for(int i = 0; i < (int)viewCorners[worstView].total(); i++)
+            coverage[getCoverageCell(viewCorners[worstView].at< Point2f >(i))]--;
+        viewCorners.erase(viewCorners.begin() + worstView);
+        viewIds.erase(viewIds.begin() + worstView);
+    }
+
+    for(int i = 0; i < (int)corners.total(); i++)
+        coverage[getCoverageCell(corners.at< Point2f >(i))]++;
+    viewCorners.push_back(corners);
+    viewIds.push_back(ids);
+    return true;
+}
+
+
+/**
+ */
+double CharucoCalibrator::calibrate(InputOutputArray _cameraMatrix, InputOutputArray _distCoeffs,
+                                    int flags, TermCriteria criteria) {
+
+    processFrames();
+    CV_Assert(getViewsNumber() > 0);
+
+    double error = calibrateCameraCharuco(viewCorners, viewIds, board, imageSize, _cameraMatrix,
+                                          _distCoeffs, noArray(), noArray(), flags, criteria);
+    _cameraMatrix.getMat().copyTo(cameraMatrix);
+    _distCoeffs.getMat().copyTo(distCoeffs);
+    return error;
+}
+
+
+/**
+ */
+void CharucoCalibrator::getViews(OutputArrayOfArrays _charucoCorners,
+                                 OutputArrayOfArrays _charucoIds) const {
+
+    _charucoCorners.create(getViewsNumber(), 1, CV_32FC2);
+    _charucoIds.create(getViewsNumber(), 1, CV_32SC1);
+    for(int v = 0; v < getViewsNumber(); v++) {
+        _charucoCorners.create((int)viewCorners[v].total(), 1, CV_32FC2, v, true);
+        viewCorners[v].copyTo(_charucoCorners.getMat(v));
+        _charucoIds.create((int)viewIds[v].total(), 1, CV_32SC1, v, true);
+        viewIds[v].copyTo(_charucoIds.getMat(v));
+    }
+}
+
+
 /**
  */
 void detectCharucoDiamond(InputArray _image, InputArrayOfArrays _markerCorners,
@@ -42,6 +42,9 @@ the use of this software, even if advised of the possibility of such damage.
 #include <opencv2/imgproc.hpp>
 #include "predefined_dictionaries.hpp"
 #include "opencv2/core/hal/hal.hpp"
+#include <opencv2/core/utility.hpp>
+#include <algorithm>
+#include <climits>
 
 namespace cv {
 namespace aruco {
@@ -49,6 +52,69 @@ namespace aruco {
 using namespace std;
 
 
+/**
+ * @brief Multi-index lookup tables of the dictionary markers. The bits of a marker are split in
+ * nChunks chunks, so any marker at a Hamming distance lower than nChunks from the candidate is
+ * equal to it in at least one of the chunks. Each chunk has a table with the chunk values of all
+ * the markers in their 4 rotations, sorted by value.
+ */
+struct DictionaryIndex {
+    typedef pair< uint64, int > Entry; // chunk value, marker * 4 + rotation
+
+    DictionaryIndex(const Mat &bytesList, int markerSize, int nChunks);
+
+    bool isValidFor(const Mat &bytesList, int _markerSize) const {
+        return bytesList.data == data && bytesList.rows == rows && bytesList.cols == cols &&
+               _markerSize == markerSize;
+    }
+
+    // value of the bits [begin, end) of the codeword, the bits are numbered as in
+    // getByteListFromBits
+    static uint64 chunkValue(const uchar *bytes, int nbits, int begin, int end) {
+        uint64 value = 0;
+        for(int k = begin; k < end; k++) {
+            int byte = k >> 3;
+            int bitsInByte = min(8, nbits - (byte << 3));
+            value = (value << 1) | ((bytes[byte] >> (bitsInByte - 1 - (k & 7))) & 1);
+        }
+        return value;
+    }
+
+    const uchar *data;
+    int rows, cols, markerSize;
+    vector< int > chunkStart; // first bit of each chunk, and the number of bits at the end
+    vector< vector< Entry > > tables;
+};
+
+
+DictionaryIndex::DictionaryIndex(const Mat &bytesList, int _markerSize, int nChunks)
+    : data(bytesList.data), rows(bytesList.rows), cols(bytesList.cols), markerSize(_markerSize) {
+
+    int nbits = markerSize * markerSize;
+    CV_Assert(nChunks > 0 && nChunks <= nbits && nbits <= 64 * nChunks);
+
+    chunkStart.resize(nChunks + 1);
+    for(int c = 0; c <= nChunks; c++)
+        chunkStart[c] = c * nbits / nChunks;
+
+    int nbytes = bytesList.cols;
+    tables.resize(nChunks);
+    for(int c = 0; c < nChunks; c++) {
+        tables[c].reserve(4 * rows);
+        for(int m = 0; m < rows; m++)
+            for(int r = 0; r < 4; r++)
+                tables[c].push_back(Entry(chunkValue(bytesList.ptr(m) + r * nbytes, nbits,
+                                                     chunkStart[c], chunkStart[c + 1]),
+                                          m * 4 + r));
+        sort(tables[c].begin(), tables[c].end());
+    }
+}
+
+
+// protects the creation of the lookup tables of all the dictionaries
+static Mutex dictionaryIndexMutex;
+
+
 /**
   */
 Dictionary::Dictionary(const Ptr<Dictionary> &_dictionary) {
@@ -90,6 +156,42 @@ Ptr<Dictionary> Dictionary::get(int dict) {
 }
 
 
+/**
+ * @brief Lookup tables with nChunks chunks for the current bytesList, built if needed
+ */
+Ptr<DictionaryIndex> Dictionary::getIndex(int nChunks) const {
+
+    AutoLock lock(dictionaryIndexMutex);
+    if((int)indexes.size() <= nChunks) indexes.resize(nChunks + 1);
+    Ptr<DictionaryIndex> &index = indexes[nChunks];
+    if(index.empty() || !index->isValidFor(bytesList, markerSize))
+        index = makePtr<DictionaryIndex>(bytesList, markerSize, nChunks);
+    return index;
+}
+
+
+/**
+ * @brief Minimum distance of the candidate to the marker m in its 4 rotations
+ */
+static int _getMarkerDistance(const Mat &bytesList, int m, const Mat &candidateBytes,
+                              int &rotation) {
+
+    int minDistance = INT_MAX;
+    for(unsigned int r = 0; r < 4; r++) {
+        int currentHamming = cv::hal::normHamming(
+                bytesList.ptr(m)+r*candidateBytes.cols,
+                candidateBytes.ptr(),
+                candidateBytes.cols);
+
+        if(currentHamming < minDistance) {
+            minDistance = currentHamming;
+            rotation = r;
+        }
+    }
+    return minDistance;
+}
+
+
 /**
  */
 bool Dictionary::identify(const Mat &onlyBits, int &idx, int &rotation,
@@ -104,27 +206,46 @@ bool Dictionary::identify(const Mat &onlyBits, int &idx, int &rotation,
 
     idx = -1; // by default, not found
 
-    // search closest marker in dict
-    for(int m = 0; m < bytesList.rows; m++) {
-        int currentMinDistance = markerSize * markerSize + 1;
-        int currentRotation = -1;
-        for(unsigned int r = 0; r < 4; r++) {
-            int currentHamming = cv::hal::normHamming(
-                    bytesList.ptr(m)+r*candidateBytes.cols,
-                    candidateBytes.ptr(),
-                    candidateBytes.cols);
-
-            if(currentHamming < currentMinDistance) {
-                currentMinDistance = currentHamming;
-                currentRotation = r;
+    // a marker within the correction distance is equal to the candidate in one of the chunks
+    int nbits = markerSize * markerSize;
+    int nChunks = maxCorrectionRecalculed + 1;
+    if(maxCorrectionRecalculed < 0 || nChunks > nbits || nbits > 64 * nChunks) {
+        // search the first marker in dict within the correction distance
+        for(int m = 0; m < bytesList.rows; m++) {
+            int currentRotation = -1;
+            int currentMinDistance = _getMarkerDistance(bytesList, m, candidateBytes,
+                                                        currentRotation);
+
+            // if maxCorrection is fullfilled, return this one
+            if(currentMinDistance <= maxCorrectionRecalculed) {
+                idx = m;
+                rotation = currentRotation;
+                break;
             }
         }
+        return idx != -1;
+    }
 
-        // if maxCorrection is fullfilled, return this one
-        if(currentMinDistance <= maxCorrectionRecalculed) {
-            idx = m;
-            rotation = currentRotation;
-            break;
+    // look up the markers matching a chunk, the one with the lowest id is taken as in the
+    // linear search
+    Ptr<DictionaryIndex> index = getIndex(nChunks);
+    for(int c = 0; c < nChunks; c++) {
+        DictionaryIndex::Entry key(DictionaryIndex::chunkValue(candidateBytes.ptr(), nbits,
+                                                               index->chunkStart[c],
+                                                               index->chunkStart[c + 1]), -1);
+        const vector< DictionaryIndex::Entry > &table = index->tables[c];
+        vector< DictionaryIndex::Entry >::const_iterator it =
+            lower_bound(table.begin(), table.end(), key);
+        for(; it != table.end() && it->first == key.first; ++it) {
+            int m = it->second / 4;
+            if(idx != -1 && m >= idx) continue;
+
+            int currentRotation = -1;
+            if(_getMarkerDistance(bytesList, m, candidateBytes, currentRotation) <=
+               maxCorrectionRecalculed) {
+                idx = m;
+                rotation = currentRotation;
+            }
         }
     }
 
@@ -358,22 +479,130 @@ static Mat _generateRandomMarker(int markerSize) {
 }
 
 /**
- * @brief Calculate selfDistance of the codification of a marker Mat. Self distance is the Hamming
+ * @brief Codewords of markers in their 4 rotations, packed in 64 bits words so that the Hamming
+ * distances are popcounts of whole words
+ */
+struct PackedMarkers {
+    explicit PackedMarkers(int markerSize) : nWords((markerSize * markerSize + 63) / 64) {}
+
+    int size() const { return (int)(words.size() / (4 * nWords)); }
+
+    void resize(int nMarkers) { words.resize((size_t)nMarkers * 4 * nWords); }
+
+    // sets the marker m from its row of a bytesList
+    void set(int m, const uchar *bytes, int nbytes) {
+        uint64 *dst = &words[(size_t)m * 4 * nWords];
+        for(int r = 0; r < 4; r++) {
+            for(int w = 0; w < nWords; w++) dst[r * nWords + w] = 0;
+            for(int b = 0; b < nbytes; b++)
+                dst[r * nWords + b / 8] |= (uint64)bytes[r * nbytes + b] << (8 * (b % 8));
+        }
+    }
+
+    void push_back(const Mat &bytes) {
+        resize(size() + 1);
+        set(size() - 1, bytes.ptr(), bytes.cols);
+    }
+
+    const uint64 *ptr(int m, int rotation = 0) const {
+        return &words[((size_t)m * 4 + rotation) * nWords];
+    }
+
+    int nWords;
+    vector< uint64 > words;
+};
+
+
+static inline int _popcount64(uint64 x) {
+#if defined __GNUC__
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & CV_BIG_UINT(0x5555555555555555));
+    x = (x & CV_BIG_UINT(0x3333333333333333)) + ((x >> 2) & CV_BIG_UINT(0x3333333333333333));
+    x = (x + (x >> 4)) & CV_BIG_UINT(0x0f0f0f0f0f0f0f0f);
+    return (int)((x * CV_BIG_UINT(0x0101010101010101)) >> 56);
+#endif
+}
+
+
+static inline int _getHammingPacked(const uint64 *a, const uint64 *b, int nWords) {
+    int distance = 0;
+    for(int w = 0; w < nWords; w++)
+        distance += _popcount64(a[w] ^ b[w]);
+    return distance;
+}
+
+
+/**
+ * @brief Calculate selfDistance of the codification of a marker. Self distance is the Hamming
  * distance of the marker to itself in the other rotations.
  * See S. Garrido-Jurado, R. Muñoz-Salinas, F. J. Madrid-Cuevas, and M. J. Marín-Jiménez. 2014.
  * "Automatic generation and detection of highly reliable fiducial markers under occlusion".
  * Pattern Recogn. 47, 6 (June 2014), 2280-2292. DOI=10.1016/j.patcog.2014.01.005
  */
-static int _getSelfDistance(const Mat &marker) {
-    Mat bytes = Dictionary::getByteListFromBits(marker);
-    int minHamming = (int)marker.total() + 1;
+static int _getSelfDistance(const PackedMarkers &markers, int m, int markerSize) {
+    int minHamming = markerSize * markerSize + 1;
     for(int r = 1; r < 4; r++) {
-        int currentHamming = cv::hal::normHamming(bytes.ptr(), bytes.ptr() + bytes.cols*r, bytes.cols);
+        int currentHamming = _getHammingPacked(markers.ptr(m), markers.ptr(m, r), markers.nWords);
         if(currentHamming < minHamming) minHamming = currentHamming;
     }
     return minHamming;
 }
 
+
+/**
+ * @brief Minimum of minDistance and of the distances of the candidate to the markers [begin, end)
+ * in their 4 rotations. The search stops as soon as the minimum is not higher than threshold, so
+ * the result is exact only when it is higher than threshold.
+ */
+static int _getMinMarkerDistance(const PackedMarkers &markers, int begin, int end,
+                                 const uint64 *candidate, int minDistance, int threshold) {
+    for(int i = begin; i < end && minDistance > threshold; i++)
+        for(int r = 0; r < 4; r++)
+            minDistance = min(minDistance, _getHammingPacked(markers.ptr(i, r), candidate,
+                                                             markers.nWords));
+    return minDistance;
+}
+
+
+/**
+  * ParallelLoopBody class for the evaluation of a batch of random candidates of
+  * generateCustomDictionary(). Each candidate gets its distance to the nAccepted first markers,
+  * which is only exact when it is higher than threshold.
+  */
+class CandidateDistancesParallel : public ParallelLoopBody {
+    public:
+    CandidateDistancesParallel(const vector< Mat > *_candidateBits, vector< Mat > *_candidateBytes,
+                               PackedMarkers *_candidates, const PackedMarkers *_markers,
+                               int _nAccepted, int _markerSize, int _threshold,
+                               vector< int > *_distances)
+        : candidateBits(_candidateBits), candidateBytes(_candidateBytes), candidates(_candidates),
+          markers(_markers), nAccepted(_nAccepted), markerSize(_markerSize),
+          threshold(_threshold), distances(_distances) {}
+
+    void operator()(const Range &range) const {
+        for(int i = range.start; i < range.end; i++) {
+            Mat &bytes = (*candidateBytes)[i];
+            bytes = Dictionary::getByteListFromBits((*candidateBits)[i]);
+            candidates->set(i, bytes.ptr(), bytes.cols);
+
+            // the distance to the other markers is only needed if the self distance is enough
+            int selfDistance = _getSelfDistance(*candidates, i, markerSize);
+            (*distances)[i] = _getMinMarkerDistance(*markers, 0, nAccepted, candidates->ptr(i),
+                                                    selfDistance, threshold);
+        }
+    }
+
+    private:
+    const vector< Mat > *candidateBits;
+    vector< Mat > *candidateBytes;
+    PackedMarkers *candidates;
+    const PackedMarkers *markers;
+    int nAccepted, markerSize, threshold;
+    vector< int > *distances;
+};
+
+
 /**
  */
 Ptr<Dictionary> generateCustomDictionary(int nMarkers, int markerSize,
@@ -389,19 +618,21 @@ Ptr<Dictionary> generateCustomDictionary(int nMarkers, int markerSize,
     int C = (int)std::floor(float(markerSize * markerSize) / 4.f);
     int tau = 2 * (int)std::floor(float(C) * 4.f / 3.f);
 
+    // accepted markers, packed for the distance computations
+    PackedMarkers markers(markerSize);
+
     // if baseDictionary is provided, calculate its intermarker distance
     if(baseDictionary->bytesList.rows > 0) {
         CV_Assert(baseDictionary->markerSize == markerSize);
         out->bytesList = baseDictionary->bytesList.clone();
+        for(int i = 0; i < out->bytesList.rows; i++)
+            markers.push_back(out->bytesList.row(i));
 
         int minDistance = markerSize * markerSize + 1;
         for(int i = 0; i < out->bytesList.rows; i++) {
-            Mat markerBytes = out->bytesList.rowRange(i, i + 1);
-            Mat markerBits = Dictionary::getBitsFromByteList(markerBytes, markerSize);
-            minDistance = min(minDistance, _getSelfDistance(markerBits));
-            for(int j = i + 1; j < out->bytesList.rows; j++) {
-                minDistance = min(minDistance, out->getDistanceToId(markerBits, j));
-            }
+            minDistance = min(minDistance, _getSelfDistance(markers, i, markerSize));
+            minDistance = _getMinMarkerDistance(markers, i + 1, out->bytesList.rows,
+                                                markers.ptr(i), minDistance, -1);
         }
         tau = minDistance;
     }
@@ -414,46 +645,65 @@ Ptr<Dictionary> generateCustomDictionary(int nMarkers, int markerSize,
     const int maxUnproductiveIterations = 5000;
     int unproductiveIterations = 0;
 
-    while(out->bytesList.rows < nMarkers) {
-        Mat currentMarker = _generateRandomMarker(markerSize);
-
-        int selfDistance = _getSelfDistance(currentMarker);
-        int minDistance = selfDistance;
-
-        // if self distance is better or equal than current best option, calculate distance
-        // to previous accepted markers
-        if(selfDistance >= bestTau) {
-            for(int i = 0; i < out->bytesList.rows; i++) {
-                int currentDistance = out->getDistanceToId(currentMarker, i);
-                minDistance = min(currentDistance, minDistance);
-                if(minDistance <= bestTau) {
-                    break;
-                }
-            }
-        }
-
-        // if distance is high enough, accept the marker
-        if(minDistance >= tau) {
-            unproductiveIterations = 0;
-            bestTau = 0;
-            Mat bytes = Dictionary::getByteListFromBits(currentMarker);
-            out->bytesList.push_back(bytes);
-        } else {
-            unproductiveIterations++;
-
-            // if distance is not enough, but is better than the current best option
-            if(minDistance > bestTau) {
-                bestTau = minDistance;
-                bestMarker = currentMarker;
-            }
+    // The candidates are drawn in batches, whose distances to the markers accepted before the
+    // batch are computed in parallel. They are then taken in order as if they were drawn one by
+    // one, so the dictionary only depends on the sequence of rand(), not on the batches.
+    const int batchSize = 1024;
+    vector< Mat > candidateBits(batchSize), candidateBytes(batchSize);
+    PackedMarkers candidates(markerSize);
+    candidates.resize(batchSize);
+    vector< int > distances(batchSize);
 
-            // if number of unproductive iterarions has been reached, accept the current best option
-            if(unproductiveIterations == maxUnproductiveIterations) {
+    while(out->bytesList.rows < nMarkers) {
+        for(int i = 0; i < batchSize; i++)
+            candidateBits[i] = _generateRandomMarker(markerSize);
+
+        const int nAccepted = markers.size();
+        const int threshold = bestTau;
+        parallel_for_(Range(0, batchSize),
+                      CandidateDistancesParallel(&candidateBits, &candidateBytes, &candidates,
+                                                 &markers, nAccepted, markerSize, threshold,
+                                                 &distances));
+
+        for(int i = 0; i < batchSize && out->bytesList.rows < nMarkers; i++) {
+            const uint64 *candidate = candidates.ptr(i);
+            int minDistance = distances[i];
+
+            // the distance is not exact when the best option has been reset in this batch, but
+            // the candidate is rejected anyway when it is not higher than the best option
+            if(minDistance <= threshold && minDistance > bestTau)
+                minDistance = _getMinMarkerDistance(markers, 0, nAccepted, candidate,
+                                                    _getSelfDistance(candidates, i, markerSize),
+                                                    bestTau);
+
+            // distance to the markers accepted in this batch
+            minDistance = _getMinMarkerDistance(markers, nAccepted, markers.size(), candidate,
+                                                minDistance, bestTau);
+
+            // if distance is high enough, accept the marker
+            if(minDistance >= tau) {
                 unproductiveIterations = 0;
-                tau = bestTau;
                 bestTau = 0;
-                Mat bytes = Dictionary::getByteListFromBits(bestMarker);
-                out->bytesList.push_back(bytes);
+                out->bytesList.push_back(candidateBytes[i]);
+                markers.push_back(candidateBytes[i]);
+            } else {
+                unproductiveIterations++;
+
+                // if distance is not enough, but is better than the current best option
+                if(minDistance > bestTau) {
+                    bestTau = minDistance;
+                    bestMarker = candidateBytes[i];
+                }
+
+                // if number of unproductive iterarions has been reached, accept the current best
+                // option
+                if(unproductiveIterations == maxUnproductiveIterations) {
+                    unproductiveIterations = 0;
+                    tau = bestTau;
+                    bestTau = 0;
+                    out->bytesList.push_back(bestMarker);
+                    markers.push_back(bestMarker);
+                }
             }
         }
     }
@@ -234,6 +234,199 @@ static Mat projectMarker(Ptr<aruco::Dictionary> &dictionary, int id, Mat cameraM
 
 
 
+/**
+ * @brief Draw a grid of 2D synthetic markers with an offset, and store their corners and ids
+ */
+static Mat drawMarkersGrid(Ptr<aruco::Dictionary> &dictionary, int firstId, int markerSidePixels,
+                           Point offset, vector< vector< Point2f > > &groundTruthCorners,
+                           vector< int > &groundTruthIds) {
+
+    int imageSize = markerSidePixels * 2 + 3 * (markerSidePixels / 2) + 20;
+    Mat img = Mat(imageSize, imageSize, CV_8UC1, Scalar::all(255));
+    groundTruthCorners.clear();
+    groundTruthIds.clear();
+    for(int y = 0; y < 2; y++) {
+        for(int x = 0; x < 2; x++) {
+            Mat marker;
+            int id = firstId + y * 2 + x;
+            aruco::drawMarker(dictionary, id, markerSidePixels, marker);
+            Point2f firstCorner =
+                Point2f(markerSidePixels / 2.f + x * (1.5f * markerSidePixels) + offset.x,
+                        markerSidePixels / 2.f + y * (1.5f * markerSidePixels) + offset.y);
+            Mat aux = img.colRange((int)firstCorner.x, (int)firstCorner.x + markerSidePixels)
+                          .rowRange((int)firstCorner.y, (int)firstCorner.y + markerSidePixels);
+            marker.copyTo(aux);
+            groundTruthIds.push_back(id);
+            groundTruthCorners.push_back(vector< Point2f >());
+            groundTruthCorners.back().push_back(firstCorner);
+            groundTruthCorners.back().push_back(firstCorner + Point2f(markerSidePixels - 1, 0));
+            groundTruthCorners.back().push_back(
+                firstCorner + Point2f(markerSidePixels - 1, markerSidePixels - 1));
+            groundTruthCorners.back().push_back(firstCorner + Point2f(0, markerSidePixels - 1));
+        }
+    }
+    return img;
+}
+
+
+/**
+ * @brief Return false if some ground truth marker is not detected or its corners are farther
+ * than maxDist
+ */
+static bool checkDetectedMarkers(const vector< vector< Point2f > > &groundTruthCorners,
+                                 const vector< int > &groundTruthIds,
+                                 const vector< vector< Point2f > > &corners, const vector< int > &ids,
+                                 double maxDist) {
+
+    if(ids.size() != groundTruthIds.size()) return false;
+    for(unsigned int m = 0; m < groundTruthIds.size(); m++) {
+        int idx = -1;
+        for(unsigned int k = 0; k < ids.size(); k++) {
+            if(groundTruthIds[m] == ids[k]) {
+                idx = (int)k;
+                break;
+            }
+        }
+        if(idx == -1) return false;
+        for(int c = 0; c < 4; c++) {
+            if(norm(groundTruthCorners[m][c] - corners[idx][c]) > maxDist) return false;
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Detect markers in a downscaled image and refine them at full resolution
+ */
+class CV_ArucoDetectionDownscaled : public cvtest::BaseTest {
+    public:
+    CV_ArucoDetectionDownscaled();
+
+    protected:
+    void run(int);
+};
+
+
+CV_ArucoDetectionDownscaled::CV_ArucoDetectionDownscaled() {}
+
+
+void CV_ArucoDetectionDownscaled::run(int) {
+
+    Ptr<aruco::Dictionary> dictionary = aruco::getPredefinedDictionary(aruco::DICT_6X6_250);
+
+    for(int i = 0; i < 10; i++) {
+        vector< vector< Point2f > > groundTruthCorners;
+        vector< int > groundTruthIds;
+        Mat img = drawMarkersGrid(dictionary, i * 4, 100, Point(i, 2 * i), groundTruthCorners,
+                                  groundTruthIds);
+
+        vector< vector< Point2f > > corners;
+        vector< int > ids;
+        Ptr<aruco::DetectorParameters> params = aruco::DetectorParameters::create();
+        params->detectionImageScale = 0.5;
+        aruco::detectMarkers(img, dictionary, corners, ids, params);
+
+        if(!checkDetectedMarkers(groundTruthCorners, groundTruthIds, corners, ids, 1.5)) {
+            ts->printf(cvtest::TS::LOG, "Incorrect markers detected in the downscaled image");
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+}
+
+
+/**
+ * @brief Detect markers only around the markers of the previous frame
+ */
+class CV_ArucoDetectionTracking : public cvtest::BaseTest {
+    public:
+    CV_ArucoDetectionTracking();
+
+    protected:
+    void run(int);
+};
+
+
+CV_ArucoDetectionTracking::CV_ArucoDetectionTracking() {}
+
+
+void CV_ArucoDetectionTracking::run(int) {
+
+    Ptr<aruco::Dictionary> dictionary = aruco::getPredefinedDictionary(aruco::DICT_6X6_250);
+    Ptr<aruco::DetectorParameters> params = aruco::DetectorParameters::create();
+
+    vector< vector< Point2f > > groundTruthCorners, corners;
+    vector< int > groundTruthIds, ids;
+
+    // without previous markers the whole image is searched
+    Mat img = drawMarkersGrid(dictionary, 0, 100, Point(0, 0), groundTruthCorners, groundTruthIds);
+    aruco::trackMarkers(img, dictionary, corners, corners, ids, params);
+    if(!checkDetectedMarkers(groundTruthCorners, groundTruthIds, corners, ids, 0.001)) {
+        ts->printf(cvtest::TS::LOG, "Incorrect markers detected without previous markers");
+        ts->set_failed_test_info(cvtest::TS::FAIL_MISMATCH);
+        return;
+    }
+
+    // the markers move a few pixels every frame
+    for(int i = 1; i < 10; i++) {
+        img = drawMarkersGrid(dictionary, 0, 100, Point(2 * i, i), groundTruthCorners,
+                              groundTruthIds);
+        vector< vector< Point2f > > previousCorners = corners;
+        aruco::trackMarkers(img, dictionary, previousCorners, corners, ids, params);
+        if(!checkDetectedMarkers(groundTruthCorners, groundTruthIds, corners, ids, 0.001)) {
+            ts->printf(cvtest::TS::LOG, "Incorrect markers tracked");
+            ts->set_failed_test_info(cvtest::TS::FAIL_MISMATCH);
+            return;
+        }
+    }
+}
+
+
+/**
+ * @brief Detect markers from a UMat, with OpenCL if available
+ */
+class CV_ArucoDetectionUMat : public cvtest::BaseTest {
+    public:
+    CV_ArucoDetectionUMat();
+
+    protected:
+    void run(int);
+};
+
+
+CV_ArucoDetectionUMat::CV_ArucoDetectionUMat() {}
+
+
+void CV_ArucoDetectionUMat::run(int) {
+
+    Ptr<aruco::Dictionary> dictionary = aruco::getPredefinedDictionary(aruco::DICT_6X6_250);
+
+    for(int i = 0; i < 10; i++) {
+        vector< vector< Point2f > > groundTruthCorners;
+        vector< int > groundTruthIds;
+        Mat img = drawMarkersGrid(dictionary, i * 4, 100, Point(i, i), groundTruthCorners,
+                                  groundTruthIds);
+        if(i % 2 == 1) cvtColor(img, img, COLOR_GRAY2BGR);
+        UMat uimg;
+        img.copyTo(uimg);
+
+        vector< vector< Point2f > > corners;
+        vector< int > ids;
+        Ptr<aruco::DetectorParameters> params = aruco::DetectorParameters::create();
+        params->detectionImageScale = (i < 5) ? 1. : 0.5;
+        aruco::detectMarkers(uimg, dictionary, corners, ids, params);
+
+        if(!checkDetectedMarkers(groundTruthCorners, groundTruthIds, corners, ids,
+                                 (i < 5) ? 0.001 : 1.5)) {
+            ts->printf(cvtest::TS::LOG, "Incorrect markers detected from a UMat");
+            ts->set_failed_test_info(cvtest::TS::FAIL_MISMATCH);
+            return;
+        }
+    }
+}
+
+
 /**
  * @brief Draws markers in perspective and detect them
  */
@@ -488,11 +681,186 @@ void CV_ArucoBitCorrection::run(int) {
 
 
 
+/**
+ * @brief Check the dictionary lookup against the distance to every marker
+ */
+class CV_ArucoDictionaryIdentify : public cvtest::BaseTest {
+    public:
+    CV_ArucoDictionaryIdentify();
+
+    protected:
+    void run(int);
+};
+
+
+CV_ArucoDictionaryIdentify::CV_ArucoDictionaryIdentify() {}
+
+
+void CV_ArucoDictionaryIdentify::run(int) {
+
+    const int dictionaries[] = { aruco::DICT_4X4_50, aruco::DICT_6X6_1000, aruco::DICT_7X7_250,
+                                 aruco::DICT_ARUCO_ORIGINAL };
+    const double rates[] = { 0., 0.6, 1. };
+    RNG rng(0);
+
+    for(int d = 0; d < 4; d++) {
+        Ptr<aruco::Dictionary> dictionary = aruco::getPredefinedDictionary(dictionaries[d]);
+        int markerSize = dictionary->markerSize;
+        for(int r = 0; r < 3; r++) {
+            int maxCorrection = int(double(dictionary->maxCorrectionBits) * rates[r]);
+            for(int i = 0; i < 200; i++) {
+                // a marker with some flipped bits, or random bits
+                Mat bits;
+                if(i % 4 != 3) {
+                    int id = rng.uniform(0, dictionary->bytesList.rows);
+                    bits = aruco::Dictionary::getBitsFromByteList(
+                        dictionary->bytesList.rowRange(id, id + 1), markerSize);
+                    int nFlips = rng.uniform(0, maxCorrection + 2);
+                    for(int f = 0; f < nFlips; f++) {
+                        uchar &bit = bits.at< uchar >(rng.uniform(0, markerSize),
+                                                      rng.uniform(0, markerSize));
+                        bit = 1 - bit;
+                    }
+                } else {
+                    bits.create(markerSize, markerSize, CV_8UC1);
+                    rng.fill(bits, RNG::UNIFORM, 0, 2);
+                }
+
+                int expectedId = -1;
+                for(int m = 0; m < dictionary->bytesList.rows && expectedId == -1; m++)
+                    if(dictionary->getDistanceToId(bits, m) <= maxCorrection) expectedId = m;
+
+                int idx, rotation;
+                bool found = dictionary->identify(bits, idx, rotation, rates[r]);
+                if(found != (expectedId != -1) || (found && idx != expectedId)) {
+                    ts->printf(cvtest::TS::LOG, "Error in Dictionary::identify");
+                    ts->set_failed_test_info(cvtest::TS::FAIL_MISMATCH);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+
+
+/**
+ * @brief Check the closed-form and warm started single marker pose estimation
+ */
+class CV_ArucoPoseEstimation : public cvtest::BaseTest {
+    public:
+    CV_ArucoPoseEstimation();
+
+    protected:
+    void run(int);
+};
+
+
+CV_ArucoPoseEstimation::CV_ArucoPoseEstimation() {}
+
+
+static bool isSamePose(const Vec3d &rvec, const Vec3d &tvec, const Mat &rvecGt, const Mat &tvecGt,
+                       double distance) {
+    Mat R, RGt;
+    Rodrigues(rvec, R);
+    Rodrigues(rvecGt, RGt);
+    return norm(R, RGt, NORM_INF) < 1e-2 && norm(Mat(tvec), tvecGt, NORM_INF) < 1e-2 * distance;
+}
+
+
+void CV_ArucoPoseEstimation::run(int) {
+
+    Mat cameraMatrix = Mat::eye(3, 3, CV_64FC1);
+    Size imgSize(500, 500);
+    cameraMatrix.at< double >(0, 0) = cameraMatrix.at< double >(1, 1) = 650;
+    cameraMatrix.at< double >(0, 2) = imgSize.width / 2;
+    cameraMatrix.at< double >(1, 2) = imgSize.height / 2;
+    Mat distCoeffs(5, 1, CV_64FC1, Scalar::all(0));
+    distCoeffs.at< double >(0) = -0.1;
+
+    const float markerLength = 0.05f;
+    vector< Point3f > objPoints;
+    objPoints.push_back(Point3f(-markerLength / 2.f, markerLength / 2.f, 0));
+    objPoints.push_back(Point3f(markerLength / 2.f, markerLength / 2.f, 0));
+    objPoints.push_back(Point3f(markerLength / 2.f, -markerLength / 2.f, 0));
+    objPoints.push_back(Point3f(-markerLength / 2.f, -markerLength / 2.f, 0));
+
+    // one marker per pose, all estimated in the same call
+    vector< vector< Point2f > > corners;
+    vector< Mat > rvecsGt, tvecsGt;
+    vector< double > distances;
+    for(double distance = 0.1; distance <= 0.5; distance += 0.2) {
+        for(int pitch = 0; pitch < 360; pitch += 60) {
+            for(int yaw = 30; yaw <= 90; yaw += 50) {
+                Mat rvec, tvec;
+                getSyntheticRT(deg2rad(yaw), deg2rad(pitch), distance, rvec, tvec);
+                vector< Point2f > markerCorners;
+                projectPoints(objPoints, rvec, tvec, cameraMatrix, distCoeffs, markerCorners);
+                corners.push_back(markerCorners);
+                rvecsGt.push_back(rvec);
+                tvecsGt.push_back(tvec);
+                distances.push_back(distance);
+            }
+        }
+    }
+
+    vector< Vec3d > rvecs, tvecs;
+    aruco::estimatePoseSingleMarkers(corners, markerLength, cameraMatrix, distCoeffs, rvecs, tvecs,
+                                     aruco::POSE_PLANAR_CLOSED_FORM);
+    for(unsigned int i = 0; i < corners.size(); i++) {
+        if(!isSamePose(rvecs[i], tvecs[i], rvecsGt[i], tvecsGt[i], distances[i])) {
+            ts->printf(cvtest::TS::LOG, "Incorrect closed-form marker pose");
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+
+    // warm start from a perturbed pose, the last marker has no guess
+    for(unsigned int i = 0; i < corners.size(); i++) {
+        rvecs[i] = Vec3d(rvecsGt[i].ptr< double >()) + Vec3d(0.05, -0.05, 0.02);
+        tvecs[i] = Vec3d(tvecsGt[i].ptr< double >()) * 1.1;
+    }
+    tvecs.back() = Vec3d(0, 0, 0);
+    for(int closedForm = 0; closedForm < 2; closedForm++) {
+        vector< Vec3d > currentRvecs = rvecs, currentTvecs = tvecs;
+        int flags = aruco::POSE_USE_EXTRINSIC_GUESS;
+        if(closedForm) flags |= aruco::POSE_PLANAR_CLOSED_FORM;
+        aruco::estimatePoseSingleMarkers(corners, markerLength, cameraMatrix, distCoeffs,
+                                         currentRvecs, currentTvecs, flags);
+        for(unsigned int i = 0; i < corners.size(); i++) {
+            if(!isSamePose(currentRvecs[i], currentTvecs[i], rvecsGt[i], tvecsGt[i],
+                           distances[i])) {
+                ts->printf(cvtest::TS::LOG, "Incorrect warm started marker pose");
+                ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+                return;
+            }
+        }
+    }
+}
+
+
+
+
 TEST(CV_ArucoDetectionSimple, algorithmic) {
     CV_ArucoDetectionSimple test;
     test.safe_run();
 }
 
+TEST(CV_ArucoDetectionDownscaled, algorithmic) {
+    CV_ArucoDetectionDownscaled test;
+    test.safe_run();
+}
+
+TEST(CV_ArucoDetectionTracking, algorithmic) {
+    CV_ArucoDetectionTracking test;
+    test.safe_run();
+}
+
+TEST(CV_ArucoDetectionUMat, algorithmic) {
+    CV_ArucoDetectionUMat test;
+    test.safe_run();
+}
+
 TEST(CV_ArucoDetectionPerspective, algorithmic) {
     CV_ArucoDetectionPerspective test;
     test.safe_run();
@@ -503,7 +871,106 @@ TEST(CV_ArucoDetectionMarkerSize, algorithmic) {
     test.safe_run();
 }
 
+TEST(CV_ArucoDictionaryIdentify, algorithmic) {
+    CV_ArucoDictionaryIdentify test;
+    test.safe_run();
+}
+
 TEST(CV_ArucoBitCorrection, algorithmic) {
     CV_ArucoBitCorrection test;
     test.safe_run();
 }
+
+TEST(CV_ArucoPoseEstimation, algorithmic) {
+    CV_ArucoPoseEstimation test;
+    test.safe_run();
+}
+
+
+static int referenceSelfDistance(const Mat &bits) {
+    Mat bytes = aruco::Dictionary::getByteListFromBits(bits);
+    int nbytes = bytes.cols, minDistance = (int)bits.total() + 1;
+    for(int r = 1; r < 4; r++)
+        minDistance = min(minDistance, (int)norm(Mat(1, nbytes, CV_8U, bytes.ptr()),
+                                                 Mat(1, nbytes, CV_8U, bytes.ptr() + r * nbytes),
+                                                 NORM_HAMMING));
+    return minDistance;
+}
+
+/**
+ * @brief Custom dictionary generated one candidate at a time, as defined in
+ * generateCustomDictionary()
+ */
+static Ptr<aruco::Dictionary> referenceCustomDictionary(int nMarkers, int markerSize,
+                                                        const Ptr<aruco::Dictionary> &base) {
+    Ptr<aruco::Dictionary> out = makePtr<aruco::Dictionary>();
+    out->markerSize = markerSize;
+    int C = (int)std::floor(float(markerSize * markerSize) / 4.f);
+    int tau = 2 * (int)std::floor(float(C) * 4.f / 3.f);
+
+    if(base->bytesList.rows > 0) {
+        out->bytesList = base->bytesList.clone();
+        int minDistance = markerSize * markerSize + 1;
+        for(int i = 0; i < out->bytesList.rows; i++) {
+            Mat bits = aruco::Dictionary::getBitsFromByteList(out->bytesList.row(i), markerSize);
+            minDistance = min(minDistance, referenceSelfDistance(bits));
+            for(int j = i + 1; j < out->bytesList.rows; j++)
+                minDistance = min(minDistance, out->getDistanceToId(bits, j));
+        }
+        tau = minDistance;
+    }
+
+    int bestTau = 0, unproductiveIterations = 0;
+    Mat bestMarker;
+    while(out->bytesList.rows < nMarkers) {
+        Mat marker(markerSize, markerSize, CV_8UC1);
+        for(int i = 0; i < markerSize; i++)
+            for(int j = 0; j < markerSize; j++)
+                marker.at< uchar >(i, j) = (uchar)(rand() % 2);
+
+        Mat bytes = aruco::Dictionary::getByteListFromBits(marker);
+        int minDistance = referenceSelfDistance(marker);
+        for(int i = 0; i < out->bytesList.rows; i++)
+            minDistance = min(minDistance, out->getDistanceToId(marker, i));
+
+        if(minDistance >= tau) {
+            unproductiveIterations = 0;
+            bestTau = 0;
+            out->bytesList.push_back(bytes);
+        } else {
+            unproductiveIterations++;
+            if(minDistance > bestTau) {
+                bestTau = minDistance;
+                bestMarker = bytes;
+            }
+            if(unproductiveIterations == 5000) {
+                unproductiveIterations = 0;
+                tau = bestTau;
+                bestTau = 0;
+                out->bytesList.push_back(bestMarker);
+            }
+        }
+    }
+    out->maxCorrectionBits = (tau - 1) / 2;
+    return out;
+}
+
+TEST(CV_ArucoCustomDictionary, same_as_reference) {
+    Ptr<aruco::Dictionary> predefined = aruco::getPredefinedDictionary(aruco::DICT_4X4_50);
+    Ptr<aruco::Dictionary> noBase = makePtr<aruco::Dictionary>();
+    Ptr<aruco::Dictionary> base = makePtr<aruco::Dictionary>(predefined->bytesList.rowRange(0, 10).clone(), 4);
+
+    for(int k = 0; k < 3; k++) {
+        int nMarkers = k == 1 ? 8 : (k == 0 ? 20 : 16), markerSize = k == 1 ? 10 : (k == 0 ? 6 : 4);
+        Ptr<aruco::Dictionary> &baseDictionary = k == 2 ? base : noBase;
+
+        srand(k + 1);
+        Ptr<aruco::Dictionary> dictionary = aruco::generateCustomDictionary(nMarkers, markerSize, baseDictionary);
+        srand(k + 1);
+        Ptr<aruco::Dictionary> reference = referenceCustomDictionary(nMarkers, markerSize, baseDictionary);
+
+        ASSERT_EQ(reference->bytesList.rows, dictionary->bytesList.rows) << "marker size " << markerSize;
+        EXPECT_EQ(0, norm(reference->bytesList, dictionary->bytesList, NORM_INF)) << "marker size " << markerSize;
+        EXPECT_EQ(reference->maxCorrectionBits, dictionary->maxCorrectionBits) << "marker size " << markerSize;
+    }
+}
@@ -546,6 +546,84 @@ void CV_CharucoDiamondDetection::run(int) {
 
 
 
+/**
+ * @brief Check the incremental calibration of charuco views
+ */
+class CV_CharucoCalibrator : public cvtest::BaseTest {
+    public:
+    CV_CharucoCalibrator();
+
+    protected:
+    void run(int);
+};
+
+
+CV_CharucoCalibrator::CV_CharucoCalibrator() {}
+
+
+void CV_CharucoCalibrator::run(int) {
+
+    Mat cameraMatrix = Mat::eye(3, 3, CV_64FC1);
+    Size imgSize(500, 500);
+    Ptr<aruco::Dictionary> dictionary = aruco::getPredefinedDictionary(aruco::DICT_6X6_250);
+    Ptr<aruco::CharucoBoard> board = aruco::CharucoBoard::create(4, 4, 0.03f, 0.015f, dictionary);
+
+    cameraMatrix.at< double >(0, 0) = cameraMatrix.at< double >(1, 1) = 650;
+    cameraMatrix.at< double >(0, 2) = imgSize.width / 2;
+    cameraMatrix.at< double >(1, 2) = imgSize.height / 2;
+
+    Ptr<aruco::DetectorParameters> params = aruco::DetectorParameters::create();
+    params->minDistanceToBorder = 3;
+    const int maxViews = 6;
+    Ptr<aruco::CharucoCalibrator> calibrator =
+        aruco::CharucoCalibrator::create(board, params, maxViews, 4);
+
+    // for different perspectives
+    int frames = 0;
+    for(double distance = 0.2; distance <= 0.4; distance += 0.2) {
+        for(int yaw = 0; yaw < 360; yaw += 100) {
+            for(int pitch = 30; pitch <= 90; pitch += 50) {
+                Mat rvec, tvec;
+                Mat img = projectCharucoBoard(board, cameraMatrix, deg2rad(pitch), deg2rad(yaw),
+                                              distance, imgSize, 1, rvec, tvec);
+                calibrator->addFrame(img);
+                frames++;
+            }
+        }
+    }
+
+    Mat estimatedCamera, estimatedDist;
+    calibrator->calibrate(estimatedCamera, estimatedDist);
+
+    if(calibrator->getViewsNumber() == 0 || calibrator->getViewsNumber() > maxViews ||
+       calibrator->getViewsNumber() > frames) {
+        ts->printf(cvtest::TS::LOG, "Invalid number of stored views");
+        ts->set_failed_test_info(cvtest::TS::FAIL_MISMATCH);
+        return;
+    }
+
+    // the stored views give the same result than the batch calibration
+    vector< Mat > charucoCorners, charucoIds;
+    calibrator->getViews(charucoCorners, charucoIds);
+    Mat batchCamera, batchDist;
+    aruco::calibrateCameraCharuco(charucoCorners, charucoIds, board, imgSize, batchCamera,
+                                  batchDist);
+    if(norm(batchCamera, estimatedCamera, NORM_INF) > 1e-6 ||
+       norm(batchDist, estimatedDist, NORM_INF) > 1e-6) {
+        ts->printf(cvtest::TS::LOG, "Calibration differs from calibrateCameraCharuco");
+        ts->set_failed_test_info(cvtest::TS::FAIL_MISMATCH);
+        return;
+    }
+
+    if(fabs(estimatedCamera.at< double >(0, 0) - 650) > 65 ||
+       fabs(estimatedCamera.at< double >(1, 1) - 650) > 65) {
+        ts->printf(cvtest::TS::LOG, "Estimated focal length too far from the real one");
+        ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+        return;
+    }
+}
+
+
 
 TEST(CV_CharucoDetection, accuracy) {
     CV_CharucoDetection test;
@@ -562,3 +640,8 @@ TEST(CV_CharucoDiamondDetection, accuracy) {
     CV_CharucoDiamondDetection test;
     test.safe_run();
 }
+
+TEST(CV_CharucoCalibrator, accuracy) {
+    CV_CharucoCalibrator test;
+    test.safe_run();
+}
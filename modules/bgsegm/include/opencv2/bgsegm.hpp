@@ -185,6 +185,24 @@ public:
 CV_EXPORTS_W Ptr<BackgroundSubtractorGMG> createBackgroundSubtractorGMG(int initializationFrames=120,
                                                                         double decisionThreshold=0.8);                                  
 
+/** @brief Updates several background subtractors, each with its own frame, at once.
+
+The updates of all the streams are split in tiles of rows, which are processed together by the OpenCV
+thread pool, so a few large streams and many small ones keep all the cores busy. The function returns when
+all the foreground masks are ready. The results are the same as calling apply() on each subtractor.
+
+The subtractors of this module are processed in tiles, the other ones (e.g. cv::BackgroundSubtractorMOG2)
+are applied as a whole, one stream per task.
+
+@param subtractors The background subtractors, one for each stream, each of them at most once in the list.
+@param frames The next frame of each stream.
+@param fgmasks The output foreground masks, one for each stream.
+@param learningRate The learning rate passed to the subtractors, see BackgroundSubtractor::apply.
+ */
+CV_EXPORTS void applyBackgroundSubtractors(const std::vector<Ptr<BackgroundSubtractor> >& subtractors,
+                                           InputArrayOfArrays frames, OutputArrayOfArrays fgmasks,
+                                           double learningRate=-1);
+
 //! @}
 
 }
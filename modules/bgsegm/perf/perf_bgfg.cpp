@@ -0,0 +1,73 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::bgsegm;
+using namespace perf;
+
+// One update of the background model per cycle, on a sequence of a noisy background and a moving square
+
+typedef std::tr1::tuple<string, Size, int> BGFG_t;
+typedef perf::TestBaseWithParam<BGFG_t> bgfg;
+
+static Ptr<BackgroundSubtractor> createSubtractor(const string& name)
+{
+    if (name == "MOG")
+        return createBackgroundSubtractorMOG();
+    if (name == "GMG")
+        return createBackgroundSubtractorGMG(20);
+    CV_Error(Error::StsBadArg, "Unknown background subtractor " + name);
+    return Ptr<BackgroundSubtractor>();
+}
+
+static void makeSequence(Size size, int type, int count, vector<Mat>& frames)
+{
+    RNG rng(0);
+    Mat background(size, type);
+    rng.fill(background, RNG::UNIFORM, 0, 256);
+    GaussianBlur(background, background, Size(0, 0), 3);
+
+    int side = size.height / 4;
+    frames.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        Mat noise(size, type);
+        rng.fill(noise, RNG::NORMAL, 0, 4);
+        add(background, noise, frames[i]);
+        int x = (size.width - side) * i / count;
+        rectangle(frames[i], Rect(x, (size.height - side) / 2, side, side), Scalar::all(255), FILLED);
+    }
+}
+
+PERF_TEST_P(bgfg, apply,
+            testing::Combine(
+                testing::Values("MOG", "GMG"),
+                testing::Values(szVGA, sz720p),
+                testing::Values(CV_8UC1, CV_8UC3)))
+{
+    string name = std::tr1::get<0>(GetParam());
+    Size size = std::tr1::get<1>(GetParam());
+    int type = std::tr1::get<2>(GetParam());
+
+    const int count = 30;
+    vector<Mat> frames;
+    makeSequence(size, type, count, frames);
+    Ptr<BackgroundSubtractor> subtractor = createSubtractor(name);
+    Mat mask;
+    // the models are initialized before the measured updates
+    for (int i = 0; i < count; i++)
+        subtractor->apply(frames[i], mask);
+
+    int frame = 0;
+    TEST_CYCLE()
+    {
+        subtractor->apply(frames[frame], mask);
+        frame = (frame + 1) % count;
+    }
+
+    SANITY_CHECK_NOTHING();
+}
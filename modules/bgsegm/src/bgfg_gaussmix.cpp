@@ -41,6 +41,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencl_kernels_bgsegm.hpp"
 #include <float.h>
 
 // to make sure we can use these short names
@@ -69,7 +70,7 @@ static const double defaultVarThreshold = 2.5*2.5;
 static const double defaultNoiseSigma = 30*0.5;
 static const double defaultInitialWeight = 0.05;
 
-class BackgroundSubtractorMOGImpl : public BackgroundSubtractorMOG
+class BackgroundSubtractorMOGImpl : public BackgroundSubtractorMOG, public BackgroundSubtractorTiles
 {
 public:
     //! the default constructor
@@ -85,6 +86,9 @@ public:
         backgroundRatio = defaultBackgroundRatio;
         noiseSigma = defaultNoiseSigma;
         name_ = "BackgroundSubtractor.MOG";
+#ifdef HAVE_OPENCL
+        modelOnDevice = false;
+#endif
     }
     // the full constructor that takes the length of the history,
     // the number of gaussian mixtures, the background ratio parameter and the noise strength
@@ -99,11 +103,19 @@ public:
         varThreshold = defaultVarThreshold;
         backgroundRatio = std::min(_backgroundRatio > 0 ? _backgroundRatio : 0.95, 1.);
         noiseSigma = _noiseSigma <= 0 ? defaultNoiseSigma : _noiseSigma;
+#ifdef HAVE_OPENCL
+        modelOnDevice = false;
+#endif
     }
 
     //! the update operator
     virtual void apply(InputArray image, OutputArray fgmask, double learningRate=0);
 
+    //! the update operator split in tiles of rows, see BackgroundSubtractorTiles
+    virtual void beginTiles(InputArray image, OutputArray fgmask, double learningRate);
+    virtual void processTile(const Range& rows);
+    virtual void endTiles();
+
     //! re-initiaization method
     virtual void initialize(Size _frameSize, int _frameType)
     {
@@ -120,6 +132,9 @@ public:
         // the diagonal covariance matrix (another nchannels values)
         bgmodel.create( 1, frameSize.height*frameSize.width*nmixtures*(2 + 2*nchannels), CV_32F );
         bgmodel = Scalar::all(0);
+#ifdef HAVE_OPENCL
+        modelOnDevice = false;
+#endif
     }
 
     virtual void getBackgroundImage(OutputArray) const
@@ -158,6 +173,22 @@ public:
     }
 
 protected:
+    //! initializes the model when needed and returns the learning rate used for the frame
+    double prepareFrame(Size size, int type, double learningRate);
+    //! the frame and the mask of the update on the CPU
+    void setTileBuffers(InputArray image, OutputArray fgmask, double learningRate);
+
+    Mat tileImage, tileMask;
+    double tileLearningRate;
+
+#ifdef HAVE_OPENCL
+    bool ocl_apply(InputArray image, OutputArray fgmask, double learningRate);
+
+    //! the model while the frames are processed by the OpenCL version
+    UMat u_bgmodel;
+    bool modelOnDevice;
+#endif
+
     Size frameSize;
     int frameType;
     Mat bgmodel;
@@ -180,21 +211,22 @@ template<typename VT> struct MixData
 };
 
 
+// updates the model of the pixels of the rows in the given range
 static void process8uC1( const Mat& image, Mat& fgmask, double learningRate,
                          Mat& bgmodel, int nmixtures, double backgroundRatio,
-                         double varThreshold, double noiseSigma )
+                         double varThreshold, double noiseSigma, const Range& range )
 {
-    int x, y, k, k1, rows = image.rows, cols = image.cols;
+    int x, y, k, k1, cols = image.cols;
     float alpha = (float)learningRate, T = (float)backgroundRatio, vT = (float)varThreshold;
     int K = nmixtures;
-    MixData<float>* mptr = (MixData<float>*)bgmodel.data;
+    MixData<float>* mptr = (MixData<float>*)bgmodel.data + (size_t)range.start*cols*K;
 
     const float w0 = (float)defaultInitialWeight;
     const float sk0 = (float)(w0/(defaultNoiseSigma*2));
     const float var0 = (float)(defaultNoiseSigma*defaultNoiseSigma*4);
     const float minVar = (float)(noiseSigma*noiseSigma);
 
-    for( y = 0; y < rows; y++ )
+    for( y = range.start; y < range.end; y++ )
     {
         const uchar* src = image.ptr<uchar>(y);
         uchar* dst = fgmask.ptr<uchar>(y);
@@ -308,11 +340,12 @@ static void process8uC1( const Mat& image, Mat& fgmask, double learningRate,
 }
 
 
+// updates the model of the pixels of the rows in the given range
 static void process8uC3( const Mat& image, Mat& fgmask, double learningRate,
                          Mat& bgmodel, int nmixtures, double backgroundRatio,
-                         double varThreshold, double noiseSigma )
+                         double varThreshold, double noiseSigma, const Range& range )
 {
-    int x, y, k, k1, rows = image.rows, cols = image.cols;
+    int x, y, k, k1, cols = image.cols;
     float alpha = (float)learningRate, T = (float)backgroundRatio, vT = (float)varThreshold;
     int K = nmixtures;
 
@@ -320,9 +353,9 @@ static void process8uC3( const Mat& image, Mat& fgmask, double learningRate,
     const float sk0 = (float)(w0/(defaultNoiseSigma*2*std::sqrt(3.)));
     const float var0 = (float)(defaultNoiseSigma*defaultNoiseSigma*4);
     const float minVar = (float)(noiseSigma*noiseSigma);
-    MixData<Vec3f>* mptr = (MixData<Vec3f>*)bgmodel.data;
+    MixData<Vec3f>* mptr = (MixData<Vec3f>*)bgmodel.data + (size_t)range.start*cols*K;
 
-    for( y = 0; y < rows; y++ )
+    for( y = range.start; y < range.end; y++ )
     {
         const uchar* src = image.ptr<uchar>(y);
         uchar* dst = fgmask.ptr<uchar>(y);
@@ -437,28 +470,123 @@ static void process8uC3( const Mat& image, Mat& fgmask, double learningRate,
     }
 }
 
-void BackgroundSubtractorMOGImpl::apply(InputArray _image, OutputArray _fgmask, double learningRate)
+// the models of the pixels are independent, so the rows are updated in parallel
+class MOGInvoker : public ParallelLoopBody
 {
-    Mat image = _image.getMat();
-    bool needToInitialize = nframes == 0 || learningRate >= 1 || image.size() != frameSize || image.type() != frameType;
+public:
+    MOGInvoker( BackgroundSubtractorTiles& _subtractor ) : subtractor(_subtractor)
+    {
+    }
 
-    if( needToInitialize )
-        initialize(image.size(), image.type());
+    void operator()( const Range& range ) const
+    {
+        subtractor.processTile(range);
+    }
+
+private:
+    BackgroundSubtractorTiles& subtractor;
+
+    MOGInvoker& operator=(const MOGInvoker&); // to quiet MSVC
+};
+
+#ifdef HAVE_OPENCL
+
+bool BackgroundSubtractorMOGImpl::ocl_apply(InputArray _image, OutputArray _fgmask, double learningRate)
+{
+    int cn = CV_MAT_CN(frameType);
+    String opts = format("-D CN=%d -D NMIXTURES=%d", cn, nmixtures);
+    ocl::Kernel k("mog_update", ocl::bgsegm::bgfg_mog_oclsrc, opts);
+    if( k.empty() )
+        return false;
+
+    // the model is moved to the device the first time, it stays there while the frames are UMats
+    if( !modelOnDevice )
+    {
+        bgmodel.copyTo(u_bgmodel);
+        modelOnDevice = true;
+    }
+
+    const float w0 = (float)defaultInitialWeight;
+    const float sk0 = (float)(w0/(defaultNoiseSigma*2*std::sqrt((double)cn)));
+    const float var0 = (float)(defaultNoiseSigma*defaultNoiseSigma*4);
+    const float minVar = (float)(noiseSigma*noiseSigma);
 
-    CV_Assert( image.depth() == CV_8U );
+    UMat image = _image.getUMat();
     _fgmask.create( image.size(), CV_8U );
-    Mat fgmask = _fgmask.getMat();
+    UMat fgmask = _fgmask.getUMat();
+
+    k.args(ocl::KernelArg::ReadOnlyNoSize(image), ocl::KernelArg::WriteOnly(fgmask),
+           ocl::KernelArg::PtrReadWrite(u_bgmodel), (float)learningRate, (float)backgroundRatio,
+           (float)varThreshold, minVar, w0, sk0, var0);
+
+    size_t globalsize[2] = { (size_t)image.cols, (size_t)image.rows };
+    return k.run(2, globalsize, NULL, false);
+}
+
+#endif
+
+double BackgroundSubtractorMOGImpl::prepareFrame(Size size, int type, double learningRate)
+{
+    bool needToInitialize = nframes == 0 || learningRate >= 1 || size != frameSize || type != frameType;
+
+    if( needToInitialize )
+        initialize(size, type);
+
+    CV_Assert( CV_MAT_DEPTH(type) == CV_8U );
+    if( type != CV_8UC1 && type != CV_8UC3 )
+        CV_Error( Error::StsUnsupportedFormat, "Only 1- and 3-channel 8-bit images are supported in BackgroundSubtractorMOG" );
 
     ++nframes;
     learningRate = learningRate >= 0 && nframes > 1 ? learningRate : 1./std::min( nframes, history );
     CV_Assert(learningRate >= 0);
+    return learningRate;
+}
 
-    if( image.type() == CV_8UC1 )
-        process8uC1( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma );
-    else if( image.type() == CV_8UC3 )
-        process8uC3( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma );
+void BackgroundSubtractorMOGImpl::setTileBuffers(InputArray _image, OutputArray _fgmask, double learningRate)
+{
+#ifdef HAVE_OPENCL
+    // the model was last updated by the OpenCL version
+    if( modelOnDevice )
+    {
+        u_bgmodel.copyTo(bgmodel);
+        modelOnDevice = false;
+    }
+#endif
+
+    tileImage = _image.getMat();
+    _fgmask.create( tileImage.size(), CV_8U );
+    tileMask = _fgmask.getMat();
+    tileLearningRate = learningRate;
+}
+
+void BackgroundSubtractorMOGImpl::beginTiles(InputArray _image, OutputArray _fgmask, double learningRate)
+{
+    setTileBuffers(_image, _fgmask, prepareFrame(_image.size(), _image.type(), learningRate));
+}
+
+void BackgroundSubtractorMOGImpl::processTile(const Range& rows)
+{
+    if( tileImage.type() == CV_8UC1 )
+        process8uC1( tileImage, tileMask, tileLearningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma, rows );
     else
-        CV_Error( Error::StsUnsupportedFormat, "Only 1- and 3-channel 8-bit images are supported in BackgroundSubtractorMOG" );
+        process8uC3( tileImage, tileMask, tileLearningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma, rows );
+}
+
+void BackgroundSubtractorMOGImpl::endTiles()
+{
+    tileImage.release();
+    tileMask.release();
+}
+
+void BackgroundSubtractorMOGImpl::apply(InputArray _image, OutputArray _fgmask, double learningRate)
+{
+    learningRate = prepareFrame(_image.size(), _image.type(), learningRate);
+
+    CV_OCL_RUN(_image.isUMat() && _fgmask.isUMat(), ocl_apply(_image, _fgmask, learningRate))
+
+    setTileBuffers(_image, _fgmask, learningRate);
+    parallel_for_( Range(0, tileImage.rows), MOGInvoker(*this), tileImage.total()/(double)(1 << 16) );
+    endTiles();
 }
 
 Ptr<BackgroundSubtractorMOG> createBackgroundSubtractorMOG(int history, int nmixtures,
@@ -50,6 +50,7 @@
 
 #include "precomp.hpp"
 #include "opencv2/core/utility.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <limits>
 
 namespace cv
@@ -57,7 +58,7 @@ namespace cv
 namespace bgsegm
 {
 
-class BackgroundSubtractorGMGImpl : public BackgroundSubtractorGMG
+class BackgroundSubtractorGMGImpl : public BackgroundSubtractorGMG, public BackgroundSubtractorTiles
 {
 public:
     BackgroundSubtractorGMGImpl()
@@ -98,6 +99,13 @@ public:
      */
     virtual void apply(InputArray image, OutputArray fgmask, double learningRate=-1.0);
 
+    /**
+     * The update operator split in tiles of rows, see BackgroundSubtractorTiles.
+     */
+    virtual void beginTiles(InputArray image, OutputArray fgmask, double learningRate);
+    virtual void processTile(const Range& rows);
+    virtual void endTiles();
+
     /**
      * Releases all inner buffers.
      */
@@ -198,6 +206,11 @@ private:
     Mat_<float> weights_;
 
     Mat buf_;
+
+    // the frame and the masks of the update in progress
+    Mat frame_;
+    Mat fgmask_;
+    Mat rawmask_;
 };
 
 
@@ -223,16 +236,25 @@ void BackgroundSubtractorGMGImpl::initialize(Size frameSize, double minVal, doub
     nfeatures_.setTo(Scalar::all(0));
 }
 
-static float findFeature(unsigned int color, const unsigned int* colors, const float* weights, int nfeatures)
+// index of the color in the histogram of the pixel, -1 if it is not in it
+static int findFeature(unsigned int color, const unsigned int* colors, int nfeatures)
 {
-    for (int i = 0; i < nfeatures; ++i)
+    int i = 0;
+#if CV_SIMD128
+    v_uint32x4 v_color = v_setall_u32(color);
+    for (; i <= nfeatures - 4; i += 4)
+    {
+        if (v_check_any(v_load(colors + i) == v_color))
+            break;
+    }
+#endif
+    for (; i < nfeatures; ++i)
     {
         if (color == colors[i])
-            return weights[i];
+            return i;
     }
 
-    // not in histogram, so return 0.
-    return 0.0f;
+    return -1;
 }
 
 static void normalizeHistogram(float* weights, int nfeatures)
@@ -248,23 +270,13 @@ static void normalizeHistogram(float* weights, int nfeatures)
     }
 }
 
-static bool insertFeature(unsigned int color, float weight, unsigned int* colors, float* weights, int& nfeatures, int maxFeatures)
+// idx is the index of the color in the histogram, as returned by findFeature
+static bool insertFeature(unsigned int color, float weight, int idx, unsigned int* colors, float* weights, int& nfeatures, int maxFeatures)
 {
-    int idx = -1;
-    for (int i = 0; i < nfeatures; ++i)
-    {
-        if (color == colors[i])
-        {
-            // feature in histogram
-            weight += weights[i];
-            idx = i;
-            break;
-        }
-    }
-
     if (idx >= 0)
     {
-        // move feature to beginning of list
+        // feature in histogram, move it to beginning of list
+        weight += weights[idx];
 
         ::memmove(colors + 1, colors, idx * sizeof(unsigned int));
         ::memmove(weights + 1, weights, idx * sizeof(float));
@@ -380,13 +392,17 @@ void GMG_LoopBody::operator() (const Range& range) const
 
             unsigned int newFeatureColor = func(frame_row, x, cn, minVal_, maxVal_, quantizationLevels_);
 
+            // the same search serves the posterior and the update of the histogram
+            int idx = findFeature(newFeatureColor, colors, nfeatures);
+
             bool isForeground = false;
 
             if (frameNum_ >= numInitializationFrames_)
             {
                 // typical operation
 
-                const double weight = findFeature(newFeatureColor, colors, weights, nfeatures);
+                // not in histogram, the weight is 0
+                const double weight = idx >= 0 ? weights[idx] : 0.0f;
 
                 // see Godbehere, Matsukawa, Goldberg (2012) for reasoning behind this implementation of Bayes rule
                 const double posterior = (weight * backgroundPrior_) / (weight * backgroundPrior_ + (1.0 - weight) * (1.0 - backgroundPrior_));
@@ -400,7 +416,7 @@ void GMG_LoopBody::operator() (const Range& range) const
                     for (int i = 0; i < nfeatures; ++i)
                         weights[i] *= (float)(1.0f - learningRate_);
 
-                    bool inserted = insertFeature(newFeatureColor, (float)learningRate_, colors, weights, nfeatures, maxFeatures_);
+                    bool inserted = insertFeature(newFeatureColor, (float)learningRate_, idx, colors, weights, nfeatures, maxFeatures_);
 
                     if (inserted)
                     {
@@ -413,7 +429,7 @@ void GMG_LoopBody::operator() (const Range& range) const
             {
                 // training-mode update
 
-                insertFeature(newFeatureColor, 1.0f, colors, weights, nfeatures, maxFeatures_);
+                insertFeature(newFeatureColor, 1.0f, idx, colors, weights, nfeatures, maxFeatures_);
 
                 if (frameNum_ == numInitializationFrames_ - 1)
                     normalizeHistogram(weights, nfeatures);
@@ -424,7 +440,7 @@ void GMG_LoopBody::operator() (const Range& range) const
     }
 }
 
-void BackgroundSubtractorGMGImpl::apply(InputArray _frame, OutputArray _fgmask, double newLearningRate)
+void BackgroundSubtractorGMGImpl::beginTiles(InputArray _frame, OutputArray _fgmask, double newLearningRate)
 {
     Mat frame = _frame.getMat();
 
@@ -450,23 +466,51 @@ void BackgroundSubtractorGMGImpl::apply(InputArray _frame, OutputArray _fgmask,
     }
 
     _fgmask.create(frameSize_, CV_8UC1);
-    Mat fgmask = _fgmask.getMat();
+    frame_ = frame;
+    fgmask_ = _fgmask.getMat();
 
-    GMG_LoopBody body(frame, fgmask, nfeatures_, colors_, weights_,
+    // with smoothing, the raw mask goes to the buffer and is filtered into the output
+    rawmask_ = fgmask_;
+    if (smoothingRadius > 0)
+    {
+        buf_.create(frameSize_, CV_8UC1);
+        rawmask_ = buf_;
+    }
+}
+
+void BackgroundSubtractorGMGImpl::processTile(const Range& rows)
+{
+    GMG_LoopBody body(frame_, rawmask_, nfeatures_, colors_, weights_,
                       maxFeatures, learningRate, numInitializationFrames, quantizationLevels, backgroundPrior, decisionThreshold,
                       maxVal_, minVal_, frameNum_, updateBackgroundModel);
-    parallel_for_(Range(0, frame.rows), body, frame.total()/(double)(1<<16));
+    body(rows);
+}
 
+void BackgroundSubtractorGMGImpl::endTiles()
+{
     if (smoothingRadius > 0)
-    {
-        medianBlur(fgmask, buf_, smoothingRadius);
-        swap(fgmask, buf_);
-    }
+        medianBlur(rawmask_, fgmask_, smoothingRadius);
+
+    frame_.release();
+    fgmask_.release();
+    rawmask_.release();
 
     // keep track of how many frames we have processed
     ++frameNum_;
 }
 
+void BackgroundSubtractorGMGImpl::apply(InputArray _frame, OutputArray _fgmask, double newLearningRate)
+{
+    beginTiles(_frame, _fgmask, newLearningRate);
+
+    GMG_LoopBody body(frame_, rawmask_, nfeatures_, colors_, weights_,
+                      maxFeatures, learningRate, numInitializationFrames, quantizationLevels, backgroundPrior, decisionThreshold,
+                      maxVal_, minVal_, frameNum_, updateBackgroundModel);
+    parallel_for_(Range(0, frame_.rows), body, frame_.total()/(double)(1<<16));
+
+    endTiles();
+}
+
 void BackgroundSubtractorGMGImpl::release()
 {
     frameSize_ = Size();
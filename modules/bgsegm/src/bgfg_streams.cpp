@@ -0,0 +1,108 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "precomp.hpp"
+
+namespace cv
+{
+namespace bgsegm
+{
+
+// about the number of pixels of the tiles, the same as the stripes of a single apply()
+static const int tilePixels = 1 << 16;
+
+struct StreamTask
+{
+    int stream;
+    // the rows of a tile, empty when the whole frame is given to apply()
+    Range rows;
+};
+
+class StreamTasksInvoker : public ParallelLoopBody
+{
+public:
+    StreamTasksInvoker( const std::vector<Ptr<BackgroundSubtractor> >& _subtractors,
+                        const std::vector<BackgroundSubtractorTiles*>& _tiled,
+                        const std::vector<Mat>& _frames, std::vector<Mat>& _fgmasks,
+                        const std::vector<StreamTask>& _tasks, double _learningRate )
+        : subtractors(_subtractors), tiled(_tiled), frames(_frames), fgmasks(_fgmasks),
+          tasks(_tasks), learningRate(_learningRate)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        for( int t = range.start; t < range.end; t++ )
+        {
+            const StreamTask& task = tasks[t];
+            if( tiled[task.stream] )
+                tiled[task.stream]->processTile(task.rows);
+            else
+                subtractors[task.stream]->apply(frames[task.stream], fgmasks[task.stream], learningRate);
+        }
+    }
+
+private:
+    const std::vector<Ptr<BackgroundSubtractor> >& subtractors;
+    const std::vector<BackgroundSubtractorTiles*>& tiled;
+    const std::vector<Mat>& frames;
+    std::vector<Mat>& fgmasks;
+    const std::vector<StreamTask>& tasks;
+    double learningRate;
+
+    StreamTasksInvoker& operator=(const StreamTasksInvoker&); // to quiet MSVC
+};
+
+void applyBackgroundSubtractors(const std::vector<Ptr<BackgroundSubtractor> >& subtractors,
+                                InputArrayOfArrays _frames, OutputArrayOfArrays _fgmasks, double learningRate)
+{
+    int nstreams = (int)subtractors.size();
+    CV_Assert( (int)_frames.total() == nstreams );
+
+    std::vector<Mat> frames(nstreams), fgmasks(nstreams);
+    std::vector<BackgroundSubtractorTiles*> tiled(nstreams);
+    _fgmasks.create(nstreams, 1, CV_8U, -1, true);
+    for( int i = 0; i < nstreams; i++ )
+    {
+        CV_Assert( !subtractors[i].empty() );
+        frames[i] = _frames.getMat(i);
+        _fgmasks.create(frames[i].size(), CV_8UC1, i, true);
+        fgmasks[i] = _fgmasks.getMat(i);
+        tiled[i] = dynamic_cast<BackgroundSubtractorTiles*>(subtractors[i].get());
+    }
+
+    // the tiles of all the streams go to the same pool
+    std::vector<StreamTask> tasks;
+    for( int i = 0; i < nstreams; i++ )
+    {
+        StreamTask task;
+        task.stream = i;
+        if( !tiled[i] )
+        {
+            task.rows = Range(0, 0);
+            tasks.push_back(task);
+            continue;
+        }
+
+        tiled[i]->beginTiles(frames[i], fgmasks[i], learningRate);
+        int rows = frames[i].rows, tileRows = std::max(tilePixels / std::max(frames[i].cols, 1), 1);
+        for( int y = 0; y < rows; y += tileRows )
+        {
+            task.rows = Range(y, std::min(y + tileRows, rows));
+            tasks.push_back(task);
+        }
+    }
+
+    parallel_for_(Range(0, (int)tasks.size()),
+                  StreamTasksInvoker(subtractors, tiled, frames, fgmasks, tasks, learningRate));
+
+    for( int i = 0; i < nstreams; i++ )
+    {
+        if( tiled[i] )
+            tiled[i]->endTiles();
+    }
+}
+
+}
+}
@@ -0,0 +1,152 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+// One work item per pixel of the BackgroundSubtractorMOG update (bgfg_gaussmix.cpp).
+// The model of a pixel is NMIXTURES mixtures of MIX_SIZE floats, laid as on the CPU:
+// the sort key, the weight, CN means and CN variances.
+
+#define MIX_SIZE (2 + 2*CN)
+
+__kernel void mog_update(__global const uchar * imgptr, int img_step, int img_offset,
+                         __global uchar * fgmask, int fgmask_step, int fgmask_offset, int rows, int cols,
+                         __global float * bgmodel, float alpha, float T, float vT, float minVar,
+                         float w0, float sk0, float var0)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+
+    if (x < cols && y < rows)
+    {
+        __global const uchar * src = imgptr + mad24(y, img_step, mad24(x, CN, img_offset));
+        __global float * mptr = bgmodel + mad24(y, cols, x) * (NMIXTURES * MIX_SIZE);
+        float pix[CN];
+        for (int c = 0; c < CN; c++)
+            pix[c] = src[c];
+
+        int k, kHit = -1, kForeground = -1;
+        uchar fg;
+
+        if (alpha > 0.f)
+        {
+            float wsum = 0.f;
+            for (k = 0; k < NMIXTURES; k++)
+            {
+                __global float * m = mptr + k*MIX_SIZE;
+                float w = m[1];
+                wsum += w;
+                if (w < FLT_EPSILON)
+                    break;
+                float diff[CN], d2 = 0.f, vsum = 0.f;
+                for (int c = 0; c < CN; c++)
+                {
+                    diff[c] = pix[c] - m[2 + c];
+                    d2 += diff[c]*diff[c];
+                    vsum += m[2 + CN + c];
+                }
+                if (d2 < vT*vsum)
+                {
+                    wsum -= w;
+                    float dw = alpha*(1.f - w);
+                    m[1] = w + dw;
+                    vsum = 0.f;
+                    for (int c = 0; c < CN; c++)
+                    {
+                        float var = m[2 + CN + c];
+                        m[2 + c] += alpha*diff[c];
+                        var = max(var + alpha*(diff[c]*diff[c] - var), minVar);
+                        m[2 + CN + c] = var;
+                        vsum += var;
+                    }
+                    m[0] = w/sqrt(vsum);
+
+                    int k1;
+                    for (k1 = k-1; k1 >= 0; k1--)
+                    {
+                        __global float * a = mptr + k1*MIX_SIZE;
+                        if (a[0] >= a[MIX_SIZE])
+                            break;
+                        for (int i = 0; i < MIX_SIZE; i++)
+                        {
+                            float t = a[i];
+                            a[i] = a[i + MIX_SIZE];
+                            a[i + MIX_SIZE] = t;
+                        }
+                    }
+
+                    kHit = k1+1;
+                    break;
+                }
+            }
+
+            if (kHit < 0) // no appropriate gaussian mixture found at all, remove the weakest mixture and create a new one
+            {
+                kHit = k = min(k, NMIXTURES-1);
+                __global float * m = mptr + k*MIX_SIZE;
+                wsum += w0 - m[1];
+                m[0] = sk0;
+                m[1] = w0;
+                for (int c = 0; c < CN; c++)
+                {
+                    m[2 + c] = pix[c];
+                    m[2 + CN + c] = var0;
+                }
+            }
+            else
+                for (; k < NMIXTURES; k++)
+                    wsum += mptr[k*MIX_SIZE + 1];
+
+            float wscale = 1.f/wsum;
+            wsum = 0.f;
+            for (k = 0; k < NMIXTURES; k++)
+            {
+                __global float * m = mptr + k*MIX_SIZE;
+                wsum += m[1] *= wscale;
+                m[0] *= wscale;
+                if (wsum > T && kForeground < 0)
+                    kForeground = k+1;
+            }
+
+            fg = kHit >= kForeground ? (uchar)255 : (uchar)0;
+        }
+        else
+        {
+            for (k = 0; k < NMIXTURES; k++)
+            {
+                __global const float * m = mptr + k*MIX_SIZE;
+                if (m[1] < FLT_EPSILON)
+                    break;
+                float d2 = 0.f, vsum = 0.f;
+                for (int c = 0; c < CN; c++)
+                {
+                    float diff = pix[c] - m[2 + c];
+                    d2 += diff*diff;
+                    vsum += m[2 + CN + c];
+                }
+                if (d2 < vT*vsum)
+                {
+                    kHit = k;
+                    break;
+                }
+            }
+
+            if (kHit >= 0)
+            {
+                float wsum = 0.f;
+                for (k = 0; k < NMIXTURES; k++)
+                {
+                    wsum += mptr[k*MIX_SIZE + 1];
+                    if (wsum > T)
+                    {
+                        kForeground = k+1;
+                        break;
+                    }
+                }
+            }
+
+            fg = kHit < 0 || kHit >= kForeground ? (uchar)255 : (uchar)0;
+        }
+
+        fgmask[mad24(y, fgmask_step, x + fgmask_offset)] = fg;
+    }
+}
@@ -49,4 +49,28 @@ the use of this software, even if advised of the possibility of such damage.
 #include <algorithm>
 #include <cmath>
 
+namespace cv
+{
+namespace bgsegm
+{
+
+// The background subtractors whose apply() can be split in tiles of rows, used by
+// applyBackgroundSubtractors to process the tiles of several streams together.
+// apply() is beginTiles(), processTile() on all the rows, then endTiles().
+class BackgroundSubtractorTiles
+{
+public:
+    virtual ~BackgroundSubtractorTiles() {}
+
+    //! everything apply() does before the update of the pixels
+    virtual void beginTiles(InputArray image, OutputArray fgmask, double learningRate) = 0;
+    //! the update of the pixels of the rows of the range, the tiles are independent one from another
+    virtual void processTile(const Range& rows) = 0;
+    //! everything apply() does after the update of the pixels
+    virtual void endTiles() = 0;
+};
+
+}
+}
+
 #endif
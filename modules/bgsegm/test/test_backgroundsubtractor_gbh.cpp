@@ -136,3 +136,25 @@ void CV_BackgroundSubtractorTest::run(int)
 }
 
 TEST(VIDEO_BGSUBGMG, accuracy) { CV_BackgroundSubtractorTest test; test.safe_run(); }
+
+TEST(BackgroundSubtractorGMG, smoothing_reaches_output)
+{
+    Mat background(64, 64, CV_8UC1, Scalar::all(0));
+    Mat frame = background.clone();
+    frame.at<uchar>(32, 32) = 255;
+
+    int radius[] = { 0, 7 };
+    int expected[] = { 1, 0 };
+    for (int i = 0; i < 2; i++)
+    {
+        Ptr<BackgroundSubtractorGMG> fgbg = createBackgroundSubtractorGMG(5);
+        fgbg->setSmoothingRadius(radius[i]);
+        Mat fgmask;
+        for (int j = 0; j < 5; j++)
+            fgbg->apply(background, fgmask);
+
+        // an isolated foreground pixel is removed by the median filter
+        fgbg->apply(frame, fgmask);
+        EXPECT_EQ(expected[i], countNonZero(fgmask));
+    }
+}
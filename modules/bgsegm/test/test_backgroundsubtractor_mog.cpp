@@ -0,0 +1,105 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace cv::bgsegm;
+
+// a moving square over a noisy background
+static void makeMOGFrames(int type, std::vector<Mat>& frames, Size size = Size(160, 120))
+{
+    RNG rng(0);
+    frames.resize(20);
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        Mat frame(size, type);
+        rng.fill(frame, RNG::NORMAL, Scalar::all(100), Scalar::all(5));
+        rectangle(frame, Rect(10 + 5 * (int)i, 40, 30, 30), Scalar::all(220), FILLED);
+        frames[i] = frame;
+    }
+}
+
+TEST(BackgroundSubtractorMOG, thread_invariance)
+{
+    int types[] = { CV_8UC1, CV_8UC3 };
+    for (int t = 0; t < 2; t++)
+    {
+        std::vector<Mat> frames;
+        makeMOGFrames(types[t], frames);
+
+        Ptr<BackgroundSubtractorMOG> mog = createBackgroundSubtractorMOG();
+        Ptr<BackgroundSubtractorMOG> mogSerial = createBackgroundSubtractorMOG();
+        int threads = getNumThreads();
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            Mat fgmask, fgmaskSerial;
+            mog->apply(frames[i], fgmask);
+            setNumThreads(1);
+            mogSerial->apply(frames[i], fgmaskSerial);
+            setNumThreads(threads);
+            ASSERT_EQ(0, cvtest::norm(fgmask, fgmaskSerial, NORM_INF));
+        }
+    }
+}
+
+TEST(BackgroundSubtractorMOG, UMat)
+{
+    int types[] = { CV_8UC1, CV_8UC3 };
+    for (int t = 0; t < 2; t++)
+    {
+        std::vector<Mat> frames;
+        makeMOGFrames(types[t], frames);
+
+        Ptr<BackgroundSubtractorMOG> mog = createBackgroundSubtractorMOG();
+        Ptr<BackgroundSubtractorMOG> mogOcl = createBackgroundSubtractorMOG();
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            Mat fgmask;
+            UMat uframe, ufgmask;
+            frames[i].copyTo(uframe);
+            mog->apply(frames[i], fgmask);
+            mogOcl->apply(uframe, ufgmask);
+            // the rounding of the device may flip a few pixels close to the thresholds
+            Mat diff = fgmask != ufgmask.getMat(ACCESS_READ);
+            EXPECT_LE(countNonZero(diff), (int)(0.001 * fgmask.total()));
+        }
+    }
+}
+
+TEST(BackgroundSubtractorStreams, same_as_apply)
+{
+    // the large stream is split in several tiles, MOG2 is applied as a whole
+    std::vector<Mat> frames[4];
+    makeMOGFrames(CV_8UC1, frames[0], Size(640, 480));
+    makeMOGFrames(CV_8UC3, frames[1]);
+    makeMOGFrames(CV_8UC1, frames[2]);
+    makeMOGFrames(CV_8UC3, frames[3]);
+
+    std::vector<Ptr<BackgroundSubtractor> > streams, single;
+    streams.push_back(createBackgroundSubtractorMOG());
+    streams.push_back(createBackgroundSubtractorMOG());
+    streams.push_back(createBackgroundSubtractorGMG(5));
+    streams.push_back(createBackgroundSubtractorMOG2());
+    single.push_back(createBackgroundSubtractorMOG());
+    single.push_back(createBackgroundSubtractorMOG());
+    single.push_back(createBackgroundSubtractorGMG(5));
+    single.push_back(createBackgroundSubtractorMOG2());
+
+    for (size_t j = 0; j < frames[0].size(); j++)
+    {
+        std::vector<Mat> input, fgmasks;
+        for (int i = 0; i < 4; i++)
+            input.push_back(frames[i][j]);
+        applyBackgroundSubtractors(streams, input, fgmasks);
+        ASSERT_EQ(input.size(), fgmasks.size());
+
+        for (int i = 0; i < 4; i++)
+        {
+            Mat fgmask;
+            single[i]->apply(input[i], fgmask);
+            ASSERT_EQ(0, cvtest::norm(fgmask, fgmasks[i], NORM_INF)) << "stream " << i << ", frame " << j;
+        }
+    }
+}
@@ -446,6 +446,16 @@ the log scale that is applied
  */
 CV_EXPORTS_W Ptr<Retina> createRetina(Size inputSize, const bool colorMode, int colorSamplingMethod=RETINA_COLOR_BAYER, const bool useRetinaLogSampling=false, const float reductionFactor=1.0f, const float samplingStrenght=10.0f);
 
+/** @brief Runs many retinas, one for each camera stream, on their next frame
+
+It is the same as calling Retina::run of each retina on its image. The streams are processed in
+parallel, each of them by a single thread, which for many streams is cheaper than parallelizing
+each filter stage of each retina on its own.
+@param retinas the retinas, each of them keeps the state of its stream
+@param inputImages the images, one for each retina, of its input size
+ */
+CV_EXPORTS void runRetinas(const std::vector<Ptr<Retina> >& retinas, InputArrayOfArrays inputImages);
+
 #ifdef HAVE_OPENCV_OCL
 Ptr<Retina> createRetina_OCL(Size inputSize);
 Ptr<Retina> createRetina_OCL(Size inputSize, const bool colorMode, int colorSamplingMethod=RETINA_COLOR_BAYER, const bool useRetinaLogSampling=false, const float reductionFactor=1.0f, const float samplingStrenght=10.0f);
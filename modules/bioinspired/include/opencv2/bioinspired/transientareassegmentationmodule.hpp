@@ -195,6 +195,18 @@ public:
  */
 CV_EXPORTS_W Ptr<TransientAreasSegmentationModule> createTransientAreasSegmentationModule(Size inputSize);
 
+/** @brief Runs many segmentation modules, one for each video stream, on their next frame
+
+It is the same as calling TransientAreasSegmentationModule::run of each module on its image. The
+streams are processed in parallel, each of them by a single thread, which for many streams is
+cheaper than parallelizing each filter of each module on its own.
+@param segmenters the segmentation modules, each of them keeps the state of its stream
+@param inputImages the images, one for each module, of its size
+@param channelIndex the channel of the images to process in case of multichannel images
+@relates bioinspired::TransientAreasSegmentationModule
+ */
+CV_EXPORTS void runTransientAreasSegmentations(const std::vector<Ptr<TransientAreasSegmentationModule> >& segmenters, InputArrayOfArrays inputImages, const int channelIndex=0);
+
 //! @}
 
 }} // namespaces end : cv and bioinspired
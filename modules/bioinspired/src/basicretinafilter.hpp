@@ -467,6 +467,11 @@ namespace bioinspired
         */
 
 #define _DEBUG_TBB // define DEBUG_TBB in order to display additionnal data on stdout
+
+        // the vertical filters stride over the rows of a column, instead each stripe is a band of about 32 columns
+        // whose rows are swept in turn, so that the memory is read by rows for any number of columns
+        static double _verticalFilterStripes(const unsigned int nbColumns) { return nbColumns/32.0; }
+
         class Parallel_horizontalAnticausalFilter: public cv::ParallelLoopBody
         {
         private:
@@ -545,19 +550,20 @@ namespace bioinspired
             Parallel_verticalCausalFilter(float *bufferToProcess, const unsigned int nbRws, const unsigned int nbCols, const float a )
                 :outputFrame(bufferToProcess), nbRows(nbRws), nbColumns(nbCols), filterParam_a(a){}
 
+            // the band of columns is swept row by row, the result of a row being the output of the previous one
             virtual void operator()( const Range& r ) const {
-                for (int IDcolumn=r.start; IDcolumn!=r.end; ++IDcolumn)
+                for (unsigned int IDrow=1; IDrow<nbRows; ++IDrow)
                 {
-                    register float result=0;
-                    register float *outputPTR=outputFrame+IDcolumn;
-
-                    for (unsigned int index=0; index<nbRows; ++index)
-                    {
-                        result = *(outputPTR) + filterParam_a * result;
-                        *(outputPTR) = result;
-                        outputPTR+=nbColumns;
-
-                    }
+                    const float *previousPTR=outputFrame+(IDrow-1)*nbColumns;
+                    float *outputPTR=outputFrame+IDrow*nbColumns;
+                    int IDcolumn=r.start;
+#if CV_SIMD128
+                    v_float32x4 v_a=v_setall_f32(filterParam_a);
+                    for (; IDcolumn<=r.end-4; IDcolumn+=4)
+                        v_store(outputPTR+IDcolumn, v_load(outputPTR+IDcolumn) + v_a*v_load(previousPTR+IDcolumn));
+#endif
+                    for (; IDcolumn<r.end; ++IDcolumn)
+                        outputPTR[IDcolumn] = outputPTR[IDcolumn] + filterParam_a * previousPTR[IDcolumn];
                 }
             }
         };
@@ -572,19 +578,30 @@ namespace bioinspired
             Parallel_verticalAnticausalFilter_multGain(float *bufferToProcess, const unsigned int nbRws, const unsigned int nbCols, const float a, const float  gain)
                 :outputFrame(bufferToProcess), nbRows(nbRws), nbColumns(nbCols), filterParam_a(a), filterParam_gain(gain){}
 
+            // the band of columns is swept row by row from the last one, the results of the band are kept aside
             virtual void operator()( const Range& r ) const {
-                float* offset=outputFrame+nbColumns*nbRows-nbColumns;
-                for (int IDcolumn=r.start; IDcolumn!=r.end; ++IDcolumn)
-                {
-                    register float result=0;
-                    register float *outputPTR=offset+IDcolumn;
+                cv::AutoBuffer<float> resultBuffer(r.end-r.start);
+                float *result=(float*)resultBuffer-r.start;
+                for (int IDcolumn=r.start; IDcolumn<r.end; ++IDcolumn)
+                    result[IDcolumn]=0;
 
-                    for (unsigned int index=0; index<nbRows; ++index)
+                for (unsigned int index=nbRows; index>0; --index)
+                {
+                    float *outputPTR=outputFrame+(index-1)*nbColumns;
+                    int IDcolumn=r.start;
+#if CV_SIMD128
+                    v_float32x4 v_a=v_setall_f32(filterParam_a), v_gain=v_setall_f32(filterParam_gain);
+                    for (; IDcolumn<=r.end-4; IDcolumn+=4)
                     {
-                        result = *(outputPTR) + filterParam_a * result;
-                        *(outputPTR) = filterParam_gain*result;
-                        outputPTR-=nbColumns;
-
+                        v_float32x4 v_result=v_load(outputPTR+IDcolumn) + v_a*v_load(result+IDcolumn);
+                        v_store(result+IDcolumn, v_result);
+                        v_store(outputPTR+IDcolumn, v_gain*v_result);
+                    }
+#endif
+                    for (; IDcolumn<r.end; ++IDcolumn)
+                    {
+                        result[IDcolumn] = outputPTR[IDcolumn] + filterParam_a * result[IDcolumn];
+                        outputPTR[IDcolumn] = filterParam_gain*result[IDcolumn];
                     }
                 }
             }
@@ -652,19 +669,20 @@ namespace bioinspired
             Parallel_verticalCausalFilter_Irregular(float *bufferToProcess, const float *spatialConst, const unsigned int nbRws, const unsigned int nbCols)
                 :outputFrame(bufferToProcess), spatialConstantBuffer(spatialConst), nbRows(nbRws), nbColumns(nbCols){}
 
+            // the band of columns is swept row by row, the result of a row being the output of the previous one
             virtual void operator()( const Range& r ) const {
-                for (int IDcolumn=r.start; IDcolumn!=r.end; ++IDcolumn)
+                for (unsigned int IDrow=1; IDrow<nbRows; ++IDrow)
                 {
-                    register float result=0;
-                    register float *outputPTR=outputFrame+IDcolumn;
-                    register const float* spatialConstantPTR=spatialConstantBuffer+IDcolumn;
-                    for (unsigned int index=0; index<nbRows; ++index)
-                    {
-                        result = *(outputPTR) +  *(spatialConstantPTR) * result;
-                        *(outputPTR) = result;
-                        outputPTR+=nbColumns;
-                        spatialConstantPTR+=nbColumns;
-                    }
+                    const float *previousPTR=outputFrame+(IDrow-1)*nbColumns;
+                    float *outputPTR=outputFrame+IDrow*nbColumns;
+                    const float *spatialConstantPTR=spatialConstantBuffer+IDrow*nbColumns;
+                    int IDcolumn=r.start;
+#if CV_SIMD128
+                    for (; IDcolumn<=r.end-4; IDcolumn+=4)
+                        v_store(outputPTR+IDcolumn, v_load(outputPTR+IDcolumn) + v_load(spatialConstantPTR+IDcolumn)*v_load(previousPTR+IDcolumn));
+#endif
+                    for (; IDcolumn<r.end; ++IDcolumn)
+                        outputPTR[IDcolumn] = outputPTR[IDcolumn] + spatialConstantPTR[IDcolumn] * previousPTR[IDcolumn];
                 }
             }
         };
@@ -64,6 +64,9 @@
 
 #include "precomp.hpp"
 #include "imagelogpolprojection.hpp"
+#ifdef HAVE_OPENCL
+#include "opencl_kernels_bioinspired.hpp"
+#endif
 
 #include <cmath>
 #include <iostream>
@@ -290,6 +293,7 @@ bool ImageLogPolProjection::_initLogRetinaSampling(const double reductionFactor,
     // (re)creating and filling the transform table
     _transformTable.resize(_usefullpixelIndex);
     memcpy(&_transformTable[0], &tempTransformTable[0], sizeof(unsigned int)*_usefullpixelIndex);
+    _initProjectionMap();
 
     // reset all buffers
     clearAllBuffers();
@@ -387,6 +391,7 @@ bool ImageLogPolProjection::_initLogPolarCortexSampling(const double reductionFa
     // (re)creating and filling the transform table
     _transformTable.resize(_usefullpixelIndex);
     memcpy(&_transformTable[0], &tempTransformTable[0], sizeof(unsigned int)*_usefullpixelIndex);
+    _initProjectionMap();
 
     // reset all buffers
     clearAllBuffers();
@@ -394,6 +399,96 @@ bool ImageLogPolProjection::_initLogPolarCortexSampling(const double reductionFa
     return true;
 }
 
+// the transform table lists the input pixel of each output pixel it samples, it is turned into a gather map
+void ImageLogPolProjection::_initProjectionMap()
+{
+    CV_Assert(_filterOutput.getNBrows() <= SHRT_MAX && _filterOutput.getNBcolumns() <= SHRT_MAX);
+    _projectionMap.create(_outputNBrows, _outputNBcolumns, CV_16SC2);
+    _projectionMap.setTo(Scalar::all(-1));
+    short *mapPTR=_projectionMap.ptr<short>();
+    const unsigned int nbColumns=_filterOutput.getNBcolumns();
+    for (unsigned int i=0 ; i<_usefullpixelIndex ; i+=2)
+    {
+        mapPTR[2*_transformTable[i]]=(short)(_transformTable[i+1]%nbColumns);
+        mapPTR[2*_transformTable[i]+1]=(short)(_transformTable[i+1]/nbColumns);
+    }
+}
+
+// the output pixels are independent, each row gathers its pixels of all the planes in one pass over the map
+class Parallel_logPolProjection: public cv::ParallelLoopBody
+{
+private:
+    const float *inputFrame;
+    float *outputFrame;
+    const Mat &projectionMap;
+    unsigned int inputNBcolumns, inputNBpixels, outputNBpixels, nbPlanes;
+public:
+    Parallel_logPolProjection(const float *inputBuffer, float *outputBuffer, const Mat &map, const unsigned int inputCols, const unsigned int inputPixels, const unsigned int planes)
+        :inputFrame(inputBuffer), outputFrame(outputBuffer), projectionMap(map), inputNBcolumns(inputCols), inputNBpixels(inputPixels),
+         outputNBpixels((unsigned int)map.total()), nbPlanes(planes){}
+
+    virtual void operator()( const Range& r ) const {
+        for (int IDrow=r.start; IDrow!=r.end; ++IDrow)
+        {
+            const short *mapPTR=projectionMap.ptr<short>(IDrow);
+            float *outputPTR=outputFrame+IDrow*projectionMap.cols;
+            for (int IDcolumn=0; IDcolumn<projectionMap.cols; ++IDcolumn, mapPTR+=2, ++outputPTR)
+            {
+                if (mapPTR[0]<0)
+                {
+                    for (unsigned int c=0; c<nbPlanes; ++c)
+                        outputPTR[c*outputNBpixels]=0;
+                    continue;
+                }
+                const float *inputPTR=inputFrame+mapPTR[1]*inputNBcolumns+mapPTR[0];
+                for (unsigned int c=0; c<nbPlanes; ++c)
+                    outputPTR[c*outputNBpixels]=inputPTR[c*inputNBpixels];
+            }
+        }
+    }
+
+private:
+    Parallel_logPolProjection& operator=(const Parallel_logPolProjection&); // to quiet MSVC
+};
+
+void ImageLogPolProjection::_project(const float *inputFrame, float *outputFrame, const unsigned int nbPlanes) const
+{
+    cv::parallel_for_(cv::Range(0, _outputNBrows), Parallel_logPolProjection(inputFrame, outputFrame, _projectionMap, _filterOutput.getNBcolumns(), _filterOutput.getNBpixels(), nbPlanes));
+}
+
+#ifdef HAVE_OPENCL
+static bool ocl_applyProjection(InputArray _src, OutputArray _dst, const Mat &projectionMap)
+{
+    ocl::Kernel kernel("logPolProjection", ocl::bioinspired::imagelogpolprojection_oclsrc);
+    if (kernel.empty())
+        return false;
+
+    UMat src = _src.getUMat(), map = projectionMap.getUMat(ACCESS_READ);
+    _dst.create(projectionMap.size(), CV_32FC1);
+    UMat dst = _dst.getUMat();
+    kernel.args(ocl::KernelArg::ReadOnlyNoSize(src), ocl::KernelArg::ReadOnlyNoSize(map), ocl::KernelArg::WriteOnly(dst));
+
+    size_t globalsize[2] = { (size_t)dst.cols, (size_t)dst.rows };
+    return kernel.run(2, globalsize, NULL, false);
+}
+#endif
+
+void ImageLogPolProjection::applyProjection(InputArray src, OutputArray dst) const
+{
+    CV_Assert(src.type() == CV_32FC1 && src.size() == Size(_filterOutput.getNBcolumns(), _filterOutput.getNBrows()));
+#ifdef HAVE_OPENCL
+    if (src.isUMat() && dst.isUMat() && ocl::useOpenCL() && ocl_applyProjection(src, dst, _projectionMap))
+        return;
+#endif
+    Mat input = src.getMat();
+    if (!input.isContinuous())
+        input = input.clone();
+    dst.create(_projectionMap.size(), CV_32FC1);
+    Mat output = dst.getMat();
+    CV_Assert(output.isContinuous());
+    _project(input.ptr<float>(), output.ptr<float>(), 1);
+}
+
 // action function
 std::valarray<float> &ImageLogPolProjection::runProjection(const std::valarray<float> &inputFrame, const bool colorMode)
 {
@@ -409,17 +504,8 @@ std::valarray<float> &ImageLogPolProjection::runProjection(const std::valarray<f
         _spatiotemporalLPfilter_Irregular(get_data(inputFrame)+_filterOutput.getNBpixels()*2, &_irregularLPfilteredFrame[0]);
         _spatiotemporalLPfilter_Irregular(&_irregularLPfilteredFrame[0], &_tempBuffer[0]+_filterOutput.getNBpixels()*2);
 
-        // applying image projection/resampling
-        register unsigned int *transformTablePTR=&_transformTable[0];
-        for (unsigned int i=0 ; i<_usefullpixelIndex ; i+=2, transformTablePTR+=2)
-        {
-#ifdef IMAGELOGPOLPROJECTION_DEBUG
-            std::cout<<"ImageLogPolProjection::i:"<<i<<"output(max="<<_outputNBpixels<<")="<<_transformTable[i]<<" / intput(max="<<_filterOutput.getNBpixels()<<")="<<_transformTable[i+1]<<std::endl;
-#endif
-            _sampledFrame[*(transformTablePTR)]=_tempBuffer[*(transformTablePTR+1)];
-            _sampledFrame[*(transformTablePTR)+_outputNBpixels]=_tempBuffer[*(transformTablePTR+1)+_filterOutput.getNBpixels()];
-            _sampledFrame[*(transformTablePTR)+_outputDoubleNBpixels]=_tempBuffer[*(transformTablePTR+1)+_inputDoubleNBpixels];
-        }
+        // applying image projection/resampling to the 3 planes together
+        _project(&_tempBuffer[0], &_sampledFrame[0], 3);
 
 #ifdef IMAGELOGPOLPROJECTION_DEBUG
         std::cout<<"ImageLogPolProjection::runProjection: color image projection OK"<<std::endl;
@@ -430,14 +516,7 @@ std::valarray<float> &ImageLogPolProjection::runProjection(const std::valarray<f
         _spatiotemporalLPfilter_Irregular(get_data(inputFrame), &_irregularLPfilteredFrame[0]);
         _spatiotemporalLPfilter_Irregular(&_irregularLPfilteredFrame[0], &_irregularLPfilteredFrame[0]);
         // applying image projection/resampling
-        register unsigned int *transformTablePTR=&_transformTable[0];
-        for (unsigned int i=0 ; i<_usefullpixelIndex ; i+=2, transformTablePTR+=2)
-        {
-#ifdef IMAGELOGPOLPROJECTION_DEBUG
-            std::cout<<"i:"<<i<<"output(max="<<_outputNBpixels<<")="<<_transformTable[i]<<" / intput(max="<<_filterOutput.getNBpixels()<<")="<<_transformTable[i+1]<<std::endl;
-#endif
-            _sampledFrame[*(transformTablePTR)]=_irregularLPfilteredFrame[*(transformTablePTR+1)];
-        }
+        _project(&_irregularLPfilteredFrame[0], &_sampledFrame[0], 1);
         //normalizeGrayOutput_0_maxOutputValue(_sampledFrame, _outputNBpixels);
 #ifdef IMAGELOGPOLPROJECTION_DEBUG
         std::cout<<"ImageLogPolProjection::runProjection: gray level image projection OK"<<std::endl;
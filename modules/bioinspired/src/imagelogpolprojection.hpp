@@ -189,6 +189,20 @@ public:
     */
     inline const std::valarray<unsigned int> &getSamplingMap() const { return _transformTable; }
 
+    /**
+    * function which gives the transformation as a cv::remap compatible map of CV_16SC2 integer input coordinates, of the output size,
+    * the output pixels which have no input pixel are mapped outside of the input image
+    * @return the projection map
+    */
+    inline const cv::Mat &getProjectionMap() const { return _projectionMap; }
+
+    /**
+    * applies the projection, without the prefilter, to one plane of the input size, on OpenCL if both are UMat
+    * @param src: the plane to project, CV_32F of the input size
+    * @param dst: the projected plane of the output size, zero where the projection has no input pixel
+    */
+    void applyProjection(InputArray src, OutputArray dst) const;
+
     inline double getOriginalRadiusLength(const double projectedRadiusLength)
     { return _azero/(_alim-projectedRadiusLength*2.0/_minDimension); }
 
@@ -220,6 +234,7 @@ private:
     std::valarray<float>_sampledFrame;
     std::valarray<float>&_tempBuffer;
     std::valarray<unsigned int>_transformTable;
+    cv::Mat _projectionMap;
 
     std::valarray<float> &_irregularLPfilteredFrame; // just a reference for easier understanding
     unsigned int _usefullpixelIndex;
@@ -233,6 +248,10 @@ private:
     // private init projections functions called by "initProjection(...)" function
     bool _initLogRetinaSampling(const double reductionFactor, const double samplingStrenght);
     bool _initLogPolarCortexSampling(const double reductionFactor, const double samplingStrenght);
+    // builds the projection map from the transform table
+    void _initProjectionMap();
+    // projects nbPlanes consecutive planes of the input size to consecutive planes of the output size
+    void _project(const float *inputFrame, float *outputFrame, const unsigned int nbPlanes) const;
 
     ImageLogPolProjection(const ImageLogPolProjection&);
     ImageLogPolProjection& operator=(const ImageLogPolProjection&);
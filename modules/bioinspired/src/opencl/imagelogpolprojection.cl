@@ -0,0 +1,23 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+// nearest neighbour gather of ImageLogPolProjection, the map holds the short (x, y) input coordinates of each
+// output pixel, negative for the output pixels which have no input pixel
+__kernel void logPolProjection(__global const uchar *srcptr, int src_step, int src_offset,
+                               __global const uchar *mapptr, int map_step, int map_offset,
+                               __global uchar *dstptr, int dst_step, int dst_offset, int dst_rows, int dst_cols)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+    if (x >= dst_cols || y >= dst_rows)
+        return;
+
+    __global const short *map = (__global const short *)(mapptr + mad24(y, map_step, mad24(x, 4, map_offset)));
+    __global float *dst = (__global float *)(dstptr + mad24(y, dst_step, mad24(x, 4, dst_offset)));
+    int sx = map[0], sy = map[1];
+    if (sx < 0)
+        dst[0] = 0.f;
+    else
+        dst[0] = *(__global const float *)(srcptr + mad24(sy, src_step, mad24(sx, 4, src_offset)));
+}
@@ -47,6 +47,7 @@
 #include "opencv2/bioinspired.hpp"
 #include "opencv2/core/utility.hpp"
 #include "opencv2/core/private.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include "opencv2/core/ocl.hpp"
 
 #include <valarray>
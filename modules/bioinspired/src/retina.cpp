@@ -300,6 +300,45 @@ Ptr<Retina> createRetina(Size inputSize, const bool colorMode, int colorSampling
     return makePtr<RetinaImpl>(inputSize, colorMode, colorSamplingMethod, useRetinaLogSampling, reductionFactor, samplingStrenght);
 }
 
+// the retinas are independent, a stream runs on one thread and the parallel loops of its filters are then sequential
+class RetinasInvoker : public ParallelLoopBody
+{
+public:
+    RetinasInvoker(const std::vector<Ptr<Retina> > &_retinas, const std::vector<Mat> &_images)
+        : retinas(_retinas), images(_images)
+    {
+    }
+
+    void operator()(const Range &range) const
+    {
+        for (int i = range.start; i < range.end; i++)
+            retinas[i]->run(images[i]);
+    }
+
+private:
+    const std::vector<Ptr<Retina> > &retinas;
+    const std::vector<Mat> &images;
+
+    RetinasInvoker& operator=(const RetinasInvoker&); // to quiet MSVC
+};
+
+void runRetinas(const std::vector<Ptr<Retina> >& retinas, InputArrayOfArrays inputImages)
+{
+    int nstreams = (int)retinas.size();
+    CV_Assert((int)inputImages.total() == nstreams);
+
+    // the sizes are checked here rather than by the exception of run() in the parallel loop
+    std::vector<Mat> images(nstreams);
+    for (int i = 0; i < nstreams; i++)
+    {
+        CV_Assert(!retinas[i].empty());
+        images[i] = inputImages.getMat(i);
+        CV_Assert(images[i].size() == retinas[i]->getInputSize());
+    }
+
+    parallel_for_(Range(0, nstreams), RetinasInvoker(retinas, images));
+}
+
 
 // RetinaImpl code
 RetinaImpl::RetinaImpl(const cv::Size inputSz)
@@ -317,20 +317,31 @@ namespace bioinspired
             Parallel_adaptiveVerticalAnticausalFilter_multGain(float *bufferToProcess, const float *imageGrad, const unsigned int nbRws, const unsigned int nbCols, const float  gain)
                 :outputFrame(bufferToProcess), imageGradient(imageGrad), nbRows(nbRws), nbColumns(nbCols), filterParam_gain(gain) { }
 
+            // the band of columns is swept row by row from the last one, the results of the band are kept aside
             virtual void operator()( const Range& r ) const {
-                float* offset=outputFrame+nbColumns*nbRows-nbColumns;
-                const float* gradOffset= imageGradient+nbColumns*nbRows-nbColumns;
-                for (int IDcolumn=r.start; IDcolumn!=r.end; ++IDcolumn)
+                cv::AutoBuffer<float> resultBuffer(r.end-r.start);
+                float *result=(float*)resultBuffer-r.start;
+                for (int IDcolumn=r.start; IDcolumn<r.end; ++IDcolumn)
+                    result[IDcolumn]=0;
+
+                for (unsigned int index=nbRows; index>0; --index)
                 {
-                    register float result=0;
-                    register float *outputPTR=offset+IDcolumn;
-                    register const float *imageGradientPTR=gradOffset+IDcolumn;
-                    for (unsigned int index=0; index<nbRows; ++index)
+                    float *outputPTR=outputFrame+(index-1)*nbColumns;
+                    const float *imageGradientPTR=imageGradient+(index-1)*nbColumns;
+                    int IDcolumn=r.start;
+#if CV_SIMD128
+                    v_float32x4 v_gain=v_setall_f32(filterParam_gain);
+                    for (; IDcolumn<=r.end-4; IDcolumn+=4)
+                    {
+                        v_float32x4 v_result=v_load(outputPTR+IDcolumn) + v_load(imageGradientPTR+IDcolumn)*v_load(result+IDcolumn);
+                        v_store(result+IDcolumn, v_result);
+                        v_store(outputPTR+IDcolumn, v_gain*v_result);
+                    }
+#endif
+                    for (; IDcolumn<r.end; ++IDcolumn)
                     {
-                        result = *(outputPTR) + *(imageGradientPTR) * result;
-                        *(outputPTR) = filterParam_gain*result;
-                        outputPTR-=nbColumns;
-                        imageGradientPTR-=nbColumns;
+                        result[IDcolumn] = outputPTR[IDcolumn] + imageGradientPTR[IDcolumn] * result[IDcolumn];
+                        outputPTR[IDcolumn] = filterParam_gain*result[IDcolumn];
                     }
                 }
             }
@@ -141,7 +141,8 @@ public:
         if (colorMode)
         {
             _runRGBToneMapping(_inputBuffer, _imageOutput, true);
-            _convertValarrayBuffer2cvMat(_imageOutput, _multiuseFilter->getNBrows(), _multiuseFilter->getNBcolumns(), true, outputToneMappedImage);
+            // the color result is read where the color engine leaves it
+            _convertValarrayBuffer2cvMat(_colorEngine->getDemultiplexedColorFrame(), _multiuseFilter->getNBrows(), _multiuseFilter->getNBcolumns(), true, outputToneMappedImage);
         }
         else
         {
@@ -175,6 +176,8 @@ private:
     std::valarray<float> _inputBuffer;
     std::valarray<float> _imageOutput;
     std::valarray<float> _temp2;
+    //!< input converted to float when it is not, kept from a frame to the next one
+    Mat _inputFloatBuffer;
     float _meanLuminanceModulatorK;
 
 
@@ -188,11 +191,9 @@ void _convertValarrayBuffer2cvMat(const std::valarray<float> &grayMatrixToConver
         Mat outMat = outBuffer.getMat();
         for (unsigned int i=0;i<nbRows;++i)
         {
+            unsigned char *outPTR=outMat.ptr<unsigned char>(i);
             for (unsigned int j=0;j<nbColumns;++j)
-            {
-                cv::Point2d pixel(j,i);
-                outMat.at<unsigned char>(pixel)=(unsigned char)*(valarrayPTR++);
-            }
+                outPTR[j]=(unsigned char)*(valarrayPTR++);
         }
     }
     else
@@ -203,15 +204,12 @@ void _convertValarrayBuffer2cvMat(const std::valarray<float> &grayMatrixToConver
         Mat outMat = outBuffer.getMat();
         for (unsigned int i=0;i<nbRows;++i)
         {
+            cv::Vec3b *outPTR=outMat.ptr<cv::Vec3b>(i);
             for (unsigned int j=0;j<nbColumns;++j,++valarrayPTR)
             {
-                cv::Point2d pixel(j,i);
-                cv::Vec3b pixelValues;
-                pixelValues[2]=(unsigned char)*(valarrayPTR);
-                pixelValues[1]=(unsigned char)*(valarrayPTR+nbPixels);
-                pixelValues[0]=(unsigned char)*(valarrayPTR+doubleNBpixels);
-
-                outMat.at<cv::Vec3b>(pixel)=pixelValues;
+                outPTR[j][2]=(unsigned char)*(valarrayPTR);
+                outPTR[j][1]=(unsigned char)*(valarrayPTR+nbPixels);
+                outPTR[j][0]=(unsigned char)*(valarrayPTR+doubleNBpixels);
             }
         }
     }
@@ -231,8 +229,16 @@ bool _convertCvMat2ValarrayBuffer(InputArray inputMat, std::valarray<float> &out
     typedef float T; // define here the target pixel format, here, float
     const int dsttype = DataType<T>::depth; // output buffer is float format
 
-    const unsigned int nbPixels=inputMat.getMat().rows*inputMat.getMat().cols;
-    const unsigned int doubleNBpixels=inputMat.getMat().rows*inputMat.getMat().cols*2;
+    const unsigned int nbPixels=inputMatToConvert.rows*inputMatToConvert.cols;
+    const unsigned int doubleNBpixels=nbPixels*2;
+
+    // the color planes are split from a float image, converted into the persistent buffer if needed
+    Mat floatInput=inputMatToConvert;
+    if (imageNumberOfChannels>1 && inputMatToConvert.depth()!=dsttype)
+    {
+        inputMatToConvert.convertTo(_inputFloatBuffer, dsttype);
+        floatInput=_inputFloatBuffer;
+    }
 
     if(imageNumberOfChannels==4)
     {
@@ -245,7 +251,7 @@ bool _convertCvMat2ValarrayBuffer(InputArray inputMat, std::valarray<float> &out
         };
         planes[3] = cv::Mat(inputMatToConvert.size(), dsttype);     // last channel (alpha) does not point on the valarray (not usefull in our case)
         // split color cv::Mat in 4 planes... it fills valarray directely
-        cv::split(Mat_<Vec<T, 4> >(inputMatToConvert), planes);
+        cv::split(floatInput, planes);
     }
     else if (imageNumberOfChannels==3)
     {
@@ -257,7 +263,7 @@ bool _convertCvMat2ValarrayBuffer(InputArray inputMat, std::valarray<float> &out
         cv::Mat(inputMatToConvert.size(), dsttype, &outputValarrayMatrix[0])
         };
         // split color cv::Mat in 3 planes... it fills valarray directely
-        cv::split(cv::Mat_<Vec<T, 3> >(inputMatToConvert), planes);
+        cv::split(floatInput, planes);
     }
     else if(imageNumberOfChannels==1)
     {
@@ -300,11 +306,8 @@ void _runRGBToneMapping(const std::valarray<float> &RGBimageInput, std::valarray
     // demultiplex tone maped image
     _colorEngine->runColorDemultiplexing(RGBimageOutput, useAdaptiveFiltering, _multiuseFilter->getMaxInputValue());//_ColorEngine->getMultiplexedFrame());//_ParvoRetinaFilter->getPhotoreceptorsLPfilteringOutput());
 
-    // rescaling result between 0 and 255
+    // rescaling result between 0 and 255, the result stays in the demultiplexed frame of the color engine
     _colorEngine->normalizeRGBOutput_0_maxOutputValue(255.0);
-
-    // return the result
-    RGBimageOutput=_colorEngine->getDemultiplexedColorFrame();
 }
 
 };
@@ -180,10 +180,9 @@ protected:
 
     /**
      * main processing method
-     * @param inputToSegment : the image to process as a valarray buffer it must match the instance buffer size !
-     * @param channelIndex : the channel to process in case of multichannel images
+     * @param inputToSegment : the single channel float image to process, it must match the instance buffer size !
      */
-    void _run(const std::valarray<float> &inputToSegment, const int channelIndex=0);
+    void _run(const float *inputToSegment);
 
     /**
      * access function
@@ -207,7 +206,7 @@ protected:
     // template buffers and related acess pointers
     std::valarray<float> _inputToSegment;
     std::valarray<float> _contextMotionEnergy;
-    std::valarray<bool> _segmentedAreas;
+    std::valarray<unsigned char> _segmentedAreas;
 
     // pointers to base class buffers
     std::valarray<float> &_localMotion;
@@ -218,7 +217,7 @@ protected:
     cv::Mat _segmentedPicture;
 
     // Buffer conversion utilities
-    void _convertValarrayBuffer2cvMat(const std::valarray<bool> &grayMatrixToConvert, const unsigned int nbRows, const unsigned int nbColumns, OutputArray outBuffer);
+    void _convertValarrayBuffer2cvMat(const std::valarray<unsigned char> &grayMatrixToConvert, const unsigned int nbRows, const unsigned int nbColumns, OutputArray outBuffer);
     bool _convertCvMat2ValarrayBuffer(InputArray inputMat, std::valarray<float> &outputValarrayMatrix);
 	
     const TransientAreasSegmentationModuleImpl & operator = (const TransientAreasSegmentationModuleImpl &);
@@ -252,6 +251,46 @@ Ptr<TransientAreasSegmentationModule> createTransientAreasSegmentationModule(Siz
     return makePtr<TransientAreasSegmentationModuleImpl_>(inputSize);
 };
 
+// the segmentation modules are independent, a stream runs on one thread and the parallel loops of its filters are then sequential
+class TransientAreasSegmentationsInvoker : public ParallelLoopBody
+{
+public:
+    TransientAreasSegmentationsInvoker(const std::vector<Ptr<TransientAreasSegmentationModule> > &_segmenters, const std::vector<Mat> &_images, int _channelIndex)
+        : segmenters(_segmenters), images(_images), channelIndex(_channelIndex)
+    {
+    }
+
+    void operator()(const Range &range) const
+    {
+        for (int i = range.start; i < range.end; i++)
+            segmenters[i]->run(images[i], channelIndex);
+    }
+
+private:
+    const std::vector<Ptr<TransientAreasSegmentationModule> > &segmenters;
+    const std::vector<Mat> &images;
+    int channelIndex;
+
+    TransientAreasSegmentationsInvoker& operator=(const TransientAreasSegmentationsInvoker&); // to quiet MSVC
+};
+
+void runTransientAreasSegmentations(const std::vector<Ptr<TransientAreasSegmentationModule> >& segmenters, InputArrayOfArrays inputImages, const int channelIndex)
+{
+    int nstreams = (int)segmenters.size();
+    CV_Assert((int)inputImages.total() == nstreams);
+
+    // the sizes are checked here rather than by the exception of run() in the parallel loop
+    std::vector<Mat> images(nstreams);
+    for (int i = 0; i < nstreams; i++)
+    {
+        CV_Assert(!segmenters[i].empty());
+        images[i] = inputImages.getMat(i);
+        CV_Assert(images[i].size() == segmenters[i]->getSize() && 0 <= channelIndex && channelIndex < images[i].channels());
+    }
+
+    parallel_for_(Range(0, nstreams), TransientAreasSegmentationsInvoker(segmenters, images, channelIndex));
+}
+
 // Constructor and destructors
 TransientAreasSegmentationModuleImpl::TransientAreasSegmentationModuleImpl(const Size size)
 :BasicRetinaFilter(size.height, size.width, 3),
@@ -430,23 +469,83 @@ void TransientAreasSegmentationModuleImpl::run(InputArray inputToProcess, const
     	throw cv::Exception(-1, errorMsg.str().c_str(), "SegmentationModule::run", "SegmentationModule.cpp", 0);
     }
 
-    // create a cv::Mat header for the input valarray
-    // convert to float AND fill the valarray buffer
+    // a continuous single channel float image is read in place, the filters do not modify their input
+    if (inputToSegment.type() == CV_32FC1 && inputToSegment.isContinuous())
+    {
+        _run(inputToSegment.ptr<float>());
+        return;
+    }
+
+    // else the processed channel is converted to float into the valarray buffer
     typedef float T; // define here the target pixel format, here, float
     const int dsttype = cv::DataType<T>::depth; // output buffer is float format
     cv::Mat dst(inputToSegment.size(), dsttype, &_inputToSegment[0]);
-    inputToSegment.convertTo(dst, dsttype);
-    //cv::imshow("Mask",dst);
-    //cv::waitKey();
+    if (inputToSegment.channels() > 1)
+    {
+        cv::Mat channel;
+        cv::extractChannel(inputToSegment, channel, channelIndex);
+        channel.convertTo(dst, dsttype);
+    }
+    else
+        inputToSegment.convertTo(dst, dsttype);
     // call the low level method
-    _run(_inputToSegment, channelIndex);
+    _run(&_inputToSegment[0]);
 }
 
-void TransientAreasSegmentationModuleImpl::_run(const std::valarray<float> &inputToSegment, const int channelIndex)
+// the segmentation decision of each pixel only depends on the filter outputs at that pixel
+class Parallel_segmentationDecision: public cv::ParallelLoopBody
 {
-#ifdef SEGMENTATIONDEBUG
-    std::cout<<"Input length vs internal buffers length = "<<inputToSegment.size()<<", "<<_localMotion.size()<<std::endl;
+private:
+    const float *localMotion, *neighborhoodMotion, *contextMotion;
+    unsigned char *segmentedAreas;
+    unsigned int nbColumns;
+    float thresholdON;
+public:
+    Parallel_segmentationDecision(const float *localMotionBuffer, const float *neighborhoodMotionBuffer, const float *contextMotionBuffer,
+                                  unsigned char *segmentationBuffer, const unsigned int nbCols, const float thON)
+        :localMotion(localMotionBuffer), neighborhoodMotion(neighborhoodMotionBuffer), contextMotion(contextMotionBuffer),
+         segmentedAreas(segmentationBuffer), nbColumns(nbCols), thresholdON(thON){}
+
+    virtual void operator()( const Range& r ) const {
+        // the motion context must be positive and above thresholdON, so it is compared to the larger of the two
+        const float contextThreshold=std::max(thresholdON, 0.f);
+        for (int IDrow=r.start; IDrow!=r.end; ++IDrow)
+        {
+            const unsigned int offset=IDrow*nbColumns;
+            const float *localMotionPTR=localMotion+offset, *neighborhoodMotionPTR=neighborhoodMotion+offset, *contextMotionPTR=contextMotion+offset;
+            unsigned char *segmentationPicturePTR=segmentedAreas+offset;
+            int index=0;
+#if CV_SIMD128
+            const v_float32x4 vContextThreshold=v_setall_f32(contextThreshold), vThresholdON=v_setall_f32(thresholdON);
+            const v_int32x4 vOne=v_setall_s32(1);
+            for (; index<=(int)nbColumns-16; index+=16)
+            {
+                v_int32x4 decisions[4];
+                for (int k=0; k<4; ++k)
+                {
+                    v_float32x4 neighborhood=v_load(neighborhoodMotionPTR+index+4*k);
+                    v_float32x4 generalMotionContextDecision=neighborhood-v_load(contextMotionPTR+index+4*k);
+                    v_float32x4 localDecision=v_load(localMotionPTR+index+4*k)-neighborhood;
+                    decisions[k]=v_reinterpret_as_s32((generalMotionContextDecision>vContextThreshold) & (localDecision>vThresholdON)) & vOne;
+                }
+                v_store(segmentationPicturePTR+index, v_pack_u(v_pack(decisions[0], decisions[1]), v_pack(decisions[2], decisions[3])));
+            }
 #endif
+            for (; index<(int)nbColumns; ++index)
+            {
+                float generalMotionContextDecision=neighborhoodMotionPTR[index]-contextMotionPTR[index];
+                /* apply segmentation on local motion superior to its neighborhood
+                 * => to segment objects moving faster than their neighborhood
+                 */
+                segmentationPicturePTR[index]=(unsigned char)(generalMotionContextDecision>contextThreshold
+                                                              && (localMotionPTR[index]-neighborhoodMotionPTR[index])>thresholdON);
+            }
+        }
+    }
+};
+
+void TransientAreasSegmentationModuleImpl::_run(const float *inputToSegment)
+{
     // preliminary basic error check
     // FIXME validate basic tests
     //if (inputToSegment.size() != _localMotion.size())
@@ -454,7 +553,7 @@ void TransientAreasSegmentationModuleImpl::_run(const std::valarray<float> &inpu
 
     // first square the input in order to increase the signal to noise ratio
     // get motion local energy
-    _squaringSpatiotemporalLPfilter(&const_cast<std::valarray<float>&>(inputToSegment)[channelIndex*getNBpixels()], &_localMotion[0]);
+    _squaringSpatiotemporalLPfilter(inputToSegment, &_localMotion[0]);
 
     // second low pass filter: access to the neighborhood motion energy
     _spatiotemporalLPfilter(&_localMotion[0], &_neighborhoodMotion[0], 1);
@@ -462,47 +561,9 @@ void TransientAreasSegmentationModuleImpl::_run(const std::valarray<float> &inpu
     // third low pass filter: access to the background motion energy
     _spatiotemporalLPfilter(&_localMotion[0], &_contextMotionEnergy[0], 2);
 
-    // compute the ON and OFF ways (positive and negative values of the difference of the two filterings)
-    float*localMotionPTR=&_localMotion[0], *neighborhoodMotionPTR=&_neighborhoodMotion[0], *contextMotionPTR=&_contextMotionEnergy[0];
-
-    // float meanEnergy=LPfilter2.sum()/(float)_LPfilter2.size();
-    register bool *segmentationPicturePTR= &_segmentedAreas[0];
-    for (unsigned int index=0; index<_filterOutput.getNBpixels() ; ++index, ++segmentationPicturePTR, ++localMotionPTR, ++neighborhoodMotionPTR, contextMotionPTR++)
-    {
-        float generalMotionContextDecision=*neighborhoodMotionPTR-*contextMotionPTR;
-
-        if (generalMotionContextDecision>0) // local maximum should be detected in this case
-        {
-            /* apply segmentation on local motion superior to its neighborhood
-             * => to segment objects moving faster than their neighborhood
-             */
-            if (generalMotionContextDecision>_segmentationParameters.thresholdON)// && meanEnergy*1.1<*neighborhoodMotionPTR)
-            {
-                *segmentationPicturePTR=((*localMotionPTR-*neighborhoodMotionPTR)>_segmentationParameters.thresholdON);
-            }
-            else
-                *segmentationPicturePTR=false;
-        }
-#ifdef USE_LOCALMINIMUMS
-        else  // local minimum should be detected in this case
-        {
-            /* apply segmentation for non moving objects
-             * only if the wide area around motion energy is high
-             * => to segment object moving slower than the neighborhood
-             */
-            if (-1.0*generalMotionContextDecision>_segmentationParameters.thresholdOFF && meanEnergy*0.9>*neighborhoodMotionPTR)
-            {
-                /* in order to segment non moving objects in a camera motion case
-                 * we focus on local energy which is much lower than the wide neighborhood
-                 */
-                *segmentationPicturePTR+=(*neighborhoodMotionPTR-*localMotionPTR>_segmentationParameters.thresholdOFF)*127;
-            }
-        }
-#else
-        else
-            *segmentationPicturePTR=false;
-#endif
-    }
+    // compute the ON way (positive values of the difference of the two filterings), the rows are independent
+    cv::parallel_for_(cv::Range(0, getNBrows()), Parallel_segmentationDecision(&_localMotion[0], &_neighborhoodMotion[0], &_contextMotionEnergy[0],
+                                                                              &_segmentedAreas[0], getNBcolumns(), _segmentationParameters.thresholdON));
     /*
 #ifdef SEGMENTATIONDEBUG
     std::cout<<"ON: max, min="<<_localMotionON.min()<<", "<<_localMotionON.max();
@@ -520,21 +581,10 @@ void TransientAreasSegmentationModuleImpl::getSegmentationPicture(OutputArray tr
 }
 
 
-void TransientAreasSegmentationModuleImpl::_convertValarrayBuffer2cvMat(const std::valarray<bool> &grayMatrixToConvert, const unsigned int nbRows, const unsigned int nbColumns, OutputArray outBuffer)
+void TransientAreasSegmentationModuleImpl::_convertValarrayBuffer2cvMat(const std::valarray<unsigned char> &grayMatrixToConvert, const unsigned int nbRows, const unsigned int nbColumns, OutputArray outBuffer)
 {
     // fill output buffer with the valarray buffer
-    const bool *valarrayPTR=get_data(grayMatrixToConvert);
-   
-    outBuffer.create(cv::Size(nbColumns, nbRows), CV_8U);
-    Mat outMat = outBuffer.getMat();
-    for (unsigned int i=0;i<nbRows;++i)
-    {
-        for (unsigned int j=0;j<nbColumns;++j)
-        {
-            cv::Point2d pixel(j,i);
-            outMat.at<unsigned char>(pixel)=(unsigned char)*(valarrayPTR++);
-        }
-    }
+    cv::Mat(nbRows, nbColumns, CV_8U, (void*)get_data(grayMatrixToConvert)).copyTo(outBuffer);
 }
 
 bool TransientAreasSegmentationModuleImpl::_convertCvMat2ValarrayBuffer(InputArray inputMat, std::valarray<float> &outputValarrayMatrix)
@@ -0,0 +1,90 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace cv::bioinspired;
+
+TEST(Bioinspired_RetinaStreams, same_as_run)
+{
+    const int nstreams = 3, nframes = 3;
+    Size size(64, 48);
+    RNG& rng = theRNG();
+
+    std::vector<Ptr<Retina> > retinas, references;
+    for (int i = 0; i < nstreams; i++)
+    {
+        bool colorMode = i != 1;
+        retinas.push_back(createRetina(size, colorMode));
+        references.push_back(createRetina(size, colorMode));
+    }
+
+    for (int t = 0; t < nframes; t++)
+    {
+        std::vector<Mat> frames(nstreams);
+        for (int i = 0; i < nstreams; i++)
+        {
+            frames[i].create(size, i == 1 ? CV_8UC1 : CV_8UC3);
+            rng.fill(frames[i], RNG::UNIFORM, 0, 256);
+            references[i]->run(frames[i]);
+        }
+
+        runRetinas(retinas, frames);
+
+        for (int i = 0; i < nstreams; i++)
+        {
+            EXPECT_EQ(0, cvtest::norm(retinas[i]->getParvoRAW(), references[i]->getParvoRAW(), NORM_INF));
+            EXPECT_EQ(0, cvtest::norm(retinas[i]->getMagnoRAW(), references[i]->getMagnoRAW(), NORM_INF));
+        }
+    }
+}
+
+TEST(Bioinspired_TransientAreasSegmentationStreams, same_as_run)
+{
+    const int nstreams = 3, nframes = 3;
+    Size size(67, 45);
+    RNG& rng = theRNG();
+
+    std::vector<Ptr<TransientAreasSegmentationModule> > segmenters, references;
+    for (int i = 0; i < nstreams; i++)
+    {
+        segmenters.push_back(createTransientAreasSegmentationModule(size));
+        references.push_back(createTransientAreasSegmentationModule(size));
+    }
+
+    for (int t = 0; t < nframes; t++)
+    {
+        // the references run on gray 8 bits images, the streams on the same values as a float image
+        // read in place and as the first channel of a color image
+        std::vector<Mat> frames(nstreams);
+        for (int i = 0; i < nstreams; i++)
+        {
+            Mat gray(size, CV_8UC1);
+            rng.fill(gray, RNG::UNIFORM, 0, 256);
+            references[i]->run(gray);
+
+            if (i == 1)
+                gray.convertTo(frames[i], CV_32F);
+            else if (i == 2)
+            {
+                Mat planes[] = { gray, Mat(size, CV_8UC1, Scalar(17)), Mat(size, CV_8UC1, Scalar(255)) };
+                merge(planes, 3, frames[i]);
+            }
+            else
+                frames[i] = gray;
+        }
+
+        runTransientAreasSegmentations(segmenters, frames);
+
+        for (int i = 0; i < nstreams; i++)
+        {
+            Mat segmentation, reference;
+            segmenters[i]->getSegmentationPicture(segmentation);
+            references[i]->getSegmentationPicture(reference);
+            ASSERT_EQ(CV_8UC1, segmentation.type());
+            EXPECT_EQ(0, cvtest::norm(segmentation, reference, NORM_INF)) << "stream " << i;
+        }
+    }
+}
@@ -157,15 +157,21 @@ public:
     void writeParameters(const std::string& filename);
 
 private:
+    friend class CameraCalibrationInvoker;
+    friend class EdgeJacobianInvoker;
+
     std::vector<std::string> readStringList();
 
     int getPhotoVertex(int timestamp);
 
-    void graphTraverse(const Mat& G, int begin, std::vector<int>& order, std::vector<int>& pre);
+    double calibrateSingleCamera(int camera, const Size& imageSize, Mat& idx);
+
+    void graphTraverse(const std::vector<std::vector<int> >& vertexEdges, int begin, std::vector<int>& order,
+        std::vector<int>& pre, std::vector<int>& preEdge);
 
-    void findRowNonZero(const Mat& row, Mat& idx);
+    void computeExtrinsicStep(const Mat& extrinsicParams, Mat& G);
 
-    void computeJacobianExtrinsic(const Mat& extrinsicParams, Mat& JTJ_inv, Mat& JTE);
+    void computeEdgeJacobian(const Mat& extrinsicParams, int edgeIdx, Mat& jacobianPhoto, Mat& jacobianCamera, Mat& error);
 
     void computePhotoCameraJacobian(const Mat& rvecPhoto, const Mat& tvecPhoto, const Mat& rvecCamera,
         const Mat& tvecCamera, Mat& rvecTran, Mat& tvecTran, const Mat& objectPoints, const Mat& imagePoints, const Mat& K,
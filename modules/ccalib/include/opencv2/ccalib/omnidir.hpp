@@ -40,6 +40,7 @@
 //M*/
 
 #include <opencv2/core.hpp>
+#include <opencv2/calib3d.hpp>
 #include <vector>
 
 #ifndef __OPENCV_OMNIDIR_HPP__
@@ -240,6 +241,67 @@ namespace omnidir
         OutputArray disparity, OutputArray image1Rec, OutputArray image2Rec, const Size& newSize = Size(), InputArray Knew = cv::noArray(),
         OutputArray pointCloud = cv::noArray(), int pointType = XYZRGB);
 
+    /** @brief Undistortion of the frames of a video, see omnidir::undistortImage. The CV_16SC2 maps of
+    omnidir::initUndistortRectifyMap are computed at the first frame, or when the size of the frames changes,
+    and are uploaded once when the frames are UMat.
+    */
+    class CV_EXPORTS Rectifier
+    {
+    public:
+        Rectifier();
+
+        /** @brief The parameters are the ones of omnidir::undistortImage
+        */
+        Rectifier(InputArray K, InputArray D, InputArray xi, int flags, InputArray Knew = cv::noArray(),
+            const Size& new_size = Size(), InputArray R = Mat::eye(3, 3, CV_64F));
+
+        /** @brief Set new parameters, the maps are computed again at the next frame
+        */
+        void init(InputArray K, InputArray D, InputArray xi, int flags, InputArray Knew = cv::noArray(),
+            const Size& new_size = Size(), InputArray R = Mat::eye(3, 3, CV_64F));
+
+        /** @brief Undistort a frame
+
+        @param distorted The input omnidirectional image, Mat or UMat.
+        @param undistorted The output undistorted image.
+        */
+        void apply(InputArray distorted, OutputArray undistorted);
+
+    private:
+        Mat _K, _D, _xi, _Knew, _R;
+        int _flags;
+        Size _newSize;
+        Mat _map1, _map2;
+        UMat _umap1, _umap2;
+    };
+
+    /** @brief Stereo 3D reconstruction of the frames of a pair of videos, see omnidir::stereoReconstruct.
+    The rectification and its maps, and the stereo matcher, are set up once for all the frames.
+    */
+    class CV_EXPORTS StereoReconstructor
+    {
+    public:
+        /** @brief The parameters are the ones of omnidir::stereoReconstruct
+        */
+        StereoReconstructor(InputArray K1, InputArray D1, InputArray xi1, InputArray K2, InputArray D2, InputArray xi2,
+            InputArray R, InputArray T, int flag, int numDisparities, int SADWindowSize, const Size& newSize = Size(),
+            InputArray Knew = cv::noArray());
+
+        /** @brief Reconstruct a pair of frames, the parameters are the ones of omnidir::stereoReconstruct
+        */
+        void reconstruct(InputArray image1, InputArray image2, OutputArray disparity, OutputArray image1Rec,
+            OutputArray image2Rec, OutputArray pointCloud = cv::noArray(), int pointType = XYZRGB);
+
+    private:
+        Rectifier _rectifier1, _rectifier2;
+        int _flag, _numDisparities, _SADWindowSize;
+        Size _newSize;
+        Matx33d _Knew;
+        double _baseline;
+        Ptr<StereoSGBM> _sgbm;
+        int _sgbmChannels;
+    };
+
 namespace internal
 {
     void initializeCalibration(InputArrayOfArrays objectPoints, InputArrayOfArrays imagePoints, Size size, OutputArrayOfArrays omAll,
@@ -255,6 +317,13 @@ namespace internal
     void computeJacobianStereo(InputArrayOfArrays objectPoints, InputArrayOfArrays imagePoints1, InputArrayOfArrays imagePoints2,
         InputArray parameters, Mat& JTJ_inv, Mat& JTE, int flags, double epsilon);
 
+    // (JTJ + epsilon)^-1 * JTE of computeJacobian, solved view by view without the dense JTJ
+    void computeGaussNewtonStep(InputArrayOfArrays objectPoints, InputArrayOfArrays imagePoints, InputArray parameters, Mat& G, int flags,
+                            double epsilon);
+
+    void computeGaussNewtonStepStereo(InputArrayOfArrays objectPoints, InputArrayOfArrays imagePoints1, InputArrayOfArrays imagePoints2,
+        InputArray parameters, Mat& G, int flags, double epsilon);
+
     void encodeParameters(InputArray K, InputArrayOfArrays omAll, InputArrayOfArrays tAll, InputArray distoaration, double xi, OutputArray parameters);
 
     void encodeParametersStereo(InputArray K1, InputArray K2, InputArray om, InputArray T, InputArrayOfArrays omL, InputArrayOfArrays tL,
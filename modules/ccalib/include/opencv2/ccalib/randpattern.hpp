@@ -88,6 +88,14 @@ public:
     */
     void loadPattern(cv::Mat patternImage);
 
+    /* @brief Set the scale of a first detection in the images, 1 by default for no first detection.
+    With a scale lower than 1, the homography to the pattern is estimated from the downscaled image first.
+    It chooses which of the image and its equalized histogram is detected at full resolution, and replaces
+    the fundamental matrix RANSAC in the removal of the outliers.
+    @param scale the scale of the first detection, in (0, 1]
+    */
+    void setDetectionScale(double scale);
+
     /* @brief Compute matched object points and image points which are used for calibration
     The objectPoints (3D) and imagePoints (2D) are stored inside the class. Run getObjectPoints()
     and getImagePoints() to get them.
@@ -126,19 +134,20 @@ private:
     Ptr<FeatureDetector> _detector;
     Ptr<DescriptorExtractor> _descriptor;
     Ptr<DescriptorMatcher> _matcher;
+    Ptr<DescriptorMatcher> _patternMatcher;
     Mat _descriptorPattern;
     std::vector<cv::KeyPoint> _keypointsPattern;
     Mat _patternImage;
     int _showExtraction;
+    double _detectionScale;
 
     void keyPoints2MatchedLocation(const std::vector<cv::KeyPoint>& imageKeypoints,
         const std::vector<cv::KeyPoint>& patternKeypoints, const std::vector<cv::DMatch> matchces,
         cv::Mat& matchedImagelocation, cv::Mat& matchedPatternLocation);
     void getFilteredLocation(cv::Mat& imageKeypoints, cv::Mat& patternKeypoints, const cv::Mat mask);
     void getObjectImagePoints(const cv::Mat& imageKeypoints, const cv::Mat& patternKeypoints);
-    void crossCheckMatching( cv::Ptr<DescriptorMatcher>& descriptorMatcher,
-        const Mat& descriptors1, const Mat& descriptors2,
-        std::vector<DMatch>& filteredMatches12, int knn=1 );
+    void crossCheckMatching( const Mat& descriptors, std::vector<DMatch>& filteredMatches12, int knn=1 );
+    void matchImage(const Mat& image, int& variant, std::vector<cv::KeyPoint>& keypoints, std::vector<cv::DMatch>& matches);
     void drawCorrespondence(const Mat& image1, const std::vector<cv::KeyPoint> keypoint1,
         const Mat& image2, const std::vector<cv::KeyPoint> keypoint2, const std::vector<cv::DMatch> matchces,
         const Mat& mask1, const Mat& mask2, const int step);
@@ -121,6 +121,63 @@ std::vector<std::string> MultiCameraCalibration::readStringList()
     return l;
 }
 
+class PatternDetectionInvoker : public ParallelLoopBody
+{
+public:
+    PatternDetectionInvoker(randpattern::RandomPatternCornerFinder& _finder, const std::vector<std::string>& _files,
+        std::vector<Size>& _sizes, std::vector<std::vector<Mat> >& _imgObj)
+        : finder(_finder), files(_files), sizes(_sizes), imgObj(_imgObj)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        for (int i = range.start; i < range.end; ++i)
+        {
+            Mat image = imread(files[i], IMREAD_GRAYSCALE);
+            sizes[i] = image.size();
+            if (!image.empty())
+                imgObj[i] = finder.computeObjectImagePointsForSingle(image);
+            else
+                imgObj[i] = std::vector<Mat>(2);
+        }
+    }
+
+private:
+    randpattern::RandomPatternCornerFinder& finder;
+    const std::vector<std::string>& files;
+    std::vector<Size>& sizes;
+    std::vector<std::vector<Mat> >& imgObj;
+
+    PatternDetectionInvoker& operator=(const PatternDetectionInvoker&); // to quiet MSVC
+};
+
+class CameraCalibrationInvoker : public ParallelLoopBody
+{
+public:
+    CameraCalibrationInvoker(MultiCameraCalibration& _calib, const std::vector<Size>& _sizes,
+        std::vector<double>& _rms, std::vector<Mat>& _idx)
+        : calib(_calib), sizes(_sizes), rms(_rms), idx(_idx)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        for (int camera = range.start; camera < range.end; ++camera)
+        {
+            rms[camera] = calib.calibrateSingleCamera(camera, sizes[camera], idx[camera]);
+        }
+    }
+
+private:
+    MultiCameraCalibration& calib;
+    const std::vector<Size>& sizes;
+    std::vector<double>& rms;
+    std::vector<Mat>& idx;
+
+    CameraCalibrationInvoker& operator=(const CameraCalibrationInvoker&); // to quiet MSVC
+};
+
 void MultiCameraCalibration::loadImages()
 {
     std::vector<std::string> file_list;
@@ -130,7 +187,11 @@ void MultiCameraCalibration::loadImages()
     Ptr<DescriptorExtractor> descriptor = _descriptor;
     Ptr<DescriptorMatcher> matcher = _matcher;
 
-    randpattern::RandomPatternCornerFinder finder(_patternWidth, _patternHeight, _nMiniMatches, CV_32F, _verbose, this->_showExtraction, detector, descriptor, matcher);
+    // the features are extracted from the images of all the cameras in parallel, unless they are shown;
+    // the matching counts of the finder would be interleaved then, the filtered ones are printed below
+    bool parallel = !this->_showExtraction;
+    randpattern::RandomPatternCornerFinder finder(_patternWidth, _patternHeight, _nMiniMatches, CV_32F,
+        parallel ? 0 : _verbose, this->_showExtraction, detector, descriptor, matcher);
     Mat pattern = cv::imread(file_list[0]);
     finder.loadPattern(pattern);
 
@@ -157,25 +218,44 @@ void MultiCameraCalibration::loadImages()
         timestampFull[cameraVertex].push_back(timestamp);
     }
 
-
-    // calibrate each camera individually
+    // find image and object points
+    std::vector<std::string> files;
     for (int camera = 0; camera < _nCamera; ++camera)
     {
-        Mat image, cameraMatrix, distortCoeffs;
+        files.insert(files.end(), filesEachCameraFull[camera].begin(), filesEachCameraFull[camera].end());
+    }
+    std::vector<Size> sizes(files.size());
+    std::vector<std::vector<Mat> > imgObjAll(files.size());
+    PatternDetectionInvoker detection(finder, files, sizes, imgObjAll);
+    if (parallel)
+    {
+        parallel_for_(Range(0, (int)files.size()), detection);
+    }
+    else
+    {
+        detection(Range(0, (int)files.size()));
+    }
 
-        // find image and object points
-        for (int imgIdx = 0; imgIdx < (int)filesEachCameraFull[camera].size(); ++imgIdx)
+    // the size of the last image of each camera is the one used for calibration
+    std::vector<Size> imageSize(_nCamera);
+    for (int camera = 0, fileIdx = 0; camera < _nCamera; ++camera)
+    {
+        for (int imgIdx = 0; imgIdx < (int)filesEachCameraFull[camera].size(); ++imgIdx, ++fileIdx)
         {
-            image = imread(filesEachCameraFull[camera][imgIdx], IMREAD_GRAYSCALE);
-			if (!image.empty() && _verbose)
+            imageSize[camera] = sizes[fileIdx];
+			if (sizes[fileIdx].area() != 0 && _verbose)
 			{
 				std::cout << "open image " << filesEachCameraFull[camera][imgIdx] << " successfully" << std::endl;
 			}
-			else if (image.empty() && _verbose)
+			else if (sizes[fileIdx].area() == 0 && _verbose)
 			{
 				std::cout << "open image" << filesEachCameraFull[camera][imgIdx] << " failed" << std::endl;
 			}
-            std::vector<Mat> imgObj = finder.computeObjectImagePointsForSingle(image);
+            const std::vector<Mat>& imgObj = imgObjAll[fileIdx];
+			if (parallel && _verbose)
+			{
+				std::cout << "number of filtered points " << (int)imgObj[0].total() << std::endl;
+			}
 			if ((int)imgObj[0].total() > _nMiniMatches)
 			{
 				_imagePointsForEachCamera[camera].push_back(imgObj[0]);
@@ -187,47 +267,16 @@ void MultiCameraCalibration::loadImages()
 				std::cout << "image " << filesEachCameraFull[camera][imgIdx] <<" has too few matched points "<< std::endl;
 			}
         }
+    }
 
-        // calibrate
-        Mat idx;
-        double rms = 0.0;
-        if (_camType == PINHOLE)
-        {
-            rms = cv::calibrateCamera(_objectPointsForEachCamera[camera], _imagePointsForEachCamera[camera],
-                image.size(), _cameraMatrix[camera], _distortCoeffs[camera], _omEachCamera[camera],
-                _tEachCamera[camera],_flags);
-            idx = Mat(1, (int)_omEachCamera[camera].size(), CV_32S);
-            for (int i = 0; i < (int)idx.total(); ++i)
-            {
-                idx.at<int>(i) = i;
-            }
-        }
-        //else if (_camType == FISHEYE)
-        //{
-        //    rms = cv::fisheye::calibrate(_objectPointsForEachCamera[camera], _imagePointsForEachCamera[camera],
-        //        image.size(), _cameraMatrix[camera], _distortCoeffs[camera], _omEachCamera[camera],
-        //        _tEachCamera[camera], _flags);
-        //    idx = Mat(1, (int)_omEachCamera[camera].size(), CV_32S);
-        //    for (int i = 0; i < (int)idx.total(); ++i)
-        //    {
-        //        idx.at<int>(i) = i;
-        //    }
-        //}
-        else if (_camType == OMNIDIRECTIONAL)
-        {
-            rms = cv::omnidir::calibrate(_objectPointsForEachCamera[camera], _imagePointsForEachCamera[camera],
-                image.size(), _cameraMatrix[camera], _xi[camera], _distortCoeffs[camera], _omEachCamera[camera],
-                _tEachCamera[camera], _flags, TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 300, 1e-7),
-                idx);
-        }
-        _cameraMatrix[camera].convertTo(_cameraMatrix[camera], CV_32F);
-        _distortCoeffs[camera].convertTo(_distortCoeffs[camera], CV_32F);
-        _xi[camera].convertTo(_xi[camera], CV_32F);
-        //else
-        //{
-        //    CV_Error_(CV_StsOutOfRange, "Unknown camera type, use PINHOLE or OMNIDIRECTIONAL");
-        //}
+    // calibrate each camera individually
+    std::vector<double> rmsEachCamera(_nCamera, 0.0);
+    std::vector<Mat> idxEachCamera(_nCamera);
+    parallel_for_(Range(0, _nCamera), CameraCalibrationInvoker(*this, imageSize, rmsEachCamera, idxEachCamera));
 
+    for (int camera = 0; camera < _nCamera; ++camera)
+    {
+        const Mat& idx = idxEachCamera[camera];
         for (int i = 0; i < (int)_omEachCamera[camera].size(); ++i)
         {
 			int cameraVertex, timestamp, photoVertex;
@@ -254,7 +303,7 @@ void MultiCameraCalibration::loadImages()
 
 			this->_edgeList.push_back(edge(cameraVertex, photoVertex, idx.at<int>(i), transform));
         }
-		std::cout << "initialized for camera " << camera << " rms = " << rms << std::endl;
+		std::cout << "initialized for camera " << camera << " rms = " << rmsEachCamera[camera] << std::endl;
 		std::cout << "initialized camera matrix for camera " << camera << " is" << std::endl;
 		std::cout << _cameraMatrix[camera] << std::endl;
 		std::cout << "xi for camera " << camera << " is " << _xi[camera] << std::endl;
@@ -262,6 +311,48 @@ void MultiCameraCalibration::loadImages()
 
 }
 
+double MultiCameraCalibration::calibrateSingleCamera(int camera, const Size& imageSize, Mat& idx)
+{
+    double rms = 0.0;
+    if (_camType == PINHOLE)
+    {
+        rms = cv::calibrateCamera(_objectPointsForEachCamera[camera], _imagePointsForEachCamera[camera],
+            imageSize, _cameraMatrix[camera], _distortCoeffs[camera], _omEachCamera[camera],
+            _tEachCamera[camera],_flags);
+        idx = Mat(1, (int)_omEachCamera[camera].size(), CV_32S);
+        for (int i = 0; i < (int)idx.total(); ++i)
+        {
+            idx.at<int>(i) = i;
+        }
+    }
+    //else if (_camType == FISHEYE)
+    //{
+    //    rms = cv::fisheye::calibrate(_objectPointsForEachCamera[camera], _imagePointsForEachCamera[camera],
+    //        imageSize, _cameraMatrix[camera], _distortCoeffs[camera], _omEachCamera[camera],
+    //        _tEachCamera[camera], _flags);
+    //    idx = Mat(1, (int)_omEachCamera[camera].size(), CV_32S);
+    //    for (int i = 0; i < (int)idx.total(); ++i)
+    //    {
+    //        idx.at<int>(i) = i;
+    //    }
+    //}
+    else if (_camType == OMNIDIRECTIONAL)
+    {
+        rms = cv::omnidir::calibrate(_objectPointsForEachCamera[camera], _imagePointsForEachCamera[camera],
+            imageSize, _cameraMatrix[camera], _xi[camera], _distortCoeffs[camera], _omEachCamera[camera],
+            _tEachCamera[camera], _flags, TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 300, 1e-7),
+            idx);
+    }
+    _cameraMatrix[camera].convertTo(_cameraMatrix[camera], CV_32F);
+    _distortCoeffs[camera].convertTo(_distortCoeffs[camera], CV_32F);
+    _xi[camera].convertTo(_xi[camera], CV_32F);
+    //else
+    //{
+    //    CV_Error_(CV_StsOutOfRange, "Unknown camera type, use PINHOLE or OMNIDIRECTIONAL");
+    //}
+    return rms;
+}
+
 int MultiCameraCalibration::getPhotoVertex(int timestamp)
 {
     int photoVertex = INVALID;
@@ -291,17 +382,25 @@ void MultiCameraCalibration::initialize()
     int nVertices = (int)_vertexList.size();
     int nEdges = (int) _edgeList.size();
 
-    // build graph
-    Mat G = Mat::zeros(nVertices, nVertices, CV_32S);
+    // build graph, the edges of each vertex are sorted by the vertex they lead to
+    // (the edges are listed camera by camera)
+    std::vector<std::vector<int> > vertexEdges(nVertices);
     for (int edgeIdx = 0; edgeIdx < nEdges; ++edgeIdx)
     {
-        G.at<int>(this->_edgeList[edgeIdx].cameraVertex, this->_edgeList[edgeIdx].photoVertex) = edgeIdx + 1;
+        vertexEdges[this->_edgeList[edgeIdx].photoVertex].push_back(edgeIdx);
+    }
+    for (int photo = _nCamera; photo < nVertices; ++photo)
+    {
+        for (int i = 0; i < (int)vertexEdges[photo].size(); ++i)
+        {
+            int edgeIdx = vertexEdges[photo][i];
+            vertexEdges[this->_edgeList[edgeIdx].cameraVertex].push_back(edgeIdx);
+        }
     }
-    G = G + G.t();
 
-    // traverse the graph
-    std::vector<int> pre, order;
-    graphTraverse(G, 0, order, pre);
+    // traverse the graph, the spanning tree of pre is the shortest path of each vertex to the first camera
+    std::vector<int> pre, preEdge, order;
+    graphTraverse(vertexEdges, 0, order, pre, preEdge);
 
     for (int i = 0; i < _nCamera; ++i)
     {
@@ -315,7 +414,7 @@ void MultiCameraCalibration::initialize()
     {
         int vertexIdx = order[i];
         Mat prePose = this->_vertexList[pre[vertexIdx]].pose;
-        int edgeIdx = G.at<int>(vertexIdx, pre[vertexIdx]) - 1;
+        int edgeIdx = preEdge[vertexIdx];
         Mat transform = this->_edgeList[edgeIdx].transform;
 
         if (vertexIdx < _nCamera)
@@ -365,9 +464,9 @@ double MultiCameraCalibration::optimizeExtrinsics()
             (_criteria.type == 3 && (change <= _criteria.epsilon || iter >= _criteria.maxCount)))
             break;
         double alpha_smooth2 = 1 - std::pow(1 - alpha_smooth, (double)iter + 1.0);
-        Mat JTJ_inv, JTError;
-        this->computeJacobianExtrinsic(extrinParam, JTJ_inv, JTError);
-        Mat G = alpha_smooth2*JTJ_inv * JTError;
+        Mat G;
+        this->computeExtrinsicStep(extrinParam, G);
+        G = alpha_smooth2*G;
         if (G.depth() == CV_64F)
         {
             G.convertTo(G, CV_32F);
@@ -400,71 +499,172 @@ double MultiCameraCalibration::optimizeExtrinsics()
     return error;
 }
 
-void MultiCameraCalibration::computeJacobianExtrinsic(const Mat& extrinsicParams, Mat& JTJ_inv, Mat& JTE)
+// J^T*J and J^T*e of an edge, by the photo and the camera of the edge
+struct EdgeNormalEquations
 {
-    int nParam = (int)extrinsicParams.total();
-    int nEdge = (int)_edgeList.size();
-    std::vector<int> pointsLocation(nEdge+1, 0);
+    Mat JTJPhoto, JTJCamera, JTJCross;  // JTJCross = JCamera^T*JPhoto
+    Mat JTEPhoto, JTECamera;
+};
 
-    for (int edgeIdx = 0; edgeIdx < nEdge; ++edgeIdx)
+class EdgeJacobianInvoker : public ParallelLoopBody
+{
+public:
+    EdgeJacobianInvoker(MultiCameraCalibration& _calib, const Mat& _extrinsicParams, std::vector<EdgeNormalEquations>& _edges)
+        : calib(_calib), extrinsicParams(_extrinsicParams), edges(_edges)
     {
-        int nPoints = (int)_objectPointsForEachCamera[_edgeList[edgeIdx].cameraVertex][_edgeList[edgeIdx].photoIndex].total();
-        pointsLocation[edgeIdx+1] = pointsLocation[edgeIdx] + nPoints*2;
     }
 
-    JTJ_inv = Mat(nParam, nParam, CV_64F);
-    JTE = Mat(nParam, 1, CV_64F);
+    void operator()(const Range& range) const
+    {
+        for (int edgeIdx = range.start; edgeIdx < range.end; ++edgeIdx)
+        {
+            Mat jacobianPhoto, jacobianCamera, error;
+            calib.computeEdgeJacobian(extrinsicParams, edgeIdx, jacobianPhoto, jacobianCamera, error);
 
-    Mat J = Mat::zeros(pointsLocation[nEdge], nParam, CV_64F);
-    Mat E = Mat::zeros(pointsLocation[nEdge], 1, CV_64F);
+            EdgeNormalEquations& e = edges[edgeIdx];
+            gemm(jacobianPhoto, jacobianPhoto, 1, noArray(), 0, e.JTJPhoto, GEMM_1_T);
+            gemm(jacobianPhoto, error, 1, noArray(), 0, e.JTEPhoto, GEMM_1_T);
+            if (calib._edgeList[edgeIdx].cameraVertex > 0)
+            {
+                gemm(jacobianCamera, jacobianCamera, 1, noArray(), 0, e.JTJCamera, GEMM_1_T);
+                gemm(jacobianCamera, jacobianPhoto, 1, noArray(), 0, e.JTJCross, GEMM_1_T);
+                gemm(jacobianCamera, error, 1, noArray(), 0, e.JTECamera, GEMM_1_T);
+            }
+        }
+    }
 
+private:
+    MultiCameraCalibration& calib;
+    const Mat& extrinsicParams;
+    std::vector<EdgeNormalEquations>& edges;
+
+    EdgeJacobianInvoker& operator=(const EdgeJacobianInvoker&); // to quiet MSVC
+};
+
+void MultiCameraCalibration::computeExtrinsicStep(const Mat& extrinsicParams, Mat& G)
+{
+    int nParam = (int)extrinsicParams.total();
+    int nEdge = (int)_edgeList.size();
+    int nVertex = (int)_vertexList.size();
+    int nCameraParam = 6*(_nCamera - 1);
+
+    std::vector<EdgeNormalEquations> edges(nEdge);
+    parallel_for_(Range(0, nEdge), EdgeJacobianInvoker(*this, extrinsicParams, edges));
+
+    // J^T*J is block diagonal for the cameras and for the photos, and an edge couples its camera and its
+    // photo. The photos are eliminated by the Schur complement, which leaves the dense system of the cameras.
+    // The step is (J^T*J + 1e-10)^-1 * J^T*e: 1e-10 is added to every entry of J^T*J, which is the rank one
+    // term u*u^T, u = (1, ..., 1)^T, solved by Sherman-Morrison with u as the second column of rhs.
+    Mat rhs(nParam, 2, CV_64F, Scalar(1));
+    rhs.col(0).setTo(0);
+    Mat S = Mat::zeros(nCameraParam, nCameraParam, CV_64F);
+    std::vector<Mat> JTJPhoto(nVertex);
+    std::vector<std::vector<int> > photoEdges(nVertex);
+    for (int vertexIdx = _nCamera; vertexIdx < nVertex; ++vertexIdx)
+    {
+        JTJPhoto[vertexIdx] = Mat::zeros(6, 6, CV_64F);
+    }
     for (int edgeIdx = 0; edgeIdx < nEdge; ++edgeIdx)
     {
         int photoVertex = _edgeList[edgeIdx].photoVertex;
-        int photoIndex = _edgeList[edgeIdx].photoIndex;
         int cameraVertex = _edgeList[edgeIdx].cameraVertex;
+        const EdgeNormalEquations& e = edges[edgeIdx];
 
-        Mat objectPoints = _objectPointsForEachCamera[cameraVertex][photoIndex];
-        Mat imagePoints = _imagePointsForEachCamera[cameraVertex][photoIndex];
-
-        Mat rvecTran, tvecTran;
-        Mat R = _edgeList[edgeIdx].transform.rowRange(0, 3).colRange(0, 3);
-        tvecTran = _edgeList[edgeIdx].transform.rowRange(0, 3).col(3);
-        cv::Rodrigues(R, rvecTran);
-
-        Mat rvecPhoto = extrinsicParams.colRange((photoVertex-1)*6, (photoVertex-1)*6 + 3);
-        Mat tvecPhoto = extrinsicParams.colRange((photoVertex-1)*6 + 3, (photoVertex-1)*6 + 6);
-
-        Mat rvecCamera, tvecCamera;
+        JTJPhoto[photoVertex] += e.JTJPhoto;
+        rhs(Rect(0, (photoVertex-1)*6, 1, 6)) += e.JTEPhoto;
         if (cameraVertex > 0)
         {
-            rvecCamera = extrinsicParams.colRange((cameraVertex-1)*6, (cameraVertex-1)*6 + 3);
-            tvecCamera = extrinsicParams.colRange((cameraVertex-1)*6 + 3, (cameraVertex-1)*6 + 6);
+            S(Rect((cameraVertex-1)*6, (cameraVertex-1)*6, 6, 6)) += e.JTJCamera;
+            rhs(Rect(0, (cameraVertex-1)*6, 1, 6)) += e.JTECamera;
         }
-        else
+        photoEdges[photoVertex].push_back(edgeIdx);
+    }
+
+    Mat r = rhs.rowRange(0, nCameraParam).clone();
+    std::vector<Mat> JTJPhotoInv(nVertex);
+    for (int photoVertex = _nCamera; photoVertex < nVertex; ++photoVertex)
+    {
+        JTJPhotoInv[photoVertex] = JTJPhoto[photoVertex].inv();
+        Mat rhsPhoto = rhs.rowRange((photoVertex-1)*6, photoVertex*6);
+        const std::vector<int>& pe = photoEdges[photoVertex];
+        for (int i = 0; i < (int)pe.size(); ++i)
         {
-            rvecCamera = Mat::zeros(3, 1, CV_32F);
-            tvecCamera = Mat::zeros(3, 1, CV_32F);
+            int camera1 = _edgeList[pe[i]].cameraVertex;
+            if (camera1 == 0)
+                continue;
+            Mat Y = edges[pe[i]].JTJCross * JTJPhotoInv[photoVertex];
+            r.rowRange((camera1-1)*6, camera1*6) -= Y * rhsPhoto;
+            for (int j = 0; j < (int)pe.size(); ++j)
+            {
+                int camera2 = _edgeList[pe[j]].cameraVertex;
+                if (camera2 == 0)
+                    continue;
+                S(Rect((camera2-1)*6, (camera1-1)*6, 6, 6)) -= Y * edges[pe[j]].JTJCross.t();
+            }
         }
+    }
 
-        Mat jacobianPhoto, jacobianCamera, error;
-        computePhotoCameraJacobian(rvecPhoto, tvecPhoto, rvecCamera, tvecCamera, rvecTran, tvecTran,
-            objectPoints, imagePoints, this->_cameraMatrix[cameraVertex], this->_distortCoeffs[cameraVertex],
-            this->_xi[cameraVertex], jacobianPhoto, jacobianCamera, error);
-        if (cameraVertex > 0)
+    Mat x(nParam, 2, CV_64F);
+    Mat xCamera = x.rowRange(0, nCameraParam);
+    if (nCameraParam > 0)
+    {
+        Mat solution;
+        solve(S, r, solution, DECOMP_LU);
+        solution.copyTo(xCamera);
+    }
+    for (int photoVertex = _nCamera; photoVertex < nVertex; ++photoVertex)
+    {
+        Mat b = rhs.rowRange((photoVertex-1)*6, photoVertex*6).clone();
+        const std::vector<int>& pe = photoEdges[photoVertex];
+        for (int i = 0; i < (int)pe.size(); ++i)
         {
-            jacobianCamera.copyTo(J.rowRange(pointsLocation[edgeIdx], pointsLocation[edgeIdx+1]).
-                colRange((cameraVertex-1)*6, cameraVertex*6));
+            int cameraVertex = _edgeList[pe[i]].cameraVertex;
+            if (cameraVertex > 0)
+                b -= edges[pe[i]].JTJCross.t() * xCamera.rowRange((cameraVertex-1)*6, cameraVertex*6);
         }
-        jacobianPhoto.copyTo(J.rowRange(pointsLocation[edgeIdx], pointsLocation[edgeIdx+1]).
-            colRange((photoVertex-1)*6, photoVertex*6));
-        error.copyTo(E.rowRange(pointsLocation[edgeIdx], pointsLocation[edgeIdx+1]));
+        Mat(JTJPhotoInv[photoVertex] * b).copyTo(x.rowRange((photoVertex-1)*6, photoVertex*6));
+    }
+
+    const double epsilon = 1e-10;
+    double uy = sum(x.col(0))[0], uz = sum(x.col(1))[0];
+    G = x.col(0) - x.col(1) * (epsilon * uy / (1 + epsilon * uz));
+}
+
+void MultiCameraCalibration::computeEdgeJacobian(const Mat& extrinsicParams, int edgeIdx, Mat& jacobianPhoto,
+    Mat& jacobianCamera, Mat& error)
+{
+    int photoVertex = _edgeList[edgeIdx].photoVertex;
+    int photoIndex = _edgeList[edgeIdx].photoIndex;
+    int cameraVertex = _edgeList[edgeIdx].cameraVertex;
+
+    Mat objectPoints = _objectPointsForEachCamera[cameraVertex][photoIndex];
+    Mat imagePoints = _imagePointsForEachCamera[cameraVertex][photoIndex];
+
+    Mat rvecTran, tvecTran;
+    Mat R = _edgeList[edgeIdx].transform.rowRange(0, 3).colRange(0, 3);
+    tvecTran = _edgeList[edgeIdx].transform.rowRange(0, 3).col(3);
+    cv::Rodrigues(R, rvecTran);
+
+    Mat rvecPhoto = extrinsicParams.colRange((photoVertex-1)*6, (photoVertex-1)*6 + 3);
+    Mat tvecPhoto = extrinsicParams.colRange((photoVertex-1)*6 + 3, (photoVertex-1)*6 + 6);
+
+    Mat rvecCamera, tvecCamera;
+    if (cameraVertex > 0)
+    {
+        rvecCamera = extrinsicParams.colRange((cameraVertex-1)*6, (cameraVertex-1)*6 + 3);
+        tvecCamera = extrinsicParams.colRange((cameraVertex-1)*6 + 3, (cameraVertex-1)*6 + 6);
+    }
+    else
+    {
+        rvecCamera = Mat::zeros(3, 1, CV_32F);
+        tvecCamera = Mat::zeros(3, 1, CV_32F);
     }
-    //std::cout << J.t() * J << std::endl;
-    JTJ_inv = (J.t() * J + 1e-10).inv();
-    JTE = J.t() * E;
 
+    computePhotoCameraJacobian(rvecPhoto, tvecPhoto, rvecCamera, tvecCamera, rvecTran, tvecTran,
+        objectPoints, imagePoints, this->_cameraMatrix[cameraVertex], this->_distortCoeffs[cameraVertex],
+        this->_xi[cameraVertex], jacobianPhoto, jacobianCamera, error);
 }
+
 void MultiCameraCalibration::computePhotoCameraJacobian(const Mat& rvecPhoto, const Mat& tvecPhoto, const Mat& rvecCamera,
     const Mat& tvecCamera, Mat& rvecTran, Mat& tvecTran, const Mat& objectPoints, const Mat& imagePoints, const Mat& K,
     const Mat& distort, const Mat& xi, Mat& jacobianPhoto, Mat& jacobianCamera, Mat& E)
@@ -529,12 +729,14 @@ void MultiCameraCalibration::computePhotoCameraJacobian(const Mat& rvecPhoto, co
     dx_dtvecPhoto.copyTo(jacobianPhoto.colRange(3, 6));
 
 }
-void MultiCameraCalibration::graphTraverse(const Mat& G, int begin, std::vector<int>& order, std::vector<int>& pre)
+void MultiCameraCalibration::graphTraverse(const std::vector<std::vector<int> >& vertexEdges, int begin,
+    std::vector<int>& order, std::vector<int>& pre, std::vector<int>& preEdge)
 {
-    CV_Assert(!G.empty() && G.rows == G.cols);
-    int nVertex = G.rows;
+    int nVertex = (int)vertexEdges.size();
+    CV_Assert(begin >= 0 && begin < nVertex);
     order.resize(0);
     pre.resize(nVertex, INVALID);
+    preEdge.resize(nVertex, INVALID);
     pre[begin] = -1;
     std::vector<bool> visited(nVertex, false);
     std::queue<int> q;
@@ -546,44 +748,22 @@ void MultiCameraCalibration::graphTraverse(const Mat& G, int begin, std::vector<
     {
         int v = q.front();
         q.pop();
-        Mat idx;
-        // use my findNonZero maybe
-        findRowNonZero(G.row(v), idx);
-        for(int i = 0; i < (int)idx.total(); ++i)
+        for(int i = 0; i < (int)vertexEdges[v].size(); ++i)
         {
-            int neighbor = idx.at<int>(i);
+            int edgeIdx = vertexEdges[v][i];
+            int neighbor = v < _nCamera ? _edgeList[edgeIdx].photoVertex : _edgeList[edgeIdx].cameraVertex;
             if (!visited[neighbor])
             {
                 visited[neighbor] = true;
                 q.push(neighbor);
                 order.push_back(neighbor);
                 pre[neighbor] = v;
+                preEdge[neighbor] = edgeIdx;
             }
         }
     }
 }
 
-void MultiCameraCalibration::findRowNonZero(const Mat& row, Mat& idx)
-{
-    CV_Assert(!row.empty() && row.rows == 1 && row.channels() == 1);
-    Mat _row;
-    std::vector<int> _idx;
-    row.convertTo(_row, CV_32F);
-    for (int i = 0; i < (int)row.total(); ++i)
-    {
-        if (_row.at<float>(i) != 0)
-        {
-            _idx.push_back(i);
-        }
-    }
-    idx.release();
-    idx.create(1, (int)_idx.size(), CV_32S);
-    for (int i = 0; i < (int)_idx.size(); ++i)
-    {
-        idx.at<int>(i) = _idx[i];
-    }
-}
-
 double MultiCameraCalibration::computeProjectError(Mat& parameters)
 {
     int nVertex = (int)_vertexList.size();
@@ -842,175 +842,435 @@ void cv::omnidir::internal::initializeStereoCalibration(InputArrayOfArrays objec
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// cv::omnidir::internal::computeJacobian
 
-void cv::omnidir::internal::computeJacobian(InputArrayOfArrays objectPoints, InputArrayOfArrays imagePoints,
-    InputArray parameters, Mat& JTJ_inv, Mat& JTE, int flags, double epsilon)
+namespace cv { namespace
 {
-    CV_Assert(!objectPoints.empty() && objectPoints.type() == CV_64FC3);
-    CV_Assert(!imagePoints.empty() && imagePoints.type() == CV_64FC2);
+    // J^T*J and J^T*e of the calibration by blocks. The 6 extrinsic parameters of a view are only coupled
+    // to themselves and to the parameters shared by all the views (the intrinsics, and the relative pose
+    // for a stereo pair), so that J^T*J is block arrow shaped.
+    struct NormalEquations
+    {
+        std::vector<Mat> U;         // JEx^T*JEx of each view, 6x6
+        std::vector<Mat> W;         // JEx^T*JShared of each view, 6 x nShared
+        std::vector<Mat> bEx;       // JEx^T*e of each view, 6x1
+        std::vector<Mat> VView;     // JShared^T*JShared of each view
+        std::vector<Mat> bView;     // JShared^T*e of each view
+        Mat V, bShared;             // the sums of VView and bView over the views
+
+        // the places of the extrinsics of each view and of the shared parameters in the parameter vector
+        std::vector<int> exOffset, sharedIdx;
+        int nParams;
+
+        void create(int n)
+        {
+            U.resize(n); W.resize(n); bEx.resize(n); VView.resize(n); bView.resize(n);
+        }
 
-    int n = (int)objectPoints.total();
+        void setView(int i, const Mat& JEx, const Mat& JShared, const Mat& error)
+        {
+            gemm(JEx, JEx, 1, noArray(), 0, U[i], GEMM_1_T);
+            gemm(JEx, JShared, 1, noArray(), 0, W[i], GEMM_1_T);
+            gemm(JEx, error, 1, noArray(), 0, bEx[i], GEMM_1_T);
+            gemm(JShared, JShared, 1, noArray(), 0, VView[i], GEMM_1_T);
+            gemm(JShared, error, 1, noArray(), 0, bView[i], GEMM_1_T);
+        }
 
-    Mat JTJ = Mat::zeros(10 + 6*n, 10 + 6*n, CV_64F);
-    JTJ_inv = Mat::zeros(10 + 6*n, 10 + 6*n, CV_64F);
-    JTE = Mat::zeros(10 + 6*n, 1, CV_64F);
+        // in the order of the views, so that the result does not depend on the number of threads
+        void sumViews()
+        {
+            int nShared = (int)sharedIdx.size();
+            V = Mat::zeros(nShared, nShared, CV_64F);
+            bShared = Mat::zeros(nShared, 1, CV_64F);
+            for (int i = 0; i < (int)VView.size(); i++)
+            {
+                V += VView[i];
+                bShared += bView[i];
+            }
+        }
+    };
 
-    int nPointsAll = 0;
-    for (int i = 0; i < n; ++i)
+    void getViewPoints(InputArrayOfArrays points, std::vector<Mat>& views)
     {
-        nPointsAll += (int)objectPoints.getMat(i).total();
+        views.resize(points.total());
+        for (int i = 0; i < (int)views.size(); i++)
+        {
+            points.getMat(i).copyTo(views[i]);
+            views[i] = views[i].reshape(views[i].channels(), (int)views[i].total());
+        }
     }
 
-    Mat J = Mat::zeros(2*nPointsAll, 10+6*n, CV_64F);
-    Mat exAll = Mat::zeros(2*nPointsAll, 10+6*n, CV_64F);
-    double *para = parameters.getMat().ptr<double>();
-    Matx33d K(para[6*n], para[6*n+2], para[6*n+3],
-        0,    para[6*n+1], para[6*n+4],
-        0,    0,  1);
-    Matx14d D(para[6*n+6], para[6*n+7], para[6*n+8], para[6*n+9]);
-    double xi = para[6*n+5];
-    for (int i = 0; i < n; i++)
+    class ViewBlocksInvoker : public ParallelLoopBody
     {
-        Mat objPoints, imgPoints, om, T;
-		objectPoints.getMat(i).copyTo(objPoints);
-		imagePoints.getMat(i).copyTo(imgPoints);
-		objPoints = objPoints.reshape(3, objPoints.rows*objPoints.cols);
-		imgPoints = imgPoints.reshape(2, imgPoints.rows*imgPoints.cols);
+    public:
+        ViewBlocksInvoker(const std::vector<Mat>& _objectPoints, const std::vector<Mat>& _imagePoints,
+            const Mat& _parameters, NormalEquations& _eq)
+            : objectPoints(_objectPoints), imagePoints(_imagePoints), parameters(_parameters), eq(_eq)
+        {
+        }
+
+        void operator()(const Range& range) const
+        {
+            int n = (int)objectPoints.size();
+            const double *para = parameters.ptr<double>();
+            Matx33d K(para[6*n], para[6*n+2], para[6*n+3],
+                0,    para[6*n+1], para[6*n+4],
+                0,    0,  1);
+            Matx14d D(para[6*n+6], para[6*n+7], para[6*n+8], para[6*n+9]);
+            double xi = para[6*n+5];
+
+            for (int i = range.start; i < range.end; i++)
+            {
+                Mat om = parameters.colRange(i*6, i*6+3);
+                Mat T = parameters.colRange(i*6+3, (i+1)*6);
+                Mat imgProj, jacobian;
+                omnidir::projectPoints(objectPoints[i], imgProj, om, T, K, xi, D, jacobian);
+                Mat projError = imagePoints[i] - imgProj;
+
+                eq.setView(i, jacobian.colRange(0, 6), jacobian.colRange(6, 16), projError.reshape(1, 2*(int)projError.total()));
+            }
+        }
 
-        om = parameters.getMat().colRange(i*6, i*6+3);
-        T = parameters.getMat().colRange(i*6+3, (i+1)*6);
-        Mat imgProj, jacobian;
-        omnidir::projectPoints(objPoints, imgProj, om, T, K, xi, D, jacobian);
-        Mat projError = imgPoints - imgProj;
+    private:
+        const std::vector<Mat>& objectPoints;
+        const std::vector<Mat>& imagePoints;
+        const Mat& parameters;
+        NormalEquations& eq;
 
-        // The intrinsic part of Jacobian
-        Mat JIn(jacobian.rows, 10, CV_64F);
-        Mat JEx(jacobian.rows, 6, CV_64F);
+        ViewBlocksInvoker& operator=(const ViewBlocksInvoker&); // to quiet MSVC
+    };
 
-        jacobian.colRange(6, 16).copyTo(JIn);
-        jacobian.colRange(0, 6).copyTo(JEx);
+    class StereoViewBlocksInvoker : public ParallelLoopBody
+    {
+    public:
+        StereoViewBlocksInvoker(const std::vector<Mat>& _objectPoints, const std::vector<Mat>& _imagePoints1,
+            const std::vector<Mat>& _imagePoints2, const Mat& _parameters, NormalEquations& _eq)
+            : objectPoints(_objectPoints), imagePoints1(_imagePoints1), imagePoints2(_imagePoints2),
+              parameters(_parameters), eq(_eq)
+        {
+        }
 
-        JTJ(Rect(6*n, 6*n, 10, 10)) = JTJ(Rect(6*n, 6*n, 10, 10)) + JIn.t()*JIn;
+        void operator()(const Range& range) const
+        {
+            int n_img = (int)objectPoints.size();
+            const double *para = parameters.ptr<double>();
+            int offset1 = (n_img + 1) * 6;
+            int offset2 = offset1 + 10;
+            Matx33d K1(para[offset1], para[offset1+2], para[offset1+3],
+                0,    para[offset1+1], para[offset1+4],
+                0,    0,  1);
+            Matx14d D1(para[offset1+6], para[offset1+7], para[offset1+8], para[offset1+9]);
+            double xi1 = para[offset1+5];
+
+            Matx33d K2(para[offset2], para[offset2+2], para[offset2+3],
+                0,    para[offset2+1], para[offset2+4],
+                0,    0,  1);
+            Matx14d D2(para[offset2+6], para[offset2+7], para[offset2+8], para[offset2+9]);
+            double xi2 = para[offset2+5];
+
+            Mat om = parameters.colRange(0, 3);
+            Mat T = parameters.colRange(3, 6);
+
+            for (int i = range.start; i < range.end; i++)
+            {
+                Mat om1 = parameters.colRange((1 + i) * 6, (1 + i) * 6 + 3);
+                Mat T1 = parameters.colRange((1 + i) * 6 + 3, (i + 1) * 6 + 6);
+
+                // jacobian for left image
+                Mat imgProj1, jacobian1;
+                cv::omnidir::projectPoints(objectPoints[i], imgProj1, om1, T1, K1, xi1, D1, jacobian1);
+                Mat projError1 = imagePoints1[i] - imgProj1;
+
+                //jacobian for right image
+                Mat om2, T2, dom2dom1, dom2dT1, dom2dom, dom2dT, dT2dom1, dT2dT1, dT2dom, dT2dT;
+                cv::omnidir::internal::compose_motion(om1, T1, om, T, om2, T2, dom2dom1, dom2dT1, dom2dom, dom2dT, dT2dom1, dT2dT1, dT2dom, dT2dT);
+                Mat imgProj2, jacobian2;
+                cv::omnidir::projectPoints(objectPoints[i], imgProj2, om2, T2, K2, xi2, D2, jacobian2);
+                Mat projError2 = imagePoints2[i] - imgProj2;
+
+                // the rows of the left image, then of the right one; the shared parameters are
+                // the relative pose, then the intrinsics of the left and of the right camera
+                int rows = jacobian1.rows;
+                Mat JEx(2*rows, 6, CV_64F);
+                Mat JShared = Mat::zeros(2*rows, 26, CV_64F);
+                Mat error(2*rows, 1, CV_64F);
+
+                jacobian1.colRange(0, 6).copyTo(JEx.rowRange(0, rows));
+                Mat(jacobian2.colRange(0, 3) * dom2dom1 + jacobian2.colRange(3, 6) * dT2dom1).copyTo(JEx(Rect(0, rows, 3, rows)));
+                Mat(jacobian2.colRange(0, 3) * dom2dT1 + jacobian2.colRange(3, 6) * dT2dT1).copyTo(JEx(Rect(3, rows, 3, rows)));
+
+                jacobian1.colRange(6, 16).copyTo(JShared(Rect(6, 0, 10, rows)));
+                Mat(jacobian2.colRange(0, 3) * dom2dom + jacobian2.colRange(3, 6) * dT2dom).copyTo(JShared(Rect(0, rows, 3, rows)));
+                Mat(jacobian2.colRange(0, 3) * dom2dT + jacobian2.colRange(3, 6) * dT2dT).copyTo(JShared(Rect(3, rows, 3, rows)));
+                jacobian2.colRange(6, 16).copyTo(JShared(Rect(16, rows, 10, rows)));
+
+                projError1.reshape(1, rows).copyTo(error.rowRange(0, rows));
+                projError2.reshape(1, rows).copyTo(error.rowRange(rows, 2*rows));
+
+                eq.setView(i, JEx, JShared, error);
+            }
+        }
 
-        JTJ(Rect(i*6, i*6, 6, 6)) = JEx.t() * JEx;
+    private:
+        const std::vector<Mat>& objectPoints;
+        const std::vector<Mat>& imagePoints1;
+        const std::vector<Mat>& imagePoints2;
+        const Mat& parameters;
+        NormalEquations& eq;
 
-        Mat JExTIn = JEx.t() * JIn;
+        StereoViewBlocksInvoker& operator=(const StereoViewBlocksInvoker&); // to quiet MSVC
+    };
 
-        JExTIn.copyTo(JTJ(Rect(6*n, i*6, 10, 6)));
+    void computeNormalEquations(InputArrayOfArrays objectPoints, InputArrayOfArrays imagePoints, InputArray parameters,
+        NormalEquations& eq)
+    {
+        CV_Assert(!objectPoints.empty() && objectPoints.type() == CV_64FC3);
+        CV_Assert(!imagePoints.empty() && imagePoints.type() == CV_64FC2);
 
-        Mat(JIn.t()*JEx).copyTo(JTJ(Rect(i*6, 6*n, 6, 10)));
+        int n = (int)objectPoints.total();
+        std::vector<Mat> objPoints, imgPoints;
+        getViewPoints(objectPoints, objPoints);
+        getViewPoints(imagePoints, imgPoints);
+        Mat params = parameters.getMat().reshape(1, 1);
+        CV_Assert((int)params.total() == 6*n + 10);
 
-        JTE(Rect(0, 6*n, 1, 10)) = JTE(Rect(0, 6*n,1, 10)) + JIn.t() * projError.reshape(1, 2*(int)projError.total());
-        JTE(Rect(0, i*6, 1, 6)) = JEx.t() * projError.reshape(1, 2*(int)projError.total());
+        eq.nParams = 6*n + 10;
+        eq.exOffset.resize(n);
+        for (int i = 0; i < n; i++)
+            eq.exOffset[i] = 6*i;
+        eq.sharedIdx.resize(10);
+        for (int k = 0; k < 10; k++)
+            eq.sharedIdx[k] = 6*n + k;
+
+        eq.create(n);
+        parallel_for_(Range(0, n), ViewBlocksInvoker(objPoints, imgPoints, params, eq));
+        eq.sumViews();
+    }
+
+    void computeNormalEquationsStereo(InputArrayOfArrays objectPoints, InputArrayOfArrays imagePoints1, InputArrayOfArrays imagePoints2,
+        InputArray parameters, NormalEquations& eq)
+    {
+        CV_Assert(!objectPoints.empty() && objectPoints.type() == CV_64FC3);
+        CV_Assert(!imagePoints1.empty() && imagePoints1.type() == CV_64FC2);
+        CV_Assert(!imagePoints2.empty() && imagePoints2.type() == CV_64FC2);
+        CV_Assert((imagePoints1.total() == imagePoints2.total()) && (imagePoints1.total() == objectPoints.total()));
+
+        int n_img = (int)objectPoints.total();
+        std::vector<Mat> objPoints, imgPoints1, imgPoints2;
+        getViewPoints(objectPoints, objPoints);
+        getViewPoints(imagePoints1, imgPoints1);
+        getViewPoints(imagePoints2, imgPoints2);
+        Mat params = parameters.getMat().reshape(1, 1);
+        CV_Assert((int)params.total() == 6*(n_img + 1) + 20);
+
+        eq.nParams = 6*(n_img + 1) + 20;
+        eq.exOffset.resize(n_img);
+        for (int i = 0; i < n_img; i++)
+            eq.exOffset[i] = 6*(i + 1);
+        eq.sharedIdx.resize(26);
+        for (int k = 0; k < 26; k++)
+            eq.sharedIdx[k] = k < 6 ? k : 6*(n_img + 1) + k - 6;
+
+        eq.create(n_img);
+        parallel_for_(Range(0, n_img), StereoViewBlocksInvoker(objPoints, imgPoints1, imgPoints2, params, eq));
+        eq.sumViews();
+    }
+
+    // the dense J^T*J and J^T*e, reduced to the free parameters given by idx
+    void denseNormalEquations(const NormalEquations& eq, const std::vector<int>& idx, Mat& JTJ, Mat& JTE)
+    {
+        int nShared = (int)eq.sharedIdx.size();
+        JTJ = Mat::zeros(eq.nParams, eq.nParams, CV_64F);
+        JTE = Mat::zeros(eq.nParams, 1, CV_64F);
+        for (int i = 0; i < (int)eq.U.size(); i++)
+        {
+            int o = eq.exOffset[i];
+            eq.U[i].copyTo(JTJ(Rect(o, o, 6, 6)));
+            eq.bEx[i].copyTo(JTE.rowRange(o, o + 6));
+            for (int k = 0; k < nShared; k++)
+            {
+                int s = eq.sharedIdx[k];
+                eq.W[i].col(k).copyTo(JTJ(Rect(s, o, 1, 6)));
+                Mat(eq.W[i].col(k).t()).copyTo(JTJ(Rect(o, s, 6, 1)));
+            }
+        }
+        for (int k = 0; k < nShared; k++)
+        {
+            int s = eq.sharedIdx[k];
+            JTE.at<double>(s) = eq.bShared.at<double>(k);
+            for (int l = 0; l < nShared; l++)
+                JTJ.at<double>(s, eq.sharedIdx[l]) = eq.V.at<double>(k, l);
+        }
 
-        //int nPoints = objectPoints.getMat(i).total();
-        //JIn.copyTo(J(Rect(6*n, i*nPoints*2, 10, nPoints*2)));
-        //JEx.copyTo(J(Rect(6*i, i*nPoints*2, 6, nPoints*2)));
-        //projError.reshape(1, 2*projError.rows).copyTo(exAll.rowRange(i*2*nPoints, (i+1)*2*nPoints));
+        omnidir::internal::subMatrix(JTJ, JTJ, idx, idx);
+        omnidir::internal::subMatrix(JTE, JTE, std::vector<int>(1, 1), idx);
     }
-    //JTJ = J.t()*J;
-    //JTE = J.t()*exAll;
-    std::vector<int> _idx(6*n+10, 1);
-    flags2idx(flags, _idx, n);
 
-    subMatrix(JTJ, JTJ, _idx, _idx);
-    subMatrix(JTE, JTE, std::vector<int>(1, 1), _idx);
-    // in case JTJ is singular
-	//SVD svd(JTJ, SVD::NO_UV);
-	//double cond = svd.w.at<double>(0)/svd.w.at<double>(5);
+    // eliminates the extrinsics of each view from JTJ*x = rhs: the rows of rhs are the free parameters,
+    // and the views are solved independently for every column of rhs
+    class SchurInvoker : public ParallelLoopBody
+    {
+    public:
+        SchurInvoker(const NormalEquations& _eq, const std::vector<int>& _freeShared, const Mat& _rhs,
+            std::vector<Mat>& _UinvW, std::vector<Mat>& _UinvB, std::vector<Mat>& _S, std::vector<Mat>& _r)
+            : eq(_eq), freeShared(_freeShared), rhs(_rhs), UinvW(_UinvW), UinvB(_UinvB), S(_S), r(_r)
+        {
+        }
+
+        void operator()(const Range& range) const
+        {
+            int m = (int)freeShared.size();
+            for (int i = range.start; i < range.end; i++)
+            {
+                Mat Wi(6, m, CV_64F);
+                for (int j = 0; j < m; j++)
+                    eq.W[i].col(freeShared[j]).copyTo(Wi.col(j));
+
+                Mat Uinv = eq.U[i].inv();
+                UinvB[i] = Uinv * rhs.rowRange(6*i, 6*i + 6);
+                if (m > 0)
+                {
+                    UinvW[i] = Uinv * Wi;
+                    gemm(Wi, UinvW[i], 1, noArray(), 0, S[i], GEMM_1_T);
+                    gemm(Wi, UinvB[i], 1, noArray(), 0, r[i], GEMM_1_T);
+                }
+            }
+        }
+
+    private:
+        const NormalEquations& eq;
+        const std::vector<int>& freeShared;
+        const Mat& rhs;
+        std::vector<Mat>& UinvW;
+        std::vector<Mat>& UinvB;
+        std::vector<Mat>& S;
+        std::vector<Mat>& r;
+
+        SchurInvoker& operator=(const SchurInvoker&); // to quiet MSVC
+    };
+
+    // solves (JTJ + epsilon)*G = JTE for the free parameters given by idx, with epsilon added to every
+    // entry of JTJ as computeJacobian does. JTJ + epsilon*u*u^T, u = (1, ..., 1)^T, is the block arrow
+    // JTJ updated by a rank one term, so the Schur complement solve of JTJ*[y z] = [JTE u] gives
+    // G = y - z*epsilon*(u^T*y)/(1 + epsilon*u^T*z).
+    void solveNormalEquations(const NormalEquations& eq, const std::vector<int>& idx, double epsilon, Mat& G)
+    {
+        int n = (int)eq.U.size();
+        std::vector<int> freeShared;
+        for (int k = 0; k < (int)eq.sharedIdx.size(); k++)
+        {
+            if (idx[eq.sharedIdx[k]])
+                freeShared.push_back(k);
+        }
+        int m = (int)freeShared.size();
+
+        // the views first, then the free shared parameters
+        Mat rhs(6*n + m, 2, CV_64F, Scalar(1));
+        for (int i = 0; i < n; i++)
+            eq.bEx[i].copyTo(rhs(Rect(0, 6*i, 1, 6)));
+        for (int j = 0; j < m; j++)
+            rhs.at<double>(6*n + j, 0) = eq.bShared.at<double>(freeShared[j]);
+
+        std::vector<Mat> UinvW(n), UinvB(n), S(n), r(n);
+        parallel_for_(Range(0, n), SchurInvoker(eq, freeShared, rhs, UinvW, UinvB, S, r));
+
+        Mat xShared = Mat::zeros(m, 2, CV_64F);
+        if (m > 0)
+        {
+            Mat Sall(m, m, CV_64F), rall = rhs.rowRange(6*n, 6*n + m).clone();
+            for (int j = 0; j < m; j++)
+            {
+                for (int l = 0; l < m; l++)
+                    Sall.at<double>(j, l) = eq.V.at<double>(freeShared[j], freeShared[l]);
+            }
+            for (int i = 0; i < n; i++)
+            {
+                Sall -= S[i];
+                rall -= r[i];
+            }
+            solve(Sall, rall, xShared, DECOMP_LU);
+        }
+
+        std::vector<Mat> xEx(n);
+        double uy = 0, uz = 0;
+        for (int j = 0; j < m; j++)
+        {
+            uy += xShared.at<double>(j, 0);
+            uz += xShared.at<double>(j, 1);
+        }
+        for (int i = 0; i < n; i++)
+        {
+            xEx[i] = m > 0 ? Mat(UinvB[i] - UinvW[i] * xShared) : UinvB[i];
+            for (int j = 0; j < 6; j++)
+            {
+                uy += xEx[i].at<double>(j, 0);
+                uz += xEx[i].at<double>(j, 1);
+            }
+        }
+        double scale = epsilon * uy / (1 + epsilon * uz);
+
+        Mat Gfull = Mat::zeros(eq.nParams, 1, CV_64F);
+        for (int i = 0; i < n; i++)
+            Mat(xEx[i].col(0) - scale * xEx[i].col(1)).copyTo(Gfull.rowRange(eq.exOffset[i], eq.exOffset[i] + 6));
+        for (int j = 0; j < m; j++)
+            Gfull.at<double>(eq.sharedIdx[freeShared[j]]) = xShared.at<double>(j, 0) - scale * xShared.at<double>(j, 1);
 
-	//if (cond_JTJ.needed())
-	//{
-	//	cond_JTJ.create(1, 1, CV_64F);
-	//	cond_JTJ.getMat().at<double>(0) = cond;
-	//}
+        omnidir::internal::subMatrix(Gfull, G, std::vector<int>(1, 1), idx);
+    }
+}}
+
+void cv::omnidir::internal::computeJacobian(InputArrayOfArrays objectPoints, InputArrayOfArrays imagePoints,
+    InputArray parameters, Mat& JTJ_inv, Mat& JTE, int flags, double epsilon)
+{
+    NormalEquations eq;
+    computeNormalEquations(objectPoints, imagePoints, parameters, eq);
+
+    int n = (int)objectPoints.total();
+    std::vector<int> _idx(6*n+10, 1);
+    flags2idx(flags, _idx, n);
 
-    //double epsilon = 1e-4*std::exp(cond);
+    Mat JTJ;
+    denseNormalEquations(eq, _idx, JTJ, JTE);
     JTJ_inv = Mat(JTJ+epsilon).inv();
 }
 
 void cv::omnidir::internal::computeJacobianStereo(InputArrayOfArrays objectPoints, InputArrayOfArrays imagePoints1, InputArrayOfArrays imagePoints2,
     InputArray parameters, Mat& JTJ_inv, Mat& JTE, int flags, double epsilon)
 {
-    CV_Assert(!objectPoints.empty() && objectPoints.type() == CV_64FC3);
-    CV_Assert(!imagePoints1.empty() && imagePoints1.type() == CV_64FC2);
-    CV_Assert(!imagePoints2.empty() && imagePoints2.type() == CV_64FC2);
-    CV_Assert((imagePoints1.total() == imagePoints2.total()) && (imagePoints1.total() == objectPoints.total()));
+    NormalEquations eq;
+    computeNormalEquationsStereo(objectPoints, imagePoints1, imagePoints2, parameters, eq);
 
-    // compute Jacobian matrix by naive way
     int n_img = (int)objectPoints.total();
-    int n_points = (int)objectPoints.getMat(0).total();
-    Mat J = Mat::zeros(4 * n_points * n_img, 20 + 6 * (n_img + 1), CV_64F);
-    Mat exAll = Mat::zeros(4 * n_points * n_img, 1, CV_64F);
-    double *para = parameters.getMat().ptr<double>();
-    int offset1 = (n_img + 1) * 6;
-    int offset2 = offset1 + 10;
-    Matx33d K1(para[offset1], para[offset1+2], para[offset1+3],
-        0,    para[offset1+1], para[offset1+4],
-        0,    0,  1);
-    Matx14d D1(para[offset1+6], para[offset1+7], para[offset1+8], para[offset1+9]);
-    double xi1 = para[offset1+5];
+    std::vector<int> _idx(6*(n_img+1)+20, 1);
+    flags2idxStereo(flags, _idx, n_img);
 
-    Matx33d K2(para[offset2], para[offset2+2], para[offset2+3],
-        0,    para[offset2+1], para[offset2+4],
-        0,    0,  1);
-    Matx14d D2(para[offset2+6], para[offset2+7], para[offset2+8], para[offset2+9]);
-    double xi2 = para[offset2+5];
+    Mat JTJ;
+    denseNormalEquations(eq, _idx, JTJ, JTE);
+    JTJ_inv = Mat(JTJ+epsilon).inv();
+}
 
-    Mat om = parameters.getMat().reshape(1, 1).colRange(0, 3);
-    Mat T = parameters.getMat().reshape(1, 1).colRange(3, 6);
+void cv::omnidir::internal::computeGaussNewtonStep(InputArrayOfArrays objectPoints, InputArrayOfArrays imagePoints,
+    InputArray parameters, Mat& G, int flags, double epsilon)
+{
+    NormalEquations eq;
+    computeNormalEquations(objectPoints, imagePoints, parameters, eq);
 
-    for (int i = 0; i < n_img; i++)
-    {
-        Mat objPointsi, imgPoints1i, imgPoints2i, om1, T1;
-        objectPoints.getMat(i).copyTo(objPointsi);
-        imagePoints1.getMat(i).copyTo(imgPoints1i);
-        imagePoints2.getMat(i).copyTo(imgPoints2i);
-        objPointsi = objPointsi.reshape(3, objPointsi.rows*objPointsi.cols);
-        imgPoints1i = imgPoints1i.reshape(2, imgPoints1i.rows*imgPoints1i.cols);
-        imgPoints2i = imgPoints2i.reshape(2, imgPoints2i.rows*imgPoints2i.cols);
-
-        om1 = parameters.getMat().reshape(1, 1).colRange((1 + i) * 6, (1 + i) * 6 + 3);
-        T1 = parameters.getMat().reshape(1, 1).colRange((1 + i) * 6 + 3, (i + 1) * 6 + 6);
-
-
-        Mat imgProj1, imgProj2, jacobian1, jacobian2;
-
-        // jacobian for left image
-        cv::omnidir::projectPoints(objPointsi, imgProj1, om1, T1, K1, xi1, D1, jacobian1);
-        Mat projError1 = imgPoints1i - imgProj1;
-        //Mat JIn1(jacobian1.rows, 10, CV_64F);
-        //Mat JEx1(jacobian1.rows, 6, CV_64F);
-        jacobian1.colRange(6, 16).copyTo(J(Rect(6*(n_img+1), i*n_points*4, 10, n_points*2)));
-        jacobian1.colRange(0, 6).copyTo(J(Rect(6+i*6, i*n_points*4, 6, n_points*2)));
-        projError1.reshape(1, 2*n_points).copyTo(exAll.rowRange(i*4*n_points, (i*4+2)*n_points));
-
-        //jacobian for right image
-        Mat om2, T2, dom2dom1, dom2dT1, dom2dom, dom2dT, dT2dom1, dT2dT1, dT2dom, dT2dT;
-        cv::omnidir::internal::compose_motion(om1, T1, om, T, om2, T2, dom2dom1, dom2dT1, dom2dom, dom2dT, dT2dom1, dT2dT1, dT2dom, dT2dT);
-        cv::omnidir::projectPoints(objPointsi, imgProj2, om2, T2, K2, xi2, D2, jacobian2);
-        Mat projError2 = imgPoints2i - imgProj2;
-        projError2.reshape(1, 2*n_points).copyTo(exAll.rowRange((i*4+2)*n_points, (i*4+4)*n_points));
-        Mat dxrdom = jacobian2.colRange(0, 3) * dom2dom + jacobian2.colRange(3, 6) * dT2dom;
-        Mat dxrdT = jacobian2.colRange(0, 3) * dom2dT + jacobian2.colRange(3, 6) * dT2dT;
-        Mat dxrdom1 = jacobian2.colRange(0, 3) * dom2dom1 + jacobian2.colRange(3, 6) * dT2dom1;
-        Mat dxrdT1 = jacobian2.colRange(0, 3) * dom2dT1 + jacobian2.colRange(3, 6) * dT2dT1;
-
-        dxrdom.copyTo(J(Rect(0, (i*4+2)*n_points, 3, n_points*2)));
-        dxrdT.copyTo(J(Rect(3, (i*4+2)*n_points, 3, n_points*2)));
-        dxrdom1.copyTo(J(Rect(6+i*6, (i*4+2)*n_points, 3, n_points*2)));
-        dxrdT1.copyTo(J(Rect(6+i*6+3, (i*4+2)*n_points, 3, n_points*2)));
-        jacobian2.colRange(6, 16).copyTo(J(Rect(6*(n_img+1)+10, (4*i+2)*n_points, 10, n_points*2)));
-    }
+    int n = (int)objectPoints.total();
+    std::vector<int> _idx(6*n+10, 1);
+    flags2idx(flags, _idx, n);
 
+    solveNormalEquations(eq, _idx, epsilon, G);
+}
+
+void cv::omnidir::internal::computeGaussNewtonStepStereo(InputArrayOfArrays objectPoints, InputArrayOfArrays imagePoints1, InputArrayOfArrays imagePoints2,
+    InputArray parameters, Mat& G, int flags, double epsilon)
+{
+    NormalEquations eq;
+    computeNormalEquationsStereo(objectPoints, imagePoints1, imagePoints2, parameters, eq);
+
+    int n_img = (int)objectPoints.total();
     std::vector<int> _idx(6*(n_img+1)+20, 1);
     flags2idxStereo(flags, _idx, n_img);
 
-    Mat JTJ = J.t()*J;
-    JTE = J.t()*exAll;
-    subMatrix(JTJ, JTJ, _idx, _idx);
-    subMatrix(JTE, JTE, std::vector<int>(1, 1), _idx);
-
-    JTJ_inv = Mat(JTJ+epsilon).inv();
+    solveNormalEquations(eq, _idx, epsilon, G);
 }
 
 // This function is from fisheye.cpp
@@ -1121,12 +1381,12 @@ double cv::omnidir::calibrate(InputArray patternPoints, InputArray imagePoints,
             (criteria.type == 3 && (change <= criteria.epsilon || iter >= criteria.maxCount)))
             break;
         double alpha_smooth2 = 1 - std::pow(1 - alpha_smooth, (double)iter + 1.0);
-        Mat JTJ_inv, JTError;
 		double epsilon = 0.01 * std::pow(0.9, (double)iter/10);
-        cv::omnidir::internal::computeJacobian(_patternPoints, _imagePoints, currentParam, JTJ_inv, JTError, flags, epsilon);
 
         // GaussCNewton
-        Mat G = alpha_smooth2*JTJ_inv * JTError;
+        Mat G;
+        cv::omnidir::internal::computeGaussNewtonStep(_patternPoints, _imagePoints, currentParam, G, flags, epsilon);
+        G = alpha_smooth2*G;
 
         omnidir::internal::fillFixed(G, flags, n);
 
@@ -1272,14 +1532,13 @@ double cv::omnidir::stereoCalibrate(InputOutputArrayOfArrays objectPoints, Input
             (criteria.type == 3 && (change <= criteria.epsilon || iter >= criteria.maxCount)))
             break;
         double alpha_smooth2 = 1 - std::pow(1 - alpha_smooth, (double)iter + 1.0);
-        Mat JTJ_inv, JTError;
 		double epsilon = 0.01 * std::pow(0.9, (double)iter/10);
 
-        cv::omnidir::internal::computeJacobianStereo(_objectPointsFilt, _imagePoints1Filt, _imagePoints2Filt, currentParam,
-			JTJ_inv, JTError, flags, epsilon);
-
         // GaussCNewton
-        Mat G = alpha_smooth2*JTJ_inv * JTError;
+        Mat G;
+        cv::omnidir::internal::computeGaussNewtonStepStereo(_objectPointsFilt, _imagePoints1Filt, _imagePoints2Filt, currentParam,
+			G, flags, epsilon);
+        G = alpha_smooth2*G;
 
         omnidir::internal::fillFixedStereo(G, flags, n);
 
@@ -1378,6 +1637,18 @@ void cv::omnidir::stereoReconstruct(InputArray image1, InputArray image2, InputA
     InputArray xi1, InputArray K2, InputArray D2, InputArray xi2, InputArray R, InputArray T, int flag,
     int numDisparities, int SADWindowSize, OutputArray disparity, OutputArray image1Rec, OutputArray image2Rec,
     const Size& newSize, InputArray Knew, OutputArray pointCloud, int pointType)
+{
+    StereoReconstructor(K1, D1, xi1, K2, D2, xi2, R, T, flag, numDisparities, SADWindowSize, newSize, Knew)
+        .reconstruct(image1, image2, disparity, image1Rec, image2Rec, pointCloud, pointType);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// cv::omnidir::StereoReconstructor
+
+cv::omnidir::StereoReconstructor::StereoReconstructor(InputArray K1, InputArray D1, InputArray xi1, InputArray K2,
+    InputArray D2, InputArray xi2, InputArray R, InputArray T, int flag, int numDisparities, int SADWindowSize,
+    const Size& newSize, InputArray Knew)
+    : _flag(flag), _numDisparities(numDisparities), _SADWindowSize(SADWindowSize), _newSize(newSize), _sgbmChannels(0)
 {
     CV_Assert(!K1.empty() && K1.size() == Size(3,3) && (K1.type() == CV_64F || K1.type() == CV_32F));
     CV_Assert(!K2.empty() && K2.size() == Size(3,3) && (K2.type() == CV_64F || K2.type() == CV_32F));
@@ -1385,8 +1656,6 @@ void cv::omnidir::stereoReconstruct(InputArray image1, InputArray image2, InputA
     CV_Assert(!D2.empty() && D2.total() == 4 && (D2.type() == CV_64F || D2.type() == CV_32F));
     CV_Assert(!R.empty() && (R.size() == Size(3,3) || R.total() == 3) && (R.type() == CV_64F || R.type() == CV_32F));
     CV_Assert(!T.empty() && T.total() == 3 && (T.type() == CV_64F || T.type() == CV_32F));
-    CV_Assert(!image1.empty() && (image1.type() == CV_8U || image1.type() == CV_8UC3));
-    CV_Assert(!image2.empty() && (image2.type() == CV_8U || image2.type() == CV_8UC3));
     CV_Assert(flag == omnidir::RECTIFY_LONGLATI || flag == omnidir::RECTIFY_PERSPECTIVE);
 
     Mat _K1, _D1, _K2, _D2, _R, _T;
@@ -1409,15 +1678,26 @@ void cv::omnidir::stereoReconstruct(InputArray image1, InputArray image2, InputA
     // stereo rectify so that stereo matching can be applied in one line
     Mat R1, R2;
     stereoRectify(_R, _T, R1, R2);
-    Mat undis1, undis2;
-    Matx33d _Knew = Matx33d(_K1);
+    _Knew = Matx33d(_K1);
     if (!Knew.empty())
     {
         Knew.getMat().convertTo(_Knew, CV_64F);
     }
+    _baseline = cv::norm(T);
 
-    undistortImage(image1.getMat(), undis1, _K1, _D1, xi1, flag, _Knew, newSize, R1);
-    undistortImage(image2.getMat(), undis2, _K2, _D2, xi2, flag, _Knew, newSize, R2);
+    _rectifier1.init(_K1, _D1, xi1, flag, _Knew, newSize, R1);
+    _rectifier2.init(_K2, _D2, xi2, flag, _Knew, newSize, R2);
+}
+
+void cv::omnidir::StereoReconstructor::reconstruct(InputArray image1, InputArray image2, OutputArray disparity,
+    OutputArray image1Rec, OutputArray image2Rec, OutputArray pointCloud, int pointType)
+{
+    CV_Assert(!image1.empty() && (image1.type() == CV_8U || image1.type() == CV_8UC3));
+    CV_Assert(!image2.empty() && (image2.type() == CV_8U || image2.type() == CV_8UC3));
+
+    Mat undis1, undis2;
+    _rectifier1.apply(image1.getMat(), undis1);
+    _rectifier2.apply(image2.getMat(), undis2);
 
     undis1.copyTo(image1Rec);
     undis2.copyTo(image2Rec);
@@ -1425,19 +1705,21 @@ void cv::omnidir::stereoReconstruct(InputArray image1, InputArray image2, InputA
     // stereo matching by semi-global
     Mat _disMap;
     int channel = image1.channels();
+    if (_sgbm.empty() || _sgbmChannels != channel)
+    {
+        _sgbm = StereoSGBM::create(0, _numDisparities, _SADWindowSize, 8 * channel*_SADWindowSize*_SADWindowSize,
+            32 * channel*_SADWindowSize*_SADWindowSize);
+        _sgbmChannels = channel;
+    }
 
-    //cv::StereoSGBM matching(0, numDisparities, SADWindowSize, 8*channel*SADWindowSize*SADWindowSize, 32*channel*SADWindowSize*SADWindowSize);
-    //matching(undis1, undis2, _depthMap);
-	Ptr<StereoSGBM> sgbm = StereoSGBM::create(0, numDisparities, SADWindowSize, 8 * channel*SADWindowSize*SADWindowSize, 32 * channel*SADWindowSize*SADWindowSize);
-
-	sgbm->compute(undis1, undis2, _disMap);
+    _sgbm->compute(undis1, undis2, _disMap);
 
     // some regions of image1 is black, the corresponding regions of disparity map is also invalid.
     Mat realDis;
 	_disMap.convertTo(_disMap, CV_32F);
     Mat(_disMap/16.0f).convertTo(realDis, CV_32F);
 
-    Mat grayImg, binaryImg, idx;
+    Mat grayImg, binaryImg;
     if (undis1.channels() == 3)
     {
         cvtColor(undis1, grayImg, COLOR_RGB2GRAY);
@@ -1448,19 +1730,14 @@ void cv::omnidir::stereoReconstruct(InputArray image1, InputArray image2, InputA
     }
 
     binaryImg = (grayImg <= 0);
-    findNonZero(binaryImg, idx);
-    for (int i = 0; i < (int)idx.total(); ++i)
-    {
-        Vec2i _idx = idx.at<Vec2i>(i);
-        realDis.at<float>(_idx[1], _idx[0]) = 0.0f;
-    }
+    realDis.setTo(0.0f, binaryImg);
 
     disparity.create(realDis.size(), realDis.type());
     realDis.copyTo(disparity.getMat());
 
     std::vector<Vec3f> _pointCloud;
     std::vector<Vec6f> _pointCloudColor;
-    double baseline = cv::norm(T);
+    double baseline = _baseline;
     double f = _Knew(0, 0);
     Matx33d K_inv = _Knew.inv();
 
@@ -1472,9 +1749,9 @@ void cv::omnidir::stereoReconstruct(InputArray image1, InputArray image2, InputA
 
     if (pointCloud.needed())
     {
-        for (int i = 0; i < newSize.width; ++i)
+        for (int i = 0; i < _newSize.width; ++i)
         {
-            for(int j = 0; j < newSize.height; ++j)
+            for(int j = 0; j < _newSize.height; ++j)
             {
                 Vec3f point;
                 Vec6f pointColor;
@@ -1485,11 +1762,11 @@ void cv::omnidir::stereoReconstruct(InputArray image1, InputArray image2, InputA
                     // for RECTIFY_LONGLATI, (x,y) are (theta, phi) angles
                     float x = float(K_inv(0,0) * i + K_inv(0,1) * j + K_inv(0,2));
                     float y = float(K_inv(1,0) * i + K_inv(1,1) * j + K_inv(1,2));
-                    if (flag == omnidir::RECTIFY_LONGLATI)
+                    if (_flag == omnidir::RECTIFY_LONGLATI)
                     {
                         point = Vec3f((float)-std::cos(x), (float)(-std::sin(x)*std::cos(y)), (float)(std::sin(x)*std::sin(y))) * depth;
                     }
-                    else if(flag == omnidir::RECTIFY_PERSPECTIVE)
+                    else if(_flag == omnidir::RECTIFY_PERSPECTIVE)
                     {
                         point = Vec3f(float(x), float(y), 1.0f) * depth;
                     }
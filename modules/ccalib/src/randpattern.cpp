@@ -73,22 +73,54 @@ RandomPatternCornerFinder::RandomPatternCornerFinder(float patternWidth, float p
     _matcher = matcher;
     _showExtraction = showExtraction;
 	_verbose = verbose;
+    _detectionScale = 1.0;
 }
 
+class ObjectImagePointsInvoker : public ParallelLoopBody
+{
+public:
+    ObjectImagePointsInvoker(RandomPatternCornerFinder& _finder, const std::vector<cv::Mat>& _inputImages,
+        std::vector<std::vector<Mat> >& _imageObjectPoints)
+        : finder(_finder), inputImages(_inputImages), imageObjectPoints(_imageObjectPoints)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        for (int i = range.start; i < range.end; ++i)
+        {
+            imageObjectPoints[i] = finder.computeObjectImagePointsForSingle(inputImages[i]);
+        }
+    }
+
+private:
+    RandomPatternCornerFinder& finder;
+    const std::vector<cv::Mat>& inputImages;
+    std::vector<std::vector<Mat> >& imageObjectPoints;
+
+    ObjectImagePointsInvoker& operator=(const ObjectImagePointsInvoker&); // to quiet MSVC
+};
+
 void RandomPatternCornerFinder::computeObjectImagePoints(std::vector<cv::Mat> inputImages)
 {
     CV_Assert(!_patternImage.empty());
     CV_Assert(inputImages.size() > 0);
 
     int nImages = (int)inputImages.size();
-    std::vector<Mat> imageObjectPoints;
+    std::vector<std::vector<Mat> > imageObjectPoints(nImages);
+    ObjectImagePointsInvoker invoker(*this, inputImages, imageObjectPoints);
+    // the correspondences are shown, and the counts are printed, image by image
+    if (_showExtraction || _verbose)
+        invoker(Range(0, nImages));
+    else
+        parallel_for_(Range(0, nImages), invoker);
+
     for (int i = 0; i < nImages; ++i)
     {
-        imageObjectPoints = computeObjectImagePointsForSingle(inputImages[i]);
-        if ((int)imageObjectPoints[0].total() > _nminiMatch)
+        if ((int)imageObjectPoints[i][0].total() > _nminiMatch)
         {
-            _imagePoints.push_back(imageObjectPoints[0]);
-            _objectPonits.push_back(imageObjectPoints[1]);
+            _imagePoints.push_back(imageObjectPoints[i][0]);
+            _objectPonits.push_back(imageObjectPoints[i][1]);
         }
     }
 }
@@ -156,24 +188,46 @@ void RandomPatternCornerFinder::getObjectImagePoints(const cv::Mat& imageKeypoin
     _objectPonits.push_back(objectPoints_i);
 }
 
-void RandomPatternCornerFinder::crossCheckMatching( Ptr<DescriptorMatcher>& descriptorMatcher,
-    const Mat& descriptors1, const Mat& descriptors2,
+void RandomPatternCornerFinder::crossCheckMatching( const Mat& descriptors,
     std::vector<DMatch>& filteredMatches12, int knn )
 {
     filteredMatches12.clear();
     std::vector<std::vector<DMatch> > matches12, matches21;
-    descriptorMatcher->knnMatch( descriptors1, descriptors2, matches12, knn );
-    descriptorMatcher->knnMatch( descriptors2, descriptors1, matches21, knn );
+    _patternMatcher->knnMatch( descriptors, matches12, knn );
+
+    // only the pattern descriptors that are matched by the image are matched back
+    std::vector<int> backIdx(_descriptorPattern.rows, -1);
+    std::vector<int> patternRows;
+    for( size_t m = 0; m < matches12.size(); m++ )
+    {
+        for( size_t fk = 0; fk < matches12[m].size(); fk++ )
+        {
+            int trainIdx = matches12[m][fk].trainIdx;
+            if( backIdx[trainIdx] < 0 )
+            {
+                backIdx[trainIdx] = (int)patternRows.size();
+                patternRows.push_back(trainIdx);
+            }
+        }
+    }
+    if( patternRows.empty() )
+        return;
+    Mat patternDescriptors((int)patternRows.size(), _descriptorPattern.cols, _descriptorPattern.type());
+    for( size_t i = 0; i < patternRows.size(); i++ )
+        _descriptorPattern.row(patternRows[i]).copyTo(patternDescriptors.row((int)i));
+    _matcher->knnMatch( patternDescriptors, descriptors, matches21, knn );
+
     for( size_t m = 0; m < matches12.size(); m++ )
     {
         bool findCrossCheck = false;
         for( size_t fk = 0; fk < matches12[m].size(); fk++ )
         {
             DMatch forward = matches12[m][fk];
+            const std::vector<DMatch>& backwards = matches21[backIdx[forward.trainIdx]];
 
-            for( size_t bk = 0; bk < matches21[forward.trainIdx].size(); bk++ )
+            for( size_t bk = 0; bk < backwards.size(); bk++ )
             {
-                DMatch backward = matches21[forward.trainIdx][bk];
+                DMatch backward = backwards[bk];
                 if( backward.trainIdx == forward.queryIdx )
                 {
                     filteredMatches12.push_back(forward);
@@ -247,47 +301,88 @@ void RandomPatternCornerFinder::loadPattern(cv::Mat patternImage)
     _detector->detect(patternImage, _keypointsPattern);
     _descriptor->compute(patternImage, _keypointsPattern, _descriptorPattern);
     _descriptorPattern.convertTo(_descriptorPattern, CV_32F);
+
+    // the pattern is indexed once, for a FlannBasedMatcher too, and the images are matched against it
+    _patternMatcher = _matcher->clone(true);
+    _patternMatcher->add(std::vector<Mat>(1, _descriptorPattern));
+    _patternMatcher->train();
+}
+
+void RandomPatternCornerFinder::setDetectionScale(double scale)
+{
+    CV_Assert(scale > 0 && scale <= 1);
+    _detectionScale = scale;
+}
+
+void RandomPatternCornerFinder::matchImage(const Mat& image, int& variant, std::vector<cv::KeyPoint>& keypoints,
+    std::vector<cv::DMatch>& matches)
+{
+    // variant 0 is the image, 1 its equalized histogram, and -1 the one of them with more matches
+    std::vector<cv::KeyPoint> keypointsImage[2];
+    std::vector<DMatch> matchesImgtoPat[2];
+    for (int v = 0; v < 2; ++v)
+    {
+        if (variant >= 0 && v != variant)
+            continue;
+
+        Mat img, descriptorImage;
+        if (v == 1)
+            equalizeHist(image, img);
+        else
+            img = image;
+        _detector->detect(img, keypointsImage[v]);
+        _descriptor->compute(img, keypointsImage[v], descriptorImage);
+        descriptorImage.convertTo(descriptorImage, CV_32F);
+        crossCheckMatching(descriptorImage, matchesImgtoPat[v], 1);
+    }
+    if (variant < 0)
+        variant = (int)matchesImgtoPat[0].size() > (int)matchesImgtoPat[1].size() ? 0 : 1;
+
+    keypoints.swap(keypointsImage[variant]);
+    matches.swap(matchesImgtoPat[variant]);
 }
 
 std::vector<cv::Mat> RandomPatternCornerFinder::computeObjectImagePointsForSingle(cv::Mat inputImage)
 {
     CV_Assert(!_patternImage.empty());
     std::vector<cv::Mat> r(2);
-    Mat descriptorImage1, descriptorImage2,descriptorImage;
-    std::vector<cv::KeyPoint> keypointsImage1, keypointsImage2, keypointsImage;
     if (inputImage.type()!=CV_8U)
     {
         inputImage.convertTo(inputImage, CV_8U);
     }
+    double homographyThreshold = 30*inputImage.cols/1000;
 
-    Mat imageEquHist;
-    equalizeHist(inputImage, imageEquHist);
-
-    _detector->detect(inputImage, keypointsImage1);
-    _descriptor->compute(inputImage, keypointsImage1, descriptorImage1);
-    _detector->detect(imageEquHist, keypointsImage2);
-    _descriptor->compute(imageEquHist, keypointsImage2, descriptorImage2);
-    descriptorImage1.convertTo(descriptorImage1, CV_32F);
-    descriptorImage2.convertTo(descriptorImage2, CV_32F);
-
-    // match with pattern
-    std::vector<DMatch> matchesImgtoPat, matchesImgtoPat1, matchesImgtoPat2;
-
-    cv::Mat keypointsImageLocation, keypointsPatternLocation;
-
-    crossCheckMatching(this->_matcher, descriptorImage1, this->_descriptorPattern, matchesImgtoPat1, 1);
-    crossCheckMatching(this->_matcher, descriptorImage2, this->_descriptorPattern, matchesImgtoPat2, 1);
-    if ((int)matchesImgtoPat1.size() > (int)matchesImgtoPat2.size())
+    // the first detection on the downscaled image, the homography is scaled to the full resolution
+    int variant = -1;
+    Mat coarseHomography;
+    if (_detectionScale < 1)
     {
-        matchesImgtoPat = matchesImgtoPat1;
-        keypointsImage = keypointsImage1;
-    }
-    else
-    {
-        matchesImgtoPat = matchesImgtoPat2;
-        keypointsImage = keypointsImage2;
+        Mat imageSmall, smallImageLocation, smallPatternLocation;
+        resize(inputImage, imageSmall, Size(), _detectionScale, _detectionScale, INTER_AREA);
+        std::vector<cv::KeyPoint> keypointsSmall;
+        std::vector<DMatch> matchesSmall;
+        matchImage(imageSmall, variant, keypointsSmall, matchesSmall);
+        keyPoints2MatchedLocation(keypointsSmall, this->_keypointsPattern, matchesSmall,
+            smallImageLocation, smallPatternLocation);
+        if ((int)smallImageLocation.total() >= 4)
+        {
+            coarseHomography = findHomography(smallImageLocation, smallPatternLocation, RANSAC, homographyThreshold);
+        }
+        if (coarseHomography.empty())
+        {
+            variant = -1;
+        }
+        else
+        {
+            coarseHomography = coarseHomography * Mat(Matx33d(_detectionScale, 0, 0, 0, _detectionScale, 0, 0, 0, 1));
+        }
     }
 
+    std::vector<cv::KeyPoint> keypointsImage;
+    std::vector<DMatch> matchesImgtoPat;
+    cv::Mat keypointsImageLocation, keypointsPatternLocation;
+    matchImage(inputImage, variant, keypointsImage, matchesImgtoPat);
+
     keyPoints2MatchedLocation(keypointsImage, this->_keypointsPattern, matchesImgtoPat,
         keypointsImageLocation, keypointsPatternLocation);
 
@@ -308,8 +403,22 @@ std::vector<cv::Mat> RandomPatternCornerFinder::computeObjectImagePointsForSingl
 		std::cout << "number of matched points " << (int)keypointsImageLocation.total() << std::endl;
 	}
     // outlier remove
-    findFundamentalMat(keypointsImageLocation, keypointsPatternLocation,
-        FM_RANSAC, 1, 0.995, innerMask1);
+    if (coarseHomography.empty())
+    {
+        findFundamentalMat(keypointsImageLocation, keypointsPatternLocation,
+            FM_RANSAC, 1, 0.995, innerMask1);
+    }
+    else if (!keypointsImageLocation.empty())
+    {
+        Mat predicted;
+        perspectiveTransform(keypointsImageLocation, predicted, coarseHomography);
+        innerMask1.create((int)predicted.total(), 1, CV_8U);
+        for (int i = 0; i < (int)predicted.total(); ++i)
+        {
+            Vec2d d = predicted.at<Vec2d>(i) - keypointsPatternLocation.at<Vec2d>(i);
+            innerMask1.at<uchar>(i) = (uchar)(d.dot(d) <= 4*homographyThreshold*homographyThreshold);
+        }
+    }
     getFilteredLocation(keypointsImageLocation, keypointsPatternLocation, innerMask1);
 
 	if (this->_showExtraction)
@@ -318,7 +427,7 @@ std::vector<cv::Mat> RandomPatternCornerFinder::computeObjectImagePointsForSingl
 			innerMask1, innerMask2, 2);
 	}
 
-    findHomography(keypointsImageLocation, keypointsPatternLocation, RANSAC, 30*inputImage.cols/1000, innerMask2);
+    findHomography(keypointsImageLocation, keypointsPatternLocation, RANSAC, homographyThreshold, innerMask2);
     getFilteredLocation(keypointsImageLocation, keypointsPatternLocation, innerMask2);
 
 	if (_verbose)
@@ -72,6 +72,10 @@ the use of this software, even if advised of the possibility of such damage.
 #include "opencv2/highgui.hpp"
 #include "opencv2/highgui/highgui_c.h"
 #include "opencv2/imgproc.hpp"
+#include "opencv2/opencv_modules.hpp"
+#ifdef HAVE_OPENCV_DNN
+#include "opencv2/dnn.hpp"
+#endif
 using caffe::Blob;
 using caffe::Caffe;
 using caffe::Datum;
@@ -208,6 +212,59 @@ namespace cnn_3dobj
         CV_WRAP static void writeBinaryfile(String filenameImg, const char* binaryPath, const char* headerPath, int num_item, int label_class, int x, int y, int z, int isrgb);
     };
 
+/** @brief Buffered writer of the binary training files written by icoSphere::writeBinaryfile.
+ The image and label files stay open while samples are added, the samples are collected in memory and
+ written with large sequential writes. The images of a call are read and converted in parallel.
+ */
+    class CV_EXPORTS binaryDatasetWriter
+    {
+        private:
+        std::ofstream imgFile;
+        std::ofstream labFile;
+        std::vector<uchar> imgBuffer;
+        std::vector<uchar> labBuffer;
+        cv::Size sampleSize;
+        int isrgb;
+        size_t bufferSize;
+
+        void addSamples(const std::vector<cv::Mat>& imgs, const std::vector<String>& filenames, const std::vector<cv::Vec4i>& labels);
+
+        binaryDatasetWriter(const binaryDatasetWriter&);
+        binaryDatasetWriter& operator=(const binaryDatasetWriter&);
+
+        public:
+        /** @brief Open the binary files binaryPath + "image" and binaryPath + "label".
+         The headers are written when the files are created, otherwise the samples are appended.
+        @param binaryPath Path which will output a binary file.
+        @param num_item Number of samples written in the headers.
+        @param rows Rows of a single sample image.
+        @param cols Columns of a single sample image.
+        @param isrgb Option for choice of using RGB images or not.
+        @param buffer_size Bytes of the samples collected before they are written.
+         */
+        binaryDatasetWriter(const String& binaryPath, int num_item, int rows, int cols, int isrgb, size_t buffer_size = 1 << 24);
+
+        /** @brief Write the remaining samples and close the files.
+         */
+        ~binaryDatasetWriter();
+
+        /** @brief Add samples.
+        @param imgs Images of rows x cols pixels, CV_8UC1 or CV_8UC3 if isrgb is set.
+        @param labels Class label and the X, Y and Z pose labels of each image.
+         */
+        void write(InputArrayOfArrays imgs, const std::vector<cv::Vec4i>& labels);
+
+        /** @brief Add samples from image files, the files are read in parallel.
+        @param filenames Paths of the images.
+        @param labels Class label and the X, Y and Z pose labels of each image.
+         */
+        void writeFiles(const std::vector<String>& filenames, const std::vector<cv::Vec4i>& labels);
+
+        /** @brief Write the collected samples to the files.
+         */
+        void flush();
+    };
+
 /** @brief Caffe based 3D images descriptor.
  A class to extract features from an image. The so obtained descriptors can be used for classification and pose estimation goals @cite wohlhart15.
  */
@@ -217,6 +274,9 @@ namespace cnn_3dobj
     {
         private:
         caffe::Net<float>* convnet;
+#ifdef HAVE_OPENCV_DNN
+        cv::dnn::Net dnnnet;
+#endif
         cv::Size input_geometry;
         int num_channels;
         bool net_set;
@@ -224,13 +284,14 @@ namespace cnn_3dobj
         cv::Mat mean_;
         String deviceType;
         int deviceId;
+        int batchSize;
 
         /** @brief Load the mean file in binaryproto format if it is needed.
         @param mean_file Path of mean file which stores the mean of training images, it is usually generated by Caffe tool.
          */
         void setMean(const String& mean_file);
 
-        /** @brief Wrap the input layer of the network in separate cv::Mat objects(one per channel).
+        /** @brief Wrap the input layer of the network in separate cv::Mat objects(one per channel of each image of the batch).
          This way we save one memcpy operation and we don't need to rely on cudaMemcpy2D.
          The last preprocessing operation will write the separate channels directly to the input layer.
          */
@@ -240,9 +301,13 @@ namespace cnn_3dobj
          */
         void preprocess(const cv::Mat& img, std::vector<cv::Mat>* input_channels);
 
+        /** @brief Run the net forward on a batch of images at once, one descriptor per row of feature.
+         */
+        void extractBatch(const cv::Mat* img, int num, const String& feature_blob, cv::Mat& feature);
+
         public:
         /** @brief Set the device for feature extraction, if the GPU is used, there should be a device_id.
-        @param device_type CPU or GPU.
+        @param device_type CPU or GPU for Caffe, or DNN to run the net with the opencv_dnn module instead.
         @param device_id ID of GPU.
          */
         descriptorExtractor(const String& device_type, int device_id = 0);
@@ -256,8 +321,9 @@ namespace cnn_3dobj
         int getDeviceId();
 
         /** @brief Set device type information for feature extraction.
-         Useful to change device without the need to reload the net.
-        @param device_type CPU or GPU.
+         Useful to change device without the need to reload the net, switching between Caffe and DNN
+        needs to call loadNet again.
+        @param device_type CPU, GPU or DNN.
          */
         void setDeviceType(const String& device_type);
 
@@ -271,14 +337,24 @@ namespace cnn_3dobj
          the network structure is stored in trained_file, you can decide whether to use mean images or not.
         @param model_file Path of caffemodel which including all parameters in CNN.
         @param trained_file Path of prototxt which defining the structure of CNN.
-        @param mean_file Path of mean file(option).
+        @param mean_file Path of mean file(option), it is not supported by the DNN device.
          */
         void loadNet(const String& model_file, const String& trained_file, const String& mean_file = "");
 
+        /** @brief Set how many images are passed through the net at once by extract.
+        @param batch_size Number of images of a batch, 1 runs the images one by one.
+         */
+        void setBatchSize(int batch_size);
+
+        /** @brief Get how many images are passed through the net at once by extract.
+         */
+        int getBatchSize();
+
         /** @brief Extract features from a single image or from a vector of images.
          If loadNet was not called before, this method invocation will fail.
+         The images of a vector are given to the input layer in batches of getBatchSize() images.
         @param inputimg Input images.
-        @param feature Output features.
+        @param feature Output features, one row per image.
         @param feature_blob Layer which the feature is extracted from.
          */
         void extract(InputArrayOfArrays inputimg, OutputArray feature, String feature_blob);
@@ -238,9 +238,14 @@ int main(int argc, char *argv[])
         cam_focal_point = Point3d(0,0,0);
     const char* headerPath = "../data/header_for_";
     const char* binaryPath = "../data/binary_";
+    /* The samples of the binary files are collected and written at once. */
+    Ptr<binaryDatasetWriter> binary_writer;
+    std::vector<String> binary_files;
+    std::vector<Vec4i> binary_labels;
     if (binary_out)
     {
         ViewSphere.createHeader(static_cast<int>(campos.size()), image_size, image_size, headerPath);
+        binary_writer = makePtr<binaryDatasetWriter>(binaryPath, static_cast<int>(campos.size())*num_class, image_size, image_size, rgb_use);
     }
     float radius = ViewSphere.getRadius(objmesh.cloud, cam_focal_point);
     objmesh.cloud = objmesh.cloud/radius*100;
@@ -322,12 +327,18 @@ int main(int argc, char *argv[])
             myWindow.saveScreenshot(filename);
             if (binary_out)
             {
-            /* Write images into binary files for further using in CNN training. */
-                ViewSphere.writeBinaryfile(filename, binaryPath, headerPath,static_cast<int>(campos.size())*num_class, label_class, static_cast<int>(campos.at(pose).x*100), static_cast<int>(campos.at(pose).y*100), static_cast<int>(campos.at(pose).z*100), rgb_use);
+                binary_files.push_back(filename);
+                binary_labels.push_back(Vec4i(label_class, static_cast<int>(campos.at(pose).x*100), static_cast<int>(campos.at(pose).y*100), static_cast<int>(campos.at(pose).z*100)));
             }
             cnt_img++;
         }
     } while (cnt_img != campos.size());
+    if (binary_out)
+    {
+        /* Write images into binary files for further using in CNN training. */
+        binary_writer->writeFiles(binary_files, binary_labels);
+        binary_writer.release();
+    }
     imglabel.close();
     return 1;
 };
@@ -5,10 +5,52 @@ namespace cv
 {
 namespace cnn_3dobj
 {
+#ifdef HAVE_OPENCV_DNN
+    /* Read the shape of the input layer, the input_dim or input_shape dim values of a prototxt,
+     * the DNN net doesn't know it before the input is set. */
+    static bool readInputShape(const String& model_file, int& channels, cv::Size& geometry)
+    {
+        std::ifstream prototxt(model_file.c_str());
+        std::vector<int> dims;
+        std::string token;
+        bool inShape = false;
+        while (dims.size() < 4 && prototxt >> token)
+        {
+            if (token == "input_shape" || token == "input_shape{")
+                inShape = true;
+            else if (token == "input_dim:" || (inShape && token == "dim:"))
+            {
+                int dim;
+                if (prototxt >> dim)
+                    dims.push_back(dim);
+            }
+        }
+        if (dims.size() < 4)
+            return false;
+        channels = dims[1];
+        geometry = cv::Size(dims[3], dims[2]);
+        return true;
+    }
+#endif
+
     descriptorExtractor::descriptorExtractor(const String& device_type, int device_id)
     {
         net_ready = 0;
-        if (strcmp(device_type.c_str(), "CPU") == 0 || strcmp(device_type.c_str(), "GPU") == 0)
+        convnet = NULL;
+        deviceId = device_id;
+        batchSize = 32;
+        if (strcmp(device_type.c_str(), "DNN") == 0)
+        {
+#ifdef HAVE_OPENCV_DNN
+            deviceType = "DNN";
+            std::cout << "Using DNN" << std::endl;
+            net_set = true;
+#else
+            std::cout << "Error: DNN device needs OpenCV to be built with the dnn module." << std::endl;
+            net_set = false;
+#endif
+        }
+        else if (strcmp(device_type.c_str(), "CPU") == 0 || strcmp(device_type.c_str(), "GPU") == 0)
         {
             if (strcmp(device_type.c_str(), "CPU") == 0)
             {
@@ -28,7 +70,7 @@ namespace cnn_3dobj
         }
         else
         {
-            std::cout << "Error: Device name must be 'GPU' together with an device number or 'CPU'." << std::endl;
+            std::cout << "Error: Device name must be 'GPU' together with an device number, 'CPU' or 'DNN'." << std::endl;
             net_set = false;
         }
     };
@@ -49,7 +91,18 @@ namespace cnn_3dobj
 
     void descriptorExtractor::setDeviceType(const String& device_type)
     {
-        if (strcmp(device_type.c_str(), "CPU") == 0 || strcmp(device_type.c_str(), "GPU") == 0)
+        bool wasDnn = strcmp(deviceType.c_str(), "DNN") == 0;
+        if (strcmp(device_type.c_str(), "DNN") == 0)
+        {
+#ifdef HAVE_OPENCV_DNN
+            deviceType = "DNN";
+            net_set = true;
+            std::cout << "Using DNN" << std::endl;
+#else
+            std::cout << "Error: DNN device needs OpenCV to be built with the dnn module." << std::endl;
+#endif
+        }
+        else if (strcmp(device_type.c_str(), "CPU") == 0 || strcmp(device_type.c_str(), "GPU") == 0)
         {
             if (strcmp(device_type.c_str(), "CPU") == 0)
             {
@@ -63,10 +116,17 @@ namespace cnn_3dobj
                 deviceType = "GPU";
                 std::cout << "Using GPU" << std::endl;
             }
+            net_set = true;
         }
         else
         {
-            std::cout << "Error: Device name must be 'GPU' or 'CPU'." << std::endl;
+            std::cout << "Error: Device name must be 'GPU', 'CPU' or 'DNN'." << std::endl;
+        }
+        if (net_ready && wasDnn != (strcmp(deviceType.c_str(), "DNN") == 0))
+        {
+            /* The net of the other backend is not loaded. */
+            net_ready = 0;
+            std::cout << "The net must be loaded again using loadNet." << std::endl;
         }
     };
 
@@ -84,8 +144,44 @@ namespace cnn_3dobj
         }
     };
 
+    void descriptorExtractor::setBatchSize(int batch_size)
+    {
+        if (batch_size > 0)
+            batchSize = batch_size;
+        else
+            std::cout << "Error: Batch size must be positive." << std::endl;
+    };
+
+    int descriptorExtractor::getBatchSize()
+    {
+        return batchSize;
+    };
+
     void descriptorExtractor::loadNet(const String& model_file, const String& trained_file, const String& mean_file)
     {
+#ifdef HAVE_OPENCV_DNN
+        if (net_set && strcmp(deviceType.c_str(), "DNN") == 0)
+        {
+            cv::dnn::initModule();
+            dnnnet = cv::dnn::readNetFromCaffe(model_file, trained_file);
+            if (dnnnet.empty())
+            {
+                std::cout << "Error: Net could not be read by the dnn module." << std::endl;
+                return;
+            }
+            if (!readInputShape(model_file, num_channels, input_geometry))
+            {
+                std::cout << "Error: The input_dim or input_shape of the net is missing in " << model_file << std::endl;
+                return;
+            }
+            if (num_channels != 3 && num_channels != 1)
+                std::cout << "Input layer should have 1 or 3 channels." << std::endl;
+            if (!mean_file.empty())
+                std::cout << "Error: Mean files are only supported by Caffe, it is ignored." << std::endl;
+            net_ready = 1;
+            return;
+        }
+#endif
         if (net_set)
         {
             /* Load the network. */
@@ -150,55 +246,70 @@ namespace cnn_3dobj
     {
         if (net_ready)
         {
-            Blob<float>* input_layer = convnet->input_blobs()[0];
-            input_layer->Reshape(1, num_channels,
-            input_geometry.height, input_geometry.width);
-            /* Forward dimension change to all layers. */
-            convnet->Reshape();
-            std::vector<cv::Mat> input_channels;
-            wrapInput(&input_channels);
-            if (inputimg.kind() == 65536)
-            {/* this is a Mat */
-                Mat img = inputimg.getMat();
-                preprocess(img, &input_channels);
-                convnet->ForwardPrefilled();
-                /* Copy the output layer to a std::vector */
-                Blob<float>* output_layer = convnet->blob_by_name(feature_blob).get();
-                const float* begin = output_layer->cpu_data();
-                const float* end = begin + output_layer->channels();
-                std::vector<float> featureVec = std::vector<float>(begin, end);
-                cv::Mat feature_mat = cv::Mat(featureVec, true).t();
-                feature_mat.copyTo(feature);
-            }
+            std::vector<Mat> img;
+            if (inputimg.kind() == _InputArray::MAT)
+                img.push_back(inputimg.getMat());
             else
-            {/* This is a vector<Mat> */
-                vector<Mat> img;
                 inputimg.getMatVector(img);
-                Mat feature_vector;
-                for (unsigned int i = 0; i < img.size(); ++i)
-                {
-                    preprocess(img[i], &input_channels);
-                    convnet->ForwardPrefilled();
-                    /* Copy the output layer to a std::vector */
-                    Blob<float>* output_layer = convnet->blob_by_name(feature_blob).get();
-                    const float* begin = output_layer->cpu_data();
-                    const float* end = begin + output_layer->channels();
-                    std::vector<float> featureVec = std::vector<float>(begin, end);
-                    if (i == 0)
-                    {
-                        feature_vector = cv::Mat(featureVec, true).t();
-                        int dim_feature = feature_vector.cols;
-                        feature_vector.resize(img.size(), dim_feature);
-                    }
-                    feature_vector.row(i) = cv::Mat(featureVec, true).t();
-                }
-                feature_vector.copyTo(feature);
+            Mat feature_vector;
+            for (size_t start = 0; start < img.size(); start += batchSize)
+            {
+                int num = (int)std::min(img.size() - start, (size_t)batchSize);
+                Mat batch_feature;
+                extractBatch(&img[start], num, feature_blob, batch_feature);
+                if (feature_vector.empty())
+                    feature_vector.create((int)img.size(), batch_feature.cols, CV_32F);
+                batch_feature.copyTo(feature_vector.rowRange((int)start, (int)start + num));
             }
+            feature_vector.copyTo(feature);
         }
         else
           std::cout << "Device must be set properly using constructor and the net must be set in advance using loadNet.";
     };
 
+    void descriptorExtractor::extractBatch(const cv::Mat* img, int num, const String& feature_blob, cv::Mat& feature)
+    {
+#ifdef HAVE_OPENCV_DNN
+        if (strcmp(deviceType.c_str(), "DNN") == 0)
+        {
+            cv::dnn::Blob input_blob(cv::dnn::BlobShape(num, num_channels, input_geometry.height, input_geometry.width));
+            for (int i = 0; i < num; ++i)
+            {
+                std::vector<cv::Mat> input_channels;
+                for (int c = 0; c < num_channels; ++c)
+                    input_channels.push_back(cv::Mat(input_geometry, CV_32FC1, input_blob.ptrf(i, c)));
+                preprocess(img[i], &input_channels);
+            }
+            dnnnet.setBlob(".data", input_blob);
+            dnnnet.forward();
+            cv::dnn::Blob output_blob = dnnnet.getBlob(feature_blob);
+            const Mat& output = output_blob.matRefConst();
+            Mat((int)num, (int)(output.total() / num), CV_32F, (void*)output.ptr<float>()).copyTo(feature);
+            return;
+        }
+#endif
+        Blob<float>* input_layer = convnet->input_blobs()[0];
+        if (input_layer->num() != num)
+        {
+            /* Forward the batch size change to all layers, only when it changes. */
+            input_layer->Reshape(num, num_channels,
+            input_geometry.height, input_geometry.width);
+            convnet->Reshape();
+        }
+        std::vector<cv::Mat> input_channels;
+        wrapInput(&input_channels);
+        for (int i = 0; i < num; ++i)
+        {
+            std::vector<cv::Mat> image_channels(input_channels.begin() + i * num_channels,
+                                                input_channels.begin() + (i + 1) * num_channels);
+            preprocess(img[i], &image_channels);
+        }
+        convnet->ForwardPrefilled();
+        /* Copy the output layer to the descriptor matrix */
+        Blob<float>* output_layer = convnet->blob_by_name(feature_blob).get();
+        Mat(num, output_layer->count() / output_layer->num(), CV_32F, (void*)output_layer->cpu_data()).copyTo(feature);
+    };
+
     /* Wrap the input layer of the network in separate cv::Mat objects
      * (one per channel). This way we save one memcpy operation and we
      * don't need to rely on cudaMemcpy2D. The last preprocessing
@@ -210,7 +321,7 @@ namespace cnn_3dobj
         int width = input_layer->width();
         int height = input_layer->height();
         float* input_data = input_layer->mutable_cpu_data();
-        for (int i = 0; i < input_layer->channels(); ++i)
+        for (int i = 0; i < input_layer->num() * input_layer->channels(); ++i)
         {
             cv::Mat channel(height, width, CV_32FC1, input_data);
             input_channels->push_back(channel);
@@ -250,9 +361,9 @@ namespace cnn_3dobj
         /* This operation will write the separate BGR planes directly to the
          * input layer of the network because it is wrapped by the cv::Mat
          * objects in input_channels. */
+        const uchar* input_data = input_channels->at(0).data;
         cv::split(sample_normalized, *input_channels);
-        if (reinterpret_cast<float*>(input_channels->at(0).data)
-      != convnet->input_blobs()[0]->cpu_data())
+        if (input_channels->at(0).data != input_data)
             std::cout << "Input channels are not wrapping the input layer of the network." << std::endl;
     };
 } /* namespace cnn_3dobj */
@@ -6,6 +6,43 @@ namespace cv
 {
 namespace cnn_3dobj
 {
+    /* Marks the view points that don't have a duplicate before them. */
+    class UniqueViewInvoker : public ParallelLoopBody
+    {
+        public:
+        UniqueViewInvoker(const std::vector<cv::Point3d>& _points, float _diff, std::vector<uchar>& _unique)
+            : points(_points), diff(_diff), unique(_unique)
+        {
+        }
+
+        void operator()(const Range& range) const
+        {
+            for (int j = range.start; j < range.end; ++j)
+            {
+                unique[j] = 1;
+                for (int k = 0; k < j; ++k)
+                {
+                    float dist_x, dist_y, dist_z;
+                    dist_x = (points[k].x-points[j].x) * (points[k].x-points[j].x);
+                    dist_y = (points[k].y-points[j].y) * (points[k].y-points[j].y);
+                    dist_z = (points[k].z-points[j].z) * (points[k].z-points[j].z);
+                    if (dist_x < diff && dist_y < diff && dist_z < diff)
+                    {
+                        unique[j] = 0;
+                        break;
+                    }
+                }
+            }
+        }
+
+        private:
+        const std::vector<cv::Point3d>& points;
+        float diff;
+        std::vector<uchar>& unique;
+
+        UniqueViewInvoker& operator=(const UniqueViewInvoker&); // to quiet MSVC
+    };
+
     icoSphere::icoSphere(float radius_in, int depth_in)
     {
         X = 0.5f;
@@ -29,20 +66,13 @@ namespace cnn_3dobj
             subdivide(vdata[tindices[i][0]], vdata[tindices[i][1]],
               vdata[tindices[i][2]], depth_in);
         }
-        CameraPos_temp.push_back(CameraPos[0]);
-        for (unsigned int j = 1; j < CameraPos.size(); ++j)
+        /* Eliminate the duplicated points, the points are compared in parallel and kept in order. */
+        std::vector<uchar> unique(CameraPos.size());
+        parallel_for_(Range(0, (int)CameraPos.size()), UniqueViewInvoker(CameraPos, diff, unique));
+        for (unsigned int j = 0; j < CameraPos.size(); ++j)
         {
-            for (unsigned int k = 0; k < j; ++k)
-            {
-                float dist_x, dist_y, dist_z;
-                dist_x = (CameraPos.at(k).x-CameraPos.at(j).x) * (CameraPos.at(k).x-CameraPos.at(j).x);
-                dist_y = (CameraPos.at(k).y-CameraPos.at(j).y) * (CameraPos.at(k).y-CameraPos.at(j).y);
-                dist_z = (CameraPos.at(k).z-CameraPos.at(j).z) * (CameraPos.at(k).z-CameraPos.at(j).z);
-                if (dist_x < diff && dist_y < diff && dist_z < diff)
-                    break;
-                else if (k == j-1)
-                    CameraPos_temp.push_back(CameraPos[j]);
-            }
+            if (unique[j])
+                CameraPos_temp.push_back(CameraPos[j]);
         }
         CameraPos = CameraPos_temp;
         cout << "View points in total: " << CameraPos.size() << endl;
@@ -69,12 +99,7 @@ namespace cnn_3dobj
     void icoSphere::add(float v[])
     {
         Point3f temp_Campos;
-        std::vector<float>* temp = new std::vector<float>;
-        for (int k = 0; k < 3; ++k)
-        {
-            temp->push_back(v[k]);
-        }
-        temp_Campos.x = temp->at(0);temp_Campos.y = temp->at(1);temp_Campos.z = temp->at(2);
+        temp_Campos.x = v[0];temp_Campos.y = v[1];temp_Campos.z = v[2];
         CameraPos.push_back(temp_Campos);
     };
 
@@ -90,9 +115,9 @@ namespace cnn_3dobj
             add(v3);
             return;
         }
-        float* v12 = new float[3];
-        float* v23 = new float[3];
-        float* v31 = new float[3];
+        float v12[3];
+        float v23[3];
+        float v31[3];
         for (int i = 0; i < 3; ++i)
         {
             v12[i] = (v1[i] + v2[i]) / 2;
@@ -261,5 +286,127 @@ namespace cnn_3dobj
         img_file.close();
         lab_file.close();
     };
+
+    /* Reads the samples and writes their channels one after another, as writeBinaryfile does. */
+    class PlanarSampleInvoker : public ParallelLoopBody
+    {
+        public:
+        PlanarSampleInvoker(const std::vector<cv::Mat>& _imgs, const std::vector<String>& _filenames, int _isrgb,
+                            cv::Size _size, uchar* _dst, std::vector<uchar>& _failed)
+            : imgs(_imgs), filenames(_filenames), isrgb(_isrgb), size(_size), dst(_dst), failed(_failed)
+        {
+        }
+
+        void operator()(const Range& range) const
+        {
+            int channels = isrgb ? 3 : 1;
+            size_t planeBytes = (size_t)size.area();
+            for (int i = range.start; i < range.end; ++i)
+            {
+                cv::Mat img = filenames.empty() ? imgs[i] : cv::imread(filenames[i], isrgb);
+                if (img.size() != size || img.type() != CV_8UC(channels))
+                {
+                    failed[i] = 1;
+                    continue;
+                }
+                std::vector<cv::Mat> planes;
+                for (int c = 0; c < channels; ++c)
+                    planes.push_back(cv::Mat(size, CV_8UC1, dst + ((size_t)i * channels + c) * planeBytes));
+                cv::split(img, planes);
+            }
+        }
+
+        private:
+        const std::vector<cv::Mat>& imgs;
+        const std::vector<String>& filenames;
+        int isrgb;
+        cv::Size size;
+        uchar* dst;
+        std::vector<uchar>& failed;
+
+        PlanarSampleInvoker& operator=(const PlanarSampleInvoker&); // to quiet MSVC
+    };
+
+    binaryDatasetWriter::binaryDatasetWriter(const String& binaryPath, int num_item, int rows, int cols, int _isrgb, size_t buffer_size)
+        : sampleSize(cols, rows), isrgb(_isrgb), bufferSize(buffer_size)
+    {
+        String binPathimg = binaryPath + "image";
+        String binPathlab = binaryPath + "label";
+        bool exists = std::ifstream(binPathimg.c_str()).good();
+        if (!exists)
+        {
+            cout << "Creating the training data at: " << binaryPath << ". " << endl;
+            icoSphere::createHeader(num_item, rows, cols, binaryPath.c_str());
+        }
+        else
+            cout << "Concatenating the training data at: " << binaryPath << ". " << endl;
+        imgFile.open(binPathimg.c_str(), ios::out|ios::binary|ios::app);
+        labFile.open(binPathlab.c_str(), ios::out|ios::binary|ios::app);
+        if (!imgFile || !labFile)
+            CV_Error(Error::StsError, "Could not open the binary files at " + binaryPath);
+    };
+
+    binaryDatasetWriter::~binaryDatasetWriter()
+    {
+        flush();
+    };
+
+    void binaryDatasetWriter::write(InputArrayOfArrays _imgs, const std::vector<cv::Vec4i>& labels)
+    {
+        std::vector<cv::Mat> imgs;
+        if (_imgs.kind() == _InputArray::MAT)
+            imgs.push_back(_imgs.getMat());
+        else
+            _imgs.getMatVector(imgs);
+        addSamples(imgs, std::vector<String>(), labels);
+    };
+
+    void binaryDatasetWriter::writeFiles(const std::vector<String>& filenames, const std::vector<cv::Vec4i>& labels)
+    {
+        addSamples(std::vector<cv::Mat>(filenames.size()), filenames, labels);
+    };
+
+    void binaryDatasetWriter::addSamples(const std::vector<cv::Mat>& imgs, const std::vector<String>& filenames,
+                                         const std::vector<cv::Vec4i>& labels)
+    {
+        CV_Assert(imgs.size() == labels.size());
+        int num = (int)imgs.size();
+        size_t sampleBytes = (size_t)sampleSize.area() * (isrgb ? 3 : 1);
+        size_t start = imgBuffer.size();
+        imgBuffer.resize(start + num * sampleBytes);
+
+        std::vector<uchar> failed(num, (uchar)0);
+        parallel_for_(Range(0, num), PlanarSampleInvoker(imgs, filenames, isrgb, sampleSize,
+                                                          imgBuffer.empty() ? NULL : &imgBuffer[start], failed));
+        for (int i = 0; i < num; ++i)
+        {
+            if (failed[i])
+            {
+                imgBuffer.resize(start);
+                CV_Error(Error::StsBadArg, format("Sample %d is not a %dx%d %s image", i, sampleSize.width,
+                                                  sampleSize.height, isrgb ? "BGR" : "grayscale"));
+            }
+        }
+
+        for (int i = 0; i < num; ++i)
+        {
+            for (int k = 0; k < 4; ++k)
+                labBuffer.push_back((uchar)(signed char)labels[i][k]);
+        }
+        if (imgBuffer.size() >= bufferSize)
+            flush();
+    };
+
+    void binaryDatasetWriter::flush()
+    {
+        if (!imgBuffer.empty())
+            imgFile.write(reinterpret_cast<const char*>(&imgBuffer[0]), imgBuffer.size());
+        if (!labBuffer.empty())
+            labFile.write(reinterpret_cast<const char*>(&labBuffer[0]), labBuffer.size());
+        imgFile.flush();
+        labFile.flush();
+        imgBuffer.clear();
+        labBuffer.clear();
+    };
 } /* namespace cnn_3dobj */
 } /* namespace cv */
@@ -0,0 +1,62 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+#include <iterator>
+
+using namespace cv;
+using namespace cv::cnn_3dobj;
+
+static std::vector<uchar> readBytes(const String& path)
+{
+    std::ifstream file(path.c_str(), std::ios::in|std::ios::binary);
+    return std::vector<uchar>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+TEST(CNN_BinaryWriter, planar_samples_after_header)
+{
+    String binaryPath = cv::tempfile();
+    Size size(5, 4);
+    std::vector<Mat> imgs(3);
+    std::vector<Vec4i> labels;
+    for (int i = 0; i < 3; i++)
+    {
+        imgs[i].create(size, CV_8UC3);
+        theRNG().fill(imgs[i], RNG::UNIFORM, 0, 256);
+        labels.push_back(Vec4i(i, -10 * i, 20, -30));
+    }
+
+    {
+        // a buffer smaller than the samples flushes on each call
+        binaryDatasetWriter writer(binaryPath, 3, size.height, size.width, 1, 64);
+        writer.write(std::vector<Mat>(imgs.begin(), imgs.begin() + 2),
+                     std::vector<Vec4i>(labels.begin(), labels.begin() + 2));
+        writer.write(imgs[2], std::vector<Vec4i>(1, labels[2]));
+    }
+
+    std::vector<uchar> img_file = readBytes(binaryPath + "image");
+    std::vector<uchar> lab_file = readBytes(binaryPath + "label");
+    std::remove((binaryPath + "image").c_str());
+    std::remove((binaryPath + "label").c_str());
+
+    size_t plane = size.area();
+    ASSERT_EQ(16 + 3 * 3 * plane, img_file.size());
+    ASSERT_EQ(8 + 3 * 4u, lab_file.size());
+    EXPECT_EQ(3, img_file[7]);
+    EXPECT_EQ(4, img_file[11]);
+    EXPECT_EQ(5, img_file[15]);
+
+    for (int i = 0; i < 3; i++)
+    {
+        std::vector<Mat> channels;
+        split(imgs[i], channels);
+        for (int c = 0; c < 3; c++)
+        {
+            Mat written(size, CV_8UC1, &img_file[16 + (i * 3 + c) * plane]);
+            EXPECT_EQ(0, cvtest::norm(written, channels[c], NORM_INF)) << "sample " << i << " channel " << c;
+        }
+        for (int k = 0; k < 4; k++)
+            EXPECT_EQ(labels[i][k], (int)(signed char)lab_file[8 + i * 4 + k]);
+    }
+}
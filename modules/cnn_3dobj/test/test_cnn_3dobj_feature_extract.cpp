@@ -58,6 +58,18 @@ void CV_CNN_Feature_Test::run(int)
       ts->set_failed_test_info(cvtest::TS::FAIL_MISSING_TEST_DATA);
       return;
     }
+
+    /* A batch gives the descriptors of its images one by one */
+    std::vector<cv::Mat> img_batch(3, img_base);
+    cv::Mat feature_batch;
+    descriptor.setBatchSize(2);
+    descriptor.extract(img_batch, feature_batch, feature_blob);
+    if (feature_batch.rows != 3 || norm(feature_batch.row(0) - feature_test) > 1e-3 ||
+        norm(feature_batch.row(1) - feature_test) > 1e-3 || norm(feature_batch.row(2) - feature_test) > 1e-3) {
+      ts->printf(cvtest::TS::LOG, "Features extracted in batches are not the same as the features of single images.");
+      ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+      return;
+    }
 }
 
 TEST(CNN_FEATURE, accuracy) { CV_CNN_Feature_Test test; test.safe_run(); }
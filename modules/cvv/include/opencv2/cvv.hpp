@@ -16,6 +16,7 @@ See cvv tutorial for a commented example application using cvv.
 
 */
 
+#include <opencv2/cvv/async_capture.hpp>
 #include <opencv2/cvv/call_meta_data.hpp>
 #include <opencv2/cvv/debug_mode.hpp>
 #include <opencv2/cvv/dmatch.hpp>
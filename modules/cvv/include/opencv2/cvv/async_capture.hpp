@@ -0,0 +1,67 @@
+#ifndef CVVISUAL_ASYNC_CAPTURE_HPP
+#define CVVISUAL_ASYNC_CAPTURE_HPP
+
+#include <cstddef>
+
+#include "opencv2/core.hpp"
+
+#include "debug_mode.hpp"
+
+#ifdef CV_DOXYGEN
+#define CVVISUAL_DEBUGMODE
+#endif
+
+namespace cvv
+{
+
+//! @addtogroup cvv
+//! @{
+
+namespace impl
+{
+// implementation outside API
+CV_EXPORTS void setAsyncCapture(bool active, size_t capacity);
+CV_EXPORTS void flushAsyncCalls();
+} // namespace impl
+
+#ifdef CVVISUAL_DEBUGMODE
+/** @brief Enable or disable the asynchronous capture of the calls.
+
+While it is active, the calls only take a snapshot of their data into a queue of at most capacity calls and
+return immediately, without passing control to the debug-window. When the queue is full, its oldest call is
+dropped. The queued calls are shown, in order, by the next flushAsyncCalls(), the next call made while the
+capture is not active or finalShow(). The debug-window keeps running in the thread that shows it, so this
+function is to be called from that thread, before any call is captured from other threads.
+
+@param active Whether the calls are captured asynchronously.
+@param capacity The number of calls kept by the queue.
+ */
+static inline void setAsyncCapture(bool active, size_t capacity = 64)
+{
+	impl::setAsyncCapture(active, capacity);
+}
+
+/** @brief Passes the control to the debug-window with the calls captured asynchronously, if any.
+ */
+static inline void flushAsyncCalls()
+{
+	if (debugMode())
+	{
+		impl::flushAsyncCalls();
+	}
+}
+#else
+static inline void setAsyncCapture(bool, size_t = 64)
+{
+}
+
+static inline void flushAsyncCalls()
+{
+}
+#endif
+
+//! @}
+
+} // namespace cvv
+
+#endif
@@ -46,47 +46,45 @@ interactive :draw_matches:drawMatches\<\>).
 descriptor index.
  */
 static inline void
-debugDMatch(cv::InputArray img1, std::vector<cv::KeyPoint> keypoints1,
-            cv::InputArray img2, std::vector<cv::KeyPoint> keypoints2,
-            std::vector<cv::DMatch> matches, const impl::CallMetaData &data,
+debugDMatch(cv::InputArray img1, const std::vector<cv::KeyPoint> &keypoints1,
+            cv::InputArray img2, const std::vector<cv::KeyPoint> &keypoints2,
+            const std::vector<cv::DMatch> &matches, const impl::CallMetaData &data,
             const char *description = nullptr, const char *view = nullptr,
             bool useTrainDescriptor = true)
 {
 	if (debugMode())
 	{
-		impl::debugDMatch(img1, std::move(keypoints1), img2,
-		                  std::move(keypoints2), std::move(matches),
+		impl::debugDMatch(img1, keypoints1, img2, keypoints2, matches,
 		                  data, description, view, useTrainDescriptor);
 	}
 }
 /** @overload */
 static inline void
-debugDMatch(cv::InputArray img1, std::vector<cv::KeyPoint> keypoints1,
-            cv::InputArray img2, std::vector<cv::KeyPoint> keypoints2,
-            std::vector<cv::DMatch> matches, const impl::CallMetaData &data,
+debugDMatch(cv::InputArray img1, const std::vector<cv::KeyPoint> &keypoints1,
+            cv::InputArray img2, const std::vector<cv::KeyPoint> &keypoints2,
+            const std::vector<cv::DMatch> &matches, const impl::CallMetaData &data,
             const std::string &description, const std::string &view,
             bool useTrainDescriptor = true)
 {
 	if (debugMode())
 	{
-		impl::debugDMatch(img1, std::move(keypoints1), img2,
-		                  std::move(keypoints2), std::move(matches),
+		impl::debugDMatch(img1, keypoints1, img2, keypoints2, matches,
 		                  data, description.c_str(), view.c_str(),
 		                  useTrainDescriptor);
 	}
 }
 #else
-static inline void debugDMatch(cv::InputArray, std::vector<cv::KeyPoint>,
-                               cv::InputArray, std::vector<cv::KeyPoint>,
-                               std::vector<cv::DMatch>,
+static inline void debugDMatch(cv::InputArray, const std::vector<cv::KeyPoint> &,
+                               cv::InputArray, const std::vector<cv::KeyPoint> &,
+                               const std::vector<cv::DMatch> &,
                                const impl::CallMetaData &,
                                const char * = nullptr, const char * = nullptr,
                                bool = true)
 {
 }
-static inline void debugDMatch(cv::InputArray, std::vector<cv::KeyPoint>,
-                               cv::InputArray, std::vector<cv::KeyPoint>,
-                               std::vector<cv::DMatch>,
+static inline void debugDMatch(cv::InputArray, const std::vector<cv::KeyPoint> &,
+                               cv::InputArray, const std::vector<cv::KeyPoint> &,
+                               const std::vector<cv::DMatch> &,
                                const impl::CallMetaData &, const std::string &,
                                const std::string &, bool = true)
 {
@@ -174,6 +174,12 @@ void ViewController::removeCallTab(size_t tabId, bool deleteIt, bool deleteCall,
 		if (deleteIt)
 		{
 			callTabMap.erase(tabId);
+			// the images of a closed tab are loaded again when it's
+			// reopened
+			if (hasCall(tabId))
+			{
+				getCall(tabId).releaseMatrices();
+			}
 		}
 	}
 	if (deleteCall && hasCall(tabId))
@@ -0,0 +1,26 @@
+#include "opencv2/cvv/async_capture.hpp"
+
+#include <algorithm>
+
+#include "data_controller.hpp"
+
+namespace cvv
+{
+namespace impl
+{
+
+void setAsyncCapture(bool active, size_t capacity)
+{
+	dataController().setQueueCapacity(active ? std::max<size_t>(capacity, 1) : 0);
+}
+
+void flushAsyncCalls()
+{
+	auto &controller = dataController();
+	if (controller.addQueuedCalls() != 0)
+	{
+		controller.callUI();
+	}
+}
+}
+} // namespaces cvv::impl
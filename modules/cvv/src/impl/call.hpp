@@ -10,6 +10,8 @@
 
 #include "opencv2/cvv/call_meta_data.hpp"
 
+#include "stored_mat.hpp"
+
 
 namespace cvv
 {
@@ -53,11 +55,44 @@ class Call
 	virtual size_t matrixCount() const = 0;
 
 	/**
-	 * Returns the n'th matrix that is involved in the call.
+	 * Returns the n'th stored image that is involved in the call.
+	 *
+	 * @throws std::out_of_range if index is higher then matrixCount().
+	 */
+	virtual const StoredMat &storedMatAt(size_t index) const = 0;
+
+	/**
+	 * Returns the n'th matrix that is involved in the call, loading it if
+	 * it was spilled to disc.
+	 *
+	 * @throws std::out_of_range if index is higher then matrixCount().
+	 */
+	const cv::Mat &matrixAt(size_t index) const
+	{
+		return storedMatAt(index).mat();
+	}
+
+	/**
+	 * Returns the thumbnail of the n'th matrix that is involved in the call.
 	 *
 	 * @throws std::out_of_range if index is higher then matrixCount().
 	 */
-	virtual const cv::Mat &matrixAt(size_t index) const = 0;
+	const cv::Mat &thumbnailAt(size_t index) const
+	{
+		return storedMatAt(index).thumbnail();
+	}
+
+	/**
+	 * @brief Drops the loaded full-resolution images that were spilled to
+	 * disc, e.g. after the tab of the call was closed.
+	 */
+	void releaseMatrices() const
+	{
+		for (size_t i = 0; i < matrixCount(); i++)
+		{
+			storedMatAt(i).release();
+		}
+	}
 
 	/**
 	 * @brief provides a description of the call.
@@ -1,6 +1,7 @@
 #include "data_controller.hpp"
 
 
+#include <algorithm>
 #include <stdexcept>
 
 namespace cvv
@@ -28,11 +29,54 @@ class CallEquality
 }
 
 void DataController::addCall(std::unique_ptr<Call> call)
+{
+	{
+		std::lock_guard<std::mutex> lock{ queueMutex };
+		if (queueCapacity != 0)
+		{
+			if (queuedCalls.size() == queueCapacity)
+			{
+				queuedCalls.pop_front();
+			}
+			queuedCalls.push_back(std::move(call));
+			return;
+		}
+	}
+	// the calls captured before come first
+	addQueuedCalls();
+	addToView(std::move(call));
+	callUI();
+}
+
+void DataController::setQueueCapacity(size_t capacity)
+{
+	std::lock_guard<std::mutex> lock{ queueMutex };
+	queueCapacity = capacity;
+	while (capacity != 0 && queuedCalls.size() > capacity)
+	{
+		queuedCalls.pop_front();
+	}
+}
+
+size_t DataController::addQueuedCalls()
+{
+	std::deque<std::unique_ptr<Call>> queued;
+	{
+		std::lock_guard<std::mutex> lock{ queueMutex };
+		queued.swap(queuedCalls);
+	}
+	for (auto &call : queued)
+	{
+		addToView(std::move(call));
+	}
+	return queued.size();
+}
+
+void DataController::addToView(std::unique_ptr<Call> call)
 {
 	auto ref = util::makeRef(*call);
 	calls.push_back(std::move(call));
 	viewController.addCall(ref);
-	callUI();
 }
 
 void DataController::removeCall(size_t Id)
@@ -1,7 +1,9 @@
 #ifndef CVVISUAL_DATA_CONTROLLER_HPP
 #define CVVISUAL_DATA_CONTROLLER_HPP
 
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "opencv2/core.hpp"
@@ -27,10 +29,29 @@ class DataController
 	}
 
 	/**
-	 * Add a new call to the calls-list.
+	 * Add a new call to the calls-list and pass control to the UI, or only
+	 * queue it while the asynchronous capture is active.
+	 *
+	 * May be called from any thread while the asynchronous capture is
+	 * active.
 	 */
 	void addCall(std::unique_ptr<Call> call);
 
+	/**
+	 * @brief Sets the number of calls kept by the queue of the
+	 * asynchronous capture, 0 for none (the calls are shown at once).
+	 *
+	 * The oldest calls are dropped when the queue is full.
+	 */
+	void setQueueCapacity(size_t capacity);
+
+	/**
+	 * @brief Moves the queued calls, in order, to the calls-list and the
+	 * view, without passing control to the UI.
+	 * @return the number of calls that were queued
+	 */
+	size_t addQueuedCalls();
+
 	/**
 	 * Remove a call.
 	 * @throws std::invalid_argument if no such call exists
@@ -76,6 +97,13 @@ class DataController
       private:
 	std::vector<std::unique_ptr<Call>> calls;
 	controller::ViewController viewController;
+
+	// the asynchronous capture, guarded by queueMutex
+	std::mutex queueMutex;
+	std::deque<std::unique_ptr<Call>> queuedCalls;
+	size_t queueCapacity = 0;
+
+	void addToView(std::unique_ptr<Call> call);
 };
 
 /**
@@ -14,18 +14,18 @@ FilterCall::FilterCall(cv::InputArray in, cv::InputArray out,
                        QString description, QString requestedView)
     : Call( data,                   std::move(type),
 	    std::move(description), std::move(requestedView) ),
-      input_{ in.getMat().clone() }, output_{ out.getMat().clone() }
+      input_{ in }, output_{ out }
 {
 }
 
-const cv::Mat &FilterCall::matrixAt(size_t index) const
+const StoredMat &FilterCall::storedMatAt(size_t index) const
 {
 	switch (index)
 	{
 	case 0:
-		return original();
+		return input_;
 	case 1:
-		return result();
+		return output_;
 	default:
 		throw std::out_of_range{ "" };
 	}
@@ -29,29 +29,29 @@ class FilterCall : public Call
 	{
 		return 2;
 	}
-	const cv::Mat &matrixAt(size_t index) const override;
+	const StoredMat &storedMatAt(size_t index) const override;
 
 	/**
 	 * @returns the original image
 	 */
 	const cv::Mat &original() const
 	{
-		return input_;
+		return input_.mat();
 	}
 	/**
 	 * @returns the filtered image
 	 */
 	const cv::Mat &result() const
 	{
-		return output_;
+		return output_.mat();
 	}
 
       private:
 	// TODO: in case we REALLY want to support several input-images: make
 	// this a std::vector
 	// TODO: those are typedefs for references, make it clean:
-	cv::Mat input_;
-	cv::Mat output_;
+	StoredMat input_;
+	StoredMat output_;
 };
 
 /**
@@ -10,6 +10,7 @@ namespace impl
 void finalShow()
 {
 	auto &controller = impl::dataController();
+	controller.addQueuedCalls();
 	if (controller.numCalls() != 0)
 	{
 		controller.lastCall();
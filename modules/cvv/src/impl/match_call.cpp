@@ -20,20 +20,20 @@ MatchCall::MatchCall(cv::InputArray img1, std::vector<cv::KeyPoint> keypoints1,
                      bool useTrainDescriptor)
     : Call( data,                   std::move(type),
 	    std::move(description), std::move(requestedView) ),
-      img1_{ img1.getMat().clone() }, keypoints1_{ std::move(keypoints1) },
-      img2_{ img2.getMat().clone() }, keypoints2_{ std::move(keypoints2) },
+      img1_{ img1 }, keypoints1_{ std::move(keypoints1) },
+      img2_{ img2 }, keypoints2_{ std::move(keypoints2) },
       matches_{ std::move(matches) }, usesTrainDescriptor_{ useTrainDescriptor }
 {
 }
 
-const cv::Mat &MatchCall::matrixAt(size_t index) const
+const StoredMat &MatchCall::storedMatAt(size_t index) const
 {
 	switch (index)
 	{
 	case 0:
-		return img1();
+		return img1_;
 	case 1:
-		return img2();
+		return img2_;
 	default:
 		throw std::out_of_range{ "" };
 	}
@@ -34,14 +34,14 @@ class MatchCall : public Call
 	{
 		return 2;
 	}
-	const cv::Mat &matrixAt(size_t index) const override;
+	const StoredMat &storedMatAt(size_t index) const override;
 
 	/**
 	 * @brief Returns the first Mat.
 	 */
 	const cv::Mat &img1() const
 	{
-		return img1_;
+		return img1_.mat();
 	}
 
 	/**
@@ -49,7 +49,7 @@ class MatchCall : public Call
 	 */
 	const cv::Mat &img2() const
 	{
-		return img2_;
+		return img2_.mat();
 	}
 
 	/**
@@ -82,9 +82,9 @@ class MatchCall : public Call
 	}
 
       private:
-	cv::Mat img1_;
+	StoredMat img1_;
 	std::vector<cv::KeyPoint> keypoints1_;
-	cv::Mat img2_;
+	StoredMat img2_;
 	std::vector<cv::KeyPoint> keypoints2_;
 	std::vector<cv::DMatch> matches_;
 	bool usesTrainDescriptor_;
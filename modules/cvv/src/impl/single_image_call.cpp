@@ -16,11 +16,11 @@ SingleImageCall::SingleImageCall(cv::InputArray img, impl::CallMetaData data,
                                  QString requestedView)
     : Call( data,                   std::move(type),
 	    std::move(description), std::move(requestedView) ),
-      img{ img.getMat().clone() }
+      img{ img }
 {
 }
 
-const cv::Mat &SingleImageCall::matrixAt(size_t index) const
+const StoredMat &SingleImageCall::storedMatAt(size_t index) const
 {
 	if (index)
 	{
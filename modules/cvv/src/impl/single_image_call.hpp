@@ -29,18 +29,18 @@ class SingleImageCall : public Call
 	{
 		return 1;
 	}
-	const cv::Mat &matrixAt(size_t index) const override;
+	const StoredMat &storedMatAt(size_t index) const override;
 
 	/**
 	 * @returns the original image
 	 */
 	const cv::Mat &mat() const
 	{
-		return img;
+		return img.mat();
 	}
 
       private:
-	cv::Mat img;
+	StoredMat img;
 };
 
 /**
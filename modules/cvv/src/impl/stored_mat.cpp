@@ -0,0 +1,110 @@
+#include "stored_mat.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <QDir>
+
+#include "opencv2/imgproc.hpp"
+
+namespace cvv
+{
+namespace impl
+{
+
+/**
+ * @brief Returns whether cv::resize can create a thumbnail of the image.
+ */
+static bool canResize(const cv::Mat &mat)
+{
+	int depth = mat.depth();
+	return mat.dims <= 2 && mat.channels() <= 4 &&
+	       (depth == CV_8U || depth == CV_16U || depth == CV_16S ||
+	        depth == CV_32F || depth == CV_64F);
+}
+
+StoredMat::StoredMat(cv::InputArray in)
+{
+	cv::Mat mat = in.getMat();
+	int longSide = std::max(mat.rows, mat.cols);
+	bool downscaled = false;
+	if (longSide > thumbnailSize && canResize(mat))
+	{
+		double scale = static_cast<double>(thumbnailSize) / longSide;
+		cv::resize(mat, thumbnail_, cv::Size{}, scale, scale,
+		           cv::INTER_AREA);
+		downscaled = true;
+	}
+
+	// only images with a thumbnail of their own are spilled, otherwise the
+	// thumbnail would keep the full image in memory anyway
+	if (downscaled && mat.total() * mat.elemSize() >= spillThreshold &&
+	    spill(mat))
+	{
+		return;
+	}
+	mat_ = mat.clone();
+	if (!downscaled)
+	{
+		thumbnail_ = mat_;
+	}
+}
+
+bool StoredMat::spill(const cv::Mat &mat)
+{
+	auto file = std::unique_ptr<QTemporaryFile>{ new QTemporaryFile{
+		QDir::tempPath() + "/cvv_XXXXXX.mat" } };
+	if (!file->open())
+	{
+		return false;
+	}
+	const qint64 rowBytes = mat.cols * mat.elemSize();
+	for (int y = 0; y < mat.rows; y++)
+	{
+		if (file->write(mat.ptr<char>(y), rowBytes) != rowBytes)
+		{
+			return false;
+		}
+	}
+	if (!file->flush())
+	{
+		return false;
+	}
+	file->close();
+
+	rows_ = mat.rows;
+	cols_ = mat.cols;
+	type_ = mat.type();
+	file_ = std::move(file);
+	return true;
+}
+
+const cv::Mat &StoredMat::mat() const
+{
+	if (!file_ || !mat_.empty())
+	{
+		return mat_;
+	}
+	cv::Mat mat{ rows_, cols_, type_ };
+	const qint64 bytes = mat.total() * mat.elemSize();
+	if (!file_->open() || !file_->seek(0) ||
+	    file_->read(mat.ptr<char>(), bytes) != bytes)
+	{
+		file_->close();
+		throw std::runtime_error{ "cannot read the spilled image " +
+			                  file_->fileName().toStdString() };
+	}
+	file_->close();
+	mat_ = mat;
+	return mat_;
+}
+
+void StoredMat::release() const
+{
+	if (file_)
+	{
+		mat_.release();
+	}
+}
+}
+} // namespaces cvv::impl
@@ -0,0 +1,90 @@
+#ifndef CVVISUAL_STORED_MAT_HPP
+#define CVVISUAL_STORED_MAT_HPP
+
+#include <memory>
+
+#include <QTemporaryFile>
+
+#include "opencv2/core.hpp"
+
+namespace cvv
+{
+namespace impl
+{
+
+/**
+ * @brief Holds an image of a call: a downscaled thumbnail that always stays in
+ * memory and the full-resolution image, which is spilled to a temporary file
+ * if it is large and loaded again only when it is requested.
+ *
+ * Keeps the memory of long debugging sessions bounded by the thumbnails and the
+ * images of the currently opened calls.
+ * The full-resolution image is loaded by the GUI-thread only.
+ */
+class StoredMat
+{
+      public:
+	/**
+	 * @brief Copies the image (or spills it to disc) and creates its
+	 * thumbnail.
+	 */
+	explicit StoredMat(cv::InputArray mat);
+
+	StoredMat(const StoredMat &) = delete;
+	StoredMat &operator=(const StoredMat &) = delete;
+
+	/**
+	 * @brief Returns the full-resolution image, loading it if it was
+	 * spilled.
+	 * The loaded image is kept until release() is called.
+	 * @throws std::runtime_error if the spilled image cannot be read.
+	 */
+	const cv::Mat &mat() const;
+
+	/**
+	 * @brief Returns an image whose longer side has at most thumbnailSize
+	 * pixels (or the image itself if it is small or cannot be resized).
+	 */
+	const cv::Mat &thumbnail() const
+	{
+		return thumbnail_;
+	}
+
+	/**
+	 * @brief Returns whether the full-resolution image lives on disc.
+	 */
+	bool isSpilled() const
+	{
+		return file_ != nullptr;
+	}
+
+	/**
+	 * @brief Drops the loaded full-resolution image of a spilled image.
+	 * Copies of it (e.g. in the views) stay valid.
+	 */
+	void release() const;
+
+	/**
+	 * @brief The maximal length of a side of the thumbnails.
+	 */
+	static const int thumbnailSize = 256;
+
+	/**
+	 * @brief The size in bytes from which on images are spilled.
+	 */
+	static const size_t spillThreshold = 1 << 20;
+
+      private:
+	bool spill(const cv::Mat &mat);
+
+	mutable cv::Mat mat_;
+	cv::Mat thumbnail_;
+	std::unique_ptr<QTemporaryFile> file_;
+	int rows_ = 0;
+	int cols_ = 0;
+	int type_ = 0;
+};
+}
+} // namespaces cvv::impl
+
+#endif
@@ -44,6 +44,7 @@
 
 #include <string>
 #include <vector>
+#include <iosfwd>
 
 #include <opencv2/core.hpp>
 
@@ -529,6 +530,26 @@ public:
     int getNumSplits() const;
 
 protected:
+    /** @brief Reads the splits from a binary cache written by saveCache().
+
+    The cache is used only when it was written for the same sources, with the same modification
+    times, see getFileTime(). Otherwise, or when the file is missing or cannot be read, the splits
+    are left empty and false is returned.
+    @param cacheFile path of the cache file.
+    @param sources files and directories the splits are parsed from.
+     */
+    bool loadCache(const std::string &cacheFile, const std::vector<std::string> &sources);
+    /** @brief Writes the splits to a binary cache, keyed on the modification times of the sources.
+
+    Nothing is written when the file cannot be created, e.g. in a read-only dataset directory.
+     */
+    void saveCache(const std::string &cacheFile, const std::vector<std::string> &sources) const;
+
+    //! writes an object of the dataset to a cache, to be implemented by the datasets that use one
+    virtual void writeObject(std::ostream &out, const Ptr<Object> &object) const;
+    //! reads an object written by writeObject()
+    virtual Ptr<Object> readObject(std::istream &in) const;
+
     std::vector< std::vector< Ptr<Object> > > train;
     std::vector< std::vector< Ptr<Object> > > test;
     std::vector< std::vector< Ptr<Object> > > validation;
@@ -66,6 +66,15 @@ void CV_EXPORTS createDirectory(const std::string &path);
 
 void CV_EXPORTS getDirList(const std::string &dirName, std::vector<std::string> &fileNames);
 
+//! modification time of a file or a directory, 0 when it does not exist
+int64 CV_EXPORTS getFileTime(const std::string &path);
+
+//! binary helpers for the caches of the datasets, see Dataset::saveCache()
+void CV_EXPORTS writeCacheInt(std::ostream &out, int value);
+int CV_EXPORTS readCacheInt(std::istream &in);
+void CV_EXPORTS writeCacheString(std::ostream &out, const std::string &value);
+std::string CV_EXPORTS readCacheString(std::istream &in);
+
 //! @}
 
 }
@@ -42,6 +42,10 @@
 #include "opencv2/datasets/dataset.hpp"
 #include "opencv2/datasets/util.hpp"
 
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+
 namespace cv
 {
 namespace datasets
@@ -84,6 +88,146 @@ int Dataset::getNumSplits() const
     return (int)train.size();
 }
 
+// the header of the caches, to be changed with their layout
+static const char cacheMagic[8] = { 'O', 'C', 'V', 'D', 'S', 'C', '0', '1' };
+
+static void writeCacheSources(ostream &out, const vector<string> &sources)
+{
+    writeCacheInt(out, (int)sources.size());
+    for (vector<string>::const_iterator it=sources.begin(); it!=sources.end(); ++it)
+    {
+        int64 time = getFileTime(*it);
+        writeCacheString(out, *it);
+        out.write((const char *)&time, sizeof(time));
+    }
+}
+
+static bool readCacheSources(istream &in, const vector<string> &sources)
+{
+    if (readCacheInt(in) != (int)sources.size())
+    {
+        return false;
+    }
+    for (vector<string>::const_iterator it=sources.begin(); it!=sources.end(); ++it)
+    {
+        int64 time = 0;
+        string name = readCacheString(in);
+        in.read((char *)&time, sizeof(time));
+        if (!in || name != *it || time != getFileTime(*it))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void writeCacheSplits(ostream &out, const vector< vector< Ptr<Object> > > &splits,
+                             const Dataset &dataset, void (Dataset::*writeObject)(ostream &, const Ptr<Object> &) const)
+{
+    writeCacheInt(out, (int)splits.size());
+    for (size_t i=0; i<splits.size(); ++i)
+    {
+        writeCacheInt(out, (int)splits[i].size());
+        for (size_t j=0; j<splits[i].size(); ++j)
+        {
+            (dataset.*writeObject)(out, splits[i][j]);
+        }
+    }
+}
+
+static bool readCacheSplits(istream &in, vector< vector< Ptr<Object> > > &splits,
+                            const Dataset &dataset, Ptr<Object> (Dataset::*readObject)(istream &) const)
+{
+    int numSplits = readCacheInt(in);
+    if (!in || numSplits < 0)
+    {
+        return false;
+    }
+    splits.resize(numSplits);
+    for (int i=0; i<numSplits; ++i)
+    {
+        int numObjects = readCacheInt(in);
+        if (!in || numObjects < 0)
+        {
+            return false;
+        }
+        splits[i].reserve(numObjects);
+        for (int j=0; j<numObjects && in; ++j)
+        {
+            splits[i].push_back((dataset.*readObject)(in));
+        }
+    }
+    return !in.fail();
+}
+
+bool Dataset::loadCache(const string &cacheFile, const vector<string> &sources)
+{
+    ifstream in(cacheFile.c_str(), ios::in | ios::binary);
+    if (!in.is_open())
+    {
+        return false;
+    }
+
+    char magic[sizeof(cacheMagic)];
+    in.read(magic, sizeof(magic));
+    if (!in || memcmp(magic, cacheMagic, sizeof(magic)) != 0 || !readCacheSources(in, sources))
+    {
+        return false;
+    }
+
+    if (!readCacheSplits(in, train, *this, &Dataset::readObject) ||
+        !readCacheSplits(in, test, *this, &Dataset::readObject) ||
+        !readCacheSplits(in, validation, *this, &Dataset::readObject))
+    {
+        train.clear();
+        test.clear();
+        validation.clear();
+        return false;
+    }
+    return true;
+}
+
+void Dataset::saveCache(const string &cacheFile, const vector<string> &sources) const
+{
+    // written aside and renamed, so that an interrupted write is not taken for a cache
+    string tmpFile(cacheFile + ".tmp");
+    {
+        ofstream out(tmpFile.c_str(), ios::out | ios::binary | ios::trunc);
+        if (!out.is_open())
+        {
+            return;
+        }
+
+        out.write(cacheMagic, sizeof(cacheMagic));
+        writeCacheSources(out, sources);
+        writeCacheSplits(out, train, *this, &Dataset::writeObject);
+        writeCacheSplits(out, test, *this, &Dataset::writeObject);
+        writeCacheSplits(out, validation, *this, &Dataset::writeObject);
+        if (!out)
+        {
+            out.close();
+            remove(tmpFile.c_str());
+            return;
+        }
+    }
+    remove(cacheFile.c_str());
+    if (rename(tmpFile.c_str(), cacheFile.c_str()) != 0)
+    {
+        remove(tmpFile.c_str());
+    }
+}
+
+void Dataset::writeObject(ostream &, const Ptr<Object> &) const
+{
+    CV_Error(Error::StsNotImplemented, "The dataset does not support caching");
+}
+
+Ptr<Object> Dataset::readObject(istream &) const
+{
+    CV_Error(Error::StsNotImplemented, "The dataset does not support caching");
+    return Ptr<Object>();
+}
+
 }
 }
 
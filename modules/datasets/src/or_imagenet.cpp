@@ -41,6 +41,7 @@
 
 #include "opencv2/datasets/or_imagenet.hpp"
 #include "opencv2/datasets/util.hpp"
+#include "opencv2/core/utility.hpp"
 
 #include <map>
 
@@ -60,6 +61,10 @@ public:
 
     virtual void load(const string &path);
 
+protected:
+    virtual void writeObject(ostream &out, const Ptr<Object> &object) const;
+    virtual Ptr<Object> readObject(istream &in) const;
+
 private:
     void loadDataset(const string &path);
 
@@ -73,7 +78,41 @@ private:
 
 void OR_imagenetImp::load(const string &path)
 {
+    // listing the images of the synsets takes most of the time, their directories key the cache
+    string cacheFile(path + "or_imagenet.cache");
+    vector<string> sources, synsets;
+    sources.push_back(path + "labels.txt");
+    sources.push_back(path + "ILSVRC2010_validation_ground_truth.txt");
+    sources.push_back(path + "ILSVRC2010_test_ground_truth.txt");
+    sources.push_back(path + "train/");
+    getDirList(path + "train/", synsets);
+    for (vector<string>::iterator it=synsets.begin(); it!=synsets.end(); ++it)
+    {
+        sources.push_back(path + "train/" + *it + "/");
+    }
+    if (loadCache(cacheFile, sources))
+    {
+        return;
+    }
+
     loadDataset(path);
+
+    saveCache(cacheFile, sources);
+}
+
+void OR_imagenetImp::writeObject(ostream &out, const Ptr<Object> &object) const
+{
+    const OR_imagenetObj *curr = static_cast<const OR_imagenetObj *>(object.get());
+    writeCacheInt(out, curr->id);
+    writeCacheString(out, curr->image);
+}
+
+Ptr<Object> OR_imagenetImp::readObject(istream &in) const
+{
+    Ptr<OR_imagenetObj> curr(new OR_imagenetObj);
+    curr->id = readCacheInt(in);
+    curr->image = readCacheString(in);
+    return curr;
 }
 
 void OR_imagenetImp::numberToString(int number, string &out)
@@ -87,6 +126,31 @@ void OR_imagenetImp::numberToString(int number, string &out)
     out += numberStr;
 }
 
+// the directories of the synsets are listed in parallel, most of the loading time with many of them
+class ListSynsetsInvoker : public ParallelLoopBody
+{
+public:
+    ListSynsetsInvoker(const string &_pathTrain, const vector<string> &_synsets, vector< vector<string> > &_fileNames)
+        : pathTrain(_pathTrain), synsets(_synsets), fileNames(_fileNames)
+    {
+    }
+
+    void operator()(const Range &range) const
+    {
+        for (int i=range.start; i<range.end; ++i)
+        {
+            getDirList(pathTrain + synsets[i] + "/", fileNames[i]);
+        }
+    }
+
+private:
+    const string &pathTrain;
+    const vector<string> &synsets;
+    vector< vector<string> > &fileNames;
+
+    ListSynsetsInvoker& operator=(const ListSynsetsInvoker&); // to quiet MSVC
+};
+
 void OR_imagenetImp::loadDataset(const string &path)
 {
     train.push_back(vector< Ptr<Object> >());
@@ -109,11 +173,13 @@ void OR_imagenetImp::loadDataset(const string &path)
     string pathTrain(path + "train/");
     vector<string> fileNames;
     getDirList(pathTrain, fileNames);
-    for (vector<string>::iterator it=fileNames.begin(); it!=fileNames.end(); ++it)
+    vector< vector<string> > fileNamesSyns(fileNames.size());
+    parallel_for_(Range(0, (int)fileNames.size()), ListSynsetsInvoker(pathTrain, fileNames, fileNamesSyns));
+    for (size_t i=0; i<fileNames.size(); ++i)
     {
+        vector<string>::iterator it=fileNames.begin()+i;
         string pathSyn((*it) + "/");
-        vector<string> fileNamesSyn;
-        getDirList((pathTrain + pathSyn), fileNamesSyn);
+        vector<string> &fileNamesSyn = fileNamesSyns[i];
         for (vector<string>::iterator itSyn=fileNamesSyn.begin(); itSyn!=fileNamesSyn.end(); ++itSyn)
         {
             Ptr<OR_imagenetObj> curr(new OR_imagenetObj);
@@ -59,6 +59,10 @@ public:
 
     virtual void load(const string &path);
 
+protected:
+    virtual void writeObject(ostream &out, const Ptr<Object> &object) const;
+    virtual Ptr<Object> readObject(istream &in) const;
+
 private:
     void loadDataset(const string &path, const string &nameImageSet, vector< Ptr<Object> > &imageSet);
     Ptr<Object> parseAnnotation(const string &path, const string &id);
@@ -68,6 +72,19 @@ private:
 
 void OR_pascalImp::load(const string &path)
 {
+    // parsing the XML annotations takes most of the time, the parsed objects are cached next to them.
+    // An annotation edited in place does not change the time of its directory, remove the cache then
+    string cacheFile(path + "or_pascal.cache");
+    vector<string> sources;
+    sources.push_back(path + "ImageSets/Main/train.txt");
+    sources.push_back(path + "ImageSets/Main/test.txt");
+    sources.push_back(path + "ImageSets/Main/val.txt");
+    sources.push_back(path + "Annotations/");
+    if (loadCache(cacheFile, sources))
+    {
+        return;
+    }
+
     train.push_back(vector< Ptr<Object> >());
     test.push_back(vector< Ptr<Object> >());
     validation.push_back(vector< Ptr<Object> >());
@@ -75,6 +92,81 @@ void OR_pascalImp::load(const string &path)
     loadDataset(path, "train", train.back());
     loadDataset(path, "test", test.back());
     loadDataset(path, "val", validation.back());
+
+    saveCache(cacheFile, sources);
+}
+
+static void writePart(ostream &out, const PascalPart &part)
+{
+    writeCacheString(out, part.name);
+    writeCacheInt(out, part.xmin);
+    writeCacheInt(out, part.ymin);
+    writeCacheInt(out, part.xmax);
+    writeCacheInt(out, part.ymax);
+}
+
+static void readPart(istream &in, PascalPart &part)
+{
+    part.name = readCacheString(in);
+    part.xmin = readCacheInt(in);
+    part.ymin = readCacheInt(in);
+    part.xmax = readCacheInt(in);
+    part.ymax = readCacheInt(in);
+}
+
+void OR_pascalImp::writeObject(ostream &out, const Ptr<Object> &object) const
+{
+    const OR_pascalObj *annotation = static_cast<const OR_pascalObj *>(object.get());
+    writeCacheString(out, annotation->filename);
+    writeCacheInt(out, annotation->width);
+    writeCacheInt(out, annotation->height);
+    writeCacheInt(out, annotation->depth);
+
+    writeCacheInt(out, (int)annotation->objects.size());
+    for (vector<PascalObj>::const_iterator it=annotation->objects.begin(); it!=annotation->objects.end(); ++it)
+    {
+        writePart(out, *it);
+        writeCacheString(out, it->pose);
+        writeCacheInt(out, (it->truncated ? 1 : 0) | (it->difficult ? 2 : 0) | (it->occluded ? 4 : 0));
+
+        writeCacheInt(out, (int)it->parts.size());
+        for (vector<PascalPart>::const_iterator itPart=it->parts.begin(); itPart!=it->parts.end(); ++itPart)
+        {
+            writePart(out, *itPart);
+        }
+    }
+}
+
+Ptr<Object> OR_pascalImp::readObject(istream &in) const
+{
+    Ptr<OR_pascalObj> annotation(new OR_pascalObj);
+    annotation->filename = readCacheString(in);
+    annotation->width = readCacheInt(in);
+    annotation->height = readCacheInt(in);
+    annotation->depth = readCacheInt(in);
+
+    int numObjects = readCacheInt(in);
+    for (int i=0; i<numObjects && in; ++i)
+    {
+        PascalObj pascal_obj;
+        readPart(in, pascal_obj);
+        pascal_obj.pose = readCacheString(in);
+        int flags = readCacheInt(in);
+        pascal_obj.truncated = (flags & 1) != 0;
+        pascal_obj.difficult = (flags & 2) != 0;
+        pascal_obj.occluded = (flags & 4) != 0;
+
+        int numParts = readCacheInt(in);
+        for (int j=0; j<numParts && in; ++j)
+        {
+            PascalPart pascal_part;
+            readPart(in, pascal_part);
+            pascal_obj.parts.push_back(pascal_part);
+        }
+        annotation->objects.push_back(pascal_obj);
+    }
+
+    return annotation;
 }
 
 void OR_pascalImp::loadDataset(const string &path, const string &nameImageSet, vector< Ptr<Object> > &imageSet)
@@ -41,6 +41,7 @@
 
 #include "opencv2/datasets/slam_kitti.hpp"
 #include "opencv2/datasets/util.hpp"
+#include "opencv2/core/utility.hpp"
 
 namespace cv
 {
@@ -72,89 +73,123 @@ void SLAM_kittiImp::load(const string &path)
     loadDataset(path);
 }
 
-void SLAM_kittiImp::loadDataset(const string &path)
+// the sequences are independent, each of them is listed and parsed on its own
+static void loadSequence(const string &path, const string &name, Ptr<SLAM_kittiObj> &curr)
 {
-    train.push_back(vector< Ptr<Object> >());
-    test.push_back(vector< Ptr<Object> >());
-    validation.push_back(vector< Ptr<Object> >());
-
     string pathSequence(path + "sequences/");
-    vector<string> fileNames;
-    getDirList(pathSequence, fileNames);
-    for (vector<string>::iterator it=fileNames.begin(); it!=fileNames.end(); ++it)
-    {
-        Ptr<SLAM_kittiObj> curr(new SLAM_kittiObj);
-        curr->name = *it;
 
-        string currPath(pathSequence + curr->name);
+    curr->name = name;
 
-        // loading velodyne
-        string pathVelodyne(currPath + "/velodyne/");
-        vector<string> velodyneNames;
-        getDirList(pathVelodyne, velodyneNames);
-        for (vector<string>::iterator itV=velodyneNames.begin(); itV!=velodyneNames.end(); ++itV)
-        {
-            curr->velodyne.push_back(*itV);
-        }
+    string currPath(pathSequence + curr->name);
+
+    // loading velodyne
+    string pathVelodyne(currPath + "/velodyne/");
+    vector<string> velodyneNames;
+    getDirList(pathVelodyne, velodyneNames);
+    for (vector<string>::iterator itV=velodyneNames.begin(); itV!=velodyneNames.end(); ++itV)
+    {
+        curr->velodyne.push_back(*itV);
+    }
 
-        // loading gray & color images
-        for (unsigned int i=0; i<=3; ++i)
+    // loading gray & color images
+    for (unsigned int i=0; i<=3; ++i)
+    {
+        char tmp[2];
+        sprintf(tmp, "%u", i);
+        string pathImage(currPath + "/image_" + tmp + "/");
+        vector<string> imageNames;
+        getDirList(pathImage, imageNames);
+        for (vector<string>::iterator itImage=imageNames.begin(); itImage!=imageNames.end(); ++itImage)
         {
-            char tmp[2];
-            sprintf(tmp, "%u", i);
-            string pathImage(currPath + "/image_" + tmp + "/");
-            vector<string> imageNames;
-            getDirList(pathImage, imageNames);
-            for (vector<string>::iterator itImage=imageNames.begin(); itImage!=imageNames.end(); ++itImage)
-            {
-                curr->images[i].push_back(*itImage);
-            }
+            curr->images[i].push_back(*itImage);
         }
+    }
+
+    // loading times
+    ifstream infile((currPath + "/times.txt").c_str());
+    string line;
+    while (getline(infile, line))
+    {
+        curr->times.push_back(atof(line.c_str()));
+    }
 
-        // loading times
-        ifstream infile((currPath + "/times.txt").c_str());
-        string line;
-        while (getline(infile, line))
+    // loading calibration
+    ifstream infile2((currPath + "/calib.txt").c_str());
+    for (unsigned int i=0; i<4; ++i)
+    {
+        getline(infile2, line);
+        vector<string> elems;
+        split(line, elems, ' ');
+        vector<string>::iterator itE=elems.begin();
+        for (++itE; itE!=elems.end(); ++itE)
         {
-            curr->times.push_back(atof(line.c_str()));
+            curr->p[i].push_back(atof((*itE).c_str()));
         }
+    }
+
+    // loading poses
+    ifstream infile3((path + "poses/" + curr->name + ".txt").c_str());
+    while (getline(infile3, line))
+    {
+        pose p;
 
-        // loading calibration
-        ifstream infile2((currPath + "/calib.txt").c_str());
-        for (unsigned int i=0; i<4; ++i)
+        unsigned int i=0;
+        vector<string> elems;
+        split(line, elems, ' ');
+        for (vector<string>::iterator itE=elems.begin(); itE!=elems.end(); ++itE, ++i)
         {
-            getline(infile2, line);
-            vector<string> elems;
-            split(line, elems, ' ');
-            vector<string>::iterator itE=elems.begin();
-            for (++itE; itE!=elems.end(); ++itE)
+            if (i>11)
             {
-                curr->p[i].push_back(atof((*itE).c_str()));
+                break;
             }
+            p.elem[i] = atof((*itE).c_str());
         }
 
-        // loading poses
-        ifstream infile3((path + "poses/" + curr->name + ".txt").c_str());
-        while (getline(infile3, line))
-        {
-            pose p;
+        curr->posesArray.push_back(p);
+    }
+}
 
-            unsigned int i=0;
-            vector<string> elems;
-            split(line, elems, ' ');
-            for (vector<string>::iterator itE=elems.begin(); itE!=elems.end(); ++itE, ++i)
-            {
-                if (i>11)
-                {
-                    break;
-                }
-                p.elem[i] = atof((*itE).c_str());
-            }
+class LoadSequencesInvoker : public ParallelLoopBody
+{
+public:
+    LoadSequencesInvoker(const string &_path, const vector<string> &_names, vector< Ptr<SLAM_kittiObj> > &_sequences)
+        : path(_path), names(_names), sequences(_sequences)
+    {
+    }
 
-            curr->posesArray.push_back(p);
+    void operator()(const Range &range) const
+    {
+        for (int i=range.start; i<range.end; ++i)
+        {
+            sequences[i] = Ptr<SLAM_kittiObj>(new SLAM_kittiObj);
+            loadSequence(path, names[i], sequences[i]);
         }
+    }
+
+private:
+    const string &path;
+    const vector<string> &names;
+    vector< Ptr<SLAM_kittiObj> > &sequences;
+
+    LoadSequencesInvoker& operator=(const LoadSequencesInvoker&); // to quiet MSVC
+};
+
+void SLAM_kittiImp::loadDataset(const string &path)
+{
+    train.push_back(vector< Ptr<Object> >());
+    test.push_back(vector< Ptr<Object> >());
+    validation.push_back(vector< Ptr<Object> >());
 
-        train.back().push_back(curr);
+    string pathSequence(path + "sequences/");
+    vector<string> fileNames;
+    getDirList(pathSequence, fileNames);
+
+    vector< Ptr<SLAM_kittiObj> > sequences(fileNames.size());
+    parallel_for_(Range(0, (int)fileNames.size()), LoadSequencesInvoker(path, fileNames, sequences));
+
+    for (vector< Ptr<SLAM_kittiObj> >::iterator it=sequences.begin(); it!=sequences.end(); ++it)
+    {
+        train.back().push_back(*it);
     }
 }
 
@@ -202,6 +202,7 @@ namespace cv
             if (id > 0 && id <= (int)data.size())
             {
                 activeDatasetID = id;
+                frameCounter = 0;
                 return true;
             }
             else
@@ -52,6 +52,8 @@
 #else
     #include <io.h>
     #include <direct.h>
+    #include <sys/types.h>
+    #include <sys/stat.h>
 #endif
 
 namespace cv
@@ -116,5 +118,63 @@ void getDirList(const string &dirName, vector<string> &fileNames)
 #endif
 }
 
+int64 getFileTime(const string &path)
+{
+    // trailing separators are not accepted by stat() on Windows
+    string name(path);
+    while (name.size() > 1 && (name[name.size()-1] == '/' || name[name.size()-1] == '\\'))
+    {
+        name.erase(name.size()-1);
+    }
+#ifndef _WIN32
+    struct stat info;
+    if (stat(name.c_str(), &info) != 0)
+    {
+        return 0;
+    }
+#else
+    struct _stat info;
+    if (_stat(name.c_str(), &info) != 0)
+    {
+        return 0;
+    }
+#endif
+    return (int64)info.st_mtime;
+}
+
+void writeCacheInt(ostream &out, int value)
+{
+    out.write((const char *)&value, sizeof(value));
+}
+
+int readCacheInt(istream &in)
+{
+    int value = 0;
+    in.read((char *)&value, sizeof(value));
+    return value;
+}
+
+void writeCacheString(ostream &out, const string &value)
+{
+    writeCacheInt(out, (int)value.size());
+    out.write(value.data(), value.size());
+}
+
+string readCacheString(istream &in)
+{
+    int size = readCacheInt(in);
+    if (!in || size < 0)
+    {
+        in.setstate(ios::failbit);
+        return string();
+    }
+    string value(size, '\0');
+    if (size > 0)
+    {
+        in.read(&value[0], size);
+    }
+    return value;
+}
+
 }
 }
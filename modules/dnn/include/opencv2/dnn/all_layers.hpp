@@ -131,6 +131,13 @@ namespace dnn
         /** @brief Returns current @f$ c_{t-1} @f$ value (deep copy). */
         CV_WRAP virtual Blob getC() const = 0;
 
+        /** @brief Resets @f$ h_{t-1} @f$ and @f$ c_{t-1} @f$ to zeros.
+          * @details The state is kept between forward() calls (and reallocations with the same number of streams),
+          * so a long sequence can be processed by consecutive chunks of timestamps, e.g. in online (streaming) pipelines.
+          * Call this method before processing of a new independent sequence.
+          */
+        CV_WRAP virtual void resetState() = 0;
+
         /** @brief Specifies either interpet first dimension of input blob as timestamp dimenion either as sample.
           *
           * If flag is set to true then shape of input blob will be interpeted as [`T`, `N`, `[data dims]`] where `T` specifies number of timpestamps, `N` is number of independent streams.
@@ -191,6 +198,13 @@ namespace dnn
          */
         CV_WRAP virtual void setProduceHiddenOutput(bool produce = false) = 0;
 
+        /** @brief Resets @f$ h_{t-1} @f$ to zeros.
+          * @details The state is kept between forward() calls (and reallocations with the same number of samples),
+          * so a long sequence can be processed by consecutive chunks of timestamps.
+          * Call this method before processing of a new independent sequence.
+          */
+        CV_WRAP virtual void resetState() = 0;
+
         /** Accepts two inputs @f$x_t@f$ and @f$h_{t-1}@f$ and compute two outputs @f$o_t@f$ and @f$h_t@f$.
 
         @param input should contain packed input @f$x_t@f$.
@@ -163,7 +163,10 @@ namespace dnn
         /** @brief Works like Blob::fromImages() but in-place. */
         void batchFromImages(InputArray image, int dstCn = -1);
 
-        /** @brief Creates blob with specified @p shape and @p type. */
+        /** @brief Creates blob with specified @p shape and @p type.
+         *  @details Like std::vector, CPU buffer which isn't shared with other arrays is kept if it's large enough
+         *  for the new shape, so repeated creation with varying shapes reallocates only when the data grows.
+         */
         void create(const BlobShape &shape, int type = CV_32F, int allocFlags = ALLOC_MAT);
 
         /** @brief Creates blob from Mat or UMat without copying the data.
@@ -289,6 +292,15 @@ namespace dnn
          */
         Blob reshaped(const BlobShape &newShape) const;
 
+        /** @brief Returns copy of CV_32F blob with elements converted to half precision floats (IEEE 754 binary16).
+         *  @details Half precision blobs have CV_16S type, i.e. elements are stored as raw 16-bit values.
+         *  Such blobs are intended for compact storage of the learned weights, see Net::convertWeightsToHalf().
+         */
+        Blob toHalf() const;
+
+        /** @brief Returns CV_32F copy of half precision blob produced by toHalf(). */
+        Blob toFloat() const;
+
         int type() const;       //!< Returns type of the blob.
         int elemSize() const;   //!< Returns size of single element in bytes.
         int getState() const;   //!< Returns current state of the blob, @see DataState.
@@ -133,6 +133,14 @@ public:
     template<typename T>
     const T &set(const String &key, const T &value);
 
+    typedef _Dict::const_iterator const_iterator;
+
+    //! Returns iterator to the first key-value pair of the dictionary.
+    const_iterator begin() const;
+
+    //! Returns iterator to the past-the-end key-value pair of the dictionary.
+    const_iterator end() const;
+
     friend std::ostream &operator<<(std::ostream &stream, const Dict &dict);
 };
 
@@ -61,6 +61,11 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
      */
     CV_EXPORTS_W void initModule();
 
+    /** @brief Returns names of matrix multiplication backends available in this build.
+     *  @see Net::setGemmBackend()
+     */
+    CV_EXPORTS_W std::vector<String> getGemmBackendNames();
+
     /** @brief This class provides all data needed to initialize layer.
      *
      * It includes dictionary with scalar params (which can be readed by using Dict interface),
@@ -137,6 +142,50 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
         virtual ~Layer();
     };
 
+    /** @brief Per-layer statistics, collected by Net when profiling is enabled.
+     *  @see Net::setProfiling(), Net::getProfile()
+     */
+    struct CV_EXPORTS LayerProfile
+    {
+        String name;        //!< Name of the layer.
+        String type;        //!< Type of the layer.
+        int calls;          //!< Number of forward() calls since the last reset.
+        double time;        //!< Total wall time of forward() calls in milliseconds.
+        size_t outputBytes; //!< Size of memory held by the output blobs of the layer.
+        double flops;       //!< Estimated number of floating point operations per forward() call.
+        bool fused;         //!< Layer computations were fused into the preceding layer.
+    };
+
+    /** @brief Output blob of a forward pass, started by Net::forwardAsync(), which may be still computed.
+     *
+     * In the OpenCL mode the OpenCL layers only enqueue their kernels, so the host is free
+     * until the result is requested. Layers computed on the host are done at once.
+     * Copies of the object refer to the same result.
+     */
+    class CV_EXPORTS BlobFuture
+    {
+    public:
+        BlobFuture(); //!< Creates an object without a result.
+
+        /** Returns true if the object refers to a result of a forward pass. */
+        bool valid() const;
+
+        /** @brief Waits until the computations of the result are finished.
+         *  @details It waits for all commands of the OpenCL queue, enqueued before the call.
+         */
+        void wait() const;
+
+        /** @brief Waits for the result and returns the output blob.
+         *  @note The blob refers to the output of the network, which is overwritten by the next forward pass.
+         */
+        Blob get() const;
+
+    private:
+        friend class Net;
+        struct Impl;
+        Ptr<Impl> impl;
+    };
+
     /** @brief This class allows to create and manipulate comprehensive artificial neural networks.
      *
      * Neural network is presented as directed acyclic graph (DAG), where vertices are Layer instances,
@@ -154,6 +203,16 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
         CV_WRAP Net();  //!< Default constructor.
         CV_WRAP ~Net(); //!< Destructor frees the net only if there aren't references to the net anymore.
 
+        /** @brief Creates an execution context of the network.
+         *  @details The returned network has the same topology and refers to the same learned parameters of the layers,
+         *  so the weights aren't duplicated, but it owns the layer instances and all intermediate blobs.
+         *  Hence, the original network and its contexts can make the forward pass simultaneously from different threads.
+         *  Options of the original network (memory reuse, int8 mode, etc.) are inherited by the context.
+         *  @note Copies of Net objects refer to the same network, so they can't be used concurrently.
+         *  @warning Learned parameters must not be modified while the contexts are in use.
+         */
+        CV_WRAP Net createContext() const;
+
         /** Returns true if there are no layers in the network. */
         CV_WRAP bool empty() const;
 
@@ -220,6 +279,18 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
         /** @brief Initializes and allocates all layers. */
         CV_WRAP void allocate();
 
+        /** @brief Enables or disables sharing of memory between output blobs of different layers.
+         *
+         * If enabled, allocate() computes lifetimes of intermediate blobs and binds blobs,
+         * whose lifetimes don't intersect, to the same memory of one common arena.
+         * It significantly reduces memory consumption of deep networks.
+         * @note When reuse is enabled only the network input blobs and outputs of the network
+         * (i.e. outputs of the layers which aren't connected to any other layers) keep the valid data after forward().
+         * Intermediate blobs, returned by getBlob(), may be overwritten by the following layers.
+         * The setting takes effect on the next allocation of the network. By default it's disabled.
+         */
+        CV_WRAP void setMemoryReuse(bool enable);
+
         /** @brief Runs forward pass to compute output of layer @p toLayer.
           * @details By default runs forward pass for the whole network.
           */
@@ -229,6 +300,16 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
         /** @overload */
         void forward(const std::vector<LayerId> &startLayers, const std::vector<LayerId> &toLayers);
 
+        /** @brief Starts forward pass to compute the output blob @p outputName, without waiting for OpenCL computations.
+         *  @param outputName descriptor of the returned blob, see connect(String, String).
+         *
+         * The next input can be prepared on the host and passed by setBlob() while the device computes
+         * the current pass. The kernels of the next pass are executed after these of the current one,
+         * and its output is overwritten, so take the result by BlobFuture::get() before the next forward pass.
+         * Without OpenCL it's the same as forward() followed by getBlob().
+         */
+        BlobFuture forwardAsync(const String &outputName);
+
         //TODO:
         /** @brief Optimized forward.
          *  @warning Not implemented yet.
@@ -238,21 +319,109 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
         /** @overload */
         void forwardOpt(const std::vector<LayerId> &toLayers);
 
+        /** @brief Enables or disables concurrent computation of independent branches of the network.
+         *
+         * If enabled, the whole network forward pass computes layers level by level,
+         * where the layers of one level don't depend on each other (e.g. branches of Inception modules or SSD heads)
+         * and are computed simultaneously by different threads.
+         * Layers which modify their inputs in-place are computed sequentially.
+         * It's useful for networks with many small layers, which aren't able to load all threads on their own.
+         * By default it's disabled.
+         */
+        CV_WRAP void setParallelBranches(bool enable);
+
+        /** @brief Enables or disables checking that intermediate blobs stay in the device memory.
+         *
+         * If enabled, the forward pass fails if some layer in the middle of the graph
+         * transfers its input blobs, which are located in the OpenCL device memory, to the host memory,
+         * or computes its outputs on the host.
+         * Layers, which outputs aren't used by other layers, are allowed to return the data to the host.
+         * It's intended to find layers which break device residency of the data in OpenCL mode.
+         * By default it's disabled.
+         */
+        CV_WRAP void setHostSyncCheck(bool enable);
+
+        /** @brief Selects implementation of matrix multiplication used by convolution and fully connected layers.
+         *  @param name of backend from getGemmBackendNames(), "auto" or empty string.
+         *
+         * Empty string restores the default choice, which depends on types and shapes of the matrices.
+         * "auto" makes each layer benchmark applicable backends for its matrix sizes during the allocation
+         * and use the fastest one; results are cached for the same sizes and the number of threads.
+         * Backends run on the number of threads set by cv::setNumThreads().
+         * Takes effect on the next forward pass. It doesn't affect computations in the OpenCL mode.
+         */
+        CV_WRAP void setGemmBackend(const String &name);
+
+        /** @brief Enables or disables collection of per-layer timings during forward passes.
+         *  @details Profiling is disabled by default, so forward passes don't pay for time measurements.
+         */
+        CV_WRAP void setProfiling(bool enable);
+
+        /** @brief Resets timings and counters of forward() calls, collected by profiling. */
+        CV_WRAP void resetProfile();
+
+        /** @brief Returns per-layer statistics: accumulated wall time, used memory of outputs and FLOPs estimation.
+         *  @details Statistics of memory and FLOPs are available after the network was allocated.
+         */
+        std::vector<LayerProfile> getProfile() const;
+
         /** @brief Sets the new value for the layer output blob
          *  @param outputName descriptor of the updating layer output blob.
          *  @param blob new blob.
          *  @see connect(String, String) to know format of the descriptor.
-         *  @note If updating blob is not empty then @p blob must have the same shape,
-         *  because network reshaping is not implemented yet.
+         *  @note If the shape of the network input blob is changed, then the network will be reallocated on the next forward pass.
+         *  Only layers, whose inputs have changed, are reallocated, and their buffers are kept while they are large enough
+         *  for new shapes. So inputs of varying sizes don't lead to allocations once the largest size was processed.
+         *  With enabled memory reuse the whole network is reallocated and its memory is planned again.
          */
         CV_WRAP void setBlob(String outputName, const Blob &blob);
 
+        /** @brief Runs one forward pass for the whole batch of images.
+         *  @param images      input images, they are packed along the first (batch) axis of the input blob, see Blob::fromImages().
+         *  @param inputName   descriptor of the network input blob, which will be filled by the images.
+         *  @param outputName  descriptor of the blob, which should be returned.
+         *  @param outputs     per-sample slices of the output blob, i. e. outputs[i] corresponds to images[i].
+         *  @param dstCn       specifies size of the second axis of the input blob, see Blob::fromImages().
+         *
+         * Compared to separate forward passes for each image this allows the layers to process all samples at once.
+         * @note @p outputs are views into the output blob of the network and don't own their data,
+         * so they are valid until the next forward pass. If the number of images changes, then the network is reallocated.
+         */
+        void forwardBatch(const std::vector<Mat> &images, const String &inputName,
+                          const String &outputName, std::vector<Mat> &outputs, int dstCn = -1);
+
         /** @brief Returns the layer output blob.
          *  @param outputName the descriptor of the returning layer output blob.
          *  @see connect(String, String)
          */
         CV_WRAP Blob getBlob(String outputName);
 
+        /** @brief Switches the network to 8-bit integer computations where it's supported.
+         *  @param samples   representative input blobs, which are used for calibration.
+         *  @param inputName descriptor of the network input blob, which will be filled by the @p samples.
+         *
+         * The network is forwarded in floating point mode on each sample and ranges of inputs of
+         * Convolution and InnerProduct layers are collected. After that these layers quantize their weights
+         * with per-channel scales and use int8 GEMM with int32 accumulation on CPU.
+         * Other layers keep floating point computations, blobs between layers are also stored as floats.
+         * @note Inputs outside of the calibrated ranges are saturated.
+         */
+        void calibrateInt8(const std::vector<Blob> &samples, const String &inputName);
+
+        /** @brief Returns all layers back to floating point computations. @sa calibrateInt8() */
+        void disableInt8();
+
+        /** @brief Converts the learned weights of Convolution, Deconvolution and InnerProduct layers to half precision floats.
+         *
+         * It halves memory occupied by the weights of these layers, which usually is the most part of the model.
+         * Computations are still performed in single precision: the weights are converted by blocks inside
+         * matrix multiplications on CPU and by the kernel in OpenCL mode. Convolutions in OpenCL mode
+         * fall back to CPU. Layers in int8 mode keep their weights.
+         * The conversion is irreversible, call it after the model is loaded to convert weights of a caffemodel.
+         * Converted weights are preserved by writeBinary() and shared by createContext().
+         */
+        void convertWeightsToHalf();
+
         /** @brief Sets the new value for the learned param of the layer.
          *  @param layer name or id of the layer.
          *  @param numParam index of the layer parameter in the Layer::blobs array.
@@ -270,6 +439,14 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
          */
         CV_WRAP Blob getParam(LayerId layer, int numParam = 0);
 
+        /** @brief Serializes the network into the native binary format.
+         *  @param path path to the output file.
+         *  @details The file keeps the topology of the network and learned parameters of its layers.
+         *  The parameters are stored as aligned raw sections, which are mapped into memory by readNetFromBinary().
+         *  @see readNetFromBinary()
+         */
+        CV_WRAP void writeBinary(const String &path) const;
+
     private:
 
         struct Impl;
@@ -299,6 +476,20 @@ namespace dnn //! This namespace is used for dnn module functionlaity.
       */
     CV_EXPORTS_W Net readNetFromCaffe(const String &prototxt, const String &caffeModel = String());
 
+    /** @brief Creates the importer of the network, serialized by Net::writeBinary().
+     *  @param path path to the file with the network.
+     *  @details The file is mapped into memory and learned blobs of the layers refer to the mapped pages directly,
+     *  so loading doesn't parse and copy the weights, and several processes loading the same file share its memory.
+     *  The pages are mapped in copy-on-write mode, so modification of the blobs doesn't affect the file.
+     */
+    CV_EXPORTS_W Ptr<Importer> createBinaryImporter(const String &path);
+
+    /** @brief Reads a network model stored in the native binary format.
+     *  @details This is shortcut consisting from createBinaryImporter and Net::populateNet calls.
+     *  @see Net::writeBinary()
+     */
+    CV_EXPORTS_W Net readNetFromBinary(const String &path);
+
     /** @brief Creates the importer of <a href="http://torch.ch">Torch7</a> framework network.
      *  @param filename path to the file, dumped from Torch by using torch.save() function.
      *  @param isBinary specifies whether the network was serialized in ascii mode or binary.
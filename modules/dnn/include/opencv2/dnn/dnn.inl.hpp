@@ -336,6 +336,16 @@ inline const T &Dict::set(const String &key, const T &value)
     return value;
 }
 
+inline Dict::const_iterator Dict::begin() const
+{
+    return dict.begin();
+}
+
+inline Dict::const_iterator Dict::end() const
+{
+    return dict.end();
+}
+
 inline std::ostream &operator<<(std::ostream &stream, const Dict &dict)
 {
     Dict::_Dict::const_iterator it;
@@ -0,0 +1,49 @@
+#ifndef __OPENCV_DNN_PERF_COMMON_HPP__
+#define __OPENCV_DNN_PERF_COMMON_HPP__
+
+namespace cvtest
+{
+
+enum {DNN_TARGET_CPU = 0, DNN_TARGET_OPENCL = 1};
+CV_ENUM(DNNTarget, DNN_TARGET_CPU, DNN_TARGET_OPENCL);
+
+//switches OpenCL on for DNN_TARGET_OPENCL and restores the previous state on exit
+class DNNTargetScope
+{
+public:
+    explicit DNNTargetScope(int target) : prevUseOpenCL(cv::ocl::useOpenCL())
+    {
+        if (target == DNN_TARGET_OPENCL && !cv::ocl::haveOpenCL())
+            throw ::perf::TestBase::PerfSkipTestException();
+        cv::ocl::setUseOpenCL(target == DNN_TARGET_OPENCL);
+    }
+
+    ~DNNTargetScope()
+    {
+        cv::ocl::setUseOpenCL(prevUseOpenCL);
+    }
+
+private:
+    bool prevUseOpenCL;
+};
+
+//fills blobs with random values, in OpenCL mode the data is moved to the device
+inline void fillInputs(const std::vector<cv::dnn::BlobShape> &shapes, std::vector<cv::dnn::Blob> &blobs,
+                       std::vector<cv::dnn::Blob*> &ptrs)
+{
+    cv::RNG rng(0);
+    blobs.resize(shapes.size());
+    ptrs.resize(shapes.size());
+    for (size_t i = 0; i < shapes.size(); i++)
+    {
+        blobs[i].create(shapes[i]);
+        rng.fill(blobs[i].matRef(), cv::RNG::UNIFORM, -1, 1);
+        if (cv::ocl::useOpenCL())
+            blobs[i].umatRef(false);
+        ptrs[i] = &blobs[i];
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,108 @@
+#include "perf_precomp.hpp"
+
+namespace cvtest
+{
+
+using std::tr1::tuple;
+using std::tr1::get;
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::dnn;
+
+//allocates the layer and measures its forward pass
+#define DNN_LAYER_PERF_CYCLE(layer, inputs, outputs) \
+    layer->allocate(inputs, outputs); \
+    declare.tbb_threads(cv::getNumThreads()); \
+    TEST_CYCLE_N(10) \
+    { \
+        layer->forward(inputs, outputs); \
+    } \
+    SANITY_CHECK_NOTHING()
+
+static const BlobShape layerShapes[] = {
+    BlobShape(1, 96, 55, 55),
+    BlobShape(1, 256, 27, 27),
+    BlobShape(8, 64, 56, 56)
+};
+
+typedef TestBaseWithParam<tuple<BlobShape, int, DNNTarget> > PoolingPerfTest;
+PERF_TEST_P(PoolingPerfTest, perf, Combine(
+    ValuesIn(layerShapes),
+    Values((int)PoolingLayer::MAX, (int)PoolingLayer::AVE),
+    DNNTarget::all())
+)
+{
+    DNNTargetScope target(get<2>(GetParam()));
+    std::vector<Blob> blobs, outputs;
+    std::vector<Blob*> inputs;
+    fillInputs(std::vector<BlobShape>(1, get<0>(GetParam())), blobs, inputs);
+
+    Ptr<Layer> layer = PoolingLayer::create(get<1>(GetParam()), Size(3, 3), Size(2, 2));
+    DNN_LAYER_PERF_CYCLE(layer, inputs, outputs);
+}
+
+typedef TestBaseWithParam<tuple<BlobShape, int, DNNTarget> > LRNPerfTest;
+PERF_TEST_P(LRNPerfTest, perf, Combine(
+    ValuesIn(layerShapes),
+    Values((int)LRNLayer::CHANNEL_NRM, (int)LRNLayer::SPATIAL_NRM),
+    DNNTarget::all())
+)
+{
+    DNNTargetScope target(get<2>(GetParam()));
+    std::vector<Blob> blobs, outputs;
+    std::vector<Blob*> inputs;
+    fillInputs(std::vector<BlobShape>(1, get<0>(GetParam())), blobs, inputs);
+
+    Ptr<Layer> layer = LRNLayer::create(get<1>(GetParam()), 5, 1e-4, 0.75);
+    DNN_LAYER_PERF_CYCLE(layer, inputs, outputs);
+}
+
+typedef TestBaseWithParam<tuple<BlobShape, DNNTarget> > SoftmaxPerfTest;
+PERF_TEST_P(SoftmaxPerfTest, perf, Combine(
+    Values(BlobShape(1, 1000), BlobShape(32, 1000), BlobShape(1, 21, 300, 300)),
+    DNNTarget::all())
+)
+{
+    DNNTargetScope target(get<1>(GetParam()));
+    std::vector<Blob> blobs, outputs;
+    std::vector<Blob*> inputs;
+    fillInputs(std::vector<BlobShape>(1, get<0>(GetParam())), blobs, inputs);
+
+    Ptr<Layer> layer = SoftmaxLayer::create(1);
+    DNN_LAYER_PERF_CYCLE(layer, inputs, outputs);
+}
+
+typedef TestBaseWithParam<tuple<BlobShape, int, DNNTarget> > EltwisePerfTest;
+PERF_TEST_P(EltwisePerfTest, perf, Combine(
+    ValuesIn(layerShapes),
+    Values((int)EltwiseLayer::SUM, (int)EltwiseLayer::PROD, (int)EltwiseLayer::MAX),
+    DNNTarget::all())
+)
+{
+    DNNTargetScope target(get<2>(GetParam()));
+    std::vector<Blob> blobs, outputs;
+    std::vector<Blob*> inputs;
+    fillInputs(std::vector<BlobShape>(2, get<0>(GetParam())), blobs, inputs);
+
+    Ptr<Layer> layer = EltwiseLayer::create((EltwiseLayer::EltwiseOp)get<1>(GetParam()), std::vector<int>());
+    DNN_LAYER_PERF_CYCLE(layer, inputs, outputs);
+}
+
+typedef TestBaseWithParam<tuple<BlobShape, int, DNNTarget> > ConcatPerfTest;
+PERF_TEST_P(ConcatPerfTest, perf, Combine(
+    ValuesIn(layerShapes),
+    Values(2, 4),
+    DNNTarget::all())
+)
+{
+    DNNTargetScope target(get<2>(GetParam()));
+    std::vector<Blob> blobs, outputs;
+    std::vector<Blob*> inputs;
+    fillInputs(std::vector<BlobShape>(get<1>(GetParam()), get<0>(GetParam())), blobs, inputs);
+
+    Ptr<Layer> layer = ConcatLayer::create(1);
+    DNN_LAYER_PERF_CYCLE(layer, inputs, outputs);
+}
+
+}
@@ -0,0 +1,97 @@
+#include "perf_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::dnn;
+
+typedef TestBaseWithParam<DNNTarget> NetPerfTest;
+
+#if defined(ENABLE_CAFFE_MODEL_TESTS)
+
+static Net readCaffeNet(const String &prototxt, const String &caffeModel)
+{
+    Net net;
+    Ptr<Importer> importer = createCaffeImporter(TestBase::getDataPath("dnn/" + prototxt),
+                                                 TestBase::getDataPath("dnn/" + caffeModel));
+    CV_Assert(importer != NULL);
+    importer->populateNet(net);
+    return net;
+}
+
+//measures forward pass of the whole network on the random input, the first pass allocates the network
+#define DNN_NET_PERF_CYCLE(net, inputShape) \
+    { \
+        std::vector<Blob> blobs; \
+        std::vector<Blob*> ptrs; \
+        fillInputs(std::vector<BlobShape>(1, inputShape), blobs, ptrs); \
+        cv::setNumThreads(cv::getNumberOfCPUs()); \
+        net.setBlob(".data", blobs[0]); \
+        net.forward(); /*allocation*/ \
+        declare.tbb_threads(cv::getNumThreads()); \
+        TEST_CYCLE_N(10) \
+        { \
+            net.forward(); \
+        } \
+    } \
+    SANITY_CHECK_NOTHING()
+
+PERF_TEST_P(NetPerfTest, AlexNet, DNNTarget::all())
+{
+    DNNTargetScope target(GetParam());
+    Net net = readCaffeNet("bvlc_alexnet.prototxt", "bvlc_alexnet.caffemodel");
+    DNN_NET_PERF_CYCLE(net, BlobShape(1, 3, 227, 227));
+}
+
+PERF_TEST_P(NetPerfTest, GoogLeNet, DNNTarget::all())
+{
+    DNNTargetScope target(GetParam());
+    Net net = readCaffeNet("bvlc_googlenet.prototxt", "bvlc_googlenet.caffemodel");
+    DNN_NET_PERF_CYCLE(net, BlobShape(1, 3, 224, 224));
+}
+
+PERF_TEST_P(NetPerfTest, SSD, DNNTarget::all())
+{
+    DNNTargetScope target(GetParam());
+    Net net = readCaffeNet("ssd_vgg16.prototxt", "VGG_ILSVRC2016_SSD_300x300_iter_440000.caffemodel");
+    DNN_NET_PERF_CYCLE(net, BlobShape(1, 3, 300, 300));
+}
+
+#endif
+
+//LSTM layer with random weights, 25 time steps over 512-dimensional input
+PERF_TEST_P(NetPerfTest, LSTM, DNNTarget::all())
+{
+    DNNTargetScope target(GetParam());
+    const int numInp = 512, numOut = 512, numTimeStamps = 25;
+
+    RNG rng(0);
+    Blob Wh(BlobShape(4*numOut, numOut)), Wx(BlobShape(4*numOut, numInp)), b(BlobShape(1, 4*numOut));
+    rng.fill(Wh.matRef(), RNG::UNIFORM, -0.1, 0.1);
+    rng.fill(Wx.matRef(), RNG::UNIFORM, -0.1, 0.1);
+    rng.fill(b.matRef(), RNG::UNIFORM, -0.1, 0.1);
+
+    Ptr<LSTMLayer> layer = LSTMLayer::create();
+    layer->setWeights(Wh, Wx, b);
+
+    std::vector<Blob> blobs, outputs;
+    std::vector<Blob*> inputs;
+    fillInputs(std::vector<BlobShape>(1, BlobShape(numTimeStamps, 1, numInp)), blobs, inputs);
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    layer->allocate(inputs, outputs);
+    declare.tbb_threads(cv::getNumThreads());
+
+    TEST_CYCLE_N(10)
+    {
+        layer->resetState();
+        layer->forward(inputs, outputs);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}
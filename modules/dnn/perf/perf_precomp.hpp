@@ -13,5 +13,7 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/dnn.hpp>
+#include <opencv2/core/ocl.hpp>
+#include "perf_common.hpp"
 
 #endif
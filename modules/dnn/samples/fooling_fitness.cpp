@@ -0,0 +1,154 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+// Evolves an image that the LeNet of the dnns_easily_fooled module classifies as a chosen digit with high
+// confidence. The whole population of a generation is evaluated by one batched forward pass.
+
+#include <opencv2/dnn.hpp>
+#include <opencv2/core/ocl.hpp>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include <opencv2/highgui.hpp>
+using namespace cv;
+using namespace cv::dnn;
+
+#include <algorithm>
+#include <iostream>
+#include <cstdlib>
+using namespace std;
+
+const char* keys =
+    "{ help h     |                                              | print this message }"
+    "{ proto      | ../../dnns_easily_fooled/model/lenet/lenet_deploy.prototxt | deploy prototxt of the classifier }"
+    "{ model      | ../../dnns_easily_fooled/model/lenet/lenet_iter_10000     | trained weights of the classifier }"
+    "{ target     | 0                                            | class the images are evolved towards }"
+    "{ population | 256                                          | images of a generation, all evaluated in one batch }"
+    "{ generations| 200                                          | number of generations }"
+    "{ mutations  | 20                                           | pixels changed by a mutation }"
+    "{ opencl     |                                              | run the layers with OpenCL if it is available }"
+    "{ output     | fooling.png                                  | where the best image is saved }";
+
+// Mutated copies of the parent image, converted to the scaled float input planes of the batch
+class MutateInvoker : public ParallelLoopBody
+{
+public:
+    MutateInvoker(const Mat& _parent, int _mutations, uint64 _seed, vector<Mat>& _children, Mat& _batch)
+        : parent(_parent), mutations(_mutations), seed(_seed), children(_children), batch(_batch)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            // one generator per child keeps the population independent of the threads
+            RNG rng(seed + (uint64)i);
+            parent.copyTo(children[i]);
+            for (int k = 0; k < mutations; k++)
+                children[i].at<uchar>(rng.uniform(0, parent.rows), rng.uniform(0, parent.cols)) = (uchar)rng.uniform(0, 256);
+
+            // the scale of the input layer the net was trained with
+            Mat plane(parent.size(), CV_32F, batch.ptr<float>(i));
+            children[i].convertTo(plane, CV_32F, 1./256);
+        }
+    }
+
+private:
+    const Mat& parent;
+    int mutations;
+    uint64 seed;
+    vector<Mat>& children;
+    Mat& batch;
+
+    MutateInvoker& operator=(const MutateInvoker&); // to quiet MSVC
+};
+
+// Confidences of the target class of the whole population at once
+static void evaluate(Net& net, const Mat& batch, Size size, bool opencl, int target, vector<float>& fitness)
+{
+    const int shape[] = { batch.rows, 1, size.height, size.width };
+    Mat input(4, shape, CV_32F, (void*)batch.data);
+    if (opencl)
+    {
+        UMat uinput;
+        input.copyTo(uinput);
+        net.setBlob(".data", Blob(uinput));
+    }
+    else
+        net.setBlob(".data", Blob(input));
+    net.forward();
+
+    Mat prob = net.getBlob("prob").matRefConst().reshape(1, batch.rows);
+    fitness.resize(batch.rows);
+    for (int i = 0; i < batch.rows; i++)
+        fitness[i] = prob.at<float>(i, target);
+}
+
+int main(int argc, char** argv)
+{
+    CommandLineParser parser(argc, argv, keys);
+    parser.about("Batched fitness evaluation of fooling images with the dnn module");
+    if (parser.has("help"))
+    {
+        parser.printMessage();
+        return 0;
+    }
+    String proto = parser.get<String>("proto");
+    String model = parser.get<String>("model");
+    int target = parser.get<int>("target");
+    int population = parser.get<int>("population");
+    int generations = parser.get<int>("generations");
+    int mutations = parser.get<int>("mutations");
+    bool opencl = parser.has("opencl") && ocl::haveOpenCL();
+    String output = parser.get<String>("output");
+    if (!parser.check() || population < 1)
+    {
+        parser.printErrors();
+        return -1;
+    }
+
+    cv::dnn::initModule();  //Required if OpenCV is built as static libs
+    ocl::setUseOpenCL(opencl);
+    Net net = dnn::readNetFromCaffe(proto, model);
+    if (net.empty())
+    {
+        cerr << "Can't load network by using the following files: " << endl;
+        cerr << "prototxt:   " << proto << endl;
+        cerr << "caffemodel: " << model << endl;
+        return -1;
+    }
+    cout << "Evaluating " << population << " images per batch" << (opencl ? " with OpenCL" : "") << endl;
+
+    const Size size(28, 28);
+    RNG rng;
+    Mat parent(size, CV_8U);
+    rng.fill(parent, RNG::UNIFORM, 0, 256);
+    float parentFitness = 0;
+
+    vector<Mat> children(population);
+    Mat batch(population, size.area(), CV_32F);
+    vector<float> fitness;
+    TickMeter timer;
+    for (int g = 0; g < generations; g++)
+    {
+        timer.start();
+        parallel_for_(Range(0, population),
+                      MutateInvoker(parent, mutations, (uint64)g * population + 1, children, batch));
+        evaluate(net, batch, size, opencl, target, fitness);
+        timer.stop();
+
+        int best = (int)(max_element(fitness.begin(), fitness.end()) - fitness.begin());
+        if (fitness[best] > parentFitness)
+        {
+            children[best].copyTo(parent);
+            parentFitness = fitness[best];
+        }
+        if (g % 10 == 0 || g == generations - 1)
+            cout << "generation " << g << ": confidence " << parentFitness << endl;
+    }
+
+    cout << "evaluations per second: " << population * generations / timer.getTimeSec() << endl;
+    imwrite(output, parent);
+    return 0;
+}
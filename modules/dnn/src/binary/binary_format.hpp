@@ -0,0 +1,99 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#ifndef __OPENCV_DNN_BINARY_FORMAT_HPP__
+#define __OPENCV_DNN_BINARY_FORMAT_HPP__
+#include "../precomp.hpp"
+
+namespace cv
+{
+namespace dnn
+{
+namespace binary
+{
+
+/* Layout of the native serialized network file:
+ *
+ * [FileHeader][topology section][padding][data section]
+ *
+ * The topology section contains the names of the network inputs and the description of each layer:
+ * name, type, parameters, connections and headers of the learned blobs.
+ * The data section contains raw payloads of the learned blobs, each payload is DATA_ALIGNMENT-aligned,
+ * and the section itself starts at PAGE_ALIGNMENT boundary, so the whole section can be mapped into memory
+ * and the blobs can refer to the mapped pages directly.
+ */
+enum
+{
+    VERSION = 1,
+    ENDIANNESS_TAG = 0x01020304,
+    DATA_ALIGNMENT = 64,
+    PAGE_ALIGNMENT = 4096
+};
+
+struct FileHeader
+{
+    char magic[8];          //"CVDNNBIN"
+    int version;
+    int endiannessTag;
+    uint64 topologyOffset;
+    uint64 topologySize;
+    uint64 dataOffset;
+    uint64 dataSize;
+};
+
+//! Description of the layer to be serialized.
+struct LayerRecord
+{
+    String name;
+    String type;
+    const LayerParams *params;
+    const std::vector<Blob> *blobs;
+    //pairs of (index of the source layer record, output number), index 0 is reserved for network inputs
+    std::vector<std::pair<int, int> > inputs;
+};
+
+//! Writes the network, described by @p netInputs and @p layers, into the file.
+void writeNet(const String &path, const std::vector<String> &netInputs, const std::vector<LayerRecord> &layers);
+
+}
+}
+}
+#endif
@@ -0,0 +1,567 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "../precomp.hpp"
+#include "binary_format.hpp"
+#include <fstream>
+#include <cstring>
+
+#if defined _WIN32
+#  ifndef NOMINMAX
+#    define NOMINMAX
+#  endif
+#  include <windows.h>
+#  define DNN_BINARY_USE_WIN32_MAPPING 1
+#elif defined __unix__ || defined __APPLE__
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  define DNN_BINARY_USE_MMAP 1
+#endif
+
+namespace cv
+{
+namespace dnn
+{
+namespace binary
+{
+
+static const char fileMagic[8] = {'C', 'V', 'D', 'N', 'N', 'B', 'I', 'N'};
+
+enum ParamKind
+{
+    PARAM_INT = 0,
+    PARAM_REAL = 1,
+    PARAM_STRING = 2
+};
+
+class TopologyWriter
+{
+public:
+
+    void writeRaw(const void *data, size_t size)
+    {
+        const uchar *p = (const uchar*)data;
+        buf.insert(buf.end(), p, p + size);
+    }
+
+    template<typename T>
+    void write(const T &v)
+    {
+        writeRaw(&v, sizeof(T));
+    }
+
+    void writeString(const String &s)
+    {
+        write((int)s.size());
+        writeRaw(s.c_str(), s.size());
+    }
+
+    void writeParam(const String &key, const DictValue &v)
+    {
+        writeString(key);
+        int size = v.size();
+
+        if (v.isInt())
+        {
+            write((int)PARAM_INT);
+            write(size);
+            for (int i = 0; i < size; i++)
+                write(v.get<int64>(i));
+        }
+        else if (v.isReal())
+        {
+            write((int)PARAM_REAL);
+            write(size);
+            for (int i = 0; i < size; i++)
+                write(v.get<double>(i));
+        }
+        else if (v.isString())
+        {
+            write((int)PARAM_STRING);
+            write(size);
+            for (int i = 0; i < size; i++)
+                writeString(v.get<String>(i));
+        }
+        else
+        {
+            CV_Error(Error::StsNotImplemented, "Unsupported type of parameter \"" + key + "\"");
+        }
+    }
+
+    const std::vector<uchar> &data() const { return buf; }
+
+private:
+    std::vector<uchar> buf;
+};
+
+class TopologyReader
+{
+public:
+
+    TopologyReader(const uchar *data, size_t size) : ptr(data), end(data + size) {}
+
+    const uchar *readRaw(size_t size)
+    {
+        if ((size_t)(end - ptr) < size)
+            CV_Error(Error::StsParseError, "Unexpected end of the network topology");
+        const uchar *p = ptr;
+        ptr += size;
+        return p;
+    }
+
+    template<typename T>
+    T read()
+    {
+        T v;
+        memcpy(&v, readRaw(sizeof(T)), sizeof(T));
+        return v;
+    }
+
+    int readCount()
+    {
+        int n = read<int>();
+        if (n < 0)
+            CV_Error(Error::StsParseError, "Corrupted network topology");
+        return n;
+    }
+
+    String readString()
+    {
+        int len = readCount();
+        const char *p = (const char*)readRaw(len);
+        return String(p, p + len);
+    }
+
+    void readParam(LayerParams &params)
+    {
+        String key = readString();
+        int kind = read<int>();
+        int size = readCount();
+
+        if (kind == PARAM_INT)
+        {
+            std::vector<int64> vals(size);
+            for (int i = 0; i < size; i++)
+                vals[i] = read<int64>();
+            params.set(key, DictValue::arrayInt(vals.begin(), size));
+        }
+        else if (kind == PARAM_REAL)
+        {
+            std::vector<double> vals(size);
+            for (int i = 0; i < size; i++)
+                vals[i] = read<double>();
+            params.set(key, DictValue::arrayReal(vals.begin(), size));
+        }
+        else if (kind == PARAM_STRING)
+        {
+            std::vector<String> vals(size);
+            for (int i = 0; i < size; i++)
+                vals[i] = readString();
+            params.set(key, DictValue::arrayString(vals.begin(), size));
+        }
+        else
+        {
+            CV_Error(Error::StsParseError, "Unknown type of parameter \"" + key + "\"");
+        }
+    }
+
+private:
+    const uchar *ptr, *end;
+};
+
+void writeNet(const String &path, const std::vector<String> &netInputs, const std::vector<LayerRecord> &layers)
+{
+    TopologyWriter topology;
+    std::vector<Mat> payloads;
+    std::vector<uint64> payloadOffsets;
+    uint64 dataSize = 0;
+
+    topology.write((int)netInputs.size());
+    for (size_t i = 0; i < netInputs.size(); i++)
+        topology.writeString(netInputs[i]);
+
+    topology.write((int)layers.size());
+    for (size_t li = 0; li < layers.size(); li++)
+    {
+        const LayerRecord &rec = layers[li];
+        topology.writeString(rec.name);
+        topology.writeString(rec.type);
+
+        const LayerParams &params = *rec.params;
+        topology.write((int)std::distance(params.begin(), params.end()));
+        for (Dict::const_iterator it = params.begin(); it != params.end(); it++)
+            topology.writeParam(it->first, it->second);
+
+        topology.write((int)rec.inputs.size());
+        for (size_t i = 0; i < rec.inputs.size(); i++)
+        {
+            topology.write(rec.inputs[i].first);
+            topology.write(rec.inputs[i].second);
+        }
+
+        const std::vector<Blob> &blobs = *rec.blobs;
+        topology.write((int)blobs.size());
+        for (size_t i = 0; i < blobs.size(); i++)
+        {
+            Mat m = blobs[i].matRefConst();
+            if (!m.isContinuous())
+                m = m.clone();
+
+            uint64 bytes = (uint64)(m.total() * m.elemSize());
+            topology.write(m.type());
+            topology.write(m.dims);
+            for (int d = 0; d < m.dims; d++)
+                topology.write(m.size[d]);
+            topology.write(dataSize);
+            topology.write(bytes);
+
+            payloads.push_back(m);
+            payloadOffsets.push_back(dataSize);
+            dataSize = alignSize((size_t)(dataSize + bytes), DATA_ALIGNMENT);
+        }
+    }
+
+    FileHeader header;
+    memcpy(header.magic, fileMagic, sizeof(fileMagic));
+    header.version = VERSION;
+    header.endiannessTag = ENDIANNESS_TAG;
+    header.topologyOffset = sizeof(FileHeader);
+    header.topologySize = topology.data().size();
+    header.dataOffset = alignSize((size_t)(header.topologyOffset + header.topologySize), PAGE_ALIGNMENT);
+    header.dataSize = dataSize;
+
+    std::ofstream fs(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!fs.is_open())
+        CV_Error(Error::StsError, "Can't open \"" + path + "\" for writing");
+
+    const char zeros[PAGE_ALIGNMENT] = {0};
+    uint64 pos = 0;
+
+    fs.write((const char*)&header, sizeof(header));
+    if (header.topologySize)
+        fs.write((const char*)&topology.data()[0], header.topologySize);
+    pos = header.topologyOffset + header.topologySize;
+
+    for (size_t i = 0; i < payloads.size(); i++)
+    {
+        uint64 offset = header.dataOffset + payloadOffsets[i];
+        fs.write(zeros, offset - pos);
+        size_t bytes = payloads[i].total() * payloads[i].elemSize();
+        fs.write((const char*)payloads[i].data, bytes);
+        pos = offset + bytes;
+    }
+    fs.write(zeros, header.dataOffset + header.dataSize - pos);
+
+    if (!fs)
+        CV_Error(Error::StsError, "Can't write the network into \"" + path + "\"");
+}
+
+//! Read-only view of the file, which memory pages are mapped in copy-on-write mode.
+class MappedFile
+{
+public:
+
+    explicit MappedFile(const String &path) : ptr(NULL), length(0)
+    {
+#if defined DNN_BINARY_USE_WIN32_MAPPING
+        mapping = NULL;
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+            CV_Error(Error::StsError, "Can't open \"" + path + "\"");
+
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+        {
+            length = (size_t)fileSize.QuadPart;
+            mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+            if (mapping)
+                ptr = (uchar*)MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+        }
+        if (!ptr)
+        {
+            release();
+            CV_Error(Error::StsError, "Can't map \"" + path + "\" into memory");
+        }
+#elif defined DNN_BINARY_USE_MMAP
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            CV_Error(Error::StsError, "Can't open \"" + path + "\"");
+
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            length = (size_t)st.st_size;
+            //private writable mapping: pages are shared through the page cache until somebody modifies them
+            void *p = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            ptr = (p != MAP_FAILED) ? (uchar*)p : NULL;
+        }
+        close(fd);
+
+        if (!ptr)
+            CV_Error(Error::StsError, "Can't map \"" + path + "\" into memory");
+#else
+        std::ifstream fs(path.c_str(), std::ios::in | std::ios::binary);
+        if (!fs.is_open())
+            CV_Error(Error::StsError, "Can't open \"" + path + "\"");
+
+        fs.seekg(0, std::ios::end);
+        length = (size_t)fs.tellg();
+        fs.seekg(0, std::ios::beg);
+        buffer.allocate(length);
+        ptr = (uchar*)buffer;
+        fs.read((char*)ptr, length);
+        if (!fs)
+            CV_Error(Error::StsError, "Can't read \"" + path + "\"");
+#endif
+    }
+
+    ~MappedFile()
+    {
+        release();
+    }
+
+    uchar *data() const { return ptr; }
+    size_t size() const { return length; }
+
+private:
+
+    void release()
+    {
+#if defined DNN_BINARY_USE_WIN32_MAPPING
+        if (ptr)
+            UnmapViewOfFile(ptr);
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#elif defined DNN_BINARY_USE_MMAP
+        if (ptr)
+            munmap(ptr, length);
+#endif
+        ptr = NULL;
+        length = 0;
+    }
+
+    uchar *ptr;
+    size_t length;
+
+#if defined DNN_BINARY_USE_WIN32_MAPPING
+    HANDLE file, mapping;
+#elif !defined DNN_BINARY_USE_MMAP
+    AutoBuffer<uchar, 1> buffer;
+#endif
+
+    MappedFile(const MappedFile&);
+    MappedFile &operator=(const MappedFile&);
+};
+
+/* Allocator of Mat headers which refer into the mapped file.
+ * Each header holds a reference to the file, so the mapping is alive until the last blob is released.
+ * New allocations (e.g. Mat::create() over such headers) are forwarded to the default allocator.
+ */
+class MappedFileAllocator : public MatAllocator
+{
+public:
+
+    UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, int flags, UMatUsageFlags usageFlags) const
+    {
+        return Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(UMatData* u, int accessFlags, UMatUsageFlags usageFlags) const
+    {
+        return Mat::getStdAllocator()->allocate(u, accessFlags, usageFlags);
+    }
+
+    void deallocate(UMatData* u) const
+    {
+        if (!u)
+            return;
+
+        CV_Assert(u->urefcount == 0 && u->refcount == 0);
+        delete (Ptr<MappedFile>*)u->userdata;
+        u->userdata = NULL;
+        delete u;
+    }
+
+    Mat wrap(const Ptr<MappedFile> &file, size_t offset, int dims, const int *sizes, int type) const
+    {
+        uchar *data = file->data() + offset;
+        Mat m(dims, sizes, type, data);
+
+        UMatData *u = new UMatData(this);
+        u->data = u->origdata = data;
+        u->size = m.total() * m.elemSize();
+        u->userdata = new Ptr<MappedFile>(file);
+        u->refcount = 1;
+
+        m.allocator = (MatAllocator*)this;
+        m.u = u;
+        return m;
+    }
+
+    static MappedFileAllocator *getInstance()
+    {
+        static MappedFileAllocator instance;
+        return &instance;
+    }
+};
+
+class BinaryImporter : public Importer
+{
+public:
+
+    BinaryImporter(const String &path) : file(new MappedFile(path))
+    {
+        if (file->size() < sizeof(FileHeader))
+            CV_Error(Error::StsParseError, "\"" + path + "\" isn't a network file");
+
+        memcpy(&header, file->data(), sizeof(FileHeader));
+        if (memcmp(header.magic, fileMagic, sizeof(fileMagic)) != 0)
+            CV_Error(Error::StsParseError, "\"" + path + "\" isn't a network file");
+        if (header.endiannessTag != ENDIANNESS_TAG)
+            CV_Error(Error::StsNotImplemented, "\"" + path + "\" was written on a machine with different byte order");
+        if (header.version != VERSION)
+            CV_Error(Error::StsNotImplemented, "Unsupported version of the network file \"" + path + "\"");
+
+        uint64 fileSize = file->size();
+        if (header.topologyOffset > fileSize || header.topologySize > fileSize - header.topologyOffset ||
+            header.dataOffset > fileSize || header.dataSize > fileSize - header.dataOffset ||
+            header.dataOffset % PAGE_ALIGNMENT != 0)
+            CV_Error(Error::StsParseError, "Network file \"" + path + "\" is corrupted");
+    }
+
+    void populateNet(Net net)
+    {
+        TopologyReader reader(file->data() + header.topologyOffset, (size_t)header.topologySize);
+
+        std::vector<String> netInputs(reader.readCount());
+        for (size_t i = 0; i < netInputs.size(); i++)
+            netInputs[i] = reader.readString();
+        net.setNetInputs(netInputs);
+
+        int numLayers = reader.readCount();
+        std::vector<int> ids(numLayers + 1, 0);
+        std::vector<std::vector<std::pair<int, int> > > inputs(numLayers + 1);
+
+        for (int li = 1; li <= numLayers; li++)
+        {
+            String name = reader.readString();
+            String type = reader.readString();
+            LayerParams params;
+
+            int numParams = reader.readCount();
+            for (int i = 0; i < numParams; i++)
+                reader.readParam(params);
+
+            inputs[li].resize(reader.readCount());
+            for (size_t i = 0; i < inputs[li].size(); i++)
+            {
+                inputs[li][i].first = reader.read<int>();
+                inputs[li][i].second = reader.read<int>();
+                if (inputs[li][i].first < 0 || inputs[li][i].first > numLayers)
+                    CV_Error(Error::StsParseError, "Invalid input of layer \"" + name + "\"");
+            }
+
+            params.blobs.resize(reader.readCount());
+            for (size_t i = 0; i < params.blobs.size(); i++)
+                params.blobs[i] = readBlob(reader);
+
+            ids[li] = net.addLayer(name, type, params);
+        }
+
+        for (int li = 1; li <= numLayers; li++)
+        {
+            for (size_t i = 0; i < inputs[li].size(); i++)
+                net.connect(ids[inputs[li][i].first], inputs[li][i].second, ids[li], (int)i);
+        }
+    }
+
+private:
+
+    Blob readBlob(TopologyReader &reader)
+    {
+        int type = reader.read<int>();
+        int dims = reader.readCount();
+        CV_Assert(dims <= CV_MAX_DIM);
+
+        std::vector<int> sizes(std::max(dims, 1));
+        size_t total = (dims > 0) ? 1 : 0;
+        for (int d = 0; d < dims; d++)
+        {
+            sizes[d] = reader.readCount();
+            total *= sizes[d];
+        }
+        uint64 offset = reader.read<uint64>();
+        uint64 bytes = reader.read<uint64>();
+
+        if (type != CV_MAT_TYPE(type) || bytes != total * CV_ELEM_SIZE(type) || offset > header.dataSize || bytes > header.dataSize - offset)
+            CV_Error(Error::StsParseError, "Invalid blob in the network file");
+        if (total == 0)
+            return Blob();
+
+        return Blob(MappedFileAllocator::getInstance()->wrap(file, (size_t)(header.dataOffset + offset), dims, &sizes[0], type));
+    }
+
+    Ptr<MappedFile> file;
+    FileHeader header;
+};
+
+}
+
+Ptr<Importer> createBinaryImporter(const String &path)
+{
+    return Ptr<Importer>(new binary::BinaryImporter(path));
+}
+
+Net readNetFromBinary(const String &path)
+{
+    Net net;
+    createBinaryImporter(path)->populateNet(net);
+    return net;
+}
+
+}
+}
@@ -41,6 +41,7 @@
 
 #include "precomp.hpp"
 #include <opencv2/dnn/shape_utils.hpp>
+#include "layers/op_fp16.hpp"
 
 namespace cv
 {
@@ -76,16 +77,37 @@ Blob::Blob(InputArray data)
 #endif
 }
 
+//like std::vector, keeps the buffer if it isn't shared with other arrays and is large enough for the new shape
+static void createKeepingCapacity(Mat &m, const BlobShape &shape, int type)
+{
+    UMatData *u = m.u;
+    size_t bytes = shape.total() * CV_ELEM_SIZE(type);
+
+    bool sameHeader = m.dims == shape.dims() && m.type() == type && shape == BlobShape(m.dims, m.size.p);
+    bool exclusive = u && u->refcount == 1 && u->urefcount == 0 && m.datastart == u->data;
+
+    if (!sameHeader && exclusive && shape.dims() > 0 && 0 < bytes && bytes <= u->size)
+    {
+        Mat res(shape.dims(), shape.ptr(), type, u->data);
+        CV_XADD(&u->refcount, 1);
+        res.u = u; //the header owns the existing buffer now
+        m = res;
+        return;
+    }
+
+    m.create(shape.dims(), shape.ptr(), type);
+}
+
 void Blob::create(const BlobShape &shape, int type, int allocFlags)
 {
 #ifndef CV_DNN_UMAT
     CV_Assert(allocFlags & ALLOC_MAT);
-    m.create(shape.dims(), shape.ptr(), type);
+    createKeepingCapacity(m, shape, type);
 #else
     CV_Assert(allocFlags & ALLOC_MAT || allocFlags & ALLOC_UMAT);
 
     if (allocFlags & ALLOC_MAT)
-        m.create(shape.dims(), shape.ptr(), type);
+        createKeepingCapacity(m, shape, type);
     if (allocFlags & ALLOC_UMAT)
         um.create(shape.dims(), shape.ptr(), type);
 
@@ -324,6 +346,7 @@ void Blob::updateUMat(bool syncData) const
             m.copyTo(um);
         else
             um.create(dims(), sizes(), type());
+        state = SYNCED;
     }
     else
     {
@@ -340,6 +363,22 @@ void Blob::sync() const
     updateUMat();
 }
 
+Blob Blob::toHalf() const
+{
+    CV_Assert(type() == CV_32F);
+    Mat res;
+    fp16::fromFloat(matRefConst(), res);
+    return Blob(res);
+}
+
+Blob Blob::toFloat() const
+{
+    CV_Assert(type() == fp16::TYPE);
+    Mat res;
+    fp16::toFloat(matRefConst(), res);
+    return Blob(res);
+}
+
 Vec4i Blob::shape4() const
 {
     return Vec4i(num(), channels(), rows(), cols());
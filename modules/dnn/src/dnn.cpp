@@ -40,6 +40,11 @@
 //M*/
 
 #include "precomp.hpp"
+#include "layers/layers_common.hpp"
+#include "layers/op_blas.hpp"
+#include "binary/binary_format.hpp"
+#include <opencv2/dnn/all_layers.hpp>
+#include <opencv2/core/ocl.hpp>
 #include <set>
 #include <algorithm>
 #include <iostream>
@@ -86,11 +91,33 @@ struct LayerPin
     }
 };
 
+//identifies the input blob, which was given to Layer::allocate()
+struct BlobSignature
+{
+    BlobSignature(const Blob &blob) : shape(blob.shape()), type(blob.type()), data(NULL)
+    {
+        int state = blob.getState();
+        if (state & Blob::HEAD_AT_MAT)
+            data = blob.matRefConst().data;
+        else if (state & Blob::HEAD_AT_UMAT)
+            data = blob.umatRefConst().u;
+    }
+
+    bool operator==(const BlobSignature &r) const
+    {
+        return shape == r.shape && type == r.type && data == r.data;
+    }
+
+    BlobShape shape;
+    int type;
+    const void *data;
+};
+
 struct LayerData
 {
-    LayerData() {}
+    LayerData() : skip(false), forwardTicks(0), forwardCalls(0) {}
     LayerData(int _id, const String &_name, const String &_type, LayerParams &_params)
-        : id(_id), name(_name), type(_type), params(_params)
+        : id(_id), name(_name), type(_type), params(_params), skip(false), forwardTicks(0), forwardCalls(0)
     {
         //add logging info
         params.name = name;
@@ -109,6 +136,14 @@ struct LayerData
     Ptr<Layer> layerInstance;
     std::vector<Blob> outputBlobs;
     std::vector<Blob*> inputBlobs;
+    std::vector<BlobSignature> allocatedInputs; //inputs of the last allocate() call
+
+    //layer computations were fused into the preceding layer, so forward() isn't called
+    bool skip;
+
+    //profiling statistics
+    int64 forwardTicks;
+    int forwardCalls;
 
     int flag;
 
@@ -144,6 +179,11 @@ struct DataLayer : public Layer
         outNames.assign(names.begin(), names.end());
     }
 
+    const std::vector<String> &getNames() const
+    {
+        return outNames;
+    }
+
 private:
     std::vector<String> outNames;
 };
@@ -162,6 +202,12 @@ struct Net::Impl
 
         lastLayerId = 1;
         netWasAllocated = false;
+        inputsReshaped = false;
+        reuseMemory = false;
+        calibrating = false;
+        profiling = false;
+        parallelBranches = false;
+        hostSyncCheck = false;
     }
 
     Ptr<DataLayer> netInputLayer;
@@ -174,16 +220,81 @@ struct Net::Impl
     int lastLayerId;
 
     bool netWasAllocated;
+    bool inputsReshaped;    //only shapes of the net inputs were changed since the allocation
+
+    bool reuseMemory;
+    Mat memoryArena;                    //shared storage for the output blobs, planned by planMemory()
+    std::vector<LayerPin> arenaBlobs;   //output blobs which were bound to the memoryArena
+
+    bool calibrating;
+    bool profiling;
+
+    bool parallelBranches;
+    std::vector<std::vector<int> > forwardLevels;
+    std::map<int, int> layerLevels;
+
+    bool hostSyncCheck;
+    String gemmBackend;
+    std::map<int, float> inputRanges;   //max absolute values of the inputs of int8 layers, collected during calibration
+
+    //copies the graph and shares the learned parameters of the source network, intermediate blobs aren't copied
+    void shareGraphFrom(Impl &src)
+    {
+        netInputLayer->setNames(src.netInputLayer->getNames());
+        layers[0].requiredOutputs = src.layers[0].requiredOutputs;
+
+        MapIdToLayerData::iterator it;
+        for (it = src.layers.begin(); it != src.layers.end(); it++)
+        {
+            LayerData &srcLd = it->second;
+            if (srcLd.id == 0)
+                continue;
+
+            LayerParams params = srcLd.params;
+            LayerData &ld = layers.insert(make_pair(srcLd.id, LayerData(srcLd.id, srcLd.name, srcLd.type, params))).first->second;
+            ld.inputBlobsId = srcLd.inputBlobsId;
+            ld.inputLayersId = srcLd.inputLayersId;
+            ld.requiredOutputs = srcLd.requiredOutputs;
+
+            //Blob copies refer to the same data, so the weights aren't duplicated
+            Ptr<Layer> layer = ld.getLayerInstance();
+            if (srcLd.layerInstance)
+                layer->blobs = srcLd.layerInstance->blobs;
+        }
+
+        layerNameToId = src.layerNameToId;
+        lastLayerId = src.lastLayerId;
+        reuseMemory = src.reuseMemory;
+        parallelBranches = src.parallelBranches;
+        hostSyncCheck = src.hostSyncCheck;
+        gemmBackend = src.gemmBackend;
+
+        inputRanges = src.inputRanges;
+        if (!inputRanges.empty())
+            setInt8Ranges(true);
+        netWasAllocated = false;
+    }
 
     void setUpNet()
     {
-        if (!netWasAllocated)
+        //the memory plan binds blobs of unchanged layers too, so it's rebuilt from scratch
+        if (!netWasAllocated || (inputsReshaped && reuseMemory))
         {
             allocateLayers();
             computeNetOutputLayers();
+            fuseLayers();
+            computeForwardLevels();
+
+            if (reuseMemory)
+                planMemory();
 
             netWasAllocated = true;
         }
+        else if (inputsReshaped)
+        {
+            allocateLayers(true);
+        }
+        inputsReshaped = false;
     }
 
     int getLayerId(const String &layerName)
@@ -339,7 +450,7 @@ struct Net::Impl
     #define CV_RETHROW_ERROR(err, newmsg)\
         cv::error(err.code, newmsg, err.func.c_str(), err.file.c_str(), err.line)
 
-    void allocateLayer(int lid)
+    void allocateLayer(int lid, bool onlyChanged)
     {
         LayerData &ld = layers[lid];
 
@@ -353,7 +464,7 @@ struct Net::Impl
 
         //allocate parents
         for (set<int>::iterator i = ld.inputLayersId.begin(); i != ld.inputLayersId.end(); i++)
-            allocateLayer(*i);
+            allocateLayer(*i, onlyChanged);
 
         //bind inputs
         ld.inputBlobs.resize(ld.inputBlobsId.size());
@@ -365,12 +476,30 @@ struct Net::Impl
             ld.inputBlobs[i] = &layers[from.lid].outputBlobs[from.oid];
         }
 
+        std::vector<BlobSignature> inputs;
+        for (size_t i = 0; i < ld.inputBlobs.size(); i++)
+            inputs.push_back(BlobSignature(*ld.inputBlobs[i]));
+
+        //outputs of the layer depend only on its inputs
+        if (onlyChanged && lid != 0 && ld.allocatedInputs == inputs && !ld.outputBlobs.empty())
+        {
+            ld.flag = 1;
+            return;
+        }
+
         //allocate layer
         ld.outputBlobs.resize(std::max((size_t)1, ld.requiredOutputs.size())); //layer produce at least one output blob
         try
         {
+            if (lid != 0)
+                detachSharedOutputs(ld);
+
             Ptr<Layer> layerPtr = ld.getLayerInstance();
+            Ptr<GemmBackendConfigurable> gemmLayer = layerPtr.dynamicCast<GemmBackendConfigurable>();
+            if (gemmLayer)
+                gemmLayer->setGemmBackend(gemmBackend);
             layerPtr->allocate(ld.inputBlobs, ld.outputBlobs);
+            ld.allocatedInputs = inputs;
         }
         catch (const cv::Exception &err)
         {
@@ -380,8 +509,47 @@ struct Net::Impl
         ld.flag = 1;
     }
 
-    void allocateLayers()
+    /* Releases outputs of not yet allocated layers (usually in-place ones), which share data with outputs of @p ld.
+     * So buffers of @p ld aren't referenced from outside and can be kept on reallocation, see Blob::create().
+     * Layers with released outputs are allocated anew, because their inputs change.
+     */
+    void detachSharedOutputs(LayerData &ld)
     {
+        for (size_t i = 0; i < ld.outputBlobs.size(); i++)
+        {
+            const Blob &out = ld.outputBlobs[i];
+            if (!(out.getState() & Blob::HEAD_AT_MAT) || out.matRefConst().empty())
+                continue;
+            const uchar *datastart = out.matRefConst().datastart;
+
+            MapIdToLayerData::iterator it;
+            for (it = layers.begin(); it != layers.end(); it++)
+            {
+                LayerData &other = it->second;
+                if (other.id == 0 || other.id == ld.id || other.flag)
+                    continue;
+
+                for (size_t j = 0; j < other.outputBlobs.size(); j++)
+                {
+                    const Blob &otherOut = other.outputBlobs[j];
+                    if ((otherOut.getState() & Blob::HEAD_AT_MAT) && otherOut.matRefConst().datastart == datastart)
+                    {
+                        other.outputBlobs[j] = Blob();
+                        other.allocatedInputs.clear();
+                    }
+                }
+            }
+        }
+    }
+
+    /* Allocates all layers in the topological order.
+     * If @p onlyChanged is true then layers, whose inputs have the same shapes and data as
+     * during the previous allocation, are skipped. It's used after reshape of the net inputs.
+     */
+    void allocateLayers(bool onlyChanged = false)
+    {
+        releaseMemoryPlan();
+
         MapIdToLayerData::iterator it;
         for (it = layers.begin(); it != layers.end(); it++)
             it->second.flag = 0;
@@ -389,10 +557,254 @@ struct Net::Impl
         for (it = layers.begin(); it != layers.end(); it++)
         {
             int lid = it->first;
-            allocateLayer(lid);
+            allocateLayer(lid, onlyChanged);
+        }
+    }
+
+    static bool sharesMatData(const Blob &a, const Blob &b)
+    {
+        if (!(a.getState() & Blob::HEAD_AT_MAT) || !(b.getState() & Blob::HEAD_AT_MAT))
+            return false;
+
+        const uchar *data = a.matRefConst().data;
+        return data != NULL && data == b.matRefConst().data;
+    }
+
+    /* Folds activation layers into the output stage of the preceding layers.
+     * Activation is fused if it's the only consumer of the previous layer's single output,
+     * and the previous layer is able to apply it in the current mode (see ActivationFusable).
+     */
+    void fuseLayers()
+    {
+        MapIdToLayerData::iterator it;
+        std::map<int, int> consumersCount;
+        for (it = layers.begin(); it != layers.end(); it++)
+        {
+            LayerData &ld = it->second;
+            ld.skip = false;
+
+            Ptr<ActivationFusable> fusable = ld.layerInstance.dynamicCast<ActivationFusable>();
+            if (fusable)
+                fusable->setActivation(Ptr<ActivationFunction>());
+
+            for (size_t i = 0; i < ld.inputBlobsId.size(); i++)
+                consumersCount[ld.inputBlobsId[i].lid]++;
+        }
+
+        for (it = layers.begin(); it != layers.end(); it++)
+        {
+            LayerData &ld = it->second;
+            Ptr<ActivationFunction> activ = ld.layerInstance.dynamicCast<ActivationFunction>();
+            if (!activ || ld.inputBlobsId.size() != 1)
+                continue;
+
+            LayerPin from = ld.inputBlobsId[0];
+            LayerData &prev = layers[from.lid];
+            if (from.lid == 0 || prev.skip || prev.outputBlobs.size() != 1 || consumersCount[from.lid] != 1)
+                continue;
+
+            Ptr<ActivationFusable> fusable = prev.layerInstance.dynamicCast<ActivationFusable>();
+            if (!fusable || !sharesMatData(ld.outputBlobs[0], prev.outputBlobs[0]))
+                continue; //activation doesn't work in-place over CPU output of the previous layer
+
+            if (fusable->setActivation(activ))
+                ld.skip = true;
         }
     }
 
+    //the same traversal as forwardAll() does, but without computations
+    void computeForwardOrder(LayerData &ld, std::vector<int> &order)
+    {
+        if (ld.flag)
+            return;
+
+        for (set<int>::iterator i = ld.inputLayersId.begin(); i != ld.inputLayersId.end(); i++)
+            computeForwardOrder(layers[*i], order);
+
+        order.push_back(ld.id);
+        ld.flag = 1;
+    }
+
+    struct MemoryGroup
+    {
+        size_t size;
+        int firstUse, lastUse;
+        bool pinned;
+        size_t offset;
+        std::vector<LayerPin> members;
+    };
+
+    struct MemorySlot
+    {
+        size_t size;
+        int lastUse;
+        std::vector<int> groups;
+    };
+
+    void releaseMemoryPlan()
+    {
+        for (size_t i = 0; i < arenaBlobs.size(); i++)
+        {
+            LayerPin pin = arenaBlobs[i];
+            MapIdToLayerData::iterator it = layers.find(pin.lid);
+            if (it != layers.end() && pin.oid < (int)it->second.outputBlobs.size())
+                it->second.outputBlobs[pin.oid] = Blob();
+        }
+        arenaBlobs.clear();
+        memoryArena.release();
+    }
+
+    /* Binds the output blobs of layers whose lifetimes don't intersect to the same region of one arena.
+     * Blobs which share data (in-place layers, reshapes) are treated as a single group.
+     * The net input blobs, the outputs of the net and non-CPU blobs are left untouched.
+     */
+    void planMemory()
+    {
+        releaseMemoryPlan();
+
+        std::vector<int> order;
+        MapIdToLayerData::iterator it;
+        for (it = layers.begin(); it != layers.end(); it++)
+            it->second.flag = 0;
+        for (it = layers.begin(); it != layers.end(); it++)
+            computeForwardOrder(it->second, order);
+
+        std::set<int> pinnedLayers(netOutputs.begin(), netOutputs.end());
+        pinnedLayers.insert(0);
+
+        std::vector<MemoryGroup> groups;
+        std::map<const uchar*, int> dataToGroup;
+
+        for (int i = 0; i < (int)order.size(); i++)
+        {
+            LayerData &ld = layers[order[i]];
+            int step = (parallelBranches) ? layerLevels[ld.id] : i; //layers of one level are alive simultaneously
+
+            for (size_t i = 0; i < ld.inputBlobs.size(); i++)
+            {
+                const Blob &inp = *ld.inputBlobs[i];
+                if (!(inp.getState() & Blob::HEAD_AT_MAT))
+                    continue;
+
+                std::map<const uchar*, int>::iterator g = dataToGroup.find(inp.matRefConst().datastart);
+                if (g != dataToGroup.end())
+                    groups[g->second].lastUse = std::max(groups[g->second].lastUse, step);
+            }
+
+            for (size_t i = 0; i < ld.outputBlobs.size(); i++)
+            {
+                const Blob &out = ld.outputBlobs[i];
+                int state = out.getState();
+                if (!(state & Blob::HEAD_AT_MAT))
+                    continue; //UMat blobs are never planned
+
+                const Mat &m = out.matRefConst();
+                if (m.empty())
+                    continue;
+
+                std::map<const uchar*, int>::iterator g = dataToGroup.find(m.datastart);
+                if (g == dataToGroup.end())
+                {
+                    MemoryGroup newGroup;
+                    newGroup.size = 0;
+                    newGroup.firstUse = step;
+                    newGroup.lastUse = step;
+                    newGroup.pinned = false;
+                    newGroup.offset = 0;
+
+                    g = dataToGroup.insert(make_pair(m.datastart, (int)groups.size())).first;
+                    groups.push_back(newGroup);
+                }
+
+                MemoryGroup &group = groups[g->second];
+                group.size = std::max(group.size, (size_t)(m.dataend - m.datastart));
+                group.lastUse = std::max(group.lastUse, step);
+                group.pinned |= (state != Blob::HEAD_AT_MAT) || pinnedLayers.count(ld.id);
+                group.members.push_back(LayerPin(ld.id, (int)i));
+            }
+        }
+
+        //greedy first-come assignment of groups to slots
+        std::vector<std::pair<int, int> > groupsByFirstUse;
+        for (int gi = 0; gi < (int)groups.size(); gi++)
+            groupsByFirstUse.push_back(make_pair(groups[gi].firstUse, gi));
+        std::sort(groupsByFirstUse.begin(), groupsByFirstUse.end());
+
+        std::vector<MemorySlot> slots;
+        size_t unsharedSize = 0;
+        for (size_t k = 0; k < groupsByFirstUse.size(); k++)
+        {
+            int gi = groupsByFirstUse[k].second;
+            MemoryGroup &group = groups[gi];
+            if (group.pinned)
+                continue;
+            unsharedSize += group.size;
+
+            int best = -1;
+            for (int si = 0; si < (int)slots.size(); si++)
+            {
+                if (slots[si].lastUse >= group.firstUse)
+                    continue;
+
+                bool fits = slots[si].size >= group.size;
+                if (best < 0)
+                    best = si;
+                else if (fits && (slots[best].size < group.size || slots[si].size < slots[best].size))
+                    best = si; //the smallest slot which fits
+                else if (!fits && slots[best].size < group.size && slots[si].size > slots[best].size)
+                    best = si; //the largest slot, if nothing fits
+            }
+
+            if (best < 0)
+            {
+                best = (int)slots.size();
+                slots.push_back(MemorySlot());
+                slots.back().size = 0;
+            }
+
+            MemorySlot &slot = slots[best];
+            slot.size = std::max(slot.size, group.size);
+            slot.lastUse = group.lastUse;
+            slot.groups.push_back(gi);
+        }
+
+        if (slots.empty())
+            return;
+
+        const size_t alignment = 64;
+        size_t arenaSize = 0;
+        for (size_t si = 0; si < slots.size(); si++)
+        {
+            for (size_t k = 0; k < slots[si].groups.size(); k++)
+                groups[slots[si].groups[k]].offset = arenaSize;
+            arenaSize += alignSize(slots[si].size, (int)alignment);
+        }
+
+        memoryArena.create(1, (int)(arenaSize + alignment), CV_8U);
+        uchar *arenaPtr = alignPtr(memoryArena.ptr(), (int)alignment);
+
+        for (size_t gi = 0; gi < groups.size(); gi++)
+        {
+            MemoryGroup &group = groups[gi];
+            if (group.pinned)
+                continue;
+
+            for (size_t k = 0; k < group.members.size(); k++)
+            {
+                LayerPin pin = group.members[k];
+                Mat &m = layers[pin.lid].outputBlobs[pin.oid].matRef();
+                uchar *dst = arenaPtr + group.offset + (m.data - m.datastart);
+                m = Mat(m.dims, m.size.p, m.type(), dst, m.step.p);
+                arenaBlobs.push_back(pin);
+            }
+        }
+
+        #ifndef NDEBUG
+        std::cout << "\nMemory planner: " << unsharedSize << " bytes of output blobs were packed into "
+                  << arenaSize << " bytes arena\n";
+        #endif
+    }
+
     void forwardLayer(LayerData &ld, bool clearFlags = true)
     {
         if (clearFlags)
@@ -412,10 +824,34 @@ struct Net::Impl
             forwardLayer(layers[*i], false);
         }
 
+        if (calibrating && ld.layerInstance.dynamicCast<Int8Quantizable>())
+            updateInputRange(ld);
+
         //forward itself
+        forwardLayerItself(ld);
+    }
+
+    void forwardLayerItself(LayerData &ld)
+    {
         try
         {
-            ld.layerInstance->forward(ld.inputBlobs, ld.outputBlobs);
+            int64 startTicks = (profiling) ? getTickCount() : 0;
+
+            std::vector<uchar> inputsOnDevice;
+            if (hostSyncCheck)
+                inputsOnDevice = getInputsOnDevice(ld);
+
+            if (!ld.skip)
+                ld.layerInstance->forward(ld.inputBlobs, ld.outputBlobs);
+
+            if (hostSyncCheck)
+                checkHostSync(ld, inputsOnDevice);
+
+            if (profiling)
+            {
+                ld.forwardTicks += getTickCount() - startTicks;
+                ld.forwardCalls++;
+            }
         }
         catch (const cv::Exception &err)
         {
@@ -425,12 +861,236 @@ struct Net::Impl
         ld.flag = 1;
     }
 
+    static std::vector<uchar> getInputsOnDevice(const LayerData &ld)
+    {
+        std::vector<uchar> onDevice(ld.inputBlobs.size());
+        for (size_t i = 0; i < ld.inputBlobs.size(); i++)
+            onDevice[i] = ld.inputBlobs[i]->getState() == Blob::HEAD_AT_UMAT;
+        return onDevice;
+    }
+
+    //the data may return to the host memory only at the end of the graph
+    static void checkHostSync(const LayerData &ld, const std::vector<uchar> &inputsOnDevice)
+    {
+        if (ld.requiredOutputs.empty())
+            return;
+
+        bool anyOnDevice = false;
+        for (size_t i = 0; i < ld.inputBlobs.size(); i++)
+        {
+            anyOnDevice |= inputsOnDevice[i] != 0;
+            if (inputsOnDevice[i] && ld.inputBlobs[i]->getState() != Blob::HEAD_AT_UMAT)
+                CV_Error(Error::StsError, format("Input blob #%d was transferred to the host memory", (int)i));
+        }
+
+        for (size_t i = 0; i < ld.outputBlobs.size() && anyOnDevice; i++)
+        {
+            if (ld.outputBlobs[i].getState() == Blob::HEAD_AT_MAT)
+                CV_Error(Error::StsError, format("Output blob #%d was computed in the host memory", (int)i));
+        }
+    }
+
+    void updateInputRange(LayerData &ld)
+    {
+        float &range = inputRanges[ld.id];
+        for (size_t i = 0; i < ld.inputBlobs.size(); i++)
+        {
+            const Blob &inp = *ld.inputBlobs[i];
+            if (inp.type() == CV_32F)
+                range = std::max(range, (float)cv::norm(inp.matRefConst(), NORM_INF));
+        }
+    }
+
+    void setInt8Ranges(bool enable)
+    {
+        MapIdToLayerData::iterator it;
+        for (it = layers.begin(); it != layers.end(); it++)
+        {
+            Ptr<Int8Quantizable> layer = it->second.layerInstance.dynamicCast<Int8Quantizable>();
+            if (!layer)
+                continue;
+
+            std::map<int, float>::iterator r = inputRanges.find(it->first);
+            float range = (enable && r != inputRanges.end()) ? r->second : 0.f;
+            if (!layer->setInt8InputRange(range))
+                layer->setInt8InputRange(0);
+        }
+
+        //layers choose their computation paths and buffers during allocation
+        netWasAllocated = false;
+    }
+
+    //rough estimation, only multiply-add heavy layers are taken into account precisely
+    static double estimateFlops(LayerData &ld)
+    {
+        double outTotal = 0, inpTotal = 0;
+        for (size_t i = 0; i < ld.outputBlobs.size(); i++)
+            outTotal += (ld.outputBlobs[i].dims() > 0) ? (double)ld.outputBlobs[i].total() : 0.;
+        for (size_t i = 0; i < ld.inputBlobs.size(); i++)
+            inpTotal += (ld.inputBlobs[i]->dims() > 0) ? (double)ld.inputBlobs[i]->total() : 0.;
+
+        Ptr<Layer> layer = ld.layerInstance;
+        if (!layer || layer->blobs.empty())
+            return outTotal;
+
+        const Blob &weights = layer->blobs[0];
+        if (layer.dynamicCast<ConvolutionLayer>() || layer.dynamicCast<InnerProductLayer>())
+            return 2 * outTotal * (double)weights.total(1);
+        if (layer.dynamicCast<DeconvolutionLayer>())
+            return 2 * inpTotal * (double)weights.total(1);
+
+        return outTotal;
+    }
+
+    void getProfile(std::vector<LayerProfile> &profile)
+    {
+        profile.clear();
+
+        MapIdToLayerData::iterator it;
+        for (it = layers.begin(); it != layers.end(); it++)
+        {
+            LayerData &ld = it->second;
+            if (ld.id == 0)
+                continue; //skip Data layer
+
+            LayerProfile p;
+            p.name = ld.name;
+            p.type = ld.type;
+            p.calls = ld.forwardCalls;
+            p.time = ld.forwardTicks * 1000. / getTickFrequency();
+            p.fused = ld.skip;
+
+            p.outputBytes = 0;
+            for (size_t i = 0; i < ld.outputBlobs.size(); i++)
+            {
+                const Blob &out = ld.outputBlobs[i];
+                if (out.dims() > 0)
+                    p.outputBytes += out.total() * out.elemSize();
+            }
+            p.flops = (netWasAllocated) ? estimateFlops(ld) : 0;
+
+            profile.push_back(p);
+        }
+    }
+
+    /* Splits layers into levels: each layer depends only on layers of the previous levels,
+     * so layers of one level may be computed concurrently.
+     */
+    void computeForwardLevels()
+    {
+        std::vector<int> order;
+        MapIdToLayerData::iterator it;
+        for (it = layers.begin(); it != layers.end(); it++)
+            it->second.flag = 0;
+        for (it = layers.begin(); it != layers.end(); it++)
+            computeForwardOrder(it->second, order);
+
+        layerLevels.clear();
+        forwardLevels.clear();
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            LayerData &ld = layers[order[i]];
+
+            int level = 0;
+            for (set<int>::iterator p = ld.inputLayersId.begin(); p != ld.inputLayersId.end(); p++)
+                level = std::max(level, layerLevels[*p] + 1);
+
+            layerLevels[ld.id] = level;
+            if ((int)forwardLevels.size() <= level)
+                forwardLevels.resize(level + 1);
+            forwardLevels[level].push_back(ld.id);
+        }
+    }
+
+    //layer modifies data of its input, so it isn't safe to run it concurrently with other consumers of the input
+    static bool worksInPlace(const LayerData &ld)
+    {
+        for (size_t i = 0; i < ld.outputBlobs.size(); i++)
+        {
+            for (size_t j = 0; j < ld.inputBlobs.size(); j++)
+            {
+                if (sharesMatData(ld.outputBlobs[i], *ld.inputBlobs[j]))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    class ParallelLayersBody : public ParallelLoopBody
+    {
+    public:
+        ParallelLayersBody(Impl *net_, const std::vector<LayerData*> &layers_)
+            : net(net_), layers(layers_), failed(false) {}
+
+        void operator()(const Range &r) const
+        {
+            for (int i = r.start; i < r.end; i++)
+            {
+                try
+                {
+                    net->forwardLayerItself(*layers[i]);
+                }
+                catch (const cv::Exception &err)
+                {
+                    AutoLock lock(mutex);
+                    if (!failed)
+                        error = err;
+                    failed = true;
+                }
+            }
+        }
+
+        Impl *net;
+        const std::vector<LayerData*> &layers;
+        mutable Mutex mutex;
+        mutable cv::Exception error;
+        mutable bool failed;
+    };
+
+    void forwardAllParallel()
+    {
+        std::vector<LayerData*> concurrent, sequential;
+
+        for (size_t level = 0; level < forwardLevels.size(); level++)
+        {
+            concurrent.clear();
+            sequential.clear();
+            for (size_t i = 0; i < forwardLevels[level].size(); i++)
+            {
+                LayerData &ld = layers[forwardLevels[level][i]];
+                if (worksInPlace(ld))
+                    sequential.push_back(&ld);
+                else
+                    concurrent.push_back(&ld);
+            }
+
+            if (concurrent.size() > 1)
+            {
+                ParallelLayersBody body(this, concurrent);
+                parallel_for_(Range(0, (int)concurrent.size()), body);
+                if (body.failed)
+                    throw body.error;
+            }
+            else if (concurrent.size() == 1)
+                forwardLayerItself(*concurrent[0]);
+
+            for (size_t i = 0; i < sequential.size(); i++)
+                forwardLayerItself(*sequential[i]);
+        }
+    }
+
     void forwardAll()
     {
         MapIdToLayerData::iterator it;
         for (it = layers.begin(); it != layers.end(); it++)
             it->second.flag = 0;
 
+        if (parallelBranches && !calibrating)
+        {
+            forwardAllParallel();
+            return;
+        }
+
         for (it = layers.begin(); it != layers.end(); it++)
             forwardLayer(it->second, false);
     }
@@ -444,6 +1104,13 @@ Net::~Net()
 {
 }
 
+Net Net::createContext() const
+{
+    Net ctx;
+    ctx.impl->shareGraphFrom(*impl);
+    return ctx;
+}
+
 int Net::addLayer(const String &name, const String &type, LayerParams &params)
 {
     if (name.find('.') != String::npos)
@@ -493,6 +1160,119 @@ void Net::allocate()
     impl->setUpNet();
 }
 
+void Net::setMemoryReuse(bool enable)
+{
+    if (impl->reuseMemory != enable)
+    {
+        impl->reuseMemory = enable;
+        impl->netWasAllocated = false;
+    }
+}
+
+void Net::calibrateInt8(const std::vector<Blob> &samples, const String &inputName)
+{
+    CV_Assert(!samples.empty());
+
+    impl->setInt8Ranges(false);
+    impl->inputRanges.clear();
+    impl->calibrating = true;
+    try
+    {
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            setBlob(inputName, samples[i]);
+            forward();
+        }
+    }
+    catch (...)
+    {
+        impl->calibrating = false;
+        throw;
+    }
+    impl->calibrating = false;
+
+    impl->setInt8Ranges(true);
+}
+
+void Net::disableInt8()
+{
+    impl->inputRanges.clear();
+    impl->setInt8Ranges(false);
+}
+
+void Net::convertWeightsToHalf()
+{
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        LayerData &ld = it->second;
+        if (ld.id == 0)
+            continue;
+
+        Ptr<HalfPrecisionStorable> layer = ld.getLayerInstance().dynamicCast<HalfPrecisionStorable>();
+        if (layer && layer->convertWeightsToHalf())
+            ld.params.blobs = ld.layerInstance->blobs; //releases the single precision copies
+    }
+    impl->netWasAllocated = false;
+}
+
+void Net::setParallelBranches(bool enable)
+{
+    if (impl->parallelBranches != enable)
+    {
+        impl->parallelBranches = enable;
+        impl->netWasAllocated &= !impl->reuseMemory; //memory plan depends on the schedule
+    }
+}
+
+void Net::setHostSyncCheck(bool enable)
+{
+    impl->hostSyncCheck = enable;
+}
+
+void Net::setGemmBackend(const String &name)
+{
+    if (!name.empty() && name != "auto")
+        selectGemmBackend(name, 1, 1, 1, CV_32F); //throws on unknown names
+
+    if (impl->gemmBackend != name)
+    {
+        impl->gemmBackend = name;
+        impl->netWasAllocated = false;
+    }
+}
+
+std::vector<String> getGemmBackendNames()
+{
+    const std::vector<Ptr<GemmBackend> > &backends = getGemmBackends();
+    std::vector<String> names(backends.size());
+    for (size_t i = 0; i < backends.size(); i++)
+        names[i] = backends[i]->name();
+    return names;
+}
+
+void Net::setProfiling(bool enable)
+{
+    impl->profiling = enable;
+}
+
+void Net::resetProfile()
+{
+    Impl::MapIdToLayerData::iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        it->second.forwardTicks = 0;
+        it->second.forwardCalls = 0;
+    }
+}
+
+std::vector<LayerProfile> Net::getProfile() const
+{
+    std::vector<LayerProfile> profile;
+    impl->getProfile(profile);
+    return profile;
+}
+
 void Net::forward(LayerId toLayer)
 {
     impl->setUpNet();
@@ -503,6 +1283,88 @@ void Net::forward(LayerId toLayer)
         impl->forwardLayer(impl->getLayerData(toLayer));
 }
 
+struct BlobFuture::Impl
+{
+    Blob blob;
+    bool pending; //the blob is in the device memory and its OpenCL commands may be not finished
+};
+
+BlobFuture::BlobFuture()
+{
+}
+
+bool BlobFuture::valid() const
+{
+    return !impl.empty();
+}
+
+void BlobFuture::wait() const
+{
+    CV_Assert(valid());
+    if (impl->pending)
+    {
+        ocl::finish();
+        impl->pending = false;
+    }
+}
+
+Blob BlobFuture::get() const
+{
+    wait();
+    return impl->blob;
+}
+
+BlobFuture Net::forwardAsync(const String &outputName)
+{
+    impl->setUpNet();
+
+    LayerPin pin = impl->getPinByAlias(outputName);
+    if (!pin.valid())
+        CV_Error(Error::StsObjectNotFound, "Requested blob \"" + outputName + "\" not found");
+    impl->forwardLayer(impl->layers[pin.lid]);
+
+    BlobFuture future;
+    future.impl = Ptr<BlobFuture::Impl>(new BlobFuture::Impl);
+    future.impl->blob = getBlob(outputName);
+    future.impl->pending = (future.impl->blob.getState() == Blob::HEAD_AT_UMAT);
+    return future;
+}
+
+void Net::writeBinary(const String &path) const
+{
+    std::vector<binary::LayerRecord> records;
+    std::map<int, int> recordIndex;
+    recordIndex[0] = 0;
+
+    Impl::MapIdToLayerData::const_iterator it;
+    for (it = impl->layers.begin(); it != impl->layers.end(); it++)
+    {
+        const LayerData &ld = it->second;
+        if (ld.id == 0)
+            continue;
+
+        binary::LayerRecord rec;
+        rec.name = ld.name;
+        rec.type = ld.type;
+        rec.params = &ld.params;
+        //blobs of the instance may be replaced by setParam()
+        rec.blobs = (ld.layerInstance) ? &ld.layerInstance->blobs : &ld.params.blobs;
+        for (size_t i = 0; i < ld.inputBlobsId.size(); i++)
+            rec.inputs.push_back(std::make_pair(ld.inputBlobsId[i].lid, ld.inputBlobsId[i].oid));
+
+        records.push_back(rec);
+        recordIndex[ld.id] = (int)records.size();
+    }
+
+    for (size_t i = 0; i < records.size(); i++)
+    {
+        for (size_t j = 0; j < records[i].inputs.size(); j++)
+            records[i].inputs[j].first = recordIndex[records[i].inputs[j].first];
+    }
+
+    binary::writeNet(path, impl->netInputLayer->getNames(), records);
+}
+
 void Net::setNetInputs(const std::vector<String> &inputBlobNames)
 {
     impl->netInputLayer->setNames(inputBlobNames);
@@ -516,9 +1378,42 @@ void Net::setBlob(String outputName, const Blob &blob)
 
     LayerData &ld = impl->layers[pin.lid];
     ld.outputBlobs.resize( std::max(pin.oid+1, (int)ld.requiredOutputs.size()) );
+
+    //network inputs of new shape require reallocation of the following layers
+    if (pin.lid == 0 && !ld.outputBlobs[pin.oid].equalShape(blob))
+        impl->inputsReshaped = true;
+
     ld.outputBlobs[pin.oid] = blob;
 }
 
+static Mat getSampleView(Blob &blob, int n)
+{
+    Mat &m = blob.matRef(false);
+    CV_Assert(m.dims >= 2 && 0 <= n && n < m.size[0]);
+
+    if (m.dims == 2)
+        return m.row(n);
+    return Mat(m.dims - 1, m.size.p + 1, m.type(), m.ptr(n), m.step.p + 1);
+}
+
+void Net::forwardBatch(const std::vector<Mat> &images, const String &inputName,
+                       const String &outputName, std::vector<Mat> &outputs, int dstCn)
+{
+    CV_Assert(!images.empty());
+
+    Blob batch;
+    batch.batchFromImages(images, dstCn);
+    setBlob(inputName, batch);
+    forward();
+
+    Blob out = getBlob(outputName);
+    CV_Assert(out.dims() >= 2 && out.num() == (int)images.size());
+
+    outputs.resize(images.size());
+    for (size_t i = 0; i < images.size(); i++)
+        outputs[i] = getSampleView(out, (int)i);
+}
+
 Blob Net::getBlob(String outputName)
 {
     LayerPin pin = impl->getPinByAlias(outputName);
@@ -538,7 +1433,7 @@ Blob Net::getParam(LayerId layer, int numParam)
 {
     LayerData &ld = impl->getLayerData(layer);
 
-    std::vector<Blob> &layerBlobs = ld.layerInstance->blobs;
+    std::vector<Blob> &layerBlobs = ld.getLayerInstance()->blobs;
     CV_Assert(numParam < (int)layerBlobs.size());
     return layerBlobs[numParam];
 }
@@ -547,7 +1442,7 @@ void Net::setParam(LayerId layer, int numParam, const Blob &blob)
 {
     LayerData &ld = impl->getLayerData(layer);
 
-    std::vector<Blob> &layerBlobs = ld.layerInstance->blobs;
+    std::vector<Blob> &layerBlobs = ld.getLayerInstance()->blobs;
     CV_Assert(numParam < (int)layerBlobs.size());
     //we don't make strong checks, use this function carefully
     layerBlobs[numParam] = blob;
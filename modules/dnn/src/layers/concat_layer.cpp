@@ -75,7 +75,7 @@ void ConcatLayerImpl::allocate(const std::vector<Blob *> &inputs, std::vector<Bl
         }
 
         axisSum += curShape[axisIdx];
-        useOpenCL |= inputs[i]->getState() == Blob::HEAD_AT_MAT;
+        useOpenCL |= inputs[i]->getState() == Blob::HEAD_AT_UMAT;
     }
 
     refShape[axisIdx] = axisSum;
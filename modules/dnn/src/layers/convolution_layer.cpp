@@ -45,6 +45,8 @@
 #include "convolution_layer.hpp"
 #include "op_im2col.hpp"
 #include "op_blas.hpp"
+#include "op_fp16.hpp"
+#include "op_winograd.hpp"
 #include <opencv2/dnn/shape_utils.hpp>
 #include <iostream>
 
@@ -56,15 +58,11 @@ namespace dnn
 ConvolutionLayerImpl::ConvolutionLayerImpl()
 {
     tryUseOpenCL = false; //true;
+    tryUseWinograd = true;
+    useWinograd = false;
+    int8InputRange = 0;
     numOutput = -1;
     group = -1;
-
-    #if HAVE_CBLAS
-        if (getBlasThreads() != cv::getThreadNum())
-        {
-            setBlasThreads(cv::getThreadNum());
-        }
-    #endif
 }
 
 void ConvolutionLayerImpl::init()
@@ -77,8 +75,8 @@ void ConvolutionLayerImpl::init()
     CV_Assert(blobs[0].dims() == 4 && blobs[0].cols() == kernel.width && blobs[0].rows() == kernel.height);
     CV_Assert(!bias || blobs[1].total() == (size_t)blobs[0].num());
 
-    //TODO: dilation in OCL mode
-    useOpenCL = ocl::useOpenCL() && tryUseOpenCL && dilation == Size(1, 1);
+    //TODO: dilation and half precision weights in OCL mode
+    useOpenCL = ocl::useOpenCL() && tryUseOpenCL && dilation == Size(1, 1) && blobs[0].type() != fp16::TYPE;
 }
 
 void ConvolutionLayerImpl::allocate(const std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
@@ -88,6 +86,7 @@ void ConvolutionLayerImpl::allocate(const std::vector<Blob*> &inputs, std::vecto
     CV_Assert(inputs.size() > 0);
     const Blob &input = *inputs[0];
     CV_Assert(input.dims() == 4 && (input.type() == CV_32F || input.type() == CV_64F));
+    CV_Assert(blobs[0].type() != fp16::TYPE || input.type() == CV_32F);
     computeInpOutShape(input);
 
     group = inpCn / blobs[0].channels();
@@ -107,17 +106,35 @@ void ConvolutionLayerImpl::allocate(const std::vector<Blob*> &inputs, std::vecto
 
     int allocFlags = useOpenCL ? Blob::ALLOC_UMAT : Blob::ALLOC_MAT;
 
-    if (!is1x1())
+    if (int8InputRange > 0 && (useOpenCL || input.type() != CV_32F))
+        int8InputRange = 0;
+
+    useWinograd = int8InputRange <= 0 && isWinogradApplicable(input);
+    if (useWinograd)
+    {
+        //reshape of the input doesn't change the transformed weights
+        const Mat &weights = blobs[0].matRefConst();
+        if (winogradWeights.empty() || winogradSrcWeights.data != weights.data)
+        {
+            winograd::transformWeights(weights, winogradWeights);
+            winogradSrcWeights = weights;
+        }
+    }
+    else if (!is1x1())
     {
         colBlob.create(Shape(ksize, outH * outW), input.type(), allocFlags);
     }
 
-    if (bias)
+    if (bias && !useWinograd)
     {
         biasOnesBlob.create(Shape(1, topH * topW), input.type(), allocFlags);
         biasOnesBlob.setTo(1);
     }
 
+    gemmBackend.release();
+    if (!useOpenCL && !useWinograd && int8InputRange <= 0 && blobs[0].type() != fp16::TYPE)
+        chooseGemmBackend(input.type());
+
     outputs.resize(inputs.size());
     for (size_t i = 0; i < inputs.size(); i++)
     {
@@ -125,6 +142,25 @@ void ConvolutionLayerImpl::allocate(const std::vector<Blob*> &inputs, std::vecto
     }
 }
 
+void ConvolutionLayerImpl::setGemmBackend(const String &name)
+{
+    gemmBackendName = name;
+}
+
+bool ConvolutionLayerImpl::convertWeightsToHalf()
+{
+    if (int8InputRange > 0 || blobs[0].type() != CV_32F)
+        return blobs[0].type() == fp16::TYPE;
+
+    blobs[0] = blobs[0].toHalf();
+    return true;
+}
+
+void ConvolutionLayerImpl::chooseGemmBackend(int type)
+{
+    gemmBackend = selectGemmBackend(gemmBackendName, outGroupCn, outH * outW, ksize, type);
+}
+
 bool ConvolutionLayerImpl::is1x1() const
 {
     return (kernel.height == 1 && kernel.width == 1) &&
@@ -132,6 +168,110 @@ bool ConvolutionLayerImpl::is1x1() const
            (dilation.height == 1 && dilation.width == 1);
 }
 
+bool ConvolutionLayerImpl::isWinogradApplicable(const Blob &input) const
+{
+    return tryUseWinograd && !useOpenCL &&
+           (kernel.height == 3 && kernel.width == 3) &&
+           (stride.height == 1 && stride.width == 1) &&
+           (dilation.height == 1 && dilation.width == 1) &&
+           input.type() == CV_32F && blobs[0].type() == CV_32F && (!bias || blobs[1].type() == CV_32F);
+}
+
+void ConvolutionLayerImpl::forwardWinograd(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
+{
+    const float *biasPtr = (bias) ? blobs[1].matRefConst().ptr<float>() : NULL;
+
+    for (size_t ii = 0; ii < outputs.size(); ii++)
+    {
+        int numImg = inputs[ii]->size(0);
+
+        for (int n = 0; n < numImg; n++)
+        {
+            for (int g = 0; g < group; g++)
+            {
+                winograd::convolve(inputs[ii]->ptrf(n, g * inpGroupCn), inpGroupCn, inpH, inpW, pad.height, pad.width,
+                                   winogradWeights, g * outGroupCn, outGroupCn, (biasPtr) ? biasPtr + g * outGroupCn : NULL,
+                                   outputs[ii].ptrf(n, g * outGroupCn), outH, outW, winogradInpBuf, winogradOutBuf);
+
+                if (activ)
+                {
+                    Mat dstMat(outGroupCn, outH * outW, CV_32F, outputs[ii].ptrf(n, g * outGroupCn));
+                    activ->apply(dstMat);
+                }
+            }
+        }
+    }
+}
+
+bool ConvolutionLayerImpl::setInt8InputRange(float maxAbs)
+{
+    if (maxAbs > 0 && (useOpenCL || blobs[0].type() != CV_32F || (bias && blobs[1].type() != CV_32F)))
+        return false;
+
+    int8InputRange = std::max(maxAbs, 0.f);
+    if (int8InputRange > 0)
+    {
+        Mat weightsMat = reshaped(blobs[0].matRefConst(), Shape(blobs[0].num(), (int)blobs[0].total(1)));
+        quantizeRowsInt8(weightsMat, weightsInt8, weightsScales);
+    }
+    else
+    {
+        weightsInt8.release();
+        weightsScales.release();
+    }
+    return true;
+}
+
+void ConvolutionLayerImpl::forwardInt8(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
+{
+    const float *biasPtr = (bias) ? blobs[1].matRefConst().ptr<float>() : NULL;
+    double inpScale = int8InputRange / 127.;
+
+    for (size_t ii = 0; ii < outputs.size(); ii++)
+    {
+        int numImg = inputs[ii]->size(0);
+        Mat inpMat = inputs[ii]->matRefConst();
+        Mat outMat = reshaped(outputs[ii].matRef(), Shape(numImg*group*outGroupCn, outH*outW));
+
+        for (int n = 0; n < numImg; n++)
+        {
+            for (int g = 0; g < group; g++)
+            {
+                Mat colMat, curInp = slice(inpMat, n, _Range(g * inpGroupCn, inpGroupCn));
+                im2col(curInp, colMat);
+                colMat.convertTo(colInt8, CV_8S, 1. / inpScale);
+
+                _Range kerRange(g * outGroupCn, outGroupCn);
+                gemmInt8(weightsInt8.rowRange(kerRange), colInt8, accInt32);
+
+                Mat dstMat = outMat.rowRange(_Range((g + n * group) * outGroupCn, outGroupCn));
+                for (int oc = 0; oc < outGroupCn; oc++)
+                {
+                    int k = g * outGroupCn + oc;
+                    accInt32.row(oc).convertTo(dstMat.row(oc), CV_32F, weightsScales.at<float>(k) * inpScale,
+                                               (biasPtr) ? biasPtr[k] : 0.);
+                }
+
+                applyActivation(dstMat);
+            }
+        }
+    }
+}
+
+//computes dst = op(weights) * src, the weights may be stored in half precision
+static void gemmWeights(const Ptr<GemmBackend> &backend, const Mat &weights, const Mat &src, Mat &dst, int flags)
+{
+    if (weights.type() == fp16::TYPE)
+        fp16::gemmHalfA(weights, src, dst, (flags & GEMM_1_T) != 0);
+    else
+        dnn::gemm(backend, weights, src, 1, dst, 0, flags);
+}
+
+static void gemmWeights(const Ptr<GemmBackend> &backend, const UMat &weights, const UMat &src, UMat &dst, int flags)
+{
+    dnn::gemm(backend, weights, src, 1, dst, 0, flags);
+}
+
 template<typename XMat>
 void ConvolutionLayerImpl::forward_(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
 {
@@ -157,12 +297,14 @@ void ConvolutionLayerImpl::forward_(std::vector<Blob*> &inputs, std::vector<Blob
                 _Range outRange((g + n * group) * outGroupCn, outGroupCn);
                 XMat dstMat = outMat.rowRange(outRange);
 
-                dnn::gemm(kerMat, colMat, 1, dstMat, 0);
+                gemmWeights(gemmBackend, kerMat, colMat, dstMat, 0);
 
                 if (bias)
                 {
                     dnn::gemm(biasesMat.rowRange(kerRange), biasOnesBlob.getRefConst<XMat>(), 1, dstMat, 1);
                 }
+
+                applyActivation(dstMat);
             }
         }
     }
@@ -170,12 +312,35 @@ void ConvolutionLayerImpl::forward_(std::vector<Blob*> &inputs, std::vector<Blob
 
 void ConvolutionLayerImpl::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
 {
-    if (!useOpenCL)
+    if (int8InputRange > 0)
+        forwardInt8(inputs, outputs);
+    else if (useWinograd)
+        forwardWinograd(inputs, outputs);
+    else if (!useOpenCL)
         forward_<Mat>(inputs, outputs);
     else
         forward_<UMat>(inputs, outputs);
 }
 
+bool ConvolutionLayerImpl::setActivation(const Ptr<ActivationFunction> &activ_)
+{
+    if (activ_ && useOpenCL)
+        return false;
+    activ = activ_;
+    return true;
+}
+
+void ConvolutionLayerImpl::applyActivation(Mat &dst) const
+{
+    if (activ)
+        activ->apply(dst);
+}
+
+void ConvolutionLayerImpl::applyActivation(UMat&) const
+{
+    CV_Assert(!activ);
+}
+
 void ConvolutionLayerImpl::im2col(const UMat &srcImg, UMat &dstCol)
 {
     if (is1x1())
@@ -226,7 +391,17 @@ void ConvolutionLayerImpl::computeInpOutShape(const Blob &input)
 
 DeConvolutionLayerImpl::DeConvolutionLayerImpl()
 {
+    tryUseWinograd = false;
+}
+
+bool DeConvolutionLayerImpl::setActivation(const Ptr<ActivationFunction> &activ_)
+{
+    return !activ_;
+}
 
+bool DeConvolutionLayerImpl::setInt8InputRange(float maxAbs)
+{
+    return maxAbs <= 0;
 }
 
 void DeConvolutionLayerImpl::computeInpOutShape(const Blob &inpBlob)
@@ -242,6 +417,11 @@ void DeConvolutionLayerImpl::computeInpOutShape(const Blob &inpBlob)
     topH = inpH; topW = inpW; topCn = inpCn;
 }
 
+void DeConvolutionLayerImpl::chooseGemmBackend(int type)
+{
+    gemmBackend = selectGemmBackend(gemmBackendName, ksize, outH * outW, outGroupCn, type, GEMM_1_T);
+}
+
 void DeConvolutionLayerImpl::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
 {
     if (!useOpenCL)
@@ -272,7 +452,7 @@ void DeConvolutionLayerImpl::forward_(std::vector<Blob *> &inputs, std::vector<B
                 XMat convMat = convBlob.rowRange(_Range((g + n * group) * outGroupCn, outGroupCn));
                 XMat wghtMat = weightsMat.rowRange(_Range(g * outGroupCn, outGroupCn));
 
-                dnn::gemm(wghtMat, convMat, 1, colMat, 0, GEMM_1_T);
+                gemmWeights(gemmBackend, wghtMat, convMat, colMat, GEMM_1_T);
 
                 if (!is1x1())
                     col2im(colMat, dstMat);
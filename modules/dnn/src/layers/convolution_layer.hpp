@@ -43,6 +43,8 @@
 #define __OPENCV_DNN_LAYERS_CONVOLUTION_LAYER_HPP__
 #include "../precomp.hpp"
 #include <opencv2/dnn/all_layers.hpp>
+#include "layers_common.hpp"
+#include "op_blas.hpp"
 
 namespace cv
 {
@@ -50,7 +52,8 @@ namespace dnn
 {
 
 //TODO: simultaneously convolution and bias addition for cache optimization
-class ConvolutionLayerImpl : public ConvolutionLayer
+class ConvolutionLayerImpl : public ConvolutionLayer, public ActivationFusable, public Int8Quantizable,
+                             public GemmBackendConfigurable, public HalfPrecisionStorable
 {
 public:
 
@@ -58,6 +61,10 @@ public:
     virtual void allocate(const std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
     virtual void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
     virtual void init();
+    virtual bool setActivation(const Ptr<ActivationFunction> &activ);
+    virtual bool setInt8InputRange(float maxAbs);
+    virtual void setGemmBackend(const String &name);
+    virtual bool convertWeightsToHalf();
 
 protected:
     int numOutput, group;
@@ -69,16 +76,32 @@ protected:
 
     bool bias;
     bool tryUseOpenCL, useOpenCL;
+    bool tryUseWinograd, useWinograd;
 
     Blob colBlob, biasOnesBlob;
+    Ptr<ActivationFunction> activ;
+    Mat winogradWeights, winogradInpBuf, winogradOutBuf;
+    Mat winogradSrcWeights; //weights which were transformed into winogradWeights
+
+    float int8InputRange;
+    Mat weightsInt8, weightsScales, colInt8, accInt32;
+
+    String gemmBackendName;
+    Ptr<GemmBackend> gemmBackend;
 
     bool is1x1() const;
+    bool isWinogradApplicable(const Blob &input) const;
+    void forwardWinograd(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
+    void forwardInt8(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
     virtual void computeInpOutShape(const Blob &inpBlob);
+    virtual void chooseGemmBackend(int type);
 
     template<typename XMat>
     void forward_(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
     void im2col(const  Mat &srcImg,  Mat &dstCol);
     void im2col(const UMat &srcImg, UMat &dstCol);
+    void applyActivation(Mat &dst) const;
+    void applyActivation(UMat &dst) const;
 };
 
 class DeConvolutionLayerImpl : public ConvolutionLayerImpl
@@ -86,10 +109,13 @@ class DeConvolutionLayerImpl : public ConvolutionLayerImpl
 public:
     DeConvolutionLayerImpl();
     virtual void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
+    virtual bool setActivation(const Ptr<ActivationFunction> &activ);
+    virtual bool setInt8InputRange(float maxAbs);
 
 protected:
 
     virtual void computeInpOutShape(const Blob &inpBlob);
+    virtual void chooseGemmBackend(int type);
 
     template<typename XMat>
     void forward_(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
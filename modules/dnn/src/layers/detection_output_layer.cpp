@@ -42,8 +42,10 @@
 #include "../precomp.hpp"
 #include "layers_common.hpp"
 #include "detection_output_layer.hpp"
+#include <opencv2/core/hal/intrin.hpp>
 #include <float.h>
 #include <string>
+#include <algorithm>
 
 namespace cv
 {
@@ -74,6 +76,15 @@ bool SortScorePairDescend(const std::pair<float, T>& pair1,
 {
     return pair1.first > pair2.first;
 }
+
+// Descending scores, the equal scores in the order of their indices, so a
+// partial sort selects the same pairs as a stable sort.
+inline bool SortScoreIndexPairDescend(const std::pair<float, int>& pair1,
+                                      const std::pair<float, int>& pair2)
+{
+    return pair1.first > pair2.first ||
+           (pair1.first == pair2.first && pair1.second < pair2.second);
+}
 }
 
 const std::string DetectionOutputLayer::_layerName = std::string("DetectionOutput");
@@ -178,6 +189,49 @@ void DetectionOutputLayer::allocate(const std::vector<Blob*> &inputs,
     outputs[0].create(BlobShape(outputShape));
 }
 
+// Non maximum suppression of the classes of all the images, every (image, class)
+// pair is independent of the others and only writes its own indices.
+class DetectionNMSInvoker : public ParallelLoopBody
+{
+public:
+    DetectionNMSInvoker(DetectionOutputLayer& _layer,
+                        const std::vector<const Mat*>& _bboxes,
+                        const std::vector<const std::vector<float>*>& _scores,
+                        float _scoreThreshold, float _nmsThreshold, int _topK,
+                        std::vector<std::vector<int> >& _indices)
+        : layer(_layer), bboxes(_bboxes), scores(_scores), scoreThreshold(_scoreThreshold),
+          nmsThreshold(_nmsThreshold), topK(_topK), indices(_indices)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        std::vector<std::pair<float, int> > scoreIndexVec;
+        for (int i = range.start; i < range.end; ++i)
+        {
+            if (!scores[i])
+            {
+                // Background class.
+                continue;
+            }
+            scoreIndexVec.clear();
+            layer.GetMaxScoreIndex(*scores[i], scoreThreshold, topK, &scoreIndexVec);
+            DetectionOutputLayer::ApplyNMSPacked(*bboxes[i], scoreIndexVec, nmsThreshold, &indices[i]);
+        }
+    }
+
+private:
+    DetectionOutputLayer& layer;
+    const std::vector<const Mat*>& bboxes;
+    const std::vector<const std::vector<float>*>& scores;
+    float scoreThreshold;
+    float nmsThreshold;
+    int topK;
+    std::vector<std::vector<int> >& indices;
+
+    DetectionNMSInvoker& operator=(const DetectionNMSInvoker&); // to quiet MSVC
+};
+
 void DetectionOutputLayer::forward(std::vector<Blob*> &inputs,
                                    std::vector<Blob> &outputs)
 {
@@ -207,15 +261,22 @@ void DetectionOutputLayer::forward(std::vector<Blob*> &inputs,
                     _shareLocation, _numLocClasses, _backgroundLabelId,
                     _codeType, _varianceEncodedInTarget, &allDecodedBBoxes);
 
-    int numKept = 0;
-    std::vector<std::map<int, std::vector<int> > > allIndices;
+    // Pack the decoded bboxes of every image and location label, and look up
+    // the bboxes and the scores of every class before the parallel nms.
+    std::vector<std::map<int, Mat> > allPackedBBoxes(_num);
+    std::vector<const Mat*> classBBoxes(_num * _numClasses, (const Mat*)0);
+    std::vector<const std::vector<float>*> classScores(_num * _numClasses,
+                                                       (const std::vector<float>*)0);
     for (int i = 0; i < _num; ++i)
     {
         const LabelBBox& decodeBBoxes = allDecodedBBoxes[i];
+        for (LabelBBox::const_iterator it = decodeBBoxes.begin(); it != decodeBBoxes.end(); ++it)
+        {
+            PackBBoxes(it->second, allPackedBBoxes[i][it->first]);
+        }
+
         const std::map<int, std::vector<float> >& confidenceScores =
             allConfidenceScores[i];
-        std::map<int, std::vector<int> > indices;
-        int numDetections = 0;
         for (int c = 0; c < (int)_numClasses; ++c)
         {
             if (c == _backgroundLabelId)
@@ -231,16 +292,40 @@ void DetectionOutputLayer::forward(std::vector<Blob*> &inputs,
 
             const std::vector<float>& scores = confidenceScores.find(c)->second;
             int label = _shareLocation ? -1 : c;
-            if (decodeBBoxes.find(label) == decodeBBoxes.end())
+            if (allPackedBBoxes[i].find(label) == allPackedBBoxes[i].end())
             {
                 // Something bad happened if there are no predictions for current label.
                 util::make_error<int>("Could not find location predictions for label ", label);
                 continue;
             }
-            const std::vector<caffe::NormalizedBBox>& bboxes =
-                decodeBBoxes.find(label)->second;
-            ApplyNMSFast(bboxes, scores, _confidenceThreshold, _nmsThreshold,
-                         _topK, &(indices[c]));
+            const Mat& bboxes = allPackedBBoxes[i].find(label)->second;
+            CV_Assert((size_t)bboxes.cols == scores.size());
+            classScores[i * _numClasses + c] = &scores;
+            classBBoxes[i * _numClasses + c] = &bboxes;
+        }
+    }
+
+    std::vector<std::vector<int> > classIndices(_num * _numClasses);
+    parallel_for_(Range(0, (int)classIndices.size()),
+                  DetectionNMSInvoker(*this, classBBoxes, classScores, _confidenceThreshold,
+                                      _nmsThreshold, _topK, classIndices));
+
+    int numKept = 0;
+    std::vector<std::map<int, std::vector<int> > > allIndices;
+    for (int i = 0; i < _num; ++i)
+    {
+        const std::map<int, std::vector<float> >& confidenceScores =
+            allConfidenceScores[i];
+        std::map<int, std::vector<int> > indices;
+        int numDetections = 0;
+        for (int c = 0; c < (int)_numClasses; ++c)
+        {
+            if (c == _backgroundLabelId)
+            {
+                // Ignore background class.
+                continue;
+            }
+            indices[c].swap(classIndices[i * _numClasses + c]);
             numDetections += indices[c].size();
         }
         if (_keepTopK > -1 && numDetections > _keepTopK)
@@ -267,8 +352,9 @@ void DetectionOutputLayer::forward(std::vector<Blob*> &inputs,
                 }
             }
             // Keep outputs k results per image.
-            std::sort(scoreIndexPairs.begin(), scoreIndexPairs.end(),
-                      util::SortScorePairDescend<std::pair<int, int> >);
+            std::partial_sort(scoreIndexPairs.begin(), scoreIndexPairs.begin() + _keepTopK,
+                              scoreIndexPairs.end(),
+                              util::SortScorePairDescend<std::pair<int, int> >);
             scoreIndexPairs.resize(_keepTopK);
             // Store the new indices.
             std::map<int, std::vector<int> > newIndices;
@@ -619,12 +705,18 @@ void DetectionOutputLayer::GetConfidenceScores(
     for (int i = 0; i < num; ++i)
     {
         std::map<int, std::vector<float> >& labelScores = (*confPreds)[i];
+        std::vector<std::vector<float>*> classScores(numClasses);
+        for (int c = 0; c < numClasses; ++c)
+        {
+            classScores[c] = &labelScores[c];
+            classScores[c]->resize(numPredsPerClass);
+        }
         for (int p = 0; p < numPredsPerClass; ++p)
         {
             int startIdx = p * numClasses;
             for (int c = 0; c < numClasses; ++c)
             {
-                labelScores[c].push_back(confData[startIdx + c]);
+                (*classScores[c])[p] = confData[startIdx + c];
             }
         }
         confData += numPredsPerClass * numClasses;
@@ -645,33 +737,106 @@ void DetectionOutputLayer::ApplyNMSFast(const std::vector<caffe::NormalizedBBox>
     GetMaxScoreIndex(scores, score_threshold, top_k, &score_index_vec);
 
     // Do nms.
+    Mat packed;
+    PackBBoxes(bboxes, packed);
+    ApplyNMSPacked(packed, score_index_vec, nms_threshold, indices);
+}
+
+void DetectionOutputLayer::PackBBoxes(const std::vector<caffe::NormalizedBBox>& bboxes,
+                                      Mat& packed)
+{
+    int num = (int)bboxes.size();
+    packed.create(5, num, CV_32F);
+    if (num == 0)
+    {
+        return;
+    }
+    float* xmin = packed.ptr<float>(0);
+    float* ymin = packed.ptr<float>(1);
+    float* xmax = packed.ptr<float>(2);
+    float* ymax = packed.ptr<float>(3);
+    float* size = packed.ptr<float>(4);
+    for (int i = 0; i < num; ++i)
+    {
+        xmin[i] = bboxes[i].xmin();
+        ymin[i] = bboxes[i].ymin();
+        xmax[i] = bboxes[i].xmax();
+        ymax[i] = bboxes[i].ymax();
+        size[i] = BBoxSize(bboxes[i]);
+    }
+}
+
+void DetectionOutputLayer::ApplyNMSPacked(const Mat& packed,
+                                          const std::vector<std::pair<float, int> >& score_index_vec,
+                                          const float nms_threshold, std::vector<int>* indices)
+{
     indices->clear();
-    while (score_index_vec.size() != 0)
+    int num = (int)score_index_vec.size();
+    if (num == 0)
     {
-        const int idx = score_index_vec.front().second;
+        return;
+    }
+    CV_Assert(packed.type() == CV_32F && packed.rows == 5);
+    const float* xmin = packed.ptr<float>(0);
+    const float* ymin = packed.ptr<float>(1);
+    const float* xmax = packed.ptr<float>(2);
+    const float* ymax = packed.ptr<float>(3);
+    const float* size = packed.ptr<float>(4);
+
+    // The kept bboxes, packed in the same way, so a candidate is compared with
+    // several of them at once.
+    AutoBuffer<float> keptBuf(num * 5);
+    float* keptXmin = keptBuf;
+    float* keptYmin = keptXmin + num;
+    float* keptXmax = keptYmin + num;
+    float* keptYmax = keptXmax + num;
+    float* keptSize = keptYmax + num;
+    int numKept = 0;
+
+    for (int i = 0; i < num; ++i)
+    {
+        const int idx = score_index_vec[i].second;
+        const float x0 = xmin[idx], y0 = ymin[idx], x1 = xmax[idx], y1 = ymax[idx], s = size[idx];
+        // Same overlap as JaccardOverlap(bboxes[idx], bboxes[kept_idx]).
         bool keep = true;
-        for (size_t k = 0; k < indices->size(); ++k)
+        int k = 0;
+#if CV_SIMD128
+        v_float32x4 vx0 = v_setall_f32(x0), vy0 = v_setall_f32(y0);
+        v_float32x4 vx1 = v_setall_f32(x1), vy1 = v_setall_f32(y1);
+        v_float32x4 vs = v_setall_f32(s), vthreshold = v_setall_f32(nms_threshold);
+        v_float32x4 vzero = v_setzero_f32();
+        for (; keep && k <= numKept - 4; k += 4)
         {
-            if (keep)
-            {
-                const int kept_idx = (*indices)[k];
-                float overlap = JaccardOverlap(bboxes[idx], bboxes[kept_idx]);
-                keep = overlap <= nms_threshold;
-            }
-            else
+            v_float32x4 w = v_min(vx1, v_load(keptXmax + k)) - v_max(vx0, v_load(keptXmin + k));
+            v_float32x4 h = v_min(vy1, v_load(keptYmax + k)) - v_max(vy0, v_load(keptYmin + k));
+            v_float32x4 intersection = w * h;
+            v_float32x4 overlap = intersection / (vs + v_load(keptSize + k) - intersection);
+            keep = !v_check_any((w > vzero) & (h > vzero) & (overlap > vthreshold));
+        }
+#endif
+        for (; keep && k < numKept; ++k)
+        {
+            float w = std::min(x1, keptXmax[k]) - std::max(x0, keptXmin[k]);
+            float h = std::min(y1, keptYmax[k]) - std::max(y0, keptYmin[k]);
+            if (w > 0 && h > 0)
             {
-                break;
+                float intersection = w * h;
+                keep = intersection / (s + keptSize[k] - intersection) <= nms_threshold;
             }
         }
         if (keep)
         {
+            keptXmin[numKept] = x0;
+            keptYmin[numKept] = y0;
+            keptXmax[numKept] = x1;
+            keptYmax[numKept] = y1;
+            keptSize[numKept] = s;
+            ++numKept;
             indices->push_back(idx);
         }
-        score_index_vec.erase(score_index_vec.begin());
     }
 }
 
-
 void DetectionOutputLayer::GetMaxScoreIndex(
     const std::vector<float>& scores, const float threshold,const int top_k,
     std::vector<std::pair<float, int> >* score_index_vec)
@@ -685,15 +850,19 @@ void DetectionOutputLayer::GetMaxScoreIndex(
         }
     }
 
-    // Sort the score pair according to the scores in descending order
-    std::stable_sort(score_index_vec->begin(), score_index_vec->end(),
-                     util::SortScorePairDescend<int>);
-
-    // Keep top_k scores if needed.
+    // Sort the score pair according to the scores in descending order,
+    // only the top_k scores are ordered and kept if needed.
     if (top_k > -1 && top_k < (int)score_index_vec->size())
     {
+        std::partial_sort(score_index_vec->begin(), score_index_vec->begin() + top_k,
+                          score_index_vec->end(), util::SortScoreIndexPairDescend);
         score_index_vec->resize(top_k);
     }
+    else
+    {
+        std::sort(score_index_vec->begin(), score_index_vec->end(),
+                  util::SortScoreIndexPairDescend);
+    }
 }
 
 void DetectionOutputLayer::IntersectBBox(const caffe::NormalizedBBox& bbox1,
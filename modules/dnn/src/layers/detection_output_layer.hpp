@@ -163,6 +163,20 @@ public:
 
     void ApplyNMS(const bool* overlapped, const int num, std::vector<int>* indices);
 
+    // Store the bboxes as the rows xmin, ymin, xmax, ymax and size of a
+    // 5 x bboxes.size() matrix, for the vectorized overlaps of ApplyNMSPacked.
+    void PackBBoxes(const std::vector<caffe::NormalizedBBox>& bboxes, Mat& packed);
+
+    // Do non maximum suppression given the packed bboxes and the score
+    // indices, as returned by GetMaxScoreIndex.
+    //    packed: bboxes stored by PackBBoxes.
+    //    score_index_vec: the (score, index) pairs sorted in descending order.
+    //    nms_threshold: a threshold used in non maximum suppression.
+    //    indices: the kept indices of bboxes after nms.
+    static void ApplyNMSPacked(const Mat& packed,
+                               const std::vector<std::pair<float, int> >& score_index_vec,
+                               const float nms_threshold, std::vector<int>* indices);
+
     // Get confidence predictions from conf_data.
     //    conf_data: num x num_preds_per_class * num_classes blob.
     //    num: the number of images.
@@ -61,7 +61,7 @@ using std::tanh;
 using std::pow;
 
 template<typename Func>
-class ElementWiseLayer : public Func::Layer
+class ElementWiseLayer : public Func::Layer, public ActivationFunction
 {
     bool useOpenCL;
     Func func;
@@ -69,11 +69,11 @@ class ElementWiseLayer : public Func::Layer
     template<typename Dtype>
     class PBody : public cv::ParallelLoopBody
     {
-        Func &func;
+        const Func &func;
         Dtype *data;
     public:
 
-        PBody(Mat &mat, Func &func_) :
+        PBody(Mat &mat, const Func &func_) :
             func(func_), data(mat.ptr<Dtype>())
         {}
 
@@ -134,7 +134,7 @@ public:
             ker.set(2, ocl::KernelArg::PtrWriteOnly(dst));
 
             size_t gSize = src.total();
-            CV_Assert(ker.run(1, &gSize, &wgSize, true));
+            CV_Assert(ker.run(1, &gSize, &wgSize, false));
         }
     }
     #endif
@@ -147,19 +147,26 @@ public:
             Mat &dst = outputs[i].matRef();
             CV_Assert(src.ptr() == dst.ptr() && src.isContinuous());
 
-            Range sizeRange = Range(0, dst.total());
-            if (dst.type() == CV_32F)
-            {
-                cv::parallel_for_(sizeRange, PBody<float>(dst, func));
-            }
-            else if (dst.type() == CV_64F)
-            {
-                cv::parallel_for_(sizeRange, PBody<double>(dst, func));
-            }
-            else
-            {
-                CV_Error(Error::StsNotImplemented, "Only CV_32F and CV_64F blobs are supported");
-            }
+            apply(dst);
+        }
+    }
+
+    void apply(Mat &dst) const
+    {
+        CV_Assert(dst.isContinuous());
+
+        Range sizeRange = Range(0, dst.total());
+        if (dst.type() == CV_32F)
+        {
+            cv::parallel_for_(sizeRange, PBody<float>(dst, func));
+        }
+        else if (dst.type() == CV_64F)
+        {
+            cv::parallel_for_(sizeRange, PBody<double>(dst, func));
+        }
+        else
+        {
+            CV_Error(Error::StsNotImplemented, "Only CV_32F and CV_64F blobs are supported");
         }
     }
 };
@@ -51,6 +51,7 @@ namespace dnn
     {
         op = op_;
         coeffs = coeffs_;
+        useOpenCL = false;
     }
 
     void EltwiseLayerImpl::allocate(const std::vector<Blob *> &inputs, std::vector<Blob> &outputs)
@@ -60,56 +61,74 @@ namespace dnn
         CV_Assert(op == SUM || coeffs.size() == 0);
 
         const BlobShape &shape0 = inputs[0]->shape();
-        for (size_t i = 1; i < inputs.size(); ++i)
+        useOpenCL = false;
+        for (size_t i = 0; i < inputs.size(); ++i)
         {
             CV_Assert(shape0 == inputs[i]->shape());
+            useOpenCL |= inputs[i]->getState() == Blob::HEAD_AT_UMAT;
         }
+        useOpenCL &= ocl::useOpenCL();
+        int allocFlags = (useOpenCL) ? Blob::ALLOC_UMAT : Blob::ALLOC_MAT;
+
         outputs.resize(1);
-        outputs[0].create(shape0);
+        outputs[0].create(shape0, inputs[0]->type(), allocFlags);
     }
 
     void EltwiseLayerImpl::forward(std::vector<Blob *> &inputs, std::vector<Blob> &outputs)
     {
+        #ifdef HAVE_OPENCL
+        if (useOpenCL)
+            forward_<UMat>(inputs, outputs);
+        else
+        #endif
+            forward_<Mat>(inputs, outputs);
+
+        if (activ)
+            activ->apply(outputs[0].matRef(false));
+    }
+
+    template<typename XMat>
+    void EltwiseLayerImpl::forward_(std::vector<Blob *> &inputs, std::vector<Blob> &outputs)
+    {
+        XMat& output = outputs[0].getRef<XMat>();
+
         switch (op)
         {
         case SUM:
             {
                 CV_Assert(coeffs.size() == 0 || coeffs.size() == inputs.size());
-                Mat& output = outputs[0].matRef();
                 output.setTo(0.);
                 if (0 < coeffs.size())
                 {
                     for (size_t i = 0; i < inputs.size(); i++)
                     {
-                        output += inputs[i]->matRefConst() * coeffs[i];
+                        scaleAdd(inputs[i]->getRefConst<XMat>(), coeffs[i], output, output);
                     }
                 }
                 else
                 {
                     for (size_t i = 0; i < inputs.size(); i++)
                     {
-                        output += inputs[i]->matRefConst();
+                        add(output, inputs[i]->getRefConst<XMat>(), output);
                     }
                 }
             }
             break;
         case PROD:
             {
-                Mat& output = outputs[0].matRef();
                 output.setTo(1.);
                 for (size_t i = 0; i < inputs.size(); i++)
                 {
-                    output = output.mul(inputs[i]->matRefConst());
+                    multiply(output, inputs[i]->getRefConst<XMat>(), output);
                 }
             }
             break;
         case MAX:
             {
-                Mat& output = outputs[0].matRef();
-                cv::max(inputs[0]->matRefConst(), inputs[1]->matRefConst(), output);
+                cv::max(inputs[0]->getRefConst<XMat>(), inputs[1]->getRefConst<XMat>(), output);
                 for (size_t i = 2; i < inputs.size(); i++)
                 {
-                    cv::max(output, inputs[i]->matRefConst(), output);
+                    cv::max(output, inputs[i]->getRefConst<XMat>(), output);
                 }
             }
             break;
@@ -119,6 +138,15 @@ namespace dnn
         };
     }
 
+    bool EltwiseLayerImpl::setActivation(const Ptr<ActivationFunction> &activ_)
+    {
+        //fused activations are computed on the host only
+        if (useOpenCL && activ_)
+            return false;
+        activ = activ_;
+        return true;
+    }
+
     Ptr<EltwiseLayer> EltwiseLayer::create(EltwiseOp op, const std::vector<int> &coeffs)
     {
         return Ptr<EltwiseLayer>(new EltwiseLayerImpl(op, coeffs));
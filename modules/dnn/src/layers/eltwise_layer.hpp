@@ -43,19 +43,26 @@
 #define __OPENCV_DNN_LAYERS_ELTWISE_LAYER_HPP__
 #include "../precomp.hpp"
 #include <opencv2/dnn/all_layers.hpp>
+#include "layers_common.hpp"
 
 namespace cv
 {
 namespace dnn
 {
-    class EltwiseLayerImpl : public EltwiseLayer
+    class EltwiseLayerImpl : public EltwiseLayer, public ActivationFusable
     {
         EltwiseOp op;
         std::vector<int> coeffs;
+        Ptr<ActivationFunction> activ;
+        bool useOpenCL;
+
+        template<typename XMat>
+        void forward_(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
     public:
         EltwiseLayerImpl(EltwiseOp op, const std::vector<int> &coeffs);
         void allocate(const std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
         void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
+        bool setActivation(const Ptr<ActivationFunction> &activ);
     };
 }
 }
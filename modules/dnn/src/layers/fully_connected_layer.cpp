@@ -43,6 +43,8 @@
 #include "layers_common.hpp"
 #include "fully_connected_layer.hpp"
 #include "op_blas.hpp"
+#include "op_fp16.hpp"
+#include "opencl_kernels_dnn.hpp"
 #include <opencv2/dnn/shape_utils.hpp>
 #include <opencv2/core/ocl.hpp>
 
@@ -54,6 +56,7 @@ namespace dnn
 FullyConnectedLayerImpl::FullyConnectedLayerImpl(int axis_)
 {
     axis = axis_;
+    int8InputRange = 0;
 }
 
 void FullyConnectedLayerImpl::allocate(const std::vector<Blob*> &input, std::vector<Blob> &output)
@@ -71,9 +74,14 @@ void FullyConnectedLayerImpl::allocate(const std::vector<Blob*> &input, std::vec
 
     CV_Assert((size_t)innerSize == input[0]->total(axisCan));
     CV_Assert(!bias || (size_t)numOutput == blobs[1].total());
+    CV_Assert(blobs[0].type() != fp16::TYPE || dtype == CV_32F);
 
-    useOpenCL = ocl::useOpenCL();
-    int allocFlags = useOpenCL ? Blob::ALLOC_UMAT : Blob::ALLOC_UMAT;
+    useOpenCL = ocl::useOpenCL() && int8InputRange <= 0;
+    int allocFlags = useOpenCL ? Blob::ALLOC_UMAT : Blob::ALLOC_MAT;
+
+    gemmBackend.release();
+    if (!useOpenCL && int8InputRange <= 0 && blobs[0].type() != fp16::TYPE)
+        gemmBackend = selectGemmBackend(gemmBackendName, outerSize, numOutput, innerSize, dtype, GEMM_2_T);
 
     biasOnesBlob.create(Shape(outerSize, 1), dtype, allocFlags);
     biasOnesBlob.setTo(1);
@@ -89,14 +97,74 @@ void FullyConnectedLayerImpl::allocate(const std::vector<Blob*> &input, std::vec
 
 void FullyConnectedLayerImpl::forward(std::vector<Blob*> &input, std::vector<Blob> &output)
 {
+    if (int8InputRange > 0 && dtype == CV_32F)
+    {
+        forwardInt8(input, output);
+        return;
+    }
+
     #ifdef HAVE_OPENCL
-    if (useOpenCL)
+    bool halfWeights = blobs[0].type() == fp16::TYPE;
+    if (useOpenCL && halfWeights && forwardHalf_ocl(input, output))
+        return;
+
+    if (useOpenCL && !halfWeights)
         forward_<UMat>(input, output);
     else
     #endif
         forward_<Mat>(input, output);
 }
 
+//computes dst = src * weights^T, the weights may be stored in half precision
+static void gemmWeights(const Ptr<GemmBackend> &backend, const Mat &src, const Mat &weights, Mat &dst)
+{
+    if (weights.type() == fp16::TYPE)
+        fp16::gemmHalfBt(src, weights, dst);
+    else
+        dnn::gemm(backend, src, weights, 1, dst, 0, GEMM_2_T);
+}
+
+static void gemmWeights(const Ptr<GemmBackend> &backend, const UMat &src, const UMat &weights, UMat &dst)
+{
+    dnn::gemm(backend, src, weights, 1, dst, 0, GEMM_2_T);
+}
+
+#ifdef HAVE_OPENCL
+bool FullyConnectedLayerImpl::forwardHalf_ocl(std::vector<Blob*> &input, std::vector<Blob> &output)
+{
+    const UMat &weight = blobs[0].umatRefConst();
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        //a kernel can't be enqueued again until its previous run is finished
+        ocl::Kernel kernel("MatMulHalfBt", ocl::dnn::gemm_half_oclsrc);
+        if (kernel.empty())
+            return false;
+
+        UMat srcMat = reshaped(input[i]->umatRefConst(), Shape(outerSize, innerSize));
+        UMat dstMat = reshaped(output[i].umatRef(), Shape(outerSize, numOutput));
+
+        kernel.args(outerSize, numOutput, innerSize, ocl::KernelArg::PtrReadOnly(srcMat),
+                    ocl::KernelArg::PtrReadOnly(weight), ocl::KernelArg::PtrWriteOnly(dstMat));
+
+        size_t globalSize[] = {(size_t)numOutput, (size_t)outerSize};
+        if (!kernel.run(2, globalSize, NULL, false))
+            return false;
+
+        if (bias)
+            dnn::gemm(biasOnesBlob.umatRefConst(), blobs[1].umatRefConst(), 1, dstMat, 1);
+
+        if (activ)
+            activ->apply(output[i].matRef(false));
+    }
+    return true;
+}
+#else
+bool FullyConnectedLayerImpl::forwardHalf_ocl(std::vector<Blob*>&, std::vector<Blob>&)
+{
+    return false;
+}
+#endif
+
 template<typename XMat>
 void FullyConnectedLayerImpl::forward_(std::vector<Blob *> &input, std::vector<Blob> &output)
 {
@@ -112,13 +180,85 @@ void FullyConnectedLayerImpl::forward_(std::vector<Blob *> &input, std::vector<B
     {
         const XMat srcMat = reshaped(input[i]->getRefConst<XMat>(), Shape(outerSize, innerSize));
         XMat dstMat = reshaped(output[i].getRef<XMat>(), Shape(outerSize, numOutput));
-        dnn::gemm(srcMat, weight, 1, dstMat, 0, GEMM_2_T);
+        gemmWeights(gemmBackend, srcMat, weight, dstMat);
 
         if (bias)
             dnn::gemm(*biasOnesMat, *biasMat, 1, dstMat, 1);
+
+        if (activ)
+            activ->apply(output[i].matRef(false));
+    }
+}
+
+void FullyConnectedLayerImpl::setGemmBackend(const String &name)
+{
+    gemmBackendName = name;
+}
+
+bool FullyConnectedLayerImpl::convertWeightsToHalf()
+{
+    if (int8InputRange > 0 || blobs[0].type() != CV_32F)
+        return blobs[0].type() == fp16::TYPE;
+
+    blobs[0] = blobs[0].toHalf();
+    return true;
+}
+
+bool FullyConnectedLayerImpl::setInt8InputRange(float maxAbs)
+{
+    if (maxAbs > 0 && (blobs[0].type() != CV_32F || (bias && blobs[1].type() != CV_32F)))
+        return false;
+
+    int8InputRange = std::max(maxAbs, 0.f);
+    if (int8InputRange > 0)
+    {
+        Mat weightsInt8;
+        quantizeRowsInt8(blobs[0].matRefConst(), weightsInt8, weightsScales);
+        transpose(weightsInt8, weightsInt8T);
+    }
+    else
+    {
+        weightsInt8T.release();
+        weightsScales.release();
+    }
+    return true;
+}
+
+void FullyConnectedLayerImpl::forwardInt8(std::vector<Blob*> &input, std::vector<Blob> &output)
+{
+    const float *biasPtr = (bias) ? blobs[1].matRefConst().ptr<float>() : NULL;
+    const float *wScales = weightsScales.ptr<float>();
+    double inpScale = int8InputRange / 127.;
+
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        const Mat srcMat = reshaped(input[i]->matRefConst(), Shape(outerSize, innerSize));
+        Mat dstMat = reshaped(output[i].matRef(), Shape(outerSize, numOutput));
+
+        srcMat.convertTo(srcInt8, CV_8S, 1. / inpScale);
+        gemmInt8(srcInt8, weightsInt8T, accInt32);
+
+        for (int r = 0; r < outerSize; r++)
+        {
+            const int *acc = accInt32.ptr<int>(r);
+            float *dst = dstMat.ptr<float>(r);
+            for (int c = 0; c < numOutput; c++)
+                dst[c] = (float)(acc[c] * wScales[c] * inpScale) + ((biasPtr) ? biasPtr[c] : 0.f);
+        }
+
+        if (activ)
+            activ->apply(output[i].matRef(false));
     }
 }
 
+bool FullyConnectedLayerImpl::setActivation(const Ptr<ActivationFunction> &activ_)
+{
+    if (activ_ && useOpenCL)
+        return false;
+    activ = activ_;
+    return true;
+}
+
 
 Ptr<InnerProductLayer> InnerProductLayer::create(int axis)
 {
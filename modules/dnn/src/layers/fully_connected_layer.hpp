@@ -43,18 +43,31 @@
 #define __OPENCV_DNN_LAYERS_FULLY_CONNECTED_LAYER_HPP__
 #include "../precomp.hpp"
 #include <opencv2/dnn/all_layers.hpp>
+#include "layers_common.hpp"
+#include "op_blas.hpp"
 
 namespace cv
 {
 namespace dnn
 {
 
-class FullyConnectedLayerImpl : public InnerProductLayer
+class FullyConnectedLayerImpl : public InnerProductLayer, public ActivationFusable, public Int8Quantizable,
+                                public GemmBackendConfigurable, public HalfPrecisionStorable
 {
     int axisCan, dtype;
     int numOutput, innerSize, outerSize;
     bool bias, useOpenCL;
     Blob biasOnesBlob;
+    Ptr<ActivationFunction> activ;
+
+    float int8InputRange;
+    Mat weightsInt8T, weightsScales, srcInt8, accInt32;
+
+    String gemmBackendName;
+    Ptr<GemmBackend> gemmBackend;
+
+    void forwardInt8(std::vector<Blob*> &input, std::vector<Blob> &output);
+    bool forwardHalf_ocl(std::vector<Blob*> &input, std::vector<Blob> &output);
 
     template<typename XMat>
     void forward_(std::vector<Blob*> &input, std::vector<Blob> &output);
@@ -64,6 +77,10 @@ public:
     FullyConnectedLayerImpl(int axisCan = 1);
     void allocate(const std::vector<Blob*> &input, std::vector<Blob> &output);
     void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
+    bool setActivation(const Ptr<ActivationFunction> &activ);
+    bool setInt8InputRange(float maxAbs);
+    void setGemmBackend(const String &name);
+    bool convertWeightsToHalf();
 };
 
 }
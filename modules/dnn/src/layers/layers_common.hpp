@@ -54,6 +54,58 @@ void getConvolutionKernelParams(LayerParams &params, int &kernelH, int &kernelW,
 
 void getPoolingKernelParams(LayerParams &params, int &kernelH, int &kernelW, bool &globalPooling, int &padH, int &padW, int &strideH, int &strideW);
 
+//Elementwise activation which can be applied by the preceding layer on its outputs
+class ActivationFunction
+{
+public:
+    //! Applies activation in-place, @p data must be continuous CPU array of CV_32F or CV_64F type
+    virtual void apply(Mat &data) const = 0;
+    virtual ~ActivationFunction() {}
+};
+
+//Layer which is able to fuse the following activation layer into its output stage
+class ActivationFusable
+{
+public:
+    //! Returns false if the activation can't be fused in current mode; empty @p activ disables fusion
+    virtual bool setActivation(const Ptr<ActivationFunction> &activ) = 0;
+    virtual ~ActivationFusable() {}
+};
+
+//Layer which supports 8-bit integer computations with symmetrically quantized inputs and weights
+class Int8Quantizable
+{
+public:
+    /** @brief Switches layer to int8 mode for inputs lying within [-maxAbs; maxAbs].
+     *  @details Non-positive @p maxAbs switches layer back to floating point mode.
+     *  Returns false if int8 computations aren't supported in current mode.
+     */
+    virtual bool setInt8InputRange(float maxAbs) = 0;
+    virtual ~Int8Quantizable() {}
+};
+
+//Layer which can store its weights in half precision floats
+class HalfPrecisionStorable
+{
+public:
+    /** @brief Converts the learned weights to half precision, computations are still performed in single precision.
+     *  @details Returns false if half precision weights aren't supported in current mode.
+     */
+    virtual bool convertWeightsToHalf() = 0;
+    virtual ~HalfPrecisionStorable() {}
+};
+
+//Layer which computes the heavy part via GEMM and can choose its implementation
+class GemmBackendConfigurable
+{
+public:
+    /** @brief Sets name of GEMM backend used since the next allocate() call.
+     *  @details Empty name means default choice, "auto" means selection by benchmarking.
+     */
+    virtual void setGemmBackend(const String &name) = 0;
+    virtual ~GemmBackendConfigurable() {}
+};
+
 }
 }
 
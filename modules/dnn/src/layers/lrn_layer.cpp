@@ -46,6 +46,7 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/core/ocl.hpp>
 #include <opencv2/dnn/shape_utils.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 #include <algorithm>
 
 namespace cv
@@ -67,8 +68,6 @@ void LRNLayerImpl::allocate(const std::vector<Blob*> &inputs, std::vector<Blob>
     CV_Assert(type == CHANNEL_NRM || type == SPATIAL_NRM);
     useOpenCL = cv::ocl::useOpenCL();
 
-    if (type == SPATIAL_NRM && !useOpenCL)
-        buf.create(inputs[0]->shape().slice(2), inputs[0]->type(), Blob::ALLOC_MAT);
     if (type == CHANNEL_NRM && useOpenCL)
         buf.create(inputs[0]->shape().slice(2), inputs[0]->type(), Blob::ALLOC_UMAT);
 
@@ -101,10 +100,115 @@ static XMat getPlane(XMat &m, int n, int cn)
     return reshaped(slice(m, n, cn), BlobShape::like(m).slice(2));
 }
 
+//acc[i] += sign * src[i]^2
+static void accumulateSquares(float *acc, const float *src, int len, float sign)
+{
+    int i = 0;
+#if CV_SIMD128
+    v_float32x4 vsign = v_setall_f32(sign);
+    for (; i <= len - 4; i += 4)
+    {
+        v_float32x4 x = v_load(src + i);
+        v_store(acc + i, v_load(acc + i) + vsign * x * x);
+    }
+#endif
+    for (; i < len; i++)
+        acc[i] += sign * src[i] * src[i];
+}
+
+/* Cross-channel LRN: dst = src * (1 + alpha/size * sum(src^2))^-beta.
+ * The images of the batch are split into blocks of pixels distributed between threads,
+ * each block slides the accumulator of squares along the channels.
+ */
+class ChannelLRNInvoker : public ParallelLoopBody
+{
+public:
+    enum { BLOCK_SIZE = 1024 };
+
+    ChannelLRNInvoker(Blob &src, Blob &dst, int size_, double alpha_, double beta_)
+        : srcData(src.ptrf()), dstData(dst.ptrf()), channels(src.channels()),
+          planeSize(src.rows() * src.cols()), size(size_), alpha(alpha_), beta(beta_)
+    {
+        blocksPerImage = (planeSize + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    }
+
+    int totalBlocks(int num) const { return num * blocksPerImage; }
+
+    void operator()(const Range &range) const
+    {
+        int ksize = (size - 1) / 2;
+        float scaleAlpha = (float)(alpha / size);
+        bool fastPow = (beta == 0.75);
+        AutoBuffer<float> buffer(2 * BLOCK_SIZE);
+        float *accum = buffer, *scale = accum + BLOCK_SIZE;
+
+        for (int b = range.start; b < range.end; b++)
+        {
+            int n = b / blocksPerImage;
+            int start = (b % blocksPerImage) * BLOCK_SIZE;
+            int len = std::min((int)BLOCK_SIZE, planeSize - start);
+            const float *src = srcData + (size_t)n * channels * planeSize + start;
+            float *dst = dstData + (size_t)n * channels * planeSize + start;
+
+            std::fill(accum, accum + len, 0.f);
+            for (int cn = 0; cn < std::min(ksize, channels); cn++)
+                accumulateSquares(accum, src + (size_t)cn * planeSize, len, 1.f);
+
+            for (int cn = 0; cn < channels; cn++)
+            {
+                if (cn + ksize < channels)
+                    accumulateSquares(accum, src + (size_t)(cn + ksize) * planeSize, len, 1.f);
+                if (cn - ksize - 1 >= 0)
+                    accumulateSquares(accum, src + (size_t)(cn - ksize - 1) * planeSize, len, -1.f);
+
+                const float *srcPlane = src + (size_t)cn * planeSize;
+                float *dstPlane = dst + (size_t)cn * planeSize;
+                int i = 0;
+                if (fastPow)
+                {
+                    //x^-0.75 = 1 / (sqrt(x) * sqrt(sqrt(x)))
+#if CV_SIMD128
+                    v_float32x4 one = v_setall_f32(1.f), va = v_setall_f32(scaleAlpha);
+                    for (; i <= len - 4; i += 4)
+                    {
+                        v_float32x4 sq = v_sqrt(one + va * v_load(accum + i));
+                        v_store(dstPlane + i, v_load(srcPlane + i) / (sq * v_sqrt(sq)));
+                    }
+#endif
+                    for (; i < len; i++)
+                    {
+                        float sq = std::sqrt(1.f + scaleAlpha * accum[i]);
+                        dstPlane[i] = srcPlane[i] / (sq * std::sqrt(sq));
+                    }
+                }
+                else
+                {
+                    for (; i < len; i++)
+                        scale[i] = 1.f + scaleAlpha * accum[i];
+                    Mat scaleMat(1, len, CV_32F, scale);
+                    cv::pow(scaleMat, -beta, scaleMat);
+                    cv::multiply(Mat(1, len, CV_32F, (void*)srcPlane), scaleMat, Mat(1, len, CV_32F, dstPlane));
+                }
+            }
+        }
+    }
+
+private:
+    const float *srcData;
+    float *dstData;
+    int channels, planeSize, blocksPerImage;
+    int size;
+    double alpha, beta;
+};
+
 void LRNLayerImpl::channelNoramlization(Blob &src, Blob &dst)
 {
     if (!useOpenCL)
-        channelNoramlization_<Mat>(src, dst);
+    {
+        CV_Assert(src.type() == CV_32F);
+        ChannelLRNInvoker invoker(src, dst, size, alpha, beta);
+        parallel_for_(Range(0, invoker.totalBlocks(src.num())), invoker);
+    }
     else
     {
         //channelNoramlization_ocl(src.getRefConst<UMat>(), dst.getRef<UMat>()); //consumes a lot of memory
@@ -140,8 +244,8 @@ void LRNLayerImpl::channelNoramlization_(Blob &srcBlob, Blob &dstBlob)
             if (cn - ksize - 1 >= 0)
             {
                 //subtractSquare
-                XMat left = getPlane(srcMat, n, cn - ksize - 1);
-                cv::pow(left, 2, left);
+                XMat left;
+                cv::multiply(getPlane(srcMat, n, cn - ksize - 1), getPlane(srcMat, n, cn - ksize - 1), left);
                 cv::subtract(accum, left, accum);
             }
 
@@ -178,14 +282,14 @@ bool LRNLayerImpl::channelNoramlization_ocl(const UMat &src, UMat &dst)
     kerScale.args((int)nthreads,
                   ocl::KernelArg::PtrReadOnly(src), shape[0], shape[1], shape[2], shape[3],
                   size, (float)(alpha/size), (float)ksize, ocl::KernelArg::PtrWriteOnly(scaleBuf));
-    if (!kerScale.run(1, &nthreads, &wgSize, true))
+    if (!kerScale.run(1, &nthreads, &wgSize, false))
         return false;
 
     nthreads = (size_t)shape.total();
     kerOutput.args((int)nthreads,
                    ocl::KernelArg::PtrReadOnly(src), ocl::KernelArg::PtrReadOnly(scaleBuf),
                    -beta, ocl::KernelArg::PtrWriteOnly(dst) );
-    if (!kerOutput.run(1, &nthreads, &wgSize, true))
+    if (!kerOutput.run(1, &nthreads, &wgSize, false))
         return false;
 
     return true;
@@ -196,22 +300,49 @@ bool LRNLayerImpl::channelNoramlization_ocl(const UMat &src, UMat &dst)
 #endif
 }
 
+//Spatial LRN of the independent planes distributed between threads
+class SpatialLRNInvoker : public ParallelLoopBody
+{
+public:
+    SpatialLRNInvoker(Blob &src, Blob &dst, int size_, double alpha_, double beta_)
+        : srcData(src.ptrf()), dstData(dst.ptrf()), rows(src.rows()), cols(src.cols()),
+          size(size_), alpha(alpha_), beta(beta_) {}
+
+    void operator()(const Range &range) const
+    {
+        for (int plane = range.start; plane < range.end; plane++)
+        {
+            //TODO: fix cv::boxFilter with BORDER_ISOLATED flag in CPU mode, raw wrappers are used instead of ROIs
+            Mat src(rows, cols, CV_32F, (void*)(srcData + (size_t)plane * rows * cols));
+            Mat dst(rows, cols, CV_32F, dstData + (size_t)plane * rows * cols);
+
+            cv::sqrBoxFilter(src, dst, dst.depth(), Size(size, size), Point(-1, -1), false, BORDER_CONSTANT);
+            dst.convertTo(dst, dst.type(), alpha/(size*size), 1);
+            cv::pow(dst, -beta, dst);
+            cv::multiply(src, dst, dst);
+        }
+    }
+
+private:
+    const float *srcData;
+    float *dstData;
+    int rows, cols;
+    int size;
+    double alpha, beta;
+};
+
 void LRNLayerImpl::spatialNormalization(Blob &src, Blob &dst)
 {
     if (!useOpenCL)
-        spatialNormalization_<Mat>(src, dst);
+    {
+        CV_Assert(src.type() == CV_32F);
+        SpatialLRNInvoker invoker(src, dst, size, alpha, beta);
+        parallel_for_(Range(0, src.num() * src.channels()), invoker);
+    }
     else
         spatialNormalization_<UMat>(src, dst);
 }
 
-//TODO: fix cv::boxFilter with BORDER_ISOLATED flag in CPU mode
-template<>
-void LRNLayerImpl::sqrBoxFilter_<Mat>(const Mat &src, Mat &dst)
-{
-    Mat srcRawWrapper(src.rows, src.cols, src.type(), src.data, src.step[0]);
-    cv::sqrBoxFilter(srcRawWrapper, dst, dst.depth(), Size(size, size), Point(-1, -1), false, BORDER_CONSTANT);
-}
-
 template<>
 void LRNLayerImpl::sqrBoxFilter_<UMat>(const UMat &src, UMat &dst)
 {
@@ -43,6 +43,7 @@
 #include "layers_common.hpp"
 #include "normalize_bbox_layer.hpp"
 #include "op_blas.hpp"
+#include <opencv2/core/ocl.hpp>
 
 #include <float.h>
 #include <algorithm>
@@ -99,6 +100,7 @@ NormalizeBBoxLayer::NormalizeBBoxLayer(LayerParams &params) : Layer(params)
     _eps = getParameter<float>(params, "eps", 0, false, 1e-10f);
     _across_spatial = getParameter<bool>(params, "across_spatial");
     _channel_shared = getParameter<bool>(params, "channel_shared");
+    useOpenCL = false;
 }
 
 void NormalizeBBoxLayer::checkInputs(const std::vector<Blob*> &inputs)
@@ -133,14 +135,23 @@ void NormalizeBBoxLayer::allocate(const std::vector<Blob*> &inputs, std::vector<
 
     _scale = blobs[0];
 
+    useOpenCL = ocl::useOpenCL() && inputs[0]->getState() == Blob::HEAD_AT_UMAT;
+    int allocFlags = (useOpenCL) ? Blob::ALLOC_UMAT : Blob::ALLOC_MAT;
+
     for(size_t i = 0; i < inputs.size(); i++)
     {
-        outputs[i].create(BlobShape(inputs[0]->shape()));
+        outputs[i].create(BlobShape(inputs[0]->shape()), inputs[0]->type(), allocFlags);
     }
 }
 
 void NormalizeBBoxLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
 {
+    if (useOpenCL)
+    {
+        forward_ocl(inputs, outputs);
+        return;
+    }
+
     Mat zeroBuffer(_channels, _channelSize, CV_32F, Scalar(0));
     Mat absDiff;
 
@@ -197,5 +208,52 @@ void NormalizeBBoxLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &
         }
     }
 }
+void NormalizeBBoxLayer::forward_ocl(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
+{
+    int planeSz[] = {(int)(_num * _channels), (int)_channelSize};
+    UMat buffer, norm;
+
+    for (size_t j = 0; j < inputs.size(); j++)
+    {
+        UMat srcPlanes = inputs[j]->umatRefConst().reshape(1, 2, planeSz);
+        UMat dstPlanes = outputs[j].umatRef(true).reshape(1, 2, planeSz);
+
+        for (size_t n = 0; n < _num; ++n)
+        {
+            Range channels((int)(n * _channels), (int)((n + 1) * _channels));
+            UMat src = srcPlanes.rowRange(channels);
+            UMat dst = dstPlanes.rowRange(channels);
+
+            multiply(src, src, buffer);
+
+            if (_across_spatial)
+            {
+                // add eps to avoid overflow
+                double absSum = sum(buffer)[0] + _eps;
+                src.convertTo(dst, -1, 1.0 / sqrt(absSum));
+            }
+            else
+            {
+                // sum of squares over channels: 1 x _channelSize
+                reduce(buffer, norm, 0, REDUCE_SUM);
+                sqrt(norm, norm);
+                repeat(norm, (int)_channels, 1, buffer);
+                divide(src, buffer, dst);
+            }
+
+            // scale the output
+            if (_channel_shared)
+            {
+                dst.convertTo(dst, -1, _scale.matRefConst().at<float>(0, 0));
+            }
+            else
+            {
+                // _scale: _channels x 1
+                repeat(_scale.umatRefConst().reshape(1, (int)_channels), 1, (int)_channelSize, buffer);
+                multiply(dst, buffer, dst);
+            }
+        }
+    }
+}
 }
 }
@@ -60,6 +60,8 @@ class NormalizeBBoxLayer : public Layer
     bool _across_spatial;
     bool _channel_shared;
 
+    bool useOpenCL;
+
     size_t _num;
     size_t _channels;
     size_t _rows;
@@ -75,6 +77,7 @@ public:
     NormalizeBBoxLayer(LayerParams &params);
     void allocate(const std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
     void forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
+    void forward_ocl(std::vector<Blob*> &inputs, std::vector<Blob> &outputs);
 
     void checkInputs(const std::vector<Blob*> &inputs);
 
@@ -5,6 +5,8 @@
 #endif
 
 #include <iostream>
+#include <float.h>
+#include <map>
 
 namespace cv
 {
@@ -97,17 +99,16 @@ public:
     double alpha, beta;
 };
 
-void gemmCPU(const Mat &A, const Mat &B, double alpha, Mat &C, double beta, int flags /*= 0*/)
+static void gemmTiled(const Mat &A, const Mat &B, double alpha, Mat &C, double beta)
+{
+    GEMMInvoker invoker(&A, &B, alpha, &C, beta);
+    double granularity = 10000000./((double)A.rows*A.cols);
+    parallel_for_(Range(0, B.cols), invoker, granularity);
+}
+
+#if HAVE_CBLAS
+static void gemmCblas(const Mat &A, const Mat &B, double alpha, Mat &C, double beta, int flags)
 {
-    if( C.type() == CV_32F && flags == 0 )
-    {
-        GEMMInvoker invoker(&A, &B, alpha, &C, beta);
-        double granularity = 10000000./((double)A.rows*A.cols);
-        parallel_for_(Range(0, B.cols), invoker, granularity);
-    }
-    else
-    {
-    #if HAVE_CBLAS
     bool transA = static_cast<bool>(flags & GEMM_1_T);
     bool transB = static_cast<bool>(flags & GEMM_2_T);
     bool transC = static_cast<bool>(flags & GEMM_3_T);
@@ -144,12 +145,247 @@ void gemmCPU(const Mat &A, const Mat &B, double alpha, Mat &C, double beta, int
     {
         CV_Error(Error::BadDepth, "Only floating point types are supported");
     }
+}
+#endif
+
+void gemmCPU(const Mat &A, const Mat &B, double alpha, Mat &C, double beta, int flags /*= 0*/)
+{
+    if( C.type() == CV_32F && flags == 0 )
+    {
+        gemmTiled(A, B, alpha, C, beta);
+    }
+    else
+    {
+    #if HAVE_CBLAS
+    gemmCblas(A, B, alpha, C, beta, flags);
     #else
     cv::gemm(A, B, alpha, C, beta, C, flags);
     #endif
     }
 }
 
+class TiledGemmBackend : public GemmBackend
+{
+public:
+    String name() const { return "tiled"; }
+
+    bool isApplicable(const Mat &A, const Mat &B, const Mat &C, int flags) const
+    {
+        return flags == 0 && A.type() == CV_32F && B.type() == CV_32F && C.type() == CV_32F &&
+               A.data != C.data && B.data != C.data;
+    }
+
+    void gemm(const Mat &A, const Mat &B, double alpha, Mat &C, double beta, int) const
+    {
+        gemmTiled(A, B, alpha, C, beta);
+    }
+};
+
+#if HAVE_CBLAS
+class CblasGemmBackend : public GemmBackend
+{
+public:
+    String name() const { return "cblas"; }
+
+    bool isApplicable(const Mat &A, const Mat &B, const Mat &C, int flags) const
+    {
+        return !(flags & GEMM_3_T) && (C.type() == CV_32F || C.type() == CV_64F) &&
+               A.type() == C.type() && B.type() == C.type() &&
+               A.isContinuous() && B.isContinuous() && C.isContinuous() &&
+               A.data != C.data && B.data != C.data;
+    }
+
+    void gemm(const Mat &A, const Mat &B, double alpha, Mat &C, double beta, int flags) const
+    {
+        //the library uses own thread pool, keep it in line with OpenCV settings
+        int numThreads = cv::getNumThreads();
+        if (getBlasThreads() != numThreads)
+            setBlasThreads(numThreads);
+        gemmCblas(A, B, alpha, C, beta, flags);
+    }
+};
+#endif
+
+class OpenCVGemmBackend : public GemmBackend
+{
+public:
+    String name() const { return "opencv"; }
+
+    bool isApplicable(const Mat &A, const Mat &B, const Mat &C, int) const
+    {
+        return (C.type() == CV_32F || C.type() == CV_64F) && A.type() == C.type() && B.type() == C.type();
+    }
+
+    void gemm(const Mat &A, const Mat &B, double alpha, Mat &C, double beta, int flags) const
+    {
+        cv::gemm(A, B, alpha, C, beta, C, flags);
+    }
+};
+
+const std::vector<Ptr<GemmBackend> > &getGemmBackends()
+{
+    static std::vector<Ptr<GemmBackend> > backends;
+    static Mutex mtx;
+
+    AutoLock lock(mtx);
+    if (backends.empty())
+    {
+        backends.push_back(Ptr<GemmBackend>(new TiledGemmBackend()));
+    #if HAVE_CBLAS
+        backends.push_back(Ptr<GemmBackend>(new CblasGemmBackend()));
+    #endif
+        backends.push_back(Ptr<GemmBackend>(new OpenCVGemmBackend()));
+    }
+    return backends;
+}
+
+static double benchmarkGemm(const GemmBackend &backend, const Mat &A, const Mat &B, Mat &C, int flags)
+{
+    const int numRuns = 3;
+    double minTime = DBL_MAX;
+
+    backend.gemm(A, B, 1, C, 0, flags); //warm up
+    for (int i = 0; i < numRuns; i++)
+    {
+        int64 t = getTickCount();
+        backend.gemm(A, B, 1, C, 0, flags);
+        minTime = std::min(minTime, (double)(getTickCount() - t));
+    }
+    return minTime;
+}
+
+Ptr<GemmBackend> selectGemmBackend(const String &preferred, int M, int N, int K, int type, int flags)
+{
+    if (preferred.empty())
+        return Ptr<GemmBackend>();
+
+    const std::vector<Ptr<GemmBackend> > &backends = getGemmBackends();
+
+    if (preferred != "auto")
+    {
+        for (size_t i = 0; i < backends.size(); i++)
+        {
+            if (backends[i]->name() == preferred)
+                return backends[i];
+        }
+        CV_Error(Error::StsBadArg, "Unknown GEMM backend \"" + preferred + "\"");
+    }
+
+    //benchmarking results are shared by all layers with the same matrix shapes
+    typedef std::map<std::vector<int>, Ptr<GemmBackend> > ChoiceCache;
+    static ChoiceCache cache;
+    static Mutex mtx;
+
+    int keyData[] = {M, N, K, type, flags, cv::getNumThreads()};
+    std::vector<int> key(keyData, keyData + sizeof(keyData)/sizeof(keyData[0]));
+
+    AutoLock lock(mtx);
+    ChoiceCache::iterator it = cache.find(key);
+    if (it != cache.end())
+        return it->second;
+
+    Mat A = (flags & GEMM_1_T) ? Mat(K, M, type) : Mat(M, K, type);
+    Mat B = (flags & GEMM_2_T) ? Mat(N, K, type) : Mat(K, N, type);
+    Mat C(M, N, type);
+    RNG rng(0);
+    rng.fill(A, RNG::UNIFORM, -1, 1);
+    rng.fill(B, RNG::UNIFORM, -1, 1);
+
+    Ptr<GemmBackend> best;
+    double bestTime = DBL_MAX;
+    for (size_t i = 0; i < backends.size(); i++)
+    {
+        if (!backends[i]->isApplicable(A, B, C, flags))
+            continue;
+
+        double time = benchmarkGemm(*backends[i], A, B, C, flags);
+        if (time < bestTime)
+        {
+            bestTime = time;
+            best = backends[i];
+        }
+    }
+
+    cache[key] = best;
+    return best;
+}
+
+void gemm(const Ptr<GemmBackend> &backend, InputArray A, InputArray B, double alpha, InputOutputArray C, double beta, int flags)
+{
+    if (backend && C.isMat())
+    {
+        Mat a = A.getMat(), b = B.getMat();
+        Mat &c = C.getMatRef();
+        if (backend->isApplicable(a, b, c, flags))
+        {
+            backend->gemm(a, b, alpha, c, beta, flags);
+            return;
+        }
+    }
+    dnn::gemm(A, B, alpha, C, beta, flags);
+}
+
+void quantizeRowsInt8(const Mat &src, Mat &dst, Mat &scales)
+{
+    CV_Assert(src.dims == 2 && src.type() == CV_32F);
+    dst.create(src.rows, src.cols, CV_8S);
+    scales.create(src.rows, 1, CV_32F);
+
+    for (int i = 0; i < src.rows; i++)
+    {
+        double maxAbs = cv::norm(src.row(i), NORM_INF);
+        float scale = (maxAbs > 0) ? (float)(maxAbs / 127) : 1.f;
+
+        src.row(i).convertTo(dst.row(i), CV_8S, 1. / scale);
+        scales.at<float>(i) = scale;
+    }
+}
+
+class GEMMInt8Invoker : public ParallelLoopBody
+{
+public:
+    GEMMInt8Invoker(const Mat *_a, const Mat *_b, Mat *_c) : a(_a), b(_b), c(_c) {}
+
+    void operator()(const Range& range) const
+    {
+        int mmax = a->rows;
+        int kmax = a->cols;
+        int nmax = range.end - range.start;
+
+        for (int m = 0; m < mmax; m++)
+        {
+            int *dst = c->ptr<int>(m) + range.start;
+            const schar *aptr = a->ptr<schar>(m);
+
+            for (int n = 0; n < nmax; n++)
+                dst[n] = 0;
+
+            for (int k = 0; k < kmax; k++)
+            {
+                int alpha = aptr[k];
+                if (alpha == 0)
+                    continue;
+
+                const schar *bptr = b->ptr<schar>(k) + range.start;
+                for (int n = 0; n < nmax; n++)
+                    dst[n] += alpha * bptr[n];
+            }
+        }
+    }
+
+    const Mat *a, *b;
+    Mat *c;
+};
+
+void gemmInt8(const Mat &A, const Mat &B, Mat &C)
+{
+    CV_Assert(A.type() == CV_8S && B.type() == CV_8S && A.cols == B.rows);
+    C.create(A.rows, B.cols, CV_32S);
+
+    double granularity = 10000000./((double)A.rows*A.cols);
+    parallel_for_(Range(0, B.cols), GEMMInt8Invoker(&A, &B, &C), granularity);
+}
+
 int getBlasThreads()
 {
     #ifdef OPENBLAS_VERSION
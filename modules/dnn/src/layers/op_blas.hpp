@@ -54,6 +54,38 @@ namespace dnn
     void gemm(InputArray A, InputArray B, double alpha, InputOutputArray C, double beta, int flags = 0);
 
     void gemmCPU(const Mat &A, const Mat &B, double alpha, Mat &C, double beta, int flags = 0);
+
+    //! Implementation of C = alpha * op(A) * op(B) + beta * C for host matrices, where C is preallocated.
+    class GemmBackend
+    {
+    public:
+        virtual ~GemmBackend() {}
+        virtual String name() const = 0;
+        //! Returns true if the backend supports the types, layouts and flags of these matrices.
+        virtual bool isApplicable(const Mat &A, const Mat &B, const Mat &C, int flags) const = 0;
+        virtual void gemm(const Mat &A, const Mat &B, double alpha, Mat &C, double beta, int flags) const = 0;
+    };
+
+    //! Returns backends available in the build: "tiled" (built-in), "cblas" (external BLAS, if linked) and "opencv".
+    const std::vector<Ptr<GemmBackend> > &getGemmBackends();
+
+    /** @brief Returns the backend for products of M x K and K x N matrices.
+     *  @details Empty @p preferred returns empty pointer, i.e. the default choice of dnn::gemm().
+     *  "auto" benchmarks applicable backends on matrices of such shapes and returns the fastest one,
+     *  the choice is cached. Otherwise the backend is searched by its name.
+     */
+    Ptr<GemmBackend> selectGemmBackend(const String &preferred, int M, int N, int K, int type, int flags = 0);
+
+    //! Uses @p backend for host matrices if it is applicable, otherwise works as dnn::gemm().
+    void gemm(const Ptr<GemmBackend> &backend, InputArray A, InputArray B, double alpha, InputOutputArray C, double beta, int flags = 0);
+
+    /** @brief Quantizes each row of CV_32F matrix @p src into CV_8S @p dst with symmetric per-row scale.
+     *  @details @p scales is CV_32F column, such that src.row(i) ~ dst.row(i) * scales[i].
+     */
+    void quantizeRowsInt8(const Mat &src, Mat &dst, Mat &scales);
+
+    /** @brief Computes C = A * B, where @p A and @p B are CV_8S matrices and @p C is CV_32S matrix. */
+    void gemmInt8(const Mat &A, const Mat &B, Mat &C);
 }
 }
 #endif
\ No newline at end of file
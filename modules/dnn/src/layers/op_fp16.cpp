@@ -0,0 +1,209 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "../precomp.hpp"
+#include "op_fp16.hpp"
+#include "op_blas.hpp"
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace cv
+{
+namespace dnn
+{
+namespace fp16
+{
+
+//conversions with rounding to nearest even, see F. Giesen, "half <-> float conversions" for details
+static inline float halfToFloat(short h)
+{
+    static const unsigned shiftedExp = 0x7c00 << 13;
+    Cv32suf magic, out;
+    magic.u = 113 << 23;
+
+    out.u = ((ushort)h & 0x7fff) << 13;
+    unsigned exp = shiftedExp & out.u;
+    out.u += (127 - 15) << 23;
+
+    if (exp == shiftedExp)  //inf or nan
+        out.u += (128 - 16) << 23;
+    else if (exp == 0)      //zero or denormal
+    {
+        out.u += 1 << 23;
+        out.f -= magic.f;
+    }
+
+    out.u |= ((ushort)h & 0x8000) << 16;
+    return out.f;
+}
+
+static inline short floatToHalf(float val)
+{
+    static const unsigned f32infty = 255 << 23, f16max = (127 + 16) << 23;
+    Cv32suf in, denormMagic;
+    denormMagic.u = ((127 - 15) + (23 - 10) + 1) << 23;
+
+    in.f = val;
+    unsigned sign = in.u & 0x80000000u;
+    in.u ^= sign;
+
+    unsigned out;
+    if (in.u >= f16max)             //overflow, inf or nan
+        out = (in.u > f32infty) ? 0x7e00 : 0x7c00;
+    else if (in.u < (113 << 23))    //denormal or zero
+    {
+        in.f += denormMagic.f;
+        out = in.u - denormMagic.u;
+    }
+    else
+    {
+        unsigned mantOdd = (in.u >> 13) & 1;
+        in.u += ((unsigned)(15 - 127) << 23) + 0xfff;
+        in.u += mantOdd;
+        out = in.u >> 13;
+    }
+
+    return (short)(out | (sign >> 16));
+}
+
+void toFloat(const short *src, float *dst, size_t len)
+{
+    size_t i = 0;
+#if defined(__F16C__)
+    for (; i + 8 <= len; i += 8)
+        _mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i*)(src + i))));
+#endif
+    for (; i < len; i++)
+        dst[i] = halfToFloat(src[i]);
+}
+
+void fromFloat(const float *src, short *dst, size_t len)
+{
+    size_t i = 0;
+#if defined(__F16C__)
+    for (; i + 8 <= len; i += 8)
+        _mm_storeu_si128((__m128i*)(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), 0));
+#endif
+    for (; i < len; i++)
+        dst[i] = floatToHalf(src[i]);
+}
+
+void fromFloat(const Mat &src, Mat &dst)
+{
+    CV_Assert(src.type() == CV_32F && src.isContinuous());
+    Mat res(src.dims, src.size.p, TYPE);
+    fromFloat(src.ptr<float>(), res.ptr<short>(), src.total());
+    dst = res;
+}
+
+void toFloat(const Mat &src, Mat &dst)
+{
+    CV_Assert(src.type() == TYPE && src.isContinuous());
+    Mat res(src.dims, src.size.p, CV_32F);
+    toFloat(src.ptr<short>(), res.ptr<float>(), src.total());
+    dst = res;
+}
+
+//number of rows of half precision matrix, which are converted at once
+static int blockRows(int rowSize)
+{
+    const int blockElems = 1 << 16;   //256 KB of floats
+    return std::max(1, blockElems / std::max(rowSize, 1));
+}
+
+static void rowsToFloat(const Mat &src, int startRow, int endRow, Mat &dst)
+{
+    dst.create(endRow - startRow, src.cols, CV_32F);
+    for (int i = startRow; i < endRow; i++)
+        toFloat(src.ptr<short>(i), dst.ptr<float>(i - startRow), src.cols);
+}
+
+void gemmHalfBt(const Mat &A, const Mat &B, Mat &C)
+{
+    CV_Assert(A.type() == CV_32F && B.type() == TYPE && C.type() == CV_32F);
+    CV_Assert(A.cols == B.cols && C.rows == A.rows && C.cols == B.rows);
+    Mat buf, dstBuf;
+
+    int step = blockRows(B.cols);
+    for (int n = 0; n < B.rows; n += step)
+    {
+        int nend = std::min(n + step, B.rows);
+        rowsToFloat(B, n, nend, buf);
+        dstBuf.create(C.rows, nend - n, CV_32F);
+        dnn::gemm(A, buf, 1, dstBuf, 0, GEMM_2_T);
+        dstBuf.copyTo(C.colRange(n, nend));
+    }
+}
+
+void gemmHalfA(const Mat &A, const Mat &B, Mat &C, bool transA)
+{
+    CV_Assert(A.type() == TYPE && B.type() == CV_32F && C.type() == CV_32F);
+    Mat buf;
+
+    int step = blockRows(A.cols);
+    if (transA)
+    {
+        CV_Assert(A.rows == B.rows && C.rows == A.cols && C.cols == B.cols);
+        for (int k = 0; k < A.rows; k += step)
+        {
+            int kend = std::min(k + step, A.rows);
+            rowsToFloat(A, k, kend, buf);
+            dnn::gemm(buf, B.rowRange(k, kend), 1, C, (k == 0) ? 0 : 1, GEMM_1_T);
+        }
+    }
+    else
+    {
+        CV_Assert(A.cols == B.rows && C.rows == A.rows && C.cols == B.cols);
+        for (int m = 0; m < A.rows; m += step)
+        {
+            int mend = std::min(m + step, A.rows);
+            rowsToFloat(A, m, mend, buf);
+            Mat dst = C.rowRange(m, mend);
+            dnn::gemm(buf, B, 1, dst, 0);
+        }
+    }
+}
+
+}
+}
+}
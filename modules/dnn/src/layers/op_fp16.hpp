@@ -0,0 +1,79 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#ifndef __OPENCV_DNN_LAYERS_OP_FP16_HPP__
+#define __OPENCV_DNN_LAYERS_OP_FP16_HPP__
+#include "../precomp.hpp"
+
+namespace cv
+{
+namespace dnn
+{
+
+/* Half precision floats (IEEE 754 binary16) are stored in CV_16S matrices as raw 16-bit values.
+ * They are used for compact storage only, all arithmetic is performed in single precision.
+ */
+namespace fp16
+{
+    enum { TYPE = CV_16S };
+
+    void toFloat(const short *src, float *dst, size_t len);
+
+    void fromFloat(const float *src, short *dst, size_t len);
+
+    //! Converts CV_32F matrix into half precision one of the same shape.
+    void fromFloat(const Mat &src, Mat &dst);
+
+    //! Converts half precision matrix into CV_32F one of the same shape.
+    void toFloat(const Mat &src, Mat &dst);
+
+    /** @brief Computes C = A * B^T, where B is half precision matrix.
+     *  @details B is converted into single precision by blocks of rows, so converted data stays in cache.
+     */
+    void gemmHalfBt(const Mat &A, const Mat &B, Mat &C);
+
+    /** @brief Computes C = A * B or C = A^T * B (@p transA), where A is half precision matrix. */
+    void gemmHalfA(const Mat &A, const Mat &B, Mat &C, bool transA);
+}
+
+}
+}
+#endif
@@ -84,7 +84,7 @@ bool im2col_ocl(const UMat &img,
 
     size_t localSize = ocl::Device::getDefault().maxWorkGroupSize();
     size_t globalSize = (size_t)channels * height_col * width_col;
-    return ker.run(1, &globalSize, &localSize, true);
+    return ker.run(1, &globalSize, &localSize, false);
 }
 
 bool col2im_ocl(const UMat &col,
@@ -118,7 +118,7 @@ bool col2im_ocl(const UMat &col,
 
     size_t localSize = ocl::Device::getDefault().maxWorkGroupSize();
     size_t globalSize = img.total();
-    return ker.run(1, &globalSize, &localSize, true);
+    return ker.run(1, &globalSize, &localSize, false);
 }
 
 #endif
@@ -0,0 +1,258 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "../precomp.hpp"
+#include "op_winograd.hpp"
+#include "op_blas.hpp"
+
+namespace cv
+{
+namespace dnn
+{
+namespace winograd
+{
+
+void transformWeights(const Mat &weights, Mat &U)
+{
+    CV_Assert(weights.dims == 4 && weights.size[2] == 3 && weights.size[3] == 3);
+    CV_Assert(weights.type() == CV_32F && weights.isContinuous());
+
+    int outCn = weights.size[0], inpCn = weights.size[1];
+    U.create(NCOEFS * outCn, inpCn, CV_32F);
+
+    const float *wptr = weights.ptr<float>();
+    for (int oc = 0; oc < outCn; oc++)
+    {
+        for (int ic = 0; ic < inpCn; ic++)
+        {
+            const float *g = wptr + (oc*inpCn + ic)*9;
+            float t[4][3], u[4][4];
+
+            //G * g
+            for (int j = 0; j < 3; j++)
+            {
+                t[0][j] = g[j];
+                t[1][j] = 0.5f*(g[j] + g[3 + j] + g[6 + j]);
+                t[2][j] = 0.5f*(g[j] - g[3 + j] + g[6 + j]);
+                t[3][j] = g[6 + j];
+            }
+
+            //(G * g) * G^T
+            for (int i = 0; i < 4; i++)
+            {
+                u[i][0] = t[i][0];
+                u[i][1] = 0.5f*(t[i][0] + t[i][1] + t[i][2]);
+                u[i][2] = 0.5f*(t[i][0] - t[i][1] + t[i][2]);
+                u[i][3] = t[i][2];
+            }
+
+            for (int e = 0; e < NCOEFS; e++)
+                U.ptr<float>(e*outCn + oc)[ic] = u[e / TILE][e % TILE];
+        }
+    }
+}
+
+class InputTransformBody : public ParallelLoopBody
+{
+public:
+    InputTransformBody(const float *inp_, int inpCn_, int inpH_, int inpW_, int padH_, int padW_,
+                       int tilesH_, int tilesW_, Mat &V_)
+        : inp(inp_), inpCn(inpCn_), inpH(inpH_), inpW(inpW_), padH(padH_), padW(padW_),
+          tilesH(tilesH_), tilesW(tilesW_), V(&V_) {}
+
+    void operator()(const Range &r) const
+    {
+        float d[4][4], t[4][4];
+        float *vptr[NCOEFS];
+
+        for (int c = r.start; c < r.end; c++)
+        {
+            const float *src = inp + (size_t)c*inpH*inpW;
+            for (int e = 0; e < NCOEFS; e++)
+                vptr[e] = V->ptr<float>(e*inpCn + c);
+
+            for (int th = 0; th < tilesH; th++)
+            {
+                int y0 = th*OUT_TILE - padH;
+                for (int tw = 0; tw < tilesW; tw++)
+                {
+                    int x0 = tw*OUT_TILE - padW;
+
+                    if (y0 >= 0 && y0 + TILE <= inpH && x0 >= 0 && x0 + TILE <= inpW)
+                    {
+                        for (int i = 0; i < 4; i++)
+                        {
+                            const float *row = src + (y0 + i)*inpW + x0;
+                            d[i][0] = row[0]; d[i][1] = row[1]; d[i][2] = row[2]; d[i][3] = row[3];
+                        }
+                    }
+                    else
+                    {
+                        for (int i = 0; i < 4; i++)
+                        {
+                            int y = y0 + i;
+                            for (int j = 0; j < 4; j++)
+                            {
+                                int x = x0 + j;
+                                d[i][j] = (0 <= y && y < inpH && 0 <= x && x < inpW) ? src[y*inpW + x] : 0.f;
+                            }
+                        }
+                    }
+
+                    //B^T * d
+                    for (int j = 0; j < 4; j++)
+                    {
+                        t[0][j] = d[0][j] - d[2][j];
+                        t[1][j] = d[1][j] + d[2][j];
+                        t[2][j] = d[2][j] - d[1][j];
+                        t[3][j] = d[1][j] - d[3][j];
+                    }
+
+                    //(B^T * d) * B
+                    int tile = th*tilesW + tw;
+                    for (int i = 0; i < 4; i++)
+                    {
+                        vptr[i*4 + 0][tile] = t[i][0] - t[i][2];
+                        vptr[i*4 + 1][tile] = t[i][1] + t[i][2];
+                        vptr[i*4 + 2][tile] = t[i][2] - t[i][1];
+                        vptr[i*4 + 3][tile] = t[i][1] - t[i][3];
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    const float *inp;
+    int inpCn, inpH, inpW, padH, padW;
+    int tilesH, tilesW;
+    Mat *V;
+};
+
+class OutputTransformBody : public ParallelLoopBody
+{
+public:
+    OutputTransformBody(const Mat &M_, int outCn_, const float *bias_, float *out_, int outH_, int outW_,
+                        int tilesH_, int tilesW_)
+        : M(&M_), outCn(outCn_), bias(bias_), out(out_), outH(outH_), outW(outW_),
+          tilesH(tilesH_), tilesW(tilesW_) {}
+
+    void operator()(const Range &r) const
+    {
+        float m[4][4], t[2][4];
+        const float *mptr[NCOEFS];
+
+        for (int oc = r.start; oc < r.end; oc++)
+        {
+            float *dst = out + (size_t)oc*outH*outW;
+            float b = (bias) ? bias[oc] : 0.f;
+            for (int e = 0; e < NCOEFS; e++)
+                mptr[e] = M->ptr<float>(e*outCn + oc);
+
+            for (int th = 0; th < tilesH; th++)
+            {
+                int y0 = th*OUT_TILE;
+                for (int tw = 0; tw < tilesW; tw++)
+                {
+                    int x0 = tw*OUT_TILE;
+                    int tile = th*tilesW + tw;
+
+                    for (int e = 0; e < NCOEFS; e++)
+                        m[e / TILE][e % TILE] = mptr[e][tile];
+
+                    //A^T * m
+                    for (int j = 0; j < 4; j++)
+                    {
+                        t[0][j] = m[0][j] + m[1][j] + m[2][j];
+                        t[1][j] = m[1][j] - m[2][j] - m[3][j];
+                    }
+
+                    //(A^T * m) * A
+                    for (int i = 0; i < OUT_TILE && y0 + i < outH; i++)
+                    {
+                        float *row = dst + (y0 + i)*outW + x0;
+                        row[0] = t[i][0] + t[i][1] + t[i][2] + b;
+                        if (x0 + 1 < outW)
+                            row[1] = t[i][1] - t[i][2] - t[i][3] + b;
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    const Mat *M;
+    int outCn;
+    const float *bias;
+    float *out;
+    int outH, outW;
+    int tilesH, tilesW;
+};
+
+void convolve(const float *inp, int inpCn, int inpH, int inpW, int padH, int padW,
+              const Mat &U, int uRow, int outCn, const float *bias,
+              float *out, int outH, int outW, Mat &V, Mat &M)
+{
+    int tilesH = (outH + OUT_TILE - 1) / OUT_TILE;
+    int tilesW = (outW + OUT_TILE - 1) / OUT_TILE;
+    int ntiles = tilesH * tilesW;
+    int uOutCn = U.rows / NCOEFS;
+
+    CV_Assert(U.type() == CV_32F && U.cols == inpCn && uRow + outCn <= uOutCn);
+    V.create(NCOEFS * inpCn, ntiles, CV_32F);
+    M.create(NCOEFS * outCn, ntiles, CV_32F);
+
+    parallel_for_(Range(0, inpCn), InputTransformBody(inp, inpCn, inpH, inpW, padH, padW, tilesH, tilesW, V));
+
+    for (int e = 0; e < NCOEFS; e++)
+    {
+        Mat Ue = U.rowRange(e*uOutCn + uRow, e*uOutCn + uRow + outCn);
+        Mat Ve = V.rowRange(e*inpCn, (e + 1)*inpCn);
+        Mat Me = M.rowRange(e*outCn, (e + 1)*outCn);
+        dnn::gemm(Ue, Ve, 1, Me, 0);
+    }
+
+    parallel_for_(Range(0, outCn), OutputTransformBody(M, outCn, bias, out, outH, outW, tilesH, tilesW));
+}
+
+}
+}
+}
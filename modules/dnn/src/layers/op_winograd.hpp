@@ -0,0 +1,81 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#ifndef __OPENCV_DNN_LAYERS_OP_WINOGRAD_HPP__
+#define __OPENCV_DNN_LAYERS_OP_WINOGRAD_HPP__
+#include "../precomp.hpp"
+
+namespace cv
+{
+namespace dnn
+{
+
+/* Winograd minimal filtering F(2x2, 3x3) for 3x3 convolutions with unit stride and dilation.
+ * Each 4x4 input tile produces 2x2 output tile, so 16 multiplications are used instead of 36.
+ * The convolution is computed as 16 independent GEMMs in the transformed domain.
+ */
+namespace winograd
+{
+    enum { TILE = 4, OUT_TILE = 2, NCOEFS = TILE*TILE };
+
+    inline int numTiles(int outH, int outW)
+    {
+        return ((outH + OUT_TILE - 1) / OUT_TILE) * ((outW + OUT_TILE - 1) / OUT_TILE);
+    }
+
+    /** @brief Transforms 3x3 kernels [outCn, inpCn, 3, 3] into matrix U with shape [16*outCn, inpCn]. */
+    void transformWeights(const Mat &weights, Mat &U);
+
+    /** @brief Computes convolution of single image [inpCn, inpH, inpW] with the transformed kernels.
+     *  @param U    transformed kernels of all groups, see transformWeights()
+     *  @param uRow first row of the kernels of the current group inside each U[e] block
+     *  @param V    buffer for transformed input with shape [16*inpCn, numTiles]
+     *  @param M    buffer for products with shape [16*outCn, numTiles]
+     *  @param bias optional pointer to outCn biases
+     */
+    void convolve(const float *inp, int inpCn, int inpH, int inpW, int padH, int padW,
+                  const Mat &U, int uRow, int outCn, const float *bias,
+                  float *out, int outH, int outW, Mat &V, Mat &M);
+}
+
+}
+}
+#endif
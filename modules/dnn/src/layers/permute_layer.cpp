@@ -42,8 +42,10 @@
 #include "../precomp.hpp"
 #include "layers_common.hpp"
 #include "permute_layer.hpp"
+#include "opencl_kernels_dnn.hpp"
 #include <float.h>
 #include <algorithm>
+#include <opencv2/core/ocl.hpp>
 
 namespace cv
 {
@@ -81,6 +83,7 @@ void PermuteLayer::checkNeedForPermutation()
 
 PermuteLayer::PermuteLayer(LayerParams &params) : Layer(params)
 {
+    useOpenCL = false;
     if (!params.has("order"))
     {
         _needsPermute = false;
@@ -126,15 +129,20 @@ void PermuteLayer::computeStrides()
 
 void PermuteLayer::allocate(const std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
 {
+    outputs.resize(inputs.size());
+
     if(!_needsPermute)
     {
+        for (size_t i = 0; i < inputs.size(); i++)
+            outputs[i].shareFrom(*inputs[i]);
         return;
     }
 
     CV_Assert(inputs.size() > 0);
     CV_Assert((int)_numAxes == inputs[0]->shape().dims());
 
-    outputs.resize(inputs.size());
+    useOpenCL = ocl::useOpenCL() && inputs[0]->getState() == Blob::HEAD_AT_UMAT;
+    int allocFlags = (useOpenCL) ? Blob::ALLOC_UMAT : Blob::ALLOC_MAT;
 
     _oldDimensionSize = inputs[0]->shape();
     for (size_t i = 0; i < _numAxes; i++)
@@ -145,10 +153,24 @@ void PermuteLayer::allocate(const std::vector<Blob*> &inputs, std::vector<Blob>
     for (size_t i = 0; i < inputs.size(); i++)
     {
         CV_Assert(inputs[i]->rows() == _oldDimensionSize[2] && inputs[i]->cols() == _oldDimensionSize[3]);
-        outputs[i].create(BlobShape(_newDimensionSize));
+        outputs[i].create(BlobShape(_newDimensionSize), inputs[i]->type(), allocFlags);
     }
 
     computeStrides();
+
+    if (useOpenCL)
+    {
+        Mat order(1, (int)_numAxes, CV_32S), oldStride(1, (int)_numAxes, CV_32S), newStride(1, (int)_numAxes, CV_32S);
+        for (size_t i = 0; i < _numAxes; i++)
+        {
+            order.at<int>((int)i) = (int)_order[i];
+            oldStride.at<int>((int)i) = (int)_oldStride[i];
+            newStride.at<int>((int)i) = (int)_newStride[i];
+        }
+        order.copyTo(_orderUMat);
+        oldStride.copyTo(_oldStrideUMat);
+        newStride.copyTo(_newStrideUMat);
+    }
 }
 
 void PermuteLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
@@ -157,13 +179,19 @@ void PermuteLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &output
     {
         for (size_t j = 0; j < inputs.size(); j++)
         {
-            outputs[j].matRef() = inputs[j]->matRef();
+            outputs[j].shareFrom(*inputs[j]);
         }
         return;
     }
 
     for (size_t k = 0; k < inputs.size(); k++)
     {
+        if (useOpenCL)
+        {
+            CV_Assert(forward_ocl(*inputs[k], outputs[k]));
+            continue;
+        }
+
         float *srcData = inputs[k]->ptrf();
         float *dstData = outputs[k].ptrf();
 
@@ -181,5 +209,31 @@ void PermuteLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &output
         }
     }
 }
+
+#ifdef HAVE_OPENCL
+bool PermuteLayer::forward_ocl(Blob &input, Blob &output)
+{
+    const UMat &srcMat = input.umatRefConst();
+    UMat &dstMat = output.umatRef(true);
+
+    String buildOpts = String("-DT=") + ocl::typeToStr(srcMat.type());
+    ocl::Kernel kernel("PermuteForward", ocl::dnn::permute_oclsrc, buildOpts);
+    if (kernel.empty())
+        return false;
+
+    kernel.args((int)_count, ocl::KernelArg::PtrReadOnly(srcMat), ocl::KernelArg::PtrReadOnly(_orderUMat),
+                ocl::KernelArg::PtrReadOnly(_oldStrideUMat), ocl::KernelArg::PtrReadOnly(_newStrideUMat),
+                (int)_numAxes, ocl::KernelArg::PtrWriteOnly(dstMat));
+
+    size_t wgSize = ocl::Device::getDefault().maxWorkGroupSize();
+    size_t globalSize = _count;
+    return kernel.run(1, &globalSize, &wgSize, false);
+}
+#else
+bool PermuteLayer::forward_ocl(Blob&, Blob&)
+{
+    return false;
+}
+#endif
 }
 }
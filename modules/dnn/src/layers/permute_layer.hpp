@@ -61,9 +61,13 @@ class PermuteLayer : public Layer
 
     size_t _numAxes;
 
+    bool useOpenCL;
+    UMat _orderUMat, _oldStrideUMat, _newStrideUMat;
+
     void checkCurrentOrder(int currentOrder);
     void checkNeedForPermutation();
     void computeStrides();
+    bool forward_ocl(Blob &input, Blob &output);
 
 public:
     PermuteLayer(LayerParams &params);
@@ -46,6 +46,7 @@
 #include <float.h>
 #include <algorithm>
 #include <opencv2/core/ocl.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 using std::max;
 using std::min;
 
@@ -141,43 +142,128 @@ bool PoolingLayerImpl::avePooling_ocl(Blob &src, Blob &dst)
     return pooling_ocl("AvePoolForward", src, dst);
 }
 
-void PoolingLayerImpl::maxPooling_cpu(Blob &src, Blob &dst)
+//dst[x] = op(src[x], ..., src[x + ksize - 1]) for x in [0, len)
+static void slidingReduce(const float *src, float *dst, int len, int ksize, bool isMax)
 {
-    CV_DbgAssert(dst.rows() == out.height && dst.cols() == out.width);
+    int x = 0;
+#if CV_SIMD128
+    for (; x <= len - 4; x += 4)
+    {
+        v_float32x4 acc = v_load(src + x);
+        for (int k = 1; k < ksize; k++)
+            acc = isMax ? v_max(acc, v_load(src + x + k)) : acc + v_load(src + x + k);
+        v_store(dst + x, acc);
+    }
+#endif
+    for (; x < len; x++)
+    {
+        float acc = src[x];
+        for (int k = 1; k < ksize; k++)
+            acc = isMax ? std::max(acc, src[x + k]) : acc + src[x + k];
+        dst[x] = acc;
+    }
+}
+
+//dst[i] = op(dst[i], src[i])
+static void reduceRows(float *dst, const float *src, int len, bool isMax)
+{
+    int i = 0;
+#if CV_SIMD128
+    for (; i <= len - 4; i += 4)
+    {
+        v_float32x4 a = v_load(dst + i), b = v_load(src + i);
+        v_store(dst + i, isMax ? v_max(a, b) : a + b);
+    }
+#endif
+    for (; i < len; i++)
+        dst[i] = isMax ? std::max(dst[i], src[i]) : dst[i] + src[i];
+}
 
-    for (int n = 0; n < src.num(); ++n)
+/* Max and average pooling of the planes, which are distributed between threads.
+ * The pooling window is separable: at first each input row is reduced by the horizontal window,
+ * then the output rows are reduced from these results by the vertical window.
+ * Both passes are vectorized along rows, so it works for any stride.
+ */
+class PoolingInvoker : public ParallelLoopBody
+{
+public:
+    PoolingInvoker(Blob &src, Blob &dst, bool isMax_, Size kernel_, Size stride_, Size pad_, Size inp_, Size out_)
+        : srcData(src.ptrf()), dstData(dst.ptrf()), isMax(isMax_),
+          kernel(kernel_), stride(stride_), pad(pad_), inp(inp_), out(out_) {}
+
+    void operator()(const Range &range) const
     {
-        for (int c = 0; c < src.channels(); ++c)
+        int slideLen = (out.width - 1) * stride.width + 1;
+        int rowLen = slideLen + kernel.width - 1;
+        AutoBuffer<float> buffer(rowLen + slideLen + inp.height * out.width + out.width);
+        float *paddedRow = buffer, *slide = paddedRow + rowLen;
+        float *rows = slide + slideLen, *colScale = rows + inp.height * out.width;
+        float neutral = isMax ? -FLT_MAX : 0.f;
+
+        //average pooling divides by the window area clipped by the padded image
+        for (int pw = 0; pw < out.width; pw++)
         {
-            const float *srcData = src.ptrf(n, c);
-            float *dstData = dst.ptrf(n, c);
+            int wstart = pw * stride.width - pad.width;
+            colScale[pw] = 1.f / (min(wstart + kernel.width, inp.width + pad.width) - wstart);
+        }
 
-            for (int ph = 0; ph < out.height; ++ph)
+        int validLen = min(inp.width, rowLen - pad.width);
+        for (int plane = range.start; plane < range.end; plane++)
+        {
+            const float *srcPlane = srcData + (size_t)plane * inp.area();
+            float *dstPlane = dstData + (size_t)plane * out.area();
+
+            for (int h = 0; h < inp.height; h++)
             {
-                for (int pw = 0; pw < out.width; ++pw)
+                std::fill(paddedRow, paddedRow + rowLen, neutral);
+                memcpy(paddedRow + pad.width, srcPlane + h * inp.width, validLen * sizeof(float));
+                slidingReduce(paddedRow, slide, slideLen, kernel.width, isMax);
+
+                float *row = rows + h * out.width;
+                for (int pw = 0; pw < out.width; pw++)
+                    row[pw] = slide[pw * stride.width];
+            }
+
+            for (int ph = 0; ph < out.height; ph++)
+            {
+                int hstart = ph * stride.height - pad.height;
+                int hend = min(hstart + kernel.height, inp.height);
+                float *dstRow = dstPlane + ph * out.width;
+
+                if (max(hstart, 0) >= hend)
+                {
+                    std::fill(dstRow, dstRow + out.width, neutral);
+                    continue;
+                }
+
+                memcpy(dstRow, rows + max(hstart, 0) * out.width, out.width * sizeof(float));
+                for (int h = max(hstart, 0) + 1; h < hend; h++)
+                    reduceRows(dstRow, rows + h * out.width, out.width, isMax);
+
+                if (!isMax)
                 {
-                    int hstart = ph * stride.height - pad.height;
-                    int wstart = pw * stride.width - pad.width;
-                    int hend = min(hstart + kernel.height, inp.height);
-                    int wend = min(wstart + kernel.width, inp.width);
-                    hstart = max(hstart, 0);
-                    wstart = max(wstart, 0);
-                    const int poolIndex = ph * out.width + pw;
-                    float max_val = -FLT_MAX;
-
-                    for (int h = hstart; h < hend; ++h)
-                        for (int w = wstart; w < wend; ++w)
-                        {
-                            const int index = h * inp.width + w;
-                            if (srcData[index] > max_val)
-                                max_val = srcData[index];
-                        }
-
-                    dstData[poolIndex] = max_val;
+                    float rowScale = 1.f / (min(hstart + kernel.height, inp.height + pad.height) - hstart);
+                    for (int pw = 0; pw < out.width; pw++)
+                        dstRow[pw] *= rowScale * colScale[pw];
                 }
             }
         }
     }
+
+private:
+    const float *srcData;
+    float *dstData;
+    bool isMax;
+    Size kernel, stride, pad, inp, out;
+};
+
+void PoolingLayerImpl::maxPooling_cpu(Blob &src, Blob &dst)
+{
+    CV_DbgAssert(dst.rows() == out.height && dst.cols() == out.width);
+    CV_Assert(src.type() == CV_32F && dst.type() == CV_32F);
+
+    PoolingInvoker invoker(src, dst, true, kernel, stride, pad, inp, out);
+    parallel_for_(Range(0, src.num() * src.channels()), invoker);
 }
 
 
@@ -201,7 +287,7 @@ bool PoolingLayerImpl::pooling_ocl(const char *kname, const Blob &src, Blob &dst
              ocl::KernelArg::PtrWriteOnly(dstMat));
 
     size_t wgSize = ocl::Device::getDefault().maxWorkGroupSize();
-    if (!ker.run(1, &nthreads, &wgSize, true))
+    if (!ker.run(1, &nthreads, &wgSize, false))
         return false;
 
     return true;
@@ -215,38 +301,11 @@ bool PoolingLayerImpl::pooling_ocl(const char*, const Blob&, Blob&, Blob*)
 
 void PoolingLayerImpl::avePooling_cpu(Blob &src, Blob &dst)
 {
-    for (int n = 0; n < src.num(); ++n)
-    {
-        for (int c = 0; c < src.channels(); ++c)
-        {
-            const float *srcData = src.ptrf(n, c);
-            float *dstData = dst.ptrf(n, c);
+    CV_DbgAssert(dst.rows() == out.height && dst.cols() == out.width);
+    CV_Assert(src.type() == CV_32F && dst.type() == CV_32F);
 
-            for (int ph = 0; ph < out.height; ++ph)
-            {
-                for (int pw = 0; pw < out.width; ++pw)
-                {
-                    int hstart = ph * stride.height - pad.height;
-                    int wstart = pw * stride.width - pad.width;
-                    int hend = min(hstart + kernel.height, inp.height + pad.height);
-                    int wend = min(wstart + kernel.width, inp.width + pad.width);
-                    int poolSize = (hend - hstart) * (wend - wstart);
-                    hstart = max(hstart, 0);
-                    wstart = max(wstart, 0);
-                    hend = min(hend, inp.height);
-                    wend = min(wend, inp.width);
-
-                    dstData[ph * out.width + pw] = 0.f;
-
-                    for (int h = hstart; h < hend; ++h)
-                        for (int w = wstart; w < wend; ++w)
-                            dstData[ph * out.width + pw] += srcData[h * inp.width + w];
-
-                    dstData[ph * out.width + pw] /= poolSize;
-                }
-            }
-        }
-    }
+    PoolingInvoker invoker(src, dst, false, kernel, stride, pad, inp, out);
+    parallel_for_(Range(0, src.num() * src.channels()), invoker);
 }
 
 void PoolingLayerImpl::computeOutputShape(Size inpSz)
@@ -45,6 +45,7 @@
 #include <float.h>
 #include <algorithm>
 #include <cmath>
+#include <opencv2/core/ocl.hpp>
 
 namespace cv
 {
@@ -160,6 +161,7 @@ void PriorBoxLayer::getVariance(const LayerParams &params)
 
 PriorBoxLayer::PriorBoxLayer(LayerParams &params) : Layer(params)
 {
+    useOpenCL = false;
     _minSize = getParameter<unsigned>(params, "min_size");
     CV_Assert(_minSize > 0);
 
@@ -188,6 +190,12 @@ void PriorBoxLayer::allocate(const std::vector<Blob*> &inputs, std::vector<Blob>
 {
     CV_Assert(inputs.size() == 2);
 
+    bool shapeChanged = _priors.empty() ||
+                        _layerWidth != (size_t)inputs[0]->cols() ||
+                        _layerHeight != (size_t)inputs[0]->rows() ||
+                        _imageWidth != (size_t)inputs[1]->cols() ||
+                        _imageHeight != (size_t)inputs[1]->rows();
+
     _layerWidth = inputs[0]->cols();
     _layerHeight = inputs[0]->rows();
 
@@ -205,15 +213,32 @@ void PriorBoxLayer::allocate(const std::vector<Blob*> &inputs, std::vector<Blob>
     size_t outChannels = 2;
     _outChannelSize = _layerHeight * _layerWidth * _numPriors * 4;
 
-    outputs[0].create(BlobShape(outNum, outChannels, _outChannelSize));
+    // priors are computed on the host and uploaded to the device, if the following layers use OpenCL
+    useOpenCL = ocl::useOpenCL();
+    int allocFlags = (useOpenCL) ? Blob::ALLOC_UMAT : Blob::ALLOC_MAT;
+
+    outputs[0].create(BlobShape(outNum, outChannels, _outChannelSize), CV_32F, allocFlags);
     outputs[0].matRef() = 0;
+
+    if (shapeChanged)
+        computePriors();
 }
 
 void PriorBoxLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outputs)
 {
     (void)inputs; // to suppress unused parameter warning
 
-    float* outputPtr = outputs[0].ptrf();
+    Mat priors(_priors.size(), CV_32F, outputs[0].ptrf());
+    _priors.copyTo(priors);
+
+    if (useOpenCL)
+        outputs[0].umatRef();
+}
+
+void PriorBoxLayer::computePriors()
+{
+    _priors.create(2, (int)_outChannelSize, CV_32F);
+    float* outputPtr = _priors.ptr<float>(0);
 
     // first prior: aspect_ratio = 1, size = min_size
     int idx = 0;
@@ -278,11 +303,10 @@ void PriorBoxLayer::forward(std::vector<Blob*> &inputs, std::vector<Blob> &outpu
         }
     }
     // set the variance.
-    outputPtr = outputs[0].ptrf(0, 1);
+    outputPtr = _priors.ptr<float>(1);
     if(_variance.size() == 1)
     {
-        Mat secondChannel(outputs[0].rows(), outputs[0].cols(), CV_32F, outputPtr);
-        secondChannel.setTo(Scalar(_variance[0]));
+        _priors.row(1).setTo(Scalar(_variance[0]));
     }
     else
     {
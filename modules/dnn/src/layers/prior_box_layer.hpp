@@ -72,8 +72,14 @@ class PriorBoxLayer : public Layer
     bool _flip;
     bool _clip;
 
+    bool useOpenCL;
+
     size_t _numPriors;
 
+    // Mean (row 0) and variance (row 1) of the prior coordinates, they only
+    // depend on the sizes of the inputs, so they are generated by allocate().
+    Mat _priors;
+
     static const size_t _numAxes = 4;
     static const std::string _layerName;
 
@@ -95,6 +101,7 @@ public:
 
     void getAspectRatios(const LayerParams &params);
     void getVariance(const LayerParams &params);
+    void computePriors();
 };
 }
 }
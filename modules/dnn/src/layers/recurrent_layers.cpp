@@ -84,7 +84,7 @@ class LSTMLayerImpl : public LSTMLayer
 {
     int numOut, numTimeStamps, numSamples, numInp;
     Mat hInternal, cInternal;
-    Mat gates, dummyOnes;
+    Mat allGates, dummyOnes;    //gates of all timestamps: (T*N) x 4*numOut
     int dtype;
     bool allocated;
 
@@ -155,6 +155,12 @@ public:
         return res;
     }
 
+    void resetState()
+    {
+        hInternal.setTo(0);
+        cInternal.setTo(0);
+    }
+
     void setOutShape(const Shape &outTailShape_)
     {
         CV_Assert(!allocated || outTailShape_.total() == outTailShape.total());
@@ -238,9 +244,9 @@ public:
             cInternal = cInternal.reshape(1, outTsMatShape.dims(), outTsMatShape.ptr());
         }
 
-        gates.create(numSamples, 4*numOut, dtype);
+        allGates.create(numTimeStamps*numSamples, 4*numOut, dtype);
 
-        dummyOnes.create(numSamples, 1, dtype);
+        dummyOnes.create(numTimeStamps*numSamples, 1, dtype);
         dummyOnes.setTo(1);
 
         allocated = true;
@@ -259,14 +265,16 @@ public:
         Mat hOutTs = reshaped(output[0].getRef<Mat>(), outMatShape);
         Mat cOutTs = (produceCellOutput) ? reshaped(output[1].getRef<Mat>(), outMatShape) : Mat();
 
+        //input projections don't depend on the previous state, so they are computed for all timestamps at once
+        dnn::gemm(xTs, Wx, 1, allGates, 0, GEMM_2_T);     // Wx * x_t
+        dnn::gemm(dummyOnes, bias, 1, allGates, 1);       //+b
+
         for (int ts = 0; ts < numTimeStamps; ts++)
         {
             Range curRowRange(ts*numSamples, (ts + 1)*numSamples);
-            Mat xCurr = xTs.rowRange(curRowRange);
+            Mat gates = allGates.rowRange(curRowRange);
 
-            dnn::gemm(xCurr, Wx, 1, gates, 0, GEMM_2_T);      // Wx * x_t
             dnn::gemm(hInternal, Wh, 1, gates, 1, GEMM_2_T);  //+Wh * h_{t-1}
-            dnn::gemm(dummyOnes, bias, 1, gates, 1);          //+b
 
             Mat getesIFO = gates.colRange(0, 3*numOut);
             Mat gateI = gates.colRange(0*numOut, 1*numOut);
@@ -328,7 +336,7 @@ class RNNLayerImpl : public RNNLayer
     int dtype;
     Mat Whh, Wxh, bh;
     Mat Who, bo;
-    Mat hCurr, hPrev, dummyBiasOnes;
+    Mat hAll, hPrev, dummyBiasOnes;   //hAll keeps hidden states of all timestamps if they aren't produced as output
     bool produceH;
 
 public:
@@ -344,6 +352,11 @@ public:
         produceH = produce;
     }
 
+    void resetState()
+    {
+        hPrev.setTo(0);
+    }
+
     void setWeights(const Blob &W_xh, const Blob &b_h, const Blob &W_hh, const Blob &W_ho, const Blob &b_o)
     {
         CV_Assert(W_hh.dims() == 2 && W_xh.dims() == 2);
@@ -381,11 +394,16 @@ public:
         numSamples = input[0]->size(1);
         numSamplesTotal = numTimestamps * numSamples;
 
-        hCurr.create(numSamples, numH, dtype);
-        hPrev.create(numSamples, numH, dtype);
-        hPrev.setTo(0);
+        //the state is kept between reallocations, if the number of samples isn't changed
+        if (hPrev.rows != numSamples || hPrev.cols != numH || hPrev.type() != dtype)
+        {
+            hPrev.create(numSamples, numH, dtype);
+            hPrev.setTo(0);
+        }
+        if (!produceH)
+            hAll.create(numSamplesTotal, numH, dtype);
 
-        dummyBiasOnes.create(numSamples, 1, dtype);
+        dummyBiasOnes.create(numSamplesTotal, 1, dtype);
         dummyBiasOnes.setTo(1);
         bh = bh.reshape(1, 1); //is 1 x numH Mat
         bo = bo.reshape(1, 1); //is 1 x numO Mat
@@ -405,26 +423,26 @@ public:
     {
         Mat xTs = reshaped(input[0]->getRefConst<Mat>(), Shape(numSamplesTotal, numX));
         Mat oTs = reshaped(output[0].getRef<Mat>(), Shape(numSamplesTotal, numO));
-        Mat hTs = (produceH) ? reshaped(output[1].getRef<Mat>(), Shape(numSamplesTotal, numH)) : Mat();
+        Mat hTs = (produceH) ? reshaped(output[1].getRef<Mat>(), Shape(numSamplesTotal, numH)) : hAll;
+
+        //input projections of all timestamps are computed at once
+        dnn::gemm(xTs, Wxh, 1, hTs, 0, GEMM_2_T);             // W_{xh} * x_{curr}
+        dnn::gemm(dummyBiasOnes, bh, 1, hTs, 1);              //+bh
 
         for (int ts = 0; ts < numTimestamps; ts++)
         {
             Range curRowRange = Range(ts * numSamples, (ts + 1) * numSamples);
-            Mat xCurr = xTs.rowRange(curRowRange);
+            Mat hCurr = hTs.rowRange(curRowRange);
 
-            dnn::gemm(hPrev, Whh, 1, hCurr, 0, GEMM_2_T); // W_{hh} * h_{prev}
-            dnn::gemm(xCurr, Wxh, 1, hCurr, 1, GEMM_2_T); //+W_{xh} * x_{curr}
-            dnn::gemm(dummyBiasOnes, bh, 1, hCurr, 1);    //+bh
-            tanh(hCurr, hPrev);
-
-            Mat oCurr = oTs.rowRange(curRowRange);
-            dnn::gemm(hPrev, Who, 1, oCurr, 0, GEMM_2_T); // W_{ho} * h_{prev}
-            dnn::gemm(dummyBiasOnes, bo, 1, oCurr, 1);    //+b_o
-            tanh(oCurr, oCurr);
-
-            if (produceH)
-                hPrev.copyTo(hTs.rowRange(curRowRange));
+            dnn::gemm(hPrev, Whh, 1, hCurr, 1, GEMM_2_T);     //+W_{hh} * h_{prev}
+            tanh(hCurr, hCurr);
+            hCurr.copyTo(hPrev);
         }
+
+        //output projections depend on the current hidden states only
+        dnn::gemm(hTs, Who, 1, oTs, 0, GEMM_2_T);             // W_{ho} * h_{curr}
+        dnn::gemm(dummyBiasOnes, bo, 1, oTs, 1);              //+b_o
+        tanh(oTs, oTs);
     }
 };
 
@@ -44,6 +44,7 @@
 #include "softmax_layer.hpp"
 #include <opencv2/core/ocl.hpp>
 #include "modules/dnn/opencl_kernels_dnn.hpp"
+#include <opencv2/core/hal/intrin.hpp>
 #include <algorithm>
 #include <stdlib.h>
 using std::max;
@@ -121,24 +122,24 @@ bool SoftMaxLayerImpl::forward_ocl(Blob &src, Blob &dst)
 
     kmax.args((int)outerSize, (int)channels, (int)innerSize,
               ocl::KernelArg::PtrReadOnly(dstMat), ocl::KernelArg::PtrReadWrite(bufMat));
-    if (!kmax.run(1, &bufSize, &wgSize, true))
+    if (!kmax.run(1, &bufSize, &wgSize, false))
         return false;
 
     ksub.args((int)totalSize, (int)outerSize, (int)channels, (int)innerSize,
               ocl::KernelArg::PtrReadOnly(bufMat), ocl::KernelArg::PtrReadWrite(dstMat));
-    if (!ksub.run(1, &totalSize, &wgSize, true))
+    if (!ksub.run(1, &totalSize, &wgSize, false))
         return false;
 
     cv::exp(dstMat, dstMat);
 
     ksum.args((int)outerSize, (int)channels, (int)innerSize,
               ocl::KernelArg::PtrReadOnly(dstMat), ocl::KernelArg::PtrReadWrite(bufMat));
-    if (!ksum.run(1, &bufSize, &wgSize, true))
+    if (!ksum.run(1, &bufSize, &wgSize, false))
         return false;
 
     kdiv.args((int)totalSize, (int)outerSize, (int)channels, (int)innerSize,
               ocl::KernelArg::PtrReadOnly(bufMat), ocl::KernelArg::PtrReadWrite(dstMat));
-    if (!kdiv.run(1, &totalSize, &wgSize, true))
+    if (!kdiv.run(1, &totalSize, &wgSize, false))
         return false;
 
     return true;
@@ -150,69 +151,164 @@ bool SoftMaxLayerImpl::forward_ocl(Blob&, Blob&)
 }
 #endif
 
-void SoftMaxLayerImpl::forward_cpu(Blob &src, Blob &dst)
+/* Softmax over the channels axis. The work is split into (outer index, block of inner indices) pairs,
+ * each pair owns its slice of the max/sum buffer, so they are distributed between threads.
+ * All passes are vectorized along the inner dimension, or along the channels if the inner size is 1.
+ */
+class SoftmaxInvoker : public ParallelLoopBody
 {
-    CV_Assert(src.type() == CV_32F);
+public:
+    enum { BLOCK_SIZE = 1024 };
 
-    float *srcPtr = src.ptrf();
-    float *dstPtr = dst.ptrf();
-    float *bufPtr = buf.ptrf();
+    SoftmaxInvoker(Blob &src, Blob &dst, Blob &buf, size_t outerSize, size_t channels_, size_t innerSize_)
+        : srcData(src.ptrf()), dstData(dst.ptrf()), bufData(buf.ptrf()),
+          channels(channels_), innerSize(innerSize_)
+    {
+        blocksPerOuter = (innerSize + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        totalBlocks = (int)(outerSize * blocksPerOuter);
+    }
 
-    size_t outerStep = src.total(axis);
-    size_t cnStep = src.total(axis + 1);
+    int total() const { return totalBlocks; }
 
-    //compute max along axis
-    for (size_t outerDim = 0; outerDim < outerSize; outerDim++)
+    void operator()(const Range &range) const
     {
-        size_t srcOffset = outerDim * outerStep;
-        size_t bufOffset = outerDim * cnStep;
-
-        memcpy(bufPtr + bufOffset, srcPtr + srcOffset, innerSize * sizeof(float));
+        for (int b = range.start; b < range.end; b++)
+        {
+            size_t outerDim = b / blocksPerOuter;
+            size_t start = (b % blocksPerOuter) * BLOCK_SIZE;
+            int len = (int)std::min((size_t)BLOCK_SIZE, innerSize - start);
+
+            const float *src = srcData + outerDim * channels * innerSize + start;
+            float *dst = dstData + outerDim * channels * innerSize + start;
+            float *buf = bufData + outerDim * innerSize + start;
+
+            if (innerSize == 1)
+                softmaxContinuous(src, dst);
+            else
+                softmaxStrided(src, dst, buf, len);
+        }
+    }
 
-        for (size_t cnDim = 1; cnDim < channels; cnDim++)
+private:
+    //the channels are contiguous
+    void softmaxContinuous(const float *src, float *dst) const
+    {
+        int cn = (int)channels, i = 0;
+        float maxVal = src[0];
+#if CV_SIMD128
+        if (cn >= 4)
         {
-            for (size_t i = 0; i < innerSize; i++)
-                bufPtr[bufOffset + i] = std::max(bufPtr[bufOffset + i], srcPtr[srcOffset + cnDim * cnStep + i]);
+            v_float32x4 vmax = v_load(src);
+            for (i = 4; i <= cn - 4; i += 4)
+                vmax = v_max(vmax, v_load(src + i));
+            maxVal = v_reduce_max(vmax);
         }
+#endif
+        for (; i < cn; i++)
+            maxVal = std::max(maxVal, src[i]);
+
+        i = 0;
+#if CV_SIMD128
+        v_float32x4 vmaxVal = v_setall_f32(maxVal);
+        for (; i <= cn - 4; i += 4)
+            v_store(dst + i, v_load(src + i) - vmaxVal);
+#endif
+        for (; i < cn; i++)
+            dst[i] = src[i] - maxVal;
+
+        Mat dstMat(1, cn, CV_32F, dst);
+        cv::exp(dstMat, dstMat);
+
+        i = 0;
+        float sum = 0.f;
+#if CV_SIMD128
+        v_float32x4 vsum = v_setzero_f32();
+        for (; i <= cn - 4; i += 4)
+            vsum += v_load(dst + i);
+        sum = v_reduce_sum(vsum);
+#endif
+        for (; i < cn; i++)
+            sum += dst[i];
+
+        dstMat *= 1.f / sum;
     }
 
-    //subtract max
-    for (size_t outerDim = 0; outerDim < outerSize; outerDim++)
+    //the channels are innerSize apart, the block of len inner elements is processed
+    void softmaxStrided(const float *src, float *dst, float *buf, int len) const
     {
-        size_t srcOffset = outerDim * outerStep;
-        size_t bufOffset = outerDim * cnStep;
+        //compute max along axis
+        memcpy(buf, src, len * sizeof(float));
+        for (size_t cnDim = 1; cnDim < channels; cnDim++)
+        {
+            const float *srcRow = src + cnDim * innerSize;
+            int i = 0;
+#if CV_SIMD128
+            for (; i <= len - 4; i += 4)
+                v_store(buf + i, v_max(v_load(buf + i), v_load(srcRow + i)));
+#endif
+            for (; i < len; i++)
+                buf[i] = std::max(buf[i], srcRow[i]);
+        }
 
+        //subtract max
         for (size_t cnDim = 0; cnDim < channels; cnDim++)
         {
-            for (size_t i = 0; i < innerSize; i++)
-                dstPtr[srcOffset + cnDim * cnStep + i] = srcPtr[srcOffset + cnDim * cnStep + i] - bufPtr[bufOffset + i];
+            const float *srcRow = src + cnDim * innerSize;
+            float *dstRow = dst + cnDim * innerSize;
+            int i = 0;
+#if CV_SIMD128
+            for (; i <= len - 4; i += 4)
+                v_store(dstRow + i, v_load(srcRow + i) - v_load(buf + i));
+#endif
+            for (; i < len; i++)
+                dstRow[i] = srcRow[i] - buf[i];
         }
-    }
 
-    cv::exp(dst.matRef(), dst.matRef());
-
-    for (size_t outerDim = 0; outerDim < outerSize; outerDim++)
-    {
-        size_t srcOffset = outerDim * outerStep;
-        size_t bufOffset = outerDim * cnStep;
+        Mat dstMat((int)channels, len, CV_32F, dst, innerSize * sizeof(float));
+        cv::exp(dstMat, dstMat);
 
         //sum exp along axis
-        for (size_t i = 0; i < innerSize; i++)
-            bufPtr[bufOffset + i] = 0.f;
-
+        std::fill(buf, buf + len, 0.f);
         for (size_t cnDim = 0; cnDim < channels; cnDim++)
         {
-            for (size_t i = 0; i < innerSize; i++)
-                bufPtr[bufOffset + i] += dstPtr[srcOffset + cnDim * cnStep + i];
+            const float *dstRow = dst + cnDim * innerSize;
+            int i = 0;
+#if CV_SIMD128
+            for (; i <= len - 4; i += 4)
+                v_store(buf + i, v_load(buf + i) + v_load(dstRow + i));
+#endif
+            for (; i < len; i++)
+                buf[i] += dstRow[i];
         }
 
         //divide by computed sum
+        for (int i = 0; i < len; i++)
+            buf[i] = 1.f / buf[i];
         for (size_t cnDim = 0; cnDim < channels; cnDim++)
         {
-            for (size_t i = 0; i < innerSize; i++)
-                dstPtr[srcOffset + cnDim * cnStep + i] /= bufPtr[bufOffset + i];
+            float *dstRow = dst + cnDim * innerSize;
+            int i = 0;
+#if CV_SIMD128
+            for (; i <= len - 4; i += 4)
+                v_store(dstRow + i, v_load(dstRow + i) * v_load(buf + i));
+#endif
+            for (; i < len; i++)
+                dstRow[i] *= buf[i];
         }
     }
+
+    const float *srcData;
+    float *dstData, *bufData;
+    size_t channels, innerSize, blocksPerOuter;
+    int totalBlocks;
+};
+
+void SoftMaxLayerImpl::forward_cpu(Blob &src, Blob &dst)
+{
+    CV_Assert(src.type() == CV_32F);
+
+    SoftmaxInvoker invoker(src, dst, buf, outerSize, channels, innerSize);
+    parallel_for_(Range(0, invoker.total()), invoker);
 }
 
 Ptr<SoftmaxLayer> SoftmaxLayer::create(int axis)
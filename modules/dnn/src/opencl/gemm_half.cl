@@ -0,0 +1,20 @@
+// Computes C = A * B^T, where B is stored in half precision (IEEE 754 binary16) and A, C - in single precision.
+// vload_half() is a part of the core OpenCL, so the kernel doesn't need cl_khr_fp16 extension.
+// Products are accumulated in single precision, because activations may exceed the range of half.
+__kernel void MatMulHalfBt(const int M, const int N, const int K,
+                           __global const float* A, __global const half* B, __global float* C) {
+  int n = get_global_id(0);
+  int m = get_global_id(1);
+  if (n < N && m < M) {
+    __global const float* a = A + m * K;
+    __global const half* b = B + n * K;
+    float4 acc4 = (float4)(0.f);
+    int k = 0;
+    for (; k + 4 <= K; k += 4)
+      acc4 += vload4(0, a + k) * vload_half4(0, b + k);
+    float acc = acc4.s0 + acc4.s1 + acc4.s2 + acc4.s3;
+    for (; k < K; k++)
+      acc += a[k] * vload_half(k, b);
+    C[m * N + n] = acc;
+  }
+}
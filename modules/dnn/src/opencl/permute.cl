@@ -0,0 +1,14 @@
+__kernel void PermuteForward(const int count, __global const T* in, __global const int* order,
+                             __global const int* oldStride, __global const int* newStride,
+                             const int numAxes, __global T* out) {
+  int index = get_global_id(0);
+  if (index < count) {
+    int oldPosition = 0;
+    int newPosition = index;
+    for (int j = 0; j < numAxes; ++j) {
+      oldPosition += (newPosition / newStride[j]) * oldStride[order[j]];
+      newPosition %= newStride[j];
+    }
+    out[index] = in[oldPosition];
+  }
+}
@@ -0,0 +1,334 @@
+#if defined(ENABLE_TORCH_IMPORTER) && ENABLE_TORCH_IMPORTER
+#include "THGeneral.h"
+#include "THMappedFile.h"
+#include "THFilePrivate.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+extern "C"
+{
+
+typedef struct THMappedFile__
+{
+    THFile file;
+
+    char *data;
+    long size;
+    long position;
+    int isOpened;
+
+#ifdef _WIN32
+    HANDLE handle;
+    HANDLE mapping;
+#endif
+
+} THMappedFile;
+
+static int THMappedFile_isOpened(THFile *self)
+{
+  THMappedFile *mfself = (THMappedFile*)self;
+  return mfself->isOpened;
+}
+
+/* the mapping only holds native binary data, so reading is a copy */
+#define READ_WRITE_METHODS(TYPE, TYPEC)                                 \
+  static long THMappedFile_read##TYPEC(THFile *self, TYPE *data, long n) \
+  {                                                                     \
+    THMappedFile *mfself = (THMappedFile*)(self);                       \
+    long nread;                                                         \
+                                                                        \
+    THArgCheck(mfself->isOpened, 1, "attempt to use a closed file");    \
+    THArgCheck(mfself->file.isBinary, 1, "mapped files are binary only"); \
+                                                                        \
+    nread = THMin(n, (mfself->size - mfself->position)/(long)sizeof(TYPE)); \
+    if(nread > 0)                                                       \
+    {                                                                   \
+      memcpy(data, mfself->data + mfself->position, nread*sizeof(TYPE)); \
+      mfself->position += nread*sizeof(TYPE);                           \
+    }                                                                   \
+    else                                                                \
+      nread = 0;                                                        \
+                                                                        \
+    if(nread != n)                                                      \
+    {                                                                   \
+      mfself->file.hasError = 1;                                        \
+      if(!mfself->file.isQuiet)                                         \
+        THError("read error: read %d blocks instead of %d", nread, n);  \
+    }                                                                   \
+                                                                        \
+    return nread;                                                       \
+  }                                                                     \
+                                                                        \
+  static long THMappedFile_write##TYPEC(THFile *self, TYPE *data, long n) \
+  {                                                                     \
+    (void)data;                                                         \
+    (void)n;                                                            \
+    THArgCheck(0, 1, "attempt to write in a read-only file");           \
+    return 0;                                                           \
+  }
+
+READ_WRITE_METHODS(unsigned char, Byte)
+READ_WRITE_METHODS(char, Char)
+READ_WRITE_METHODS(short, Short)
+READ_WRITE_METHODS(int, Int)
+READ_WRITE_METHODS(long, Long)
+READ_WRITE_METHODS(float, Float)
+READ_WRITE_METHODS(double, Double)
+
+const void *THMappedFile_readPointer(THFile *self, long n)
+{
+  THMappedFile *mfself = (THMappedFile*)(self);
+  const char *ptr;
+
+  THArgCheck(mfself->isOpened, 1, "attempt to use a closed file");
+  THArgCheck(n >= 0, 2, "size must be positive");
+
+  if(n > mfself->size - mfself->position)
+  {
+    mfself->file.hasError = 1;
+    if(!mfself->file.isQuiet)
+      THError("read error: %ld bytes left instead of %ld", mfself->size - mfself->position, n);
+    return NULL;
+  }
+
+  ptr = mfself->data + mfself->position;
+  mfself->position += n;
+  return ptr;
+}
+
+static long THMappedFile_readString(THFile *self, const char *format, char **str_)
+{
+  THMappedFile *mfself = (THMappedFile*)(self);
+  long size;
+  char *p;
+
+  THArgCheck(mfself->isOpened, 1, "attempt to use a closed file");
+  THArgCheck((strlen(format) >= 2 ? (format[0] == '*') && (format[1] == 'a' || format[1] == 'l') : 0), 2, "format must be '*a' or '*l'");
+
+  if(mfself->position >= mfself->size)
+  {
+    mfself->file.hasError = 1;
+    if(!mfself->file.isQuiet)
+      THError("read error: read 0 blocks instead of 1");
+
+    *str_ = NULL;
+    return 0;
+  }
+
+  size = mfself->size - mfself->position;
+  if(format[1] == 'l')
+  {
+    const char *eol = (const char*)memchr(mfself->data + mfself->position, '\n', size);
+    if(eol)
+      size = eol - (mfself->data + mfself->position);
+  }
+
+  p = (char*)THAlloc(size > 0 ? size : 1);
+  memcpy(p, mfself->data + mfself->position, size);
+  mfself->position += size;
+  /* do not include `eol' */
+  if(format[1] == 'l' && mfself->position < mfself->size)
+    mfself->position++;
+
+  *str_ = p;
+  return size;
+}
+
+static long THMappedFile_writeString(THFile *self, const char *str, long size)
+{
+  (void)self;
+  (void)str;
+  (void)size;
+  THArgCheck(0, 1, "attempt to write in a read-only file");
+  return 0;
+}
+
+static void THMappedFile_synchronize(THFile *self)
+{
+  THMappedFile *mfself = (THMappedFile*)(self);
+  THArgCheck(mfself->isOpened, 1, "attempt to use a closed file");
+}
+
+static void THMappedFile_seek(THFile *self, long position)
+{
+  THMappedFile *mfself = (THMappedFile*)(self);
+
+  THArgCheck(mfself->isOpened, 1, "attempt to use a closed file");
+  THArgCheck(position >= 0, 2, "position must be positive");
+
+  if(position > mfself->size)
+  {
+    mfself->file.hasError = 1;
+    if(!mfself->file.isQuiet)
+      THError("unable to seek at position %d", position);
+  }
+  else
+    mfself->position = position;
+}
+
+static void THMappedFile_seekEnd(THFile *self)
+{
+  THMappedFile *mfself = (THMappedFile*)(self);
+  THArgCheck(mfself->isOpened, 1, "attempt to use a closed file");
+  mfself->position = mfself->size;
+}
+
+static long THMappedFile_position(THFile *self)
+{
+  THMappedFile *mfself = (THMappedFile*)(self);
+  THArgCheck(mfself->isOpened, 1, "attempt to use a closed file");
+  return mfself->position;
+}
+
+static void THMappedFile_unmap(THMappedFile *mfself)
+{
+#ifdef _WIN32
+  if(mfself->data)
+    UnmapViewOfFile(mfself->data);
+  if(mfself->mapping)
+    CloseHandle(mfself->mapping);
+  if(mfself->handle != INVALID_HANDLE_VALUE)
+    CloseHandle(mfself->handle);
+  mfself->mapping = NULL;
+  mfself->handle = INVALID_HANDLE_VALUE;
+#else
+  if(mfself->data)
+    munmap(mfself->data, mfself->size);
+#endif
+  mfself->data = NULL;
+  mfself->isOpened = 0;
+}
+
+static void THMappedFile_close(THFile *self)
+{
+  THMappedFile *mfself = (THMappedFile*)(self);
+  THArgCheck(mfself->isOpened, 1, "attempt to use a closed file");
+  THMappedFile_unmap(mfself);
+}
+
+static void THMappedFile_free(THFile *self)
+{
+  THMappedFile *mfself = (THMappedFile*)(self);
+  if(mfself->isOpened)
+    THMappedFile_unmap(mfself);
+  THFree(mfself);
+}
+
+/* maps the whole file, an empty file is opened without a mapping */
+static int THMappedFile_map(THMappedFile *self, const char *name)
+{
+#ifdef _WIN32
+  LARGE_INTEGER size;
+
+  self->handle = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  self->mapping = NULL;
+  if(self->handle == INVALID_HANDLE_VALUE)
+    return 0;
+  if(!GetFileSizeEx(self->handle, &size) || size.QuadPart > LONG_MAX)
+    return 0;
+  self->size = (long)size.QuadPart;
+  if(self->size == 0)
+    return 1;
+
+  self->mapping = CreateFileMappingA(self->handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(!self->mapping)
+    return 0;
+  self->data = (char*)MapViewOfFile(self->mapping, FILE_MAP_READ, 0, 0, 0);
+  return self->data != NULL;
+#else
+  struct stat st;
+  void *data;
+  int fd = open(name, O_RDONLY);
+
+  if(fd < 0)
+    return 0;
+  if(fstat(fd, &st) < 0 || st.st_size > LONG_MAX)
+  {
+    close(fd);
+    return 0;
+  }
+  self->size = (long)st.st_size;
+  if(self->size == 0)
+  {
+    close(fd);
+    return 1;
+  }
+
+  data = mmap(NULL, self->size, PROT_READ, MAP_PRIVATE, fd, 0);
+  /* the mapping keeps its own reference to the file */
+  close(fd);
+  if(data == MAP_FAILED)
+    return 0;
+  self->data = (char*)data;
+  return 1;
+#endif
+}
+
+THFile *THMappedFile_new(const char *name, int isQuiet)
+{
+  static struct THFileVTable vtable = {
+    THMappedFile_isOpened,
+
+    THMappedFile_readByte,
+    THMappedFile_readChar,
+    THMappedFile_readShort,
+    THMappedFile_readInt,
+    THMappedFile_readLong,
+    THMappedFile_readFloat,
+    THMappedFile_readDouble,
+    THMappedFile_readString,
+
+    THMappedFile_writeByte,
+    THMappedFile_writeChar,
+    THMappedFile_writeShort,
+    THMappedFile_writeInt,
+    THMappedFile_writeLong,
+    THMappedFile_writeFloat,
+    THMappedFile_writeDouble,
+    THMappedFile_writeString,
+
+    THMappedFile_synchronize,
+    THMappedFile_seek,
+    THMappedFile_seekEnd,
+    THMappedFile_position,
+    THMappedFile_close,
+    THMappedFile_free
+  };
+
+  THMappedFile *self = (THMappedFile*)THAlloc(sizeof(THMappedFile));
+
+  self->data = NULL;
+  self->size = 0;
+  self->position = 0;
+  self->isOpened = 1;
+
+  if(!THMappedFile_map(self, name))
+  {
+    THMappedFile_unmap(self);
+    THFree(self);
+    if(isQuiet)
+      return 0;
+    else
+      THError("cannot map <%s> in mode r", name);
+  }
+
+  self->file.vtable = &vtable;
+  self->file.isQuiet = isQuiet;
+  self->file.isReadable = 1;
+  self->file.isWritable = 0;
+  self->file.isBinary = 1;
+  self->file.isAutoSpacing = 0;
+  self->file.hasError = 0;
+
+  return (THFile*)self;
+}
+
+}
+#endif
@@ -0,0 +1,13 @@
+#ifndef TH_MAPPED_FILE_INC
+#define TH_MAPPED_FILE_INC
+
+#include "THFile.h"
+
+/* read-only binary file in native encoding, mapped in memory */
+TH_API THFile *THMappedFile_new(const char *name, int isQuiet);
+
+/* pointer to the next n bytes of the mapping, which are skipped as if they were read,
+   NULL if the file has not n bytes left; it is valid until the file is closed */
+TH_API const void *THMappedFile_readPointer(THFile *self, long n);
+
+#endif
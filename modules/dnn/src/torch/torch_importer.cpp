@@ -51,6 +51,7 @@ namespace dnn {
 
 #if defined(ENABLE_TORCH_IMPORTER) && ENABLE_TORCH_IMPORTER
 #include "THDiskFile.h"
+#include "THMappedFile.h"
 
 #ifdef NDEBUG
 static bool dbgPrint = false;
@@ -94,6 +95,7 @@ struct TorchImporter : public ::cv::dnn::Importer
     Net net;
 
     THFile *file;
+    bool isMapped;
     std::set<int> readedIndexes;
     std::map<int, Mat> storages;
     std::map<int, Blob> tensors;
@@ -123,7 +125,11 @@ struct TorchImporter : public ::cv::dnn::Importer
         rootModule = curModule = NULL;
         moduleCounter = 0;
 
-        file = THDiskFile_new(filename.c_str(), "r", 0);
+        //binary files are mapped, so the storages are read without copies
+        file = isBinary ? THMappedFile_new(filename.c_str(), 1) : NULL;
+        isMapped = (file != NULL);
+        if (!isMapped)
+            file = THDiskFile_new(filename.c_str(), "r", 0);
         CV_Assert(file && THFile_isOpened(file));
 
         if (isBinary)
@@ -132,6 +138,12 @@ struct TorchImporter : public ::cv::dnn::Importer
             THFile_ascii(file);
     }
 
+    ~TorchImporter()
+    {
+        delete rootModule;
+        THFile_free(file);
+    }
+
     /* Simple readers */
 
     inline int readInt()
@@ -233,6 +245,16 @@ struct TorchImporter : public ::cv::dnn::Importer
     void readTorchStorage(int index, int type = -1)
     {
         long size = readLong();
+
+        if (isMapped && type != CV_USRTYPE1 && type >= 0)
+        {
+            //the storage refers to the mapped file, tensors are converted from it into their own Blobs
+            const void *data = THMappedFile_readPointer(file, size * CV_ELEM_SIZE(type));
+            CV_Assert(data);
+            storages.insert(std::make_pair(index, Mat(1, size, type, const_cast<void*>(data))));
+            return;
+        }
+
         Mat storageMat(1, size, (type != CV_USRTYPE1) ? type : CV_64F); //handle LongStorage as CV_64F Mat
 
         switch (type)
@@ -0,0 +1,146 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "test_precomp.hpp"
+#include "npy_blob.hpp"
+#include <cstdio>
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::dnn;
+
+template<typename TString>
+static std::string _tf(TString filename)
+{
+    return (getOpenCVExtraDir() + "/dnn/") + filename;
+}
+
+TEST(Test_Binary, write_read_params)
+{
+    RNG rng(0);
+    Blob weights(BlobShape(4, 3, 3, 3)), biases(BlobShape(4));
+    rng.fill(weights.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(biases.matRef(), RNG::UNIFORM, -1, 1);
+
+    LayerParams convParams;
+    convParams.set("kernel_size", 3);
+    convParams.set("num_output", 4);
+    convParams.blobs.push_back(weights);
+    convParams.blobs.push_back(biases);
+
+    LayerParams poolParams;
+    poolParams.set("pool", "AVE");
+    poolParams.set("kernel_size", 2);
+    poolParams.set("stride", 2);
+
+    LayerParams powerParams;
+    powerParams.set("scale", 0.5);
+
+    Net net;
+    std::vector<String> netInputs(1, "data");
+    net.setNetInputs(netInputs);
+    int convId = net.addLayer("conv", "Convolution", convParams);
+    int poolId = net.addLayer("pool", "Pooling", poolParams);
+    int powerId = net.addLayer("power", "Power", powerParams);
+    net.connect(0, 0, convId, 0);
+    net.connect(convId, 0, poolId, 0);
+    net.connect(poolId, 0, powerId, 0);
+
+    Blob inp(BlobShape(2, 3, 10, 10));
+    rng.fill(inp.matRef(), RNG::UNIFORM, -1, 1);
+    net.setBlob(".data", inp);
+    net.forward();
+    Blob ref = net.getBlob("power");
+
+    String path = tempfile(".cvdnn");
+    net.writeBinary(path);
+
+    {
+        Net net2 = readNetFromBinary(path);
+        normAssert(weights, net2.getParam("conv", 0));
+        normAssert(biases, net2.getParam("conv", 1));
+
+        net2.setBlob(".data", inp);
+        net2.forward();
+        normAssert(ref, net2.getBlob("power"));
+    }
+    remove(path.c_str());
+}
+
+TEST(Test_Binary, read_invalid)
+{
+    String path = tempfile(".cvdnn");
+    {
+        FILE *f = fopen(path.c_str(), "wb");
+        ASSERT_TRUE(f != NULL);
+        fputs("name: \"not a network\"", f);
+        fclose(f);
+    }
+
+    EXPECT_ANY_THROW(readNetFromBinary(path));
+    remove(path.c_str());
+}
+
+TEST(Reproducibility_GoogLeNet, Binary)
+{
+    String path = tempfile(".cvdnn");
+    readNetFromCaffe(_tf("bvlc_googlenet.prototxt"), _tf("bvlc_googlenet.caffemodel")).writeBinary(path);
+
+    Net net = readNetFromBinary(path);
+
+    std::vector<Mat> inpMats;
+    inpMats.push_back( imread(_tf("googlenet_0.jpg")) );
+    inpMats.push_back( imread(_tf("googlenet_1.jpg")) );
+    ASSERT_TRUE(!inpMats[0].empty() && !inpMats[1].empty());
+
+    net.setBlob(".data", Blob::fromImages(inpMats));
+    net.forward();
+
+    Blob out = net.getBlob("prob");
+    Blob ref = blobFromNPY(_tf("googlenet_prob.npy"));
+    normAssert(out, ref);
+
+    remove(path.c_str());
+}
+
+}
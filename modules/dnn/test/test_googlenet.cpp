@@ -57,7 +57,7 @@ static std::string _tf(TString filename)
     return (getOpenCVExtraDir() + "/dnn/") + filename;
 }
 
-static void launchGoogleNetTest()
+static void launchGoogleNetTest(bool reuseMemory = false, bool parallelBranches = false)
 {
     Net net;
     {
@@ -71,6 +71,8 @@ static void launchGoogleNetTest()
     inpMats.push_back( imread(_tf("googlenet_1.jpg")) );
     ASSERT_TRUE(!inpMats[0].empty() && !inpMats[1].empty());
 
+    net.setMemoryReuse(reuseMemory);
+    net.setParallelBranches(parallelBranches);
     net.setBlob(".data", Blob::fromImages(inpMats));
     net.forward();
 
@@ -84,6 +86,16 @@ TEST(Reproducibility_GoogLeNet, Accuracy)
     OCL_OFF(launchGoogleNetTest());
 }
 
+TEST(Reproducibility_GoogLeNet, MemoryReuse)
+{
+    OCL_OFF(launchGoogleNetTest(true));
+}
+
+TEST(Reproducibility_GoogLeNet, ParallelBranches)
+{
+    OCL_OFF(launchGoogleNetTest(true, true));
+}
+
 OCL_TEST(Reproducibility_GoogLeNet, Accuracy)
 {
     OCL_ON(launchGoogleNetTest());
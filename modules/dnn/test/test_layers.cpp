@@ -42,6 +42,7 @@
 #include "test_precomp.hpp"
 #include <opencv2/core/ocl.hpp>
 #include <iostream>
+#include <float.h>
 #include "npy_blob.hpp"
 #include <opencv2/dnn/all_layers.hpp>
 #include <opencv2/ts/ocl_test.hpp>
@@ -120,6 +121,29 @@ OCL_TEST(Layer_Test_Softmax, Accuracy)
      OCL_OFF();
 }
 
+TEST(Layer_Test_Convolution, forwardBatch)
+{
+    Net net;
+    {
+        Ptr<Importer> importer = createCaffeImporter(_tf("layer_convolution.prototxt"), _tf("layer_convolution.caffemodel"));
+        ASSERT_TRUE(importer != NULL);
+        importer->populateNet(net);
+    }
+
+    Blob inp = blobFromNPY(_tf("blob.npy"));
+    Blob ref = blobFromNPY(_tf("layer_convolution.npy"));
+
+    std::vector<Mat> images, outputs;
+    for (int n = 0; n < inp.num(); n++)
+        images.push_back(inp.getPlanes(n));
+
+    net.forwardBatch(images, ".input", "output", outputs);
+
+    ASSERT_EQ(images.size(), outputs.size());
+    for (int n = 0; n < ref.num(); n++)
+        normAssert(ref.getPlanes(n), outputs[n]);
+}
+
 TEST(Layer_Test_LRN_spatial, Accuracy)
 {
      OCL_OFF(testLayerUsingCaffeModels("layer_lrn_spatial"));
@@ -150,6 +174,364 @@ OCL_TEST(Layer_Test_Convolution, Accuracy)
      OCL_OFF();
 }
 
+TEST(Layer_Test_Convolution, Winograd3x3)
+{
+    const int inpCn = 5, outCn = 7, rows = 11, cols = 13;
+    RNG rng(0);
+
+    Blob weights(BlobShape(outCn, inpCn, 3, 3)), biases(BlobShape(outCn));
+    rng.fill(weights.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(biases.matRef(), RNG::UNIFORM, -1, 1);
+
+    Ptr<BaseConvolutionLayer> layer = ConvolutionLayer::create(Size(3, 3), Size(1, 1), Size(1, 1));
+    layer->blobs.push_back(weights);
+    layer->blobs.push_back(biases);
+
+    std::vector<Blob> inputs(1, Blob(BlobShape(2, inpCn, rows, cols))), outputs;
+    rng.fill(inputs[0].matRef(), RNG::UNIFORM, -1, 1);
+    runLayer(layer, inputs, outputs);
+
+    Blob ref(BlobShape(2, outCn, rows, cols));
+    for (int n = 0; n < 2; n++)
+    {
+        for (int oc = 0; oc < outCn; oc++)
+        {
+            Mat acc(rows, cols, CV_32F, Scalar(biases.matRefConst().at<float>(oc)));
+            for (int ic = 0; ic < inpCn; ic++)
+            {
+                Mat kernel(3, 3, CV_32F, weights.ptrf(oc, ic)), dst;
+                filter2D(inputs[0].getPlane(n, ic), dst, CV_32F, kernel, Point(-1, -1), 0, BORDER_CONSTANT);
+                acc += dst;
+            }
+            acc.copyTo(ref.getPlane(n, oc));
+        }
+    }
+
+    normAssert(ref, outputs[0]);
+}
+
+TEST(Layer_Test_Fusion, Convolution_ReLU)
+{
+    RNG rng(0);
+    Blob weights(BlobShape(4, 3, 3, 3)), biases(BlobShape(4));
+    rng.fill(weights.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(biases.matRef(), RNG::UNIFORM, -1, 1);
+
+    LayerParams convParams;
+    convParams.set("kernel_size", 3);
+    convParams.set("num_output", 4);
+    convParams.blobs.push_back(weights);
+    convParams.blobs.push_back(biases);
+
+    Blob inp(BlobShape(2, 3, 10, 10));
+    rng.fill(inp.matRef(), RNG::UNIFORM, -1, 1);
+
+    std::vector<Blob> inputs(1, inp), convOutputs;
+    runLayer(LayerFactory::createLayerInstance("Convolution", convParams), inputs, convOutputs);
+    Mat ref = cv::max(convOutputs[0].matRefConst(), 0);
+
+    Net net;
+    LayerParams reluParams;
+    int convId = net.addLayer("conv", "Convolution", convParams);
+    int reluId = net.addLayer("relu", "ReLU", reluParams);
+    net.connect(0, 0, convId, 0);
+    net.connect(convId, 0, reluId, 0);
+
+    net.setBlob(".0", inp);
+    net.forward();
+
+    normAssert(ref, net.getBlob("relu").matRefConst());
+}
+
+class ForwardContextsBody : public ParallelLoopBody
+{
+public:
+    ForwardContextsBody(std::vector<Net> &nets_, const std::vector<Blob> &inputs_, std::vector<Blob> &outputs_)
+        : nets(nets_), inputs(inputs_), outputs(outputs_) {}
+
+    void operator()(const Range &r) const
+    {
+        for (int i = r.start; i < r.end; i++)
+        {
+            nets[i].setBlob(".0", inputs[i]);
+            nets[i].forward();
+            outputs[i] = nets[i].getBlob("relu");
+        }
+    }
+
+private:
+    std::vector<Net> &nets;
+    const std::vector<Blob> &inputs;
+    std::vector<Blob> &outputs;
+};
+
+TEST(Layer_Test_Net, createContext)
+{
+    RNG rng(0);
+    Blob weights(BlobShape(4, 3, 3, 3)), biases(BlobShape(4));
+    rng.fill(weights.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(biases.matRef(), RNG::UNIFORM, -1, 1);
+
+    LayerParams convParams;
+    convParams.set("kernel_size", 3);
+    convParams.set("num_output", 4);
+    convParams.blobs.push_back(weights);
+    convParams.blobs.push_back(biases);
+
+    Net net;
+    LayerParams reluParams;
+    int convId = net.addLayer("conv", "Convolution", convParams);
+    int reluId = net.addLayer("relu", "ReLU", reluParams);
+    net.connect(0, 0, convId, 0);
+    net.connect(convId, 0, reluId, 0);
+
+    const int numContexts = 4;
+    std::vector<Net> nets(1, net);
+    std::vector<Blob> inputs(numContexts), outputs(numContexts), refs(numContexts);
+    for (int i = 0; i < numContexts; i++)
+    {
+        if (i > 0)
+            nets.push_back(net.createContext());
+        inputs[i] = Blob(BlobShape(2, 3, 10, 10));
+        rng.fill(inputs[i].matRef(), RNG::UNIFORM, -1, 1);
+
+        std::vector<Blob> convInputs(1, inputs[i]), convOutputs;
+        runLayer(LayerFactory::createLayerInstance("Convolution", convParams), convInputs, convOutputs);
+        refs[i] = Blob(cv::max(convOutputs[0].matRefConst(), 0));
+    }
+
+    parallel_for_(Range(0, numContexts), ForwardContextsBody(nets, inputs, outputs));
+
+    for (int i = 0; i < numContexts; i++)
+    {
+        EXPECT_EQ(net.getParam("conv").matRefConst().data, nets[i].getParam("conv").matRefConst().data);
+        normAssert(refs[i], outputs[i]);
+    }
+}
+
+TEST(Layer_Test_Net, GemmBackends)
+{
+    RNG rng(0);
+    Blob weights(BlobShape(8, 3, 3, 3)), fcWeights(BlobShape(5, 8*8*8)), fcBiases(BlobShape(5));
+    rng.fill(weights.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(fcWeights.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(fcBiases.matRef(), RNG::UNIFORM, -1, 1);
+
+    LayerParams convParams, fcParams;
+    convParams.set("kernel_size", 3);
+    convParams.set("num_output", 8);
+    convParams.set("bias_term", false);
+    convParams.blobs.push_back(weights);
+    fcParams.set("num_output", 5);
+    fcParams.blobs.push_back(fcWeights);
+    fcParams.blobs.push_back(fcBiases);
+
+    Net net;
+    int convId = net.addLayer("conv", "Convolution", convParams);
+    int fcId = net.addLayer("fc", "InnerProduct", fcParams);
+    net.connect(0, 0, convId, 0);
+    net.connect(convId, 0, fcId, 0);
+
+    Blob input(BlobShape(2, 3, 10, 10));
+    rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+    net.setBlob(".input", input);
+    net.forward();
+    Blob ref(net.getBlob("fc").matRefConst().clone());
+
+    std::vector<String> backends = getGemmBackendNames();
+    ASSERT_FALSE(backends.empty());
+    backends.push_back("auto");
+    for (size_t i = 0; i < backends.size(); i++)
+    {
+        net.setGemmBackend(backends[i]);
+        net.setBlob(".input", input);
+        net.forward();
+        Blob out = net.getBlob("fc");
+        normAssert(ref, out, backends[i].c_str());
+    }
+
+    EXPECT_ANY_THROW(net.setGemmBackend("unknown"));
+}
+
+static void testHalfWeights()
+{
+    RNG rng(0);
+    Blob weights(BlobShape(8, 3, 3, 3)), deconvWeights(BlobShape(8, 8, 3, 3)), fcWeights(BlobShape(5, 8*10*10)), fcBiases(BlobShape(5));
+    rng.fill(weights.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(deconvWeights.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(fcWeights.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(fcBiases.matRef(), RNG::UNIFORM, -1, 1);
+
+    LayerParams convParams, deconvParams, fcParams;
+    convParams.set("kernel_size", 3);
+    convParams.set("num_output", 8);
+    convParams.blobs.push_back(weights);
+    deconvParams.set("kernel_size", 3);
+    deconvParams.set("num_output", 8);
+    deconvParams.blobs.push_back(deconvWeights);
+    fcParams.set("num_output", 5);
+    fcParams.blobs.push_back(fcWeights);
+    fcParams.blobs.push_back(fcBiases);
+
+    Net net;
+    int convId = net.addLayer("conv", "Convolution", convParams);
+    int deconvId = net.addLayer("deconv", "Deconvolution", deconvParams);
+    int fcId = net.addLayer("fc", "InnerProduct", fcParams);
+    net.connect(0, 0, convId, 0);
+    net.connect(convId, 0, deconvId, 0);
+    net.connect(deconvId, 0, fcId, 0);
+
+    Blob input(BlobShape(2, 3, 10, 10));
+    rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+    net.setBlob(".input", input);
+    net.forward();
+    Mat ref = net.getBlob("fc").matRefConst().clone();
+
+    net.convertWeightsToHalf();
+    EXPECT_EQ(CV_16S, net.getParam("conv").type());
+    EXPECT_EQ(CV_16S, net.getParam("deconv").type());
+    EXPECT_EQ(CV_16S, net.getParam("fc").type());
+    EXPECT_EQ(CV_32F, net.getParam("fc", 1).type());
+
+    net.setBlob(".input", input);
+    net.forward();
+    Mat out = net.getBlob("fc").matRefConst();
+
+    //half precision keeps 11 significant bits
+    EXPECT_LE(cvtest::norm(ref, out, NORM_INF), 1e-2 * cvtest::norm(ref, NORM_INF));
+}
+
+TEST(Layer_Test_Net, HalfWeights)
+{
+    OCL_OFF(testHalfWeights());
+}
+OCL_TEST(Layer_Test_Net, HalfWeights)
+{
+    OCL_ON(testHalfWeights());
+    OCL_OFF();
+}
+
+TEST(Layer_Test_Blob, toHalf)
+{
+    float data[] = {0.f, 1.f, -2.5f, 65504.f, 1e-7f, 1e5f, 0.1f};
+    Blob src(Mat(1, 7, CV_32F, data));
+    Blob half = src.toHalf();
+    ASSERT_EQ(CV_16S, half.type());
+    EXPECT_EQ(src.shape(), half.shape());
+
+    Mat dst = half.toFloat().matRefConst();
+    ASSERT_EQ(CV_32F, dst.type());
+    EXPECT_EQ(0.f, dst.at<float>(0));
+    EXPECT_EQ(1.f, dst.at<float>(1));
+    EXPECT_EQ(-2.5f, dst.at<float>(2));
+    EXPECT_EQ(65504.f, dst.at<float>(3));        //max finite value
+    EXPECT_NEAR(1e-7f, dst.at<float>(4), 6e-8f);  //denormal
+    EXPECT_GT(dst.at<float>(5), 65504.f);         //overflow
+    EXPECT_NEAR(0.1f, dst.at<float>(6), 1e-4f);
+}
+
+TEST(Layer_Test_Blob, createKeepsCapacity)
+{
+    Blob blob(BlobShape(2, 3, 10, 10));
+    const uchar *data = blob.matRefConst().data;
+
+    blob.create(BlobShape(1, 3, 8, 8));
+    EXPECT_EQ(data, blob.matRefConst().data);
+    EXPECT_EQ(BlobShape(1, 3, 8, 8), blob.shape());
+
+    Blob shared = blob;
+    blob.create(BlobShape(1, 3, 4, 4));
+    EXPECT_NE(data, blob.matRefConst().data);
+    EXPECT_EQ(BlobShape(1, 3, 8, 8), shared.shape());
+
+    blob.create(BlobShape(1, 3, 20, 20));
+    EXPECT_EQ(BlobShape(1, 3, 20, 20), blob.shape());
+}
+
+TEST(Layer_Test_Net, reshapeInputs)
+{
+    RNG rng(0);
+    Blob weights(BlobShape(4, 3, 3, 3));
+    rng.fill(weights.matRef(), RNG::UNIFORM, -1, 1);
+
+    LayerParams convParams, reluParams, poolParams;
+    convParams.set("kernel_size", 3);
+    convParams.set("num_output", 4);
+    convParams.set("pad", 1);
+    convParams.blobs.push_back(weights);
+    poolParams.set("pool", "max");
+    poolParams.set("kernel_size", 2);
+    poolParams.set("stride", 2);
+
+    Net net;
+    int convId = net.addLayer("conv", "Convolution", convParams);
+    int reluId = net.addLayer("relu", "ReLU", reluParams);
+    int poolId = net.addLayer("pool", "Pooling", poolParams);
+    net.connect(0, 0, convId, 0);
+    net.connect(convId, 0, reluId, 0);
+    net.connect(reluId, 0, poolId, 0);
+
+    int sizes[] = {12, 8, 16, 8};
+    const uchar *convData = NULL;
+    for (int i = 0; i < (int)(sizeof(sizes)/sizeof(sizes[0])); i++)
+    {
+        Blob input(BlobShape(1, 3, sizes[i], sizes[i]));
+        rng.fill(input.matRef(), RNG::UNIFORM, -1, 1);
+
+        net.setBlob(".input", input);
+        net.forward();
+        Blob out = net.getBlob("pool");
+        ASSERT_EQ(BlobShape(1, 4, sizes[i] / 2, sizes[i] / 2), out.shape());
+
+        //buffers grow only
+        if (i == 1)
+            EXPECT_EQ(convData, net.getBlob("conv").matRefConst().data);
+        convData = net.getBlob("conv").matRefConst().data;
+
+        std::vector<Blob> inputs(1, input), convOutputs, poolOutputs;
+        runLayer(LayerFactory::createLayerInstance("Convolution", convParams), inputs, convOutputs);
+        convOutputs[0] = Blob(cv::max(convOutputs[0].matRefConst(), 0));
+        runLayer(LayerFactory::createLayerInstance("Pooling", poolParams), convOutputs, poolOutputs);
+        normAssert(poolOutputs[0], out);
+    }
+}
+
+TEST(Layer_Test_Convolution, Int8)
+{
+    RNG rng(0);
+    Blob weights(BlobShape(8, 6, 3, 3)), biases(BlobShape(8));
+    rng.fill(weights.matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(biases.matRef(), RNG::UNIFORM, -1, 1);
+
+    LayerParams convParams;
+    convParams.set("kernel_size", 3);
+    convParams.set("num_output", 8);
+    convParams.blobs.push_back(weights);
+    convParams.blobs.push_back(biases);
+
+    Net net;
+    int convId = net.addLayer("conv", "Convolution", convParams);
+    net.connect(0, 0, convId, 0);
+
+    Blob inp(BlobShape(2, 6, 16, 16));
+    rng.fill(inp.matRef(), RNG::UNIFORM, -1, 1);
+
+    net.setBlob(".0", inp);
+    net.forward();
+    Mat ref = net.getBlob("conv").matRefConst().clone();
+
+    net.calibrateInt8(std::vector<Blob>(1, inp), ".0");
+    net.setBlob(".0", inp);
+    net.forward();
+    Mat out = net.getBlob("conv").matRefConst().clone();
+
+    EXPECT_LE(cvtest::norm(ref, out, NORM_L2) / cvtest::norm(ref, NORM_L2), 0.02);
+
+    net.disableInt8();
+    net.forward();
+    normAssert(ref, net.getBlob("conv").matRefConst());
+}
+
 TEST(Layer_Test_DeConvolution, Accuracy)
 {
      OCL_OFF(testLayerUsingCaffeModels("layer_deconvolution", true, false));
@@ -192,6 +574,180 @@ OCL_TEST(Layer_Test_Pooling_ave, Accuracy)
      OCL_OFF();
 }
 
+//reference implementation of the Caffe pooling
+static void poolingNaive(const Blob &src, Blob &dst, int type, Size kernel, Size stride, Size pad)
+{
+    const Mat &inp = src.matRefConst();
+    Mat &out = dst.matRef();
+    int H = src.rows(), W = src.cols(), outH = dst.rows(), outW = dst.cols();
+
+    for (int plane = 0; plane < src.num() * src.channels(); plane++)
+    {
+        const float *srcPlane = inp.ptr<float>() + plane * H * W;
+        float *dstPlane = out.ptr<float>() + plane * outH * outW;
+
+        for (int ph = 0; ph < outH; ph++)
+        {
+            for (int pw = 0; pw < outW; pw++)
+            {
+                int hstart = ph * stride.height - pad.height, wstart = pw * stride.width - pad.width;
+                int hend = std::min(hstart + kernel.height, H + pad.height);
+                int wend = std::min(wstart + kernel.width, W + pad.width);
+                int poolSize = (hend - hstart) * (wend - wstart);
+                hend = std::min(hend, H);
+                wend = std::min(wend, W);
+
+                float val = (type == PoolingLayer::MAX) ? -FLT_MAX : 0.f;
+                for (int h = std::max(hstart, 0); h < hend; h++)
+                    for (int w = std::max(wstart, 0); w < wend; w++)
+                        val = (type == PoolingLayer::MAX) ? std::max(val, srcPlane[h * W + w]) : val + srcPlane[h * W + w];
+                dstPlane[ph * outW + pw] = (type == PoolingLayer::MAX) ? val : val / poolSize;
+            }
+        }
+    }
+}
+
+TEST(Layer_Test_Pooling, OddSizesAndStrides)
+{
+    OCL_OFF();
+    const int types[] = { PoolingLayer::MAX, PoolingLayer::AVE };
+    const Size kernels[] = { Size(3, 3), Size(2, 2), Size(3, 2), Size(17, 13) };
+    const Size strides[] = { Size(2, 2), Size(1, 1), Size(1, 3), Size(1, 1) };
+    const Size pads[] = { Size(1, 1), Size(0, 0), Size(1, 0), Size(0, 0) };
+
+    RNG rng(0);
+    std::vector<Blob> inputs(1, Blob(BlobShape(2, 3, 13, 17)));
+    rng.fill(inputs[0].matRef(), RNG::UNIFORM, -1, 1);
+
+    for (int t = 0; t < 2; t++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            Ptr<Layer> layer = PoolingLayer::create(types[t], kernels[i], strides[i], pads[i]);
+            std::vector<Blob> outputs;
+            runLayer(layer, inputs, outputs);
+
+            Blob ref(outputs[0].shape());
+            poolingNaive(inputs[0], ref, types[t], kernels[i], strides[i], pads[i]);
+            normAssert(ref, outputs[0]);
+        }
+    }
+}
+
+//reference of the SSD detection output with shared locations and corner coded bboxes:
+//greedy nms of the top_k scores of every class, the bboxes are decoded as xmin, ymin, xmax, ymax
+static void detectionOutputNaive(const Mat &loc, const Mat &conf, const float *priors, int numPriors,
+                                 int numClasses, float confThreshold, float nmsThreshold, int topK,
+                                 std::vector<Vec<float, 7> > &detections)
+{
+    for (int n = 0; n < loc.rows; n++)
+    {
+        std::vector<Vec4f> bboxes(numPriors);
+        for (int i = 0; i < numPriors; i++)
+            for (int j = 0; j < 4; j++)
+                bboxes[i][j] = priors[i * 4 + j] + priors[(numPriors + i) * 4 + j] * loc.at<float>(n, i * 4 + j);
+
+        for (int c = 1; c < numClasses; c++)
+        {
+            std::vector<std::pair<float, int> > candidates;
+            for (int i = 0; i < numPriors; i++)
+            {
+                float score = conf.at<float>(n, i * numClasses + c);
+                if (score > confThreshold)
+                    candidates.push_back(std::make_pair(-score, i));
+            }
+            std::sort(candidates.begin(), candidates.end());
+            if ((int)candidates.size() > topK)
+                candidates.resize(topK);
+
+            std::vector<int> kept;
+            for (size_t k = 0; k < candidates.size(); k++)
+            {
+                const Vec4f &a = bboxes[candidates[k].second];
+                bool keep = true;
+                for (size_t j = 0; j < kept.size() && keep; j++)
+                {
+                    const Vec4f &b = bboxes[kept[j]];
+                    float w = std::min(a[2], b[2]) - std::max(a[0], b[0]);
+                    float h = std::min(a[3], b[3]) - std::max(a[1], b[1]);
+                    float sizeA = (a[2] < a[0] || a[3] < a[1]) ? 0.f : (a[2] - a[0]) * (a[3] - a[1]);
+                    float sizeB = (b[2] < b[0] || b[3] < b[1]) ? 0.f : (b[2] - b[0]) * (b[3] - b[1]);
+                    if (w > 0 && h > 0)
+                        keep = w * h / (sizeA + sizeB - w * h) <= nmsThreshold;
+                }
+                if (!keep)
+                    continue;
+                kept.push_back(candidates[k].second);
+
+                Vec<float, 7> det;
+                det[0] = (float)n;
+                det[1] = (float)c;
+                det[2] = -candidates[k].first;
+                for (int j = 0; j < 4; j++)
+                    det[3 + j] = std::min(std::max(a[j], 0.f), 1.f);
+                detections.push_back(det);
+            }
+        }
+    }
+}
+
+TEST(Layer_Test_DetectionOutput, NMSSameAsReference)
+{
+    OCL_OFF();
+    LayerParams priorParams;
+    priorParams.set("min_size", 8);
+    priorParams.set("max_size", 16);
+    priorParams.set("aspect_ratio", 2.);
+    priorParams.set("flip", 1);
+    priorParams.set("clip", 1);
+    float variance[] = { 0.1f, 0.1f, 0.2f, 0.2f };
+    priorParams.set("variance", DictValue::arrayReal(variance, 4));
+    Ptr<Layer> priorBox = LayerFactory::createLayerInstance("PriorBox", priorParams);
+
+    std::vector<Blob> priorInputs;
+    priorInputs.push_back(Blob(BlobShape(1, 1, 5, 6)));
+    priorInputs.push_back(Blob(BlobShape(1, 3, 40, 48)));
+    std::vector<Blob> priorOutputs;
+    runLayer(priorBox, priorInputs, priorOutputs);
+    Blob priors(priorOutputs[0].matRefConst().clone());
+
+    // the cached priors are the same on the next call
+    priorOutputs[0].matRef() = 0;
+    runLayer(priorBox, priorInputs, priorOutputs, FORWARD_ONLY);
+    normAssert(priors, priorOutputs[0]);
+
+    const int numPriors = 5 * 6 * 4, numClasses = 4, topK = 30;
+    const float confThreshold = 0.1f, nmsThreshold = 0.45f;
+    LayerParams detectionParams;
+    detectionParams.set("num_classes", numClasses);
+    detectionParams.set("share_location", 1);
+    detectionParams.set("background_label_id", 0);
+    detectionParams.set("code_type", "CORNER");
+    detectionParams.set("keep_top_k", -1);
+    detectionParams.set("top_k", topK);
+    detectionParams.set("confidence_threshold", (double)confThreshold);
+    detectionParams.set("nms_threshold", (double)nmsThreshold);
+    Ptr<Layer> detectionOutput = LayerFactory::createLayerInstance("DetectionOutput", detectionParams);
+
+    RNG rng(0);
+    std::vector<Blob> inputs;
+    inputs.push_back(Blob(BlobShape(3, numPriors * 4)));
+    inputs.push_back(Blob(BlobShape(3, numPriors * numClasses)));
+    inputs.push_back(priors);
+    rng.fill(inputs[0].matRef(), RNG::UNIFORM, -1, 1);
+    rng.fill(inputs[1].matRef(), RNG::UNIFORM, 0, 1);
+    std::vector<Blob> outputs;
+    runLayer(detectionOutput, inputs, outputs);
+
+    std::vector<Vec<float, 7> > detections;
+    detectionOutputNaive(inputs[0].matRefConst(), inputs[1].matRefConst(), priors.ptrf(), numPriors,
+                         numClasses, confThreshold, nmsThreshold, topK, detections);
+    ASSERT_EQ((int)detections.size(), outputs[0].rows());
+    Mat ref((int)detections.size(), 7, CV_32F, &detections[0]);
+    Mat out(outputs[0].rows(), 7, CV_32F, outputs[0].ptrf());
+    EXPECT_LE(cvtest::norm(ref, out, NORM_INF), 1e-5);
+}
+
 TEST(Layer_Test_MVN, Accuracy)
 {
      OCL_OFF(testLayerUsingCaffeModels("layer_mvn"));
@@ -264,6 +820,135 @@ OCL_TEST(Layer_Test_Reshape_Split_Slice, Accuracy)
     OCL_OFF();
 }
 
+static Net createEltwisePermuteNet(RNG &rng)
+{
+    LayerParams convParams[2];
+    for (int i = 0; i < 2; i++)
+    {
+        Blob weights(BlobShape(4, 3, 3, 3)), biases(BlobShape(4));
+        rng.fill(weights.matRef(), RNG::UNIFORM, -1, 1);
+        rng.fill(biases.matRef(), RNG::UNIFORM, -1, 1);
+
+        convParams[i].set("kernel_size", 3);
+        convParams[i].set("pad", 1);
+        convParams[i].set("num_output", 4);
+        convParams[i].blobs.push_back(weights);
+        convParams[i].blobs.push_back(biases);
+    }
+
+    LayerParams eltwiseParams;
+    eltwiseParams.set("operation", "sum");
+
+    int order[] = {0, 2, 3, 1};
+    LayerParams permuteParams;
+    permuteParams.set("order", DictValue::arrayInt(order, 4));
+
+    LayerParams reluParams;
+
+    Net net;
+    int conv1Id = net.addLayer("conv1", "Convolution", convParams[0]);
+    int conv2Id = net.addLayer("conv2", "Convolution", convParams[1]);
+    int eltwiseId = net.addLayer("eltwise", "Eltwise", eltwiseParams);
+    int permuteId = net.addLayer("permute", "Permute", permuteParams);
+    int reluId = net.addLayer("relu", "ReLU", reluParams);
+    net.connect(0, 0, conv1Id, 0);
+    net.connect(0, 0, conv2Id, 0);
+    net.connect(conv1Id, 0, eltwiseId, 0);
+    net.connect(conv2Id, 0, eltwiseId, 1);
+    net.connect(eltwiseId, 0, permuteId, 0);
+    net.connect(permuteId, 0, reluId, 0);
+    return net;
+}
+
+static Blob forwardEltwisePermuteNet(bool hostSyncCheck)
+{
+    RNG rng(0);
+    Net net = createEltwisePermuteNet(rng);
+
+    Blob inp(BlobShape(2, 3, 8, 8));
+    rng.fill(inp.matRef(), RNG::UNIFORM, -1, 1);
+
+    net.setHostSyncCheck(hostSyncCheck);
+    net.setBlob(".0", inp);
+    net.forward();
+
+    return net.getBlob("relu");
+}
+
+TEST(Layer_Test_Eltwise_Permute, Accuracy)
+{
+    Blob out;
+    OCL_OFF(out = forwardEltwisePermuteNet(false));
+    ASSERT_EQ(BlobShape(2, 8, 8, 4), out.shape());
+}
+OCL_TEST(Layer_Test_Eltwise_Permute, DeviceResidency)
+{
+    Blob ref, out;
+    OCL_OFF(ref = forwardEltwisePermuteNet(false));
+    OCL_ON(out = forwardEltwisePermuteNet(true));
+    OCL_OFF();
+
+    normAssert(ref, out);
+}
+
+//the next input is prepared while the previous forward pass may be still computed
+static std::vector<Blob> forwardEltwisePermuteNetSequence(int numInputs, bool async)
+{
+    RNG rng(0);
+    Net net = createEltwisePermuteNet(rng);
+
+    std::vector<Blob> outputs;
+    BlobFuture future;
+    for (int i = 0; i <= numInputs; i++)
+    {
+        Blob inp;
+        if (i < numInputs)
+        {
+            inp = Blob(BlobShape(2, 3, 8, 8));
+            rng.fill(inp.matRef(), RNG::UNIFORM, -1, 1);
+        }
+        if (future.valid())
+            outputs.push_back(Blob(future.get().matRefConst().clone()));
+        if (i == numInputs)
+            break;
+
+        net.setBlob(".0", inp);
+        if (async)
+        {
+            future = net.forwardAsync("relu");
+        }
+        else
+        {
+            net.forward();
+            outputs.push_back(Blob(net.getBlob("relu").matRefConst().clone()));
+        }
+    }
+    return outputs;
+}
+
+TEST(Layer_Test_Net, forwardAsync)
+{
+    std::vector<Blob> refs, outs;
+    OCL_OFF(refs = forwardEltwisePermuteNetSequence(3, false));
+    OCL_OFF(outs = forwardEltwisePermuteNetSequence(3, true));
+
+    ASSERT_EQ(refs.size(), outs.size());
+    for (size_t i = 0; i < refs.size(); i++)
+        normAssert(refs[i], outs[i]);
+}
+
+OCL_TEST(Layer_Test_Net, forwardAsync)
+{
+    std::vector<Blob> refs, outs;
+    OCL_OFF(refs = forwardEltwisePermuteNetSequence(3, false));
+    OCL_ON(outs = forwardEltwisePermuteNetSequence(3, true));
+    OCL_OFF();
+
+    ASSERT_EQ(refs.size(), outs.size());
+    for (size_t i = 0; i < refs.size(); i++)
+        normAssert(refs[i], outs[i]);
+}
+
 class Layer_LSTM_Test : public ::testing::Test
 {
 public:
@@ -335,6 +1020,40 @@ TEST(Layer_LSTM_Test_Accuracy_with_, CaffeRecurrent)
     normAssert(h_t_reference, outputs[0]);
 }
 
+TEST(Layer_LSTM_Test_Accuracy_with_, Streaming)
+{
+    Ptr<LSTMLayer> layer = LSTMLayer::create();
+
+    Blob Wx = blobFromNPY(_tf("lstm.prototxt.w_0.npy"));
+    Blob Wh = blobFromNPY(_tf("lstm.prototxt.w_2.npy"));
+    Blob b  = blobFromNPY(_tf("lstm.prototxt.w_1.npy"));
+    layer->setWeights(Wh, Wx, b);
+
+    Blob inp = blobFromNPY(_tf("recurrent.input.npy"));
+    Blob h_t_reference = blobFromNPY(_tf("lstm.prototxt.h_1.npy"));
+    int numTimestamps = inp.size(0);
+    ASSERT_GE(numTimestamps, 2);
+
+    //feed the sequence by two chunks, the state is kept between them
+    int split = numTimestamps / 2;
+    Range ranges[] = {Range(0, split), Range(split, numTimestamps)};
+    for (int i = 0; i < 2; i++)
+    {
+        std::vector<Range> inpRanges(inp.dims(), Range::all()), refRanges(h_t_reference.dims(), Range::all());
+        inpRanges[0] = refRanges[0] = ranges[i];
+
+        std::vector<Blob> inputs(1, Blob(inp.matRefConst()(&inpRanges[0]).clone())), outputs;
+        runLayer(layer, inputs, outputs);
+        normAssert(Blob(h_t_reference.matRefConst()(&refRanges[0]).clone()), outputs[0]);
+    }
+
+    //the whole sequence again from the zero state
+    layer->resetState();
+    std::vector<Blob> inputs(1, inp), outputs;
+    runLayer(layer, inputs, outputs);
+    normAssert(h_t_reference, outputs[0]);
+}
+
 TEST(Layer_RNN_Test_Accuracy_with_, CaffeRecurrent)
 {
     Ptr<RNNLayer> layer = RNNLayer::create();
@@ -42,6 +42,7 @@
 
 #include <opencv2/dpm.hpp>
 #include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 #include <opencv2/videoio.hpp>
@@ -97,15 +98,7 @@ int main( int argc, char** argv )
         return -1;
     }
 
-#ifdef HAVE_TBB
-    cout << "Running with TBB" << endl;
-#else
-#ifdef _OPENMP
-    cout << "Running with OpenMP" << endl;
-#else
-    cout << "Running without OpenMP and without TBB" << endl;
-#endif
-#endif
+    cout << "Running with " << getNumThreads() << " threads" << endl;
 
     Mat frame;
     namedWindow("DPM Cascade Detection", 1);
@@ -42,6 +42,7 @@
 
 #include <opencv2/dpm.hpp>
 #include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 
@@ -113,15 +114,7 @@ int main( int argc, char** argv )
     if ( !readImageLists(image_list, imgFileList) )
         return -1;
 
-#ifdef HAVE_TBB
-    cout << "Running with TBB" << endl;
-#else
-#ifdef _OPENMP
-    cout << "Running with OpenMP" << endl;
-#else
-    cout << "Running without OpenMP and without TBB" << endl;
-#endif
-#endif
+    cout << "Running with " << getNumThreads() << " threads" << endl;
 
     cv::Ptr<DPMDetector> detector = \
     DPMDetector::create(vector<string>(1, model_path));
@@ -140,7 +140,7 @@ void DPMCascade::initDPMCascade()
     pcaDtArgmaxY.resize(dtLevelOffset[nlevels]);
 }
 
-vector< vector<double> > DPMCascade::detect(Mat &image)
+vector< vector<double> > DPMCascade::detect(Mat &image, const DPMCascade *shared)
 {
     if (image.channels() == 1)
         cvtColor(image, image, COLOR_GRAY2BGR);
@@ -149,7 +149,10 @@ vector< vector<double> > DPMCascade::detect(Mat &image)
         image.convertTo(image, CV_64FC3);
 
     // compute features
-    computeFeatures(image);
+    if (shared)
+        shareFeatures(*shared);
+    else
+        computeFeatures(image);
 
     // pre-allocate storage
     initDPMCascade();
@@ -183,6 +186,24 @@ void DPMCascade::computeFeatures(const Mat &im)
     feature.projectFeaturePyramid(model.pcaCoeff, pyramid, pcaPyramid);
 }
 
+bool DPMCascade::hasSamePyramid(const DPMCascade &other) const
+{
+    return model.maxSizeX == other.model.maxSizeX && model.maxSizeY == other.model.maxSizeY &&
+        model.interval == other.model.interval && model.sBin == other.model.sBin;
+}
+
+void DPMCascade::shareFeatures(const DPMCascade &other)
+{
+    CV_Assert(hasSamePyramid(other));
+
+    // the levels are shared, the parameters come with the scales of the levels
+    feature = other.feature;
+    pyramid = other.pyramid;
+
+    // compute projected pyramid with the coefficients of this model
+    feature.projectFeaturePyramid(model.pcaCoeff, pyramid, pcaPyramid);
+}
+
 void DPMCascade::computeLocationScores(vector< vector< double > >  &locationScores)
 {
     vector< vector < double > > locationWeight = model.locationWeight;
@@ -220,53 +241,45 @@ void DPMCascade::computeRootPCAScores(vector< vector< Mat > > &rootScores)
     for (int comp = 0; comp < model.numComponents; comp++)
     {
         rootScores[comp].resize(nlevels);
-#ifdef HAVE_TBB // parallel computing
-        ParalComputeRootPCAScores paralTask(pcaPyramid, model.rootPCAFilters[comp],
-                model.pcaDim, rootScores[comp]);
-        parallel_for_(Range(interval, nlevels), paralTask);
-#else
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
+        const Mat &filter = model.rootPCAFilters[comp];
         for (int level = interval; level < nlevels; level++)
         {
-            Mat feat = pcaPyramid[level];
-            Mat filter = model.rootPCAFilters[comp];
-
-            // compute size of output
-            int height = feat.rows - filter.rows + 1;
-            int width = (feat.cols - filter.cols) / model.pcaDim + 1;
-
-            if (height < 1 || width < 1)
+            const Mat &feat = pcaPyramid[level];
+            if (feat.rows < filter.rows || feat.cols < filter.cols)
                 CV_Error(CV_StsBadArg,
                         "Invalid input, filter size should be smaller than feature size.");
-
-            Mat result = Mat::zeros(Size(width, height), CV_64F);
-            convolutionEngine.convolve(feat, filter, model.pcaDim, result);
-            rootScores[comp][level] = result;
         }
-#endif
     }
+
+    // parallel computing over the components and the pyramid levels
+    ParalComputeRootPCAScores paralTask(pcaPyramid, model.rootPCAFilters,
+            model.pcaDim, interval, rootScores);
+    parallel_for_(Range(0, model.numComponents*(nlevels - interval)), paralTask);
 }
 
-#ifdef HAVE_TBB
 ParalComputeRootPCAScores::ParalComputeRootPCAScores(
         const vector< Mat > &pcaPyrad,
-        const Mat &f,
+        const vector< Mat > &f,
         int dim,
-        vector< Mat > &sc):
+        int i,
+        vector< vector< Mat > > &sc):
     pcaPyramid(pcaPyrad),
-    filter(f),
+    filters(f),
     pcaDim(dim),
+    interval(i),
     scores(sc)
 {
 }
 
 void ParalComputeRootPCAScores::operator() (const Range &range) const
 {
-    for (int level = range.start; level != range.end; level++)
+    int nlevels = (int)pcaPyramid.size() - interval;
+    for (int task = range.start; task != range.end; task++)
     {
-        Mat feat = pcaPyramid[level];
+        int comp = task / nlevels;
+        int level = interval + task % nlevels;
+        const Mat &feat = pcaPyramid[level];
+        const Mat &filter = filters[comp];
 
         // compute size of output
         int height = feat.rows - filter.rows + 1;
@@ -276,27 +289,18 @@ void ParalComputeRootPCAScores::operator() (const Range &range) const
         // convolution engine
         ConvolutionEngine convEngine;
         convEngine.convolve(feat, filter, pcaDim, result);
-        scores[level] = result;
+        scores[comp][level] = result;
     }
 }
-#endif
 
 void DPMCascade::process( vector< vector<double> > &dets)
 {
     PyramidParameter params = feature.getPyramidParameters();
     int interval = params.interval;
-    int padx = params.padx;
-    int pady = params.pady;
-    vector<double> scales = params.scales;
 
     int nlevels = (int)pyramid.size() - interval;
     CV_Assert(nlevels > 0);
 
-    // keep track of the PCA scores for each PCA filter
-    vector< vector< double > > pcaScore(model.numComponents);
-    for (int comp = 0; comp < model.numComponents; comp++)
-        pcaScore[comp].resize(model.numParts[comp]+1);
-
     // compute location scores
     vector< vector< double > > locationScores;
     computeLocationScores(locationScores);
@@ -305,145 +309,188 @@ void DPMCascade::process( vector< vector<double> > &dets)
     vector< vector< Mat > > rootPCAScores;
     computeRootPCAScores(rootPCAScores);
 
-    // process each model component and pyramid level
+    // process the pyramid levels in parallel. The cached part scores
+    // of a level are only used by the hypotheses of this level, and
+    // its components are processed in order, so the detections are
+    // the same as with a serial process
+    vector< vector< vector<double> > > levelDets(model.numComponents*nlevels);
+    ParalProcessLevels paralTask(*this, locationScores, rootPCAScores, levelDets);
+    parallel_for_(Range(0, nlevels), paralTask);
+
+    // gather the detections by component, then by pyramid level
+    for (size_t i = 0; i < levelDets.size(); i++)
+        dets.insert(dets.end(), levelDets[i].begin(), levelDets[i].end());
+}
+
+void DPMCascade::processLevel(int plevel,
+        const vector< vector< double > > &locationScores,
+        const vector< vector< Mat > > &rootPCAScores,
+        vector< vector< vector<double> > > &levelDets)
+{
+    PyramidParameter params = feature.getPyramidParameters();
+    int interval = params.interval;
+    int padx = params.padx;
+    int pady = params.pady;
+    const vector<double> &scales = params.scales;
+    int nlevels = (int)pyramid.size() - interval;
+
+    // process each model component
     for (int comp = 0; comp < model.numComponents; comp++)
     {
-        for (int plevel = 0; plevel < nlevels; plevel++)
+        // keep track of the PCA scores for each PCA filter
+        vector< double > pcaScore(model.numParts[comp]+1);
+
+        // root filter pyramid level
+        int rlevel = plevel + interval;
+        double bias = model.bias[comp] + locationScores[comp][rlevel];
+        // get the scores of the first PCA filter
+        Mat rtscore = rootPCAScores[comp][rlevel];
+        // process each location in the current pyramid level
+        for (int rx = (int)ceil(padx/2.0); rx < rtscore.cols - (int)ceil(padx/2.0); rx++)
         {
-            // root filter pyramid level
-            int rlevel = plevel + interval;
-            double bias = model.bias[comp] + locationScores[comp][rlevel];
-            // get the scores of the first PCA filter
-            Mat rtscore = rootPCAScores[comp][rlevel];
-            // process each location in the current pyramid level
-            for (int rx = (int)ceil(padx/2.0); rx < rtscore.cols - (int)ceil(padx/2.0); rx++)
+            for (int ry = (int)ceil(pady/2.0); ry < rtscore.rows - (int)ceil(pady/2.0); ry++)
             {
-                for (int ry = (int)ceil(pady/2.0); ry < rtscore.rows - (int)ceil(pady/2.0); ry++)
+                // get stage 0 score
+                double score = rtscore.at<double>(ry, rx) + bias;
+                // record PCA score
+                pcaScore[0] = score - bias;
+                // cascade stage 1 through 2*numparts + 2
+                int stage = 1;
+                int numstages = 2*model.numParts[comp] + 2;
+                for(; stage < numstages; stage++)
                 {
-                    // get stage 0 score
-                    double score = rtscore.at<double>(ry, rx) + bias;
-                    // record PCA score
-                    pcaScore[comp][0] = score - bias;
-                    // cascade stage 1 through 2*numparts + 2
-                    int stage = 1;
-                    int numstages = 2*model.numParts[comp] + 2;
-                    for(; stage < numstages; stage++)
+                    double t = model.prunThreshold[comp][2*stage-1];
+                    // check for hypothesis pruning
+                    if (score < t)
+                        break;
+
+                    // pca == 1 if place filters
+                    // pca == 0 if place non-pca filters
+                    bool isPCA = (stage < model.numParts[comp] + 1 ? true : false);
+                    // get the part index
+                    // root parts have index -1, none-root part are indexed 0:numParts-1
+                    int part = model.partOrder[comp][stage] - 1;// partOrder
+
+                    if (part == -1)
                     {
-                        double t = model.prunThreshold[comp][2*stage-1];
-                        // check for hypothesis pruning
-                        if (score < t)
-                            break;
-
-                        // pca == 1 if place filters
-                        // pca == 0 if place non-pca filters
-                        bool isPCA = (stage < model.numParts[comp] + 1 ? true : false);
-                        // get the part index
-                        // root parts have index -1, none-root part are indexed 0:numParts-1
-                        int part = model.partOrder[comp][stage] - 1;// partOrder
-
-                        if (part == -1)
+                        // calculate the root non-pca score
+                        // and replace the PCA score
+                        double rscore = 0.0;
+                        if (isPCA)
                         {
-                            // calculate the root non-pca score
-                            // and replace the PCA score
-                            double rscore = 0.0;
-                            if (isPCA)
-                            {
-                                rscore = convolutionEngine.convolve(pcaPyramid[rlevel],
-                                        model.rootPCAFilters[comp],
-                                        model.pcaDim, rx, ry);
-                            }
-                            else
-                            {
-                                rscore = convolutionEngine.convolve(pyramid[rlevel],
-                                        model.rootFilters[comp],
-                                        model.numFeatures, rx, ry);
-                            }
-                            score += rscore - pcaScore[comp][0];
+                            rscore = convolutionEngine.convolve(pcaPyramid[rlevel],
+                                    model.rootPCAFilters[comp],
+                                    model.pcaDim, rx, ry);
                         }
                         else
                         {
-                            // place a non-root filter
-                            int pId = model.pFind[comp][part];
-                            int px = 2*rx + (int)model.anchors[pId][0];
-                            int py = 2*ry + (int)model.anchors[pId][1];
-
-                            // look up the filter and deformation model
-                            double defThreshold =
-                                model.prunThreshold[comp][2*stage] - score;
-
-                            double ps = computePartScore(plevel, pId, px, py,
-                                    isPCA, defThreshold);
-
-                            if (isPCA)
-                            {
-                                // record PCA filter score
-                                pcaScore[comp][part+1] = ps;
-                                // update the hypothesis score
-                                score += ps;
-                            }
-                            else
-                            {
-                                // update the hypothesis score by replacing
-                                // the PCA score
-                                score += ps - pcaScore[comp][part+1];
-                            } // isPCA == false
-                        } // part != -1
-
-                    } // stages
-
-                    // check if the hypothesis passed all stages with a
-                    // final score over the global threshold
-                    if (stage == numstages && score >= model.scoreThresh)
+                            rscore = convolutionEngine.convolve(pyramid[rlevel],
+                                    model.rootFilters[comp],
+                                    model.numFeatures, rx, ry);
+                        }
+                        score += rscore - pcaScore[0];
+                    }
+                    else
                     {
-                        vector<double> coords;
-                        // compute and record image coordinates of the detection window
-                        double scale = model.sBin/scales[rlevel];
-                        double x1 = (rx-padx)*scale;
-                        double y1 = (ry-pady)*scale;
-                        double x2 = x1 + model.rootFilterDims[comp].width*scale - 1;
-                        double y2 = y1 + model.rootFilterDims[comp].height*scale - 1;
+                        // place a non-root filter
+                        int pId = model.pFind[comp][part];
+                        int px = 2*rx + (int)model.anchors[pId][0];
+                        int py = 2*ry + (int)model.anchors[pId][1];
 
-                        coords.push_back(x1);
-                        coords.push_back(y1);
-                        coords.push_back(x2);
-                        coords.push_back(y2);
+                        // look up the filter and deformation model
+                        double defThreshold =
+                            model.prunThreshold[comp][2*stage] - score;
+
+                        double ps = computePartScore(plevel, pId, px, py,
+                                isPCA, defThreshold);
 
-                        // compute and record image coordinates of the part filters
-                        scale = model.sBin/scales[plevel];
-                        int featWidth = pyramid[plevel].cols/feature.dimHOG;
-                        for (int p = 0; p < model.numParts[comp]; p++)
+                        if (isPCA)
                         {
-                            int pId = model.pFind[comp][p];
-                            int probx = 2*rx + (int)model.anchors[pId][0];
-                            int proby = 2*ry + (int)model.anchors[pId][1];
-                            int offset = dtLevelOffset[plevel] +
-                                pId*featDimsProd[plevel] +
-                                (proby - pady)*featWidth +
-                                probx - padx;
-                            int px = dtArgmaxX[offset] + padx;
-                            int py = dtArgmaxY[offset] + pady;
-                            x1 = (px - 2*padx)*scale;
-                            y1 = (py - 2*pady)*scale;
-                            x2 = x1 + model.partFilterDims[p].width*scale - 1;
-                            y2 = y1 + model.partFilterDims[p].height*scale - 1;
-                            coords.push_back(x1);
-                            coords.push_back(y1);
-                            coords.push_back(x2);
-                            coords.push_back(y2);
+                            // record PCA filter score
+                            pcaScore[part+1] = ps;
+                            // update the hypothesis score
+                            score += ps;
                         }
+                        else
+                        {
+                            // update the hypothesis score by replacing
+                            // the PCA score
+                            score += ps - pcaScore[part+1];
+                        } // isPCA == false
+                    } // part != -1
 
-                        // record component number and score
-                        coords.push_back(comp + 1);
-                        coords.push_back(score);
+                } // stages
 
-                        dets.push_back(coords);
+                // check if the hypothesis passed all stages with a
+                // final score over the global threshold
+                if (stage == numstages && score >= model.scoreThresh)
+                {
+                    vector<double> coords;
+                    // compute and record image coordinates of the detection window
+                    double scale = model.sBin/scales[rlevel];
+                    double x1 = (rx-padx)*scale;
+                    double y1 = (ry-pady)*scale;
+                    double x2 = x1 + model.rootFilterDims[comp].width*scale - 1;
+                    double y2 = y1 + model.rootFilterDims[comp].height*scale - 1;
+
+                    coords.push_back(x1);
+                    coords.push_back(y1);
+                    coords.push_back(x2);
+                    coords.push_back(y2);
+
+                    // compute and record image coordinates of the part filters
+                    scale = model.sBin/scales[plevel];
+                    int featWidth = pyramid[plevel].cols/feature.dimHOG;
+                    for (int p = 0; p < model.numParts[comp]; p++)
+                    {
+                        int pId = model.pFind[comp][p];
+                        int probx = 2*rx + (int)model.anchors[pId][0];
+                        int proby = 2*ry + (int)model.anchors[pId][1];
+                        int offset = dtLevelOffset[plevel] +
+                            pId*featDimsProd[plevel] +
+                            (proby - pady)*featWidth +
+                            probx - padx;
+                        int px = dtArgmaxX[offset] + padx;
+                        int py = dtArgmaxY[offset] + pady;
+                        x1 = (px - 2*padx)*scale;
+                        y1 = (py - 2*pady)*scale;
+                        x2 = x1 + model.partFilterDims[p].width*scale - 1;
+                        y2 = y1 + model.partFilterDims[p].height*scale - 1;
+                        coords.push_back(x1);
+                        coords.push_back(y1);
+                        coords.push_back(x2);
+                        coords.push_back(y2);
                     }
-                } // ry
-            } // rx
-        } // for each pyramid level
+
+                    // record component number and score
+                    coords.push_back(comp + 1);
+                    coords.push_back(score);
+
+                    levelDets[comp*nlevels + plevel].push_back(coords);
+                }
+            } // ry
+        } // rx
     } // for each component
 }
 
+ParalProcessLevels::ParalProcessLevels(
+        DPMCascade &c,
+        const vector< vector< double > > &ls,
+        const vector< vector< Mat > > &rs,
+        vector< vector< vector<double> > > &d):
+    cascade(c),
+    locationScores(ls),
+    rootPCAScores(rs),
+    levelDets(d)
+{
+}
+
+void ParalProcessLevels::operator() (const Range &range) const
+{
+    for (int plevel = range.start; plevel != range.end; plevel++)
+        cascade.processLevel(plevel, locationScores, rootPCAScores, levelDets);
+}
+
 double DPMCascade::computePartScore(int plevel, int pId, int px, int py, bool isPCA, double defThreshold)
 {
     // remove virtual padding
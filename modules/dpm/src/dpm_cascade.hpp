@@ -48,6 +48,7 @@
 
 #include "opencv2/imgproc.hpp"
 #include "opencv2/core.hpp"
+#include "opencv2/core/utility.hpp"
 
 #include <string>
 #include <vector>
@@ -109,6 +110,13 @@ class DPMCascade
         // compute feature pyramid and projected feature pyramid
         void computeFeatures(const Mat &im);
 
+        // whether the feature pyramids of the models are built with the same parameters
+        bool hasSamePyramid(const DPMCascade &other) const;
+
+        // reuse the feature pyramid of another cascade with the same
+        // pyramid parameters, and compute projected feature pyramid
+        void shareFeatures(const DPMCascade &other);
+
         // compute root PCA scores
         void computeRootPCAScores(std::vector< std::vector< Mat > > &rootScores);
 
@@ -124,34 +132,63 @@ class DPMCascade
         // cascade process
         void process(std::vector< std::vector<double> > &detections);
 
-        // detect object from image
-        std::vector< std::vector<double> > detect(Mat &image);
+        // cascade process of a pyramid level, the detections are recorded
+        // by component and level in levelDets[comp*nlevels + plevel]
+        void processLevel(int plevel,
+                const std::vector< std::vector< double > > &locationScores,
+                const std::vector< std::vector< Mat > > &rootPCAScores,
+                std::vector< std::vector< std::vector<double> > > &levelDets);
+
+        // detect object from image, with the feature pyramid of shared
+        // when given, see shareFeatures()
+        std::vector< std::vector<double> > detect(Mat &image, const DPMCascade *shared = 0);
 };
 
-#ifdef HAVE_TBB
 /** @brief This class convolves root PCA feature pyramid
- * and root PCA filters in parallel using Intel Threading
- * Building Blocks (TBB)
+ * and root PCA filters of all the components in parallel
  */
 class ParalComputeRootPCAScores : public ParallelLoopBody
 {
     public:
         // constructor
-        ParalComputeRootPCAScores(const std::vector< Mat > &pcaPyramid, const Mat &filter,\
-                int dim, std::vector< Mat > &scores);
+        ParalComputeRootPCAScores(const std::vector< Mat > &pcaPyramid, const std::vector< Mat > &filters,\
+                int dim, int interval, std::vector< std::vector< Mat > > &scores);
 
-        // parallel loop body
+        // parallel loop body, over the pairs of a component and a pyramid level
         void operator() (const Range &range) const;
 
-        ParalComputeRootPCAScores(const ParalComputeRootPCAScores &pComp);
-
     private:
         const std::vector< Mat > &pcaPyramid;
-        const Mat &filter;
+        const std::vector< Mat > &filters;
         int pcaDim;
-        std::vector< Mat > &scores;
+        int interval;
+        std::vector< std::vector< Mat > > &scores;
+
+        ParalComputeRootPCAScores& operator=(const ParalComputeRootPCAScores&); // to quiet MSVC
+};
+
+/** @brief This class runs the cascade on the pyramid levels in parallel
+ */
+class ParalProcessLevels : public ParallelLoopBody
+{
+    public:
+        // constructor
+        ParalProcessLevels(DPMCascade &cascade,\
+                const std::vector< std::vector< double > > &locationScores,\
+                const std::vector< std::vector< Mat > > &rootPCAScores,\
+                std::vector< std::vector< std::vector<double> > > &levelDets);
+
+        // parallel loop body
+        void operator() (const Range &range) const;
+
+    private:
+        DPMCascade &cascade;
+        const std::vector< std::vector< double > > &locationScores;
+        const std::vector< std::vector< Mat > > &rootPCAScores;
+        std::vector< std::vector< std::vector<double> > > &levelDets;
+
+        ParalProcessLevels& operator=(const ParalProcessLevels&); // to quiet MSVC
 };
-#endif
 } // namespace dpm
 } // namespace cv
 
@@ -153,9 +153,17 @@ void DPMDetectorImpl::detect( Mat &image,
 
     for( size_t classID = 0; classID < detectors.size(); classID++ )
     {
+        // the feature pyramid is computed once for the models with the same pyramid parameters
+        const DPMCascade *shared = 0;
+        for( size_t j = 0; j < classID && !shared; j++ )
+        {
+            if( detectors[j]->hasSamePyramid(*detectors[classID]) )
+                shared = detectors[j].get();
+        }
+
         // detect objects
         vector< vector<double> > detections;
-        detections = detectors[classID]->detect(image);
+        detections = detectors[classID]->detect(image, shared);
 
         for (unsigned int i = 0; i < detections.size(); i++)
         {
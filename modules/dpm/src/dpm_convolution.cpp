@@ -59,9 +59,18 @@ double ConvolutionEngine::convolve(const Mat &feat, const Mat &filter,
     return val;
 }
 
+// filters of at least this number of cells are convolved in the frequency domain
+static const int minDFTFilterCells = 48;
+
 void ConvolutionEngine::convolve(const Mat &feat, const Mat &filter,
         int dimHOG, Mat &result)
 {
+    if ((filter.cols/dimHOG)*filter.rows >= minDFTFilterCells)
+    {
+        convolveDFT(feat, filter, dimHOG, result);
+        return;
+    }
+
     for (int x = 0; x < result.cols; x++)
     {
         for (int y = 0; y < result.rows; y++)
@@ -77,5 +86,38 @@ void ConvolutionEngine::convolve(const Mat &feat, const Mat &filter,
         } // y
     } // x
 }
+
+void ConvolutionEngine::convolveDFT(const Mat &feat, const Mat &filter,
+        int dimHOG, Mat &result)
+{
+    CV_Assert(feat.type() == CV_64F && filter.type() == CV_64F);
+
+    // the cells of the maps are stored in dimHOG interleaved channels
+    Mat featChannels = feat.reshape(dimHOG);
+    Mat filterChannels = filter.reshape(dimHOG);
+
+    // the output is the valid part of the circular correlation,
+    // there are no wrapped values in it with the size of the features
+    Size dftSize(getOptimalDFTSize(featChannels.cols), getOptimalDFTSize(featChannels.rows));
+    Mat plane(dftSize, CV_64F), spectrum, filterSpectrum, sum = Mat::zeros(dftSize, CV_64F);
+
+    for (int c = 0; c < dimHOG; c++)
+    {
+        plane.setTo(Scalar::all(0));
+        extractChannel(featChannels, plane(Rect(0, 0, featChannels.cols, featChannels.rows)), c);
+        dft(plane, spectrum, 0, featChannels.rows);
+
+        plane.setTo(Scalar::all(0));
+        extractChannel(filterChannels, plane(Rect(0, 0, filterChannels.cols, filterChannels.rows)), c);
+        dft(plane, filterSpectrum, 0, filterChannels.rows);
+
+        // the spectra of the channels are summed, one inverse transform gives the sum of the correlations
+        mulSpectrums(spectrum, filterSpectrum, spectrum, 0, true);
+        sum += spectrum;
+    }
+
+    dft(sum, plane, DFT_INVERSE | DFT_SCALE | DFT_REAL_OUTPUT, result.rows);
+    plane(Rect(0, 0, result.cols, result.rows)).copyTo(result);
+}
 } // namespace cv
 } // namespace dpm
@@ -68,6 +68,10 @@ class ConvolutionEngine
         // sum the filter convolution values into results
         void convolve(const Mat &feat, const Mat &filter,
                 int dimHOG, Mat &result);
+
+        // compute the same convolution with the DFT, faster for large filters
+        void convolveDFT(const Mat &feat, const Mat &filter,
+                int dimHOG, Mat &result);
 };
 } // namespace dpm
 } // namespace cv
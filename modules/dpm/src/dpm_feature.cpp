@@ -40,6 +40,7 @@
 //M*/
 
 #include "dpm_feature.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 using namespace std;
 
@@ -58,65 +59,12 @@ Feature::Feature (PyramidParameter p):params(p)
 
 void Feature::computeFeaturePyramid(const Mat &imageM, vector< Mat > &pyramid)
 {
-#ifdef HAVE_TBB
     ParalComputePyramid paralTask(imageM, pyramid, params);
     paralTask.initialize();
-    // perform parallel computing
+    // perform parallel computing, each task builds the octaves of one scale
     parallel_for_(Range(0, params.interval), paralTask);
-#else
-    CV_Assert(params.interval > 0);
-    // scale factor between two levels
-    params.sfactor = pow(2.0, 1.0/params.interval);
-    const Size_<double> imSize = imageM.size();
-    params.maxScale = 1 + (int)floor(log(min(imSize.width, imSize.height)/
-                (float)(params.binSize*5.0))/log(params.sfactor));
-
-    if (params.maxScale < params.interval)
-    {
-        CV_Error(CV_StsBadArg, "The image is too small to create a pyramid");
-        return;
-    }
-
-    pyramid.resize(params.maxScale + params.interval);
-    params.scales.resize(params.maxScale + params.interval);
-
-#ifdef _OPENMP
-#pragma omp parallel for
-#endif
-    for (int i = 0; i < params.interval; i++)
-    {
-        const double scale = (double)(1.0f/pow(params.sfactor, i));
-        Mat imScaled;
-        resize(imageM, imScaled, imSize * scale);
-        // First octave at twice the image resolution
-        computeHOG32D(imScaled, pyramid[i], params.binSize/2,
-                params.padx + 1, params.pady + 1);
-
-        params.scales[i] = 2*scale;
-
-        // Second octave at the original resolution
-        if (i + params.interval <= params.maxScale)
-            computeHOG32D(imScaled, pyramid[i+params.interval],
-                    params.binSize, params.padx + 1, params.pady + 1);
-
-        params.scales[i+params.interval] = scale;
-
-        // Remaining octaves
-        for ( int j = i + params.interval; j < params.maxScale; j += params.interval)
-        {
-            Mat imScaled2;
-            Size_<double> imScaledSize = imScaled.size();
-            resize(imScaled, imScaled2, imScaledSize*0.5);
-            imScaled = imScaled2;
-            computeHOG32D(imScaled2, pyramid[j+params.interval],
-                    params.binSize, params.padx + 1, params.pady + 1);
-            params.scales[j+params.interval] = params.scales[j]*0.5;
-        }
-    }
-#endif
 }
 
-#ifdef HAVE_TBB
 ParalComputePyramid::ParalComputePyramid(const Mat &inputImage, \
         vector< Mat > &outputPyramid,\
         PyramidParameter &p):
@@ -177,7 +125,6 @@ void ParalComputePyramid::operator() (const Range &range) const
         }
     }
 }
-#endif
 
 void Feature::computeHOG32D(const Mat &imageM, Mat &featM, const int sbin, const int pad_x, const int pad_y)
 {
@@ -210,7 +157,9 @@ void Feature::computeHOG32D(const Mat &imageM, Mat &featM, const int sbin, const
     // initialize historgram, norm, output feature matrices
     Mat histM = Mat::zeros(Size(blockSize.width*numOrient, blockSize.height), CV_64F);
     Mat normM = Mat::zeros(Size(blockSize.width, blockSize.height), CV_64F);
-    featM = Mat::zeros(Size(outSize.width*dimHOG, outSize.height), CV_64F);
+    // the features of the previous frame are overwritten when they have the same size
+    featM.create(Size(outSize.width*dimHOG, outSize.height), CV_64F);
+    featM.setTo(Scalar::all(0));
 
     // get the stride of each matrix
     const size_t imStride = imageM.step1();
@@ -307,14 +256,25 @@ void Feature::computeHOG32D(const Mat &imageM, Mat &featM, const int sbin, const
         while (dst < dst_end)
         {
             *dst = 0;
-            for (int o = 0; o < (int)(numOrient/2); o++)
+            int o = 0;
+#if CV_SIMD128_64F
+            v_float64x2 energy = v_setzero_f64();
+            for (; o <= (int)(numOrient/2) - 2; o += 2)
             {
-                *dst += (*src + *(src + numOrient/2))*
-                    (*src + *(src + numOrient/2));
-                src++;
+                v_float64x2 sum = v_load(src + o) + v_load(src + o + numOrient/2);
+                energy += sum*sum;
+            }
+            double CV_DECL_ALIGNED(16) buf[2];
+            v_store_aligned(buf, energy);
+            *dst = buf[0] + buf[1];
+#endif
+            for (; o < (int)(numOrient/2); o++)
+            {
+                *dst += (*(src + o) + *(src + o + numOrient/2))*
+                    (*(src + o) + *(src + o + numOrient/2));
             }
             dst++;
-            src += numOrient/2;
+            src += numOrient;
         }
     }
 
@@ -340,7 +300,35 @@ void Feature::computeHOG32D(const Mat &imageM, Mat &featM, const int sbin, const
 
             // contrast-sesitive features
             src = hist + (y - pad_y + 1)*histStride + (x - pad_x + 1)*numOrient;
-            for (int o = 0; o < numOrient; o++)
+            int o = 0;
+#if CV_SIMD128_64F
+            v_float64x2 vn1 = v_setall_f64(n1), vn2 = v_setall_f64(n2);
+            v_float64x2 vn3 = v_setall_f64(n3), vn4 = v_setall_f64(n4);
+            v_float64x2 vmax = v_setall_f64(0.2), vhalf = v_setall_f64(0.5);
+            v_float64x2 vt1 = v_setzero_f64(), vt2 = v_setzero_f64();
+            v_float64x2 vt3 = v_setzero_f64(), vt4 = v_setzero_f64();
+            for (; o <= numOrient - 2; o += 2)
+            {
+                v_float64x2 val = v_load(src);
+                v_float64x2 h1 = v_min(val*vn1, vmax);
+                v_float64x2 h2 = v_min(val*vn2, vmax);
+                v_float64x2 h3 = v_min(val*vn3, vmax);
+                v_float64x2 h4 = v_min(val*vn4, vmax);
+                v_store(dst, vhalf*(h1 + h2 + h3 + h4));
+                dst += 2;
+                src += 2;
+                vt1 += h1;
+                vt2 += h2;
+                vt3 += h3;
+                vt4 += h4;
+            }
+            double CV_DECL_ALIGNED(16) buf[2];
+            v_store_aligned(buf, vt1); t1 = buf[0] + buf[1];
+            v_store_aligned(buf, vt2); t2 = buf[0] + buf[1];
+            v_store_aligned(buf, vt3); t3 = buf[0] + buf[1];
+            v_store_aligned(buf, vt4); t4 = buf[0] + buf[1];
+#endif
+            for (; o < numOrient; o++)
             {
                 double val = *src;
                 double h1 = min(val*n1, 0.2);
@@ -357,7 +345,21 @@ void Feature::computeHOG32D(const Mat &imageM, Mat &featM, const int sbin, const
 
             // contrast-insensitive features
             src =  hist + (y - pad_y + 1)*histStride + (x - pad_x + 1)*numOrient;
-            for (int o = 0; o < numOrient/2; o++)
+            o = 0;
+#if CV_SIMD128_64F
+            for (; o <= numOrient/2 - 2; o += 2)
+            {
+                v_float64x2 sum = v_load(src) + v_load(src + numOrient/2);
+                v_float64x2 h1 = v_min(sum*vn1, vmax);
+                v_float64x2 h2 = v_min(sum*vn2, vmax);
+                v_float64x2 h3 = v_min(sum*vn3, vmax);
+                v_float64x2 h4 = v_min(sum*vn4, vmax);
+                v_store(dst, vhalf*(h1 + h2 + h3 + h4));
+                dst += 2;
+                src += 2;
+            }
+#endif
+            for (; o < numOrient/2; o++)
             {
                 double sum = *src + *(src + numOrient/2);
                 double h1 = min(sum * n1, 0.2);
@@ -399,17 +401,36 @@ void Feature::projectFeaturePyramid(const Mat &pcaCoeff, const std::vector< Mat
 
     projPyramid.resize(pyramid.size());
 
+    // the levels of the pyramid are projected in parallel
+    parallel_for_(Range(0, (int)pyramid.size()),
+            ParalProjectPyramid(pcaCoeff, pyramid, projPyramid));
+}
+
+ParalProjectPyramid::ParalProjectPyramid(const Mat &coeff, \
+        const vector< Mat > &inputPyramid,\
+        vector< Mat > &outputPyramid):
+    pcaCoeff(coeff), pyramid(inputPyramid), projPyramid(outputPyramid)
+{
+}
+
+void ParalProjectPyramid::operator() (const Range &range) const
+{
+    const int dimHOG = Feature::dimHOG;
+    const int dimPCA = pcaCoeff.cols;
+
     // loop for each level of the pyramid
-    for (unsigned int i = 0; i < pyramid.size(); i++)
+    for (int i = range.start; i != range.end; i++)
     {
         Mat orgM = pyramid[i];
         // note that the features are stored in 32-32-32
         int width = orgM.cols/dimHOG;
         int height = orgM.rows;
-        // initialize the project feature matrix
-        Mat projM = Mat::zeros(height, width*dimPCA, CV_64F);
+        // initialize the project feature matrix, reusing the one of the previous frame
+        Mat &projM = projPyramid[i];
+        projM.create(height, width*dimPCA, CV_64F);
+        projM.setTo(Scalar::all(0));
         //get the pointer of the matrix
-        double* const featOrg = orgM.ptr<double>(0);
+        const double* const featOrg = orgM.ptr<double>(0);
         double* const featProj = projM.ptr<double>(0);
 
         // get the stride of each matrix
@@ -424,7 +445,7 @@ void Feature::projectFeaturePyramid(const Mat &pcaCoeff, const std::vector< Mat
                 // for each pca dimension
                 for (int c = 0; c < dimPCA; c++)
                 {
-                    double* org = featOrg + y*orgStride + x*dimHOG;
+                    const double* org = featOrg + y*orgStride + x*dimHOG;
                     // dot product 32d HOG feature with the coefficient vector
                     for (int r = 0; r < dimHOG; r++)
                     {
@@ -436,7 +457,6 @@ void Feature::projectFeaturePyramid(const Mat &pcaCoeff, const std::vector< Mat
 
             } // for x
         } // for y
-        projPyramid[i] = projM;
     } // for each level of the pyramid
 }
 
@@ -43,6 +43,7 @@
 #define __DPM_FEATURE__
 
 #include "opencv2/core.hpp"
+#include "opencv2/core/utility.hpp"
 #include "opencv2/core/core_c.h"
 #include "opencv2/imgproc.hpp"
 
@@ -137,9 +138,7 @@ class Feature
 
 };
 
-#ifdef HAVE_TBB
 /** @brief This class computes feature pyramid in parallel
- * using Intel Threading Building Blocks (TBB)
  */
 class ParalComputePyramid : public ParallelLoopBody
 {
@@ -164,8 +163,34 @@ class ParalComputePyramid : public ParallelLoopBody
         std::vector< Mat > &pyramid;
         // pyramid parameters
         PyramidParameter &params;
+
+        ParalComputePyramid& operator=(const ParalComputePyramid&); // to quiet MSVC
+};
+
+/** @brief This class projects the levels of a feature pyramid
+ * with the PCA coefficient matrix in parallel
+ */
+class ParalProjectPyramid : public ParallelLoopBody
+{
+    public:
+        // constructor
+        ParalProjectPyramid(const Mat &coeff, \
+                const std::vector< Mat > &inputPyramid,\
+                std::vector< Mat > &outputPyramid);
+
+        // parallel loop body
+        void operator() (const Range &range) const;
+
+    private:
+        // PCA coefficient matrix
+        const Mat &pcaCoeff;
+        // input feature pyramid
+        const std::vector< Mat > &pyramid;
+        // output projected pyramid
+        std::vector< Mat > &projPyramid;
+
+        ParalProjectPyramid& operator=(const ParalProjectPyramid&); // to quiet MSVC
 };
-#endif
 
 } // namespace dpm
 } // namespace cv
@@ -41,6 +41,7 @@
 
 #include "dpm_nms.hpp"
 #include <algorithm>
+#include <cmath>
 
 using namespace std;
 
@@ -49,21 +50,86 @@ namespace cv
 namespace dpm
 {
 
-void NonMaximumSuppression::sort(const vector< double > x, vector< int > &indices)
+// orders indices by increasing value of x, indices of equal values keep their order
+struct IndexLess
 {
-    for (unsigned int i = 0; i < x.size(); i++)
-    {
-        for (unsigned int j = i + 1; j < x.size(); j++)
+    IndexLess(const vector< double > &_x) : x(_x) {}
+    bool operator()(int a, int b) const { return x[a] < x[b]; }
+    const vector< double > &x;
+};
+
+void NonMaximumSuppression::sort(const vector< double > &x, vector< int > &indices)
+{
+    std::stable_sort(indices.begin(), indices.end(), IndexLess(x));
+}
+
+/* Uniform grid over the boxes, each cell lists the selected boxes touching it.
+ * A box covers [x1, x2 + 1) x [y1, y2 + 1), so two boxes with a positive
+ * overlap always share a cell.
+ */
+class BoxGrid
+{
+    public:
+        BoxGrid(const vector< vector< double > > &detections)
         {
-            if (x[indices[j]] < x[indices[i]])
+            int numBoxes = (int) detections.size();
+            double minX = detections[0][0], minY = detections[0][1];
+            double maxX = detections[0][2] + 1, maxY = detections[0][3] + 1;
+            double sizeSum = 0;
+            for (int i = 0; i < numBoxes; i++)
             {
-                int tmp = indices[i];
-                indices[i] = indices[j];
-                indices[j] = tmp;
+                const vector< double > &d = detections[i];
+                minX = min(minX, d[0]);
+                minY = min(minY, d[1]);
+                maxX = max(maxX, d[2] + 1);
+                maxY = max(maxY, d[3] + 1);
+                sizeSum += max(d[2] - d[0] + 1, 0.0) + max(d[3] - d[1] + 1, 0.0);
             }
+
+            // cells of the mean box size, with about as many cells as boxes at most
+            originX = minX;
+            originY = minY;
+            cellSize = max(sizeSum / (2 * numBoxes), 1.0);
+            double numCells = ((maxX - minX) / cellSize + 1) * ((maxY - minY) / cellSize + 1);
+            if (numCells > 4.0 * numBoxes + 16)
+                cellSize *= std::sqrt(numCells / (4.0 * numBoxes + 16));
+            cols = (int) ((maxX - minX) / cellSize) + 1;
+            rows = (int) ((maxY - minY) / cellSize) + 1;
+            cells.resize((size_t) cols * rows);
+        }
+
+        // cells covered by the box, empty if the box is empty
+        bool cellRange(const vector< double > &d, int &c1, int &r1, int &c2, int &r2) const
+        {
+            c1 = cellIndex(d[0] - originX, cols);
+            r1 = cellIndex(d[1] - originY, rows);
+            c2 = cellIndex(d[2] + 1 - originX, cols);
+            r2 = cellIndex(d[3] + 1 - originY, rows);
+            return c1 <= c2 && r1 <= r2;
+        }
+
+        void insert(const vector< double > &d, int box)
+        {
+            int c1, r1, c2, r2;
+            if (!cellRange(d, c1, r1, c2, r2))
+                return;
+            for (int r = r1; r <= r2; r++)
+                for (int c = c1; c <= c2; c++)
+                    cells[(size_t) r * cols + c].push_back(box);
         }
-    }
-}
+
+        const vector< int > &cell(int c, int r) const { return cells[(size_t) r * cols + c]; }
+
+    private:
+        int cellIndex(double v, int n) const
+        {
+            return std::min(std::max((int) std::floor(v / cellSize), 0), n - 1);
+        }
+
+        double originX, originY, cellSize;
+        int cols, rows;
+        vector< vector< int > > cells;
+};
 
 void NonMaximumSuppression::process(vector< vector< double > > &detections, double overlapThreshold)
 {
@@ -91,56 +157,64 @@ void NonMaximumSuppression::process(vector< vector< double > > &detections, doub
 
     // sort boxes by score
     sort(score, indices);
+
+    // Greedily select the boxes from the highest score: a box is selected unless it is
+    // significantly covered by a box selected before it. Only the selected boxes sharing
+    // a cell of the grid with it can cover it.
+    BoxGrid grid(detections);
     vector< int > pick;
-    vector< int > suppress;
+    vector< int > lastTested(numBoxes, -1);
 
-    while (indices.size() > 0)
+    for (int n = numBoxes - 1; n >= 0; n--)
     {
-        int last = (int) indices.size() - 1;
-        int i = indices[last];
-        pick.push_back(i);
-        suppress.clear();
-        suppress.push_back(last);
+        int j = indices[n];
+        bool isSuppressed = false;
 
-        for (int k = 0; k <= last - 1; k++)
+        int c1, r1, c2, r2;
+        if (grid.cellRange(detections[j], c1, r1, c2, r2))
         {
-            int j = indices[k];
-            double xx1 = max(detections[i][0], detections[j][0]);
-            double yy1 = max(detections[i][1], detections[j][1]);
-            double xx2 = min(detections[i][2], detections[j][2]);
-            double yy2 = min(detections[i][3], detections[j][3]);
-
-            double w = xx2 - xx1 + 1;
-            double h = yy2 - yy1 + 1;
-
-            if (w > 0 && h > 0)
+            for (int r = r1; r <= r2 && !isSuppressed; r++)
             {
-                // compute overlap
-                double o = w*h / area[j];
-                if (o > overlapThreshold)
-                    suppress.push_back(k);
-            }
-        } // k
-
-        // remove suppressed indices
-        vector< int > newIndices;
-        for (unsigned int n = 0; n < indices.size(); n++)
-        {
-            bool isSuppressed = false;
-            for (unsigned int r = 0; r < suppress.size(); r++)
-            {
-                if (n == (unsigned int)suppress[r])
+                for (int c = c1; c <= c2 && !isSuppressed; c++)
                 {
-                    isSuppressed = true;
-                    break;
+                    const vector< int > &cell = grid.cell(c, r);
+                    for (size_t k = 0; k < cell.size(); k++)
+                    {
+                        int i = cell[k];
+                        // a box spanning several cells is tested once
+                        if (lastTested[i] == j)
+                            continue;
+                        lastTested[i] = j;
+
+                        double xx1 = max(detections[i][0], detections[j][0]);
+                        double yy1 = max(detections[i][1], detections[j][1]);
+                        double xx2 = min(detections[i][2], detections[j][2]);
+                        double yy2 = min(detections[i][3], detections[j][3]);
+
+                        double w = xx2 - xx1 + 1;
+                        double h = yy2 - yy1 + 1;
+
+                        if (w > 0 && h > 0)
+                        {
+                            // compute overlap
+                            double o = w*h / area[j];
+                            if (o > overlapThreshold)
+                            {
+                                isSuppressed = true;
+                                break;
+                            }
+                        }
+                    }
                 }
             }
+        }
 
-            if (!isSuppressed)
-                newIndices.push_back(indices[n]);
+        if (!isSuppressed)
+        {
+            pick.push_back(j);
+            grid.insert(detections[j], j);
         }
-        indices = newIndices;
-    } // while
+    }
 
     vector< vector< double > > newDetections(pick.size());
     for (unsigned int i = 0; i < pick.size(); i++)
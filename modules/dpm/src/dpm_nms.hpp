@@ -50,6 +50,9 @@ namespace dpm
  * Greedily select high-scoring detections and skip
  * detections that are significantly covered by a
  * previously selected detection.
+ * The detections are sorted in O(n log n) and the
+ * coverage is only tested against the selected
+ * detections of the same cells of a uniform grid.
  */
 class NonMaximumSuppression
 {
@@ -57,7 +60,8 @@ class NonMaximumSuppression
         NonMaximumSuppression() {}
         ~NonMaximumSuppression() {}
 
-        void sort(const std::vector< double > x, std::vector< int > &indices);
+        // stable ordering of indices by increasing value of x
+        void sort(const std::vector< double > &x, std::vector< int > &indices);
 
         void process(std::vector< std::vector< double > > &detections, double overlapThreshold);
 };
@@ -215,9 +215,11 @@ public:
 
     This method updates a (probably trained) FaceRecognizer, but only if the algorithm supports it. The
     Local Binary Patterns Histograms (LBPH) recognizer (see createLBPHFaceRecognizer) can be updated.
-    For the Eigenfaces and Fisherfaces method, this is algorithmically not possible and you have to
-    re-estimate the model with FaceRecognizer::train. In any case, a call to train empties the existing
-    model and learns a new model, while update does not delete any model data.
+    The Eigenfaces recognizer (see createEigenFaceRecognizer) can be updated too: its principal
+    components are incrementally updated with the new images instead of being re-estimated from all of
+    them. For the Fisherfaces method, this is algorithmically not possible and you have to re-estimate
+    the model with FaceRecognizer::train. In any case, a call to train empties the existing model and
+    learns a new model, while update does not delete any model data.
 
     @code
     // Create a new LBPH model (it can be updated) and use the default parameters,
@@ -241,11 +243,11 @@ public:
     // with the new features extracted from newImages!
     @endcode
 
-    Calling update on an Eigenfaces model (see createEigenFaceRecognizer), which doesn't support
+    Calling update on a Fisherfaces model (see createFisherFaceRecognizer), which doesn't support
     updating, will throw an error similar to:
 
     @code
-    OpenCV Error: The function/feature is not implemented (This FaceRecognizer (FaceRecognizer.Eigenfaces) does not support updating, you have to use FaceRecognizer::train to update it.) in update, file /home/philipp/git/opencv/modules/contrib/src/facerec.cpp, line 305
+    OpenCV Error: The function/feature is not implemented (This FaceRecognizer (FaceRecognizer.Fisherfaces) does not support updating, you have to use FaceRecognizer::train to update it.) in update, file /home/philipp/git/opencv/modules/contrib/src/facerec.cpp, line 305
     terminate called after throwing an instance of 'cv::Exception'
     @endcode
 
@@ -306,6 +308,18 @@ public:
     */
     CV_WRAP_AS(predict_collect) virtual void predict(InputArray src, Ptr<PredictCollector> collector) const = 0;
 
+    /** @brief Predicts several samples at once, sending the results of every sample to its collector.
+    @param src Sample images to get a prediction from.
+    @param collectors The collectors of the samples, one per sample. If it is empty, it is filled with
+    a StandardCollector per sample with the threshold of the model. Use TopKCollector to keep only the
+    k nearest results of every sample.
+
+    The samples are processed in parallel, so every sample must have its own collector object.
+    Eigenfaces and Fisherfaces project all the samples with one matrix product and compute all the
+    distances to the training samples with another one.
+    */
+    virtual void predictBatch(InputArrayOfArrays src, std::vector<Ptr<PredictCollector> >& collectors) const;
+
     /** @brief Saves a FaceRecognizer and its model state.
 
     Saves this model to a given filename, either as XML or YAML.
@@ -329,6 +343,25 @@ public:
      */
     CV_WRAP virtual void load(const String& filename);
 
+    /** @brief Saves a FaceRecognizer and its model state to a compact binary file.
+
+    The arrays of the model (the histograms of LBPH, the eigenvectors and the projections of
+    Eigenfaces and Fisherfaces) are written as raw arrays, each of them starting at a 64 bytes aligned
+    offset of the file, so the file is much smaller than the XML/YAML one and it is loaded with one
+    read per array. The file is written in the byte order of the machine.
+
+    @param filename The filename to store this FaceRecognizer to.
+    @param depth The depth the arrays are stored with: -1 keeps the depth of the model, CV_32F stores
+    them in single precision. The histograms of LBPH can also be quantized to CV_16U or CV_8U, they
+    are stored scaled to the range of the type and are converted back to floats when loaded.
+     */
+    CV_WRAP virtual void saveBinary(const String& filename, int depth = -1) const;
+
+    /** @brief Loads a FaceRecognizer and its model state from a file written by
+    FaceRecognizer::saveBinary.
+     */
+    CV_WRAP virtual void loadBinary(const String& filename);
+
     /** @overload
     Saves this model to a given FileStorage.
     @param fs The FileStorage to store this FaceRecognizer to.
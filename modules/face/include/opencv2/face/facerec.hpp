@@ -33,6 +33,16 @@ public:
     CV_WRAP virtual cv::Mat getEigenValues() const = 0;
     CV_WRAP virtual cv::Mat getEigenVectors() const = 0;
     CV_WRAP virtual cv::Mat getMean() const = 0;
+    /** @brief Sets the number of nearest training samples reported to the PredictCollector in predict.
+
+    With the default value 0 the distances to all the training samples are reported. With a positive
+    value an approximate nearest neighbour index of the training samples is built at train time,
+    and only the distances to the val samples found with it are reported (the distances are exact but
+    the samples may not be the true nearest ones). This speeds up the prediction for large galleries.
+     */
+    CV_WRAP virtual void setNumCandidates(int val) = 0;
+    /** @see setNumCandidates */
+    CV_WRAP virtual int getNumCandidates() const = 0;
 };
 
 /**
@@ -50,7 +60,10 @@ number. Keeping 80 components should almost always be sufficient.
     SIZE.** (caps-lock, because I got so many mails asking for this). You have to make sure your
     input data has the correct shape, else a meaningful exception is thrown. Use resize to resize
     the images.
--   This model does not support updating.
+-   This model supports updating: the mean and the principal components are updated with the new
+    images (merging of eigenspace models), and the projections of the previous images are mapped
+    to the new components. When num_components is kept at its default (0), the number of components
+    grows with the number of images; otherwise, the first num_components are kept.
 
 ### Model internal data:
 
@@ -123,6 +136,16 @@ public:
     CV_WRAP virtual void setThreshold(double val) = 0;
     CV_WRAP virtual std::vector<cv::Mat> getHistograms() const = 0;
     CV_WRAP virtual cv::Mat getLabels() const = 0;
+    /** @brief Sets the number of nearest training samples reported to the PredictCollector in predict.
+
+    With the default value 0 the distances to all the training samples are reported. With a positive
+    value an approximate nearest neighbour index of the training samples is built at train/update time,
+    and only the distances to the val samples found with it are reported (the distances are exact but
+    the samples may not be the true nearest ones). This speeds up the prediction for large galleries.
+     */
+    CV_WRAP virtual void setNumCandidates(int val) = 0;
+    /** @see setNumCandidates */
+    CV_WRAP virtual int getNumCandidates() const = 0;
 };
 
 /**
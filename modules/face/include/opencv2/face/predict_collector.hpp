@@ -120,6 +120,32 @@ public:
     CV_WRAP static Ptr<StandardCollector> create(double threshold = DBL_MAX);
 };
 
+/** @brief Collector of the k nearest results
+
+Keeps the k results with the smallest distances below the threshold, for instance to get the top-k
+labels of every sample with FaceRecognizer::predictBatch.
+*/
+class CV_EXPORTS_W TopKCollector : public StandardCollector
+{
+protected:
+    size_t k;
+public:
+    /** @brief Constructor
+    @param k_ the number of results to keep
+    @param threshold_ set threshold
+    */
+    TopKCollector(int k_, double threshold_ = DBL_MAX);
+    /** @brief overloaded interface method */
+    void init(size_t size);
+    /** @brief overloaded interface method */
+    bool collect(int label, double dist);
+    /** @brief Static constructor
+    @param k the number of results to keep
+    @param threshold set threshold
+    */
+    CV_WRAP static Ptr<TopKCollector> create(int k, double threshold = DBL_MAX);
+};
+
 //! @}
 }
 }
@@ -0,0 +1,70 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::face;
+using namespace perf;
+
+// Training and prediction of the LBPH recognizer on synthetic faces of the size of the AT&T database,
+// the prediction compares the query with the histograms of all the training images
+
+typedef std::tr1::tuple<int, int> LBPH_t;
+typedef perf::TestBaseWithParam<LBPH_t> lbph;
+
+static void makeFaces(int count, int labelsCount, vector<Mat>& faces, vector<int>& labels)
+{
+    RNG rng(0);
+    faces.resize(count);
+    labels.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        faces[i].create(112, 92, CV_8UC1);
+        rng.fill(faces[i], RNG::UNIFORM, 0, 256);
+        GaussianBlur(faces[i], faces[i], Size(5, 5), 0);
+        labels[i] = i % labelsCount;
+    }
+}
+
+PERF_TEST_P(lbph, train,
+            testing::Combine(
+                testing::Values(40, 400),
+                testing::Values(8, 16)))
+{
+    int count = std::tr1::get<0>(GetParam());
+    int grid = std::tr1::get<1>(GetParam());
+
+    vector<Mat> faces;
+    vector<int> labels;
+    makeFaces(count, 40, faces, labels);
+    Ptr<LBPHFaceRecognizer> model = createLBPHFaceRecognizer(1, 8, grid, grid);
+
+    TEST_CYCLE() model->train(faces, labels);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(lbph, predict,
+            testing::Combine(
+                testing::Values(40, 400),
+                testing::Values(8, 16)))
+{
+    int count = std::tr1::get<0>(GetParam());
+    int grid = std::tr1::get<1>(GetParam());
+
+    vector<Mat> faces;
+    vector<int> labels;
+    makeFaces(count, 40, faces, labels);
+    Ptr<LBPHFaceRecognizer> model = createLBPHFaceRecognizer(1, 8, grid, grid);
+    model->train(faces, labels);
+
+    int label = -1;
+    double confidence = 0;
+    TEST_CYCLE() model->predict(faces[count / 2], label, confidence);
+
+    EXPECT_EQ(labels[count / 2], label);
+    SANITY_CHECK_NOTHING();
+}
@@ -91,6 +91,8 @@ const double kGaborWavelens[kNumBandsMax][2] = {
     {11.5, 12.7}, {14.1, 15.4}, {16.8, 18.2}, {19.7, 21.2}
 };
 
+class BIFUnitsInvoker;
+
 class BIFImpl : public cv::face::BIF {
 public:
     BIFImpl(int num_bands, int num_rotations) {
@@ -105,17 +107,71 @@ public:
                          cv::OutputArray features) const;
 
 private:
+    friend class BIFUnitsInvoker;
+
     struct UnitParams {
         cv::Size cell_size;
         cv::Mat filter1, filter2;
     };
 
+    // The spectra of the filters for the images of a given size. The filters
+    // are applied as products with the spectrum of the image, the image is
+    // padded by border pixels so the responses match the ones of filter2D.
+    struct FilterBank {
+        cv::Size image_size;
+        cv::Size dft_size;
+        int border;
+        std::vector<cv::Mat> spectra1, spectra2;
+    };
+
     void initUnits(int num_bands, int num_rotations);
-    void computeUnit(int unit_idx, const cv::Mat &img, cv::Mat &dst) const;
+    cv::Ptr<FilterBank> getFilterBank(const cv::Size &image_size) const;
+    void computeUnit(int unit_idx, const FilterBank &bank,
+                     const cv::Mat &spectrum, const cv::Size &image_size,
+                     float *dst) const;
 
     int num_bands_;
     int num_rotations_;
+    int border_;
     std::vector<UnitParams> units_;
+
+    // filter bank of the size of the last image
+    mutable cv::Mutex bank_mutex_;
+    mutable cv::Ptr<FilterBank> bank_;
+};
+
+// The number of features of a unit, one per cell of half the cell size.
+inline int unitNumFeatures(const cv::Size &image_size, const cv::Size &cell_size) {
+    int Hhalf = cell_size.height / 2;
+    int Whalf = cell_size.width / 2;
+    return ((image_size.height + Hhalf - 1) / Hhalf) *
+           ((image_size.width + Whalf - 1) / Whalf);
+}
+
+// Computes the features of a range of units of BIFImpl::compute.
+class BIFUnitsInvoker : public cv::ParallelLoopBody {
+public:
+    BIFUnitsInvoker(const BIFImpl &bif, const BIFImpl::FilterBank &bank,
+                    const cv::Mat &spectrum, const cv::Size &image_size,
+                    const std::vector<int> &offsets, cv::Mat &features)
+        : bif_(bif), bank_(bank), spectrum_(spectrum), image_size_(image_size),
+          offsets_(offsets), features_(features) {}
+
+    void operator()(const cv::Range &range) const {
+        for (int i = range.start; i < range.end; ++i)
+            bif_.computeUnit(i, bank_, spectrum_, image_size_,
+                             features_.ptr<float>(offsets_[i]));
+    }
+
+private:
+    const BIFImpl &bif_;
+    const BIFImpl::FilterBank &bank_;
+    const cv::Mat &spectrum_;
+    cv::Size image_size_;
+    const std::vector<int> &offsets_;
+    cv::Mat &features_;
+
+    BIFUnitsInvoker& operator=(const BIFUnitsInvoker&); // to quiet MSVC
 };
 
 void BIFImpl::compute(cv::InputArray _image,
@@ -123,24 +179,28 @@ void BIFImpl::compute(cv::InputArray _image,
     cv::Mat image = _image.getMat();
     CV_Assert(image.type() == CV_32F);
 
-    std::vector<cv::Mat> fea_units(units_.size());
-    int fea_dim = 0;
+    cv::Ptr<FilterBank> bank = getFilterBank(image.size());
+
+    // the spectrum of the padded image is shared by all the units
+    cv::Mat padded = cv::Mat::zeros(bank->dft_size, CV_32F), spectrum;
+    cv::Mat roi = padded(cv::Rect(0, 0, image.cols + 2*bank->border,
+                                  image.rows + 2*bank->border));
+    cv::copyMakeBorder(image, roi, bank->border, bank->border, bank->border,
+                       bank->border, cv::BORDER_REFLECT_101);
+    cv::dft(padded, spectrum, 0, roi.rows);
 
+    std::vector<int> offsets(units_.size());
+    int fea_dim = 0;
     for (size_t i = 0; i < units_.size(); ++i) {
-        computeUnit(static_cast<int>(i), image, fea_units[i]);
-        fea_dim += fea_units[i].rows;
+        offsets[i] = fea_dim;
+        fea_dim += unitNumFeatures(image.size(), units_[i].cell_size);
     }
 
     _features.create(fea_dim, 1, CV_32F);
     cv::Mat fea = _features.getMat();
 
-    int offset = 0;
-    for (size_t i = 0; i < fea_units.size(); ++i) {
-        cv::Mat roi = fea.rowRange(offset, offset + fea_units[i].rows);
-        fea_units[i].copyTo(roi);
-        offset += fea_units[i].rows;
-    }
-    CV_Assert(offset == fea_dim);
+    cv::parallel_for_(cv::Range(0, static_cast<int>(units_.size())),
+                      BIFUnitsInvoker(*this, *bank, spectrum, image.size(), offsets, fea));
 }
 
 void BIFImpl::initUnits(int num_bands, int num_rotations) {
@@ -149,6 +209,7 @@ void BIFImpl::initUnits(int num_bands, int num_rotations) {
 
     num_bands_ = num_bands;
     num_rotations_ = num_rotations;
+    border_ = 0;
 
     for (int ri = 0; ri < num_rotations; ++ri) {
         double angle = CV_PI / num_rotations * ri;
@@ -164,6 +225,8 @@ void BIFImpl::initUnits(int num_bands, int num_rotations) {
                 // the same across all filters.
                 kernel[i] /= 2 * kGaborSigmas[bi][i] * kGaborSigmas[bi][i]
                              / kGaborGamma;
+
+                border_ = std::max(border_, std::max(kernel[i].rows, kernel[i].cols) / 2);
             }
 
             UnitParams unit;
@@ -175,41 +238,74 @@ void BIFImpl::initUnits(int num_bands, int num_rotations) {
     }
 }
 
-void BIFImpl::computeUnit(int unit_idx, const cv::Mat &img,
-                          cv::Mat &dst) const {
-    cv::Mat resp1, resp2;
-    cv::filter2D(img, resp1, CV_32F, units_[unit_idx].filter1);
-    cv::filter2D(img, resp2, CV_32F, units_[unit_idx].filter2);
+cv::Ptr<BIFImpl::FilterBank> BIFImpl::getFilterBank(const cv::Size &image_size) const {
+    cv::AutoLock lock(bank_mutex_);
+    if (bank_ && bank_->image_size == image_size)
+        return bank_;
+
+    cv::Ptr<FilterBank> bank = cv::makePtr<FilterBank>();
+    bank->image_size = image_size;
+    bank->border = border_;
+    bank->dft_size = cv::Size(cv::getOptimalDFTSize(image_size.width + 2*border_),
+                              cv::getOptimalDFTSize(image_size.height + 2*border_));
+    bank->spectra1.resize(units_.size());
+    bank->spectra2.resize(units_.size());
+    for (size_t i = 0; i < units_.size(); ++i) {
+        const cv::Mat *filters[2] = { &units_[i].filter1, &units_[i].filter2 };
+        cv::Mat *spectra[2] = { &bank->spectra1[i], &bank->spectra2[i] };
+        for (int j = 0; j < 2; ++j) {
+            cv::Mat kernel = cv::Mat::zeros(bank->dft_size, CV_32F);
+            filters[j]->copyTo(kernel(cv::Rect(0, 0, filters[j]->cols, filters[j]->rows)));
+            cv::dft(kernel, *spectra[j], 0, filters[j]->rows);
+        }
+    }
+    bank_ = bank;
+    return bank;
+}
+
+void BIFImpl::computeUnit(int unit_idx, const FilterBank &bank,
+                          const cv::Mat &spectrum, const cv::Size &image_size,
+                          float *dst) const {
+    const UnitParams &unit = units_[unit_idx];
+    int rows = image_size.height + bank.border;
+
+    // correlations with the filters, the response of the pixel (x,y) is at
+    // (x + border - anchor.x, y + border - anchor.y)
+    cv::Mat prod, full1, full2;
+    cv::mulSpectrums(spectrum, bank.spectra1[unit_idx], prod, 0, true);
+    cv::idft(prod, full1, cv::DFT_SCALE | cv::DFT_REAL_OUTPUT, rows);
+    cv::mulSpectrums(spectrum, bank.spectra2[unit_idx], prod, 0, true);
+    cv::idft(prod, full2, cv::DFT_SCALE | cv::DFT_REAL_OUTPUT, rows);
+    cv::Mat resp1 = full1(cv::Rect(cv::Point(bank.border - unit.filter1.cols/2,
+                                             bank.border - unit.filter1.rows/2), image_size));
+    cv::Mat resp2 = full2(cv::Rect(cv::Point(bank.border - unit.filter2.cols/2,
+                                             bank.border - unit.filter2.rows/2), image_size));
 
     cv::Mat resp, sum, sumsq;
     cv::max(resp1, resp2, resp);
-    cv::integral(resp, sum, sumsq);
-
-    int Hhalf = units_[unit_idx].cell_size.height / 2;
-    int Whalf = units_[unit_idx].cell_size.width / 2;
+    cv::integral(resp, sum, sumsq, CV_64F, CV_64F);
 
-    int nrows = (resp.rows + Hhalf - 1) / Hhalf;
-    int ncols = (resp.cols + Whalf - 1) / Whalf;
-    dst.create(nrows*ncols, 1, CV_32F);
+    int Hhalf = unit.cell_size.height / 2;
+    int Whalf = unit.cell_size.width / 2;
 
     for (int pos = 0, yc = 0; yc < resp.rows; yc += Hhalf) {
         int y0 = std::max(0, yc - Hhalf);
         int y1 = std::min(resp.rows, yc + Hhalf);
+        const double *s0 = sum.ptr<double>(y0), *s1 = sum.ptr<double>(y1);
+        const double *q0 = sumsq.ptr<double>(y0), *q1 = sumsq.ptr<double>(y1);
 
         for (int xc = 0; xc < resp.cols; xc += Whalf, ++pos) {
             int x0 = std::max(0, xc - Whalf);
             int x1 = std::min(resp.cols, xc + Whalf);
             int area = (y1-y0) * (x1-x0);
 
-            float mean = sum.at<float>(y1,x1) - sum.at<float>(y1,x0)
-                         - sum.at<float>(y0,x1) + sum.at<float>(y0,x0);
+            double mean = s1[x1] - s1[x0] - s0[x1] + s0[x0];
             mean /= area;
 
-            double sd = sumsq.at<double>(y1,x1) - sumsq.at<double>(y1,x0)
-                        - sumsq.at<double>(y0,x1) + sumsq.at<double>(y0,x0);
-            sd = sqrt(sd / area - mean * mean);
+            double sd = q1[x1] - q1[x0] - q0[x1] + q0[x0];
+            sd = sqrt(std::max(0.0, sd / area - mean * mean));
 
-            dst.at<float>(pos) = static_cast<float>(sd);
+            dst[pos] = static_cast<float>(sd);
         }
     }
 }
@@ -34,15 +34,23 @@ class Eigenfaces : public BasicFaceRecognizerImpl
 public:
     // Initializes an empty Eigenfaces model.
     Eigenfaces(int num_components = 0, double threshold = DBL_MAX)
-        : BasicFaceRecognizerImpl(num_components, threshold)
+        : BasicFaceRecognizerImpl(num_components, threshold), _keep_all_components(num_components <= 0)
     {}
 
     // Computes an Eigenfaces model with images in src and corresponding labels
     // in labels.
     void train(InputArrayOfArrays src, InputArray labels);
 
+    // Updates the Eigenfaces model with images in src and corresponding labels
+    // in labels, without recomputing the PCA of the previous images.
+    void update(InputArrayOfArrays src, InputArray labels);
+
     // Send all predict results to caller side for custom result handling
     void predict(InputArray src, Ptr<PredictCollector> collector) const;
+
+private:
+    // the number of components was not given, it grows with the number of samples
+    bool _keep_all_components;
 };
 
 //------------------------------------------------------------------------------
@@ -81,6 +89,7 @@ void Eigenfaces::train(InputArrayOfArrays _src, InputArray _local_labels) {
     _labels.release();
     _projections.clear();
     // clip number of components to be valid
+    _keep_all_components = (_num_components <= 0) || (_num_components >= n);
     if((_num_components <= 0) || (_num_components > n))
         _num_components = n;
 
@@ -97,6 +106,95 @@ void Eigenfaces::train(InputArrayOfArrays _src, InputArray _local_labels) {
         Mat p = LDA::subspaceProject(_eigenvectors, _mean, data.row(sampleIdx));
         _projections.push_back(p);
     }
+    // index the projections for the prediction
+    buildIndex();
+}
+
+// Merges the eigenspace of the current model with the new samples (Hall, Marshall and Martin, "Merging
+// and splitting eigenspace models", PAMI 2000). The scatter matrix of all the samples is
+//   n*U*L*U' + (B-v)'*(B-v) + n*m/(n+m)*(v-u)'*(v-u)
+// for the current mean u, components U and eigenvalues L of n samples and the m new samples B with
+// mean v, so the new components are the left singular vectors of the d x (k+m+1) matrix whose
+// product with its transpose is that scatter, which costs O(d*(k+m)^2) instead of a PCA of all the
+// samples. The previous samples are only known through their projections, they are mapped to the
+// new components assuming they lie in the span of the current ones (exact when all the components
+// are kept).
+void Eigenfaces::update(InputArrayOfArrays _src, InputArray _local_labels) {
+    // got no data, just return
+    if(_src.total() == 0)
+        return;
+    // nothing to update, learn a new model
+    if(_projections.empty()) {
+        train(_src, _local_labels);
+        return;
+    }
+    if(_local_labels.getMat().type() != CV_32SC1) {
+        String error_message = format("Labels must be given as integer (CV_32SC1). Expected %d, but was %d.", CV_32SC1, _local_labels.type());
+        CV_Error(Error::StsBadArg, error_message);
+    }
+    for(int i = 0; i < static_cast<int>(_src.total()); i++) {
+        if(_src.getMat(i).total() != (size_t)_eigenvectors.rows) {
+            String error_message = format("In the Eigenfaces method all input samples (training images) must be of equal size! Expected %d pixels, but was %d pixels.", _eigenvectors.rows, _src.getMat(i).total());
+            CV_Error(Error::StsUnsupportedFormat, error_message);
+        }
+    }
+    Mat labels = _local_labels.getMat();
+    // new observations in row
+    Mat data = asRowMatrix(_src, CV_64FC1);
+    int n = (int)_projections.size();
+    int m = data.rows;
+    if(static_cast<int>(labels.total()) != m) {
+        String error_message = format("The number of samples (src) must equal the number of labels (labels)! len(src)=%d, len(labels)=%d.", m, labels.total());
+        CV_Error(Error::StsBadArg, error_message);
+    }
+    int d = _eigenvectors.rows;
+    int k = _eigenvectors.cols;
+
+    // mean of the new samples and of all of them
+    Mat newMean;
+    reduce(data, newMean, 0, REDUCE_AVG, CV_64F);
+    Mat mean = (n*_mean + m*newMean) / (n + m);
+
+    // the matrix whose scatter is the one of all the samples
+    Mat A(d, k + m + 1, CV_64FC1);
+    for(int i = 0; i < k; i++) {
+        double scale = std::sqrt(std::max(0.0, n*_eigenvalues.at<double>(i)));
+        Mat col = A.col(i);
+        _eigenvectors.col(i).convertTo(col, CV_64F, scale);
+    }
+    for(int j = 0; j < m; j++) {
+        Mat col = A.col(k + j);
+        Mat((data.row(j) - newMean).t()).copyTo(col);
+    }
+    {
+        Mat col = A.col(k + m);
+        Mat((newMean - _mean).t() * std::sqrt((double)n*m/(n + m))).copyTo(col);
+    }
+
+    SVD svd(A);
+    int num_components = _keep_all_components ? n + m : _num_components;
+    num_components = std::min(num_components, svd.w.rows);
+
+    Mat eigenvectors = svd.u.colRange(0, num_components).clone();
+    Mat eigenvalues = svd.w.rowRange(0, num_components).mul(svd.w.rowRange(0, num_components)) / (n + m);
+
+    // map the projections of the previous samples to the new components:
+    // (u + p*U' - mean)*V = (u - mean)*V + p*(U'*V)
+    Mat offset = (_mean - mean) * eigenvectors;
+    Mat rotation = _eigenvectors.t() * eigenvectors;
+    for(int i = 0; i < n; i++)
+        _projections[i] = offset + _projections[i] * rotation;
+
+    _mean = mean;
+    _eigenvectors = eigenvectors;
+    _eigenvalues = eigenvalues;
+    _num_components = num_components;
+    for(int j = 0; j < m; j++) {
+        _labels.push_back(labels.at<int>(j));
+        _projections.push_back(LDA::subspaceProject(_eigenvectors, _mean, data.row(j)));
+    }
+    // index the projections for the prediction
+    buildIndex();
 }
 
 void Eigenfaces::predict(InputArray _src, Ptr<PredictCollector> collector) const {
@@ -114,12 +212,7 @@ void Eigenfaces::predict(InputArray _src, Ptr<PredictCollector> collector) const
     }
     // project into PCA subspace
     Mat q = LDA::subspaceProject(_eigenvectors, _mean, src.reshape(1, 1));
-    collector->init(_projections.size());
-    for (size_t sampleIdx = 0; sampleIdx < _projections.size(); sampleIdx++) {
-        double dist = norm(_projections[sampleIdx], q, NORM_L2);
-        int label = _labels.at<int>((int)sampleIdx);
-        if (!collector->collect(label, dist))return;
-    }
+    collectProjections(q, collector);
 }
 
 Ptr<BasicFaceRecognizer> createEigenFaceRecognizer(int num_components, double threshold)
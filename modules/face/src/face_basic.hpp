@@ -2,6 +2,7 @@
 #define __OPENCV_FACE_BASIC_HPP
 
 #include "opencv2/face.hpp"
+#include "opencv2/flann.hpp"
 #include "precomp.hpp"
 
 #include <set>
@@ -106,12 +107,115 @@ inline void read(const cv::FileNode& node, LabelInfo& x, const LabelInfo& defaul
         x.read(node);
 }
 
+// Prepares the collectors of FaceRecognizer::predictBatch: one StandardCollector per sample if none
+// is given, or checks that there is one per sample.
+inline void initBatchCollectors(size_t num_samples, double threshold,
+                                std::vector<Ptr<cv::face::PredictCollector> >& collectors) {
+    if (collectors.empty()) {
+        for (size_t i = 0; i < num_samples; i++)
+            collectors.push_back(cv::face::StandardCollector::create(threshold));
+    } else if (collectors.size() != num_samples) {
+        String error_message = format("There must be one collector per sample. Was len(samples)=%d, len(collectors)=%d.", num_samples, collectors.size());
+        CV_Error(Error::StsBadArg, error_message);
+    }
+}
+
+// Compact binary model file (see FaceRecognizer::saveBinary): a header followed by named arrays, the
+// data of every array starts at a multiple of BINARY_MODEL_ALIGNMENT bytes from the beginning of the
+// file. Every array is stored with a scale, the stored values are the model values multiplied by it.
+enum { BINARY_MODEL_ALIGNMENT = 64 };
+
+class BinaryModelWriter
+{
+public:
+    explicit BinaryModelWriter(const String& filename);
+    ~BinaryModelWriter();
+
+    // writes src converted to depth (-1 keeps its depth) and multiplied by scale
+    void write(const String& name, const Mat& src, int depth = -1, double scale = 1);
+    // writes the samples as the rows of a single array
+    void write(const String& name, const std::vector<Mat>& samples, int depth = -1, double scale = 1);
+    void write(const String& name, int value);
+    void write(const std::map<int, String>& labelsInfo);
+
+private:
+    // writes the data as it is, scale is the one it was multiplied by
+    void writeArray(const String& name, const Mat& data, double scale);
+    void writeRaw(const void* data, size_t size);
+    void pad();
+
+    FILE* _file;
+    size_t _offset;
+};
+
+class BinaryModelReader
+{
+public:
+    // reads all the arrays of the file
+    explicit BinaryModelReader(const String& filename);
+
+    // the array converted to depth (-1 keeps the stored depth, quantized arrays are given as CV_32F)
+    Mat get(const String& name, int depth = -1) const;
+    // the rows of the array, they share the data of a single matrix
+    void get(const String& name, std::vector<Mat>& samples, int depth = -1) const;
+    int getInt(const String& name) const;
+    void get(std::map<int, String>& labelsInfo) const;
+
+private:
+    struct Array
+    {
+        Mat data;
+        double scale;
+    };
+    const Array& find(const String& name) const;
+
+    std::map<String, Array> _arrays;
+};
+
+// Approximate nearest neighbour index over the training samples of a recognizer, used instead of the
+// exhaustive search when the number of candidates of the recognizer is set. The samples are the rows
+// of a CV_32FC1 matrix and the index is searched with the L2 distance.
+class SampleIndex
+{
+public:
+    void build(const Mat& samples)
+    {
+        CV_Assert(samples.type() == CV_32FC1);
+        // the index refers to the data of the samples
+        samples.copyTo(_samples);
+        _index = makePtr<flann::Index>(_samples, flann::KDTreeIndexParams(4));
+    }
+
+    void release()
+    {
+        _index.release();
+        _samples.release();
+    }
+
+    bool empty() const { return _index.empty(); }
+
+    // finds (approximately) the knn samples nearest to the query, indices are sorted by distance
+    void search(const Mat& query, int knn, std::vector<int>& indices) const
+    {
+        knn = std::min(knn, _samples.rows);
+        Mat idx, dists;
+        _index->knnSearch(query, idx, dists, knn, flann::SearchParams(std::max(32, 2*knn)));
+        indices.clear();
+        for (int i = 0; i < knn; i++)
+            if (idx.at<int>(0,i) >= 0)
+                indices.push_back(idx.at<int>(0,i));
+    }
+
+private:
+    Mat _samples;
+    Ptr<flann::Index> _index;
+};
 
 class BasicFaceRecognizerImpl : public cv::face::BasicFaceRecognizer
 {
 public:
     BasicFaceRecognizerImpl(int num_components = 0, double threshold = DBL_MAX)
-        : _num_components(num_components), _threshold(threshold)
+        : _num_components(num_components), _threshold(threshold), _num_candidates(0)
     {}
 
     void load(const FileStorage& fs)
@@ -135,6 +239,7 @@ public:
                _labelsInfo.insert(std::make_pair(item.label, item.value));
            }
         }
+        buildIndex();
     }
 
     void save(FileStorage& fs) const
@@ -153,6 +258,68 @@ public:
         fs << "]";
     }
 
+    // Projects all the samples with one product and computes their squared distances to the
+    // projections of the training samples as |q|^2 + |p|^2 - 2*q*p' with another one.
+    void predictBatch(InputArrayOfArrays _src, std::vector<Ptr<cv::face::PredictCollector> >& collectors) const
+    {
+        // the candidates of the index are searched one sample at a time
+        if (!_index.empty() || _projections.empty() || _src.total() == 0) {
+            FaceRecognizer::predictBatch(_src, collectors);
+            return;
+        }
+        std::vector<Mat> src;
+        _src.getMatVector(src);
+        for (size_t i = 0; i < src.size(); i++) {
+            if (_eigenvectors.rows != static_cast<int>(src[i].total())) {
+                String error_message = format("Wrong input image size. Reason: Training and Test images must be of equal size! Expected an image with %d elements, but got %d.", _eigenvectors.rows, src[i].total());
+                CV_Error(Error::StsBadArg, error_message);
+            }
+        }
+        initBatchCollectors(src.size(), _threshold, collectors);
+
+        Mat q = LDA::subspaceProject(_eigenvectors, _mean, asRowMatrix(src, CV_64FC1));
+        Mat p = asRowMatrix(_projections, CV_64FC1);
+        Mat dists, qn, pn;
+        gemm(q, p, -2, noArray(), 0, dists, GEMM_2_T);
+        reduce(q.mul(q), qn, 1, REDUCE_SUM);
+        reduce(p.mul(p), pn, 1, REDUCE_SUM);
+        for (int i = 0; i < dists.rows; i++) {
+            const double* d = dists.ptr<double>(i);
+            collectors[i]->init(p.rows);
+            for (int j = 0; j < p.rows; j++) {
+                double dist = std::sqrt(std::max(0.0, d[j] + qn.at<double>(i) + pn.at<double>(j)));
+                if (!collectors[i]->collect(_labels.at<int>(j), dist))break;
+            }
+        }
+    }
+
+    void saveBinary(const String& filename, int depth) const
+    {
+        CV_Assert(depth == -1 || depth == CV_32F || depth == CV_64F);
+        BinaryModelWriter writer(filename);
+        writer.write("num_components", _num_components);
+        writer.write("mean", _mean, depth);
+        writer.write("eigenvalues", _eigenvalues, depth);
+        writer.write("eigenvectors", _eigenvectors, depth);
+        writer.write("projections", _projections, depth);
+        writer.write("labels", _labels);
+        writer.write(_labelsInfo);
+    }
+
+    void loadBinary(const String& filename)
+    {
+        BinaryModelReader reader(filename);
+        // the model is computed in double precision, whatever the stored depth
+        _num_components = reader.getInt("num_components");
+        _mean = reader.get("mean", CV_64F);
+        _eigenvalues = reader.get("eigenvalues", CV_64F);
+        _eigenvectors = reader.get("eigenvectors", CV_64F);
+        reader.get("projections", _projections, CV_64F);
+        _labels = reader.get("labels");
+        reader.get(_labelsInfo);
+        buildIndex();
+    }
+
     CV_IMPL_PROPERTY(int, NumComponents, _num_components)
     CV_IMPL_PROPERTY(double, Threshold, _threshold)
     CV_IMPL_PROPERTY_RO(std::vector<cv::Mat>, Projections, _projections)
@@ -161,9 +328,62 @@ public:
     CV_IMPL_PROPERTY_RO(cv::Mat, EigenVectors, _eigenvectors)
     CV_IMPL_PROPERTY_RO(cv::Mat, Mean, _mean)
 
+    int getNumCandidates() const { return _num_candidates; }
+    void setNumCandidates(int val)
+    {
+        CV_Assert(val >= 0);
+        _num_candidates = val;
+        buildIndex();
+    }
+
 protected:
+    // (re)builds the index of the projections, or releases it if the search is exhaustive
+    void buildIndex()
+    {
+        if (_num_candidates == 0 || _projections.empty())
+        {
+            _index.release();
+            return;
+        }
+        Mat samples((int)_projections.size(), (int)_projections[0].total(), CV_32FC1);
+        for (int i = 0; i < samples.rows; i++)
+        {
+            Mat row = samples.row(i);
+            _projections[i].reshape(1, 1).convertTo(row, CV_32F);
+        }
+        _index.build(samples);
+    }
+
+    // sends the distances between the projection q and the projections of the training samples to
+    // the collector, either all of them or those of the candidates found with the index
+    void collectProjections(const Mat& q, Ptr<PredictCollector> collector) const
+    {
+        if (_index.empty())
+        {
+            collector->init(_projections.size());
+            for (size_t sampleIdx = 0; sampleIdx < _projections.size(); sampleIdx++) {
+                double dist = norm(_projections[sampleIdx], q, NORM_L2);
+                int label = _labels.at<int>((int)sampleIdx);
+                if (!collector->collect(label, dist))return;
+            }
+            return;
+        }
+        Mat query;
+        q.reshape(1, 1).convertTo(query, CV_32F);
+        std::vector<int> candidates;
+        _index.search(query, _num_candidates, candidates);
+        collector->init(candidates.size());
+        for (size_t i = 0; i < candidates.size(); i++) {
+            double dist = norm(_projections[candidates[i]], q, NORM_L2);
+            int label = _labels.at<int>(candidates[i]);
+            if (!collector->collect(label, dist))return;
+        }
+    }
+
     int _num_components;
     double _threshold;
+    int _num_candidates;
+    SampleIndex _index;
     std::vector<Mat> _projections;
     Mat _labels;
     Mat _eigenvectors;
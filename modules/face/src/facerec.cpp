@@ -17,6 +17,226 @@
  */
 #include "precomp.hpp"
 #include "opencv2/face.hpp"
+#include "face_basic.hpp"
+
+namespace
+{
+
+struct BinaryModelHeader
+{
+    char magic[8];
+    int version;
+    unsigned int byte_order;
+    int alignment;
+    char reserved[44];
+};
+
+struct BinaryArrayHeader
+{
+    char name[32];
+    int type;
+    int rows;
+    int cols;
+    int reserved;
+    double scale;
+    char padding[8];
+};
+
+const char BINARY_MODEL_MAGIC[8] = { 'C', 'V', 'F', 'A', 'C', 'E', 'M', 'D' };
+const int BINARY_MODEL_VERSION = 1;
+const unsigned int BINARY_MODEL_BYTE_ORDER = 0x01020304;
+
+// closes the file when the reading fails
+struct FileCloser
+{
+    FileCloser(FILE* _file) : file(_file) {}
+    ~FileCloser() { fclose(file); }
+    FILE* file;
+};
+
+}
+
+BinaryModelWriter::BinaryModelWriter(const String& filename) : _offset(0)
+{
+    _file = fopen(filename.c_str(), "wb");
+    if (!_file)
+        CV_Error(Error::StsError, "File can't be opened for writing!");
+    BinaryModelHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BINARY_MODEL_MAGIC, sizeof(header.magic));
+    header.version = BINARY_MODEL_VERSION;
+    header.byte_order = BINARY_MODEL_BYTE_ORDER;
+    header.alignment = BINARY_MODEL_ALIGNMENT;
+    writeRaw(&header, sizeof(header));
+}
+
+BinaryModelWriter::~BinaryModelWriter()
+{
+    fclose(_file);
+}
+
+void BinaryModelWriter::writeRaw(const void* data, size_t size)
+{
+    if (size > 0 && fwrite(data, 1, size, _file) != size)
+        CV_Error(Error::StsError, "Can't write to the model file!");
+    _offset += size;
+}
+
+void BinaryModelWriter::pad()
+{
+    static const char zeros[BINARY_MODEL_ALIGNMENT] = { 0 };
+    size_t rem = _offset % BINARY_MODEL_ALIGNMENT;
+    if (rem != 0)
+        writeRaw(zeros, BINARY_MODEL_ALIGNMENT - rem);
+}
+
+void BinaryModelWriter::write(const String& name, const Mat& src, int depth, double scale)
+{
+    Mat data = src;
+    if ((depth >= 0 && depth != src.depth()) || scale != 1)
+        src.convertTo(data, depth, scale);
+    writeArray(name, data, scale);
+}
+
+void BinaryModelWriter::writeArray(const String& name, const Mat& src, double scale)
+{
+    CV_Assert(name.size() < sizeof(BinaryArrayHeader().name) && src.dims <= 2);
+    Mat data = src.isContinuous() ? src : src.clone();
+
+    BinaryArrayHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.name, name.c_str(), name.size());
+    header.type = data.type();
+    header.rows = data.rows;
+    header.cols = data.cols;
+    header.scale = scale;
+    writeRaw(&header, sizeof(header));
+    writeRaw(data.data, data.total()*data.elemSize());
+    pad();
+}
+
+void BinaryModelWriter::write(const String& name, const std::vector<Mat>& samples, int depth, double scale)
+{
+    if (samples.empty())
+    {
+        writeArray(name, Mat(), scale);
+        return;
+    }
+    if (depth < 0)
+        depth = samples[0].depth();
+    writeArray(name, asRowMatrix(samples, depth, scale), scale);
+}
+
+void BinaryModelWriter::write(const String& name, int value)
+{
+    write(name, Mat(1, 1, CV_32SC1, &value));
+}
+
+void BinaryModelWriter::write(const std::map<int, String>& labelsInfo)
+{
+    // the labels and their strings, each of them terminated by a null character
+    Mat labels(1, (int)labelsInfo.size(), CV_32SC1);
+    std::vector<uchar> values;
+    int i = 0;
+    for (std::map<int, String>::const_iterator it = labelsInfo.begin(); it != labelsInfo.end(); it++, i++)
+    {
+        labels.at<int>(i) = it->first;
+        values.insert(values.end(), it->second.begin(), it->second.end());
+        values.push_back(0);
+    }
+    write("labels_info_keys", labelsInfo.empty() ? Mat() : labels);
+    write("labels_info_values", values.empty() ? Mat() : Mat(values).reshape(1, 1));
+}
+
+BinaryModelReader::BinaryModelReader(const String& filename)
+{
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file)
+        CV_Error(Error::StsError, "File can't be opened for reading!");
+    FileCloser closer(file);
+
+    BinaryModelHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, BINARY_MODEL_MAGIC, sizeof(header.magic)) != 0)
+        CV_Error(Error::StsError, "The file is not a binary FaceRecognizer model!");
+    if (header.version != BINARY_MODEL_VERSION)
+        CV_Error(Error::StsError, format("Unsupported version %d of the binary model format.", header.version));
+    if (header.byte_order != BINARY_MODEL_BYTE_ORDER)
+        CV_Error(Error::StsError, "The binary model was written on a machine with a different byte order.");
+    CV_Assert(header.alignment > 0);
+
+    BinaryArrayHeader arrayHeader;
+    while (fread(&arrayHeader, sizeof(arrayHeader), 1, file) == 1)
+    {
+        arrayHeader.name[sizeof(arrayHeader.name) - 1] = 0;
+        CV_Assert(arrayHeader.rows >= 0 && arrayHeader.cols >= 0);
+        Array& array = _arrays[String(arrayHeader.name)];
+        array.scale = arrayHeader.scale;
+        array.data.release();
+        size_t size = 0;
+        if (arrayHeader.rows > 0 && arrayHeader.cols > 0)
+        {
+            array.data.create(arrayHeader.rows, arrayHeader.cols, arrayHeader.type);
+            size = array.data.total()*array.data.elemSize();
+            if (fread(array.data.data, 1, size, file) != size)
+                CV_Error(Error::StsError, "The binary model file is truncated!");
+        }
+        // the next array starts at the next aligned offset
+        size_t rem = (sizeof(arrayHeader) + size) % header.alignment;
+        if (rem != 0)
+            fseek(file, (long)(header.alignment - rem), SEEK_CUR);
+    }
+}
+
+const BinaryModelReader::Array& BinaryModelReader::find(const String& name) const
+{
+    std::map<String, Array>::const_iterator it = _arrays.find(name);
+    if (it == _arrays.end())
+        CV_Error(Error::StsError, format("The binary model has no array '%s'.", name.c_str()));
+    return it->second;
+}
+
+Mat BinaryModelReader::get(const String& name, int depth) const
+{
+    const Array& array = find(name);
+    if (depth < 0)
+        depth = array.scale != 1 ? CV_32F : array.data.depth();
+    if (array.data.empty() || (depth == array.data.depth() && array.scale == 1))
+        return array.data;
+    Mat data;
+    array.data.convertTo(data, depth, 1.0/array.scale);
+    return data;
+}
+
+void BinaryModelReader::get(const String& name, std::vector<Mat>& samples, int depth) const
+{
+    Mat data = get(name, depth);
+    samples.resize(data.rows);
+    for (int i = 0; i < data.rows; i++)
+        samples[i] = data.row(i);
+}
+
+int BinaryModelReader::getInt(const String& name) const
+{
+    Mat data = get(name);
+    CV_Assert(data.total() == 1 && data.type() == CV_32SC1);
+    return data.at<int>(0);
+}
+
+void BinaryModelReader::get(std::map<int, String>& labelsInfo) const
+{
+    Mat labels = get("labels_info_keys"), values = get("labels_info_values");
+    labelsInfo.clear();
+    const char* value = values.empty() ? 0 : values.ptr<char>();
+    const char* end = value + values.total();
+    for (size_t i = 0; i < labels.total(); i++)
+    {
+        CV_Assert(value && value < end);
+        String str(value);
+        labelsInfo.insert(std::make_pair(labels.at<int>((int)i), str));
+        value += str.size() + 1;
+    }
+}
 
 namespace cv
 {
@@ -72,6 +292,49 @@ void FaceRecognizer::save(const String &filename) const
     fs.release();
 }
 
+// Predicts the samples of a batch in parallel, each of them with its own collector.
+class PredictBatchInvoker : public ParallelLoopBody
+{
+public:
+    PredictBatchInvoker(const FaceRecognizer& _model, const std::vector<Mat>& _src,
+                        std::vector<Ptr<PredictCollector> >& _collectors)
+        : model(_model), src(_src), collectors(_collectors) {}
+
+    void operator()(const Range& range) const
+    {
+        for (int i = range.start; i < range.end; i++)
+            model.predict(src[i], collectors[i]);
+    }
+
+private:
+    const FaceRecognizer& model;
+    const std::vector<Mat>& src;
+    std::vector<Ptr<PredictCollector> >& collectors;
+
+    PredictBatchInvoker& operator=(const PredictBatchInvoker&); // to quiet MSVC
+};
+
+void FaceRecognizer::predictBatch(InputArrayOfArrays _src, std::vector<Ptr<PredictCollector> >& collectors) const
+{
+    std::vector<Mat> src;
+    _src.getMatVector(src);
+    initBatchCollectors(src.size(), getThreshold(), collectors);
+    parallel_for_(Range(0, (int)src.size()), PredictBatchInvoker(*this, src, collectors));
+}
+
+void FaceRecognizer::saveBinary(const String &filename, int depth) const
+{
+    (void)filename;
+    (void)depth;
+    CV_Error(Error::StsNotImplemented, "This FaceRecognizer does not support the binary model format.");
+}
+
+void FaceRecognizer::loadBinary(const String &filename)
+{
+    (void)filename;
+    CV_Error(Error::StsNotImplemented, "This FaceRecognizer does not support the binary model format.");
+}
+
 int FaceRecognizer::predict(InputArray src) const {
     int _label;
     double _dist;
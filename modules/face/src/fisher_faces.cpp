@@ -118,6 +118,8 @@ void Fisherfaces::train(InputArrayOfArrays src, InputArray _lbls) {
         Mat p = LDA::subspaceProject(_eigenvectors, _mean, data.row(sampleIdx));
         _projections.push_back(p);
     }
+    // index the projections for the prediction
+    buildIndex();
 }
 
 void Fisherfaces::predict(InputArray _src, Ptr<PredictCollector> collector) const {
@@ -134,12 +136,7 @@ void Fisherfaces::predict(InputArray _src, Ptr<PredictCollector> collector) cons
     // project into LDA subspace
     Mat q = LDA::subspaceProject(_eigenvectors, _mean, src.reshape(1,1));
     // find 1-nearest neighbor
-    collector->init((int)_projections.size());
-    for (size_t sampleIdx = 0; sampleIdx < _projections.size(); sampleIdx++) {
-        double dist = norm(_projections[sampleIdx], q, NORM_L2);
-        int label = _labels.at<int>((int)sampleIdx);
-        if (!collector->collect(label, dist))return;
-    }
+    collectProjections(q, collector);
 }
 
 Ptr<BasicFaceRecognizer> createFisherFaceRecognizer(int num_components, double threshold)
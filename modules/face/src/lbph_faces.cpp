@@ -18,6 +18,7 @@
 #include "precomp.hpp"
 #include "opencv2/face.hpp"
 #include "face_basic.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv { namespace face {
 
@@ -35,10 +36,18 @@ private:
     int _radius;
     int _neighbors;
     double _threshold;
+    int _num_candidates;
 
     std::vector<Mat> _histograms;
     Mat _labels;
 
+    // index of the square roots of the histograms: the L2 distance between them (the Hellinger
+    // distance) ranks the histograms like the chi-square distance
+    SampleIndex _index;
+
+    // (re)builds the index of the histograms, or releases it if the search is exhaustive
+    void buildIndex();
+
     // Computes a LBPH model with images in src and
     // corresponding labels in labels, possibly preserving
     // old model data.
@@ -61,7 +70,8 @@ public:
         _grid_y(gridy),
         _radius(radius_),
         _neighbors(neighbors_),
-        _threshold(threshold) {}
+        _threshold(threshold),
+        _num_candidates(0) {}
 
     // Initializes and computes this LBPH Model. The current implementation is
     // rather fixed as it uses the Extended Local Binary Patterns per default.
@@ -77,7 +87,8 @@ public:
                 _grid_y(gridy),
                 _radius(radius_),
                 _neighbors(neighbors_),
-                _threshold(threshold) {
+                _threshold(threshold),
+                _num_candidates(0) {
         train(src, labels);
     }
 
@@ -100,6 +111,12 @@ public:
     // See FaceRecognizer::save.
     void save(FileStorage& fs) const;
 
+    // See FaceRecognizer::saveBinary.
+    void saveBinary(const String& filename, int depth) const;
+
+    // See FaceRecognizer::loadBinary.
+    void loadBinary(const String& filename);
+
     CV_IMPL_PROPERTY(int, GridX, _grid_x)
     CV_IMPL_PROPERTY(int, GridY, _grid_y)
     CV_IMPL_PROPERTY(int, Radius, _radius)
@@ -107,6 +124,14 @@ public:
     CV_IMPL_PROPERTY(double, Threshold, _threshold)
     CV_IMPL_PROPERTY_RO(std::vector<cv::Mat>, Histograms, _histograms)
     CV_IMPL_PROPERTY_RO(cv::Mat, Labels, _labels)
+
+    int getNumCandidates() const { return _num_candidates; }
+    void setNumCandidates(int val)
+    {
+        CV_Assert(val >= 0);
+        _num_candidates = val;
+        buildIndex();
+    }
 };
 
 
@@ -129,6 +154,7 @@ void LBPH::load(const FileStorage& fs) {
             _labelsInfo.insert(std::make_pair(item.label, item.value));
         }
     }
+    buildIndex();
 }
 
 // See FaceRecognizer::save.
@@ -146,6 +172,45 @@ void LBPH::save(FileStorage& fs) const {
     fs << "]";
 }
 
+// See FaceRecognizer::saveBinary.
+void LBPH::saveBinary(const String& filename, int depth) const {
+    CV_Assert(depth == -1 || depth == CV_32F || depth == CV_16U || depth == CV_8U);
+    // the quantized histograms are scaled so their largest bin is the largest value of the type
+    double scale = 1;
+    if (depth == CV_16U || depth == CV_8U) {
+        double maxVal = 0;
+        for (size_t i = 0; i < _histograms.size(); i++) {
+            double histMax = 0;
+            minMaxLoc(_histograms[i], 0, &histMax);
+            maxVal = std::max(maxVal, histMax);
+        }
+        if (maxVal > 0)
+            scale = (depth == CV_8U ? UCHAR_MAX : USHRT_MAX) / maxVal;
+    }
+    BinaryModelWriter writer(filename);
+    writer.write("radius", _radius);
+    writer.write("neighbors", _neighbors);
+    writer.write("grid_x", _grid_x);
+    writer.write("grid_y", _grid_y);
+    writer.write("histograms", _histograms, depth, scale);
+    writer.write("labels", _labels);
+    writer.write(_labelsInfo);
+}
+
+// See FaceRecognizer::loadBinary.
+void LBPH::loadBinary(const String& filename) {
+    BinaryModelReader reader(filename);
+    _radius = reader.getInt("radius");
+    _neighbors = reader.getInt("neighbors");
+    _grid_x = reader.getInt("grid_x");
+    _grid_y = reader.getInt("grid_y");
+    // the histograms are compared as floats
+    reader.get("histograms", _histograms, CV_32F);
+    _labels = reader.get("labels");
+    reader.get(_labelsInfo);
+    buildIndex();
+}
+
 void LBPH::train(InputArrayOfArrays _in_src, InputArray _in_labels) {
     this->train(_in_src, _in_labels, false);
 }
@@ -336,6 +401,135 @@ static Mat elbp(InputArray src, int radius, int neighbors) {
     return dst;
 }
 
+//------------------------------------------------------------------------------
+// extended local binary patterns accumulated straight into the spatial histogram
+//------------------------------------------------------------------------------
+
+// Same result as spatial_histogram(elbp(src, radius, neighbors), ...) in a single pass: the codes of
+// each row are computed for all the sample points at once (vectorized) and counted into the cells,
+// without the intermediate lbp image nor a calcHist per cell. The image is converted to float, which
+// is exact for the 8 and 16 bit types, so those and CV_32FC1 are supported.
+static bool elbp_spatial_histogram(const Mat& src, int radius, int neighbors,
+                                   int grid_x, int grid_y, Mat& result)
+{
+    int type = src.type();
+    if (type != CV_8UC1 && type != CV_8SC1 && type != CV_16UC1 && type != CV_16SC1 && type != CV_32FC1)
+        return false;
+    if (neighbors <= 0 || neighbors > 16 || radius <= 0)
+        return false;
+    int rows = src.rows-2*radius, cols = src.cols-2*radius;
+    if (rows <= 0 || cols <= 0 || grid_x <= 0 || grid_y <= 0)
+        return false;
+    // calculate LBP patch size
+    int width = cols/grid_x;
+    int height = rows/grid_y;
+    if (width == 0 || height == 0)
+        return false;
+
+    Mat srcf;
+    src.convertTo(srcf, CV_32F);
+
+    // sample points, interpolation weights and the row offsets of the four neighbours of each one
+    std::vector<int> fx(neighbors), fy(neighbors), cx(neighbors), cy(neighbors);
+    std::vector<float> w1(neighbors), w2(neighbors), w3(neighbors), w4(neighbors);
+    for(int n=0; n<neighbors; n++) {
+        float x = static_cast<float>(radius * cos(2.0*CV_PI*n/static_cast<float>(neighbors)));
+        float y = static_cast<float>(-radius * sin(2.0*CV_PI*n/static_cast<float>(neighbors)));
+        fx[n] = static_cast<int>(floor(x));
+        fy[n] = static_cast<int>(floor(y));
+        cx[n] = static_cast<int>(ceil(x));
+        cy[n] = static_cast<int>(ceil(y));
+        float ty = y - fy[n];
+        float tx = x - fx[n];
+        w1[n] = (1 - tx) * (1 - ty);
+        w2[n] =      tx  * (1 - ty);
+        w3[n] = (1 - tx) *      ty;
+        w4[n] =      tx  *      ty;
+    }
+
+    int numPatterns = 1 << neighbors;
+    int usedCols = width*grid_x;
+    Mat counts = Mat::zeros(grid_x * grid_y, numPatterns, CV_32SC1);
+    std::vector<int> codes(usedCols);
+    const float eps = std::numeric_limits<float>::epsilon();
+
+    for(int i = 0; i < height*grid_y; i++) {
+        std::fill(codes.begin(), codes.end(), 0);
+        const float* center = srcf.ptr<float>(i+radius) + radius;
+        for(int n=0; n<neighbors; n++) {
+            const float* p1 = srcf.ptr<float>(i+radius+fy[n]) + radius + fx[n];
+            const float* p2 = srcf.ptr<float>(i+radius+fy[n]) + radius + cx[n];
+            const float* p3 = srcf.ptr<float>(i+radius+cy[n]) + radius + fx[n];
+            const float* p4 = srcf.ptr<float>(i+radius+cy[n]) + radius + cx[n];
+            int j = 0;
+#if CV_SIMD128
+            v_float32x4 vw1 = v_setall_f32(w1[n]), vw2 = v_setall_f32(w2[n]);
+            v_float32x4 vw3 = v_setall_f32(w3[n]), vw4 = v_setall_f32(w4[n]);
+            v_float32x4 veps = v_setall_f32(eps);
+            v_int32x4 vbit = v_setall_s32(1 << n);
+            for(; j <= usedCols - 4; j += 4) {
+                v_float32x4 t = vw1*v_load(p1+j) + vw2*v_load(p2+j) + vw3*v_load(p3+j) + vw4*v_load(p4+j);
+                v_float32x4 c = v_load(center+j);
+                v_float32x4 mask = (t > c) | (v_abs(t - c) < veps);
+                v_int32x4 code = v_load(&codes[j]) | (v_reinterpret_as_s32(mask) & vbit);
+                v_store(&codes[j], code);
+            }
+#endif
+            for(; j < usedCols; j++) {
+                float t = w1[n]*p1[j] + w2[n]*p2[j] + w3[n]*p3[j] + w4[n]*p4[j];
+                codes[j] += ((t > center[j]) || (std::abs(t-center[j]) < eps)) << n;
+            }
+        }
+        // count the codes into the cells of the row
+        int* cellRow = counts.ptr<int>((i/height)*grid_x);
+        for(int j = 0; j < usedCols; j++)
+            cellRow[(j/width)*numPatterns + codes[j]]++;
+    }
+
+    // normalized histograms as a single feature vector
+    counts.reshape(1,1).convertTo(result, CV_32FC1, 1.0/(width*height));
+    return true;
+}
+
+// spatial histogram of the extended local binary patterns of src
+static Mat lbp_histogram(InputArray _src, int radius, int neighbors, int grid_x, int grid_y) {
+    Mat src = _src.getMat();
+    Mat result;
+    if (elbp_spatial_histogram(src, radius, neighbors, grid_x, grid_y, result))
+        return result;
+    // calculate lbp image
+    Mat lbp_image = elbp(src, radius, neighbors);
+    // get spatial histogram from this lbp image
+    return spatial_histogram(
+            lbp_image, /* lbp_image */
+            static_cast<int>(std::pow(2.0, static_cast<double>(neighbors))), /* number of possible patterns */
+            grid_x, /* grid size x */
+            grid_y, /* grid size y */
+            true /* normed histograms */);
+}
+
+// computes the histograms of a range of training images
+class LBPHTrainInvoker : public ParallelLoopBody
+{
+public:
+    LBPHTrainInvoker(const std::vector<Mat>& _src, std::vector<Mat>& _histograms,
+                     int _radius, int _neighbors, int _grid_x, int _grid_y)
+        : src(_src), histograms(_histograms), radius(_radius), neighbors(_neighbors),
+          grid_x(_grid_x), grid_y(_grid_y) {}
+
+    void operator()(const Range& range) const {
+        for (int i = range.start; i < range.end; i++)
+            histograms[i] = lbp_histogram(src[i], radius, neighbors, grid_x, grid_y);
+    }
+
+private:
+    LBPHTrainInvoker& operator=(const LBPHTrainInvoker&); // to quiet MSVC
+
+    const std::vector<Mat>& src;
+    std::vector<Mat>& histograms;
+    int radius, neighbors, grid_x, grid_y;
+};
+
 void LBPH::train(InputArrayOfArrays _in_src, InputArray _in_labels, bool preserveData) {
     if(_in_src.kind() != _InputArray::STD_VECTOR_MAT && _in_src.kind() != _InputArray::STD_VECTOR_VECTOR) {
         String error_message = "The images are expected as InputArray::STD_VECTOR_MAT (a std::vector<Mat>) or _InputArray::STD_VECTOR_VECTOR (a std::vector< std::vector<...> >).";
@@ -367,20 +561,28 @@ void LBPH::train(InputArrayOfArrays _in_src, InputArray _in_labels, bool preserv
     for(size_t labelIdx = 0; labelIdx < labels.total(); labelIdx++) {
         _labels.push_back(labels.at<int>((int)labelIdx));
     }
-    // store the spatial histograms of the original data
-    for(size_t sampleIdx = 0; sampleIdx < src.size(); sampleIdx++) {
-        // calculate lbp image
-        Mat lbp_image = elbp(src[sampleIdx], _radius, _neighbors);
-        // get spatial histogram from this lbp image
-        Mat p = spatial_histogram(
-                lbp_image, /* lbp_image */
-                static_cast<int>(std::pow(2.0, static_cast<double>(_neighbors))), /* number of possible patterns */
-                _grid_x, /* grid size x */
-                _grid_y, /* grid size y */
-                true);
-        // add to templates
-        _histograms.push_back(p);
+    // store the spatial histograms of the original data, the images are processed in parallel
+    std::vector<Mat> histograms(src.size());
+    parallel_for_(Range(0, (int)src.size()),
+                  LBPHTrainInvoker(src, histograms, _radius, _neighbors, _grid_x, _grid_y));
+    // add to templates
+    _histograms.insert(_histograms.end(), histograms.begin(), histograms.end());
+    // index the histograms for the prediction
+    buildIndex();
+}
+
+void LBPH::buildIndex() {
+    if (_num_candidates == 0 || _histograms.empty()) {
+        _index.release();
+        return;
+    }
+    Mat samples((int)_histograms.size(), (int)_histograms[0].total(), CV_32FC1);
+    for (int i = 0; i < samples.rows; i++) {
+        Mat row = samples.row(i);
+        _histograms[i].reshape(1, 1).convertTo(row, CV_32F);
     }
+    sqrt(samples, samples);
+    _index.build(samples);
 }
 
 void LBPH::predict(InputArray _src, Ptr<PredictCollector> collector) const {
@@ -391,13 +593,21 @@ void LBPH::predict(InputArray _src, Ptr<PredictCollector> collector) const {
     }
     Mat src = _src.getMat();
     // get the spatial histogram from input image
-    Mat lbp_image = elbp(src, _radius, _neighbors);
-    Mat query = spatial_histogram(
-            lbp_image, /* lbp_image */
-            static_cast<int>(std::pow(2.0, static_cast<double>(_neighbors))), /* number of possible patterns */
-            _grid_x, /* grid size x */
-            _grid_y, /* grid size y */
-            true /* normed histograms */);
+    Mat query = lbp_histogram(src, _radius, _neighbors, _grid_x, _grid_y);
+    if (!_index.empty()) {
+        // find the candidates with the index and rank them with the chi-square distance
+        Mat sqrt_query;
+        sqrt(query, sqrt_query);
+        std::vector<int> candidates;
+        _index.search(sqrt_query, _num_candidates, candidates);
+        collector->init(candidates.size());
+        for (size_t i = 0; i < candidates.size(); i++) {
+            double dist = compareHist(_histograms[candidates[i]], query, HISTCMP_CHISQR_ALT);
+            int label = _labels.at<int>(candidates[i]);
+            if (!collector->collect(label, dist))return;
+        }
+        return;
+    }
     // find 1-nearest neighbor
     collector->init((int)_histograms.size());
     for (size_t sampleIdx = 0; sampleIdx < _histograms.size(); sampleIdx++) {
@@ -41,7 +41,9 @@ and on any theory of liability, whether in contract, strict liability,
 or tort (including negligence or otherwise) arising in any way out of
 the use of this software, even if advised of the possibility of such damage.
 */
+#include "precomp.hpp"
 #include "opencv2/face/predict_collector.hpp"
+#include <algorithm>
 
 namespace cv {namespace face {
 
@@ -49,6 +51,11 @@ static std::pair<int, double> toPair(const StandardCollector::PredictResult & va
     return std::make_pair(val.label, val.distance);
 }
 
+// orders the results of TopKCollector as a max-heap of the distances
+static bool resultLess(const StandardCollector::PredictResult & lhs, const StandardCollector::PredictResult & rhs) {
+    return lhs.distance < rhs.distance;
+}
+
 static bool pairLess(const std::pair<int, double> & lhs, const std::pair<int, double> & rhs) {
     return lhs.second < rhs.second;
 }
@@ -111,4 +118,43 @@ Ptr<StandardCollector> StandardCollector::create(double threshold) {
     return makePtr<StandardCollector>(threshold);
 }
 
+//===================================
+
+TopKCollector::TopKCollector(int k_, double threshold_) : StandardCollector(threshold_) {
+    CV_Assert(k_ > 0);
+    k = (size_t)k_;
+}
+
+void TopKCollector::init(size_t size) {
+    minRes = PredictResult();
+    data.clear();
+    data.reserve(std::min(size, k));
+}
+
+bool TopKCollector::collect(int label, double dist) {
+    if (dist < threshold)
+    {
+        PredictResult res(label, dist);
+        if (res.distance < minRes.distance)
+            minRes = res;
+        if (data.size() < k)
+        {
+            data.push_back(res);
+            std::push_heap(data.begin(), data.end(), &resultLess);
+        }
+        else if (res.distance < data.front().distance)
+        {
+            // replace the farthest of the kept results
+            std::pop_heap(data.begin(), data.end(), &resultLess);
+            data.back() = res;
+            std::push_heap(data.begin(), data.end(), &resultLess);
+        }
+    }
+    return true;
+}
+
+Ptr<TopKCollector> TopKCollector::create(int k, double threshold) {
+    return makePtr<TopKCollector>(k, threshold);
+}
+
 }} // cv::face::
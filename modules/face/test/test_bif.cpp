@@ -65,3 +65,38 @@ TEST(CV_Face_BIF, can_compute) {
     EXPECT_NO_THROW(bif->compute(image, fea));
     EXPECT_EQ(cv::Size(1, 13188), fea.size());
 }
+
+TEST(CV_Face_BIF, first_unit_matches_filter2D) {
+    cv::Mat image(50, 70, CV_32F);
+    cv::theRNG().fill(image, cv::RNG::UNIFORM, -1, 1);
+
+    cv::Ptr<cv::face::BIF> bif = cv::face::createBIF(1, 1);
+    cv::Mat fea;
+    bif->compute(image, fea);
+
+    // the first band without rotation, computed with filter2D
+    cv::Mat kernel1 = cv::getGaborKernel(cv::Size(5,5), 2.0, 0, 2.5, 0.3, 0, CV_32F) / (2 * 2.0 * 2.0 / 0.3);
+    cv::Mat kernel2 = cv::getGaborKernel(cv::Size(7,7), 2.8, 0, 3.5, 0.3, 0, CV_32F) / (2 * 2.8 * 2.8 / 0.3);
+    cv::Mat resp1, resp2, resp;
+    cv::filter2D(image, resp1, CV_32F, kernel1);
+    cv::filter2D(image, resp2, CV_32F, kernel2);
+    cv::max(resp1, resp2, resp);
+
+    int pos = 0;
+    for (int yc = 0; yc < resp.rows; yc += 3) {
+        for (int xc = 0; xc < resp.cols; xc += 3, ++pos) {
+            cv::Mat cell = resp(cv::Range(std::max(0, yc - 3), std::min(resp.rows, yc + 3)),
+                                cv::Range(std::max(0, xc - 3), std::min(resp.cols, xc + 3)));
+            cv::Scalar mean, sd;
+            cv::meanStdDev(cell, mean, sd);
+            ASSERT_LT(pos, fea.rows);
+            EXPECT_NEAR(sd[0], fea.at<float>(pos), 1e-4);
+        }
+    }
+    EXPECT_EQ(pos, fea.rows);
+
+    // the cached filter bank gives the same features
+    cv::Mat fea2;
+    bif->compute(image, fea2);
+    EXPECT_EQ(0, cv::norm(fea, fea2, cv::NORM_INF));
+}
@@ -0,0 +1,287 @@
+/*
+By downloading, copying, installing or using the software you agree to this
+license. If you do not agree to this license, do not download, install,
+copy or use the software.
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are
+disclaimed. In no event shall copyright holders or contributors be liable for
+any direct, indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace cv::face;
+
+static void makeGallery(int num_samples, int first_label, std::vector<Mat>& images, Mat& labels)
+{
+    RNG rng(0x1234 + first_label);
+    images.clear();
+    labels.create(num_samples, 1, CV_32SC1);
+    for (int i = 0; i < num_samples; i++)
+    {
+        Mat image(24, 24, CV_8UC1);
+        rng.fill(image, RNG::UNIFORM, 0, 256);
+        images.push_back(image);
+        labels.at<int>(i) = first_label + i;
+    }
+}
+
+// the training samples must be found among the candidates reported by the index
+static void checkCandidates(Ptr<FaceRecognizer> model, const std::vector<Mat>& images, const Mat& labels, int num_candidates)
+{
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        Ptr<StandardCollector> collector = StandardCollector::create();
+        model->predict(images[i], collector);
+        EXPECT_EQ(labels.at<int>((int)i), collector->getMinLabel());
+        EXPECT_LE((int)collector->getResults().size(), num_candidates);
+    }
+}
+
+TEST(CV_Face_Eigenfaces, indexed_predict)
+{
+    std::vector<Mat> images;
+    Mat labels;
+    makeGallery(64, 0, images, labels);
+
+    Ptr<BasicFaceRecognizer> model = createEigenFaceRecognizer(16);
+    model->train(images, labels);
+    model->setNumCandidates(5);
+    checkCandidates(model, images, labels, 5);
+
+    // the exhaustive search reports all the samples
+    model->setNumCandidates(0);
+    Ptr<StandardCollector> collector = StandardCollector::create();
+    model->predict(images[0], collector);
+    EXPECT_EQ(images.size(), collector->getResults().size());
+}
+
+TEST(CV_Face_LBPH, indexed_predict)
+{
+    std::vector<Mat> images;
+    Mat labels;
+    makeGallery(64, 0, images, labels);
+
+    Ptr<LBPHFaceRecognizer> model = createLBPHFaceRecognizer(1, 8, 4, 4);
+    model->setNumCandidates(5);
+    model->train(images, labels);
+    checkCandidates(model, images, labels, 5);
+
+    // the updated samples are indexed too
+    std::vector<Mat> more_images;
+    Mat more_labels;
+    makeGallery(8, 64, more_images, more_labels);
+    model->update(more_images, more_labels);
+    checkCandidates(model, more_images, more_labels, 5);
+}
+
+TEST(CV_Face_LBPH, fused_histogram_matches_lbp_image)
+{
+    std::vector<Mat> images;
+    Mat labels;
+    makeGallery(4, 0, images, labels);
+
+    // CV_32SC1 images go through the lbp image and a histogram per cell, CV_8UC1 ones through the fused kernel
+    std::vector<Mat> images32s(images.size());
+    for (size_t i = 0; i < images.size(); i++)
+        images[i].convertTo(images32s[i], CV_32S);
+
+    const int params[][2] = { {1, 8}, {2, 8}, {3, 12} };
+    for (int k = 0; k < 3; k++)
+    {
+        Ptr<LBPHFaceRecognizer> fused = createLBPHFaceRecognizer(params[k][0], params[k][1], 3, 3);
+        Ptr<LBPHFaceRecognizer> reference = createLBPHFaceRecognizer(params[k][0], params[k][1], 3, 3);
+        fused->train(images, labels);
+        reference->train(images32s, labels);
+        std::vector<Mat> h1 = fused->getHistograms(), h2 = reference->getHistograms();
+        ASSERT_EQ(h1.size(), h2.size());
+        for (size_t i = 0; i < h1.size(); i++)
+            EXPECT_LE(norm(h1[i], h2[i], NORM_INF), 1e-6);
+    }
+}
+
+TEST(CV_Face_Eigenfaces, incremental_update)
+{
+    std::vector<Mat> images;
+    Mat labels;
+    makeGallery(30, 0, images, labels);
+
+    Ptr<BasicFaceRecognizer> batch = createEigenFaceRecognizer();
+    batch->train(images, labels);
+
+    Ptr<BasicFaceRecognizer> incremental = createEigenFaceRecognizer();
+    std::vector<Mat> first(images.begin(), images.begin() + 20), second(images.begin() + 20, images.end());
+    incremental->train(first, labels.rowRange(0, 20));
+    incremental->update(second, labels.rowRange(20, 30));
+
+    // all the components are kept, so the merged eigenspace is the one of all the images
+    EXPECT_LE(norm(batch->getMean(), incremental->getMean(), NORM_INF), 1e-9);
+    Mat e1 = batch->getEigenValues(), e2 = incremental->getEigenValues();
+    ASSERT_GE(e2.total(), (size_t)29);
+    for (int i = 0; i < 29; i++)
+        EXPECT_NEAR(e1.at<double>(i), e2.at<double>(i), 1e-6 * e1.at<double>(0));
+
+    // and the distances between the images are preserved
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        Ptr<StandardCollector> c1 = StandardCollector::create(), c2 = StandardCollector::create();
+        batch->predict(images[i], c1);
+        incremental->predict(images[i], c2);
+        std::map<int, double> r1 = c1->getResultsMap(), r2 = c2->getResultsMap();
+        ASSERT_EQ(r1.size(), r2.size());
+        for (std::map<int, double>::const_iterator it = r1.begin(); it != r1.end(); ++it)
+            EXPECT_NEAR(it->second, r2[it->first], 1e-6 * (1 + it->second));
+        EXPECT_EQ(labels.at<int>((int)i), c2->getMinLabel());
+    }
+}
+
+TEST(CV_Face_LBPH, binary_model)
+{
+    std::vector<Mat> images;
+    Mat labels;
+    makeGallery(16, 0, images, labels);
+
+    Ptr<LBPHFaceRecognizer> model = createLBPHFaceRecognizer();
+    model->train(images, labels);
+    model->setLabelInfo(3, "three");
+
+    String filename = tempfile(".bin");
+    int depths[] = { -1, CV_16U, CV_8U };
+    for (int d = 0; d < 3; d++)
+    {
+        model->saveBinary(filename, depths[d]);
+        Ptr<LBPHFaceRecognizer> loaded = createLBPHFaceRecognizer(2, 4, 4, 4);
+        loaded->loadBinary(filename);
+        EXPECT_EQ(model->getRadius(), loaded->getRadius());
+        EXPECT_EQ(model->getNeighbors(), loaded->getNeighbors());
+        EXPECT_EQ(model->getGridX(), loaded->getGridX());
+        EXPECT_EQ(model->getGridY(), loaded->getGridY());
+        EXPECT_EQ("three", loaded->getLabelInfo(3));
+        EXPECT_EQ(0, norm(model->getLabels(), loaded->getLabels(), NORM_INF));
+
+        // the quantization error is at most half a step of the largest bin
+        std::vector<Mat> h1 = model->getHistograms(), h2 = loaded->getHistograms();
+        ASSERT_EQ(h1.size(), h2.size());
+        double maxVal = 0;
+        for (size_t i = 0; i < h1.size(); i++)
+        {
+            double histMax = 0;
+            minMaxLoc(h1[i], 0, &histMax);
+            maxVal = std::max(maxVal, histMax);
+        }
+        double eps = depths[d] == CV_8U ? maxVal / 255 : depths[d] == CV_16U ? maxVal / 65535 : 0;
+        for (size_t i = 0; i < h1.size(); i++)
+            EXPECT_LE(norm(h1[i], h2[i], NORM_INF), eps);
+        for (size_t i = 0; i < images.size(); i++)
+            EXPECT_EQ(labels.at<int>((int)i), loaded->predict(images[i]));
+    }
+    remove(filename.c_str());
+}
+
+TEST(CV_Face_Eigenfaces, binary_model)
+{
+    std::vector<Mat> images;
+    Mat labels;
+    makeGallery(16, 0, images, labels);
+
+    Ptr<BasicFaceRecognizer> model = createEigenFaceRecognizer(10);
+    model->train(images, labels);
+
+    String filename = tempfile(".bin");
+    model->saveBinary(filename);
+    Ptr<BasicFaceRecognizer> loaded = createEigenFaceRecognizer();
+    loaded->loadBinary(filename);
+    remove(filename.c_str());
+
+    EXPECT_EQ(model->getNumComponents(), loaded->getNumComponents());
+    EXPECT_EQ(0, norm(model->getMean(), loaded->getMean(), NORM_INF));
+    EXPECT_EQ(0, norm(model->getEigenVectors(), loaded->getEigenVectors(), NORM_INF));
+    std::vector<Mat> p1 = model->getProjections(), p2 = loaded->getProjections();
+    ASSERT_EQ(p1.size(), p2.size());
+    for (size_t i = 0; i < p1.size(); i++)
+        EXPECT_EQ(0, norm(p1[i], p2[i], NORM_INF));
+    for (size_t i = 0; i < images.size(); i++)
+        EXPECT_EQ(labels.at<int>((int)i), loaded->predict(images[i]));
+}
+
+// the batch predictions must be the ones of the samples predicted one by one
+static void checkBatchPredict(Ptr<FaceRecognizer> model, const std::vector<Mat>& images, int k)
+{
+    std::vector<Ptr<PredictCollector> > collectors;
+    for (size_t i = 0; i < images.size(); i++)
+        collectors.push_back(TopKCollector::create(k));
+    model->predictBatch(images, collectors);
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        Ptr<StandardCollector> single = StandardCollector::create();
+        model->predict(images[i], single);
+        std::vector< std::pair<int, double> > expected = single->getResults(true);
+        std::vector< std::pair<int, double> > results = collectors[i].dynamicCast<TopKCollector>()->getResults(true);
+        ASSERT_EQ((size_t)k, results.size());
+        for (int j = 0; j < k; j++)
+        {
+            EXPECT_EQ(expected[j].first, results[j].first);
+            EXPECT_NEAR(expected[j].second, results[j].second, 1e-6 * (1 + expected[j].second));
+        }
+    }
+}
+
+TEST(CV_Face_Eigenfaces, batch_predict)
+{
+    std::vector<Mat> images, queries;
+    Mat labels, query_labels;
+    makeGallery(32, 0, images, labels);
+    makeGallery(8, 32, queries, query_labels);
+
+    Ptr<BasicFaceRecognizer> model = createEigenFaceRecognizer();
+    model->train(images, labels);
+    checkBatchPredict(model, images, 3);
+    checkBatchPredict(model, queries, 3);
+
+    // without collectors, the minimal label of every sample is collected
+    std::vector<Ptr<PredictCollector> > collectors;
+    model->predictBatch(images, collectors);
+    ASSERT_EQ(images.size(), collectors.size());
+    for (size_t i = 0; i < images.size(); i++)
+        EXPECT_EQ(labels.at<int>((int)i), collectors[i].dynamicCast<StandardCollector>()->getMinLabel());
+}
+
+TEST(CV_Face_LBPH, batch_predict)
+{
+    std::vector<Mat> images;
+    Mat labels;
+    makeGallery(16, 0, images, labels);
+
+    Ptr<LBPHFaceRecognizer> model = createLBPHFaceRecognizer();
+    model->train(images, labels);
+    checkBatchPredict(model, images, 4);
+}
@@ -100,6 +100,19 @@ namespace ft
     */
     CV_EXPORTS void FT02D_process(const Mat &image, const Mat &kernel, Mat &output, const Mat &mask);
 
+    /** @brief Computes F0-transfrom and inverse F0-transfrom at once, by tiles.
+    @param image Input image.
+    @param kernel Kernel used for processing. Function **createKernel** can be used.
+    @param output Output 32-bit array.
+    @param mask Mask used for unwanted area marking, or an empty Mat when no area is marked.
+    @param tileSize Size of the tiles of the output.
+
+    The tiles of the output are computed independently and in parallel, each one from the part of the image read by the components that cover it,
+    so that the working memory depends on the size of the tiles and not on the size of the image. The output is the same as the one of **FT02D_process**
+    on the whole image.
+    */
+    CV_EXPORTS void FT02D_process(const Mat &image, const Mat &kernel, Mat &output, const Mat &mask, Size tileSize);
+
     /** @brief Computes F0-transfrom and inverse F0-transfrom at once and return state.
     @param image Input image.
     @param kernel Kernel used for processing. Function **createKernel** can be used.
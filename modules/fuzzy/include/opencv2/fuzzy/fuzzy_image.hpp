@@ -93,6 +93,20 @@ namespace ft
     */
     CV_EXPORTS void inpaint(const cv::Mat &image, const cv::Mat &mask, cv::Mat &output, int radius = 2, int function = ft::LINEAR, int algorithm = ft::ONE_STEP);
 
+    /** @brief Image inpainting by tiles
+    @param image Input image.
+    @param mask Mask used for unwanted area marking.
+    @param output Output 32-bit image.
+    @param radius Radius of the basic function.
+    @param function Function type could be one of the following:
+        -   **LINEAR** Linear basic function.
+    @param algorithm Algorithm, only **ONE_STEP** can be computed by tiles.
+    @param tileSize Size of the tiles of the output.
+
+    The same as **inpaint**, with the F-transform computed by **FT02D_process** with tiles.
+    */
+    CV_EXPORTS void inpaint(const cv::Mat &image, const cv::Mat &mask, cv::Mat &output, int radius, int function, int algorithm, cv::Size tileSize);
+
     /** @brief Image filtering
     @param image Input image.
     @param kernel Final 32-b kernel.
@@ -102,6 +116,16 @@ namespace ft
     */
     CV_EXPORTS void filter(const cv::Mat &image, const cv::Mat &kernel, cv::Mat &output);
 
+    /** @brief Image filtering by tiles
+    @param image Input image.
+    @param kernel Final 32-b kernel.
+    @param output Output 32-bit image.
+    @param tileSize Size of the tiles of the output.
+
+    The same as **filter**, with the F-transform computed by **FT02D_process** with tiles.
+    */
+    CV_EXPORTS void filter(const cv::Mat &image, const cv::Mat &kernel, cv::Mat &output, cv::Size tileSize);
+
     //! @}
 }
 }
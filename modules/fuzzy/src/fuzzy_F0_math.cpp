@@ -43,6 +43,387 @@
 
 using namespace cv;
 
+namespace
+{
+
+// The kernel of the F-transform in double precision, with its column and row factors for each channel when it is
+// separable, as the kernels of createKernel are
+struct FTKernel
+{
+    Mat weights;
+    Mat colFactor;
+    Mat rowFactor;
+    bool separable;
+    int radiusX;
+    int radiusY;
+};
+
+void prepareKernel(const Mat &kernel, FTKernel &k)
+{
+    int cn = kernel.channels();
+
+    kernel.convertTo(k.weights, CV_64F);
+    k.radiusX = (kernel.cols - 1) / 2;
+    k.radiusY = (kernel.rows - 1) / 2;
+    k.colFactor.create(kernel.rows, 1, CV_64FC(cn));
+    k.rowFactor.create(1, kernel.cols, CV_64FC(cn));
+    k.separable = true;
+
+    CV_Assert(k.radiusX > 0 && k.radiusY > 0);
+
+    for (int c = 0; c < cn; c++)
+    {
+        // The kernel is the product of its column and its row through its largest element
+        int r0 = 0, c0 = 0;
+        double maxAbs = 0;
+
+        for (int y = 0; y < kernel.rows; y++)
+        {
+            for (int x = 0; x < kernel.cols; x++)
+            {
+                double v = std::abs(k.weights.ptr<double>(y)[x * cn + c]);
+
+                if (v > maxAbs)
+                {
+                    maxAbs = v;
+                    r0 = y;
+                    c0 = x;
+                }
+            }
+        }
+
+        double pivot = k.weights.ptr<double>(r0)[c0 * cn + c];
+
+        for (int y = 0; y < kernel.rows; y++)
+        {
+            k.colFactor.ptr<double>(y)[c] = k.weights.ptr<double>(y)[c0 * cn + c];
+        }
+        for (int x = 0; x < kernel.cols; x++)
+        {
+            k.rowFactor.ptr<double>(0)[x * cn + c] = maxAbs > 0 ? k.weights.ptr<double>(r0)[x * cn + c] / pivot : 0;
+        }
+
+        for (int y = 0; y < kernel.rows && k.separable; y++)
+        {
+            for (int x = 0; x < kernel.cols; x++)
+            {
+                double product = k.colFactor.ptr<double>(y)[c] * k.rowFactor.ptr<double>(0)[x * cn + c];
+
+                if (std::abs(k.weights.ptr<double>(y)[x * cn + c] - product) > 1e-6 * maxAbs)
+                {
+                    k.separable = false;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+// The range of the components of a grid axis with step radius whose windows of size ksize contain the coordinate
+inline Range componentsCovering(int coordinate, int radius, int ksize, int count)
+{
+    // the window of the component n covers [n * radius - radius, n * radius - radius + ksize)
+    int first = coordinate + radius - ksize + 1;
+    first = first > 0 ? (first + radius - 1) / radius : 0;
+    int last = std::min((coordinate + radius) / radius + 1, count);
+
+    return Range(first, std::max(first, last));
+}
+
+// The range of an axis of the image read by the components that cover [start, end) of the axis, starting on
+// the grid of the components so that they keep their positions in a tile of the image
+inline Range tileInputRange(int start, int end, int radius, int ksize, int size)
+{
+    int count = size / radius + 1;
+    int first = componentsCovering(start, radius, ksize, count).start;
+    int last = componentsCovering(end - 1, radius, ksize, count).end;
+
+    return Range(std::max(first - 1, 0) * radius, std::min((last - 2) * radius + ksize, size));
+}
+
+// The sums of image * kernel * mask and kernel * mask over the window of each component, stored
+// at (o * An + i) * cn + c, with the mask of one channel or of the channels of the image
+class ComponentSumsInvoker : public ParallelLoopBody
+{
+public:
+    ComponentSumsInvoker(const Mat &_image, const Mat &_mask, const FTKernel &_kernel, int _An,
+                         const std::vector<double> &_rowSums, std::vector<double> &_numerators, std::vector<double> &_denominators) :
+        image(_image), mask(_mask), kernel(_kernel), An(_An), rowSums(_rowSums), numerators(_numerators), denominators(_denominators)
+    {
+    }
+
+    void operator()(const Range &range) const
+    {
+        int cn = image.channels();
+        int kh = kernel.weights.rows;
+
+        for (int o = range.start; o < range.end; o++)
+        {
+            int top = o * kernel.radiusY - kernel.radiusY;
+            int y0 = std::max(top, 0), y1 = std::min(top + kh, image.rows);
+
+            for (int i = 0; i < An; i++)
+            {
+                for (int c = 0; c < cn; c++)
+                {
+                    double numerator = 0, denominator = 0;
+
+                    if (kernel.separable)
+                    {
+                        // the column pass over the row sums of the component
+                        for (int y = y0; y < y1; y++)
+                        {
+                            double a = kernel.colFactor.ptr<double>(y - top)[c];
+                            const double *sums = &rowSums[((size_t)(y * An + i) * cn + c) * 2];
+
+                            numerator += a * sums[0];
+                            denominator += a * sums[1];
+                        }
+                    }
+                    else
+                    {
+                        int left = i * kernel.radiusX - kernel.radiusX;
+                        int x0 = std::max(left, 0), x1 = std::min(left + kernel.weights.cols, image.cols);
+
+                        for (int y = y0; y < y1; y++)
+                        {
+                            const float *pixels = image.ptr<float>(y);
+                            const uchar *masks = mask.ptr<uchar>(y);
+                            const double *weights = kernel.weights.ptr<double>(y - top);
+
+                            for (int x = x0; x < x1; x++)
+                            {
+                                if (masks[mask.channels() == 1 ? x : x * cn + c])
+                                {
+                                    double w = weights[(x - left) * cn + c];
+
+                                    numerator += w * pixels[x * cn + c];
+                                    denominator += w;
+                                }
+                            }
+                        }
+                    }
+
+                    numerators[(size_t)(o * An + i) * cn + c] = numerator;
+                    denominators[(size_t)(o * An + i) * cn + c] = denominator;
+                }
+            }
+        }
+    }
+
+private:
+    const Mat &image;
+    const Mat &mask;
+    const FTKernel &kernel;
+    int An;
+    const std::vector<double> &rowSums;
+    std::vector<double> &numerators;
+    std::vector<double> &denominators;
+
+    ComponentSumsInvoker& operator=(const ComponentSumsInvoker&); // to quiet MSVC
+};
+
+// The row pass of a separable kernel: the sums of image * row factor * mask and row factor * mask
+// over the columns of the window of each component, for every row of the image
+class ComponentRowSumsInvoker : public ParallelLoopBody
+{
+public:
+    ComponentRowSumsInvoker(const Mat &_image, const Mat &_mask, const FTKernel &_kernel, int _An, std::vector<double> &_rowSums) :
+        image(_image), mask(_mask), kernel(_kernel), An(_An), rowSums(_rowSums)
+    {
+    }
+
+    void operator()(const Range &range) const
+    {
+        int cn = image.channels();
+        bool maskPerChannel = mask.channels() != 1;
+        const double *b = kernel.rowFactor.ptr<double>(0);
+
+        for (int y = range.start; y < range.end; y++)
+        {
+            const float *pixels = image.ptr<float>(y);
+            const uchar *masks = mask.ptr<uchar>(y);
+
+            for (int i = 0; i < An; i++)
+            {
+                int left = i * kernel.radiusX - kernel.radiusX;
+                int x0 = std::max(left, 0), x1 = std::min(left + kernel.weights.cols, image.cols);
+                double *sums = &rowSums[(size_t)(y * An + i) * cn * 2];
+
+                for (int c = 0; c < cn; c++)
+                {
+                    double numerator = 0, denominator = 0;
+
+                    for (int x = x0; x < x1; x++)
+                    {
+                        if (masks[maskPerChannel ? x * cn + c : x])
+                        {
+                            double w = b[(x - left) * cn + c];
+
+                            numerator += w * pixels[x * cn + c];
+                            denominator += w;
+                        }
+                    }
+
+                    sums[c * 2] = numerator;
+                    sums[c * 2 + 1] = denominator;
+                }
+            }
+        }
+    }
+
+private:
+    const Mat &image;
+    const Mat &mask;
+    const FTKernel &kernel;
+    int An;
+    std::vector<double> &rowSums;
+
+    ComponentRowSumsInvoker& operator=(const ComponentRowSumsInvoker&); // to quiet MSVC
+};
+
+// The inverse F-transform of the Bn x An components of the channels of the kernel, in rows of the output
+class InverseFTInvoker : public ParallelLoopBody
+{
+public:
+    InverseFTInvoker(const std::vector<float> &_components, int _An, int _Bn, const FTKernel &_kernel, Mat &_output) :
+        components(_components), An(_An), Bn(_Bn), kernel(_kernel), output(_output)
+    {
+    }
+
+    void operator()(const Range &range) const
+    {
+        int cn = output.channels();
+        int kw = kernel.weights.cols, kh = kernel.weights.rows;
+        int len = output.cols * cn;
+        AutoBuffer<double> _acc(len);
+        double *acc = _acc;
+
+        for (int y = range.start; y < range.end; y++)
+        {
+            for (int k = 0; k < len; k++)
+            {
+                acc[k] = 0;
+            }
+
+            Range rows = componentsCovering(y, kernel.radiusY, kh, Bn);
+
+            for (int o = rows.start; o < rows.end; o++)
+            {
+                const double *weights = kernel.weights.ptr<double>(y - (o * kernel.radiusY - kernel.radiusY));
+
+                for (int i = 0; i < An; i++)
+                {
+                    int left = i * kernel.radiusX - kernel.radiusX;
+                    int x0 = std::max(left, 0), x1 = std::min(left + kw, output.cols);
+                    const float *component = &components[(size_t)(o * An + i) * cn];
+
+                    for (int x = x0; x < x1; x++)
+                    {
+                        for (int c = 0; c < cn; c++)
+                        {
+                            acc[x * cn + c] += component[c] * weights[(x - left) * cn + c];
+                        }
+                    }
+                }
+            }
+
+            float *dst = output.ptr<float>(y);
+
+            for (int k = 0; k < len; k++)
+            {
+                dst[k] = (float)acc[k];
+            }
+        }
+    }
+
+private:
+    const std::vector<float> &components;
+    int An;
+    int Bn;
+    const FTKernel &kernel;
+    Mat &output;
+
+    InverseFTInvoker& operator=(const InverseFTInvoker&); // to quiet MSVC
+};
+
+// FT02D_process of the output tiles of the image, each one from the part of the image under its components
+class TiledProcessInvoker : public ParallelLoopBody
+{
+public:
+    TiledProcessInvoker(const Mat &_image, const Mat &_kernel, const Mat &_mask, Size _tileSize, Mat &_output) :
+        image(_image), kernel(_kernel), mask(_mask), tileSize(_tileSize), output(_output)
+    {
+    }
+
+    void operator()(const Range &range) const
+    {
+        int tilesX = (image.cols + tileSize.width - 1) / tileSize.width;
+        int radiusX = (kernel.cols - 1) / 2;
+        int radiusY = (kernel.rows - 1) / 2;
+
+        for (int t = range.start; t < range.end; t++)
+        {
+            Rect tile = Rect(Point((t % tilesX) * tileSize.width, (t / tilesX) * tileSize.height), tileSize) & Rect(0, 0, image.cols, image.rows);
+            Range rows = tileInputRange(tile.y, tile.y + tile.height, radiusY, kernel.rows, image.rows);
+            Range cols = tileInputRange(tile.x, tile.x + tile.width, radiusX, kernel.cols, image.cols);
+
+            Mat tileMask = mask.empty() ? Mat(rows.size(), cols.size(), CV_8U, Scalar(1)) : mask(rows, cols);
+            Mat tileOutput;
+
+            ft::FT02D_process(image(rows, cols), kernel, tileOutput, tileMask);
+            tileOutput(Rect(tile.x - cols.start, tile.y - rows.start, tile.width, tile.height)).copyTo(output(tile));
+        }
+    }
+
+private:
+    const Mat &image;
+    const Mat &kernel;
+    const Mat &mask;
+    Size tileSize;
+    Mat &output;
+
+    TiledProcessInvoker& operator=(const TiledProcessInvoker&); // to quiet MSVC
+};
+
+// Computes the numerators and the denominators of the components of the image in the workspace
+void computeComponentSums(const Mat &image, const Mat &mask, const FTKernel &kernel, int An, int Bn, ft::FTWorkspace &workspace)
+{
+    CV_Assert(mask.type() == CV_8UC1 || mask.type() == CV_8UC(image.channels()));
+    CV_Assert(mask.size() == image.size());
+
+    const Mat *input = &image;
+    Mat image32F;
+
+    if (image.depth() != CV_32F)
+    {
+        image.convertTo(image32F, CV_32F);
+        input = &image32F;
+    }
+
+    size_t count = (size_t)An * Bn * image.channels();
+
+    workspace.numerators.resize(count);
+    workspace.denominators.resize(count);
+
+    if (kernel.separable)
+    {
+        workspace.rowSums.resize((size_t)image.rows * An * image.channels() * 2);
+        parallel_for_(Range(0, image.rows), ComponentRowSumsInvoker(*input, mask, kernel, An, workspace.rowSums));
+    }
+
+    parallel_for_(Range(0, Bn), ComponentSumsInvoker(*input, mask, kernel, An, workspace.rowSums,
+                                                     workspace.numerators, workspace.denominators));
+}
+
+void computeInverseFT(const FTKernel &kernel, int An, int Bn, int width, int height, ft::FTWorkspace &workspace, Mat &output)
+{
+    output.create(height, width, CV_MAKETYPE(CV_32F, kernel.weights.channels()));
+    parallel_for_(Range(0, height), InverseFTInvoker(workspace.components, An, Bn, kernel, output));
+}
+
+}
+
 void ft::FT02D_components(InputArray matrix, InputArray kernel, OutputArray components, InputArray mask)
 {
     Mat matrixMat = matrix.getMat();
@@ -51,38 +432,23 @@ void ft::FT02D_components(InputArray matrix, InputArray kernel, OutputArray comp
 
     CV_Assert(matrixMat.channels() == 1 && kernelMat.channels() == 1 && maskMat.channels() == 1);
 
-    int radiusX = (kernelMat.cols - 1) / 2;
-    int radiusY = (kernelMat.rows - 1) / 2;
-    int An = matrixMat.cols / radiusX + 1;
-    int Bn = matrixMat.rows / radiusY + 1;
+    FTKernel k;
+    prepareKernel(kernelMat, k);
 
-    Mat matrixPadded;
-    Mat maskPadded;
+    int An = matrixMat.cols / k.radiusX + 1;
+    int Bn = matrixMat.rows / k.radiusY + 1;
 
-    copyMakeBorder(matrixMat, matrixPadded, radiusY, kernelMat.rows, radiusX, kernelMat.cols, BORDER_CONSTANT, Scalar(0));
-    copyMakeBorder(maskMat, maskPadded, radiusY, kernelMat.rows, radiusX, kernelMat.cols, BORDER_CONSTANT, Scalar(0));
+    FTWorkspace workspace;
+    computeComponentSums(matrixMat, maskMat, k, An, Bn, workspace);
 
     components.create(Bn, An, CV_32F);
     Mat componentsMat = components.getMat();
 
-    for (int i = 0; i < An; i++)
+    for (int o = 0; o < Bn; o++)
     {
-        for (int o = 0; o < Bn; o++)
+        for (int i = 0; i < An; i++)
         {
-            int centerX = (i * radiusX) + radiusX;
-            int centerY = (o * radiusY) + radiusY;
-            Rect area(centerX - radiusX, centerY - radiusY, kernelMat.cols, kernelMat.rows);
-
-            Mat roiImage(matrixPadded, area);
-            Mat roiMask(maskPadded, area);
-            Mat kernelMasked;
-
-            kernelMat.copyTo(kernelMasked, roiMask);
-
-            Mat numerator;
-            multiply(roiImage, kernelMasked, numerator, 1, CV_32F);
-
-            componentsMat.row(o).col(i) = sum(numerator) / sum(kernelMasked);
+            componentsMat.at<float>(o, i) = (float)(workspace.numerators[o * An + i] / workspace.denominators[o * An + i]);
         }
     }
 }
@@ -101,154 +467,136 @@ void ft::FT02D_inverseFT(InputArray components, InputArray kernel, OutputArray o
 
     CV_Assert(componentsMat.channels() == 1 && kernelMat.channels() == 1);
 
-    int radiusX = (kernelMat.cols - 1) / 2;
-    int radiusY = (kernelMat.rows - 1) / 2;
-    int paddedOutputWidth = radiusX + width + kernelMat.cols;
-    int paddedOutputHeight = radiusY + height + kernelMat.rows;
-
-    output.create(height, width, CV_32F);
-
-    Mat outputZeroes(paddedOutputHeight, paddedOutputWidth, CV_32F, Scalar(0));
-
-    for (int i = 0; i < componentsMat.cols; i++)
-    {
-        for (int o = 0; o < componentsMat.rows; o++)
-        {
-            int centerX = (i * radiusX) + radiusX;
-            int centerY = (o * radiusY) + radiusY;
-            Rect area(centerX - radiusX, centerY - radiusY, kernelMat.cols, kernelMat.rows);
+    FTKernel k;
+    prepareKernel(kernelMat, k);
 
-            Mat roiOutput(outputZeroes, area);
-            roiOutput += kernelMat.mul(componentsMat.at<float>(o,i));
-        }
-    }
+    FTWorkspace workspace;
+    componentsMat.convertTo(componentsMat, CV_32F);
+    workspace.components.assign(componentsMat.begin<float>(), componentsMat.end<float>());
 
-    outputZeroes(Rect(radiusX, radiusY, width, height)).copyTo(output);
+    Mat outputMat;
+    computeInverseFT(k, componentsMat.cols, componentsMat.rows, width, height, workspace, outputMat);
+    outputMat.copyTo(output);
 }
 
 void ft::FT02D_process(const cv::Mat &image, const cv::Mat &kernel, cv::Mat &output, const cv::Mat &mask)
 {
     CV_Assert(image.channels() == kernel.channels());
 
-    int radiusX = (kernel.cols - 1) / 2;
-    int radiusY = (kernel.rows - 1) / 2;
-    int An = image.cols / radiusX + 1;
-    int Bn = image.rows / radiusY + 1;
-    int outputWidthPadded = radiusX + image.cols + kernel.cols;
-    int outputHeightPadded = radiusY + image.rows + kernel.rows;
-
-    Mat imagePadded;
-    Mat maskPadded;
+    FTKernel k;
+    prepareKernel(kernel, k);
 
-    output = Mat::zeros(outputHeightPadded, outputWidthPadded, CV_MAKETYPE(CV_32F, image.channels()));
+    int An = image.cols / k.radiusX + 1;
+    int Bn = image.rows / k.radiusY + 1;
 
-    copyMakeBorder(image, imagePadded, radiusY, kernel.rows, radiusX, kernel.cols, BORDER_CONSTANT, Scalar(0));
-    copyMakeBorder(mask, maskPadded, radiusY, kernel.rows, radiusX, kernel.cols, BORDER_CONSTANT, Scalar(0));
+    FTWorkspace workspace;
+    computeComponentSums(image, mask, k, An, Bn, workspace);
 
-    for (int i = 0; i < An; i++)
+    workspace.components.resize(workspace.numerators.size());
+    for (size_t n = 0; n < workspace.components.size(); n++)
     {
-        for (int o = 0; o < Bn; o++)
-        {
-            int centerX = (i * radiusX) + radiusX;
-            int centerY = (o * radiusY) + radiusY;
-            Rect area(centerX - radiusX, centerY - radiusY, kernel.cols, kernel.rows);
+        workspace.components[n] = (float)(workspace.numerators[n] / workspace.denominators[n]);
+    }
 
-            Mat roiImage(imagePadded, area);
-            Mat roiMask(maskPadded, area);
-            Mat kernelMasked;
+    computeInverseFT(k, An, Bn, image.cols, image.rows, workspace, output);
+}
 
-            kernel.copyTo(kernelMasked, roiMask);
+void ft::FT02D_process(const cv::Mat &image, const cv::Mat &kernel, cv::Mat &output, const cv::Mat &mask, Size tileSize)
+{
+    CV_Assert(image.channels() == kernel.channels());
+    CV_Assert(tileSize.width > 0 && tileSize.height > 0);
+    CV_Assert(mask.empty() || mask.size() == image.size());
 
-            Mat numerator;
-            multiply(roiImage, kernelMasked, numerator, 1, CV_32F);
+    int tilesX = (image.cols + tileSize.width - 1) / tileSize.width;
+    int tilesY = (image.rows + tileSize.height - 1) / tileSize.height;
 
-            Scalar component;
-            divide(sum(numerator), sum(kernelMasked), component, 1, CV_32F);
+    // The tiles run in parallel, each one with the parallel loops of FT02D_process nested
+    Mat result(image.size(), CV_MAKETYPE(CV_32F, image.channels()));
 
-            Mat inverse;
-            multiply(kernel, component, inverse, 1, CV_32F);
+    parallel_for_(Range(0, tilesX * tilesY), TiledProcessInvoker(image, kernel, mask, tileSize, result));
 
-            Mat roiOutput(output, area);
-            add(roiOutput, inverse, roiOutput);
-        }
-    }
-
-    output = output(Rect(radiusX, radiusY, image.cols, image.rows));
+    output = result;
 }
 
 int ft::FT02D_iteration(const Mat &image, const Mat &kernel, Mat &imageOutput, const Mat &mask, Mat &maskOutput, bool firstStop)
+{
+    FTWorkspace workspace;
+
+    return ft::FT02D_iteration(image, kernel, imageOutput, mask, maskOutput, firstStop, workspace);
+}
+
+int ft::FT02D_iteration(const Mat &image, const Mat &kernel, Mat &imageOutput, const Mat &mask, Mat &maskOutput, bool firstStop, FTWorkspace &workspace)
 {
     CV_Assert(image.channels() == kernel.channels() && mask.channels() == 1);
 
-    int radiusX = (kernel.cols - 1) / 2;
-    int radiusY = (kernel.rows - 1) / 2;
-    int An = image.cols / radiusX + 1;
-    int Bn = image.rows / radiusY + 1;
-    int outputWidthPadded = radiusX + image.cols + kernel.cols;
-    int outputHeightPadded = radiusY + image.rows + kernel.rows;
+    FTKernel k;
+    prepareKernel(kernel, k);
+
+    int An = image.cols / k.radiusX + 1;
+    int Bn = image.rows / k.radiusY + 1;
+    int cn = image.channels();
     int undefinedComponents = 0;
 
-    Mat imagePadded;
-    Mat maskPadded;
+    computeComponentSums(image, mask, k, An, Bn, workspace);
 
-    imageOutput = Mat::zeros(outputHeightPadded, outputWidthPadded, CV_MAKETYPE(CV_32F, image.channels()));
-    maskOutput = Mat::ones(outputHeightPadded, outputWidthPadded, CV_8UC1);
+    Mat maskResult = Mat::ones(image.size(), CV_8UC1);
+    bool stopped = false;
 
-    copyMakeBorder(image, imagePadded, radiusY, kernel.rows, radiusX, kernel.cols, BORDER_CONSTANT, Scalar(0));
-    copyMakeBorder(mask, maskPadded, radiusY, kernel.rows, radiusX, kernel.cols, BORDER_CONSTANT, Scalar(0));
+    workspace.components.resize(workspace.numerators.size());
 
+    // The components are visited in the order of the columns of the grid, so that firstStop leaves
+    // out the same components as a sequential computation
     for (int i = 0; i < An; i++)
     {
         for (int o = 0; o < Bn; o++)
         {
-            int centerX = (i * radiusX) + radiusX;
-            int centerY = (o * radiusY) + radiusY;
-            Rect area(centerX - radiusX, centerY - radiusY, kernel.cols, kernel.rows);
-
-            Mat roiImage(imagePadded, area);
-            Mat roiMask(maskPadded, area);
-            Mat kernelMasked;
-
-            kernel.copyTo(kernelMasked, roiMask);
+            size_t n = (size_t)(o * An + i) * cn;
 
-            Mat numerator;
-            multiply(roiImage, kernelMasked, numerator, 1, CV_32F);
-
-            Scalar denominator = sum(kernelMasked);
-
-            if (denominator[0] == 0)
+            if (stopped || workspace.denominators[n] == 0)
             {
-                if (firstStop)
+                for (int c = 0; c < cn; c++)
                 {
-                    imageOutput = imageOutput(Rect(radiusX, radiusY, image.cols, image.rows));
-                    maskOutput = maskPadded(Rect(radiusX, radiusY, image.cols, image.rows));
-
-                    return -1;
+                    workspace.components[n + c] = 0;
                 }
-                else
-                {
-                    undefinedComponents++;
 
-                    Mat roiMaskOutput(maskOutput, Rect(centerX - radiusX + 1, centerY - radiusY + 1, kernel.cols - 2, kernel.rows - 2));
-                    roiMaskOutput = 0;
+                if (stopped)
+                {
+                    continue;
+                }
 
+                if (firstStop)
+                {
+                    stopped = true;
                     continue;
                 }
-            }
 
-            Scalar component;
-            divide(sum(numerator), denominator, component, 1, CV_32F);
+                undefinedComponents++;
+
+                // the inner part of the window of the component is not reconstructed
+                Rect area(i * k.radiusX - k.radiusX + 1, o * k.radiusY - k.radiusY + 1, kernel.cols - 2, kernel.rows - 2);
+                Mat roiMaskOutput(maskResult, area & Rect(0, 0, image.cols, image.rows));
+                roiMaskOutput = 0;
 
-            Mat inverse;
-            multiply(kernel, component, inverse, 1, CV_32F);
+                continue;
+            }
 
-            Mat roiImageOutput(imageOutput, area);
-            add(roiImageOutput, inverse, roiImageOutput);
+            for (int c = 0; c < cn; c++)
+            {
+                workspace.components[n + c] = (float)(workspace.numerators[n + c] / workspace.denominators[n + c]);
+            }
         }
     }
 
-    imageOutput = imageOutput(Rect(radiusX, radiusY, image.cols, image.rows));
-    maskOutput = maskOutput(Rect(radiusX, radiusY, image.cols, image.rows));
+    computeInverseFT(k, An, Bn, image.cols, image.rows, workspace, imageOutput);
+
+    if (stopped)
+    {
+        maskOutput = mask;
+
+        return -1;
+    }
+
+    maskOutput = maskResult;
 
     return undefinedComponents;
 }
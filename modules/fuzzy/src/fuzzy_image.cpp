@@ -113,6 +113,7 @@ void ft::inpaint(const cv::Mat &image, const cv::Mat &mask, cv::Mat &output, int
         Mat kernel;
         Mat processingOutput;
         Mat outpuMask;
+        ft::FTWorkspace workspace;
         int state = 0;
         int currentRadius = radius;
 
@@ -126,7 +127,7 @@ void ft::inpaint(const cv::Mat &image, const cv::Mat &mask, cv::Mat &output, int
         {
             ft::createKernel(function, currentRadius, kernel, image.channels());
 
-            state = ft::FT02D_iteration(processingInput, kernel, processingOutput, processingMask, outpuMask, true);
+            state = ft::FT02D_iteration(processingInput, kernel, processingOutput, processingMask, outpuMask, true, workspace);
 
             currentRadius++;
         }
@@ -141,6 +142,7 @@ void ft::inpaint(const cv::Mat &image, const cv::Mat &mask, cv::Mat &output, int
         Mat kernel;
         Mat processingOutput;
         Mat maskOutput;
+        ft::FTWorkspace workspace;
         int state = 0;
         int currentRadius = radius;
 
@@ -159,7 +161,7 @@ void ft::inpaint(const cv::Mat &image, const cv::Mat &mask, cv::Mat &output, int
 
             Mat invMask = 1 - processingMask;
 
-            state = ft::FT02D_iteration(processingInput, kernel, processingOutput, processingMask, maskOutput, false);
+            state = ft::FT02D_iteration(processingInput, kernel, processingOutput, processingMask, maskOutput, false, workspace);
 
             maskOutput.copyTo(processingMask);
             processingOutput.copyTo(processingInput, invMask);
@@ -178,3 +180,34 @@ void ft::filter(const cv::Mat &image, const cv::Mat &kernel, cv::Mat &output)
 
     ft::FT02D_process(image, kernel, output, mask);
 }
+
+void ft::inpaint(const cv::Mat &image, const cv::Mat &mask, cv::Mat &output, int radius, int function, int algorithm, cv::Size tileSize)
+{
+    // the other algorithms grow the radius over the whole image until it is reconstructed
+    CV_Assert(algorithm == ft::ONE_STEP);
+
+    Mat kernel;
+    ft::createKernel(function, radius, kernel, image.channels());
+
+    Mat processingOutput;
+    ft::FT02D_process(image, kernel, processingOutput, mask, tileSize);
+
+    // the unmasked pixels are copied by bands of tiles, with no 32-bit copy of the whole image
+    for (int y = 0; y < image.rows; y += tileSize.height)
+    {
+        Range rows(y, std::min(y + tileSize.height, image.rows));
+        Mat processingInput;
+
+        image.rowRange(rows).convertTo(processingInput, CV_32F);
+
+        Mat processingOutputRows = processingOutput.rowRange(rows);
+        processingInput.copyTo(processingOutputRows, mask.rowRange(rows));
+    }
+
+    output = processingOutput;
+}
+
+void ft::filter(const cv::Mat &image, const cv::Mat &kernel, cv::Mat &output, cv::Size tileSize)
+{
+    ft::FT02D_process(image, kernel, output, Mat(), tileSize);
+}
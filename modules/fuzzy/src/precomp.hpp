@@ -47,4 +47,25 @@
 #include "opencv2/imgproc.hpp"
 #include "opencv2/fuzzy.hpp"
 
+#include <vector>
+
+namespace cv
+{
+
+namespace ft
+{
+    // Buffers of the F-transform computation, kept by the callers that repeat it to avoid reallocations
+    struct FTWorkspace
+    {
+        std::vector<double> rowSums;
+        std::vector<double> numerators;
+        std::vector<double> denominators;
+        std::vector<float> components;
+    };
+
+    // FT02D_iteration with the buffers of a workspace
+    int FT02D_iteration(const Mat &image, const Mat &kernel, Mat &imageOutput, const Mat &mask, Mat &maskOutput, bool firstStop, FTWorkspace &workspace);
+}
+}
+
 #endif
@@ -0,0 +1,106 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+
+// The F0-transform and its inverse of a 1-channel image, component by component as in the definition
+static void referenceProcess(const Mat &image, const Mat &kernel, const Mat &mask, Mat &output)
+{
+    int radiusX = (kernel.cols - 1) / 2;
+    int radiusY = (kernel.rows - 1) / 2;
+    int An = image.cols / radiusX + 1;
+    int Bn = image.rows / radiusY + 1;
+
+    output = Mat::zeros(image.size(), CV_64F);
+
+    for (int o = 0; o < Bn; o++)
+    {
+        for (int i = 0; i < An; i++)
+        {
+            int left = i * radiusX - radiusX, top = o * radiusY - radiusY;
+            double numerator = 0, denominator = 0;
+
+            for (int y = max(top, 0); y < min(top + kernel.rows, image.rows); y++)
+            {
+                for (int x = max(left, 0); x < min(left + kernel.cols, image.cols); x++)
+                {
+                    if (mask.at<uchar>(y, x))
+                    {
+                        numerator += kernel.at<float>(y - top, x - left) * image.at<float>(y, x);
+                        denominator += kernel.at<float>(y - top, x - left);
+                    }
+                }
+            }
+
+            for (int y = max(top, 0); y < min(top + kernel.rows, image.rows); y++)
+            {
+                for (int x = max(left, 0); x < min(left + kernel.cols, image.cols); x++)
+                {
+                    output.at<double>(y, x) += (numerator / denominator) * kernel.at<float>(y - top, x - left);
+                }
+            }
+        }
+    }
+
+    output.convertTo(output, CV_32F);
+}
+
+TEST(Fuzzy_F0, process_separable_and_generic_kernels)
+{
+    Mat image(53, 71, CV_32F), mask(image.size(), CV_8U);
+    RNG& rng = theRNG();
+    rng.fill(image, RNG::UNIFORM, 0, 255);
+    rng.fill(mask, RNG::UNIFORM, 0, 16);
+    mask = mask > 0;
+
+    Mat separable, generic;
+    ft::createKernel(ft::LINEAR, 3, separable, 1);
+    // a kernel that is not the product of a column and a row
+    generic = separable.clone();
+    generic.at<float>(1, 2) += 0.25f;
+
+    Mat kernels[] = { separable, generic };
+    for (int k = 0; k < 2; k++)
+    {
+        Mat output, expected;
+        ft::FT02D_process(image, kernels[k], output, mask);
+        referenceProcess(image, kernels[k], mask, expected);
+
+        ASSERT_EQ(CV_32FC1, output.type());
+        EXPECT_LE(cvtest::norm(output, expected, NORM_INF), 1e-3) << "kernel " << k;
+
+        // The components and the inverse F0-transform give the same result
+        Mat components, inverse;
+        ft::FT02D_components(image, kernels[k], components, mask);
+        ft::FT02D_inverseFT(components, kernels[k], inverse, image.cols, image.rows);
+        EXPECT_LE(cvtest::norm(inverse, expected, NORM_INF), 1e-3) << "kernel " << k;
+    }
+}
+
+TEST(Fuzzy_F0, process_tiles_same_as_whole)
+{
+    Mat image(61, 83, CV_8UC3), mask(image.size(), CV_8UC3);
+    RNG& rng = theRNG();
+    rng.fill(image, RNG::UNIFORM, 0, 256);
+    rng.fill(mask, RNG::UNIFORM, 0, 16);
+    mask = mask > 0;
+
+    for (int radius = 2; radius <= 4; radius++)
+    {
+        Mat kernel;
+        ft::createKernel(ft::LINEAR, radius, kernel, 3);
+
+        Mat whole, tiled;
+        ft::FT02D_process(image, kernel, whole, mask);
+        ft::FT02D_process(image, kernel, tiled, mask, Size(23, 17));
+        EXPECT_EQ(0, cvtest::norm(whole, tiled, NORM_INF)) << "radius " << radius;
+
+        ft::filter(image, kernel, whole);
+        ft::filter(image, kernel, tiled, Size(16, 16));
+        EXPECT_EQ(0, cvtest::norm(whole, tiled, NORM_INF)) << "radius " << radius;
+    }
+}
@@ -47,6 +47,7 @@ using namespace std;
 //! @addtogroup hdf5
 //! @{
 
+class HDF5Appender;
 
 /** @brief Hierarchical Data Format version 5 interface.
 
@@ -291,6 +292,44 @@ public:
      */
     CV_WRAP virtual int dsgettype( String dslabel ) const = 0;
 
+    /** @brief Set the chunk cache of a dataset
+    @param dslabel specify the hdf5 dataset label.
+    @param nslots number of chunk slots in the hash table of the cache, preferably a prime number.
+    @param nbytes total size of the cache in bytes.
+    @param w0 preemption policy, from 0 to 1, favouring the eviction of the chunks already fully read or written.
+
+    The parameters are those of H5Pset_chunk_cache. The library default is a cache of 1 MB, too small for
+    datasets whose chunks are larger or for slices crossing many chunks.
+
+    @note The opened datasets are kept open until close(), consecutive dsread(), dswrite() and dsinsert()
+    calls on the same dataset do not reopen it. The cache is set when the dataset is opened, so setting it
+    on an already opened dataset reopens it on its next use. The cache is only used by chunked datasets.
+     */
+    CV_WRAP virtual void dssetchunkcache( String dslabel, const size_t nslots,
+                                          const size_t nbytes, const double w0 = 0.75 ) const = 0;
+
+    /** @brief Create a buffered appender of rows to a two dimensional dataset.
+    @param dslabel specify the hdf5 dataset label, the dataset must exist with H5_UNLIMITED rows.
+    @param bufferRows amount of rows buffered before being written, by default the rows of a chunk.
+
+    Appended rows go after the rows the dataset holds. They are kept in memory and written by
+    dsinsert() in blocks of **bufferRows** rows, so that a compressed dataset gets whole chunks
+    instead of being read, decompressed and compressed again for every partial one.
+
+    @note The HDF5 object must stay open while the appender is used. The rows left in the buffer
+    are written by HDF5Appender::flush() and by the destructor of the appender.
+
+    - Example below logs 64-float features at the end of an unlimited dataset chunked by 256 rows:
+    @code{.cpp}
+      int chunks[2] = { 256, 64 };
+      h5io->dscreate( cv::hdf::HDF5::H5_UNLIMITED, 64, CV_32F, "features", 1, chunks );
+      cv::Ptr<cv::hdf::HDF5Appender> appender = h5io->dsappender( "features" );
+      for ( ;; )
+        appender->append( computeFeatures() );
+    @endcode
+     */
+    virtual Ptr<HDF5Appender> dsappender( String dslabel, const int bufferRows = 0 ) const = 0;
+
     /* @overload */
     CV_WRAP virtual void dswrite( InputArray Array, String dslabel ) const = 0;
     /* @overload */
@@ -434,6 +473,20 @@ public:
     CV_WRAP virtual void dsread( OutputArray Array, String dslabel,
                  const vector<int>& dims_offset,
                  const vector<int>& dims_counts = vector<int>() ) const = 0;
+    /** @brief Map a dataset in memory.
+    @param dslabel specify the source hdf5 dataset label.
+
+    Returns a Mat over the file pages of a dataset stored contiguous, not compressed nor filtered,
+    and in the native byte order. Its pages are read by the system on access instead of being
+    copied by dsread(), which suits random access into large datasets. Other datasets are read
+    with dsread().
+
+    @note The mapped Mat is **read only**, writing into it is an access violation. It stays valid
+    until close() and shows the data of the file, later writes once the library flushes them.
+    Memory mapping needs a POSIX system, on others the dataset is always read with dsread().
+     */
+    virtual Mat dsmap( String dslabel ) const = 0;
+
     /** @brief Read specific dataset from hdf5 file into Mat object.
     @param Array Mat container where data reads will be returned.
     @param dslabel specify the source hdf5 dataset label.
@@ -442,7 +495,8 @@ public:
     @param dims_counts each array member specify the amount over dataset's each
            dimensions of dataset to read into OutputArray.
 
-    Reads out Mat object reflecting the stored dataset.
+    Reads out Mat object reflecting the stored dataset. A Mat already of the size and type of the read data
+    is not reallocated, so that a loop reading slices of the same size can keep reusing one buffer.
 
     @note If hdf5 file does not exist an exception will be thrown. Use hlexists() to check dataset presence.
     It is thread safe.
@@ -700,6 +754,28 @@ public:
    */
   CV_EXPORTS_W Ptr<HDF5> open( String HDF5Filename );
 
+/** @brief Buffered appender of rows to a dataset, see HDF5::dsappender().
+ */
+class CV_EXPORTS HDF5Appender
+{
+public:
+
+    virtual ~HDF5Appender() {}
+
+    /** @brief Append rows.
+    @param rows rows of the type and amount of columns of the dataset.
+     */
+    virtual void append( InputArray rows ) = 0;
+
+    /** @brief Write the buffered rows.
+     */
+    virtual void flush() = 0;
+
+    /** @brief Amount of rows of the dataset once the buffered ones are written.
+     */
+    virtual int getRows() const = 0;
+};
+
 //! @}
 
 } // end namespace hdf
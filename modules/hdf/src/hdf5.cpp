@@ -36,6 +36,13 @@
 
 #include <hdf5.h>
 
+#if defined __unix__ || defined __APPLE__
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define HDF5_HAVE_MMAP
+#endif
+
 using namespace std;
 
 namespace cv
@@ -78,6 +85,16 @@ public:
     /* get data type of dataset */
     virtual int dsgettype( String dslabel ) const;
 
+    // set the chunk cache of a dataset
+    virtual void dssetchunkcache( String dslabel, const size_t nslots,
+                                  const size_t nbytes, const double w0 = 0.75 ) const;
+
+    // buffered appender of rows
+    virtual Ptr<HDF5Appender> dsappender( String dslabel, const int bufferRows = 0 ) const;
+
+    // read only Mat over the file pages of the dataset
+    virtual Mat dsmap( String dslabel ) const;
+
     // overload dscreate() #1
     virtual void dscreate( const int rows, const int cols, const int type, String dslabel ) const;
 
@@ -182,6 +199,21 @@ private:
     // hdf5 file handler
     hid_t m_h5_file_id;
 
+    // datasets opened by label, kept open until close()
+    mutable map<String, hid_t> m_datasets;
+
+    // dataset access properties (the chunk cache) by label
+    mutable map<String, hid_t> m_dsaccess;
+
+    // datasets mapped in memory, kept mapped until close()
+    mutable vector< pair<void*, size_t> > m_mappings;
+
+    // guards the two maps and the mappings
+    mutable Mutex m_dsmutex;
+
+    // open a dataset or get it from the opened ones, it must not be closed by the caller
+    hid_t dsopen( const String& dslabel ) const;
+
     // translate cvType -> h5Type
     inline hid_t GetH5type( int cvType ) const;
 
@@ -280,6 +312,21 @@ HDF5Impl::HDF5Impl( String _hdf5_filename )
 
 void HDF5Impl::close()
 {
+    {
+      AutoLock lock( m_dsmutex );
+      for ( map<String, hid_t>::iterator it = m_datasets.begin(); it != m_datasets.end(); ++it )
+        H5Dclose( it->second );
+      for ( map<String, hid_t>::iterator it = m_dsaccess.begin(); it != m_dsaccess.end(); ++it )
+        H5Pclose( it->second );
+      m_datasets.clear();
+      m_dsaccess.clear();
+#ifdef HDF5_HAVE_MMAP
+      for ( size_t i = 0; i < m_mappings.size(); i++ )
+        munmap( m_mappings[i].first, m_mappings[i].second );
+#endif
+      m_mappings.clear();
+    }
+
     if ( m_h5_file_id != -1 )
       H5Fclose( m_h5_file_id );
     // mark closed
@@ -290,6 +337,25 @@ void HDF5Impl::close()
  * h5 generic
  */
 
+hid_t HDF5Impl::dsopen( const String& dslabel ) const
+{
+    AutoLock lock( m_dsmutex );
+
+    map<String, hid_t>::const_iterator it = m_datasets.find( dslabel );
+    if ( it != m_datasets.end() )
+      return it->second;
+
+    map<String, hid_t>::const_iterator ap = m_dsaccess.find( dslabel );
+    hid_t dsdata = H5Dopen( m_h5_file_id, dslabel.c_str(),
+                            ap != m_dsaccess.end() ? ap->second : H5P_DEFAULT );
+
+    // a failed open is not kept, the caller gets the invalid handle as before
+    if ( dsdata >= 0 )
+      m_datasets[dslabel] = dsdata;
+
+    return dsdata;
+}
+
 bool HDF5Impl::hlexists( String label ) const
 {
     bool exists = false;
@@ -320,7 +386,7 @@ void HDF5Impl::grcreate( String grlabel )
 vector<int> HDF5Impl::dsgetsize( String dslabel, int dims_flag ) const
 {
     // open dataset
-    hid_t dsdata = H5Dopen( m_h5_file_id, dslabel.c_str(), H5P_DEFAULT );
+    hid_t dsdata = dsopen( dslabel );
 
     // get file space
     hid_t fspace = H5Dget_space( dsdata );
@@ -364,7 +430,6 @@ vector<int> HDF5Impl::dsgetsize( String dslabel, int dims_flag ) const
     for ( size_t d = 0; d < SizeVect.size(); d++ )
       SizeVect[d] = (int) dims[d];
 
-    H5Dclose( dsdata );
     H5Sclose( fspace );
 
     delete [] dims;
@@ -377,7 +442,7 @@ int HDF5Impl::dsgettype( String dslabel ) const
     hid_t h5type;
 
     // open dataset
-    hid_t dsdata = H5Dopen( m_h5_file_id, dslabel.c_str(), H5P_DEFAULT );
+    hid_t dsdata = dsopen( dslabel );
 
     // get data type
     hid_t dstype = H5Dget_type( dsdata );
@@ -401,11 +466,35 @@ int HDF5Impl::dsgettype( String dslabel ) const
     int cvtype = GetCVtype( h5type );
 
     H5Tclose( dstype );
-    H5Dclose( dsdata );
 
     return CV_MAKETYPE( cvtype, channs );
 }
 
+void HDF5Impl::dssetchunkcache( String dslabel, const size_t nslots,
+                                const size_t nbytes, const double w0 ) const
+{
+    AutoLock lock( m_dsmutex );
+
+    hid_t dapl;
+    map<String, hid_t>::iterator ap = m_dsaccess.find( dslabel );
+    if ( ap != m_dsaccess.end() )
+      dapl = ap->second;
+    else
+    {
+      dapl = H5Pcreate( H5P_DATASET_ACCESS );
+      m_dsaccess[dslabel] = dapl;
+    }
+    H5Pset_chunk_cache( dapl, nslots, nbytes, w0 );
+
+    // the cache is set when the dataset is opened, an opened one is reopened on its next use
+    map<String, hid_t>::iterator it = m_datasets.find( dslabel );
+    if ( it != m_datasets.end() )
+    {
+      H5Dclose( it->second );
+      m_datasets.erase( it );
+    }
+}
+
 // overload
 void HDF5Impl::dscreate( const int rows, const int cols, const int type,
                          String dslabel ) const
@@ -581,7 +670,7 @@ void HDF5Impl::dsread( OutputArray Array, String dslabel,
     hid_t h5type;
 
     // open the HDF5 dataset
-    hid_t dsdata = H5Dopen( m_h5_file_id, dslabel.c_str(), H5P_DEFAULT );
+    hid_t dsdata = dsopen( dslabel );
 
     // get data type
     hid_t dstype = H5Dget_type( dsdata );
@@ -656,9 +745,16 @@ void HDF5Impl::dsread( OutputArray Array, String dslabel,
     H5Sselect_hyperslab( fspace, H5S_SELECT_SET,
                          foffset, NULL, dsdims, NULL );
 
-    // read from DS
+    // read from DS, straight into the given Mat when it is continuous
     Mat matrix = Array.getMat();
-    H5Dread( dsdata, dstype, dspace, fspace, H5P_DEFAULT, matrix.data );
+    if ( matrix.isContinuous() )
+      H5Dread( dsdata, dstype, dspace, fspace, H5P_DEFAULT, matrix.data );
+    else
+    {
+      Mat buffer( n_dims, mxdims, matrix.type() );
+      H5Dread( dsdata, dstype, dspace, fspace, H5P_DEFAULT, buffer.data );
+      buffer.copyTo( matrix );
+    }
 
     delete [] dsdims;
     delete [] mxdims;
@@ -668,7 +764,84 @@ void HDF5Impl::dsread( OutputArray Array, String dslabel,
     H5Tclose( dstype );
     H5Sclose( dspace );
     H5Sclose( fspace );
-    H5Dclose( dsdata );
+}
+
+Mat HDF5Impl::dsmap( String dslabel ) const
+{
+#ifdef HDF5_HAVE_MMAP
+    // check dataset exists
+    if ( hlexists( dslabel ) == false )
+      CV_Error( Error::StsInternal, "Dataset does not exist." );
+
+    hid_t dsdata = dsopen( dslabel );
+
+    // only contiguous and not filtered (compressed) data is stored as it is in memory
+    hid_t dcpl = H5Dget_create_plist( dsdata );
+    bool mappable = H5Pget_layout( dcpl ) == H5D_CONTIGUOUS && H5Pget_nfilters( dcpl ) == 0;
+    H5Pclose( dcpl );
+
+    // and the addresses are those of the file without user block
+    hid_t fcpl = H5Fget_create_plist( m_h5_file_id );
+    hsize_t userblock = 0;
+    H5Pget_userblock( fcpl, &userblock );
+    H5Pclose( fcpl );
+
+    // the storage is not allocated until the dataset is written
+    haddr_t offset = mappable && userblock == 0 ? H5Dget_offset( dsdata ) : HADDR_UNDEF;
+
+    int type = dsgettype( dslabel );
+    if ( offset != HADDR_UNDEF )
+    {
+      // the stored type must be the native one, in byte order as well
+      hid_t dstype = H5Dget_type( dsdata );
+      hid_t memtype = GetH5type( type );
+      if ( CV_MAT_CN( type ) > 1 )
+      {
+        hsize_t adims[1] = { (hsize_t)CV_MAT_CN( type ) };
+        memtype = H5Tarray_create( memtype, 1, adims );
+      }
+      mappable = H5Tequal( dstype, memtype ) > 0;
+      if ( CV_MAT_CN( type ) > 1 )
+        H5Tclose( memtype );
+      H5Tclose( dstype );
+    }
+
+    if ( offset != HADDR_UNDEF && mappable )
+    {
+      vector<int> dims = dsgetsize( dslabel );
+      size_t nbytes = CV_ELEM_SIZE( type );
+      for ( size_t d = 0; d < dims.size(); d++ )
+        nbytes *= dims[d];
+
+      // written data can still be in the buffers of the library
+      H5Fflush( m_h5_file_id, H5F_SCOPE_LOCAL );
+
+      int fd = ::open( m_hdf5_filename.c_str(), O_RDONLY );
+      if ( fd >= 0 && nbytes > 0 )
+      {
+        // mappings start on a page
+        off_t page = (off_t) sysconf( _SC_PAGESIZE );
+        off_t start = (off_t) offset / page * page;
+        size_t length = nbytes + (size_t)( (off_t) offset - start );
+        void* addr = mmap( NULL, length, PROT_READ, MAP_SHARED, fd, start );
+        ::close( fd );
+
+        if ( addr != MAP_FAILED )
+        {
+          AutoLock lock( m_dsmutex );
+          m_mappings.push_back( make_pair( addr, length ) );
+          return Mat( (int) dims.size(), &dims[0], type, (uchar*) addr + ( (off_t) offset - start ) );
+        }
+      }
+      else if ( fd >= 0 )
+        ::close( fd );
+    }
+#endif
+
+    // read it otherwise
+    Mat matrix;
+    dsread( matrix, dslabel );
+    return matrix;
 }
 
 // overload
@@ -727,7 +900,7 @@ void HDF5Impl::dswrite( InputArray Array, String dslabel,
     }
 
     // open dataset
-    hid_t dsdata = H5Dopen( m_h5_file_id, dslabel.c_str(), H5P_DEFAULT );
+    hid_t dsdata = dsopen( dslabel );
 
     // create input data space
     hid_t dspace = H5Screate_simple( n_dims, dsdims, NULL );
@@ -767,7 +940,6 @@ void HDF5Impl::dswrite( InputArray Array, String dslabel,
 
     H5Sclose( dspace );
     H5Sclose( fspace );
-    H5Dclose( dsdata );
 }
 
 // overload
@@ -829,7 +1001,7 @@ void HDF5Impl::dsinsert( InputArray Array, String dslabel,
     }
 
     // open dataset
-    hid_t dsdata = H5Dopen( m_h5_file_id, dslabel.c_str(), H5P_DEFAULT );
+    hid_t dsdata = dsopen( dslabel );
 
     // create input data space
     hid_t dspace = H5Screate_simple( n_dims, dsdims, NULL );
@@ -903,7 +1075,6 @@ void HDF5Impl::dsinsert( InputArray Array, String dslabel,
 
     H5Sclose( dspace );
     H5Sclose( fspace );
-    H5Dclose( dsdata );
 }
 
 /*
@@ -1015,7 +1186,7 @@ void HDF5Impl::kpwrite( const vector<KeyPoint> keypoints, String kplabel,
       dsddims[0] = counts;
 
     // open dataset
-    hid_t dsdata = H5Dopen( m_h5_file_id, kplabel.c_str(), H5P_DEFAULT );
+    hid_t dsdata = dsopen( kplabel );
 
     // create input data space
     hid_t dspace = H5Screate_simple( 1, dsddims, NULL );
@@ -1045,7 +1216,6 @@ void HDF5Impl::kpwrite( const vector<KeyPoint> keypoints, String kplabel,
     H5Tclose( mmtype );
     H5Sclose( dspace );
     H5Sclose( fspace );
-    H5Dclose( dsdata );
 }
 
 void HDF5Impl::kpinsert( const vector<KeyPoint> keypoints, String kplabel,
@@ -1069,7 +1239,7 @@ void HDF5Impl::kpinsert( const vector<KeyPoint> keypoints, String kplabel,
       dsddims[0] = counts;
 
     // open dataset
-    hid_t dsdata = H5Dopen( m_h5_file_id, kplabel.c_str(), H5P_DEFAULT );
+    hid_t dsdata = dsopen( kplabel );
 
     // create input data space
     hid_t dspace = H5Screate_simple( 1, dsddims, NULL );
@@ -1129,7 +1299,6 @@ void HDF5Impl::kpinsert( const vector<KeyPoint> keypoints, String kplabel,
     H5Tclose( mmtype );
     H5Sclose( dspace );
     H5Sclose( fspace );
-    H5Dclose( dsdata );
 }
 
 void HDF5Impl::kpread( vector<KeyPoint>& keypoints, String kplabel,
@@ -1138,7 +1307,7 @@ void HDF5Impl::kpread( vector<KeyPoint>& keypoints, String kplabel,
     CV_Assert( keypoints.size() == 0 );
 
     // open the HDF5 dataset
-    hid_t dsdata = H5Dopen( m_h5_file_id, kplabel.c_str(), H5P_DEFAULT );
+    hid_t dsdata = dsopen( kplabel );
 
     // get data type
     hid_t dstype = H5Dget_type( dsdata );
@@ -1190,7 +1359,107 @@ void HDF5Impl::kpread( vector<KeyPoint>& keypoints, String kplabel,
     H5Tclose( dstype );
     H5Sclose( dspace );
     H5Sclose( fspace );
-    H5Dclose( dsdata );
+}
+
+/*
+ *  buffered appender
+ */
+
+class HDF5AppenderImpl : public HDF5Appender
+{
+public:
+
+    HDF5AppenderImpl( const HDF5* _h5io, String _dslabel, int _rows, int cols, int type, int bufferRows )
+                    : h5io( _h5io ), dslabel( _dslabel ), rows( _rows ), buffered( 0 ),
+                      buffer( bufferRows, cols, type ) {}
+
+    virtual ~HDF5AppenderImpl() { flush(); }
+
+    virtual void append( InputArray _rows );
+
+    virtual void flush();
+
+    virtual int getRows() const { return rows + buffered; }
+
+private:
+
+    // write rows after the ones of the dataset
+    void insert( const Mat& block );
+
+    const HDF5* h5io;
+    String dslabel;
+    // rows written in the dataset
+    int rows;
+    // rows waiting in the buffer
+    int buffered;
+    Mat buffer;
+};
+
+void HDF5AppenderImpl::insert( const Mat& block )
+{
+    int offset[2] = { rows, 0 };
+    h5io->dsinsert( block, dslabel, offset );
+    rows += block.rows;
+}
+
+void HDF5AppenderImpl::append( InputArray _rows )
+{
+    Mat src = _rows.getMat();
+    CV_Assert( src.dims == 2 && src.cols == buffer.cols && src.type() == buffer.type() );
+
+    int bufferRows = buffer.rows;
+    int start = 0;
+    while ( start < src.rows )
+    {
+      // whole blocks go straight to the dataset when nothing is buffered
+      int blocks = ( src.rows - start ) / bufferRows;
+      if ( buffered == 0 && blocks > 0 && src.isContinuous() )
+      {
+        insert( src.rowRange( start, start + blocks * bufferRows ) );
+        start += blocks * bufferRows;
+        continue;
+      }
+
+      int n = std::min( src.rows - start, bufferRows - buffered );
+      src.rowRange( start, start + n ).copyTo( buffer.rowRange( buffered, buffered + n ) );
+      buffered += n;
+      start += n;
+
+      if ( buffered == bufferRows )
+      {
+        insert( buffer );
+        buffered = 0;
+      }
+    }
+}
+
+void HDF5AppenderImpl::flush()
+{
+    if ( buffered > 0 )
+    {
+      insert( buffer.rowRange( 0, buffered ) );
+      buffered = 0;
+    }
+}
+
+Ptr<HDF5Appender> HDF5Impl::dsappender( String dslabel, const int bufferRows ) const
+{
+    // check dataset exists
+    if ( hlexists( dslabel ) == false )
+      CV_Error( Error::StsInternal, "Dataset does not exist." );
+
+    vector<int> dims = dsgetsize( dslabel );
+    CV_Assert( dims.size() == 2 );
+
+    int nrows = bufferRows;
+    if ( nrows <= 0 )
+    {
+      // rows of a chunk, a single row for a non chunked dataset
+      vector<int> chunks = dsgetsize( dslabel, H5_GETCHUNKDIMS );
+      nrows = chunks.size() == 2 ? chunks[0] : 1;
+    }
+
+    return makePtr<HDF5AppenderImpl>( this, dslabel, dims[0], dims[1], dsgettype( dslabel ), nrows );
 }
 
 CV_EXPORTS Ptr<HDF5> open( String HDF5Filename )
@@ -36,8 +36,10 @@
 #define __OPENCV_HDF_PRECOMP_H__
 
 #include "opencv2/core.hpp"
+#include "opencv2/core/utility.hpp"
 
 #include <vector>
+#include <map>
 
 #include "opencv2/hdf.hpp"
 #endif
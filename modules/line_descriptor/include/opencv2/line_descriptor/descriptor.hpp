@@ -485,9 +485,10 @@ class CV_EXPORTS BinaryDescriptor : public Algorithm
     LineChains lines_;  //store the detected line chains;
 
     //store the line Equation coefficients, vec3=[w1,w2,w3] for line w1*x + w2*y + w3=0;
+    //only the first lines_.numOfLines entries are valid, the others are kept for the next images
     std::vector<std::vector<double> > lineEquations_;
 
-    //store the line endpoints, [x1,y1,x2,y3]
+    //store the line endpoints, [x1,y1,x2,y3]; as lineEquations_, it can have more than lines_.numOfLines entries
     std::vector<std::vector<float> > lineEndpoints_;
 
     //store the line direction
@@ -556,6 +557,11 @@ class CV_EXPORTS BinaryDescriptor : public Algorithm
     bool LineValidation_( unsigned int *xCors, unsigned int *yCors, unsigned int offsetS, unsigned int offsetE, std::vector<double> &lineEquation,
                           float &direction );
 
+    /** Store the equation, the endpoints and the direction of the lineID-th line, reusing the
+     * storage left by the previous images.
+     */
+    void StoreLine_( unsigned int lineID, const std::vector<double> &lineEquation, const float *lineEndpoints, float direction );
+
     bool bValidate_;  //flag to decide whether line will be validated
 
     int ksize_;  //the size of Gaussian kernel: ksize X ksize, default value is 5.
@@ -605,6 +611,10 @@ class CV_EXPORTS BinaryDescriptor : public Algorithm
 
     cv::Mat dirImg_;  //store the direction image
 
+    cv::Mat dxABS_, dyABS_, sumDxDy_;  //absolute gradients and their sum, kept between images
+
+    EdgeChains edges_;  //the edges of the last image, kept between images
+
     double logNT_;
 
     cv::Mat_<float> ATA;   //the previous matrix of A^T * A;
@@ -845,6 +855,13 @@ unsigned char binaryConversion( float* f1, float* f2 );
 /* compute LBD descriptors using EDLine extractor */
 int computeLBD( ScaleLines &keyLines, bool useDetectionData = false );
 
+/* compute LBD descriptors of a range of groups of lines */
+void computeLBD( ScaleLines &keyLines, const Range &range, bool useDetectionData ) const;
+
+/* run EDLine on a range of octaves, and LBD on a range of groups of lines, in parallel */
+class EDLineInvoker;
+class LBDInvoker;
+
 /* gathers lines in groups using EDLine extractor.
  Each group contains the same line, detected in different octaves */
 int OctaveKeyLines( cv::Mat& image, ScaleLines &keyLines );
@@ -927,15 +944,27 @@ void detect( const Mat& image, CV_OUT std::vector<KeyLine>& keypoints, int scale
 void detect( const std::vector<Mat>& images, std::vector<std::vector<KeyLine> >& keylines, int scale, int numOctaves,
 const std::vector<Mat>& masks = std::vector<Mat>() ) const;
 
+/** @brief Detect lines inside the octaves of a prebuilt Gaussian pyramid of an image.
+
+The result is the same as the one of detect() on the image whose pyramid is given, the pyramid is
+not built again when it is already available.
+@param pyramid octaves of the pyramid, of type CV_8UC1, the first one being the image and each of the
+next ones being the pyrDown() of the previous one to its size divided by scale
+@param keylines vector that will store extracted lines
+@param scale scale factor used in pyramid generation
+@param mask mask matrix of the size of the image to detect only KeyLines of interest
+ */
+void detectInPyramid( const std::vector<Mat>& pyramid, CV_OUT std::vector<KeyLine>& keylines, int scale, const Mat& mask = Mat() ) const;
+
 private:
 /* compute Gaussian pyramid of input image */
-void computeGaussianPyramid( const Mat& image, int numOctaves, int scale );
+void computeGaussianPyramid( const Mat& image, int numOctaves, int scale, std::vector<cv::Mat>& gaussianPyrs ) const;
 
 /* implementation of line detection */
 void detectImpl( const Mat& imageSrc, std::vector<KeyLine>& keylines, int numOctaves, int scale, const Mat& mask ) const;
 
-/* matrices for Gaussian pyramids */
-std::vector<cv::Mat> gaussianPyrs;
+/* implementation of line detection in the octaves of a pyramid */
+void detectPyramidImpl( const std::vector<cv::Mat>& gaussianPyrs, std::vector<KeyLine>& keylines, int scale, const Mat& mask ) const;
 };
 
 /** @brief furnishes all functionalities for querying a dataset provided by user or internal to
@@ -1247,18 +1276,12 @@ UINT64 N;
 /** Table of original full-length codes */
 cv::Mat codes;
 
-/** Counter for eliminating duplicate results (it is not thread safe) */
-bitarray *counter;
-
 /** Array of m hashtables */
 SparseHashtable *H;
 
 /** Volume of a b-bit Hamming ball with radius s (for s = 0 to d) */
 UINT32 *xornum;
 
-/** Used within generation of binary codes at a certain Hamming distance */
-int power[100];
-
 /** constructor */
 Mihasher();
 
@@ -1279,8 +1302,14 @@ void batchquery( UINT32 * results, UINT32 *numres/*, qstat *stats*/, const cv::M
 
 private:
 
-/** execute a single query */
-void query( UINT32 * results, UINT32* numres/*, qstat *stats*/, UINT8 *q, UINT64 * chunks, UINT32 * res );
+/** execute a single query, with the duplicates counter and the buffers of the calling thread */
+void query( UINT32 * results, UINT32* numres/*, qstat *stats*/, UINT8 *q, UINT64 * chunks, UINT32 * res, bitarray & counter, int * power );
+
+/** queries a range of descriptors, each thread with its own buffers */
+class QueryInvoker;
+
+/** fills a range of hashtables from the splitted codes */
+class PopulateInvoker;
 };
 
 /** retrieve Hamming distances */
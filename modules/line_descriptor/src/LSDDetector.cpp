@@ -52,13 +52,13 @@ Ptr<LSDDetector> LSDDetector::createLSDDetector()
 }
 
 /* compute Gaussian pyramid of input image */
-void LSDDetector::computeGaussianPyramid( const Mat& image, int numOctaves, int scale )
+void LSDDetector::computeGaussianPyramid( const Mat& image, int numOctaves, int scale, std::vector<cv::Mat>& gaussianPyrs ) const
 {
-  /* clear class fields */
+  /* clear output */
   gaussianPyrs.clear();
 
   /* insert input image into pyramid */
-  cv::Mat currentMat = image.clone();
+  cv::Mat currentMat = image;
   //cv::GaussianBlur( currentMat, currentMat, cv::Size( 5, 5 ), 1 );
   gaussianPyrs.push_back( currentMat );
 
@@ -70,7 +70,6 @@ void LSDDetector::computeGaussianPyramid( const Mat& image, int numOctaves, int
     gaussianPyrs.push_back( currentMat );
   }
 }
-
 /* check lines' extremes */
 inline void checkLineExtremes( cv::Vec4f& extremes, cv::Size imageSize )
 {
@@ -110,19 +109,106 @@ void LSDDetector::detect( const Mat& image, CV_OUT std::vector<KeyLine>& keyline
     detectImpl( image, keylines, numOctaves, scale, mask );
 }
 
+/* detection in the octaves of a pyramid (octaves are independent, each one has its own LSD extractor) */
+class LSDOctavesInvoker : public ParallelLoopBody
+{
+public:
+  LSDOctavesInvoker( const std::vector<cv::Mat>& _gaussianPyrs, std::vector<std::vector<cv::Vec4f> >& _lines_lsd ) :
+      gaussianPyrs( _gaussianPyrs ),
+      lines_lsd( _lines_lsd )
+  {
+  }
+
+  void operator()( const Range& range ) const
+  {
+    for ( int i = range.start; i < range.end; i++ )
+    {
+      cv::Ptr<cv::LineSegmentDetector> ls = cv::createLineSegmentDetector( cv::LSD_REFINE_ADV );
+      ls->detect( gaussianPyrs[i], lines_lsd[i] );
+    }
+  }
+
+private:
+  const std::vector<cv::Mat>& gaussianPyrs;
+  std::vector<std::vector<cv::Vec4f> >& lines_lsd;
+
+  LSDOctavesInvoker& operator=( const LSDOctavesInvoker& );  // to quiet MSVC
+};
+
+/* detection in a list of images (images are independent) */
+class LSDImagesInvoker : public ParallelLoopBody
+{
+public:
+  LSDImagesInvoker( LSDDetector& _lsd, const std::vector<Mat>& _images, std::vector<std::vector<KeyLine> >& _keylines, int _scale,
+                    int _numOctaves, const std::vector<Mat>& _masks ) :
+      lsd( _lsd ),
+      images( _images ),
+      keylines( _keylines ),
+      scale( _scale ),
+      numOctaves( _numOctaves ),
+      masks( _masks )
+  {
+  }
+
+  void operator()( const Range& range ) const
+  {
+    for ( int i = range.start; i < range.end; i++ )
+      lsd.detect( images[i], keylines[i], scale, numOctaves, masks.empty() ? Mat() : masks[i] );
+  }
+
+private:
+  LSDDetector& lsd;
+  const std::vector<Mat>& images;
+  std::vector<std::vector<KeyLine> >& keylines;
+  int scale, numOctaves;
+  const std::vector<Mat>& masks;
+
+  LSDImagesInvoker& operator=( const LSDImagesInvoker& );  // to quiet MSVC
+};
+
 /* requires line detection (more than one image) */
 void LSDDetector::detect( const std::vector<Mat>& images, std::vector<std::vector<KeyLine> >& keylines, int scale, int numOctaves,
                           const std::vector<Mat>& masks ) const
 {
-  /* detect lines from each image */
-  for ( size_t counter = 0; counter < images.size(); counter++ )
+  if( !masks.empty() && masks.size() != images.size() )
+    throw std::runtime_error( "Masks error while detecting lines: please provide one mask for each image" );
+
+  /* check the inputs before the parallel loop */
+  for ( size_t counter = 0; counter < masks.size(); counter++ )
   {
     if( masks[counter].data != NULL && ( masks[counter].size() != images[counter].size() || masks[counter].type() != CV_8UC1 ) )
       throw std::runtime_error( "Masks error while detecting lines: please check their dimensions and that data types are CV_8UC1" );
+  }
+  for ( size_t counter = 0; counter < images.size(); counter++ )
+  {
+    if( images[counter].depth() != CV_8U )
+      throw std::runtime_error( "Error, depth image!= 0" );
+  }
+
+  /* create a pointer to self, the detection of an image does not modify the detector */
+  LSDDetector *lsd = const_cast<LSDDetector*>( this );
+
+  /* detect lines from each image */
+  keylines.resize( images.size() );
+  parallel_for_( Range( 0, (int) images.size() ), LSDImagesInvoker( *lsd, images, keylines, scale, numOctaves, masks ) );
+}
+
+/* requires line detection in a prebuilt pyramid */
+void LSDDetector::detectInPyramid( const std::vector<Mat>& pyramid, CV_OUT std::vector<KeyLine>& keylines, int scale, const Mat& mask ) const
+{
+  if( pyramid.empty() )
+    throw std::runtime_error( "Error, the pyramid is empty" );
 
-    else
-      detectImpl( images[counter], keylines[counter], numOctaves, scale, masks[counter] );
+  for ( size_t i = 0; i < pyramid.size(); i++ )
+  {
+    if( pyramid[i].type() != CV_8UC1 )
+      throw std::runtime_error( "Error, the octaves of the pyramid must be of type CV_8UC1" );
   }
+
+  if( mask.data != NULL && ( mask.size() != pyramid[0].size() || mask.type() != CV_8UC1 ) )
+    throw std::runtime_error( "Mask error while detecting lines: please check its dimensions and that data type is CV_8UC1" );
+
+  detectPyramidImpl( pyramid, keylines, scale, mask );
 }
 
 /* implementation of line detection */
@@ -132,31 +218,28 @@ void LSDDetector::detectImpl( const Mat& imageSrc, std::vector<KeyLine>& keyline
   if( imageSrc.channels() != 1 )
     cvtColor( imageSrc, image, COLOR_BGR2GRAY );
   else
-    image = imageSrc.clone();
+    image = imageSrc;
 
   /*check whether image depth is different from 0 */
   if( image.depth() != 0 )
     throw std::runtime_error( "Error, depth image!= 0" );
 
-  /* create a pointer to self */
-  LSDDetector *lsd = const_cast<LSDDetector*>( this );
+  /* compute Gaussian pyramids, the pyramid is local so that images can be processed in parallel */
+  std::vector<cv::Mat> gaussianPyrs;
+  computeGaussianPyramid( image, numOctaves, scale, gaussianPyrs );
 
-  /* compute Gaussian pyramids */
-  lsd->computeGaussianPyramid( image, numOctaves, scale );
-
-  /* create an LSD extractor */
-  cv::Ptr<cv::LineSegmentDetector> ls = cv::createLineSegmentDetector( cv::LSD_REFINE_ADV );
+  detectPyramidImpl( gaussianPyrs, keylines, scale, mask );
+}
 
-  /* prepare a vector to host extracted segments */
-  std::vector<std::vector<cv::Vec4f> > lines_lsd;
+/* implementation of line detection in the octaves of a pyramid */
+void LSDDetector::detectPyramidImpl( const std::vector<cv::Mat>& gaussianPyrs, std::vector<KeyLine>& keylines, int scale, const Mat& mask ) const
+{
+  /* extract lines, octave by octave in parallel */
+  std::vector<std::vector<cv::Vec4f> > lines_lsd( gaussianPyrs.size() );
+  parallel_for_( Range( 0, (int) gaussianPyrs.size() ), LSDOctavesInvoker( gaussianPyrs, lines_lsd ) );
 
-  /* extract lines */
-  for ( int i = 0; i < numOctaves; i++ )
-  {
-    std::vector<Vec4f> octave_lines;
-    ls->detect( gaussianPyrs[i], octave_lines );
-    lines_lsd.push_back( octave_lines );
-  }
+  /* the lines already in keylines are kept */
+  size_t firstNew = keylines.size();
 
   /* create keylines */
   int class_counter = -1;
@@ -197,18 +280,17 @@ void LSDDetector::detectImpl( const Mat& imageSrc, std::vector<KeyLine>& keyline
     }
   }
 
-  /* delete undesired KeyLines, according to input mask */
+  /* delete undesired KeyLines, according to input mask, keeping the order of the other ones */
   if( !mask.empty() )
   {
-    for ( size_t keyCounter = 0; keyCounter < keylines.size(); keyCounter++ )
+    size_t kept = firstNew;
+    for ( size_t keyCounter = firstNew; keyCounter < keylines.size(); keyCounter++ )
     {
-      KeyLine kl = keylines[keyCounter];
-      if( mask.at<uchar>( (int) kl.startPointY, (int) kl.startPointX ) == 0 && mask.at<uchar>( (int) kl.endPointY, (int) kl.endPointX ) == 0 )
-      {
-        keylines.erase( keylines.begin() + keyCounter );
-        keyCounter--;
-      }
+      const KeyLine& kl = keylines[keyCounter];
+      if( mask.at<uchar>( (int) kl.startPointY, (int) kl.startPointX ) != 0 || mask.at<uchar>( (int) kl.endPointY, (int) kl.endPointX ) != 0 )
+        keylines[kept++] = kl;
     }
+    keylines.resize( kept );
   }
 
 }
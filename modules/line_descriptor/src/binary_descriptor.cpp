@@ -40,6 +40,7 @@
  //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #ifdef _MSC_VER
     #if (_MSC_VER <= 1700)
@@ -683,6 +684,55 @@ void BinaryDescriptor::computeImpl( const Mat& imageSrc, std::vector<KeyLine>& k
 
 }
 
+/* extracts the lines of a range of octaves, each octave with its own EDLineDetector */
+class BinaryDescriptor::EDLineInvoker : public ParallelLoopBody
+{
+ public:
+  EDLineInvoker( const std::vector<Ptr<EDLineDetector> >& _detectors, std::vector<cv::Mat>& _images, std::vector<int>& _results ) :
+      detectors( _detectors ),
+      images( _images ),
+      results( _results )
+  {
+  }
+
+  void operator()( const Range& range ) const
+  {
+    for ( int octaveCount = range.start; octaveCount < range.end; octaveCount++ )
+      results[octaveCount] = detectors[octaveCount]->EDline( images[octaveCount] );
+  }
+
+ private:
+  const std::vector<Ptr<EDLineDetector> >& detectors;
+  std::vector<cv::Mat>& images;
+  std::vector<int>& results;
+
+  EDLineInvoker& operator=( const EDLineInvoker& ); // to quiet MSVC
+};
+
+/* computes the LBD descriptors of a range of groups of lines */
+class BinaryDescriptor::LBDInvoker : public ParallelLoopBody
+{
+ public:
+  LBDInvoker( const BinaryDescriptor& _descriptor, ScaleLines& _keyLines, bool _useDetectionData ) :
+      descriptor( _descriptor ),
+      keyLines( _keyLines ),
+      useDetectionData( _useDetectionData )
+  {
+  }
+
+  void operator()( const Range& range ) const
+  {
+    descriptor.computeLBD( keyLines, range, useDetectionData );
+  }
+
+ private:
+  const BinaryDescriptor& descriptor;
+  ScaleLines& keyLines;
+  bool useDetectionData;
+
+  LBDInvoker& operator=( const LBDInvoker& ); // to quiet MSVC
+};
+
 int BinaryDescriptor::OctaveKeyLines( cv::Mat& image, ScaleLines &keyLines )
 {
 
@@ -694,28 +744,19 @@ int BinaryDescriptor::OctaveKeyLines( cv::Mat& image, ScaleLines &keyLines )
   float curSigma2 = 1.0;  //[sqrt(2)]^0=1;
   double factor = sqrt( 2.0 );  //the down sample factor between connective two octave images
 
+  /* blurred images of the octaves, which only depend on the previous ones */
+  std::vector<cv::Mat> blurs( params.numOfOctave_ );
+
   /* loop over number of octaves */
   for ( int octaveCount = 0; octaveCount < params.numOfOctave_; octaveCount++ )
   {
-    /* matrix storing results from blurring processes */
-    cv::Mat blur;
-
     /* apply Gaussian blur */
     float increaseSigma = sqrt( curSigma2 - preSigma2 );
-    cv::GaussianBlur( image, blur, cv::Size( params.ksize_, params.ksize_ ), increaseSigma );
-    images_sizes[octaveCount] = blur.size();
-
-    /* for current octave, extract lines */
-    if( ( edLineVec_[octaveCount]->EDline( blur ) ) != 1 )
-    {
-      return -1;
-    }
-
-    /* update number of total extracted lines */
-    numOfFinalLine += edLineVec_[octaveCount]->lines_.numOfLines;
+    cv::GaussianBlur( image, blurs[octaveCount], cv::Size( params.ksize_, params.ksize_ ), increaseSigma );
+    images_sizes[octaveCount] = blurs[octaveCount].size();
 
     /* resize image for next level of pyramid */
-    cv::resize( blur, image, cv::Size(), ( 1.f / factor ), ( 1.f / factor ) );
+    cv::resize( blurs[octaveCount], image, cv::Size(), ( 1.f / factor ), ( 1.f / factor ) );
 
     /* update sigma values */
     preSigma2 = curSigma2;
@@ -723,6 +764,21 @@ int BinaryDescriptor::OctaveKeyLines( cv::Mat& image, ScaleLines &keyLines )
 
   } /* end of loop over number of octaves */
 
+  /* extract lines from all the octaves at once, each with its own EDLineDetector */
+  std::vector<int> results( params.numOfOctave_ );
+  parallel_for_( Range( 0, params.numOfOctave_ ), EDLineInvoker( edLineVec_, blurs, results ) );
+
+  for ( int octaveCount = 0; octaveCount < params.numOfOctave_; octaveCount++ )
+  {
+    if( results[octaveCount] != 1 )
+    {
+      return -1;
+    }
+
+    /* update number of total extracted lines */
+    numOfFinalLine += edLineVec_[octaveCount]->lines_.numOfLines;
+  }
+
   /* prepare a vector to store octave information associated to extracted lines */
   std::vector < OctaveLine > octaveLines( numOfFinalLine );
 
@@ -1021,11 +1077,17 @@ int BinaryDescriptor::OctaveKeyLines( cv::Mat& image, ScaleLines &keyLines )
 }
 
 int BinaryDescriptor::computeLBD( ScaleLines &keyLines, bool useDetectionData )
+{
+  /* the groups of lines are independent, so they are described in parallel */
+  parallel_for_( Range( 0, (int) keyLines.size() ), LBDInvoker( *this, keyLines, useDetectionData ) );
+  return 1;
+}
+
+void BinaryDescriptor::computeLBD( ScaleLines &keyLines, const Range &range, bool useDetectionData ) const
 {
   //the default length of the band is the line length.
-  short numOfFinalLine = (short) keyLines.size();
-  float *dL = new float[2];  //line direction cos(dir), sin(dir)
-  float *dO = new float[2];  //the clockwise orthogonal vector of line direction.
+  float dL[2];  //line direction cos(dir), sin(dir)
+  float dO[2];  //the clockwise orthogonal vector of line direction.
   short heightOfLSP = (short) ( params.widthOfBand_ * NUM_OF_BANDS );  //the height of line support region;
   short descriptor_size = NUM_OF_BANDS * 8;  //each band, we compute the m( pgdL, ngdL,  pgdO, ngdO) and std( pgdL, ngdL,  pgdO, ngdO);
   float pgdLRowSum;  //the summation of {g_dL |g_dL>0 } for each row of the region;
@@ -1037,14 +1099,14 @@ int BinaryDescriptor::computeLBD( ScaleLines &keyLines, bool useDetectionData )
   float pgdO2RowSum;  //the summation of {g_dO^2 |g_dO>0 } for each row of the region;
   float ngdO2RowSum;  //the summation of {g_dO^2 |g_dO<0 } for each row of the region;
 
-  float *pgdLBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL |g_dL>0 } for each band of the region;
-  float *ngdLBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL |g_dL<0 } for each band of the region;
-  float *pgdL2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL^2 |g_dL>0 } for each band of the region;
-  float *ngdL2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dL^2 |g_dL<0 } for each band of the region;
-  float *pgdOBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO |g_dO>0 } for each band of the region;
-  float *ngdOBandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO |g_dO<0 } for each band of the region;
-  float *pgdO2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO^2 |g_dO>0 } for each band of the region;
-  float *ngdO2BandSum = new float[NUM_OF_BANDS];  //the summation of {g_dO^2 |g_dO<0 } for each band of the region;
+  float pgdLBandSum[NUM_OF_BANDS];  //the summation of {g_dL |g_dL>0 } for each band of the region;
+  float ngdLBandSum[NUM_OF_BANDS];  //the summation of {g_dL |g_dL<0 } for each band of the region;
+  float pgdL2BandSum[NUM_OF_BANDS];  //the summation of {g_dL^2 |g_dL>0 } for each band of the region;
+  float ngdL2BandSum[NUM_OF_BANDS];  //the summation of {g_dL^2 |g_dL<0 } for each band of the region;
+  float pgdOBandSum[NUM_OF_BANDS];  //the summation of {g_dO |g_dO>0 } for each band of the region;
+  float ngdOBandSum[NUM_OF_BANDS];  //the summation of {g_dO |g_dO<0 } for each band of the region;
+  float pgdO2BandSum[NUM_OF_BANDS];  //the summation of {g_dO^2 |g_dO>0 } for each band of the region;
+  float ngdO2BandSum[NUM_OF_BANDS];  //the summation of {g_dO^2 |g_dO<0 } for each band of the region;
 
   short numOfBitsBand = NUM_OF_BANDS * sizeof(float);
   short lengthOfLSP;  //the length of line support region, varies with lines
@@ -1055,18 +1117,22 @@ int BinaryDescriptor::computeLBD( ScaleLines &keyLines, bool useDetectionData )
   float lineMiddlePointX, lineMiddlePointY;
   float sCorX, sCorY, sCorX0, sCorY0;
   short tempCor, xCor, yCor;  //pixel coordinates in image plane
-  short dx, dy;
   float gDL;  //store the gradient projection of pixels in support region along dL vector
   float gDO;  //store the gradient projection of pixels in support region along dO vector
   short imageWidth, imageHeight, realWidth;
-  short *pdxImg, *pdyImg;
+  const short *pdxImg, *pdyImg;
   float *desVec;
 
+  /* the gradients of the current row of the line support region, gathered
+   before being projected */
+  cv::AutoBuffer<float> rowGradients;
+  float *rowDx, *rowDy;
+
   short sameLineSize;
   short octaveCount;
   OctaveSingleLine *pSingleLine;
   /* loop over list of LineVec */
-  for ( short lineIDInScaleVec = 0; lineIDInScaleVec < numOfFinalLine; lineIDInScaleVec++ )
+  for ( int lineIDInScaleVec = range.start; lineIDInScaleVec < range.end; lineIDInScaleVec++ )
   {
     sameLineSize = (short) ( keyLines[lineIDInScaleVec].size() );
     /* loop over current LineVec's lines */
@@ -1113,6 +1179,9 @@ int BinaryDescriptor::computeLBD( ScaleLines &keyLines, bool useDetectionData )
       /* get length of line and its half */
       lengthOfLSP = (short) keyLines[lineIDInScaleVec][lineIDInSameLine].numOfPixels;
       halfWidth = ( lengthOfLSP - 1 ) / 2;
+      rowGradients.allocate( 2 * lengthOfLSP );
+      rowDx = rowGradients;
+      rowDy = rowDx + lengthOfLSP;
 
       /* get middlepoint of line */
       lineMiddlePointX = (float) ( 0.5 * ( pSingleLine->sPointInOctaveX + pSingleLine->ePointInOctaveX ) );
@@ -1154,12 +1223,39 @@ int BinaryDescriptor::computeLBD( ScaleLines &keyLines, bool useDetectionData )
           tempCor = (short) round( sCorY );
           yCor = ( tempCor < 0 ) ? 0 : ( tempCor > imageHeight ) ? imageHeight : tempCor;
 
-          /* To achieve rotation invariance, each simple gradient is rotated aligned with
-           * the line direction and clockwise orthogonal direction.*/
-          dx = pdxImg[yCor * realWidth + xCor];
-          dy = pdyImg[yCor * realWidth + xCor];
-          gDL = dx * dL[0] + dy * dL[1];
-          gDO = dx * dO[0] + dy * dO[1];
+          rowDx[wID] = pdxImg[yCor * realWidth + xCor];
+          rowDy[wID] = pdyImg[yCor * realWidth + xCor];
+          sCorX += dL[0];
+          sCorY += dL[1];
+        }
+
+        /* To achieve rotation invariance, each simple gradient is rotated aligned with
+         * the line direction and clockwise orthogonal direction.*/
+        short wID = 0;
+#if CV_SIMD128
+        v_float32x4 vdL0 = v_setall_f32( dL[0] ), vdL1 = v_setall_f32( dL[1] );
+        v_float32x4 vdO0 = v_setall_f32( dO[0] ), vdO1 = v_setall_f32( dO[1] );
+        v_float32x4 vzero = v_setzero_f32();
+        v_float32x4 vpgdL = vzero, vngdL = vzero, vpgdO = vzero, vngdO = vzero;
+        for ( ; wID <= lengthOfLSP - 4; wID += 4 )
+        {
+          v_float32x4 vdx = v_load( rowDx + wID ), vdy = v_load( rowDy + wID );
+          v_float32x4 vgDL = vdx * vdL0 + vdy * vdL1;
+          v_float32x4 vgDO = vdx * vdO0 + vdy * vdO1;
+          vpgdL += v_max( vgDL, vzero );
+          vngdL -= v_min( vgDL, vzero );
+          vpgdO += v_max( vgDO, vzero );
+          vngdO -= v_min( vgDO, vzero );
+        }
+        pgdLRowSum = v_reduce_sum( vpgdL );
+        ngdLRowSum = v_reduce_sum( vngdL );
+        pgdORowSum = v_reduce_sum( vpgdO );
+        ngdORowSum = v_reduce_sum( vngdO );
+#endif
+        for ( ; wID < lengthOfLSP; wID++ )
+        {
+          gDL = rowDx[wID] * dL[0] + rowDy[wID] * dL[1];
+          gDO = rowDx[wID] * dO[0] + rowDy[wID] * dO[1];
           if( gDL > 0 )
           {
             pgdLRowSum += gDL;
@@ -1176,9 +1272,6 @@ int BinaryDescriptor::computeLBD( ScaleLines &keyLines, bool useDetectionData )
           {
             ngdORowSum -= gDO;
           }
-          sCorX += dL[0];
-          sCorY += dL[1];
-          /* gDLMat[hID][wID] = gDL; */
         }
         sCorX0 -= dL[1];
         sCorY0 += dL[0];
@@ -1338,33 +1431,8 @@ int BinaryDescriptor::computeLBD( ScaleLines &keyLines, bool useDetectionData )
       }
     }/* end for(short lineIDInSameLine = 0; lineIDInSameLine<sameLineSize;
      lineIDInSameLine++) */
-
-    cv::Mat appoggio = cv::Mat( 1, 32, CV_32FC1 );
-    float* pointerToRow = appoggio.ptr<float>( 0 );
-    for ( int g = 0; g < 32; g++ )
-    {
-      /* get LBD data */
-      float* des_Vec = &keyLines[lineIDInScaleVec][0].descriptor.front();
-      *pointerToRow = des_Vec[g];
-      pointerToRow++;
-
-    }
-
-  }/* end for(short lineIDInScaleVec = 0;
-   lineIDInScaleVec<numOfFinalLine; lineIDInScaleVec++) */
-
-  delete[] dL;
-  delete[] dO;
-  delete[] pgdLBandSum;
-  delete[] ngdLBandSum;
-  delete[] pgdL2BandSum;
-  delete[] ngdL2BandSum;
-  delete[] pgdOBandSum;
-  delete[] ngdOBandSum;
-  delete[] pgdO2BandSum;
-  delete[] ngdO2BandSum;
-
-  return 1;
+  }/* end for(int lineIDInScaleVec = range.start;
+   lineIDInScaleVec<range.end; lineIDInScaleVec++) */
 
 }
 
@@ -1478,15 +1546,14 @@ int BinaryDescriptor::EDLineDetector::EdgeDrawing( cv::Mat &image, EdgeChains &e
   cv::Sobel( image, dyImg_, CV_16SC1, 0, 1, 3 );
 
   //compute gradient and direction images
-  cv::Mat dxABS_m = cv::abs( dxImg_ );
-  cv::Mat dyABS_m = cv::abs( dyImg_ );
-  cv::Mat sumDxDy;
-  cv::add( dyABS_m, dxABS_m, sumDxDy );
+  dxABS_ = cv::abs( dxImg_ );
+  dyABS_ = cv::abs( dyImg_ );
+  cv::add( dyABS_, dxABS_, sumDxDy_ );
 
-  cv::threshold( sumDxDy, gImg_, gradienThreshold_ + 1, 255, cv::THRESH_TOZERO );
+  cv::threshold( sumDxDy_, gImg_, gradienThreshold_ + 1, 255, cv::THRESH_TOZERO );
   gImg_ = gImg_ / 4;
-  gImgWO_ = sumDxDy / 4;
-  cv::compare( dxABS_m, dyABS_m, dirImg_, cv::CMP_LT );
+  gImgWO_ = sumDxDy_ / 4;
+  cv::compare( dxABS_, dyABS_, dirImg_, cv::CMP_LT );
 
   short *pgImg = gImg_.ptr<short>();
   unsigned char *pdirImg = dirImg_.ptr();
@@ -2240,7 +2307,7 @@ int BinaryDescriptor::EDLineDetector::EDline( cv::Mat &image, LineChains &lines
 {
 
   //first, call EdgeDrawing function to extract edges
-  EdgeChains edges;
+  EdgeChains &edges = edges_;
   if( ( EdgeDrawing( image, edges ) ) != 1 )
   {
     std::cout << "Line Detection not finished" << std::endl;
@@ -2261,8 +2328,8 @@ int BinaryDescriptor::EDLineDetector::EDline( cv::Mat &image, LineChains &lines
   logNT_ = 2.0 * ( log10( (double) imageWidth ) + log10( (double) imageHeight ) );
   double lineFitErr = 0;    //the line fit error;
   std::vector<double> lineEquation( 2, 0 );
-  lineEquations_.clear();
-  lineEndpoints_.clear();
+  std::vector<double> lineEqu( 3, 0 );
+  float lineEndP[4];    //line endpoints
   lineDirection_.clear();
   unsigned char *pdirImg = dirImg_.data;
   unsigned int numOfLines = 0;
@@ -2345,20 +2412,16 @@ int BinaryDescriptor::EDLineDetector::EDline( cv::Mat &image, LineChains &lines
           }
         }
         //the line equation coefficients,for line w1x+w2y+w3 =0, we normalize it to make w1^2+w2^2 = 1.
-        std::vector<double> lineEqu( 3, 0 );
         lineEqu[0] = lineEquation[0] * coef1;
         lineEqu[1] = -1 * coef1;
         lineEqu[2] = lineEquation[1] * coef1;
         if( LineValidation_( pLineXCors, pLineYCors, pLineSID[numOfLines], offsetInLineArray, lineEqu, direction ) )
         {           //check the line
-          //store the line equation coefficients
-          lineEquations_.push_back( lineEqu );
           /*At last, compute the line endpoints and store them.
            *we project the first and last pixels in the pixelChain onto the best fit line
            *to get the line endpoints.
            *xp= (w2^2*x0-w1*w2*y0-w3*w1)/(w1^2+w2^2)
            *yp= (w1^2*y0-w1*w2*x0-w3*w2)/(w1^2+w2^2)  */
-          std::vector<float> lineEndP( 4, 0 );          //line endpoints
           double a1 = lineEqu[1] * lineEqu[1];
           double a2 = lineEqu[0] * lineEqu[0];
           double a3 = lineEqu[0] * lineEqu[1];
@@ -2372,8 +2435,8 @@ int BinaryDescriptor::EDLineDetector::EDline( cv::Mat &image, LineChains &lines
           Py = pLineYCors[offsetInLineArray - 1];
           lineEndP[2] = (float) ( a1 * Px - a3 * Py - a4 );         //x
           lineEndP[3] = (float) ( a2 * Py - a3 * Px - a5 );         //y
-          lineEndpoints_.push_back( lineEndP );
-          lineDirection_.push_back( direction );
+          //store the line equation coefficients, the endpoints and the direction
+          StoreLine_( numOfLines, lineEqu, lineEndP, direction );
           numOfLines++;
         }
         else
@@ -2431,21 +2494,17 @@ int BinaryDescriptor::EDLineDetector::EDline( cv::Mat &image, LineChains &lines
           }
         }
         //the line equation coefficients,for line w1x+w2y+w3 =0, we normalize it to make w1^2+w2^2 = 1.
-        std::vector<double> lineEqu( 3, 0 );
         lineEqu[0] = 1 * coef1;
         lineEqu[1] = -lineEquation[0] * coef1;
         lineEqu[2] = -lineEquation[1] * coef1;
 
         if( LineValidation_( pLineXCors, pLineYCors, pLineSID[numOfLines], offsetInLineArray, lineEqu, direction ) )
         {           //check the line
-          //store the line equation coefficients
-          lineEquations_.push_back( lineEqu );
           /*At last, compute the line endpoints and store them.
            *we project the first and last pixels in the pixelChain onto the best fit line
            *to get the line endpoints.
            *xp= (w2^2*x0-w1*w2*y0-w3*w1)/(w1^2+w2^2)
            *yp= (w1^2*y0-w1*w2*x0-w3*w2)/(w1^2+w2^2)  */
-          std::vector<float> lineEndP( 4, 0 );          //line endpoints
           double a1 = lineEqu[1] * lineEqu[1];
           double a2 = lineEqu[0] * lineEqu[0];
           double a3 = lineEqu[0] * lineEqu[1];
@@ -2459,8 +2518,8 @@ int BinaryDescriptor::EDLineDetector::EDline( cv::Mat &image, LineChains &lines
           Py = pLineYCors[offsetInLineArray - 1];
           lineEndP[2] = (float) ( a1 * Px - a3 * Py - a4 );         //x
           lineEndP[3] = (float) ( a2 * Py - a3 * Px - a5 );         //y
-          lineEndpoints_.push_back( lineEndP );
-          lineDirection_.push_back( direction );
+          //store the line equation coefficients, the endpoints and the direction
+          StoreLine_( numOfLines, lineEqu, lineEndP, direction );
           numOfLines++;
         }
         else
@@ -2478,6 +2537,24 @@ int BinaryDescriptor::EDLineDetector::EDline( cv::Mat &image, LineChains &lines
   return 1;
 }
 
+void BinaryDescriptor::EDLineDetector::StoreLine_( unsigned int lineID, const std::vector<double> &lineEquation, const float *lineEndpoints,
+                                                   float direction )
+{
+  /* the inner vectors of the previous images are overwritten, so that
+   a video stream of similar images doesn't allocate them again */
+  if( lineID < lineEquations_.size() )
+    std::copy( lineEquation.begin(), lineEquation.end(), lineEquations_[lineID].begin() );
+  else
+    lineEquations_.push_back( lineEquation );
+
+  if( lineID < lineEndpoints_.size() )
+    std::copy( lineEndpoints, lineEndpoints + 4, lineEndpoints_[lineID].begin() );
+  else
+    lineEndpoints_.push_back( std::vector<float>( lineEndpoints, lineEndpoints + 4 ) );
+
+  lineDirection_.push_back( direction );
+}
+
 double BinaryDescriptor::EDLineDetector::LeastSquaresLineFit_( unsigned int *xCors, unsigned int *yCors, unsigned int offsetS,
                                                                std::vector<double> &lineEquation )
 {
@@ -592,47 +592,56 @@ void BinaryDescriptorMatcher::radiusMatch( const Mat& queryDescriptors, std::vec
 
 }
 
-/* execute a batch query */
-void BinaryDescriptorMatcher::Mihasher::batchquery( UINT32 * results, UINT32 *numres, const cv::Mat & queries, UINT32 numq, int dim1queries )
+/* queries a range of descriptors: every thread has its own duplicates
+ counter and its own buffers, the results of query i go to their own rows */
+class BinaryDescriptorMatcher::Mihasher::QueryInvoker : public ParallelLoopBody
 {
-  /* create and initialize a bitarray */
-  counter = new bitarray;
-  counter->init( N );
-
-  UINT32 *res = new UINT32[K * ( D + 1 )];
-  UINT64 *chunks = new UINT64[m];
-  UINT32 * presults = results;
-  UINT32 *pnumres = numres;
-
-  /* make a copy of input queries */
-  cv::Mat queries_clone = queries.clone();
-
-  /* set a pointer to first query (row) */
-  UINT8 *pq = queries_clone.ptr();
+ public:
+  QueryInvoker( Mihasher& _mihasher, UINT32 * _results, UINT32 * _numres, const cv::Mat& _queries ) :
+      mihasher( _mihasher ),
+      results( _results ),
+      numres( _numres ),
+      queries( _queries )
+  {
+  }
 
-  /* loop over number of descriptors */
-  for ( size_t i = 0; i < numq; i++ )
+  void operator()( const Range& range ) const
   {
-    /* for every descriptor, query database */
-    query( presults, pnumres, pq, chunks, res );
+    bitarray counter;
+    counter.init( mihasher.N );
+    std::vector<UINT32> res( std::max( mihasher.K * ( mihasher.D + 1 ), 1 ) );
+    std::vector<UINT64> chunks( mihasher.m );
+    int power[100];
 
-    /* move pointer to write next K indeces */
-    presults += K;
-    pnumres += B + 1;
+    for ( int i = range.start; i < range.end; i++ )
+    {
+      UINT8 *pq = const_cast<UINT8*>( queries.ptr( i ) );
+      mihasher.query( results + (size_t) i * mihasher.K, numres + (size_t) i * ( mihasher.B + 1 ), pq, &chunks[0], &res[0], counter, power );
+    }
+  }
 
-    /* move forward pointer to current row in descriptors matrix */
-    pq += dim1queries;
+ private:
+  Mihasher& mihasher;
+  UINT32 * results;
+  UINT32 * numres;
+  const cv::Mat& queries;
 
-  }
+  QueryInvoker& operator=( const QueryInvoker& ); // to quiet MSVC
+};
 
-  delete[] res;
-  delete[] chunks;
+/* execute a batch query */
+void BinaryDescriptorMatcher::Mihasher::batchquery( UINT32 * results, UINT32 *numres, const cv::Mat & queries, UINT32 numq, int dim1queries )
+{
+  CV_Assert( (int) numq <= queries.rows && queries.cols * (int) queries.elemSize() >= dim1queries );
 
-  delete counter;
+  /* the queries are read-only, the hashtables too: they can be processed
+   concurrently. Each stripe is big enough to amortize its counter of N bits */
+  parallel_for_( Range( 0, (int) numq ), QueryInvoker( *this, results, numres, queries ), std::max( 1., numq / 64. ) );
 }
 
 /* execute a single query */
-void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres, UINT8 * Query, UINT64 *chunks, UINT32 *res )
+void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres, UINT8 * Query, UINT64 *chunks, UINT32 *res, bitarray & counter,
+                                                int * power )
 {
   /* if K == 0 that means we want everything to be processed.
    So maxres = N in that case. Otherwise K limits the results processed */
@@ -654,7 +663,7 @@ void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres,
   UINT32 index;
   int hammd;
 
-  counter->erase();
+  counter.erase();
   memset( numres, 0, ( B + 1 ) * sizeof ( *numres ) );
 
   split( chunks, Query, m, mplus, b );
@@ -712,9 +721,9 @@ void BinaryDescriptorMatcher::Mihasher::query( UINT32* results, UINT32* numres,
             for ( int c = 0; c < size; c++ )
             {
               index = arr[c];
-              if( !counter->get( index ) )
+              if( !counter.get( index ) )
               { /* if it is not a duplicate */
-                counter->set( index );
+                counter.set( index );
                 hammd = cv::line_descriptor::match( codes.ptr() + (UINT64) index * ( B_over_8 ), Query, B_over_8 );
 
                 nc++;
@@ -796,26 +805,50 @@ BinaryDescriptorMatcher::Mihasher::~Mihasher()
   delete[] H;
 }
 
+/* fills a range of hashtables: the tables are independent from each other
+ and each of them receives the codes in the same order as a serial insertion */
+class BinaryDescriptorMatcher::Mihasher::PopulateInvoker : public ParallelLoopBody
+{
+ public:
+  PopulateInvoker( Mihasher& _mihasher, const std::vector<UINT64>& _chunks ) :
+      mihasher( _mihasher ),
+      chunks( _chunks )
+  {
+  }
+
+  void operator()( const Range& range ) const
+  {
+    const int m = mihasher.m;
+    for ( int k = range.start; k < range.end; k++ )
+    {
+      const UINT64 * pchunks = &chunks[k];
+      for ( UINT64 i = 0; i < mihasher.N; i++, pchunks += m )
+        mihasher.H[k].insert( *pchunks, (UINT32) i );
+    }
+  }
+
+ private:
+  Mihasher& mihasher;
+  const std::vector<UINT64>& chunks;
+
+  PopulateInvoker& operator=( const PopulateInvoker& ); // to quiet MSVC
+};
+
 /* populate tables */
 void BinaryDescriptorMatcher::Mihasher::populate( cv::Mat & _codes, UINT32 N_val, int dim1codes )
 {
   N = N_val;
   codes = _codes;
-  UINT64 * chunks = new UINT64[m];
+  if( N == 0 )
+    return;
 
+  /* split every code once, then fill the m hashtables in parallel */
+  std::vector<UINT64> chunks( (size_t) N * m );
   UINT8 * pcodes = codes.ptr();
   for ( UINT64 i = 0; i < N; i++, pcodes += dim1codes )
-  {
-    split( chunks, pcodes, m, mplus, b );
-
-    for ( int k = 0; k < m; k++ )
-      H[k].insert( chunks[k], (UINT32) i );
-
-    if( i % (int) ceil( N / 1000.0 ) == 0 )
-      fflush (stdout);
-  }
+    split( &chunks[(size_t) i * m], pcodes, m, mplus, b );
 
-  delete[] chunks;
+  parallel_for_( Range( 0, m ), PopulateInvoker( *this, chunks ) );
 }
 
 /* constructor */
@@ -337,3 +337,91 @@ TEST( BinaryDescriptor_Detector, regression )
   CV_BinaryDescriptorDetectorTest test( std::string( "edl_detector_keylines_cameraman" ) );
   test.safe_run();
 }
+
+TEST( BinaryDescriptor_Detector, repeated_detection )
+{
+  Mat first( 240, 320, CV_8UC1, Scalar::all( 30 ) ), second( 240, 320, CV_8UC1, Scalar::all( 30 ) );
+  rectangle( first, Rect( 40, 30, 150, 110 ), Scalar::all( 220 ), -1 );
+  line( first, Point( 20, 210 ), Point( 300, 150 ), Scalar::all( 200 ), 3 );
+  for ( int i = 0; i < 6; i++ )
+    rectangle( second, Rect( 20 + 45 * i, 40 + 10 * i, 30, 120 ), Scalar::all( 120 + 20 * i ), -1 );
+
+  /* the buffers kept by the detector between images must not change the results */
+  Ptr<BinaryDescriptor> bd = BinaryDescriptor::createBinaryDescriptor();
+  std::vector<KeyLine> keylines, keylinesOther, keylinesAgain;
+  Mat descriptors, descriptorsAgain;
+  bd->detect( first, keylines );
+  bd->compute( first, keylines, descriptors );
+  bd->detect( second, keylinesOther );
+  bd->detect( first, keylinesAgain );
+  bd->compute( first, keylinesAgain, descriptorsAgain );
+
+  ASSERT_FALSE( keylines.empty() );
+  ASSERT_EQ( keylines.size(), keylinesAgain.size() );
+  for ( size_t i = 0; i < keylines.size(); i++ )
+  {
+    EXPECT_EQ( keylines[i].startPointX, keylinesAgain[i].startPointX );
+    EXPECT_EQ( keylines[i].startPointY, keylinesAgain[i].startPointY );
+    EXPECT_EQ( keylines[i].endPointX, keylinesAgain[i].endPointX );
+    EXPECT_EQ( keylines[i].endPointY, keylinesAgain[i].endPointY );
+    EXPECT_EQ( keylines[i].octave, keylinesAgain[i].octave );
+  }
+  EXPECT_EQ( 0, norm( descriptors, descriptorsAgain, NORM_HAMMING ) );
+}
+
+TEST( LSDDetector_Detector, images_and_pyramid_same_as_image )
+{
+  Mat first( 240, 320, CV_8UC1, Scalar::all( 30 ) ), second( 200, 260, CV_8UC3, Scalar::all( 30 ) );
+  rectangle( first, Rect( 40, 30, 150, 110 ), Scalar::all( 220 ), -1 );
+  line( first, Point( 20, 210 ), Point( 300, 150 ), Scalar::all( 200 ), 3 );
+  for ( int i = 0; i < 5; i++ )
+    rectangle( second, Rect( 20 + 45 * i, 40 + 10 * i, 30, 120 ), Scalar( 120 + 20 * i, 60, 200 - 20 * i ), -1 );
+  Mat mask( first.size(), CV_8UC1, Scalar::all( 0 ) );
+  mask( Rect( 0, 0, 160, 240 ) ) = Scalar::all( 255 );
+
+  const int scale = 2, numOctaves = 3;
+  Ptr<LSDDetector> lsd = LSDDetector::createLSDDetector();
+  std::vector<KeyLine> firstLines, secondLines;
+  lsd->detect( first, firstLines, scale, numOctaves, mask );
+  lsd->detect( second, secondLines, scale, numOctaves );
+  ASSERT_FALSE( firstLines.empty() );
+  ASSERT_FALSE( secondLines.empty() );
+
+  /* the images processed in parallel */
+  std::vector<Mat> images, masks;
+  images.push_back( first );
+  images.push_back( second );
+  masks.push_back( mask );
+  masks.push_back( Mat() );
+  std::vector<std::vector<KeyLine> > linesOfImages;
+  lsd->detect( images, linesOfImages, scale, numOctaves, masks );
+  ASSERT_EQ( 2u, linesOfImages.size() );
+
+  /* the same pyramid given to the detector */
+  std::vector<Mat> pyramid( 1, first );
+  for ( int i = 1; i < numOctaves; i++ )
+  {
+    Mat octave;
+    pyrDown( pyramid.back(), octave, Size( pyramid.back().cols / scale, pyramid.back().rows / scale ) );
+    pyramid.push_back( octave );
+  }
+  std::vector<KeyLine> pyramidLines;
+  lsd->detectInPyramid( pyramid, pyramidLines, scale, mask );
+
+  const std::vector<KeyLine>* results[] = { &linesOfImages[0], &linesOfImages[1], &pyramidLines };
+  const std::vector<KeyLine>* expected[] = { &firstLines, &secondLines, &firstLines };
+  for ( int r = 0; r < 3; r++ )
+  {
+    ASSERT_EQ( expected[r]->size(), results[r]->size() ) << "result " << r;
+    for ( size_t i = 0; i < expected[r]->size(); i++ )
+    {
+      const KeyLine &a = ( *expected[r] )[i], &b = ( *results[r] )[i];
+      EXPECT_EQ( a.startPointX, b.startPointX );
+      EXPECT_EQ( a.startPointY, b.startPointY );
+      EXPECT_EQ( a.endPointX, b.endPointX );
+      EXPECT_EQ( a.endPointY, b.endPointY );
+      EXPECT_EQ( a.octave, b.octave );
+      EXPECT_EQ( a.class_id, b.class_id );
+    }
+  }
+}
@@ -577,3 +577,38 @@ TEST( BinaryDescriptor_Matcher, regression)
   CV_BinaryDescriptorMatcherTest test( 0.01f );
   test.safe_run();
 }
+
+TEST( BinaryDescriptor_Matcher, parallel_batch_query )
+{
+  Mat query( 500, 32, CV_8UC1 ), train( 2000, 32, CV_8UC1 );
+  RNG& rng = theRNG();
+  rng.fill( query, RNG::UNIFORM, 0, 256 );
+  rng.fill( train, RNG::UNIFORM, 0, 256 );
+
+  Ptr<BinaryDescriptorMatcher> matcher = BinaryDescriptorMatcher::createBinaryDescriptorMatcher();
+  std::vector<std::vector<DMatch> > matches, matches_serial;
+  matcher->knnMatch( query, train, matches, 3 );
+
+  /* the queries and the hashtables don't depend on the number of threads */
+  int threads = getNumThreads();
+  setNumThreads( 1 );
+  matcher->knnMatch( query, train, matches_serial, 3 );
+  setNumThreads( threads );
+
+  ASSERT_EQ( matches.size(), matches_serial.size() );
+  for ( size_t i = 0; i < matches.size(); i++ )
+  {
+    ASSERT_EQ( matches[i].size(), matches_serial[i].size() );
+    for ( size_t j = 0; j < matches[i].size(); j++ )
+    {
+      EXPECT_EQ( matches[i][j].trainIdx, matches_serial[i][j].trainIdx );
+      EXPECT_EQ( matches[i][j].distance, matches_serial[i][j].distance );
+    }
+
+    /* the best match is the one a brute-force search finds */
+    double best = DBL_MAX;
+    for ( int t = 0; t < train.rows; t++ )
+      best = std::min( best, norm( query.row( (int) i ), train.row( t ), NORM_HAMMING ) );
+    EXPECT_EQ( best, matches[i][0].distance );
+  }
+}
@@ -47,6 +47,7 @@
 */
 
 #include "mxarray.hpp"
+#include "transpose.hpp"
 #include <vector>
 #include <string>
 #include <opencv2/core.hpp>
@@ -109,6 +110,8 @@ void deepCopyAndTranspose(const cv::Mat& src, matlab::MxArray& dst);
 template <typename InputScalar, typename OutputScalar>
 void deepCopyAndTranspose(const matlab::MxArray& src, cv::Mat& dst);
 
+cv::Mat transposedView(const matlab::MxArray& arr);
+
 
 
 
@@ -223,6 +226,14 @@ public:
   cv::Mat toMat() const;
   operator cv::Mat() const { return toMat(); }
 
+  /*!
+   * @brief zero-copy view of a 2D single-channel array
+   *
+   * Returns a cols x rows header over the Matlab data, i.e. the transpose of
+   * the Matlab matrix, without copying. See transposedView()
+   */
+  cv::Mat toMatTransposedView() const { return transposedView(ptr_); }
+
   template <typename Scalar>
   static matlab::MxArray FromMat(const cv::Mat& mat) {
     matlab::MxArray arr(mat.rows, mat.cols, mat.channels(), matlab::Traits<Scalar>::ScalarType);
@@ -587,23 +598,32 @@ cv::Mat Bridge::toMat() const { return toMat<matlab::InheritType>(); }
 // ----------------------------------------------------------------------------
 
 
+/*
+ * Saturating element conversion of the copies, as cv::Mat::convertTo.
+ * char is a distinct type from schar and has no saturate_cast of its own
+ */
+template <typename OutputScalar>
+struct SaturateCast {
+  template <typename InputScalar>
+  OutputScalar operator()(InputScalar v) const { return cv::saturate_cast<OutputScalar>(v); }
+  OutputScalar operator()(char v) const { return cv::saturate_cast<OutputScalar>(static_cast<schar>(v)); }
+};
+
+/*
+ * The copies run in a single blocked pass per channel from the source
+ * straight into the destination, without intermediate matrices
+ */
 template <typename InputScalar, typename OutputScalar>
 void deepCopyAndTranspose(const cv::Mat& in, matlab::MxArray& out) {
   matlab::conditionalError(static_cast<size_t>(in.rows) == out.rows(), "Matrices must have the same number of rows");
   matlab::conditionalError(static_cast<size_t>(in.cols) == out.cols(), "Matrices must have the same number of cols");
   matlab::conditionalError(static_cast<size_t>(in.channels()) == out.channels(), "Matrices must have the same number of channels");
-  std::vector<cv::Mat> channels;
-  cv::split(in, channels);
-  for (size_t c = 0; c < out.channels(); ++c) {
-    cv::transpose(channels[c], channels[c]);
-    cv::Mat outmat(out.cols(), out.rows(), cv::DataType<OutputScalar>::type,
-      static_cast<void *>(out.real<OutputScalar>() + out.cols()*out.rows()*c));
-    channels[c].convertTo(outmat, cv::DataType<OutputScalar>::type);
-  }
-
-  //const InputScalar* inp = in.ptr<InputScalar>(0);
-  //OutputScalar* outp = out.real<OutputScalar>();
-  //gemt('R', out.rows(), out.cols(), inp, in.step1(), outp, out.rows());
+  const size_t rows = out.rows(), cols = out.cols(), cn = out.channels();
+  if (rows == 0 || cols == 0) return;
+  const InputScalar* inp = in.ptr<InputScalar>(0);
+  OutputScalar* outp = out.real<OutputScalar>();
+  for (size_t c = 0; c < cn; ++c)
+    transposeCast(rows, cols, inp + c, in.step1(), cn, outp + rows*cols*c, rows, 1, SaturateCast<OutputScalar>());
 }
 
 template <typename InputScalar, typename OutputScalar>
@@ -611,20 +631,43 @@ void deepCopyAndTranspose(const matlab::MxArray& in, cv::Mat& out) {
   matlab::conditionalError(in.rows() == static_cast<size_t>(out.rows), "Matrices must have the same number of rows");
   matlab::conditionalError(in.cols() == static_cast<size_t>(out.cols), "Matrices must have the same number of cols");
   matlab::conditionalError(in.channels() == static_cast<size_t>(out.channels()), "Matrices must have the same number of channels");
-  std::vector<cv::Mat> channels;
-  for (size_t c = 0; c < in.channels(); ++c) {
-    cv::Mat outmat;
-    cv::Mat inmat(in.cols(), in.rows(), cv::DataType<InputScalar>::type,
-      static_cast<void *>(const_cast<InputScalar *>(in.real<InputScalar>() + in.cols()*in.rows()*c)));
-    inmat.convertTo(outmat, cv::DataType<OutputScalar>::type);
-    cv::transpose(outmat, outmat);
-    channels.push_back(outmat);
-  }
-  cv::merge(channels, out);
+  const size_t rows = in.rows(), cols = in.cols(), cn = in.channels();
+  if (rows == 0 || cols == 0) return;
+  const InputScalar* inp = in.real<InputScalar>();
+  OutputScalar* outp = out.ptr<OutputScalar>(0);
+  for (size_t c = 0; c < cn; ++c)
+    transposeCast(cols, rows, inp + rows*cols*c, rows, 1, outp + c, out.step1(), cn, SaturateCast<OutputScalar>());
+}
 
-  //const InputScalar* inp = in.real<InputScalar>();
-  //OutputScalar* outp = out.ptr<OutputScalar>(0);
-  //gemt('C', in.rows(), in.cols(), inp, in.rows(), outp, out.step1());
+/*!
+ * @brief zero-copy transposed view of a Matlab array
+ *
+ * Matlab stores matrices column-major, so the data of a real, single-channel
+ * rows x cols array is exactly a continuous cols x rows cv::Mat. The returned
+ * header shares the data with the array and must not outlive it. Algorithms
+ * that do not depend on the orientation (elementwise operations, reductions,
+ * filters with symmetric kernels) can run on the view directly, and writing
+ * into the view of a freshly created MxArray fills a Matlab output in place.
+ * Inputs from the Matlab workspace are shared with other variables, so their
+ * views must not be written.
+ */
+inline cv::Mat transposedView(const matlab::MxArray& arr) {
+  matlab::conditionalError(arr.channels() == 1, "Only single-channel arrays can be viewed without a copy");
+  matlab::conditionalError(!arr.isComplex(), "Complex arrays cannot be viewed without a copy");
+  int depth = -1;
+  switch (arr.ID()) {
+    case mxINT8_CLASS:    depth = CV_8S;  break;
+    case mxUINT8_CLASS:   depth = CV_8U;  break;
+    case mxLOGICAL_CLASS: depth = CV_8U;  break;
+    case mxINT16_CLASS:   depth = CV_16S; break;
+    case mxUINT16_CLASS:  depth = CV_16U; break;
+    case mxINT32_CLASS:   depth = CV_32S; break;
+    case mxSINGLE_CLASS:  depth = CV_32F; break;
+    case mxDOUBLE_CLASS:  depth = CV_64F; break;
+    default: matlab::error("Attempted to view an array with no matching OpenCV type");
+  }
+  return cv::Mat(static_cast<int>(arr.cols()), static_cast<int>(arr.rows()), depth,
+                 const_cast<void *>(static_cast<const void *>(arr.real<uint8_t>())));
 }
 
 //! @}
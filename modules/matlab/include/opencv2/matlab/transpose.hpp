@@ -43,6 +43,8 @@
 #ifndef OPENCV_TRANSPOSE_HPP_
 #define OPENCV_TRANSPOSE_HPP_
 
+#include <algorithm>
+
 //! @addtogroup matlab
 //! @{
 
@@ -120,6 +122,30 @@ void gemt(const char major, const size_t M, const size_t N, const InputScalar* a
   transposeBlock(Frem, Srem, aptr, lda, bptr, ldb);
 }
 
+/*
+ * Blocked copy, transpose and cast
+ * b[n*ldb + m*incb] = cast(a[m*lda + n*inca]) for an M x N source. The increments
+ * address one channel of interleaved data. The matrix is walked in square tiles
+ * so that both the reads and the strided writes stay in cache.
+ */
+template <typename InputScalar, typename OutputScalar, typename Cast>
+void transposeCast(const size_t M, const size_t N, const InputScalar* a, size_t lda, size_t inca,
+                   OutputScalar* b, size_t ldb, size_t incb, Cast cast) {
+  const size_t tile = 32;
+  for (size_t m0 = 0; m0 < M; m0 += tile) {
+    const size_t m1 = std::min(m0 + tile, M);
+    for (size_t n0 = 0; n0 < N; n0 += tile) {
+      const size_t n1 = std::min(n0 + tile, N);
+      for (size_t m = m0; m < m1; ++m) {
+        const InputScalar* aptr = a + m*lda;
+        OutputScalar* bptr = b + m*incb;
+        for (size_t n = n0; n < n1; ++n)
+          bptr[n*ldb] = cast(aptr[n*inca]);
+      }
+    }
+  }
+}
+
 #ifdef __SSE2__
 /*
  * SSE2 supported fast copy, transpose and cast
@@ -127,7 +153,7 @@ void gemt(const char major, const size_t M, const size_t N, const InputScalar* a
 #include <emmintrin.h>
 
 template <>
-void transpose4x4<float, float>(const float* src, size_t lda, float* dst, size_t ldb) {
+inline void transpose4x4<float, float>(const float* src, size_t lda, float* dst, size_t ldb) {
   __m128 row0, row1, row2, row3;
   row0 = _mm_loadu_ps(src);
   row1 = _mm_loadu_ps(src+lda);
@@ -144,6 +144,9 @@ CV_EXPORTS_W void calcOpticalFlowSparseToDense ( InputArray from, InputArray to,
 The function readOpticalFlow loads a flow field from a file and returns it as a single matrix.
 Resulting Mat has a type CV_32FC2 - floating-point, 2-channel. First channel corresponds to the
 flow in the horizontal direction (u), second - vertical (v).
+
+A path with the .png extension is read in the 16-bit KITTI flow format instead, the flow of the
+pixels marked as invalid is NaN. An empty matrix is returned when the file can't be read.
  */
 CV_EXPORTS_W Mat readOpticalFlow( const String& path );
 /** @brief Write a .flo to disk
@@ -154,6 +157,10 @@ CV_EXPORTS_W Mat readOpticalFlow( const String& path );
 The function stores a flow field in a file, returns true on success, false otherwise.
 The flow field must be a 2-channel, floating-point matrix (CV_32FC2). First channel corresponds
 to the flow in the horizontal direction (u), second - vertical (v).
+
+A path with the .png extension is written in the 16-bit KITTI flow format: the flow is quantized
+to 1/64 pixel and saturated to about 512 pixels, the NaN and the unknown flow (1e9 and more) are
+marked as invalid. The file is a few times smaller than a .flo one.
  */
 CV_EXPORTS_W bool writeOpticalFlow( const String& path, InputArray flow );
 
@@ -346,6 +353,15 @@ public:
     CV_WRAP virtual bool getUseSpatialPropagation() const = 0;
     /** @copybrief getUseSpatialPropagation @see getUseSpatialPropagation */
     CV_WRAP virtual void setUseSpatialPropagation(bool val) = 0;
+
+    /** @brief Whether calc is called on the consecutive frames of a video. When this option is on and no initial
+        flow is passed, the flow of the previous call advected by itself is used as the initial flow, and the
+        pyramid of the previous I1 is reused for I0 when the new I0 is the same image. The option is turned off
+        by default, changing it drops the cached frame and flow.
+    @see setUseVideoMode */
+    CV_WRAP virtual bool getUseVideoMode() const = 0;
+    /** @copybrief getUseVideoMode @see getUseVideoMode */
+    CV_WRAP virtual void setUseVideoMode(bool val) = 0;
 };
 
 /** @brief Creates an instance of DISOpticalFlow
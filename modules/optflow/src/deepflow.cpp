@@ -41,7 +41,6 @@
  //M*/
 
 #include "precomp.hpp"
-#include <opencv2/highgui.hpp>
 
 namespace cv
 {
@@ -70,6 +69,8 @@ protected:
     int maxLayers; // max amount of layers in the pyramid
     int interpolationType;
 
+    Ptr<VariationalRefinement> var; // solver shared by all the levels, keeping its buffers between them
+
 private:
     std::vector<Mat> buildPyramid( const Mat& src );
 
@@ -91,6 +92,8 @@ OpticalFlowDeepFlow::OpticalFlowDeepFlow()
     //consts
     interpolationType = INTER_LINEAR;
     maxLayers = 200;
+
+    var = createVariationalFlowRefinement();
 }
 
 std::vector<Mat> OpticalFlowDeepFlow::buildPyramid( const Mat& src )
@@ -111,6 +114,7 @@ std::vector<Mat> OpticalFlowDeepFlow::buildPyramid( const Mat& src )
                 interpolationType);
         pyramid.push_back(next);
         prev = next;
+        i++;
     }
     return pyramid;
 }
@@ -149,8 +153,6 @@ void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray
 
     for ( int level = levelCount - 1; level >= 0; --level )
     { //iterate through  all levels, beginning with the most coarse
-        Ptr<VariationalRefinement> var = createVariationalFlowRefinement();
-
         var->setAlpha(4 * alpha);
         var->setDelta(delta / 3);
         var->setGamma(gamma / 3);
@@ -170,7 +172,7 @@ void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray
     W.copyTo(_flow);
 }
 
-void OpticalFlowDeepFlow::collectGarbage() {}
+void OpticalFlowDeepFlow::collectGarbage() { var->collectGarbage(); }
 
 Ptr<DenseOpticalFlow> createOptFlow_DeepFlow() { return makePtr<OpticalFlowDeepFlow>(); }
 
@@ -42,6 +42,7 @@
 
 #include "opencv2/core/hal/intrin.hpp"
 #include "precomp.hpp"
+#include "opencl_kernels_optflow.hpp"
 using namespace std;
 #define EPS 0.001F
 #define INF 1E+10F
@@ -70,6 +71,7 @@ class DISOpticalFlowImpl : public DISOpticalFlow
     float variational_refinement_delta;
     bool use_mean_normalization;
     bool use_spatial_propagation;
+    bool use_video_mode;
 
   protected: //!< some auxiliary variables
     int border_size;
@@ -98,6 +100,13 @@ class DISOpticalFlowImpl : public DISOpticalFlow
     void setUseMeanNormalization(bool val) { use_mean_normalization = val; }
     bool getUseSpatialPropagation() const { return use_spatial_propagation; }
     void setUseSpatialPropagation(bool val) { use_spatial_propagation = val; }
+    bool getUseVideoMode() const { return use_video_mode; }
+    void setUseVideoMode(bool val)
+    {
+        use_video_mode = val;
+        prev_I1.release();
+        prev_flow.release();
+    }
 
   protected:                      //!< internal buffers
     vector<Mat_<uchar> > I0s;     //!< Gaussian pyramid for the current frame
@@ -136,8 +145,14 @@ class DISOpticalFlowImpl : public DISOpticalFlow
 
     vector<Ptr<VariationalRefinement> > variational_refinement_processors;
 
+    /* State of the video mode: */
+    Mat prev_I1;     //!< copy of the I1 of the previous call, whose pyramid is still in I1s
+    Mat prev_flow;   //!< output flow of the previous call
+    Mat warped_flow; //!< prev_flow advected by itself, the initial flow of the current call
+    int prev_finest_scale;
+
   private: //!< private methods and parallel sections
-    void prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_flow);
+    void prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_flow, bool reuse_I0_pyramid);
     void precomputeStructureTensor(Mat &dst_I0xx, Mat &dst_I0yy, Mat &dst_I0xy, Mat &dst_I0x, Mat &dst_I0y, Mat &I0x,
                                    Mat &I0y);
 
@@ -166,6 +181,16 @@ class DISOpticalFlowImpl : public DISOpticalFlow
                               Mat &src_Sy, Mat &_I0, Mat &_I1);
         void operator()(const Range &range) const;
     };
+
+#ifdef HAVE_OPENCL
+    /* OpenCL counterparts of the buffers above, the variational refinement stays on the CPU and works on the Mats */
+    vector<UMat> u_I0s, u_I1s, u_I1s_ext, u_I0xs, u_I0ys, u_Ux, u_Uy;
+    UMat u_U, u_Sx, u_Sy;
+    UMat u_I0xx_buf, u_I0yy_buf, u_I0xy_buf, u_I0x_buf, u_I0y_buf;
+
+    void ocl_prepareBuffers(UMat &I0, UMat &I1);
+    bool ocl_calc(InputArray I0, InputArray I1, InputOutputArray flow);
+#endif
 };
 
 DISOpticalFlowImpl::DISOpticalFlowImpl()
@@ -182,6 +207,8 @@ DISOpticalFlowImpl::DISOpticalFlowImpl()
     border_size = 16;
     use_mean_normalization = true;
     use_spatial_propagation = true;
+    use_video_mode = false;
+    prev_finest_scale = -1;
 
     /* Use separate variational refinement instances for different scales to avoid repeated memory allocation: */
     int max_possible_scales = 10;
@@ -189,8 +216,11 @@ DISOpticalFlowImpl::DISOpticalFlowImpl()
         variational_refinement_processors.push_back(createVariationalFlowRefinement());
 }
 
-void DISOpticalFlowImpl::prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_flow)
+void DISOpticalFlowImpl::prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_flow, bool reuse_I0_pyramid)
 {
+    /* The pyramid of the previous I1 becomes the pyramid of I0, only the gradients have to be computed again */
+    if (reuse_I0_pyramid)
+        I0s.swap(I1s);
     I0s.resize(coarsest_scale + 1);
     I1s.resize(coarsest_scale + 1);
     I1s_ext.resize(coarsest_scale + 1);
@@ -206,6 +236,12 @@ void DISOpticalFlowImpl::prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_fl
         initial_Ux.resize(coarsest_scale + 1);
         initial_Uy.resize(coarsest_scale + 1);
     }
+    else
+    {
+        /* Don't keep the temporal candidates of a previous call */
+        initial_Ux.clear();
+        initial_Uy.clear();
+    }
 
     int fraction = 1;
     int cur_rows = 0, cur_cols = 0;
@@ -217,8 +253,11 @@ void DISOpticalFlowImpl::prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_fl
         {
             cur_rows = I0.rows / fraction;
             cur_cols = I0.cols / fraction;
-            I0s[i].create(cur_rows, cur_cols);
-            resize(I0, I0s[i], I0s[i].size(), 0.0, 0.0, INTER_AREA);
+            if (!reuse_I0_pyramid)
+            {
+                I0s[i].create(cur_rows, cur_cols);
+                resize(I0, I0s[i], I0s[i].size(), 0.0, 0.0, INTER_AREA);
+            }
             I1s[i].create(cur_rows, cur_cols);
             resize(I1, I1s[i], I1s[i].size(), 0.0, 0.0, INTER_AREA);
 
@@ -243,8 +282,11 @@ void DISOpticalFlowImpl::prepareBuffers(Mat &I0, Mat &I1, Mat &flow, bool use_fl
         {
             cur_rows = I0s[i - 1].rows / 2;
             cur_cols = I0s[i - 1].cols / 2;
-            I0s[i].create(cur_rows, cur_cols);
-            resize(I0s[i - 1], I0s[i], I0s[i].size(), 0.0, 0.0, INTER_AREA);
+            if (!reuse_I0_pyramid)
+            {
+                I0s[i].create(cur_rows, cur_cols);
+                resize(I0s[i - 1], I0s[i], I0s[i].size(), 0.0, 0.0, INTER_AREA);
+            }
             I1s[i].create(cur_rows, cur_cols);
             resize(I1s[i - 1], I1s[i], I1s[i].size(), 0.0, 0.0, INTER_AREA);
         }
@@ -1004,6 +1046,207 @@ void DISOpticalFlowImpl::Densification_ParBody::operator()(const Range &range) c
 #undef UPDATE_SPARSE_J_COORDINATES
 }
 
+/* The flow of the previous frame moved along itself, assuming a constant motion between the frames: the vector
+ * found at x in the previous frame is expected at x + flow(x) in the current one, which is approximated by looking
+ * it up at x - flow(x)
+ */
+static void advectFlow(const Mat &prev_flow, Mat &dst)
+{
+    Mat map(prev_flow.size(), CV_32FC2);
+    for (int i = 0; i < prev_flow.rows; i++)
+    {
+        const Vec2f *flow_row = prev_flow.ptr<Vec2f>(i);
+        Vec2f *map_row = map.ptr<Vec2f>(i);
+        for (int j = 0; j < prev_flow.cols; j++)
+            map_row[j] = Vec2f(j - flow_row[j][0], i - flow_row[j][1]);
+    }
+    remap(prev_flow, dst, map, noArray(), INTER_LINEAR, BORDER_REPLICATE);
+}
+
+#ifdef HAVE_OPENCL
+void DISOpticalFlowImpl::ocl_prepareBuffers(UMat &I0, UMat &I1)
+{
+    u_I0s.resize(coarsest_scale + 1);
+    u_I1s.resize(coarsest_scale + 1);
+    u_I1s_ext.resize(coarsest_scale + 1);
+    u_I0xs.resize(coarsest_scale + 1);
+    u_I0ys.resize(coarsest_scale + 1);
+    u_Ux.resize(coarsest_scale + 1);
+    u_Uy.resize(coarsest_scale + 1);
+    if (variational_refinement_iter > 0)
+    {
+        I0s.resize(coarsest_scale + 1);
+        I1s.resize(coarsest_scale + 1);
+        Ux.resize(coarsest_scale + 1);
+        Uy.resize(coarsest_scale + 1);
+    }
+
+    int fraction = 1;
+    int cur_rows = 0, cur_cols = 0;
+
+    for (int i = 0; i <= coarsest_scale; i++)
+    {
+        /* Same pyramid as in prepareBuffers, levels above the finest scale are skipped */
+        if (i == finest_scale)
+        {
+            cur_rows = I0.rows / fraction;
+            cur_cols = I0.cols / fraction;
+            resize(I0, u_I0s[i], Size(cur_cols, cur_rows), 0.0, 0.0, INTER_AREA);
+            resize(I1, u_I1s[i], Size(cur_cols, cur_rows), 0.0, 0.0, INTER_AREA);
+
+            /* These buffers are reused in each scale so we initialize them once on the finest scale: */
+            Size sparse_sz(cur_cols / patch_stride, cur_rows / patch_stride);
+            u_Sx.create(sparse_sz, CV_32FC1);
+            u_Sy.create(sparse_sz, CV_32FC1);
+            u_I0xx_buf.create(sparse_sz, CV_32FC1);
+            u_I0yy_buf.create(sparse_sz, CV_32FC1);
+            u_I0xy_buf.create(sparse_sz, CV_32FC1);
+            u_I0x_buf.create(sparse_sz, CV_32FC1);
+            u_I0y_buf.create(sparse_sz, CV_32FC1);
+        }
+        else if (i > finest_scale)
+        {
+            cur_rows = u_I0s[i - 1].rows / 2;
+            cur_cols = u_I0s[i - 1].cols / 2;
+            resize(u_I0s[i - 1], u_I0s[i], Size(cur_cols, cur_rows), 0.0, 0.0, INTER_AREA);
+            resize(u_I1s[i - 1], u_I1s[i], Size(cur_cols, cur_rows), 0.0, 0.0, INTER_AREA);
+        }
+
+        if (i >= finest_scale)
+        {
+            copyMakeBorder(u_I1s[i], u_I1s_ext[i], border_size, border_size, border_size, border_size,
+                           BORDER_REPLICATE);
+            spatialGradient(u_I0s[i], u_I0xs[i], u_I0ys[i]);
+            u_Ux[i].create(cur_rows, cur_cols, CV_32FC1);
+            u_Uy[i].create(cur_rows, cur_cols, CV_32FC1);
+            if (variational_refinement_iter > 0)
+            {
+                u_I0s[i].copyTo(I0s[i]);
+                u_I1s[i].copyTo(I1s[i]);
+                Ux[i].create(cur_rows, cur_cols);
+                Uy[i].create(cur_rows, cur_cols);
+            }
+            variational_refinement_processors[i]->setAlpha(variational_refinement_alpha);
+            variational_refinement_processors[i]->setDelta(variational_refinement_delta);
+            variational_refinement_processors[i]->setGamma(variational_refinement_gamma);
+            variational_refinement_processors[i]->setSorIterations(5);
+            variational_refinement_processors[i]->setFixedPointIterations(variational_refinement_iter);
+        }
+
+        fraction *= 2;
+    }
+}
+
+bool DISOpticalFlowImpl::ocl_calc(InputArray I0, InputArray I1, InputOutputArray flow)
+{
+    ocl::Kernel k_tensor("dis_structure_tensor", ocl::optflow::dis_flow_oclsrc);
+    ocl::Kernel k_init("dis_init_sparse_flow", ocl::optflow::dis_flow_oclsrc);
+    ocl::Kernel k_propagation("dis_spatial_propagation", ocl::optflow::dis_flow_oclsrc);
+    ocl::Kernel k_descent("dis_gradient_descent", ocl::optflow::dis_flow_oclsrc);
+    ocl::Kernel k_densification("dis_densification", ocl::optflow::dis_flow_oclsrc);
+    if (k_tensor.empty() || k_init.empty() || k_propagation.empty() || k_descent.empty() || k_densification.empty())
+        return false;
+
+    UMat I0UMat = I0.getUMat();
+    UMat I1UMat = I1.getUMat();
+    coarsest_scale = (int)(log((2 * I0UMat.cols) / (4.0 * patch_size)) / log(2.0) + 0.5) - 1;
+
+    ocl_prepareBuffers(I0UMat, I1UMat);
+    u_Ux[coarsest_scale].setTo(0.0f);
+    u_Uy[coarsest_scale].setTo(0.0f);
+
+    int bsz = border_size;
+    int mean_norm = use_mean_normalization ? 1 : 0;
+    for (int i = coarsest_scale; i >= finest_scale; i--)
+    {
+        w = u_I0s[i].cols;
+        h = u_I0s[i].rows;
+        ws = 1 + (w - patch_size) / patch_stride;
+        hs = 1 + (h - patch_size) / patch_stride;
+
+        size_t sparse_size[2] = {(size_t)ws, (size_t)hs};
+        size_t dense_size[2] = {(size_t)w, (size_t)h};
+
+        k_tensor.args(ocl::KernelArg::PtrReadOnly(u_I0xs[i]), ocl::KernelArg::PtrReadOnly(u_I0ys[i]),
+                      ocl::KernelArg::PtrWriteOnly(u_I0xx_buf), ocl::KernelArg::PtrWriteOnly(u_I0yy_buf),
+                      ocl::KernelArg::PtrWriteOnly(u_I0xy_buf), ocl::KernelArg::PtrWriteOnly(u_I0x_buf),
+                      ocl::KernelArg::PtrWriteOnly(u_I0y_buf), w, ws, hs, patch_size, patch_stride);
+        if (!k_tensor.run(2, sparse_size, NULL, false))
+            return false;
+
+        k_init.args(ocl::KernelArg::PtrReadOnly(u_Ux[i]), ocl::KernelArg::PtrReadOnly(u_Uy[i]),
+                    ocl::KernelArg::PtrWriteOnly(u_Sx), ocl::KernelArg::PtrWriteOnly(u_Sy), w, ws, hs, patch_size,
+                    patch_stride);
+        if (!k_init.run(2, sparse_size, NULL, false))
+            return false;
+
+        /* With spatial propagation the iterations are split into a forward and a backward pass as on the CPU,
+         * each scanning the rows and then the columns of the sparse grid
+         */
+        int num_passes = use_spatial_propagation ? 2 : 1;
+        int num_inner_iter = grad_descent_iter / num_passes;
+        for (int pass = 0; pass < num_passes; pass++)
+        {
+            if (use_spatial_propagation)
+            {
+                int dir = pass % 2 == 0 ? 1 : -1;
+                for (int horizontal = 1; horizontal >= 0; horizontal--)
+                {
+                    size_t lines_size[1] = {(size_t)(horizontal ? hs : ws)};
+                    k_propagation.args(ocl::KernelArg::PtrReadOnly(u_I0s[i]),
+                                       ocl::KernelArg::PtrReadOnly(u_I1s_ext[i]), ocl::KernelArg::PtrReadWrite(u_Sx),
+                                       ocl::KernelArg::PtrReadWrite(u_Sy), w, h, ws, hs, patch_size, patch_stride, bsz,
+                                       mean_norm, horizontal, dir);
+                    if (!k_propagation.run(1, lines_size, NULL, false))
+                        return false;
+                }
+            }
+
+            k_descent.args(ocl::KernelArg::PtrReadOnly(u_I0s[i]), ocl::KernelArg::PtrReadOnly(u_I1s_ext[i]),
+                           ocl::KernelArg::PtrReadOnly(u_I0xs[i]), ocl::KernelArg::PtrReadOnly(u_I0ys[i]),
+                           ocl::KernelArg::PtrReadOnly(u_I0xx_buf), ocl::KernelArg::PtrReadOnly(u_I0yy_buf),
+                           ocl::KernelArg::PtrReadOnly(u_I0xy_buf), ocl::KernelArg::PtrReadOnly(u_I0x_buf),
+                           ocl::KernelArg::PtrReadOnly(u_I0y_buf), ocl::KernelArg::PtrReadWrite(u_Sx),
+                           ocl::KernelArg::PtrReadWrite(u_Sy), w, h, ws, hs, patch_size, patch_stride, bsz, mean_norm,
+                           num_inner_iter);
+            if (!k_descent.run(2, sparse_size, NULL, false))
+                return false;
+        }
+
+        k_densification.args(ocl::KernelArg::PtrReadOnly(u_Sx), ocl::KernelArg::PtrReadOnly(u_Sy),
+                             ocl::KernelArg::PtrReadOnly(u_I0s[i]), ocl::KernelArg::PtrReadOnly(u_I1s[i]),
+                             ocl::KernelArg::PtrWriteOnly(u_Ux[i]), ocl::KernelArg::PtrWriteOnly(u_Uy[i]), w, h, ws,
+                             hs, patch_size, patch_stride);
+        if (!k_densification.run(2, dense_size, NULL, false))
+            return false;
+
+        if (variational_refinement_iter > 0)
+        {
+            u_Ux[i].copyTo(Ux[i]);
+            u_Uy[i].copyTo(Uy[i]);
+            variational_refinement_processors[i]->calcUV(I0s[i], I1s[i], Ux[i], Uy[i]);
+            Ux[i].copyTo(u_Ux[i]);
+            Uy[i].copyTo(u_Uy[i]);
+        }
+
+        if (i > finest_scale)
+        {
+            UMat tmp;
+            resize(u_Ux[i], tmp, u_Ux[i - 1].size());
+            multiply(tmp, Scalar::all(2), u_Ux[i - 1]);
+            resize(u_Uy[i], tmp, u_Uy[i - 1].size());
+            multiply(tmp, Scalar::all(2), u_Uy[i - 1]);
+        }
+    }
+    UMat uxy[] = {u_Ux[finest_scale], u_Uy[finest_scale]};
+    merge(uxy, 2, u_U);
+    UMat tmp;
+    resize(u_U, tmp, I0UMat.size());
+    multiply(tmp, Scalar::all(1 << finest_scale), flow);
+    return true;
+}
+#endif
+
 void DISOpticalFlowImpl::calc(InputArray I0, InputArray I1, InputOutputArray flow)
 {
     CV_Assert(!I0.empty() && I0.depth() == CV_8U && I0.channels() == 1);
@@ -1012,6 +1255,11 @@ void DISOpticalFlowImpl::calc(InputArray I0, InputArray I1, InputOutputArray flo
     CV_Assert(I0.isContinuous());
     CV_Assert(I1.isContinuous());
 
+    /* The OpenCL version doesn't take an initial flow (temporal candidates) */
+    CV_OCL_RUN(flow.isUMat() && !use_video_mode &&
+                   !(flow.sameSize(I0) && flow.depth() == CV_32F && flow.channels() == 2),
+               ocl_calc(I0, I1, flow))
+
     Mat I0Mat = I0.getMat();
     Mat I1Mat = I1.getMat();
     bool use_input_flow = false;
@@ -1023,7 +1271,21 @@ void DISOpticalFlowImpl::calc(InputArray I0, InputArray I1, InputOutputArray flo
     coarsest_scale = (int)(log((2 * I0Mat.cols) / (4.0 * patch_size)) / log(2.0) + 0.5) - 1;
     int num_stripes = getNumThreads();
 
-    prepareBuffers(I0Mat, I1Mat, flowMat, use_input_flow);
+    bool reuse_I0_pyramid = false;
+    Mat *init_flow = &flowMat;
+    if (use_video_mode && !prev_I1.empty() && prev_I1.size() == I0Mat.size())
+    {
+        reuse_I0_pyramid = prev_finest_scale == finest_scale && (int)I0s.size() == coarsest_scale + 1 &&
+                           memcmp(prev_I1.data, I0Mat.data, I0Mat.total()) == 0;
+        if (!use_input_flow && prev_flow.size() == I0Mat.size())
+        {
+            advectFlow(prev_flow, warped_flow);
+            init_flow = &warped_flow;
+            use_input_flow = true;
+        }
+    }
+
+    prepareBuffers(I0Mat, I1Mat, *init_flow, use_input_flow, reuse_I0_pyramid);
     Ux[coarsest_scale].setTo(0.0f);
     Uy[coarsest_scale].setTo(0.0f);
 
@@ -1067,6 +1329,13 @@ void DISOpticalFlowImpl::calc(InputArray I0, InputArray I1, InputOutputArray flo
     merge(uxy, 2, U);
     resize(U, flowMat, flowMat.size());
     flowMat *= 1 << finest_scale;
+
+    if (use_video_mode)
+    {
+        I1Mat.copyTo(prev_I1);
+        flowMat.copyTo(prev_flow);
+        prev_finest_scale = finest_scale;
+    }
 }
 
 void DISOpticalFlowImpl::collectGarbage()
@@ -1087,6 +1356,27 @@ void DISOpticalFlowImpl::collectGarbage()
     I0xx_buf_aux.release();
     I0yy_buf_aux.release();
     I0xy_buf_aux.release();
+    prev_I1.release();
+    prev_flow.release();
+    warped_flow.release();
+
+#ifdef HAVE_OPENCL
+    u_I0s.clear();
+    u_I1s.clear();
+    u_I1s_ext.clear();
+    u_I0xs.clear();
+    u_I0ys.clear();
+    u_Ux.clear();
+    u_Uy.clear();
+    u_U.release();
+    u_Sx.release();
+    u_Sy.release();
+    u_I0xx_buf.release();
+    u_I0yy_buf.release();
+    u_I0xy_buf.release();
+    u_I0x_buf.release();
+    u_I0y_buf.release();
+#endif
 
     for (int i = finest_scale; i <= coarsest_scale; i++)
         variational_refinement_processors[i]->collectGarbage();
@@ -54,7 +54,7 @@ using std::vector;
 static bool ocl_updateMotionHistory( InputArray _silhouette, InputOutputArray _mhi,
                                      float timestamp, float delbound )
 {
-    ocl::Kernel k("updateMotionHistory", ocl::video::updatemotionhistory_oclsrc);
+    ocl::Kernel k("updateMotionHistory", ocl::optflow::updatemotionhistory_oclsrc);
     if (k.empty())
         return false;
 
@@ -67,8 +67,211 @@ static bool ocl_updateMotionHistory( InputArray _silhouette, InputOutputArray _m
     return k.run(2, globalsize, NULL, false);
 }
 
+static bool ocl_calcMotionGradient( InputArray _mhi, OutputArray _mask, OutputArray _orientation,
+                                    float gradient_epsilon, float min_delta, float max_delta,
+                                    int aperture_size )
+{
+    ocl::Kernel k("calcMotionGradient", ocl::optflow::motiongradient_oclsrc);
+    if (k.empty())
+        return false;
+
+    UMat mhi = _mhi.getUMat(), dX, dY, mhiMin, mhiMax;
+    Sobel( mhi, dX, CV_32F, 1, 0, aperture_size, 1, 0, BORDER_REPLICATE );
+    Sobel( mhi, dY, CV_32F, 0, 1, aperture_size, 1, 0, BORDER_REPLICATE );
+    erode( mhi, mhiMin, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
+    dilate( mhi, mhiMax, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
+
+    // the kernel only reads the temporary buffers, so the outputs may alias the MHI
+    _mask.create(mhi.size(), CV_8U);
+    _orientation.create(mhi.size(), CV_32F);
+    UMat mask = _mask.getUMat(), orient = _orientation.getUMat();
+
+    k.args(ocl::KernelArg::ReadOnlyNoSize(dX), ocl::KernelArg::ReadOnlyNoSize(dY),
+           ocl::KernelArg::ReadOnlyNoSize(mhiMin), ocl::KernelArg::ReadOnlyNoSize(mhiMax),
+           ocl::KernelArg::WriteOnlyNoSize(mask), ocl::KernelArg::WriteOnly(orient),
+           gradient_epsilon, min_delta, max_delta);
+
+    size_t globalsize[2] = { (size_t)mhi.cols, (size_t)mhi.rows };
+    return k.run(2, globalsize, NULL, false);
+}
+
+#endif
+
+class UpdateMotionHistoryInvoker : public ParallelLoopBody
+{
+public:
+    UpdateMotionHistoryInvoker( const Mat& _silh, Mat& _mhi, float _ts, float _delbound )
+        : silh(_silh), mhi(_mhi), ts(_ts), delbound(_delbound)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int width = silh.cols;
+#if CV_SSE2
+        volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
+#endif
+
+        for( int y = range.start; y < range.end; y++ )
+        {
+            const uchar* silhData = silh.ptr<uchar>(y);
+            float* mhiData = mhi.ptr<float>(y);
+            int x = 0;
+
+#if CV_SSE2
+            if( useSIMD )
+            {
+                __m128 ts4 = _mm_set1_ps(ts), db4 = _mm_set1_ps(delbound);
+                for( ; x <= width - 8; x += 8 )
+                {
+                    __m128i z = _mm_setzero_si128();
+                    __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(silhData + x)), z);
+                    __m128 s0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(s, z)), s1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(s, z));
+                    __m128 v0 = _mm_loadu_ps(mhiData + x), v1 = _mm_loadu_ps(mhiData + x + 4);
+                    __m128 fz = _mm_setzero_ps();
+
+                    v0 = _mm_and_ps(v0, _mm_cmpge_ps(v0, db4));
+                    v1 = _mm_and_ps(v1, _mm_cmpge_ps(v1, db4));
+
+                    __m128 m0 = _mm_and_ps(_mm_xor_ps(v0, ts4), _mm_cmpneq_ps(s0, fz));
+                    __m128 m1 = _mm_and_ps(_mm_xor_ps(v1, ts4), _mm_cmpneq_ps(s1, fz));
+
+                    v0 = _mm_xor_ps(v0, m0);
+                    v1 = _mm_xor_ps(v1, m1);
+
+                    _mm_storeu_ps(mhiData + x, v0);
+                    _mm_storeu_ps(mhiData + x + 4, v1);
+                }
+            }
 #endif
 
+            for( ; x < width; x++ )
+            {
+                float val = mhiData[x];
+                val = silhData[x] ? ts : val < delbound ? 0 : val;
+                mhiData[x] = val;
+            }
+        }
+    }
+
+private:
+    const Mat& silh;
+    Mat& mhi;
+    float ts, delbound;
+
+    UpdateMotionHistoryInvoker& operator=(const UpdateMotionHistoryInvoker&); // to quiet MSVC
+};
+
+// Orientation and mask of the motion gradient from the derivatives and the extrema of the MHI
+// around each pixel, in a single pass over the rows
+class MotionGradientInvoker : public ParallelLoopBody
+{
+public:
+    MotionGradientInvoker( const Mat& _dX, const Mat& _dY, const Mat& _mhiMin, const Mat& _mhiMax,
+                           Mat& _mask, Mat& _orient, float _gradient_epsilon, float _min_delta, float _max_delta )
+        : dX(_dX), dY(_dY), mhiMin(_mhiMin), mhiMax(_mhiMax), mask(_mask), orient(_orient),
+          gradient_epsilon(_gradient_epsilon), min_delta(_min_delta), max_delta(_max_delta)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int width = dX.cols;
+        for( int y = range.start; y < range.end; y++ )
+        {
+            const float* dX_row = dX.ptr<float>(y);
+            const float* dY_row = dY.ptr<float>(y);
+            const float* min_row = mhiMin.ptr<float>(y);
+            const float* max_row = mhiMax.ptr<float>(y);
+            float* orient_row = orient.ptr<float>(y);
+            uchar* mask_row = mask.ptr<uchar>(y);
+
+            cv::hal::fastAtan2(dY_row, dX_row, orient_row, width, true);
+
+            // make orientation zero where the gradient is very small and
+            // mask off pixels which have little motion difference in their neighborhood
+            for( int x = 0; x < width; x++ )
+            {
+                float d0 = max_row[x] - min_row[x];
+
+                if( (std::abs(dX_row[x]) < gradient_epsilon && std::abs(dY_row[x]) < gradient_epsilon) ||
+                    d0 < min_delta || max_delta < d0 )
+                {
+                    mask_row[x] = (uchar)0;
+                    orient_row[x] = 0.f;
+                }
+                else
+                    mask_row[x] = (uchar)1;
+            }
+        }
+    }
+
+private:
+    const Mat &dX, &dY, &mhiMin, &mhiMax;
+    Mat &mask, &orient;
+    float gradient_epsilon, min_delta, max_delta;
+
+    MotionGradientInvoker& operator=(const MotionGradientInvoker&); // to quiet MSVC
+};
+
+// Partial sums of calcGlobalOrientation, one per row so that the result doesn't depend on the
+// number of threads
+class GlobalOrientationInvoker : public ParallelLoopBody
+{
+public:
+    GlobalOrientationInvoker( const Mat& _orient, const Mat& _mask, const Mat& _mhi, float _a, float _b,
+                              float _delbound, float _fbaseOrient,
+                              vector<double>& _shiftOrient, vector<double>& _shiftWeight )
+        : orient(_orient), mask(_mask), mhi(_mhi), a(_a), b(_b), delbound(_delbound),
+          fbaseOrient(_fbaseOrient), shiftOrient(_shiftOrient), shiftWeight(_shiftWeight)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        int width = mhi.cols;
+        for( int y = range.start; y < range.end; y++ )
+        {
+            const float* mhiptr = mhi.ptr<float>(y);
+            const float* oriptr = orient.ptr<float>(y);
+            const uchar* maskptr = mask.ptr<uchar>(y);
+            double rowOrient = 0, rowWeight = 0;
+
+            for( int x = 0; x < width; x++ )
+            {
+                if( maskptr[x] != 0 && mhiptr[x] > delbound )
+                {
+                    /*
+                     orient in 0..360, base_orient in 0..360
+                     -> (rel_angle = orient - base_orient) in -360..360.
+                     rel_angle is translated to -180..180
+                     */
+                    float weight = mhiptr[x] * a + b;
+                    float relAngle = oriptr[x] - fbaseOrient;
+
+                    relAngle += (relAngle < -180 ? 360 : 0);
+                    relAngle += (relAngle > 180 ? -360 : 0);
+
+                    if( fabs(relAngle) < 45 )
+                    {
+                        rowOrient += weight * relAngle;
+                        rowWeight += weight;
+                    }
+                }
+            }
+            shiftOrient[y] = rowOrient;
+            shiftWeight[y] = rowWeight;
+        }
+    }
+
+private:
+    const Mat &orient, &mask, &mhi;
+    float a, b, delbound, fbaseOrient;
+    vector<double> &shiftOrient, &shiftWeight;
+
+    GlobalOrientationInvoker& operator=(const GlobalOrientationInvoker&); // to quiet MSVC
+};
+
 void updateMotionHistory( InputArray _silhouette, InputOutputArray _mhi,
                               double timestamp, double duration )
 {
@@ -82,72 +285,26 @@ void updateMotionHistory( InputArray _silhouette, InputOutputArray _mhi,
                ocl_updateMotionHistory(_silhouette, _mhi, ts, delbound))
 
     Mat silh = _silhouette.getMat(), mhi = _mhi.getMat();
-    Size size = silh.size();
+
 #if defined(HAVE_IPP)
+    Size size = silh.size();
     int silhstep = (int)silh.step, mhistep = (int)mhi.step;
-#endif
-
     if( silh.isContinuous() && mhi.isContinuous() )
     {
         size.width *= size.height;
         size.height = 1;
-#if defined(HAVE_IPP)
         silhstep = (int)silh.total();
         mhistep = (int)mhi.total() * sizeof(Ipp32f);
-#endif
     }
 
-#if defined(HAVE_IPP)
     IppStatus status = ippiUpdateMotionHistory_8u32f_C1IR((const Ipp8u *)silh.data, silhstep, (Ipp32f *)mhi.data, mhistep,
                                                           ippiSize(size.width, size.height), (Ipp32f)timestamp, (Ipp32f)duration);
     if (status >= 0)
         return;
 #endif
 
-#if CV_SSE2
-    volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
-#endif
-
-    for(int y = 0; y < size.height; y++ )
-    {
-        const uchar* silhData = silh.ptr<uchar>(y);
-        float* mhiData = mhi.ptr<float>(y);
-        int x = 0;
-
-#if CV_SSE2
-        if( useSIMD )
-        {
-            __m128 ts4 = _mm_set1_ps(ts), db4 = _mm_set1_ps(delbound);
-            for( ; x <= size.width - 8; x += 8 )
-            {
-                __m128i z = _mm_setzero_si128();
-                __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(silhData + x)), z);
-                __m128 s0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(s, z)), s1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(s, z));
-                __m128 v0 = _mm_loadu_ps(mhiData + x), v1 = _mm_loadu_ps(mhiData + x + 4);
-                __m128 fz = _mm_setzero_ps();
-
-                v0 = _mm_and_ps(v0, _mm_cmpge_ps(v0, db4));
-                v1 = _mm_and_ps(v1, _mm_cmpge_ps(v1, db4));
-
-                __m128 m0 = _mm_and_ps(_mm_xor_ps(v0, ts4), _mm_cmpneq_ps(s0, fz));
-                __m128 m1 = _mm_and_ps(_mm_xor_ps(v1, ts4), _mm_cmpneq_ps(s1, fz));
-
-                v0 = _mm_xor_ps(v0, m0);
-                v1 = _mm_xor_ps(v1, m1);
-
-                _mm_storeu_ps(mhiData + x, v0);
-                _mm_storeu_ps(mhiData + x + 4, v1);
-            }
-        }
-#endif
-
-        for( ; x < size.width; x++ )
-        {
-            float val = mhiData[x];
-            val = silhData[x] ? ts : val < delbound ? 0 : val;
-            mhiData[x] = val;
-        }
-    }
+    parallel_for_(Range(0, silh.rows), UpdateMotionHistoryInvoker(silh, mhi, ts, delbound),
+                  silh.total() / (double)(1 << 16));
 }
 
 
@@ -156,34 +313,16 @@ void calcMotionGradient( InputArray _mhi, OutputArray _mask,
                              double delta1, double delta2,
                              int aperture_size )
 {
-    static int runcase = 0; runcase++;
-
-    Mat mhi = _mhi.getMat();
-    Size size = mhi.size();
-
-    _mask.create(size, CV_8U);
-    _orientation.create(size, CV_32F);
-
-    Mat mask = _mask.getMat();
-    Mat orient = _orientation.getMat();
-
     if( aperture_size < 3 || aperture_size > 7 || (aperture_size & 1) == 0 )
         CV_Error( Error::StsOutOfRange, "aperture_size must be 3, 5 or 7" );
 
     if( delta1 <= 0 || delta2 <= 0 )
         CV_Error( Error::StsOutOfRange, "both delta's must be positive" );
 
-    if( mhi.type() != CV_32FC1 )
+    if( _mhi.type() != CV_32FC1 )
         CV_Error( Error::StsUnsupportedFormat,
                  "MHI must be single-channel floating-point images" );
 
-    if( orient.data == mhi.data )
-    {
-        _orientation.release();
-        _orientation.create(size, CV_32F);
-        orient = _orientation.getMat();
-    }
-
     if( delta1 > delta2 )
         std::swap(delta1, delta2);
 
@@ -191,68 +330,38 @@ void calcMotionGradient( InputArray _mhi, OutputArray _mask,
     float min_delta = (float)delta1;
     float max_delta = (float)delta2;
 
-    Mat dX_min, dY_max;
+    CV_OCL_RUN(_mhi.isUMat() && _orientation.isUMat() && _mhi.dims() <= 2,
+               ocl_calcMotionGradient(_mhi, _mask, _orientation, gradient_epsilon, min_delta, max_delta,
+                                      aperture_size))
 
-    // calc Dx and Dy
-    Sobel( mhi, dX_min, CV_32F, 1, 0, aperture_size, 1, 0, BORDER_REPLICATE );
-    Sobel( mhi, dY_max, CV_32F, 0, 1, aperture_size, 1, 0, BORDER_REPLICATE );
+    Mat mhi = _mhi.getMat();
+    Size size = mhi.size();
 
-    int x, y;
+    _mask.create(size, CV_8U);
+    _orientation.create(size, CV_32F);
 
-    if( mhi.isContinuous() && orient.isContinuous() && mask.isContinuous() )
-    {
-        size.width *= size.height;
-        size.height = 1;
-    }
+    Mat mask = _mask.getMat();
+    Mat orient = _orientation.getMat();
 
-    // calc gradient
-    for( y = 0; y < size.height; y++ )
+    if( orient.data == mhi.data )
     {
-        const float* dX_min_row = dX_min.ptr<float>(y);
-        const float* dY_max_row = dY_max.ptr<float>(y);
-        float* orient_row = orient.ptr<float>(y);
-        uchar* mask_row = mask.ptr<uchar>(y);
-
-        cv::hal::fastAtan2(dY_max_row, dX_min_row, orient_row, size.width, true);
-
-        // make orientation zero where the gradient is very small
-        for( x = 0; x < size.width; x++ )
-        {
-            float dY = dY_max_row[x];
-            float dX = dX_min_row[x];
-
-            if( std::abs(dX) < gradient_epsilon && std::abs(dY) < gradient_epsilon )
-            {
-                mask_row[x] = (uchar)0;
-                orient_row[x] = 0.f;
-            }
-            else
-                mask_row[x] = (uchar)1;
-        }
+        _orientation.release();
+        _orientation.create(size, CV_32F);
+        orient = _orientation.getMat();
     }
 
-    erode( mhi, dX_min, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
-    dilate( mhi, dY_max, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
+    Mat dX, dY, mhiMin, mhiMax;
 
-    // mask off pixels which have little motion difference in their neighborhood
-    for( y = 0; y < size.height; y++ )
-    {
-        const float* dX_min_row = dX_min.ptr<float>(y);
-        const float* dY_max_row = dY_max.ptr<float>(y);
-        float* orient_row = orient.ptr<float>(y);
-        uchar* mask_row = mask.ptr<uchar>(y);
+    // calc Dx and Dy
+    Sobel( mhi, dX, CV_32F, 1, 0, aperture_size, 1, 0, BORDER_REPLICATE );
+    Sobel( mhi, dY, CV_32F, 0, 1, aperture_size, 1, 0, BORDER_REPLICATE );
 
-        for( x = 0; x < size.width; x++ )
-        {
-            float d0 = dY_max_row[x] - dX_min_row[x];
+    erode( mhi, mhiMin, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
+    dilate( mhi, mhiMax, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
 
-            if( mask_row[x] == 0 || d0 < min_delta || max_delta < d0 )
-            {
-                mask_row[x] = (uchar)0;
-                orient_row[x] = 0.f;
-            }
-        }
-    }
+    parallel_for_(Range(0, size.height),
+                  MotionGradientInvoker(dX, dY, mhiMin, mhiMax, mask, orient, gradient_epsilon, min_delta, max_delta),
+                  size.area() / (double)(1 << 16));
 }
 
 double calcGlobalOrientation( InputArray _orientation, InputArray _mask,
@@ -287,12 +396,6 @@ double calcGlobalOrientation( InputArray _orientation, InputArray _mask,
     float b = (float)(1. - timestamp * a);
     float delbound = (float)(timestamp - duration);
 
-    if( mhi.isContinuous() && mask.isContinuous() && orient.isContinuous() )
-    {
-        size.width *= size.height;
-        size.height = 1;
-    }
-
     /*
      a = 254/(255*dt)
      b = 1 - t*a = 1 - 254*t/(255*dur) =
@@ -304,36 +407,19 @@ double calcGlobalOrientation( InputArray _orientation, InputArray _mask,
      ((x - (t - dt))*254 + dt)/(255*dt) =
      (((x - (t - dt))/dt)*254 + 1)/255 = (((x - low_time)/dt)*254 + 1)/255
      */
-    float shiftOrient = 0, shiftWeight = 0;
+    vector<double> rowShiftOrient(size.height), rowShiftWeight(size.height);
+    parallel_for_(Range(0, size.height),
+                  GlobalOrientationInvoker(orient, mask, mhi, a, b, delbound, fbaseOrient,
+                                           rowShiftOrient, rowShiftWeight),
+                  size.area() / (double)(1 << 16));
+
+    double sumOrient = 0, sumWeight = 0;
     for( int y = 0; y < size.height; y++ )
     {
-        const float* mhiptr = mhi.ptr<float>(y);
-        const float* oriptr = orient.ptr<float>(y);
-        const uchar* maskptr = mask.ptr<uchar>(y);
-
-        for( int x = 0; x < size.width; x++ )
-        {
-            if( maskptr[x] != 0 && mhiptr[x] > delbound )
-            {
-                /*
-                 orient in 0..360, base_orient in 0..360
-                 -> (rel_angle = orient - base_orient) in -360..360.
-                 rel_angle is translated to -180..180
-                 */
-                float weight = mhiptr[x] * a + b;
-                float relAngle = oriptr[x] - fbaseOrient;
-
-                relAngle += (relAngle < -180 ? 360 : 0);
-                relAngle += (relAngle > 180 ? -360 : 0);
-
-                if( fabs(relAngle) < 45 )
-                {
-                    shiftOrient += weight * relAngle;
-                    shiftWeight += weight;
-                }
-            }
-        }
+        sumOrient += rowShiftOrient[y];
+        sumWeight += rowShiftWeight[y];
     }
+    float shiftOrient = (float)sumOrient, shiftWeight = (float)sumWeight;
 
     // add the dominant orientation and the relative shift
     if( shiftWeight == 0 )
@@ -365,17 +451,9 @@ void segmentMotion(InputArray _mhi, OutputArray _segmask,
     int x, y;
 
     // protect zero mhi pixels from floodfill.
-    for( y = 0; y < mhi.rows; y++ )
-    {
-        const float* mhiptr = mhi.ptr<float>(y);
-        uchar* maskptr = mask.ptr<uchar>(y+1) + 1;
-
-        for( x = 0; x < mhi.cols; x++ )
-        {
-            if( mhiptr[x] == 0 )
-                maskptr[x] = 1;
-        }
-    }
+    Mat maskInner = mask(Rect(1, 1, mhi.cols, mhi.rows));
+    compare( mhi, Scalar::all(0), maskInner, CMP_EQ );
+    bitwise_and( maskInner, Scalar::all(1), maskInner );
 
     float ts = (float)timestamp;
     float comp_idx = 1.f;
@@ -0,0 +1,262 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+// OpenCL version of the patch inverse search and densification of DIS optical flow (dis_flow.cpp).
+// All the buffers are continuous, I1_ext being I1 with borders of size bsz.
+
+#define EPS 0.001f
+#define INF 1E+10F
+
+// Bilinear weights of the position of I1_ext matched by the patch (i, j) with
+// the flow vector (Ux, Uy), clamped as on the CPU
+#define INIT_BILINEAR_WEIGHTS(Ux, Uy)                                          \
+    i_I1 = clamp(i + (Uy) + bsz, i_lower_limit, i_upper_limit);                \
+    j_I1 = clamp(j + (Ux) + bsz, j_lower_limit, j_upper_limit);                \
+    w11 = (i_I1 - floor(i_I1)) * (j_I1 - floor(j_I1));                         \
+    w10 = (i_I1 - floor(i_I1)) * (floor(j_I1) + 1 - j_I1);                     \
+    w01 = (floor(i_I1) + 1 - i_I1) * (j_I1 - floor(j_I1));                     \
+    w00 = (floor(i_I1) + 1 - i_I1) * (floor(j_I1) + 1 - j_I1);
+
+#define DECLARE_LIMITS                                                         \
+    float i_lower_limit = bsz - psz + 1.0f;                                    \
+    float i_upper_limit = bsz + h - 1.0f;                                      \
+    float j_lower_limit = bsz - psz + 1.0f;                                    \
+    float j_upper_limit = bsz + w - 1.0f;                                      \
+    float i_I1, j_I1, w00, w01, w10, w11;
+
+inline float computeSSD(__global const uchar *I0_ptr, __global const uchar *I1_ptr, int I0_stride, int I1_stride,
+                        float w00, float w01, float w10, float w11, int psz, int use_mean_normalization)
+{
+    float sum_diff = 0.0f, sum_diff_sq = 0.0f;
+    for (int i = 0; i < psz; i++)
+        for (int j = 0; j < psz; j++)
+        {
+            float diff = w00 * I1_ptr[i * I1_stride + j] + w01 * I1_ptr[i * I1_stride + j + 1] +
+                         w10 * I1_ptr[(i + 1) * I1_stride + j] + w11 * I1_ptr[(i + 1) * I1_stride + j + 1] -
+                         I0_ptr[i * I0_stride + j];
+            sum_diff += diff;
+            sum_diff_sq += diff * diff;
+        }
+    if (use_mean_normalization)
+        return sum_diff_sq - sum_diff * sum_diff / (psz * psz);
+    return sum_diff_sq;
+}
+
+inline float processPatch(float *dst_dUx, float *dst_dUy, __global const uchar *I0_ptr, __global const uchar *I1_ptr,
+                          __global const short *I0x_ptr, __global const short *I0y_ptr, int I0_stride, int I1_stride,
+                          float w00, float w01, float w10, float w11, int psz, int use_mean_normalization,
+                          float x_grad_sum, float y_grad_sum)
+{
+    float sum_diff = 0.0f, sum_diff_sq = 0.0f;
+    float sum_I0x_mul = 0.0f, sum_I0y_mul = 0.0f;
+    for (int i = 0; i < psz; i++)
+        for (int j = 0; j < psz; j++)
+        {
+            float diff = w00 * I1_ptr[i * I1_stride + j] + w01 * I1_ptr[i * I1_stride + j + 1] +
+                         w10 * I1_ptr[(i + 1) * I1_stride + j] + w11 * I1_ptr[(i + 1) * I1_stride + j + 1] -
+                         I0_ptr[i * I0_stride + j];
+            sum_diff += diff;
+            sum_diff_sq += diff * diff;
+            sum_I0x_mul += diff * I0x_ptr[i * I0_stride + j];
+            sum_I0y_mul += diff * I0y_ptr[i * I0_stride + j];
+        }
+    if (use_mean_normalization)
+    {
+        float n = (float)(psz * psz);
+        *dst_dUx = sum_I0x_mul - sum_diff * x_grad_sum / n;
+        *dst_dUy = sum_I0y_mul - sum_diff * y_grad_sum / n;
+        return sum_diff_sq - sum_diff * sum_diff / n;
+    }
+    *dst_dUx = sum_I0x_mul;
+    *dst_dUy = sum_I0y_mul;
+    return sum_diff_sq;
+}
+
+#define COMPUTE_SSD(dst, Ux, Uy)                                               \
+    INIT_BILINEAR_WEIGHTS(Ux, Uy);                                             \
+    dst = computeSSD(I0 + i * w + j, I1_ext + (int)i_I1 * w_ext + (int)j_I1, w, w_ext, \
+                     w00, w01, w10, w11, psz, use_mean_normalization);
+
+// Structure tensor and gradient sums of the patch of each sparse grid location
+__kernel void dis_structure_tensor(__global const short *I0x, __global const short *I0y,
+                                   __global float *I0xx_buf, __global float *I0yy_buf, __global float *I0xy_buf,
+                                   __global float *I0x_buf, __global float *I0y_buf,
+                                   int w, int ws, int hs, int psz, int pstr)
+{
+    int js = get_global_id(0);
+    int is = get_global_id(1);
+    if (js >= ws || is >= hs)
+        return;
+
+    float sum_xx = 0.0f, sum_yy = 0.0f, sum_xy = 0.0f, sum_x = 0.0f, sum_y = 0.0f;
+    int offset = is * pstr * w + js * pstr;
+    for (int i = 0; i < psz; i++)
+        for (int j = 0; j < psz; j++)
+        {
+            float x = I0x[offset + i * w + j], y = I0y[offset + i * w + j];
+            sum_xx += x * x;
+            sum_yy += y * y;
+            sum_xy += x * y;
+            sum_x += x;
+            sum_y += y;
+        }
+
+    int idx = is * ws + js;
+    I0xx_buf[idx] = sum_xx;
+    I0yy_buf[idx] = sum_yy;
+    I0xy_buf[idx] = sum_xy;
+    I0x_buf[idx] = sum_x;
+    I0y_buf[idx] = sum_y;
+}
+
+// Initializes the sparse flow with the flow of the previous pyramid level at the patch centers
+__kernel void dis_init_sparse_flow(__global const float *Ux, __global const float *Uy,
+                                   __global float *Sx, __global float *Sy,
+                                   int w, int ws, int hs, int psz, int pstr)
+{
+    int js = get_global_id(0);
+    int is = get_global_id(1);
+    if (js >= ws || is >= hs)
+        return;
+
+    int psz2 = psz / 2;
+    int idx = (is * pstr + psz2) * w + js * pstr + psz2;
+    Sx[is * ws + js] = Ux[idx];
+    Sy[is * ws + js] = Uy[idx];
+}
+
+// Spatial propagation along the rows of the sparse grid (horizontal != 0) or along its columns. Each work-item
+// scans one row or column in the direction dir, a patch taking the vector of its predecessor when it fits better.
+__kernel void dis_spatial_propagation(__global const uchar *I0, __global const uchar *I1_ext,
+                                      __global float *Sx, __global float *Sy,
+                                      int w, int h, int ws, int hs, int psz, int pstr, int bsz,
+                                      int use_mean_normalization, int horizontal, int dir)
+{
+    int line = get_global_id(0);
+    int nlines = horizontal ? hs : ws;
+    int len = horizontal ? ws : hs;
+    if (line >= nlines)
+        return;
+
+    int w_ext = w + 2 * bsz;
+    DECLARE_LIMITS;
+
+    int step = horizontal ? 1 : ws;
+    int first = dir > 0 ? 0 : len - 1;
+    int base = horizontal ? line * ws : line;
+    int i, j;
+
+    for (int k = first + dir; k >= 0 && k < len; k += dir)
+    {
+        int idx = base + k * step, prev = idx - dir * step;
+        i = (horizontal ? line : k) * pstr;
+        j = (horizontal ? k : line) * pstr;
+
+        float cur_SSD, prev_SSD;
+        COMPUTE_SSD(cur_SSD, Sx[idx], Sy[idx]);
+        COMPUTE_SSD(prev_SSD, Sx[prev], Sy[prev]);
+        if (prev_SSD < cur_SSD)
+        {
+            Sx[idx] = Sx[prev];
+            Sy[idx] = Sy[prev];
+        }
+    }
+}
+
+// Inverse compositional gradient descent of each patch starting from its current sparse flow vector
+__kernel void dis_gradient_descent(__global const uchar *I0, __global const uchar *I1_ext,
+                                   __global const short *I0x, __global const short *I0y,
+                                   __global const float *I0xx_buf, __global const float *I0yy_buf,
+                                   __global const float *I0xy_buf, __global const float *I0x_buf,
+                                   __global const float *I0y_buf, __global float *Sx, __global float *Sy,
+                                   int w, int h, int ws, int hs, int psz, int pstr, int bsz,
+                                   int use_mean_normalization, int num_inner_iter)
+{
+    int js = get_global_id(0);
+    int is = get_global_id(1);
+    if (js >= ws || is >= hs)
+        return;
+
+    int w_ext = w + 2 * bsz;
+    DECLARE_LIMITS;
+    int i = is * pstr, j = js * pstr;
+    int idx = is * ws + js;
+
+    float start_Ux = Sx[idx], start_Uy = Sy[idx];
+    float cur_Ux = start_Ux, cur_Uy = start_Uy;
+
+    /* Computing the inverse of the structure tensor: */
+    float detH = I0xx_buf[idx] * I0yy_buf[idx] - I0xy_buf[idx] * I0xy_buf[idx];
+    if (fabs(detH) < EPS)
+        detH = EPS;
+    float invH11 = I0yy_buf[idx] / detH;
+    float invH12 = -I0xy_buf[idx] / detH;
+    float invH22 = I0xx_buf[idx] / detH;
+    float x_grad_sum = I0x_buf[idx];
+    float y_grad_sum = I0y_buf[idx];
+
+    float prev_SSD = INF, SSD, dUx, dUy;
+    for (int t = 0; t < num_inner_iter; t++)
+    {
+        INIT_BILINEAR_WEIGHTS(cur_Ux, cur_Uy);
+        SSD = processPatch(&dUx, &dUy, I0 + i * w + j, I1_ext + (int)i_I1 * w_ext + (int)j_I1,
+                           I0x + i * w + j, I0y + i * w + j, w, w_ext, w00, w01, w10, w11, psz,
+                           use_mean_normalization, x_grad_sum, y_grad_sum);
+
+        cur_Ux -= invH11 * dUx + invH12 * dUy;
+        cur_Uy -= invH12 * dUx + invH22 * dUy;
+
+        /* Break when patch distance stops decreasing */
+        if (SSD >= prev_SSD)
+            break;
+        prev_SSD = SSD;
+    }
+
+    /* Vectors that moved further than the patch size are dropped */
+    float dx = cur_Ux - start_Ux, dy = cur_Uy - start_Uy;
+    if (sqrt(dx * dx + dy * dy) <= psz)
+    {
+        Sx[idx] = cur_Ux;
+        Sy[idx] = cur_Uy;
+    }
+}
+
+// Dense flow as the weighted average of the vectors of the patches covering each pixel
+__kernel void dis_densification(__global const float *Sx, __global const float *Sy,
+                                __global const uchar *I0, __global const uchar *I1,
+                                __global float *Ux, __global float *Uy,
+                                int w, int h, int ws, int hs, int psz, int pstr)
+{
+    int j = get_global_id(0);
+    int i = get_global_id(1);
+    if (j >= w || i >= h)
+        return;
+
+    /* Patches of the sparse grid starting in (i - psz, i], the last one being kept after the end of the grid */
+    int end_is = min(i / pstr, hs - 1);
+    int start_is = min(i >= psz ? (i - psz) / pstr + 1 : 0, end_is);
+    int end_js = min(j / pstr, ws - 1);
+    int start_js = min(j >= psz ? (j - psz) / pstr + 1 : 0, end_js);
+
+    float sum_coef = 0.0f, sum_Ux = 0.0f, sum_Uy = 0.0f;
+    for (int is = start_is; is <= end_is; is++)
+        for (int js = start_js; js <= end_js; js++)
+        {
+            float sx = Sx[is * ws + js], sy = Sy[is * ws + js];
+            float j_m = min(max(j + sx, 0.0f), w - 1.0f - EPS);
+            float i_m = min(max(i + sy, 0.0f), h - 1.0f - EPS);
+            int j_l = (int)j_m, j_u = j_l + 1;
+            int i_l = (int)i_m, i_u = i_l + 1;
+            float diff = (j_m - j_l) * (i_m - i_l) * I1[i_u * w + j_u] +
+                         (j_u - j_m) * (i_m - i_l) * I1[i_u * w + j_l] +
+                         (j_m - j_l) * (i_u - i_m) * I1[i_l * w + j_u] +
+                         (j_u - j_m) * (i_u - i_m) * I1[i_l * w + j_l] - I0[i * w + j];
+            float coef = 1.0f / max(1.0f, fabs(diff));
+            sum_Ux += coef * sx;
+            sum_Uy += coef * sy;
+            sum_coef += coef;
+        }
+    Ux[i * w + j] = sum_Ux / sum_coef;
+    Uy[i * w + j] = sum_Uy / sum_coef;
+}
@@ -0,0 +1,43 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+// Orientation and validity mask of the motion gradient (motempl.cpp), from the Sobel derivatives
+// and the minimum and maximum of the MHI in the aperture.
+
+__kernel void calcMotionGradient(__global const uchar * dxptr, int dx_step, int dx_offset,
+                                 __global const uchar * dyptr, int dy_step, int dy_offset,
+                                 __global const uchar * minptr, int min_step, int min_offset,
+                                 __global const uchar * maxptr, int max_step, int max_offset,
+                                 __global uchar * maskptr, int mask_step, int mask_offset,
+                                 __global uchar * orientptr, int orient_step, int orient_offset,
+                                 int rows, int cols, float gradient_epsilon, float min_delta, float max_delta)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+
+    if (x < cols && y < rows)
+    {
+        int offset = x * (int)sizeof(float);
+        float dX = *(__global const float *)(dxptr + mad24(y, dx_step, dx_offset + offset));
+        float dY = *(__global const float *)(dyptr + mad24(y, dy_step, dy_offset + offset));
+        float d0 = *(__global const float *)(maxptr + mad24(y, max_step, max_offset + offset)) -
+                   *(__global const float *)(minptr + mad24(y, min_step, min_offset + offset));
+
+        // the orientation is zero where the gradient is very small or where the neighborhood
+        // has too little or too much motion difference
+        bool valid = !(fabs(dX) < gradient_epsilon && fabs(dY) < gradient_epsilon) &&
+                     d0 >= min_delta && d0 <= max_delta;
+
+        float angle = 0.f;
+        if (valid)
+        {
+            angle = atan2(dY, dX) * (180.f / M_PI_F);
+            angle += angle < 0.f ? 360.f : 0.f;
+            angle = angle >= 360.f ? 0.f : angle;
+        }
+
+        maskptr[mad24(y, mask_step, mask_offset + x)] = valid ? (uchar)1 : (uchar)0;
+        *(__global float *)(orientptr + mad24(y, orient_step, orient_offset + offset)) = angle;
+    }
+}
@@ -40,18 +40,88 @@
  //
  //M*/
 #include "precomp.hpp"
+#include "opencv2/imgcodecs.hpp"
 #include<iostream>
 #include<fstream>
+#include<limits>
+#include<cctype>
 
 namespace cv {
 namespace optflow {
 const float FLOW_TAG_FLOAT = 202021.25f;
 const char *FLOW_TAG_STRING = "PIEH";
+
+// KITTI flow png: the flow is stored in 1/64 pixel with an offset of 2^15, the third channel tells
+// whether the flow of a pixel is known
+const float KITTI_FLOW_SCALE = 64.f;
+const float KITTI_FLOW_OFFSET = 32768.f;
+
+static bool isPngPath( const String& path )
+{
+    size_t dot = path.find_last_of('.');
+    if ( dot == String::npos )
+        return false;
+    String ext = path.substr(dot + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == "png";
+}
+
+static Mat readOpticalFlowKITTI( const String& path )
+{
+    Mat_<Point2f> flow;
+    Mat encoded = imread(path, IMREAD_UNCHANGED);
+    if ( encoded.type() != CV_16UC3 )
+        return flow;
+
+    const float unknown = std::numeric_limits<float>::quiet_NaN();
+    flow.create(encoded.size());
+    for ( int i = 0; i < flow.rows; ++i )
+    {
+        // the channels of the file are (u, v, valid), they are read in BGR order
+        const Vec3w* src = encoded.ptr<Vec3w>(i);
+        Point2f* dst = flow[i];
+        for ( int j = 0; j < flow.cols; ++j )
+        {
+            if ( src[j][0] )
+                dst[j] = Point2f((src[j][2] - KITTI_FLOW_OFFSET) / KITTI_FLOW_SCALE,
+                                 (src[j][1] - KITTI_FLOW_OFFSET) / KITTI_FLOW_SCALE);
+            else
+                dst[j] = Point2f(unknown, unknown);
+        }
+    }
+    return flow;
+}
+
+static bool writeOpticalFlowKITTI( const String& path, const Mat& flow )
+{
+    Mat encoded(flow.size(), CV_16UC3);
+    for ( int i = 0; i < flow.rows; ++i )
+    {
+        const Point2f* src = flow.ptr<Point2f>(i);
+        Vec3w* dst = encoded.ptr<Vec3w>(i);
+        for ( int j = 0; j < flow.cols; ++j )
+        {
+            Point2f u = src[j];
+            // same unknown flow as in the .flo files
+            bool known = !cvIsNaN(u.x) && !cvIsNaN(u.y) && fabs(u.x) < 1e9 && fabs(u.y) < 1e9;
+            if ( known )
+                dst[j] = Vec3w(1, saturate_cast<ushort>(u.y * KITTI_FLOW_SCALE + KITTI_FLOW_OFFSET),
+                               saturate_cast<ushort>(u.x * KITTI_FLOW_SCALE + KITTI_FLOW_OFFSET));
+            else
+                dst[j] = Vec3w(0, 0, 0);
+        }
+    }
+    return imwrite(path, encoded);
+}
+
 CV_EXPORTS_W Mat readOpticalFlow( const String& path )
 {
 //    CV_Assert(sizeof(float) == 4);
     //FIXME: ensure right sizes of int and float - here and in writeOpticalFlow()
 
+    if ( isPngPath(path) )
+        return readOpticalFlowKITTI(path);
+
     Mat_<Point2f> flow;
     std::ifstream file(path.c_str(), std::ios_base::binary);
     if ( !file.good() )
@@ -66,25 +136,22 @@ CV_EXPORTS_W Mat readOpticalFlow( const String& path )
 
     file.read((char*) &width, 4);
     file.read((char*) &height, 4);
+    if ( !file.good() || width <= 0 || height <= 0 )
+        return flow;
 
-    flow.create(height, width);
+    // the file must hold the whole field, the size is sanity checked before the allocation
+    std::streampos dataStart = file.tellg();
+    file.seekg(0, std::ios_base::end);
+    std::streamoff dataSize = file.tellg() - dataStart;
+    file.seekg(dataStart);
+    if ( dataSize / ((std::streamoff)2 * sizeof(float)) < (std::streamoff)width * height )
+        return flow;
 
-    for ( int i = 0; i < flow.rows; ++i )
-    {
-        for ( int j = 0; j < flow.cols; ++j )
-        {
-            Point2f u;
-            file.read((char*) &u.x, sizeof(float));
-            file.read((char*) &u.y, sizeof(float));
-            if ( !file.good() )
-            {
-                flow.release();
-                return flow;
-            }
-
-            flow(i, j) = u;
-        }
-    }
+    // the values are stored in the order of a continuous CV_32FC2 matrix
+    flow.create(height, width);
+    file.read((char*) flow.ptr(), (std::streamsize)(flow.total() * flow.elemSize()));
+    if ( !file.good() )
+        flow.release();
     file.close();
     return flow;
 }
@@ -98,6 +165,9 @@ CV_EXPORTS_W bool writeOpticalFlow( const String& path, InputArray flow )
     if ( input.channels() != nChannels || input.depth() != CV_32F || path.length() == 0 )
         return false;
 
+    if ( isPngPath(path) )
+        return writeOpticalFlowKITTI(path, input);
+
     std::ofstream file(path.c_str(), std::ofstream::binary);
     if ( !file.good() )
         return false;
@@ -117,18 +187,18 @@ CV_EXPORTS_W bool writeOpticalFlow( const String& path, InputArray flow )
     if ( !file.good() )
         return false;
 
-//    if ( input.isContinuous() ) //matrix is continous - treat it as a single row
-//    {
-//        nCols *= nRows;
-//        nRows = 1;
-//    }
+    if ( input.isContinuous() ) //matrix is continous - treat it as a single row
+    {
+        nCols *= nRows;
+        nRows = 1;
+    }
 
     int row;
     char* p;
     for ( row = 0; row < nRows; row++ )
     {
         p = input.ptr<char>(row);
-        file.write(p, nCols * nChannels * sizeof(float));
+        file.write(p, (std::streamsize)nCols * nChannels * sizeof(float));
         if ( !file.good() )
             return false;
     }
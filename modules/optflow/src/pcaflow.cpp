@@ -191,14 +191,81 @@ void solveLSQR( const Mat &A, const Mat &b, OutputArray xOut, const double damp
   }
 }
 
-inline void _cpu_fillDCTSampledPoints( float *row, const Point2f &p, const Size &basisSize, const Size &size )
+/* The 2D DCT basis is separable, the row of A being the outer product of the 1D cosines in x and y:
+ * basisSize.width + basisSize.height cosines per point instead of two per basis function.
+ */
+inline void _cpu_fillDCTSampledPoints( float *row, const Point2f &p, const Size &basisSize, const Size &size,
+                                       float *cosX, float *cosY )
 {
+  for ( int n1 = 0; n1 < basisSize.width; ++n1 )
+    cosX[n1] = cosf( ( n1 * CV_PI / size.width ) * ( p.x + 0.5 ) );
+  for ( int n2 = 0; n2 < basisSize.height; ++n2 )
+    cosY[n2] = cosf( ( n2 * CV_PI / size.height ) * ( p.y + 0.5 ) );
   for ( int n1 = 0; n1 < basisSize.width; ++n1 )
     for ( int n2 = 0; n2 < basisSize.height; ++n2 )
-      row[n1 * basisSize.height + n2] =
-        cosf( ( n1 * CV_PI / size.width ) * ( p.x + 0.5 ) ) * cosf( ( n2 * CV_PI / size.height ) * ( p.y + 0.5 ) );
+      row[n1 * basisSize.height + n2] = cosX[n1] * cosY[n2];
 }
 
+/* Fills the rows of A and b sampled at the features, in parallel over the features */
+class FillSystem_ParBody : public ParallelLoopBody
+{
+public:
+  FillSystem_ParBody( Mat &_A, Mat &_b1, Mat &_b2, const std::vector<Point2f> &_features,
+                      const std::vector<Point2f> &_predictedFeatures, const Size &_basisSize, const Size &_size )
+      : A( _A ), b1( _b1 ), b2( _b2 ), features( _features ), predictedFeatures( _predictedFeatures ),
+        basisSize( _basisSize ), size( _size )
+  {
+  }
+
+  void operator()( const Range &range ) const
+  {
+    std::vector<float> cosX( basisSize.width ), cosY( basisSize.height );
+    for ( int i = range.start; i < range.end; ++i )
+    {
+      _cpu_fillDCTSampledPoints( A.ptr<float>( i ), features[i], basisSize, size, &cosX[0], &cosY[0] );
+      const Point2f flow = predictedFeatures[i] - features[i];
+      b1.at<float>( i ) = flow.x;
+      b2.at<float>( i ) = flow.y;
+    }
+  }
+
+private:
+  Mat &A, &b1, &b2;
+  const std::vector<Point2f> &features, &predictedFeatures;
+  const Size basisSize, size;
+
+  FillSystem_ParBody &operator=( const FillSystem_ParBody & ); // to quiet MSVC
+};
+
+/* The x and y systems are independent */
+class SolveLSQR_ParBody : public ParallelLoopBody
+{
+public:
+  SolveLSQR_ParBody( const Mat &_A1, const Mat &_A2, const Mat &_b1, const Mat &_b2, Mat &_w1, Mat &_w2,
+                     double _damp )
+      : A1( _A1 ), A2( _A2 ), b1( _b1 ), b2( _b2 ), w1( _w1 ), w2( _w2 ), damp( _damp )
+  {
+  }
+
+  void operator()( const Range &range ) const
+  {
+    for ( int i = range.start; i < range.end; ++i )
+    {
+      if ( i == 0 )
+        solveLSQR( A1, b1, w1, damp );
+      else
+        solveLSQR( A2, b2, w2, damp );
+    }
+  }
+
+private:
+  const Mat &A1, &A2, &b1, &b2;
+  Mat &w1, &w2;
+  const double damp;
+
+  SolveLSQR_ParBody &operator=( const SolveLSQR_ParBody & ); // to quiet MSVC
+};
+
 ocl::ProgramSource _ocl_fillDCTSampledPointsSource(
   "__kernel void fillDCTSampledPoints(__global const uchar* features, int fstep, int foff, __global "
   "uchar* A, int Astep, int Aoff, int fs, int bsw, int bsh, int sw, int sh) {"
@@ -348,13 +415,8 @@ void OpticalFlowPCAFlow::getSystem( OutputArray AOut, OutputArray b1Out, OutputA
     Mat b1 = b1Out.getMat();
     Mat b2 = b2Out.getMat();
 
-    for ( size_t i = 0; i < features.size(); ++i )
-    {
-      _cpu_fillDCTSampledPoints( A.ptr<float>( i ), features[i], basisSize, size );
-      const Point2f flow = predictedFeatures[i] - features[i];
-      b1.at<float>( i ) = flow.x;
-      b2.at<float>( i ) = flow.y;
-    }
+    parallel_for_( Range( 0, (int)features.size() ),
+                   FillSystem_ParBody( A, b1, b2, features, predictedFeatures, basisSize, size ) );
   }
 }
 
@@ -396,13 +458,8 @@ void OpticalFlowPCAFlow::getSystem( OutputArray A1Out, OutputArray A2Out, Output
     Mat b1 = b1Out.getMat();
     Mat b2 = b2Out.getMat();
 
-    for ( size_t i = 0; i < features.size(); ++i )
-    {
-      _cpu_fillDCTSampledPoints( A1.ptr<float>( i ), features[i], basisSize, size );
-      const Point2f flow = predictedFeatures[i] - features[i];
-      b1.at<float>( i ) = flow.x;
-      b2.at<float>( i ) = flow.y;
-    }
+    parallel_for_( Range( 0, (int)features.size() ),
+                   FillSystem_ParBody( A1, b1, b2, features, predictedFeatures, basisSize, size ) );
   }
 
   Mat A1 = A1Out.getMat();
@@ -461,15 +518,13 @@ void OpticalFlowPCAFlow::calc( InputArray I0, InputArray I1, InputOutputArray fl
   {
     Mat A1, A2, b1, b2;
     getSystem( A1, A2, b1, b2, features, predictedFeatures, size );
-    solveLSQR( A1, b1, w1, dampingFactor * size.area() );
-    solveLSQR( A2, b2, w2, dampingFactor * size.area() );
+    parallel_for_( Range( 0, 2 ), SolveLSQR_ParBody( A1, A2, b1, b2, w1, w2, dampingFactor * size.area() ) );
   }
   else
   {
     Mat A, b1, b2;
     getSystem( A, b1, b2, features, predictedFeatures, size );
-    solveLSQR( A, b1, w1, dampingFactor * size.area() );
-    solveLSQR( A, b2, w2, dampingFactor * size.area() );
+    parallel_for_( Range( 0, 2 ), SolveLSQR_ParBody( A, A, b1, b2, w1, w2, dampingFactor * size.area() ) );
   }
   Mat flowSmall( ( size / 8 ) * 2, CV_32FC2 );
   reduceToFlow( w1, w2, flowSmall, basisSize );
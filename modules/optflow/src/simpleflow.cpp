@@ -222,53 +222,79 @@ static void crossBilateralFilter(InputArray joint_,
   parallel_for_(range, CrossBilateralFilter<Vec3b, Vec2f>(jointTemp, confidenceTemp, srcTemp, src, radius, flag, spaceWeights, expLut));
 }
 
+class CalcConfidence : public ParallelLoopBody {
+    const Mat &prev, &next, &flow;
+    Mat &confidence;
+    int max_flow;
+
+public:
+    CalcConfidence(const Mat &prev_, const Mat &next_, const Mat &flow_, Mat &confidence_, int max_flow_)
+            :
+            prev(prev_),
+            next(next_),
+            flow(flow_),
+            confidence(confidence_),
+            max_flow(max_flow_) {
+    }
+
+    void operator()(const Range &range) const {
+      const int rows = prev.rows;
+      const int cols = prev.cols;
+      for (int r0 = range.start; r0 < range.end; ++r0) {
+        const Vec2f *flowRow = flow.ptr<Vec2f>(r0);
+        const Vec3b *prevRow = prev.ptr<Vec3b>(r0);
+        float *confidenceRow = confidence.ptr<float>(r0);
+        for (int c0 = 0; c0 < cols; ++c0) {
+          Vec2f flow_at_point = flowRow[c0];
+          int u0 = cvRound(flow_at_point[0]);
+          if (r0 + u0 < 0) { u0 = -r0; }
+          if (r0 + u0 >= rows) { u0 = rows - 1 - r0; }
+          int v0 = cvRound(flow_at_point[1]);
+          if (c0 + v0 < 0) { v0 = -c0; }
+          if (c0 + v0 >= cols) { v0 = cols - 1 - c0; }
+
+          const int top_row_shift = -std::min(r0 + u0, max_flow);
+          const int bottom_row_shift = std::min(rows - 1 - (r0 + u0), max_flow);
+          const int left_col_shift = -std::min(c0 + v0, max_flow);
+          const int right_col_shift = std::min(cols - 1 - (c0 + v0), max_flow);
+
+          bool first_flow_iteration = true;
+          int sum_e = 0, min_e = 0;
+
+          for (int u = top_row_shift; u <= bottom_row_shift; ++u) {
+            const Vec3b *nextRow = next.ptr<Vec3b>(r0 + u0 + u) + c0 + v0;
+            for (int v = left_col_shift; v <= right_col_shift; ++v) {
+              int e = dist(prevRow[c0], nextRow[v]);
+              if (first_flow_iteration) {
+                sum_e = e;
+                min_e = e;
+                first_flow_iteration = false;
+              } else {
+                sum_e += e;
+                min_e = std::min(min_e, e);
+              }
+            }
+          }
+          int windows_square = (bottom_row_shift - top_row_shift + 1) *
+                               (right_col_shift - left_col_shift + 1);
+          confidenceRow[c0] = (windows_square == 0) ? 0
+                                                    : static_cast<float>(sum_e) / windows_square - min_e;
+          CV_Assert(confidenceRow[c0] >= 0);
+        }
+      }
+    }
+
+private:
+    CalcConfidence& operator=(const CalcConfidence&); // to quiet MSVC
+};
+
 static void calcConfidence(const Mat& prev,
                            const Mat& next,
                            const Mat& flow,
                            Mat& confidence,
                            int max_flow) {
-  const int rows = prev.rows;
-  const int cols = prev.cols;
-  confidence = Mat::zeros(rows, cols, CV_32F);
-
-  for (int r0 = 0; r0 < rows; ++r0) {
-    for (int c0 = 0; c0 < cols; ++c0) {
-      Vec2f flow_at_point = flow.at<Vec2f>(r0, c0);
-      int u0 = cvRound(flow_at_point[0]);
-      if (r0 + u0 < 0) { u0 = -r0; }
-      if (r0 + u0 >= rows) { u0 = rows - 1 - r0; }
-      int v0 = cvRound(flow_at_point[1]);
-      if (c0 + v0 < 0) { v0 = -c0; }
-      if (c0 + v0 >= cols) { v0 = cols - 1 - c0; }
-
-      const int top_row_shift = -std::min(r0 + u0, max_flow);
-      const int bottom_row_shift = std::min(rows - 1 - (r0 + u0), max_flow);
-      const int left_col_shift = -std::min(c0 + v0, max_flow);
-      const int right_col_shift = std::min(cols - 1 - (c0 + v0), max_flow);
-
-      bool first_flow_iteration = true;
-      int sum_e = 0, min_e = 0;
-
-      for (int u = top_row_shift; u <= bottom_row_shift; ++u) {
-        for (int v = left_col_shift; v <= right_col_shift; ++v) {
-          int e = dist(prev.at<Vec3b>(r0, c0), next.at<Vec3b>(r0 + u0 + u, c0 + v0 + v));
-          if (first_flow_iteration) {
-            sum_e = e;
-            min_e = e;
-            first_flow_iteration = false;
-          } else {
-            sum_e += e;
-            min_e = std::min(min_e, e);
-          }
-        }
-      }
-      int windows_square = (bottom_row_shift - top_row_shift + 1) *
-                           (right_col_shift - left_col_shift + 1);
-      confidence.at<float>(r0, c0) = (windows_square == 0) ? 0
-                                                           : static_cast<float>(sum_e) / windows_square - min_e;
-      CV_Assert(confidence.at<float>(r0, c0) >= 0);
-    }
-  }
+  confidence = Mat::zeros(prev.rows, prev.cols, CV_32F);
+  parallel_for_(Range(0, prev.rows), CalcConfidence(prev, next, flow, confidence, max_flow));
 }
 
 template<typename SrcVec, typename DstVec>
@@ -420,26 +446,49 @@ static Mat upscaleOpticalFlow(int new_rows,
   return new_flow;
 }
 
-static Mat calcIrregularityMat(const Mat& flow, int radius) {
-  const int rows = flow.rows;
-  const int cols = flow.cols;
-  Mat irregularity = Mat::zeros(rows, cols, CV_32F);
-  for (int r = 0; r < rows; ++r) {
-    const int start_row = std::max(0, r - radius);
-    const int end_row = std::min(rows - 1, r + radius);
-    for (int c = 0; c < cols; ++c) {
-      const int start_col = std::max(0, c - radius);
-      const int end_col = std::min(cols - 1, c + radius);
-      for (int dr = start_row; dr <= end_row; ++dr) {
-        for (int dc = start_col; dc <= end_col; ++dc) {
-          const float diff = dist(flow.at<Vec2f>(r, c), flow.at<Vec2f>(dr, dc));
-          if (diff > irregularity.at<float>(r, c)) {
-            irregularity.at<float>(r, c) = diff;
+class CalcIrregularity : public ParallelLoopBody {
+    const Mat &flow;
+    Mat &irregularity;
+    int radius;
+
+public:
+    CalcIrregularity(const Mat &flow_, Mat &irregularity_, int radius_)
+            :
+            flow(flow_),
+            irregularity(irregularity_),
+            radius(radius_) {
+    }
+
+    void operator()(const Range &range) const {
+      const int rows = flow.rows;
+      const int cols = flow.cols;
+      for (int r = range.start; r < range.end; ++r) {
+        const int start_row = std::max(0, r - radius);
+        const int end_row = std::min(rows - 1, r + radius);
+        const Vec2f *flowRow = flow.ptr<Vec2f>(r);
+        float *irregularityRow = irregularity.ptr<float>(r);
+        for (int c = 0; c < cols; ++c) {
+          const int start_col = std::max(0, c - radius);
+          const int end_col = std::min(cols - 1, c + radius);
+          float max_diff = 0;
+          for (int dr = start_row; dr <= end_row; ++dr) {
+            const Vec2f *neighbourRow = flow.ptr<Vec2f>(dr);
+            for (int dc = start_col; dc <= end_col; ++dc) {
+              max_diff = std::max(max_diff, dist(flowRow[c], neighbourRow[dc]));
+            }
           }
+          irregularityRow[c] = max_diff;
         }
       }
     }
-  }
+
+private:
+    CalcIrregularity& operator=(const CalcIrregularity&); // to quiet MSVC
+};
+
+static Mat calcIrregularityMat(const Mat& flow, int radius) {
+  Mat irregularity = Mat::zeros(flow.rows, flow.cols, CV_32F);
+  parallel_for_(Range(0, flow.rows), CalcIrregularity(flow, irregularity, radius));
   return irregularity;
 }
 
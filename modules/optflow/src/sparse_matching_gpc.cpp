@@ -155,6 +155,37 @@ void getRandomCauchyVector( Vec< double, GPCPatchDescriptor::nFeatures > &v )
   for ( unsigned i = 0; i < GPCPatchDescriptor::nFeatures; ++i )
     v[i] = getRandomCauchyScalar();
 }
+
+/* Projections of the two descriptors of every sample onto the hyperplane normal: proj[2k] and proj[2k+1] for the
+ * sample begin + k. Every sample writes its own entries, so the result doesn't depend on the number of threads. */
+class ProjectSamples_ParBody : public ParallelLoopBody
+{
+public:
+  ProjectSamples_ParBody( const Vec< double, GPCPatchDescriptor::nFeatures > &_coef, GPCSamplesVector::const_iterator _begin,
+                          std::vector< double > &_proj )
+      : coef( _coef ), begin( _begin ), proj( _proj )
+  {
+  }
+
+  void operator()( const Range &range ) const
+  {
+    for ( int k = range.start; k < range.end; ++k )
+    {
+      const GPCPatchSample &sample = *( begin + k );
+      proj[2 * k] = coef.dot( sample.first.feature );
+      proj[2 * k + 1] = coef.dot( sample.second.feature );
+    }
+  }
+
+private:
+  const Vec< double, GPCPatchDescriptor::nFeatures > &coef;
+  GPCSamplesVector::const_iterator begin;
+  std::vector< double > &proj;
+
+  ProjectSamples_ParBody &operator=( const ProjectSamples_ParBody & ); // to quiet MSVC
+};
+
+const int samplesPerStripe = 4096; // small nodes are projected by the calling thread
 }
 
 GPCPatchDescriptor::GPCPatchDescriptor( const Mat *imgCh, int i, int j )
@@ -199,7 +230,8 @@ bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
 
   // Select the best hyperplane
   unsigned globalBestScore = 0;
-  std::vector< double > values;
+  const int nSamples = (int)std::distance( begin, end );
+  std::vector< double > proj( 2 * nSamples ), values;
 
   for ( int j = 0; j < globalIters; ++j )
   { // Global search step
@@ -212,24 +244,18 @@ bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
       double randomModification = getRandomCauchyScalar();
       const int pos = i % GPCPatchDescriptor::nFeatures;
       std::swap( coef[pos], randomModification );
-      values.clear();
 
-      for ( SIter iter = begin; iter != end; ++iter )
-      {
-        values.push_back( coef.dot( iter->first.feature ) );
-        values.push_back( coef.dot( iter->second.feature ) );
-      }
+      // The projections are computed once, the median search reorders a copy of them
+      parallel_for_( Range( 0, nSamples ), ProjectSamples_ParBody( coef, begin, proj ), double( nSamples ) / samplesPerStripe );
+      values = proj;
 
       std::nth_element( values.begin(), values.begin() + values.size() / 2, values.end() );
       const double median = values[values.size() / 2];
       unsigned correct = 0;
 
-      for ( SIter iter = begin; iter != end; ++iter )
-      {
-        const bool direction = ( coef.dot( iter->first.feature ) < median );
-        if ( direction == ( coef.dot( iter->second.feature ) < median ) )
+      for ( int k = 0; k < nSamples; ++k )
+        if ( ( proj[2 * k] < median ) == ( proj[2 * k + 1] < median ) )
           ++correct;
-      }
 
       if ( correct > localBestScore )
         localBestScore = correct;
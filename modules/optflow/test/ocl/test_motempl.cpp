@@ -58,9 +58,63 @@ OCL_TEST_P(UpdateMotionHistory, Mat)
     }
 }
 
+PARAM_TEST_CASE(CalcMotionGradient, int, bool)
+{
+    int aperture_size;
+    bool use_roi;
+
+    TEST_DECLARE_INPUT_PARAMETER(mhi);
+    TEST_DECLARE_OUTPUT_PARAMETER(mask);
+    TEST_DECLARE_OUTPUT_PARAMETER(orientation);
+
+    virtual void SetUp()
+    {
+        aperture_size = GET_PARAM(0);
+        use_roi = GET_PARAM(1);
+    }
+
+    virtual void generateTestData()
+    {
+        Size roiSize = randomSize(1, MAX_VALUE);
+        Border mhiBorder = randomBorder(0, use_roi ? MAX_VALUE : 0);
+        randomSubMat(mhi, mhi_roi, roiSize, mhiBorder, CV_32FC1, 0, 8);
+
+        // integer timestamps keep the derivatives exact, so the masks can be compared as they are
+        Mat mhi_int;
+        mhi.convertTo(mhi_int, CV_32S);
+        mhi_int.convertTo(mhi, CV_32F);
+
+        Border maskBorder = randomBorder(0, use_roi ? MAX_VALUE : 0);
+        randomSubMat(mask, mask_roi, roiSize, maskBorder, CV_8UC1, 0, 2);
+
+        Border orientationBorder = randomBorder(0, use_roi ? MAX_VALUE : 0);
+        randomSubMat(orientation, orientation_roi, roiSize, orientationBorder, CV_32FC1, 0, 360);
+
+        UMAT_UPLOAD_INPUT_PARAMETER(mhi);
+        UMAT_UPLOAD_OUTPUT_PARAMETER(mask);
+        UMAT_UPLOAD_OUTPUT_PARAMETER(orientation);
+    }
+};
+
+OCL_TEST_P(CalcMotionGradient, Mat)
+{
+    for (int j = 0; j < test_loop_times; j++)
+    {
+        generateTestData();
+
+        OCL_OFF(cv::motempl::calcMotionGradient(mhi_roi, mask_roi, orientation_roi, 1, 5, aperture_size));
+        OCL_ON(cv::motempl::calcMotionGradient(umhi_roi, umask_roi, uorientation_roi, 1, 5, aperture_size));
+
+        OCL_EXPECT_MATS_NEAR(mask, 0);
+        // fastAtan2 on the CPU is accurate to about 0.3 degrees
+        OCL_EXPECT_MATS_NEAR(orientation, 1);
+    }
+}
+
 //////////////////////////////////////// Instantiation /////////////////////////////////////////
 
 OCL_INSTANTIATE_TEST_CASE_P(Video, UpdateMotionHistory, Values(false, true));
+OCL_INSTANTIATE_TEST_CASE_P(Video, CalcMotionGradient, Combine(Values(3, 5), Values(false, true)));
 
 } } // namespace cvtest::ocl
 
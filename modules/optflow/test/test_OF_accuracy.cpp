@@ -166,6 +166,67 @@ TEST(DenseOpticalFlow_DIS, ReferenceAccuracy)
     }
 }
 
+TEST(DenseOpticalFlow_DIS, VideoMode)
+{
+    Mat frame1, frame2, GT;
+    ASSERT_TRUE(readRubberWhale(frame1, frame2, GT));
+    float target_RMSE = 0.74f;
+    cvtColor(frame1, frame1, COLOR_BGR2GRAY);
+    cvtColor(frame2, frame2, COLOR_BGR2GRAY);
+
+    Ptr<DISOpticalFlow> algo = createOptFlow_DIS(DISOpticalFlow::PRESET_FAST);
+    algo->setUseVideoMode(true);
+    ASSERT_TRUE(algo->getUseVideoMode());
+
+    // the first call has nothing cached yet
+    Mat flow, flow_ref;
+    algo->calc(frame1, frame2, flow);
+    createOptFlow_DIS(DISOpticalFlow::PRESET_FAST)->calc(frame1, frame2, flow_ref);
+    EXPECT_EQ(0, cvtest::norm(flow, flow_ref, NORM_INF));
+
+    // warm start from the previous flow
+    Mat flow_warm;
+    algo->calc(frame1, frame2, flow_warm);
+    EXPECT_LE(calcRMSE(GT, flow_warm), target_RMSE);
+
+    // I0 being the previous I1, its pyramid is reused
+    Mat flow_back, flow_shared;
+    algo->calc(frame2, frame1, flow_back);
+    algo->calc(frame1, frame2, flow_shared);
+    ASSERT_EQ(GT.rows, flow_shared.rows);
+    ASSERT_EQ(GT.cols, flow_shared.cols);
+    EXPECT_LE(calcRMSE(GT, flow_shared), target_RMSE);
+}
+
+TEST(DenseOpticalFlow_DIS, ReferenceAccuracyUMat)
+{
+    Mat frame1, frame2, GT;
+    ASSERT_TRUE(readRubberWhale(frame1, frame2, GT));
+    int presets[] = {DISOpticalFlow::PRESET_ULTRAFAST, DISOpticalFlow::PRESET_FAST, DISOpticalFlow::PRESET_MEDIUM};
+    // the OpenCL version visits the patches in another order during the spatial propagation
+    float target_RMSE[] = {0.88f, 0.76f, 0.51f};
+    cvtColor(frame1, frame1, COLOR_BGR2GRAY);
+    cvtColor(frame2, frame2, COLOR_BGR2GRAY);
+
+    UMat ocl_frame1, ocl_frame2;
+    frame1.copyTo(ocl_frame1);
+    frame2.copyTo(ocl_frame2);
+
+    Ptr<DenseOpticalFlow> algo;
+
+    // iterate over presets:
+    for (int i = 0; i < 3; i++)
+    {
+        UMat ocl_flow;
+        algo = createOptFlow_DIS(presets[i]);
+        algo->calc(ocl_frame1, ocl_frame2, ocl_flow);
+        Mat flow = ocl_flow.getMat(ACCESS_READ).clone();
+        ASSERT_EQ(GT.rows, flow.rows);
+        ASSERT_EQ(GT.cols, flow.cols);
+        EXPECT_LE(calcRMSE(GT, flow), target_RMSE[i]);
+    }
+}
+
 TEST(DenseOpticalFlow_VariationalRefinement, ReferenceAccuracy)
 {
     Mat frame1, frame2, GT;
@@ -188,3 +249,41 @@ TEST(DenseOpticalFlow_VariationalRefinement, ReferenceAccuracy)
     ASSERT_EQ(GT.cols, flow.cols);
     EXPECT_LE(calcRMSE(GT, flow), target_RMSE);
 }
+
+TEST(OpticalFlowIO, WriteReadFloAndPng)
+{
+    Mat flow(37, 53, CV_32FC2);
+    randu(flow, -300.f, 300.f);
+    flow.at<Point2f>(3, 5) = Point2f(1e10f, 1e10f);
+
+    string floPath = tempfile(".flo");
+    ASSERT_TRUE(writeOpticalFlow(floPath, flow));
+    Mat flo = readOpticalFlow(floPath);
+    ASSERT_EQ(CV_32FC2, flo.type());
+    EXPECT_EQ(0, norm(flow, flo, NORM_INF));
+    // a part of a non continuous matrix
+    ASSERT_TRUE(writeOpticalFlow(floPath, flow(Rect(2, 3, 31, 17))));
+    flo = readOpticalFlow(floPath);
+    EXPECT_EQ(0, norm(flow(Rect(2, 3, 31, 17)), flo, NORM_INF));
+    remove(floPath.c_str());
+
+    string pngPath = tempfile(".png");
+    ASSERT_TRUE(writeOpticalFlow(pngPath, flow));
+    Mat png = readOpticalFlow(pngPath);
+    remove(pngPath.c_str());
+    ASSERT_EQ(CV_32FC2, png.type());
+    ASSERT_EQ(flow.size(), png.size());
+    for (int i = 0; i < flow.rows; i++)
+        for (int j = 0; j < flow.cols; j++)
+        {
+            Point2f u = flow.at<Point2f>(i, j), v = png.at<Point2f>(i, j);
+            if (isFlowCorrect(u.x))
+            {
+                // quantized to 1/64 pixel
+                EXPECT_LE(fabs(u.x - v.x), 0.5f / 64 + 1e-4f);
+                EXPECT_LE(fabs(u.y - v.y), 0.5f / 64 + 1e-4f);
+            }
+            else
+                EXPECT_TRUE(cvIsNaN(v.x) && cvIsNaN(v.y));
+        }
+}
@@ -75,6 +75,20 @@ namespace cv
             CV_WRAP virtual void setPlotTextColor(Scalar _plotTextColor) = 0;
             CV_WRAP virtual void setPlotSize(int _plotSizeWidth, int _plotSizeHeight) = 0;
             CV_WRAP virtual void render(Mat &_plotResult) = 0;
+
+            /** @brief Appends points to the plotted data, e.g. the new samples of a live trace.
+            The next render() only draws the lines to the new points on the last rendered plot, as long
+            as no setting was changed in between. The limits of the axes are not updated from the new
+            points, so set them with setMinX(), setMaxX(), setMinY() and setMaxY() to cover the data.
+            @param data the new Y values, a 1xN or Nx1 CV_64F matrix. Their X values continue the indices
+            of the points.
+            */
+            CV_WRAP virtual void appendPlotData(Mat data) = 0;
+            /** @overload
+            @param dataX the X values of the new points, a 1xN or Nx1 CV_64F matrix
+            @param dataY the Y values of the new points, of the same size as dataX
+            */
+            CV_WRAP virtual void appendPlotData(Mat dataX, Mat dataY) = 0;
         };
 
         CV_EXPORTS_W Ptr<Plot2d> createPlot2d(Mat data);
@@ -53,6 +53,26 @@ namespace cv
     {
         using namespace std;
 
+        //Image coordinates of the data, as int(size*(X - minVal)/(maxVal - minVal)) with the negative
+        //coordinates set to 0
+        static void dataToPixels(const double* data, int n, double minVal, double maxVal, int size, int* pixels)
+        {
+            double scale = size/(maxVal - minVal);
+            int i = 0;
+#if CV_SIMD128_64F
+            v_float64x2 vmin = v_setall_f64(minVal), vscale = v_setall_f64(scale);
+            v_int32x4 vzero = v_setzero_s32();
+            for( ; i <= n - 4; i += 4 )
+            {
+                v_int32x4 lo = v_trunc((v_load(data + i) - vmin)*vscale);
+                v_int32x4 hi = v_trunc((v_load(data + i + 2) - vmin)*vscale);
+                v_store(pixels + i, v_max(v_combine_low(lo, hi), vzero));
+            }
+#endif
+            for( ; i < n; i++ )
+                pixels[i] = std::max((int)((data[i] - minVal)*scale), 0);
+        }
+
         class Plot2dImpl : public Plot2d
         {
             public:
@@ -125,45 +145,55 @@ namespace cv
             {
                 plotMinX = _plotMinX;
                 plotMinX_plusZero = _plotMinX;
+                plotCacheValid = false;
             }
             void setMaxX(double _plotMaxX)
             {
                 plotMaxX = _plotMaxX;
                 plotMaxX_plusZero = _plotMaxX;
+                plotCacheValid = false;
             }
             void setMinY(double _plotMinY)
             {
                 plotMinY = _plotMinY;
                 plotMinY_plusZero = _plotMinY;
+                plotCacheValid = false;
             }
             void setMaxY(double _plotMaxY)
             {
                 plotMaxY = _plotMaxY;
                 plotMaxY_plusZero = _plotMaxY;
+                plotCacheValid = false;
             }
             void setPlotLineWidth(int _plotLineWidth)
             {
                 plotLineWidth=_plotLineWidth;
+                plotCacheValid = false;
             }
             void setPlotLineColor(Scalar _plotLineColor)
             {
                 plotLineColor=_plotLineColor;
+                plotCacheValid = false;
             }
             void setPlotBackgroundColor(Scalar _plotBackgroundColor)
             {
                 plotBackgroundColor=_plotBackgroundColor;
+                plotCacheValid = false;
             }
             void setPlotAxisColor(Scalar _plotAxisColor)
             {
                 plotAxisColor=_plotAxisColor;
+                plotCacheValid = false;
             }
             void setPlotGridColor(Scalar _plotGridColor)
             {
                 plotGridColor=_plotGridColor;
+                plotCacheValid = false;
             }
             void setPlotTextColor(Scalar _plotTextColor)
             {
                 plotTextColor=_plotTextColor;
+                plotCacheValid = false;
             }
             void setPlotSize(int _plotSizeWidth, int _plotSizeHeight)
             {
@@ -176,57 +206,78 @@ namespace cv
                     plotSizeHeight = _plotSizeHeight;
                 else
                     plotSizeHeight = 300;
+
+                plotCacheValid = false;
             }
 
-            //render the plotResult to a Mat
-            void render(Mat &_plotResult)
+            void appendPlotData(Mat _plotData)
             {
-                //create the plot result
-                plotResult = Mat(plotSizeHeight, plotSizeWidth, CV_8UC3, plotBackgroundColor);
-
-                int NumVecElements = plotDataX.rows;
+                CV_Assert(_plotData.type() == CV_64F && (_plotData.rows == 1 || _plotData.cols == 1));
 
-                Mat InterpXdata = linearInterpolation(plotMinX, plotMaxX, 0, plotSizeWidth, plotDataX);
-                Mat InterpYdata = linearInterpolation(plotMinY, plotMaxY, 0, plotSizeHeight, plotDataY);
-
-                //Find the zeros in image coordinates
-                Mat InterpXdataFindZero = linearInterpolation(plotMinX_plusZero, plotMaxX_plusZero, 0, plotSizeWidth, plotDataX_plusZero);
-                Mat InterpYdataFindZero = linearInterpolation(plotMinY_plusZero, plotMaxY_plusZero, 0, plotSizeHeight, plotDataY_plusZero);
+                Mat dataX(_plotData.rows*_plotData.cols, 1, CV_64F);
+                for (int i=0; i<dataX.rows; i++)
+                {
+                    dataX.at<double>(i,0) = plotDataX.rows + i;
+                }
+                appendPlotData(dataX, _plotData);
+            }
 
-                int ImageXzero = (int)InterpXdataFindZero.at<double>(NumVecElements,0);
-                int ImageYzero = (int)InterpYdataFindZero.at<double>(NumVecElements,0);
+            void appendPlotData(Mat _plotDataX, Mat _plotDataY)
+            {
+                CV_Assert(_plotDataX.type() == CV_64F && _plotDataY.type() == CV_64F);
+                CV_Assert((_plotDataX.rows == 1 || _plotDataX.cols == 1) && (_plotDataY.rows == 1 || _plotDataY.cols == 1));
+                CV_Assert(_plotDataX.total() == _plotDataY.total());
 
-                double CurrentX = plotDataX.at<double>(NumVecElements-1,0);
-                double CurrentY = plotDataY.at<double>(NumVecElements-1,0);
+                //the new points and the line to them are drawn on the last rendered plot
+                plotDataX.push_back(_plotDataX.cols > 1 ? Mat(_plotDataX.t()) : _plotDataX);
+                plotDataY.push_back(_plotDataY.cols > 1 ? Mat(_plotDataY.t()) : _plotDataY);
+            }
 
-                //Draw the plot by connecting lines between the points
-                Point p1;
-                p1.x = (int)InterpXdata.at<double>(0,0);
-                p1.y = (int)InterpYdata.at<double>(0,0);
+            //render the plotResult to a Mat
+            void render(Mat &_plotResult)
+            {
+                int NumVecElements = plotDataX.rows;
 
-                drawAxis(ImageXzero,ImageYzero, CurrentX, CurrentY, plotAxisColor, plotGridColor);
+                //Redraw everything if some setting changed, otherwise only the appended data
+                if(!plotCacheValid || plotCache.empty())
+                {
+                    //create the plot result
+                    plotCache = Mat(plotSizeHeight, plotSizeWidth, CV_8UC3, plotBackgroundColor);
+                    plotResult = plotCache;
 
-                for (int r=1; r<InterpXdata.rows; r++){
+                    //Find the zeros in image coordinates
+                    int ImageXzero, ImageYzero;
+                    double zero = 0;
+                    dataToPixels(&zero, 1, plotMinX_plusZero, plotMaxX_plusZero, plotSizeWidth, &ImageXzero);
+                    dataToPixels(&zero, 1, plotMinY_plusZero, plotMaxY_plusZero, plotSizeHeight, &ImageYzero);
 
-                    Point p2;
-                    p2.x = (int)InterpXdata.at<double>(r,0);
-                    p2.y = (int)InterpYdata.at<double>(r,0);
+                    drawAxis(ImageXzero,ImageYzero, plotAxisColor, plotGridColor);
 
-                    line(plotResult, p1, p2, plotLineColor, plotLineWidth, 8, 0);
+                    drawnPoints = 0;
+                    plotCacheValid = true;
+                }
 
-                    p1 = p2;
+                //Draw the plot by connecting lines between the points, from the last drawn one on
+                plotResult = plotCache;
+                drawPlotLine(std::max(drawnPoints - 1, 0));
+                drawnPoints = NumVecElements;
 
+                plotResult = plotCache.clone();
+                if(NumVecElements > 0)
+                {
+                    double CurrentX = plotDataX.at<double>(NumVecElements-1,0);
+                    double CurrentY = plotDataY.at<double>(NumVecElements-1,0);
+                    drawValuesAsText("X = %g",CurrentX, 0, 0, 40, 20);
+                    drawValuesAsText("Y = %g",CurrentY, 0, 20, 40, 20);
                 }
 
-                _plotResult = plotResult.clone();
+                _plotResult = plotResult;
             }
 
             protected:
 
             Mat plotDataX;
             Mat plotDataY;
-            Mat plotDataX_plusZero;
-            Mat plotDataY_plusZero;
             const char * plotName;
 
             //dimensions and limits of the plot
@@ -252,29 +303,28 @@ namespace cv
             //the final plot result
             Mat plotResult;
 
-            void plotHelper(Mat _plotDataX, Mat _plotDataY)
-            {
-                plotDataX=_plotDataX;
-                plotDataY=_plotDataY;
+            //the plot without the current values, and how many points are drawn on it
+            Mat plotCache;
+            int drawnPoints;
+            bool plotCacheValid;
 
-                int NumVecElements = plotDataX.rows;
+            //image coordinates of the points being drawn
+            std::vector<int> pixelsX;
+            std::vector<int> pixelsY;
 
-                plotDataX_plusZero = Mat::zeros(NumVecElements+1,1,CV_64F);
-                plotDataY_plusZero = Mat::zeros(NumVecElements+1,1,CV_64F);
+            void plotHelper(Mat _plotDataX, Mat _plotDataY)
+            {
+                //the points are read as contiguous arrays
+                plotDataX = _plotDataX.isContinuous() ? _plotDataX : _plotDataX.clone();
+                plotDataY = _plotDataY.isContinuous() ? _plotDataY : _plotDataY.clone();
 
-                for(int i=0; i<NumVecElements; i++){
-                    plotDataX_plusZero.at<double>(i,0) = plotDataX.at<double>(i,0);
-                    plotDataY_plusZero.at<double>(i,0) = plotDataY.at<double>(i,0);
-                }
+                plotCacheValid = false;
+                drawnPoints = 0;
 
                 double MinX;
                 double MaxX;
                 double MinY;
                 double MaxY;
-                double MinX_plusZero;
-                double MaxX_plusZero;
-                double MinY_plusZero;
-                double MaxY_plusZero;
 
                 //Obtain the minimum and maximum values of Xdata
                 minMaxLoc(plotDataX,&MinX,&MaxX);
@@ -282,11 +332,11 @@ namespace cv
                 //Obtain the minimum and maximum values of Ydata
                 minMaxLoc(plotDataY,&MinY,&MaxY);
 
-                //Obtain the minimum and maximum values of Xdata plus zero
-                minMaxLoc(plotDataX_plusZero,&MinX_plusZero,&MaxX_plusZero);
-
-                //Obtain the minimum and maximum values of Ydata plus zero
-                minMaxLoc(plotDataY_plusZero,&MinY_plusZero,&MaxY_plusZero);
+                //The minimum and maximum values of the data plus zero
+                double MinX_plusZero = std::min(MinX, 0.);
+                double MaxX_plusZero = std::max(MaxX, 0.);
+                double MinY_plusZero = std::min(MinY, 0.);
+                double MaxY_plusZero = std::max(MaxY, 0.);
 
                 //setting the min and max values for each axis
                 plotMinX = MinX;
@@ -312,14 +362,12 @@ namespace cv
                 setPlotTextColor(Scalar(255, 255, 255));
             }
 
-            void drawAxis(int ImageXzero, int ImageYzero, double CurrentX, double CurrentY, Scalar axisColor, Scalar gridColor)
+            void drawAxis(int ImageXzero, int ImageYzero, Scalar axisColor, Scalar gridColor)
             {
                 drawValuesAsText(0, ImageXzero, ImageYzero, 10, 20);
                 drawValuesAsText(0, ImageXzero, ImageYzero, -20, 20);
                 drawValuesAsText(0, ImageXzero, ImageYzero, 10, -10);
                 drawValuesAsText(0, ImageXzero, ImageYzero, -20, -10);
-                drawValuesAsText("X = %g",CurrentX, 0, 0, 40, 20);
-                drawValuesAsText("Y = %g",CurrentY, 0, 20, 40, 20);
 
                 //Horizontal X axis and equispaced horizontal lines
                 int LineSpace = 50;
@@ -353,21 +401,39 @@ namespace cv
                 }
             }
 
-            Mat linearInterpolation(double Xa, double Xb, double Ya, double Yb, Mat Xdata){
-
-                Mat Ydata = Xdata*0;
-
-                for (int i=0; i<Xdata.rows; i++){
-
-                    double X = Xdata.at<double>(i,0);
-                    Ydata.at<double>(i,0) = int(Ya + (Yb-Ya)*(X-Xa)/(Xb-Xa));
-
-                    if(Ydata.at<double>(i,0)<0)
-                        Ydata.at<double>(i,0)=0;
+            //Draw the lines between the points from start on. All the consecutive points that fall into the
+            //same pixel column are drawn as one vertical line, which covers the same pixels as their lines
+            void drawPlotLine(int start)
+            {
+                int n = plotDataX.rows - start;
+                if(n < 2)
+                    return;
+
+                pixelsX.resize(n);
+                pixelsY.resize(n);
+                dataToPixels(plotDataX.ptr<double>(start), n, plotMinX, plotMaxX, plotSizeWidth, &pixelsX[0]);
+                dataToPixels(plotDataY.ptr<double>(start), n, plotMinY, plotMaxY, plotSizeHeight, &pixelsY[0]);
+
+                Point p1(pixelsX[0], pixelsY[0]);
+                int r = 1;
+                while(r < n){
+
+                    if(pixelsX[r] != p1.x){
+                        Point p2(pixelsX[r], pixelsY[r]);
+                        line(plotResult, p1, p2, plotLineColor, plotLineWidth, 8, 0);
+                        p1 = p2;
+                        r++;
+                        continue;
+                    }
 
+                    int MinPixelY = p1.y, MaxPixelY = p1.y;
+                    for( ; r < n && pixelsX[r] == p1.x; r++){
+                        MinPixelY = std::min(MinPixelY, pixelsY[r]);
+                        MaxPixelY = std::max(MaxPixelY, pixelsY[r]);
+                    }
+                    line(plotResult, Point(p1.x, MinPixelY), Point(p1.x, MaxPixelY), plotLineColor, plotLineWidth, 8, 0);
+                    p1.y = pixelsY[r-1];
                 }
-
-                return Ydata;
             }
 
             void drawValuesAsText(double Value, int Xloc, int Yloc, int XMargin, int YMargin){
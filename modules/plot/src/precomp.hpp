@@ -50,6 +50,7 @@
 
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 #include "opencv2/plot.hpp"
 #include "opencv2/opencv_modules.hpp"
 
@@ -39,6 +39,7 @@
 #define MAPPERPYRAMID_H_
 
 #include "mapper.hpp"
+#include <vector>
 
 
 namespace cv {
@@ -63,12 +64,26 @@ public:
 
     cv::Ptr<Map> getMap(void) const;
 
+    /*
+     * Computes and keeps the pyramid of a reference image, reused by calculate() while it is called with
+     * this same image and number of levels, as when registering the frames of a video against one reference.
+     * The image data must not change while it is set.
+     * \param[in] img1 Reference image
+     */
+    void setReference(const cv::Mat& img1);
+
+    /*
+     * Releases the pyramid kept by setReference()
+     */
+    void clearReference(void);
+
     unsigned numLev_;           /*!< Number of levels of the pyramid */
     unsigned numIterPerScale_;  /*!< Number of iterations at a given scale of the pyramid */
 
 private:
     MapperPyramid& operator=(const MapperPyramid&);
     const Mapper& baseMapper_;  /*!< Mapper used in inner level */
+    std::vector<cv::Mat> refPyramid_;  /*!< Pyramid of the reference image set by setReference() */
 };
 
 //! @}
@@ -36,12 +36,24 @@
 //M*/
 
 #include "precomp.hpp"
+#include "normalequations.hpp"
 #include "opencv2/reg/mappergradshift.hpp"
 #include "opencv2/reg/mapshift.hpp"
 
 namespace cv {
 namespace reg {
 
+// Derivatives of a pixel with respect to the shift
+struct ShiftJacobian
+{
+    enum { N = 2 };
+    static void compute(double, double, double Ix, double Iy, double* J)
+    {
+        J[0] = Ix;
+        J[1] = Iy;
+    }
+};
+
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 MapperGradShift::MapperGradShift(void)
@@ -59,7 +71,6 @@ MapperGradShift::~MapperGradShift(void)
 void MapperGradShift::calculate(
     const cv::Mat& img1, const cv::Mat& image2, cv::Ptr<Map>& res) const
 {
-    Mat gradx, grady, imgDiff;
     Mat img2;
 
     CV_DbgAssert(img1.size() == image2.size());
@@ -71,23 +82,10 @@ void MapperGradShift::calculate(
         img2 = image2;
     }
 
-    // Get gradient in all channels
-    gradient(img1, img2, gradx, grady, imgDiff);
-
-    // Calculate parameters using least squares
+    // Calculate parameters using least squares, accumulated over all the pixels and channels
     Matx<double, 2, 2> A;
     Vec<double, 2> b;
-    // For each value in A, all the matrix elements are added and then the channels are also added,
-    // so we have two calls to "sum". The result can be found in the first element of the final
-    // Scalar object.
-
-    A(0, 0) = sum(sum(gradx.mul(gradx)))[0];
-    A(0, 1) = sum(sum(gradx.mul(grady)))[0];
-    A(1, 1) = sum(sum(grady.mul(grady)))[0];
-    A(1, 0) = A(0, 1);
-
-    b(0) = -sum(sum(imgDiff.mul(gradx)))[0];
-    b(1) = -sum(sum(imgDiff.mul(grady)))[0];
+    computeNormalEquations<ShiftJacobian>(img1, img2, A, b);
 
     // Calculate shift. We use Cholesky decomposition, as A is symmetric.
     Vec<double, 2> shift = A.inv(DECOMP_CHOLESKY)*b;
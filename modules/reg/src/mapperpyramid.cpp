@@ -68,14 +68,16 @@ void MapperPyramid::calculate(const Mat& img1, const Mat& image2, Ptr<Map>& res)
 
     cv::Ptr<Map> ident = baseMapper_.getMap();
 
-    // Precalculate pyramid images
-    vector<Mat> pyrIm1(numLev_), pyrIm2(numLev_);
-    pyrIm1[0] = img1;
-    pyrIm2[0] = img2;
-    for(size_t im_i = 1; im_i < numLev_; ++im_i) {
-        pyrDown(pyrIm1[im_i - 1], pyrIm1[im_i]);
-        pyrDown(pyrIm2[im_i - 1], pyrIm2[im_i]);
+    // Precalculate pyramid images, reusing the reference pyramid if it was set for img1
+    bool cachedRef = refPyramid_.size() == numLev_ && refPyramid_[0].data == img1.data &&
+                     refPyramid_[0].size() == img1.size() && refPyramid_[0].type() == img1.type();
+    vector<Mat> pyrIm1, pyrIm2;
+    if(cachedRef) {
+        pyrIm1 = refPyramid_;
+    } else {
+        buildPyramid(img1, pyrIm1, (int)numLev_ - 1);
     }
+    buildPyramid(img2, pyrIm2, (int)numLev_ - 1);
 
     Mat currRef, currImg;
     for(size_t lv_i = 0; lv_i < numLev_; ++lv_i) {
@@ -93,6 +95,18 @@ void MapperPyramid::calculate(const Mat& img1, const Mat& image2, Ptr<Map>& res)
     res->compose(*ident.get());
 }
 
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void MapperPyramid::setReference(const Mat& img1)
+{
+    buildPyramid(img1, refPyramid_, (int)numLev_ - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+void MapperPyramid::clearReference(void)
+{
+    refPyramid_.clear();
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 cv::Ptr<Map> MapperPyramid::getMap(void) const
 {
@@ -0,0 +1,167 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#ifndef OPENCV_REG_NORMALEQUATIONS_HPP__
+#define OPENCV_REG_NORMALEQUATIONS_HPP__
+
+#include <opencv2/core.hpp>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include <vector>
+
+namespace cv {
+namespace reg {
+
+/*
+ * Accumulates the normal equations A = sum(J*J^t), b = -sum(It*J) of the least squares step of a gradient
+ * mapper, for all the pixels and channels of two CV_64F images. The gradients of img2 and the difference It
+ * are computed on the fly, as Mapper::gradient does, so no intermediate image is allocated.
+ *
+ * Jacobian gives the N parameter derivatives J of a pixel from its coordinates and its gradient:
+ *     enum { N = ... };
+ *     static void compute(double x, double y, double Ix, double Iy, double* J);
+ *
+ * The rows are processed in parallel in fixed blocks whose sums are added in order, so the result does
+ * not depend on the number of threads.
+ */
+template<class Jacobian>
+class NormalEquationsInvoker : public ParallelLoopBody
+{
+public:
+    enum { N = Jacobian::N, NA = N*(N + 1)/2, NSUMS = NA + N };
+
+    // Rows of a block of the accumulation
+    static int blockRows() { return 16; }
+
+    NormalEquationsInvoker(const Mat& _img1, const Mat& _img2, std::vector<double>& _sums)
+        : img1(_img1), img2(_img2), sums(_sums)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        const int rows = img1.rows, cn = img1.channels(), len = img1.cols*cn;
+        // The jacobians of a row, parameter by parameter, then the image differences
+        AutoBuffer<double> _buf((N + 1)*len);
+        double* J = _buf;
+        double* It = J + N*len;
+
+        for(int blk = range.start; blk < range.end; ++blk) {
+            double* acc = &sums[(size_t)blk*NSUMS];
+            for(int i = 0; i < NSUMS; ++i)
+                acc[i] = 0.;
+
+            int y0 = blk*blockRows(), y1 = std::min(y0 + blockRows(), rows);
+            for(int y = y0; y < y1; ++y) {
+                computeRow(y, J, It);
+                accumulateRow(J, It, len, acc);
+            }
+        }
+    }
+
+private:
+    void computeRow(int y, double* J, double* It) const
+    {
+        const int rows = img1.rows, cols = img1.cols, cn = img1.channels(), len = cols*cn;
+        const double* p1 = img1.ptr<double>(y);
+        const double* p2 = img2.ptr<double>(y);
+        const double* up = img2.ptr<double>(std::max(y - 1, 0));
+        const double* down = img2.ptr<double>(std::min(y + 1, rows - 1));
+        double Jp[N];
+
+        for(int x = 0; x < cols; ++x) {
+            // Central differences with replicated borders
+            int left = std::max(x - 1, 0)*cn, right = std::min(x + 1, cols - 1)*cn;
+            for(int c = 0; c < cn; ++c) {
+                int k = x*cn + c;
+                double Ix = (p2[right + c] - p2[left + c])*0.5;
+                double Iy = (down[k] - up[k])*0.5;
+                Jacobian::compute(x, y, Ix, Iy, Jp);
+                for(int i = 0; i < N; ++i)
+                    J[i*len + k] = Jp[i];
+                It[k] = p2[k] - p1[k];
+            }
+        }
+    }
+
+    // Adds the upper triangle of sum(J*J^t) and -sum(It*J) of a row to acc
+    static void accumulateRow(const double* J, const double* It, int len, double* acc)
+    {
+        int k = 0;
+#if CV_SIMD128_64F
+        v_float64x2 vA[NA], vb[N];
+        for(int i = 0; i < NA; ++i)
+            vA[i] = v_setzero_f64();
+        for(int i = 0; i < N; ++i)
+            vb[i] = v_setzero_f64();
+        for(; k <= len - 2; k += 2) {
+            v_float64x2 vJ[N], vIt = v_load(It + k);
+            for(int i = 0; i < N; ++i)
+                vJ[i] = v_load(J + i*len + k);
+            for(int i = 0, a = 0; i < N; ++i) {
+                for(int j = i; j < N; ++j, ++a)
+                    vA[a] += vJ[i]*vJ[j];
+                vb[i] -= vIt*vJ[i];
+            }
+        }
+        double CV_DECL_ALIGNED(16) buf[2];
+        for(int i = 0; i < NA; ++i) {
+            v_store_aligned(buf, vA[i]);
+            acc[i] += buf[0] + buf[1];
+        }
+        for(int i = 0; i < N; ++i) {
+            v_store_aligned(buf, vb[i]);
+            acc[NA + i] += buf[0] + buf[1];
+        }
+#endif
+        for(; k < len; ++k) {
+            for(int i = 0, a = 0; i < N; ++i) {
+                double Ji = J[i*len + k];
+                for(int j = i; j < N; ++j, ++a)
+                    acc[a] += Ji*J[j*len + k];
+                acc[NA + i] -= It[k]*Ji;
+            }
+        }
+    }
+
+    const Mat& img1;
+    const Mat& img2;
+    std::vector<double>& sums;
+
+    NormalEquationsInvoker& operator=(const NormalEquationsInvoker&); // to quiet MSVC
+};
+
+template<class Jacobian>
+void computeNormalEquations(const Mat& img1, const Mat& img2,
+                            Matx<double, Jacobian::N, Jacobian::N>& A, Vec<double, Jacobian::N>& b)
+{
+    typedef NormalEquationsInvoker<Jacobian> Invoker;
+    const int N = Jacobian::N;
+
+    CV_Assert(img1.depth() == CV_64F && img1.type() == img2.type() && img1.size() == img2.size());
+
+    int nblocks = (img1.rows + Invoker::blockRows() - 1)/Invoker::blockRows();
+    std::vector<double> sums((size_t)nblocks*Invoker::NSUMS);
+    parallel_for_(Range(0, nblocks), Invoker(img1, img2, sums));
+
+    A = Matx<double, Jacobian::N, Jacobian::N>::zeros();
+    b = Vec<double, Jacobian::N>::all(0.);
+    for(int blk = 0; blk < nblocks; ++blk) {
+        const double* acc = &sums[(size_t)blk*Invoker::NSUMS];
+        for(int i = 0, a = 0; i < N; ++i) {
+            for(int j = i; j < N; ++j, ++a)
+                A(i, j) += acc[a];
+            b(i) += acc[Invoker::NA + i];
+        }
+    }
+
+    // Lower half values (A is symmetric)
+    for(int i = 1; i < N; ++i)
+        for(int j = 0; j < i; ++j)
+            A(i, j) = A(j, i);
+}
+
+}}  // namespace cv::reg
+
+#endif  // OPENCV_REG_NORMALEQUATIONS_HPP__
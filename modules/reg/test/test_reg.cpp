@@ -70,6 +70,7 @@ public:
     void testSimilarity();
     void testAffine();
     void testProjective();
+    void testReference();
 private:
     Mat img1;
 };
@@ -242,6 +243,29 @@ void RegTest::testProjective()
     EXPECT_GE(projNorm, sqrt(3.) - 0.01);
 }
 
+void RegTest::testReference()
+{
+    // Register two frames against the same reference, with and without its pyramid kept
+    MapperGradAffine mapper;
+    MapperPyramid mappPyr(mapper), mappPyrRef(mapper);
+    mappPyrRef.setReference(img1);
+
+    for(int i = 1; i <= 2; ++i) {
+        Mat img2;
+        MapAffine mapTest(Matx<double, 2, 2>(1., 0.02*i, -0.01*i, 1.), Vec<double, 2>(2.*i, 3.));
+        mapTest.warp(img1, img2);
+
+        Ptr<Map> mapPtr, mapPtrRef;
+        mappPyr.calculate(img1, img2, mapPtr);
+        mappPyrRef.calculate(img1, img2, mapPtrRef);
+
+        MapAffine* mapAff = dynamic_cast<MapAffine*>(mapPtr.get());
+        MapAffine* mapAffRef = dynamic_cast<MapAffine*>(mapPtrRef.get());
+        EXPECT_EQ(0., norm(mapAff->getLinTr() - mapAffRef->getLinTr()));
+        EXPECT_EQ(0., norm(mapAff->getShift() - mapAffRef->getShift()));
+    }
+}
+
 void RegTest::loadImage()
 {
     const string imageName = cvtest::TS::ptr()->get_data_path() + "reg/home.png";
@@ -282,3 +306,9 @@ TEST_F(RegTest, projective)
     loadImage();
     testProjective();
 }
+
+TEST_F(RegTest, reference_pyramid)
+{
+    loadImage();
+    testReference();
+}
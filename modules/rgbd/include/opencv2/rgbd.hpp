@@ -315,6 +315,58 @@ namespace rgbd
                 InputArray Rt, InputArray unregisteredDepth, const Size& outputImagePlaneSize,
                 OutputArray registeredDepth, bool depthDilation=false);
 
+  /** Front end of an RGB-D frame: registers the depth to an external camera, cleans it, converts it to
+   * 3d points and computes their normals in one call.
+   * The cleaning and the conversion to 3d points are done together row by row while the registered
+   * depth is in cache, and every intermediate image is kept from one frame to the next.
+   * It gives the same results as calling registerDepth, DepthCleaner, depthTo3d and RgbdNormals in a row.
+   */
+  class CV_EXPORTS RgbdFrontEnd: public Algorithm
+  {
+  public:
+    /** Constructor
+     * @param unregisteredCameraMatrix the camera matrix of the depth camera
+     * @param registeredCameraMatrix the camera matrix of the external camera
+     * @param registeredDistCoeffs the distortion coefficients of the external camera
+     * @param Rt the rigid body transform between the cameras, from depth camera frame to external camera frame
+     * @param outputImagePlaneSize the image plane dimensions of the external camera (width, height)
+     * @param depthDilation whether or not the registered depth is dilated to avoid holes
+     * @param clean whether or not the registered depth is cleaned with DepthCleaner::DEPTH_CLEANER_NIL
+     * @param normals_method one of the RgbdNormals methods
+     * @param window_size the window size to compute the normals: can only be 1,3,5 or 7
+     */
+    RgbdFrontEnd(InputArray unregisteredCameraMatrix, InputArray registeredCameraMatrix,
+                 InputArray registeredDistCoeffs, InputArray Rt, const Size& outputImagePlaneSize,
+                 bool depthDilation = false, bool clean = true,
+                 int normals_method = RgbdNormals::RGBD_NORMALS_METHOD_FALS, int window_size = 5);
+
+    /** Processes a depth frame
+     * @param depth the unregistered depth image, CV_16U (in millimeters), CV_32F or CV_64F (in meters)
+     * @param registeredDepth the registered (and cleaned) depth, of the same type as depth
+     * @param points3d the CV_32FC3 3d points of the registered depth
+     * @param normals the CV_32FC3 normals of the points, not computed if not needed
+     */
+    void
+    operator()(InputArray depth, OutputArray registeredDepth, OutputArray points3d,
+               OutputArray normals = noArray()) const;
+
+  protected:
+    Matx33f unregistered_K_;
+    Matx33f registered_K_;
+    Mat_<float> registered_dist_coeffs_;
+    Matx44f Rt_;
+    Size size_;
+    bool depth_dilation_;
+    bool clean_;
+    Ptr<RgbdNormals> normals_;
+
+    // intermediate images kept between frames
+    mutable Mat registered_;
+    mutable Mat_<Point3f> cloud_;
+    mutable Mat_<Point3f> transformed_cloud_;
+    mutable Mat points3d_;
+  };
+
   /**
    * @param depth the depth image
    * @param in_K
@@ -351,13 +403,16 @@ namespace rgbd
   rescaleDepth(InputArray in, int depth, OutputArray out);
 
   /** Object that can compute planes in an image
+   * - RGBD_PLANE_METHOD_DEFAULT grows the planes one after the other from the most planar blocks
+   * - RGBD_PLANE_METHOD_PARALLEL fits all the planar blocks at once, merges the neighboring ones
+   *   lying on the same plane with a union-find and assigns the points to the planes in parallel
    */
   class CV_EXPORTS RgbdPlane: public Algorithm
   {
   public:
     enum RGBD_PLANE_METHOD
     {
-      RGBD_PLANE_METHOD_DEFAULT
+      RGBD_PLANE_METHOD_DEFAULT, RGBD_PLANE_METHOD_PARALLEL
     };
 
     RgbdPlane(RGBD_PLANE_METHOD method = RGBD_PLANE_METHOD_DEFAULT)
@@ -1013,6 +1068,51 @@ namespace rgbd
     mutable Ptr<RgbdNormals> normalsComputer;
   };
 
+  /** Odometry over a sequence of frames.
+   * Each call computes the transformation from the previous frame to the given one. The cache the
+   * given frame gets in the dstFrame role (image, depth and cloud pyramids) is kept and reused when
+   * the frame becomes the srcFrame of the next call, so these pyramids are built once per frame.
+   * The role dependent data (masks, normals, derivatives) is prepared again, the results are the
+   * same as the ones of Odometry::compute on each pair of frames.
+   */
+  class CV_EXPORTS OdometryStream
+  {
+  public:
+    /** @param odometry The odometry used for the consecutive frames.
+     */
+    OdometryStream(const Ptr<Odometry>& odometry);
+
+    /** Computes the transformation from the previous frame to the given one.
+     * The method returns false for the first frame (Rt is set to the identity) and otherwise the
+     * result of Odometry::compute. The frame becomes the previous frame in both cases.
+     * @param frame The new frame, its cache is prepared for the dstFrame role.
+     * @param Rt Resulting transformation from the previous frame to the new one (see Odometry::compute).
+     * @param initRt Initial transformation from the previous frame to the new one (optional)
+     */
+    bool
+    compute(Ptr<OdometryFrame>& frame, Mat& Rt, const Mat& initRt = Mat());
+
+    /** The same as above for the frame data of image, depth and mask (see Odometry::compute).
+     */
+    bool
+    compute(const Mat& image, const Mat& depth, const Mat& mask, Mat& Rt, const Mat& initRt = Mat());
+
+    /** Forgets the previous frame, the next frame starts a new sequence.
+     */
+    void
+    reset();
+
+    Ptr<Odometry>
+    getOdometry() const
+    {
+      return odometry;
+    }
+
+  protected:
+    Ptr<Odometry> odometry;
+    Ptr<OdometryFrame> prevFrame;
+  };
+
   /** Warp the image: compute 3d points from the depth, transform them using given transformation,
    * then project color point cloud to an image plane.
    * This function can be used to visualize results of the Odometry algorithm.
@@ -0,0 +1,85 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::rgbd;
+using namespace perf;
+
+// The odometries on synthetic smooth frames, the second frame is the first one moved by a few pixels
+
+typedef std::tr1::tuple<string, Size> Odometry_t;
+typedef perf::TestBaseWithParam<Odometry_t> odometry;
+
+static Mat cameraMatrix(Size size)
+{
+    float f = 525.f * size.width / 640.f;
+    return (Mat_<float>(3, 3) << f, 0.f, (size.width - 1) * 0.5f, 0.f, f, (size.height - 1) * 0.5f, 0.f, 0.f, 1.f);
+}
+
+static void makeFrames(Size size, Mat images[2], Mat depths[2])
+{
+    RNG rng(0);
+    Mat image(size, CV_8UC1), depth(size, CV_32FC1);
+    rng.fill(image, RNG::UNIFORM, 0, 256);
+    GaussianBlur(image, image, Size(0, 0), 2);
+    rng.fill(depth, RNG::UNIFORM, 1.f, 3.f);
+    GaussianBlur(depth, depth, Size(0, 0), 8);
+
+    Mat M = (Mat_<double>(2, 3) << 1, 0, 3, 0, 1, 1);
+    images[0] = image;
+    depths[0] = depth;
+    warpAffine(image, images[1], M, size, INTER_LINEAR, BORDER_REPLICATE);
+    warpAffine(depth, depths[1], M, size, INTER_NEAREST, BORDER_REPLICATE);
+}
+
+#define ODOMETRY_TYPES "RgbdOdometry", "ICPOdometry", "RgbdICPOdometry"
+
+PERF_TEST_P(odometry, compute,
+            testing::Combine(
+                testing::Values(ODOMETRY_TYPES),
+                testing::Values(szQVGA, szVGA)))
+{
+    string type = std::tr1::get<0>(GetParam());
+    Size size = std::tr1::get<1>(GetParam());
+
+    Mat images[2], depths[2];
+    makeFrames(size, images, depths);
+    Ptr<Odometry> odom = Odometry::create(type);
+    odom->setCameraMatrix(cameraMatrix(size));
+
+    Mat Rt;
+    TEST_CYCLE() odom->compute(images[0], depths[0], Mat(), images[1], depths[1], Mat(), Rt);
+
+    SANITY_CHECK_NOTHING();
+}
+
+// A video loop, each frame is prepared once and used in both roles
+PERF_TEST_P(odometry, stream,
+            testing::Combine(
+                testing::Values(ODOMETRY_TYPES),
+                testing::Values(szQVGA, szVGA)))
+{
+    string type = std::tr1::get<0>(GetParam());
+    Size size = std::tr1::get<1>(GetParam());
+
+    Mat images[2], depths[2];
+    makeFrames(size, images, depths);
+    Ptr<Odometry> odom = Odometry::create(type);
+    odom->setCameraMatrix(cameraMatrix(size));
+    OdometryStream stream(odom);
+
+    Mat Rt;
+    int frame = 0;
+    stream.compute(images[frame], depths[frame], Mat(), Rt);
+    TEST_CYCLE()
+    {
+        frame = 1 - frame;
+        stream.compute(images[frame], depths[frame], Mat(), Rt);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
@@ -43,6 +43,7 @@
 
 
 #include "precomp.hpp"
+#include "utils.h"
 
 
 namespace cv
@@ -132,6 +133,8 @@ namespace rgbd
      * @param depthDilation whether or not the depth is dilated to avoid holes and occlusion errors
      * @param inputDepthToMetersScale the scale needed to transform the input depth units to meters
      * @param registeredDepth the result of transforming the depth into the external camera
+     * @param point_tmp buffer for the cloud of the input depth
+     * @param transformedCloud buffer for the transformed cloud
      */
     template<typename DepthDepth>
     void
@@ -143,11 +146,14 @@ namespace rgbd
                         const Size outputImagePlaneSize,
                         const bool depthDilation,
                         const float inputDepthToMetersScale,
-                        Mat &registeredDepth)
+                        Mat &registeredDepth,
+                        Mat_<Point3f> &point_tmp,
+                        Mat_<Point3f> &transformedCloud)
     {
 
         // Create output Mat of the correct type, filled with an initial value indicating no depth
-        registeredDepth = Mat_<DepthDepth>(outputImagePlaneSize, noDepthSentinelValue<DepthDepth>());
+        registeredDepth.create(outputImagePlaneSize, DataType<DepthDepth>::type);
+        registeredDepth.setTo(Scalar::all(noDepthSentinelValue<DepthDepth>()));
 
         // Figure out whether we'll have to apply a distortion
         bool hasDistortion = (countNonZero(registeredDistCoeffs) > 0);
@@ -183,9 +189,8 @@ namespace rgbd
         }
 
         // Apply the initial projection to the input depth
-        Mat_<Point3f> transformedCloud;
         {
-            Mat_<Point3f> point_tmp(outputImagePlaneSize);
+            point_tmp.create(outputImagePlaneSize);
 
             for(int j = 0; j < point_tmp.rows; ++j)
             {
@@ -341,31 +346,43 @@ namespace rgbd
 
 
         Mat &registeredDepthMat = registeredDepth.getMatRef();
+        Mat_<Point3f> cloud, transformedCloud;
 
+        registerDepthBuffered(_unregisteredCameraMatrix, _registeredCameraMatrix, _registeredDistCoeffs, _rbtRgb2Depth,
+                              unregisteredDepth.getMat(), outputImagePlaneSize, registeredDepthMat, depthDilation,
+                              cloud, transformedCloud);
+    }
+
+    void
+    registerDepthBuffered(const Matx33f& unregisteredCameraMatrix, const Matx33f& registeredCameraMatrix,
+                          const Mat_<float>& registeredDistCoeffs, const Matx44f& Rt, const Mat& unregisteredDepth,
+                          const Size& outputImagePlaneSize, Mat& registeredDepth, bool depthDilation,
+                          Mat_<Point3f>& cloud, Mat_<Point3f>& transformedCloud)
+    {
         switch (unregisteredDepth.depth())
         {
             case CV_16U:
             {
-                performRegistration<unsigned short>(unregisteredDepth.getMat(), _unregisteredCameraMatrix,
-                                                    _registeredCameraMatrix, _registeredDistCoeffs,
-                                                    _rbtRgb2Depth, outputImagePlaneSize, depthDilation,
-                                                    .001f, registeredDepthMat);
+                performRegistration<unsigned short>(unregisteredDepth, unregisteredCameraMatrix,
+                                                    registeredCameraMatrix, registeredDistCoeffs,
+                                                    Rt, outputImagePlaneSize, depthDilation,
+                                                    .001f, registeredDepth, cloud, transformedCloud);
                 break;
             }
             case CV_32F:
             {
-                performRegistration<float>(unregisteredDepth.getMat(), _unregisteredCameraMatrix,
-                                           _registeredCameraMatrix, _registeredDistCoeffs,
-                                           _rbtRgb2Depth, outputImagePlaneSize, depthDilation,
-                                           1.0f, registeredDepthMat);
+                performRegistration<float>(unregisteredDepth, unregisteredCameraMatrix,
+                                           registeredCameraMatrix, registeredDistCoeffs,
+                                           Rt, outputImagePlaneSize, depthDilation,
+                                           1.0f, registeredDepth, cloud, transformedCloud);
                 break;
             }
             case CV_64F:
             {
-                performRegistration<double>(unregisteredDepth.getMat(), _unregisteredCameraMatrix,
-                                            _registeredCameraMatrix, _registeredDistCoeffs,
-                                            _rbtRgb2Depth, outputImagePlaneSize, depthDilation,
-                                            1.0f, registeredDepthMat);
+                performRegistration<double>(unregisteredDepth, unregisteredCameraMatrix,
+                                            registeredCameraMatrix, registeredDistCoeffs,
+                                            Rt, outputImagePlaneSize, depthDilation,
+                                            1.0f, registeredDepth, cloud, transformedCloud);
                 break;
             }
             default:
@@ -373,8 +390,6 @@ namespace rgbd
                 CV_Error(Error::StsUnsupportedFormat, "Input depth must be unsigned short, float, or double.");
             }
         }
-
-
     }
 
 } /* namespace rgbd */
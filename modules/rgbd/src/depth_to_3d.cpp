@@ -34,9 +34,14 @@
  */
 
 #include <opencv2/rgbd.hpp>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/core/ocl.hpp>
+#include <opencv2/core/hal/intrin.hpp>
+#include "opencv2/core/private.hpp"
 
 #include "depth_to_3d.h"
 #include "utils.h"
+#include "opencl_kernels_rgbd.hpp"
 
 namespace cv
 {
@@ -125,6 +130,76 @@ namespace rgbd
     points3d = points3d.reshape(3, 1);
   }
 
+  /** Computes the points of a row from the cached x factors, the y factor and the depths
+   * @return the number of points computed with SIMD instructions, the caller does the others
+   */
+  template<typename T>
+  inline int
+  depthTo3dRowSIMD(const T*, T, const T*, T*, int)
+  {
+    return 0;
+  }
+
+#if CV_SIMD128
+  template<>
+  inline int
+  depthTo3dRowSIMD<float>(const float* x_cache, float y_factor, const float* depth, float* points, int cols)
+  {
+    v_float32x4 vy = v_setall_f32(y_factor);
+    int x = 0;
+    for (; x <= cols - 4; x += 4)
+    {
+      v_float32x4 z = v_load(depth + x);
+      v_store_interleave(points + 3 * x, v_load(x_cache + x) * z, vy * z, z);
+    }
+    return x;
+  }
+#endif
+
+  /** Computes the 3d points of a range of rows of the depth image
+   */
+  template<typename T>
+  class DepthTo3dNoMaskInvoker : public ParallelLoopBody
+  {
+  public:
+    DepthTo3dNoMaskInvoker(const Mat_<T>& z_mat, const Mat_<T>& x_cache, const Mat_<T>& y_cache, Mat& points3d)
+        :
+          z_mat_(z_mat),
+          x_cache_(x_cache),
+          y_cache_(y_cache),
+          points3d_(points3d)
+    {
+    }
+
+    virtual void
+    operator()(const Range& range) const
+    {
+      const T* x_cache = x_cache_[0];
+      for (int y = range.start; y < range.end; ++y)
+      {
+        T y_factor = y_cache_(y, 0);
+        const T* depth = z_mat_[y];
+        T* point = points3d_.ptr<T>(y);
+        int x = depthTo3dRowSIMD<T>(x_cache, y_factor, depth, point, z_mat_.cols);
+        for (point += 3 * x; x < z_mat_.cols; ++x, point += 3)
+        {
+          T z = depth[x];
+          point[0] = x_cache[x] * z;
+          point[1] = y_factor * z;
+          point[2] = z;
+        }
+      }
+    }
+
+  private:
+    const Mat_<T>& z_mat_;
+    const Mat_<T>& x_cache_;
+    const Mat_<T>& y_cache_;
+    Mat& points3d_;
+
+    DepthTo3dNoMaskInvoker& operator=(const DepthTo3dNoMaskInvoker&); // to quiet MSVC
+  };
+
   /**
    * @param K
    * @param depth the depth image
@@ -154,21 +229,34 @@ namespace rgbd
     for (int y = 0; y < in_depth.rows; ++y, ++y_cache_ptr)
       *y_cache_ptr = (y - oy) * inv_fy;
 
-    y_cache_ptr = y_cache[0];
-    for (int y = 0; y < in_depth.rows; ++y, ++y_cache_ptr)
-    {
-      cv::Vec<T, 3>* point = points3d.ptr<cv::Vec<T, 3> >(y);
-      const T* x_cache_ptr_end = x_cache[0] + in_depth.cols;
-      const T* depth = z_mat[y];
-      for (x_cache_ptr = x_cache[0]; x_cache_ptr != x_cache_ptr_end; ++x_cache_ptr, ++point, ++depth)
-      {
-        T z = *depth;
-        (*point)[0] = (*x_cache_ptr) * z;
-        (*point)[1] = (*y_cache_ptr) * z;
-        (*point)[2] = z;
-      }
-    }
+    parallel_for_(Range(0, in_depth.rows), DepthTo3dNoMaskInvoker<T>(z_mat, x_cache, y_cache, points3d));
+  }
+
+#ifdef HAVE_OPENCL
+  static bool
+  ocl_depthTo3dNoMask(InputArray depth_in, const Mat& K, OutputArray points3d_out)
+  {
+    int depth_type = depth_in.type();
+    if (K.depth() != CV_32F || depth_type == CV_64FC1)
+      return false;
+
+    String opts = depth_type == CV_16UC1 ? "-D DEPTH_TYPE=ushort -D DEPTH_16U" :
+                  depth_type == CV_16SC1 ? "-D DEPTH_TYPE=short -D DEPTH_16S" : "-D DEPTH_TYPE=float";
+    ocl::Kernel k("depthTo3d", ocl::rgbd::depth_to_3d_oclsrc, opts);
+    if (k.empty())
+      return false;
+
+    UMat depth = depth_in.getUMat();
+    points3d_out.create(depth.size(), CV_32FC3);
+    UMat points3d = points3d_out.getUMat();
+
+    k.args(ocl::KernelArg::ReadOnlyNoSize(depth), ocl::KernelArg::WriteOnly(points3d),
+           1.0f / K.at<float>(0, 0), 1.0f / K.at<float>(1, 1), K.at<float>(0, 2), K.at<float>(1, 2));
+
+    size_t globalsize[2] = { (size_t)depth.cols, (size_t)depth.rows };
+    return k.run(2, globalsize, NULL, false);
   }
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -224,23 +312,28 @@ namespace rgbd
   void
   depthTo3d(InputArray depth_in, InputArray K_in, OutputArray points3d_out, InputArray mask_in)
   {
-    cv::Mat depth = depth_in.getMat();
     cv::Mat K = K_in.getMat();
-    cv::Mat mask = mask_in.getMat();
+    int depth_type = depth_in.type(), depth_depth = CV_MAT_DEPTH(depth_type);
     CV_Assert(K.cols == 3 && K.rows == 3 && (K.depth() == CV_64F || K.depth()==CV_32F));
     CV_Assert(
-        depth.type() == CV_64FC1 || depth.type() == CV_32FC1 || depth.type() == CV_16UC1 || depth.type() == CV_16SC1);
-    CV_Assert(mask.empty() || mask.channels() == 1);
+        depth_type == CV_64FC1 || depth_type == CV_32FC1 || depth_type == CV_16UC1 || depth_type == CV_16SC1);
+    CV_Assert(mask_in.empty() || mask_in.channels() == 1);
 
     // TODO figure out what to do when types are different: convert or reject ?
     cv::Mat K_new;
-    if ((depth.depth() == CV_32F || depth.depth() == CV_64F) && depth.depth() != K.depth())
+    if ((depth_depth == CV_32F || depth_depth == CV_64F) && depth_depth != K.depth())
     {
-      K.convertTo(K_new, depth.depth());
+      K.convertTo(K_new, depth_depth);
     }
     else
       K_new = K;
 
+    CV_OCL_RUN(points3d_out.isUMat() && mask_in.empty() && depth_in.dims() <= 2,
+               ocl_depthTo3dNoMask(depth_in, K_new, points3d_out))
+
+    cv::Mat depth = depth_in.getMat();
+    cv::Mat mask = mask_in.getMat();
+
     // Create 3D points in one go.
     if (!mask.empty())
     {
@@ -0,0 +1,194 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "precomp.hpp"
+#include "utils.h"
+
+namespace cv
+{
+namespace rgbd
+{
+  /** Cleans the registered depth and computes its 3d points, a range of rows at a time.
+   * The cleaning is the one of DepthCleaner::DEPTH_CLEANER_NIL written as a gather over the 3x3
+   * neighbourhood of each pixel, so that a row only needs the rows just above and below it.
+   */
+  template<typename DepthDepth, typename ContainerDepth>
+  class FrontEndRowsInvoker : public ParallelLoopBody
+  {
+  public:
+    FrontEndRowsInvoker(const Mat& registered, bool clean, ContainerDepth scale, const Matx33f& K,
+                        Mat& depth_out, Mat& points3d)
+        :
+          registered_(registered),
+          clean_(clean),
+          scale_(scale),
+          depth_out_(depth_out),
+          points3d_(points3d)
+    {
+      const float inv_fx = 1.f / K(0, 0), ox = K(0, 2);
+      inv_fy_ = 1.f / K(1, 1);
+      oy_ = K(1, 2);
+      x_cache_.resize(registered.cols);
+      for (int x = 0; x < registered.cols; ++x)
+        x_cache_[x] = (x - ox) * inv_fx;
+    }
+
+    virtual void
+    operator()(const Range& range) const
+    {
+      const ContainerDepth theta_mean = (float)(30. * CV_PI / 180);
+      const ContainerDepth sigma_L = (float)(0.8 + 0.035 * theta_mean / (CV_PI / 2 - theta_mean));
+      const ContainerDepth difference_threshold = 10;
+      const int rows = registered_.rows, cols = registered_.cols;
+
+      for (int y = range.start; y < range.end; ++y)
+      {
+        const DepthDepth* depth_in = registered_.ptr<DepthDepth>(y);
+        DepthDepth* depth_out = depth_out_.ptr<DepthDepth>(y);
+        Point3f* point = points3d_.ptr<Point3f>(y);
+        const float y_factor = (y - oy_) * inv_fy_;
+
+        for (int x = 0; x < cols; ++x)
+        {
+          if (clean_)
+          {
+            const DepthDepth d = depth_in[x];
+            const ContainerDepth sigma_z = (float)(0.0012 + 0.0019 * (d * scale_ - 0.4) * (d * scale_ - 0.4));
+            ContainerDepth w_sum = 0, Dw_sum = 0;
+            for (int j = -1; j <= 1; ++j)
+            {
+              if (y + j < 0 || y + j >= rows)
+                continue;
+              const DepthDepth* neighbors = registered_.ptr<DepthDepth>(y + j);
+              for (int i = -1; i <= 1; ++i)
+              {
+                if (x + i < 0 || x + i >= cols)
+                  continue;
+                // DepthCleaner only weighs a pair of pixels when the first of them in row-major
+                // order is not on the left, right or bottom border
+                bool first = (j > 0) || (j == 0 && i >= 0);
+                int first_y = first ? y : y + j, first_x = first ? x : x + i;
+                if (first_y >= rows - 1 || first_x < 1 || first_x >= cols - 1)
+                  continue;
+
+                const DepthDepth n = neighbors[x + i];
+                ContainerDepth delta_u = sqrt(ContainerDepth(j) * ContainerDepth(j) + ContainerDepth(i) * ContainerDepth(i));
+                ContainerDepth delta_z;
+                if (d > n)
+                  delta_z = (float)(d - n);
+                else
+                  delta_z = (float)(n - d);
+                if (delta_z < difference_threshold)
+                {
+                  delta_z *= scale_;
+                  ContainerDepth w = exp(
+                      -delta_u * delta_u / 2 / sigma_L / sigma_L - delta_z * delta_z / 2 / sigma_z / sigma_z);
+                  w_sum += w;
+                  Dw_sum += n * w;
+                }
+              }
+            }
+            depth_out[x] = saturate_cast<DepthDepth>(w_sum != 0 ? Dw_sum / w_sum : ContainerDepth(0));
+          }
+
+          float z = toMeters(depth_out[x]);
+          point[x].x = x_cache_[x] * z;
+          point[x].y = y_factor * z;
+          point[x].z = z;
+        }
+      }
+    }
+
+  private:
+    // the same conversion as rescaleDepth
+    float
+    toMeters(DepthDepth depth) const
+    {
+      return (float)depth;
+    }
+
+    const Mat& registered_;
+    bool clean_;
+    ContainerDepth scale_;
+    Mat& depth_out_;
+    Mat& points3d_;
+    std::vector<float> x_cache_;
+    float inv_fy_, oy_;
+
+    FrontEndRowsInvoker& operator=(const FrontEndRowsInvoker&); // to quiet MSVC
+  };
+
+  template<>
+  float
+  FrontEndRowsInvoker<unsigned short, float>::toMeters(unsigned short depth) const
+  {
+    return depth == 0 ? std::numeric_limits<float>::quiet_NaN() : depth * (1 / 1000.f);
+  }
+
+  RgbdFrontEnd::RgbdFrontEnd(InputArray unregisteredCameraMatrix, InputArray registeredCameraMatrix,
+                             InputArray registeredDistCoeffs, InputArray Rt, const Size& outputImagePlaneSize,
+                             bool depthDilation, bool clean, int normals_method, int window_size)
+      :
+        unregistered_K_(unregisteredCameraMatrix.getMat()),
+        registered_K_(registeredCameraMatrix.getMat()),
+        registered_dist_coeffs_(registeredDistCoeffs.getMat()),
+        Rt_(Rt.getMat()),
+        size_(outputImagePlaneSize),
+        depth_dilation_(depthDilation),
+        clean_(clean)
+  {
+    CV_Assert(size_.height > 0 && size_.width > 0);
+    normals_ = makePtr<RgbdNormals>(size_.height, size_.width, CV_32F, Mat(registered_K_), window_size,
+                                    normals_method);
+  }
+
+  void
+  RgbdFrontEnd::operator()(InputArray depth_in, OutputArray registeredDepth_out, OutputArray points3d_out,
+                           OutputArray normals_out) const
+  {
+    Mat depth = depth_in.getMat();
+    CV_Assert(depth.type() == CV_16UC1 || depth.type() == CV_32FC1 || depth.type() == CV_64FC1);
+
+    registeredDepth_out.create(size_, depth.type());
+    Mat registered_depth = registeredDepth_out.getMat();
+
+    // When cleaning, the registration goes to the workspace and the cleaned depth to the output
+    Mat& registered = clean_ ? registered_ : registered_depth;
+    registerDepthBuffered(unregistered_K_, registered_K_, registered_dist_coeffs_, Rt_, depth, size_, registered,
+                          depth_dilation_, cloud_, transformed_cloud_);
+
+    Mat points3d;
+    if (points3d_out.needed())
+    {
+      points3d_out.create(size_, CV_32FC3);
+      points3d = points3d_out.getMat();
+    }
+    else
+    {
+      points3d_.create(size_, CV_32FC3);
+      points3d = points3d_;
+    }
+
+    Range rows(0, size_.height);
+    switch (depth.depth())
+    {
+      case CV_16U:
+        parallel_for_(rows, FrontEndRowsInvoker<unsigned short, float>(registered, clean_, 0.001f, registered_K_,
+                                                                        registered_depth, points3d));
+        break;
+      case CV_32F:
+        parallel_for_(rows, FrontEndRowsInvoker<float, float>(registered, clean_, 1, registered_K_,
+                                                               registered_depth, points3d));
+        break;
+      case CV_64F:
+        parallel_for_(rows, FrontEndRowsInvoker<double, double>(registered, clean_, 1, registered_K_,
+                                                                 registered_depth, points3d));
+        break;
+    }
+
+    if (normals_out.needed())
+      (*normals_)(points3d, normals_out);
+  }
+}
+}
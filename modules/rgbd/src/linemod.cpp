@@ -920,6 +920,9 @@ static void orUnaligned8u(const uchar * src, const int src_stride,
                    uchar * dst, const int dst_stride,
                    const int width, const int height)
 {
+#if CV_AVX2
+  volatile bool haveAVX2 = checkHardwareSupport(CV_CPU_AVX2);
+#endif
 #if CV_SSE2
   volatile bool haveSSE2 = checkHardwareSupport(CPU_SSE2);
 #if CV_SSE3
@@ -932,6 +935,18 @@ static void orUnaligned8u(const uchar * src, const int src_stride,
   {
     int c = 0;
 
+#if CV_AVX2
+    // 32 labels at a time, the rows of dst are not 32-byte aligned in general
+    if (haveAVX2)
+    {
+      for ( ; c < width - 31; c += 32)
+      {
+        __m256i val = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + c));
+        __m256i* dst_ptr = reinterpret_cast<__m256i*>(dst + c);
+        _mm256_storeu_si256(dst_ptr, _mm256_or_si256(_mm256_loadu_si256(dst_ptr), val));
+      }
+    }
+#endif
 #if CV_SSE2
     // Use aligned loads if possible
     if (haveSSE2 && src_aligned)
@@ -1196,6 +1211,9 @@ static void similarity(const std::vector<Mat>& linear_memories, const Template&
   dst = Mat::zeros(H, W, CV_8U);
   uchar* dst_ptr = dst.ptr<uchar>();
 
+#if CV_AVX2
+  volatile bool haveAVX2 = checkHardwareSupport(CV_CPU_AVX2);
+#endif
 #if CV_SSE2
   volatile bool haveSSE2 = checkHardwareSupport(CV_CPU_SSE2);
 #if CV_SSE3
@@ -1218,7 +1236,18 @@ static void similarity(const std::vector<Mat>& linear_memories, const Template&
 
     // Now we do an aligned/unaligned add of dst_ptr and lm_ptr with template_positions elements
     int j = 0;
-    // Process responses 16 at a time if vectorization possible
+    // Process responses 32 or 16 at a time if vectorization possible
+#if CV_AVX2
+    if (haveAVX2)
+    {
+      for ( ; j < template_positions - 31; j += 32)
+      {
+        __m256i responses = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lm_ptr + j));
+        __m256i* dst_ptr_avx = reinterpret_cast<__m256i*>(dst_ptr + j);
+        _mm256_storeu_si256(dst_ptr_avx, _mm256_add_epi8(_mm256_loadu_si256(dst_ptr_avx), responses));
+      }
+    }
+#endif
 #if CV_SSE2
 #if CV_SSE3
     if (haveSSE3)
@@ -1339,6 +1368,33 @@ static void addUnaligned8u16u(const uchar * src1, const uchar * src2, ushort * r
 {
   const uchar * end = src1 + length;
 
+#if CV_AVX2
+  if (checkHardwareSupport(CV_CPU_AVX2))
+  {
+    // Widen 16 responses of each source to 16 bits and add them
+    for ( ; end - src1 >= 16; src1 += 16, src2 += 16, res += 16)
+    {
+      __m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src1)));
+      __m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src2)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(res), _mm256_add_epi16(a, b));
+    }
+  }
+#endif
+#if CV_SSE2
+  if (checkHardwareSupport(CV_CPU_SSE2))
+  {
+    __m128i zero = _mm_setzero_si128();
+    for ( ; end - src1 >= 16; src1 += 16, src2 += 16, res += 16)
+    {
+      __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src1));
+      __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src2));
+      __m128i* res_ptr = reinterpret_cast<__m128i*>(res);
+      _mm_storeu_si128(res_ptr, _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)));
+      _mm_storeu_si128(res_ptr + 1, _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)));
+    }
+  }
+#endif
+
   while (src1 != end)
   {
     *res = *src1 + *src2;
@@ -1378,6 +1434,7 @@ static void addSimilarities(const std::vector<Mat>& similarities, Mat& dst)
 \****************************************************************************************/
 
 Detector::Detector()
+  : cache_linear_memories(false)
 {
 }
 
@@ -1385,18 +1442,101 @@ Detector::Detector(const std::vector< Ptr<Modality> >& _modalities,
                    const std::vector<int>& T_pyramid)
   : modalities(_modalities),
     pyramid_levels(static_cast<int>(T_pyramid.size())),
-    T_at_level(T_pyramid)
+    T_at_level(T_pyramid),
+    cache_linear_memories(false)
 {
 }
 
-void Detector::match(const std::vector<Mat>& sources, float threshold, std::vector<Match>& matches,
-                     const std::vector<String>& class_ids, OutputArrayOfArrays quantized_images,
-                     const std::vector<Mat>& masks) const
+class Detector::MatchTemplatesInvoker : public ParallelLoopBody
 {
-  matches.clear();
-  if (quantized_images.needed())
-    quantized_images.create(1, static_cast<int>(pyramid_levels * modalities.size()), CV_8U);
+public:
+  struct Job
+  {
+    const String* class_id;
+    int template_id;
+    const TemplatePyramid* tp;
+  };
+
+  static void addJobs(TemplatesMap::const_iterator it, std::vector<Job>& jobs)
+  {
+    for (size_t template_id = 0; template_id < it->second.size(); ++template_id)
+    {
+      Job job;
+      job.class_id = &it->first;
+      job.template_id = static_cast<int>(template_id);
+      job.tp = &it->second[template_id];
+      jobs.push_back(job);
+    }
+  }
+
+  MatchTemplatesInvoker(const Detector& _detector, const LinearMemoryPyramid& _lm_pyramid,
+                        const std::vector<Size>& _sizes, float _threshold,
+                        const std::vector<Job>& _jobs, std::vector< std::vector<Match> >& _candidates)
+    : detector(_detector), lm_pyramid(_lm_pyramid), sizes(_sizes), threshold(_threshold),
+      jobs(_jobs), candidates(_candidates) {}
+
+  void operator()(const Range& range) const
+  {
+    for (int i = range.start; i < range.end; ++i)
+    {
+      const Job& job = jobs[i];
+      detector.matchTemplate(lm_pyramid, sizes, threshold, candidates[i],
+                             *job.class_id, job.template_id, *job.tp);
+    }
+  }
 
+private:
+  const Detector& detector;
+  const LinearMemoryPyramid& lm_pyramid;
+  const std::vector<Size>& sizes;
+  float threshold;
+  const std::vector<Job>& jobs;
+  std::vector< std::vector<Match> >& candidates;
+
+  MatchTemplatesInvoker& operator=(const MatchTemplatesInvoker&); // to quiet MSVC
+};
+
+struct Detector::LinearMemoryCache
+{
+  Mutex mutex;
+  std::vector<Mat> sources;
+  std::vector<Mat> masks;
+  LinearMemoryPyramid lm_pyramid;
+  std::vector<Size> sizes;
+  std::vector<Mat> quantized_images;
+};
+
+static bool sameImage(const Mat& a, const Mat& b)
+{
+  if (a.size() != b.size() || a.type() != b.type())
+    return false;
+  size_t row_size = a.cols * a.elemSize();
+  for (int r = 0; r < a.rows; ++r)
+    if (memcmp(a.ptr(r), b.ptr(r), row_size) != 0)
+      return false;
+  return true;
+}
+
+static bool sameImages(const std::vector<Mat>& a, const std::vector<Mat>& b)
+{
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); ++i)
+    if (!sameImage(a[i], b[i]))
+      return false;
+  return true;
+}
+
+void Detector::setCacheLinearMemories(bool enabled)
+{
+  cache_linear_memories = enabled;
+  lm_cache = enabled ? makePtr<LinearMemoryCache>() : Ptr<LinearMemoryCache>();
+}
+
+void Detector::computeLinearMemories(const std::vector<Mat>& sources, const std::vector<Mat>& masks,
+                                     LinearMemoryPyramid& lm_pyramid, std::vector<Size>& sizes,
+                                     std::vector<Mat>& quantized_images) const
+{
   CV_Assert(sources.size() == modalities.size());
   // Initialize each modality with our sources
   std::vector< Ptr<QuantizedPyramid> > quantizers;
@@ -1411,11 +1551,11 @@ void Detector::match(const std::vector<Mat>& sources, float threshold, std::vect
     quantizers.push_back(modalities[i]->process(source, mask));
   }
   // pyramid level -> modality -> quantization
-  LinearMemoryPyramid lm_pyramid(pyramid_levels,
-                                 std::vector<LinearMemories>(modalities.size(), LinearMemories(8)));
+  lm_pyramid.assign(pyramid_levels, std::vector<LinearMemories>(modalities.size(), LinearMemories(8)));
 
   // For each pyramid level, precompute linear memories for each modality
-  std::vector<Size> sizes;
+  sizes.clear();
+  quantized_images.clear();
   for (int l = 0; l < pyramid_levels; ++l)
   {
     int T = T_at_level[l];
@@ -1427,10 +1567,12 @@ void Detector::match(const std::vector<Mat>& sources, float threshold, std::vect
         quantizers[i]->pyrDown();
     }
 
-    Mat quantized, spread_quantized;
+    Mat spread_quantized;
     std::vector<Mat> response_maps;
     for (int i = 0; i < (int)quantizers.size(); ++i)
     {
+      // a new image for each level and modality, they are all returned
+      Mat quantized;
       quantizers[i]->quantize(quantized);
       spread(quantized, spread_quantized, T);
       computeResponseMaps(spread_quantized, response_maps);
@@ -1439,19 +1581,69 @@ void Detector::match(const std::vector<Mat>& sources, float threshold, std::vect
       for (int j = 0; j < 8; ++j)
         linearize(response_maps[j], memories[j], T);
 
-      if (quantized_images.needed()) //use copyTo here to side step reference semantics.
-        quantized.copyTo(quantized_images.getMatRef(static_cast<int>(l*quantizers.size() + i)));
+      quantized_images.push_back(quantized);
     }
 
-    sizes.push_back(quantized.size());
+    sizes.push_back(quantized_images.empty() ? Size() : quantized_images.back().size());
   }
+}
 
+void Detector::match(const std::vector<Mat>& sources, float threshold, std::vector<Match>& matches,
+                     const std::vector<String>& class_ids, OutputArrayOfArrays quantized_images,
+                     const std::vector<Mat>& masks) const
+{
+  matches.clear();
+
+  LinearMemoryPyramid lm_pyramid;
+  std::vector<Size> sizes;
+  std::vector<Mat> quantized;
+  bool cached = false;
+  if (cache_linear_memories)
+  {
+    AutoLock lock(lm_cache->mutex);
+    if (sameImages(sources, lm_cache->sources) && sameImages(masks, lm_cache->masks))
+    {
+      // the linear memories are only read by the matching, sharing them is fine
+      lm_pyramid = lm_cache->lm_pyramid;
+      sizes = lm_cache->sizes;
+      quantized = lm_cache->quantized_images;
+      cached = true;
+    }
+  }
+
+  if (!cached)
+  {
+    computeLinearMemories(sources, masks, lm_pyramid, sizes, quantized);
+    if (cache_linear_memories)
+    {
+      AutoLock lock(lm_cache->mutex);
+      lm_cache->sources.resize(sources.size());
+      for (size_t i = 0; i < sources.size(); ++i)
+        sources[i].copyTo(lm_cache->sources[i]);
+      lm_cache->masks.resize(masks.size());
+      for (size_t i = 0; i < masks.size(); ++i)
+        masks[i].copyTo(lm_cache->masks[i]);
+      lm_cache->lm_pyramid = lm_pyramid;
+      lm_cache->sizes = sizes;
+      lm_cache->quantized_images = quantized;
+    }
+  }
+
+  if (quantized_images.needed())
+  {
+    quantized_images.create(1, static_cast<int>(pyramid_levels * modalities.size()), CV_8U);
+    for (int i = 0; i < (int)quantized.size(); ++i) //use copyTo here to side step reference semantics.
+      quantized[i].copyTo(quantized_images.getMatRef(i));
+  }
+
+  // Gather the template pyramids to match, in the order of the classes
+  std::vector<MatchTemplatesInvoker::Job> jobs;
   if (class_ids.empty())
   {
     // Match all templates
     TemplatesMap::const_iterator it = class_templates.begin(), itend = class_templates.end();
     for ( ; it != itend; ++it)
-      matchClass(lm_pyramid, sizes, threshold, matches, it->first, it->second);
+      MatchTemplatesInvoker::addJobs(it, jobs);
   }
   else
   {
@@ -1460,10 +1652,18 @@ void Detector::match(const std::vector<Mat>& sources, float threshold, std::vect
     {
       TemplatesMap::const_iterator it = class_templates.find(class_ids[i]);
       if (it != class_templates.end())
-        matchClass(lm_pyramid, sizes, threshold, matches, it->first, it->second);
+        MatchTemplatesInvoker::addJobs(it, jobs);
     }
   }
 
+  // The templates are independent of each other, each one gets its own candidates which
+  // are appended in order, so the matches don't depend on the number of threads
+  std::vector< std::vector<Match> > candidates(jobs.size());
+  parallel_for_(Range(0, (int)jobs.size()),
+                MatchTemplatesInvoker(*this, lm_pyramid, sizes, threshold, jobs, candidates));
+  for (size_t i = 0; i < candidates.size(); ++i)
+    matches.insert(matches.end(), candidates[i].begin(), candidates[i].end());
+
   // Sort matches by similarity, and prune any duplicates introduced by pyramid refinement
   std::sort(matches.begin(), matches.end());
   std::vector<Match>::iterator new_end = std::unique(matches.begin(), matches.end());
@@ -1485,124 +1685,132 @@ void Detector::matchClass(const LinearMemoryPyramid& lm_pyramid,
                           const std::vector<TemplatePyramid>& template_pyramids) const
 {
   // For each template...
+  std::vector<Match> candidates;
   for (size_t template_id = 0; template_id < template_pyramids.size(); ++template_id)
   {
-    const TemplatePyramid& tp = template_pyramids[template_id];
-
-    // First match over the whole image at the lowest pyramid level
-    /// @todo Factor this out into separate function
-    const std::vector<LinearMemories>& lowest_lm = lm_pyramid.back();
-
-    // Compute similarity maps for each modality at lowest pyramid level
-    std::vector<Mat> similarities(modalities.size());
-    int lowest_start = static_cast<int>(tp.size() - modalities.size());
-    int lowest_T = T_at_level.back();
-    int num_features = 0;
-    for (int i = 0; i < (int)modalities.size(); ++i)
-    {
-      const Template& templ = tp[lowest_start + i];
-      num_features += static_cast<int>(templ.features.size());
-      similarity(lowest_lm[i], templ, similarities[i], sizes.back(), lowest_T);
-    }
+    matchTemplate(lm_pyramid, sizes, threshold, candidates, class_id,
+                  static_cast<int>(template_id), template_pyramids[template_id]);
+    matches.insert(matches.end(), candidates.begin(), candidates.end());
+  }
+}
+
+void Detector::matchTemplate(const LinearMemoryPyramid& lm_pyramid,
+                             const std::vector<Size>& sizes,
+                             float threshold, std::vector<Match>& candidates,
+                             const String& class_id, int template_id,
+                             const TemplatePyramid& tp) const
+{
+  // First match over the whole image at the lowest pyramid level
+  /// @todo Factor this out into separate function
+  const std::vector<LinearMemories>& lowest_lm = lm_pyramid.back();
+
+  // Compute similarity maps for each modality at lowest pyramid level
+  std::vector<Mat> similarities(modalities.size());
+  int lowest_start = static_cast<int>(tp.size() - modalities.size());
+  int lowest_T = T_at_level.back();
+  int num_features = 0;
+  for (int i = 0; i < (int)modalities.size(); ++i)
+  {
+    const Template& templ = tp[lowest_start + i];
+    num_features += static_cast<int>(templ.features.size());
+    similarity(lowest_lm[i], templ, similarities[i], sizes.back(), lowest_T);
+  }
 
-    // Combine into overall similarity
-    /// @todo Support weighting the modalities
-    Mat total_similarity;
-    addSimilarities(similarities, total_similarity);
+  // Combine into overall similarity
+  /// @todo Support weighting the modalities
+  Mat total_similarity;
+  addSimilarities(similarities, total_similarity);
 
-    // Convert user-friendly percentage to raw similarity threshold. The percentage
-    // threshold scales from half the max response (what you would expect from applying
-    // the template to a completely random image) to the max response.
-    // NOTE: This assumes max per-feature response is 4, so we scale between [2*nf, 4*nf].
-    int raw_threshold = static_cast<int>(2*num_features + (threshold / 100.f) * (2*num_features) + 0.5f);
+  // Convert user-friendly percentage to raw similarity threshold. The percentage
+  // threshold scales from half the max response (what you would expect from applying
+  // the template to a completely random image) to the max response.
+  // NOTE: This assumes max per-feature response is 4, so we scale between [2*nf, 4*nf].
+  int raw_threshold = static_cast<int>(2*num_features + (threshold / 100.f) * (2*num_features) + 0.5f);
 
-    // Find initial matches
-    std::vector<Match> candidates;
-    for (int r = 0; r < total_similarity.rows; ++r)
+  // Find initial matches
+  candidates.clear();
+  for (int r = 0; r < total_similarity.rows; ++r)
+  {
+    ushort* row = total_similarity.ptr<ushort>(r);
+    for (int c = 0; c < total_similarity.cols; ++c)
     {
-      ushort* row = total_similarity.ptr<ushort>(r);
-      for (int c = 0; c < total_similarity.cols; ++c)
+      int raw_score = row[c];
+      if (raw_score > raw_threshold)
       {
-        int raw_score = row[c];
-        if (raw_score > raw_threshold)
-        {
-          int offset = lowest_T / 2 + (lowest_T % 2 - 1);
-          int x = c * lowest_T + offset;
-          int y = r * lowest_T + offset;
-          float score =(raw_score * 100.f) / (4 * num_features) + 0.5f;
-          candidates.push_back(Match(x, y, score, class_id, static_cast<int>(template_id)));
-        }
+        int offset = lowest_T / 2 + (lowest_T % 2 - 1);
+        int x = c * lowest_T + offset;
+        int y = r * lowest_T + offset;
+        float score =(raw_score * 100.f) / (4 * num_features) + 0.5f;
+        candidates.push_back(Match(x, y, score, class_id, template_id));
       }
     }
+  }
 
-    // Locally refine each match by marching up the pyramid
-    for (int l = pyramid_levels - 2; l >= 0; --l)
+  // Locally refine each match by marching up the pyramid
+  for (int l = pyramid_levels - 2; l >= 0; --l)
+  {
+    const std::vector<LinearMemories>& lms = lm_pyramid[l];
+    int T = T_at_level[l];
+    int start = static_cast<int>(l * modalities.size());
+    Size size = sizes[l];
+    int border = 8 * T;
+    int offset = T / 2 + (T % 2 - 1);
+    int max_x = size.width - tp[start].width - border;
+    int max_y = size.height - tp[start].height - border;
+
+    std::vector<Mat> similarities2(modalities.size());
+    Mat total_similarity2;
+    for (int m = 0; m < (int)candidates.size(); ++m)
     {
-      const std::vector<LinearMemories>& lms = lm_pyramid[l];
-      int T = T_at_level[l];
-      int start = static_cast<int>(l * modalities.size());
-      Size size = sizes[l];
-      int border = 8 * T;
-      int offset = T / 2 + (T % 2 - 1);
-      int max_x = size.width - tp[start].width - border;
-      int max_y = size.height - tp[start].height - border;
-
-      std::vector<Mat> similarities2(modalities.size());
-      Mat total_similarity2;
-      for (int m = 0; m < (int)candidates.size(); ++m)
-      {
-        Match& match2 = candidates[m];
-        int x = match2.x * 2 + 1; /// @todo Support other pyramid distance
-        int y = match2.y * 2 + 1;
+      Match& match2 = candidates[m];
+      int x = match2.x * 2 + 1; /// @todo Support other pyramid distance
+      int y = match2.y * 2 + 1;
 
-        // Require 8 (reduced) row/cols to the up/left
-        x = std::max(x, border);
-        y = std::max(y, border);
+      // Require 8 (reduced) row/cols to the up/left
+      x = std::max(x, border);
+      y = std::max(y, border);
 
-        // Require 8 (reduced) row/cols to the down/left, plus the template size
-        x = std::min(x, max_x);
-        y = std::min(y, max_y);
+      // Require 8 (reduced) row/cols to the down/left, plus the template size
+      x = std::min(x, max_x);
+      y = std::min(y, max_y);
 
-        // Compute local similarity maps for each modality
-        int numFeatures = 0;
-        for (int i = 0; i < (int)modalities.size(); ++i)
-        {
-          const Template& templ = tp[start + i];
-          numFeatures += static_cast<int>(templ.features.size());
-          similarityLocal(lms[i], templ, similarities2[i], size, T, Point(x, y));
-        }
-        addSimilarities(similarities2, total_similarity2);
+      // Compute local similarity maps for each modality
+      int numFeatures = 0;
+      for (int i = 0; i < (int)modalities.size(); ++i)
+      {
+        const Template& templ = tp[start + i];
+        numFeatures += static_cast<int>(templ.features.size());
+        similarityLocal(lms[i], templ, similarities2[i], size, T, Point(x, y));
+      }
+      addSimilarities(similarities2, total_similarity2);
 
-        // Find best local adjustment
-        int best_score = 0;
-        int best_r = -1, best_c = -1;
-        for (int r = 0; r < total_similarity2.rows; ++r)
+      // Find best local adjustment
+      int best_score = 0;
+      int best_r = -1, best_c = -1;
+      for (int r = 0; r < total_similarity2.rows; ++r)
+      {
+        ushort* row = total_similarity2.ptr<ushort>(r);
+        for (int c = 0; c < total_similarity2.cols; ++c)
         {
-          ushort* row = total_similarity2.ptr<ushort>(r);
-          for (int c = 0; c < total_similarity2.cols; ++c)
+          int score = row[c];
+          if (score > best_score)
           {
-            int score = row[c];
-            if (score > best_score)
-            {
-              best_score = score;
-              best_r = r;
-              best_c = c;
-            }
+            best_score = score;
+            best_r = r;
+            best_c = c;
           }
         }
-        // Update current match
-        match2.x = (x / T - 8 + best_c) * T + offset;
-        match2.y = (y / T - 8 + best_r) * T + offset;
-        match2.similarity = (best_score * 100.f) / (4 * numFeatures);
       }
-
-      // Filter out any matches that drop below the similarity threshold
-      std::vector<Match>::iterator new_end = std::remove_if(candidates.begin(), candidates.end(),
-                                                            MatchPredicate(threshold));
-      candidates.erase(new_end, candidates.end());
+      // Update current match
+      match2.x = (x / T - 8 + best_c) * T + offset;
+      match2.y = (y / T - 8 + best_r) * T + offset;
+      match2.similarity = (best_score * 100.f) / (4 * numFeatures);
     }
 
-    matches.insert(matches.end(), candidates.begin(), candidates.end());
+    // Filter out any matches that drop below the similarity threshold
+    std::vector<Match>::iterator new_end = std::remove_if(candidates.begin(), candidates.end(),
+                                                          MatchPredicate(threshold));
+    candidates.erase(new_end, candidates.end());
   }
 }
 
@@ -1694,6 +1902,8 @@ void Detector::read(const FileNode& fn)
   fn["T"] >> T_at_level;
 
   modalities.clear();
+  if (cache_linear_memories)
+    lm_cache = makePtr<LinearMemoryCache>();
   FileNode modalities_fn = fn["modalities"];
   FileNodeIterator it = modalities_fn.begin(), it_end = modalities_fn.end();
   for ( ; it != it_end; ++it)
@@ -1822,6 +2032,185 @@ void Detector::writeClasses(const String& format) const
   }
 }
 
+static const char TEMPLATES_BINARY_MAGIC[8] = { 'C', 'V', 'L', 'M', 'T', 'P', 'L', 'B' };
+static const int TEMPLATES_BINARY_VERSION = 1;
+static const unsigned int TEMPLATES_BINARY_BYTE_ORDER = 0x01020304;
+
+// closes the file on every exit, including errors
+struct TemplatesFile
+{
+  TemplatesFile(const String& filename, const char* mode) : file(fopen(filename.c_str(), mode)) {}
+  ~TemplatesFile() { if (file) fclose(file); }
+  FILE* file;
+};
+
+static void writeRaw(FILE* file, const void* data, size_t size)
+{
+  if (size > 0 && fwrite(data, 1, size, file) != size)
+    CV_Error(Error::StsError, "Can't write to the templates file!");
+}
+
+static void readRaw(FILE* file, void* data, size_t size)
+{
+  if (size > 0 && fread(data, 1, size, file) != size)
+    CV_Error(Error::StsError, "The templates file is truncated!");
+}
+
+static void writeInts(FILE* file, const std::vector<int>& values)
+{
+  int size = static_cast<int>(values.size());
+  writeRaw(file, &size, sizeof(size));
+  if (size > 0)
+    writeRaw(file, &values[0], values.size() * sizeof(int));
+}
+
+static void readInts(FILE* file, std::vector<int>& values)
+{
+  int size = 0;
+  readRaw(file, &size, sizeof(size));
+  CV_Assert(size >= 0);
+  values.resize(size);
+  if (size > 0)
+    readRaw(file, &values[0], values.size() * sizeof(int));
+}
+
+static void writeString(FILE* file, const String& str)
+{
+  int size = static_cast<int>(str.size());
+  writeRaw(file, &size, sizeof(size));
+  writeRaw(file, str.c_str(), str.size());
+}
+
+static String readString(FILE* file)
+{
+  int size = 0;
+  readRaw(file, &size, sizeof(size));
+  CV_Assert(size >= 0);
+  std::vector<char> buf(size + 1, 0);
+  readRaw(file, &buf[0], size);
+  return String(&buf[0], size);
+}
+
+void Detector::writeTemplatesBinary(const String& filename) const
+{
+  TemplatesFile f(filename, "wb");
+  if (!f.file)
+    CV_Error(Error::StsError, "File can't be opened for writing!");
+
+  writeRaw(f.file, TEMPLATES_BINARY_MAGIC, sizeof(TEMPLATES_BINARY_MAGIC));
+  std::vector<int> header(2);
+  header[0] = TEMPLATES_BINARY_VERSION;
+  header[1] = static_cast<int>(TEMPLATES_BINARY_BYTE_ORDER);
+  writeInts(f.file, header);
+
+  // Detector settings the templates depend on
+  std::vector<int> settings(3);
+  settings[0] = static_cast<int>(modalities.size());
+  settings[1] = pyramid_levels;
+  settings[2] = static_cast<int>(class_templates.size());
+  writeInts(f.file, settings);
+  for (size_t i = 0; i < modalities.size(); ++i)
+    writeString(f.file, modalities[i]->name());
+
+  // Every template is a flat array of ints: width, height, pyramid_level, then (x, y, label)
+  // for each feature
+  std::vector<int> values;
+  TemplatesMap::const_iterator it = class_templates.begin(), it_end = class_templates.end();
+  for ( ; it != it_end; ++it)
+  {
+    const std::vector<TemplatePyramid>& tps = it->second;
+    writeString(f.file, it->first);
+    values.assign(1, static_cast<int>(tps.size()));
+    for (size_t i = 0; i < tps.size(); ++i)
+      values.push_back(static_cast<int>(tps[i].size()));
+    writeInts(f.file, values);
+
+    for (size_t i = 0; i < tps.size(); ++i)
+    {
+      for (size_t j = 0; j < tps[i].size(); ++j)
+      {
+        const Template& templ = tps[i][j];
+        values.resize(3 + 3 * templ.features.size());
+        values[0] = templ.width;
+        values[1] = templ.height;
+        values[2] = templ.pyramid_level;
+        for (size_t k = 0; k < templ.features.size(); ++k)
+        {
+          const Feature& feat = templ.features[k];
+          values[3 + 3*k] = feat.x;
+          values[4 + 3*k] = feat.y;
+          values[5 + 3*k] = feat.label;
+        }
+        writeInts(f.file, values);
+      }
+    }
+  }
+}
+
+void Detector::readTemplatesBinary(const String& filename)
+{
+  TemplatesFile f(filename, "rb");
+  if (!f.file)
+    CV_Error(Error::StsError, "File can't be opened for reading!");
+
+  char magic[sizeof(TEMPLATES_BINARY_MAGIC)];
+  readRaw(f.file, magic, sizeof(magic));
+  if (memcmp(magic, TEMPLATES_BINARY_MAGIC, sizeof(magic)) != 0)
+    CV_Error(Error::StsError, "The file is not a binary LINEMOD templates file!");
+  std::vector<int> header;
+  readInts(f.file, header);
+  CV_Assert(header.size() == 2);
+  if (header[0] != TEMPLATES_BINARY_VERSION)
+    CV_Error(Error::StsError, cv::format("Unsupported version %d of the binary templates format.", header[0]));
+  if (static_cast<unsigned int>(header[1]) != TEMPLATES_BINARY_BYTE_ORDER)
+    CV_Error(Error::StsError, "The templates were written on a machine with a different byte order.");
+
+  // Verify compatible with Detector settings
+  std::vector<int> settings;
+  readInts(f.file, settings);
+  CV_Assert(settings.size() == 3);
+  CV_Assert(settings[0] == (int)modalities.size() && settings[1] == pyramid_levels);
+  for (size_t i = 0; i < modalities.size(); ++i)
+    CV_Assert(modalities[i]->name() == readString(f.file));
+
+  std::vector<int> values;
+  for (int c = 0; c < settings[2]; ++c)
+  {
+    String class_id = readString(f.file);
+    // Detector should not already have this class
+    CV_Assert(class_templates.find(class_id) == class_templates.end());
+
+    TemplatesMap::value_type v(class_id, std::vector<TemplatePyramid>());
+    std::vector<TemplatePyramid>& tps = v.second;
+    readInts(f.file, values);
+    CV_Assert(!values.empty() && (int)values.size() == values[0] + 1);
+    tps.resize(values[0]);
+    for (size_t i = 0; i < tps.size(); ++i)
+    {
+      CV_Assert(values[i + 1] >= 0);
+      tps[i].resize(values[i + 1]);
+    }
+
+    for (size_t i = 0; i < tps.size(); ++i)
+    {
+      for (size_t j = 0; j < tps[i].size(); ++j)
+      {
+        Template& templ = tps[i][j];
+        readInts(f.file, values);
+        CV_Assert(values.size() >= 3 && values.size() % 3 == 0);
+        templ.width = values[0];
+        templ.height = values[1];
+        templ.pyramid_level = values[2];
+        templ.features.resize(values.size() / 3 - 1);
+        for (size_t k = 0; k < templ.features.size(); ++k)
+          templ.features[k] = Feature(values[3 + 3*k], values[4 + 3*k], values[5 + 3*k]);
+      }
+    }
+
+    class_templates.insert(v);
+  }
+}
+
 static const int T_DEFAULTS[] = {5, 8};
 
 Ptr<Detector> getDefaultLINE()
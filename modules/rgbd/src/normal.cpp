@@ -34,6 +34,7 @@
  */
 
 #include "precomp.hpp"
+#include <opencv2/core/hal/intrin.hpp>
 
 namespace cv
 {
@@ -161,6 +162,66 @@ namespace rgbd
     }
   }
 
+  /** Makes the normals of a range of rows point towards the camera and normalizes them
+   */
+  template<typename T>
+  class SignNormalsInvoker : public ParallelLoopBody
+  {
+  public:
+    typedef Vec<T, 3> Vec3T;
+
+    explicit SignNormalsInvoker(Mat &normals)
+        :
+          normals_(normals)
+    {
+    }
+
+    virtual void
+    operator()(const Range &range) const
+    {
+      for (int y = range.start; y < range.end; ++y)
+      {
+        Vec3T *normal = normals_.ptr<Vec3T>(y), *normal_end = normal + normals_.cols;
+        for (; normal != normal_end; ++normal)
+          signNormal((*normal)[0], (*normal)[1], (*normal)[2], *normal);
+      }
+    }
+
+  private:
+    Mat &normals_;
+
+    SignNormalsInvoker& operator=(const SignNormalsInvoker&); // to quiet MSVC
+  };
+
+  /** Computes a row of the B = V / r of FALS, B is 0 where r is NaN
+   * @return the number of elements computed with SIMD instructions, the caller does the others
+   */
+  template<typename T>
+  inline int
+  computeFALSBRowSIMD(const T*, const T*, T*, int)
+  {
+    return 0;
+  }
+
+#if CV_SIMD128
+  template<>
+  inline int
+  computeFALSBRowSIMD<float>(const float *r, const float *V, float *B, int cols)
+  {
+    v_float32x4 one = v_setall_f32(1.f);
+    int x = 0;
+    for (; x <= cols - 4; x += 4)
+    {
+      v_float32x4 vr = v_load(r + x), v0, v1, v2;
+      // NaN != NaN, the inverse of the invalid radii is set to 0
+      v_float32x4 inv = (one / vr) & (vr == vr);
+      v_load_deinterleave(V + 3 * x, v0, v1, v2);
+      v_store_interleave(B + 3 * x, v0 * inv, v1 * inv, v2 * inv);
+    }
+    return x;
+  }
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
   class RgbdNormalsImpl
@@ -277,43 +338,106 @@ namespace rgbd
     {
       // Compute B
       Mat_<Vec3T> B(rows_, cols_);
-
-      const T* row_r = r.ptr < T > (0), *row_r_end = row_r + rows_ * cols_;
-      const Vec3T *row_V = V_[0];
-      Vec3T *row_B = B[0];
-      for (; row_r != row_r_end; ++row_r, ++row_B, ++row_V)
-      {
-        if (cvIsNaN(*row_r))
-          *row_B = Vec3T();
-        else
-          *row_B = (*row_V) / (*row_r);
-      }
+      parallel_for_(Range(0, rows_), ComputeBInvoker(r, V_, B));
 
       // Apply a box filter to B
       boxFilter(B, B, B.depth(), Size(window_size_, window_size_), Point(-1, -1), false);
 
       // compute the Minv*B products
-      row_r = r.ptr < T > (0);
-      const Vec3T * B_vec = B[0];
-      const Mat33T * M_inv = reinterpret_cast<const Mat33T *>(M_inv_.ptr(0));
-      Vec3T *normal = normals.ptr<Vec3T>(0);
-      for (; row_r != row_r_end; ++row_r, ++B_vec, ++normal, ++M_inv)
-        if (cvIsNaN(*row_r))
+      parallel_for_(Range(0, rows_), ComputeNormalsInvoker(r, B, M_inv_, normals));
+    }
+
+  private:
+    /** Computes B = V / r for a range of rows
+     */
+    class ComputeBInvoker : public ParallelLoopBody
+    {
+    public:
+      ComputeBInvoker(const Mat &r, const Mat_<Vec3T> &V, Mat_<Vec3T> &B)
+          :
+            r_(r),
+            V_(V),
+            B_(B)
+      {
+      }
+
+      virtual void
+      operator()(const Range &range) const
+      {
+        for (int y = range.start; y < range.end; ++y)
         {
-          (*normal)[0] = *row_r;
-          (*normal)[1] = *row_r;
-          (*normal)[2] = *row_r;
+          const T* row_r = r_.ptr<T>(y);
+          const Vec3T *row_V = V_[y];
+          Vec3T *row_B = B_[y];
+          int x = computeFALSBRowSIMD<T>(row_r, row_V->val, row_B->val, r_.cols);
+          for (; x < r_.cols; ++x)
+          {
+            if (cvIsNaN(row_r[x]))
+              row_B[x] = Vec3T();
+            else
+              row_B[x] = row_V[x] / row_r[x];
+          }
         }
-        else
+      }
+
+    private:
+      const Mat &r_;
+      const Mat_<Vec3T> &V_;
+      Mat_<Vec3T> &B_;
+
+      ComputeBInvoker& operator=(const ComputeBInvoker&); // to quiet MSVC
+    };
+
+    /** Computes the normals Minv*B for a range of rows
+     */
+    class ComputeNormalsInvoker : public ParallelLoopBody
+    {
+    public:
+      ComputeNormalsInvoker(const Mat &r, const Mat_<Vec3T> &B, const Mat_<Vec9T> &M_inv, Mat &normals)
+          :
+            r_(r),
+            B_(B),
+            M_inv_(M_inv),
+            normals_(normals)
+      {
+      }
+
+      virtual void
+      operator()(const Range &range) const
+      {
+        for (int y = range.start; y < range.end; ++y)
         {
-            Mat33T Mr = *M_inv;
-            Vec3T Br = *B_vec;
-            Vec3T MBr(Mr(0, 0) * Br[0] + Mr(0, 1)*Br[1] + Mr(0, 2)*Br[2],
-                      Mr(1, 0) * Br[0] + Mr(1, 1)*Br[1] + Mr(1, 2)*Br[2],
-                      Mr(2, 0) * Br[0] + Mr(2, 1)*Br[1] + Mr(2, 2)*Br[2]);
-           signNormal(MBr, *normal);
+          const T* row_r = r_.ptr<T>(y), *row_r_end = row_r + r_.cols;
+          const Vec3T * B_vec = B_[y];
+          const Mat33T * M_inv = reinterpret_cast<const Mat33T *>(M_inv_[y]);
+          Vec3T *normal = normals_.ptr<Vec3T>(y);
+          for (; row_r != row_r_end; ++row_r, ++B_vec, ++normal, ++M_inv)
+            if (cvIsNaN(*row_r))
+            {
+              (*normal)[0] = *row_r;
+              (*normal)[1] = *row_r;
+              (*normal)[2] = *row_r;
+            }
+            else
+            {
+              const Mat33T &Mr = *M_inv;
+              const Vec3T &Br = *B_vec;
+              Vec3T MBr(Mr(0, 0) * Br[0] + Mr(0, 1)*Br[1] + Mr(0, 2)*Br[2],
+                        Mr(1, 0) * Br[0] + Mr(1, 1)*Br[1] + Mr(1, 2)*Br[2],
+                        Mr(2, 0) * Br[0] + Mr(2, 1)*Br[1] + Mr(2, 2)*Br[2]);
+              signNormal(MBr, *normal);
+            }
         }
-    }
+      }
+
+    private:
+      const Mat &r_;
+      const Mat_<Vec3T> &B_;
+      const Mat_<Vec9T> &M_inv_;
+      Mat &normals_;
+
+      ComputeNormalsInvoker& operator=(const ComputeNormalsInvoker&); // to quiet MSVC
+    };
 
   private:
     Mat_<Vec3T> V_;
@@ -403,26 +527,6 @@ multiply_by_K_inv(const Matx<T, 3, 3> & K_inv, U a, U b, U c, Vec<T, 3> &res)
     Mat
     computeImpl(const Mat_<DepthDepth> &depth, Mat & normals) const
     {
-      const int r = 5; // used to be 7
-      const int sample_step = r;
-      const int square_size = ((2 * r / sample_step) + 1);
-      long offsets[square_size * square_size];
-      long offsets_x[square_size * square_size];
-      long offsets_y[square_size * square_size];
-      long offsets_x_x[square_size * square_size];
-      long offsets_x_y[square_size * square_size];
-      long offsets_y_y[square_size * square_size];
-      for (int j = -r, index = 0; j <= r; j += sample_step)
-        for (int i = -r; i <= r; i += sample_step, ++index)
-        {
-          offsets_x[index] = i;
-          offsets_y[index] = j;
-          offsets_x_x[index] = i*i;
-          offsets_x_y[index] = i*j;
-          offsets_y_y[index] = j*j;
-          offsets[index] = j * cols_ + i;
-        }
-
       // Define K_inv by hand, just for higher accuracy
       Mat33T K_inv = Matx<T, 3, 3>::eye(), K;
       K_.copyTo(K);
@@ -432,62 +536,115 @@ multiply_by_K_inv(const Matx<T, 3, 3> & K_inv, U a, U b, U c, Vec<T, 3> &res)
       K_inv(1, 1) = 1 / K(1, 1);
       K_inv(1, 2) = -K(1, 2) / K(1, 1);
 
-      Vec3T X1_minus_X, X2_minus_X;
-
-      ContainerDepth difference_threshold = 50;
       normals.setTo(std::numeric_limits<DepthDepth>::quiet_NaN());
-      for (int y = r; y < rows_ - r - 1; ++y)
+      const int r = ComputeInvoker<DepthDepth, ContainerDepth>::r;
+      if (rows_ - 2 * r - 1 > 0)
+        parallel_for_(Range(r, rows_ - r - 1),
+                      ComputeInvoker<DepthDepth, ContainerDepth>(depth, K_inv, cols_, normals));
+
+      return normals;
+    }
+
+    /** Computes the normals of a range of rows
+     */
+    template<typename DepthDepth, typename ContainerDepth>
+    class ComputeInvoker : public ParallelLoopBody
+    {
+    public:
+      enum { r = 5 }; // used to be 7
+      enum { sample_step = r };
+      enum { square_size = ((2 * r / sample_step) + 1) };
+
+      ComputeInvoker(const Mat_<DepthDepth> &depth, const Mat33T &K_inv, int cols, Mat &normals)
+          :
+            depth_(depth),
+            K_inv_(K_inv),
+            cols_(cols),
+            normals_(normals)
+      {
+        for (int j = -r, index = 0; j <= r; j += sample_step)
+          for (int i = -r; i <= r; i += sample_step, ++index)
+          {
+            offsets_x_[index] = i;
+            offsets_y_[index] = j;
+            offsets_x_x_[index] = i*i;
+            offsets_x_y_[index] = i*j;
+            offsets_y_y_[index] = j*j;
+            offsets_[index] = j * cols_ + i;
+          }
+      }
+
+      virtual void
+      operator()(const Range &range) const
       {
-        const DepthDepth * p_line = reinterpret_cast<const DepthDepth*>(depth.ptr(y, r));
-        Vec3T *normal = normals.ptr<Vec3T>(y, r);
+        Vec3T X1_minus_X, X2_minus_X;
 
-        for (int x = r; x < cols_ - r - 1; ++x)
+        ContainerDepth difference_threshold = 50;
+        for (int y = range.start; y < range.end; ++y)
         {
-          DepthDepth d = p_line[0];
-
-          // accum
-          long A[4];
-          A[0] = A[1] = A[2] = A[3] = 0;
-          ContainerDepth b[2];
-          b[0] = b[1] = 0;
-          for (unsigned int i = 0; i < square_size * square_size; ++i) {
-            // We need to cast to ContainerDepth in case we have unsigned DepthDepth
-            ContainerDepth delta = ContainerDepth(p_line[offsets[i]]) - ContainerDepth(d);
-            if (std::abs(delta) > difference_threshold)
-               continue;
-
-             A[0] += offsets_x_x[i];
-             A[1] += offsets_x_y[i];
-             A[3] += offsets_y_y[i];
-             b[0] += offsets_x[i] * delta;
-             b[1] += offsets_y[i] * delta;
-          }
+          const DepthDepth * p_line = reinterpret_cast<const DepthDepth*>(depth_.ptr(y, r));
+          Vec3T *normal = normals_.ptr<Vec3T>(y, r);
 
-          // solve for the optimal gradient D of equation (8)
-          long det = A[0] * A[3] - A[1] * A[1];
-          // We should divide the following two by det, but instead, we multiply
-          // X1_minus_X and X2_minus_X by det (which does not matter as we normalize the normals)
-          // Therefore, no division is done: this is only for speedup
-          ContainerDepth dx = (A[3] * b[0] - A[1] * b[1]);
-          ContainerDepth dy = (-A[1] * b[0] + A[0] * b[1]);
-
-          // Compute the dot product
-          //Vec3T X = K_inv * Vec3T(x, y, 1) * depth(y, x);
-          //Vec3T X1 = K_inv * Vec3T(x + 1, y, 1) * (depth(y, x) + dx);
-          //Vec3T X2 = K_inv * Vec3T(x, y + 1, 1) * (depth(y, x) + dy);
-          //Vec3T nor = (X1 - X).cross(X2 - X);
-          multiply_by_K_inv(K_inv, d * det + (x + 1) * dx, y * dx, dx, X1_minus_X);
-          multiply_by_K_inv(K_inv, x * dy, d * det + (y + 1) * dy, dy, X2_minus_X);
-          Vec3T nor = X1_minus_X.cross(X2_minus_X);
-          signNormal(nor, *normal);
-
-          ++p_line;
-          ++normal;
+          for (int x = r; x < cols_ - r - 1; ++x)
+          {
+            DepthDepth d = p_line[0];
+
+            // accum
+            long A[4];
+            A[0] = A[1] = A[2] = A[3] = 0;
+            ContainerDepth b[2];
+            b[0] = b[1] = 0;
+            for (unsigned int i = 0; i < square_size * square_size; ++i) {
+              // We need to cast to ContainerDepth in case we have unsigned DepthDepth
+              ContainerDepth delta = ContainerDepth(p_line[offsets_[i]]) - ContainerDepth(d);
+              if (std::abs(delta) > difference_threshold)
+                 continue;
+
+               A[0] += offsets_x_x_[i];
+               A[1] += offsets_x_y_[i];
+               A[3] += offsets_y_y_[i];
+               b[0] += offsets_x_[i] * delta;
+               b[1] += offsets_y_[i] * delta;
+            }
+
+            // solve for the optimal gradient D of equation (8)
+            long det = A[0] * A[3] - A[1] * A[1];
+            // We should divide the following two by det, but instead, we multiply
+            // X1_minus_X and X2_minus_X by det (which does not matter as we normalize the normals)
+            // Therefore, no division is done: this is only for speedup
+            ContainerDepth dx = (A[3] * b[0] - A[1] * b[1]);
+            ContainerDepth dy = (-A[1] * b[0] + A[0] * b[1]);
+
+            // Compute the dot product
+            //Vec3T X = K_inv * Vec3T(x, y, 1) * depth(y, x);
+            //Vec3T X1 = K_inv * Vec3T(x + 1, y, 1) * (depth(y, x) + dx);
+            //Vec3T X2 = K_inv * Vec3T(x, y + 1, 1) * (depth(y, x) + dy);
+            //Vec3T nor = (X1 - X).cross(X2 - X);
+            multiply_by_K_inv(K_inv_, d * det + (x + 1) * dx, y * dx, dx, X1_minus_X);
+            multiply_by_K_inv(K_inv_, x * dy, d * det + (y + 1) * dy, dy, X2_minus_X);
+            Vec3T nor = X1_minus_X.cross(X2_minus_X);
+            signNormal(nor, *normal);
+
+            ++p_line;
+            ++normal;
+          }
         }
       }
 
-      return normals;
-    }
+    private:
+      const Mat_<DepthDepth> &depth_;
+      Mat33T K_inv_;
+      int cols_;
+      Mat &normals_;
+      long offsets_[square_size * square_size];
+      long offsets_x_[square_size * square_size];
+      long offsets_y_[square_size * square_size];
+      long offsets_x_x_[square_size * square_size];
+      long offsets_x_y_[square_size * square_size];
+      long offsets_y_y_[square_size * square_size];
+
+      ComputeInvoker& operator=(const ComputeInvoker&); // to quiet MSVC
+    };
   };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -622,38 +779,68 @@ multiply_by_K_inv(const Matx<T, 3, 3> & K_inv, U a, U b, U c, Vec<T, 3> &res)
 
       // Fill the result matrix
       Mat_<Vec3T> normals(rows_, cols_);
+      parallel_for_(Range(0, rows_), ComputeInvoker(r, r_theta, r_phi, R_hat_, normals));
 
-      const T* r_theta_ptr = r_theta[0], *r_theta_ptr_end = r_theta_ptr + rows_ * cols_;
-      const T* r_phi_ptr = r_phi[0];
-      const Mat33T * R = reinterpret_cast<const Mat33T *>(R_hat_[0]);
-      const T* r_ptr = r[0];
-      Vec3T * normal = normals[0];
-      for (; r_theta_ptr != r_theta_ptr_end; ++r_theta_ptr, ++r_phi_ptr, ++R, ++r_ptr, ++normal)
+      remap(normals, normals_out, invxy_, invfxy_, INTER_LINEAR);
+      parallel_for_(Range(0, rows_), SignNormalsInvoker<T>(normals_out));
+    }
+
+  private:
+    /** Computes the normals in the SRI space of a range of rows
+     */
+    class ComputeInvoker : public ParallelLoopBody
+    {
+    public:
+      ComputeInvoker(const Mat_<T> &r, const Mat_<T> &r_theta, const Mat_<T> &r_phi, const Mat_<Vec9T> &R_hat,
+                     Mat_<Vec3T> &normals)
+          :
+            r_(r),
+            r_theta_(r_theta),
+            r_phi_(r_phi),
+            R_hat_(R_hat),
+            normals_(normals)
       {
-        if (cvIsNaN(*r_ptr))
-        {
-          (*normal)[0] = *r_ptr;
-          (*normal)[1] = *r_ptr;
-          (*normal)[2] = *r_ptr;
-        }
-        else
+      }
+
+      virtual void
+      operator()(const Range &range) const
+      {
+        for (int y = range.start; y < range.end; ++y)
         {
-          T r_theta_over_r = (*r_theta_ptr) / (*r_ptr);
-          T r_phi_over_r = (*r_phi_ptr) / (*r_ptr);
-          // R(1,1) is 0
-          signNormal((*R)(0, 0) + (*R)(0, 1) * r_theta_over_r + (*R)(0, 2) * r_phi_over_r,
-                     (*R)(1, 0) + (*R)(1, 2) * r_phi_over_r,
-                     (*R)(2, 0) + (*R)(2, 1) * r_theta_over_r + (*R)(2, 2) * r_phi_over_r, *normal);
+          const T* r_theta_ptr = r_theta_[y], *r_theta_ptr_end = r_theta_ptr + r_theta_.cols;
+          const T* r_phi_ptr = r_phi_[y];
+          const Mat33T * R = reinterpret_cast<const Mat33T *>(R_hat_[y]);
+          const T* r_ptr = r_[y];
+          Vec3T * normal = normals_[y];
+          for (; r_theta_ptr != r_theta_ptr_end; ++r_theta_ptr, ++r_phi_ptr, ++R, ++r_ptr, ++normal)
+          {
+            if (cvIsNaN(*r_ptr))
+            {
+              (*normal)[0] = *r_ptr;
+              (*normal)[1] = *r_ptr;
+              (*normal)[2] = *r_ptr;
+            }
+            else
+            {
+              T r_theta_over_r = (*r_theta_ptr) / (*r_ptr);
+              T r_phi_over_r = (*r_phi_ptr) / (*r_ptr);
+              // R(1,1) is 0
+              signNormal((*R)(0, 0) + (*R)(0, 1) * r_theta_over_r + (*R)(0, 2) * r_phi_over_r,
+                         (*R)(1, 0) + (*R)(1, 2) * r_phi_over_r,
+                         (*R)(2, 0) + (*R)(2, 1) * r_theta_over_r + (*R)(2, 2) * r_phi_over_r, *normal);
+            }
+          }
         }
       }
 
-      remap(normals, normals_out, invxy_, invfxy_, INTER_LINEAR);
-      normal = normals_out.ptr<Vec3T>(0);
-      Vec3T * normal_end = normal + rows_ * cols_;
-      for (; normal != normal_end; ++normal)
-        signNormal((*normal)[0], (*normal)[1], (*normal)[2], *normal);
-    }
-  private:
+    private:
+      const Mat_<T> &r_, &r_theta_, &r_phi_;
+      const Mat_<Vec9T> &R_hat_;
+      Mat_<Vec3T> &normals_;
+
+      ComputeInvoker& operator=(const ComputeInvoker&); // to quiet MSVC
+    };
+
     /** Stores R */
     Mat_<Vec9T> R_hat_;
     float phi_step_, theta_step_;
@@ -631,78 +631,292 @@ void calcICPEquationCoeffsTranslation(double* C, const Point3f& /*p0*/, const Ve
 typedef
 void (*CalcICPEquationCoeffsPtr)(double*, const Point3f&, const Vec3f&);
 
+// The correspondences are reduced by blocks of fixed size: every block has its own accumulators and
+// the blocks are summed in order, so the result does not depend on the number of threads.
+const int correspsBlockSize = 1024;
+
+static inline
+int correspsBlockCount(int correspsCount)
+{
+    return (correspsCount + correspsBlockSize - 1) / correspsBlockSize;
+}
+
+// adds the equation A * x = diff of weight w to the upper triangle of AtA and to AtB, stored in acc
+// as the transformDim rows of [AtA | AtB]
+static inline
+void accumulateLsmEquation(double* acc, const double* A_ptr, double w_diff, int transformDim)
+{
+    for(int y = 0; y < transformDim; y++)
+    {
+        double* acc_row = acc + y * (transformDim + 1);
+        for(int x = y; x < transformDim; x++)
+            acc_row[x] += A_ptr[y] * A_ptr[x];
+
+        acc_row[transformDim] += A_ptr[y] * w_diff;
+    }
+}
+
+// sums the accumulators of the blocks into AtA and AtB
+static
+void reduceLsmBlocks(const std::vector<double>& blocksAcc, int transformDim, Mat& AtA, Mat& AtB)
+{
+    const int accSize = transformDim * (transformDim + 1);
+    AtA = Mat(transformDim, transformDim, CV_64FC1, Scalar(0));
+    AtB = Mat(transformDim, 1, CV_64FC1, Scalar(0));
+    for(size_t block = 0; block < blocksAcc.size() / accSize; block++)
+    {
+        const double* acc = &blocksAcc[block * accSize];
+        for(int y = 0; y < transformDim; y++)
+        {
+            const double* acc_row = acc + y * (transformDim + 1);
+            double* AtA_ptr = AtA.ptr<double>(y);
+            for(int x = y; x < transformDim; x++)
+                AtA_ptr[x] += acc_row[x];
+            AtB.at<double>(y) += acc_row[transformDim];
+        }
+    }
+
+    for(int y = 0; y < transformDim; y++)
+        for(int x = y+1; x < transformDim; x++)
+            AtA.at<double>(x,y) = AtA.at<double>(y,x);
+}
+
+// sums the squared differences of the blocks
+static
+double reduceSigmaBlocks(const std::vector<double>& blocksSigma, int correspsCount)
+{
+    double sigma = 0;
+    for(size_t block = 0; block < blocksSigma.size(); block++)
+        sigma += blocksSigma[block];
+    return std::sqrt(sigma/correspsCount);
+}
+
+class RgbdDiffsInvoker : public ParallelLoopBody
+{
+public:
+    RgbdDiffsInvoker(const Mat& _image0, const Mat& _image1, const Mat& _corresps,
+                     float* _diffs_ptr, std::vector<double>& _blocksSigma)
+        : image0(_image0), image1(_image1), corresps(_corresps),
+          diffs_ptr(_diffs_ptr), blocksSigma(_blocksSigma) {}
+
+    void operator()(const Range& range) const
+    {
+        const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
+        for(int block = range.start; block < range.end; block++)
+        {
+            int end = std::min(corresps.rows, (block + 1) * correspsBlockSize);
+            double sigma = 0;
+            for(int correspIndex = block * correspsBlockSize; correspIndex < end; correspIndex++)
+            {
+                const Vec4i& c = corresps_ptr[correspIndex];
+                int u0 = c[0], v0 = c[1];
+                int u1 = c[2], v1 = c[3];
+
+                diffs_ptr[correspIndex] = static_cast<float>(static_cast<int>(image0.at<uchar>(v0,u0)) -
+                                                             static_cast<int>(image1.at<uchar>(v1,u1)));
+                sigma += diffs_ptr[correspIndex] * diffs_ptr[correspIndex];
+            }
+            blocksSigma[block] = sigma;
+        }
+    }
+
+private:
+    const Mat& image0;
+    const Mat& image1;
+    const Mat& corresps;
+    float* diffs_ptr;
+    std::vector<double>& blocksSigma;
+
+    RgbdDiffsInvoker& operator=(const RgbdDiffsInvoker&); // to quiet MSVC
+};
+
+class RgbdLsmInvoker : public ParallelLoopBody
+{
+public:
+    RgbdLsmInvoker(const Mat& _cloud0, const Mat& _Rt, const Mat& _dI_dx1, const Mat& _dI_dy1,
+                   const Mat& _corresps, const float* _diffs_ptr, double _sigma,
+                   double _fx, double _fy, double _sobelScaleIn,
+                   CalcRgbdEquationCoeffsPtr _func, int _transformDim, std::vector<double>& _blocksAcc)
+        : cloud0(_cloud0), Rt(_Rt), dI_dx1(_dI_dx1), dI_dy1(_dI_dy1),
+          corresps(_corresps), diffs_ptr(_diffs_ptr), sigma(_sigma),
+          fx(_fx), fy(_fy), sobelScaleIn(_sobelScaleIn),
+          func(_func), transformDim(_transformDim), blocksAcc(_blocksAcc) {}
+
+    void operator()(const Range& range) const
+    {
+        const double * Rt_ptr = Rt.ptr<const double>();
+        const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
+        const int accSize = transformDim * (transformDim + 1);
+        double A_ptr[6];
+
+        for(int block = range.start; block < range.end; block++)
+        {
+            int end = std::min(corresps.rows, (block + 1) * correspsBlockSize);
+            double* acc = &blocksAcc[block * accSize];
+            for(int correspIndex = block * correspsBlockSize; correspIndex < end; correspIndex++)
+            {
+                const Vec4i& c = corresps_ptr[correspIndex];
+                int u0 = c[0], v0 = c[1];
+                int u1 = c[2], v1 = c[3];
+
+                double w = sigma + std::abs(diffs_ptr[correspIndex]);
+                w = w > DBL_EPSILON ? 1./w : 1.;
+
+                double w_sobelScale = w * sobelScaleIn;
+
+                const Point3f& p0 = cloud0.at<Point3f>(v0,u0);
+                Point3f tp0;
+                tp0.x = (float)(p0.x * Rt_ptr[0] + p0.y * Rt_ptr[1] + p0.z * Rt_ptr[2] + Rt_ptr[3]);
+                tp0.y = (float)(p0.x * Rt_ptr[4] + p0.y * Rt_ptr[5] + p0.z * Rt_ptr[6] + Rt_ptr[7]);
+                tp0.z = (float)(p0.x * Rt_ptr[8] + p0.y * Rt_ptr[9] + p0.z * Rt_ptr[10] + Rt_ptr[11]);
+
+                func(A_ptr,
+                     w_sobelScale * dI_dx1.at<short int>(v1,u1),
+                     w_sobelScale * dI_dy1.at<short int>(v1,u1),
+                     tp0, fx, fy);
+
+                accumulateLsmEquation(acc, A_ptr, w * diffs_ptr[correspIndex], transformDim);
+            }
+        }
+    }
+
+private:
+    const Mat& cloud0;
+    const Mat& Rt;
+    const Mat& dI_dx1;
+    const Mat& dI_dy1;
+    const Mat& corresps;
+    const float* diffs_ptr;
+    double sigma, fx, fy, sobelScaleIn;
+    CalcRgbdEquationCoeffsPtr func;
+    int transformDim;
+    std::vector<double>& blocksAcc;
+
+    RgbdLsmInvoker& operator=(const RgbdLsmInvoker&); // to quiet MSVC
+};
+
 static 
 void calcRgbdLsmMatrices(const Mat& image0, const Mat& cloud0, const Mat& Rt,
                const Mat& image1, const Mat& dI_dx1, const Mat& dI_dy1,
                const Mat& corresps, double fx, double fy, double sobelScaleIn,
                Mat& AtA, Mat& AtB, CalcRgbdEquationCoeffsPtr func, int transformDim)
 {
-    AtA = Mat(transformDim, transformDim, CV_64FC1, Scalar(0));
-    AtB = Mat(transformDim, 1, CV_64FC1, Scalar(0));
-    double* AtB_ptr = AtB.ptr<double>();
-
     const int correspsCount = corresps.rows;
+    const int blockCount = correspsBlockCount(correspsCount);
 
     CV_Assert(Rt.type() == CV_64FC1);
-    const double * Rt_ptr = Rt.ptr<const double>();
+    CV_Assert(transformDim <= 6);
 
     AutoBuffer<float> diffs(correspsCount);
     float* diffs_ptr = diffs;
 
-    const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
+    std::vector<double> blocksSigma(blockCount);
+    parallel_for_(Range(0, blockCount), RgbdDiffsInvoker(image0, image1, corresps, diffs_ptr, blocksSigma));
+    double sigma = reduceSigmaBlocks(blocksSigma, correspsCount);
 
-    double sigma = 0;
-    for(int correspIndex = 0; correspIndex < corresps.rows; correspIndex++)
-    {
-         const Vec4i& c = corresps_ptr[correspIndex];
-         int u0 = c[0], v0 = c[1];
-         int u1 = c[2], v1 = c[3];
-              
-         diffs_ptr[correspIndex] = static_cast<float>(static_cast<int>(image0.at<uchar>(v0,u0)) - 
-                                                      static_cast<int>(image1.at<uchar>(v1,u1)));
-         sigma += diffs_ptr[correspIndex] * diffs_ptr[correspIndex];
-    }
-    sigma = std::sqrt(sigma/correspsCount);
+    std::vector<double> blocksAcc(blockCount * transformDim * (transformDim + 1), 0.);
+    parallel_for_(Range(0, blockCount), RgbdLsmInvoker(cloud0, Rt, dI_dx1, dI_dy1, corresps, diffs_ptr, sigma,
+                                                       fx, fy, sobelScaleIn, func, transformDim, blocksAcc));
+    reduceLsmBlocks(blocksAcc, transformDim, AtA, AtB);
+}
 
-    std::vector<double> A_buf(transformDim);
-    double* A_ptr = &A_buf[0];
+class ICPDiffsInvoker : public ParallelLoopBody
+{
+public:
+    ICPDiffsInvoker(const Mat& _cloud0, const Mat& _Rt, const Mat& _cloud1, const Mat& _normals1,
+                    const Mat& _corresps, float* _diffs_ptr, Point3f* _tps0_ptr, std::vector<double>& _blocksSigma)
+        : cloud0(_cloud0), Rt(_Rt), cloud1(_cloud1), normals1(_normals1), corresps(_corresps),
+          diffs_ptr(_diffs_ptr), tps0_ptr(_tps0_ptr), blocksSigma(_blocksSigma) {}
 
-    for(int correspIndex = 0; correspIndex < corresps.rows; correspIndex++)
+    void operator()(const Range& range) const
     {
-         const Vec4i& c = corresps_ptr[correspIndex];
-         int u0 = c[0], v0 = c[1];
-         int u1 = c[2], v1 = c[3];
-
-         double w = sigma + std::abs(diffs_ptr[correspIndex]);
-         w = w > DBL_EPSILON ? 1./w : 1.;
+        const double * Rt_ptr = Rt.ptr<const double>();
+        const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
+        for(int block = range.start; block < range.end; block++)
+        {
+            int end = std::min(corresps.rows, (block + 1) * correspsBlockSize);
+            double sigma = 0;
+            for(int correspIndex = block * correspsBlockSize; correspIndex < end; correspIndex++)
+            {
+                const Vec4i& c = corresps_ptr[correspIndex];
+                int u0 = c[0], v0 = c[1];
+                int u1 = c[2], v1 = c[3];
+
+                const Point3f& p0 = cloud0.at<Point3f>(v0,u0);
+                Point3f tp0;
+                tp0.x = (float)(p0.x * Rt_ptr[0] + p0.y * Rt_ptr[1] + p0.z * Rt_ptr[2] + Rt_ptr[3]);
+                tp0.y = (float)(p0.x * Rt_ptr[4] + p0.y * Rt_ptr[5] + p0.z * Rt_ptr[6] + Rt_ptr[7]);
+                tp0.z = (float)(p0.x * Rt_ptr[8] + p0.y * Rt_ptr[9] + p0.z * Rt_ptr[10] + Rt_ptr[11]);
+
+                Vec3f n1 = normals1.at<Vec3f>(v1, u1);
+                Point3f v = cloud1.at<Point3f>(v1,u1) - tp0;
+
+                tps0_ptr[correspIndex] = tp0;
+                diffs_ptr[correspIndex] = n1[0] * v.x + n1[1] * v.y + n1[2] * v.z;
+                sigma += diffs_ptr[correspIndex] * diffs_ptr[correspIndex];
+            }
+            blocksSigma[block] = sigma;
+        }
+    }
 
-         double w_sobelScale = w * sobelScaleIn;
+private:
+    const Mat& cloud0;
+    const Mat& Rt;
+    const Mat& cloud1;
+    const Mat& normals1;
+    const Mat& corresps;
+    float* diffs_ptr;
+    Point3f* tps0_ptr;
+    std::vector<double>& blocksSigma;
+
+    ICPDiffsInvoker& operator=(const ICPDiffsInvoker&); // to quiet MSVC
+};
 
-         const Point3f& p0 = cloud0.at<Point3f>(v0,u0);
-         Point3f tp0;
-         tp0.x = (float)(p0.x * Rt_ptr[0] + p0.y * Rt_ptr[1] + p0.z * Rt_ptr[2] + Rt_ptr[3]);
-         tp0.y = (float)(p0.x * Rt_ptr[4] + p0.y * Rt_ptr[5] + p0.z * Rt_ptr[6] + Rt_ptr[7]);
-         tp0.z = (float)(p0.x * Rt_ptr[8] + p0.y * Rt_ptr[9] + p0.z * Rt_ptr[10] + Rt_ptr[11]);
+class ICPLsmInvoker : public ParallelLoopBody
+{
+public:
+    ICPLsmInvoker(const Mat& _normals1, const Mat& _corresps, const float* _diffs_ptr, const Point3f* _tps0_ptr,
+                  double _sigma, CalcICPEquationCoeffsPtr _func, int _transformDim, std::vector<double>& _blocksAcc)
+        : normals1(_normals1), corresps(_corresps), diffs_ptr(_diffs_ptr), tps0_ptr(_tps0_ptr),
+          sigma(_sigma), func(_func), transformDim(_transformDim), blocksAcc(_blocksAcc) {}
 
-         func(A_ptr,
-              w_sobelScale * dI_dx1.at<short int>(v1,u1),
-              w_sobelScale * dI_dy1.at<short int>(v1,u1),
-              tp0, fx, fy);
+    void operator()(const Range& range) const
+    {
+        const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
+        const int accSize = transformDim * (transformDim + 1);
+        double A_ptr[6];
 
-        for(int y = 0; y < transformDim; y++)
+        for(int block = range.start; block < range.end; block++)
         {
-            double* AtA_ptr = AtA.ptr<double>(y);
-            for(int x = y; x < transformDim; x++)
-                AtA_ptr[x] += A_ptr[y] * A_ptr[x];
+            int end = std::min(corresps.rows, (block + 1) * correspsBlockSize);
+            double* acc = &blocksAcc[block * accSize];
+            for(int correspIndex = block * correspsBlockSize; correspIndex < end; correspIndex++)
+            {
+                const Vec4i& c = corresps_ptr[correspIndex];
+                int u1 = c[2], v1 = c[3];
+
+                double w = sigma + std::abs(diffs_ptr[correspIndex]);
+                w = w > DBL_EPSILON ? 1./w : 1.;
 
-            AtB_ptr[y] += A_ptr[y] * w * diffs_ptr[correspIndex];
+                func(A_ptr, tps0_ptr[correspIndex], normals1.at<Vec3f>(v1, u1) * w);
+
+                accumulateLsmEquation(acc, A_ptr, w * diffs_ptr[correspIndex], transformDim);
+            }
         }
-    }		
-    
-    for(int y = 0; y < transformDim; y++)
-        for(int x = y+1; x < transformDim; x++)
-            AtA.at<double>(x,y) = AtA.at<double>(y,x);
-}
+    }
+
+private:
+    const Mat& normals1;
+    const Mat& corresps;
+    const float* diffs_ptr;
+    const Point3f* tps0_ptr;
+    double sigma;
+    CalcICPEquationCoeffsPtr func;
+    int transformDim;
+    std::vector<double>& blocksAcc;
+
+    ICPLsmInvoker& operator=(const ICPLsmInvoker&); // to quiet MSVC
+};
 
 static
 void calcICPLsmMatrices(const Mat& cloud0, const Mat& Rt,
@@ -710,14 +924,11 @@ void calcICPLsmMatrices(const Mat& cloud0, const Mat& Rt,
                         const Mat& corresps,
                         Mat& AtA, Mat& AtB, CalcICPEquationCoeffsPtr func, int transformDim)
 {
-    AtA = Mat(transformDim, transformDim, CV_64FC1, Scalar(0));
-    AtB = Mat(transformDim, 1, CV_64FC1, Scalar(0));
-    double* AtB_ptr = AtB.ptr<double>();
-
     const int correspsCount = corresps.rows;
+    const int blockCount = correspsBlockCount(correspsCount);
 
     CV_Assert(Rt.type() == CV_64FC1);
-    const double * Rt_ptr = Rt.ptr<const double>();
+    CV_Assert(transformDim <= 6);
 
     AutoBuffer<float> diffs(correspsCount);
     float * diffs_ptr = diffs;
@@ -725,56 +936,15 @@ void calcICPLsmMatrices(const Mat& cloud0, const Mat& Rt,
     AutoBuffer<Point3f> transformedPoints0(correspsCount);
     Point3f * tps0_ptr = transformedPoints0;
 
-    const Vec4i* corresps_ptr = corresps.ptr<Vec4i>();
-
-    double sigma = 0;
-    for(int correspIndex = 0; correspIndex < corresps.rows; correspIndex++)
-    {
-        const Vec4i& c = corresps_ptr[correspIndex];
-        int u0 = c[0], v0 = c[1];
-        int u1 = c[2], v1 = c[3];
-
-        const Point3f& p0 = cloud0.at<Point3f>(v0,u0);
-        Point3f tp0;
-        tp0.x = (float)(p0.x * Rt_ptr[0] + p0.y * Rt_ptr[1] + p0.z * Rt_ptr[2] + Rt_ptr[3]);
-        tp0.y = (float)(p0.x * Rt_ptr[4] + p0.y * Rt_ptr[5] + p0.z * Rt_ptr[6] + Rt_ptr[7]);
-        tp0.z = (float)(p0.x * Rt_ptr[8] + p0.y * Rt_ptr[9] + p0.z * Rt_ptr[10] + Rt_ptr[11]);
-
-        Vec3f n1 = normals1.at<Vec3f>(v1, u1);
-        Point3f v = cloud1.at<Point3f>(v1,u1) - tp0;
-
-        tps0_ptr[correspIndex] = tp0;
-        diffs_ptr[correspIndex] = n1[0] * v.x + n1[1] * v.y + n1[2] * v.z;
-        sigma += diffs_ptr[correspIndex] * diffs_ptr[correspIndex];
-    }
-
-    sigma = std::sqrt(sigma/correspsCount);
+    std::vector<double> blocksSigma(blockCount);
+    parallel_for_(Range(0, blockCount), ICPDiffsInvoker(cloud0, Rt, cloud1, normals1, corresps,
+                                                        diffs_ptr, tps0_ptr, blocksSigma));
+    double sigma = reduceSigmaBlocks(blocksSigma, correspsCount);
 
-    std::vector<double> A_buf(transformDim);
-    double* A_ptr = &A_buf[0];
-    for(int correspIndex = 0; correspIndex < corresps.rows; correspIndex++)
-    {
-        const Vec4i& c = corresps_ptr[correspIndex];
-        int u1 = c[2], v1 = c[3];
-
-        double w = sigma + std::abs(diffs_ptr[correspIndex]);
-        w = w > DBL_EPSILON ? 1./w : 1.;
-
-        func(A_ptr, tps0_ptr[correspIndex], normals1.at<Vec3f>(v1, u1) * w);
-
-        for(int y = 0; y < transformDim; y++)
-        {
-            double* AtA_ptr = AtA.ptr<double>(y);
-            for(int x = y; x < transformDim; x++)
-                AtA_ptr[x] += A_ptr[y] * A_ptr[x];
-
-            AtB_ptr[y] += A_ptr[y] * w * diffs_ptr[correspIndex];
-        }
-    }
-
-    for(int y = 0; y < transformDim; y++)
-        for(int x = y+1; x < transformDim; x++)
-            AtA.at<double>(x,y) = AtA.at<double>(y,x);
+    std::vector<double> blocksAcc(blockCount * transformDim * (transformDim + 1), 0.);
+    parallel_for_(Range(0, blockCount), ICPLsmInvoker(normals1, corresps, diffs_ptr, tps0_ptr, sigma,
+                                                      func, transformDim, blocksAcc));
+    reduceLsmBlocks(blocksAcc, transformDim, AtA, AtB);
 }
 
 static
@@ -1401,6 +1571,50 @@ bool RgbdICPOdometry::computeImpl(const Ptr<OdometryFrame>& srcFrame, const Ptr<
     return RGBDICPOdometryImpl(Rt, initRt, srcFrame, dstFrame, cameraMatrix, (float)maxDepthDiff, iterCounts,  maxTranslation, maxRotation, MERGED_ODOMETRY, transformType);
 }
 
+//
+OdometryStream::OdometryStream(const Ptr<Odometry>& _odometry) : odometry(_odometry)
+{
+    if(odometry.empty())
+        CV_Error(Error::StsBadArg, "Null odometry pointer.\n");
+}
+
+bool OdometryStream::compute(const Mat& image, const Mat& depth, const Mat& mask, Mat& Rt, const Mat& initRt)
+{
+    Ptr<OdometryFrame> frame(new OdometryFrame(image, depth, mask));
+
+    return compute(frame, Rt, initRt);
+}
+
+bool OdometryStream::compute(Ptr<OdometryFrame>& frame, Mat& Rt, const Mat& initRt)
+{
+    // the masks passed by the user are kept, the computed ones depend on the frame role
+    bool hasPyramidMask = !frame.empty() && !frame->pyramidMask.empty();
+
+    bool isComputed = false;
+    if(prevFrame.empty())
+    {
+        odometry->prepareFrameCache(frame, OdometryFrame::CACHE_DST);
+        Rt = Mat::eye(4, 4, CV_64FC1);
+    }
+    else
+        isComputed = odometry->compute(prevFrame, frame, Rt, initRt);
+
+    // The pyramids that do not depend on the role are shared with the next srcFrame
+    prevFrame = makePtr<OdometryFrame>(frame->image, frame->depth, frame->mask, frame->normals, frame->ID);
+    prevFrame->pyramidImage = frame->pyramidImage;
+    prevFrame->pyramidDepth = frame->pyramidDepth;
+    prevFrame->pyramidCloud = frame->pyramidCloud;
+    if(hasPyramidMask)
+        prevFrame->pyramidMask = frame->pyramidMask;
+
+    return isComputed;
+}
+
+void OdometryStream::reset()
+{
+    prevFrame.release();
+}
+
 //
 
 void
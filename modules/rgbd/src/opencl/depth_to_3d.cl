@@ -0,0 +1,31 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+// Converts a depth image of type DEPTH_TYPE to an organized set of float 3d points.
+// Integer depths are in millimeters, their invalid values (0 for ushort, the extreme values for short)
+// give NaN points.
+__kernel void depthTo3d(__global const uchar * depthptr, int depth_step, int depth_offset,
+                        __global uchar * pointsptr, int points_step, int points_offset, int rows, int cols,
+                        float inv_fx, float inv_fy, float ox, float oy)
+{
+    int x = get_global_id(0);
+    int y = get_global_id(1);
+
+    if (x < cols && y < rows)
+    {
+        DEPTH_TYPE d = *(__global const DEPTH_TYPE *)(depthptr + mad24(y, depth_step, depth_offset + x * (int)sizeof(DEPTH_TYPE)));
+        __global float * point = (__global float *)(pointsptr + mad24(y, points_step, points_offset + x * 3 * (int)sizeof(float)));
+
+#if defined DEPTH_16U
+        float z = d == 0 ? NAN : d * 0.001f;
+#elif defined DEPTH_16S
+        float z = (d == SHRT_MIN || d == SHRT_MAX) ? NAN : d * 0.001f;
+#else
+        float z = d;
+#endif
+        point[0] = (x - ox) * inv_fx * z;
+        point[1] = (y - oy) * inv_fy * z;
+        point[2] = z;
+    }
+}
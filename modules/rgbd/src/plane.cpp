@@ -127,6 +127,16 @@ public:
     ++K_;
   }
 
+  /** Add the statistics of a whole set of points
+   */
+  void
+  UpdateStatistics(const Vec3f & m_sum, const Matx33f & Q_sum, int K)
+  {
+    m_sum_ += m_sum;
+    Q_ += Q_sum;
+    K_ += K;
+  }
+
   inline size_t
   empty() const
   {
@@ -245,58 +255,9 @@ public:
     n_.create(mini_rows, mini_cols);
     Q_.create(points3d.rows, points3d.cols);
     mse_.create(mini_rows, mini_cols);
-    for (int y = 0; y < mini_rows; ++y)
-      for (int x = 0; x < mini_cols; ++x)
-      {
-        // Update the tiles
-        Matx33f Q = Matx33f::zeros();
-        Vec3f m = Vec3f(0, 0, 0);
-        int K = 0;
-        for (int j = y * block_size; j < std::min((y + 1) * block_size, points3d.rows); ++j)
-        {
-          const Vec3f * vec = points3d.ptr < Vec3f > (j, x * block_size), *vec_end;
-          float * pointpointt = reinterpret_cast<float*>(Q_.ptr < Vec<float, 9> > (j, x * block_size));
-          if (x == mini_cols - 1)
-            vec_end = points3d.ptr < Vec3f > (j, points3d.cols - 1) + 1;
-          else
-            vec_end = vec + block_size;
-          for (; vec != vec_end; ++vec, pointpointt += 9)
-          {
-            if (cvIsNaN(vec->val[0]))
-              continue;
-            // Fill point*point.t()
-            *pointpointt = vec->val[0] * vec->val[0];
-            *(pointpointt + 1) = vec->val[0] * vec->val[1];
-            *(pointpointt + 2) = vec->val[0] * vec->val[2];
-            *(pointpointt + 3) = *(pointpointt + 1);
-            *(pointpointt + 4) = vec->val[1] * vec->val[1];
-            *(pointpointt + 5) = vec->val[1] * vec->val[2];
-            *(pointpointt + 6) = *(pointpointt + 2);
-            *(pointpointt + 7) = *(pointpointt + 5);
-            *(pointpointt + 8) = vec->val[2] * vec->val[2];
-
-            Q += *reinterpret_cast<Matx33f*>(pointpointt);
-            m += (*vec);
-            ++K;
-          }
-        }
-        if (K == 0)
-        {
-          mse_(y, x) = std::numeric_limits<float>::max();
-          continue;
-        }
-
-        m /= K;
-        m_(y, x) = m;
-
-        // Compute C
-        Matx33f C = Q - K * m * m.t();
-
-        // Compute n
-        SVD svd(C);
-        n_(y, x) = Vec3f(svd.vt.at<float>(2, 0), svd.vt.at<float>(2, 1), svd.vt.at<float>(2, 2));
-        mse_(y, x) = svd.w.at<float>(2) / K;
-      }
+    Q_sum_.create(mini_rows, mini_cols);
+    K_.create(mini_rows, mini_cols);
+    parallel_for_(Range(0, mini_rows), TilesInvoker(*this, points3d));
   }
 
   /** The size of the block */
@@ -305,6 +266,92 @@ public:
   Mat_<Vec3f> n_;
   Mat_<Vec<float, 9> > Q_;
   Mat_<float> mse_;
+  /** The sum of p * p^\top and the number of points of each tile */
+  Mat_<Vec<float, 9> > Q_sum_;
+  Mat_<int> K_;
+
+private:
+  void
+  computeTile(const Mat_<Vec3f> & points3d, int y, int x)
+  {
+    const int block_size = block_size_, mini_cols = m_.cols;
+    // Update the tiles
+    Matx33f Q = Matx33f::zeros();
+    Vec3f m = Vec3f(0, 0, 0);
+    int K = 0;
+    for (int j = y * block_size; j < std::min((y + 1) * block_size, points3d.rows); ++j)
+    {
+      const Vec3f * vec = points3d.ptr < Vec3f > (j, x * block_size), *vec_end;
+      float * pointpointt = reinterpret_cast<float*>(Q_.ptr < Vec<float, 9> > (j, x * block_size));
+      if (x == mini_cols - 1)
+        vec_end = points3d.ptr < Vec3f > (j, points3d.cols - 1) + 1;
+      else
+        vec_end = vec + block_size;
+      for (; vec != vec_end; ++vec, pointpointt += 9)
+      {
+        if (cvIsNaN(vec->val[0]))
+          continue;
+        // Fill point*point.t()
+        *pointpointt = vec->val[0] * vec->val[0];
+        *(pointpointt + 1) = vec->val[0] * vec->val[1];
+        *(pointpointt + 2) = vec->val[0] * vec->val[2];
+        *(pointpointt + 3) = *(pointpointt + 1);
+        *(pointpointt + 4) = vec->val[1] * vec->val[1];
+        *(pointpointt + 5) = vec->val[1] * vec->val[2];
+        *(pointpointt + 6) = *(pointpointt + 2);
+        *(pointpointt + 7) = *(pointpointt + 5);
+        *(pointpointt + 8) = vec->val[2] * vec->val[2];
+
+        Q += *reinterpret_cast<Matx33f*>(pointpointt);
+        m += (*vec);
+        ++K;
+      }
+    }
+    *reinterpret_cast<Matx33f*>(Q_sum_.ptr < Vec<float, 9> > (y, x)) = Q;
+    K_(y, x) = K;
+    if (K == 0)
+    {
+      mse_(y, x) = std::numeric_limits<float>::max();
+      return;
+    }
+
+    m /= K;
+    m_(y, x) = m;
+
+    // Compute C
+    Matx33f C = Q - K * m * m.t();
+
+    // Compute n
+    SVD svd(C);
+    n_(y, x) = Vec3f(svd.vt.at<float>(2, 0), svd.vt.at<float>(2, 1), svd.vt.at<float>(2, 2));
+    mse_(y, x) = svd.w.at<float>(2) / K;
+  }
+
+  /** The tiles are independent, they are computed a row of tiles at a time */
+  class TilesInvoker : public ParallelLoopBody
+  {
+  public:
+    TilesInvoker(PlaneGrid & grid, const Mat_<Vec3f> & points3d)
+        :
+          grid_(grid),
+          points3d_(points3d)
+    {
+    }
+
+    virtual void
+    operator()(const Range& range) const
+    {
+      for (int y = range.start; y < range.end; ++y)
+        for (int x = 0; x < grid_.m_.cols; ++x)
+          grid_.computeTile(points3d_, y, x);
+    }
+
+  private:
+    PlaneGrid & grid_;
+    const Mat_<Vec3f> & points3d_;
+
+    TilesInvoker& operator=(const TilesInvoker&); // to quiet MSVC
+  };
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -528,6 +575,345 @@ private:
   const InlierFinder & operator = (const InlierFinder &);
 };
 
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/** Union-find over the tiles, the root of a set is always its smallest tile index so that the sets
+ * don't depend on the order of the merges
+ */
+class TileUnionFind
+{
+public:
+  TileUnionFind(int n)
+      :
+        parent_(n)
+  {
+    for (int i = 0; i < n; ++i)
+      parent_[i] = i;
+  }
+
+  int
+  find(int i)
+  {
+    while (parent_[i] != i)
+    {
+      parent_[i] = parent_[parent_[i]];
+      i = parent_[i];
+    }
+    return i;
+  }
+
+  void
+  unite(int i, int j)
+  {
+    i = find(i);
+    j = find(j);
+    if (i < j)
+      parent_[j] = i;
+    else if (j < i)
+      parent_[i] = j;
+  }
+private:
+  std::vector<int> parent_;
+};
+
+static Ptr<PlaneBase>
+createPlane(const Vec3f & m, const Vec3f & n, int index, float sensor_error_a, float sensor_error_b,
+            float sensor_error_c)
+{
+  if ((sensor_error_a == 0) && (sensor_error_b == 0) && (sensor_error_c == 0))
+    return Ptr<PlaneBase>(new Plane(m, n, index));
+  return Ptr<PlaneBase>(new PlaneABC(m, n, index, sensor_error_a, sensor_error_b, sensor_error_c));
+}
+
+/** Checks in parallel which neighboring planar tiles lie on the same plane: bit 0 of the result is set
+ * when a tile can be merged with its right neighbor, bit 1 with its bottom neighbor
+ */
+class TileEdgesInvoker : public ParallelLoopBody
+{
+public:
+  TileEdgesInvoker(const PlaneGrid & grid, const std::vector<Ptr<PlaneBase> > & tile_planes, float err,
+                   Mat_<uchar> & edges)
+      :
+        grid_(grid),
+        tile_planes_(tile_planes),
+        err_(err),
+        edges_(edges)
+  {
+  }
+
+  virtual void
+  operator()(const Range& range) const
+  {
+    const int cols = grid_.mse_.cols, rows = grid_.mse_.rows;
+    for (int y = range.start; y < range.end; ++y)
+      for (int x = 0; x < cols; ++x)
+      {
+        uchar edges = 0;
+        if (x + 1 < cols && similar(y * cols + x, y * cols + x + 1))
+          edges |= 1;
+        if (y + 1 < rows && similar(y * cols + x, (y + 1) * cols + x))
+          edges |= 2;
+        edges_(y, x) = edges;
+      }
+  }
+
+private:
+  bool
+  similar(int i, int j) const
+  {
+    const Ptr<PlaneBase> & a = tile_planes_[i], & b = tile_planes_[j];
+    if (a.empty() || b.empty())
+      return false;
+    const int cols = grid_.mse_.cols;
+    return (std::abs(a->n().dot(b->n())) > 0.95) && (a->distance(grid_.m_(j / cols, j % cols)) < err_)
+        && (b->distance(grid_.m_(i / cols, i % cols)) < err_);
+  }
+
+  const PlaneGrid & grid_;
+  const std::vector<Ptr<PlaneBase> > & tile_planes_;
+  float err_;
+  Mat_<uchar> & edges_;
+
+  TileEdgesInvoker& operator=(const TileEdgesInvoker&); // to quiet MSVC
+};
+
+/** Assigns the points to the closest plane of their tile or of the 8 neighboring tiles, and sums the
+ * statistics of the inliers of every plane by blocks of rows
+ */
+class PlaneInliersInvoker : public ParallelLoopBody
+{
+public:
+  struct Statistics
+  {
+    Statistics()
+        :
+          m_sum(0, 0, 0),
+          Q(Matx33f::zeros()),
+          K(0)
+    {
+    }
+    Vec3f m_sum;
+    Matx33f Q;
+    int K;
+  };
+
+  PlaneInliersInvoker(const PlaneGrid & grid, const Mat_<Vec3f> & points3d, const Mat_<Vec3f> & normals,
+                      const Mat_<int> & tile_labels, const std::vector<Ptr<PlaneBase> > & planes, float err,
+                      int block_rows, Mat_<int> & labels, std::vector<std::vector<Statistics> > & statistics)
+      :
+        grid_(grid),
+        points3d_(points3d),
+        normals_(normals),
+        tile_labels_(tile_labels),
+        planes_(planes),
+        err_(err),
+        block_rows_(block_rows),
+        labels_(labels),
+        statistics_(statistics)
+  {
+  }
+
+  virtual void
+  operator()(const Range& range) const
+  {
+    const int block_size = grid_.block_size_;
+    std::vector<int> candidates;
+    for (int block = range.start; block < range.end; ++block)
+    {
+      std::vector<Statistics> & statistics = statistics_[block];
+      statistics.assign(planes_.size(), Statistics());
+      int y_end = std::min(points3d_.rows, (block + 1) * block_rows_);
+      for (int y = block * block_rows_; y < y_end; ++y)
+      {
+        const Vec3f* point = points3d_[y];
+        const Matx33f* Q_local = reinterpret_cast<const Matx33f *>(grid_.Q_.ptr < Vec<float, 9> > (y));
+        int* label = labels_[y];
+        int tile_y = y / block_size;
+        for (int x = 0; x < points3d_.cols; ++x)
+        {
+          label[x] = -1;
+          if (cvIsNaN(point[x][0]))
+            continue;
+
+          // The different planes of the neighborhood, from the own tile first
+          int tile_x = x / block_size;
+          candidates.clear();
+          for (int j = 0; j < 9; ++j)
+          {
+            int ty = tile_y + (j / 3 + 1) % 3 - 1, tx = tile_x + (j % 3 + 1) % 3 - 1;
+            if (ty < 0 || ty >= tile_labels_.rows || tx < 0 || tx >= tile_labels_.cols)
+              continue;
+            int plane = tile_labels_(ty, tx);
+            if (plane >= 0 && std::find(candidates.begin(), candidates.end(), plane) == candidates.end())
+              candidates.push_back(plane);
+          }
+
+          float best_distance = err_;
+          for (size_t i = 0; i < candidates.size(); ++i)
+          {
+            const PlaneBase & plane = *planes_[candidates[i]];
+            float distance = plane.distance(point[x]);
+            if (distance >= best_distance)
+              continue;
+            // make sure the normals are similar to the plane
+            if (!normals_.empty() && std::abs(plane.n().dot(normals_(y, x))) <= 0.3)
+              continue;
+            best_distance = distance;
+            label[x] = candidates[i];
+          }
+
+          if (label[x] >= 0)
+          {
+            Statistics & stats = statistics[label[x]];
+            stats.m_sum += point[x];
+            stats.Q += Q_local[x];
+            ++stats.K;
+          }
+        }
+      }
+    }
+  }
+
+private:
+  const PlaneGrid & grid_;
+  const Mat_<Vec3f> & points3d_;
+  const Mat_<Vec3f> & normals_;
+  const Mat_<int> & tile_labels_;
+  const std::vector<Ptr<PlaneBase> > & planes_;
+  float err_;
+  int block_rows_;
+  Mat_<int> & labels_;
+  std::vector<std::vector<Statistics> > & statistics_;
+
+  PlaneInliersInvoker& operator=(const PlaneInliersInvoker&); // to quiet MSVC
+};
+
+/** Block-parallel plane segmentation: every planar tile is a seed, neighboring seeds on the same plane
+ * are merged with a union-find, and the points are then assigned to the merged planes in parallel
+ */
+static void
+findPlanesParallel(const Mat_<Vec3f> & points3d, const Mat_<Vec3f> & normals, int block_size, int min_size,
+                   float threshold, float sensor_error_a, float sensor_error_b, float sensor_error_c,
+                   Mat_<unsigned char> & mask, std::vector<Vec4f> & plane_coefficients)
+{
+  PlaneGrid plane_grid(points3d, block_size);
+  const int tile_rows = plane_grid.mse_.rows, tile_cols = plane_grid.mse_.cols;
+  const float mse_min = threshold * threshold;
+
+  // Seeds: a plane for every planar tile
+  std::vector<Ptr<PlaneBase> > tile_planes(tile_rows * tile_cols);
+  for (int y = 0; y < tile_rows; ++y)
+    for (int x = 0; x < tile_cols; ++x)
+      if (plane_grid.mse_(y, x) <= mse_min)
+        tile_planes[y * tile_cols + x] = createPlane(plane_grid.m_(y, x), plane_grid.n_(y, x), 0, sensor_error_a,
+                                                     sensor_error_b, sensor_error_c);
+
+  // Merge the neighboring seeds lying on the same plane
+  Mat_<uchar> edges(tile_rows, tile_cols);
+  parallel_for_(Range(0, tile_rows), TileEdgesInvoker(plane_grid, tile_planes, threshold, edges));
+  TileUnionFind sets(tile_rows * tile_cols);
+  for (int y = 0; y < tile_rows; ++y)
+    for (int x = 0; x < tile_cols; ++x)
+    {
+      if (edges(y, x) & 1)
+        sets.unite(y * tile_cols + x, y * tile_cols + x + 1);
+      if (edges(y, x) & 2)
+        sets.unite(y * tile_cols + x, (y + 1) * tile_cols + x);
+    }
+
+  // Fit a plane to the tiles of every set
+  std::vector<Ptr<PlaneBase> > planes;
+  std::vector<float> planes_mse;
+  std::vector<int> root_plane(tile_rows * tile_cols, -1);
+  Mat_<int> tile_labels(tile_rows, tile_cols, -1);
+  for (int i = 0; i < tile_rows * tile_cols; ++i)
+  {
+    if (tile_planes[i].empty())
+      continue;
+    int root = sets.find(i);
+    if (root_plane[root] < 0)
+    {
+      root_plane[root] = (int)planes.size();
+      planes.push_back(createPlane(plane_grid.m_(root / tile_cols, root % tile_cols), tile_planes[root]->n(),
+                                   (int)planes.size(), sensor_error_a, sensor_error_b, sensor_error_c));
+      planes_mse.push_back(std::numeric_limits<float>::max());
+    }
+    int plane = root_plane[root], y = i / tile_cols, x = i % tile_cols;
+    planes[plane]->UpdateStatistics(plane_grid.m_(y, x) * (float)plane_grid.K_(y, x),
+                                    *reinterpret_cast<const Matx33f*>(&plane_grid.Q_sum_(y, x)),
+                                    plane_grid.K_(y, x));
+    planes_mse[plane] = std::min(planes_mse[plane], plane_grid.mse_(y, x));
+    tile_labels(y, x) = plane;
+  }
+  for (size_t i = 0; i < planes.size(); ++i)
+    planes[i]->UpdateParameters();
+
+  // Assign the points and refit the planes to their inliers
+  const int block_rows = block_size;
+  const int n_blocks = (points3d.rows + block_rows - 1) / block_rows;
+  Mat_<int> labels(points3d.size());
+  std::vector<std::vector<PlaneInliersInvoker::Statistics> > statistics(n_blocks);
+  parallel_for_(Range(0, n_blocks), PlaneInliersInvoker(plane_grid, points3d, normals, tile_labels, planes,
+                                                        threshold, block_rows, labels, statistics));
+
+  // Index the big enough planes, the most planar seeds first like the default method
+  std::vector<std::pair<float, int> > order;
+  for (size_t i = 0; i < planes.size(); ++i)
+  {
+    PlaneInliersInvoker::Statistics stats;
+    for (int block = 0; block < n_blocks; ++block)
+    {
+      stats.m_sum += statistics[block][i].m_sum;
+      stats.Q += statistics[block][i].Q;
+      stats.K += statistics[block][i].K;
+    }
+    if (stats.K == 0 || stats.K < min_size)
+      continue;
+    planes[i] = createPlane(stats.m_sum / stats.K, planes[i]->n(), (int)i, sensor_error_a, sensor_error_b,
+                            sensor_error_c);
+    planes[i]->UpdateStatistics(stats.m_sum, stats.Q, stats.K);
+    planes[i]->UpdateParameters();
+    order.push_back(std::make_pair(planes_mse[i], (int)i));
+  }
+  std::sort(order.begin(), order.end());
+  if (order.size() > 255)
+    order.resize(255);
+
+  std::vector<uchar> plane_index(planes.size(), 255);
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    const PlaneBase & plane = *planes[order[i].second];
+    plane_index[order[i].second] = (uchar)i;
+    Vec4f coeffs(plane.n()[0], plane.n()[1], plane.n()[2], plane.d());
+    if (coeffs(2) > 0)
+      coeffs = -coeffs;
+    plane_coefficients.push_back(coeffs);
+  }
+
+  for (int y = 0; y < points3d.rows; ++y)
+  {
+    const int* label = labels[y];
+    uchar* data = mask[y];
+    for (int x = 0; x < points3d.cols; ++x)
+      data[x] = label[x] < 0 ? 255 : plane_index[label[x]];
+  }
+}
+
+/** Fill the plane coefficients
+ */
+static void
+writePlaneCoefficients(const std::vector<Vec4f> & plane_coefficients, OutputArray plane_coefficients_out)
+{
+  if (plane_coefficients.empty())
+    return;
+  plane_coefficients_out.create((int)plane_coefficients.size(), 1, CV_32FC4);
+  Mat plane_coefficients_mat = plane_coefficients_out.getMat();
+  float* data = plane_coefficients_mat.ptr<float>(0);
+  for(size_t i=0; i<plane_coefficients.size(); ++i)
+    for(uchar j=0; j<4; ++j, ++data)
+      *data = plane_coefficients[i][j];
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
   void
@@ -558,11 +944,19 @@ private:
     Mat mask_out_mat = mask_out.getMat();
     Mat_<unsigned char> mask_out_uc = (Mat_<unsigned char>&) mask_out_mat;
     mask_out_uc.setTo(255);
+    std::vector<Vec4f> plane_coefficients;
+    if (method_ == RGBD_PLANE_METHOD_PARALLEL)
+    {
+      findPlanesParallel(points3d, normals, block_size_, min_size_, (float)threshold_, (float)sensor_error_a_,
+                         (float)sensor_error_b_, (float)sensor_error_c_, mask_out_uc, plane_coefficients);
+      writePlaneCoefficients(plane_coefficients, plane_coefficients_out);
+      return;
+    }
+
     PlaneGrid plane_grid(points3d, block_size_);
     TileQueue plane_queue(plane_grid);
     size_t index_plane = 0;
 
-    std::vector<Vec4f> plane_coefficients;
     float mse_min = (float)(threshold_ * threshold_);
 
     while (!plane_queue.empty())
@@ -629,15 +1023,7 @@ private:
       plane_coefficients.push_back(coeffs);
     };
 
-    // Fill the plane coefficients
-    if (plane_coefficients.empty())
-      return;
-    plane_coefficients_out.create((int)plane_coefficients.size(), 1, CV_32FC4);
-    Mat plane_coefficients_mat = plane_coefficients_out.getMat();
-    float* data = plane_coefficients_mat.ptr<float>(0);
-    for(size_t i=0; i<plane_coefficients.size(); ++i)
-      for(uchar j=0; j<4; ++j, ++data)
-        *data = plane_coefficients[i][j];
+    writePlaneCoefficients(plane_coefficients, plane_coefficients_out);
   }
 }
 }
@@ -53,6 +53,14 @@ namespace rgbd
  * @param the desired output depth (floats or double)
  * @param out The rescaled float depth image
  */
+/** registerDepth() with the buffers of the intermediate clouds given by the caller, to keep them between frames
+ */
+void
+registerDepthBuffered(const Matx33f& unregisteredCameraMatrix, const Matx33f& registeredCameraMatrix,
+                      const Mat_<float>& registeredDistCoeffs, const Matx44f& Rt, const Mat& unregisteredDepth,
+                      const Size& outputImagePlaneSize, Mat& registeredDepth, bool depthDilation,
+                      Mat_<Point3f>& cloud, Mat_<Point3f>& transformedCloud);
+
 template<typename T>
 void
 rescaleDepthTemplated(const Mat& in, Mat& out);
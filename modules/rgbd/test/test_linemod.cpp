@@ -0,0 +1,108 @@
+#include "test_precomp.hpp"
+
+#include <opencv2/imgproc.hpp>
+
+static cv::Mat
+linemodScene(cv::Point offset)
+{
+  cv::Mat image(480, 640, CV_8UC3, cv::Scalar::all(40));
+  cv::rectangle(image, cv::Rect(offset.x, offset.y, 120, 90), cv::Scalar(220, 40, 40), -1);
+  cv::circle(image, offset + cv::Point(60, 45), 30, cv::Scalar(40, 220, 220), -1);
+  cv::line(image, offset + cv::Point(0, 90), offset + cv::Point(120, 0), cv::Scalar(40, 220, 40), 5);
+  return image;
+}
+
+TEST(Rgbd_Linemod, match_templates)
+{
+  cv::Ptr<cv::linemod::Detector> detector = cv::linemod::getDefaultLINE();
+
+  // A few classes with several templates each, so the matching is spread over threads
+  for (int i = 0; i < 4; ++i)
+  {
+    cv::Point offset(100 + 10 * i, 120 + 5 * i);
+    cv::Mat mask = cv::Mat::zeros(480, 640, CV_8U);
+    mask(cv::Rect(offset.x - 5, offset.y - 5, 130, 100)).setTo(255);
+    std::vector<cv::Mat> sources(1, linemodScene(offset));
+    for (int j = 0; j < 3; ++j)
+      ASSERT_GE(detector->addTemplate(sources, cv::format("class_%d", j), mask), 0);
+  }
+
+  std::vector<cv::Mat> scene(1, linemodScene(cv::Point(300, 200)));
+  std::vector<cv::linemod::Match> matches;
+  detector->match(scene, 80, matches);
+  ASSERT_FALSE(matches.empty());
+  EXPECT_LE(std::abs(matches[0].x - 295), 16);
+  EXPECT_LE(std::abs(matches[0].y - 195), 16);
+
+  // The matches don't depend on the number of threads
+  int threads = cv::getNumThreads();
+  cv::setNumThreads(1);
+  std::vector<cv::linemod::Match> matches_serial;
+  detector->match(scene, 80, matches_serial);
+  cv::setNumThreads(threads);
+
+  ASSERT_EQ(matches.size(), matches_serial.size());
+  for (size_t i = 0; i < matches.size(); ++i)
+  {
+    EXPECT_TRUE(matches[i] == matches_serial[i]);
+    EXPECT_EQ(matches[i].template_id, matches_serial[i].template_id);
+    EXPECT_EQ(matches[i].similarity, matches_serial[i].similarity);
+  }
+}
+
+TEST(Rgbd_Linemod, binary_templates_and_cache)
+{
+  cv::Ptr<cv::linemod::Detector> detector = cv::linemod::getDefaultLINE();
+  cv::Point offset(100, 120);
+  cv::Mat mask = cv::Mat::zeros(480, 640, CV_8U);
+  mask(cv::Rect(offset.x - 5, offset.y - 5, 130, 100)).setTo(255);
+  std::vector<cv::Mat> sources(1, linemodScene(offset));
+  ASSERT_EQ(0, detector->addTemplate(sources, "first", mask));
+  ASSERT_EQ(1, detector->addTemplate(sources, "first", mask));
+  ASSERT_EQ(0, detector->addTemplate(sources, "second", mask));
+
+  std::string filename = cv::tempfile(".bin");
+  detector->writeTemplatesBinary(filename);
+  cv::Ptr<cv::linemod::Detector> loaded = cv::linemod::getDefaultLINE();
+  loaded->readTemplatesBinary(filename);
+  remove(filename.c_str());
+
+  ASSERT_EQ(detector->numTemplates(), loaded->numTemplates());
+  ASSERT_EQ(detector->classIds(), loaded->classIds());
+  const std::vector<cv::linemod::Template>& expected = detector->getTemplates("first", 1);
+  const std::vector<cv::linemod::Template>& actual = loaded->getTemplates("first", 1);
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i)
+  {
+    EXPECT_EQ(expected[i].width, actual[i].width);
+    EXPECT_EQ(expected[i].height, actual[i].height);
+    EXPECT_EQ(expected[i].pyramid_level, actual[i].pyramid_level);
+    ASSERT_EQ(expected[i].features.size(), actual[i].features.size());
+    for (size_t j = 0; j < expected[i].features.size(); ++j)
+    {
+      EXPECT_EQ(expected[i].features[j].x, actual[i].features[j].x);
+      EXPECT_EQ(expected[i].features[j].y, actual[i].features[j].y);
+      EXPECT_EQ(expected[i].features[j].label, actual[i].features[j].label);
+    }
+  }
+
+  // The cached linear memories give the same matches, also once the scene changed
+  std::vector<cv::linemod::Match> matches, matches_cached;
+  std::vector<cv::Mat> scene(1, linemodScene(cv::Point(300, 200)));
+  loaded->match(scene, 80, matches);
+  loaded->setCacheLinearMemories(true);
+  for (int i = 0; i < 2; ++i)
+  {
+    loaded->match(scene, 80, matches_cached);
+    ASSERT_EQ(matches.size(), matches_cached.size());
+    for (size_t j = 0; j < matches.size(); ++j)
+      EXPECT_TRUE(matches[j] == matches_cached[j]);
+  }
+  // Same buffer, different scene: the cached memories must not be reused
+  linemodScene(cv::Point(200, 100)).copyTo(scene[0]);
+  detector->match(scene, 80, matches);
+  loaded->match(scene, 80, matches_cached);
+  ASSERT_EQ(matches.size(), matches_cached.size());
+  for (size_t j = 0; j < matches.size(); ++j)
+    EXPECT_TRUE(matches[j] == matches_cached[j]);
+}
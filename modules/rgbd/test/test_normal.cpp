@@ -411,7 +411,9 @@ protected:
 class CV_RgbdPlaneTest: public cvtest::BaseTest
 {
 public:
-  CV_RgbdPlaneTest()
+  CV_RgbdPlaneTest(RgbdPlane::RGBD_PLANE_METHOD method = RgbdPlane::RGBD_PLANE_METHOD_DEFAULT)
+      :
+        method_(method)
   {
   }
   ~CV_RgbdPlaneTest()
@@ -423,7 +425,7 @@ protected:
   {
     try
     {
-      RgbdPlane plane_computer;
+      RgbdPlane plane_computer(method_);
 
       std::vector<Plane> planes;
       Mat points3d, ground_normals;
@@ -506,6 +508,8 @@ protected:
       std::cout << "plane " << tm2.getTimeMilli() << " ms " << std::endl;
     }
   }
+
+  RgbdPlane::RGBD_PLANE_METHOD method_;
 };
 
 }
@@ -524,3 +528,9 @@ TEST(Rgbd_Plane, compute)
   cv::rgbd::CV_RgbdPlaneTest test;
   test.safe_run();
 }
+
+TEST(Rgbd_Plane, compute_parallel)
+{
+  cv::rgbd::CV_RgbdPlaneTest test(cv::rgbd::RgbdPlane::RGBD_PLANE_METHOD_PARALLEL);
+  test.safe_run();
+}
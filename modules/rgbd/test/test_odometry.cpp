@@ -330,6 +330,52 @@ void CV_OdometryTest::run(int)
     }
 }
 
+// The stream reuses the cache of each frame in both roles and has to give the pairwise results
+static
+void testOdometryStream(const Ptr<Odometry>& odometry)
+{
+    std::string dataPath = cvtest::TS::ptr()->get_data_path();
+    Mat image = imread(dataPath + "rgbd/rgb.png", 0);
+    Mat depth16 = imread(dataPath + "rgbd/depth.png", -1);
+    ASSERT_FALSE(image.empty());
+    ASSERT_FALSE(depth16.empty());
+
+    Mat depth;
+    depth16.convertTo(depth, CV_32FC1, 1.f/5000.f);
+    depth.setTo(std::numeric_limits<float>::quiet_NaN(), depth < FLT_EPSILON);
+
+    Mat K = (Mat_<float>(3,3) << 525.f, 0.f, 319.5f, 0.f, 525.f, 239.5f, 0.f, 0.f, 1.f);
+    odometry->setCameraMatrix(K);
+
+    std::vector<Mat> images(1, image), depths(1, depth);
+    RNG rng(0);
+    for(int i = 0; i < 2; i++)
+    {
+        Mat rvec(3, 1, CV_64FC1), tvec(3, 1, CV_64FC1);
+        rng.fill(rvec, RNG::UNIFORM, -0.01, 0.01);
+        rng.fill(tvec, RNG::UNIFORM, -0.01, 0.01);
+        Mat warpedImage, warpedDepth;
+        warpFrame(images.back(), depths.back(), rvec, tvec, K, warpedImage, warpedDepth);
+        dilateFrame(warpedImage, warpedDepth);
+        images.push_back(warpedImage);
+        depths.push_back(warpedDepth);
+    }
+
+    OdometryStream stream(odometry);
+    Mat Rt;
+    EXPECT_FALSE(stream.compute(images[0], depths[0], Mat(), Rt));
+    EXPECT_EQ(0, cvtest::norm(Rt, Mat::eye(4,4,CV_64FC1), NORM_INF));
+    for(size_t i = 1; i < images.size(); i++)
+    {
+        Mat streamRt, pairRt;
+        bool isStreamComputed = stream.compute(images[i], depths[i], Mat(), streamRt);
+        bool isPairComputed = odometry->compute(images[i-1], depths[i-1], Mat(), images[i], depths[i], Mat(), pairRt);
+        ASSERT_EQ(isPairComputed, isStreamComputed) << "frame " << i;
+        if(isPairComputed)
+            EXPECT_EQ(0, cvtest::norm(streamRt, pairRt, NORM_INF)) << "frame " << i;
+    }
+}
+
 /****************************************************************************************\
 *                                Tests registrations                                     *
 \****************************************************************************************/
@@ -353,3 +399,10 @@ TEST(DISABLED_RGBD_Odometry_RgbdICP, algorithmic)
     cv::rgbd::CV_OdometryTest test(cv::rgbd::Odometry::create("RgbdICPOdometry"), 0.99, 0.99);
     test.safe_run();
 }
+
+TEST(RGBD_OdometryStream, same_as_pairs)
+{
+    cv::rgbd::testOdometryStream(cv::rgbd::Odometry::create("RgbdOdometry"));
+    cv::rgbd::testOdometryStream(cv::rgbd::Odometry::create("ICPOdometry"));
+    cv::rgbd::testOdometryStream(cv::rgbd::Odometry::create("RgbdICPOdometry"));
+}
@@ -158,3 +158,45 @@ TEST(Rgbd_DepthRegistration, compute)
   cv::rgbd::CV_RgbdDepthRegistrationTest test;
   test.safe_run();
 }
+
+TEST(Rgbd_DepthRegistration, front_end)
+{
+  cv::Matx33f K(525.f, 0.f, 319.5f, 0.f, 525.f, 239.5f, 0.f, 0.f, 1.f);
+  cv::Matx44f Rt = cv::Matx44f::eye();
+  Rt(0, 3) = 0.025f;
+
+  // A slanted plane with some noise
+  cv::Mat_<float> depth(480, 640);
+  cv::RNG rng;
+  for (int y = 0; y < depth.rows; ++y)
+    for (int x = 0; x < depth.cols; ++x)
+      depth(y, x) = 1.f + 0.001f * x + rng.uniform(-0.002f, 0.002f);
+
+  cv::rgbd::RgbdFrontEnd front_end(K, K, cv::Mat(), Rt, depth.size());
+  cv::Mat registered, points3d, normals;
+  for (int i = 0; i < 2; ++i) // the second frame reuses the buffers
+    front_end(depth, registered, points3d, normals);
+
+  // The same stages one after the other
+  cv::Mat registered_ref, cleaned_ref, points3d_ref, normals_ref;
+  cv::rgbd::registerDepth(K, K, cv::Mat(), Rt, depth, depth.size(), registered_ref);
+  cv::rgbd::DepthCleaner cleaner(CV_32F);
+  cleaner(registered_ref, cleaned_ref);
+  cv::rgbd::depthTo3d(cleaned_ref, K, points3d_ref);
+  cv::rgbd::RgbdNormals normals_computer(depth.rows, depth.cols, CV_32F, K);
+  normals_computer(points3d_ref, normals_ref);
+
+  ASSERT_EQ(CV_32FC1, registered.type());
+  ASSERT_EQ(CV_32FC3, points3d.type());
+  ASSERT_EQ(CV_32FC3, normals.type());
+
+  cv::patchNaNs(registered, -1);
+  cv::patchNaNs(cleaned_ref, -1);
+  EXPECT_LE(cv::norm(registered, cleaned_ref, cv::NORM_INF), 1e-5);
+  cv::patchNaNs(points3d, -1);
+  cv::patchNaNs(points3d_ref, -1);
+  EXPECT_LE(cv::norm(points3d, points3d_ref, cv::NORM_INF), 1e-5);
+  cv::patchNaNs(normals, -1);
+  cv::patchNaNs(normals_ref, -1);
+  EXPECT_LE(cv::norm(normals, normals_ref, cv::NORM_INF), 1e-3);
+}
@@ -67,3 +67,26 @@ TEST(Rgbd_DepthTo3d, compute)
   cv::rgbd::CV_RgbdDepthTo3dTest test;
   test.safe_run();
 }
+
+TEST(Rgbd_DepthTo3d, umat)
+{
+  cv::Mat K = (cv::Mat_<float>(3, 3) << 525., 0., 319.5, 0., 525., 239.5, 0., 0., 1.);
+
+  cv::Mat_<ushort> depth(480, 640);
+  cv::RNG rng;
+  rng.fill(depth, cv::RNG::UNIFORM, 0, 5000);
+  depth(10, 10) = 0;
+
+  cv::Mat points3d;
+  cv::rgbd::depthTo3d(depth, K, points3d);
+
+  cv::UMat upoints3d;
+  cv::rgbd::depthTo3d(depth.getUMat(cv::ACCESS_READ), K, upoints3d);
+  cv::Mat points3d_ocl = upoints3d.getMat(cv::ACCESS_READ).clone();
+
+  ASSERT_EQ(CV_32FC3, points3d_ocl.type());
+  ASSERT_EQ(points3d.size(), points3d_ocl.size());
+  EXPECT_TRUE(cvIsNaN(points3d_ocl.at<cv::Vec3f>(10, 10)[2]));
+  points3d.at<cv::Vec3f>(10, 10) = points3d_ocl.at<cv::Vec3f>(10, 10) = cv::Vec3f();
+  EXPECT_LE(cv::norm(points3d, points3d_ocl, cv::NORM_INF), 1e-5);
+}
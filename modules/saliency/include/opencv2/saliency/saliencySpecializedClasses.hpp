@@ -93,6 +93,16 @@ public:
     resImHeight = val;
   }
 
+  /** @brief Computes the saliency maps of many images, as computeSaliency does for each of them.
+
+    The images are processed in parallel and the buffers of the spectrum are shared by the images
+    processed by the same thread, which pays off for many small images such as thumbnails.
+    @param images the input images, 8-bit with one or three channels
+    @param saliencyMaps the CV_32F saliency maps, each of the size of its image
+    @return false if one of the images is empty, in which case no map is computed
+  */
+  bool computeSaliencyBatch( InputArrayOfArrays images, OutputArrayOfArrays saliencyMaps );
+
 protected:
   bool computeSaliencyImpl( InputArray image, OutputArray saliencyMap );
   int resImWidth;
@@ -166,6 +176,12 @@ private:
   bool templateOrdering();
   bool templateReplacement( const Mat& finalBFMask, const Mat& image );
 
+  // the rows of pixels (blocks of N rows for the low resolution) are independent, they are processed in parallel
+  void fullResolutionDetectionRows( const Mat& image, Mat& highResBFMask, const Range& rows );
+  void lowResolutionDetectionRows( const Mat& image, Mat& lowResBFMask, const Range& blockRows );
+  void templateOrderingRows( const Range& rows );
+  class BackgroundModelInvoker;
+
   // changing structure
   std::vector<Ptr<Mat> > backgroundModel;// The vector represents the background template T0---TK of reference paper.
   // Matrices are two-channel matrix. In the first layer there are the B (background value)
@@ -377,6 +393,9 @@ private:
     return n > 0 && _svmReW1f.size() == Size( 2, n ) && _svmFilter.size() == Size( _W, _W );
   }
   void predictBBoxSI( Mat &mag3u, ValStructVec<float, Vec4i> &valBoxes, std::vector<int> &sz, int NUM_WIN_PSZ = 100, bool fast = true );
+  // The boxes of stage I for the active size of index ir, the sizes are processed in parallel
+  void predictBBoxSIForSize( Mat &img3u, int ir, ValStructVec<float, Vec4i> &valBoxes, int NUM_WIN_PSZ, bool fast );
+  class PredictBBoxSIInvoker;
   void predictBBoxSII( ValStructVec<float, Vec4i> &valBoxes, const std::vector<int> &sz );
 
   // Calculate the image gradient: center option as in VLFeat
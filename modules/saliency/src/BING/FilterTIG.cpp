@@ -52,8 +52,9 @@ struct TIGbits
   TIGbits() : bc0(0), bc1(0) {}
   inline void accumulate(int64_t tig, int64_t tigMask0, int64_t tigMask1, uchar shift)
   {
-    bc0 += ((POPCNT64(tigMask0 & tig) << 1) - POPCNT64(tig)) << shift;
-    bc1 += ((POPCNT64(tigMask1 & tig) << 1) - POPCNT64(tig)) << shift;
+    int64_t bc = POPCNT64(tig);
+    bc0 += ((POPCNT64(tigMask0 & tig) << 1) - bc) << shift;
+    bc1 += ((POPCNT64(tigMask1 & tig) << 1) - bc) << shift;
   }
   int64_t bc0;
   int64_t bc1;
@@ -107,47 +108,39 @@ void ObjectnessBING::FilterTIG::reconstruct( Mat &w1f )
 
 // For a W by H gradient magnitude map, find a W-7 by H-7 CV_32F matching score map
 // Please refer to my paper for definition of the variables used in this function
+// Only the binary TIGs of the current and of the upper row are kept, the left column and the row above
+// the first one being 0 to avoid dealing with boundary conditions
 Mat ObjectnessBING::FilterTIG::matchTemplate( const Mat &mag1u )
 {
   const int H = mag1u.rows, W = mag1u.cols;
-  const Size sz( W + 1, H + 1 );  // Expand original size to avoid dealing with boundary conditions
-  Mat_<int64_t> Tig1 = Mat_<int64_t>::zeros( sz ), Tig2 = Mat_<int64_t>::zeros( sz );
-  Mat_<int64_t> Tig4 = Mat_<int64_t>::zeros( sz ), Tig8 = Mat_<int64_t>::zeros( sz );
-  Mat_<BYTE> Row1 = Mat_<BYTE>::zeros( sz ), Row2 = Mat_<BYTE>::zeros( sz );
-  Mat_<BYTE> Row4 = Mat_<BYTE>::zeros( sz ), Row8 = Mat_<BYTE>::zeros( sz );
-  Mat_<float> scores( sz );
+  CV_Assert( mag1u.type() == CV_8U && H >= 7 && W >= 7 );
+  Mat matchCost1f( H - 7, W - 7, CV_32F );
+  AutoBuffer<int64_t> tigBuf( 8 * ( W + 1 ) );
+  memset( (int64_t*) tigBuf, 0, 8 * ( W + 1 ) * sizeof(int64_t) );
+  int64_t *Tu = tigBuf, *T = Tu + 4 * ( W + 1 );  // Binary TIGs of upper and current row, 4 per pixel
   for ( int y = 1; y <= H; y++ )
   {
     const BYTE* G = mag1u.ptr<BYTE>( y - 1 );
-    int64_t* T1 = Tig1.ptr<int64_t>( y );  // Binary TIG of current row
-    int64_t* T2 = Tig2.ptr<int64_t>( y );
-    int64_t* T4 = Tig4.ptr<int64_t>( y );
-    int64_t* T8 = Tig8.ptr<int64_t>( y );
-    int64_t* Tu1 = Tig1.ptr<int64_t>( y - 1 );  // Binary TIG of upper row
-    int64_t* Tu2 = Tig2.ptr<int64_t>( y - 1 );
-    int64_t* Tu4 = Tig4.ptr<int64_t>( y - 1 );
-    int64_t* Tu8 = Tig8.ptr<int64_t>( y - 1 );
-    BYTE* R1 = Row1.ptr<BYTE>( y );
-    BYTE* R2 = Row2.ptr<BYTE>( y );
-    BYTE* R4 = Row4.ptr<BYTE>( y );
-    BYTE* R8 = Row8.ptr<BYTE>( y );
-    float *s = scores.ptr<float>( y );
+    float *s = y >= 8 ? matchCost1f.ptr<float>( y - 8 ) : 0;
+    BYTE R1 = 0, R2 = 0, R4 = 0, R8 = 0;  // Binary gradients of the last 8 pixels of the row
     for ( int x = 1; x <= W; x++ )
     {
       BYTE g = G[x - 1];
-      R1[x] = ( R1[x - 1] << 1 ) | ( ( g >> 4 ) & 1 );
-      R2[x] = ( R2[x - 1] << 1 ) | ( ( g >> 5 ) & 1 );
-      R4[x] = ( R4[x - 1] << 1 ) | ( ( g >> 6 ) & 1 );
-      R8[x] = ( R8[x - 1] << 1 ) | ( ( g >> 7 ) & 1 );
-      T1[x] = ( Tu1[x] << 8 ) | R1[x];
-      T2[x] = ( Tu2[x] << 8 ) | R2[x];
-      T4[x] = ( Tu4[x] << 8 ) | R4[x];
-      T8[x] = ( Tu8[x] << 8 ) | R8[x];
-      s[x] = dot( T1[x], T2[x], T4[x], T8[x] );
+      R1 = (BYTE) ( ( R1 << 1 ) | ( ( g >> 4 ) & 1 ) );
+      R2 = (BYTE) ( ( R2 << 1 ) | ( ( g >> 5 ) & 1 ) );
+      R4 = (BYTE) ( ( R4 << 1 ) | ( ( g >> 6 ) & 1 ) );
+      R8 = (BYTE) ( ( R8 << 1 ) | ( ( g >> 7 ) & 1 ) );
+      int64_t* t = T + 4 * x;
+      const int64_t* tu = Tu + 4 * x;
+      t[0] = ( tu[0] << 8 ) | R1;
+      t[1] = ( tu[1] << 8 ) | R2;
+      t[2] = ( tu[2] << 8 ) | R4;
+      t[3] = ( tu[3] << 8 ) | R8;
+      if( s && x >= 8 )
+        s[x - 8] = dot( t[0], t[1], t[2], t[3] );
     }
+    std::swap( T, Tu );
   }
-  Mat matchCost1f;
-  scores( Rect( 8, 8, W - 7, H - 7 ) ).copyTo( matchCost1f );
   return matchCost1f;
 }
 
@@ -124,47 +124,86 @@ int ObjectnessBING::loadTrainedModel( std::string modelName )  // Return -1, 0,
   return 1;
 }
 
+void ObjectnessBING::predictBBoxSIForSize( Mat &img3u, int ir, ValStructVec<float, Vec4i> &valBoxes, int NUM_WIN_PSZ, bool fast )
+{
+  const int imgW = img3u.cols, imgH = img3u.rows;
+  int r = _svmSzIdxs[ir];
+  int height = cvRound( pow( _base, r / _numT + _minT ) ), width = cvRound( pow( _base, r % _numT + _minT ) );
+  if( height > imgH * _base || width > imgW * _base )
+    return;
+
+  height = min( height, imgH ), width = min( width, imgW );
+  Mat im3u, matchCost1f, mag1u;
+  resize( img3u, im3u, Size( cvRound( _W * imgW * 1.0 / width ), cvRound( _W * imgH * 1.0 / height ) ) );
+  gradientMag( im3u, mag1u );
+
+  matchCost1f = _tigF.matchTemplate( mag1u );
+
+  ValStructVec<float, Point> matchCost;
+  nonMaxSup( matchCost1f, matchCost, _NSS, NUM_WIN_PSZ, fast );
+
+  // Find true locations and match values
+  double ratioX = width / _W, ratioY = height / _W;
+  int iMax = min( matchCost.size(), NUM_WIN_PSZ );
+  valBoxes.reserve( iMax );
+  for ( int i = 0; i < iMax; i++ )
+  {
+    float mVal = matchCost( i );
+    Point pnt = matchCost[i];
+    Vec4i box( cvRound( pnt.x * ratioX ), cvRound( pnt.y * ratioY ) );
+    box[2] = cvRound( min( box[0] + width, imgW ) );
+    box[3] = cvRound( min( box[1] + height, imgH ) );
+    box[0]++;
+    box[1]++;
+    valBoxes.pushBack( mVal, box );
+  }
+}
+
+// The sizes are independent, each of them is resized, filtered and suppressed on its own
+class ObjectnessBING::PredictBBoxSIInvoker : public ParallelLoopBody
+{
+public:
+  PredictBBoxSIInvoker( ObjectnessBING &_bing, Mat &_img3u, std::vector<ValStructVec<float, Vec4i> > &_sizeBoxes, int _NUM_WIN_PSZ, bool _fast ) :
+      bing( _bing ), img3u( _img3u ), sizeBoxes( _sizeBoxes ), NUM_WIN_PSZ( _NUM_WIN_PSZ ), fast( _fast )
+  {
+  }
+
+  void operator()( const Range &range ) const
+  {
+    for ( int ir = range.start; ir < range.end; ir++ )
+      bing.predictBBoxSIForSize( img3u, ir, sizeBoxes[ir], NUM_WIN_PSZ, fast );
+  }
+
+private:
+  ObjectnessBING &bing;
+  Mat &img3u;
+  std::vector<ValStructVec<float, Vec4i> > &sizeBoxes;
+  int NUM_WIN_PSZ;
+  bool fast;
+
+  PredictBBoxSIInvoker& operator=( const PredictBBoxSIInvoker& ); // to quiet MSVC
+};
+
 void ObjectnessBING::predictBBoxSI( Mat &img3u, ValStructVec<float, Vec4i> &valBoxes, std::vector<int> &sz, int NUM_WIN_PSZ, bool fast )
 {
   const int numSz = (int) _svmSzIdxs.size();
-  const int imgW = img3u.cols, imgH = img3u.rows;
   valBoxes.reserve( 10000 );
   sz.clear();
   sz.reserve( 10000 );
-  for ( int ir = numSz - 1; ir >= 0; ir-- )
-  {
-    int r = _svmSzIdxs[ir];
-    int height = cvRound( pow( _base, r / _numT + _minT ) ), width = cvRound( pow( _base, r % _numT + _minT ) );
-    if( height > imgH * _base || width > imgW * _base )
-      continue;
-
-    height = min( height, imgH ), width = min( width, imgW );
-    Mat im3u, matchCost1f, mag1u;
-    resize( img3u, im3u, Size( cvRound( _W * imgW * 1.0 / width ), cvRound( _W * imgH * 1.0 / height ) ) );
-    gradientMag( im3u, mag1u );
-
-    matchCost1f = _tigF.matchTemplate( mag1u );
 
-    ValStructVec<float, Point> matchCost;
-    nonMaxSup( matchCost1f, matchCost, _NSS, NUM_WIN_PSZ, fast );
+  std::vector<ValStructVec<float, Vec4i> > sizeBoxes( numSz );
+  parallel_for_( Range( 0, numSz ), PredictBBoxSIInvoker( *this, img3u, sizeBoxes, NUM_WIN_PSZ, fast ) );
 
-    // Find true locations and match values
-    double ratioX = width / _W, ratioY = height / _W;
-    int iMax = min( matchCost.size(), NUM_WIN_PSZ );
-    for ( int i = 0; i < iMax; i++ )
+  // the boxes are gathered in the order of the sequential version, from the last size to the first one
+  for ( int ir = numSz - 1; ir >= 0; ir-- )
+  {
+    const ValStructVec<float, Vec4i> &boxes = sizeBoxes[ir];
+    for ( int i = 0; i < boxes.size(); i++ )
     {
-      float mVal = matchCost( i );
-      Point pnt = matchCost[i];
-      Vec4i box( cvRound( pnt.x * ratioX ), cvRound( pnt.y * ratioY ) );
-      box[2] = cvRound( min( box[0] + width, imgW ) );
-      box[3] = cvRound( min( box[1] + height, imgH ) );
-      box[0]++;
-      box[1]++;
-      valBoxes.pushBack( mVal, box );
+      valBoxes.pushBack( boxes( i ), boxes[i] );
       sz.push_back( ir );
     }
   }
-
 }
 
 void ObjectnessBING::predictBBoxSII( ValStructVec<float, Vec4i> &valBoxes, const std::vector<int> &sz )
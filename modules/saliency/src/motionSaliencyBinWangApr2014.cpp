@@ -104,25 +104,67 @@ MotionSaliencyBinWangApr2014::~MotionSaliencyBinWangApr2014()
 
 }
 
-// classification (and adaptation) functions
-bool MotionSaliencyBinWangApr2014::fullResolutionDetection( const Mat& image2, Mat& highResBFMask )
+// The three passes of the model are independent per pixel (per block of pixels for the low resolution),
+// each stripe runs the sequential loop on its rows
+class MotionSaliencyBinWangApr2014::BackgroundModelInvoker : public ParallelLoopBody
 {
-  Mat image = image2.clone();
+public:
+  enum Pass
+  {
+    FULL_RESOLUTION,
+    LOW_RESOLUTION,
+    TEMPLATE_ORDERING
+  };
 
-  float currentPixelValue;
-  float currentEpslonValue;
-  bool backgFlag = false;
+  BackgroundModelInvoker( MotionSaliencyBinWangApr2014 &_saliency, Pass _pass, const Mat &_image, Mat &_mask ) :
+      saliency( _saliency ), pass( _pass ), image( _image ), mask( _mask )
+  {
+  }
+
+  void operator()( const Range &range ) const
+  {
+    if( pass == FULL_RESOLUTION )
+      saliency.fullResolutionDetectionRows( image, mask, range );
+    else if( pass == LOW_RESOLUTION )
+      saliency.lowResolutionDetectionRows( image, mask, range );
+    else
+      saliency.templateOrderingRows( range );
+  }
+
+private:
+  MotionSaliencyBinWangApr2014 &saliency;
+  Pass pass;
+  const Mat &image;
+  Mat &mask;
+
+  BackgroundModelInvoker& operator=( const BackgroundModelInvoker& ); // to quiet MSVC
+};
 
+// classification (and adaptation) functions
+bool MotionSaliencyBinWangApr2014::fullResolutionDetection( const Mat& image, Mat& highResBFMask )
+{
   // Initially, all pixels are considered as foreground and then we evaluate with the background model
   highResBFMask.create( image.rows, image.cols, CV_32F );
   highResBFMask.setTo( 1 );
 
-  uchar* pImage;
-  float* pEpslon;
+  parallel_for_( Range( 0, image.rows ), BackgroundModelInvoker( *this, BackgroundModelInvoker::FULL_RESOLUTION, image, highResBFMask ),
+                 image.total() / (double) ( 1 << 16 ) );
+
+  return true;
+}
+
+void MotionSaliencyBinWangApr2014::fullResolutionDetectionRows( const Mat& image, Mat& highResBFMask, const Range& rows )
+{
+  float currentPixelValue;
+  float currentEpslonValue;
+  bool backgFlag = false;
+
+  const uchar* pImage;
+  const float* pEpslon;
   float* pMask;
 
-  // Scan all pixels of image
-  for ( int i = 0; i < image.rows; i++ )
+  // Scan all pixels of the rows
+  for ( int i = rows.start; i < rows.end; i++ )
   {
 
     pImage = image.ptr<uchar>( i );
@@ -186,100 +228,77 @@ bool MotionSaliencyBinWangApr2014::fullResolutionDetection( const Mat& image2, M
 
     }
   }  // end "for" cicle of all image's pixels
-
-  return true;
 }
 
 bool MotionSaliencyBinWangApr2014::lowResolutionDetection( const Mat& image, Mat& lowResBFMask )
 {
-  std::vector<Mat> mv;
-  split( *backgroundModel[0], mv );
+  Mat C0;
+  extractChannel( *backgroundModel[0], C0, 1 );
+
+  // Initially, all pixels are considered as foreground and then we evaluate with the background model
+  lowResBFMask.create( image.rows, image.cols, CV_32F );
+  lowResBFMask.setTo( 1 );
 
   //if at least the first template is activated / initialized for all pixels
-  if( countNonZero( mv[1] ) > ( mv[1].cols * mv[1].rows ) / 2 )
+  if( countNonZero( C0 ) > ( C0.cols * C0.rows ) / 2 )
+  {
+    int blockRows = ( image.rows + N - 1 ) / N;
+    parallel_for_( Range( 0, blockRows ), BackgroundModelInvoker( *this, BackgroundModelInvoker::LOW_RESOLUTION, image, lowResBFMask ),
+                   image.total() / (double) ( 1 << 16 ) );
+    return true;
+  }
+  else
   {
-    float currentPixelValue;
-    float currentEpslonValue;
-    float currentB;
-    float currentC;
+    return false;
+  }
 
-    // Create a mask to select ROI in the original Image and Backgound model and at the same time compute the mean
+}
 
-    Rect roi( Point( 0, 0 ), Size( N, N ) );
-    Scalar imageROImean;
-    Scalar backGModelROImean;
-    Mat currentModel;
+void MotionSaliencyBinWangApr2014::lowResolutionDetectionRows( const Mat& image, Mat& lowResBFMask, const Range& blockRows )
+{
+  float currentPixelValue;
+  float currentEpslonValue;
+  float currentB;
+  float currentC;
 
-    // Initially, all pixels are considered as foreground and then we evaluate with the background model
-    lowResBFMask.create( image.rows, image.cols, CV_32F );
-    lowResBFMask.setTo( 1 );
+  // Scan the NxN blocks of original matrices, the last ones of a row or of a column are cut at the border
+  for ( int i = blockRows.start; i < blockRows.end; i++ )
+  {
+    int y = i * N;
+    int height = std::min( N, image.rows - y );
 
-    // Scan all the ROI of original matrices
-    for ( int i = 0; i < ceil( (float) image.rows / N ); i++ )
+    for ( int x = 0; x < image.cols; x += N )
     {
-      if( ( roi.y + ( N - 1 ) ) <= ( image.rows - 1 ) )
-      {
-        // Reset original ROI dimension
-        roi = Rect( Point( roi.x, roi.y ), Size( N, N ) );
-      }
+      Rect roi( x, y, std::min( N, image.cols - x ), height );
+
+      // Compute the mean of image's block and epslonMatrix's block based on ROI
+      Mat roiImage = image( roi );
+      Mat roiEpslon = epslonPixelsValue( roi );
+      currentPixelValue = (float) mean( roiImage ).val[0];
+      currentEpslonValue = (float) mean( roiEpslon ).val[0];
 
-      for ( int j = 0; j < ceil( (float) image.cols / N ); j++ )
+      // scan background model vector
+      for ( int z = 0; z < N_DS; z++ )
       {
-        // Compute the mean of image's block and epslonMatrix's block based on ROI
-        Mat roiImage = image( roi );
-        Mat roiEpslon = epslonPixelsValue( roi );
-        currentPixelValue = (float) mean( roiImage ).val[0];
-        currentEpslonValue = (float) mean( roiEpslon ).val[0];
+        // Select the current template 2 channel matrix, select ROI and compute the mean for each channel separately
+        Mat roiTemplate = ( * ( backgroundModel[z] ) )( roi );
+        Scalar templateMean = mean( roiTemplate );
+        currentB = (float) templateMean[0];
+        currentC = (float) templateMean[1];
 
-        // scan background model vector
-        for ( int z = 0; z < N_DS; z++ )
+        if( ( currentC ) > 0 )  //The current template is active
         {
-          // Select the current template 2 channel matrix, select ROI and compute the mean for each channel separately
-          Mat roiTemplate = ( * ( backgroundModel[z] ) )( roi );
-          Scalar templateMean = mean( roiTemplate );
-          currentB = (float) templateMean[0];
-          currentC = (float) templateMean[1];
-
-          if( ( currentC ) > 0 )  //The current template is active
+          // If there is a match with a current background template
+          if( abs( currentPixelValue - ( currentB ) ) < currentEpslonValue )
           {
-            // If there is a match with a current background template
-            if( abs( currentPixelValue - ( currentB ) ) < currentEpslonValue )
-            {
-              // The correspondence pixel in the  BF mask is set as background ( 0 value)
-              rectangle( lowResBFMask, roi, Scalar( 0 ), FILLED );
-              break;
-            }
+            // The correspondence pixels in the  BF mask are set as background ( 0 value)
+            lowResBFMask( roi ).setTo( Scalar( 0 ) );
+            break;
           }
         }
-        // Shift the ROI from left to right follow the block dimension
-        roi = roi + Point( N, 0 );
-        if( ( roi.x + ( roi.width - 1 ) ) > ( image.cols - 1 ) && ( roi.y + ( N - 1 ) ) <= ( image.rows - 1 ) )
-        {
-          roi = Rect( Point( roi.x, roi.y ), Size( abs( ( image.cols - 1 ) - roi.x ) + 1, N ) );
-        }
-        else if( ( roi.x + ( roi.width - 1 ) ) > ( image.cols - 1 ) && ( roi.y + ( N - 1 ) ) > ( image.rows - 1 ) )
-        {
-          roi = Rect( Point( roi.x, roi.y ), Size( abs( ( image.cols - 1 ) - roi.x ) + 1, abs( ( image.rows - 1 ) - roi.y ) + 1 ) );
-        }
-      }
-      //Shift the ROI from up to down follow the block dimension, also bringing it back to beginning of row
-      roi.x = 0;
-      roi.y += N;
-      if( ( roi.y + ( roi.height - 1 ) ) > ( image.rows - 1 ) )
-      {
-        roi = Rect( Point( roi.x, roi.y ), Size( N, abs( ( image.rows - 1 ) - roi.y ) + 1 ) );
       }
-
     }
-    return true;
-  }
-  else
-  {
-    lowResBFMask.create( image.rows, image.cols, CV_32F );
-    lowResBFMask.setTo( 1 );
-    return false;
   }
-
 }
 
 bool inline pairCompare( std::pair<float, float> t, std::pair<float, float> t_plusOne )
@@ -292,13 +311,23 @@ bool inline pairCompare( std::pair<float, float> t, std::pair<float, float> t_pl
 // Background model maintenance functions
 bool MotionSaliencyBinWangApr2014::templateOrdering()
 {
-  std::vector<std::pair<float, float> > pixelTemplates( backgroundModel.size() );
+  Mat dummy;
+  parallel_for_( Range( 0, backgroundModel[0]->rows ), BackgroundModelInvoker( *this, BackgroundModelInvoker::TEMPLATE_ORDERING, dummy, dummy ),
+                 backgroundModel[0]->total() / (double) ( 1 << 16 ) );
+
+  return true;
+}
+
+void MotionSaliencyBinWangApr2014::templateOrderingRows( const Range& rows )
+{
+  // only the templates T1...Tk are sorted
+  std::vector<std::pair<float, float> > pixelTemplates( backgroundModel.size() - 1 );
 
   Vec2f* bgModel_0P;
   Vec2f* bgModel_1P;
 
-// Scan all pixels of image
-  for ( int i = 0; i < backgroundModel[0]->rows; i++ )
+// Scan all pixels of the rows
+  for ( int i = rows.start; i < rows.end; i++ )
   {
     bgModel_0P = backgroundModel[0]->ptr<Vec2f>( i );
     bgModel_1P = backgroundModel[1]->ptr<Vec2f>( i );
@@ -338,16 +367,15 @@ bool MotionSaliencyBinWangApr2014::templateOrdering()
 
     }
   }
-
-  return true;
 }
+
 bool MotionSaliencyBinWangApr2014::templateReplacement( const Mat& finalBFMask, const Mat& image )
 {
-  std::vector<Mat> temp;
-  split( *backgroundModel[0], temp );
+  Mat C0;
+  extractChannel( *backgroundModel[0], C0, 1 );
 
 //if at least the first template is activated / initialized for all pixels
-  if( countNonZero( temp[1] ) <= ( temp[1].cols * temp[1].rows ) / 2 )
+  if( countNonZero( C0 ) <= ( C0.cols * C0.rows ) / 2 )
   {
     thetaA = 50;
     thetaL = 150;
@@ -361,25 +389,22 @@ bool MotionSaliencyBinWangApr2014::templateReplacement( const Mat& finalBFMask,
     neighborhoodCheck = true;
   }
 
-  int roiSize = 3;  // FIXED ROI SIZE, not change until you first appropriately adjust the following controls in the EVALUATION section!
-  int countNonZeroElements = 0;
-  std::vector<Mat> mv;
-  Mat replicateCurrentBAMat( roiSize, roiSize, CV_32F );
-  Mat backgroundModelROI( roiSize, roiSize, CV_32F );
-  Mat diffResult( roiSize, roiSize, CV_32F );
+  // This pass stays sequential: a replaced pixel of TK is seen by the neighborhood check of the next pixels
+  Mat& lastTemplate = *backgroundModel[backgroundModel.size() - 1];
+  int rows = finalBFMask.rows, cols = finalBFMask.cols;
 
 // Scan all pixels of finalBFMask and all pixels of others models (the dimension are the same)
   const float* finalBFMaskP;
   Vec2f* pbgP;
   const uchar* imageP;
-  float* epslonP;
-  for ( int i = 0; i < finalBFMask.rows; i++ )
+  const float* epslonP;
+  for ( int i = 0; i < rows; i++ )
   {
     finalBFMaskP = finalBFMask.ptr<float>( i );
     pbgP = potentialBackground.ptr<Vec2f>( i );
     imageP = image.ptr<uchar>( i );
     epslonP = epslonPixelsValue.ptr<float>( i );
-    for ( int j = 0; j < finalBFMask.cols; j++ )
+    for ( int j = 0; j < cols; j++ )
     {
       /////////////////// MAINTENANCE of potentialBackground model ///////////////////
       if( finalBFMaskP[j] == 1 )  // i.e. the corresponding frame pixel has been market as foreground
@@ -406,92 +431,43 @@ bool MotionSaliencyBinWangApr2014::templateReplacement( const Mat& finalBFMask,
         /////////////////// EVALUATION of potentialBackground values ///////////////////
         if( pbgP[j][1] > thetaA )
         {
+          bool replace = true;
           if( neighborhoodCheck )
           {
-            // replicate currentBA value
-            replicateCurrentBAMat.setTo( pbgP[j][0] );
-
-            for ( size_t z = 0; z < backgroundModel.size(); z++ )
+            /* Check if the value of current pixel BA in potentialBackground model is already contained in at least one of its neighbors'
+             * background model. The 3x3 neighborhood is centered in the pixel coordinates and cut at the image border.
+             * As with the threshold of the absolute difference, a NaN B (not initialized template) counts as contained.
+             */
+            float currentBA = pbgP[j][0];
+            float currentEpslon = epslonP[j];
+            int y0 = std::max( i - 1, 0 ), y1 = std::min( i + 1, rows - 1 );
+            int x0 = std::max( j - 1, 0 ), x1 = std::min( j + 1, cols - 1 );
+
+            replace = false;
+            for ( size_t z = 0; z < backgroundModel.size() && !replace; z++ )
             {
-              // Neighborhood of current pixel in the current background model template.
-              // The ROI is centered in the pixel coordinates
-
-              if( i > 0 && j > 0 && i < ( backgroundModel[z]->rows - 1 ) && j < ( backgroundModel[z]->cols - 1 ) )
+              for ( int y = y0; y <= y1 && !replace; y++ )
               {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), roiSize, roiSize ) );
-              }
-              else if( i == 0 && j == 0 )  // upper leftt
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j, i, (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( j == 0 && i > 0 && i < ( backgroundModel[z]->rows - 1 ) )  // middle left
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j, i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), roiSize ) );
-              }
-              else if( i == ( backgroundModel[z]->rows - 1 ) && j == 0 )  //down left
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j, i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( i == 0 && j > 0 && j < ( backgroundModel[z]->cols - 1 ) )  // upper - middle
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( ( j - (int) floor((float) roiSize / 2 ) ), i, roiSize, (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( i == ( backgroundModel[z]->rows - 1 ) && j > 0 && j < ( backgroundModel[z]->cols - 1 ) )  //down middle
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0](
-                    Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), roiSize, (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( i == 0 && j == ( backgroundModel[z]->cols - 1 ) )  // upper right
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j - (int) floor((float) roiSize / 2 ), i, (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( j == ( backgroundModel[z]->cols - 1 ) && i > 0 && i < ( backgroundModel[z]->rows - 1 ) )  // middle - right
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0](
-                    Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), roiSize ) );
-              }
-              else if( i == ( backgroundModel[z]->rows - 1 ) && j == ( backgroundModel[z]->cols - 1 ) )  // down right
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0](
-                    Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
-              }
-
-              /* Check if the value of current pixel BA in potentialBackground model is already contained in at least one of its neighbors'
-               * background model
-               */
-              resize( replicateCurrentBAMat, replicateCurrentBAMat, Size( backgroundModelROI.cols, backgroundModelROI.rows ), 0, 0, INTER_LINEAR );
-              resize( diffResult, diffResult, Size( backgroundModelROI.cols, backgroundModelROI.rows ), 0, 0, INTER_LINEAR );
-
-              absdiff( replicateCurrentBAMat, backgroundModelROI, diffResult );
-              threshold( diffResult, diffResult, epslonP[j], 255, THRESH_BINARY_INV );
-              countNonZeroElements = countNonZero( diffResult );
-
-              if( countNonZeroElements > 0 )
-              {
-                /////////////////// REPLACEMENT of backgroundModel template ///////////////////
-                //replace TA with current TK
-                backgroundModel[backgroundModel.size() - 1]->at<Vec2f>( i, j ) = potentialBackground.at<Vec2f>( i, j );
-                potentialBackground.at<Vec2f>( i, j )[0] = std::numeric_limits<float>::quiet_NaN();
-                potentialBackground.at<Vec2f>( i, j )[1] = 0;
-
-                break;
+                const Vec2f* bgModel_zP = backgroundModel[z]->ptr<Vec2f>( y );
+                for ( int x = x0; x <= x1; x++ )
+                {
+                  if( !( abs( currentBA - bgModel_zP[x][0] ) > currentEpslon ) )
+                  {
+                    replace = true;
+                    break;
+                  }
+                }
               }
             }  // end for backgroundModel size
           }
-          else
+
+          if( replace )
           {
-            backgroundModel[backgroundModel.size() - 1]->at<Vec2f>( i, j ) = potentialBackground.at<Vec2f>( i, j );
-            potentialBackground.at<Vec2f>( i, j )[0] = std::numeric_limits<float>::quiet_NaN();
-            potentialBackground.at<Vec2f>( i, j )[1] = 0;
+            /////////////////// REPLACEMENT of backgroundModel template ///////////////////
+            //replace TA with current TK
+            lastTemplate.at<Vec2f>( i, j ) = pbgP[j];
+            pbgP[j][0] = std::numeric_limits<float>::quiet_NaN();
+            pbgP[j][1] = 0;
           }
         }  // close if of EVALUATION
       }  // end of  if( finalBFMask.at<uchar>( i, j ) == 1 )  // i.e. the corresponding frame pixel has been market as foreground
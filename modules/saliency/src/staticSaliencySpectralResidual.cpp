@@ -73,64 +73,89 @@ void StaticSaliencySpectralResidual::write( cv::FileStorage& /*fs*/) const
   //params.write( fs );
 }
 
-bool StaticSaliencySpectralResidual::computeSaliencyImpl( InputArray image, OutputArray saliencyMap )
+// The buffers of the spectral residual of one image, sized once for resImWidth x resImHeight
+struct SpectralResidualBuffers
 {
   Mat grayTemp, grayDown;
-  std::vector<Mat> mv;
-  Size resizedImageSize( resImWidth, resImHeight );
-
-  Mat realImage( resizedImageSize, CV_64F );
-  Mat imaginaryImage( resizedImageSize, CV_64F );
-  imaginaryImage.setTo( 0 );
-  Mat combinedImage( resizedImageSize, CV_64FC2 );
-  Mat imageDFT;
-  Mat logAmplitude;
-  Mat angle( resizedImageSize, CV_64F );
-  Mat magnitude( resizedImageSize, CV_64F );
-  Mat logAmplitude_blur, imageGR;
+  Mat realImage;
+  Mat imageDFT, imageIDFT;  // complex spectrum and back transform
+  Mat magnitude;
+  Mat logAmplitude, logAmplitude_blur;
+};
+
+static void computeSpectralResidual( const Mat& image, Size resizedImageSize, SpectralResidualBuffers& buf, Mat& saliencyMap )
+{
+  int rows = resizedImageSize.height, cols = resizedImageSize.width;
 
   if( image.channels() == 3 )
   {
-    cvtColor( image, imageGR, COLOR_BGR2GRAY );
-    resize( imageGR, grayDown, resizedImageSize, 0, 0, INTER_LINEAR );
+    cvtColor( image, buf.grayTemp, COLOR_BGR2GRAY );
+    resize( buf.grayTemp, buf.grayDown, resizedImageSize, 0, 0, INTER_LINEAR );
   }
   else
   {
-    resize( image, grayDown, resizedImageSize, 0, 0, INTER_LINEAR );
+    resize( image, buf.grayDown, resizedImageSize, 0, 0, INTER_LINEAR );
   }
 
-  grayDown.convertTo( realImage, CV_64F );
+  // the imaginary part of the image being zero, its full complex spectrum is the one of the real image
+  buf.grayDown.convertTo( buf.realImage, CV_64F );
+  dft( buf.realImage, buf.imageDFT, DFT_COMPLEX_OUTPUT );
 
-  mv.push_back( realImage );
-  mv.push_back( imaginaryImage );
-  merge( mv, combinedImage );
-  dft( combinedImage, imageDFT );
-  split( imageDFT, mv );
-
-  //-- Get magnitude and phase of frequency spectrum --//
-  cartToPolar( mv.at( 0 ), mv.at( 1 ), magnitude, angle, false );
-  log( magnitude, logAmplitude );
+  //-- Get magnitude and phase of frequency spectrum in a single pass, the phase is kept as the unit complex number --//
+  buf.magnitude.create( resizedImageSize, CV_64F );
+  for ( int i = 0; i < rows; i++ )
+  {
+    Vec2d* F = buf.imageDFT.ptr<Vec2d>( i );
+    double* mag = buf.magnitude.ptr<double>( i );
+    for ( int j = 0; j < cols; j++ )
+    {
+      double m = std::sqrt( F[j][0] * F[j][0] + F[j][1] * F[j][1] );
+      mag[j] = m;
+      // a null coefficient has the zero angle
+      F[j] = m > 0 ? Vec2d( F[j][0] / m, F[j][1] / m ) : Vec2d( 1, 0 );
+    }
+  }
+  log( buf.magnitude, buf.logAmplitude );
   //-- Blur log amplitude with averaging filter --//
-  blur( logAmplitude, logAmplitude_blur, Size( 3, 3 ), Point( -1, -1 ), BORDER_DEFAULT );
+  blur( buf.logAmplitude, buf.logAmplitude_blur, Size( 3, 3 ), Point( -1, -1 ), BORDER_DEFAULT );
 
-  exp( logAmplitude - logAmplitude_blur, magnitude );
+  subtract( buf.logAmplitude, buf.logAmplitude_blur, buf.logAmplitude );
+  exp( buf.logAmplitude, buf.magnitude );
   //-- Back to cartesian frequency domain --//
-  polarToCart( magnitude, angle, mv.at( 0 ), mv.at( 1 ), false );
-  merge( mv, imageDFT );
-  dft( imageDFT, combinedImage, DFT_INVERSE );
-  split( combinedImage, mv );
+  for ( int i = 0; i < rows; i++ )
+  {
+    Vec2d* F = buf.imageDFT.ptr<Vec2d>( i );
+    const double* mag = buf.magnitude.ptr<double>( i );
+    for ( int j = 0; j < cols; j++ )
+      F[j] *= mag[j];
+  }
+  dft( buf.imageDFT, buf.imageIDFT, DFT_INVERSE );
 
-  cartToPolar( mv.at( 0 ), mv.at( 1 ), magnitude, angle, false );
-  GaussianBlur( magnitude, magnitude, Size( 5, 5 ), 8, 0, BORDER_DEFAULT );
-  magnitude = magnitude.mul( magnitude );
+  // magnitude of the back transform
+  for ( int i = 0; i < rows; i++ )
+  {
+    const Vec2d* f = buf.imageIDFT.ptr<Vec2d>( i );
+    double* mag = buf.magnitude.ptr<double>( i );
+    for ( int j = 0; j < cols; j++ )
+      mag[j] = std::sqrt( f[j][0] * f[j][0] + f[j][1] * f[j][1] );
+  }
+  GaussianBlur( buf.magnitude, buf.magnitude, Size( 5, 5 ), 8, 0, BORDER_DEFAULT );
+  multiply( buf.magnitude, buf.magnitude, buf.magnitude );
 
   double minVal, maxVal;
-  minMaxLoc( magnitude, &minVal, &maxVal );
+  minMaxLoc( buf.magnitude, &minVal, &maxVal );
+
+  buf.magnitude.convertTo( buf.logAmplitude, CV_32F, 1. / maxVal );
 
-  magnitude = magnitude / maxVal;
-  magnitude.convertTo( magnitude, CV_32F );
+  resize( buf.logAmplitude, saliencyMap, image.size(), 0, 0, INTER_LINEAR );
+}
 
-  resize( magnitude, saliencyMap, image.size(), 0, 0, INTER_LINEAR );
+bool StaticSaliencySpectralResidual::computeSaliencyImpl( InputArray image, OutputArray saliencyMap )
+{
+  SpectralResidualBuffers buf;
+  saliencyMap.create( image.size(), CV_32F );
+  Mat map = saliencyMap.getMat();
+  computeSpectralResidual( image.getMat(), Size( resImWidth, resImHeight ), buf, map );
 
 #ifdef SALIENCY_DEBUG
   // visualize saliency map
@@ -141,5 +166,53 @@ bool StaticSaliencySpectralResidual::computeSaliencyImpl( InputArray image, Outp
 
 }
 
+// The images are independent, the buffers are those of the thread
+class SpectralResidualBatchInvoker : public ParallelLoopBody
+{
+public:
+  SpectralResidualBatchInvoker( const std::vector<Mat> &_images, std::vector<Mat> &_maps, Size _resizedImageSize ) :
+      images( _images ), maps( _maps ), resizedImageSize( _resizedImageSize )
+  {
+  }
+
+  void operator()( const Range &range ) const
+  {
+    SpectralResidualBuffers& buf = buffers.getRef();
+    for ( int i = range.start; i < range.end; i++ )
+      computeSpectralResidual( images[i], resizedImageSize, buf, maps[i] );
+  }
+
+private:
+  const std::vector<Mat> &images;
+  std::vector<Mat> &maps;
+  Size resizedImageSize;
+  mutable TLSData<SpectralResidualBuffers> buffers;
+
+  SpectralResidualBatchInvoker& operator=( const SpectralResidualBatchInvoker& ); // to quiet MSVC
+};
+
+bool StaticSaliencySpectralResidual::computeSaliencyBatch( InputArrayOfArrays _images, OutputArrayOfArrays _saliencyMaps )
+{
+  int n = (int) _images.total();
+  std::vector<Mat> images( n ), maps( n );
+  for ( int i = 0; i < n; i++ )
+  {
+    images[i] = _images.getMat( i );
+    if( images[i].empty() )
+      return false;
+  }
+
+  _saliencyMaps.create( n, 1, CV_32F, -1, true );
+  for ( int i = 0; i < n; i++ )
+  {
+    _saliencyMaps.create( images[i].size(), CV_32F, i, true );
+    maps[i] = _saliencyMaps.getMat( i );
+  }
+
+  parallel_for_( Range( 0, n ), SpectralResidualBatchInvoker( images, maps, Size( resImWidth, resImHeight ) ) );
+
+  return true;
+}
+
 } /* namespace saliency */
 }/* namespace cv */
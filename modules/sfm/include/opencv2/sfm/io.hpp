@@ -59,7 +59,8 @@ enum {
   SFM_IO_VISUALSFM = 1,
   SFM_IO_OPENSFM = 2,
   SFM_IO_OPENMVG = 3,
-  SFM_IO_THEIASFM = 4
+  SFM_IO_THEIASFM = 4,
+  SFM_IO_BINARY = 5
 };
 
 /** @brief Import a reconstruction file.
@@ -70,7 +71,8 @@ enum {
   @param points3d Output array with 3d points. Is 3 x N.
   @param file_format The format of the file to import.
 
-  The function supports reconstructions from Bundler.
+  The function supports reconstructions from Bundler and the binary files written by
+  exportReconstruction.
 */
 CV_EXPORTS_W
 void
@@ -78,6 +80,23 @@ importReconstruction(const cv::String &file, OutputArrayOfArrays Rs,
                      OutputArrayOfArrays Ts, OutputArrayOfArrays Ks,
                      OutputArray points3d, int file_format = SFM_IO_BUNDLER);
 
+/** @brief Export a reconstruction file.
+  @param file The path to the file.
+  @param Rs Input vector of 3x3 rotations of the camera.
+  @param Ts Input vector of 3x1 translations of the camera.
+  @param Ks Input vector of 3x3 instrinsics of the camera, or a single one shared by all the cameras.
+  @param points3d Input array with 3d points. Is 3 x N.
+  @param file_format The format of the file to export.
+
+  The function supports the SFM_IO_BINARY format, which stores the reconstruction as doubles
+  so that it is saved and loaded again with importReconstruction without any parsing.
+*/
+CV_EXPORTS_W
+void
+exportReconstruction(const cv::String &file, InputArrayOfArrays Rs,
+                     InputArrayOfArrays Ts, InputArrayOfArrays Ks,
+                     InputArray points3d, int file_format = SFM_IO_BINARY);
+
 //! @} sfm
 
 } /* namespace sfm */
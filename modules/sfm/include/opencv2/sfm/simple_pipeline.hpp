@@ -130,6 +130,8 @@ enum { SFM_REFINE_FOCAL_LENGTH         = (1 << 0),  // libmv::BUNDLE_FOCAL_LENGT
   @param _refine_intrinsics camera parameter or combination of parameters to refine.
   @param _select_keyframes allows to select automatically the initial keyframes. If 1 then autoselection is enabled. If 0 then is disabled.
   @param _verbosity_level verbosity logs level for Glog. If -1 then logs are disabled, otherwise the log level will be the input integer.
+  @param _num_threads number of threads used to intersect the tracks, resect the views and run the bundle adjustment. If -1 then cv::getNumThreads() threads are used.
+  @param _keyframes_window number of keyframes refined by the local bundle adjustment of SFMLibmvEuclideanReconstruction::addFrame.
  */
 class CV_EXPORTS_W_SIMPLE libmv_ReconstructionOptions
 {
@@ -139,16 +141,22 @@ public:
                               const int _keyframe2=2,
                               const int _refine_intrinsics=1,
                               const int _select_keyframes=1,
-                              const int _verbosity_level=-1)
+                              const int _verbosity_level=-1,
+                              const int _num_threads=-1,
+                              const int _keyframes_window=10)
     : keyframe1(_keyframe1), keyframe2(_keyframe2),
       refine_intrinsics(_refine_intrinsics),
       select_keyframes(_select_keyframes),
-      verbosity_level(_verbosity_level) {}
+      verbosity_level(_verbosity_level),
+      num_threads(_num_threads),
+      keyframes_window(_keyframes_window) {}
 
   CV_PROP_RW int keyframe1, keyframe2;
   CV_PROP_RW int refine_intrinsics;
   CV_PROP_RW int select_keyframes;
   CV_PROP_RW int verbosity_level;
+  CV_PROP_RW int num_threads;
+  CV_PROP_RW int keyframes_window;
 };
 
 
@@ -235,6 +243,21 @@ public:
   virtual void run(const std::vector<std::string> &images, InputOutputArray K, OutputArray Rs,
                    OutputArray Ts, OutputArray points3d) = 0;
 
+  /** @brief Adds a frame to the reconstruction without solving it again from scratch.
+    @param points2d Input 2xN array with the 2d points of the frame, the column i being the point of the track i.
+      Points with non positive coordinates are not visible in the frame, as in run().
+
+    The frame is resected against the 3d points already estimated, the tracks it sees for the first time are
+    triangulated and a bundle adjustment refines the last keyframes, selected with the GRIC criterion. So the
+    time spent per frame doesn't grow with the total number of frames. The frames follow the ones given to run(),
+    if any; until there is an initial reconstruction, the frames given so far are solved again as a batch.
+
+    @note
+      - After a frame is added, getError() returns the reprojection error of the keyframes window.
+  */
+  CV_WRAP
+  virtual void addFrame(InputArray points2d) = 0;
+
   /** @brief Returns the computed reprojection error.
   */
   CV_WRAP
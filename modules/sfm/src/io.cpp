@@ -41,6 +41,7 @@
 
 #include <opencv2/sfm/io.hpp>
 #include "io/io_bundler.h"
+#include "io/io_binary.h"
 
 namespace cv
 {
@@ -65,8 +66,10 @@ importReconstruction(const cv::String &file, OutputArrayOfArrays _Rs,
         CV_Error(Error::StsNotImplemented, "The requested function/feature is not implemented");
     } else if (file_format == SFM_IO_THEIASFM) {
         CV_Error(Error::StsNotImplemented, "The requested function/feature is not implemented");
+    } else if (file_format == SFM_IO_BINARY) {
+        readBinaryFile(file, Rs, Ts, Ks, points3d);
     } else {
-        CV_Error(Error::StsBadArg, "The file format one of SFM_IO_BUNDLER, SFM_IO_VISUALSFM, SFM_IO_OPENSFM, SFM_IO_OPENMVG or SFM_IO_THEIASFM");
+        CV_Error(Error::StsBadArg, "The file format one of SFM_IO_BUNDLER, SFM_IO_VISUALSFM, SFM_IO_OPENSFM, SFM_IO_OPENMVG, SFM_IO_THEIASFM or SFM_IO_BINARY");
     }
 
     const size_t num_cameras = Rs.size();
@@ -87,6 +90,69 @@ importReconstruction(const cv::String &file, OutputArrayOfArrays _Rs,
         Mat(points3d[i]).copyTo(_points3d.getMatRef(i));
 }
 
+/* Copies the doubles of a 3x3 or 3x1 matrix.
+ */
+
+static void
+copyValues(const Mat &src, double *dst, int n)
+{
+    CV_Assert(src.total()*src.channels() == (size_t)n);
+    Mat_<double> values;
+    src.convertTo(values, CV_64F);
+    values = values.reshape(1, n);
+    for (int i = 0; i < n; ++i)
+        dst[i] = values(i);
+}
+
+void
+exportReconstruction(const cv::String &file, InputArrayOfArrays _Rs,
+                     InputArrayOfArrays _Ts, InputArrayOfArrays _Ks,
+                     InputArray _points3d, int file_format) {
+
+    std::vector<Mat> Rs_, Ts_, Ks_;
+    _Rs.getMatVector(Rs_);
+    _Ts.getMatVector(Ts_);
+    if (_Ks.kind() == _InputArray::STD_VECTOR_MAT)
+        _Ks.getMatVector(Ks_);
+    else
+        Ks_.assign(Rs_.size(), _Ks.getMat());
+    CV_Assert(Rs_.size() == Ts_.size() && Rs_.size() == Ks_.size());
+
+    const size_t num_cameras = Rs_.size();
+    std::vector<Matx33d> Rs(num_cameras), Ks(num_cameras);
+    std::vector<Vec3d> Ts(num_cameras), points3d;
+
+    for (size_t i = 0; i < num_cameras; ++i) {
+        copyValues(Rs_[i], Rs[i].val, 9);
+        copyValues(Ts_[i], Ts[i].val, 3);
+        copyValues(Ks_[i], Ks[i].val, 9);
+    }
+
+    if (_points3d.kind() == _InputArray::STD_VECTOR_MAT) {
+        std::vector<Mat> points;
+        _points3d.getMatVector(points);
+        points3d.resize(points.size());
+        for (size_t i = 0; i < points.size(); ++i)
+            copyValues(points[i], points3d[i].val, 3);
+    } else if (!_points3d.empty()) {
+        // One point per row
+        Mat points = _points3d.getMat();
+        if (points.channels() == 3)
+            points = points.reshape(1, (int)points.total());
+        else if (points.rows == 3)
+            points = points.t();
+        CV_Assert(points.cols == 3);
+        points3d.resize(points.rows);
+        for (int i = 0; i < points.rows; ++i)
+            copyValues(points.row(i), points3d[i].val, 3);
+    }
+
+    if (file_format == SFM_IO_BINARY) {
+        writeBinaryFile(file, Rs, Ts, Ks, points3d);
+    } else {
+        CV_Error(Error::StsNotImplemented, "The reconstructions can only be exported to SFM_IO_BINARY files");
+    }
+}
 
 } /* namespace sfm */
 } /* namespace cv */
\ No newline at end of file
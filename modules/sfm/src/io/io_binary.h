@@ -0,0 +1,111 @@
+/*
+ Binary reconstruction files, to save a reconstruction and resume from it
+ without parsing text.
+
+ The file starts with a header (magic, version, byte order, number of cameras
+ and of points), followed by the intrinsics, rotation and translation of every
+ camera and then by the 3d points, all of them as doubles.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <opencv2/core.hpp>
+
+namespace
+{
+
+struct BinaryReconstructionHeader
+{
+  char magic[8];
+  int version;
+  unsigned int byte_order;
+  int num_cameras;
+  int num_points;
+};
+
+const char BINARY_RECONSTRUCTION_MAGIC[8] = { 'C', 'V', 'S', 'F', 'M', 'R', 'E', 'C' };
+const int BINARY_RECONSTRUCTION_VERSION = 1;
+const unsigned int BINARY_RECONSTRUCTION_BYTE_ORDER = 0x01020304;
+
+// closes the file when the reading or the writing fails
+struct BinaryFileCloser
+{
+  BinaryFileCloser(FILE* _file) : file(_file) {}
+  ~BinaryFileCloser() { fclose(file); }
+  FILE* file;
+};
+
+}
+
+void writeBinaryFile(const std::string &file,
+                     const std::vector<cv::Matx33d> &Rs,
+                     const std::vector<cv::Vec3d> &Ts,
+                     const std::vector<cv::Matx33d> &Ks,
+                     const std::vector<cv::Vec3d> &points3d) {
+
+  CV_Assert(Rs.size() == Ts.size() && Rs.size() == Ks.size());
+
+  FILE* f = fopen(file.c_str(), "wb");
+  if (!f)
+    CV_Error(cv::Error::StsError, "File can't be opened for writing!");
+  BinaryFileCloser closer(f);
+
+  BinaryReconstructionHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, BINARY_RECONSTRUCTION_MAGIC, sizeof(header.magic));
+  header.version = BINARY_RECONSTRUCTION_VERSION;
+  header.byte_order = BINARY_RECONSTRUCTION_BYTE_ORDER;
+  header.num_cameras = (int)Rs.size();
+  header.num_points = (int)points3d.size();
+
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+  for (size_t i = 0; ok && i < Rs.size(); ++i) {
+    ok = fwrite(Ks[i].val, sizeof(double), 9, f) == 9 &&
+         fwrite(Rs[i].val, sizeof(double), 9, f) == 9 &&
+         fwrite(Ts[i].val, sizeof(double), 3, f) == 3;
+  }
+  if (ok && !points3d.empty())
+    ok = fwrite(&points3d[0], sizeof(cv::Vec3d), points3d.size(), f) == points3d.size();
+  if (!ok)
+    CV_Error(cv::Error::StsError, "Can't write to the reconstruction file!");
+}
+
+bool readBinaryFile(const std::string &file,
+                    std::vector<cv::Matx33d> &Rs,
+                    std::vector<cv::Vec3d> &Ts,
+                    std::vector<cv::Matx33d> &Ks,
+                    std::vector<cv::Vec3d> &points3d) {
+
+  FILE* f = fopen(file.c_str(), "rb");
+  if (!f)
+    CV_Error(cv::Error::StsError, "File can't be opened for reading!");
+  BinaryFileCloser closer(f);
+
+  BinaryReconstructionHeader header;
+  if (fread(&header, sizeof(header), 1, f) != 1 ||
+      memcmp(header.magic, BINARY_RECONSTRUCTION_MAGIC, sizeof(header.magic)) != 0)
+    CV_Error(cv::Error::StsError, "The file is not a binary reconstruction!");
+  if (header.version != BINARY_RECONSTRUCTION_VERSION)
+    CV_Error(cv::Error::StsError, cv::format("Unsupported version %d of the binary reconstruction format.", header.version));
+  if (header.byte_order != BINARY_RECONSTRUCTION_BYTE_ORDER)
+    CV_Error(cv::Error::StsError, "The binary reconstruction was written on a machine with a different byte order.");
+  CV_Assert(header.num_cameras >= 0 && header.num_points >= 0);
+
+  Rs.resize(header.num_cameras);
+  Ts.resize(header.num_cameras);
+  Ks.resize(header.num_cameras);
+  points3d.resize(header.num_points);
+
+  bool ok = true;
+  for (int i = 0; ok && i < header.num_cameras; ++i) {
+    ok = fread(Ks[i].val, sizeof(double), 9, f) == 9 &&
+         fread(Rs[i].val, sizeof(double), 9, f) == 9 &&
+         fread(Ts[i].val, sizeof(double), 3, f) == 3;
+  }
+  if (ok && header.num_points > 0)
+    ok = fread(&points3d[0], sizeof(cv::Vec3d), points3d.size(), f) == points3d.size();
+  if (!ok)
+    CV_Error(cv::Error::StsError, "The binary reconstruction file is truncated!");
+
+  return true;
+}
@@ -42,6 +42,9 @@
 #ifndef __OPENCV_SFM_LIBMV_CAPI__
 #define __OPENCV_SFM_LIBMV_CAPI__
 
+#include <deque>
+#include <map>
+
 #include "libmv/logging/logging.h"
 
 #include "libmv/correspondence/feature.h"
@@ -53,8 +56,10 @@
 #include "libmv/simple_pipeline/camera_intrinsics.h"
 #include "libmv/simple_pipeline/keyframe_selection.h"
 #include "libmv/simple_pipeline/initialize_reconstruction.h"
+#include "libmv/simple_pipeline/intersect.h"
 #include "libmv/simple_pipeline/pipeline.h"
 #include "libmv/simple_pipeline/reconstruction_scale.h"
+#include "libmv/simple_pipeline/resect.h"
 #include "libmv/simple_pipeline/tracks.h"
 #include "gflags/gflags.h"
 
@@ -80,6 +85,26 @@ struct libmv_Reconstruction {
   bool is_valid;
 };
 
+/* A frame of the sliding window of an incremental reconstruction */
+struct libmv_WindowFrame {
+  int image;
+  libmv::vector<Marker> markers;
+  /* The markers with the camera intrinsics inverted */
+  libmv::vector<Marker> normalized_markers;
+};
+
+/* State of a reconstruction that is extended one frame at a time */
+struct libmv_IncrementalReconstruction {
+  libmv_IncrementalReconstruction() : num_frames(0) {}
+
+  /* Number of frames given so far, which is the image of the next frame */
+  int num_frames;
+  /* Markers of all the frames while there is no initial reconstruction */
+  libmv::vector<Marker> initial_markers;
+  /* Keyframes of the local bundle adjustment, the oldest first */
+  std::deque<libmv_WindowFrame> keyframes;
+};
+
 
 //////////////////////////////////////
 // Based on 'libmv_capi' (blender API)
@@ -304,7 +329,8 @@ void libmv_solveRefineIntrinsics(
     const int refine_intrinsics,
     const int bundle_constraints,
     EuclideanReconstruction* reconstruction,
-    CameraIntrinsics* intrinsics) {
+    CameraIntrinsics* intrinsics,
+    const int num_threads) {
   /* only a few combinations are supported but trust the caller/ */
   int bundle_intrinsics = 0;
 
@@ -325,7 +351,9 @@ void libmv_solveRefineIntrinsics(
                                   bundle_intrinsics,
                                   bundle_constraints,
                                   reconstruction,
-                                  intrinsics);
+                                  intrinsics,
+                                  NULL,
+                                  num_threads);
 }
 
 
@@ -351,6 +379,20 @@ void finishReconstruction(
 }
 
 
+//////////////////////////////////////////////
+// Number of threads of the reconstruction
+//////////////////////////////////////////////
+
+/* Number of threads of the reconstruction given its options
+ */
+
+int libmv_reconstructionNumThreads(
+    const libmv_ReconstructionOptions* libmv_reconstruction_options) {
+  return libmv_reconstruction_options->num_threads > 0 ?
+    libmv_reconstruction_options->num_threads : cv::getNumThreads();
+}
+
+
 ////////////////////////////////////////////////////////////////////////////////////////
 // Based on the 'libmv_solveReconstruction()' function from 'libmv_capi' (blender API)
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -410,11 +452,16 @@ libmv_Reconstruction *libmv_solveReconstruction(
     return libmv_reconstruction;
   }
 
+  /* Threads of the intersections, resections and bundle adjustments. */
+  const int num_threads = libmv_reconstructionNumThreads(libmv_reconstruction_options);
+  LG << "number of threads: " << num_threads;
+
   EuclideanReconstructTwoFrames(keyframe_markers, &reconstruction);
-  EuclideanBundle(normalized_tracks, &reconstruction);
+  EuclideanBundle(normalized_tracks, &reconstruction, num_threads);
   EuclideanCompleteReconstruction(normalized_tracks,
                                   &reconstruction,
-                                  NULL);
+                                  NULL,
+                                  num_threads);
 
   /* Refinement/ */
   if (libmv_reconstruction_options->refine_intrinsics) {
@@ -423,7 +470,8 @@ libmv_Reconstruction *libmv_solveReconstruction(
                                 libmv_reconstruction_options->refine_intrinsics,
                                 libmv::BUNDLE_NO_CONSTRAINTS,
                                 &reconstruction,
-                                camera_intrinsics);
+                                camera_intrinsics,
+                                num_threads);
   }
 
   /* Set reconstruction scale to unity. */
@@ -437,4 +485,219 @@ libmv_Reconstruction *libmv_solveReconstruction(
   return (libmv_Reconstruction *) libmv_reconstruction;
 }
 
+
+////////////////////////////////////////////////////////////////////////////////////////
+// Incremental reconstruction
+////////////////////////////////////////////////////////////////////////////////////////
+
+/* Fills a window frame with the given markers and their normalized version
+ */
+
+void libmv_fillWindowFrame(
+    int image,
+    const libmv::vector<Marker> &markers,
+    const CameraIntrinsics &camera_intrinsics,
+    libmv_WindowFrame *frame) {
+  frame->image = image;
+  frame->markers = markers;
+  frame->normalized_markers = markers;
+  for (int i = 0; i < markers.size(); ++i) {
+    Marker &marker = frame->normalized_markers[i];
+    camera_intrinsics.InvertIntrinsics(marker.x, marker.y,
+                                       &marker.x, &marker.y);
+  }
+}
+
+/* Starts the incremental reconstruction after a batch one. The sliding window
+ * gets the last reconstructed frames, or all the markers are kept for the
+ * initialization when the batch reconstruction failed.
+ */
+
+void libmv_seedIncrementalReconstruction(
+    const Tracks &tracks,
+    int num_frames,
+    const libmv_ReconstructionOptions* libmv_reconstruction_options,
+    const libmv_Reconstruction &libmv_reconstruction,
+    libmv_IncrementalReconstruction *incremental) {
+  incremental->num_frames = num_frames;
+  incremental->initial_markers.clear();
+  incremental->keyframes.clear();
+
+  if (!libmv_reconstruction.is_valid) {
+    incremental->initial_markers = tracks.AllMarkers();
+    return;
+  }
+
+  const int window = std::max(libmv_reconstruction_options->keyframes_window, 2);
+  for (int image = num_frames - 1;
+       image >= 0 && (int)incremental->keyframes.size() < window; --image) {
+    if (!libmv_reconstruction.reconstruction.CameraForImage(image))
+      continue;
+    libmv_WindowFrame frame;
+    libmv_fillWindowFrame(image,
+                          tracks.MarkersInImage(image),
+                          *libmv_reconstruction.intrinsics,
+                          &frame);
+    incremental->keyframes.push_front(frame);
+  }
+}
+
+/* Tells if a frame is a good keyframe after the last one. It runs the keyframe
+ * selection on the two frames only, so it doesn't depend on the sequence length.
+ */
+
+bool libmv_isNewKeyframe(
+    const libmv_WindowFrame &keyframe,
+    const libmv_WindowFrame &frame,
+    const CameraIntrinsics &camera_intrinsics) {
+  /* The keyframe selection starts from image 1 */
+  libmv::vector<Marker> markers;
+  for (int i = 0; i < keyframe.normalized_markers.size(); ++i) {
+    markers.push_back(keyframe.normalized_markers[i]);
+    markers.back().image = 1;
+  }
+  for (int i = 0; i < frame.normalized_markers.size(); ++i) {
+    markers.push_back(frame.normalized_markers[i]);
+    markers.back().image = 2;
+  }
+  Tracks pair_tracks(markers);
+
+  libmv::vector<int> keyframes;
+  SelectKeyframesBasedOnGRICAndVariance(pair_tracks,
+                                        camera_intrinsics,
+                                        keyframes);
+  if (keyframes.size() >= 2)
+    return true;
+
+  /* Keep following the stream once the frame shares too few tracks with the
+   * keyframe for the selection to ever accept it. */
+  return pair_tracks.MarkersForTracksInBothImages(1, 2).size() / 2 < 16;
+}
+
+/* Adds a frame to the reconstruction: the frame is resected against the
+ * existing points, the new tracks are intersected and a bundle adjustment
+ * refines the sliding window of keyframes. Until there is an initial
+ * reconstruction, the frames are solved together in a batch.
+ *
+ * The markers are the ones of image incremental->num_frames, in pixels.
+ */
+
+void libmv_addFrameToReconstruction(
+    const libmv::vector<Marker> &markers,
+    const libmv_CameraIntrinsicsOptions* libmv_camera_intrinsics_options,
+    libmv_ReconstructionOptions* libmv_reconstruction_options,
+    libmv_IncrementalReconstruction *incremental,
+    libmv_Reconstruction *libmv_reconstruction) {
+  const int image = incremental->num_frames++;
+
+  if (!libmv_reconstruction->is_valid) {
+    for (int i = 0; i < markers.size(); ++i)
+      incremental->initial_markers.push_back(markers[i]);
+    if (incremental->num_frames < 2)
+      return;
+
+    Tracks initial_tracks(incremental->initial_markers);
+    libmv_Reconstruction *initial =
+      libmv_solveReconstruction(initial_tracks,
+                                libmv_camera_intrinsics_options,
+                                libmv_reconstruction_options);
+    if (!initial->is_valid) {
+      LG << "No initial reconstruction from " << incremental->num_frames << " frames";
+      delete initial->intrinsics;
+      delete initial;
+      return;
+    }
+    delete libmv_reconstruction->intrinsics;
+    *libmv_reconstruction = *initial;
+    delete initial;
+
+    libmv_seedIncrementalReconstruction(initial_tracks,
+                                        incremental->num_frames,
+                                        libmv_reconstruction_options,
+                                        *libmv_reconstruction,
+                                        incremental);
+    return;
+  }
+
+  EuclideanReconstruction &reconstruction =
+    libmv_reconstruction->reconstruction;
+  const CameraIntrinsics &camera_intrinsics = *libmv_reconstruction->intrinsics;
+  const int num_threads = libmv_reconstructionNumThreads(libmv_reconstruction_options);
+
+  libmv_WindowFrame frame;
+  libmv_fillWindowFrame(image, markers, camera_intrinsics, &frame);
+
+  /* Resect the frame against the points already reconstructed. */
+  libmv::vector<Marker> reconstructed_markers;
+  for (int i = 0; i < frame.normalized_markers.size(); ++i) {
+    if (reconstruction.PointForTrack(frame.normalized_markers[i].track))
+      reconstructed_markers.push_back(frame.normalized_markers[i]);
+  }
+  if (reconstructed_markers.size() < 5 ||
+      !EuclideanResect(reconstructed_markers, &reconstruction, true)) {
+    LG << "Failed to resect frame " << image;
+    return;
+  }
+
+  /* Intersect the new tracks seen by the keyframes and the frame. */
+  std::map<int, libmv::vector<Marker> > window_markers;
+  for (size_t k = 0; k < incremental->keyframes.size(); ++k) {
+    const libmv::vector<Marker> &keyframe_markers =
+      incremental->keyframes[k].normalized_markers;
+    for (int i = 0; i < keyframe_markers.size(); ++i)
+      window_markers[keyframe_markers[i].track].push_back(keyframe_markers[i]);
+  }
+  int num_intersects = 0;
+  for (int i = 0; i < frame.normalized_markers.size(); ++i) {
+    const Marker &marker = frame.normalized_markers[i];
+    if (reconstruction.PointForTrack(marker.track))
+      continue;
+    libmv::vector<Marker> &track_markers = window_markers[marker.track];
+    track_markers.push_back(marker);
+    if (track_markers.size() >= 2 &&
+        EuclideanIntersect(track_markers, &reconstruction))
+      num_intersects++;
+  }
+  LG << "Frame " << image << ": " << num_intersects << " new points";
+
+  /* Slide the window when the frame is a keyframe. */
+  bool is_keyframe = incremental->keyframes.empty() ||
+    libmv_isNewKeyframe(incremental->keyframes.back(), frame, camera_intrinsics);
+  if (is_keyframe) {
+    incremental->keyframes.push_back(frame);
+    const int window = std::max(libmv_reconstruction_options->keyframes_window, 2);
+    while ((int)incremental->keyframes.size() > window)
+      incremental->keyframes.pop_front();
+  }
+
+  /* Bundle the window, keeping its two oldest keyframes constant so the
+   * scale of the reconstruction doesn't drift. */
+  std::vector<const libmv_WindowFrame*> window;
+  for (size_t k = 0; k < incremental->keyframes.size(); ++k)
+    window.push_back(&incremental->keyframes[k]);
+  if (!is_keyframe)
+    window.push_back(&frame);
+
+  libmv::vector<Marker> window_tracks_markers, window_normalized_markers;
+  libmv::vector<int> refined_images;
+  for (size_t k = 0; k < window.size(); ++k) {
+    for (int i = 0; i < window[k]->markers.size(); ++i) {
+      window_tracks_markers.push_back(window[k]->markers[i]);
+      window_normalized_markers.push_back(window[k]->normalized_markers[i]);
+    }
+    if (k >= 2 || window[k]->image == image)
+      refined_images.push_back(window[k]->image);
+  }
+  EuclideanBundleLocal(Tracks(window_normalized_markers),
+                       refined_images,
+                       &reconstruction,
+                       num_threads);
+
+  /* The error is the one of the window, which is all that was refined. */
+  libmv_reconstruction->tracks = Tracks(window_tracks_markers);
+  libmv_reconstruction->error = EuclideanReprojectionError(libmv_reconstruction->tracks,
+                                                           reconstruction,
+                                                           camera_intrinsics);
+}
+
 #endif
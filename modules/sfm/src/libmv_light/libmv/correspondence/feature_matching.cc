@@ -22,6 +22,16 @@
 
 #include "libmv/correspondence/feature_matching.h"
 
+// Binary descriptors are matched with LSH, as the default KD-trees only
+// handle float descriptors.
+static cv::Ptr<cv::FlannBasedMatcher> CreateMatcher(const cv::Mat &descriptors) {
+  if (descriptors.depth() == CV_8U) {
+    return cv::makePtr<cv::FlannBasedMatcher>(
+      cv::makePtr<cv::flann::LshIndexParams>(12, 20, 2));
+  }
+  return cv::makePtr<cv::FlannBasedMatcher>();
+}
+
 // Compute candidate matches between 2 sets of features.  Two features A and B
 // are a candidate match if A is the nearest neighbor of B and B is the nearest
 // neighbor of A.
@@ -33,25 +43,25 @@ void FindCandidateMatches(const FeatureSet &left,
     return;
   }
 
-  cv::FlannBasedMatcher matcherA;
-  cv::FlannBasedMatcher matcherB;
-
   // Paste the necessary data in contiguous arrays.
   cv::Mat arrayA = FeatureSet::FeatureSetDescriptorsToContiguousArray(left);
   cv::Mat arrayB = FeatureSet::FeatureSetDescriptorsToContiguousArray(right);
 
-  matcherA.add(std::vector<cv::Mat>(1, arrayB));
-  matcherB.add(std::vector<cv::Mat>(1, arrayA));
+  cv::Ptr<cv::FlannBasedMatcher> matcherA = CreateMatcher(arrayA);
+  cv::Ptr<cv::FlannBasedMatcher> matcherB = CreateMatcher(arrayB);
+  matcherA->add(std::vector<cv::Mat>(1, arrayB));
+  matcherB->add(std::vector<cv::Mat>(1, arrayA));
   std::vector<cv::DMatch> matchesA, matchesB;
-  matcherA.match(arrayA, matchesA);
-  matcherB.match(arrayB, matchesB);
+  matcherA->match(arrayA, matchesA);
+  matcherB->match(arrayB, matchesB);
 
   // From putative matches get symmetric matches.
   int max_track_number = 0;
   for (size_t i = 0; i < matchesA.size(); ++i)
   {
     // Add the match only if we have a symmetric result.
-    if (i == matchesB[matchesA[i].trainIdx].trainIdx)
+    if (matchesA[i].trainIdx >= 0 &&
+        i == (size_t)matchesB[matchesA[i].trainIdx].trainIdx)
     {
       matches->Insert(0, max_track_number, &left.features[i]);
       matches->Insert(1, max_track_number, &right.features[matchesA[i].trainIdx]);
@@ -66,9 +76,10 @@ cv::Mat FeatureSet::FeatureSetDescriptorsToContiguousArray
   if (featureSet.features.empty())  {
     return cv::Mat();
   }
-  int descriptorSize = featureSet.features[0].descriptor.cols;
-  // Allocate and paste the necessary data.
-  cv::Mat array(featureSet.features.size(), descriptorSize, CV_32F);
+  const cv::Mat &descriptor = featureSet.features[0].descriptor;
+  // Allocate and paste the necessary data, keeping the type of the descriptors
+  // so that the binary ones are still matched with the Hamming distance.
+  cv::Mat array((int)featureSet.features.size(), descriptor.cols, descriptor.type());
 
   //-- Paste data in the contiguous array :
   for (int i = 0; i < (int)featureSet.features.size(); ++i) {
@@ -85,20 +96,22 @@ void FindCandidateMatches_Ratio(const FeatureSet &left,
   if (left.features.empty() || right.features.empty())
     return;
 
-  cv::FlannBasedMatcher matcherA;
-
   // Paste the necessary data in contiguous arrays.
   cv::Mat arrayA = FeatureSet::FeatureSetDescriptorsToContiguousArray(left);
   cv::Mat arrayB = FeatureSet::FeatureSetDescriptorsToContiguousArray(right);
 
-  matcherA.add(std::vector<cv::Mat>(1, arrayB));
+  cv::Ptr<cv::FlannBasedMatcher> matcherA = CreateMatcher(arrayA);
+  matcherA->add(std::vector<cv::Mat>(1, arrayB));
   std::vector < std::vector<cv::DMatch> > matchesA;
-  matcherA.knnMatch(arrayA, matchesA, 2);
+  matcherA->knnMatch(arrayA, matchesA, 2);
 
   // From putative matches get matches that fit the "Ratio" heuristic.
   int max_track_number = 0;
   for (size_t i = 0; i < matchesA.size(); ++i)
   {
+    // LSH may find less than two neighbors.
+    if (matchesA[i].size() < 2)
+      continue;
     float distance0 = matchesA[i][0].distance;
     float distance1 = matchesA[i][1].distance;
     // Add the match only if we have a symmetric result.
@@ -121,19 +134,21 @@ void FindCorrespondences(const FeatureSet &left,
   if (left.features.empty() || right.features.empty())
     return;
 
-  cv::FlannBasedMatcher matcherA;
-
   // Paste the necessary data in contiguous arrays.
   cv::Mat arrayA = FeatureSet::FeatureSetDescriptorsToContiguousArray(left);
   cv::Mat arrayB = FeatureSet::FeatureSetDescriptorsToContiguousArray(right);
 
-  matcherA.add(std::vector<cv::Mat>(1, arrayB));
+  cv::Ptr<cv::FlannBasedMatcher> matcherA = CreateMatcher(arrayA);
+  matcherA->add(std::vector<cv::Mat>(1, arrayB));
   std::vector < std::vector<cv::DMatch> > matchesA;
-  matcherA.knnMatch(arrayA, matchesA, 2);
+  matcherA->knnMatch(arrayA, matchesA, 2);
 
   // From putative matches get matches that fit the "Ratio" heuristic.
   for (size_t i = 0; i < matchesA.size(); ++i)
   {
+    // LSH may find less than two neighbors.
+    if (matchesA[i].size() < 2)
+      continue;
     float distance0 = matchesA[i][0].distance;
     float distance1 = matchesA[i][1].distance;
     // Add the match only if we have a symmetric result.
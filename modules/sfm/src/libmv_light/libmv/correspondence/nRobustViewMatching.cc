@@ -18,6 +18,9 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <algorithm>
+
+#include <opencv2/features2d.hpp>
 #include <opencv2/highgui.hpp>
 
 #include "libmv/base/vector_utils.h"
@@ -30,7 +33,99 @@ using namespace libmv;
 using namespace correspondence;
 using namespace std;
 
-nRobustViewMatching::nRobustViewMatching(){
+namespace {
+
+// Fit a fundamental matrix to the putative matches between two images and
+// return the inliers, as indices in the tracks of the matches.
+void robustInliers(const Matches & matchIn,
+                   libmv::vector<int> * tracks,
+                   libmv::vector<int> * inliers)
+{
+  libmv::vector<Mat> x;
+  libmv::vector<int> images;
+  images.push_back(0);
+  images.push_back(1);
+  PointMatchMatrices(matchIn, images, tracks, &x);
+
+  Mat3 H;
+  // TODO(pmoulon) Make the Correspondence filter a parameter.
+  //HomographyFromCorrespondences2PointRobust(x[0], x[1], 0.3, &H, &inliers);
+  //HomographyFromCorrespondences4PointRobust(x[0], x[1], 0.3, &H, &inliers);
+  //AffineFromCorrespondences2PointRobust(x[0], x[1], 1, &H, &inliers);
+  FundamentalFromCorrespondences7PointRobust(x[0], x[1], 1.0, &H, inliers);
+
+  //TODO(pmoulon) insert an optimization phase.
+  // Rerun Robust correspondance on the inliers.
+  // it will allow to compute a better model and filter ugly fitting.
+}
+
+// Matches of a pair of images before they are merged into the tracks.
+struct PairMatches {
+  Matches candidates;
+  libmv::vector<int> tracks;
+  libmv::vector<int> inliers;
+};
+
+// Computes the putative matches and their robust inliers for a range of
+// pairs. It only reads the features, so the pairs are matched concurrently.
+class MatchPairsInvoker : public cv::ParallelLoopBody {
+ public:
+  MatchPairsInvoker(const map<string,FeatureSet> & viewData,
+                    const std::vector<string> & names,
+                    const std::vector< pair<int,int> > & pairs,
+                    int first,
+                    std::vector<PairMatches> & results)
+    : viewData_(viewData), names_(names), pairs_(pairs), first_(first),
+      results_(results) {}
+
+  virtual void operator()(const cv::Range & range) const
+  {
+    for (int k = range.start; k < range.end; ++k) {
+      const pair<int,int> & imagePair = pairs_[first_ + k];
+      PairMatches & result = results_[k];
+      FindCandidateMatches_Ratio(
+        viewData_.find(names_[imagePair.first])->second,
+        viewData_.find(names_[imagePair.second])->second,
+        &result.candidates);
+      robustInliers(result.candidates, &result.tracks, &result.inliers);
+    }
+  }
+
+ private:
+  const map<string,FeatureSet> & viewData_;
+  const std::vector<string> & names_;
+  const std::vector< pair<int,int> > & pairs_;
+  int first_;
+  std::vector<PairMatches> & results_;
+
+  MatchPairsInvoker& operator=(const MatchPairsInvoker&); // to quiet MSVC
+};
+
+// Descriptors of a feature set as floats, as required by the clustering.
+cv::Mat floatDescriptors(const FeatureSet & featureSet)
+{
+  cv::Mat descriptors =
+    FeatureSet::FeatureSetDescriptorsToContiguousArray(featureSet);
+  if (!descriptors.empty() && descriptors.depth() != CV_32F)
+    descriptors.convertTo(descriptors, CV_32F);
+  return descriptors;
+}
+
+// Sorts the images by decreasing similarity.
+struct MoreSimilar {
+  MoreSimilar(const float * similarities) : similarities_(similarities) {}
+  bool operator()(int a, int b) const
+  {
+    return similarities_[a] > similarities_[b] ||
+      (similarities_[a] == similarities_[b] && a < b);
+  }
+  const float * similarities_;
+};
+
+}  // namespace
+
+nRobustViewMatching::nRobustViewMatching()
+  : m_preselectedNeighbors(0), m_vocabularySize(256) {
 #ifdef CV_VERSION_EPOCH
   m_pDescriber = NULL;
 #endif
@@ -38,11 +133,19 @@ nRobustViewMatching::nRobustViewMatching(){
 
 nRobustViewMatching::nRobustViewMatching(
     cv::Ptr<cv::FeatureDetector> pDetector,
-    cv::Ptr<cv::DescriptorExtractor> pDescriber){
+    cv::Ptr<cv::DescriptorExtractor> pDescriber)
+  : m_preselectedNeighbors(0), m_vocabularySize(256) {
   m_pDetector = pDetector;
   m_pDescriber = pDescriber;
 }
 
+void nRobustViewMatching::setPairPreselection(int neighbors, int vocabularySize)
+{
+  CV_Assert(neighbors >= 0 && vocabularySize > 0);
+  m_preselectedNeighbors = neighbors;
+  m_vocabularySize = vocabularySize;
+}
+
 /**
  * Compute the data and store it in the class map<string,T>
  *
@@ -164,18 +267,107 @@ bool nRobustViewMatching::computeCrossMatch( const std::vector<string> & vec_dat
     bRes &= computeData(vec_data[i]);
   }
 
-  bool bRes2 = true;
-  for (int i=0; i < vec_data.size(); ++i) {
-    for (int j=0; j < i; ++j)
-    {
-      if (m_ViewData.find(vec_data[i]) != m_ViewData.end() &&
-        m_ViewData.find(vec_data[j]) != m_ViewData.end())
+  std::vector< pair<int,int> > pairs;
+  selectPairs(&pairs);
+  return matchPairs(pairs);
+}
+
+void nRobustViewMatching::selectPairs(std::vector< pair<int,int> > * pairs) const
+{
+  const int n = (int)m_vec_InputNames.size();
+  std::vector<bool> selected(n * n, m_preselectedNeighbors == 0 ||
+                                    m_preselectedNeighbors >= n - 1);
+
+  if (!selected.empty() && !selected[0]) {
+    // Train the vocabulary on an even subset of the descriptors of all the images.
+    std::vector<cv::Mat> descriptors(n);
+    int total = 0;
+    for (int i = 0; i < n; ++i) {
+      map<string,FeatureSet>::const_iterator it = m_ViewData.find(m_vec_InputNames[i]);
+      if (it != m_ViewData.end())
+        descriptors[i] = floatDescriptors(it->second);
+      total += descriptors[i].rows;
+    }
+    const int step = std::max(1, total / (100 * m_vocabularySize));
+    cv::BOWKMeansTrainer trainer(m_vocabularySize);
+    for (int i = 0; i < n; ++i)
+      for (int r = 0; r < descriptors[i].rows; r += step)
+        trainer.add(descriptors[i].row(r));
+
+    if (trainer.descriptorsCount() >= m_vocabularySize) {
+      cv::BOWImgDescriptorExtractor bow(cv::makePtr<cv::FlannBasedMatcher>());
+      bow.setVocabulary(trainer.cluster());
+
+      // L2 normalized histograms of words, one per row.
+      cv::Mat histograms = cv::Mat::zeros(n, m_vocabularySize, CV_32F);
+      for (int i = 0; i < n; ++i) {
+        if (descriptors[i].empty())
+          continue;
+        cv::Mat histogram;
+        bow.compute(descriptors[i], histogram);
+        cv::normalize(histogram, histograms.row(i));
+      }
+      cv::Mat similarities = histograms * histograms.t();
+
+      // Keep the most similar images of each image, in both directions.
+      std::vector<int> others;
+      for (int i = 0; i < n; ++i) {
+        others.clear();
+        for (int j = 0; j < n; ++j)
+          if (j != i)
+            others.push_back(j);
+        std::partial_sort(others.begin(), others.begin() + m_preselectedNeighbors,
+                          others.end(), MoreSimilar(similarities.ptr<float>(i)));
+        for (int k = 0; k < m_preselectedNeighbors; ++k)
+          selected[i * n + others[k]] = selected[others[k] * n + i] = true;
+      }
+    }
+    else {
+      LOG(INFO) << "[nViewMatching::selectPairs] "
+                << "Not enough descriptors for the vocabulary, matching all the pairs.";
+      selected.assign(selected.size(), true);
+    }
+  }
+
+  pairs->clear();
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < i; ++j) {
+      if (selected[i * n + j] &&
+          m_ViewData.find(m_vec_InputNames[i]) != m_ViewData.end() &&
+          m_ViewData.find(m_vec_InputNames[j]) != m_ViewData.end())
+        pairs->push_back(make_pair(i, j));
+    }
+  }
+}
+
+bool nRobustViewMatching::matchPairs(const std::vector< pair<int,int> > & pairs)
+{
+  // The pairs are matched by chunks, to bound the memory of the putative matches.
+  const int chunk = 4 * std::max(1, cv::getNumThreads());
+  std::vector<PairMatches> results;
+  for (int first = 0; first < (int)pairs.size(); first += chunk) {
+    const int count = std::min(chunk, (int)pairs.size() - first);
+    results.assign(count, PairMatches());
+    cv::parallel_for_(cv::Range(0, count),
+                      MatchPairsInvoker(m_ViewData, m_vec_InputNames, pairs, first, results));
+
+    // Merge in the order of the pairs, as the sequential matching did.
+    for (int k = 0; k < count; ++k) {
+      const int iDataA = pairs[first + k].first, iDataB = pairs[first + k].second;
+      Matches matches;
+      mergeConstrainMatches(results[k].candidates, results[k].tracks, results[k].inliers,
+                            iDataA, iDataB, &matches);
+      if (matches.NumTracks() > 0)
       {
-        bRes2 &= this->MatchData( vec_data[i], vec_data[j]);
+        m_sharedData.insert(
+          make_pair(
+            make_pair(m_vec_InputNames[iDataA],m_vec_InputNames[iDataB]),
+            matches)
+          );
       }
     }
   }
-  return bRes2;
+  return true;
 }
 
 bool nRobustViewMatching::computeRelativeMatch(
@@ -191,17 +383,22 @@ bool nRobustViewMatching::computeRelativeMatch(
     bRes &= computeData(vec_data[i]);
   }
 
-  bool bRes2 = true;
+  std::vector< pair<int,int> > pairs;
   for (int i=1; i < vec_data.size(); ++i) {
     if (m_ViewData.find(vec_data[i-1]) != m_ViewData.end() &&
         m_ViewData.find(vec_data[i])   != m_ViewData.end())
     {
-      bRes2 &= this->MatchData(vec_data[i-1], vec_data[i]);
+      pairs.push_back(make_pair(i-1, i));
     }
   }
   // Match the first and the last images (in order to detect loop)
-  bRes2 &= this->MatchData(vec_data[0], vec_data[vec_data.size() - 1]);
-  return bRes2;
+  if (!vec_data.empty() &&
+      m_ViewData.find(vec_data[0]) != m_ViewData.end() &&
+      m_ViewData.find(vec_data[vec_data.size() - 1]) != m_ViewData.end())
+  {
+    pairs.push_back(make_pair(0, (int)vec_data.size() - 1));
+  }
+  return matchPairs(pairs);
 }
 
 /**
@@ -225,23 +422,22 @@ bool nRobustViewMatching::computeConstrainMatches(const Matches & matchIn,
               << " Could not export constrained matches.";
     return false;
   }
-  libmv::vector<Mat> x;
-  libmv::vector<int> tracks, images;
+  libmv::vector<int> tracks, inliers;
+  robustInliers(matchIn, &tracks, &inliers);
+  mergeConstrainMatches(matchIn, tracks, inliers, dataAindex, dataBindex, matchesOut);
+  return true;
+}
+
+void nRobustViewMatching::mergeConstrainMatches(const Matches & matchIn,
+                             const libmv::vector<int> & tracks,
+                             const libmv::vector<int> & inliers,
+                             int dataAindex,
+                             int dataBindex,
+                             Matches * matchesOut)
+{
+  libmv::vector<int> images;
   images.push_back(0);
   images.push_back(1);
-  PointMatchMatrices(matchIn, images, &tracks, &x);
-
-  libmv::vector<int> inliers;
-  Mat3 H;
-  // TODO(pmoulon) Make the Correspondence filter a parameter.
-  //HomographyFromCorrespondences2PointRobust(x[0], x[1], 0.3, &H, &inliers);
-  //HomographyFromCorrespondences4PointRobust(x[0], x[1], 0.3, &H, &inliers);
-  //AffineFromCorrespondences2PointRobust(x[0], x[1], 1, &H, &inliers);
-  FundamentalFromCorrespondences7PointRobust(x[0], x[1], 1.0, &H, &inliers);
-
-  //TODO(pmoulon) insert an optimization phase.
-  // Rerun Robust correspondance on the inliers.
-  // it will allow to compute a better model and filter ugly fitting.
 
   //-- Assert that the output of the model is consistent :
   // As much as the minimal points are inliers.
@@ -298,6 +494,5 @@ bool nRobustViewMatching::computeConstrainMatches(const Matches & matchIn,
       }
     }
   }
-  return true;
 }
 
@@ -24,6 +24,7 @@
 struct FeatureSet;
 #include <map>
 
+#include "libmv/base/vector.h"
 #include "libmv/correspondence/feature.h"
 #include "libmv/correspondence/matches.h"
 #include "libmv/correspondence/nViewMatchingInterface.h"
@@ -101,6 +102,19 @@ class nRobustViewMatching :public nViewMatchingInterface  {
                                int dataBindex,
                                Matches * matchesOut);
 
+  /**
+  * Restrict the cross matching to the pairs of images that likely overlap.
+  *
+  * A vocabulary of visual words is built by clustering the descriptors of
+  * all the images, and each image is only matched with the images whose
+  * histograms of words are the most similar to its own one.
+  *
+  * \param[in] neighbors The number of images matched with each image,
+  *  0 matches all the pairs.
+  * \param[in] vocabularySize The number of words of the vocabulary.
+  */
+  void setPairPreselection(int neighbors, int vocabularySize = 256);
+
   /// Return pairwise correspondence ( geometrically filtered )
   const map< pair<string,string>, Matches> & getSharedData() const
     { return m_sharedData;  }
@@ -112,6 +126,18 @@ class nRobustViewMatching :public nViewMatchingInterface  {
     { return m_tracks;  }
 
 private :
+  /// Select the pairs (i, j), j < i, of the input data to match.
+  void selectPairs(std::vector< pair<int,int> > * pairs) const;
+  /// Match the pairs concurrently and merge them in order into the tracks.
+  bool matchPairs(const std::vector< pair<int,int> > & pairs);
+  /// Merge the robust inliers of the matches between A and B into the tracks.
+  void mergeConstrainMatches(const Matches & matchIn,
+                             const libmv::vector<int> & tracks,
+                             const libmv::vector<int> & inliers,
+                             int dataAindex,
+                             int dataBindex,
+                             Matches * matchesOut);
+
   /// Input data names
   std::vector<string> m_vec_InputNames;
   /// Data that represent each named element.
@@ -130,6 +156,11 @@ private :
   cv::Ptr<cv::FeatureDetector> m_pDetector;
   /// Interface to describe Keypoint.
   cv::Ptr<cv::DescriptorExtractor> m_pDescriber;
+
+  /// Number of images matched with each image, 0 for all the pairs.
+  int m_preselectedNeighbors;
+  /// Number of visual words used by the pair preselection.
+  int m_vocabularySize;
 };
 
 } // using namespace correspondence
@@ -44,6 +44,23 @@ struct SampsonError {
     return Square(y.dot(F_x)) / (  F_x.head<2>().squaredNorm()
                                 + Ft_y.head<2>().squaredNorm());
   }
+
+  // The errors of all the columns of x1 and x2, with the products by F done
+  // for all of them at once so that Eigen vectorizes them.
+  template<typename TMatX>
+  static void Errors(const Mat3 &F, const TMatX &x1, const TMatX &x2,
+                     double *errors) {
+    Mat3X F_x = F.leftCols<2>() * x1;
+    F_x.colwise() += F.col(2);
+    Mat3X Ft_y = F.topRows<2>().transpose() * x2;
+    Ft_y.colwise() += F.row(2).transpose();
+    Eigen::Array<double, 1, Eigen::Dynamic> y_F_x =
+        (x2.array() * F_x.topRows<2>().array()).colwise().sum() +
+        F_x.row(2).array();
+    Eigen::Map<Eigen::Array<double, 1, Eigen::Dynamic> >(errors, x1.cols()) =
+        y_F_x.square() / (  F_x.topRows<2>().colwise().squaredNorm()
+                          + Ft_y.topRows<2>().colwise().squaredNorm()).array();
+  }
 };
 
 struct SymmetricEpipolarDistanceError {
@@ -51,6 +51,15 @@ class Kernel {
     Mat2X error = Project(model, X) - x_.col(sample);
     return error.col(0).squaredNorm();
   }
+  // The errors of the samples first, ..., first + count - 1.
+  void Errors(const Model &model, int first, int count, double *errors) const {
+    Mat3X PX = model * X_.middleCols(first, count);
+    Eigen::Map<Eigen::Array<double, 1, Eigen::Dynamic> >(errors, count) =
+        (PX.row(0).array() / PX.row(2).array() -
+         x_.row(0).segment(first, count).array()).square() +
+        (PX.row(1).array() / PX.row(2).array() -
+         x_.row(1).segment(first, count).array()).square();
+  }
   int NumSamples() const {
     return x_.cols();
   }
@@ -22,6 +22,11 @@
 #define LIBMV_MULTIVIEW_ROBUST_ESTIMATION_H_
 
 #include <set>
+#include <vector>
+
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
 
 #include "libmv/base/vector.h"
 #include "libmv/logging/logging.h"
@@ -50,6 +55,22 @@ class MLEScorer {
     }
     return cost;
   }
+  // The cost of a block of errors, for the estimators which score by blocks.
+  // As in Score(), an error which is not below the threshold (NaN included)
+  // costs the threshold.
+  double Cost(const double *errors, int count) const {
+    Eigen::Map<const Eigen::ArrayXd> e(errors, count);
+    return (e < threshold_).select(e, threshold_).sum();
+  }
+  // Appends the samples first, ..., first + count - 1 which are inliers.
+  void Inliers(const double *errors, int first, int count,
+               vector<int> *inliers) const {
+    for (int j = 0; j < count; ++j) {
+      if (errors[j] < threshold_) {
+        inliers->push_back(first + j);
+      }
+    }
+  }
  private:
   double threshold_;
 };
@@ -149,6 +170,129 @@ typename Kernel::Model Estimate(const Kernel &kernel,
   return best_model;
 }
 
+// The same estimation as Estimate(), with the hypotheses fitted and scored by
+// batches in parallel. The kernel also provides
+//
+// 5. Kernel::Errors(Model, first, count, double *errors)
+//
+// and the scorer Cost(errors, count) and Inliers(errors, first, count,
+// inliers), so that the errors of a model are computed by blocks of samples.
+// The scoring of a model is preempted as soon as its partial cost reaches the
+// best cost of the previous batches, as it can't become the best one anymore.
+//
+// The samples are still drawn sequentially and the batches are merged in
+// order, so the result doesn't depend on the number of threads. A number of
+// threads below 1 uses as many threads as OpenMP reports.
+template<typename Kernel, typename Scorer>
+typename Kernel::Model EstimateParallel(const Kernel &kernel,
+                                        const Scorer &scorer,
+                                        vector<int> *best_inliers = NULL,
+                                        double *best_score = NULL,
+                                        double outliers_probability = 1e-2,
+                                        int num_threads = -1) {
+  CHECK(outliers_probability < 1.0);
+  CHECK(outliers_probability > 0.0);
+  const size_t min_samples = Kernel::MINIMUM_SAMPLES;
+  const size_t total_samples = kernel.NumSamples();
+  const int batch_size = 32;
+  const int block_size = 256;
+
+  size_t max_iterations = 100;
+  const size_t really_max_iterations = 1000;
+
+  int best_num_inliers = 0;
+  double best_cost = HUGE_VAL;
+  double best_inlier_ratio = 0.0;
+  typename Kernel::Model best_model;
+
+  // Test if we have sufficient points to for the kernel.
+  if (total_samples < min_samples)  {
+    if (best_inliers) {
+      best_inliers->resize(0);
+    }
+    return best_model;
+  }
+
+#ifdef _OPENMP
+  if (num_threads < 1) {
+    num_threads = omp_get_max_threads();
+  }
+#else
+  (void) num_threads;
+#endif
+
+  std::vector<vector<int> > samples(batch_size);
+  std::vector<vector<typename Kernel::Model> > models(batch_size);
+  std::vector<vector<double> > costs(batch_size);
+
+  size_t iteration = 0;
+  while (iteration < max_iterations &&
+         iteration < really_max_iterations) {
+    const int count = static_cast<int>(std::min<size_t>(
+        batch_size, std::min(max_iterations, really_max_iterations) - iteration));
+    for (int h = 0; h < count; ++h) {
+      UniformSample(min_samples, total_samples, &samples[h]);
+    }
+
+    const double preemption_cost = best_cost;
+#ifdef _OPENMP
+#  pragma omp parallel for schedule(dynamic) num_threads(num_threads) \
+  if (num_threads > 1)
+#endif
+    for (int h = 0; h < count; ++h) {
+      models[h].clear();
+      kernel.Fit(samples[h], &models[h]);
+      costs[h].resize(models[h].size());
+
+      vector<double> errors(block_size);
+      for (int i = 0; i < models[h].size(); ++i) {
+        double cost = 0.0;
+        for (int first = 0;
+             first < total_samples && cost < preemption_cost;
+             first += block_size) {
+          const int n = std::min<int>(block_size, total_samples - first);
+          kernel.Errors(models[h][i], first, n, errors.data());
+          cost += scorer.Cost(errors.data(), n);
+        }
+        costs[h][i] = cost < preemption_cost ? cost : HUGE_VAL;
+      }
+    }
+
+    // Merge the batch in the order of the samples, stopping where the
+    // sequential estimation would have stopped.
+    for (int h = 0; h < count && iteration < max_iterations; ++h, ++iteration) {
+      VLOG(4) << "Fitted subset; found " << models[h].size() << " model(s).";
+      for (int i = 0; i < models[h].size(); ++i) {
+        if (costs[h][i] < best_cost) {
+          vector<int> inliers;
+          vector<double> errors(total_samples);
+          kernel.Errors(models[h][i], 0, total_samples, errors.data());
+          scorer.Inliers(errors.data(), 0, total_samples, &inliers);
+
+          best_cost = costs[h][i];
+          best_inlier_ratio = inliers.size() / double(total_samples);
+          best_num_inliers = inliers.size();
+          best_model = models[h][i];
+          if (best_inliers) {
+            best_inliers->swap(inliers);
+          }
+          VLOG(4) << "New best cost: " << best_cost << " with "
+                  << best_num_inliers << " inlying of "
+                  << total_samples << " total samples.";
+        }
+        if (best_inlier_ratio) {
+          max_iterations = IterationsRequired(min_samples,
+                                              outliers_probability,
+                                              best_inlier_ratio);
+        }
+      }
+    }
+  }
+  if (best_score)
+    *best_score = best_cost;
+  return best_model;
+}
+
 } // namespace libmv
 
 #endif  // LIBMV_MULTIVIEW_ROBUST_ESTIMATION_H_
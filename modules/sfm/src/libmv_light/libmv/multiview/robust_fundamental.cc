@@ -38,8 +38,8 @@ double FundamentalFromCorrespondences8PointRobust(const Mat &x1,
   double best_score = HUGE_VAL;
   typedef fundamental::kernel::NormalizedEightPointKernel Kernel;
   Kernel kernel(x1, x2);
-  *F = Estimate(kernel, MLEScorer<Kernel>(threshold), inliers,
-                &best_score, outliers_probability);
+  *F = EstimateParallel(kernel, MLEScorer<Kernel>(threshold), inliers,
+                        &best_score, outliers_probability);
   if (best_score == HUGE_VAL)
     return HUGE_VAL;
   else
@@ -37,8 +37,8 @@ double ResectionRobust(const Mat2X &x_image,
   double best_score = HUGE_VAL;
   typedef libmv::resection::kernel::Kernel Kernel;
   Kernel kernel(x_image, X_world);
-  *P = Estimate(kernel, MLEScorer<Kernel>(threshold), inliers,
-                &best_score, outliers_probability);
+  *P = EstimateParallel(kernel, MLEScorer<Kernel>(threshold), inliers,
+                        &best_score, outliers_probability);
   if (best_score == HUGE_VAL)
     return HUGE_VAL;
   else
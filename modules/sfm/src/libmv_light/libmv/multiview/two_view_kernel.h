@@ -97,6 +97,10 @@ struct IsotropicNormalizedSolver {
 //   3. Kernel::Fit(vector<int>, vector<Kernel::Model> *)
 //   4. Kernel::Error(int, Model) -> error
 //
+// Kernel::Errors(Model, first, count, errors) computes the errors of a range
+// of samples at once, for the estimators which score the models by blocks.
+// It is only available when ErrorArg has the same Errors() for matrices.
+//
 // The fit routine must not clear existing entries in the vector of models; it
 // should append new solutions to the end.
 template<typename SolverArg,
@@ -118,6 +122,12 @@ class Kernel {
                            static_cast<Vec>(x1_.col(sample)),
                            static_cast<Vec>(x2_.col(sample)));
   }
+  void Errors(const Model &model, int first, int count, double *errors) const {
+    ErrorArg::Errors(model,
+                     x1_.middleCols(first, count),
+                     x2_.middleCols(first, count),
+                     errors);
+  }
   int NumSamples() const {
     return x1_.cols();
   }
@@ -21,6 +21,7 @@
 #include "libmv/simple_pipeline/bundle.h"
 
 #include <map>
+#include <set>
 
 #include "ceres/ceres.h"
 #include "ceres/rotation.h"
@@ -164,6 +165,19 @@ struct OpenCVReprojectionError {
   const double weight_;
 };
 
+// Number of threads of the Ceres solver; a value below one means as many
+// threads as OpenMP reports, or a single one without OpenMP.
+int BundleNumThreads(const int num_threads) {
+  if (num_threads > 0) {
+    return num_threads;
+  }
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
 // Print a message to the log which camera intrinsics are gonna to be optimixed.
 void BundleIntrinsicsLogMessage(const int bundle_intrinsics) {
   if (bundle_intrinsics == BUNDLE_NO_INTRINSICS) {
@@ -379,7 +393,8 @@ void EuclideanBundlePointsOnly(const DistortionModelType distortion_model,
                                const vector<Marker> &markers,
                                vector<Vec6> &all_cameras_R_t,
                                double ceres_intrinsics[OFFSET_MAX],
-                               EuclideanReconstruction *reconstruction) {
+                               EuclideanReconstruction *reconstruction,
+                               const int num_threads) {
   ceres::Problem::Options problem_options;
   ceres::Problem problem(problem_options);
   int num_residuals = 0;
@@ -428,10 +443,8 @@ void EuclideanBundlePointsOnly(const DistortionModelType distortion_model,
   options.use_inner_iterations = true;
   options.max_num_iterations = 100;
 
-#ifdef _OPENMP
-  options.num_threads = omp_get_max_threads();
-  options.num_linear_solver_threads = omp_get_max_threads();
-#endif
+  options.num_threads = BundleNumThreads(num_threads);
+  options.num_linear_solver_threads = options.num_threads;
 
   // Solve!
   ceres::Solver::Summary summary;
@@ -444,14 +457,16 @@ void EuclideanBundlePointsOnly(const DistortionModelType distortion_model,
 }  // namespace
 
 void EuclideanBundle(const Tracks &tracks,
-                     EuclideanReconstruction *reconstruction) {
+                     EuclideanReconstruction *reconstruction,
+                     const int num_threads) {
   PolynomialCameraIntrinsics empty_intrinsics;
   EuclideanBundleCommonIntrinsics(tracks,
                                   BUNDLE_NO_INTRINSICS,
                                   BUNDLE_NO_CONSTRAINTS,
                                   reconstruction,
                                   &empty_intrinsics,
-                                  NULL);
+                                  NULL,
+                                  num_threads);
 }
 
 void EuclideanBundleCommonIntrinsics(
@@ -460,7 +475,8 @@ void EuclideanBundleCommonIntrinsics(
     const int bundle_constraints,
     EuclideanReconstruction *reconstruction,
     CameraIntrinsics *intrinsics,
-    BundleEvaluation *evaluation) {
+    BundleEvaluation *evaluation,
+    const int num_threads) {
   LG << "Original intrinsics: " << *intrinsics;
   vector<Marker> markers = tracks.AllMarkers();
 
@@ -598,10 +614,8 @@ void EuclideanBundleCommonIntrinsics(
   options.use_inner_iterations = true;
   options.max_num_iterations = 100;
 
-#ifdef _OPENMP
-  options.num_threads = omp_get_max_threads();
-  options.num_linear_solver_threads = omp_get_max_threads();
-#endif
+  options.num_threads = BundleNumThreads(num_threads);
+  options.num_linear_solver_threads = options.num_threads;
 
   // Solve!
   ceres::Solver::Summary summary;
@@ -645,7 +659,108 @@ void EuclideanBundleCommonIntrinsics(
                               zero_weight_markers,
                               all_cameras_R_t,
                               ceres_intrinsics,
-                              reconstruction);
+                              reconstruction,
+                              num_threads);
+  }
+}
+
+void EuclideanBundleLocal(const Tracks &tracks,
+                          const vector<int> &images,
+                          EuclideanReconstruction *reconstruction,
+                          const int num_threads) {
+  vector<Marker> markers = tracks.AllMarkers();
+  std::set<int> refined_images(images.begin(), images.end());
+
+  // Pack the rotations and translations of the cameras seen by the markers
+  // first, so the parameter blocks don't move while building the problem.
+  std::map<int, int> camera_blocks;
+  vector<Vec6> cameras_R_t;
+  for (int i = 0; i < markers.size(); ++i) {
+    int image = markers[i].image;
+    const EuclideanCamera *camera = reconstruction->CameraForImage(image);
+    if (camera == NULL || camera_blocks.count(image)) {
+      continue;
+    }
+    Vec6 R_t;
+    ceres::RotationMatrixToAngleAxis(&camera->R(0, 0), &R_t(0));
+    R_t.tail<3>() = camera->t;
+    camera_blocks[image] = cameras_R_t.size();
+    cameras_R_t.push_back(R_t);
+  }
+
+  // The markers are normalized, as for EuclideanBundle.
+  PolynomialCameraIntrinsics empty_intrinsics;
+  double ceres_intrinsics[OFFSET_MAX];
+  PackIntrinisicsIntoArray(empty_intrinsics, ceres_intrinsics);
+
+  ceres::Problem::Options problem_options;
+  ceres::Problem problem(problem_options);
+  int num_residuals = 0;
+  for (int i = 0; i < markers.size(); ++i) {
+    const Marker &marker = markers[i];
+    EuclideanPoint *point = reconstruction->PointForTrack(marker.track);
+    if (!camera_blocks.count(marker.image) || point == NULL ||
+        marker.weight == 0.0) {
+      continue;
+    }
+
+    double *current_camera_R_t =
+        &cameras_R_t[camera_blocks[marker.image]](0);
+    problem.AddResidualBlock(new ceres::AutoDiffCostFunction<
+        OpenCVReprojectionError, 2, OFFSET_MAX, 6, 3>(
+            new OpenCVReprojectionError(
+                empty_intrinsics.GetDistortionModelType(),
+                marker.x,
+                marker.y,
+                marker.weight)),
+        NULL,
+        ceres_intrinsics,
+        current_camera_R_t,
+        &point->X(0));
+
+    // The cameras which are not refined anchor the solution.
+    if (!refined_images.count(marker.image)) {
+      problem.SetParameterBlockConstant(current_camera_R_t);
+    }
+    num_residuals++;
+  }
+
+  LG << "Number of residuals: " << num_residuals;
+  if (!num_residuals) {
+    LG << "Skipping running minimizer with zero residuals";
+    return;
+  }
+
+  problem.SetParameterBlockConstant(ceres_intrinsics);
+
+  // Configure the solver.
+  ceres::Solver::Options options;
+  options.use_nonmonotonic_steps = true;
+  options.preconditioner_type = ceres::SCHUR_JACOBI;
+  options.linear_solver_type = ceres::ITERATIVE_SCHUR;
+  options.use_explicit_schur_complement = true;
+  options.use_inner_iterations = true;
+  options.max_num_iterations = 100;
+
+  options.num_threads = BundleNumThreads(num_threads);
+  options.num_linear_solver_threads = options.num_threads;
+
+  // Solve!
+  ceres::Solver::Summary summary;
+  ceres::Solve(options, &problem, &summary);
+
+  LG << "Final report:\n" << summary.FullReport();
+
+  // Copy the refined rotations and translations back.
+  for (std::map<int, int>::const_iterator it = camera_blocks.begin();
+       it != camera_blocks.end(); ++it) {
+    if (!refined_images.count(it->first)) {
+      continue;
+    }
+    EuclideanCamera *camera = reconstruction->CameraForImage(it->first);
+    ceres::AngleAxisToRotationMatrix(&cameras_R_t[it->second](0),
+                                     &camera->R(0, 0));
+    camera->t = cameras_R_t[it->second].tail<3>();
   }
 }
 
@@ -21,6 +21,7 @@
 #ifndef LIBMV_SIMPLE_PIPELINE_BUNDLE_H
 #define LIBMV_SIMPLE_PIPELINE_BUNDLE_H
 
+#include "libmv/base/vector.h"
 #include "libmv/numeric/numeric.h"
 
 namespace libmv {
@@ -70,10 +71,15 @@ struct BundleEvaluation {
     \note This assumes a calibrated reconstruction, e.g. the markers are
           already corrected for camera intrinsics and radial distortion.
 
+    \a num_threads is the number of threads of the solver. With a value below
+    one it uses as many threads as OpenMP reports, or a single thread when
+    libmv is built without OpenMP.
+
     \sa EuclideanResect, EuclideanIntersect, EuclideanReconstructTwoFrames
 */
 void EuclideanBundle(const Tracks &tracks,
-                     EuclideanReconstruction *reconstruction);
+                     EuclideanReconstruction *reconstruction,
+                     const int num_threads = -1);
 
 /*!
     Refine camera poses and 3D coordinates using bundle adjustment.
@@ -95,6 +101,9 @@ void EuclideanBundle(const Tracks &tracks,
     there, plus all the requested additional information (like jacobian) is
     also calculating there. Also see comments for BundleEvaluation.
 
+    \a num_threads is the number of threads of the solver, as for
+    EuclideanBundle.
+
     \note This assumes an outlier-free set of markers.
 
     \sa EuclideanResect, EuclideanIntersect, EuclideanReconstructTwoFrames
@@ -120,7 +129,33 @@ void EuclideanBundleCommonIntrinsics(
     const int bundle_constraints,
     EuclideanReconstruction *reconstruction,
     CameraIntrinsics *intrinsics,
-    BundleEvaluation *evaluation = NULL);
+    BundleEvaluation *evaluation = NULL,
+    const int num_threads = -1);
+
+/*!
+    Refine the poses of some cameras and the 3D coordinates they see using
+    bundle adjustment.
+
+    This routine adjusts the cameras of \a images and all the points seen by
+    the markers of \a tracks. The cameras of the other images of \a tracks
+    are kept constant and anchor the solution. Only \a tracks is used, so the
+    cost of the minimization depends on its size and not on the size of
+    \a *reconstruction; it is meant for a sliding window of keyframes of an
+    incremental reconstruction.
+
+    \a num_threads is the number of threads of the solver, as for
+    EuclideanBundle.
+
+    \note This assumes an outlier-free set of markers.
+    \note This assumes a calibrated reconstruction, e.g. the markers are
+          already corrected for camera intrinsics and radial distortion.
+
+    \sa EuclideanBundle, EuclideanResect, EuclideanIntersect
+*/
+void EuclideanBundleLocal(const Tracks &tracks,
+                          const vector<int> &images,
+                          EuclideanReconstruction *reconstruction,
+                          const int num_threads = -1);
 
 /*!
     Refine camera poses and 3D coordinates using bundle adjustment.
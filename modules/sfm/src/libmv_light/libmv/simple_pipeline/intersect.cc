@@ -67,7 +67,8 @@ class EuclideanIntersectCostFunctor {
 }  // namespace
 
 bool EuclideanIntersect(const vector<Marker> &markers,
-                        EuclideanReconstruction *reconstruction) {
+                        const EuclideanReconstruction &reconstruction,
+                        EuclideanPoint *point) {
   if (markers.size() < 2) {
     return false;
   }
@@ -78,7 +79,8 @@ bool EuclideanIntersect(const vector<Marker> &markers,
   vector<Mat34> cameras;
   Mat34 P;
   for (int i = 0; i < markers.size(); ++i) {
-    EuclideanCamera *camera = reconstruction->CameraForImage(markers[i].image);
+    const EuclideanCamera *camera =
+        reconstruction.CameraForImage(markers[i].image);
     P_From_KRt(K, camera->R, camera->t, &P);
     cameras.push_back(P);
   }
@@ -106,7 +108,7 @@ bool EuclideanIntersect(const vector<Marker> &markers,
     const Marker &marker = markers[i];
     if (marker.weight != 0.0) {
       const EuclideanCamera &camera =
-          *reconstruction->CameraForImage(marker.image);
+          *reconstruction.CameraForImage(marker.image);
 
       problem.AddResidualBlock(
           new ceres::AutoDiffCostFunction<
@@ -130,8 +132,8 @@ bool EuclideanIntersect(const vector<Marker> &markers,
     // optimized or not. If track is a constant zero it'll use
     // algebraic intersection result as a 3D coordinate.
 
-    Vec3 point = X.head<3>();
-    reconstruction->InsertPoint(markers[0].track, point);
+    point->track = markers[0].track;
+    point->X = X.head<3>();
 
     return true;
   }
@@ -153,7 +155,7 @@ bool EuclideanIntersect(const vector<Marker> &markers,
   // Try projecting the point; make sure it's in front of everyone.
   for (int i = 0; i < cameras.size(); ++i) {
     const EuclideanCamera &camera =
-        *reconstruction->CameraForImage(markers[i].image);
+        *reconstruction.CameraForImage(markers[i].image);
     Vec3 x = camera.R * X + camera.t;
     if (x(2) < 0) {
       LOG(ERROR) << "POINT BEHIND CAMERA " << markers[i].image
@@ -162,13 +164,23 @@ bool EuclideanIntersect(const vector<Marker> &markers,
     }
   }
 
-  Vec3 point = X.head<3>();
-  reconstruction->InsertPoint(markers[0].track, point);
+  point->track = markers[0].track;
+  point->X = X.head<3>();
 
   // TODO(keir): Add proper error checking.
   return true;
 }
 
+bool EuclideanIntersect(const vector<Marker> &markers,
+                        EuclideanReconstruction *reconstruction) {
+  EuclideanPoint point;
+  if (!EuclideanIntersect(markers, *reconstruction, &point)) {
+    return false;
+  }
+  reconstruction->InsertPoint(point.track, point.X);
+  return true;
+}
+
 namespace {
 
 struct ProjectiveIntersectCostFunction {
@@ -201,7 +213,8 @@ struct ProjectiveIntersectCostFunction {
 }  // namespace
 
 bool ProjectiveIntersect(const vector<Marker> &markers,
-                         ProjectiveReconstruction *reconstruction) {
+                         const ProjectiveReconstruction &reconstruction,
+                         ProjectivePoint *point) {
   if (markers.size() < 2) {
     return false;
   }
@@ -209,7 +222,8 @@ bool ProjectiveIntersect(const vector<Marker> &markers,
   // Get the cameras to use for the intersection.
   vector<Mat34> cameras;
   for (int i = 0; i < markers.size(); ++i) {
-    ProjectiveCamera *camera = reconstruction->CameraForImage(markers[i].image);
+    const ProjectiveCamera *camera =
+        reconstruction.CameraForImage(markers[i].image);
     cameras.push_back(camera->P);
   }
 
@@ -227,7 +241,7 @@ bool ProjectiveIntersect(const vector<Marker> &markers,
 
   typedef LevenbergMarquardt<ProjectiveIntersectCostFunction> Solver;
 
-  ProjectiveIntersectCostFunction triangulate_cost(markers, *reconstruction);
+  ProjectiveIntersectCostFunction triangulate_cost(markers, reconstruction);
   Solver::SolverParameters params;
   Solver solver(triangulate_cost);
 
@@ -237,7 +251,7 @@ bool ProjectiveIntersect(const vector<Marker> &markers,
   // Try projecting the point; make sure it's in front of everyone.
   for (int i = 0; i < cameras.size(); ++i) {
     const ProjectiveCamera &camera =
-        *reconstruction->CameraForImage(markers[i].image);
+        *reconstruction.CameraForImage(markers[i].image);
     Vec3 x = camera.P * X;
     if (x(2) < 0) {
       LOG(ERROR) << "POINT BEHIND CAMERA " << markers[i].image
@@ -245,10 +259,21 @@ bool ProjectiveIntersect(const vector<Marker> &markers,
     }
   }
 
-  reconstruction->InsertPoint(markers[0].track, X);
+  point->track = markers[0].track;
+  point->X = X;
 
   // TODO(keir): Add proper error checking.
   return true;
 }
 
+bool ProjectiveIntersect(const vector<Marker> &markers,
+                         ProjectiveReconstruction *reconstruction) {
+  ProjectivePoint point;
+  if (!ProjectiveIntersect(markers, *reconstruction, &point)) {
+    return false;
+  }
+  reconstruction->InsertPoint(point.track, point.X);
+  return true;
+}
+
 }  // namespace libmv
@@ -49,6 +49,18 @@ namespace libmv {
 bool EuclideanIntersect(const vector<Marker> &markers,
                         EuclideanReconstruction *reconstruction);
 
+/*!
+    Estimate the 3D coordinates of a track without modifying the
+    reconstruction.
+
+    This is the same as the EuclideanIntersect above, except that the new
+    point is returned in \a *point instead of being inserted in
+    \a reconstruction, so several tracks can be intersected concurrently.
+*/
+bool EuclideanIntersect(const vector<Marker> &markers,
+                        const EuclideanReconstruction &reconstruction,
+                        EuclideanPoint *point);
+
 /*!
     Estimate the homogeneous coordinates of a track by intersecting rays.
 
@@ -72,6 +84,18 @@ bool EuclideanIntersect(const vector<Marker> &markers,
 bool ProjectiveIntersect(const vector<Marker> &markers,
                          ProjectiveReconstruction *reconstruction);
 
+/*!
+    Estimate the homogeneous coordinates of a track without modifying the
+    reconstruction.
+
+    This is the same as the ProjectiveIntersect above, except that the new
+    point is returned in \a *point instead of being inserted in
+    \a reconstruction, so several tracks can be intersected concurrently.
+*/
+bool ProjectiveIntersect(const vector<Marker> &markers,
+                         const ProjectiveReconstruction &reconstruction,
+                         ProjectivePoint *point);
+
 }  // namespace libmv
 
 #endif  // LIBMV_SIMPLE_PIPELINE_INTERSECT_H
@@ -34,6 +34,10 @@
 #  define snprintf _snprintf
 #endif
 
+#ifdef _OPENMP
+#  include <omp.h>
+#endif
+
 namespace libmv {
 namespace {
 
@@ -47,18 +51,26 @@ struct EuclideanPipelineRoutines {
   typedef EuclideanPoint Point;
 
   static void Bundle(const Tracks &tracks,
-                     EuclideanReconstruction *reconstruction) {
-    EuclideanBundle(tracks, reconstruction);
+                     EuclideanReconstruction *reconstruction,
+                     int num_threads) {
+    EuclideanBundle(tracks, reconstruction, num_threads);
   }
 
   static bool Resect(const vector<Marker> &markers,
-                     EuclideanReconstruction *reconstruction, bool final_pass) {
-    return EuclideanResect(markers, reconstruction, final_pass);
+                     const EuclideanReconstruction &reconstruction,
+                     bool final_pass, EuclideanCamera *camera) {
+    return EuclideanResect(markers, reconstruction, final_pass, camera);
+  }
+
+  static void InsertCamera(const EuclideanCamera &camera,
+                           EuclideanReconstruction *reconstruction) {
+    reconstruction->InsertCamera(camera.image, camera.R, camera.t);
   }
 
   static bool Intersect(const vector<Marker> &markers,
-                        EuclideanReconstruction *reconstruction) {
-    return EuclideanIntersect(markers, reconstruction);
+                        const EuclideanReconstruction &reconstruction,
+                        EuclideanPoint *point) {
+    return EuclideanIntersect(markers, reconstruction, point);
   }
 
   static Marker ProjectMarker(const EuclideanPoint &point,
@@ -85,20 +97,30 @@ struct ProjectivePipelineRoutines {
   typedef ProjectivePoint Point;
 
   static void Bundle(const Tracks &tracks,
-                     ProjectiveReconstruction *reconstruction) {
+                     ProjectiveReconstruction *reconstruction,
+                     int num_threads) {
+    (void) num_threads;  // Ignored.
+
     ProjectiveBundle(tracks, reconstruction);
   }
 
   static bool Resect(const vector<Marker> &markers,
-                     ProjectiveReconstruction *reconstruction, bool final_pass) {
+                     const ProjectiveReconstruction &reconstruction,
+                     bool final_pass, ProjectiveCamera *camera) {
     (void) final_pass;  // Ignored.
 
-    return ProjectiveResect(markers, reconstruction);
+    return ProjectiveResect(markers, reconstruction, camera);
+  }
+
+  static void InsertCamera(const ProjectiveCamera &camera,
+                           ProjectiveReconstruction *reconstruction) {
+    reconstruction->InsertCamera(camera.image, camera.P);
   }
 
   static bool Intersect(const vector<Marker> &markers,
-                        ProjectiveReconstruction *reconstruction) {
-    return ProjectiveIntersect(markers, reconstruction);
+                        const ProjectiveReconstruction &reconstruction,
+                        ProjectivePoint *point) {
+    return ProjectiveIntersect(markers, reconstruction, point);
   }
 
   static Marker ProjectMarker(const ProjectivePoint &point,
@@ -139,11 +161,133 @@ static void CompleteReconstructionLogProgress(
   }
 }
 
+// Intersects all the tracks that have no point yet and are seen by at least
+// two reconstructed cameras. An intersection only reads the cameras, so the
+// tracks are intersected concurrently and the new points are inserted
+// afterwards in track order, which gives the same points as intersecting and
+// inserting them one after the other.
+template<typename PipelineRoutines>
+int InternalIntersectTracks(
+    const Tracks &tracks,
+    int num_threads,
+    typename PipelineRoutines::Reconstruction *reconstruction) {
+  int max_track = tracks.MaxTrack();
+  vector<vector<Marker> > reconstructed_markers(max_track + 1);
+  for (int track = 0; track <= max_track; ++track) {
+    if (reconstruction->PointForTrack(track)) {
+      LG << "Skipping point: " << track;
+      continue;
+    }
+    vector<Marker> all_markers = tracks.MarkersForTrack(track);
+    LG << "Got " << all_markers.size() << " markers for track " << track;
+
+    for (int i = 0; i < all_markers.size(); ++i) {
+      if (reconstruction->CameraForImage(all_markers[i].image)) {
+        reconstructed_markers[track].push_back(all_markers[i]);
+      }
+    }
+    LG << "Got " << reconstructed_markers[track].size()
+       << " reconstructed markers for track " << track;
+  }
+
+  const typename PipelineRoutines::Reconstruction &cameras = *reconstruction;
+  vector<typename PipelineRoutines::Point> points(max_track + 1);
+  vector<int> intersected(max_track + 1, 0);
+#ifdef _OPENMP
+#  pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+#else
+  (void) num_threads;
+#endif
+  for (int track = 0; track <= max_track; ++track) {
+    if (reconstructed_markers[track].size() >= 2) {
+      intersected[track] = PipelineRoutines::Intersect(
+          reconstructed_markers[track], cameras, &points[track]);
+    }
+  }
+
+  int num_intersects = 0;
+  for (int track = 0; track <= max_track; ++track) {
+    if (reconstructed_markers[track].size() < 2) {
+      continue;
+    }
+    if (intersected[track]) {
+      reconstruction->InsertPoint(points[track].track, points[track].X);
+      num_intersects++;
+      LG << "Ran Intersect() for track " << track;
+    } else {
+      LG << "Failed Intersect() for track " << track;
+    }
+  }
+  return num_intersects;
+}
+
+// Resects all the images that have no camera yet and see at least five
+// reconstructed points. Like the intersections above, the resections only
+// read the points, so they run concurrently and the new cameras are inserted
+// afterwards in image order.
+template<typename PipelineRoutines>
+int InternalResectImages(
+    const Tracks &tracks,
+    bool final_pass,
+    int num_threads,
+    typename PipelineRoutines::Reconstruction *reconstruction) {
+  int max_image = tracks.MaxImage();
+  vector<vector<Marker> > reconstructed_markers(max_image + 1);
+  for (int image = 0; image <= max_image; ++image) {
+    if (reconstruction->CameraForImage(image)) {
+      LG << "Skipping frame: " << image;
+      continue;
+    }
+    vector<Marker> all_markers = tracks.MarkersInImage(image);
+    LG << "Got " << all_markers.size() << " markers for image " << image;
+
+    for (int i = 0; i < all_markers.size(); ++i) {
+      if (reconstruction->PointForTrack(all_markers[i].track)) {
+        reconstructed_markers[image].push_back(all_markers[i]);
+      }
+    }
+    LG << "Got " << reconstructed_markers[image].size()
+       << " reconstructed markers for image " << image;
+  }
+
+  const typename PipelineRoutines::Reconstruction &points = *reconstruction;
+  vector<typename PipelineRoutines::Camera> cameras(max_image + 1);
+  vector<int> resected(max_image + 1, 0);
+#ifdef _OPENMP
+#  pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+#else
+  (void) num_threads;
+#endif
+  for (int image = 0; image <= max_image; ++image) {
+    if (reconstructed_markers[image].size() >= 5) {
+      resected[image] = PipelineRoutines::Resect(
+          reconstructed_markers[image], points, final_pass, &cameras[image]);
+    }
+  }
+
+  const char *pass = final_pass ? "final " : "";
+  int num_resects = 0;
+  for (int image = 0; image <= max_image; ++image) {
+    if (reconstructed_markers[image].size() < 5) {
+      continue;
+    }
+    if (resected[image]) {
+      PipelineRoutines::InsertCamera(cameras[image], reconstruction);
+      num_resects++;
+      LG << "Ran " << pass << "Resect() for image " << image;
+    } else {
+      LG << "Failed " << pass << "Resect() for image " << image;
+    }
+  }
+  return num_resects;
+}
+
 template<typename PipelineRoutines>
 void InternalCompleteReconstruction(
     const Tracks &tracks,
     typename PipelineRoutines::Reconstruction *reconstruction,
-    ProgressUpdateCallback *update_callback = NULL) {
+    ProgressUpdateCallback *update_callback = NULL,
+    int num_threads = -1) {
   int max_track = tracks.MaxTrack();
   int max_image = tracks.MaxImage();
   int num_resects = -1;
@@ -152,118 +296,59 @@ void InternalCompleteReconstruction(
   LG << "Max track: " << max_track;
   LG << "Max image: " << max_image;
   LG << "Number of markers: " << tracks.NumMarkers();
+  if (num_threads < 1) {
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#else
+    num_threads = 1;
+#endif
+  }
+  LG << "Number of threads: " << num_threads;
   while (num_resects != 0 || num_intersects != 0) {
     // Do all possible intersections.
-    num_intersects = 0;
-    for (int track = 0; track <= max_track; ++track) {
-      if (reconstruction->PointForTrack(track)) {
-        LG << "Skipping point: " << track;
-        continue;
-      }
-      vector<Marker> all_markers = tracks.MarkersForTrack(track);
-      LG << "Got " << all_markers.size() << " markers for track " << track;
-
-      vector<Marker> reconstructed_markers;
-      for (int i = 0; i < all_markers.size(); ++i) {
-        if (reconstruction->CameraForImage(all_markers[i].image)) {
-          reconstructed_markers.push_back(all_markers[i]);
-        }
-      }
-      LG << "Got " << reconstructed_markers.size()
-         << " reconstructed markers for track " << track;
-      if (reconstructed_markers.size() >= 2) {
-        CompleteReconstructionLogProgress(update_callback,
-                                          (double)tot_resects/(max_image));
-        if (PipelineRoutines::Intersect(reconstructed_markers,
-                                        reconstruction)) {
-          num_intersects++;
-          LG << "Ran Intersect() for track " << track;
-        } else {
-          LG << "Failed Intersect() for track " << track;
-        }
-      }
-    }
+    CompleteReconstructionLogProgress(update_callback,
+                                      (double)tot_resects/(max_image));
+    num_intersects = InternalIntersectTracks<PipelineRoutines>(tracks,
+                                                               num_threads,
+                                                               reconstruction);
     if (num_intersects) {
       CompleteReconstructionLogProgress(update_callback,
                                         (double)tot_resects/(max_image),
                                         "Bundling...");
-      PipelineRoutines::Bundle(tracks, reconstruction);
+      PipelineRoutines::Bundle(tracks, reconstruction, num_threads);
       LG << "Ran Bundle() after intersections.";
     }
     LG << "Did " << num_intersects << " intersects.";
 
     // Do all possible resections.
-    num_resects = 0;
-    for (int image = 0; image <= max_image; ++image) {
-      if (reconstruction->CameraForImage(image)) {
-        LG << "Skipping frame: " << image;
-        continue;
-      }
-      vector<Marker> all_markers = tracks.MarkersInImage(image);
-      LG << "Got " << all_markers.size() << " markers for image " << image;
-
-      vector<Marker> reconstructed_markers;
-      for (int i = 0; i < all_markers.size(); ++i) {
-        if (reconstruction->PointForTrack(all_markers[i].track)) {
-          reconstructed_markers.push_back(all_markers[i]);
-        }
-      }
-      LG << "Got " << reconstructed_markers.size()
-         << " reconstructed markers for image " << image;
-      if (reconstructed_markers.size() >= 5) {
-        CompleteReconstructionLogProgress(update_callback,
-                                          (double)tot_resects/(max_image));
-        if (PipelineRoutines::Resect(reconstructed_markers,
-                                     reconstruction, false)) {
-          num_resects++;
-          tot_resects++;
-          LG << "Ran Resect() for image " << image;
-        } else {
-          LG << "Failed Resect() for image " << image;
-        }
-      }
-    }
+    CompleteReconstructionLogProgress(update_callback,
+                                      (double)tot_resects/(max_image));
+    num_resects = InternalResectImages<PipelineRoutines>(tracks,
+                                                         false,
+                                                         num_threads,
+                                                         reconstruction);
+    tot_resects += num_resects;
     if (num_resects) {
       CompleteReconstructionLogProgress(update_callback,
                                         (double)tot_resects/(max_image),
                                         "Bundling...");
-      PipelineRoutines::Bundle(tracks, reconstruction);
+      PipelineRoutines::Bundle(tracks, reconstruction, num_threads);
     }
     LG << "Did " << num_resects << " resects.";
   }
 
   // One last pass...
-  num_resects = 0;
-  for (int image = 0; image <= max_image; ++image) {
-    if (reconstruction->CameraForImage(image)) {
-      LG << "Skipping frame: " << image;
-      continue;
-    }
-    vector<Marker> all_markers = tracks.MarkersInImage(image);
-
-    vector<Marker> reconstructed_markers;
-    for (int i = 0; i < all_markers.size(); ++i) {
-      if (reconstruction->PointForTrack(all_markers[i].track)) {
-        reconstructed_markers.push_back(all_markers[i]);
-      }
-    }
-    if (reconstructed_markers.size() >= 5) {
-      CompleteReconstructionLogProgress(update_callback,
-                                        (double)tot_resects/(max_image));
-      if (PipelineRoutines::Resect(reconstructed_markers,
-                                   reconstruction, true)) {
-        num_resects++;
-        LG << "Ran final Resect() for image " << image;
-      } else {
-        LG << "Failed final Resect() for image " << image;
-      }
-    }
-  }
+  CompleteReconstructionLogProgress(update_callback,
+                                    (double)tot_resects/(max_image));
+  num_resects = InternalResectImages<PipelineRoutines>(tracks,
+                                                       true,
+                                                       num_threads,
+                                                       reconstruction);
   if (num_resects) {
     CompleteReconstructionLogProgress(update_callback,
                                       (double)tot_resects/(max_image),
                                       "Bundling...");
-    PipelineRoutines::Bundle(tracks, reconstruction);
+    PipelineRoutines::Bundle(tracks, reconstruction, num_threads);
   }
 }
 
@@ -340,10 +425,12 @@ double ProjectiveReprojectionError(
 
 void EuclideanCompleteReconstruction(const Tracks &tracks,
                                      EuclideanReconstruction *reconstruction,
-                                     ProgressUpdateCallback *update_callback) {
+                                     ProgressUpdateCallback *update_callback,
+                                     int num_threads) {
   InternalCompleteReconstruction<EuclideanPipelineRoutines>(tracks,
                                                             reconstruction,
-                                                            update_callback);
+                                                            update_callback,
+                                                            num_threads);
 }
 
 void ProjectiveCompleteReconstruction(const Tracks &tracks,
@@ -43,13 +43,18 @@ namespace libmv {
     \a reconstruction should contain at least some 3D points or some estimated
     cameras. The minimum number of cameras is two (with no 3D points) and the
     minimum number of 3D points (with no estimated cameras) is 5.
+    \a num_threads is the number of threads used by the intersections, the
+    resections and the bundle adjustment. With a value below one libmv uses
+    as many threads as OpenMP reports, or a single thread when it is built
+    without OpenMP.
 
     \sa EuclideanResect, EuclideanIntersect, EuclideanBundle
 */
 void EuclideanCompleteReconstruction(
         const Tracks &tracks,
         EuclideanReconstruction *reconstruction,
-        ProgressUpdateCallback *update_callback = NULL);
+        ProgressUpdateCallback *update_callback = NULL,
+        int num_threads = -1);
 
 /*!
     Estimate camera matrices and homogeneous 3D coordinates for all frames and
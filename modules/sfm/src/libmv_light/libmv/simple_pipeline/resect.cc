@@ -92,14 +92,15 @@ struct EuclideanResectCostFunction {
 }  // namespace
 
 bool EuclideanResect(const vector<Marker> &markers,
-                     EuclideanReconstruction *reconstruction, bool final_pass) {
+                     const EuclideanReconstruction &reconstruction,
+                     bool final_pass, EuclideanCamera *camera) {
   if (markers.size() < 5) {
     return false;
   }
   Mat2X points_2d = PointMatrixFromMarkers(markers);
   Mat3X points_3d(3, markers.size());
   for (int i = 0; i < markers.size(); i++) {
-    points_3d.col(i) = reconstruction->PointForTrack(markers[i].track)->X;
+    points_3d.col(i) = reconstruction.PointForTrack(markers[i].track)->X;
   }
   LG << "Points for resect:\n" << points_2d;
 
@@ -154,7 +155,7 @@ bool EuclideanResect(const vector<Marker> &markers,
   typedef LevenbergMarquardt<EuclideanResectCostFunction> Solver;
 
   // Give the cost our initial guess for R.
-  EuclideanResectCostFunction resect_cost(markers, *reconstruction, R);
+  EuclideanResectCostFunction resect_cost(markers, reconstruction, R);
 
   // Encode the initial parameters: start with zero delta rotation, and the
   // guess for t obtained from resection.
@@ -174,7 +175,19 @@ bool EuclideanResect(const vector<Marker> &markers,
 
   LG << "Resection for image " << markers[0].image << " got:\n"
      << "R:\n" << R << "\nt:\n" << t;
-  reconstruction->InsertCamera(markers[0].image, R, t);
+  camera->image = markers[0].image;
+  camera->R = R;
+  camera->t = t;
+  return true;
+}
+
+bool EuclideanResect(const vector<Marker> &markers,
+                     EuclideanReconstruction *reconstruction, bool final_pass) {
+  EuclideanCamera camera;
+  if (!EuclideanResect(markers, *reconstruction, final_pass, &camera)) {
+    return false;
+  }
+  reconstruction->InsertCamera(camera.image, camera.R, camera.t);
   return true;
 }
 
@@ -219,7 +232,8 @@ struct ProjectiveResectCostFunction {
 }  // namespace
 
 bool ProjectiveResect(const vector<Marker> &markers,
-                      ProjectiveReconstruction *reconstruction) {
+                      const ProjectiveReconstruction &reconstruction,
+                      ProjectiveCamera *camera) {
   if (markers.size() < 5) {
     return false;
   }
@@ -229,7 +243,7 @@ bool ProjectiveResect(const vector<Marker> &markers,
   Mat4X points_3d_homogeneous(4, markers.size());
   for (int i = 0; i < markers.size(); i++) {
     points_3d_homogeneous.col(i) =
-        reconstruction->PointForTrack(markers[i].track)->X;
+        reconstruction.PointForTrack(markers[i].track)->X;
   }
   LG << "Points for resect:\n" << points_2d;
 
@@ -248,7 +262,7 @@ bool ProjectiveResect(const vector<Marker> &markers,
   // Refine the resulting projection matrix using geometric error.
   typedef LevenbergMarquardt<ProjectiveResectCostFunction> Solver;
 
-  ProjectiveResectCostFunction resect_cost(markers, *reconstruction);
+  ProjectiveResectCostFunction resect_cost(markers, reconstruction);
 
   // Pack the initial P matrix into a size-12 vector..
   Vec12 vector_P = Map<Vec12>(P.data());
@@ -264,7 +278,18 @@ bool ProjectiveResect(const vector<Marker> &markers,
 
   LG << "Resection for image " << markers[0].image << " got:\n"
      << "P:\n" << P;
-  reconstruction->InsertCamera(markers[0].image, P);
+  camera->image = markers[0].image;
+  camera->P = P;
+  return true;
+}
+
+bool ProjectiveResect(const vector<Marker> &markers,
+                      ProjectiveReconstruction *reconstruction) {
+  ProjectiveCamera camera;
+  if (!ProjectiveResect(markers, *reconstruction, &camera)) {
+    return false;
+  }
+  reconstruction->InsertCamera(camera.image, camera.P);
   return true;
 }
 }  // namespace libmv
@@ -54,6 +54,18 @@ namespace libmv {
 bool EuclideanResect(const vector<Marker> &markers,
                      EuclideanReconstruction *reconstruction, bool final_pass);
 
+/*!
+    Estimate the Euclidean pose of a camera without modifying the
+    reconstruction.
+
+    This is the same as the EuclideanResect above, except that the new camera
+    is returned in \a *camera instead of being inserted in \a reconstruction,
+    so several images can be resected concurrently.
+*/
+bool EuclideanResect(const vector<Marker> &markers,
+                     const EuclideanReconstruction &reconstruction,
+                     bool final_pass, EuclideanCamera *camera);
+
 /*!
     Estimate the projective pose of a camera from 2D to 3D correspondences.
 
@@ -81,6 +93,18 @@ bool EuclideanResect(const vector<Marker> &markers,
 bool ProjectiveResect(const vector<Marker> &markers,
                       ProjectiveReconstruction *reconstruction);
 
+/*!
+    Estimate the projective pose of a camera without modifying the
+    reconstruction.
+
+    This is the same as the ProjectiveResect above, except that the new camera
+    is returned in \a *camera instead of being inserted in \a reconstruction,
+    so several images can be resected concurrently.
+*/
+bool ProjectiveResect(const vector<Marker> &markers,
+                      const ProjectiveReconstruction &reconstruction,
+                      ProjectiveCamera *camera);
+
 }  // namespace libmv
 
 #endif  // LIBMV_SIMPLE_PIPELINE_RESECT_H
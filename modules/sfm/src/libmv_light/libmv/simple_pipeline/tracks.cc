@@ -23,30 +23,106 @@
 #include <algorithm>
 #include <vector>
 #include <iterator>
+#include <utility>
 
 #include "libmv/numeric/numeric.h"
 
 namespace libmv {
 
-Tracks::Tracks(const Tracks &other) {
-  markers_ = other.markers_;
+Tracks::Tracks() : num_indexed_(0), max_image_(0), max_track_(0) {
+  BuildIndex();
 }
 
-Tracks::Tracks(const vector<Marker> &markers) : markers_(markers) {}
+Tracks::Tracks(const Tracks &other) : markers_(other.markers_) {
+  BuildIndex();
+}
 
-void Tracks::Insert(int image, int track, double x, double y, double weight) {
-  // TODO(keir): Wow, this is quadratic for repeated insertions. Fix this by
-  // adding a smarter data structure like a set<>.
+Tracks::Tracks(const vector<Marker> &markers) : markers_(markers) {
+  BuildIndex();
+}
+
+Tracks &Tracks::operator=(const Tracks &other) {
+  if (this != &other) {
+    markers_ = other.markers_;
+    BuildIndex();
+  }
+  return *this;
+}
+
+void Tracks::BuildIndex() const {
+  max_image_ = 0;
+  max_track_ = 0;
+  for (int i = 0; i < markers_.size(); ++i) {
+    max_image_ = std::max(markers_[i].image, max_image_);
+    max_track_ = std::max(markers_[i].track, max_track_);
+  }
+
+  // Counting sort of the marker positions by image and by track, which keeps
+  // the positions of an image or of a track in increasing order.
+  image_offsets_.assign(max_image_ + 2, 0);
+  track_offsets_.assign(max_track_ + 2, 0);
+  for (int i = 0; i < markers_.size(); ++i) {
+    if (markers_[i].image >= 0 && markers_[i].track >= 0) {
+      ++image_offsets_[markers_[i].image + 1];
+      ++track_offsets_[markers_[i].track + 1];
+    }
+  }
+  for (int i = 0; i <= max_image_; ++i) {
+    image_offsets_[i + 1] += image_offsets_[i];
+  }
+  for (int i = 0; i <= max_track_; ++i) {
+    track_offsets_[i + 1] += track_offsets_[i];
+  }
+
+  image_markers_.resize(image_offsets_.back());
+  track_markers_.resize(track_offsets_.back());
+  std::vector<int> image_next(image_offsets_.begin(), image_offsets_.end() - 1);
+  std::vector<int> track_next(track_offsets_.begin(), track_offsets_.end() - 1);
   for (int i = 0; i < markers_.size(); ++i) {
-    if (markers_[i].image == image &&
-        markers_[i].track == track) {
-      markers_[i].x = x;
-      markers_[i].y = y;
-      return;
+    if (markers_[i].image >= 0 && markers_[i].track >= 0) {
+      image_markers_[image_next[markers_[i].image]++] = i;
+      track_markers_[track_next[markers_[i].track]++] = i;
+    }
+  }
+  num_indexed_ = markers_.size();
+}
+
+void Tracks::EnsureIndex() const {
+  if (num_indexed_ != markers_.size()) {
+    BuildIndex();
+  }
+}
+
+int Tracks::Find(int image, int track) const {
+  if (image >= 0 && image <= max_image_) {
+    for (int k = image_offsets_[image]; k < image_offsets_[image + 1]; ++k) {
+      if (markers_[image_markers_[k]].track == track) {
+        return image_markers_[k];
+      }
     }
   }
+  // The markers inserted since the index was built.
+  for (int i = num_indexed_; i < markers_.size(); ++i) {
+    if (markers_[i].image == image && markers_[i].track == track) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void Tracks::Insert(int image, int track, double x, double y, double weight) {
+  int i = Find(image, track);
+  if (i >= 0) {
+    markers_[i].x = x;
+    markers_[i].y = y;
+    return;
+  }
   Marker marker = { image, track, x, y, weight };
   markers_.push_back(marker);
+  // Bound the markers that Find() scans linearly.
+  if (markers_.size() - num_indexed_ >= 256) {
+    BuildIndex();
+  }
 }
 
 vector<Marker> Tracks::AllMarkers() const {
@@ -54,73 +130,113 @@ vector<Marker> Tracks::AllMarkers() const {
 }
 
 vector<Marker> Tracks::MarkersInImage(int image) const {
+  EnsureIndex();
   vector<Marker> markers;
-  for (int i = 0; i < markers_.size(); ++i) {
-    if (image == markers_[i].image) {
-      markers.push_back(markers_[i]);
+  if (image >= 0 && image <= max_image_) {
+    markers.reserve(image_offsets_[image + 1] - image_offsets_[image]);
+    for (int k = image_offsets_[image]; k < image_offsets_[image + 1]; ++k) {
+      markers.push_back(markers_[image_markers_[k]]);
     }
   }
   return markers;
 }
 
 vector<Marker> Tracks::MarkersForTrack(int track) const {
+  EnsureIndex();
   vector<Marker> markers;
-  for (int i = 0; i < markers_.size(); ++i) {
-    if (track == markers_[i].track) {
-      markers.push_back(markers_[i]);
+  if (track >= 0 && track <= max_track_) {
+    markers.reserve(track_offsets_[track + 1] - track_offsets_[track]);
+    for (int k = track_offsets_[track]; k < track_offsets_[track + 1]; ++k) {
+      markers.push_back(markers_[track_markers_[k]]);
     }
   }
   return markers;
 }
 
 vector<Marker> Tracks::MarkersInBothImages(int image1, int image2) const {
+  EnsureIndex();
+  // Merge the positions of both images, so that the markers keep their order.
+  std::vector<int> positions;
+  if (image1 >= 0 && image1 <= max_image_) {
+    positions.insert(positions.end(),
+                     image_markers_.begin() + image_offsets_[image1],
+                     image_markers_.begin() + image_offsets_[image1 + 1]);
+  }
+  if (image2 != image1 && image2 >= 0 && image2 <= max_image_) {
+    const int middle = positions.size();
+    positions.insert(positions.end(),
+                     image_markers_.begin() + image_offsets_[image2],
+                     image_markers_.begin() + image_offsets_[image2 + 1]);
+    std::inplace_merge(positions.begin(), positions.begin() + middle,
+                       positions.end());
+  }
+
   vector<Marker> markers;
-  for (int i = 0; i < markers_.size(); ++i) {
-    int image = markers_[i].image;
-    if (image == image1 || image == image2)
-      markers.push_back(markers_[i]);
+  markers.reserve(positions.size());
+  for (int i = 0; i < positions.size(); ++i) {
+    markers.push_back(markers_[positions[i]]);
   }
   return markers;
 }
 
 vector<Marker> Tracks::MarkersForTracksInBothImages(int image1,
                                                     int image2) const {
-  std::vector<int> image1_tracks;
-  std::vector<int> image2_tracks;
-
-  for (int i = 0; i < markers_.size(); ++i) {
-    int image = markers_[i].image;
-    if (image == image1) {
-      image1_tracks.push_back(markers_[i].track);
-    } else if (image == image2) {
-      image2_tracks.push_back(markers_[i].track);
-    }
+  EnsureIndex();
+  vector<Marker> markers;
+  if (image1 < 0 || image1 > max_image_ || image2 < 0 || image2 > max_image_) {
+    return markers;
+  }
+  if (image1 == image2) {
+    return MarkersInImage(image1);
   }
 
+  // The (track, position) of the markers of both images, sorted by track.
+  std::vector<std::pair<int, int> > image1_tracks, image2_tracks;
+  for (int k = image_offsets_[image1]; k < image_offsets_[image1 + 1]; ++k) {
+    const int i = image_markers_[k];
+    image1_tracks.push_back(std::make_pair(markers_[i].track, i));
+  }
+  for (int k = image_offsets_[image2]; k < image_offsets_[image2 + 1]; ++k) {
+    const int i = image_markers_[k];
+    image2_tracks.push_back(std::make_pair(markers_[i].track, i));
+  }
   std::sort(image1_tracks.begin(), image1_tracks.end());
   std::sort(image2_tracks.begin(), image2_tracks.end());
 
-  std::vector<int> intersection;
-  std::set_intersection(image1_tracks.begin(), image1_tracks.end(),
-                        image2_tracks.begin(), image2_tracks.end(),
-                        std::back_inserter(intersection));
-
-  vector<Marker> markers;
-  for (int i = 0; i < markers_.size(); ++i) {
-    if ((markers_[i].image == image1 || markers_[i].image == image2) &&
-        std::binary_search(intersection.begin(), intersection.end(),
-                           markers_[i].track)) {
-      markers.push_back(markers_[i]);
+  // Keep the markers of the common tracks, in their order.
+  std::vector<int> positions;
+  int k1 = 0, k2 = 0;
+  while (k1 < image1_tracks.size() && k2 < image2_tracks.size()) {
+    const int track1 = image1_tracks[k1].first;
+    const int track2 = image2_tracks[k2].first;
+    if (track1 < track2) {
+      ++k1;
+    } else if (track2 < track1) {
+      ++k2;
+    } else {
+      for (; k1 < image1_tracks.size() && image1_tracks[k1].first == track1;
+           ++k1) {
+        positions.push_back(image1_tracks[k1].second);
+      }
+      for (; k2 < image2_tracks.size() && image2_tracks[k2].first == track1;
+           ++k2) {
+        positions.push_back(image2_tracks[k2].second);
+      }
     }
   }
+  std::sort(positions.begin(), positions.end());
+
+  markers.reserve(positions.size());
+  for (int i = 0; i < positions.size(); ++i) {
+    markers.push_back(markers_[positions[i]]);
+  }
   return markers;
 }
 
 Marker Tracks::MarkerInImageForTrack(int image, int track) const {
-  for (int i = 0; i < markers_.size(); ++i) {
-    if (markers_[i].image == image && markers_[i].track == track) {
-      return markers_[i];
-    }
+  int i = Find(image, track);
+  if (i >= 0) {
+    return markers_[i];
   }
   Marker null = { -1, -1, -1, -1, 0.0 };
   return null;
@@ -134,6 +250,7 @@ void Tracks::RemoveMarkersForTrack(int track) {
     }
   }
   markers_.resize(size);
+  BuildIndex();
 }
 
 void Tracks::RemoveMarker(int image, int track) {
@@ -144,24 +261,17 @@ void Tracks::RemoveMarker(int image, int track) {
     }
   }
   markers_.resize(size);
+  BuildIndex();
 }
 
 int Tracks::MaxImage() const {
-  // TODO(MatthiasF): maintain a max_image_ member (updated on Insert)
-  int max_image = 0;
-  for (int i = 0; i < markers_.size(); ++i) {
-    max_image = std::max(markers_[i].image, max_image);
-  }
-  return max_image;
+  EnsureIndex();
+  return max_image_;
 }
 
 int Tracks::MaxTrack() const {
-  // TODO(MatthiasF): maintain a max_track_ member (updated on Insert)
-  int max_track = 0;
-  for (int i = 0; i < markers_.size(); ++i) {
-    max_track = std::max(markers_[i].track, max_track);
-  }
-  return max_track;
+  EnsureIndex();
+  return max_track_;
 }
 
 int Tracks::NumMarkers() const {
@@ -21,6 +21,8 @@
 #ifndef LIBMV_SIMPLE_PIPELINE_TRACKS_H_
 #define LIBMV_SIMPLE_PIPELINE_TRACKS_H_
 
+#include <vector>
+
 #include "libmv/base/vector.h"
 #include "libmv/numeric/numeric.h"
 
@@ -57,12 +59,17 @@ struct Marker {
 
     The container has several fast lookups for queries typically needed for
     structure from motion algorithms, such as \l MarkersForTracksInBothImages().
+    They use an index of the markers of every image and of every track, in
+    compressed rows, which is rebuilt by the first query after new markers
+    were inserted. Building the object from a vector of markers is cheaper
+    than inserting them one by one. Querying the same object from several threads is only safe
+    when it was not modified since its last query or its construction.
 
     \sa Marker
 */
 class Tracks {
  public:
-  Tracks() { }
+  Tracks();
 
   // Copy constructor for a tracks object.
   Tracks(const Tracks &other);
@@ -125,8 +132,26 @@ class Tracks {
   /// Returns the number of markers.
   int NumMarkers() const;
 
+  Tracks &operator=(const Tracks &other);
+
  private:
+  // Rebuilds the index when markers were inserted since it was built.
+  void EnsureIndex() const;
+  void BuildIndex() const;
+
+  // Returns the position of the marker of \a track in \a image, or -1.
+  int Find(int image, int track) const;
+
   vector<Marker> markers_;
+
+  // The positions of the markers of image i are
+  // image_markers_[image_offsets_[i]] ... image_markers_[image_offsets_[i + 1] - 1],
+  // in increasing order, and similarly for the tracks. Only the first
+  // num_indexed_ markers are indexed.
+  mutable std::vector<int> image_offsets_, image_markers_;
+  mutable std::vector<int> track_offsets_, track_markers_;
+  mutable int num_indexed_;
+  mutable int max_image_, max_track_;
 };
 
 void CoordinatesForMarkersInImage(const vector<Marker> &markers,
@@ -55,15 +55,24 @@ namespace sfm
 void
 parser_2D_tracks( const std::vector<Mat> &points2d, libmv::Tracks &tracks )
 {
+  // Every (frame, track) appears once, so the new markers are collected and
+  // indexed at once instead of being inserted one by one.
+  libmv::vector<libmv::Marker> markers = tracks.AllMarkers();
   const int nframes = static_cast<int>(points2d.size());
   for (int frame = 0; frame < nframes; ++frame) {
-    const int ntracks = points2d[frame].cols;
+    CV_Assert( points2d[frame].rows == 2 );
+    const Mat_<double> frame_pts = points2d[frame];
+    const double *xs = frame_pts[0], *ys = frame_pts[1];
+    const int ntracks = frame_pts.cols;
     for (int track = 0; track < ntracks; ++track) {
-      const Vec2d track_pt = points2d[frame].col(track);
-      if ( track_pt[0] > 0 && track_pt[1] > 0 )
-        tracks.Insert(frame, track, track_pt[0], track_pt[1]);
+      if ( xs[track] > 0 && ys[track] > 0 )
+      {
+        libmv::Marker marker = { frame, track, xs[track], ys[track], 1.0 };
+        markers.push_back(marker);
+      }
     }
   }
+  tracks = libmv::Tracks(markers);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -149,8 +158,10 @@ class SFMLibmvReconstructionImpl : public T
 public:
   SFMLibmvReconstructionImpl(const libmv_CameraIntrinsicsOptions &camera_instrinsic_options,
                              const libmv_ReconstructionOptions &reconstruction_options) :
+    libmv_reconstruction_(),
     libmv_reconstruction_options_(reconstruction_options),
-    libmv_camera_intrinsics_options_(camera_instrinsic_options) {}
+    libmv_camera_intrinsics_options_(camera_instrinsic_options),
+    logging_initialized_(false) {}
 
   /* Run the pipeline given 2d points
    */
@@ -166,20 +177,20 @@ public:
     parser_2D_tracks(points2d, tracks);
 
     // Set libmv logs level
-    libmv_initLogging("");
-
-    if (libmv_reconstruction_options_.verbosity_level >= 0)
-    {
-      libmv_startDebugLogging();
-      libmv_setLoggingVerbosity(
-        libmv_reconstruction_options_.verbosity_level);
-    }
+    setupLogging();
 
     // Perform reconstruction
     libmv_reconstruction_ =
       *libmv_solveReconstruction(tracks,
                                  &libmv_camera_intrinsics_options_,
                                  &libmv_reconstruction_options_);
+
+    // The next frames of addFrame() follow these ones
+    libmv_seedIncrementalReconstruction(tracks,
+                                        (int)points2d.size(),
+                                        &libmv_reconstruction_options_,
+                                        libmv_reconstruction_,
+                                        &libmv_incremental_);
   }
 
   virtual void run(InputArrayOfArrays points2d, InputOutputArray K, OutputArray Rs,
@@ -199,14 +210,7 @@ public:
   virtual void run(const std::vector <std::string> &images)
   {
     // Set libmv logs level
-    libmv_initLogging("");
-
-    if (libmv_reconstruction_options_.verbosity_level >= 0)
-    {
-      libmv_startDebugLogging();
-      libmv_setLoggingVerbosity(
-        libmv_reconstruction_options_.verbosity_level);
-    }
+    setupLogging();
 
     // Perform reconstruction
 
@@ -214,6 +218,13 @@ public:
       *libmv_solveReconstructionImpl(images,
                                      &libmv_camera_intrinsics_options_,
                                      &libmv_reconstruction_options_);
+
+    // The next frames of addFrame() follow these ones
+    libmv_seedIncrementalReconstruction(libmv_reconstruction_.tracks,
+                                        (int)images.size(),
+                                        &libmv_reconstruction_options_,
+                                        libmv_reconstruction_,
+                                        &libmv_incremental_);
   }
 
 
@@ -227,6 +238,37 @@ public:
     extractLibmvReconstructionData(K, Rs, Ts, points3d);
   }
 
+  /* Add a frame to the reconstruction given its 2d points
+   */
+
+  virtual void addFrame(InputArray _points2d)
+  {
+    Mat points2d = _points2d.getMat();
+    CV_Assert( points2d.empty() || (points2d.rows == 2 && points2d.channels() == 1) );
+    if (!points2d.empty() && points2d.depth() != CV_64F)
+      points2d.convertTo(points2d, CV_64F);
+
+    const int image = libmv_incremental_.num_frames;
+    libmv::vector<Marker> markers;
+    for (int track = 0; track < points2d.cols; ++track)
+    {
+      const double x = points2d.at<double>(0, track), y = points2d.at<double>(1, track);
+      if ( x > 0 && y > 0 )
+      {
+        Marker marker = { image, track, x, y, 1.0 };
+        markers.push_back(marker);
+      }
+    }
+
+    setupLogging();
+
+    libmv_addFrameToReconstruction(markers,
+                                   &libmv_camera_intrinsics_options_,
+                                   &libmv_reconstruction_options_,
+                                   &libmv_incremental_,
+                                   &libmv_reconstruction_);
+  }
+
   virtual double getError() const { return libmv_reconstruction_.error; }
 
   virtual void
@@ -284,6 +326,24 @@ public:
 
 private:
 
+  void
+  setupLogging()
+  {
+    // glog can only be initialized once
+    if (!logging_initialized_)
+    {
+      libmv_initLogging("");
+      logging_initialized_ = true;
+    }
+
+    if (libmv_reconstruction_options_.verbosity_level >= 0)
+    {
+      libmv_startDebugLogging();
+      libmv_setLoggingVerbosity(
+        libmv_reconstruction_options_.verbosity_level);
+    }
+  }
+
   void
   extractLibmvReconstructionData(InputOutputArray K,
                                  OutputArray Rs,
@@ -296,8 +356,10 @@ private:
   }
 
   libmv_Reconstruction libmv_reconstruction_;
+  libmv_IncrementalReconstruction libmv_incremental_;
   libmv_ReconstructionOptions libmv_reconstruction_options_;
   libmv_CameraIntrinsicsOptions libmv_camera_intrinsics_options_;
+  bool logging_initialized_;
 };
 
 ///////////////////////////////////////////////////////////////////////////////////////////////
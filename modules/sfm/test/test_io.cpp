@@ -0,0 +1,77 @@
+/*
+ * Software License Agreement (BSD License)
+ *
+ *  Copyright (c) 2009, Willow Garage, Inc.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above
+ *     copyright notice, this list of conditions and the following
+ *     disclaimer in the documentation and/or other materials provided
+ *     with the distribution.
+ *   * Neither the name of Willow Garage, Inc. nor the names of its
+ *     contributors may be used to endorse or promote products derived
+ *     from this software without specific prior written permission.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ *  FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ *  COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ *  INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ *  BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ *  LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ *  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ *  LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ *  ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ *  POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <opencv2/calib3d.hpp>
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace cv::sfm;
+using namespace std;
+
+
+TEST(Sfm_io, binary_reconstruction)
+{
+    std::vector<Mat> Rs, Ts;
+    Matx33d K(800, 0, 320, 0, 800, 240, 0, 0, 1);
+    for (int i = 0; i < 3; ++i)
+    {
+        Mat R;
+        Rodrigues(Vec3d(0.1 * i, -0.2, 0.05 * i), R);
+        Rs.push_back(R);
+        Ts.push_back(Mat(Vec3d(i, 2.0 * i, -1.0)));
+    }
+    Mat_<double> points3d(3, 5);
+    randu(points3d, -10, 10);
+
+    std::string filename = cv::tempfile(".bin");
+    exportReconstruction(filename, Rs, Ts, K, points3d);
+
+    std::vector<Mat> Rs_loaded, Ts_loaded, Ks_loaded, points3d_loaded;
+    importReconstruction(filename, Rs_loaded, Ts_loaded, Ks_loaded, points3d_loaded, SFM_IO_BINARY);
+    remove(filename.c_str());
+
+    ASSERT_EQ(Rs.size(), Rs_loaded.size());
+    ASSERT_EQ(Rs.size(), Ks_loaded.size());
+    for (size_t i = 0; i < Rs.size(); ++i)
+    {
+        EXPECT_EQ(0, cvtest::norm(Rs[i], Rs_loaded[i].reshape(1, 3), NORM_INF));
+        EXPECT_EQ(0, cvtest::norm(Ts[i], Ts_loaded[i].reshape(1, 3), NORM_INF));
+        EXPECT_EQ(0, cvtest::norm(Mat(K), Ks_loaded[i].reshape(1, 3), NORM_INF));
+    }
+    ASSERT_EQ(points3d.cols, (int)points3d_loaded.size());
+    for (int i = 0; i < points3d.cols; ++i)
+        EXPECT_EQ(0, cvtest::norm(points3d.col(i), points3d_loaded[i].reshape(1, 3), NORM_INF));
+}
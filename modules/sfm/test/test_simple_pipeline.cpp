@@ -86,4 +86,42 @@ TEST(Sfm_simple_pipeline, backyard)
                               // UPDATE:  1.38894
 }
 
+TEST(Sfm_simple_pipeline, backyard_incremental)
+{
+    string trackFilename =
+      string(TS::ptr()->get_data_path()) + SFM_DIR + "/" + TRACK_FILENAME;
+
+    std::vector<Mat> points2d;
+    parser_2D_tracks( trackFilename, points2d );
+
+    // The batch reconstruction needs the initial keyframes
+    int keyframe1 = 1, keyframe2 = 30;
+    const size_t nbatch = std::max<size_t>(keyframe2 + 1, points2d.size() / 2);
+    ASSERT_GT( points2d.size(), nbatch );
+
+    double focal_length = 860.986572265625;
+    double principal_x = 400, principal_y = 225, k1 = -0.158, k2 = 0.131, k3 = 0;
+
+    int refine_intrinsics = SFM_REFINE_FOCAL_LENGTH | SFM_REFINE_PRINCIPAL_POINT | SFM_REFINE_RADIAL_DISTORTION_K1 | SFM_REFINE_RADIAL_DISTORTION_K2;
+    libmv_CameraIntrinsicsOptions camera_instrinsic_options =
+      libmv_CameraIntrinsicsOptions(SFM_DISTORTION_MODEL_POLYNOMIAL,
+                                    focal_length, principal_x, principal_y,
+                                    k1, k2, k3);
+    libmv_ReconstructionOptions reconstruction_options(keyframe1, keyframe2, refine_intrinsics, 0, -1);
+
+    Ptr<SFMLibmvEuclideanReconstruction> euclidean_reconstruction =
+        SFMLibmvEuclideanReconstruction::create(camera_instrinsic_options, reconstruction_options);
+
+    // Reconstruct the first frames, then add the others one by one
+    std::vector<Mat> batch(points2d.begin(), points2d.begin() + nbatch);
+    euclidean_reconstruction->run(batch);
+    for (size_t i = nbatch; i < points2d.size(); ++i)
+        euclidean_reconstruction->addFrame(points2d[i]);
+
+    std::vector<Mat> Rs, Ts;
+    euclidean_reconstruction->getCameras(Rs, Ts);
+    EXPECT_EQ( points2d.size(), Rs.size() );
+    EXPECT_LE( euclidean_reconstruction->getError(), 2.0 );
+}
+
 #endif /* CERES_FOUND */
@@ -184,7 +184,8 @@ namespace cv
 
         -   By default, the algorithm is single-pass, which means that you consider only 5 directions
         instead of 8. Set mode=StereoSGBM::MODE_HH in createStereoSGBM to run the full variant of the
-        algorithm but beware that it may consume a lot of memory.
+        algorithm but beware that it may consume a lot of memory. MODE_HH_STRIPES runs the full variant
+        on overlapping stripes of rows in parallel, its memory only grows with the stripe height.
         -   The algorithm matches blocks, not individual pixels. Though, setting blockSize=1 reduces the
         blocks to single pixels.
         -   Mutual information cost function is not implemented. Instead, a simpler Birchfield-Tomasi
@@ -203,7 +204,8 @@ namespace cv
             enum
             {
                 MODE_SGBM = 0,
-                MODE_HH   = 1
+                MODE_HH   = 1,
+                MODE_HH_STRIPES = 2
             };
 
             virtual int getPreFilterCap() const = 0;
@@ -261,7 +263,10 @@ namespace cv
             Normally, 1 or 2 is good enough.
             @param mode Set it to StereoSGBM::MODE_HH to run the full-scale two-pass dynamic programming
             algorithm. It will consume O(W\*H\*numDisparities) bytes, which is large for 640x480 stereo and
-            huge for HD-size pictures. By default, it is set to false .
+            huge for HD-size pictures. By default, it is set to false . StereoSGBM::MODE_HH_STRIPES runs the
+            same algorithm independently on overlapping stripes of rows, in parallel and with
+            O(W\*numDisparities) bytes per thread. The paths crossing a stripe only start in its overlap, so
+            the result is close to but not the same as with MODE_HH.
 
             The first constructor initializes StereoSGBM with all the default parameters. So, you only have to
             set StereoSGBM::numDisparities at minimum. The second constructor enables you to set each parameter
@@ -45,6 +45,7 @@
 *                                                                                                                 *
 \******************************************************************************************************************/
 #include <stdint.h>
+#include "opencv2/core/hal/intrin.hpp"
 
 #ifndef _OPENCV_MATCHING_HPP_
 #define _OPENCV_MATCHING_HPP_
@@ -63,8 +64,6 @@ namespace cv
             int scallingFactor;
             //!the confidence to which a min disparity found is good or not
             double confidenceCheck;
-            //!the LUT used in case SSE is not available
-            int hamLut[65537];
             //!function used for getting the minimum disparity from the cost volume"
             static int minim(short *c, int iwpj, int widthDisp,const double confidence, const int search_region)
             {
@@ -128,20 +127,92 @@ namespace cv
                     p = winDisp + p;
                 return p;
             }
-            //!a pre processing function that generates the Hamming LUT in case the algorithm will ever be used on platform where SSE is not available
-            void hammingLut()
+            //!the number of set bits, used when the hardware popcount is not available
+            static inline int hammingWeight(int val)
             {
-                for (int i = 0; i <= 65536; i++)
+                unsigned v = (unsigned)val;
+                v = v - ((v >> 1) & 0x55555555u);
+                v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+                return (int)((((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+            }
+            //!compare and exchange of two values, used by the median sorting network
+            template <typename V>
+            static inline void sortPair(V &a, V &b)
+            {
+                V t = a;
+                a = std::min(t, b);
+                b = std::max(t, b);
+            }
+#if CV_SIMD128
+            static inline void sortPair(v_uint8x16 &a, v_uint8x16 &b)
+            {
+                v_uint8x16 t = a;
+                a = v_min(t, b);
+                b = v_max(t, b);
+            }
+            static inline void sortPair(v_int16x8 &a, v_int16x8 &b)
+            {
+                v_int16x8 t = a;
+                a = v_min(t, b);
+                b = v_max(t, b);
+            }
+#endif
+            //!the median of 9 values with a network of 19 compare and exchanges, the values are reordered
+            template <typename V>
+            static inline V median9(V *p)
+            {
+                sortPair(p[1], p[2]); sortPair(p[4], p[5]); sortPair(p[7], p[8]);
+                sortPair(p[0], p[1]); sortPair(p[3], p[4]); sortPair(p[6], p[7]);
+                sortPair(p[1], p[2]); sortPair(p[4], p[5]); sortPair(p[7], p[8]);
+                sortPair(p[0], p[3]); sortPair(p[5], p[8]); sortPair(p[4], p[7]);
+                sortPair(p[3], p[6]); sortPair(p[1], p[4]); sortPair(p[2], p[5]);
+                sortPair(p[4], p[7]); sortPair(p[4], p[2]); sortPair(p[6], p[4]);
+                sortPair(p[4], p[2]);
+                return p[4];
+            }
+            //!the vectorized part of median9Row, returns the number of computed elements
+            template <typename T>
+            static int median9RowSimd(const T *, int, T *, int)
+            {
+                return 0;
+            }
+#if CV_SIMD128
+            static int median9RowSimd(const uint8_t *src, int stride, uint8_t *dst, int len)
+            {
+                int n = 0;
+                for (; n <= len - 16; n += 16)
                 {
-                    int dist = 0;
-                    int j = i;
-                    //we number the bits from our number
-                    while (j)
-                    {
-                        dist = dist + 1;
-                        j = j & (j - 1);
-                    }
-                    hamLut[i] = dist;
+                    v_uint8x16 p[9];
+                    for (int k = 0; k < 9; k++)
+                        p[k] = v_load(src + n + k * stride);
+                    v_store(dst + n, median9(p));
+                }
+                return n;
+            }
+            static int median9RowSimd(const short *src, int stride, short *dst, int len)
+            {
+                int n = 0;
+                for (; n <= len - 8; n += 8)
+                {
+                    v_int16x8 p[9];
+                    for (int k = 0; k < 9; k++)
+                        p[k] = v_load(src + n + k * stride);
+                    v_store(dst + n, median9(p));
+                }
+                return n;
+            }
+#endif
+            //!dst[n] is the median of src[n + k * stride], k = 0..8, for the len elements of dst
+            template <typename T>
+            static void median9Row(const T *src, int stride, T *dst, int len)
+            {
+                int n = median9RowSimd(src, stride, dst, len);
+                for (; n < len; n++)
+                {
+                    T p[9];
+                    for (int k = 0; k < 9; k++)
+                        p[k] = src[n + k * stride];
+                    dst[n] = median9(p);
                 }
             }
             //!the class used in computing the hamming distance
@@ -151,11 +222,14 @@ namespace cv
                 int *left, *right;
                 short *c;
                 int v,kernelSize, width;
-                int MASK;
-                int *hammLut;
+                bool usePopcnt;
             public :
-                hammingDistance(const Mat &leftImage, const Mat &rightImage, short *cost, int maxDisp, int kerSize, int *hammingLUT):
-                    left((int *)leftImage.data), right((int *)rightImage.data), c(cost), v(maxDisp),kernelSize(kerSize),width(leftImage.cols), MASK(65535), hammLut(hammingLUT){}
+                hammingDistance(const Mat &leftImage, const Mat &rightImage, short *cost, int maxDisp, int kerSize):
+                    left((int *)leftImage.data), right((int *)rightImage.data), c(cost), v(maxDisp),kernelSize(kerSize),width(leftImage.cols)
+                {
+                    //the hardware check is done once and not for every cost
+                    usePopcnt = checkHardwareSupport(CV_CPU_POPCNT);
+                }
                 void operator()(const cv::Range &r) const {
                     for (int i = r.start; i <= r.end ; i++)
                     {
@@ -171,20 +245,88 @@ namespace cv
                                 j2 = (0 > j - d) ? (0) : (j - d);
                                 xorul = left[(iwj)] ^ right[(iw + j2)];
 #if CV_POPCNT
-                                if (checkHardwareSupport(CV_CPU_POPCNT))
+                                if (usePopcnt)
                                 {
                                     c[(iwj)* (v + 1) + d] = (short)_mm_popcnt_u32(xorul);
                                 }
                                 else
 #endif
                                 {
-                                    c[(iwj)* (v + 1) + d] = (short)(hammLut[xorul & MASK] + hammLut[(xorul >> 16) & MASK]);
+                                    c[(iwj)* (v + 1) + d] = (short)hammingWeight(xorul);
                                 }
                             }
                         }
                     }
                 }
             };
+            //!running sums of the hamming costs along the rows, each row starting from 0
+            //!the rows of the cost volume being laid one after the other, the sums of a row are later offset by the carry
+            //!of all the rows above it
+            class horizontalPartialSums:public ParallelLoopBody
+            {
+            private:
+                short *c, *ham;
+                int maxDisp, width;
+            public:
+                horizontalPartialSums(const Mat &hammingDistanceCost, int maxDispa, Mat &cost)
+                {
+                    c = (short *)cost.data;
+                    ham = (short *)hammingDistanceCost.data;
+                    maxDisp = maxDispa;
+                    width = cost.cols / ( maxDisp + 1) - 1;
+                }
+                void operator()(const cv::Range &r) const {
+                    for (int i = r.start; i < r.end; i++)
+                    {
+                        int iw = i * width;
+                        int iwi = (i - 1) * width;
+                        short *row = c + (iw + 1) * (maxDisp + 1);
+                        const short *h = ham + iwi * (maxDisp + 1);
+                        for (int d = 0; d <= maxDisp; d++)
+                            row[d] = h[d];
+                        for (int j = 2; j <= width; j++)
+                        {
+                            short *cur = row + (j - 1) * (maxDisp + 1);
+                            const short *prev = cur - (maxDisp + 1);
+                            const short *hj = h + (j - 1) * (maxDisp + 1);
+                            for (int d = 0; d <= maxDisp; d++)
+                                cur[d] = (short)(hj[d] + prev[d]);
+                        }
+                    }
+                }
+            };
+            //!adds the row carry to the running sums of the rows and accumulates them along the columns
+            class verticalPartialSums:public ParallelLoopBody
+            {
+            private:
+                short *c;
+                const short *carry;
+                int maxDisp, width, height;
+            public:
+                verticalPartialSums(const short *rowCarry, int maxDispa, Mat &cost)
+                {
+                    c = (short *)cost.data;
+                    carry = rowCarry;
+                    maxDisp = maxDispa;
+                    width = cost.cols / ( maxDisp + 1) - 1;
+                    height = cost.rows - 1;
+                }
+                void operator()(const cv::Range &r) const {
+                    for (int i = 1; i <= height; i++)
+                    {
+                        const short *ci = carry + i * (maxDisp + 1);
+                        for (int j = r.start; j < r.end; j++)
+                        {
+                            int iwj = (i * width + j) * (maxDisp + 1);
+                            int iwjmu = ((i - 1)  * width + j) * (maxDisp + 1);
+                            for (int d = 0; d <= maxDisp; d++)
+                            {
+                                c[iwj + d] = (short)(c[iwj + d] + ci[d] + c[iwjmu + d]);
+                            }
+                        }
+                    }
+                }
+            };
             //!cost aggregation
             class agregateCost:public ParallelLoopBody
             {
@@ -301,27 +443,10 @@ namespace cv
                     width = originalImage.cols;
                 }
                 void operator()(const cv::Range &r) const{
+                    if (width <= 8)
+                        return;
                     for (int m = r.start; m <= r.end; m++)
-                    {
-                        for (int n = 4; n < width - 4; ++n)
-                        {
-                            int k = 0;
-                            T window[9];
-                            for (int i = n - 4; i <= n + 4; ++i)
-                                window[k++] = original[m * width + i];
-                            for (int j = 0; j < 5; ++j)
-                            {
-                                int min = j;
-                                for (int l = j + 1; l < 9; ++l)
-                                    if (window[l] < window[min])
-                                        min = l;
-                                const T temp = window[j];
-                                window[j] = window[min];
-                                window[min] = temp;
-                            }
-                            filtered[m  * width + n] = window[4];
-                        }
-                    }
+                        median9Row(original + m * width, 1, filtered + m * width + 4, width - 8);
                 }
             };
             //!median 9x1 paralelized filter
@@ -341,28 +466,54 @@ namespace cv
                     width = originalImage.cols;
                 }
                 void operator()(const Range &r) const{
-                    for (int n = r.start; n <= r.end; ++n)
+                    //the columns of the range are filtered together along each row
+                    for (int m = 4; m < height - 4; ++m)
+                        median9Row(original + (m - 4) * width + r.start, width, filtered + m * width + r.start, r.end - r.start + 1);
+                }
+            };
+            //!the 1x9 and the 9x1 median filters in a single pass over stripes of rows
+            //!the 1x9 medians of the rows a stripe needs are kept in a buffer of the stripe
+            template <typename T>
+            class Median1x9And9x1:public ParallelLoopBody
+            {
+            private:
+                const Mat &original;
+                Mat &filtered;
+                int stripeRows;
+            public:
+                Median1x9And9x1(const Mat &originalImage, Mat &filteredImage, int stripe) :
+                    original(originalImage), filtered(filteredImage), stripeRows(stripe)
+                {
+                }
+                void operator()(const Range &r) const{
+                    int height = original.rows;
+                    int width = original.cols;
+                    std::vector<T> rowMedians;
+                    for (int s = r.start; s < r.end; s++)
                     {
-                        for (int m = 4; m < height - 4; ++m)
+                        int y0 = s * stripeRows, y1 = std::min(y0 + stripeRows, height);
+                        //the pixels out of reach of the 9x1 filter keep their values
+                        for (int y = y0; y < y1; y++)
+                            memcpy(filtered.ptr<T>(y), original.ptr<T>(y), width * sizeof(T));
+                        int m0 = std::max(y0, 4), m1 = std::min(y1, height - 4);
+                        if (m0 >= m1 || width < 3)
+                            continue;
+                        //the 1x9 medians, the pixels out of reach of the 1x9 filter keep their values
+                        rowMedians.resize((size_t)(m1 - m0 + 8) * width);
+                        for (int y = m0 - 4; y < m1 + 4; y++)
                         {
-                            int k = 0;
-                            T window[9];
-                            for (int i = m - 4; i <= m + 4; ++i)
-                                window[k++] = original[i * width + n];
-                            for (int j = 0; j < 5; j++)
-                            {
-                                int min = j;
-                                for (int l = j + 1; l < 9; ++l)
-                                    if (window[l] < window[min])
-                                        min = l;
-                                const T temp = window[j];
-                                window[j] = window[min];
-                                window[min] = temp;
-                            }
-                            filtered[m  * width + n] = window[4];
+                            const T *orow = original.ptr<T>(y);
+                            T *mrow = &rowMedians[(size_t)(y - m0 + 4) * width];
+                            memcpy(mrow, orow, width * sizeof(T));
+                            if (y >= 1 && y < height - 1 && width > 8)
+                                median9Row(orow, 1, mrow + 4, width - 8);
                         }
+                        for (int m = m0; m < m1; m++)
+                            median9Row(&rowMedians[(size_t)(m - m0) * width] + 1, width, filtered.ptr<T>(m) + 1, width - 2);
                     }
                 }
+            private:
+                Median1x9And9x1& operator=(const Median1x9And9x1&); // to quiet MSVC
             };
         protected:
             //arrays used in the region removal
@@ -373,6 +524,8 @@ namespace cv
             //int *specklePointY;
             //long long *pus;
             int previous_size;
+            //!the carries between the rows of the cost volume, used in the cost gathering
+            Mat rowCarry;
             //!method for setting the maximum disparity
             void setMaxDisparity(int val)
             {
@@ -418,7 +571,7 @@ namespace cv
                 CV_Assert(cost.cols / (maxDisparity + 1) == leftImage.cols);
                 short *c = (short *)cost.data;
                 memset(c, 0, sizeof(c[0]) * leftImage.cols * leftImage.rows * (maxDisparity + 1));
-                parallel_for_(cv::Range(kernelSize / 2,leftImage.rows - kernelSize / 2), hammingDistance(leftImage,rightImage,(short *)cost.data,maxDisparity,kernelSize / 2,hamLut));
+                parallel_for_(cv::Range(kernelSize / 2,leftImage.rows - kernelSize / 2), hammingDistance(leftImage,rightImage,(short *)cost.data,maxDisparity,kernelSize / 2));
             }
             //preprocessing the cost volume in order to get it ready for aggregation
             void costGathering(const Mat &hammingDistanceCost, Mat &cost)
@@ -430,35 +583,22 @@ namespace cv
                 int width = cost.cols / ( maxDisp + 1) - 1;
                 int height = cost.rows - 1;
                 short *c = (short *)cost.data;
-                short *ham = (short *)hammingDistanceCost.data;
                 memset(c, 0, sizeof(c[0]) * (width + 1) * (height + 1) * (maxDisp + 1));
-                for (int i = 1; i <= height; i++)
+                parallel_for_(cv::Range(1, height + 1), horizontalPartialSums(hammingDistanceCost, maxDisp, cost));
+                //the last sums of a row are the first ones of the next row, so the carries are chained here
+                rowCarry.create(height + 1, maxDisp + 1, CV_16S);
+                rowCarry.row(0).setTo(Scalar::all(0));
+                if (height > 0)
+                    rowCarry.row(1).setTo(Scalar::all(0));
+                for (int i = 2; i <= height; i++)
                 {
-                    int iw = i * width;
-                    int iwi = (i - 1) * width;
-                    for (int j = 1; j <= width; j++)
-                    {
-                        int iwj = (iw + j) * (maxDisp + 1);
-                        int iwjmu = (iw + j - 1) * (maxDisp + 1);
-                        int iwijmu = (iwi + j - 1) * (maxDisp + 1);
-                        for (int d = 0; d <= maxDisp; d++)
-                        {
-                            c[iwj + d] = ham[iwijmu + d] + c[iwjmu + d];
-                        }
-                    }
-                }
-                for (int i = 1; i <= height; i++)
-                {
-                    for (int j = 1; j <= width; j++)
-                    {
-                        int iwj = (i * width + j) * (maxDisp + 1);
-                        int iwjmu = ((i - 1)  * width + j) * (maxDisp + 1);
-                        for (int d = 0; d <= maxDisp; d++)
-                        {
-                            c[iwj + d] += c[iwjmu + d];
-                        }
-                    }
+                    short *ci = rowCarry.ptr<short>(i);
+                    const short *cprev = rowCarry.ptr<short>(i - 1);
+                    const short *last = c + ((i - 1) * width + width) * (maxDisp + 1);
+                    for (int d = 0; d <= maxDisp; d++)
+                        ci[d] = (short)(cprev[d] + last[d]);
                 }
+                parallel_for_(cv::Range(1, width + 1), verticalPartialSums(rowCarry.ptr<short>(), maxDisp, cost));
             }
             //!The aggregation on the cost volume
             void blockAgregation(const Mat &partialSums, int windowSize, Mat &cost)
@@ -576,6 +716,47 @@ namespace cv
                 parallel_for_(Range(0,height - 1), makeMap(costVolume,th,disparity,confidenceCheck,scallingFactor,mapFinal));
             }
         public:
+            //!the hamming costs of one row of the two transformed images, the same as the ones of the row of the cost
+            //!volume computed by hammingDistanceBlockMatching, but with numDisp costs for each pixel
+            //!used for streaming the costs when the whole cost volume is not needed at once
+            void hammingDistanceRow(const Mat &leftImage, const Mat &rightImage, int row, int numDisp, short *c, const int kernelSize = 9) const
+            {
+                CV_Assert(leftImage.size() == rightImage.size());
+                CV_Assert(kernelSize % 2 != 0);
+                int width = leftImage.cols;
+                int kerSize = kernelSize / 2;
+                memset(c, 0, sizeof(c[0]) * width * numDisp);
+                if (row < kerSize || row > leftImage.rows - kerSize)
+                    return;
+                const int *left = (const int *)leftImage.data + row * width;
+                const int *right = (const int *)rightImage.data + row * width;
+#if CV_POPCNT
+                bool usePopcnt = checkHardwareSupport(CV_CPU_POPCNT);
+#endif
+                for (int j = kerSize; j < width - kerSize; j++)
+                {
+                    short *cj = c + j * numDisp;
+                    int lj = left[j];
+                    //the disparities for which the right pixel is inside the image, the others compare with its first pixel
+                    int dmax = std::min(j, numDisp - 1);
+#if CV_POPCNT
+                    if (usePopcnt)
+                    {
+                        for (int d = 0; d <= dmax; d++)
+                            cj[d] = (short)_mm_popcnt_u32(lj ^ right[j - d]);
+                        for (int d = dmax + 1; d < numDisp; d++)
+                            cj[d] = (short)_mm_popcnt_u32(lj ^ right[0]);
+                    }
+                    else
+#endif
+                    {
+                        for (int d = 0; d <= dmax; d++)
+                            cj[d] = (short)hammingWeight(lj ^ right[j - d]);
+                        for (int d = dmax + 1; d < numDisp; d++)
+                            cj[d] = (short)hammingWeight(lj ^ right[0]);
+                    }
+                }
+            }
             //!a median filter of 1x9 and 9x1
             //!1x9 median filter
             template<typename T>
@@ -593,11 +774,22 @@ namespace cv
                 CV_Assert(originalImage.cols == filteredImage.cols);
                 parallel_for_(Range(1,originalImage.cols - 2), Median9x1<T>(originalImage,filteredImage));
             }
+            //!the 9x1 median filter of the 1x9 median filter in one pass, filteredImage has to be another image
+            //!the pixels that either filter does not reach are copied, the borders of the 1x9 median included
+            template<typename T>
+            void Median1x9And9x1Filter(const Mat &originalImage, Mat &filteredImage)
+            {
+                CV_Assert(originalImage.size() == filteredImage.size());
+                CV_Assert(originalImage.type() == filteredImage.type());
+                CV_Assert(originalImage.data != filteredImage.data);
+                const int stripeRows = 32;
+                parallel_for_(Range(0, (originalImage.rows + stripeRows - 1) / stripeRows),
+                              Median1x9And9x1<T>(originalImage, filteredImage, stripeRows));
+            }
             //!constructor for the matching class
             //!maxDisp - represents the maximum disparity
             Matching(void)
             {
-                hammingLut();
             }
             ~Matching(void)
             {
@@ -613,8 +805,6 @@ namespace cv
                 setScallingFactor(scalling);
                 //set the value for the confidence
                 setConfidence(confidence);
-                //generate the hamming lut in case SSE is not available
-                hammingLut();
             }
         };
     }
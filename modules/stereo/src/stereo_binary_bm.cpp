@@ -270,12 +270,15 @@ namespace cv
             StereoBinaryBMImpl(): Matching(64)
             {
                 params = StereoBinaryBMParams();
+                previous_size = 0;
+                previous_disparities = 0;
             }
 
             StereoBinaryBMImpl(int _numDisparities, int _kernelSize) : Matching(_numDisparities)
             {
                 params = StereoBinaryBMParams(_numDisparities, _kernelSize);
                 previous_size = 0;
+                previous_disparities = 0;
             }
 
             void compute(InputArray leftarr, InputArray rightarr, OutputArray disparr)
@@ -322,9 +325,12 @@ namespace cv
 
                 int width = left0.cols;
                 int height = left0.rows;
-                if(previous_size != width * height)
+                //the buffers are kept from one call to the next, they only change with the size of the images
+                //or with the number of disparities of the cost volume
+                if(previous_size != width * height || previous_disparities != params.numDisparities)
                 {
                     previous_size = width * height;
+                    previous_disparities = params.numDisparities;
                     speckleX.create(height,width,CV_32SC4);
                     speckleY.create(height,width,CV_32SC4);
                     puss.create(height,width,CV_32SC4);
@@ -344,17 +350,12 @@ namespace cv
 
                 Mat left = preFilteredImg0, right = preFilteredImg1;
 
-                int ndisp = params.numDisparities;
-
-                int wsz = params.kernelSize;
-                int bufSize0 = (int)((ndisp + 2)*sizeof(int));
-                bufSize0 += (int)((height + wsz + 2)*ndisp*sizeof(int));
-                bufSize0 += (int)((height + wsz + 2)*sizeof(int));
-                bufSize0 += (int)((height + wsz + 2)*ndisp*(wsz + 2)*sizeof(uchar) + 256);
-
                 int bufSize1 = (int)((width + params.preFilterSize + 2) * sizeof(int) + 256);
                 if(params.usePrefilter == true)
                 {
+                    //one sliding sum buffer for each of the two images
+                    if(slidingSumBuf.total() < (size_t)bufSize1 * 2)
+                        slidingSumBuf.create(1, bufSize1 * 2, CV_8U);
                     uchar *_buf = slidingSumBuf.ptr();
 
                     parallel_for_(Range(0, 2), PrefilterInvoker(left0, right0, left, right, _buf, _buf + bufSize1, &params), 1);
@@ -404,8 +405,8 @@ namespace cv
                 costGathering(hammingDistance, partialSumsLR);
                 blockAgregation(partialSumsLR, params.agregationWindowSize, agregatedHammingLRCost);
                 dispartyMapFormation(agregatedHammingLRCost, disp0, 3);
-                Median1x9Filter<uint8_t>(disp0, aux);
-                Median9x1Filter<uint8_t>(aux,disp0);
+                Median1x9And9x1Filter<uint8_t>(disp0, aux);
+                aux.copyTo(disp0);
 
                 if(params.regionRemoval == CV_SPECKLE_REMOVAL_AVG_ALGORITHM)
                 {
@@ -504,6 +505,7 @@ namespace cv
             StereoBinaryBMParams params;
             Mat preFilteredImg0, preFilteredImg1, cost, dispbuf;
             Mat slidingSumBuf;
+            int previous_disparities;
             Mat parSumsIntensityImage[2];
             Mat Integral[2];
             Mat censusImage[2];
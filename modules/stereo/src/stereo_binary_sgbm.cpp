@@ -126,10 +126,12 @@ namespace cv
         is written as is, without interpolation.
         disp2cost also has the same size as img1 (or img2).
         It contains the minimum current cost, used to find the best disparity, corresponding to the minimal cost.
+        The matching costs of the row y of img1 are the hamming distances computed from the row row0 + y
+        of census1 and census2, one row at a time.
         */
         static void computeDisparityBinarySGBM( const Mat& img1, const Mat& img2,
             Mat& disp1, const StereoBinarySGBMParams& params,
-            Mat& buffer,const Mat& hamDist)
+            Mat& buffer, const Matching& matching, const Mat& census1, const Mat& census2, int row0)
         {
 #if CV_SSE2
             static const uchar LSBTab[] =
@@ -179,9 +181,6 @@ namespace cv
             // the previous row, i.e. 2 rows in total
             const int NLR = 2;
             const int LrBorder = NLR - 1;
-            int ww = img2.cols;
-            short *ham;
-            ham = (short *)hamDist.data;
             // for each possible stereo match (img1(x,y) <=> img2(x-d,y))
             // we keep pixel difference cost (C) and the summary cost over NR directions (S).
             // we also keep all the partial costs for the previous line L_r(x,d) and also min_k L_r(x, k)
@@ -248,13 +247,9 @@ namespace cv
                             CostType* hsumAdd = hsumBuf + (std::min(k, height-1) % hsumBufNRows)*costBufSize;
                             if( k < height )
                             {
-                                for(int ii = 0; ii <= ww; ii++)
-                                {
-                                    for(int dd = 0; dd <= params.numDisparities; dd++)
-                                    {
-                                        pixDiff[ii * (params.numDisparities)+ dd] = (CostType)(ham[(k * (ww) + ii) * (params.numDisparities +1) + dd]);
-                                    }
-                                }
+                                // the hamming costs of the row are computed here from the census images,
+                                // so the whole cost volume is never stored
+                                matching.hammingDistanceRow(census1, census2, row0 + k, D, pixDiff);
                                 memset(hsumAdd, 0, D*sizeof(CostType));
                                 for( x = 0; x <= SW2*D; x += D )
                                 {
@@ -618,6 +613,53 @@ namespace cv
                 }
             }
         }
+
+        // MODE_HH_STRIPES: each stripe computes STRIPE_ROWS rows of the disparity with the full dynamic
+        // programming on a sub-image extended by STRIPE_OVERLAP rows on both sides, so that the vertical and
+        // diagonal paths have run for a while when they reach the rows of the stripe. The stripes don't depend
+        // on the number of threads.
+        enum { STRIPE_ROWS = 32, STRIPE_OVERLAP = 16 };
+
+        class ComputeDisparityStripes_ParBody : public ParallelLoopBody
+        {
+        public:
+            ComputeDisparityStripes_ParBody( const Mat& _img1, const Mat& _img2, Mat& _disp1,
+                const StereoBinarySGBMParams& _params, TLSData<Mat>& _buffers, const Matching& _matching,
+                const Mat& _census1, const Mat& _census2 )
+                : img1(_img1), img2(_img2), disp1(_disp1), params(_params), buffers(_buffers), matching(_matching),
+                census1(_census1), census2(_census2)
+            {
+                params.mode = StereoBinarySGBM::MODE_HH;
+            }
+
+            void operator()( const Range& range ) const
+            {
+                Mat& buffer = buffers.getRef();
+                Mat disp;
+                for( int s = range.start; s < range.end; s++ )
+                {
+                    int y0 = s*STRIPE_ROWS, y1 = std::min(y0 + STRIPE_ROWS, img1.rows);
+                    int ext0 = std::max(y0 - STRIPE_OVERLAP, 0), ext1 = std::min(y1 + STRIPE_OVERLAP, img1.rows);
+                    disp.create(ext1 - ext0, disp1.cols, disp1.type());
+                    computeDisparityBinarySGBM( img1.rowRange(ext0, ext1), img2.rowRange(ext0, ext1), disp,
+                        params, buffer, matching, census1, census2, ext0 );
+                    disp.rowRange(y0 - ext0, y1 - ext0).copyTo(disp1.rowRange(y0, y1));
+                }
+            }
+
+        private:
+            const Mat& img1;
+            const Mat& img2;
+            Mat& disp1;
+            StereoBinarySGBMParams params;
+            TLSData<Mat>& buffers;
+            const Matching& matching;
+            const Mat& census1;
+            const Mat& census2;
+
+            ComputeDisparityStripes_ParBody& operator=(const ComputeDisparityStripes_ParBody&); // to quiet MSVC
+        };
+
         class StereoBinarySGBMImpl : public StereoBinarySGBM, public Matching
         {
         public:
@@ -645,8 +687,6 @@ namespace cv
                 censusImageLeft.create(left.rows,left.cols,CV_32SC4);
                 censusImageRight.create(left.rows,left.cols,CV_32SC4);
 
-                hamDist.create(left.rows, left.cols * (params.numDisparities + 1),CV_16S);
-
                 if(params.kernelType == CV_SPARSE_CENSUS)
                 {
                     censusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight,CV_SPARSE_CENSUS);
@@ -684,9 +724,15 @@ namespace cv
                     starCensusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight);
                 }
 
-                hammingDistanceBlockMatching(censusImageLeft, censusImageRight, hamDist);
-
-                computeDisparityBinarySGBM( left, right, disp, params, buffer,hamDist);
+                if(params.mode == StereoBinarySGBM::MODE_HH_STRIPES)
+                {
+                    int nstripes = (left.rows + STRIPE_ROWS - 1) / STRIPE_ROWS;
+                    parallel_for_(Range(0, nstripes),
+                        ComputeDisparityStripes_ParBody(left, right, disp, params, stripeBuffers, *this,
+                        censusImageLeft, censusImageRight));
+                }
+                else
+                    computeDisparityBinarySGBM( left, right, disp, params, buffer, *this, censusImageLeft, censusImageRight, 0);
 
                 if(params.regionRemoval == CV_SPECKLE_REMOVAL_AVG_ALGORITHM)
                 {
@@ -701,8 +747,8 @@ namespace cv
                     }
                     Mat aux;
                     aux.create(height,width,CV_16S);
-                    Median1x9Filter<short>(disp, aux);
-                    Median9x1Filter<short>(aux,disp);
+                    Median1x9And9x1Filter<short>(disp, aux);
+                    aux.copyTo(disp);
                     smallRegionRemoval<short>(disp, params.speckleWindowSize, disp);
                 }
                 else if(params.regionRemoval == CV_SPECKLE_REMOVAL_ALGORITHM)
@@ -711,8 +757,8 @@ namespace cv
                     int height = left.rows;
                     Mat aux;
                     aux.create(height,width,CV_16S);
-                    Median1x9Filter<short>(disp, aux);
-                    Median9x1Filter<short>(aux,disp);
+                    Median1x9And9x1Filter<short>(disp, aux);
+                    aux.copyTo(disp);
                     if( params.speckleWindowSize > 0 )
                         filterSpeckles(disp, (params.minDisparity - 1) * StereoMatcher::DISP_SCALE, params.speckleWindowSize,
                         StereoMatcher::DISP_SCALE * params.speckleRange, buffer);
@@ -795,12 +841,12 @@ namespace cv
 
             StereoBinarySGBMParams params;
             Mat buffer;
+            TLSData<Mat> stripeBuffers; // per-thread buffers of MODE_HH_STRIPES
             static const char* name_;
             Mat censusImageLeft;
             Mat censusImageRight;
             Mat partialSumsLR;
             Mat agregatedHammingLRCost;
-            Mat hamDist;
             Mat parSumsIntensityImage[2];
             Mat Integral[2];
         };
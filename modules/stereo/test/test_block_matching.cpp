@@ -239,3 +239,94 @@ void CV_SGBlockMatchingTest::run(int )
 }
 TEST(block_matching_simple_test, accuracy) { CV_BlockMatchingTest test; test.safe_run(); }
 TEST(SG_block_matching_simple_test, accuracy) { CV_SGBlockMatchingTest test; test.safe_run(); }
+
+TEST(SG_block_matching_stripes, close_to_full_dp)
+{
+    Mat left(240, 320, CV_8UC1), right;
+    RNG rng(0);
+    rng.fill(left, RNG::UNIFORM, 0, 255);
+    GaussianBlur(left, left, Size(0, 0), 1.5);
+    // the right view is the left one moved by 6 pixels
+    Mat M = (Mat_<double>(2, 3) << 1, 0, -6, 0, 1, 0);
+    warpAffine(left, right, M, left.size(), INTER_NEAREST, BORDER_REPLICATE);
+
+    Ptr<StereoBinarySGBM> sgbm = StereoBinarySGBM::create(0, 16, 5);
+    sgbm->setP1(10);
+    sgbm->setP2(100);
+    sgbm->setMode(StereoBinarySGBM::MODE_HH);
+    Mat dispFull;
+    sgbm->compute(left, right, dispFull);
+
+    sgbm->setMode(StereoBinarySGBM::MODE_HH_STRIPES);
+    Mat dispStripes, dispStripesSerial;
+    sgbm->compute(left, right, dispStripes);
+    ASSERT_EQ(dispFull.size(), dispStripes.size());
+    ASSERT_EQ(dispFull.type(), dispStripes.type());
+
+    // only the paths crossing the stripe boundaries differ
+    Mat diff = abs(dispFull - dispStripes) > StereoMatcher::DISP_SCALE;
+    EXPECT_LE(countNonZero(diff), (int)(0.02 * dispFull.total()));
+
+    // the stripes don't depend on the number of threads
+    int threads = getNumThreads();
+    setNumThreads(1);
+    sgbm->compute(left, right, dispStripesSerial);
+    setNumThreads(threads);
+    EXPECT_EQ(0, cvtest::norm(dispStripes, dispStripesSerial, NORM_INF));
+}
+
+TEST(block_matching_parallel, thread_invariance)
+{
+    Mat left(240, 320, CV_8UC1), right;
+    RNG rng(0);
+    rng.fill(left, RNG::UNIFORM, 0, 255);
+    GaussianBlur(left, left, Size(0, 0), 1.5);
+    // the right view is the left one moved by 6 pixels
+    Mat M = (Mat_<double>(2, 3) << 1, 0, -6, 0, 1, 0);
+    warpAffine(left, right, M, left.size(), INTER_NEAREST, BORDER_REPLICATE);
+
+    Ptr<StereoBinaryBM> sbm = StereoBinaryBM::create(16, 9);
+    sbm->setPreFilterCap(31);
+    sbm->setScalleFactor(16);
+    sbm->setAgregationWindowSize(11);
+    sbm->setSpekleRemovalTechnique(CV_SPECKLE_REMOVAL_AVG_ALGORITHM);
+    sbm->setPreFilterType(StereoBinaryBM::PREFILTER_NORMALIZED_RESPONSE);
+    sbm->setUsePrefilter(true);
+
+    Mat disp(left.size(), CV_8UC1), dispSerial(left.size(), CV_8UC1);
+    sbm->compute(left, right, disp);
+
+    // the cost volume is gathered in parallel, the result must not depend on the number of threads
+    int threads = getNumThreads();
+    setNumThreads(1);
+    sbm->compute(left, right, dispSerial);
+    setNumThreads(threads);
+    EXPECT_EQ(0, cvtest::norm(disp, dispSerial, NORM_INF));
+}
+
+template <typename T>
+static void testFusedMedian(int depth)
+{
+    Matching matching;
+    RNG rng(0);
+    Size sizes[] = { Size(320, 240), Size(37, 29), Size(8, 12) };
+    for (int i = 0; i < 3; i++)
+    {
+        Mat image(sizes[i], depth), aux, separate, fused(sizes[i], depth);
+        rng.fill(image, RNG::UNIFORM, 0, 100);
+        // the pixels the 1x9 filter does not reach keep their values
+        aux = image.clone();
+        separate = image.clone();
+        matching.Median1x9Filter<T>(image, aux);
+        matching.Median9x1Filter<T>(aux, separate);
+
+        matching.Median1x9And9x1Filter<T>(image, fused);
+        EXPECT_EQ(0, cvtest::norm(separate, fused, NORM_INF)) << "size " << sizes[i];
+    }
+}
+
+TEST(block_matching_median, fused_same_as_separate)
+{
+    testFusedMedian<uint8_t>(CV_8U);
+    testFusedMedian<short>(CV_16S);
+}
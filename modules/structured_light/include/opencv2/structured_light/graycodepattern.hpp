@@ -50,6 +50,67 @@ namespace structured_light {
 //! @addtogroup structured_light
 //! @{
 
+/** @brief Decoder of the Gray-code pattern images captured by one or more cameras, fed one image at a time.
+ *
+ *  Each captured pattern image is folded into a packed code word per camera pixel as soon as its inverse is given, so that the decoding
+ *  overlaps the capture and only one code image per camera is kept instead of all the pattern images.
+ *  It is created by GrayCodePattern::createStreamDecoder, with the thresholds of the pattern at that time.
+ */
+class CV_EXPORTS_W GrayCodeStreamDecoder : public Algorithm
+{
+ public:
+
+  /** @brief Folds the next captured pattern image of a camera into its code words.
+   *
+   *  @param camera The index of the camera.
+   *  @param patternImage The CV_8UC1 pattern image, in the order of GrayCodePattern::generate.
+   */
+  CV_WRAP
+  virtual void addPatternImage( int camera, InputArray patternImage ) = 0;
+
+  /** @brief Marks the shadowed pixels of a camera, where the black and white images differ by the black threshold at most.
+   *
+   *  It may be called at any time before the decoded pixels are read. Without it, no pixel of the camera is shadowed.
+   *
+   *  @param camera The index of the camera.
+   *  @param blackImage The CV_8UC1 image captured with the all-black image of GrayCodePattern::getImagesForShadowMasks.
+   *  @param whiteImage The CV_8UC1 image captured with the all-white image.
+   */
+  CV_WRAP
+  virtual void addShadowImages( int camera, InputArray blackImage, InputArray whiteImage ) = 0;
+
+  /** @brief Returns the number of pattern images added for a camera.
+   */
+  CV_WRAP
+  virtual size_t getNumberOfAddedImages( int camera ) const = 0;
+
+  /** @brief Returns true when all the pattern images of all the cameras have been added.
+   */
+  CV_WRAP
+  virtual bool isComplete() const = 0;
+
+  /** @brief Returns the projector pixel of each pixel of a camera, once all its pattern images have been added.
+   *
+   *  @param camera The index of the camera.
+   *  @param projPixels CV_32SC2 map of the projector pixels, (-1, -1) where the pixel is shadowed or cannot be decoded.
+   */
+  CV_WRAP
+  virtual void getProjPixels( int camera, OutputArray projPixels ) const = 0;
+
+  /** @brief Computes the disparity map of the first two cameras, as StructuredLightPattern::decode does.
+   *
+   *  @param disparityMap The CV_64F disparity map of the first camera.
+   *  @return false if the decoder has less than two cameras or is not complete.
+   */
+  CV_WRAP
+  virtual bool computeDisparity( OutputArray disparityMap ) const = 0;
+
+  /** @brief Drops the code words of all the cameras, to decode a new scan.
+   */
+  CV_WRAP
+  virtual void reset() = 0;
+};
+
 /** @brief Class implementing the Gray-code pattern, based on @cite UNDERWORLD.
  *
  *  The generation of the pattern images is performed with Gray encoding using the traditional white and black colors.
@@ -141,6 +202,13 @@ class CV_EXPORTS_W GrayCodePattern : public StructuredLightPattern
    */
   CV_WRAP
   virtual bool getProjPixel( InputArrayOfArrays patternImages, int x, int y, Point &projPix ) const = 0;
+
+  /** @brief Creates a decoder that takes the pattern images one at a time, as they are captured.
+   *
+   *  @param numOfCameras The number of cameras of the scan.
+   */
+  CV_WRAP
+  virtual Ptr<GrayCodeStreamDecoder> createStreamDecoder( int numOfCameras = 2 ) const = 0;
 };
 
 //! @}
@@ -40,6 +40,8 @@
  //M*/
 
 #include "precomp.hpp"
+#include "opencv2/imgproc.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv {
 namespace structured_light {
@@ -74,6 +76,9 @@ class CV_EXPORTS_W GrayCodePattern_Impl : public GrayCodePattern
   // For a (x,y) pixel of the camera returns the corresponding projector pixel
   bool getProjPixel(InputArrayOfArrays patternImages, int x, int y, Point &projPix) const;
 
+  // Creates a decoder of the pattern images as they are captured
+  Ptr<GrayCodeStreamDecoder> createStreamDecoder( int numOfCameras ) const;
+
  private:
   // Parameters
   Params params;
@@ -209,6 +214,157 @@ bool GrayCodePattern_Impl::generate( OutputArrayOfArrays pattern )
   return true;
 }
 
+// Decodes the rows of the images of a camera: projPixels( y, x ) is the index x * projHeight + y
+// of the projector pixel seen by the camera pixel, or -1 where it is shadowed or cannot be decoded
+class DecodeRowsInvoker : public ParallelLoopBody
+{
+ public:
+  DecodeRowsInvoker( const std::vector<Mat>& _patternImages, const Mat& _shadowMask, int _numOfColImgs,
+                     int _numOfRowImgs, size_t _whiteThreshold, int _projWidth, int _projHeight, Mat& _projPixels ) :
+      patternImages( _patternImages ), shadowMask( _shadowMask ), numOfColImgs( _numOfColImgs ),
+      numOfRowImgs( _numOfRowImgs ), whiteThreshold( _whiteThreshold ), projWidth( _projWidth ),
+      projHeight( _projHeight ), projPixels( _projPixels )
+  {
+  }
+
+  void operator()( const Range& range ) const
+  {
+    int width = projPixels.cols;
+    AutoBuffer<int> _dec( 2 * width );
+    AutoBuffer<uchar> _err( 2 * width );
+    int* decX = _dec, *decY = decX + width;
+    uchar* errX = _err, *errY = errX + width;
+    std::vector<const uchar*> planes( patternImages.size() );
+
+    for( int y = range.start; y < range.end; y++ )
+    {
+      for( size_t i = 0; i < planes.size(); i++ )
+        planes[i] = patternImages[i].ptr<uchar>( y );
+
+      decodePlanes( &planes[0], numOfColImgs, width, decX, errX );
+      decodePlanes( &planes[2 * numOfColImgs], numOfRowImgs, width, decY, errY );
+
+      const uchar* shadow = shadowMask.ptr<uchar>( y );
+      int* dst = projPixels.ptr<int>( y );
+      for( int x = 0; x < width; x++ )
+      {
+        bool valid = shadow[x] && !errX[x] && !errY[x] && decX[x] < projWidth && decY[x] < projHeight;
+        dst[x] = valid ? decX[x] * projHeight + decY[x] : -1;
+      }
+    }
+  }
+
+ private:
+  // The gray code of nPlanes pairs of a pattern and its inverse, converted to a decimal number, and whether
+  // the intensity difference of a pair is too low
+  void decodePlanes( const uchar* const * planes, int nPlanes, int width, int* dec, uchar* err ) const
+  {
+    int x = 0;
+#if CV_SIMD128
+    // with a threshold over 255, every pixel is an error and the scalar comparison below tells it
+    if( whiteThreshold <= 255 )
+    {
+      v_uint8x16 vthreshold = v_setall_u8( (uchar) whiteThreshold ), one = v_setall_u8( 1 );
+      for( ; x <= width - 16; x += 16 )
+      {
+        v_uint8x16 bin = v_setzero_u8(), error = v_setzero_u8();
+        v_uint32x4 d0 = v_setzero_u32(), d1 = v_setzero_u32(), d2 = v_setzero_u32(), d3 = v_setzero_u32();
+        for( int c = 0; c < nPlanes; c++ )
+        {
+          v_uint8x16 val1 = v_load( planes[2 * c] + x ), val2 = v_load( planes[2 * c + 1] + x );
+          error |= v_absdiff( val1, val2 ) < vthreshold;
+          // gray to binary: each bit is the XOR of the previous binary bit and the gray one
+          bin ^= val1 > val2;
+
+          v_uint16x8 b0, b1;
+          v_uint32x4 b00, b01, b10, b11;
+          v_expand( bin & one, b0, b1 );
+          v_expand( b0, b00, b01 );
+          v_expand( b1, b10, b11 );
+          d0 = ( d0 << 1 ) | b00;
+          d1 = ( d1 << 1 ) | b01;
+          d2 = ( d2 << 1 ) | b10;
+          d3 = ( d3 << 1 ) | b11;
+        }
+        v_store( (unsigned*) dec + x, d0 );
+        v_store( (unsigned*) dec + x + 4, d1 );
+        v_store( (unsigned*) dec + x + 8, d2 );
+        v_store( (unsigned*) dec + x + 12, d3 );
+        v_store( err + x, error );
+      }
+    }
+#endif
+    for( ; x < width; x++ )
+    {
+      int d = 0;
+      uchar bin = 0, error = 0;
+      for( int c = 0; c < nPlanes; c++ )
+      {
+        int val1 = planes[2 * c][x], val2 = planes[2 * c + 1][x];
+        if( (size_t) std::abs( val1 - val2 ) < whiteThreshold )
+          error = 1;
+        bin ^= (uchar) ( val1 > val2 );
+        d = ( d << 1 ) | bin;
+      }
+      dec[x] = d;
+      err[x] = error;
+    }
+  }
+
+  const std::vector<Mat>& patternImages;
+  const Mat& shadowMask;
+  int numOfColImgs, numOfRowImgs;
+  size_t whiteThreshold;
+  int projWidth, projHeight;
+  Mat& projPixels;
+
+  DecodeRowsInvoker& operator=( const DecodeRowsInvoker& ); // to quiet MSVC
+};
+
+// Computes the disparity map of the first camera from the projector pixel indices seen by the first two cameras:
+// the difference of the mean x of the pixels of the two cameras that see the same projector pixel
+static void computeDisparityMap( const std::vector<Mat>& projPixels, int projPixelsCount, Mat& disparityMap )
+{
+  CV_Assert( projPixels.size() >= 2 );
+
+  // The camera pixels of each camera that correspond to the same pixel of the projector, by their x sum
+  // and their count in tables indexed by the projector pixel
+  std::vector<std::vector<int> > counts( 2, std::vector<int>( projPixelsCount, 0 ) );
+  std::vector<std::vector<double> > sumsX( 2, std::vector<double>( projPixelsCount, 0. ) );
+
+  for( size_t k = 0; k < 2; k++ )
+  {
+    for( int y = 0; y < projPixels[k].rows; y++ )
+    {
+      const int* idx = projPixels[k].ptr<int>( y );
+      for( int x = 0; x < projPixels[k].cols; x++ )
+      {
+        if( idx[x] >= 0 )
+        {
+          counts[k][idx[x]]++;
+          sumsX[k][idx[x]] += x;
+        }
+      }
+    }
+  }
+
+  disparityMap = Mat( projPixels[0].size(), CV_64F, double( 0 ) );
+
+  for( int y = 0; y < disparityMap.rows; y++ )
+  {
+    const int* idx = projPixels[0].ptr<int>( y );
+    double* disparity = disparityMap.ptr<double>( y );
+    for( int x = 0; x < disparityMap.cols; x++ )
+    {
+      int p = idx[x];
+      if( p < 0 || counts[1][p] == 0 )
+        continue;
+
+      disparity[x] = sumsX[1][p] / counts[1][p] - sumsX[0][p] / counts[0][p];
+    }
+  }
+}
+
 bool GrayCodePattern_Impl::decode( InputArrayOfArrays patternImages, OutputArray disparityMap,
                                    InputArrayOfArrays blackImages, InputArrayOfArrays whitheImages, int flags ) const
 {
@@ -220,94 +376,284 @@ bool GrayCodePattern_Impl::decode( InputArrayOfArrays patternImages, OutputArray
     std::vector<Mat> shadowMasks;
     computeShadowMasks( blackImages, whitheImages, shadowMasks );
 
-    int cam_width = acquired_pattern[0][0].cols;
-    int cam_height = acquired_pattern[0][0].rows;
+    std::vector<Mat> projPixels( 2 );
+    for( size_t k = 0; k < 2; k++ )
+    {
+      CV_Assert( acquired_pattern[k].size() == numOfPatternImages );
+      Size size = acquired_pattern[k][0].size();
+      for( size_t i = 0; i < numOfPatternImages; i++ )
+        CV_Assert( acquired_pattern[k][i].type() == CV_8UC1 && acquired_pattern[k][i].size() == size );
+      CV_Assert( shadowMasks[k].size() == size );
+
+      projPixels[k].create( size, CV_32S );
+      parallel_for_( Range( 0, size.height ),
+                     DecodeRowsInvoker( acquired_pattern[k], shadowMasks[k], (int) numOfColImgs, (int) numOfRowImgs,
+                                        whiteThreshold, params.width, params.height, projPixels[k] ) );
+    }
+
+    Mat& disparityMap_ = *( Mat* ) disparityMap.getObj();
+    computeDisparityMap( projPixels, params.width * params.height, disparityMap_ );
+
+    return true;
+  }  // end if flags
+
+  return false;
+}
+
+/*
+ *  GrayCodeStreamDecoder
+ */
 
-    Point projPixel;
+// The code word of a camera pixel: the binary column bits followed by the binary row bits, as they are
+// folded in, and the error flag of a shadowed pixel or of a pattern pair too close to its inverse
+static const unsigned codeErrorBit = 0x80000000u;
+static const unsigned codeBitsMask = 0x7fffffffu;
 
-    // Storage for the pixels of the two cams that correspond to the same pixel of the projector
-    std::vector<std::vector<std::vector<Point> > > camsPixels;
-    camsPixels.resize( acquired_pattern.size() );
+// Folds a captured pair of a pattern image and its inverse into the code words of a camera
+class FoldPatternPairInvoker : public ParallelLoopBody
+{
+ public:
+  FoldPatternPairInvoker( const Mat& _pattern, const Mat& _inverse, bool _firstOfAxis, size_t _whiteThreshold,
+                          Mat& _codes ) :
+      pattern( _pattern ), inverse( _inverse ), firstOfAxis( _firstOfAxis ), whiteThreshold( _whiteThreshold ),
+      codes( _codes )
+  {
+  }
 
-    // TODO: parallelize for (k and j)
-    for( size_t k = 0; k < acquired_pattern.size(); k++ )
+  void operator()( const Range& range ) const
+  {
+    int width = codes.cols;
+    for( int y = range.start; y < range.end; y++ )
     {
-      camsPixels[k].resize( params.height * params.width );
-      for( int i = 0; i < cam_width; i++ )
+      const uchar* val1 = pattern.ptr<uchar>( y );
+      const uchar* val2 = inverse.ptr<uchar>( y );
+      unsigned* code = codes.ptr<unsigned>( y );
+      int x = 0;
+#if CV_SIMD128
+      // with a threshold over 255, every pixel is an error and the scalar comparison below tells it
+      if( whiteThreshold <= 255 )
       {
-        for( int j = 0; j < cam_height; j++ )
+        v_uint8x16 vthreshold = v_setall_u8( (uchar) whiteThreshold ), one8 = v_setall_u8( 1 );
+        v_uint32x4 one = v_setall_u32( 1 ), vbits = v_setall_u32( codeBitsMask ),
+                   verror = v_setall_u32( codeErrorBit ), vchain = v_setall_u32( firstOfAxis ? 0 : 1 );
+        for( ; x <= width - 16; x += 16 )
         {
-          //if the pixel is not shadowed, reconstruct
-          if( shadowMasks[k].at<uchar>( j, i ) )
+          v_uint8x16 v1 = v_load( val1 + x ), v2 = v_load( val2 + x );
+          v_uint8x16 gray = ( v1 > v2 ) & one8;
+          v_uint8x16 error = ( v_absdiff( v1, v2 ) < vthreshold ) & one8;
+
+          v_uint16x8 g0, g1, e0, e1;
+          v_expand( gray, g0, g1 );
+          v_expand( error, e0, e1 );
+          v_uint32x4 g[4], e[4];
+          v_expand( g0, g[0], g[1] );
+          v_expand( g1, g[2], g[3] );
+          v_expand( e0, e[0], e[1] );
+          v_expand( e1, e[2], e[3] );
+
+          for( int i = 0; i < 4; i++ )
           {
-            //for a (x,y) pixel of the camera returns the corresponding projector pixel by calculating the decimal number
-            bool error = getProjPixel( acquired_pattern[k], i, j, projPixel );
-
-            if( error )
-            {
-              continue;
-            }
-
-            camsPixels[k][projPixel.x * params.height + projPixel.y].push_back( Point( i, j ) );
+            v_uint32x4 d = v_load( code + x + 4 * i );
+            // gray to binary: each bit is the XOR of the previous binary bit of the axis and the gray one
+            v_uint32x4 bin = ( d & vchain ) ^ g[i];
+            d = ( ( d & vbits ) << 1 ) | ( d & verror ) | ( e[i] << 31 ) | ( bin & one );
+            v_store( code + x + 4 * i, d );
           }
         }
       }
+#endif
+      for( ; x < width; x++ )
+      {
+        unsigned d = code[x];
+        unsigned bin = ( firstOfAxis ? 0 : d & 1 ) ^ ( val1[x] > val2[x] ? 1 : 0 );
+        unsigned error = (size_t) std::abs( val1[x] - val2[x] ) < whiteThreshold ? codeErrorBit : 0;
+        code[x] = ( ( d & codeBitsMask ) << 1 ) | ( d & codeErrorBit ) | error | bin;
+      }
     }
+  }
 
-    std::vector<Point> cam1Pixs, cam2Pixs;
+ private:
+  const Mat& pattern;
+  const Mat& inverse;
+  bool firstOfAxis;
+  size_t whiteThreshold;
+  Mat& codes;
 
-    Mat& disparityMap_ = *( Mat* ) disparityMap.getObj();
-    disparityMap_ = Mat( cam_height, cam_width, CV_64F, double( 0 ) );
+  FoldPatternPairInvoker& operator=( const FoldPatternPairInvoker& ); // to quiet MSVC
+};
 
-    double number_of_pixels_cam1 = 0;
-    double number_of_pixels_cam2 = 0;
+class GrayCodeStreamDecoder_Impl : public GrayCodeStreamDecoder
+{
+ public:
+  GrayCodeStreamDecoder_Impl( const GrayCodePattern::Params& _params, size_t _numOfColImgs, size_t _numOfRowImgs,
+                              size_t _blackThreshold, size_t _whiteThreshold, int numOfCameras ) :
+      params( _params ), numOfColImgs( _numOfColImgs ), numOfRowImgs( _numOfRowImgs ),
+      blackThreshold( _blackThreshold ), whiteThreshold( _whiteThreshold ), codes( numOfCameras ),
+      pending( numOfCameras ), numOfAddedImages( numOfCameras, 0 )
+  {
+    CV_Assert( numOfCameras > 0 );
+    // the column and the row bits share a 31-bit code word
+    CV_Assert( numOfColImgs + numOfRowImgs <= 31 );
+  }
 
-    for( int i = 0; i < params.width; i++ )
-    {
-      for( int j = 0; j < params.height; j++ )
-      {
-        cam1Pixs = camsPixels[0][i * params.height + j];
-        cam2Pixs = camsPixels[1][i * params.height + j];
+  void addPatternImage( int camera, InputArray patternImage );
 
-        if( cam1Pixs.size() == 0 || cam2Pixs.size() == 0 )
-          continue;
+  void addShadowImages( int camera, InputArray blackImage, InputArray whiteImage );
 
-        Point p1;
-        Point p2;
+  size_t getNumberOfAddedImages( int camera ) const;
 
-        double sump1x = 0;
-        double sump2x = 0;
+  bool isComplete() const;
 
-        number_of_pixels_cam1 += cam1Pixs.size();
-        number_of_pixels_cam2 += cam2Pixs.size();
-        for( int c1 = 0; c1 < (int) cam1Pixs.size(); c1++ )
-        {
-          p1 = cam1Pixs[c1];
-          sump1x += p1.x;
-        }
-        for( int c2 = 0; c2 < (int) cam2Pixs.size(); c2++ )
-        {
-          p2 = cam2Pixs[c2];
-          sump2x += p2.x;
-        }
+  void getProjPixels( int camera, OutputArray projPixels ) const;
 
-        sump2x /= cam2Pixs.size();
-        sump1x /= cam1Pixs.size();
-        for( int c1 = 0; c1 < (int) cam1Pixs.size(); c1++ )
-        {
-          p1 = cam1Pixs[c1];
-          disparityMap_.at<double>( p1.y, p1.x ) = ( double ) (sump2x - sump1x);
-        }
+  bool computeDisparity( OutputArray disparityMap ) const;
 
-        sump2x = 0;
-        sump1x = 0;
-      }
+  void reset();
+
+ private:
+  GrayCodePattern::Params params;
+  size_t numOfColImgs, numOfRowImgs;
+  size_t blackThreshold, whiteThreshold;
+
+  // The code words of each camera, CV_32S
+  std::vector<Mat> codes;
+
+  // The pattern image of each camera waiting for its inverse
+  std::vector<Mat> pending;
+
+  std::vector<size_t> numOfAddedImages;
+
+  // Allocates the code words of a camera at the size of its first image
+  void initCodes( int camera, Size size );
+
+  // The index x * height + y of the projector pixel of each camera pixel, or -1 where it is not decoded
+  void getProjPixelIndices( int camera, Mat& indices ) const;
+};
+
+void GrayCodeStreamDecoder_Impl::initCodes( int camera, Size size )
+{
+  CV_Assert( 0 <= camera && camera < (int) codes.size() );
+  if( codes[camera].empty() )
+    codes[camera] = Mat::zeros( size, CV_32S );
+  CV_Assert( codes[camera].size() == size );
+}
+
+void GrayCodeStreamDecoder_Impl::addPatternImage( int camera, InputArray patternImage )
+{
+  Mat image = patternImage.getMat();
+  CV_Assert( image.type() == CV_8UC1 );
+  initCodes( camera, image.size() );
+  CV_Assert( numOfAddedImages[camera] < 2 * ( numOfColImgs + numOfRowImgs ) );
+
+  size_t index = numOfAddedImages[camera]++;
+  if( index % 2 == 0 )
+  {
+    // keep the pattern image until its inverse comes, the capture may reuse its buffer
+    image.copyTo( pending[camera] );
+    return;
+  }
+
+  size_t pair = index / 2;
+  bool firstOfAxis = pair == 0 || pair == numOfColImgs;
+  parallel_for_( Range( 0, image.rows ),
+                 FoldPatternPairInvoker( pending[camera], image, firstOfAxis, whiteThreshold, codes[camera] ) );
+}
+
+void GrayCodeStreamDecoder_Impl::addShadowImages( int camera, InputArray blackImage, InputArray whiteImage )
+{
+  Mat black = blackImage.getMat(), white = whiteImage.getMat();
+  CV_Assert( black.type() == CV_8UC1 && white.type() == CV_8UC1 && black.size() == white.size() );
+  initCodes( camera, black.size() );
+
+  // the pixels where the white and the black images differ by blackThreshold at most are shadowed
+  Mat diff, shadowed;
+  absdiff( white, black, diff );
+  compare( diff, Scalar::all( (double) blackThreshold ), shadowed, CMP_LE );
+  bitwise_or( codes[camera], Scalar::all( (double) (int) codeErrorBit ), codes[camera], shadowed );
+}
+
+size_t GrayCodeStreamDecoder_Impl::getNumberOfAddedImages( int camera ) const
+{
+  CV_Assert( 0 <= camera && camera < (int) numOfAddedImages.size() );
+  return numOfAddedImages[camera];
+}
+
+bool GrayCodeStreamDecoder_Impl::isComplete() const
+{
+  for( size_t k = 0; k < numOfAddedImages.size(); k++ )
+  {
+    if( numOfAddedImages[k] != 2 * ( numOfColImgs + numOfRowImgs ) )
+      return false;
+  }
+  return true;
+}
+
+void GrayCodeStreamDecoder_Impl::getProjPixelIndices( int camera, Mat& indices ) const
+{
+  CV_Assert( 0 <= camera && camera < (int) codes.size() );
+  CV_Assert( numOfAddedImages[camera] == 2 * ( numOfColImgs + numOfRowImgs ) );
+
+  const Mat& code = codes[camera];
+  unsigned rowMask = ( 1u << numOfRowImgs ) - 1;
+  indices.create( code.size(), CV_32S );
+  for( int y = 0; y < code.rows; y++ )
+  {
+    const unsigned* d = code.ptr<unsigned>( y );
+    int* dst = indices.ptr<int>( y );
+    for( int x = 0; x < code.cols; x++ )
+    {
+      int col = (int) ( ( d[x] & codeBitsMask ) >> numOfRowImgs ), row = (int) ( d[x] & rowMask );
+      bool valid = !( d[x] & codeErrorBit ) && col < params.width && row < params.height;
+      dst[x] = valid ? col * params.height + row : -1;
     }
+  }
+}
 
-    return true;
-  }  // end if flags
+void GrayCodeStreamDecoder_Impl::getProjPixels( int camera, OutputArray projPixels ) const
+{
+  Mat indices;
+  getProjPixelIndices( camera, indices );
 
-  return false;
+  projPixels.create( indices.size(), CV_32SC2 );
+  Mat projPixels_ = projPixels.getMat();
+  for( int y = 0; y < indices.rows; y++ )
+  {
+    const int* idx = indices.ptr<int>( y );
+    Point* dst = projPixels_.ptr<Point>( y );
+    for( int x = 0; x < indices.cols; x++ )
+      dst[x] = idx[x] < 0 ? Point( -1, -1 ) : Point( idx[x] / params.height, idx[x] % params.height );
+  }
+}
+
+bool GrayCodeStreamDecoder_Impl::computeDisparity( OutputArray disparityMap ) const
+{
+  if( codes.size() < 2 || !isComplete() )
+    return false;
+
+  std::vector<Mat> projPixels( 2 );
+  for( int k = 0; k < 2; k++ )
+    getProjPixelIndices( k, projPixels[k] );
+
+  Mat disparityMap_;
+  computeDisparityMap( projPixels, params.width * params.height, disparityMap_ );
+  disparityMap_.copyTo( disparityMap );
+  return true;
+}
+
+void GrayCodeStreamDecoder_Impl::reset()
+{
+  for( size_t k = 0; k < codes.size(); k++ )
+  {
+    codes[k].release();
+    pending[k].release();
+    numOfAddedImages[k] = 0;
+  }
+}
+
+Ptr<GrayCodeStreamDecoder> GrayCodePattern_Impl::createStreamDecoder( int numOfCameras ) const
+{
+  return makePtr<GrayCodeStreamDecoder_Impl>( params, numOfColImgs, numOfRowImgs, blackThreshold, whiteThreshold,
+                                              numOfCameras );
 }
 
 // Computes the required number of pattern images
@@ -334,30 +680,12 @@ void GrayCodePattern_Impl::computeShadowMasks( InputArrayOfArrays blackImages, I
 
   shadowMasks_.resize( whiteImages_.size() );
 
-  int cam_width = whiteImages_[0].cols;
-  int cam_height = whiteImages_[0].rows;
-
-  // TODO: parallelize for
+  // 1 where the white and the black images differ by more than blackThreshold
+  Mat diff;
   for( int k = 0; k < (int) shadowMasks_.size(); k++ )
   {
-    shadowMasks_[k] = Mat( cam_height, cam_width, CV_8U );
-    for( int i = 0; i < cam_width; i++ )
-    {
-      for( int j = 0; j < cam_height; j++ )
-      {
-        double white = whiteImages_[k].at<uchar>( Point( i, j ) );
-        double black = blackImages_[k].at<uchar>( Point( i, j ) );
-
-        if( abs(white - black) > blackThreshold )
-        {
-          shadowMasks_[k].at<uchar>( Point( i, j ) ) = ( uchar ) 1;
-        }
-        else
-        {
-          shadowMasks_[k].at<uchar>( Point( i, j ) ) = ( uchar ) 0;
-        }
-      }
-    }
+    absdiff( whiteImages_[k], blackImages_[k], diff );
+    threshold( diff, shadowMasks_[k], (double) blackThreshold, 1, THRESH_BINARY );
   }
 }
 
@@ -0,0 +1,147 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2015, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+
+/****************************************************************************************\
+*                                   Decode test                                          *
+\****************************************************************************************/
+class CV_GrayCodeDecodeTest : public cvtest::BaseTest
+{
+ public:
+  // streaming: decode with a GrayCodeStreamDecoder fed one image at a time
+  explicit CV_GrayCodeDecodeTest( bool streaming );
+  ~CV_GrayCodeDecodeTest();
+ protected:
+  void run(int);
+
+  bool streaming;
+};
+
+CV_GrayCodeDecodeTest::CV_GrayCodeDecodeTest( bool _streaming ) : streaming( _streaming ){}
+
+CV_GrayCodeDecodeTest::~CV_GrayCodeDecodeTest(){}
+
+void CV_GrayCodeDecodeTest::run( int )
+{
+  // A width that is not a multiple of the vector size, to reach the scalar tail of the decoding
+  const int width = 67, height = 40, shift = 5;
+  Ptr<structured_light::GrayCodePattern> graycode = structured_light::GrayCodePattern::create( width, height );
+
+  vector<Mat> pattern;
+  graycode->generate( pattern );
+
+  // The first camera sees the pattern as it is, the second one sees it moved left by shift pixels
+  vector<vector<Mat> > captured( 2, vector<Mat>( pattern.size() ) );
+  for( size_t i = 0; i < pattern.size(); i++ )
+  {
+    captured[0][i] = pattern[i].clone();
+    captured[1][i] = Mat::zeros( height, width, CV_8U );
+    pattern[i].colRange( shift, width ).copyTo( captured[1][i].colRange( 0, width - shift ) );
+  }
+
+  vector<Mat> blackImages( 2, Mat( height, width, CV_8U, Scalar( 0 ) ) );
+  vector<Mat> whiteImages( 2, Mat( height, width, CV_8U, Scalar( 255 ) ) );
+
+  Mat disparityMap;
+  if( streaming )
+  {
+    Ptr<structured_light::GrayCodeStreamDecoder> decoder = graycode->createStreamDecoder( 2 );
+
+    // the shadow images may come before or after the pattern images
+    decoder->addShadowImages( 0, blackImages[0], whiteImages[0] );
+    for( size_t i = 0; i < pattern.size(); i++ )
+    {
+      EXPECT_FALSE( decoder->isComplete() );
+      decoder->addPatternImage( 0, captured[0][i] );
+      decoder->addPatternImage( 1, captured[1][i] );
+    }
+    decoder->addShadowImages( 1, blackImages[1], whiteImages[1] );
+    ASSERT_TRUE( decoder->isComplete() );
+    ASSERT_EQ( pattern.size(), decoder->getNumberOfAddedImages( 1 ) );
+
+    Mat projPixels;
+    decoder->getProjPixels( 0, projPixels );
+    ASSERT_EQ( CV_32SC2, projPixels.type() );
+    for( int y = 0; y < height; y++ )
+      for( int x = 0; x < width; x++ )
+        EXPECT_EQ( Point( x, y ), projPixels.at<Point>( y, x ) );
+
+    ASSERT_TRUE( decoder->computeDisparity( disparityMap ) );
+  }
+  else
+  {
+    bool decoded = graycode->decode( captured, disparityMap, blackImages, whiteImages,
+                                     structured_light::DECODE_3D_UNDERWORLD );
+    ASSERT_TRUE( decoded );
+  }
+  ASSERT_EQ( CV_64F, disparityMap.type() );
+  ASSERT_EQ( Size( width, height ), disparityMap.size() );
+
+  for( int y = 0; y < height; y++ )
+  {
+    for( int x = 0; x < width; x++ )
+    {
+      // the columns of the projector that are out of the view of the second camera have no disparity
+      double expected = x < shift ? 0. : -shift;
+      EXPECT_EQ( expected, disparityMap.at<double>( y, x ) ) << "at (" << x << ", " << y << ")";
+    }
+  }
+}
+
+/****************************************************************************************\
+*                                Test registration                                     *
+\****************************************************************************************/
+
+TEST( GrayCodePattern, decode )
+{
+  CV_GrayCodeDecodeTest test( false );
+  test.safe_run();
+}
+
+TEST( GrayCodePattern, streamDecode )
+{
+  CV_GrayCodeDecodeTest test( true );
+  test.safe_run();
+}
@@ -138,6 +138,21 @@ public:
      */
   int registerModelToScene(const Mat& srcPC, const Mat& dstPC, double& residual, double pose[16]);
 
+  /**
+     *  \brief Perform registration against a scene indexed beforehand
+     *
+     *  @param [in] srcPC The input point cloud for the model. Expected to have the normals (Nx6).
+     *  @param [in] dstPC The input point cloud for the scene, with the normals (Nx6).
+     *  @param [in] sceneIndex Index of dstPC built with indexPCFlann(dstPC). It is only read, so
+     *  the same index can be shared by several registrations running concurrently.
+     *  @param [out] residual The output registration error.
+     *  @param [out] pose Transformation between srcPC and dstPC.
+     *  \return On successful termination, the function returns 0.
+     *
+     *  \details Same as the overload without index, which builds the index on each call.
+     */
+  int registerModelToScene(const Mat& srcPC, const Mat& dstPC, const void* sceneIndex, double& residual, double pose[16]);
+
   /**
      *  \brief Perform registration with multiple initial poses
      *
@@ -147,7 +162,7 @@ public:
      *  @param [in,out] poses Input poses to start with but also list output of poses.
      *  \return On successful termination, the function returns 0.
      *
-     *  \details It is assumed that the model is registered on the scene. Scene remains static, while the model transforms. The output poses transform the models onto the scene. Because of the point to plane minimization, the scene is expected to have the normals available. Expected to have the normals (Nx6).
+     *  \details The scene is indexed once and the poses are refined in parallel. It is assumed that the model is registered on the scene. Scene remains static, while the model transforms. The output poses transform the models onto the scene. Because of the point to plane minimization, the scene is expected to have the normals available. Expected to have the normals (Nx6).
      */
   int registerModelToScene(const Mat& srcPC, const Mat& dstPC, std::vector<Pose3DPtr>& poses);
 
@@ -56,19 +56,59 @@ namespace ppf_match_3d
 
 /**
  *  @brief Load a PLY file
- *  @param [in] fileName The PLY model to read
+ *  @param [in] fileName The PLY model to read, in ASCII or binary format
  *  @param [in] withNormals Flag wheather the input PLY contains normal information,
  *  and whether it should be loaded or not
  *  @return Returns the matrix on successfull load
  */
 CV_EXPORTS Mat loadPLYSimple(const char* fileName, int withNormals);
 
+/**
+ *  @brief Reads the vertices of a PLY file by chunks, so that large point clouds can be
+ *  processed without holding the whole file in memory.
+ *
+ *  ASCII, binary little endian and binary big endian files are supported. The vertex
+ *  properties x, y, z and nx, ny, nz are picked by name whatever their type and position, the
+ *  other properties are skipped. Binary files whose vertices are exactly the requested float
+ *  columns are read straight into the output matrix. The normals are normalized to unit norm.
+ */
+class CV_EXPORTS PLYReader
+{
+public:
+  PLYReader();
+  ~PLYReader();
+
+  /**
+   *  @brief Open a file and parse its header
+   *  @param [in] fileName The PLY file to read
+   *  @param [in] withNormals Whether the normals are read, in the columns 3 to 5
+   *  @return false if the file cannot be read
+   */
+  bool open(const char* fileName, int withNormals);
+  void close();
+
+  int getNumVertices() const;
+
+  /**
+   *  @brief Read the next vertices
+   *  @param [out] chunk The vertices, with 3 or 6 CV_32F columns
+   *  @param [in] maxRows Maximum number of vertices to read
+   *  @return Number of vertices read, 0 at the end of the file or on error
+   */
+  int read(Mat& chunk, int maxRows);
+
+private:
+  struct Impl;
+  Ptr<Impl> impl;
+};
+
 /**
  *  @brief Write a point cloud to PLY file
  *  @param [in] PC Input point cloud
  *  @param [in] fileName The PLY model file to write
+ *  @param [in] binary Write a binary little endian file instead of an ASCII one
 */
-CV_EXPORTS void writePLY(Mat PC, const char* fileName);
+CV_EXPORTS void writePLY(Mat PC, const char* fileName, bool binary=false);
 
 /**
 *  @brief Used for debbuging pruposes, writes a point cloud to a PLY file with the tip
@@ -92,14 +132,21 @@ Mat samplePCUniformInd(Mat PC, int sampleStep, std::vector<int>& indices);
  *  the parameter sample_step_relative. 
  *  @param [in] weightByCenter The contribution of the quantized data points can be weighted
  *  by the distance to the origin. This parameter enables/disables the use of weighting.
- *  @return Sampled point cloud
+ *  @return Sampled point cloud, one point per occupied cell. Only the occupied cells are stored,
+ *  so the memory used is linear in the number of points whatever the sampling step.
 */
 CV_EXPORTS Mat samplePCByQuantization(Mat pc, float xrange[2], float yrange[2], float zrange[2], float sample_step_relative, int weightByCenter=0);
 
 void computeBboxStd(Mat pc, float xRange[2], float yRange[2], float zRange[2]);
 
-void* indexPCFlann(Mat pc);
-void destroyFlann(void* flannIndex);
+/**
+ *  @brief Builds a KD-tree over the points (first three columns) of a point cloud, e.g. the scene
+ *  shared by several ICP registrations. The index has to be released with destroyFlann.
+ *  @param [in] pc Input point cloud (CV_32F family)
+ *  @return Opaque pointer to the index
+*/
+CV_EXPORTS void* indexPCFlann(Mat pc);
+CV_EXPORTS void destroyFlann(void* flannIndex);
 void queryPCFlann(void* flannIndex, Mat& pc, Mat& indices, Mat& distances);
 void queryPCFlann(void* flannIndex, Mat& pc, Mat& indices, Mat& distances, const int numNeighbors);
 
@@ -82,6 +82,8 @@ typedef struct THash
   int i, ppfInd;
 } THash;
 
+class PoseClusterHash;
+
 /**
   * @brief Class, allowing the load and matching 3D models.
   * Typical Use:
@@ -149,7 +151,7 @@ protected:
   double sampling_step_relative, angle_step_relative, distance_step_relative;
   Mat sampled_pc, ppf;
   int num_ref_points, ppf_step;
-  hashtable_int* hash_table;
+  hashtable_flat* hash_table;
   THash* hash_nodes;
 
   double position_threshold, rotation_threshold;
@@ -166,6 +168,9 @@ private:
 
   bool matchPose(const Pose3D& sourcePose, const Pose3D& targetPose);
 
+  int findPoseCluster(const Pose3D& pose, const std::vector<PoseCluster3DPtr>& poseClusters,
+                      const PoseClusterHash& clusterHash, int minIndex, int maxIndex);
+
   void clusterPoses(std::vector<Pose3DPtr> poseList, int numPoses, std::vector<Pose3DPtr> &finalPoses);
 
   bool trained;
@@ -103,6 +103,41 @@ hashtable_int *hashtableRead(FILE* f);
 int hashtableWrite(const hashtable_int * hashtbl, const size_t dataSize, FILE* f);
 void hashtablePrint(hashtable_int *hashtbl);
 
+/** @brief Static hashtable with the values of each key stored contiguously
+
+The table is built once from all its entries. The distinct keys are grouped by bucket and
+the values are grouped by key, in the order of insertion, in flat CSR-like arrays: the keys of
+bucket b are keys[bucketOffsets[b] .. bucketOffsets[b+1]) and the values of the k-th key are
+values[valueOffsets[k] .. valueOffsets[k+1]). A lookup visits a few contiguous arrays instead of
+a linked list.
+
+All the arrays are stored in a single block of 32 bit words preceded by a small header, which is
+also the serialized form of the table, so that a written table can be mapped in memory and
+attached without any copy.
+*/
+typedef struct HSHTBL_flat
+{
+  size_t size; // number of buckets, a power of two
+  size_t numKeys, numValues;
+  const unsigned int* bucketOffsets;
+  const KeyType* keys;
+  const unsigned int* valueOffsets;
+  const unsigned int* values;
+  const unsigned int* block; // header and arrays
+  size_t blockSize; // in bytes
+  bool ownsBlock;
+} hashtable_flat;
+
+/** @brief Build a static hashtable from numEntries pairs of keys and values */
+hashtable_flat *hashtableFlatCreate(const KeyType* keys, const unsigned int* values, size_t numEntries);
+/** @brief Attach a static hashtable to a serialized block (e.g. a mapped file), which has to outlive it */
+hashtable_flat *hashtableFlatAttach(const void* block, size_t blockSize);
+void hashtableFlatDestroy(hashtable_flat *hashtbl);
+/** @brief Values of a key, their number is returned in count */
+const unsigned int* hashtableFlatGet(const hashtable_flat *hashtbl, KeyType key, size_t* count);
+hashtable_flat *hashtableFlatRead(FILE* f);
+int hashtableFlatWrite(const hashtable_flat *hashtbl, FILE* f);
+
 //! @}
 
 } // namespace ppf_match_3d
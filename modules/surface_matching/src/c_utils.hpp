@@ -659,6 +659,94 @@ static inline void quatToDCM(double *q, double *R)
   R[7] = 2.0 * (tmp1 - tmp2);
 }
 
+/**
+ *  \brief Eigenvector of the smallest eigenvalue of a symmetric 3x3 matrix, in closed form
+ *
+ *  The eigenvalue is the smallest root of the characteristic polynomial, from the trigonometric
+ *  solution of the cubic. The eigenvector is the largest cross product of two rows of A-lambda*I,
+ *  when the eigenvalue is repeated it is any vector orthogonal to the remaining direction.
+ *
+ *  \param [in] C Symmetric matrix
+ *  \param [out] v Unit eigenvector
+ */
+static inline void eigenVectorMinSym33(const double C[3][3], double v[3])
+{
+  // scale the matrix, so that the thresholds are relative and nothing overflows
+  double scale = 0;
+  for (int i=0; i<3; i++)
+    for (int j=0; j<3; j++)
+      scale = fabs(C[i][j]) > scale ? fabs(C[i][j]) : scale;
+
+  v[0] = 0; v[1] = 0; v[2] = 1;
+  if (scale == 0)
+    return;
+
+  double A[3][3];
+  for (int i=0; i<3; i++)
+    for (int j=0; j<3; j++)
+      A[i][j] = C[i][j] / scale;
+
+  const double q = (A[0][0] + A[1][1] + A[2][2]) / 3;
+  const double p1 = A[0][1]*A[0][1] + A[0][2]*A[0][2] + A[1][2]*A[1][2];
+  const double p2 = (A[0][0]-q)*(A[0][0]-q) + (A[1][1]-q)*(A[1][1]-q) + (A[2][2]-q)*(A[2][2]-q) + 2*p1;
+  double lambda = q;
+
+  if (p2 > 0)
+  {
+    // r = det(B)/2 with B = (A-q*I)/p
+    const double p = sqrt(p2 / 6);
+    const double b00 = (A[0][0]-q)/p, b11 = (A[1][1]-q)/p, b22 = (A[2][2]-q)/p;
+    const double b01 = A[0][1]/p, b02 = A[0][2]/p, b12 = A[1][2]/p;
+    double r = 0.5 * (b00*(b11*b22 - b12*b12) - b01*(b01*b22 - b12*b02) + b02*(b01*b12 - b11*b02));
+    r = r < -1 ? -1 : (r > 1 ? 1 : r);
+    lambda = q + 2 * p * cos(acos(r) / 3 + 2 * M_PI / 3);
+  }
+
+  double rows[3][3];
+  double maxRowNorm = 0;
+  int maxRow = 0;
+  for (int i=0; i<3; i++)
+  {
+    for (int j=0; j<3; j++)
+      rows[i][j] = A[i][j] - (i==j ? lambda : 0);
+    const double n = TDot3(rows[i], rows[i]);
+    if (n > maxRowNorm)
+    {
+      maxRowNorm = n;
+      maxRow = i;
+    }
+  }
+  if (maxRowNorm == 0)
+    return;
+
+  const int pairs[3][2] = { {0, 1}, {0, 2}, {1, 2} };
+  double maxCrossNorm = 0;
+  for (int k=0; k<3; k++)
+  {
+    double c[3];
+    TCross(rows[pairs[k][0]], rows[pairs[k][1]], c);
+    const double n = TDot3(c, c);
+    if (n > maxCrossNorm)
+    {
+      maxCrossNorm = n;
+      v[0] = c[0]; v[1] = c[1]; v[2] = c[2];
+    }
+  }
+
+  if (maxCrossNorm <= 1e-12 * maxRowNorm * maxRowNorm)
+  {
+    // A-lambda*I has rank one, cross its row with the axis the least aligned with it
+    const double* row = rows[maxRow];
+    double axis[3] = {0, 0, 0};
+    int k = fabs(row[0]) < fabs(row[1]) ? 0 : 1;
+    k = fabs(row[k]) < fabs(row[2]) ? k : 2;
+    axis[k] = 1;
+    TCross(row, axis, v);
+  }
+
+  TNormalize3(v);
+}
+
 } // namespace ppf_match_3d
 
 } // namespace cv
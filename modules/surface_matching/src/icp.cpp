@@ -294,6 +294,17 @@ static hashtable_int* getHashtable(int* data, size_t length, int numMaxElement)
 
 // source point clouds are assumed to contain their normals
 int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, double& residual, double pose[16])
+{
+  void* flann = indexPCFlann(dstPC);
+  int status = registerModelToScene(srcPC, dstPC, flann, residual, pose);
+  destroyFlann(flann);
+  return status;
+}
+
+// The scene index is built on the original scene points, while the registration works on the
+// normalized clouds. The normalization is a similarity, so the nearest neighbours are the same:
+// the queries are mapped back to the scene frame and the squared distances are rescaled.
+int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, const void* sceneIndex, double& residual, double pose[16])
 {
   int n = srcPC.rows;
 
@@ -307,6 +318,7 @@ int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, double& residu
   double meanAvg[3]={0.5*(meanSrc[0]+meanDst[0]), 0.5*(meanSrc[1]+meanDst[1]), 0.5*(meanSrc[2]+meanDst[2])};
   subtractColumns(srcTemp, meanAvg);
   subtractColumns(dstTemp, meanAvg);
+  double negMeanAvg[3]={-meanAvg[0], -meanAvg[1], -meanAvg[2]};
 
   double distSrc = computeDistToOrigin(srcTemp);
   double distDst = computeDistToOrigin(dstTemp);
@@ -322,8 +334,9 @@ int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, double& residu
   // initialize pose
   matrixIdentity(4, pose);
 
-  void* flann = indexPCFlann(dstPC0);
+  void* flann = const_cast<void*>(sceneIndex);
   Mat M = Mat::eye(4,4,CV_64F);
+  Mat Src_Query;
 
   double tempResidual = 0;
 
@@ -384,10 +397,14 @@ int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, double& residu
     {
       size_t di=0, selInd = 0;
 
-      queryPCFlann(flann, Src_Moved, Indices, Distances);
+      Src_Moved.colRange(0, 3).copyTo(Src_Query);
+      Src_Query *= 1.0/scale;
+      subtractColumns(Src_Query, negMeanAvg);
+      queryPCFlann(flann, Src_Query, Indices, Distances);
 
       for (di=0; di<numElSrc; di++)
       {
+        distances[di] *= (float)(scale*scale);
         newI[di] = (int)di;
         newJ[di] = indices[di];
       }
@@ -533,20 +550,27 @@ int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, double& residu
 
   residual = tempResidual;
 
-  destroyFlann(flann);
   return 0;
 }
 
 // source point clouds are assumed to contain their normals
 int ICP::registerModelToScene(const Mat& srcPC, const Mat& dstPC, std::vector<Pose3DPtr>& poses)
 {
-  for (size_t i=0; i<poses.size(); i++)
+  // the scene index is only read by the registrations, it is shared by all of them
+  void* flann = indexPCFlann(dstPC);
+
+#if defined _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i=0; i<(int)poses.size(); i++)
   {
     double poseICP[16]={0};
     Mat srcTemp = transformPCPose(srcPC, poses[i]->pose);
-    registerModelToScene(srcTemp, dstPC, poses[i]->residual, poseICP);
+    registerModelToScene(srcTemp, dstPC, flann, poses[i]->residual, poseICP);
     poses[i]->appendPose(poseICP);
   }
+
+  destroyFlann(flann);
   return 0;
 }
 
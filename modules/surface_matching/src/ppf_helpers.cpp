@@ -55,64 +55,288 @@ void getRandomRotation(double R[9]);
 void meanCovLocalPC(const float* pc, const int ws, const int point_count, double CovMat[3][3], double Mean[4]);
 void meanCovLocalPCInd(const float* pc, const int* Indices, const int ws, const int point_count, double CovMat[3][3], double Mean[4]);
 
-Mat loadPLYSimple(const char* fileName, int withNormals)
+enum PLYFormat
 {
-  Mat cloud;
-  int numVertices=0;
+  PLY_ASCII,
+  PLY_BINARY_LITTLE_ENDIAN,
+  PLY_BINARY_BIG_ENDIAN
+};
+
+enum PLYType
+{
+  PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32, PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64
+};
+
+static int plyTypeFromName(const std::string& name)
+{
+  if (name == "char" || name == "int8") return PLY_INT8;
+  if (name == "uchar" || name == "uint8") return PLY_UINT8;
+  if (name == "short" || name == "int16") return PLY_INT16;
+  if (name == "ushort" || name == "uint16") return PLY_UINT16;
+  if (name == "int" || name == "int32") return PLY_INT32;
+  if (name == "uint" || name == "uint32") return PLY_UINT32;
+  if (name == "float" || name == "float32") return PLY_FLOAT32;
+  if (name == "double" || name == "float64") return PLY_FLOAT64;
+  return -1;
+}
 
-  std::ifstream ifs(fileName);
+static size_t plyTypeSize(int type)
+{
+  static const size_t sizes[] = {1, 1, 2, 2, 4, 4, 4, 8};
+  return sizes[type];
+}
+
+static bool isHostLittleEndian()
+{
+  const int one = 1;
+  return *(const char*)&one == 1;
+}
+
+static float readPLYValue(const uchar* ptr, int type, bool swapBytes)
+{
+  uchar bytes[8];
+  const size_t size = plyTypeSize(type);
+  for (size_t k = 0; k < size; k++)
+    bytes[k] = swapBytes ? ptr[size-1-k] : ptr[k];
 
-  if (!ifs.is_open())
+  switch (type)
   {
-    printf("Cannot open file...\n");
-    return Mat();
+  case PLY_INT8: { schar v; memcpy(&v, bytes, size); return (float)v; }
+  case PLY_UINT8: { uchar v; memcpy(&v, bytes, size); return (float)v; }
+  case PLY_INT16: { short v; memcpy(&v, bytes, size); return (float)v; }
+  case PLY_UINT16: { ushort v; memcpy(&v, bytes, size); return (float)v; }
+  case PLY_INT32: { int v; memcpy(&v, bytes, size); return (float)v; }
+  case PLY_UINT32: { unsigned int v; memcpy(&v, bytes, size); return (float)v; }
+  case PLY_FLOAT32: { float v; memcpy(&v, bytes, size); return v; }
+  default: { double v; memcpy(&v, bytes, size); return (float)v; }
   }
+}
 
-  std::string str;
-  while (str.substr(0, 10) !="end_header")
+static void normalizeNormals(Mat& pc)
+{
+  for (int i = 0; i < pc.rows; i++)
   {
-    std::string entry = str.substr(0, 14);
-    if (entry == "element vertex")
+    float* data = pc.ptr<float>(i);
+
+    // normalize to unit norm
+    double norm = sqrt(data[3]*data[3] + data[4]*data[4] + data[5]*data[5]);
+    if (norm>0.00001)
     {
-      numVertices = atoi(str.substr(15, str.size()-15).c_str());
+      data[3]/=(float)norm;
+      data[4]/=(float)norm;
+      data[5]/=(float)norm;
     }
-    std::getline(ifs, str);
   }
+}
 
-  if (withNormals)
-    cloud=Mat(numVertices, 6, CV_32FC1);
-  else
-    cloud=Mat(numVertices, 3, CV_32FC1);
+struct PLYReader::Impl
+{
+  std::ifstream ifs;
+  int format;
+  int numVertices, numRead;
+  int numCols;
+  std::vector<int> propTypes;
+  std::vector<size_t> propOffsets;
+  size_t vertexSize;
+  int columns[6]; // property of each output column
+  bool directRead; // the binary vertices are the output rows
+  std::vector<uchar> buffer;
+  std::vector<float> values;
+};
+
+PLYReader::PLYReader() : impl(new Impl)
+{
+  impl->numVertices = impl->numRead = 0;
+}
+
+PLYReader::~PLYReader()
+{
+  close();
+}
+
+void PLYReader::close()
+{
+  if (impl->ifs.is_open())
+    impl->ifs.close();
+  impl->numVertices = impl->numRead = 0;
+}
 
-  for (int i = 0; i < numVertices; i++)
+int PLYReader::getNumVertices() const
+{
+  return impl->numVertices;
+}
+
+bool PLYReader::open(const char* fileName, int withNormals)
+{
+  close();
+  impl->ifs.open(fileName, std::ios::in | std::ios::binary);
+  if (!impl->ifs.is_open())
+    return false;
+
+  impl->format = PLY_ASCII;
+  impl->numCols = withNormals ? 6 : 3;
+  impl->propTypes.clear();
+  impl->propOffsets.clear();
+  impl->vertexSize = 0;
+
+  static const char* names[6] = {"x", "y", "z", "nx", "ny", "nz"};
+  std::vector<std::string> propNames;
+  std::string line, currentElement;
+  bool vertexFirst = true, header = true;
+
+  while (header)
   {
-    float* data = (float*)(&cloud.data[i*cloud.step[0]]);
-    if (withNormals)
+    if (!std::getline(impl->ifs, line))
+      return false;
+    if (!line.empty() && line[line.size()-1] == '\r')
+      line.erase(line.size()-1);
+
+    std::istringstream tokens(line);
+    std::string keyword;
+    tokens >> keyword;
+
+    if (keyword == "end_header")
+      header = false;
+    else if (keyword == "format")
+    {
+      std::string format;
+      tokens >> format;
+      if (format == "binary_little_endian")
+        impl->format = PLY_BINARY_LITTLE_ENDIAN;
+      else if (format == "binary_big_endian")
+        impl->format = PLY_BINARY_BIG_ENDIAN;
+    }
+    else if (keyword == "element")
+    {
+      int count = 0;
+      tokens >> currentElement >> count;
+      if (currentElement == "vertex")
+        impl->numVertices = count;
+      else if (impl->numVertices == 0 && count > 0)
+        vertexFirst = false;
+    }
+    else if (keyword == "property" && currentElement == "vertex")
     {
-      ifs >> data[0] >> data[1] >> data[2] >> data[3] >> data[4] >> data[5];
+      std::string type, name;
+      tokens >> type >> name;
+      const int plyType = plyTypeFromName(type);
+      if (plyType < 0)
+        return false; // list properties of vertices are not supported
+
+      impl->propTypes.push_back(plyType);
+      impl->propOffsets.push_back(impl->vertexSize);
+      impl->vertexSize += plyTypeSize(plyType);
+      propNames.push_back(name);
+    }
+  }
+
+  // the data of the other elements would have to be skipped in binary files
+  if (impl->format != PLY_ASCII && !vertexFirst)
+    return false;
+
+  // the columns are found by name, or by position as in the files without property names
+  const int numProps = (int)propNames.size();
+  for (int c = 0; c < impl->numCols; c++)
+  {
+    impl->columns[c] = (int)(std::find(propNames.begin(), propNames.end(), names[c]) - propNames.begin());
+    if (impl->columns[c] == numProps)
+      impl->columns[c] = c;
+    if (impl->format != PLY_ASCII && impl->columns[c] >= numProps)
+      return false;
+  }
+
+  impl->directRead = impl->format == (isHostLittleEndian() ? PLY_BINARY_LITTLE_ENDIAN : PLY_BINARY_BIG_ENDIAN) &&
+                     numProps == impl->numCols;
+  for (int c = 0; c < impl->numCols && impl->directRead; c++)
+    impl->directRead = impl->columns[c] == c && impl->propTypes[c] == PLY_FLOAT32;
+
+  return true;
+}
+
+int PLYReader::read(Mat& chunk, int maxRows)
+{
+  const int numRows = std::min(maxRows, impl->numVertices - impl->numRead);
+  if (numRows <= 0 || !impl->ifs.is_open())
+  {
+    chunk = Mat();
+    return 0;
+  }
+  chunk.create(numRows, impl->numCols, CV_32FC1);
 
-      // normalize to unit norm
-      double norm = sqrt(data[3]*data[3] + data[4]*data[4] + data[5]*data[5]);
-      if (norm>0.00001)
+  if (impl->directRead && chunk.isContinuous())
+  {
+    impl->ifs.read((char*)chunk.data, (std::streamsize)(numRows * impl->vertexSize));
+  }
+  else if (impl->format != PLY_ASCII)
+  {
+    const bool swapBytes = (impl->format == PLY_BINARY_LITTLE_ENDIAN) != isHostLittleEndian();
+    impl->buffer.resize(numRows * impl->vertexSize);
+    impl->ifs.read((char*)&impl->buffer[0], (std::streamsize)impl->buffer.size());
+
+    for (int i = 0; i < numRows; i++)
+    {
+      const uchar* vertex = &impl->buffer[i * impl->vertexSize];
+      float* data = chunk.ptr<float>(i);
+      for (int c = 0; c < impl->numCols; c++)
       {
-        data[3]/=(float)norm;
-        data[4]/=(float)norm;
-        data[5]/=(float)norm;
+        const int prop = impl->columns[c];
+        data[c] = readPLYValue(vertex + impl->propOffsets[prop], impl->propTypes[prop], swapBytes);
       }
     }
-    else
+  }
+  else
+  {
+    const int numProps = (int)impl->propTypes.size();
+    int numValues = impl->numCols;
+    for (int c = 0; c < impl->numCols; c++)
+      numValues = std::max(numValues, impl->columns[c] + 1);
+    numValues = std::max(numValues, numProps);
+    impl->values.resize(numValues);
+
+    for (int i = 0; i < numRows; i++)
     {
-      ifs >> data[0] >> data[1] >> data[2];
+      float* data = chunk.ptr<float>(i);
+      for (int k = 0; k < numValues; k++)
+        impl->ifs >> impl->values[k];
+      for (int c = 0; c < impl->numCols; c++)
+        data[c] = impl->values[impl->columns[c]];
     }
   }
 
+  if (impl->ifs.fail())
+  {
+    close();
+    chunk = Mat();
+    return 0;
+  }
+
+  if (impl->numCols == 6)
+    normalizeNormals(chunk);
+
+  impl->numRead += numRows;
+  return numRows;
+}
+
+Mat loadPLYSimple(const char* fileName, int withNormals)
+{
+  PLYReader reader;
+
+  if (!reader.open(fileName, withNormals))
+  {
+    printf("Cannot open file...\n");
+    return Mat();
+  }
+
+  Mat cloud;
+  reader.read(cloud, reader.getNumVertices());
+
   //cloud *= 5.0f;
   return cloud;
 }
 
-void writePLY(Mat PC, const char* FileName)
+void writePLY(Mat PC, const char* FileName, bool binary)
 {
-  std::ofstream outFile( FileName );
+  std::ofstream outFile( FileName, binary ? std::ios::out | std::ios::binary : std::ios::out );
 
   if ( !outFile )
   {
@@ -129,7 +353,7 @@ void writePLY(Mat PC, const char* FileName)
   const int vertNum  = ( int ) PC.cols;
 
   outFile << "ply" << std::endl;
-  outFile << "format ascii 1.0" << std::endl;
+  outFile << (binary ? "format binary_little_endian 1.0" : "format ascii 1.0") << std::endl;
   outFile << "element vertex " << pointNum << std::endl;
   outFile << "property float x" << std::endl;
   outFile << "property float y" << std::endl;
@@ -146,6 +370,21 @@ void writePLY(Mat PC, const char* FileName)
   // Points
   ////
 
+  const int numCols = vertNum==6 ? 6 : 3;
+  if (binary)
+  {
+    const bool swapBytes = !isHostLittleEndian();
+    std::vector<uchar> row(numCols * sizeof(float));
+    for ( int pi = 0; pi < pointNum; ++pi )
+    {
+      const uchar* point = PC.ptr<uchar>(pi);
+      for (size_t k = 0; k < row.size(); k++)
+        row[k] = swapBytes ? point[(k/4)*4 + 3 - k%4] : point[k];
+      outFile.write((const char*)&row[0], (std::streamsize)row.size());
+    }
+    return;
+  }
+
   for ( int pi = 0; pi < pointNum; ++pi )
   {
     const float* point = (float*)(&PC.data[ pi*PC.step ]);
@@ -274,25 +513,28 @@ void queryPCFlann(void* flannIndex, Mat& pc, Mat& indices, Mat& distances, const
   ((FlannIndex*)flannIndex)->knnSearch(obj_32f, indices, distances, numNeighbors, cvflann::SearchParams(32));
 }
 
+// Cell in the grid of a point and its index
+typedef std::pair<int64, int> PointCell;
+
 // uses a volume instead of an octree
 // TODO: Right now normals are required.
 // This is much faster than sample_pc_octree
+// Only the occupied cells are stored: the points are sorted by their cell, so the memory is linear
+// in the number of points whatever the sampling step, and the output is in the order of the cells.
 Mat samplePCByQuantization(Mat pc, float xrange[2], float yrange[2], float zrange[2], float sampleStep, int weightByCenter)
 {
-  std::vector< std::vector<int> > map;
-
-  int numSamplesDim = (int)(1.0/sampleStep);
+  const int numSamplesDim = (int)(1.0/sampleStep);
+  const int64 numSamplesDim2 = (int64)numSamplesDim*numSamplesDim;
 
   float xr = xrange[1] - xrange[0];
   float yr = yrange[1] - yrange[0];
   float zr = zrange[1] - zrange[0];
 
-  int numPoints = 0;
+  std::vector<PointCell> cells(pc.rows);
 
-  map.resize((numSamplesDim+1)*(numSamplesDim+1)*(numSamplesDim+1));
-
-  // OpenMP might seem like a good idea, but it didn't speed this up for me
-  //#pragma omp parallel for
+#if defined _OPENMP
+#pragma omp parallel for
+#endif
   for (int i=0; i<pc.rows; i++)
   {
     const float* point = (float*)(&pc.data[i * pc.step]);
@@ -301,126 +543,124 @@ Mat samplePCByQuantization(Mat pc, float xrange[2], float yrange[2], float zrang
     const int xCell =(int) ((float)numSamplesDim*(point[0]-xrange[0])/xr);
     const int yCell =(int) ((float)numSamplesDim*(point[1]-yrange[0])/yr);
     const int zCell =(int) ((float)numSamplesDim*(point[2]-zrange[0])/zr);
-    const int index = xCell*numSamplesDim*numSamplesDim+yCell*numSamplesDim+zCell;
-
-    /*#pragma omp critical
-        {*/
-    map[index].push_back(i);
-    //  }
+    cells[i] = PointCell(xCell*numSamplesDim2+(int64)yCell*numSamplesDim+zCell, i);
   }
 
-  for (unsigned int i=0; i<map.size(); i++)
+  // the points of a cell are contiguous and in their order in the cloud
+  std::sort(cells.begin(), cells.end());
+
+  std::vector<int> cellStarts;
+  for (int i=0; i<pc.rows; i++)
   {
-    numPoints += (map[i].size()>0);
+    if (i==0 || cells[i].first!=cells[i-1].first)
+      cellStarts.push_back(i);
   }
+  const int numPoints = (int)cellStarts.size();
+  cellStarts.push_back(pc.rows);
 
   Mat pcSampled = Mat(numPoints, pc.cols, CV_32F);
-  int c = 0;
 
-  for (unsigned int i=0; i<map.size(); i++)
+#if defined _OPENMP
+#pragma omp parallel for
+#endif
+  for (int c=0; c<numPoints; c++)
   {
     double px=0, py=0, pz=0;
     double nx=0, ny=0, nz=0;
 
-    std::vector<int> curCell = map[i];
-    int cn = (int)curCell.size();
-    if (cn>0)
+    const int cellStart = cellStarts[c];
+    const int cn = cellStarts[c+1] - cellStart;
+    const int64 index = cells[cellStart].first;
+
+    if (weightByCenter)
     {
-      if (weightByCenter)
-      {
-        int xCell, yCell, zCell;
-        double xc, yc, zc;
-        double weightSum = 0 ;
-        zCell = i % numSamplesDim;
-        yCell = ((i-zCell)/numSamplesDim) % numSamplesDim;
-        xCell = ((i-zCell-yCell*numSamplesDim)/(numSamplesDim*numSamplesDim));
-
-        xc = ((double)xCell+0.5) * (double)xr/numSamplesDim + (double)xrange[0];
-        yc = ((double)yCell+0.5) * (double)yr/numSamplesDim + (double)yrange[0];
-        zc = ((double)zCell+0.5) * (double)zr/numSamplesDim + (double)zrange[0];
-
-        for (int j=0; j<cn; j++)
-        {
-          const int ptInd = curCell[j];
-          float* point = (float*)(&pc.data[ptInd * pc.step]);
-          const double dx = point[0]-xc;
-          const double dy = point[1]-yc;
-          const double dz = point[2]-zc;
-          const double d = sqrt(dx*dx+dy*dy+dz*dz);
-          double w = 0;
-
-          if (d>EPS)
-          {
-            // it is possible to use different weighting schemes.
-            // inverse weigthing was just good for me
-            // exp( - (distance/h)**2 )
-            //const double w = exp(-d*d);
-            w = 1.0/d;
-          }
-
-          //float weights[3]={1,1,1};
-          px += w*(double)point[0];
-          py += w*(double)point[1];
-          pz += w*(double)point[2];
-          nx += w*(double)point[3];
-          ny += w*(double)point[4];
-          nz += w*(double)point[5];
-
-          weightSum+=w;
-        }
-        px/=(double)weightSum;
-        py/=(double)weightSum;
-        pz/=(double)weightSum;
-        nx/=(double)weightSum;
-        ny/=(double)weightSum;
-        nz/=(double)weightSum;
-      }
-      else
+      int64 xCell, yCell, zCell;
+      double xc, yc, zc;
+      double weightSum = 0 ;
+      zCell = index % numSamplesDim;
+      yCell = ((index-zCell)/numSamplesDim) % numSamplesDim;
+      xCell = ((index-zCell-yCell*numSamplesDim)/numSamplesDim2);
+
+      xc = ((double)xCell+0.5) * (double)xr/numSamplesDim + (double)xrange[0];
+      yc = ((double)yCell+0.5) * (double)yr/numSamplesDim + (double)yrange[0];
+      zc = ((double)zCell+0.5) * (double)zr/numSamplesDim + (double)zrange[0];
+
+      for (int j=0; j<cn; j++)
       {
-        for (int j=0; j<cn; j++)
+        const int ptInd = cells[cellStart+j].second;
+        float* point = (float*)(&pc.data[ptInd * pc.step]);
+        const double dx = point[0]-xc;
+        const double dy = point[1]-yc;
+        const double dz = point[2]-zc;
+        const double d = sqrt(dx*dx+dy*dy+dz*dz);
+        double w = 0;
+
+        if (d>EPS)
         {
-          const int ptInd = curCell[j];
-          float* point = (float*)(&pc.data[ptInd * pc.step]);
-
-          px += (double)point[0];
-          py += (double)point[1];
-          pz += (double)point[2];
-          nx += (double)point[3];
-          ny += (double)point[4];
-          nz += (double)point[5];
+          // it is possible to use different weighting schemes.
+          // inverse weigthing was just good for me
+          // exp( - (distance/h)**2 )
+          //const double w = exp(-d*d);
+          w = 1.0/d;
         }
 
-        px/=(double)cn;
-        py/=(double)cn;
-        pz/=(double)cn;
-        nx/=(double)cn;
-        ny/=(double)cn;
-        nz/=(double)cn;
+        //float weights[3]={1,1,1};
+        px += w*(double)point[0];
+        py += w*(double)point[1];
+        pz += w*(double)point[2];
+        nx += w*(double)point[3];
+        ny += w*(double)point[4];
+        nz += w*(double)point[5];
 
+        weightSum+=w;
       }
+      px/=(double)weightSum;
+      py/=(double)weightSum;
+      pz/=(double)weightSum;
+      nx/=(double)weightSum;
+      ny/=(double)weightSum;
+      nz/=(double)weightSum;
+    }
+    else
+    {
+      for (int j=0; j<cn; j++)
+      {
+        const int ptInd = cells[cellStart+j].second;
+        float* point = (float*)(&pc.data[ptInd * pc.step]);
+
+        px += (double)point[0];
+        py += (double)point[1];
+        pz += (double)point[2];
+        nx += (double)point[3];
+        ny += (double)point[4];
+        nz += (double)point[5];
+      }
+
+      px/=(double)cn;
+      py/=(double)cn;
+      pz/=(double)cn;
+      nx/=(double)cn;
+      ny/=(double)cn;
+      nz/=(double)cn;
 
-      float *pcData = (float*)(&pcSampled.data[c*pcSampled.step[0]]);
-      pcData[0]=(float)px;
-      pcData[1]=(float)py;
-      pcData[2]=(float)pz;
+    }
 
-      // normalize the normals
-      double norm = sqrt(nx*nx+ny*ny+nz*nz);
+    float *pcData = (float*)(&pcSampled.data[c*pcSampled.step[0]]);
+    pcData[0]=(float)px;
+    pcData[1]=(float)py;
+    pcData[2]=(float)pz;
 
-      if (norm>EPS)
-      {
-        pcData[3]=(float)(nx/norm);
-        pcData[4]=(float)(ny/norm);
-        pcData[5]=(float)(nz/norm);
-      }
-      //#pragma omp atomic
-      c++;
+    // normalize the normals
+    double norm = sqrt(nx*nx+ny*ny+nz*nz);
 
-      curCell.clear();
+    if (norm>EPS)
+    {
+      pcData[3]=(float)(nx/norm);
+      pcData[4]=(float)(ny/norm);
+      pcData[5]=(float)(nz/norm);
     }
   }
 
-  map.clear();
   return pcSampled;
 }
 
@@ -759,6 +999,11 @@ CV_EXPORTS int computeNormalsPC3d(const Mat& PC, Mat& PCNormals, const int NumNe
 
   PCNormals = Mat(PC.rows, 6, CV_32F);
 
+  // the points are independent, the normal is the eigenvector of the smallest eigenvalue of
+  // the covariance of the neighbours, solved in closed form
+#if defined _OPENMP
+#pragma omp parallel for
+#endif
   for (i=0; i<PC.rows; i++)
   {
     double C[3][3], mu[4];
@@ -771,26 +1016,7 @@ CV_EXPORTS int computeNormalsPC3d(const Mat& PC, Mat& PCNormals, const int NumNe
     // compute covariance matrix
     meanCovLocalPCInd(dataset, indLocal, 3, NumNeighbors, C, mu);
 
-    // eigenvectors of covariance matrix
-    Mat cov(3, 3, CV_64F), eigVect, eigVal;
-    double* covData = (double*)cov.data;
-    covData[0] = C[0][0];
-    covData[1] = C[0][1];
-    covData[2] = C[0][2];
-    covData[3] = C[1][0];
-    covData[4] = C[1][1];
-    covData[5] = C[1][2];
-    covData[6] = C[2][0];
-    covData[7] = C[2][1];
-    covData[8] = C[2][2];
-    eigen(cov, eigVal, eigVect);
-    Mat lowestEigVec;
-    //the eigenvector for the lowest eigenvalue is in the last row
-    eigVect.row(eigVect.rows - 1).copyTo(lowestEigVec);
-    double* eigData = (double*)lowestEigVec.data;
-    nr[0] = eigData[0];
-    nr[1] = eigData[1];
-    nr[2] = eigData[2];
+    eigenVectorMinSym33(C, nr);
 
     pcr[0] = pci[0];
     pcr[1] = pci[1];
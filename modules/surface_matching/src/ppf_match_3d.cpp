@@ -128,6 +128,8 @@ PPF3DDetector::PPF3DDetector()
   angle_step_radians = (360.0/angle_step_relative)*M_PI/180.0;
   angle_step = angle_step_radians;
   trained = false;
+  hash_table = 0;
+  hash_nodes = 0;
 
   setSearchParams();
 }
@@ -141,6 +143,8 @@ PPF3DDetector::PPF3DDetector(const double RelativeSamplingStep, const double Rel
   //SceneSampleStep = 1.0/RelativeSceneSampleStep;
   angle_step = angle_step_radians;
   trained = false;
+  hash_table = 0;
+  hash_nodes = 0;
 
   setSearchParams();
 }
@@ -217,7 +221,7 @@ void PPF3DDetector::clearTrainingModels()
 
   if (this->hash_table)
   {
-    hashtableDestroy(this->hash_table);
+    hashtableFlatDestroy(this->hash_table);
     this->hash_table=0;
   }
 }
@@ -246,10 +250,6 @@ void PPF3DDetector::trainModel(const Mat &PC)
 
   Mat sampled = samplePCByQuantization(PC, xRange, yRange, zRange, (float)sampling_step_relative,0);
 
-  int size = sampled.rows*sampled.rows;
-
-  hashtable_int* hashTable = hashtableCreate(size, NULL);
-
   int numPPF = sampled.rows*sampled.rows;
   ppf = Mat(numPPF, PPF_LENGTH, CV_32FC1);
   int ppfStep = (int)ppf.step;
@@ -261,11 +261,11 @@ void PPF3DDetector::trainModel(const Mat &PC)
   // pre-allocate the hash nodes
   hash_nodes = (THash*)calloc(numRefPoints*numRefPoints, sizeof(THash));
 
-  // TODO : This can easily be parallelized. But we have to lock hashtable_insert.
-  // I realized that performance drops when this loop is parallelized (unordered
-  // inserts into the hashtable
-  // But it is still there to be investigated. For now, I leave this unparallelized
-  // since this is just a training part.
+  // The features are computed in parallel, each reference point filling its own row of
+  // hash_nodes and ppf. The static hashtable is then built at once from all the nodes.
+#if defined _OPENMP
+#pragma omp parallel for
+#endif
   for (int i=0; i<numRefPoints; i++)
   {
     float* f1 = (float*)(&sampled.data[i * sampledStep]);
@@ -294,8 +294,6 @@ void PPF3DDetector::trainModel(const Mat &PC)
         hashNode->i = i;
         hashNode->ppfInd = ppfInd;
 
-        hashtableInsertHashed(hashTable, hashValue, (void*)hashNode);
-
         float* ppfRow = (float*)(&(ppf.data[ ppfInd ]));
         ppfRow[0] = (float)f[0];
         ppfRow[1] = (float)f[1];
@@ -306,6 +304,27 @@ void PPF3DDetector::trainModel(const Mat &PC)
     }
   }
 
+  std::vector<KeyType> keys;
+  std::vector<unsigned int> nodeIndices;
+  keys.reserve(numRefPoints*(numRefPoints-1));
+  nodeIndices.reserve(numRefPoints*(numRefPoints-1));
+  for (int i=0; i<numRefPoints; i++)
+  {
+    for (int j=0; j<numRefPoints; j++)
+    {
+      if (i!=j)
+      {
+        keys.push_back((KeyType)hash_nodes[i*numRefPoints+j].id);
+        nodeIndices.push_back(i*numRefPoints+j);
+      }
+    }
+  }
+
+  hashtable_flat* hashTable = hashtableFlatCreate(keys.empty() ? NULL : &keys[0],
+                                                  nodeIndices.empty() ? NULL : &nodeIndices[0],
+                                                  keys.size());
+  CV_Assert(hashTable);
+
   angle_step = angle_step_radians;
   distance_step = distanceStep;
   hash_table = hashTable;
@@ -331,6 +350,89 @@ bool PPF3DDetector::matchPose(const Pose3D& sourcePose, const Pose3D& targetPose
   return (phi<this->rotation_threshold && dNorm < this->position_threshold);
 }
 
+// Buckets of the pose clusters by the cell of their center in the space of the translation and of the
+// rotation angle. The cells are of the size of the thresholds of matchPose, so the centers matching a
+// pose are in the 3x3x3x3 cells around the cell of the pose.
+class PoseClusterHash
+{
+public:
+  enum { NUM_NEIGHBOURS = 81 };
+
+  PoseClusterHash(double positionStep, double angleStep, int maxClusters)
+    // slightly larger cells, so that the rounding never puts two matching poses two cells apart
+    : invPositionStep(1.0/(positionStep*1.001)), invAngleStep(1.0/(angleStep*1.001))
+  {
+    size_t numBuckets = 64;
+    while (numBuckets < (size_t)maxClusters)
+      numBuckets *= 2;
+    buckets.resize(numBuckets);
+  }
+
+  void insert(const Pose3D& center, int clusterIndex)
+  {
+    int c[4];
+    cell(center, c);
+    buckets[bucket(c[0], c[1], c[2], c[3])].push_back(clusterIndex);
+  }
+
+  // the buckets of the cells around the one of the pose, two of them may be the same
+  void neighbourBuckets(const Pose3D& pose, const std::vector<int>* neighbours[NUM_NEIGHBOURS]) const
+  {
+    int c[4], n = 0;
+    cell(pose, c);
+    for (int dx=-1; dx<=1; dx++)
+      for (int dy=-1; dy<=1; dy++)
+        for (int dz=-1; dz<=1; dz++)
+          for (int da=-1; da<=1; da++)
+            neighbours[n++] = &buckets[bucket(c[0]+dx, c[1]+dy, c[2]+dz, c[3]+da)];
+  }
+
+private:
+  void cell(const Pose3D& pose, int c[4]) const
+  {
+    c[0] = cvFloor(pose.t[0]*invPositionStep);
+    c[1] = cvFloor(pose.t[1]*invPositionStep);
+    c[2] = cvFloor(pose.t[2]*invPositionStep);
+    c[3] = cvFloor(pose.angle*invAngleStep);
+  }
+
+  size_t bucket(int x, int y, int z, int a) const
+  {
+    unsigned int h = (unsigned int)x*73856093u ^ (unsigned int)y*19349663u ^ (unsigned int)z*83492791u ^ (unsigned int)a*2654435761u;
+    return h & (buckets.size()-1);
+  }
+
+  double invPositionStep, invAngleStep;
+  std::vector<std::vector<int> > buckets;
+};
+
+// the first cluster of index in [minIndex, maxIndex) whose center matches the pose, or -1
+int PPF3DDetector::findPoseCluster(const Pose3D& pose, const std::vector<PoseCluster3DPtr>& poseClusters,
+                                   const PoseClusterHash& clusterHash, int minIndex, int maxIndex)
+{
+  const std::vector<int>* neighbours[PoseClusterHash::NUM_NEIGHBOURS];
+  clusterHash.neighbourBuckets(pose, neighbours);
+
+  int match = -1;
+  for (int n=0; n<PoseClusterHash::NUM_NEIGHBOURS; n++)
+  {
+    // the clusters of a bucket are in creation order
+    const std::vector<int>& bucket = *neighbours[n];
+    for (size_t k=0; k<bucket.size(); k++)
+    {
+      const int j = bucket[k];
+      if (j>=maxIndex || (match>=0 && j>=match))
+        break;
+      if (j>=minIndex && matchPose(pose, *poseClusters[j]->poseList[0]))
+      {
+        match = j;
+        break;
+      }
+    }
+  }
+  return match;
+}
+
 void PPF3DDetector::clusterPoses(std::vector<Pose3DPtr> poseList, int numPoses, std::vector<Pose3DPtr> &finalPoses)
 {
   std::vector<PoseCluster3DPtr> poseClusters;
@@ -340,25 +442,47 @@ void PPF3DDetector::clusterPoses(std::vector<Pose3DPtr> poseList, int numPoses,
   // sort the poses for stability
   std::sort(poseList.begin(), poseList.end(), pose3DPtrCompare);
 
-  for (int i=0; i<numPoses; i++)
+  // Each pose joins the first cluster whose center matches it. The poses are processed by
+  // blocks: the clusters existing before a block are searched in parallel for all the poses
+  // of the block, then the block is assigned serially, only searching the clusters created in
+  // the block itself. The result is the same as the serial assignment, since the centers of
+  // the clusters never change. The clusters are only searched in the cells of the hash around
+  // the pose, no pose matches when a threshold is not positive.
+  const int blockSize = 256;
+  std::vector<int> firstMatch(blockSize);
+  const bool canMatch = position_threshold>0 && rotation_threshold>0;
+  PoseClusterHash clusterHash(canMatch ? position_threshold : 1.0, canMatch ? rotation_threshold : 1.0, canMatch ? numPoses : 0);
+
+  for (int blockStart=0; blockStart<numPoses; blockStart+=blockSize)
   {
-    Pose3DPtr pose = poseList[i];
-    bool assigned = false;
+    const int blockEnd = std::min(numPoses, blockStart+blockSize);
+    const int numOldClusters = (int)poseClusters.size();
 
-    // search all clusters
-    for (size_t j=0; j<poseClusters.size() && !assigned; j++)
+#if defined _OPENMP
+#pragma omp parallel for
+#endif
+    for (int i=blockStart; i<blockEnd; i++)
     {
-      const Pose3DPtr poseCenter = poseClusters[j]->poseList[0];
-      if (matchPose(*pose, *poseCenter))
-      {
-        poseClusters[j]->addPose(pose);
-        assigned = true;
-      }
+      firstMatch[i-blockStart] = canMatch ? findPoseCluster(*poseList[i], poseClusters, clusterHash, 0, numOldClusters) : -1;
     }
 
-    if (!assigned)
+    for (int i=blockStart; i<blockEnd; i++)
     {
-      poseClusters.push_back(PoseCluster3DPtr(new PoseCluster3D(pose)));
+      const Pose3DPtr& pose = poseList[i];
+      int match = firstMatch[i-blockStart];
+
+      // search the clusters created in this block
+      if (match<0 && canMatch)
+        match = findPoseCluster(*pose, poseClusters, clusterHash, numOldClusters, (int)poseClusters.size());
+
+      if (match>=0)
+        poseClusters[match]->addPose(pose);
+      else
+      {
+        if (canMatch)
+          clusterHash.insert(*pose, (int)poseClusters.size());
+        poseClusters.push_back(PoseCluster3DPtr(new PoseCluster3D(pose)));
+      }
     }
   }
 
@@ -382,7 +506,7 @@ void PPF3DDetector::clusterPoses(std::vector<Pose3DPtr> poseList, int numPoses,
 
       // Perform the final averaging
       PoseCluster3DPtr curCluster = poseClusters[i];
-      std::vector<Pose3DPtr> curPoses = curCluster->poseList;
+      const std::vector<Pose3DPtr>& curPoses = curCluster->poseList;
       int curSize = (int)curPoses.size();
       int numTotalVotes = 0;
 
@@ -433,7 +557,7 @@ void PPF3DDetector::clusterPoses(std::vector<Pose3DPtr> poseList, int numPoses,
 
       // Perform the final averaging
       PoseCluster3DPtr curCluster = poseClusters[i];
-      std::vector<Pose3DPtr> curPoses = curCluster->poseList;
+      const std::vector<Pose3DPtr>& curPoses = curCluster->poseList;
       const int curSize = (int)curPoses.size();
 
       for (int j=0; j<curSize; j++)
@@ -503,164 +627,169 @@ void PPF3DDetector::match(const Mat& pc, std::vector<Pose3DPtr>& results, const
      unsigned int* accumulator = (unsigned int*)calloc(numAngles*n, sizeof(unsigned int));
   #endif*/
 
-  poseList.reserve((sampled.rows/sceneSamplingStep)+4);
+  // the poses are stored in the order of the reference points, whatever the thread computing them
+  const int numPosesAdded = (sampled.rows + sceneSamplingStep - 1) / sceneSamplingStep;
+  poseList.resize(numPosesAdded);
 
 #if defined _OPENMP
-#pragma omp parallel for
+#pragma omp parallel
 #endif
-  for (int i = 0; i < sampled.rows; i += sceneSamplingStep)
   {
-    unsigned int refIndMax = 0, alphaIndMax = 0;
-    unsigned int maxVotes = 0;
+    // one accumulator per thread, cleared while its maximum is searched
+    unsigned int* accumulator = (unsigned int*)calloc(numAngles*n, sizeof(unsigned int));
 
-    float* f1 = (float*)(&sampled.data[i * sampled.step]);
-    const double p1[4] = {f1[0], f1[1], f1[2], 0};
-    const double n1[4] = {f1[3], f1[4], f1[5], 0};
-    double *row2, *row3, tsg[3]={0}, Rsg[9]={0}, RInv[9]={0};
+#if defined _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (int r = 0; r < numPosesAdded; r++)
+    {
+      const int i = r * sceneSamplingStep;
+      unsigned int refIndMax = 0, alphaIndMax = 0;
+      unsigned int maxVotes = 0;
 
-    unsigned int* accumulator = (unsigned int*)calloc(numAngles*n, sizeof(unsigned int));
-    computeTransformRT(p1, n1, Rsg, tsg);
-    row2=&Rsg[3];
-    row3=&Rsg[6];
+      float* f1 = (float*)(&sampled.data[i * sampled.step]);
+      const double p1[4] = {f1[0], f1[1], f1[2], 0};
+      const double n1[4] = {f1[3], f1[4], f1[5], 0};
+      double *row2, *row3, tsg[3]={0}, Rsg[9]={0}, RInv[9]={0};
 
-    // Tolga Birdal's notice:
-    // As a later update, we might want to look into a local neighborhood only
-    // To do this, simply search the local neighborhood by radius look up
-    // and collect the neighbors to compute the relative pose
+      computeTransformRT(p1, n1, Rsg, tsg);
+      row2=&Rsg[3];
+      row3=&Rsg[6];
 
-    for (int j = 0; j < sampled.rows; j ++)
-    {
-      if (i!=j)
+      // Tolga Birdal's notice:
+      // As a later update, we might want to look into a local neighborhood only
+      // To do this, simply search the local neighborhood by radius look up
+      // and collect the neighbors to compute the relative pose
+
+      for (int j = 0; j < sampled.rows; j ++)
       {
-        float* f2 = (float*)(&sampled.data[j * sampled.step]);
-        const double p2[4] = {f2[0], f2[1], f2[2], 0};
-        const double n2[4] = {f2[3], f2[4], f2[5], 0};
-        double p2t[4], alpha_scene;
+        if (i!=j)
+        {
+          float* f2 = (float*)(&sampled.data[j * sampled.step]);
+          const double p2[4] = {f2[0], f2[1], f2[2], 0};
+          const double n2[4] = {f2[3], f2[4], f2[5], 0};
+          double p2t[4], alpha_scene;
 
-        double f[4]={0};
-        computePPFFeatures(p1, n1, p2, n2, f);
-        KeyType hashValue = hashPPF(f, angle_step, distanceStep);
+          double f[4]={0};
+          computePPFFeatures(p1, n1, p2, n2, f);
+          KeyType hashValue = hashPPF(f, angle_step, distanceStep);
 
-        // we don't need to call this here, as we already estimate the tsg from scene reference point
-        // double alpha = computeAlpha(p1, n1, p2);
-        p2t[1] = tsg[1] + row2[0] * p2[0] + row2[1] * p2[1] + row2[2] * p2[2];
-        p2t[2] = tsg[2] + row3[0] * p2[0] + row3[1] * p2[1] + row3[2] * p2[2];
+          // we don't need to call this here, as we already estimate the tsg from scene reference point
+          // double alpha = computeAlpha(p1, n1, p2);
+          p2t[1] = tsg[1] + row2[0] * p2[0] + row2[1] * p2[1] + row2[2] * p2[2];
+          p2t[2] = tsg[2] + row3[0] * p2[0] + row3[1] * p2[1] + row3[2] * p2[2];
 
-        alpha_scene=atan2(-p2t[2], p2t[1]);
+          alpha_scene=atan2(-p2t[2], p2t[1]);
 
-        if ( alpha_scene != alpha_scene)
-        {
-          continue;
-        }
+          if ( alpha_scene != alpha_scene)
+          {
+            continue;
+          }
+
+          if (sin(alpha_scene)*p2t[2]<0.0)
+            alpha_scene=-alpha_scene;
 
-        if (sin(alpha_scene)*p2t[2]<0.0)
           alpha_scene=-alpha_scene;
 
-        alpha_scene=-alpha_scene;
+          size_t numNodes = 0;
+          const unsigned int* nodes = hashtableFlatGet(hash_table, hashValue, &numNodes);
 
-        hashnode_i* node = hashtableGetBucketHashed(hash_table, (hashValue));
+          for (size_t k = 0; k < numNodes; k++)
+          {
+            const THash* tData = &hash_nodes[nodes[k]];
+            int corrI = (int)tData->i;
+            int ppfInd = (int)tData->ppfInd;
+            float* ppfCorrScene = (float*)(&ppf.data[ppfInd]);
+            double alpha_model = (double)ppfCorrScene[PPF_LENGTH-1];
+            double alpha = alpha_model - alpha_scene;
 
-        while (node)
-        {
-          THash* tData = (THash*) node->data;
-          int corrI = (int)tData->i;
-          int ppfInd = (int)tData->ppfInd;
-          float* ppfCorrScene = (float*)(&ppf.data[ppfInd]);
-          double alpha_model = (double)ppfCorrScene[PPF_LENGTH-1];
-          double alpha = alpha_model - alpha_scene;
-
-          /*  Tolga Birdal's note: Map alpha to the indices:
-                  atan2 generates results in (-pi pi]
-                  That's why alpha should be in range [-2pi 2pi]
-                  So the quantization would be :
-                  numAngles * (alpha+2pi)/(4pi)
-                  */
-
-          //printf("%f\n", alpha);
-          int alpha_index = (int)(numAngles*(alpha + 2*M_PI) / (4*M_PI));
-
-          unsigned int accIndex = corrI * numAngles + alpha_index;
-
-          accumulator[accIndex]++;
-          node = node->next;
+            /*  Tolga Birdal's note: Map alpha to the indices:
+                    atan2 generates results in (-pi pi]
+                    That's why alpha should be in range [-2pi 2pi]
+                    So the quantization would be :
+                    numAngles * (alpha+2pi)/(4pi)
+                    */
+
+            //printf("%f\n", alpha);
+            int alpha_index = (int)(numAngles*(alpha + 2*M_PI) / (4*M_PI));
+
+            unsigned int accIndex = corrI * numAngles + alpha_index;
+
+            accumulator[accIndex]++;
+          }
         }
       }
-    }
 
-    // Maximize the accumulator
-    for (unsigned int k = 0; k < n; k++)
-    {
-      for (int j = 0; j < numAngles; j++)
+      // Maximize the accumulator
+      for (unsigned int k = 0; k < n; k++)
       {
-        const unsigned int accInd = k*numAngles + j;
-        const unsigned int accVal = accumulator[ accInd ];
-        if (accVal > maxVotes)
+        for (int j = 0; j < numAngles; j++)
         {
-          maxVotes = accVal;
-          refIndMax = k;
-          alphaIndMax = j;
+          const unsigned int accInd = k*numAngles + j;
+          const unsigned int accVal = accumulator[ accInd ];
+          if (accVal > maxVotes)
+          {
+            maxVotes = accVal;
+            refIndMax = k;
+            alphaIndMax = j;
+          }
+
+          accumulator[accInd ] = 0;
         }
-
-#if !defined (_OPENMP)
-        accumulator[accInd ] = 0;
-#endif
       }
+
+      // invert Tsg : Luckily rotation is orthogonal: Inverse = Transpose.
+      // We are not required to invert.
+      double tInv[3], tmg[3], Rmg[9];
+      matrixTranspose33(Rsg, RInv);
+      matrixProduct331(RInv, tsg, tInv);
+
+      double TsgInv[16] = { RInv[0], RInv[1], RInv[2], -tInv[0],
+                            RInv[3], RInv[4], RInv[5], -tInv[1],
+                            RInv[6], RInv[7], RInv[8], -tInv[2],
+                            0, 0, 0, 1
+                          };
+
+      // TODO : Compute pose
+      const float* fMax = (float*)(&sampled_pc.data[refIndMax * sampled_pc.step]);
+      const double pMax[4] = {fMax[0], fMax[1], fMax[2], 1};
+      const double nMax[4] = {fMax[3], fMax[4], fMax[5], 1};
+
+      computeTransformRT(pMax, nMax, Rmg, tmg);
+      row2=&Rsg[3];
+      row3=&Rsg[6];
+
+      double Tmg[16] = { Rmg[0], Rmg[1], Rmg[2], tmg[0],
+                         Rmg[3], Rmg[4], Rmg[5], tmg[1],
+                         Rmg[6], Rmg[7], Rmg[8], tmg[2],
+                         0, 0, 0, 1
+                       };
+
+      // convert alpha_index to alpha
+      int alpha_index = alphaIndMax;
+      double alpha = (alpha_index*(4*M_PI))/numAngles-2*M_PI;
+
+      // Equation 2:
+      double Talpha[16]={0};
+      getUnitXRotation_44(alpha, Talpha);
+
+      double Temp[16]={0};
+      double rawPose[16]={0};
+      matrixProduct44(Talpha, Tmg, Temp);
+      matrixProduct44(TsgInv, Temp, rawPose);
+
+      Pose3DPtr pose(new Pose3D(alpha, refIndMax, maxVotes));
+      pose->updatePose(rawPose);
+      poseList[r] = pose;
+
     }
 
-    // invert Tsg : Luckily rotation is orthogonal: Inverse = Transpose.
-    // We are not required to invert.
-    double tInv[3], tmg[3], Rmg[9];
-    matrixTranspose33(Rsg, RInv);
-    matrixProduct331(RInv, tsg, tInv);
-
-    double TsgInv[16] = { RInv[0], RInv[1], RInv[2], -tInv[0],
-                          RInv[3], RInv[4], RInv[5], -tInv[1],
-                          RInv[6], RInv[7], RInv[8], -tInv[2],
-                          0, 0, 0, 1
-                        };
-
-    // TODO : Compute pose
-    const float* fMax = (float*)(&sampled_pc.data[refIndMax * sampled_pc.step]);
-    const double pMax[4] = {fMax[0], fMax[1], fMax[2], 1};
-    const double nMax[4] = {fMax[3], fMax[4], fMax[5], 1};
-
-    computeTransformRT(pMax, nMax, Rmg, tmg);
-    row2=&Rsg[3];
-    row3=&Rsg[6];
-
-    double Tmg[16] = { Rmg[0], Rmg[1], Rmg[2], tmg[0],
-                       Rmg[3], Rmg[4], Rmg[5], tmg[1],
-                       Rmg[6], Rmg[7], Rmg[8], tmg[2],
-                       0, 0, 0, 1
-                     };
-
-    // convert alpha_index to alpha
-    int alpha_index = alphaIndMax;
-    double alpha = (alpha_index*(4*M_PI))/numAngles-2*M_PI;
-
-    // Equation 2:
-    double Talpha[16]={0};
-    getUnitXRotation_44(alpha, Talpha);
-
-    double Temp[16]={0};
-    double rawPose[16]={0};
-    matrixProduct44(Talpha, Tmg, Temp);
-    matrixProduct44(TsgInv, Temp, rawPose);
-
-    Pose3DPtr pose(new Pose3D(alpha, refIndMax, maxVotes));
-    pose->updatePose(rawPose);
-    poseList.push_back(pose);
-
-#if defined (_OPENMP)
     free(accumulator);
-#endif
   }
 
   // TODO : Make the parameters relative if not arguments.
   //double MinMatchScore = 0.5;
 
-  int numPosesAdded = sampled.rows/sceneSamplingStep;
-
   clusterPoses(poseList, numPosesAdded, results);
 }
 
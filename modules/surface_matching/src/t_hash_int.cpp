@@ -367,6 +367,165 @@ hashtable_int *hashtableRead(FILE* f)
     return hashtbl;
 }
 
+
+///////////////////////// STATIC HASHTABLE ////////////////////////////////
+
+#define T_HASH_FLAT_MAGIC 427462443
+#define T_HASH_FLAT_HEADER 4
+
+static bool flatEntryCompare(const std::pair<KeyType, unsigned int>& a, const std::pair<KeyType, unsigned int>& b)
+{
+    return a.first < b.first || (a.first == b.first && a.second < b.second);
+}
+
+hashtable_flat *hashtableFlatCreate(const KeyType* keys, const unsigned int* values, size_t numEntries)
+{
+    // sort the entries by key, keeping the insertion order of the values of each key
+    std::vector< std::pair<KeyType, unsigned int> > entries(numEntries);
+    for (size_t i=0; i<numEntries; i++)
+        entries[i] = std::make_pair(keys[i], (unsigned int)i);
+    std::sort(entries.begin(), entries.end(), flatEntryCompare);
+    
+    std::vector<size_t> keyStarts;
+    for (size_t i=0; i<numEntries; i++)
+    {
+        if (i==0 || entries[i].first!=entries[i-1].first)
+            keyStarts.push_back(i);
+    }
+    const size_t numKeys = keyStarts.size();
+    keyStarts.push_back(numEntries);
+    
+    size_t size = numKeys < 16 ? 16 : (size_t)next_power_of_two((unsigned int)numKeys);
+    size_t blockWords = T_HASH_FLAT_HEADER + (size+1) + numKeys + (numKeys+1) + numEntries;
+    unsigned int* block = (unsigned int*)malloc(blockWords*sizeof(unsigned int));
+    if (!block)
+        return NULL;
+        
+    block[0] = T_HASH_FLAT_MAGIC;
+    block[1] = (unsigned int)size;
+    block[2] = (unsigned int)numKeys;
+    block[3] = (unsigned int)numEntries;
+    unsigned int* bucketOffsets = block + T_HASH_FLAT_HEADER;
+    KeyType* flatKeys = bucketOffsets + size + 1;
+    unsigned int* valueOffsets = flatKeys + numKeys;
+    unsigned int* flatValues = valueOffsets + numKeys + 1;
+    
+    // counting sort of the distinct keys by bucket
+    memset(bucketOffsets, 0, (size+1)*sizeof(unsigned int));
+    for (size_t k=0; k<numKeys; k++)
+        bucketOffsets[(entries[keyStarts[k]].first & (size-1)) + 1]++;
+    for (size_t b=0; b<size; b++)
+        bucketOffsets[b+1] += bucketOffsets[b];
+        
+    std::vector<unsigned int> keyPos(bucketOffsets, bucketOffsets + size);
+    std::vector<size_t> keyOrder(numKeys);
+    for (size_t k=0; k<numKeys; k++)
+        keyOrder[keyPos[entries[keyStarts[k]].first & (size-1)]++] = k;
+        
+    unsigned int nValues = 0;
+    for (size_t k=0; k<numKeys; k++)
+    {
+        const size_t sortedKey = keyOrder[k];
+        flatKeys[k] = entries[keyStarts[sortedKey]].first;
+        valueOffsets[k] = nValues;
+        for (size_t i=keyStarts[sortedKey]; i<keyStarts[sortedKey+1]; i++)
+            flatValues[nValues++] = values[entries[i].second];
+    }
+    valueOffsets[numKeys] = nValues;
+    
+    hashtable_flat* hashtbl = hashtableFlatAttach(block, blockWords*sizeof(unsigned int));
+    if (!hashtbl)
+    {
+        free(block);
+        return NULL;
+    }
+    hashtbl->ownsBlock = true;
+    return hashtbl;
+}
+
+hashtable_flat *hashtableFlatAttach(const void* block, size_t blockSize)
+{
+    const unsigned int* words = (const unsigned int*)block;
+    if (blockSize < T_HASH_FLAT_HEADER*sizeof(unsigned int) || words[0]!=T_HASH_FLAT_MAGIC)
+        return NULL;
+        
+    const size_t size = words[1], numKeys = words[2], numValues = words[3];
+    const size_t blockWords = T_HASH_FLAT_HEADER + (size+1) + numKeys + (numKeys+1) + numValues;
+    if (blockSize < blockWords*sizeof(unsigned int))
+        return NULL;
+        
+    hashtable_flat* hashtbl = (hashtable_flat*)malloc(sizeof(hashtable_flat));
+    if (!hashtbl)
+        return NULL;
+        
+    hashtbl->size = size;
+    hashtbl->numKeys = numKeys;
+    hashtbl->numValues = numValues;
+    hashtbl->bucketOffsets = words + T_HASH_FLAT_HEADER;
+    hashtbl->keys = hashtbl->bucketOffsets + size + 1;
+    hashtbl->valueOffsets = hashtbl->keys + numKeys;
+    hashtbl->values = hashtbl->valueOffsets + numKeys + 1;
+    hashtbl->block = words;
+    hashtbl->blockSize = blockWords*sizeof(unsigned int);
+    hashtbl->ownsBlock = false;
+    return hashtbl;
+}
+
+void hashtableFlatDestroy(hashtable_flat *hashtbl)
+{
+    if (hashtbl->ownsBlock)
+        free((void*)hashtbl->block);
+    free(hashtbl);
+}
+
+const unsigned int* hashtableFlatGet(const hashtable_flat *hashtbl, KeyType key, size_t* count)
+{
+    const size_t bucket = key & (hashtbl->size-1);
+    
+    for (unsigned int k=hashtbl->bucketOffsets[bucket]; k<hashtbl->bucketOffsets[bucket+1]; k++)
+    {
+        if (hashtbl->keys[k]==key)
+        {
+            *count = hashtbl->valueOffsets[k+1] - hashtbl->valueOffsets[k];
+            return hashtbl->values + hashtbl->valueOffsets[k];
+        }
+    }
+    
+    *count = 0;
+    return NULL;
+}
+
+int hashtableFlatWrite(const hashtable_flat *hashtbl, FILE* f)
+{
+    return fwrite(hashtbl->block, hashtbl->blockSize, 1, f) == 1;
+}
+
+hashtable_flat *hashtableFlatRead(FILE* f)
+{
+    unsigned int header[T_HASH_FLAT_HEADER];
+    if (fread(header, sizeof(header), 1, f)!=1 || header[0]!=T_HASH_FLAT_MAGIC)
+        return NULL;
+        
+    const size_t blockWords = T_HASH_FLAT_HEADER + (header[1]+1) + header[2] + (header[2]+1) + header[3];
+    unsigned int* block = (unsigned int*)malloc(blockWords*sizeof(unsigned int));
+    if (!block)
+        return NULL;
+        
+    memcpy(block, header, sizeof(header));
+    const size_t dataWords = blockWords - T_HASH_FLAT_HEADER;
+    hashtable_flat* hashtbl = NULL;
+    if (fread(block + T_HASH_FLAT_HEADER, sizeof(unsigned int), dataWords, f)==dataWords)
+        hashtbl = hashtableFlatAttach(block, blockWords*sizeof(unsigned int));
+        
+    if (!hashtbl)
+    {
+        free(block);
+        return NULL;
+    }
+    hashtbl->ownsBlock = true;
+    return hashtbl;
+}
+
 } // namespace ppf_match_3d
 
 } // namespace cv
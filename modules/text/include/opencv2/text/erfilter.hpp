@@ -350,6 +350,27 @@ An example of MSERsToERStats in use can be found in the text detection webcam_de
 CV_EXPORTS void MSERsToERStats(InputArray image, std::vector<std::vector<Point> > &contours,
                                std::vector<std::vector<ERStat> > &regions);
 
+/** @brief Runs the 1st and the 2nd stage of the N&M algorithm [Neumann12] on several channels.
+
+@param channels Vector of single channel images CV_8UC1, e.g. the output of computeNMChannels and
+their inverted versions.
+
+@param er_filter1 Filter for the 1st stage, e.g. created with createERFilterNM1.
+
+@param er_filter2 Filter for the 2nd stage, e.g. created with createERFilterNM2. It can be empty.
+
+@param regions Output, the ER's of each channel, as expected by erGrouping.
+
+The channels are processed in parallel. The ERFilter objects created by createERFilterNM1 and
+createERFilterNM2 are copied for each channel, so that each one extracts its own component tree,
+while the classifier callbacks are shared by the copies: the callbacks must be thread-safe, as the
+default classifiers are. Other ERFilter implementations are run on the channels one after another.
+The result is the same as calling er_filter1->run and er_filter2->run on each channel.
+ */
+CV_EXPORTS void runERFilters(InputArrayOfArrays channels, const Ptr<ERFilter>& er_filter1,
+                             const Ptr<ERFilter>& er_filter2,
+                             std::vector<std::vector<ERStat> > &regions);
+
 // Utility funtion for scripting
 CV_EXPORTS_W void detectRegions(InputArray image, const Ptr<ERFilter>& er_filter1, const Ptr<ERFilter>& er_filter2, CV_OUT std::vector< std::vector<Point> >& regions);
 
@@ -139,6 +139,48 @@ public:
                                     const char* char_whitelist=NULL, int oem=3, int psmode=3);
 };
 
+/** @brief OCRTesseractPool class holds several tesseract-ocr engines to recognize text from several
+threads at once.
+
+A single OCRTesseract instance can not be used concurrently. The pool initializes a fixed number of
+engines with the same parameters when it is created, and each call to run() is dispatched to a free
+engine, waiting for one only when all of them are busy. The pool can be used wherever an OCRTesseract
+is expected.
+ */
+class CV_EXPORTS OCRTesseractPool : public OCRTesseract
+{
+public:
+    using OCRTesseract::run;
+
+    /** @brief Recognize text in several images (e.g. the cropped regions of a scene) using all the engines.
+
+    @param images Input images CV_8UC1 or CV_8UC3
+    @param output_texts Output text of the tesseract-ocr for each image.
+    @param component_rects If provided the method will output, for each image, the list of Rects of the
+    individual text elements found.
+    @param component_texts If provided the method will output, for each image, the list of text strings
+    of the individual text elements found.
+    @param component_confidences If provided the method will output, for each image, the list of
+    confidence values of the individual text elements found.
+    @param component_level OCR_LEVEL_WORD (by default), or OCR_LEVEL_TEXT_LINE.
+     */
+    virtual void run(const std::vector<Mat>& images, std::vector<std::string>& output_texts,
+                     std::vector< std::vector<Rect> >* component_rects=NULL,
+                     std::vector< std::vector<std::string> >* component_texts=NULL,
+                     std::vector< std::vector<float> >* component_confidences=NULL,
+                     int component_level=0) = 0;
+
+    /** @brief Creates a pool of tesseract-ocr engines.
+
+    @param num_engines the number of engines, i.e. the maximum number of concurrent recognitions.
+
+    The other parameters are the ones of OCRTesseract::create and are used for all the engines. Each
+    engine loads its own copy of the language data.
+     */
+    static Ptr<OCRTesseractPool> create(int num_engines, const char* datapath=NULL, const char* language=NULL,
+                                        const char* char_whitelist=NULL, int oem=3, int psmode=3);
+};
+
 
 /* OCR HMM Decoder */
 
@@ -180,6 +222,18 @@ public:
         corresponding to each classes in out_class.
          */
         virtual void eval( InputArray image, std::vector<int>& out_class, std::vector<double>& out_confidence);
+
+        /** @brief Classifies several letters at once, e.g. all the characters of a word.
+
+        @param images Input images CV_8UC1 or CV_8UC3, each one with a single letter.
+        @param out_classes For each image, the output of eval.
+        @param out_confidences For each image, the output of eval.
+
+        The default implementation calls eval for each image, classifiers that can share work between
+        the images (e.g. the one created by loadOCRHMMClassifierCNN) override it.
+         */
+        virtual void evalBatch( InputArrayOfArrays images, std::vector< std::vector<int> >& out_classes,
+                                std::vector< std::vector<double> >& out_confidences );
     };
 
 public:
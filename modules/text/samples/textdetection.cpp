@@ -49,14 +49,10 @@ int main(int argc, const char * argv[])
     Ptr<ERFilter> er_filter2 = createERFilterNM2(loadClassifierNM2("trained_classifierNM2.xml"),0.5);
 
     vector<vector<ERStat> > regions(channels.size());
-    // Apply the default cascade classifier to each independent channel (could be done in parallel)
+    // Apply the default cascade classifier to each independent channel, in parallel
     cout << "Extracting Class Specific Extremal Regions from " << (int)channels.size() << " channels ..." << endl;
     cout << "    (...) this may take a while (...)" << endl << endl;
-    for (int c=0; c<(int)channels.size(); c++)
-    {
-        er_filter1->run(channels[c], regions[c]);
-        er_filter2->run(channels[c], regions[c]);
-    }
+    runERFilters(channels, er_filter1, er_filter2, regions);
 
     // Detect character groups
     cout << "Grouping extracted ERs ... ";
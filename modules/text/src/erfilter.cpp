@@ -45,7 +45,8 @@
 #include "opencv2/ml.hpp"
 #include <limits>
 #include <fstream>
-#include <queue>
+#include <algorithm>
+#include <iterator>
 
 #if defined _MSC_VER && _MSC_VER == 1500
     typedef int int_fast32_t;
@@ -65,27 +66,6 @@ using namespace cv::ml;
 using namespace std;
 using namespace cv::ml;
 
-// Deletes a tree of ERStat regions starting at root. Used only
-// internally to this implementation.
-static void deleteERStatTree(ERStat* root) {
-    queue<ERStat*> to_delete;
-    to_delete.push(root);
-    while (!to_delete.empty()) {
-        ERStat* n = to_delete.front();
-        to_delete.pop();
-        ERStat* c = n->child;
-        if (c != NULL) {
-            to_delete.push(c);
-            ERStat* sibling = c->next;
-            while (sibling != NULL) {
-                to_delete.push(sibling);
-                sibling = sibling->next;
-            }
-        }
-        delete n;
-    }
-}
-
 ERStat::ERStat(int init_level, int init_pixel, int init_x, int init_y) : pixel(init_pixel),
                level(init_level), area(0), perimeter(0), euler(0), probability(1.0),
                parent(0), child(0), next(0), prev(0), local_maxima(0),
@@ -105,6 +85,72 @@ ERStat::ERStat(int init_level, int init_pixel, int init_x, int init_y) : pixel(i
 // derivative classes
 
 
+// Storage for the nodes of the component tree used internally by ERFilterNM. The nodes and their
+// crossings are recycled from one component to the next and from one image to the next, instead
+// of being allocated and freed for every component. The addresses of the nodes are stable.
+class ERStatPool
+{
+public:
+    ERStatPool() {}
+    // the nodes are never shared by the copies of a filter
+    ERStatPool(const ERStatPool&) {}
+    ERStatPool& operator=(const ERStatPool&) { return *this; }
+    ~ERStatPool()
+    {
+        for (size_t i = 0; i < nodes.size(); i++)
+            delete nodes[i].crossings;
+    }
+
+    // returns a node initialized as ERStat(level, pixel, x, y)
+    ERStat* get(int level, int pixel, int x, int y)
+    {
+        if (free_nodes.empty())
+        {
+            nodes.push_back(ERStat(level, pixel, x, y));
+            return &nodes.back();
+        }
+
+        ERStat* er = free_nodes.back();
+        free_nodes.pop_back();
+
+        er->pixel = pixel;
+        er->level = level;
+        er->area = 0;
+        er->perimeter = 0;
+        er->euler = 0;
+        er->rect = Rect(x,y,1,1);
+        er->raw_moments[0] = 0.0;
+        er->raw_moments[1] = 0.0;
+        er->central_moments[0] = 0.0;
+        er->central_moments[1] = 0.0;
+        er->central_moments[2] = 0.0;
+        er->crossings->clear();
+        er->crossings->push_back(0);
+        er->probability = 1.0;
+        er->parent = er->child = er->next = er->prev = NULL;
+        er->local_maxima = false;
+        er->max_probability_ancestor = er->min_probability_ancestor = NULL;
+        return er;
+    }
+
+    // gives back a single node, its children are not affected
+    void release(ERStat* er) { free_nodes.push_back(er); }
+
+    // gives back all the nodes at once
+    void releaseAll()
+    {
+        free_nodes.resize(nodes.size());
+        for (size_t i = 0; i < nodes.size(); i++)
+            free_nodes[i] = &nodes[i];
+    }
+
+private:
+    // the crossings of each node are owned by the pool, they are never NULL
+    deque<ERStat> nodes;
+    vector<ERStat*> free_nodes;
+};
+
+
 // the classe implementing the interface for the 1st and 2nd stages of Neumann and Matas algorithm
 class CV_EXPORTS ERFilterNM : public ERFilter
 {
@@ -150,6 +196,8 @@ private:
     vector<ERStat> *regions;
     // image mask used for feature calculations
     Mat region_mask;
+    // nodes of the component tree during the extraction
+    ERStatPool er_pool;
 
     // extract the component tree and store all the ER regions
     void er_tree_extract( InputArray image );
@@ -303,7 +351,7 @@ void ERFilterNM::er_tree_extract( InputArray image )
     vector<int> boundary_edges[256];
 
     // add a dummy-component before start
-    er_stack.push_back(new ERStat);
+    er_stack.push_back(er_pool.get(256, 0, 0, 0));
 
     // we'll look initially for all pixels with grey-level lower than a grey-level higher than any allowed in the image
     int threshold_level = (255/thresholdDelta)+1;
@@ -323,7 +371,7 @@ void ERFilterNM::er_tree_extract( InputArray image )
 
         // push a component with current level in the component stack
         if (push_new_component)
-            er_stack.push_back(new ERStat(current_level, current_pixel, x, y));
+            er_stack.push_back(er_pool.get(current_level, current_pixel, x, y));
         push_new_component = false;
 
         // explore the (remaining) edges to the neighbors to the current pixel
@@ -520,19 +568,9 @@ void ERFilterNM::er_tree_extract( InputArray image )
             regions->reserve(num_accepted_regions+1);
             er_save(er_stack.back(), NULL, NULL);
 
-            // clean memory
-            for (size_t r=0; r<er_stack.size(); r++)
-            {
-                ERStat *stat = er_stack.at(r);
-                if (stat->crossings)
-                {
-                    stat->crossings->clear();
-                    delete(stat->crossings);
-                    stat->crossings = NULL;
-                }
-                deleteERStatTree(stat);
-            }
+            // recycle the nodes for the next image
             er_stack.clear();
+            er_pool.releaseAll();
 
             return;
         }
@@ -563,7 +601,7 @@ void ERFilterNM::er_tree_extract( InputArray image )
 
                 if (new_level < er_stack.back()->level)
                 {
-                    er_stack.push_back(new ERStat(new_level, current_pixel, current_pixel%width, current_pixel/width));
+                    er_stack.push_back(er_pool.get(new_level, current_pixel, current_pixel%width, current_pixel/width));
                     er_merge(er_stack.back(), er);
                     break;
                 }
@@ -664,11 +702,6 @@ void ERFilterNM::er_merge(ERStat *parent, ERStat *child)
     sort(m_crossings.begin(), m_crossings.end());
     child->med_crossings = (float)m_crossings.at(1);
 
-    // free unnecessary mem
-    child->crossings->clear();
-    delete(child->crossings);
-    child->crossings = NULL;
-
     // recover the original grey-level
     child->level = child->level*thresholdDelta;
 
@@ -711,14 +744,8 @@ void ERFilterNM::er_merge(ERStat *parent, ERStat *child)
             child->child->parent = parent;
         }
 
-        // free mem
-        if(child->crossings)
-        {
-            child->crossings->clear();
-            delete(child->crossings);
-            child->crossings = NULL;
-        }
-        delete(child);
+        // the node can be reused by the next component
+        er_pool.release(child);
     }
 
 }
@@ -729,6 +756,8 @@ ERStat* ERFilterNM::er_save( ERStat *er, ERStat *parent, ERStat *prev )
 
     regions->push_back(*er);
 
+    // the crossings stay in the pool
+    regions->back().crossings = NULL;
     regions->back().parent = parent;
     if (prev != NULL)
     {
@@ -1392,16 +1421,12 @@ static double log_gamma_windschitl(double x)
 */
 #define log_gamma(x) ((x)>15.0?log_gamma_windschitl(x):log_gamma_lanczos(x))
 
-// Size of the table to store already computed inverse values.
-#define TABSIZE 100000
-
 /*
      Computes -log10(NFA).
      NFA stands for Number of False Alarms:
 */
 static double NFA(int n, int k, double p, double logNT)
 {
-    static double inv[TABSIZE];   /* table to keep computed inverse values */
     double tolerance = 0.1;       /* an error of 10% in the result is accepted */
     double log1term,term,bin_term,mult_term,bin_tail,err,p_term;
     int i;
@@ -1443,9 +1468,7 @@ static double NFA(int n, int k, double p, double logNT)
     bin_tail = term;
     for(i=k+1;i<=n;i++)
     {
-        bin_term = (double) (n-i+1) * ( i<TABSIZE ?
-                    ( inv[i]!=0.0 ? inv[i] : ( inv[i] = 1.0 / (double) i ) ) :
-                    1.0 / (double) i );
+        bin_term = (double) (n-i+1) * ( 1.0 / (double) i );
 
         mult_term = bin_term * p_term;
         term *= mult_term;
@@ -2216,7 +2239,7 @@ public:
 
     /// Constructor.
     MaxMeaningfulClustering(unsigned char _method, unsigned char _metric, vector<ERFeatures> &_regions,
-                            Size _imsize, const string &filename, double _minProbability);
+                            Size _imsize, const Ptr<Boost> &_group_boost, double _minProbability);
 
     void operator()(double *data, unsigned int num, int dim, unsigned char method,
                     unsigned char metric, vector< vector<int> > *meaningful_clusters);
@@ -2242,12 +2265,17 @@ private:
 };
 
 MaxMeaningfulClustering::MaxMeaningfulClustering(unsigned char _method, unsigned char _metric, vector<ERFeatures> &_regions,
-                                                 Size _imsize, const string &filename, double _minProbability):
-                                                 method_(_method), metric_(_metric), regions(_regions), imsize(_imsize)
+                                                 Size _imsize, const Ptr<Boost> &_group_boost, double _minProbability):
+                                                 method_(_method), metric_(_metric), group_boost(_group_boost),
+                                                 regions(_regions), imsize(_imsize)
 {
-
     minProbability = _minProbability;
+}
 
+// The group classifier is loaded once and shared by the clusterings of all the channels
+static Ptr<Boost> loadGroupClassifier(const string &filename)
+{
+    Ptr<Boost> group_boost;
     if (ifstream(filename.c_str()))
     {
         group_boost = StatModel::load<Boost>( filename.c_str() );
@@ -2259,6 +2287,7 @@ MaxMeaningfulClustering::MaxMeaningfulClustering(unsigned char _method, unsigned
     }
     else
         CV_Error(Error::StsBadArg, "erGrouping: Default classifier file not found!");
+    return group_boost;
 }
 
 
@@ -3018,103 +3047,143 @@ float extract_features(Mat &grey, Mat& channel, vector<ERStat> &regions, vector<
     \param  filename       The XML or YAML file with the classifier model (e.g. trained_classifier_erGrouping.xml)
     \param  minProbability The minimum probability for accepting a group
 */
-static void erGroupingGK(InputArray _image, InputArrayOfArrays _src, vector<vector<ERStat> > &regions, vector<vector<Vec2i> > &groups,  vector<Rect> &text_boxes, const string& filename, float minProbability)
+// Groups the regions of one channel in its learned feature space
+static void erGroupingGKChannel(Mat &grey, Mat &channel, int c, vector<ERStat> &regions, const Ptr<Boost> &group_boost,
+                                float minProbability, vector<vector<Vec2i> > &groups, vector<Rect> &text_boxes)
 {
+    // assert correct image type
+    CV_Assert( channel.type() == CV_8UC1 );
 
-    CV_Assert( _image.getMat().type() == CV_8UC3 );
-    // TODO assert correct vector<Mat>
+    //CV_Assert( !regions.empty() );
 
-    Mat image = _image.getMat();
-    Mat grey;
-    cvtColor(image, grey, COLOR_BGR2GRAY);
+    if ( regions.size() < 3 )
+        return;
 
-    vector<Mat> src;
-    _src.getMatVector(src);
 
-    CV_Assert ( !src.empty() );
-    CV_Assert ( src.size() == regions.size() );
+    vector<vector<int> > meaningful_clusters;
+    vector<ERFeatures> features;
+    float max_stroke = extract_features(grey, channel, regions, features);
 
-    if (!text_boxes.empty())
+
+
+    // Find the Max. Meaningful Clusters in the learned feature space
+
+    unsigned int N = (unsigned int)regions.size();
+    int dim = 7; //dimensionality of feature space
+    double *data = (double*)malloc(dim*N * sizeof(double));
+    if (data == NULL)
+        CV_Error(Error::StsNoMem, "Not enough Memory for erGrouping hierarchical clustering structures!");
+
+    //Learned weights
+    float weight_param1 = 1.00f;
+    float weight_param2 = 0.65f;
+    float weight_param3 = 0.65f;
+    float weight_param4 = 0.49f;
+    float weight_param5 = 0.67f;
+    float weight_param6 = 0.91f;
+
+    int count = 0;
+    for (int i=0; i<(int)regions.size(); i++)
     {
-        text_boxes.clear();
+        data[count] = (double)features.at(i).center.x/channel.cols*weight_param1;
+        data[count+1] = (double)features.at(i).center.y/channel.rows*weight_param1;
+        data[count+2] = (double)features.at(i).intensity_mean/255*weight_param2;
+        data[count+3] = (double)features.at(i).boundary_intensity_mean/255*weight_param3;
+        data[count+4] = (double)max(features.at(i).rect.height,features.at(i).rect.width)/
+                                max(channel.rows,channel.cols)*weight_param5;
+        data[count+5] = (double)features.at(i).stroke_mean/max_stroke*weight_param6;
+        data[count+6] = (double)features.at(i).gradient_mean/255*weight_param4;
+
+        count = count+dim;
     }
 
-    for (int c=0; c<(int)src.size(); c++)
-    {
-        Mat channel = src.at(c);
+    MaxMeaningfulClustering   mm_clustering(METHOD_METR_SINGLE, METRIC_SEUCLIDEAN, features, Size(channel.cols,channel.rows), group_boost, minProbability);
+    mm_clustering(data, N, dim, METHOD_METR_SINGLE, METRIC_SEUCLIDEAN, &meaningful_clusters);
 
-        // assert correct image type
-        CV_Assert( channel.type() == CV_8UC1 );
+    free(data);
 
-        //CV_Assert( !regions.at(c).empty() );
+    for (size_t k=0; k<meaningful_clusters.size(); k++)
+    {
+        if (meaningful_clusters[k].size()>2)
+        {
+            Rect group_rect = features[meaningful_clusters[k][0]].rect;
+            vector<Vec2i> group;
+            group.push_back(Vec2i(c,meaningful_clusters[k][0]));
+            for (size_t l=1; l<meaningful_clusters[k].size(); l++)
+            {
+                group_rect = group_rect | features[meaningful_clusters[k][l]].rect;
+                group.push_back(Vec2i(c,meaningful_clusters[k][l]));
+            }
+            text_boxes.push_back(group_rect);
+            groups.push_back(group);
+        }
+    }
 
-        if ( regions.at(c).size() < 3 )
-            continue;
+    //getLines(img, &regions, &final_clusters, line_rects, line_regions, multi_oriented);
+}
 
+// Groups the regions of a range of channels, each channel into its own output
+class ERGroupingGKInvoker : public ParallelLoopBody
+{
+public:
+    ERGroupingGKInvoker(Mat &_grey, vector<Mat> &_src, vector<vector<ERStat> > &_regions, const Ptr<Boost> &_group_boost,
+                        float _minProbability, vector<vector<vector<Vec2i> > > &_groups, vector<vector<Rect> > &_text_boxes)
+        : grey(_grey), src(_src), regions(_regions), group_boost(_group_boost), minProbability(_minProbability),
+          groups(_groups), text_boxes(_text_boxes)
+    {
+    }
 
-        vector<vector<int> > meaningful_clusters;
-        vector<ERFeatures> features;
-        float max_stroke = extract_features(grey, channel, regions.at(c), features);
+    virtual void operator()( const Range &r ) const
+    {
+        for (int c=r.start; c<r.end; c++)
+            erGroupingGKChannel(grey, src[c], c, regions[c], group_boost, minProbability, groups[c], text_boxes[c]);
+    }
 
+private:
+    Mat &grey;
+    vector<Mat> &src;
+    vector<vector<ERStat> > &regions;
+    const Ptr<Boost> &group_boost;
+    float minProbability;
+    vector<vector<vector<Vec2i> > > &groups;
+    vector<vector<Rect> > &text_boxes;
 
+    ERGroupingGKInvoker & operator=(const ERGroupingGKInvoker&); // to quiet MSVC
+};
 
-        // Find the Max. Meaningful Clusters in the learned feature space
+static void erGroupingGK(InputArray _image, InputArrayOfArrays _src, vector<vector<ERStat> > &regions, vector<vector<Vec2i> > &groups,  vector<Rect> &text_boxes, const string& filename, float minProbability)
+{
 
-        unsigned int N = (unsigned int)regions.at(c).size();
-        int dim = 7; //dimensionality of feature space
-        double *data = (double*)malloc(dim*N * sizeof(double));
-        if (data == NULL)
-            CV_Error(Error::StsNoMem, "Not enough Memory for erGrouping hierarchical clustering structures!");
+    CV_Assert( _image.getMat().type() == CV_8UC3 );
+    // TODO assert correct vector<Mat>
 
-        //Learned weights
-        float weight_param1 = 1.00f;
-        float weight_param2 = 0.65f;
-        float weight_param3 = 0.65f;
-        float weight_param4 = 0.49f;
-        float weight_param5 = 0.67f;
-        float weight_param6 = 0.91f;
+    Mat image = _image.getMat();
+    Mat grey;
+    cvtColor(image, grey, COLOR_BGR2GRAY);
 
-        int count = 0;
-        for (int i=0; i<(int)regions.at(c).size(); i++)
-        {
-            data[count] = (double)features.at(i).center.x/channel.cols*weight_param1;
-            data[count+1] = (double)features.at(i).center.y/channel.rows*weight_param1;
-            data[count+2] = (double)features.at(i).intensity_mean/255*weight_param2;
-            data[count+3] = (double)features.at(i).boundary_intensity_mean/255*weight_param3;
-            data[count+4] = (double)max(features.at(i).rect.height,features.at(i).rect.width)/
-                                    max(channel.rows,channel.cols)*weight_param5;
-            data[count+5] = (double)features.at(i).stroke_mean/max_stroke*weight_param6;
-            data[count+6] = (double)features.at(i).gradient_mean/255*weight_param4;
-
-            count = count+dim;
-        }
+    vector<Mat> src;
+    _src.getMatVector(src);
 
-        MaxMeaningfulClustering   mm_clustering(METHOD_METR_SINGLE, METRIC_SEUCLIDEAN, features, Size(channel.cols,channel.rows), filename, minProbability);
-        mm_clustering(data, N, dim, METHOD_METR_SINGLE, METRIC_SEUCLIDEAN, &meaningful_clusters);
+    CV_Assert ( !src.empty() );
+    CV_Assert ( src.size() == regions.size() );
 
-        free(data);
+    if (!text_boxes.empty())
+    {
+        text_boxes.clear();
+    }
 
-        for (size_t k=0; k<meaningful_clusters.size(); k++)
-        {
-            if (meaningful_clusters[k].size()>2)
-            {
-                Rect group_rect = features[meaningful_clusters[k][0]].rect;
-                vector<Vec2i> group;
-                group.push_back(Vec2i(c,meaningful_clusters[k][0]));
-                for (size_t l=1; l<meaningful_clusters[k].size(); l++)
-                {
-                    group_rect = group_rect | features[meaningful_clusters[k][l]].rect;
-                    group.push_back(Vec2i(c,meaningful_clusters[k][l]));
-                }
-                text_boxes.push_back(group_rect);
-                groups.push_back(group);
-            }
-        }
+    Ptr<Boost> group_boost = loadGroupClassifier(filename);
 
-        //getLines(img, &regions, &final_clusters, line_rects, line_regions, multi_oriented);
+    // the feature spaces of the channels are independent, their groups are appended in the order of the channels
+    vector<vector<vector<Vec2i> > > channel_groups(src.size());
+    vector<vector<Rect> > channel_boxes(src.size());
+    parallel_for_(Range(0, (int)src.size()),
+                  ERGroupingGKInvoker(grey, src, regions, group_boost, minProbability, channel_groups, channel_boxes));
 
-        meaningful_clusters.clear();
-        features.clear();
+    for (size_t c=0; c<src.size(); c++)
+    {
+        groups.insert(groups.end(), channel_groups[c].begin(), channel_groups[c].end());
+        text_boxes.insert(text_boxes.end(), channel_boxes[c].begin(), channel_boxes[c].end());
     }
 }
 
@@ -3263,10 +3332,28 @@ struct region_sequence
     region_sequence () {}
 };
 
+// struct region_colour
+// Mean grey level and mean a, b values of the pixels of an ER
+struct region_colour
+{
+    int grey_mean;
+    float a_mean;
+    float b_mean;
+};
+
 // Evaluates if a pair of regions is valid or not
 // using thresholds learned on training (defined above)
 bool isValidPair(Mat &grey, Mat& lab, Mat& mask, vector<Mat> &channels, vector< vector<ERStat> >& regions, Vec2i idx1, Vec2i idx2);
 
+// The geometric rules of isValidPair, they only need the bounding boxes of the regions
+bool isValidPairGeometry(vector< vector<ERStat> >& regions, Vec2i idx1, Vec2i idx2);
+
+// The colour rules of isValidPair
+bool isValidPairColour(const region_colour &colour1, const region_colour &colour2);
+
+// Computes the colour of a region, the pixels of the region are found with a flood fill in mask
+region_colour regionColour(Mat &grey, Mat& lab, Mat& mask, vector<Mat> &channels, vector< vector<ERStat> >& regions, Vec2i idx);
+
 // Evaluates if a set of 3 regions is valid or not
 // using thresholds learned on training (defined above)
 bool isValidTriplet(vector< vector<ERStat> >& regions, region_pair pair1, region_pair pair2, region_triplet &triplet);
@@ -3475,6 +3562,15 @@ bool fitLineEstimates(vector< vector<ERStat> > &regions, region_triplet &triplet
 // Evaluates if a pair of regions is valid or not
 // using thresholds learned on training (defined above)
 bool isValidPair(Mat &grey, Mat &lab, Mat &mask, vector<Mat> &channels, vector< vector<ERStat> >& regions, Vec2i idx1, Vec2i idx2)
+{
+    if (!isValidPairGeometry(regions, idx1, idx2))
+        return false;
+
+    return isValidPairColour(regionColour(grey, lab, mask, channels, regions, idx1),
+                             regionColour(grey, lab, mask, channels, regions, idx2));
+}
+
+bool isValidPairGeometry(vector< vector<ERStat> >& regions, Vec2i idx1, Vec2i idx2)
 {
     Rect minarearect  = regions[idx1[0]][idx1[1]].rect | regions[idx2[0]][idx2[1]].rect;
 
@@ -3516,8 +3612,12 @@ bool isValidPair(Mat &grey, Mat &lab, Mat &mask, vector<Mat> &channels, vector<
     if ((i->parent == NULL)||(j->parent == NULL)) // deprecate the root region
       return false;
 
-    i = &regions[idx1[0]][idx1[1]];
-    j = &regions[idx2[0]][idx2[1]];
+    return true;
+}
+
+region_colour regionColour(Mat &grey, Mat &lab, Mat &mask, vector<Mat> &channels, vector< vector<ERStat> >& regions, Vec2i idx)
+{
+    ERStat *i = &regions[idx[0]][idx[1]];
 
     Mat region = mask(Rect(Point(i->rect.x,i->rect.y),
                            Point(i->rect.br().x+2,i->rect.br().y+2)));
@@ -3527,48 +3627,72 @@ bool isValidPair(Mat &grey, Mat &lab, Mat &mask, vector<Mat> &channels, vector<
     int flags = 4 + (newMaskVal << 8) + FLOODFILL_FIXED_RANGE + FLOODFILL_MASK_ONLY;
     Rect rect;
 
-    floodFill( channels[idx1[0]](Rect(Point(i->rect.x,i->rect.y),Point(i->rect.br().x,i->rect.br().y))),
+    floodFill( channels[idx[0]](Rect(Point(i->rect.x,i->rect.y),Point(i->rect.br().x,i->rect.br().y))),
                region, Point(i->pixel%grey.cols - i->rect.x, i->pixel/grey.cols - i->rect.y),
                Scalar(255), &rect, Scalar(i->level), Scalar(0), flags);
-    rect.width += 2;
-    rect.height += 2;
     Mat rect_mask = mask(Rect(i->rect.x+1,i->rect.y+1,i->rect.width,i->rect.height));
 
+    region_colour colour;
     Scalar mean,std;
     meanStdDev(grey(i->rect),mean,std,rect_mask);
-    int grey_mean1 = (int)mean[0];
+    colour.grey_mean = (int)mean[0];
     meanStdDev(lab(i->rect),mean,std,rect_mask);
-    float a_mean1 = (float)mean[1];
-    float b_mean1 = (float)mean[2];
+    colour.a_mean = (float)mean[1];
+    colour.b_mean = (float)mean[2];
 
-    region = mask(Rect(Point(j->rect.x,j->rect.y),
-                           Point(j->rect.br().x+2,j->rect.br().y+2)));
-    region = Scalar(0);
-
-    floodFill( channels[idx2[0]](Rect(Point(j->rect.x,j->rect.y),Point(j->rect.br().x,j->rect.br().y))),
-               region, Point(j->pixel%grey.cols - j->rect.x, j->pixel/grey.cols - j->rect.y),
-               Scalar(255), &rect, Scalar(j->level), Scalar(0), flags);
-    rect.width += 2;
-    rect.height += 2;
-    rect_mask = mask(Rect(j->rect.x+1,j->rect.y+1,j->rect.width,j->rect.height));
-
-    meanStdDev(grey(j->rect),mean,std,rect_mask);
-    int grey_mean2 = (int)mean[0];
-    meanStdDev(lab(j->rect),mean,std,rect_mask);
-    float a_mean2 = (float)mean[1];
-    float b_mean2 = (float)mean[2];
+    return colour;
+}
 
-    if (abs(grey_mean1-grey_mean2) > PAIR_MAX_INTENSITY_DIST)
+bool isValidPairColour(const region_colour &colour1, const region_colour &colour2)
+{
+    if (abs(colour1.grey_mean-colour2.grey_mean) > PAIR_MAX_INTENSITY_DIST)
       return false;
 
-    if (sqrt(pow(a_mean1-a_mean2,2)+pow(b_mean1-b_mean2,2)) > PAIR_MAX_AB_DIST)
+    if (sqrt(pow(colour1.a_mean-colour2.a_mean,2)+pow(colour1.b_mean-colour2.b_mean,2)) > PAIR_MAX_AB_DIST)
       return false;
 
-
-
     return true;
 }
 
+// isValidPair for the regions of one channel, the colour of a region is computed only once
+class ChannelPairValidator
+{
+public:
+    ChannelPairValidator(Mat &_grey, Mat &_lab, Mat &_mask, vector<Mat> &_channels, vector< vector<ERStat> >& _regions, int c)
+        : grey(_grey), lab(_lab), mask(_mask), channels(_channels), regions(_regions),
+          colours(_regions[c].size()), has_colour(_regions[c].size(), (uchar)0)
+    {
+    }
+
+    bool operator()(Vec2i idx1, Vec2i idx2)
+    {
+        if (!isValidPairGeometry(regions, idx1, idx2))
+            return false;
+        return isValidPairColour(colour(idx1), colour(idx2));
+    }
+
+private:
+    const region_colour& colour(Vec2i idx)
+    {
+        if (!has_colour[idx[1]])
+        {
+            colours[idx[1]] = regionColour(grey, lab, mask, channels, regions, idx);
+            has_colour[idx[1]] = 1;
+        }
+        return colours[idx[1]];
+    }
+
+    Mat &grey;
+    Mat &lab;
+    Mat &mask;
+    vector<Mat> &channels;
+    vector< vector<ERStat> > &regions;
+    vector<region_colour> colours;
+    vector<uchar> has_colour;
+
+    ChannelPairValidator & operator=(const ChannelPairValidator&); // to quiet MSVC
+};
+
 // Evaluates if a set of 3 regions is valid or not
 // using thresholds learned on training (defined above)
 bool isValidTriplet(vector< vector<ERStat> >& regions, region_pair pair1, region_pair pair2, region_triplet &triplet)
@@ -3747,333 +3871,393 @@ bool sort_couples (Vec3i i,Vec3i j) { return (i[0]<j[0]); }
     \param  do_feedback    Whenever the grouping algorithm uses a feedback loop to recover missing regions in a line.
 */
 
-void erGroupingNM(InputArray _img, InputArrayOfArrays _src, vector< vector<ERStat> >& regions,
-                  vector< vector<Vec2i> >& out_groups, vector<Rect>& out_boxes, bool do_feedback_loop)
+// Exhaustive Search grouping of the regions of one channel
+static void erGroupingNMChannel(Mat &grey, Mat &lab, vector<Mat> &src, vector< vector<ERStat> >& regions, size_t c,
+                                vector< vector<Vec2i> >& out_groups, vector<Rect>& out_boxes, bool do_feedback_loop)
 {
-
-    vector<Mat> src;
-    _src.getMatVector(src);
-
-    CV_Assert ( !src.empty() );
-    //CV_Assert ( src.size() == regions.size() );
-    size_t num_channels = src.size();
-
-    Mat img = _img.getMat();
-
-    //process each channel independently
-    for(size_t c=0; c<num_channels; c++)
+    //store indices to regions in a single vector
+    vector< Vec2i > all_regions;
+    for(size_t r=0; r<regions[c].size(); r++)
     {
-        //store indices to regions in a single vector
-        vector< Vec2i > all_regions;
-        for(size_t r=0; r<regions[c].size(); r++)
-        {
-            all_regions.push_back(Vec2i((int)c,(int)r));
-        }
+        all_regions.push_back(Vec2i((int)c,(int)r));
+    }
 
-        vector< region_pair > valid_pairs;
-        Mat mask = Mat::zeros(img.rows+2, img.cols+2, CV_8UC1);
-        Mat grey,lab;
-        cvtColor(img, lab, COLOR_RGB2Lab);
-        cvtColor(img, grey, COLOR_RGB2GRAY);
+    vector< region_pair > valid_pairs;
+    Mat mask = Mat::zeros(grey.rows+2, grey.cols+2, CV_8UC1);
+    ChannelPairValidator isValidChannelPair(grey, lab, mask, src, regions, (int)c);
 
-        //check every possible pair of regions
-        for (size_t i=0; i<all_regions.size(); i++)
+    //check every possible pair of regions
+    for (size_t i=0; i<all_regions.size(); i++)
+    {
+        vector<int> i_siblings;
+        int first_i_sibling_idx = (int)valid_pairs.size();
+        for (size_t j=i+1; j<all_regions.size(); j++)
         {
-            vector<int> i_siblings;
-            int first_i_sibling_idx = (int)valid_pairs.size();
-            for (size_t j=i+1; j<all_regions.size(); j++)
+            // check height ratio, centroid angle and region distance normalized by region width
+            // fall within a given interval
+            if (isValidChannelPair(all_regions[i],all_regions[j]))
             {
-                // check height ratio, centroid angle and region distance normalized by region width
-                // fall within a given interval
-                if (isValidPair(grey, lab, mask, src, regions, all_regions[i],all_regions[j]))
+                bool isCycle = false;
+                for (size_t k=0; k<i_siblings.size(); k++)
                 {
-                    bool isCycle = false;
-                    for (size_t k=0; k<i_siblings.size(); k++)
+                  if (isValidChannelPair(all_regions[j],all_regions[i_siblings[k]]))
+                  {
+                    // choose as sibling the closer and not the first that was "paired" with i
+                    Point i_center = Point( regions[all_regions[i][0]][all_regions[i][1]].rect.x +
+                                            regions[all_regions[i][0]][all_regions[i][1]].rect.width/2,
+                                            regions[all_regions[i][0]][all_regions[i][1]].rect.y +
+                                            regions[all_regions[i][0]][all_regions[i][1]].rect.height/2 );
+                    Point j_center = Point( regions[all_regions[j][0]][all_regions[j][1]].rect.x +
+                                            regions[all_regions[j][0]][all_regions[j][1]].rect.width/2,
+                                            regions[all_regions[j][0]][all_regions[j][1]].rect.y +
+                                            regions[all_regions[j][0]][all_regions[j][1]].rect.height/2 );
+                    Point k_center = Point( regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.x +
+                                            regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.width/2,
+                                            regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.y +
+                                            regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.height/2 );
+
+                    if ( norm(i_center - j_center) < norm(i_center - k_center) )
                     {
-                      if (isValidPair(grey, lab, mask, src, regions, all_regions[j],all_regions[i_siblings[k]]))
-                      {
-                        // choose as sibling the closer and not the first that was "paired" with i
-                        Point i_center = Point( regions[all_regions[i][0]][all_regions[i][1]].rect.x +
-                                                regions[all_regions[i][0]][all_regions[i][1]].rect.width/2,
-                                                regions[all_regions[i][0]][all_regions[i][1]].rect.y +
-                                                regions[all_regions[i][0]][all_regions[i][1]].rect.height/2 );
-                        Point j_center = Point( regions[all_regions[j][0]][all_regions[j][1]].rect.x +
-                                                regions[all_regions[j][0]][all_regions[j][1]].rect.width/2,
-                                                regions[all_regions[j][0]][all_regions[j][1]].rect.y +
-                                                regions[all_regions[j][0]][all_regions[j][1]].rect.height/2 );
-                        Point k_center = Point( regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.x +
-                                                regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.width/2,
-                                                regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.y +
-                                                regions[all_regions[i_siblings[k]][0]][all_regions[i_siblings[k]][1]].rect.height/2 );
-
-                        if ( norm(i_center - j_center) < norm(i_center - k_center) )
-                        {
-                          valid_pairs[first_i_sibling_idx+k] = region_pair(all_regions[i],all_regions[j]);
-                          i_siblings[k] = (int)j;
-                        }
-                        isCycle = true;
-                        break;
-                      }
-                    }
-                    if (!isCycle)
-                    {
-                      valid_pairs.push_back(region_pair(all_regions[i],all_regions[j]));
-                      i_siblings.push_back((int)j);
-                      //cout << "Valid pair (" << all_regions[i][0] << ","  << all_regions[i][1] << ") (" << all_regions[j][0] << ","  << all_regions[j][1] << ")" << endl;
+                      valid_pairs[first_i_sibling_idx+k] = region_pair(all_regions[i],all_regions[j]);
+                      i_siblings[k] = (int)j;
                     }
+                    isCycle = true;
+                    break;
+                  }
+                }
+                if (!isCycle)
+                {
+                  valid_pairs.push_back(region_pair(all_regions[i],all_regions[j]));
+                  i_siblings.push_back((int)j);
+                  //cout << "Valid pair (" << all_regions[i][0] << ","  << all_regions[i][1] << ") (" << all_regions[j][0] << ","  << all_regions[j][1] << ")" << endl;
                 }
             }
         }
+    }
 
-        //cout << "GroupingNM : detected " << valid_pairs.size() << " valid pairs" << endl;
+    //cout << "GroupingNM : detected " << valid_pairs.size() << " valid pairs" << endl;
 
-        vector< region_triplet > valid_triplets;
+    vector< region_triplet > valid_triplets;
 
-        //check every possible triplet of regions
-        for (size_t i=0; i<valid_pairs.size(); i++)
+    // a triplet is made of two pairs with a region in common, so only the pairs sharing a region are checked
+    vector< vector<int> > region_pairs(regions[c].size());
+    for (size_t i=0; i<valid_pairs.size(); i++)
+    {
+        region_pairs[valid_pairs[i].a[1]].push_back((int)i);
+        region_pairs[valid_pairs[i].b[1]].push_back((int)i);
+    }
+
+    //check every possible triplet of regions
+    for (size_t i=0; i<valid_pairs.size(); i++)
+    {
+        const vector<int> &pairs_a = region_pairs[valid_pairs[i].a[1]];
+        const vector<int> &pairs_b = region_pairs[valid_pairs[i].b[1]];
+        vector<int> candidates;
+        candidates.reserve(pairs_a.size() + pairs_b.size());
+        // both lists are sorted, the candidates are visited in the order of the exhaustive search
+        std::set_union(pairs_a.begin(), pairs_a.end(), pairs_b.begin(), pairs_b.end(), std::back_inserter(candidates));
+        for (size_t n=0; n<candidates.size(); n++)
         {
-            for (size_t j=i+1; j<valid_pairs.size(); j++)
+            size_t j = (size_t)candidates[n];
+            if (j <= i)
+                continue;
+            // check colinearity rules
+            region_triplet valid_triplet(Vec2i(0,0),Vec2i(0,0),Vec2i(0,0));
+            if (isValidTriplet(regions, valid_pairs[i],valid_pairs[j], valid_triplet))
             {
-                // check colinearity rules
-                region_triplet valid_triplet(Vec2i(0,0),Vec2i(0,0),Vec2i(0,0));
-                if (isValidTriplet(regions, valid_pairs[i],valid_pairs[j], valid_triplet))
-                {
-                    valid_triplets.push_back(valid_triplet);
-                    //cout << "Valid triplet (" << valid_triplet.a[1] << "," <<  valid_triplet.b[1] << "," <<  valid_triplet.c[1] << ")" << endl;
-                }
+                valid_triplets.push_back(valid_triplet);
+                //cout << "Valid triplet (" << valid_triplet.a[1] << "," <<  valid_triplet.b[1] << "," <<  valid_triplet.c[1] << ")" << endl;
             }
         }
+    }
 
-        //cout << "GroupingNM : detected " << valid_triplets.size() << " valid triplets" << endl;
+    //cout << "GroupingNM : detected " << valid_triplets.size() << " valid triplets" << endl;
 
-        vector<region_sequence> valid_sequences;
-        vector<region_sequence> pending_sequences;
+    vector<region_sequence> valid_sequences;
+    vector<region_sequence> pending_sequences;
 
-        for (size_t i=0; i<valid_triplets.size(); i++)
-        {
-            pending_sequences.push_back(region_sequence(valid_triplets[i]));
-        }
+    for (size_t i=0; i<valid_triplets.size(); i++)
+    {
+        pending_sequences.push_back(region_sequence(valid_triplets[i]));
+    }
 
 
-        for (size_t i=0; i<pending_sequences.size(); i++)
+    for (size_t i=0; i<pending_sequences.size(); i++)
+    {
+        bool expanded = false;
+        for (size_t j=i+1; j<pending_sequences.size(); j++)
         {
-            bool expanded = false;
-            for (size_t j=i+1; j<pending_sequences.size(); j++)
+            if (isValidSequence(pending_sequences[i], pending_sequences[j]))
             {
-                if (isValidSequence(pending_sequences[i], pending_sequences[j]))
-                {
-                    expanded = true;
-                    pending_sequences[i].triplets.insert(pending_sequences[i].triplets.begin(), pending_sequences[j].triplets.begin(), pending_sequences[j].triplets.end());
-                    pending_sequences.erase(pending_sequences.begin()+j);
-                    j--;
-                }
-            }
-            if (expanded)
-            {
-                valid_sequences.push_back(pending_sequences[i]);
+                expanded = true;
+                pending_sequences[i].triplets.insert(pending_sequences[i].triplets.begin(), pending_sequences[j].triplets.begin(), pending_sequences[j].triplets.end());
+                pending_sequences.erase(pending_sequences.begin()+j);
+                j--;
             }
         }
+        if (expanded)
+        {
+            valid_sequences.push_back(pending_sequences[i]);
+        }
+    }
 
-        // remove a sequence if one its regions is already grouped within a longer seq
-        for (size_t i=0; i<valid_sequences.size(); i++)
+    // remove a sequence if one its regions is already grouped within a longer seq
+    for (size_t i=0; i<valid_sequences.size(); i++)
+    {
+        for (size_t j=i+1; j<valid_sequences.size(); j++)
         {
-            for (size_t j=i+1; j<valid_sequences.size(); j++)
+          if (haveCommonRegion(valid_sequences[i],valid_sequences[j]))
+          {
+            if (valid_sequences[i].triplets.size() < valid_sequences[j].triplets.size())
             {
-              if (haveCommonRegion(valid_sequences[i],valid_sequences[j]))
-              {
-                if (valid_sequences[i].triplets.size() < valid_sequences[j].triplets.size())
-                {
-                  valid_sequences.erase(valid_sequences.begin()+i);
-                  i--;
-                  break;
-                }
-                else
-                {
-                  valid_sequences.erase(valid_sequences.begin()+j);
-                  j--;
-                }
-              }
+              valid_sequences.erase(valid_sequences.begin()+i);
+              i--;
+              break;
             }
+            else
+            {
+              valid_sequences.erase(valid_sequences.begin()+j);
+              j--;
+            }
+          }
         }
+    }
 
 
-        //cout << "GroupingNM : detected " << valid_sequences.size() << " sequences." << endl;
+    //cout << "GroupingNM : detected " << valid_sequences.size() << " sequences." << endl;
 
-        if (do_feedback_loop)
+    if (do_feedback_loop)
+    {
+
+        //Feedback loop of detected lines to region extraction ... tries to recover missmatches in the region decomposition step by extracting regions in the neighbourhood of a valid sequence and checking if they are consistent with its line estimates
+        Ptr<ERFilter> er_filter = createERFilterNM1(loadDummyClassifier(),1,0.005f,0.3f,0.f,false);
+        for (int i=0; i<(int)valid_sequences.size(); i++)
         {
+            vector<Point> bbox_points;
 
-            //Feedback loop of detected lines to region extraction ... tries to recover missmatches in the region decomposition step by extracting regions in the neighbourhood of a valid sequence and checking if they are consistent with its line estimates
-            Ptr<ERFilter> er_filter = createERFilterNM1(loadDummyClassifier(),1,0.005f,0.3f,0.f,false);
-            for (int i=0; i<(int)valid_sequences.size(); i++)
+            for (size_t j=0; j<valid_sequences[i].triplets.size(); j++)
             {
-                vector<Point> bbox_points;
+                bbox_points.push_back(regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect.tl());
+                bbox_points.push_back(regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect.br());
+                bbox_points.push_back(regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect.tl());
+                bbox_points.push_back(regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect.br());
+                bbox_points.push_back(regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect.tl());
+                bbox_points.push_back(regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect.br());
+            }
 
-                for (size_t j=0; j<valid_sequences[i].triplets.size(); j++)
-                {
-                    bbox_points.push_back(regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect.tl());
-                    bbox_points.push_back(regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect.br());
-                    bbox_points.push_back(regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect.tl());
-                    bbox_points.push_back(regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect.br());
-                    bbox_points.push_back(regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect.tl());
-                    bbox_points.push_back(regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect.br());
-                }
+            Rect rect = boundingRect(bbox_points);
+            rect.x = max(rect.x-10,0);
+            rect.y = max(rect.y-10,0);
+            rect.width = min(rect.width+20,src[c].cols-rect.x);
+            rect.height = min(rect.height+20,src[c].rows-rect.y);
 
-                Rect rect = boundingRect(bbox_points);
-                rect.x = max(rect.x-10,0);
-                rect.y = max(rect.y-10,0);
-                rect.width = min(rect.width+20,src[c].cols-rect.x);
-                rect.height = min(rect.height+20,src[c].rows-rect.y);
+            vector<ERStat> aux_regions;
+            Mat tmp;
+            src[c](rect).copyTo(tmp);
+            er_filter->run(tmp, aux_regions);
 
-                vector<ERStat> aux_regions;
-                Mat tmp;
-                src[c](rect).copyTo(tmp);
-                er_filter->run(tmp, aux_regions);
+            for(size_t r=0; r<aux_regions.size(); r++)
+            {
+                if ((aux_regions[r].rect.y == 0)||(aux_regions[r].rect.br().y >= tmp.rows))
+                  continue;
 
-                for(size_t r=0; r<aux_regions.size(); r++)
+                aux_regions[r].rect   = aux_regions[r].rect + Point(rect.x,rect.y);
+                aux_regions[r].pixel  = ((aux_regions[r].pixel/tmp.cols)+rect.y)*src[c].cols + (aux_regions[r].pixel%tmp.cols) + rect.x;
+                bool overlaps = false;
+                for (size_t j=0; j<valid_sequences[i].triplets.size(); j++)
                 {
-                    if ((aux_regions[r].rect.y == 0)||(aux_regions[r].rect.br().y >= tmp.rows))
-                      continue;
+                    Rect minarearect_a  = regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect | aux_regions[r].rect;
+                    Rect minarearect_b  = regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect | aux_regions[r].rect;
+                    Rect minarearect_c  = regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect | aux_regions[r].rect;
+
+                    // Overlapping regions are not valid pair in any case
+                    if ( (minarearect_a == aux_regions[r].rect) ||
+                         (minarearect_b == aux_regions[r].rect) ||
+                         (minarearect_c == aux_regions[r].rect) ||
+                         (minarearect_a == regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect) ||
+                         (minarearect_b == regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect) ||
+                         (minarearect_c == regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect) )
 
-                    aux_regions[r].rect   = aux_regions[r].rect + Point(rect.x,rect.y);
-                    aux_regions[r].pixel  = ((aux_regions[r].pixel/tmp.cols)+rect.y)*src[c].cols + (aux_regions[r].pixel%tmp.cols) + rect.x;
-                    bool overlaps = false;
+                    {
+                        overlaps = true;
+                        break;
+                    }
+                }
+                if (!overlaps)
+                {
+                    //now check if it has at least one valid pair
+                    vector<Vec3i> left_couples, right_couples;
+                    regions[c].push_back(aux_regions[r]);
                     for (size_t j=0; j<valid_sequences[i].triplets.size(); j++)
                     {
-                        Rect minarearect_a  = regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect | aux_regions[r].rect;
-                        Rect minarearect_b  = regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect | aux_regions[r].rect;
-                        Rect minarearect_c  = regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect | aux_regions[r].rect;
-
-                        // Overlapping regions are not valid pair in any case
-                        if ( (minarearect_a == aux_regions[r].rect) ||
-                             (minarearect_b == aux_regions[r].rect) ||
-                             (minarearect_c == aux_regions[r].rect) ||
-                             (minarearect_a == regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect) ||
-                             (minarearect_b == regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect) ||
-                             (minarearect_c == regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect) )
-
+                        if (isValidPair(grey, lab, mask, src, regions, valid_sequences[i].triplets[j].a, Vec2i((int)c,(int)(regions[c].size())-1)))
                         {
-                            overlaps = true;
-                            break;
+                            if (regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect.x > aux_regions[r].rect.x)
+                                right_couples.push_back(Vec3i(regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect.x - aux_regions[r].rect.x, valid_sequences[i].triplets[j].a[0],valid_sequences[i].triplets[j].a[1]));
+                            else
+                                left_couples.push_back(Vec3i(aux_regions[r].rect.x - regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect.x, valid_sequences[i].triplets[j].a[0],valid_sequences[i].triplets[j].a[1]));
                         }
-                    }
-                    if (!overlaps)
-                    {
-                        //now check if it has at least one valid pair
-                        vector<Vec3i> left_couples, right_couples;
-                        regions[c].push_back(aux_regions[r]);
-                        for (size_t j=0; j<valid_sequences[i].triplets.size(); j++)
+                        if (isValidPair(grey, lab, mask, src, regions, valid_sequences[i].triplets[j].b, Vec2i((int)c,(int)(regions[c].size())-1)))
                         {
-                            if (isValidPair(grey, lab, mask, src, regions, valid_sequences[i].triplets[j].a, Vec2i((int)c,(int)(regions[c].size())-1)))
-                            {
-                                if (regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect.x > aux_regions[r].rect.x)
-                                    right_couples.push_back(Vec3i(regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect.x - aux_regions[r].rect.x, valid_sequences[i].triplets[j].a[0],valid_sequences[i].triplets[j].a[1]));
-                                else
-                                    left_couples.push_back(Vec3i(aux_regions[r].rect.x - regions[valid_sequences[i].triplets[j].a[0]][valid_sequences[i].triplets[j].a[1]].rect.x, valid_sequences[i].triplets[j].a[0],valid_sequences[i].triplets[j].a[1]));
-                            }
-                            if (isValidPair(grey, lab, mask, src, regions, valid_sequences[i].triplets[j].b, Vec2i((int)c,(int)(regions[c].size())-1)))
-                            {
-                                if (regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect.x > aux_regions[r].rect.x)
-                                    right_couples.push_back(Vec3i(regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect.x - aux_regions[r].rect.x, valid_sequences[i].triplets[j].b[0],valid_sequences[i].triplets[j].b[1]));
-                                else
-                                    left_couples.push_back(Vec3i(aux_regions[r].rect.x - regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect.x, valid_sequences[i].triplets[j].b[0],valid_sequences[i].triplets[j].b[1]));
-                            }
-                            if (isValidPair(grey, lab, mask, src, regions, valid_sequences[i].triplets[j].c, Vec2i((int)c,(int)(regions[c].size())-1)))
-                            {
-                                if (regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect.x > aux_regions[r].rect.x)
-                                    right_couples.push_back(Vec3i(regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect.x - aux_regions[r].rect.x, valid_sequences[i].triplets[j].c[0],valid_sequences[i].triplets[j].c[1]));
-                                else
-                                    left_couples.push_back(Vec3i(aux_regions[r].rect.x - regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect.x, valid_sequences[i].triplets[j].c[0],valid_sequences[i].triplets[j].c[1]));
-                            }
+                            if (regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect.x > aux_regions[r].rect.x)
+                                right_couples.push_back(Vec3i(regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect.x - aux_regions[r].rect.x, valid_sequences[i].triplets[j].b[0],valid_sequences[i].triplets[j].b[1]));
+                            else
+                                left_couples.push_back(Vec3i(aux_regions[r].rect.x - regions[valid_sequences[i].triplets[j].b[0]][valid_sequences[i].triplets[j].b[1]].rect.x, valid_sequences[i].triplets[j].b[0],valid_sequences[i].triplets[j].b[1]));
                         }
-
-                        //make it part of a triplet and check if line estimates is consistent with the sequence
-                        vector<region_triplet> new_valid_triplets;
-                        if(!left_couples.empty() && !right_couples.empty())
+                        if (isValidPair(grey, lab, mask, src, regions, valid_sequences[i].triplets[j].c, Vec2i((int)c,(int)(regions[c].size())-1)))
                         {
-                            sort(left_couples.begin(), left_couples.end(), sort_couples);
-                            sort(right_couples.begin(), right_couples.end(), sort_couples);
-                            region_pair pair1(Vec2i(left_couples[0][1],left_couples[0][2]),Vec2i((int)c,(int)(regions[c].size())-1));
-                            region_pair pair2(Vec2i((int)c,(int)(regions[c].size())-1), Vec2i(right_couples[0][1],right_couples[0][2]));
-                            region_triplet triplet(Vec2i(0,0),Vec2i(0,0),Vec2i(0,0));
-                            if (isValidTriplet(regions, pair1, pair2, triplet))
-                            {
-                                new_valid_triplets.push_back(triplet);
-                            }
+                            if (regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect.x > aux_regions[r].rect.x)
+                                right_couples.push_back(Vec3i(regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect.x - aux_regions[r].rect.x, valid_sequences[i].triplets[j].c[0],valid_sequences[i].triplets[j].c[1]));
+                            else
+                                left_couples.push_back(Vec3i(aux_regions[r].rect.x - regions[valid_sequences[i].triplets[j].c[0]][valid_sequences[i].triplets[j].c[1]].rect.x, valid_sequences[i].triplets[j].c[0],valid_sequences[i].triplets[j].c[1]));
                         }
-                        else if (right_couples.size() >= 2)
+                    }
+
+                    //make it part of a triplet and check if line estimates is consistent with the sequence
+                    vector<region_triplet> new_valid_triplets;
+                    if(!left_couples.empty() && !right_couples.empty())
+                    {
+                        sort(left_couples.begin(), left_couples.end(), sort_couples);
+                        sort(right_couples.begin(), right_couples.end(), sort_couples);
+                        region_pair pair1(Vec2i(left_couples[0][1],left_couples[0][2]),Vec2i((int)c,(int)(regions[c].size())-1));
+                        region_pair pair2(Vec2i((int)c,(int)(regions[c].size())-1), Vec2i(right_couples[0][1],right_couples[0][2]));
+                        region_triplet triplet(Vec2i(0,0),Vec2i(0,0),Vec2i(0,0));
+                        if (isValidTriplet(regions, pair1, pair2, triplet))
                         {
-                            sort(right_couples.begin(), right_couples.end(), sort_couples);
-                            region_pair pair1(Vec2i((int)c,(int)(regions[c].size())-1), Vec2i(right_couples[0][1],right_couples[0][2]));
-                            region_pair pair2(Vec2i(right_couples[0][1],right_couples[0][2]), Vec2i(right_couples[1][1],right_couples[1][2]));
-                            region_triplet triplet(Vec2i(0,0),Vec2i(0,0),Vec2i(0,0));
-                            if (isValidTriplet(regions, pair1, pair2, triplet))
-                            {
-                                new_valid_triplets.push_back(triplet);
-                            }
+                            new_valid_triplets.push_back(triplet);
                         }
-                        else if (left_couples.size() >=2)
+                    }
+                    else if (right_couples.size() >= 2)
+                    {
+                        sort(right_couples.begin(), right_couples.end(), sort_couples);
+                        region_pair pair1(Vec2i((int)c,(int)(regions[c].size())-1), Vec2i(right_couples[0][1],right_couples[0][2]));
+                        region_pair pair2(Vec2i(right_couples[0][1],right_couples[0][2]), Vec2i(right_couples[1][1],right_couples[1][2]));
+                        region_triplet triplet(Vec2i(0,0),Vec2i(0,0),Vec2i(0,0));
+                        if (isValidTriplet(regions, pair1, pair2, triplet))
                         {
-                            sort(left_couples.begin(), left_couples.end(), sort_couples);
-                            region_pair pair1(Vec2i(left_couples[1][1],left_couples[1][2]), Vec2i(left_couples[0][1],left_couples[0][2]));
-                            region_pair pair2(Vec2i(left_couples[0][1],left_couples[0][2]),Vec2i((int)c,(int)(regions[c].size())-1));
-                            region_triplet triplet(Vec2i(0,0),Vec2i(0,0),Vec2i(0,0));
-                            if (isValidTriplet(regions, pair1, pair2, triplet))
-                            {
-                                new_valid_triplets.push_back(triplet);
-                            }
+                            new_valid_triplets.push_back(triplet);
                         }
-                        else
+                    }
+                    else if (left_couples.size() >=2)
+                    {
+                        sort(left_couples.begin(), left_couples.end(), sort_couples);
+                        region_pair pair1(Vec2i(left_couples[1][1],left_couples[1][2]), Vec2i(left_couples[0][1],left_couples[0][2]));
+                        region_pair pair2(Vec2i(left_couples[0][1],left_couples[0][2]),Vec2i((int)c,(int)(regions[c].size())-1));
+                        region_triplet triplet(Vec2i(0,0),Vec2i(0,0),Vec2i(0,0));
+                        if (isValidTriplet(regions, pair1, pair2, triplet))
                         {
-                            // no possible triplet found
-                            continue;
+                            new_valid_triplets.push_back(triplet);
                         }
+                    }
+                    else
+                    {
+                        // no possible triplet found
+                        continue;
+                    }
 
-                        //check if line estimates is consistent with the sequence
-                        for (size_t t=0; t<new_valid_triplets.size(); t++)
+                    //check if line estimates is consistent with the sequence
+                    for (size_t t=0; t<new_valid_triplets.size(); t++)
+                    {
+                        region_sequence sequence(new_valid_triplets[t]);
+                        if (isValidSequence(valid_sequences[i],sequence))
                         {
-                            region_sequence sequence(new_valid_triplets[t]);
-                            if (isValidSequence(valid_sequences[i],sequence))
-                            {
-                                valid_sequences[i].triplets.push_back(new_valid_triplets[t]);
-                            }
-
+                            valid_sequences[i].triplets.push_back(new_valid_triplets[t]);
                         }
+
                     }
                 }
             }
-
         }
 
+    }
 
-        // Prepare the sequences for output
-        for (size_t i=0; i<valid_sequences.size(); i++)
-        {
-            vector<Point> bbox_points;
-            vector<Vec2i> group_regions;
 
-            for (size_t j=0; j<valid_sequences[i].triplets.size(); j++)
+    // Prepare the sequences for output
+    for (size_t i=0; i<valid_sequences.size(); i++)
+    {
+        vector<Point> bbox_points;
+        vector<Vec2i> group_regions;
+
+        for (size_t j=0; j<valid_sequences[i].triplets.size(); j++)
+        {
+            size_t prev_size = group_regions.size();
+            if(find(group_regions.begin(), group_regions.end(), valid_sequences[i].triplets[j].a) == group_regions.end())
+              group_regions.push_back(valid_sequences[i].triplets[j].a);
+            if(find(group_regions.begin(), group_regions.end(), valid_sequences[i].triplets[j].b) == group_regions.end())
+              group_regions.push_back(valid_sequences[i].triplets[j].b);
+            if(find(group_regions.begin(), group_regions.end(), valid_sequences[i].triplets[j].c) == group_regions.end())
+              group_regions.push_back(valid_sequences[i].triplets[j].c);
+
+            for (size_t k=prev_size; k<group_regions.size(); k++)
             {
-                size_t prev_size = group_regions.size();
-                if(find(group_regions.begin(), group_regions.end(), valid_sequences[i].triplets[j].a) == group_regions.end())
-                  group_regions.push_back(valid_sequences[i].triplets[j].a);
-                if(find(group_regions.begin(), group_regions.end(), valid_sequences[i].triplets[j].b) == group_regions.end())
-                  group_regions.push_back(valid_sequences[i].triplets[j].b);
-                if(find(group_regions.begin(), group_regions.end(), valid_sequences[i].triplets[j].c) == group_regions.end())
-                  group_regions.push_back(valid_sequences[i].triplets[j].c);
-
-                for (size_t k=prev_size; k<group_regions.size(); k++)
-                {
-                    bbox_points.push_back(regions[group_regions[k][0]][group_regions[k][1]].rect.tl());
-                    bbox_points.push_back(regions[group_regions[k][0]][group_regions[k][1]].rect.br());
-                }
+                bbox_points.push_back(regions[group_regions[k][0]][group_regions[k][1]].rect.tl());
+                bbox_points.push_back(regions[group_regions[k][0]][group_regions[k][1]].rect.br());
             }
+        }
 
-            out_groups.push_back(group_regions);
-            out_boxes.push_back(boundingRect(bbox_points));
+        out_groups.push_back(group_regions);
+        out_boxes.push_back(boundingRect(bbox_points));
 
-        }
     }
+}
+
+// Groups the regions of a range of channels, each channel into its own output
+class ERGroupingNMInvoker : public ParallelLoopBody
+{
+public:
+    ERGroupingNMInvoker(Mat &_grey, Mat &_lab, vector<Mat> &_src, vector< vector<ERStat> >& _regions,
+                        vector< vector< vector<Vec2i> > >& _groups, vector< vector<Rect> >& _boxes, bool _do_feedback_loop)
+        : grey(_grey), lab(_lab), src(_src), regions(_regions), groups(_groups), boxes(_boxes),
+          do_feedback_loop(_do_feedback_loop)
+    {
+    }
+
+    virtual void operator()( const Range &r ) const
+    {
+        for (int c=r.start; c<r.end; c++)
+            erGroupingNMChannel(grey, lab, src, regions, (size_t)c, groups[c], boxes[c], do_feedback_loop);
+    }
+
+private:
+    Mat &grey;
+    Mat &lab;
+    vector<Mat> &src;
+    vector< vector<ERStat> > &regions;
+    vector< vector< vector<Vec2i> > > &groups;
+    vector< vector<Rect> > &boxes;
+    bool do_feedback_loop;
+
+    ERGroupingNMInvoker & operator=(const ERGroupingNMInvoker&); // to quiet MSVC
+};
 
+void erGroupingNM(InputArray _img, InputArrayOfArrays _src, vector< vector<ERStat> >& regions,
+                  vector< vector<Vec2i> >& out_groups, vector<Rect>& out_boxes, bool do_feedback_loop)
+{
+
+    vector<Mat> src;
+    _src.getMatVector(src);
+
+    CV_Assert ( !src.empty() );
+    //CV_Assert ( src.size() == regions.size() );
+    size_t num_channels = src.size();
+
+    Mat img = _img.getMat();
+
+    Mat grey,lab;
+    cvtColor(img, lab, COLOR_RGB2Lab);
+    cvtColor(img, grey, COLOR_RGB2GRAY);
+
+    //process each channel independently, the groups are appended in the order of the channels
+    vector< vector< vector<Vec2i> > > channel_groups(num_channels);
+    vector< vector<Rect> > channel_boxes(num_channels);
+    parallel_for_(Range(0, (int)num_channels),
+                  ERGroupingNMInvoker(grey, lab, src, regions, channel_groups, channel_boxes, do_feedback_loop));
+
+    for (size_t c=0; c<num_channels; c++)
+    {
+        out_groups.insert(out_groups.end(), channel_groups[c].begin(), channel_groups[c].end());
+        out_boxes.insert(out_boxes.end(), channel_boxes[c].begin(), channel_boxes[c].end());
+    }
 }
 
 void erGrouping(InputArray image, InputArrayOfArrays channels, vector<vector<ERStat> > &regions,  vector<vector<Vec2i> > &groups,  vector<Rect> &groups_rects, int method, const string& filename, float minProbability)
@@ -4184,6 +4368,69 @@ void MSERsToERStats(InputArray image, vector<vector<Point> > &contours, vector<v
 }
 
 // Utility funtion for scripting
+// ParallelLoopBody running the filters on a range of channels, each one with its own copy of the
+// filters so that the component trees and the state of the filters are not shared
+class ERFiltersInvoker : public ParallelLoopBody
+{
+public:
+    ERFiltersInvoker(const vector<Mat>& _channels, const ERFilterNM* _er_filter1,
+                     const ERFilterNM* _er_filter2, vector< vector<ERStat> >& _regions)
+        : channels(_channels), er_filter1(_er_filter1), er_filter2(_er_filter2), regions(_regions) {}
+
+    void operator()(const Range& range) const
+    {
+        for (int c = range.start; c < range.end; c++)
+        {
+            ERFilterNM filter1(*er_filter1);
+            filter1.run(channels[c], regions[c]);
+            if (er_filter2)
+            {
+                ERFilterNM filter2(*er_filter2);
+                filter2.run(channels[c], regions[c]);
+            }
+        }
+    }
+
+private:
+    ERFiltersInvoker& operator=(const ERFiltersInvoker&); // to quiet MSVC
+
+    const vector<Mat>& channels;
+    const ERFilterNM* er_filter1;
+    const ERFilterNM* er_filter2;
+    vector< vector<ERStat> >& regions;
+};
+
+void runERFilters(InputArrayOfArrays _channels, const Ptr<ERFilter>& er_filter1,
+                  const Ptr<ERFilter>& er_filter2, vector< vector<ERStat> >& regions)
+{
+    // at least one ERFilter must be passed
+    CV_Assert( !er_filter1.empty() );
+
+    vector<Mat> channels;
+    _channels.getMatVector(channels);
+    for (size_t c = 0; c < channels.size(); c++)
+        CV_Assert( channels[c].type() == CV_8UC1 );
+
+    regions.clear();
+    regions.resize(channels.size());
+
+    const ERFilterNM* filter1 = dynamic_cast<const ERFilterNM*>(er_filter1.get());
+    const ERFilterNM* filter2 = er_filter2.empty() ? NULL : dynamic_cast<const ERFilterNM*>(er_filter2.get());
+    if (filter1 && (er_filter2.empty() || filter2))
+    {
+        parallel_for_(Range(0, (int)channels.size()), ERFiltersInvoker(channels, filter1, filter2, regions));
+        return;
+    }
+
+    // unknown filters cannot be copied
+    for (size_t c = 0; c < channels.size(); c++)
+    {
+        er_filter1->run(channels[c], regions[c]);
+        if (!er_filter2.empty())
+            er_filter2->run(channels[c], regions[c]);
+    }
+}
+
 void detectRegions(InputArray image, const Ptr<ERFilter>& er_filter1, const Ptr<ERFilter>& er_filter2, CV_OUT vector< vector<Point> >& regions)
 {
     // assert correct image type
@@ -144,12 +144,13 @@ struct beamSearch_node {
     double score;
     vector<int> segmentation;
     bool expanded;
-    // TODO calculating score of its childs would be much faster if we store the last column
-    //      of their "root" path.
+    // last column of the Viterbi trellis of the segmentation, the score of the childs is computed
+    // from it with a single step. It is empty if the segmentation was discarded by the heuristics.
+    vector<double> viterbi;
 };
 
-bool beam_sort_function ( beamSearch_node a, beamSearch_node b );
-bool beam_sort_function ( beamSearch_node a, beamSearch_node b )
+bool beam_sort_function ( const beamSearch_node& a, const beamSearch_node& b );
+bool beam_sort_function ( const beamSearch_node& a, const beamSearch_node& b )
 {
     return (a.score > b.score);
 }
@@ -184,6 +185,17 @@ public:
                     transition_p.at<double>(i,j) = log(transition_p.at<double>(i,j));
             }
         }
+
+        // the possible transitions to each character, the table is sparse when it comes from a lexicon
+        transitions_to.resize(transition_p.cols);
+        for (int i=0; i<transition_p.cols; i++)
+        {
+            for (int j=0; j<transition_p.rows; j++)
+            {
+                if (transition_p.at<double>(j,i) != -DBL_MAX)
+                    transitions_to[i].push_back(j);
+            }
+        }
     }
 
     ~OCRBeamSearchDecoderImpl()
@@ -293,25 +305,27 @@ public:
         }
 
         // initialize the beam with all possible character's pairs
+        beam.clear();
         int generated_chids = 0;
+        vector<double> start_viterbi;
         for (size_t i=0; i<recognition_probabilities.size()-1; i++)
         {
+          viterbi_start((int)i, start_viterbi);
           for (size_t j=i+1; j<recognition_probabilities.size(); j++)
           {
 
             beamSearch_node node;
             node.segmentation.push_back((int)i);
             node.segmentation.push_back((int)j);
-            node.score = score_segmentation(node.segmentation, out_sequence);
-            vector< vector<int> > childs = generate_childs( node.segmentation );
+            if (viterbi_step(start_viterbi, (int)i, (int)j, node.viterbi))
+              node.score = viterbi_score(node.viterbi, node.segmentation.size());
+            else
+              node.score = -DBL_MAX;
             node.expanded = true;
 
-            beam.push_back( node );
+            insert_node( node );
 
-            if (!childs.empty())
-              update_beam( childs );
-
-            generated_chids += (int)childs.size();
+            generated_chids += update_beam( node );
 
           }
         }
@@ -322,15 +336,13 @@ public:
 
             for (size_t i=0; i<beam.size(); i++)
             {
-                vector< vector<int> > childs;
                 if (!beam[i].expanded)
                 {
-                  childs = generate_childs( beam[i].segmentation );
                   beam[i].expanded = true;
+                  // the beam changes while the childs are inserted
+                  beamSearch_node node = beam[i];
+                  generated_chids += update_beam( node );
                 }
-                if (!childs.empty())
-                    update_beam( childs );
-                generated_chids += (int)childs.size();
             }
         }
 
@@ -353,50 +365,97 @@ private:
     vector< vector<double> > recognition_probabilities;
     vector<int> oversegmentation;
 
-    vector< vector<int> > generate_childs( vector<int> &segmentation )
+    // the possible transitions to each character
+    vector< vector<int> > transitions_to;
+
+    // inserts a node in the beam keeping it sorted by score and not larger than beam_size
+    void insert_node( const beamSearch_node &node )
+    {
+        beam.insert(upper_bound(beam.begin(), beam.end(), node, beam_sort_function), node);
+        if ((int)beam.size() > beam_size)
+            beam.pop_back();
+    }
+
+    // scores the childs of a node (the segmentations with one more point) and inserts those that
+    // fit into the beam, returns the number of childs
+    int update_beam( const beamSearch_node &node )
     {
+        int last_point = node.segmentation.back();
+        int num_childs = (int)oversegmentation.size() - last_point - 1;
 
-        vector< vector<int> > childs;
-        for (size_t i=segmentation[segmentation.size()-1]+1; i<oversegmentation.size(); i++)
+        beamSearch_node child;
+        child.expanded = false;
+        for (int seg_point=last_point+1; seg_point<(int)oversegmentation.size(); seg_point++)
         {
-            int seg_point = (int)i;
-            if (find(segmentation.begin(), segmentation.end(), seg_point) == segmentation.end())
+            double min_score = -DBL_MAX; //min score value to be part of the beam
+            if ((int)beam.size() >= beam_size)
+                min_score = beam.back().score; //last element has the lowest score
+
+            // a child of a discarded segmentation is also discarded
+            if (node.viterbi.empty() || !viterbi_step(node.viterbi, last_point, seg_point, child.viterbi))
+                continue;
+
+            double score = viterbi_score(child.viterbi, node.segmentation.size()+1);
+            if (score > min_score)
             {
-                vector<int> child = segmentation;
-                child.push_back(seg_point);
-                childs.push_back(child);
+                child.score = score;
+                child.segmentation = node.segmentation;
+                child.segmentation.push_back(seg_point);
+                insert_node(child);
             }
         }
-        return childs;
+        return num_childs;
     }
 
-    void update_beam ( vector< vector<int> > &childs )
+    // first column of the Viterbi trellis of a segmentation starting at seg_point
+    void viterbi_start( int seg_point, vector<double> &viterbi )
     {
-        string out_sequence;
-        double min_score = -DBL_MAX; //min score value to be part of the beam
-        if ((int)beam.size() >= beam_size)
-            min_score = beam[beam_size-1].score; //last element has the lowest score
+        viterbi.resize(vocabulary.size());
+        for (int i=0; i<(int)vocabulary.size(); i++)
+            viterbi[i] = log(1.0/vocabulary.size()) + recognition_probabilities[seg_point][i];
+    }
+
+    // computes the next column of the Viterbi trellis when seg_point follows prev_point, the same score
+    // heuristics of score_segmentation are applied to the new pair and false is returned if it is discarded
+    bool viterbi_step( const vector<double> &prev_viterbi, int prev_point, int seg_point, vector<double> &viterbi )
+    {
+        float interdist = (float)oversegmentation[seg_point]*step_size
+                          - (float)oversegmentation[prev_point]*step_size;
+        if ((interdist/win_size > 2.25) || (interdist/win_size < 0.15))
+            return false;
 
-        for (size_t i=0; i<childs.size(); i++)
+        const vector<double> &rec_p = recognition_probabilities[seg_point];
+        viterbi.resize(vocabulary.size());
+        for (int i=0; i<(int)vocabulary.size(); i++)
         {
-            double score = score_segmentation(childs[i], out_sequence);
-            if (score > min_score)
+            // the impossible transitions and previous states can not improve on -DBL_MAX
+            double max_prob = -DBL_MAX;
+            const vector<int> &from = transitions_to[i];
+            for (size_t k=0; k<from.size(); k++)
             {
-                beamSearch_node node;
-                node.score = score;
-                node.segmentation = childs[i];
-                node.expanded = false;
-                beam.push_back(node);
-                sort(beam.begin(),beam.end(),beam_sort_function);
-                if ((int)beam.size() > beam_size)
-                {
-                    beam.erase(beam.begin()+beam_size,beam.end());
-                    min_score = beam[beam.size()-1].score;
-                }
+                int j = from[k];
+                if (prev_viterbi[j] == -DBL_MAX)
+                    continue;
+                double prob = prev_viterbi[j] + transition_p.at<double>(j,i) + rec_p[i];
+                if (prob > max_prob)
+                    max_prob = prob;
             }
+            viterbi[i] = max_prob;
         }
+        return true;
     }
 
+    // score of a segmentation of the given length from the last column of its Viterbi trellis
+    double viterbi_score( const vector<double> &viterbi, size_t length )
+    {
+        double max_prob = -DBL_MAX;
+        for (size_t i=0; i<viterbi.size(); i++)
+        {
+            if (viterbi[i] > max_prob)
+                max_prob = viterbi[i];
+        }
+        return (max_prob / (length-1));
+    }
 
     double score_segmentation( vector<int> &segmentation, string& outstring )
     {
@@ -510,6 +569,9 @@ CV_EXPORTS_W Ptr<OCRBeamSearchDecoder> OCRBeamSearchDecoder::create(Ptr<OCRBeamS
 }
 
 
+// the pools of the 9xD representation to which each of the 25 quads contributes, one bit per pool
+static const int quad_pools[25] = { 0x1, 0x3, 0x2, 0x6, 0x4, 0x9, 0x1b, 0x12, 0x36, 0x24, 0x8, 0x18, 0x10, 0x30, 0x20, 0x48, 0xd8, 0x90, 0x1b0, 0x120, 0x40, 0xc0, 0x80, 0x180, 0x100 };
+
 class CV_EXPORTS OCRBeamSearchClassifierCNN : public OCRBeamSearchDecoder::ClassifierCallback
 {
 public:
@@ -526,7 +588,10 @@ public:
 
 protected:
     void normalizeAndZCA(Mat& patches);
-    double eval_feature(Mat& feature, double* prob_estimates);
+    void extractPatches(const Mat& img, Mat& patches);
+    void computeResponses(Mat& patches, Mat& responses);
+    void poolResponses(const Mat& responses, int patches_x, int x, Mat& feature);
+    void eval_features(Mat& features, Mat& prob_estimates, vector<int>& labels);
 
 private:
     int window_size; // window size
@@ -596,108 +661,96 @@ void OCRBeamSearchClassifierCNN::eval( InputArray _src, vector< vector<double> >
 
     resize(src,src,Size(window_size*src.cols/src.rows,window_size));
 
-    int seg_points = 0;
+    if (src.cols < window_size)
+        return;
+
+    // the detection windows overlap, so the responses of all the patches of the line are computed
+    // once and shared by the windows
+    int patches_x = src.cols-patch_size+1;
+    Mat patches(patches_x*(window_size-patch_size+1), kernels.cols, CV_64FC1);
+    extractPatches(src, patches);
 
-    Mat quad;
-    Mat tmp;
-    Mat img;
+    Mat responses;
+    computeResponses(patches, responses);
 
-    // begin sliding window loop foreach detection window
-    for (int x_c=0; x_c<=src.cols-window_size; x_c=x_c+step_size)
+    // sliding window loop foreach detection window
+    int num_windows = (src.cols-window_size)/step_size+1;
+    Mat features = Mat::zeros(num_windows,9*kernels.rows,CV_64FC1);
+    for (int w=0; w<num_windows; w++)
     {
+        Mat feature = features.row(w);
+        poolResponses(responses, patches_x, w*step_size, feature);
+    }
 
-        img = src(Rect(Point(x_c,0),Size(window_size,window_size)));
+    Mat p;
+    vector<int> predict_labels;
+    eval_features(features, p, predict_labels);
 
-        int patch_count = 0;
-        vector< vector<double> > data_pool(9);
+    for (int w=0; w<num_windows; w++)
+    {
+        vector<double> recognition_p(p.ptr<double>(w), p.ptr<double>(w)+nr_class);
+        recognition_probabilities.push_back(recognition_p);
+        oversegmentation.push_back(w);
+    }
 
+}
 
-        int quad_id = 1;
-        for (int q_x=0; q_x<=window_size-quad_size; q_x=q_x+(quad_size/2-1))
+// stores each patch of img (patch_size x patch_size) as a row of patches,
+// the rows are in row-major order of the patch positions
+void OCRBeamSearchClassifierCNN::extractPatches(const Mat& img, Mat& patches)
+{
+    int patches_x = img.cols-patch_size+1;
+    for (int y=0; y<=img.rows-patch_size; y++)
+    {
+        for (int x=0; x<patches_x; x++)
         {
-            for (int q_y=0; q_y<=window_size-quad_size; q_y=q_y+(quad_size/2-1))
+            double* patch = patches.ptr<double>(y*patches_x+x);
+            for (int r=0; r<patch_size; r++)
             {
-                Rect quad_rect = Rect(q_x,q_y,quad_size,quad_size);
-                quad = img(quad_rect);
-
-                //start sliding window (8x8) in each tile and store the patch as row in data_pool
-                for (int w_x=0; w_x<=quad_size-patch_size; w_x++)
-                {
-                    for (int w_y=0; w_y<=quad_size-patch_size; w_y++)
-                    {
-                        quad(Rect(w_x,w_y,patch_size,patch_size)).copyTo(tmp);
-                        tmp = tmp.reshape(0,1);
-                        tmp.convertTo(tmp, CV_64F);
-                        normalizeAndZCA(tmp);
-                        vector<double> patch;
-                        tmp.copyTo(patch);
-                        if ((quad_id == 1)||(quad_id == 2)||(quad_id == 6)||(quad_id == 7))
-                            data_pool[0].insert(data_pool[0].end(),patch.begin(),patch.end());
-                        if ((quad_id == 2)||(quad_id == 7)||(quad_id == 3)||(quad_id == 8)||(quad_id == 4)||(quad_id == 9))
-                            data_pool[1].insert(data_pool[1].end(),patch.begin(),patch.end());
-                        if ((quad_id == 4)||(quad_id == 9)||(quad_id == 5)||(quad_id == 10))
-                            data_pool[2].insert(data_pool[2].end(),patch.begin(),patch.end());
-                        if ((quad_id == 6)||(quad_id == 11)||(quad_id == 16)||(quad_id == 7)||(quad_id == 12)||(quad_id == 17))
-                            data_pool[3].insert(data_pool[3].end(),patch.begin(),patch.end());
-                        if ((quad_id == 7)||(quad_id == 12)||(quad_id == 17)||(quad_id == 8)||(quad_id == 13)||(quad_id == 18)||(quad_id == 9)||(quad_id == 14)||(quad_id == 19))
-                            data_pool[4].insert(data_pool[4].end(),patch.begin(),patch.end());
-                        if ((quad_id == 9)||(quad_id == 14)||(quad_id == 19)||(quad_id == 10)||(quad_id == 15)||(quad_id == 20))
-                            data_pool[5].insert(data_pool[5].end(),patch.begin(),patch.end());
-                        if ((quad_id == 16)||(quad_id == 21)||(quad_id == 17)||(quad_id == 22))
-                            data_pool[6].insert(data_pool[6].end(),patch.begin(),patch.end());
-                        if ((quad_id == 17)||(quad_id == 22)||(quad_id == 18)||(quad_id == 23)||(quad_id == 19)||(quad_id == 24))
-                            data_pool[7].insert(data_pool[7].end(),patch.begin(),patch.end());
-                        if ((quad_id == 19)||(quad_id == 24)||(quad_id == 20)||(quad_id == 25))
-                            data_pool[8].insert(data_pool[8].end(),patch.begin(),patch.end());
-                        patch_count++;
-                    }
-                }
-
-                quad_id++;
+                const uchar* src = img.ptr<uchar>(y+r)+x;
+                for (int c=0; c<patch_size; c++)
+                    *patch++ = src[c];
             }
         }
+    }
+}
+
+// normalizes and whitens the patches and applies the kernels bank to all of them as a single GEMM,
+// followed by the non-linear activation function z = max(0, |D*a| - alpha)
+void OCRBeamSearchClassifierCNN::computeResponses(Mat& patches, Mat& responses)
+{
+    normalizeAndZCA(patches);
+    gemm(patches, kernels, 1, noArray(), 0, responses, GEMM_2_T);
+    responses = cv::abs(responses) - alpha;
+    responses = cv::max(responses, 0.0);
+}
 
-        //do dot product of each normalized and whitened patch
-        //each pool is averaged and this yields a representation of 9xD
-        Mat feature = Mat::zeros(9,kernels.rows,CV_64FC1);
-        for (int i=0; i<9; i++)
+// sums the responses of the patches of each quad of the window starting at column x into the 9 pools
+// of the quad, this yields a representation of 9xD stored in feature
+void OCRBeamSearchClassifierCNN::poolResponses(const Mat& responses, int patches_x, int x, Mat& feature)
+{
+    Mat quad_sum(1, kernels.rows, CV_64FC1);
+    int quad_id = 0;
+    for (int q_x=0; q_x<=window_size-quad_size; q_x=q_x+(quad_size/2-1))
+    {
+        for (int q_y=0; q_y<=window_size-quad_size; q_y=q_y+(quad_size/2-1))
         {
-            Mat pool = Mat(data_pool[i]);
-            pool = pool.reshape(0,(int)data_pool[i].size()/kernels.cols);
-            for (int p=0; p<pool.rows; p++)
+            quad_sum = Scalar(0);
+            for (int w_x=0; w_x<=quad_size-patch_size; w_x++)
+                for (int w_y=0; w_y<=quad_size-patch_size; w_y++)
+                    quad_sum += responses.row((q_y+w_y)*patches_x+x+q_x+w_x);
+
+            for (int i=0; i<9; i++)
             {
-                for (int f=0; f<kernels.rows; f++)
+                if (quad_pools[quad_id] & (1<<i))
                 {
-                    feature.row(i).at<double>(0,f) = feature.row(i).at<double>(0,f) + max(0.0,std::abs(pool.row(p).dot(kernels.row(f)))-alpha);
+                    Mat pool = feature.colRange(i*kernels.rows,(i+1)*kernels.rows);
+                    pool += quad_sum;
                 }
             }
+            quad_id++;
         }
-        feature = feature.reshape(0,1);
-
-
-        // data must be normalized within the range obtained during training
-        double lower = -1.0;
-        double upper =  1.0;
-        for (int k=0; k<feature.cols; k++)
-        {
-            feature.at<double>(0,k) = lower + (upper-lower) *
-                    (feature.at<double>(0,k)-feature_min.at<double>(0,k))/
-                    (feature_max.at<double>(0,k)-feature_min.at<double>(0,k));
-        }
-
-        double *p = new double[nr_class];
-        double predict_label = eval_feature(feature,p);
-
-        if ( (predict_label < 0) || (predict_label > nr_class) )
-            CV_Error(Error::StsOutOfRange, "OCRBeamSearchClassifierCNN::eval Error: unexpected prediction in eval_feature()");
-
-
-        vector<double> recognition_p(p, p+nr_class);
-        recognition_probabilities.push_back(recognition_p);
-        oversegmentation.push_back(seg_points);
-        seg_points++;
     }
-
 }
 
 // normalize for contrast and apply ZCA whitening to a set of image patches
@@ -747,33 +800,51 @@ void OCRBeamSearchClassifierCNN::normalizeAndZCA(Mat& patches)
 
 }
 
-double OCRBeamSearchClassifierCNN::eval_feature(Mat& feature, double* prob_estimates)
+// scales each row of features and evaluates the Logistic Regression on it, prob_estimates has one row
+// of class probabilities per feature and labels the most probable class of each one
+void OCRBeamSearchClassifierCNN::eval_features(Mat& features, Mat& prob_estimates, vector<int>& labels)
 {
-    for(int i=0;i<nr_class;i++)
-        prob_estimates[i] = 0;
+    // data must be normalized within the range obtained during training
+    double lower = -1.0;
+    double upper =  1.0;
+    for (int n=0; n<features.rows; n++)
+    {
+        double* feature = features.ptr<double>(n);
+        for (int k=0; k<features.cols; k++)
+        {
+            feature[k] = lower + (upper-lower) *
+                    (feature[k]-feature_min.at<double>(0,k))/
+                    (feature_max.at<double>(0,k)-feature_min.at<double>(0,k));
+        }
+    }
 
-    for(int idx=0; idx<nr_feature; idx++)
-        for(int i=0;i<nr_class;i++)
-            prob_estimates[i] += weights.at<float>(idx,i)*feature.at<double>(0,idx); //TODO use vectorized dot product
+    Mat weights_d;
+    weights.convertTo(weights_d, CV_64F);
+    prob_estimates = features*weights_d;
 
-    int dec_max_idx = 0;
-    for(int i=1;i<nr_class;i++)
+    labels.resize(prob_estimates.rows);
+    for (int n=0; n<prob_estimates.rows; n++)
     {
-        if(prob_estimates[i] > prob_estimates[dec_max_idx])
-            dec_max_idx = i;
-    }
+        double* p = prob_estimates.ptr<double>(n);
 
-    for(int i=0;i<nr_class;i++)
-        prob_estimates[i]=1/(1+exp(-prob_estimates[i]));
+        int dec_max_idx = 0;
+        for(int i=1;i<nr_class;i++)
+        {
+            if(p[i] > p[dec_max_idx])
+                dec_max_idx = i;
+        }
+        labels[n] = dec_max_idx;
 
-    double sum=0;
-    for(int i=0; i<nr_class; i++)
-        sum+=prob_estimates[i];
+        for(int i=0;i<nr_class;i++)
+            p[i]=1/(1+exp(-p[i]));
 
-    for(int i=0; i<nr_class; i++)
-        prob_estimates[i]=prob_estimates[i]/sum;
+        double sum=0;
+        for(int i=0; i<nr_class; i++)
+            sum+=p[i];
 
-    return dec_max_idx;
+        for(int i=0; i<nr_class; i++)
+            p[i]=p[i]/sum;
+    }
 }
 
 Ptr<OCRBeamSearchDecoder::ClassifierCallback> loadOCRBeamSearchClassifierCNN(const String& filename)
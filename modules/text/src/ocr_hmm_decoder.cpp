@@ -137,6 +137,17 @@ void OCRHMMDecoder::ClassifierCallback::eval( InputArray image, vector<int>& out
     out_confidence.clear();
 }
 
+void OCRHMMDecoder::ClassifierCallback::evalBatch( InputArrayOfArrays _images, vector< vector<int> >& out_classes,
+                                                   vector< vector<double> >& out_confidences )
+{
+    vector<Mat> images;
+    _images.getMatVector(images);
+    out_classes.resize(images.size());
+    out_confidences.resize(images.size());
+    for (size_t i=0; i<images.size(); i++)
+        eval(images[i], out_classes[i], out_confidences[i]);
+}
+
 
 bool sort_rect_horiz (Rect a,Rect b);
 bool sort_rect_horiz (Rect a,Rect b) { return (a.x<b.x); }
@@ -306,20 +317,17 @@ public:
 
             sort(contours_rect.begin(), contours_rect.end(), sort_rect_horiz);
 
-            // Do character recognition foreach contour
+            // Do character recognition of all the contours at once
+            vector<Mat> chars_mask(contours.size());
             for (int i=0; i<(int)contours.size(); i++)
+                words_mask[w](contours_rect.at(i)).copyTo(chars_mask[i]);
+
+            classifier->evalBatch(chars_mask,observations,confidences);
+            for (int i=0; i<(int)observations.size(); i++)
             {
-                Mat tmp_mask;
-                words_mask[w](contours_rect.at(i)).copyTo(tmp_mask);
-
-                vector<int> out_class;
-                vector<double> out_conf;
-                classifier->eval(tmp_mask,out_class,out_conf);
-                if (!out_class.empty())
-                    obs.push_back(out_class[0]);
-                observations.push_back(out_class);
-                confidences.push_back(out_conf);
-                //cout << " out class = " << vocabulary[out_class[0]] << endl;
+                if (!observations[i].empty())
+                    obs.push_back(observations[i][0]);
+                //cout << " out class = " << vocabulary[observations[i][0]] << endl;
             }
 
 
@@ -554,11 +562,10 @@ public:
 
             sort(contours_rect.begin(), contours_rect.end(), sort_rect_horiz);
 
-            // Do character recognition foreach contour
+            // Do character recognition of all the contours at once
+            vector<Mat> chars_image(contours.size());
             for (int i=0; i<(int)contours.size(); i++)
             {
-                vector<int> out_class;
-                vector<double> out_conf;
                 //take the center of the char rect and translate it to the real origin
                 Point char_center = Point(contours_rect.at(i).x+contours_rect.at(i).width/2,
                                           contours_rect.at(i).y+contours_rect.at(i).height/2);
@@ -568,15 +575,15 @@ public:
                 win_size += (int)(win_size*0.6); // add some pixels in the border TODO: is this a parameter for the user space?
                 Rect char_rect = Rect(char_center.x-win_size/2,char_center.y-win_size/2,win_size,win_size);
                 char_rect &= Rect(0,0,image.cols,image.rows);
-                Mat tmp_image;
-                image(char_rect).copyTo(tmp_image);
-
-                classifier->eval(tmp_image,out_class,out_conf);
-                if (!out_class.empty())
-                    obs.push_back(out_class[0]);
-                //cout << " out class = " << vocabulary[out_class[0]] << "(" << out_conf[0] << ")" << endl;
-                observations.push_back(out_class);
-                confidences.push_back(out_conf);
+                image(char_rect).copyTo(chars_image[i]);
+            }
+
+            classifier->evalBatch(chars_image,observations,confidences);
+            for (int i=0; i<(int)observations.size(); i++)
+            {
+                if (!observations[i].empty())
+                    obs.push_back(observations[i][0]);
+                //cout << " out class = " << vocabulary[observations[i][0]] << "(" << confidences[i][0] << ")" << endl;
             }
 
 
@@ -923,6 +930,9 @@ Ptr<OCRHMMDecoder::ClassifierCallback> loadOCRHMMClassifierNM(const String& file
     return makePtr<OCRHMMClassifierKNN>(std::string(filename));
 }
 
+// the pools of the 9xD representation to which each of the 25 quads contributes, one bit per pool
+static const int quad_pools[25] = { 0x1, 0x3, 0x2, 0x6, 0x4, 0x9, 0x1b, 0x12, 0x36, 0x24, 0x8, 0x18, 0x10, 0x30, 0x20, 0x48, 0xd8, 0x90, 0x1b0, 0x120, 0x40, 0xc0, 0x80, 0x180, 0x100 };
+
 class CV_EXPORTS OCRHMMClassifierCNN : public OCRHMMDecoder::ClassifierCallback
 {
 public:
@@ -932,10 +942,14 @@ public:
     ~OCRHMMClassifierCNN() {}
 
     void eval( InputArray image, vector<int>& out_class, vector<double>& out_confidence );
+    void evalBatch( InputArrayOfArrays images, vector< vector<int> >& out_classes, vector< vector<double> >& out_confidences );
 
 protected:
     void normalizeAndZCA(Mat& patches);
-    double eval_feature(Mat& feature, double* prob_estimates);
+    void extractPatches(const Mat& img, Mat& patches);
+    void computeResponses(Mat& patches, Mat& responses);
+    void poolResponses(const Mat& responses, int patches_x, int x, Mat& feature);
+    void eval_features(Mat& features, Mat& prob_estimates, vector<int>& labels);
 
 private:
     int nr_class;		 // number of classes
@@ -993,121 +1007,135 @@ OCRHMMClassifierCNN::OCRHMMClassifierCNN (const string& filename)
 
 void OCRHMMClassifierCNN::eval( InputArray _src, vector<int>& out_class, vector<double>& out_confidence )
 {
+    vector<Mat> images(1, _src.getMat());
+    vector< vector<int> > out_classes;
+    vector< vector<double> > out_confidences;
+    evalBatch(images, out_classes, out_confidences);
 
-    CV_Assert(( _src.getMat().type() == CV_8UC3 ) || ( _src.getMat().type() == CV_8UC1 ));
+    out_class.swap(out_classes[0]);
+    out_confidence.swap(out_confidences[0]);
+}
 
-    out_class.clear();
-    out_confidence.clear();
+// the patches of all the images are whitened and convolved together, and the Logistic Regression
+// is evaluated on the features of all the images at once
+void OCRHMMClassifierCNN::evalBatch( InputArrayOfArrays _images, vector< vector<int> >& out_classes, vector< vector<double> >& out_confidences )
+{
+    vector<Mat> images;
+    _images.getMatVector(images);
+    int num_images = (int)images.size();
 
+    out_classes.assign(num_images, vector<int>());
+    out_confidences.assign(num_images, vector<double>());
+    if (num_images == 0)
+        return;
 
-    Mat img = _src.getMat();
-    if(img.type() == CV_8UC3)
+    int patches_x = window_size-patch_size+1;
+    int num_patches = patches_x*patches_x;
+    Mat patches(num_images*num_patches, kernels.cols, CV_64FC1);
+    for (int n=0; n<num_images; n++)
     {
-        cvtColor(img,img,COLOR_RGB2GRAY);
-    }
+        CV_Assert(( images[n].type() == CV_8UC3 ) || ( images[n].type() == CV_8UC1 ));
 
-    // shall we resize the input image or make a copy ?
-    resize(img,img,Size(window_size,window_size));
+        Mat img = images[n];
+        if(img.type() == CV_8UC3)
+        {
+            cvtColor(img,img,COLOR_RGB2GRAY);
+        }
 
-    Mat quad;
-    Mat tmp;
+        Mat resized;
+        resize(img,resized,Size(window_size,window_size));
 
-    int patch_count = 0;
-    vector< vector<double> > data_pool(9);
+        Mat image_patches = patches.rowRange(n*num_patches,(n+1)*num_patches);
+        extractPatches(resized, image_patches);
+    }
 
+    Mat responses;
+    computeResponses(patches, responses);
 
-    int quad_id = 1;
-    for (int q_x=0; q_x<=window_size-quad_size; q_x=q_x+(int)(quad_size/2-1))
+    Mat features = Mat::zeros(num_images,9*kernels.rows,CV_64FC1);
+    for (int n=0; n<num_images; n++)
     {
-        for (int q_y=0; q_y<=window_size-quad_size; q_y=q_y+(int)(quad_size/2-1))
-        {
-            Rect quad_rect = Rect(q_x,q_y,quad_size,quad_size);
-            quad = img(quad_rect);
+        Mat feature = features.row(n);
+        poolResponses(responses.rowRange(n*num_patches,(n+1)*num_patches), patches_x, 0, feature);
+    }
 
-            //start sliding window (8x8) in each tile and store the patch as row in data_pool
-            for (int w_x=0; w_x<=quad_size-patch_size; w_x++)
-            {
-                for (int w_y=0; w_y<=quad_size-patch_size; w_y++)
-                {
-                    quad(Rect(w_x,w_y,patch_size,patch_size)).copyTo(tmp);
-                    tmp = tmp.reshape(0,1);
-                    tmp.convertTo(tmp, CV_64F);
-                    normalizeAndZCA(tmp);
-                    vector<double> patch;
-                    tmp.copyTo(patch);
-                    if ((quad_id == 1)||(quad_id == 2)||(quad_id == 6)||(quad_id == 7))
-                        data_pool[0].insert(data_pool[0].end(),patch.begin(),patch.end());
-                    if ((quad_id == 2)||(quad_id == 7)||(quad_id == 3)||(quad_id == 8)||(quad_id == 4)||(quad_id == 9))
-                        data_pool[1].insert(data_pool[1].end(),patch.begin(),patch.end());
-                    if ((quad_id == 4)||(quad_id == 9)||(quad_id == 5)||(quad_id == 10))
-                        data_pool[2].insert(data_pool[2].end(),patch.begin(),patch.end());
-                    if ((quad_id == 6)||(quad_id == 11)||(quad_id == 16)||(quad_id == 7)||(quad_id == 12)||(quad_id == 17))
-                        data_pool[3].insert(data_pool[3].end(),patch.begin(),patch.end());
-                    if ((quad_id == 7)||(quad_id == 12)||(quad_id == 17)||(quad_id == 8)||(quad_id == 13)||(quad_id == 18)||(quad_id == 9)||(quad_id == 14)||(quad_id == 19))
-                        data_pool[4].insert(data_pool[4].end(),patch.begin(),patch.end());
-                    if ((quad_id == 9)||(quad_id == 14)||(quad_id == 19)||(quad_id == 10)||(quad_id == 15)||(quad_id == 20))
-                        data_pool[5].insert(data_pool[5].end(),patch.begin(),patch.end());
-                    if ((quad_id == 16)||(quad_id == 21)||(quad_id == 17)||(quad_id == 22))
-                        data_pool[6].insert(data_pool[6].end(),patch.begin(),patch.end());
-                    if ((quad_id == 17)||(quad_id == 22)||(quad_id == 18)||(quad_id == 23)||(quad_id == 19)||(quad_id == 24))
-                        data_pool[7].insert(data_pool[7].end(),patch.begin(),patch.end());
-                    if ((quad_id == 19)||(quad_id == 24)||(quad_id == 20)||(quad_id == 25))
-                        data_pool[8].insert(data_pool[8].end(),patch.begin(),patch.end());
-                    patch_count++;
-                }
-            }
+    Mat p;
+    vector<int> predict_labels;
+    eval_features(features, p, predict_labels);
 
-            quad_id++;
+    for (int n=0; n<num_images; n++)
+    {
+        int predict_label = predict_labels[n];
+        out_classes[n].push_back(predict_label);
+        out_confidences[n].push_back(p.at<double>(n,predict_label));
+
+        for (int i = 0; i<nr_class; i++)
+        {
+          if ( (i != predict_label) && (p.at<double>(n,i) != 0.) )
+          {
+            out_classes[n].push_back(i);
+            out_confidences[n].push_back(p.at<double>(n,i));
+          }
         }
     }
+}
 
-    //do dot product of each normalized and whitened patch
-    //each pool is averaged and this yields a representation of 9xD
-    Mat feature = Mat::zeros(9,kernels.rows,CV_64FC1);
-    for (int i=0; i<9; i++)
+// stores each patch of img (patch_size x patch_size) as a row of patches,
+// the rows are in row-major order of the patch positions
+void OCRHMMClassifierCNN::extractPatches(const Mat& img, Mat& patches)
+{
+    int patches_x = img.cols-patch_size+1;
+    for (int y=0; y<=img.rows-patch_size; y++)
     {
-        Mat pool = Mat(data_pool[i]);
-        pool = pool.reshape(0,(int)data_pool[i].size()/kernels.cols);
-        for (int p=0; p<pool.rows; p++)
+        for (int x=0; x<patches_x; x++)
         {
-            for (int f=0; f<kernels.rows; f++)
+            double* patch = patches.ptr<double>(y*patches_x+x);
+            for (int r=0; r<patch_size; r++)
             {
-                feature.row(i).at<double>(0,f) = feature.row(i).at<double>(0,f) + max(0.0,std::abs(pool.row(p).dot(kernels.row(f)))-alpha);
+                const uchar* src = img.ptr<uchar>(y+r)+x;
+                for (int c=0; c<patch_size; c++)
+                    *patch++ = src[c];
             }
         }
     }
-    feature = feature.reshape(0,1);
+}
 
+// normalizes and whitens the patches and applies the kernels bank to all of them as a single GEMM,
+// followed by the non-linear activation function z = max(0, |D*a| - alpha)
+void OCRHMMClassifierCNN::computeResponses(Mat& patches, Mat& responses)
+{
+    normalizeAndZCA(patches);
+    gemm(patches, kernels, 1, noArray(), 0, responses, GEMM_2_T);
+    responses = cv::abs(responses) - alpha;
+    responses = cv::max(responses, 0.0);
+}
 
-    // data must be normalized within the range obtained during training
-    double lower = -1.0;
-    double upper =  1.0;
-    for (int k=0; k<feature.cols; k++)
+// sums the responses of the patches of each quad of the window starting at column x into the 9 pools
+// of the quad, this yields a representation of 9xD stored in feature
+void OCRHMMClassifierCNN::poolResponses(const Mat& responses, int patches_x, int x, Mat& feature)
+{
+    Mat quad_sum(1, kernels.rows, CV_64FC1);
+    int quad_id = 0;
+    for (int q_x=0; q_x<=window_size-quad_size; q_x=q_x+(quad_size/2-1))
     {
-        feature.at<double>(0,k) = lower + (upper-lower) *
-                (feature.at<double>(0,k)-feature_min.at<double>(0,k))/
-                (feature_max.at<double>(0,k)-feature_min.at<double>(0,k));
-    }
-
-    double *p = new double[nr_class];
-    double predict_label = eval_feature(feature,p);
-    //cout << " Prediction: " << vocabulary[predict_label] << " with probability " << p[0] << endl;
-    if (predict_label < 0)
-        CV_Error(Error::StsInternal, "OCRHMMClassifierCNN::eval Error: unexpected prediction in eval_feature()");
-
-    out_class.push_back((int)predict_label);
-    out_confidence.push_back(p[(int)predict_label]);
+        for (int q_y=0; q_y<=window_size-quad_size; q_y=q_y+(quad_size/2-1))
+        {
+            quad_sum = Scalar(0);
+            for (int w_x=0; w_x<=quad_size-patch_size; w_x++)
+                for (int w_y=0; w_y<=quad_size-patch_size; w_y++)
+                    quad_sum += responses.row((q_y+w_y)*patches_x+x+q_x+w_x);
 
-    for (int i = 0; i<nr_class; i++)
-    {
-      if ( (i != (int)predict_label) && (p[i] != 0.) )
-      {
-        out_class.push_back(i);
-        out_confidence.push_back(p[i]);
-      }
+            for (int i=0; i<9; i++)
+            {
+                if (quad_pools[quad_id] & (1<<i))
+                {
+                    Mat pool = feature.colRange(i*kernels.rows,(i+1)*kernels.rows);
+                    pool += quad_sum;
+                }
+            }
+            quad_id++;
+        }
     }
-
-
 }
 
 // normalize for contrast and apply ZCA whitening to a set of image patches
@@ -1157,36 +1185,53 @@ void OCRHMMClassifierCNN::normalizeAndZCA(Mat& patches)
 
 }
 
-double OCRHMMClassifierCNN::eval_feature(Mat& feature, double* prob_estimates)
+// scales each row of features and evaluates the Logistic Regression on it, prob_estimates has one row
+// of class probabilities per feature and labels the most probable class of each one
+void OCRHMMClassifierCNN::eval_features(Mat& features, Mat& prob_estimates, vector<int>& labels)
 {
-    for(int i=0;i<nr_class;i++)
-        prob_estimates[i] = 0;
+    // data must be normalized within the range obtained during training
+    double lower = -1.0;
+    double upper =  1.0;
+    for (int n=0; n<features.rows; n++)
+    {
+        double* feature = features.ptr<double>(n);
+        for (int k=0; k<features.cols; k++)
+        {
+            feature[k] = lower + (upper-lower) *
+                    (feature[k]-feature_min.at<double>(0,k))/
+                    (feature_max.at<double>(0,k)-feature_min.at<double>(0,k));
+        }
+    }
 
-    for(int idx=0; idx<nr_feature; idx++)
-        for(int i=0;i<nr_class;i++)
-            prob_estimates[i] += weights.at<float>(idx,i)*feature.at<double>(0,idx); //TODO use vectorized dot product
+    Mat weights_d;
+    weights.convertTo(weights_d, CV_64F);
+    prob_estimates = features*weights_d;
 
-    int dec_max_idx = 0;
-    for(int i=1;i<nr_class;i++)
+    labels.resize(prob_estimates.rows);
+    for (int n=0; n<prob_estimates.rows; n++)
     {
-        if(prob_estimates[i] > prob_estimates[dec_max_idx])
-            dec_max_idx = i;
-    }
+        double* p = prob_estimates.ptr<double>(n);
 
-    for(int i=0;i<nr_class;i++)
-        prob_estimates[i]=1/(1+exp(-prob_estimates[i]));
+        int dec_max_idx = 0;
+        for(int i=1;i<nr_class;i++)
+        {
+            if(p[i] > p[dec_max_idx])
+                dec_max_idx = i;
+        }
+        labels[n] = dec_max_idx;
 
-    double sum=0;
-    for(int i=0; i<nr_class; i++)
-        sum+=prob_estimates[i];
+        for(int i=0;i<nr_class;i++)
+            p[i]=1/(1+exp(-p[i]));
 
-    for(int i=0; i<nr_class; i++)
-        prob_estimates[i]=prob_estimates[i]/sum;
+        double sum=0;
+        for(int i=0; i<nr_class; i++)
+            sum+=p[i];
 
-    return dec_max_idx;
+        for(int i=0; i<nr_class; i++)
+            p[i]=p[i]/sum;
+    }
 }
 
-
 Ptr<OCRHMMDecoder::ClassifierCallback> loadOCRHMMClassifierCNN(const String& filename)
 
 {
@@ -273,5 +273,150 @@ Ptr<OCRTesseract> OCRTesseract::create(const char* datapath, const char* languag
 }
 
 
+class OCRTesseractPoolImpl : public OCRTesseractPool
+{
+private:
+    // the engines and the locks telling whether they are busy
+    vector< Ptr<OCRTesseract> > engines;
+    vector< Ptr<Mutex> > engine_locks;
+    // the engine to wait for when all of them are busy
+    int next_engine;
+    Mutex next_engine_lock;
+
+    class EngineLock;
+    friend class EngineLock;
+
+    // locks a free engine until it is destroyed
+    class EngineLock
+    {
+    public:
+        EngineLock(OCRTesseractPoolImpl& pool) : locks(pool.engine_locks)
+        {
+            for (engine = 0; engine < (int)locks.size(); engine++)
+                if (locks[engine]->trylock())
+                    return;
+
+            {
+                AutoLock lock(pool.next_engine_lock);
+                engine = pool.next_engine;
+                pool.next_engine = (pool.next_engine + 1) % (int)locks.size();
+            }
+            locks[engine]->lock();
+        }
+        ~EngineLock() { locks[engine]->unlock(); }
+
+        int engine;
+
+    private:
+        EngineLock(const EngineLock&);
+        EngineLock& operator=(const EngineLock&);
+
+        vector< Ptr<Mutex> >& locks;
+    };
+
+    // recognizes a range of images, each one with the first free engine
+    class BatchInvoker : public ParallelLoopBody
+    {
+    public:
+        BatchInvoker(OCRTesseractPoolImpl& _pool, const vector<Mat>& _images, vector<string>& _output_texts,
+                     vector< vector<Rect> >* _component_rects, vector< vector<string> >* _component_texts,
+                     vector< vector<float> >* _component_confidences, int _component_level)
+            : pool(_pool), images(_images), output_texts(_output_texts), component_rects(_component_rects),
+              component_texts(_component_texts), component_confidences(_component_confidences),
+              component_level(_component_level) {}
+
+        void operator()(const Range& range) const
+        {
+            for (int i = range.start; i < range.end; i++)
+            {
+                Mat image = images[i];
+                pool.run(image, output_texts[i],
+                         component_rects ? &(*component_rects)[i] : NULL,
+                         component_texts ? &(*component_texts)[i] : NULL,
+                         component_confidences ? &(*component_confidences)[i] : NULL,
+                         component_level);
+            }
+        }
+
+    private:
+        BatchInvoker& operator=(const BatchInvoker&); // to quiet MSVC
+
+        OCRTesseractPoolImpl& pool;
+        const vector<Mat>& images;
+        vector<string>& output_texts;
+        vector< vector<Rect> >* component_rects;
+        vector< vector<string> >* component_texts;
+        vector< vector<float> >* component_confidences;
+        int component_level;
+    };
+
+public:
+    OCRTesseractPoolImpl(int num_engines, const char* datapath, const char* language,
+                         const char* char_whitelist, int oemode, int psmode) : next_engine(0)
+    {
+        CV_Assert( num_engines > 0 );
+        for (int i = 0; i < num_engines; i++)
+        {
+            engines.push_back(makePtr<OCRTesseractImpl>(datapath, language, char_whitelist, oemode, psmode));
+            engine_locks.push_back(makePtr<Mutex>());
+        }
+    }
+
+    void run(Mat& image, string& output, vector<Rect>* component_rects=NULL,
+             vector<string>* component_texts=NULL, vector<float>* component_confidences=NULL,
+             int component_level=0)
+    {
+        EngineLock lock(*this);
+        engines[lock.engine]->run(image, output, component_rects, component_texts, component_confidences,
+                                  component_level);
+    }
+
+    void run(Mat& image, Mat& mask, string& output, vector<Rect>* component_rects=NULL,
+             vector<string>* component_texts=NULL, vector<float>* component_confidences=NULL,
+             int component_level=0)
+    {
+        EngineLock lock(*this);
+        engines[lock.engine]->run(image, mask, output, component_rects, component_texts, component_confidences,
+                                  component_level);
+    }
+
+    void run(const vector<Mat>& images, vector<string>& output_texts,
+             vector< vector<Rect> >* component_rects=NULL,
+             vector< vector<string> >* component_texts=NULL,
+             vector< vector<float> >* component_confidences=NULL,
+             int component_level=0)
+    {
+        output_texts.resize(images.size());
+        if (component_rects != NULL)
+            component_rects->resize(images.size());
+        if (component_texts != NULL)
+            component_texts->resize(images.size());
+        if (component_confidences != NULL)
+            component_confidences->resize(images.size());
+
+        parallel_for_(Range(0, (int)images.size()),
+                      BatchInvoker(*this, images, output_texts, component_rects, component_texts,
+                                   component_confidences, component_level),
+                      (double)engines.size());
+    }
+
+    void setWhiteList(const String& char_whitelist)
+    {
+        // wait for each engine to finish its current recognition
+        for (size_t i = 0; i < engines.size(); i++)
+        {
+            AutoLock lock(*engine_locks[i]);
+            engines[i]->setWhiteList(char_whitelist);
+        }
+    }
+};
+
+Ptr<OCRTesseractPool> OCRTesseractPool::create(int num_engines, const char* datapath, const char* language,
+                                               const char* char_whitelist, int oem, int psmode)
+{
+    return makePtr<OCRTesseractPoolImpl>(num_engines, datapath, language, char_whitelist, oem, psmode);
+}
+
+
 }
 }
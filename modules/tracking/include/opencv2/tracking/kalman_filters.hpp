@@ -114,6 +114,23 @@ public:
     * @param z_k - measurement vector.
     */
     virtual void measurementFunction( const Mat& x_k, const Mat& n_k, Mat& z_k ) = 0;
+
+    /** The function for computing the next states of a set of states at once, e.g. of all the sigma points.
+    * The default implementation calls stateConversionFunction for each column, override it to propagate
+    * all the states in one pass.
+    * @param x_k - previous state vectors, one per column,
+    * @param u_k - control vector, the same for all the states or one column per state,
+    * @param v_k - noise vector, the same for all the states or one column per state,
+    * @param x_kplus1 - next state vectors, one per column, preallocated.
+    */
+    virtual void stateConversionFunctionBatch( const Mat& x_k, const Mat& u_k, const Mat& v_k, Mat& x_kplus1 );
+    /** The function for computing the measurements of a set of states at once.
+    * The default implementation calls measurementFunction for each column.
+    * @param x_k - state vectors, one per column,
+    * @param n_k - noise vector, the same for all the states or one column per state,
+    * @param z_k - measurement vectors, one per column, preallocated.
+    */
+    virtual void measurementFunctionBatch( const Mat& x_k, const Mat& n_k, Mat& z_k );
 };
 
 
@@ -222,6 +239,55 @@ CV_EXPORTS Ptr<UnscentedKalmanFilter> createUnscentedKalmanFilter( const Unscent
 */
 CV_EXPORTS Ptr<UnscentedKalmanFilter> createAugmentedUnscentedKalmanFilter( const AugmentedUnscentedKalmanFilterParams &params );
 
+/** @brief The interface for a bank of independent Unscented Kalman filters, e.g. one per tracked target.
+* All the filters share the parameters and the system model. Their states are kept as the columns of one matrix,
+* the sigma points of all the filters are propagated by one call of the batched functions of the model and
+* the other steps run in parallel over the filters.
+*/
+class CV_EXPORTS UnscentedKalmanFilterBank
+{
+public:
+
+    virtual ~UnscentedKalmanFilterBank(){}
+
+    /** The function performs prediction step of all the filters
+    * @param control - the current control vector, the same for all the filters (CP x 1) or one column per filter,
+    * @return the predicted estimates of the states, one column per filter.
+    */
+    virtual Mat predict( const Mat& control = Mat() ) = 0;
+
+    /** The function performs correction step of all the filters
+    * @param measurements - the current measurement vectors, one column per filter,
+    * @return the corrected estimates of the states, one column per filter.
+    */
+    virtual Mat correct( const Mat& measurements ) = 0;
+
+    /**
+    * @return the number of filters.
+    */
+    virtual int getNumberOfFilters() const = 0;
+
+    /**
+    * @param index - index of the filter,
+    * @return the error cross-covariance matrix of the filter.
+    */
+    virtual Mat getErrorCov( int index ) const = 0;
+
+    /**
+    * @return the current estimates of the states, one column per filter.
+    */
+    virtual Mat getStates() const = 0;
+};
+
+/** @brief Unscented Kalman Filter bank factory method
+
+* @param params - an object of the UnscentedKalmanFilterParams class containing UKF parameters, the same for all the filters,
+* @param initialStates - initial states of the filters, DP x N, one column per filter.
+* @return pointer to the object implementing UnscentedKalmanFilterBank with N filters.
+*/
+CV_EXPORTS Ptr<UnscentedKalmanFilterBank> createUnscentedKalmanFilterBank( const UnscentedKalmanFilterParams &params,
+                                                                           const Mat& initialStates );
+
 } // tracking
 } // cv
 
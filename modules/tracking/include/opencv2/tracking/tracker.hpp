@@ -1186,6 +1186,17 @@ class CV_EXPORTS TrackerTLD : public Tracker
   struct CV_EXPORTS Params
   {
     Params();
+    /** @brief Which stored exemplar is replaced when the NN model store is full
+     */
+    enum
+    {
+      EVICT_RANDOM = 0,            //!< replace a random exemplar
+      EVICT_OLDEST = 1,            //!< replace the oldest exemplar, the store works as a ring buffer
+      EVICT_RESERVOIR = 2,         //!< reservoir sampling, every exemplar seen has the same chance to be kept
+      EVICT_LEAST_INFORMATIVE = 3  //!< replace the exemplar which is the most similar to the new one
+    };
+    int maxExamples;     //!< capacity of each of the positive and negative exemplars stores, from 1 to 500
+    int evictionPolicy;  //!< one of the EVICT_* values
     void read( const FileNode& /*fn*/ );
     void write( FileStorage& /*fs*/ ) const;
   };
@@ -1247,6 +1258,11 @@ public:
 		int compressed_size;          //!<  feature size after compression
 		unsigned int desc_pca;        //!<  compressed descriptors of TrackerKCF::MODE
 		unsigned int desc_npca;       //!<  non-compressed descriptors of TrackerKCF::MODE
+		bool scale_adaptive;          //!<  estimate the scale of the target with a separate 1D scale filter (DSST)
+		int scale_count;              //!<  number of scales evaluated by the scale filter
+		double scale_step;            //!<  ratio between two neighbouring scales
+		double scale_sigma_factor;    //!<  bandwidth of the desired response of the scale filter
+		int scale_model_max_area;     //!<  the scale samples are resized to at most this number of pixels
 	};
 
 	virtual void setFeatureExtractor(void(*)(const Mat, const Rect, Mat&), bool pca_func = false);
@@ -1312,6 +1328,8 @@ public:
 	/**
 	* \brief Update the current tracking status.
 	* The result will be saved in the internal storage.
+	* The trackers of different objects are independent and are updated in parallel,
+	* so they must not share state with each other.
 	* @param image input image
 	*/
 	bool update(const Mat& image);
@@ -1449,6 +1467,51 @@ public:
 	bool update_opt(const Mat& image);
 };
 
+/** @brief Multi Object Tracker for KCF, see cv::TrackerKCF. All targets have to be added with the "KCF" algorithm.
+
+The targets are processed together instead of one after another: the frame is resized and converted to grayscale once
+for all of them, every stage of the KCF update runs for all targets in parallel, and the fourier transforms of
+the targets which share a template size are batched.
+
+@sa Tracker, MultiTracker, TrackerKCF
+*/
+class CV_EXPORTS MultiTrackerKCF : public MultiTracker_Alt
+{
+public:
+	/** @brief Update all trackers from the tracking-list, find a new most likely bounding boxes for the targets by
+	optimized update method. The results are the same as the ones of MultiTracker_Alt::update up to the rounding errors,
+	but all targets are updated even if some of them are lost. Custom feature extractors of the trackers
+	(see TrackerKCF::setFeatureExtractor) are called from several threads.
+
+	@param image The current frame.
+
+	@return True means that all targets were located and false means that tracker couldn't locate one of the targets in
+	current frame.
+	*/
+	bool update_opt(const Mat& image);
+};
+
+/** @brief Multi Object Tracker for MedianFlow trackers.
+
+@sa Tracker, MultiTracker, TrackerMedianFlow
+*/
+class CV_EXPORTS MultiTrackerMedianFlow : public MultiTracker_Alt
+{
+public:
+	/** @brief Update all trackers from the tracking-list, find a new most likely bounding boxes for the targets by
+	optimized update method. The grayscale frame and its pyramid are computed once for all the targets, and the grid
+	points of the targets tracked from the same frame are tracked by one forward and one backward Lucas-Kanade flow.
+	The results are the same as the ones of MultiTracker_Alt::update, but all targets are updated even if some of
+	them are lost.
+
+	@param image The current frame.
+
+	@return True means that all targets were located and false means that tracker couldn't locate one of the targets in
+	current frame.
+	*/
+	bool update_opt(const Mat& image);
+};
+
 //! @}
 
 } /* namespace cv */
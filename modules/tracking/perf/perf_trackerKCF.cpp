@@ -0,0 +1,118 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+
+// counts the Mat buffers allocated through the default allocator
+class CountingAllocator : public MatAllocator
+{
+public:
+  CountingAllocator() : stdAllocator(Mat::getStdAllocator()), allocations(0) {}
+
+  UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step, int flags, UMatUsageFlags usageFlags) const
+  {
+    if( !data )
+      CV_XADD(&allocations, 1);
+    return stdAllocator->allocate(dims, sizes, type, data, step, flags, usageFlags);
+  }
+
+  bool allocate(UMatData* u, int accessFlags, UMatUsageFlags usageFlags) const
+  {
+    return stdAllocator->allocate(u, accessFlags, usageFlags);
+  }
+
+  void deallocate(UMatData* u) const
+  {
+    stdAllocator->deallocate(u);
+  }
+
+  int count() const { return allocations; }
+
+private:
+  MatAllocator* stdAllocator;
+  mutable int allocations;
+};
+
+PERF_TEST(KCF, update_withoutMatAllocations)
+{
+  const int numFrames = 16;
+  RNG rng(0);
+  Mat background(240, 320, CV_8UC3), target(30, 40, CV_8UC3);
+  rng.fill(background, RNG::UNIFORM, 0, 80);
+  rng.fill(target, RNG::UNIFORM, 100, 256);
+
+  // the target moves back and forth, so the tracker runs over and over the same frames
+  vector<Mat> frames(numFrames);
+  for( int i = 0; i < numFrames; i++ )
+  {
+    int shift = i < numFrames / 2 ? i : numFrames - i;
+    background.copyTo(frames[i]);
+    Mat roi = frames[i](Rect(Point(100 + 2 * shift, 100 + shift), target.size()));
+    target.copyTo(roi);
+  }
+
+  Ptr<Tracker> tracker = Tracker::create("KCF");
+  Rect2d bb(Point(100, 100), target.size());
+  ASSERT_TRUE(tracker->init(frames[0], bb));
+
+  // the buffers depending on the number of feature channels are allocated by the first updates
+  for( int i = 1; i < 3; i++ )
+    ASSERT_TRUE(tracker->update(frames[i], bb));
+
+  CountingAllocator counter;
+  MatAllocator* defaultAllocator = Mat::getDefaultAllocator();
+  Mat::setDefaultAllocator(&counter);
+
+  int frameId = 3;
+  TEST_CYCLE()
+  {
+    tracker->update(frames[frameId++ % numFrames], bb);
+  }
+
+  Mat::setDefaultAllocator(defaultAllocator);
+  EXPECT_EQ(0, counter.count());
+
+  SANITY_CHECK_NOTHING();
+}
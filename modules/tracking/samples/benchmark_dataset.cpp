@@ -0,0 +1,335 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                           License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "opencv2/datasets/track_vot.hpp"
+#include <opencv2/core/utility.hpp>
+#include <opencv2/tracking.hpp>
+#include <opencv2/highgui.hpp>
+
+#include <cstdio>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+using namespace cv;
+using namespace cv::datasets;
+
+static const char* keys =
+{ "{help h usage ? |     | show this message }"
+"{@dataset        |vot  | dataset type: vot (VOT 2015 folder layout) or tld (TLD dataset) }"
+"{@dataset_path   |     | dataset path }"
+"{trackers        |MIL,BOOSTING,MEDIANFLOW,TLD,KCF| comma separated list of the trackers }"
+"{id              |0    | sequence ID, 0 runs all the sequences }"
+"{frames          |0    | the maximum number of frames per sequence, 0 for the full sequences }"
+};
+
+static void help()
+{
+	cout << "\nThis benchmark runs the trackers over full dataset sequences without displaying them and reports\n"
+		"the per-frame latency percentiles, the throughput, the memory high-water mark and the overlap accuracy.\n"
+		"The time of reading the frames is not counted. The TLD loader gives the initial box only,\n"
+		"so the accuracy is reported for the VOT sequences.\n"
+		"Example:\n"
+		"./example_tracking_benchmark_dataset vot <vot2015_path> -trackers=KCF,MEDIANFLOW\n"
+		<< endl;
+}
+
+/*
+ * The memory high-water mark of the process in MB, -1 if it cannot be measured.
+ * On Linux the mark is reset before every run, elsewhere it is the peak of the whole process so far.
+ */
+static void resetPeakMemory()
+{
+#if defined(__linux__)
+	FILE* f = fopen("/proc/self/clear_refs", "w");
+	if (f)
+	{
+		fputs("5", f);
+		fclose(f);
+	}
+#endif
+}
+
+static double peakMemoryMB()
+{
+#if defined(__linux__)
+	FILE* f = fopen("/proc/self/status", "r");
+	if (f)
+	{
+		char line[128];
+		long kb = -1;
+		while (fgets(line, sizeof(line), f))
+		{
+			if (strncmp(line, "VmHWM:", 6) == 0)
+			{
+				kb = atol(line + 6);
+				break;
+			}
+		}
+		fclose(f);
+		if (kb >= 0)
+			return kb / 1024.0;
+	}
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+#if defined(__APPLE__)
+		return usage.ru_maxrss / (1024.0 * 1024.0);
+#else
+		return usage.ru_maxrss / 1024.0;
+#endif
+	}
+#endif
+	return -1.0;
+}
+
+static inline double overlap(const Rect2d& r1, const Rect2d& r2)
+{
+	double a0 = (r1 & r2).area();
+	return a0 / (r1.area() + r2.area() - a0);
+}
+
+/*
+ * A sequence of frames and their ground truth, the ground truth box is empty if unknown
+ */
+class Sequence
+{
+public:
+	virtual ~Sequence() {}
+	virtual bool start(int id) = 0;
+	virtual bool next(Mat& frame, Rect2d& gt) = 0;
+	virtual int size() const = 0;
+};
+
+class VOTSequence : public Sequence
+{
+public:
+	VOTSequence(const string& path) : dataset(TRACK_vot::create()) { dataset->load(path); }
+	bool start(int id) { return dataset->initDataset(id); }
+	bool next(Mat& frame, Rect2d& gt)
+	{
+		if (!dataset->getNextFrame(frame))
+			return false;
+		// bounding box of the ground truth polygon
+		vector<Point2d> points = dataset->getGT();
+		double x0 = DBL_MAX, y0 = DBL_MAX, x1 = -DBL_MAX, y1 = -DBL_MAX;
+		for (size_t i = 0; i < points.size(); i++)
+		{
+			x0 = std::min(x0, points[i].x); y0 = std::min(y0, points[i].y);
+			x1 = std::max(x1, points[i].x); y1 = std::max(y1, points[i].y);
+		}
+		gt = points.empty() ? Rect2d() : Rect2d(x0, y0, x1 - x0, y1 - y0);
+		return true;
+	}
+	int size() const { return dataset->getDatasetsNum(); }
+private:
+	Ptr<TRACK_vot> dataset;
+};
+
+class TLDSequence : public Sequence
+{
+public:
+	TLDSequence(const string& path) : rootPath(path), first(false) {}
+	bool start(int id)
+	{
+		initBox = tld::tld_InitDataset(id, rootPath.c_str(), 0);
+		first = true;
+		return true;
+	}
+	bool next(Mat& frame, Rect2d& gt)
+	{
+		frame = tld::tld_getNextDatasetFrame();
+		gt = first ? initBox : Rect2d();
+		first = false;
+		return !frame.empty();
+	}
+	int size() const { return 10; }
+private:
+	string rootPath;
+	Rect2d initBox;
+	bool first;
+};
+
+struct BenchmarkResult
+{
+	BenchmarkResult() : initTime(0), frames(0), failures(0), sumOverlap(0), assessed(0), correct(0), peakMemory(-1) {}
+	vector<double> latencies; // ms per update
+	double initTime; // ms in total
+	int frames, failures;
+	double sumOverlap;
+	int assessed, correct;
+	double peakMemory; // MB
+};
+
+// nearest-rank percentile of the sorted values
+static double percentile(const vector<double>& sorted, double p)
+{
+	if (sorted.empty())
+		return 0;
+	int rank = (int)std::ceil(p / 100.0 * sorted.size());
+	return sorted[std::min(std::max(rank, 1), (int)sorted.size()) - 1];
+}
+
+static bool runSequence(const string& trackerName, Sequence& sequence, int id, int maxFrames, BenchmarkResult& result)
+{
+	Mat frame;
+	Rect2d gt, boundingBox;
+	if (!sequence.start(id) || !sequence.next(frame, gt) || gt.area() <= 0)
+		return false;
+
+	Ptr<Tracker> tracker = Tracker::create(trackerName);
+	if (tracker == NULL)
+		return false;
+
+	resetPeakMemory();
+	boundingBox = gt;
+	int64 t = getTickCount();
+	if (!tracker->init(frame, boundingBox))
+		return false;
+	result.initTime += (getTickCount() - t) * 1000.0 / getTickFrequency();
+
+	for (int i = 1; (maxFrames <= 0 || i < maxFrames) && sequence.next(frame, gt); i++)
+	{
+		t = getTickCount();
+		bool res = tracker->update(frame, boundingBox);
+		result.latencies.push_back((getTickCount() - t) * 1000.0 / getTickFrequency());
+		result.frames++;
+		if (!res)
+			result.failures++;
+
+		if (gt.area() > 0)
+		{
+			double o = res ? overlap(gt, boundingBox) : 0.0;
+			result.sumOverlap += o;
+			result.assessed++;
+			if (o > 0.5)
+				result.correct++;
+		}
+	}
+	result.peakMemory = std::max(result.peakMemory, peakMemoryMB());
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	CommandLineParser parser(argc, argv, keys);
+	string datasetType = parser.get<string>(0);
+	string datasetRootPath = parser.get<string>(1);
+	string trackersList = parser.get<string>("trackers");
+	int datasetID = parser.get<int>("id");
+	int maxFrames = parser.get<int>("frames");
+	if (parser.has("help") || datasetRootPath.empty() || (datasetType != "vot" && datasetType != "tld"))
+	{
+		help();
+		parser.printMessage();
+		return -1;
+	}
+
+	vector<string> trackers;
+	for (size_t pos = 0; pos <= trackersList.size();)
+	{
+		size_t end = std::min(trackersList.find(',', pos), trackersList.size());
+		if (end > pos)
+			trackers.push_back(trackersList.substr(pos, end - pos));
+		pos = end + 1;
+	}
+
+	Ptr<Sequence> sequence;
+	if (datasetType == "vot")
+		sequence = Ptr<Sequence>(new VOTSequence(datasetRootPath));
+	else
+		sequence = Ptr<Sequence>(new TLDSequence(datasetRootPath));
+
+	int firstID = datasetID > 0 ? datasetID : 1;
+	int lastID = datasetID > 0 ? datasetID : sequence->size();
+
+	vector<BenchmarkResult> results(trackers.size());
+	for (size_t i = 0; i < trackers.size(); i++)
+	{
+		for (int id = firstID; id <= lastID; id++)
+		{
+			int frames = results[i].frames;
+			int64 t = getTickCount();
+			if (!runSequence(trackers[i], *sequence, id, maxFrames, results[i]))
+			{
+				printf("%s: cannot run sequence %d\n", trackers[i].c_str(), id);
+				continue;
+			}
+			printf("%s: sequence %d, %d frames, %.1fs\n", trackers[i].c_str(), id, results[i].frames - frames,
+				(getTickCount() - t) / getTickFrequency());
+		}
+	}
+
+	printf("\n%-12s %8s %8s %9s %9s %9s %9s %9s %8s %8s %8s %10s\n", "tracker", "frames", "fps",
+		"p50(ms)", "p90(ms)", "p99(ms)", "max(ms)", "init(ms)", "IoU", "IoU>0.5", "failures", "peak(MB)");
+	for (size_t i = 0; i < trackers.size(); i++)
+	{
+		BenchmarkResult& r = results[i];
+		vector<double> sorted = r.latencies;
+		std::sort(sorted.begin(), sorted.end());
+		double total = 0;
+		for (size_t j = 0; j < sorted.size(); j++)
+			total += sorted[j];
+
+		char iou[16] = "n/a", correct[16] = "n/a", memory[16] = "n/a";
+		if (r.assessed > 0)
+		{
+			sprintf(iou, "%.3f", r.sumOverlap / r.assessed);
+			sprintf(correct, "%.3f", (double)r.correct / r.assessed);
+		}
+		if (r.peakMemory >= 0)
+			sprintf(memory, "%.1f", r.peakMemory);
+
+		printf("%-12s %8d %8.1f %9.2f %9.2f %9.2f %9.2f %9.2f %8s %8s %8d %10s\n", trackers[i].c_str(), r.frames,
+			total > 0 ? r.frames * 1000.0 / total : 0.0, percentile(sorted, 50), percentile(sorted, 90), percentile(sorted, 99),
+			sorted.empty() ? 0.0 : sorted.back(), r.initTime, iou, correct, r.failures, memory);
+	}
+	return 0;
+}
@@ -1,4 +1,5 @@
 #include "opencv2/core.hpp"
+#include "opencv2/core/utility.hpp"
 #include "opencv2/core/core_c.h"
 #include <algorithm>
 #include <typeinfo>
@@ -18,6 +19,8 @@ namespace cv{
             virtual void correctParams(double* /*optParams*/)const{}
             //!is used when there is a dependence on the number of iterations done in calc(), note that levels are counted starting from 1
             virtual void setLevel(int /*level*/, int /*levelsNum*/){}
+            //!calc() and correctParams() are called for several particles at once from parallel threads,
+            //!so they must not modify the function
         };
         PFSolver();
         void getOptParam(OutputArray params)const;
@@ -43,9 +46,37 @@ namespace cv{
         int _maxItNum,_iter,_particlesNum;
         double _alpha;
         inline void normalize(Mat_<double>& row);
+        void resample();
         RNG rng;
     };
 
+    //!perturbs and measures the particles of the range, each one with its own generator so that the result
+    //!does not depend on the number of threads
+    class PFParticlesInvoker : public ParallelLoopBody{
+    public:
+        PFParticlesInvoker(Mat_<double>& particles,Mat_<double>& logweight,const Mat_<double>& std,
+                const PFSolver::Function* function,uint64 seed):
+            _particles(particles),_logweight(logweight),_std(std),_function(function),_seed(seed){}
+        void operator()(const Range& range)const{
+            for(int i=range.start;i<range.end;i++){
+                RNG prng(_seed+(uint64)i);
+                double* row=_particles[i];
+                for(int j=0;j<_particles.cols;j++){
+                    row[j]+=prng.gaussian(_std(0,j));
+                }
+                _function->correctParams(row);
+                _logweight(0,i)=-(_function->calc(row));
+            }
+        }
+    private:
+        Mat_<double>& _particles;
+        Mat_<double>& _logweight;
+        const Mat_<double>& _std;
+        const PFSolver::Function* _function;
+        uint64 _seed;
+        PFParticlesInvoker& operator=(const PFParticlesInvoker&); // to quiet MSVC
+    };
+
     CV_EXPORTS_W Ptr<PFSolver> createPFSolver(const Ptr<MinProblemSolver::Function>& f=Ptr<MinProblemSolver::Function>(),InputArray std=Mat(),
             TermCriteria termcrit=TermCriteria(TermCriteria::MAX_ITER,5,0.0),int particlesNum=100,double alpha=0.6);
 
@@ -79,43 +110,12 @@ namespace cv{
 
         _real_function->setLevel(_iter+1,_maxItNum);
 
-        //perturb
-        for(int j=0;j<_particles.cols;j++){
-            double sigma=_std(0,j);
-            for(int i=0;i<_particles.rows;i++){
-                    _particles(i,j)+=rng.gaussian(sigma);
-            }
-        }
-
-        //measure
-        for(int i=0;i<_particles.rows;i++){
-            _real_function->correctParams((double*)_particles.row(i).data);
-            _logweight(0,i)=-(_real_function->calc((double*)_particles.row(i).data));
-        }
+        //perturb and measure
+        parallel_for_(Range(0,_particles.rows),PFParticlesInvoker(_particles,_logweight,_std,_real_function,(uint64)rng.next()));
         //normalize
         normalize(_logweight);
         //replicate
-        Mat_<double> new_particles(_particlesNum,_std.cols);
-        int num_particles=0;
-        for(int i=0;i<_particles.rows;i++){
-            int num_replicons=cvFloor(new_particles.rows/exp(-_logweight(0,i)));
-            for(int j=0;j<num_replicons;j++,num_particles++){
-                _particles.row(i).copyTo(new_particles.row(num_particles));
-            }
-        }
-        //Mat_<double> maxrow=_particles.row(std::max_element(_logweight.begin(),_logweight.end())-_logweight.begin());
-        double max_element;
-        minMaxLoc(_logweight, 0, &max_element);
-        Mat_<double> maxrow=_particles.row((int)max_element);
-        for(;num_particles<new_particles.rows;num_particles++){
-                maxrow.copyTo(new_particles.row(num_particles));
-        }
-
-        if(_particles.rows!=new_particles.rows){
-            _particles=new_particles;
-        }else{
-            new_particles.copyTo(_particles);
-        }
+        resample();
         _std=_std*_alpha;
         _iter++;
         return _iter;
@@ -209,6 +209,24 @@ namespace cv{
             ptr->setAlpha(alpha);
             return ptr;
     }
+    //!systematic resampling: _particlesNum evenly spaced pointers with a common random offset
+    //!walk once through the cumulative weights, the new particles have equal weights
+    void PFSolver::resample(){
+        Mat_<double> new_particles(_particlesNum,_std.cols);
+        double step=1.0/_particlesNum,u=rng.uniform(0.0,step),cumsum=exp(_logweight(0,0));
+        int i=0;
+        for(int k=0;k<_particlesNum;k++,u+=step){
+            while(cumsum<u && i<_particles.rows-1){
+                i++;
+                cumsum+=exp(_logweight(0,i));
+            }
+            _particles.row(i).copyTo(new_particles.row(k));
+        }
+
+        _particles=new_particles;
+        _logweight.create(1,_particles.rows);
+        _logweight.setTo(-log((double)_particles.rows));
+    }
     void PFSolver::normalize(Mat_<double>& row){
         double logsum=0.0;
         //double max=*(std::max_element(row.begin(),row.end()));
@@ -13,53 +13,71 @@ namespace cv{
             double calc(const double* x) const;
             void correctParams(double* pt)const;
         private:
-            Mat _image;
+            //!histogram bins of the pixels of the current image, computed once per frame by update()
+            Mat_<int> _bins;
             static inline Rect rectFromRow(const double* row);
+            static Mat_<int> computeBins(const Mat& img,int nh,int ns,int nv);
             const int _nh,_ns,_nv;
+            //!HS histogram of the saturated and bright pixels (bin h*ns+s) followed by V histogram of the others
             class TrackingHistogram{
             public:
-                TrackingHistogram(const Mat& img,int nh,int ns,int nv);
-                double dist(const TrackingHistogram& hist)const;
+                TrackingHistogram(const Mat_<int>& bins,int nh,int ns,int nv);
+                //!distance to the histogram of a region of a bin map, counted directly from the bins
+                double dist(const Mat_<int>& bins)const;
             private:
-                Mat_<double> HShist, Vhist;
+                Mat_<double> hist;
             };
             TrackingHistogram _origHist;
 			const TrackingFunctionPF & operator = (const TrackingFunctionPF &);
     };
 
-    TrackingFunctionPF::TrackingHistogram::TrackingHistogram(const Mat& img,int nh,int ns,int nv){
+    Mat_<int> TrackingFunctionPF::computeBins(const Mat& img,int nh,int ns,int nv){
 
         Mat hsv;
         img.convertTo(hsv,CV_32F,1.0/255.0);
         cvtColor(hsv,hsv,CV_BGR2HSV);
 
-        HShist=Mat_<double>(nh,ns,0.0);
-        Vhist=Mat_<double>(1,nv,0.0);
-
+        Mat_<int> bins(img.rows,img.cols);
         for(int i=0;i<img.rows;i++){
+            const Vec3f* row=hsv.ptr<Vec3f>(i);
+            int* brow=bins[i];
             for(int j=0;j<img.cols;j++){
-                const Vec3f& pt=hsv.at<Vec3f>(i,j);
+                const Vec3f& pt=row[j];
 
                 if(pt.val[1]>0.1 && pt.val[2]>0.2){
-                    HShist(MIN(nh-1,(int)(nh*pt.val[0]/360.0)),MIN(ns-1,(int)(ns*pt.val[1])))++;
+                    brow[j]=MIN(nh-1,(int)(nh*pt.val[0]/360.0))*ns+MIN(ns-1,(int)(ns*pt.val[1]));
                 }else{
-                    Vhist(0,MIN(nv-1,(int)(nv*pt.val[2])))++;
+                    brow[j]=nh*ns+MIN(nv-1,(int)(nv*pt.val[2]));
                 }
             }}
-
-        double total=*(sum(HShist)+sum(Vhist)).val;
-        HShist/=total;
-        Vhist/=total;
+        return bins;
     }
-    double TrackingFunctionPF::TrackingHistogram::dist(const TrackingHistogram& hist)const{
-        double res=1.0;
+    TrackingFunctionPF::TrackingHistogram::TrackingHistogram(const Mat_<int>& bins,int nh,int ns,int nv){
 
-        for(int i=0;i<HShist.rows;i++){
-            for(int j=0;j<HShist.cols;j++){
-                res-=sqrt(HShist(i,j)*hist.HShist(i,j));
+        hist=Mat_<double>(1,nh*ns+nv,0.0);
+        for(int i=0;i<bins.rows;i++){
+            const int* brow=bins[i];
+            for(int j=0;j<bins.cols;j++){
+                hist(0,brow[j])++;
             }}
-        for(int j=0;j<Vhist.cols;j++){
-            res-=sqrt(Vhist(0,j)*hist.Vhist(0,j));
+
+        hist/=(double)bins.total();
+    }
+    double TrackingFunctionPF::TrackingHistogram::dist(const Mat_<int>& bins)const{
+        AutoBuffer<int> _counts(hist.cols);
+        int* counts=_counts;
+        std::fill(counts,counts+hist.cols,0);
+        for(int i=0;i<bins.rows;i++){
+            const int* brow=bins[i];
+            for(int j=0;j<bins.cols;j++){
+                counts[brow[j]]++;
+            }}
+
+        double res=1.0,total=(double)bins.total();
+        for(int k=0;k<hist.cols;k++){
+            if(counts[k]){
+                res-=sqrt(counts[k]/total*hist(0,k));
+            }
         }
 
         return sqrt(res);
@@ -69,20 +87,18 @@ namespace cv{
         if(rect.area()==0){
             return 2.0;
         }
-        return _origHist.dist(TrackingHistogram(_image(rect),_nh,_ns,_nv));
+        return _origHist.dist(_bins(rect));
     }
-    TrackingFunctionPF::TrackingFunctionPF(const Mat& chosenRect):_nh(HIST_SIZE),_ns(HIST_SIZE),_nv(HIST_SIZE),_origHist(chosenRect,_nh,_ns,_nv){
+    TrackingFunctionPF::TrackingFunctionPF(const Mat& chosenRect):_nh(HIST_SIZE),_ns(HIST_SIZE),_nv(HIST_SIZE),_origHist(computeBins(chosenRect,_nh,_ns,_nv),_nh,_ns,_nv){
     }
     void TrackingFunctionPF::update(const Mat& image){
-        _image=image;
-
-        TrackingHistogram hist(image,_nh,_ns,_nv);
+        _bins=computeBins(image,_nh,_ns,_nv);
     }
     void TrackingFunctionPF::correctParams(double* pt)const{
-        pt[0]=CLIP(pt[0],0.0,_image.cols+0.9);
-        pt[1]=CLIP(pt[1],0.0,_image.rows+0.9);
-        pt[2]=CLIP(pt[2],0.0,_image.cols+0.9);
-        pt[3]=CLIP(pt[3],0.0,_image.rows+0.9);
+        pt[0]=CLIP(pt[0],0.0,_bins.cols+0.9);
+        pt[1]=CLIP(pt[1],0.0,_bins.rows+0.9);
+        pt[2]=CLIP(pt[2],0.0,_bins.cols+0.9);
+        pt[3]=CLIP(pt[3],0.0,_bins.rows+0.9);
         if(pt[0]>pt[2]){
             double tmp=pt[0];
             pt[0]=pt[2];
@@ -41,56 +41,13 @@
 
 #include "precomp.hpp"
 #include "opencv2/tracking/kalman_filters.hpp"
+#include "unscented_kalman_common.hpp"
 
 namespace cv
 {
 namespace tracking
 {
 
-/* Cholesky decomposition
- The function performs Cholesky decomposition <https://en.wikipedia.org/wiki/Cholesky_decomposition>.
- A - the Hermitian, positive-definite matrix,
- astep - size of row in A,
- asize - number of cols and rows in A,
- L - the lower triangular matrix, A = L*Lt.
-*/
-template<typename _Tp> bool
-inline choleskyDecomposition( const _Tp* A, size_t astep, const int asize, _Tp* L )
-{
-    int i, j, k;
-    double s;
-    astep /= sizeof(A[0]);
-    for( i = 0; i < asize; i++ )
-
-    {
-        for( j = 0; j < i; j++ )
-        {
-            s = A[i*astep + j];
-            for( k = 0; k < j; k++ )
-                s -= L[i*astep + k]*L[j*astep + k];
-            L[i*astep + j] = (_Tp)(s/L[j*astep + j]);
-        }
-        s = A[i*astep + i];
-        for( k = 0; k < i; k++ )
-        {
-            double t = L[i*astep + k];
-            s -= t*t;
-        }
-        if( s < std::numeric_limits<_Tp>::epsilon() )
-            return false;
-        L[i*astep + i] = (_Tp)(std::sqrt(s));
-    }
-
-   for( i = 0; i < asize; i++ )
-       for( j = i+1; j < asize; j++ )
-       {
-           L[i*astep + j] = 0.0;
-       }
-
-    return true;
-}
-
-
 void AugmentedUnscentedKalmanFilterParams::
     init( int dp, int mp, int cp, double processNoiseCovDiag, double measurementNoiseCovDiag,
                                 Ptr<UkfSystemModel> dynamicalSystem, int type )
@@ -161,7 +118,7 @@ class AugmentedUnscentedKalmanFilterImpl: public UnscentedKalmanFilter
 // Auxillary members
     Mat measurementEstimate;                    // estimate of current measurement (y*), MP x 1
 
-    Mat sigmaPoints;                            // set of sigma points ( x_i, i = 1..2*DP+1 ), DP x 2*DP+1
+    Mat sigmaPoints;                            // set of sigma points ( x_i, i = 1..2*DAug+1 ), DAug x 2*DAug+1
 
     Mat transitionSPFuncVals;                   // set of state function values at sigma points ( f_i, i = 1..2*DP+1 ), DP x 2*DP+1
     Mat measurementSPFuncVals;                  // set of measurement function values at sigma points ( h_i, i = 1..2*DP+1 ), MP x 2*DP+1
@@ -169,8 +126,14 @@ class AugmentedUnscentedKalmanFilterImpl: public UnscentedKalmanFilter
     Mat transitionSPFuncValsCenter;             // set of state function values at sigma points minus estimate of state ( fc_i, i = 1..2*DP+1 ), DP x 2*DP+1
     Mat measurementSPFuncValsCenter;            // set of measurement function values at sigma points minus estimate of measurement ( hc_i, i = 1..2*DP+1 ), MP x 2*DP+1
 
-    Mat Wm;                                     // vector of weights for estimate mean, 2*DP+1 x 1
-    Mat Wc;                                     // matrix of weights for estimate covariance, 2*DP+1 x 2*DP+1
+    Mat Wm;                                     // vector of weights for estimate mean, 2*DAug+1 x 1
+    Mat WcState;                                // weights for estimate covariance repeated in each row, DP x 2*DAug+1
+    Mat WcMeasurement;                          // weights for estimate covariance repeated in each row, MP x 2*DAug+1
+    Mat onesRow;                                // row of ones, 1 x 2*DAug+1
+
+    Mat covMatrixL;                             // Cholesky factor of Pa, DAug x DAug
+    Mat weightedState;                          // fc_i multiplied by the weights Wc[i], DP x 2*DAug+1
+    Mat weightedMeasurement;                    // hc_i multiplied by the weights Wc[i], MP x 2*DAug+1
 
     Mat gain;                                   // Kalman gain matrix (K), DP x MP
     Mat xyCov;                                  // estimate of the covariance between x* and y* (Sxy), DP x MP
@@ -180,11 +143,6 @@ class AugmentedUnscentedKalmanFilterImpl: public UnscentedKalmanFilter
     Mat q;                                      // zero vector of measurement noise for getting measurementSPFuncVals
 
 
-    template <typename T>
-    Mat getSigmaPoints(const Mat& mean, const Mat& covMatrix, double coef);
-
-    Mat getSigmaPoints(const Mat& mean, const Mat& covMatrix, double coef);
-
 public:
 
     AugmentedUnscentedKalmanFilterImpl(const AugmentedUnscentedKalmanFilterParams& params);
@@ -243,30 +201,26 @@ AugmentedUnscentedKalmanFilterImpl::AugmentedUnscentedKalmanFilterImpl(const Aug
 
     gain = Mat::zeros( DAug, DAug, dataType );
 
+    sigmaPoints = Mat::zeros( DAug, 2*DAug+1, dataType );
+    covMatrixL = Mat::zeros( DAug, DAug, dataType );
+
     transitionSPFuncVals = Mat::zeros( DP, 2*DAug+1, dataType );
     measurementSPFuncVals = Mat::zeros( MP, 2*DAug+1, dataType );
 
     transitionSPFuncValsCenter = Mat::zeros( DP, 2*DAug+1, dataType );
     measurementSPFuncValsCenter = Mat::zeros( MP, 2*DAug+1, dataType );
 
+    weightedState = Mat::zeros( DP, 2*DAug+1, dataType );
+    weightedMeasurement = Mat::zeros( MP, 2*DAug+1, dataType );
+
     lambda = alpha*alpha*( DAug + k ) - DAug;
     tmpLambda = lambda + DAug;
 
-    double tmp2Lambda = 0.5/tmpLambda;
-
-    Wm = tmp2Lambda * Mat::ones( 2*DAug+1, 1, dataType );
-    Wc = tmp2Lambda * Mat::eye( 2*DAug+1, 2*DAug+1, dataType );
-
-    if ( dataType == CV_64F )
-    {
-        Wm.at<double>(0,0) = lambda/tmpLambda;
-        Wc.at<double>(0,0) = lambda/tmpLambda + 1.0 - alpha*alpha + beta;
-    }
-    else
-    {
-        Wm.at<float>(0,0) = (float)(lambda/tmpLambda);
-        Wc.at<float>(0,0) = (float)(lambda/tmpLambda + 1.0 - alpha*alpha + beta);
-    }
+    Mat WcRow;
+    computeSigmaPointWeights( DAug, alpha, beta, lambda, dataType, Wm, WcRow );
+    WcState = repeat( WcRow, DP, 1 );
+    WcMeasurement = repeat( WcRow, MP, 1 );
+    onesRow = Mat::ones( 1, 2*DAug+1, dataType );
 
 }
 
@@ -292,7 +246,13 @@ AugmentedUnscentedKalmanFilterImpl::~AugmentedUnscentedKalmanFilterImpl()
     measurementSPFuncValsCenter.release();
 
     Wm.release();
-    Wc.release();
+    WcState.release();
+    WcMeasurement.release();
+    onesRow.release();
+
+    covMatrixL.release();
+    weightedState.release();
+    weightedMeasurement.release();
 
     gain.release();
     xyCov.release();
@@ -303,67 +263,26 @@ AugmentedUnscentedKalmanFilterImpl::~AugmentedUnscentedKalmanFilterImpl()
 
 }
 
-template <typename T>
-Mat AugmentedUnscentedKalmanFilterImpl::getSigmaPoints(const Mat &mean, const Mat &covMatrix, double coef)
-{
-// x_0 = mean
-// x_i = mean + coef * cholesky( covMatrix ), i = 1..n
-// x_(i+n) = mean - coef * cholesky( covMatrix ), i = 1..n
-
-    int n = mean.rows;
-    Mat points = repeat(mean, 1, 2*n+1);
-
-// covMatrixL = cholesky( covMatrix )
-    Mat covMatrixL = covMatrix.clone();
-    covMatrixL.setTo(0);
-
-    choleskyDecomposition<T>( covMatrix.ptr<T>(), covMatrix.step, covMatrix.rows, covMatrixL.ptr<T>() );
-    covMatrixL = coef * covMatrixL;
-
-    Mat p_plus = points( Rect( 1, 0, n, n ) );
-    Mat p_minus = points( Rect( n+1, 0, n, n ) );
-
-    add(p_plus, covMatrixL, p_plus);
-    subtract(p_minus, covMatrixL, p_minus);
-
-    return points;
-}
-
-Mat AugmentedUnscentedKalmanFilterImpl::getSigmaPoints(const Mat& mean, const Mat& covMatrix, double coef)
-{
-    if ( dataType == CV_64F ) return getSigmaPoints<double>(mean, covMatrix, coef);
-    if ( dataType == CV_32F ) return getSigmaPoints<float>(mean, covMatrix, coef);
-
-    return Mat();
-}
-
 Mat AugmentedUnscentedKalmanFilterImpl::predict(const Mat& control)
 {
 // get sigma points from xa* and Pa
-    sigmaPoints = getSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ) );
+    computeSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ), covMatrixL, sigmaPoints );
 
-// compute f-function values at sigma points
+// compute f-function values at all the sigma points at once
 // f_i = f(x_i[0:DP-1], control, x_i[DP:2*DP-1]), i = 0..2*DAug
-    Mat x, fx;
-    for ( int i = 0; i<2*DAug+1; i++)
-    {
-        x = sigmaPoints( Rect( i, 0, 1, DP) );
-        q = sigmaPoints( Rect( i, DP, 1, DP) );
-        fx = transitionSPFuncVals( Rect( i, 0, 1, DP) );
-        model->stateConversionFunction( x, control, q, fx );
-    }
+    q = sigmaPoints.rowRange( DP, 2*DP );
+    model->stateConversionFunctionBatch( sigmaPoints.rowRange( 0, DP ), control, q, transitionSPFuncVals );
 
 // compute the estimate of state as mean f-function value at sigma point
 // x* = SUM_{i=0}^{2*DAug}( Wm[i]*f_i )
-    state = transitionSPFuncVals * Wm;
-
-// compute f-function values at sigma points minus estimate of state
+// and f-function values at sigma points minus estimate of state
 // fc_i = f_i - x*, i = 0..2*DAug
-    subtract(transitionSPFuncVals, repeat( state, 1, 2*DAug+1 ), transitionSPFuncValsCenter);
+    centerSigmaPointValues( transitionSPFuncVals, Wm, onesRow, state, transitionSPFuncValsCenter );
 
 // compute the estimate of the state cross-covariance matrix
 // P = SUM_{i=0}^{2*DAug}( Wc[i]*fc_i*fc_i.t )
-    errorCov = transitionSPFuncValsCenter * Wc * transitionSPFuncValsCenter.t();
+    weightedSigmaPointCovariance( transitionSPFuncValsCenter, transitionSPFuncValsCenter, WcState, Mat(),
+                                  weightedState, errorCov );
 
     return state.clone();
 }
@@ -371,35 +290,28 @@ Mat AugmentedUnscentedKalmanFilterImpl::predict(const Mat& control)
 Mat AugmentedUnscentedKalmanFilterImpl::correct(const Mat& measurement)
 {
 // get sigma points from xa* and Pa
-    sigmaPoints = getSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ) );
+    computeSigmaPoints( stateAug, errorCovAug, sqrt( tmpLambda ), covMatrixL, sigmaPoints );
 
-// compute h-function values at sigma points
+// compute h-function values at all the sigma points at once
 // h_i = h(x_i[0:DP-1], x_i[2*DP:DAug-1]), i = 0..2*DAug
-    Mat x, hx;
-    measurementEstimate.setTo(0);
-    for ( int i = 0; i<2*DAug+1; i++)
-    {
-        x = transitionSPFuncVals( Rect( i, 0, 1, DP) );
-        r = sigmaPoints( Rect( i, 2*DP, 1, MP) );
-        hx = measurementSPFuncVals( Rect( i, 0, 1, MP) );
-        model->measurementFunction( x, r, hx );
-    }
+    r = sigmaPoints.rowRange( 2*DP, DAug );
+    model->measurementFunctionBatch( transitionSPFuncVals, r, measurementSPFuncVals );
 
 // compute the estimate of measurement as mean h-function value at sigma point
 // y* = SUM_{i=0}^{2*DAug}( Wm[i]*h_i )
-    measurementEstimate = measurementSPFuncVals * Wm;
-
-// compute h-function values at sigma points minus estimate of state
+// and h-function values at sigma points minus estimate of state
 // hc_i = h_i - y*, i = 0..2*DAug
-    subtract(measurementSPFuncVals, repeat( measurementEstimate, 1, 2*DAug+1 ), measurementSPFuncValsCenter);
+    centerSigmaPointValues( measurementSPFuncVals, Wm, onesRow, measurementEstimate, measurementSPFuncValsCenter );
 
 // compute the estimate of the y* cross-covariance matrix
 // Syy = SUM_{i=0}^{2*DAug}( Wc[i]*hc_i*hc_i.t )
-    yyCov = measurementSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t();
+    weightedSigmaPointCovariance( measurementSPFuncValsCenter, measurementSPFuncValsCenter, WcMeasurement, Mat(),
+                                  weightedMeasurement, yyCov );
 
 // compute the estimate of the covariance between x* and y*
 // Sxy = SUM_{i=0}^{2*DAug}( Wc[i]*fc_i*hc_i.t )
-    xyCov = transitionSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t();
+    weightedSigmaPointCovariance( transitionSPFuncValsCenter, measurementSPFuncValsCenter, WcState, Mat(),
+                                  weightedState, xyCov );
 
 // compute the Kalman gain matrix
 // K = Sxy * Syy^(-1)
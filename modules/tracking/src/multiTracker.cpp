@@ -653,4 +653,248 @@ namespace cv
 	}
 #endif
 
+	//Multitracker KCF
+	class KCFStageInvoker : public ParallelLoopBody
+	{
+	public:
+		enum Stage
+		{
+			DETECT_FEATURES,
+			TRAIN_FEATURES,
+			CORRELATE,
+			COMPUTE_KERNEL,
+			COMPUTE_RESPONSE,
+			LOCATE_TARGET,
+			ESTIMATE_SCALE,
+			UPDATE_COEFFICIENTS
+		};
+
+		KCFStageInvoker(Stage _stage, const std::vector<TrackerKCFImpl*>& _trackers, std::vector<uchar>& _active,
+			std::vector<std::vector<KCFDftJob> >& _jobs, const Mat* _images, const Mat* _grays, std::vector<Rect2d>& _boundingBoxes)
+			: stage(_stage), trackers(_trackers), active(_active), jobs(_jobs), images(_images), grays(_grays), boundingBoxes(_boundingBoxes)
+		{
+		}
+
+		void operator()(const Range& range) const
+		{
+			for (int k = range.start; k < range.end; k++)
+			{
+				if (!active[k])
+					continue;
+
+				TrackerKCFImpl* tracker = trackers[k];
+				int s = tracker->usesResizedImage() ? 1 : 0;
+				switch (stage)
+				{
+				case DETECT_FEATURES:
+					active[k] = tracker->detectFeatures(images[s], grays[s], jobs[k]);
+					break;
+				case TRAIN_FEATURES:
+					active[k] = tracker->trainFeatures(images[s], grays[s], boundingBoxes[k], jobs[k]);
+					break;
+				case CORRELATE:
+					tracker->correlate(jobs[k]);
+					break;
+				case COMPUTE_KERNEL:
+					tracker->computeKernel(jobs[k]);
+					break;
+				case COMPUTE_RESPONSE:
+					tracker->computeResponse(jobs[k]);
+					break;
+				case LOCATE_TARGET:
+					tracker->locateTarget();
+					break;
+				case ESTIMATE_SCALE:
+					tracker->estimateScale(images[s], grays[s]);
+					break;
+				case UPDATE_COEFFICIENTS:
+					tracker->updateCoefficients();
+					break;
+				}
+			}
+		}
+
+	private:
+		Stage stage;
+		const std::vector<TrackerKCFImpl*>& trackers;
+		std::vector<uchar>& active;
+		std::vector<std::vector<KCFDftJob> >& jobs;
+		const Mat* images;
+		const Mat* grays;
+		std::vector<Rect2d>& boundingBoxes;
+
+		KCFStageInvoker& operator=(const KCFStageInvoker&);
+	};
+
+	/*Runs the stage for the active targets in parallel, then the scheduled transforms of all targets together */
+	static void runKCFStage(KCFStageInvoker::Stage stage, const std::vector<TrackerKCFImpl*>& trackers, std::vector<uchar>& active,
+		const Mat* images, const Mat* grays, std::vector<Rect2d>& boundingBoxes)
+	{
+		std::vector<std::vector<KCFDftJob> > jobs(trackers.size());
+		parallel_for_(Range(0, (int)trackers.size()), KCFStageInvoker(stage, trackers, active, jobs, images, grays, boundingBoxes));
+
+		std::vector<KCFDftJob> allJobs;
+		for (size_t k = 0; k < jobs.size(); k++)
+			allJobs.insert(allJobs.end(), jobs[k].begin(), jobs[k].end());
+		runDftJobs(allJobs, true);
+	}
+
+	/*Optimized update method for KCF Multitracker */
+	bool MultiTrackerKCF::update_opt(const Mat& image)
+	{
+		if (image.empty())
+			return false;
+		CV_Assert(image.channels() == 1 || image.channels() == 3);
+
+		std::vector<TrackerKCFImpl*> kcfTrackers(trackers.size());
+		bool needResized = false, needGray = false;
+		for (size_t k = 0; k < trackers.size(); k++)
+		{
+			kcfTrackers[k] = dynamic_cast<TrackerKCFImpl*>(trackers[k].get());
+			CV_Assert(kcfTrackers[k] != NULL);
+			needResized = needResized || kcfTrackers[k]->usesResizedImage();
+			needGray = needGray || kcfTrackers[k]->usesGrayFeatures();
+		}
+
+		//Frame data shared by all targets: the frame, its resized version and their grayscale versions
+		Mat images[2], grays[2];
+		images[0] = image;
+		if (needResized)
+			resize(image, images[1], Size(image.cols / 2, image.rows / 2));
+		if (needGray && image.channels() == 3)
+		{
+			for (int s = 0; s < 2; s++)
+				if (!images[s].empty())
+					cvtColor(images[s], grays[s], COLOR_BGR2GRAY);
+		}
+
+		//Detection part
+		std::vector<uchar> detecting(trackers.size()), training(trackers.size(), 1);
+		for (size_t k = 0; k < trackers.size(); k++)
+			detecting[k] = kcfTrackers[k]->isDetecting();
+
+		runKCFStage(KCFStageInvoker::DETECT_FEATURES, kcfTrackers, detecting, images, grays, boundingBoxes);
+		runKCFStage(KCFStageInvoker::CORRELATE, kcfTrackers, detecting, images, grays, boundingBoxes);
+		runKCFStage(KCFStageInvoker::COMPUTE_KERNEL, kcfTrackers, detecting, images, grays, boundingBoxes);
+		runKCFStage(KCFStageInvoker::COMPUTE_RESPONSE, kcfTrackers, detecting, images, grays, boundingBoxes);
+		runKCFStage(KCFStageInvoker::LOCATE_TARGET, kcfTrackers, detecting, images, grays, boundingBoxes);
+		runKCFStage(KCFStageInvoker::ESTIMATE_SCALE, kcfTrackers, detecting, images, grays, boundingBoxes);
+
+		//The targets whose patch left the frame are not updated, as in TrackerKCF
+		for (size_t k = 0; k < trackers.size(); k++)
+			if (kcfTrackers[k]->isDetecting() && !detecting[k])
+				training[k] = 0;
+
+		//Learning part
+		runKCFStage(KCFStageInvoker::TRAIN_FEATURES, kcfTrackers, training, images, grays, boundingBoxes);
+		runKCFStage(KCFStageInvoker::CORRELATE, kcfTrackers, training, images, grays, boundingBoxes);
+		runKCFStage(KCFStageInvoker::COMPUTE_KERNEL, kcfTrackers, training, images, grays, boundingBoxes);
+		runKCFStage(KCFStageInvoker::UPDATE_COEFFICIENTS, kcfTrackers, training, images, grays, boundingBoxes);
+
+		bool result = true;
+		for (size_t k = 0; k < trackers.size(); k++)
+			result = result && training[k];
+
+		return result;
+	}
+
+
+	/*Finishes the updates of MedianFlow targets from their tracked grid points, every target is one work item */
+	class MedianFlowFinishInvoker : public ParallelLoopBody
+	{
+	public:
+		MedianFlowFinishInvoker(const std::vector<TrackerMedianFlowImpl*>& _trackers, const std::vector<int>& _targets,
+			const std::vector<int>& _offsets, const Ptr<MedianFlowFrame>& _newFrame, const std::vector<Point2f>& _oldPoints,
+			const std::vector<Point2f>& _newPoints, const std::vector<uchar>& _status, const std::vector<Point2f>& _reprojectedPoints,
+			std::vector<Rect2d>& _boundingBoxes, std::vector<uchar>& _results)
+			: trackers(_trackers), targets(_targets), offsets(_offsets), newFrame(_newFrame), oldPoints(_oldPoints),
+			newPoints(_newPoints), status(_status), reprojectedPoints(_reprojectedPoints), boundingBoxes(_boundingBoxes), results(_results)
+		{
+		}
+
+		void operator()(const Range& range) const
+		{
+			for (int i = range.start; i < range.end; i++)
+			{
+				int k = targets[i], begin = offsets[i], end = offsets[i + 1];
+				results[k] = trackers[k]->finishUpdate(newFrame,
+					std::vector<Point2f>(oldPoints.begin() + begin, oldPoints.begin() + end),
+					std::vector<Point2f>(newPoints.begin() + begin, newPoints.begin() + end),
+					std::vector<uchar>(status.begin() + begin, status.begin() + end),
+					std::vector<Point2f>(reprojectedPoints.begin() + begin, reprojectedPoints.begin() + end),
+					boundingBoxes[k]);
+			}
+		}
+
+	private:
+		const std::vector<TrackerMedianFlowImpl*>& trackers;
+		const std::vector<int>& targets;
+		const std::vector<int>& offsets;
+		const Ptr<MedianFlowFrame>& newFrame;
+		const std::vector<Point2f>& oldPoints;
+		const std::vector<Point2f>& newPoints;
+		const std::vector<uchar>& status;
+		const std::vector<Point2f>& reprojectedPoints;
+		std::vector<Rect2d>& boundingBoxes;
+		std::vector<uchar>& results;
+
+		MedianFlowFinishInvoker& operator=(const MedianFlowFinishInvoker&);
+	};
+
+	static bool sameMedianFlowFrame(const Ptr<MedianFlowFrame>& a, const Ptr<MedianFlowFrame>& b)
+	{
+		return a == b || (a->gray.size() == b->gray.size() && a->gray.type() == b->gray.type() &&
+			norm(a->gray, b->gray, NORM_INF) == 0);
+	}
+
+	/*Optimized update method for MedianFlow Multitracker */
+	bool MultiTrackerMedianFlow::update_opt(const Mat& image)
+	{
+		if (image.empty())
+			return false;
+
+		std::vector<TrackerMedianFlowImpl*> mfTrackers(trackers.size());
+		for (size_t k = 0; k < trackers.size(); k++)
+		{
+			mfTrackers[k] = dynamic_cast<TrackerMedianFlowImpl*>(trackers[k].get());
+			CV_Assert(mfTrackers[k] != NULL);
+		}
+
+		//The grayscale frame and its pyramid are shared by all targets
+		Ptr<MedianFlowFrame> newFrame = TrackerMedianFlowImpl::prepareFrame(image);
+
+		//The targets tracked from the same frame have all their grid points tracked together
+		std::vector<uchar> grouped(trackers.size(), 0), results(trackers.size(), 0);
+		for (size_t k = 0; k < trackers.size(); k++)
+		{
+			if (grouped[k])
+				continue;
+
+			Ptr<MedianFlowFrame> oldFrame = mfTrackers[k]->getFrame();
+			std::vector<int> targets, offsets(1, 0);
+			std::vector<Point2f> oldPoints, newPoints, reprojectedPoints, points;
+			std::vector<uchar> status;
+			for (size_t j = k; j < trackers.size(); j++)
+			{
+				if (grouped[j] || !sameMedianFlowFrame(oldFrame, mfTrackers[j]->getFrame()))
+					continue;
+				grouped[j] = 1;
+				mfTrackers[j]->getGridPoints(points);
+				oldPoints.insert(oldPoints.end(), points.begin(), points.end());
+				targets.push_back((int)j);
+				offsets.push_back((int)oldPoints.size());
+			}
+
+			TrackerMedianFlowImpl::trackPoints(*oldFrame, *newFrame, oldPoints, newPoints, status, reprojectedPoints);
+			parallel_for_(Range(0, (int)targets.size()), MedianFlowFinishInvoker(mfTrackers, targets, offsets, newFrame,
+				oldPoints, newPoints, status, reprojectedPoints, boundingBoxes, results));
+		}
+
+		bool result = true;
+		for (size_t k = 0; k < trackers.size(); k++)
+			result = result && results[k];
+
+		return result;
+	}
+
 }
\ No newline at end of file
@@ -45,6 +45,8 @@
 #include "precomp.hpp"
 #include "tldTracker.hpp"
 #include "tldUtils.hpp"
+#include "trackerKCF.hpp"
+#include "trackerMedianFlow.hpp"
 #include <math.h>
 
 namespace cv
@@ -103,10 +103,27 @@ namespace cv {
   };
 
   // update position of the tracked objects, the result is stored in internal storage
-  bool MultiTracker::update( const Mat& image){
-    for(unsigned i=0;i< trackerList.size(); i++){
-      trackerList[i]->update(image, objects[i]);
+  // every target is one work item, so the trackers are updated concurrently
+  class MultiTrackerUpdateInvoker : public ParallelLoopBody{
+  public:
+    MultiTrackerUpdateInvoker(const Mat& image_, std::vector< Ptr<Tracker> >& trackers_, std::vector<Rect2d>& objects_)
+      : image(image_), trackers(trackers_), objects(objects_){}
+
+    void operator()(const Range& range) const{
+      for(int i=range.start;i<range.end;i++){
+        trackers[i]->update(image, objects[i]);
+      }
     }
+
+  private:
+    const Mat& image;
+    std::vector< Ptr<Tracker> >& trackers;
+    std::vector<Rect2d>& objects;
+  };
+
+  bool MultiTracker::update( const Mat& image){
+    int n=(int)trackerList.size();
+    parallel_for_(Range(0,n), MultiTrackerUpdateInvoker(image, trackerList, objects), n);
     return true;
   };
 
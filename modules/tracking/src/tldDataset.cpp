@@ -152,7 +152,7 @@ namespace cv
 				}
 
 			strcpy(tldRootPath, rootPath);
-			strcat(tldRootPath, "\\");
+			strcat(tldRootPath, "/");
 			strcat(tldRootPath, folderName);
 
 
@@ -164,7 +164,7 @@ namespace cv
 			char fullPath[100];
 			char numStr[10];
 			strcpy(fullPath, tldRootPath);
-			strcat(fullPath, "\\");
+			strcat(fullPath, "/");
 			if (flagVOT)
 				strcat(fullPath, "000");
 			if (frameNum < 10) strcat(fullPath, "0000");
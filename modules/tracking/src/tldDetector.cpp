@@ -40,6 +40,8 @@
 //M*/
 
 #include "tldDetector.hpp"
+#include "opencv2/core/hal/intrin.hpp"
+#include <float.h>
 
 namespace cv
 {
@@ -62,25 +64,108 @@ namespace cv
 			return p;
 		}
 
-		// Calculate Relative similarity of the patch (NN-Model)
-		double TLDDetector::Sr(const Mat_<uchar>& patch)
+		// Sum and sum of squares of the model sample and its dot product with the patch
+		static inline void sampleStats(const uchar* sample, const uchar* patch, int len, int& sum, int& sqSum, int& prod)
 		{
-			double splus = 0.0, sminus = 0.0;
-			Mat_<uchar> modelSample(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE);
+			int i = 0;
+			sum = sqSum = prod = 0;
+#if CV_SIMD128
+			v_int32x4 vsum = v_setzero_s32(), vsqsum = v_setzero_s32(), vprod = v_setzero_s32();
+			v_int16x8 vone = v_setall_s16(1);
+			for (; i <= len - 16; i += 16)
+			{
+				v_uint16x8 s0, s1, p0, p1;
+				v_expand(v_load(sample + i), s0, s1);
+				v_expand(v_load(patch + i), p0, p1);
+				v_int16x8 a0 = v_reinterpret_as_s16(s0), a1 = v_reinterpret_as_s16(s1);
+				v_int16x8 b0 = v_reinterpret_as_s16(p0), b1 = v_reinterpret_as_s16(p1);
+				vsum += v_dotprod(a0, vone) + v_dotprod(a1, vone);
+				vsqsum += v_dotprod(a0, a0) + v_dotprod(a1, a1);
+				vprod += v_dotprod(a0, b0) + v_dotprod(a1, b1);
+			}
+			sum = v_reduce_sum(vsum);
+			sqSum = v_reduce_sum(vsqsum);
+			prod = v_reduce_sum(vprod);
+#endif
+			for (; i < len; i++)
+			{
+				int a = sample[i], b = patch[i];
+				sum += a;
+				sqSum += a * a;
+				prod += a * b;
+			}
+		}
+
+		// Same as NCC(), but from the precomputed sums of both patches
+		static inline double nccFromStats(int N, int s1, int n1, int s2, int n2, int prod)
+		{
+			double sq1 = sqrt(std::max(0.0, n1 - 1.0 * s1 * s1 / N)), sq2 = sqrt(std::max(0.0, n2 - 1.0 * s2 * s2 / N));
+			return (sq2 == 0) ? sq1 / std::abs(sq1) : (prod - s1 * s2 / N) / sq1 / sq2;
+		}
+
+		// Calculate Relative (srValue) and Conservative (scValue) similarity of the patch (NN-Model) in one pass.
+		// Positive examples newer than medianTimeStamp are ignored for scValue.
+		void TLDDetector::nnSimilarity(const Mat_<uchar>& patch, int medianTimeStamp, double& srValue, double& scValue) const
+		{
+			const int N = STANDARD_PATCH_SIZE * STANDARD_PATCH_SIZE;
+			CV_Assert(patch.rows * patch.cols == N);
+			Mat_<uchar> contPatch = patch.isContinuous() ? patch : patch.clone();
+			const uchar* patchData = contPatch.data;
+
+			int s2, n2, s1, n1, prod;
+			sampleStats(patchData, patchData, N, s2, n2, prod);
+
+			double splusR = 0.0, splusC = 0.0, sminus = 0.0;
 			for (int i = 0; i < *posNum; i++)
 			{
-				modelSample.data = &(posExp->data[i * 225]);
-				splus = std::max(splus, 0.5 * (NCC(modelSample, patch) + 1.0));
+				sampleStats(&(posExp->data[i * N]), patchData, N, s1, n1, prod);
+				double s = 0.5 * (nccFromStats(N, s1, n1, s2, n2, prod) + 1.0);
+				splusR = std::max(splusR, s);
+				if ((int)(*timeStampsPositive)[i] <= medianTimeStamp)
+					splusC = std::max(splusC, s);
 			}
 			for (int i = 0; i < *negNum; i++)
 			{
-				modelSample.data = &(negExp->data[i * 225]);
-				sminus = std::max(sminus, 0.5 * (NCC(modelSample, patch) + 1.0));
+				sampleStats(&(negExp->data[i * N]), patchData, N, s1, n1, prod);
+				sminus = std::max(sminus, 0.5 * (nccFromStats(N, s1, n1, s2, n2, prod) + 1.0));
 			}
 
-			if (splus + sminus == 0.0)
-				return 0.0;
-			return splus / (sminus + splus);
+			srValue = (splusR + sminus == 0.0) ? 0.0 : splusR / (sminus + splusR);
+			scValue = (splusC + sminus == 0.0) ? 0.0 : splusC / (sminus + splusC);
+		}
+
+		// Index of the stored positive or negative example with the highest NCC to the patch, -1 if there are none
+		int TLDDetector::closestExample(const Mat_<uchar>& patch, bool positive) const
+		{
+			const int N = STANDARD_PATCH_SIZE * STANDARD_PATCH_SIZE;
+			CV_Assert(patch.rows * patch.cols == N);
+			Mat_<uchar> contPatch = patch.isContinuous() ? patch : patch.clone();
+			const uchar* patchData = contPatch.data;
+			const Mat& examples = positive ? *posExp : *negExp;
+			int num = positive ? *posNum : *negNum;
+
+			int s2, n2, s1, n1, prod, closest = -1;
+			sampleStats(patchData, patchData, N, s2, n2, prod);
+			double maxNCC = -DBL_MAX;
+			for (int i = 0; i < num; i++)
+			{
+				sampleStats(examples.ptr(i), patchData, N, s1, n1, prod);
+				double ncc = nccFromStats(N, s1, n1, s2, n2, prod);
+				if (ncc > maxNCC)
+				{
+					maxNCC = ncc;
+					closest = i;
+				}
+			}
+			return closest;
+		}
+
+		// Calculate Relative similarity of the patch (NN-Model)
+		double TLDDetector::Sr(const Mat_<uchar>& patch)
+		{
+			double srValue, scValue;
+			nnSimilarity(patch, INT_MAX, srValue, scValue);
+			return srValue;
 		}
 
 #ifdef HAVE_OPENCL
@@ -191,27 +276,9 @@ namespace cv
 		// Calculate Conservative similarity of the patch (NN-Model)
 		double TLDDetector::Sc(const Mat_<uchar>& patch)
 		{
-			double splus = 0.0, sminus = 0.0;
-			Mat_<uchar> modelSample(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE);
-			int med = getMedian((*timeStampsPositive));
-			for (int i = 0; i < *posNum; i++)
-			{
-				if ((int)(*timeStampsPositive)[i] <= med)
-				{
-					modelSample.data = &(posExp->data[i * 225]);
-					splus = std::max(splus, 0.5 * (NCC(modelSample, patch) + 1.0));
-				}
-			}
-			for (int i = 0; i < *negNum; i++)
-			{
-				modelSample.data = &(negExp->data[i * 225]);
-				sminus = std::max(sminus, 0.5 * (NCC(modelSample, patch) + 1.0));
-			}
-
-			if (splus + sminus == 0.0)
-				return 0.0;
-
-			return splus / (sminus + splus);
+			double srValue, scValue;
+			nnSimilarity(patch, getMedian((*timeStampsPositive)), srValue, scValue);
+			return scValue;
 		}
 
 #ifdef HAVE_OPENCL
@@ -296,94 +363,193 @@ namespace cv
 			}
 		}
 
-		//Detection - returns most probable new target location (Max Sc)
-
-		bool TLDDetector::detect(const Mat& img, const Mat& imgBlurred, Rect2d& res, std::vector<LabeledPatch>& patches, Size initSize)
+		// Variance filter and ensemble classifier over the scanning windows of all the scales.
+		// Each work item is one column of the grid of one scale, the verdicts are written to mask,
+		// column by column in the same order as the windows are scanned.
+		class VarianceEnsembleInvoker : public ParallelLoopBody
 		{
-			patches.clear();
-			Mat_<uchar> standardPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE);
-			Mat tmp;
-			int dx = initSize.width / 10, dy = initSize.height / 10;
-			Size2d size = img.size();
-			double scale = 1.0;
-			int npos = 0, nneg = 0;
-			double maxSc = -5.0;
-			Rect2d maxScRect;
-			int scaleID;
-			std::vector <Mat> resized_imgs, blurred_imgs;
-			std::vector <Point> varBuffer, ensBuffer;
-			std::vector <int> varScaleIDs, ensScaleIDs;
+		public:
+			VarianceEnsembleInvoker(TLDDetector* detector_, const std::vector<Mat_<double> >& intImgP_, const std::vector<Mat_<double> >& intImgP2_,
+				const std::vector<Mat>& blurred_imgs_, const std::vector<int>& firstColumn_, const std::vector<int>& firstWindow_,
+				const std::vector<int>& windowsPerColumn_, Size initSize_, uchar* mask_)
+				: detector(detector_), intImgP(intImgP_), intImgP2(intImgP2_), blurred_imgs(blurred_imgs_), firstColumn(firstColumn_),
+				firstWindow(firstWindow_), windowsPerColumn(windowsPerColumn_), initSize(initSize_), mask(mask_)
+			{
+				dx = initSize.width / 10;
+				dy = initSize.height / 10;
+			}
 
-			//Detection part
-			//Generate windows and filter by variance
-			scaleID = 0;
-			resized_imgs.push_back(img);
-			blurred_imgs.push_back(imgBlurred);
-			do
+			void operator()(const Range& range) const
 			{
-				Mat_<double> intImgP, intImgP2;
-				computeIntegralImages(resized_imgs[scaleID], intImgP, intImgP2);
-				for (int i = 0, imax = cvFloor((0.0 + resized_imgs[scaleID].cols - initSize.width) / dx); i < imax; i++)
+				for (int c = range.start; c < range.end; c++)
 				{
-					for (int j = 0, jmax = cvFloor((0.0 + resized_imgs[scaleID].rows - initSize.height) / dy); j < jmax; j++)
+					int scaleID = (int)(std::upper_bound(firstColumn.begin(), firstColumn.end(), c) - firstColumn.begin()) - 1;
+					int i = c - firstColumn[scaleID], jmax = windowsPerColumn[scaleID];
+					uchar* verdicts = mask + firstWindow[scaleID] + i * jmax;
+					for (int j = 0; j < jmax; j++)
 					{
-						if (!patchVariance(intImgP, intImgP2, originalVariancePtr, Point(dx * i, dy * j), initSize))
-							continue;
-						varBuffer.push_back(Point(dx * i, dy * j));
-						varScaleIDs.push_back(scaleID);
+						Point pt(dx * i, dy * j);
+						verdicts[j] = TLDDetector::patchVariance(intImgP[scaleID], intImgP2[scaleID], detector->originalVariancePtr, pt, initSize) &&
+							detector->ensembleClassifierNum(&blurred_imgs[scaleID].at<uchar>(pt.y, pt.x)) > ENSEMBLE_THRESHOLD;
 					}
 				}
-				scaleID++;
+			}
+
+		private:
+			TLDDetector* detector;
+			const std::vector<Mat_<double> >& intImgP, & intImgP2;
+			const std::vector<Mat>& blurred_imgs;
+			const std::vector<int>& firstColumn, & firstWindow, & windowsPerColumn;
+			Size initSize;
+			int dx, dy;
+			uchar* mask;
+		};
+
+		// Builds the scales pyramid and returns the windows that pass the variance filter and the ensemble classifier
+		void TLDDetector::scanGrid(const Mat& img, const Mat& imgBlurred, Size initSize, std::vector<Mat>& resized_imgs,
+			std::vector<Point>& ensBuffer, std::vector<int>& ensScaleIDs)
+		{
+			CV_Assert(imgBlurred.size() == img.size() && imgBlurred.type() == img.type());
+			int dx = initSize.width / 10, dy = initSize.height / 10;
+			std::vector<Size> sizes;
+			Size2d size = img.size();
+			do
+			{
+				sizes.push_back(size);
 				size.width /= SCALE_STEP;
 				size.height /= SCALE_STEP;
-				scale *= SCALE_STEP;
-				resize(img, tmp, size, 0, 0, DOWNSCALE_MODE);
-				resized_imgs.push_back(tmp);
-				GaussianBlur(resized_imgs[scaleID], tmp, GaussBlurKernelSize, 0.0f);
-				blurred_imgs.push_back(tmp);
 			} while (size.width >= initSize.width && size.height >= initSize.height);
+			int nscales = (int)sizes.size();
+
+			//Blurred images of all the scales share one buffer, so the classifiers offsets
+			//are the same for every scale and have to be prepared only once
+			int totalRows = 0;
+			for (int k = 0; k < nscales; k++)
+				totalRows += sizes[k].height;
+			Mat blurredPyr(totalRows, img.cols, img.type());
+			std::vector<Mat> blurred_imgs(nscales);
+			std::vector<Mat_<double> > intImgP(nscales), intImgP2(nscales);
+			std::vector<int> firstColumn(nscales), firstWindow(nscales), windowsPerColumn(nscales);
+			int totalColumns = 0, totalWindows = 0;
+
+			resized_imgs.resize(nscales);
+			for (int k = 0, row = 0; k < nscales; row += sizes[k].height, k++)
+			{
+				blurred_imgs[k] = blurredPyr(Rect(0, row, sizes[k].width, sizes[k].height));
+				if (k == 0)
+				{
+					resized_imgs[k] = img;
+					imgBlurred.copyTo(blurred_imgs[k]);
+				}
+				else
+				{
+					resize(img, resized_imgs[k], sizes[k], 0, 0, DOWNSCALE_MODE);
+					GaussianBlur(resized_imgs[k], blurred_imgs[k], GaussBlurKernelSize, 0.0f);
+				}
+				computeIntegralImages(resized_imgs[k], intImgP[k], intImgP2[k]);
+
+				int imax = std::max(0, cvFloor((0.0 + sizes[k].width - initSize.width) / dx));
+				int jmax = std::max(0, cvFloor((0.0 + sizes[k].height - initSize.height) / dy));
+				firstColumn[k] = totalColumns;
+				firstWindow[k] = totalWindows;
+				windowsPerColumn[k] = jmax;
+				totalColumns += imax;
+				totalWindows += imax * jmax;
+			}
+
+			prepareClassifiers((int)blurredPyr.step[0]);
+			std::vector<uchar> mask(totalWindows);
+			parallel_for_(Range(0, totalColumns), VarianceEnsembleInvoker(this, intImgP, intImgP2, blurred_imgs,
+				firstColumn, firstWindow, windowsPerColumn, initSize, mask.empty() ? NULL : &mask[0]));
 
-			//Encsemble classification
-			for (int i = 0; i < (int)varBuffer.size(); i++)
+			ensBuffer.clear();
+			ensScaleIDs.clear();
+			for (int k = 0; k < nscales; k++)
+			{
+				int jmax = windowsPerColumn[k];
+				int kmax = (k + 1 < nscales ? firstWindow[k + 1] : totalWindows) - firstWindow[k];
+				for (int w = 0; w < kmax; w++)
+				{
+					if (!mask[firstWindow[k] + w])
+						continue;
+					ensBuffer.push_back(Point(dx * (w / jmax), dy * (w % jmax)));
+					ensScaleIDs.push_back(k);
+				}
+			}
+		}
+
+		// NN classification of the windows that passed the ensemble classifier
+		class NNClassifierInvoker : public ParallelLoopBody
+		{
+		public:
+			NNClassifierInvoker(const TLDDetector* detector_, const std::vector<Mat>& resized_imgs_, const std::vector<Point>& ensBuffer_,
+				const std::vector<int>& ensScaleIDs_, Size initSize_, int medianTimeStamp_, double* srValues_, double* scValues_)
+				: detector(detector_), resized_imgs(resized_imgs_), ensBuffer(ensBuffer_), ensScaleIDs(ensScaleIDs_),
+				initSize(initSize_), medianTimeStamp(medianTimeStamp_), srValues(srValues_), scValues(scValues_)
 			{
-				prepareClassifiers(static_cast<int> (blurred_imgs[varScaleIDs[i]].step[0]));
-				if (ensembleClassifierNum(&blurred_imgs[varScaleIDs[i]].at<uchar>(varBuffer[i].y, varBuffer[i].x)) <= ENSEMBLE_THRESHOLD)
-					continue;
-				ensBuffer.push_back(varBuffer[i]);
-				ensScaleIDs.push_back(varScaleIDs[i]);
 			}
 
+			void operator()(const Range& range) const
+			{
+				Mat_<uchar> standardPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE);
+				for (int i = range.start; i < range.end; i++)
+				{
+					resample(resized_imgs[ensScaleIDs[i]], Rect2d(ensBuffer[i], initSize), standardPatch);
+					detector->nnSimilarity(standardPatch, medianTimeStamp, srValues[i], scValues[i]);
+				}
+			}
+
+		private:
+			const TLDDetector* detector;
+			const std::vector<Mat>& resized_imgs;
+			const std::vector<Point>& ensBuffer;
+			const std::vector<int>& ensScaleIDs;
+			Size initSize;
+			int medianTimeStamp;
+			double *srValues, *scValues;
+		};
+
+		//Detection - returns most probable new target location (Max Sc)
+
+		bool TLDDetector::detect(const Mat& img, const Mat& imgBlurred, Rect2d& res, std::vector<LabeledPatch>& patches, Size initSize)
+		{
+			patches.clear();
+			double maxSc = -5.0;
+			Rect2d maxScRect;
+			std::vector <Mat> resized_imgs;
+			std::vector <Point> ensBuffer;
+			std::vector <int> ensScaleIDs;
+
+			//Detection part
+			//Generate windows and filter by variance and by the ensemble classifier
+			scanGrid(img, imgBlurred, initSize, resized_imgs, ensBuffer, ensScaleIDs);
+
 			//NN classification
-			for (int i = 0; i < (int)ensBuffer.size(); i++)
+			int numOfPatches = (int)ensBuffer.size();
+			if (numOfPatches == 0)
+				return false;
+			std::vector<double> srValues(numOfPatches), scValues(numOfPatches);
+			parallel_for_(Range(0, numOfPatches), NNClassifierInvoker(this, resized_imgs, ensBuffer, ensScaleIDs, initSize,
+				getMedian((*timeStampsPositive)), &srValues[0], &scValues[0]));
+
+			for (int i = 0; i < numOfPatches; i++)
 			{
 				LabeledPatch labPatch;
 				double curScale = pow(SCALE_STEP, ensScaleIDs[i]);
 				labPatch.rect = Rect2d(ensBuffer[i].x*curScale, ensBuffer[i].y*curScale, initSize.width * curScale, initSize.height * curScale);
-				resample(resized_imgs[ensScaleIDs[i]], Rect2d(ensBuffer[i], initSize), standardPatch);
-
-				double srValue, scValue;
-				srValue = Sr(standardPatch);
 
 				////To fix: Check the paper, probably this cause wrong learning
 				//
-				labPatch.isObject = srValue > THETA_NN;
-				labPatch.shouldBeIntegrated = abs(srValue - THETA_NN) < 0.1;
+				labPatch.isObject = srValues[i] > THETA_NN;
+				labPatch.shouldBeIntegrated = abs(srValues[i] - THETA_NN) < 0.1;
 				patches.push_back(labPatch);
 				//
 
 				if (!labPatch.isObject)
-				{
-					nneg++;
 					continue;
-				}
-				else
-				{
-					npos++;
-				}
-				scValue = Sc(standardPatch);
-				if (scValue > maxSc)
+				if (scValues[i] > maxSc)
 				{
-					maxSc = scValue;
+					maxSc = scValues[i];
 					maxScRect = labPatch.rect;
 				}
 			}
@@ -402,56 +568,16 @@ namespace cv
 		{
 			patches.clear();
 			Mat_<uchar> standardPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE);
-			Mat tmp;
-			int dx = initSize.width / 10, dy = initSize.height / 10;
-			Size2d size = img.size();
-			double scale = 1.0;
 			int npos = 0, nneg = 0;
 			double maxSc = -5.0;
 			Rect2d maxScRect;
-			int scaleID;
-			std::vector <Mat> resized_imgs, blurred_imgs;
-			std::vector <Point> varBuffer, ensBuffer;
-			std::vector <int> varScaleIDs, ensScaleIDs;
+			std::vector <Mat> resized_imgs;
+			std::vector <Point> ensBuffer;
+			std::vector <int> ensScaleIDs;
 
 			//Detection part
-			//Generate windows and filter by variance
-			scaleID = 0;
-			resized_imgs.push_back(img);
-			blurred_imgs.push_back(imgBlurred);
-			do
-			{
-				Mat_<double> intImgP, intImgP2;
-				computeIntegralImages(resized_imgs[scaleID], intImgP, intImgP2);
-				for (int i = 0, imax = cvFloor((0.0 + resized_imgs[scaleID].cols - initSize.width) / dx); i < imax; i++)
-				{
-					for (int j = 0, jmax = cvFloor((0.0 + resized_imgs[scaleID].rows - initSize.height) / dy); j < jmax; j++)
-					{
-						if (!patchVariance(intImgP, intImgP2, originalVariancePtr, Point(dx * i, dy * j), initSize))
-							continue;
-						varBuffer.push_back(Point(dx * i, dy * j));
-						varScaleIDs.push_back(scaleID);
-					}
-				}
-				scaleID++;
-				size.width /= SCALE_STEP;
-				size.height /= SCALE_STEP;
-				scale *= SCALE_STEP;
-				resize(img, tmp, size, 0, 0, DOWNSCALE_MODE);
-				resized_imgs.push_back(tmp);
-				GaussianBlur(resized_imgs[scaleID], tmp, GaussBlurKernelSize, 0.0f);
-				blurred_imgs.push_back(tmp);
-			} while (size.width >= initSize.width && size.height >= initSize.height);
-
-			//Encsemble classification
-			for (int i = 0; i < (int)varBuffer.size(); i++)
-			{
-				prepareClassifiers((int)blurred_imgs[varScaleIDs[i]].step[0]);
-				if (ensembleClassifierNum(&blurred_imgs[varScaleIDs[i]].at<uchar>(varBuffer[i].y, varBuffer[i].x)) <= ENSEMBLE_THRESHOLD)
-					continue;
-				ensBuffer.push_back(varBuffer[i]);
-				ensScaleIDs.push_back(varScaleIDs[i]);
-			}
+			//Generate windows and filter by variance and by the ensemble classifier
+			scanGrid(img, imgBlurred, initSize, resized_imgs, ensBuffer, ensScaleIDs);
 
 			//NN classification
 			//Prepare batch of patches
@@ -516,7 +642,7 @@ namespace cv
 
 		// Computes the variance of subimage given by box, with the help of two integral
 		// images intImgP and intImgP2 (sum of squares), which should be also provided.
-		bool TLDDetector::patchVariance(Mat_<double>& intImgP, Mat_<double>& intImgP2, double *originalVariance, Point pt, Size size)
+		bool TLDDetector::patchVariance(const Mat_<double>& intImgP, const Mat_<double>& intImgP2, const double *originalVariance, Point pt, Size size)
 		{
 			int x = (pt.x), y = (pt.y), width = (size.width), height = (size.height);
 			CV_Assert(0 <= x && (x + width) < intImgP.cols && (x + width) < intImgP2.cols);
@@ -77,6 +77,8 @@ namespace cv
 			void prepareClassifiers(int rowstep);
 			double Sr(const Mat_<uchar>& patch);
 			double Sc(const Mat_<uchar>& patch);
+			void nnSimilarity(const Mat_<uchar>& patch, int medianTimeStamp, double& srValue, double& scValue) const;
+			int closestExample(const Mat_<uchar>& patch, bool positive) const;
 #ifdef HAVE_OPENCL
 			double ocl_Sr(const Mat_<uchar>& patch);
 			double ocl_Sc(const Mat_<uchar>& patch);
@@ -86,7 +88,6 @@ namespace cv
 			std::vector<TLDEnsembleClassifier> classifiers;
 			Mat *posExp, *negExp;
 			int *posNum, *negNum;
-			std::vector<Mat_<uchar> > *positiveExamples, *negativeExamples;
 			std::vector<int> *timeStampsPositive, *timeStampsNegative;
 			double *originalVariancePtr;
 
@@ -98,10 +99,12 @@ namespace cv
 			};
 			bool detect(const Mat& img, const Mat& imgBlurred, Rect2d& res, std::vector<LabeledPatch>& patches, Size initSize);
 			bool ocl_detect(const Mat& img, const Mat& imgBlurred, Rect2d& res, std::vector<LabeledPatch>& patches,  Size initSize);
+			void scanGrid(const Mat& img, const Mat& imgBlurred, Size initSize, std::vector<Mat>& resized_imgs,
+				std::vector<Point>& ensBuffer, std::vector<int>& ensScaleIDs);
 
 			friend class MyMouseCallbackDEBUG;
 			static void computeIntegralImages(const Mat& img, Mat_<double>& intImgP, Mat_<double>& intImgP2){ integral(img, intImgP, intImgP2, CV_64F); }
-			static inline bool patchVariance(Mat_<double>& intImgP, Mat_<double>& intImgP2, double *originalVariance, Point pt, Size size);
+			static inline bool patchVariance(const Mat_<double>& intImgP, const Mat_<double>& intImgP2, const double *originalVariance, Point pt, Size size);
 		};
 
 
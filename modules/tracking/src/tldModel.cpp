@@ -58,15 +58,16 @@ namespace cv
 			//Propagate data to Detector
 			posNum = 0;
 			negNum = 0;
-			posExp = Mat(Size(225, 500), CV_8UC1);
-			negExp = Mat(Size(225, 500), CV_8UC1);
+			CV_Assert(0 < params_.maxExamples && params_.maxExamples <= MAX_EXAMPLES_IN_MODEL);
+			CV_Assert(params_.evictionPolicy >= TrackerTLD::Params::EVICT_RANDOM &&
+				params_.evictionPolicy <= TrackerTLD::Params::EVICT_LEAST_INFORMATIVE);
+			posExp = Mat(Size(225, params_.maxExamples), CV_8UC1);
+			negExp = Mat(Size(225, params_.maxExamples), CV_8UC1);
 			detector->posNum = &posNum;
 			detector->negNum = &negNum;
 			detector->posExp = &posExp;
 			detector->negExp = &negExp;
 
-			detector->positiveExamples = &positiveExamples;
-			detector->negativeExamples = &negativeExamples;
 			detector->timeStampsPositive = &timeStampsPositive;
 			detector->timeStampsNegative = &timeStampsNegative;
 			detector->originalVariancePtr = &originalVariance_;
@@ -83,8 +84,6 @@ namespace cv
 			TLDEnsembleClassifier::makeClassifiers(minSize, MEASURES_PER_CLASSIFIER, GRIDSIZE, detector->classifiers);
 
 			//Generate initial positive samples and put them to the model
-			positiveExamples.reserve(200);
-
 			for (int i = 0; i < (int)closest.size(); i++)
 			{
 				for (int j = 0; j < 20; j++)
@@ -122,11 +121,9 @@ namespace cv
 
 			//Generate initial negative samples and put them to the model
 			TLDDetector::generateScanGrid(image.rows, image.cols, minSize, scanGrid, true);
-			negativeExamples.clear();
-			negativeExamples.reserve(NEG_EXAMPLES_IN_INIT_MODEL);
 			std::vector<int> indices;
 			indices.reserve(NEG_EXAMPLES_IN_INIT_MODEL);
-			while ((int)negativeExamples.size() < NEG_EXAMPLES_IN_INIT_MODEL)
+			for (int pushed = 0; pushed < NEG_EXAMPLES_IN_INIT_MODEL;)
 			{
 				int i = rng.uniform((int)0, (int)scanGrid.size());
 				if (std::find(indices.begin(), indices.end(), i) == indices.end() && overlap(boundingBox, scanGrid[i]) < NEXPERT_THRESHOLD)
@@ -134,6 +131,7 @@ namespace cv
 					Mat_<uchar> standardPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE);
 					resample(image, scanGrid[i], standardPatch);
 					pushIntoModel(standardPatch, false);
+					pushed++;
 
 					resample(image_blurred, scanGrid[i], blurredPatch);
 					for (int k = 0; k < (int)detector->classifiers.size(); k++)
@@ -277,58 +275,61 @@ namespace cv
 		//Push the patch to the model
 		void TrackerTLDModel::pushIntoModel(const Mat_<uchar>& example, bool positive)
 		{
-			std::vector<Mat_<uchar> >* proxyV;
-			int* proxyN;
-			std::vector<int>* proxyT;
-			if (positive)
-			{
-				if (posNum < 500)
-				{
-					uchar *patchPtr = example.data;
-					uchar *modelPtr = posExp.data;
-					for (int i = 0; i < STANDARD_PATCH_SIZE*STANDARD_PATCH_SIZE; i++)
-						modelPtr[posNum*STANDARD_PATCH_SIZE*STANDARD_PATCH_SIZE + i] = patchPtr[i];
-					posNum++;
-				}
+			Mat& store = positive ? posExp : negExp;
+			int& num = positive ? posNum : negNum;
+			std::vector<int>& timeStamps = positive ? timeStampsPositive : timeStampsNegative;
+			int& timeStampNext = positive ? timeStampPositiveNext : timeStampNegativeNext;
 
-				proxyV = &positiveExamples;
-				proxyN = &timeStampPositiveNext;
-				proxyT = &timeStampsPositive;
-			}
-			else
+			int index = (num < store.rows) ? num : chooseEvicted(example, positive);
+			if (index >= 0)
 			{
-				if (negNum < 500)
+				Mat storedPatch(STANDARD_PATCH_SIZE, STANDARD_PATCH_SIZE, CV_8UC1, store.ptr(index));
+				example.copyTo(storedPatch);
+				if (index == num)
 				{
-					uchar *patchPtr = example.data;
-					uchar *modelPtr = negExp.data;
-					for (int i = 0; i < STANDARD_PATCH_SIZE*STANDARD_PATCH_SIZE; i++)
-						modelPtr[negNum*STANDARD_PATCH_SIZE*STANDARD_PATCH_SIZE + i] = patchPtr[i];
-					negNum++;
+					num++;
+					timeStamps.push_back(timeStampNext);
 				}
-
-				proxyV = &negativeExamples;
-				proxyN = &timeStampNegativeNext;
-				proxyT = &timeStampsNegative;
+				else
+					timeStamps[index] = timeStampNext;
 			}
-			if ((int)proxyV->size() < MAX_EXAMPLES_IN_MODEL)
+			timeStampNext++;
+		}
+
+		//Choose the exemplar to be replaced by the new one when the store is full, -1 to drop the new one
+		int TrackerTLDModel::chooseEvicted(const Mat_<uchar>& example, bool positive)
+		{
+			int num = positive ? posNum : negNum;
+			const std::vector<int>& timeStamps = positive ? timeStampsPositive : timeStampsNegative;
+			int seen = positive ? timeStampPositiveNext : timeStampNegativeNext;
+
+			switch (params_.evictionPolicy)
+			{
+			case TrackerTLD::Params::EVICT_OLDEST:
+				return (int)(std::min_element(timeStamps.begin(), timeStamps.end()) - timeStamps.begin());
+			case TrackerTLD::Params::EVICT_RESERVOIR:
 			{
-				proxyV->push_back(example);
-				proxyT->push_back(*proxyN);
+				int index = rng.uniform(0, seen + 1);
+				return (index < num) ? index : -1;
 			}
-			else
+			case TrackerTLD::Params::EVICT_LEAST_INFORMATIVE:
 			{
-				int index = rng.uniform((int)0, (int)proxyV->size());
-				(*proxyV)[index] = example;
-				(*proxyT)[index] = (*proxyN);
+				int index = detector->closestExample(example, positive);
+				if (index >= 0)
+					return index;
+				break;
+			}
+			default:
+				break;
 			}
-			(*proxyN)++;
+			return rng.uniform(0, num);
 		}
 
 		void TrackerTLDModel::printme(FILE* port)
 		{
 			dfprintf((port, "TrackerTLDModel:\n"));
-			dfprintf((port, "\tpositiveExamples.size() = %d\n", (int)positiveExamples.size()));
-			dfprintf((port, "\tnegativeExamples.size() = %d\n", (int)negativeExamples.size()));
+			dfprintf((port, "\tposNum = %d\n", posNum));
+			dfprintf((port, "\tnegNum = %d\n", negNum));
 		}
 	}
 }
\ No newline at end of file
@@ -65,7 +65,7 @@ namespace cv
 			void printme(FILE* port = stdout);
 			Ptr<TLDDetector> detector;
 
-			std::vector<Mat_<uchar> > positiveExamples, negativeExamples;
+			//Positive and negative exemplars, one patch per row; the first posNum/negNum rows are used
 			Mat posExp, negExp;
 			int posNum, negNum;
 			std::vector<int> timeStampsPositive, timeStampsNegative;
@@ -78,6 +78,7 @@ namespace cv
 			Size minSize_;
 			TrackerTLD::Params params_;
 			void pushIntoModel(const Mat_<uchar>& example, bool positive);
+			int chooseEvicted(const Mat_<uchar>& example, bool positive);
 			void modelEstimationImpl(const std::vector<Mat>& /*responses*/){}
 			void modelUpdateImpl(){}
 			Rect2d boundingBox_;
@@ -45,11 +45,23 @@
 namespace cv
 {
 
-	TrackerTLD::Params::Params(){}
-
-	void TrackerTLD::Params::read(const cv::FileNode& /*fn*/){}
-
-	void TrackerTLD::Params::write(cv::FileStorage& /*fs*/) const {}
+	TrackerTLD::Params::Params()
+	{
+		maxExamples = tld::MAX_EXAMPLES_IN_MODEL;
+		evictionPolicy = EVICT_RANDOM;
+	}
+
+	void TrackerTLD::Params::read(const cv::FileNode& fn)
+	{
+		maxExamples = fn["maxExamples"];
+		evictionPolicy = fn["evictionPolicy"];
+	}
+
+	void TrackerTLD::Params::write(cv::FileStorage& fs) const
+	{
+		fs << "maxExamples" << maxExamples;
+		fs << "evictionPolicy" << evictionPolicy;
+	}
 
 
 Ptr<TrackerTLD> TrackerTLD::createTracker(const TrackerTLD::Params &parameters)
@@ -195,75 +195,158 @@ bool TrackerFeatureHAAR::swapFeature( int source, int target )
   return true;
 }
 
-bool TrackerFeatureHAAR::extractSelected( const std::vector<int> selFeatures, const std::vector<Mat>& images, Mat& response )
+/* Corner offsets of the rectangles of a set of Haar features, for samples which are windows
+ * of the same size over integral images with the same row step. With them each rectangle sum
+ * is four loads from the sample origin, with the same clipping as FeatureHaar::getSum.
+ */
+class HaarFeatureOffsets
 {
-  if( images.empty() )
+ public:
+  HaarFeatureOffsets( const std::vector<CvHaarEvaluator::FeatureHaar>& features, const std::vector<int>& featureIds, const Mat& sample ) :
+      size( sample.size() ),
+      type( sample.type() ),
+      step( sample.step[0] )
   {
-    return false;
+    size_t esz = sample.elemSize();
+    areaEnd.resize( featureIds.size() );
+    for ( size_t j = 0; j < featureIds.size(); j++ )
+    {
+      const CvHaarEvaluator::FeatureHaar& feature = features[featureIds[j]];
+      const std::vector<Rect>& areas = feature.getAreas();
+      const std::vector<float>& w = feature.getWeights();
+      for ( size_t a = 0; a < areas.size(); a++ )
+      {
+        int x = areas[a].x, y = areas[a].y, width = areas[a].width, height = areas[a].height;
+        if( x + width >= size.width - 1 )
+          width = ( size.width - 1 ) - x;
+        if( y + height >= size.height - 1 )
+          height = ( size.height - 1 ) - y;
+
+        ofs.push_back( (int) ( ( ( y + height ) * step ) / esz ) + x + width );
+        ofs.push_back( (int) ( ( y * step ) / esz ) + x );
+        ofs.push_back( (int) ( ( y * step ) / esz ) + x + width );
+        ofs.push_back( (int) ( ( ( y + height ) * step ) / esz ) + x );
+        weights.push_back( (float) w[a] / (float) ( areas[a].width * areas[a].height ) );
+      }
+      areaEnd[j] = (int) weights.size();
+    }
   }
 
-  int numFeatures = featureEvaluator->getNumFeatures();
-  int numSelFeatures = (int)selFeatures.size();
+  bool isCompatible( const Mat& sample ) const
+  {
+    return sample.size() == size && sample.type() == type && sample.step[0] == step &&
+        ( type == CV_32SC1 || type == CV_32FC1 || type == CV_64FC1 );
+  }
 
-  //response = Mat_<float>( Size( images.size(), numFeatures ) );
-  response.create( Size( (int)images.size(), numFeatures ), CV_32F );
-  response.setTo( 0 );
+  // j-th feature of the sample goes to dst[j * dstStep]
+  void eval( const Mat& sample, float* dst, size_t dstStep ) const
+  {
+    if( type == CV_32SC1 )
+      eval_( sample.ptr<int>(), dst, dstStep );
+    else if( type == CV_32FC1 )
+      eval_( sample.ptr<float>(), dst, dstStep );
+    else
+      eval_( sample.ptr<double>(), dst, dstStep );
+  }
 
-  //double t = getTickCount();
-  //for each sample compute #n_feature -> put each feature (n Rect) in response
-  for ( size_t i = 0; i < images.size(); i++ )
+ private:
+  template<typename T>
+  void eval_( const T* origin, float* dst, size_t dstStep ) const
   {
-    int c = images[i].cols;
-    int r = images[i].rows;
-    for ( int j = 0; j < numSelFeatures; j++ )
+    const int* o = ofs.empty() ? NULL : &ofs[0];
+    for ( size_t j = 0, a = 0; j < areaEnd.size(); j++ )
     {
-      float res = 0;
-      //const feat
-      CvHaarEvaluator::FeatureHaar& feature = featureEvaluator->getFeatures( selFeatures[j] );
-      feature.eval( images[i], Rect( 0, 0, c, r ), &res );
-      //( Mat_<float>( response ) )( j, i ) = res;
-      response.at<float>( selFeatures[j], (int)i ) = res;
+      float res = 0.0f;
+      for ( ; a < (size_t) areaEnd[j]; a++, o += 4 )
+        res += static_cast<float>( origin[o[0]] + origin[o[1]] - origin[o[2]] - origin[o[3]] ) * weights[a];
+      dst[j * dstStep] = res;
     }
   }
-  //t = ( (double) getTickCount() - t ) / getTickFrequency();
-  //std::cout << "StrongClassifierDirectSelection time " << t << std::endl;
 
-  return true;
-}
+  Size size;
+  int type;
+  size_t step;
+  std::vector<int> ofs;
+  std::vector<float> weights;
+  std::vector<int> areaEnd;
+};
 
+/* Evaluates the features featureIds on every sample, the value of the j-th feature of sample i
+ * is written to response( featureIds[j], i ). The samples are distributed between threads.
+ */
 class Parallel_compute : public cv::ParallelLoopBody
 {
  private:
   Ptr<CvHaarEvaluator> featureEvaluator;
-  std::vector<Mat> images;
-  Mat response;
-  //std::vector<CvHaarEvaluator::FeatureHaar> features;
+  const std::vector<Mat>& images;
+  const std::vector<int>& featureIds;
+  const HaarFeatureOffsets& offsets;
+  float* respData;
+  size_t respStep;
+  bool contiguousIds;
  public:
-  Parallel_compute( Ptr<CvHaarEvaluator>& fe, const std::vector<Mat>& img, Mat& resp ) :
+  Parallel_compute( Ptr<CvHaarEvaluator>& fe, const std::vector<Mat>& img, const std::vector<int>& ids, const HaarFeatureOffsets& ofs, Mat& resp ) :
       featureEvaluator( fe ),
       images( img ),
-      response( resp )
+      featureIds( ids ),
+      offsets( ofs ),
+      respData( resp.ptr<float>() ),
+      respStep( resp.step[0] / sizeof(float) )
   {
-
-    //features = featureEvaluator->getFeatures();
+    contiguousIds = true;
+    for ( size_t j = 0; j < featureIds.size(); j++ )
+      contiguousIds = contiguousIds && featureIds[j] == (int) j;
   }
 
   virtual void operator()( const cv::Range &r ) const
   {
-    for ( register int jf = r.start; jf != r.end; ++jf )
+    std::vector<float> buf;
+    for ( int jf = r.start; jf != r.end; ++jf )
     {
-      int cols = images[jf].cols;
-      int rows = images[jf].rows;
-      for ( int j = 0; j < featureEvaluator->getNumFeatures(); j++ )
+      const Mat& sample = images[jf];
+      if( offsets.isCompatible( sample ) )
+      {
+        if( contiguousIds )
+        {
+          offsets.eval( sample, respData + jf, respStep );
+          continue;
+        }
+        buf.resize( featureIds.size() );
+        offsets.eval( sample, buf.empty() ? NULL : &buf[0], 1 );
+        for ( size_t j = 0; j < featureIds.size(); j++ )
+          respData[featureIds[j] * respStep + jf] = buf[j];
+        continue;
+      }
+
+      for ( size_t j = 0; j < featureIds.size(); j++ )
       {
         float res = 0;
-        featureEvaluator->getFeatures()[j].eval( images[jf], Rect( 0, 0, cols, rows ), &res );
-        ( Mat_<float>( response ) )( j, jf ) = res;
+        featureEvaluator->getFeatures( featureIds[j] ).eval( sample, Rect( 0, 0, sample.cols, sample.rows ), &res );
+        respData[featureIds[j] * respStep + jf] = res;
       }
     }
   }
 };
 
+bool TrackerFeatureHAAR::extractSelected( const std::vector<int> selFeatures, const std::vector<Mat>& images, Mat& response )
+{
+  if( images.empty() )
+  {
+    return false;
+  }
+
+  int numFeatures = featureEvaluator->getNumFeatures();
+
+  response.create( Size( (int)images.size(), numFeatures ), CV_32F );
+  response.setTo( 0 );
+
+  //for each sample compute the selected features -> put each feature (n Rect) in response
+  HaarFeatureOffsets offsets( featureEvaluator->getFeatures(), selFeatures, images[0] );
+  parallel_for_( Range( 0, (int)images.size() ), Parallel_compute( featureEvaluator, images, selFeatures, offsets, response ) );
+
+  return true;
+}
+
 bool TrackerFeatureHAAR::computeImpl( const std::vector<Mat>& images, Mat& response )
 {
   if( images.empty() )
@@ -275,21 +358,13 @@ bool TrackerFeatureHAAR::computeImpl( const std::vector<Mat>& images, Mat& respo
 
   response = Mat_<float>( Size( (int)images.size(), numFeatures ) );
 
-  std::vector<CvHaarEvaluator::FeatureHaar> f = featureEvaluator->getFeatures();
-  //for each sample compute #n_feature -> put each feature (n Rect) in response
-  parallel_for_( Range( 0, (int)images.size() ), Parallel_compute( featureEvaluator, images, response ) );
+  std::vector<int> featureIds( numFeatures );
+  for ( int j = 0; j < numFeatures; j++ )
+    featureIds[j] = j;
 
-  /*for ( size_t i = 0; i < images.size(); i++ )
-  {
-    int c = images[i].cols;
-    int r = images[i].rows;
-    for ( int j = 0; j < numFeatures; j++ )
-    {
-      float res = 0;
-      featureEvaluator->getFeatures( j ).eval( images[i], Rect( 0, 0, c, r ), &res );
-      ( Mat_<float>( response ) )( j, i ) = res;
-    }
-  }*/
+  //for each sample compute #n_feature -> put each feature (n Rect) in response
+  HaarFeatureOffsets offsets( featureEvaluator->getFeatures(), featureIds, images[0] );
+  parallel_for_( Range( 0, (int)images.size() ), Parallel_compute( featureEvaluator, images, featureIds, offsets, response ) );
 
   return true;
 }
@@ -72,9 +72,7 @@ void TrackerFeatureSet::extraction( const std::vector<Mat>& images )
 
   for ( size_t i = 0; i < features.size(); i++ )
   {
-    Mat response;
-    features[i].second->compute( images, response );
-    responses[i] = response;
+    features[i].second->compute( images, responses[i] );
   }
 
   if( !blockAddTrackerFeature )
@@ -39,8 +39,7 @@
  //
  //M*/
 
-#include "precomp.hpp"
-#include <complex>
+#include "trackerKCF.hpp"
 
 /*---------------------------
 |  TrackerKCFModel
@@ -65,98 +64,6 @@ namespace cv{
 |---------------------------*/
 namespace cv{
 
-  /*
- * Prototype
- */
-  class TrackerKCFImpl : public TrackerKCF {
-  public:
-    TrackerKCFImpl( const TrackerKCF::Params &parameters = TrackerKCF::Params() );
-    void read( const FileNode& /*fn*/ );
-    void write( FileStorage& /*fs*/ ) const;
-    void setFeatureExtractor(void (*f)(const Mat, const Rect, Mat&), bool pca_func = false);
-
-  protected:
-     /*
-    * basic functions and vars
-    */
-    bool initImpl( const Mat& /*image*/, const Rect2d& boundingBox );
-    bool updateImpl( const Mat& image, Rect2d& boundingBox );
-
-    TrackerKCF::Params params;
-
-    /*
-    * KCF functions and vars
-    */
-    void createHanningWindow(OutputArray dest, const cv::Size winSize, const int type) const;
-    void inline fft2(const Mat src, std::vector<Mat> & dest, std::vector<Mat> & layers_data) const;
-    void inline fft2(const Mat src, Mat & dest) const;
-    void inline ifft2(const Mat src, Mat & dest) const;
-    void inline pixelWiseMult(const std::vector<Mat> src1, const std::vector<Mat>  src2, std::vector<Mat>  & dest, const int flags, const bool conjB=false) const;
-    void inline sumChannels(std::vector<Mat> src, Mat & dest) const;
-    void inline updateProjectionMatrix(const Mat src, Mat & old_cov,Mat &  proj_matrix,double pca_rate, int compressed_sz,
-                                       std::vector<Mat> & layers_pca,std::vector<Scalar> & average, Mat pca_data, Mat new_cov, Mat w, Mat u, Mat v) const;
-    void inline compress(const Mat proj_matrix, const Mat src, Mat & dest, Mat & data, Mat & compressed) const;
-    bool getSubWindow(const Mat img, const Rect roi, Mat& feat, Mat& patch, TrackerKCF::MODE desc = GRAY) const;
-    bool getSubWindow(const Mat img, const Rect roi, Mat& feat, void (*f)(const Mat, const Rect, Mat& )) const;
-    void extractCN(Mat patch_data, Mat & cnFeatures) const;
-    void denseGaussKernel(const double sigma, const Mat , const Mat y_data, Mat & k_data,
-                          std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> xyf_v, Mat xy, Mat xyf ) const;
-    void calcResponse(const Mat alphaf_data, const Mat kf_data, Mat & response_data, Mat & spec_data) const;
-    void calcResponse(const Mat alphaf_data, const Mat alphaf_den_data, const Mat kf_data, Mat & response_data, Mat & spec_data, Mat & spec2_data) const;
-
-    void shiftRows(Mat& mat) const;
-    void shiftRows(Mat& mat, int n) const;
-    void shiftCols(Mat& mat, int n) const;
-
-  private:
-    double output_sigma;
-    Rect2d roi;
-    Mat hann; 	//hann window filter
-    Mat hann_cn; //10 dimensional hann-window filter for CN features,
-
-    Mat y,yf; 	// training response and its FFT
-    Mat x; 	// observation and its FFT
-    Mat k,kf;	// dense gaussian kernel and its FFT
-    Mat kf_lambda; // kf+lambda
-    Mat new_alphaf, alphaf;	// training coefficients
-    Mat new_alphaf_den, alphaf_den; // for splitted training coefficients
-    Mat z; // model
-    Mat response; // detection result
-    Mat old_cov_mtx, proj_mtx; // for feature compression
-
-    // pre-defined Mat variables for optimization of private functions
-    Mat spec, spec2;
-    std::vector<Mat> layers;
-    std::vector<Mat> vxf,vyf,vxyf;
-    Mat xy_data,xyf_data;
-    Mat data_temp, compress_data;
-    std::vector<Mat> layers_pca_data;
-    std::vector<Scalar> average_data;
-    Mat img_Patch;
-
-    // storage for the extracted features, KRLS model, KRLS compressed model
-    Mat X[2],Z[2],Zc[2];
-
-    // storage of the extracted features
-    std::vector<Mat> features_pca;
-    std::vector<Mat> features_npca;
-    std::vector<MODE> descriptors_pca;
-    std::vector<MODE> descriptors_npca;
-
-    // optimization variables for updateProjectionMatrix
-    Mat data_pca, new_covar,w_data,u_data,vt_data;
-
-    // custom feature extractor
-    bool use_custom_extractor_pca;
-    bool use_custom_extractor_npca;
-    std::vector<void(*)(const Mat img, const Rect roi, Mat& output)> extractor_pca;
-    std::vector<void(*)(const Mat img, const Rect roi, Mat& output)> extractor_npca;
-
-    bool resizeImage; // resize the image whenever needed and the patch size is large
-
-    int frame;
-  };
-
   /*
  * Constructor
  */
@@ -204,6 +111,8 @@ namespace cv{
       roi.width/=2.0;
       roi.height/=2.0;
     }
+    baseTargetSize=roi.size();
+    currentScale=1.0;
 
     // add padding to the roi
     roi.x-=roi.width/2;
@@ -256,6 +165,21 @@ namespace cv{
       || use_custom_extractor_npca
     );
 
+    // preallocate the workspaces of the per-frame path, the ones depending on the number of feature channels
+    // are allocated by the first update
+    k.create(hann.size(), CV_64F);
+    xy_data.create(hann.size(), CV_64F);
+    response.create(hann.size(), CV_64F);
+    kf.create(hann.size(), CV_64FC2);
+    kf_lambda.create(hann.size(), CV_64FC2);
+    xyf_data.create(hann.size(), CV_64FC2);
+    spec.create(hann.size(), CV_64FC2);
+    spec2.create(hann.size(), CV_64FC2);
+    new_alphaf.create(hann.size(), CV_64FC2);
+    new_alphaf_den.create(hann.size(), CV_64FC2);
+
+    if(params.scale_adaptive)initScaleFilter();
+
     // TODO: return true only if roi inside the image
     return true;
   }
@@ -264,114 +188,142 @@ namespace cv{
    * Main part of the KCF algorithm
    */
   bool TrackerKCFImpl::updateImpl( const Mat& image, Rect2d& boundingBox ){
-    double minVal, maxVal;	// min-max response
-    Point minLoc,maxLoc;	// min-max location
-
-    Mat img=image.clone();
     // check the channels of the input image, grayscale is preferred
-    CV_Assert(img.channels() == 1 || img.channels() == 3);
+    CV_Assert(image.channels() == 1 || image.channels() == 3);
 
     // resize the image whenever needed
-    if(resizeImage)resize(img,img,Size(img.cols/2,img.rows/2));
-
-    // detection part
-    if(frame>0){
-
-      // extract and pre-process the patch
-      // get non compressed descriptors
-      for(unsigned i=0;i<descriptors_npca.size()-extractor_npca.size();i++){
-        if(!getSubWindow(img,roi, features_npca[i], img_Patch, descriptors_npca[i]))return false;
-      }
-      //get non-compressed custom descriptors
-      for(unsigned i=0,j=(unsigned)(descriptors_npca.size()-extractor_npca.size());i<extractor_npca.size();i++,j++){
-        if(!getSubWindow(img,roi, features_npca[j], extractor_npca[i]))return false;
-      }
-      if(features_npca.size()>0)merge(features_npca,X[1]);
-
-      // get compressed descriptors
-      for(unsigned i=0;i<descriptors_pca.size()-extractor_pca.size();i++){
-        if(!getSubWindow(img,roi, features_pca[i], img_Patch, descriptors_pca[i]))return false;
-      }
-      //get compressed custom descriptors
-      for(unsigned i=0,j=(unsigned)(descriptors_pca.size()-extractor_pca.size());i<extractor_pca.size();i++,j++){
-        if(!getSubWindow(img,roi, features_pca[j], extractor_pca[i]))return false;
-      }
-      if(features_pca.size()>0)merge(features_pca,X[0]);
-
-      //compress the features and the KRSL model
-      if(params.desc_pca !=0){
-        compress(proj_mtx,X[0],X[0],data_temp,compress_data);
-        compress(proj_mtx,Z[0],Zc[0],data_temp,compress_data);
-      }
-
-      // copy the compressed KRLS model
-      Zc[1] = Z[1];
-
-      // merge all features
-      if(features_npca.size()==0){
-        x = X[0];
-        z = Zc[0];
-      }else if(features_pca.size()==0){
-        x = X[1];
-        z = Z[1];
+    if(resizeImage)resize(image,img_resized,Size(image.cols/2,image.rows/2));
+    const Mat& img = resizeImage ? img_resized : image;
+
+    // the grayscale frame is shared by the translation and the scale features
+    Mat imgGray;
+    if(params.scale_adaptive){
+      if(img.channels()==3){
+        cvtColor(img,img_gray,COLOR_BGR2GRAY);
+        imgGray=img_gray;
       }else{
-        merge(X,2,x);
-        merge(Zc,2,z);
+        imgGray=img;
       }
+    }
 
-      //compute the gaussian kernel
-      denseGaussKernel(params.sigma,x,z,k,layers,vxf,vyf,vxyf,xy_data,xyf_data);
+    std::vector<KCFDftJob> & jobs = dft_jobs;
 
-      // compute the fourier transform of the kernel
-      fft2(k,kf);
-      if(frame==1)spec2=Mat_<Vec2d >(kf.rows, kf.cols);
+    // detection part
+    if(frame>0){
+      if(!detectFeatures(img,imgGray,jobs))return false;
+      runDftJobs(jobs,false);
+      correlate(jobs);
+      runDftJobs(jobs,false);
+      computeKernel(jobs);
+      runDftJobs(jobs,false);
+      computeResponse(jobs);
+      runDftJobs(jobs,false);
+      locateTarget();
+      estimateScale(img,imgGray);
+    }
 
-      // calculate filter response
-      if(params.split_coeff)
-        calcResponse(alphaf,alphaf_den,kf,response, spec, spec2);
-      else
-        calcResponse(alphaf,kf,response, spec);
+    // learning part
+    if(!trainFeatures(img,imgGray,boundingBox,jobs))return false;
+    runDftJobs(jobs,false);
+    correlate(jobs);
+    runDftJobs(jobs,false);
+    computeKernel(jobs);
+    runDftJobs(jobs,false);
+    updateCoefficients();
 
-      // extract the maximum response
-      minMaxLoc( response, &minVal, &maxVal, &minLoc, &maxLoc );
-      roi.x+=(maxLoc.x-roi.width/2+1);
-      roi.y+=(maxLoc.y-roi.height/2+1);
-    }
+    return true;
+  }
 
-    // update the bounding box
-    boundingBox.x=(resizeImage?roi.x*2:roi.x)+(resizeImage?roi.width*2:roi.width)/4;
-    boundingBox.y=(resizeImage?roi.y*2:roi.y)+(resizeImage?roi.height*2:roi.height)/4;
-    boundingBox.width = (resizeImage?roi.width*2:roi.width)/2;
-    boundingBox.height = (resizeImage?roi.height*2:roi.height)/2;
+  /*
+   * extract the patch of all descriptors from the current roi at the current scale
+   * into X[0] (compressed) and X[1] (non-compressed)
+   */
+  bool TrackerKCFImpl::extractFeatures(const Mat& img, const Mat& imgGray){
+    Rect2d sampleRoi=scaledRoi();
 
-    // extract the patch for learning purpose
     // get non compressed descriptors
     for(unsigned i=0;i<descriptors_npca.size()-extractor_npca.size();i++){
-      if(!getSubWindow(img,roi, features_npca[i], img_Patch, descriptors_npca[i]))return false;
+      if(!getSubWindow(img,sampleRoi, features_npca[i], descriptors_npca[i], imgGray))return false;
     }
     //get non-compressed custom descriptors
     for(unsigned i=0,j=(unsigned)(descriptors_npca.size()-extractor_npca.size());i<extractor_npca.size();i++,j++){
-      if(!getSubWindow(img,roi, features_npca[j], extractor_npca[i]))return false;
+      if(!getSubWindow(img,sampleRoi, features_npca[j], extractor_npca[i]))return false;
     }
     if(features_npca.size()>0)merge(features_npca,X[1]);
 
     // get compressed descriptors
     for(unsigned i=0;i<descriptors_pca.size()-extractor_pca.size();i++){
-      if(!getSubWindow(img,roi, features_pca[i], img_Patch, descriptors_pca[i]))return false;
+      if(!getSubWindow(img,sampleRoi, features_pca[i], descriptors_pca[i], imgGray))return false;
     }
     //get compressed custom descriptors
     for(unsigned i=0,j=(unsigned)(descriptors_pca.size()-extractor_pca.size());i<extractor_pca.size();i++,j++){
-      if(!getSubWindow(img,roi, features_pca[j], extractor_pca[i]))return false;
+      if(!getSubWindow(img,sampleRoi, features_pca[j], extractor_pca[i]))return false;
     }
     if(features_pca.size()>0)merge(features_pca,X[0]);
 
+    return true;
+  }
+
+  /*
+   * detection: extract the features around the previous position and compute them with the model
+   */
+  bool TrackerKCFImpl::detectFeatures(const Mat& img, const Mat& imgGray, std::vector<KCFDftJob> & jobs){
+    // extract and pre-process the patch
+    if(!extractFeatures(img,imgGray))return false;
+
+    //compress the features and the KRSL model
+    if(params.desc_pca !=0 || use_custom_extractor_pca){
+      compress(proj_mtx,X[0],Xc[0],data_temp,compress_data);
+      compress(proj_mtx,Z[0],Zc[0],data_temp,compress_data);
+    }
+
+    // copy the non-compressed features and KRLS model
+    Xc[1] = X[1];
+    Zc[1] = Z[1];
+
+    // merge all features
+    if(features_npca.size()==0){
+      x = Xc[0];
+      z = Zc[0];
+    }else if(features_pca.size()==0){
+      x = X[1];
+      z = Z[1];
+    }else{
+      merge(Xc,2,x);
+      merge(Zc,2,z);
+    }
+
+    //compute the gaussian kernel of x and z
+    autoCorrelation=false;
+    scheduleFeaturesDft(x,layers,vxf,jobs);
+    scheduleFeaturesDft(z,layers_z,vyf,jobs);
+    return true;
+  }
+
+  /*
+   * training: extract the features at the new position and update the model
+   */
+  bool TrackerKCFImpl::trainFeatures(const Mat& img, const Mat& imgGray, Rect2d& boundingBox, std::vector<KCFDftJob> & jobs){
+    // update the bounding box
+    Rect2d r=scaledRoi();
+    boundingBox.x=(resizeImage?r.x*2:r.x)+(resizeImage?r.width*2:r.width)/4;
+    boundingBox.y=(resizeImage?r.y*2:r.y)+(resizeImage?r.height*2:r.height)/4;
+    boundingBox.width = (resizeImage?r.width*2:r.width)/2;
+    boundingBox.height = (resizeImage?r.height*2:r.height)/2;
+
+    // extract the patch for learning purpose
+    if(!extractFeatures(img,imgGray))return false;
+
+    // the scale filter learns at the new position and scale
+    if(params.scale_adaptive)trainScale(img,imgGray);
+
     //update the training data
     if(frame==0){
       Z[0] = X[0].clone();
       Z[1] = X[1].clone();
     }else{
-      Z[0]=(1.0-params.interp_factor)*Z[0]+params.interp_factor*X[0];
-      Z[1]=(1.0-params.interp_factor)*Z[1]+params.interp_factor*X[1];
+      if(!Z[0].empty())addWeighted(Z[0],1.0-params.interp_factor,X[0],params.interp_factor,0.0,Z[0]);
+      if(!Z[1].empty())addWeighted(Z[1],1.0-params.interp_factor,X[1],params.interp_factor,0.0,Z[1]);
     }
 
     if(params.desc_pca !=0 || use_custom_extractor_pca){
@@ -382,33 +334,137 @@ namespace cv{
       }
 
       // feature compression
-      updateProjectionMatrix(Z[0],old_cov_mtx,proj_mtx,params.pca_learning_rate,params.compressed_size,layers_pca_data,average_data,data_pca, new_covar,w_data,u_data,vt_data);
-      compress(proj_mtx,X[0],X[0],data_temp,compress_data);
+      updateProjectionMatrix(Z[0],old_cov_mtx,proj_mtx,params.pca_learning_rate,params.compressed_size,layers_pca_data,average_data,data_pca,
+                             new_covar,w_data,u_data,vt_data,proj_vars_data,proj_covar);
+      compress(proj_mtx,X[0],Xc[0],data_temp,compress_data);
     }
+    Xc[1] = X[1];
 
     // merge all features
     if(features_npca.size()==0)
-      x = X[0];
+      x = Xc[0];
     else if(features_pca.size()==0)
       x = X[1];
     else
-      merge(X,2,x);
+      merge(Xc,2,x);
 
-    // initialize some required Mat variables
-    if(frame==0){
-      layers.resize(x.channels());
-      vxf.resize(x.channels());
-      vyf.resize(x.channels());
-      vxyf.resize(vyf.size());
-      new_alphaf=Mat_<Vec2d >(yf.rows, yf.cols);
+    // Kernel Regularized Least-Squares, the gaussian kernel of x with itself
+    autoCorrelation=true;
+    scheduleFeaturesDft(x,layers,vxf,jobs);
+    return true;
+  }
+
+  /*
+   * dense gauss kernel, part 1: cross-correlation of the features in the fourier domain
+   */
+  void TrackerKCFImpl::correlate(std::vector<KCFDftJob> & jobs){
+    normX=norm(x);
+    normX*=normX;
+    if(autoCorrelation){
+      normY=normX;
+    }else{
+      normY=norm(z);
+      normY*=normY;
     }
 
-    // Kernel Regularized Least-Squares, calculate alphas
-    denseGaussKernel(params.sigma,x,x,k,layers,vxf,vyf,vxyf,xy_data,xyf_data);
+    vxyf.resize(vxf.size());
+    pixelWiseMult(vxf,autoCorrelation ? vxf : vyf,vxyf,0,true);
+    sumChannels(vxyf,xyf_data);
 
-    // compute the fourier transform of the kernel and add a small value
-    fft2(k,kf);
-    kf_lambda=kf+params.lambda;
+    KCFDftJob job = {xyf_data, &xy_data, true};
+    jobs.push_back(job);
+  }
+
+  /*
+   * dense gauss kernel, part 2: the kernel values from the correlation
+   */
+  void TrackerKCFImpl::computeKernel(std::vector<KCFDftJob> & jobs){
+    if(params.wrap_kernel){
+      shiftRows(xy_data, x.rows/2);
+      shiftCols(xy_data, x.cols/2);
+    }
+
+    //(xx + yy - 2 * xy) / numel(x)
+    double numel=x.rows*x.cols*x.channels();
+    xy_data.convertTo(xy_data,CV_64F,-2.0/numel,(normX+normY)/numel);
+
+    // TODO: check wether we really need thresholding or not
+    //threshold(xy,xy,0.0,0.0,THRESH_TOZERO);//max(0, (xx + yy - 2 * xy) / numel(x))
+    for(int i=0;i<xy_data.rows;i++){
+      for(int j=0;j<xy_data.cols;j++){
+        if(xy_data.at<double>(i,j)<0.0)xy_data.at<double>(i,j)=0.0;
+      }
+    }
+
+    double sig=-1.0/(params.sigma*params.sigma);
+    xy_data.convertTo(xy_data,CV_64F,sig);
+    exp(xy_data,k);
+
+    // compute the fourier transform of the kernel
+    KCFDftJob job = {k, &kf, false};
+    jobs.push_back(job);
+  }
+
+  /*
+   * detection: the filter response in the fourier domain
+   */
+  void TrackerKCFImpl::computeResponse(std::vector<KCFDftJob> & jobs){
+    if(params.split_coeff){
+      calcResponse(alphaf,alphaf_den,kf,spec,spec2);
+    }else{
+      calcResponse(alphaf,kf,spec);
+    }
+
+    KCFDftJob job = {params.split_coeff ? spec2 : spec, &response, true};
+    jobs.push_back(job);
+  }
+
+  /*
+   * detection: move the roi to the maximum response
+   */
+  void TrackerKCFImpl::locateTarget(){
+    double minVal, maxVal;	// min-max response
+    Point minLoc,maxLoc;	// min-max location
+
+    // extract the maximum response
+    minMaxLoc( response, &minVal, &maxVal, &minLoc, &maxLoc );
+    roi.x+=(maxLoc.x-roi.width/2+1)*currentScale;
+    roi.y+=(maxLoc.y-roi.height/2+1)*currentScale;
+  }
+
+  /*
+   * detection: the scale change of the target at its new position, the responses of all the scales
+   * are obtained from a single transform of the scale samples
+   */
+  void TrackerKCFImpl::estimateScale(const Mat& img, const Mat& imgGray){
+    if(!params.scale_adaptive || sf_num.empty() || !getScaleSamples(img,imgGray))return;
+
+    dft(scale_samples,scale_samplesf,DFT_ROWS|DFT_COMPLEX_OUTPUT);
+    mulSpectrums(sf_num,scale_samplesf,scale_spec,DFT_ROWS);
+    reduce(scale_spec,scale_respf,0,REDUCE_SUM);
+
+    // the denominator is real
+    Vec2d* respf=scale_respf.ptr<Vec2d>();
+    const Vec2d* den=sf_den.ptr<Vec2d>();
+    for(int i=0;i<scale_respf.cols;i++){
+      double inv=1.0/(den[i][0]+params.lambda);
+      respf[i][0]*=inv;
+      respf[i][1]*=inv;
+    }
+    idft(scale_respf,scale_response,DFT_SCALE|DFT_REAL_OUTPUT);
+
+    Point maxLoc;
+    minMaxLoc(scale_response,NULL,NULL,NULL,&maxLoc);
+    currentScale*=scaleFactors[maxLoc.x];
+    currentScale=std::min(std::max(currentScale,minScaleFactor),maxScaleFactor);
+  }
+
+  /*
+   * training: calculate alphas and update the RLS model
+   */
+  void TrackerKCFImpl::updateCoefficients(){
+    // add a small value to the fourier transform of the kernel
+    add(kf,Scalar(params.lambda),kf_lambda);
 
     double den;
     if(params.split_coeff){
@@ -432,15 +488,13 @@ namespace cv{
       alphaf=new_alphaf.clone();
       if(params.split_coeff)alphaf_den=new_alphaf_den.clone();
     }else{
-      alphaf=(1.0-params.interp_factor)*alphaf+params.interp_factor*new_alphaf;
-      if(params.split_coeff)alphaf_den=(1.0-params.interp_factor)*alphaf_den+params.interp_factor*new_alphaf_den;
+      addWeighted(alphaf,1.0-params.interp_factor,new_alphaf,params.interp_factor,0.0,alphaf);
+      if(params.split_coeff)addWeighted(alphaf_den,1.0-params.interp_factor,new_alphaf_den,params.interp_factor,0.0,alphaf_den);
     }
 
     frame++;
-    return true;
   }
 
-
   /*-------------------------------------
   |  implementation of the KCF functions
   |-------------------------------------*/
@@ -486,29 +540,34 @@ namespace cv{
   /*
    * simplification of fourier transform function in opencv
    */
-  void inline TrackerKCFImpl::fft2(const Mat src, Mat & dest) const {
+  void inline TrackerKCFImpl::fft2(const Mat& src, Mat & dest) const {
     dft(src,dest,DFT_COMPLEX_OUTPUT);
   }
 
-  void inline TrackerKCFImpl::fft2(const Mat src, std::vector<Mat> & dest, std::vector<Mat> & layers_data) const {
+  /*
+   * split the channels of src and schedule their fourier transforms to dest
+   */
+  void TrackerKCFImpl::scheduleFeaturesDft(const Mat& src, std::vector<Mat> & layers_data, std::vector<Mat> & dest, std::vector<KCFDftJob> & jobs) const {
     split(src, layers_data);
+    dest.resize(layers_data.size());
 
-    for(int i=0;i<src.channels();i++){
-      dft(layers_data[i],dest[i],DFT_COMPLEX_OUTPUT);
+    for(unsigned i=0;i<layers_data.size();i++){
+      KCFDftJob job = {layers_data[i], &dest[i], false};
+      jobs.push_back(job);
     }
   }
 
   /*
    * simplification of inverse fourier transform function in opencv
    */
-  void inline TrackerKCFImpl::ifft2(const Mat src, Mat & dest) const {
+  void inline TrackerKCFImpl::ifft2(const Mat& src, Mat & dest) const {
     idft(src,dest,DFT_SCALE+DFT_REAL_OUTPUT);
   }
 
   /*
    * Point-wise multiplication of two Multichannel Mat data
    */
-  void inline TrackerKCFImpl::pixelWiseMult(const std::vector<Mat> src1, const std::vector<Mat>  src2, std::vector<Mat>  & dest, const int flags, const bool conjB) const {
+  void inline TrackerKCFImpl::pixelWiseMult(const std::vector<Mat> & src1, const std::vector<Mat> & src2, std::vector<Mat> & dest, const int flags, const bool conjB) const {
     for(unsigned i=0;i<src1.size();i++){
       mulSpectrums(src1[i], src2[i], dest[i],flags,conjB);
     }
@@ -517,18 +576,19 @@ namespace cv{
   /*
    * Combines all channels in a multi-channels Mat data into a single channel
    */
-  void inline TrackerKCFImpl::sumChannels(std::vector<Mat> src, Mat & dest) const {
-    dest=src[0].clone();
+  void inline TrackerKCFImpl::sumChannels(const std::vector<Mat> & src, Mat & dest) const {
+    src[0].copyTo(dest);
     for(unsigned i=1;i<src.size();i++){
-      dest+=src[i];
+      add(dest,src[i],dest);
     }
   }
 
   /*
    * obtains the projection matrix using PCA
    */
-  void inline TrackerKCFImpl::updateProjectionMatrix(const Mat src, Mat & old_cov,Mat &  proj_matrix, double pca_rate, int compressed_sz,
-                                                     std::vector<Mat> & layers_pca,std::vector<Scalar> & average, Mat pca_data, Mat new_cov, Mat w, Mat u, Mat vt) const {
+  void inline TrackerKCFImpl::updateProjectionMatrix(const Mat& src, Mat & old_cov,Mat &  proj_matrix, double pca_rate, int compressed_sz,
+                                                     std::vector<Mat> & layers_pca,std::vector<Scalar> & average, Mat & pca_data, Mat & new_cov, Mat & w, Mat & u, Mat & vt,
+                                                     Mat & proj_vars, Mat & proj_cov) const {
     CV_Assert(compressed_sz<=src.channels());
 
     split(src,layers_pca);
@@ -540,38 +600,50 @@ namespace cv{
 
     // calc covariance matrix
     merge(layers_pca,pca_data);
-    pca_data=pca_data.reshape(1,src.rows*src.cols);
+    Mat pca_rows=pca_data.reshape(1,src.rows*src.cols);
 
-    new_cov=1.0/(double)(src.rows*src.cols-1)*(pca_data.t()*pca_data);
+    gemm(pca_rows,pca_rows,1.0/(double)(src.rows*src.cols-1),noArray(),0.0,new_cov,GEMM_1_T);
     if(old_cov.rows==0)old_cov=new_cov.clone();
 
     // calc PCA
-    SVD::compute((1.0-pca_rate)*old_cov+pca_rate*new_cov, w, u, vt);
+    addWeighted(old_cov,1.0-pca_rate,new_cov,pca_rate,0.0,new_cov);
+    SVD::compute(new_cov, w, u, vt);
 
     // extract the projection matrix
-    proj_matrix=u(Rect(0,0,compressed_sz,src.channels())).clone();
-    Mat proj_vars=Mat::eye(compressed_sz,compressed_sz,proj_matrix.type());
+    u(Rect(0,0,compressed_sz,src.channels())).copyTo(proj_matrix);
+
+    // update the covariance matrix with proj_matrix*diag(w)*proj_matrix^T
+    proj_matrix.copyTo(proj_vars);
     for(int i=0;i<compressed_sz;i++){
-      proj_vars.at<double>(i,i)=w.at<double>(i);
+      Mat col=proj_vars.col(i);
+      col*=w.at<double>(i);
     }
-
-    // update the covariance matrix
-    old_cov=(1.0-pca_rate)*old_cov+pca_rate*proj_matrix*proj_vars*proj_matrix.t();
+    gemm(proj_vars,proj_matrix,1.0,noArray(),0.0,proj_cov,GEMM_2_T);
+    addWeighted(old_cov,1.0-pca_rate,proj_cov,pca_rate,0.0,old_cov);
   }
 
   /*
    * compress the features
    */
-  void inline TrackerKCFImpl::compress(const Mat proj_matrix, const Mat src, Mat & dest, Mat & data, Mat & compressed) const {
+  void inline TrackerKCFImpl::compress(const Mat& proj_matrix, const Mat& src, Mat & dest, Mat & data, Mat & compressed) const {
     data=src.reshape(1,src.rows*src.cols);
-    compressed=data*proj_matrix;
-    dest=compressed.reshape(proj_matrix.cols,src.rows).clone();
+    gemm(data,proj_matrix,1.0,noArray(),0.0,compressed);
+    compressed.reshape(proj_matrix.cols,src.rows).copyTo(dest);
   }
 
   /*
-   * obtain the patch and apply hann window filter to it
+   * the roi scaled by the current target scale around its center
    */
-  bool TrackerKCFImpl::getSubWindow(const Mat img, const Rect _roi, Mat& feat, Mat& patch, TrackerKCF::MODE desc) const {
+  Rect2d TrackerKCFImpl::scaledRoi() const {
+    if(currentScale==1.0)return roi;
+    double w=roi.width*currentScale, h=roi.height*currentScale;
+    return Rect2d(roi.x+(roi.width-w)/2, roi.y+(roi.height-h)/2, w, h);
+  }
+
+  /*
+   * crop the roi from the image, the parts outside the image are filled by replicating the border
+   */
+  bool TrackerKCFImpl::cropPatch(const Mat& img, const Rect _roi, Mat& patch) const {
 
     Rect region=_roi;
 
@@ -590,8 +662,6 @@ namespace cv{
     if(region.width>img.cols)region.width=img.cols;
     if(region.height>img.rows)region.height=img.rows;
 
-    patch=img(region).clone();
-
     // add some padding to compensate when the patch is outside image border
     int addTop,addBottom, addLeft, addRight;
     addTop=region.y-_roi.y;
@@ -599,24 +669,44 @@ namespace cv{
     addLeft=region.x-_roi.x;
     addRight=(_roi.width+_roi.x>img.cols?_roi.width+_roi.x-img.cols:0);
 
-    copyMakeBorder(patch,patch,addTop,addBottom,addLeft,addRight,BORDER_REPLICATE);
-    if(patch.rows==0 || patch.cols==0)return false;
+    // the patch buffer keeps its size between frames, so it is not reallocated
+    copyMakeBorder(img(region),patch,addTop,addBottom,addLeft,addRight,BORDER_REPLICATE|BORDER_ISOLATED);
+    return patch.rows!=0 && patch.cols!=0;
+  }
+
+  /*
+   * obtain the patch and apply hann window filter to it
+   */
+  bool TrackerKCFImpl::getSubWindow(const Mat& img, const Rect _roi, Mat& feat, TrackerKCF::MODE desc, const Mat& imgGray) {
+
+    // the grayscale version of the frame is cropped instead of converting the patch if it is given
+    bool useGrayFrame=(desc==GRAY && !imgGray.empty());
+    Mat& cropped=useGrayFrame ? gray_Patch : img_Patch;
+    if(!cropPatch(useGrayFrame ? imgGray : img,_roi,cropped))return false;
+
+    // the patch is sampled at the target scale, it is brought to the template size
+    const Mat* patchPtr=&cropped;
+    if(cropped.size()!=hann.size()){
+      resize(cropped,scaled_Patch,hann.size());
+      patchPtr=&scaled_Patch;
+    }
+    const Mat& patch=*patchPtr;
 
     // extract the desired descriptors
     switch(desc){
       case CN:
         CV_Assert(img.channels() == 3);
         extractCN(patch,feat);
-        feat=feat.mul(hann_cn); // hann window filter
+        multiply(feat,hann_cn,feat); // hann window filter
         break;
       default: // GRAY
-        if(img.channels()>1)
-          cvtColor(patch,feat, CV_BGR2GRAY);
-        else
-          feat=patch;
-        feat.convertTo(feat,CV_64F);
-        feat=feat/255.0-0.5; // normalize to range -0.5 .. 0.5
-        feat=feat.mul(hann); // hann window filter
+        if(patch.channels()>1){
+          cvtColor(patch,gray_Patch, CV_BGR2GRAY);
+          gray_Patch.convertTo(feat,CV_64F,1.0/255.0,-0.5); // normalize to range -0.5 .. 0.5
+        }else{
+          patch.convertTo(feat,CV_64F,1.0/255.0,-0.5);
+        }
+        multiply(feat,hann,feat); // hann window filter
         break;
     }
 
@@ -627,7 +717,7 @@ namespace cv{
   /*
    * get feature using external function
    */
-  bool TrackerKCFImpl::getSubWindow(const Mat img, const Rect _roi, Mat& feat, void (*f)(const Mat, const Rect, Mat& )) const{
+  bool TrackerKCFImpl::getSubWindow(const Mat& img, const Rect _roi, Mat& feat, void (*f)(const Mat, const Rect, Mat& )){
 
     // return false if roi is outside the image
     if((_roi.x+_roi.width<0)
@@ -643,81 +733,123 @@ namespace cv{
       printf("Rules: roi.width==feat.cols && roi.height = feat.rows \n");
     }
 
-    Mat hann_win;
-    std::vector<Mat> _layers;
+    // the features are extracted at the target scale, they are brought to the template size
+    if(feat.size()!=hann.size())resize(feat,feat,hann.size());
 
-    for(int i=0;i<feat.channels();i++)
-      _layers.push_back(hann);
-
-    merge(_layers, hann_win);
+    // the hann window is built once for the number of channels of the custom features
+    if(hann_custom.channels()!=feat.channels() || hann_custom.size()!=hann.size()){
+      std::vector<Mat> _layers(feat.channels(), hann);
+      merge(_layers, hann_custom);
+    }
 
-    feat=feat.mul(hann_win); // hann window filter
+    multiply(feat,hann_custom,feat); // hann window filter
 
     return true;
   }
 
-  /* Convert BGR to ColorNames
+  /*
+   * scale filter: the scale factors of the samples, their window and the desired response
    */
-  void TrackerKCFImpl::extractCN(Mat patch_data, Mat & cnFeatures) const {
-    Vec3b & pixel = patch_data.at<Vec3b>(0,0);
-    unsigned index;
-
-    if(cnFeatures.type() != CV_64FC(10))
-      cnFeatures = Mat::zeros(patch_data.rows,patch_data.cols,CV_64FC(10));
+  void TrackerKCFImpl::initScaleFilter(){
+    CV_Assert(params.scale_count>0 && params.scale_step>1.0 && params.scale_model_max_area>0);
+    int n=params.scale_count;
+    double scale_sigma=params.scale_sigma_factor*n/sqrt(33.0);
+
+    Mat ys(1,n,CV_64F);
+    scaleFactors.resize(n);
+    scaleWindow.resize(n);
+    for(int i=0;i<n;i++){
+      double ss=i+1-cvCeil(n/2.0);
+      ys.at<double>(i)=exp(-0.5*ss*ss/(scale_sigma*scale_sigma));
+      scaleFactors[i]=pow(params.scale_step,-ss);
+      scaleWindow[i]=(n>1)?0.5*(1.0-cos(2.0*CV_PI*i/(n-1))):1.0;
+    }
 
-    for(int i=0;i<patch_data.rows;i++){
-      for(int j=0;j<patch_data.cols;j++){
-        pixel=patch_data.at<Vec3b>(i,j);
-        index=(unsigned)(floor((float)pixel[2]/8)+32*floor((float)pixel[1]/8)+32*32*floor((float)pixel[0]/8));
+    // the samples are resized to a fixed size, limited to scale_model_max_area pixels
+    double modelFactor=1.0;
+    if(baseTargetSize.area()>params.scale_model_max_area)modelFactor=sqrt(params.scale_model_max_area/baseTargetSize.area());
+    scaleModelSize=Size(std::max(1,cvFloor(baseTargetSize.width*modelFactor)),std::max(1,cvFloor(baseTargetSize.height*modelFactor)));
+
+    // one row per feature, so the desired response is repeated for every row
+    Mat ysf_row;
+    dft(ys,ysf_row,DFT_COMPLEX_OUTPUT);
+    repeat(ysf_row,scaleModelSize.area(),1,ysf);
+
+    scale_samples.create(scaleModelSize.area(),n,CV_64F);
+    sf_num.release();
+    sf_den.release();
+    minScaleFactor=0.0;
+    maxScaleFactor=DBL_MAX;
+  }
 
-        //copy the values
-        for(int _k=0;_k<10;_k++){
-          cnFeatures.at<Vec<double,10> >(i,j)[_k]=ColorNames[index][_k];
-        }
-      }
+  /*
+   * scale filter: the grayscale target patches at all the scales around the current position, resized to scaleModelSize,
+   * normalized and windowed, the patch of the i-th scale is the i-th column of scale_samples
+   */
+  bool TrackerKCFImpl::getScaleSamples(const Mat& img, const Mat& imgGray){
+    const Mat& gray=imgGray.empty() ? img : imgGray;
+    CV_Assert(gray.channels()==1);
+
+    Point2d center(roi.x+roi.width/2, roi.y+roi.height/2);
+    int d=scaleModelSize.area();
+    for(int i=0;i<params.scale_count;i++){
+      double w=baseTargetSize.width*currentScale*scaleFactors[i], h=baseTargetSize.height*currentScale*scaleFactors[i];
+      Rect patchRoi(cvFloor(center.x-w/2), cvFloor(center.y-h/2), std::max(1,cvRound(w)), std::max(1,cvRound(h)));
+      if(!cropPatch(gray,patchRoi,scale_Patch))return false;
+      resize(scale_Patch,scale_Patch_resized,scaleModelSize);
+
+      Mat col=scale_samples.col(i);
+      scale_Patch_resized.reshape(1,d).convertTo(col,CV_64F,scaleWindow[i]/255.0,-0.5*scaleWindow[i]);
     }
-
+    return true;
   }
 
   /*
-   *  dense gauss kernel function
+   * scale filter: update the numerator and the denominator with the samples at the current position and scale
    */
-  void TrackerKCFImpl::denseGaussKernel(const double sigma, const Mat x_data, const Mat y_data, Mat & k_data,
-                                        std::vector<Mat> & layers_data,std::vector<Mat> & xf_data,std::vector<Mat> & yf_data, std::vector<Mat> xyf_v, Mat xy, Mat xyf ) const {
-    double normX, normY;
+  void TrackerKCFImpl::trainScale(const Mat& img, const Mat& imgGray){
+    // the scales are limited by the minimum target size and by the frame size
+    if(sf_num.empty()){
+      double logStep=log(params.scale_step);
+      minScaleFactor=pow(params.scale_step,cvCeil(log(std::max(5.0/baseTargetSize.width,5.0/baseTargetSize.height))/logStep));
+      maxScaleFactor=pow(params.scale_step,cvFloor(log(std::min(img.rows/baseTargetSize.height,img.cols/baseTargetSize.width))/logStep));
+    }
 
-    fft2(x_data,xf_data,layers_data);
-    fft2(y_data,yf_data,layers_data);
+    if(!getScaleSamples(img,imgGray))return;
+    dft(scale_samples,scale_samplesf,DFT_ROWS|DFT_COMPLEX_OUTPUT);
 
-    normX=norm(x_data);
-    normX*=normX;
-    normY=norm(y_data);
-    normY*=normY;
+    // numerator: the desired response times the conjugated spectrum of the samples
+    mulSpectrums(ysf,scale_samplesf,scale_spec,DFT_ROWS,true);
+    if(sf_num.empty())scale_spec.copyTo(sf_num);
+    else addWeighted(sf_num,1.0-params.interp_factor,scale_spec,params.interp_factor,0.0,sf_num);
 
-    pixelWiseMult(xf_data,yf_data,xyf_v,0,true);
-    sumChannels(xyf_v,xyf);
-    ifft2(xyf,xyf);
+    // denominator: the energy of the samples spectrum summed over the features
+    mulSpectrums(scale_samplesf,scale_samplesf,scale_spec,DFT_ROWS,true);
+    reduce(scale_spec,scale_respf,0,REDUCE_SUM);
+    if(sf_den.empty())scale_respf.copyTo(sf_den);
+    else addWeighted(sf_den,1.0-params.interp_factor,scale_respf,params.interp_factor,0.0,sf_den);
+  }
 
-    if(params.wrap_kernel){
-      shiftRows(xyf, x_data.rows/2);
-      shiftCols(xyf, x_data.cols/2);
-    }
+  /* Convert BGR to ColorNames
+   */
+  void TrackerKCFImpl::extractCN(const Mat& patch_data, Mat & cnFeatures) const {
+    if(cnFeatures.type() != CV_64FC(10) || cnFeatures.size() != patch_data.size())
+      cnFeatures = Mat::zeros(patch_data.rows,patch_data.cols,CV_64FC(10));
 
-    //(xx + yy - 2 * xy) / numel(x)
-    xy=(normX+normY-2*xyf)/(x_data.rows*x_data.cols*x_data.channels());
+    for(int i=0;i<patch_data.rows;i++){
+      const Vec3b* pixels=patch_data.ptr<Vec3b>(i);
+      Vec<double,10>* features=cnFeatures.ptr<Vec<double,10> >(i);
+      for(int j=0;j<patch_data.cols;j++){
+        const Vec3b& pixel=pixels[j];
+        unsigned index=(unsigned)((pixel[2]>>3)+32*(pixel[1]>>3)+32*32*(pixel[0]>>3));
 
-    // TODO: check wether we really need thresholding or not
-    //threshold(xy,xy,0.0,0.0,THRESH_TOZERO);//max(0, (xx + yy - 2 * xy) / numel(x))
-    for(int i=0;i<xy.rows;i++){
-      for(int j=0;j<xy.cols;j++){
-        if(xy.at<double>(i,j)<0.0)xy.at<double>(i,j)=0.0;
+        //copy the values
+        for(int _k=0;_k<10;_k++){
+          features[j][_k]=ColorNames[index][_k];
+        }
       }
     }
 
-    double sig=-1.0/(sigma*sigma);
-    xy=sig*xy;
-    exp(xy,k_data);
-
   }
 
   /* CIRCULAR SHIFT Function
@@ -772,18 +904,17 @@ namespace cv{
   }
 
   /*
-   * calculate the detection response
+   * calculate the spectrum of the detection response
    */
-  void TrackerKCFImpl::calcResponse(const Mat alphaf_data, const Mat kf_data, Mat & response_data, Mat & spec_data) const {
+  void TrackerKCFImpl::calcResponse(const Mat& alphaf_data, const Mat& kf_data, Mat & spec_data) const {
     //alpha f--> 2channels ; k --> 1 channel;
     mulSpectrums(alphaf_data,kf_data,spec_data,0,false);
-    ifft2(spec_data,response_data);
   }
 
   /*
-   * calculate the detection response for splitted form
+   * calculate the spectrum of the detection response for splitted form
    */
-  void TrackerKCFImpl::calcResponse(const Mat alphaf_data, const Mat _alphaf_den, const Mat kf_data, Mat & response_data, Mat & spec_data, Mat & spec2_data) const {
+  void TrackerKCFImpl::calcResponse(const Mat& alphaf_data, const Mat& _alphaf_den, const Mat& kf_data, Mat & spec_data, Mat & spec2_data) const {
 
     mulSpectrums(alphaf_data,kf_data,spec_data,0,false);
 
@@ -798,8 +929,6 @@ namespace cv{
           (spec_data.at<Vec2d>(i,j)[1]*_alphaf_den.at<Vec2d>(i,j)[0]-spec_data.at<Vec2d>(i,j)[0]*_alphaf_den.at<Vec2d>(i,j)[1])*den;
       }
     }
-
-    ifft2(spec2_data,response_data);
   }
 
   void TrackerKCFImpl::setFeatureExtractor(void (*f)(const Mat, const Rect, Mat&), bool pca_func){
@@ -811,6 +940,113 @@ namespace cv{
       use_custom_extractor_npca = true;
     }
   }
+  /*-------------------------------------
+  |  deferred fourier transforms
+  |-------------------------------------*/
+
+  static void runDftJob(const KCFDftJob& job){
+    if(job.inverse)
+      idft(job.src,*job.dst,DFT_SCALE+DFT_REAL_OUTPUT);
+    else
+      dft(job.src,*job.dst,DFT_COMPLEX_OUTPUT);
+  }
+
+  /*
+   * 2D transforms of equally sized planes as two passes of 1D transforms of all their rows and columns.
+   * Forward: real planes to complex spectrums, inverse: complex spectrums with conjugate symmetry to real planes.
+   */
+  static void runDftBatch(const std::vector<KCFDftJob> & jobs, const std::vector<int> & group){
+    const int rows=jobs[group[0]].src.rows, cols=jobs[group[0]].src.cols, n=(int)group.size();
+    Mat rowsData, colsData(n*cols, rows, CV_64FC2), roi;
+
+    if(!jobs[group[0]].inverse){
+      // rows pass, real to complex
+      Mat planes(n*rows, cols, CV_64F);
+      for(int i=0;i<n;i++){
+        roi=planes.rowRange(i*rows,(i+1)*rows);
+        jobs[group[i]].src.copyTo(roi);
+      }
+      dft(planes,rowsData,DFT_ROWS+DFT_COMPLEX_OUTPUT);
+
+      // columns pass, complex to complex
+      for(int i=0;i<n;i++){
+        roi=colsData.rowRange(i*cols,(i+1)*cols);
+        transpose(rowsData.rowRange(i*rows,(i+1)*rows),roi);
+      }
+      dft(colsData,colsData,DFT_ROWS);
+
+      for(int i=0;i<n;i++)
+        transpose(colsData.rowRange(i*cols,(i+1)*cols),*jobs[group[i]].dst);
+    }else{
+      // columns pass, complex to complex
+      for(int i=0;i<n;i++){
+        roi=colsData.rowRange(i*cols,(i+1)*cols);
+        transpose(jobs[group[i]].src,roi);
+      }
+      dft(colsData,colsData,DFT_INVERSE+DFT_ROWS+DFT_SCALE);
+
+      // rows pass, complex to real
+      Mat spectrums(n*rows, cols, CV_64FC2);
+      for(int i=0;i<n;i++){
+        roi=spectrums.rowRange(i*rows,(i+1)*rows);
+        transpose(colsData.rowRange(i*cols,(i+1)*cols),roi);
+      }
+      dft(spectrums,rowsData,DFT_INVERSE+DFT_ROWS+DFT_SCALE+DFT_REAL_OUTPUT);
+
+      for(int i=0;i<n;i++)
+        rowsData.rowRange(i*rows,(i+1)*rows).copyTo(*jobs[group[i]].dst);
+    }
+  }
+
+  class DftBatchInvoker : public ParallelLoopBody{
+  public:
+    DftBatchInvoker(const std::vector<KCFDftJob> & _jobs, const std::vector<std::vector<int> > & _groups) :
+      jobs(_jobs), groups(_groups){}
+
+    void operator()(const Range& range) const {
+      for(int g=range.start;g<range.end;g++){
+        if(groups[g].size()==1)
+          runDftJob(jobs[groups[g][0]]);
+        else
+          runDftBatch(jobs, groups[g]);
+      }
+    }
+
+  private:
+    const std::vector<KCFDftJob> & jobs;
+    const std::vector<std::vector<int> > & groups;
+    DftBatchInvoker& operator=(const DftBatchInvoker&);
+  };
+
+  void runDftJobs(std::vector<KCFDftJob> & jobs, bool batch){
+    if(!batch){
+      for(unsigned i=0;i<jobs.size();i++)
+        runDftJob(jobs[i]);
+      jobs.clear();
+      return;
+    }
+
+    // group the jobs by the direction and the size of the planes
+    std::vector<std::vector<int> > groups;
+    for(int i=0;i<(int)jobs.size();i++){
+      const Mat& src=jobs[i].src;
+      CV_Assert(src.type()==(jobs[i].inverse ? CV_64FC2 : CV_64FC1));
+
+      unsigned g=0;
+      for(;g<groups.size();g++){
+        const KCFDftJob& first=jobs[groups[g][0]];
+        if(first.inverse==jobs[i].inverse && first.src.size()==src.size())
+          break;
+      }
+      if(g==groups.size())
+        groups.push_back(std::vector<int>());
+      groups[g].push_back(i);
+    }
+
+    parallel_for_(Range(0,(int)groups.size()),DftBatchInvoker(jobs,groups));
+    jobs.clear();
+  }
+
   /*----------------------------------------------------------------------*/
 
   /*
@@ -832,6 +1068,13 @@ namespace cv{
       compress_feature=true;
       compressed_size=2;
       pca_learning_rate=0.15;
+
+      //scale estimation
+      scale_adaptive=false;
+      scale_count=33;
+      scale_step=1.02;
+      scale_sigma_factor=0.25;
+      scale_model_max_area=512;
   }
 
   void TrackerKCF::Params::read( const cv::FileNode& /*fn*/ ){}
@@ -0,0 +1,207 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#ifndef OPENCV_TRACKER_KCF
+#define OPENCV_TRACKER_KCF
+
+#include "precomp.hpp"
+#include <complex>
+
+namespace cv{
+
+  /*
+   * Deferred fourier transform of a plane, it allows to run the transforms of several trackers together
+   */
+  struct KCFDftJob{
+    Mat src;
+    Mat* dst;
+    bool inverse; // inverse transform with scaling and real output, forward transform with complex output otherwise
+  };
+
+  /*
+   * Performs the scheduled transforms and clears the list.
+   * If batch is true, the jobs on equally sized planes are grouped and transformed as the rows of a single matrix,
+   * so the DFT is factorized once per group instead of once per plane, and the groups run in parallel.
+   */
+  void runDftJobs(std::vector<KCFDftJob> & jobs, bool batch);
+
+  /*
+ * Prototype
+ */
+  class TrackerKCFImpl : public TrackerKCF {
+  public:
+    TrackerKCFImpl( const TrackerKCF::Params &parameters = TrackerKCF::Params() );
+    void read( const FileNode& /*fn*/ );
+    void write( FileStorage& /*fs*/ ) const;
+    void setFeatureExtractor(void (*f)(const Mat, const Rect, Mat&), bool pca_func = false);
+
+    /*
+    * Staged update. updateImpl runs the stages one after another,
+    * MultiTrackerKCF runs every stage for all targets before the next one to batch their transforms.
+    * The detection is done only if isDetecting() is true:
+    *   detectFeatures, correlate, computeKernel, computeResponse, locateTarget, estimateScale
+    * and the training is done every frame:
+    *   trainFeatures, correlate, computeKernel, updateCoefficients
+    * The transforms scheduled by a stage have to be done (see runDftJobs) before the next stage.
+    */
+    bool usesResizedImage() const { return resizeImage; }
+    bool usesGrayFeatures() const { return ((params.desc_pca | params.desc_npca) & GRAY) == GRAY || params.scale_adaptive; }
+    bool isDetecting() const { return frame > 0; }
+
+    // img is the frame resized according to usesResizedImage(), imgGray is its grayscale version or empty
+    bool detectFeatures(const Mat& img, const Mat& imgGray, std::vector<KCFDftJob> & jobs);
+    bool trainFeatures(const Mat& img, const Mat& imgGray, Rect2d& boundingBox, std::vector<KCFDftJob> & jobs);
+    void correlate(std::vector<KCFDftJob> & jobs);
+    void computeKernel(std::vector<KCFDftJob> & jobs);
+    void computeResponse(std::vector<KCFDftJob> & jobs);
+    void locateTarget();
+    void estimateScale(const Mat& img, const Mat& imgGray);
+    void updateCoefficients();
+
+  protected:
+     /*
+    * basic functions and vars
+    */
+    bool initImpl( const Mat& /*image*/, const Rect2d& boundingBox );
+    bool updateImpl( const Mat& image, Rect2d& boundingBox );
+
+    TrackerKCF::Params params;
+
+    /*
+    * KCF functions and vars
+    */
+    void createHanningWindow(OutputArray dest, const cv::Size winSize, const int type) const;
+    void inline fft2(const Mat& src, Mat & dest) const;
+    void inline ifft2(const Mat& src, Mat & dest) const;
+    void inline pixelWiseMult(const std::vector<Mat> & src1, const std::vector<Mat> & src2, std::vector<Mat> & dest, const int flags, const bool conjB=false) const;
+    void inline sumChannels(const std::vector<Mat> & src, Mat & dest) const;
+    void inline updateProjectionMatrix(const Mat& src, Mat & old_cov,Mat &  proj_matrix,double pca_rate, int compressed_sz,
+                                       std::vector<Mat> & layers_pca,std::vector<Scalar> & average, Mat & pca_data, Mat & new_cov, Mat & w, Mat & u, Mat & vt,
+                                       Mat & proj_vars, Mat & proj_cov) const;
+    void inline compress(const Mat& proj_matrix, const Mat& src, Mat & dest, Mat & data, Mat & compressed) const;
+    Rect2d scaledRoi() const;
+    bool cropPatch(const Mat& src, const Rect roi, Mat& patch) const;
+    bool getSubWindow(const Mat& img, const Rect roi, Mat& feat, TrackerKCF::MODE desc = GRAY, const Mat& imgGray = Mat());
+    bool getSubWindow(const Mat& img, const Rect roi, Mat& feat, void (*f)(const Mat, const Rect, Mat& ));
+    bool extractFeatures(const Mat& img, const Mat& imgGray);
+    void scheduleFeaturesDft(const Mat& src, std::vector<Mat> & layers_data, std::vector<Mat> & dest, std::vector<KCFDftJob> & jobs) const;
+    void extractCN(const Mat& patch_data, Mat & cnFeatures) const;
+    void initScaleFilter();
+    bool getScaleSamples(const Mat& img, const Mat& imgGray);
+    void trainScale(const Mat& img, const Mat& imgGray);
+    void calcResponse(const Mat& alphaf_data, const Mat& kf_data, Mat & spec_data) const;
+    void calcResponse(const Mat& alphaf_data, const Mat& alphaf_den_data, const Mat& kf_data, Mat & spec_data, Mat & spec2_data) const;
+
+    void shiftRows(Mat& mat) const;
+    void shiftRows(Mat& mat, int n) const;
+    void shiftCols(Mat& mat, int n) const;
+
+  private:
+    double output_sigma;
+    Rect2d roi;
+    Mat hann; 	//hann window filter
+    Mat hann_cn; //10 dimensional hann-window filter for CN features,
+
+    Mat y,yf; 	// training response and its FFT
+    Mat x; 	// observation and its FFT
+    Mat k,kf;	// dense gaussian kernel and its FFT
+    Mat kf_lambda; // kf+lambda
+    Mat new_alphaf, alphaf;	// training coefficients
+    Mat new_alphaf_den, alphaf_den; // for splitted training coefficients
+    Mat z; // model
+    Mat response; // detection result
+    Mat old_cov_mtx, proj_mtx; // for feature compression
+
+    // pre-defined Mat variables for optimization of private functions
+    Mat spec, spec2;
+    std::vector<Mat> layers, layers_z;
+    std::vector<Mat> vxf,vyf,vxyf;
+    Mat xy_data,xyf_data;
+    Mat data_temp, compress_data;
+    std::vector<Mat> layers_pca_data;
+    std::vector<Scalar> average_data;
+    Mat img_Patch, gray_Patch; // the patch cut from the frame and its grayscale version
+    Mat hann_custom; // hann window with the channels of the custom features
+    Mat img_resized; // the frame resized for the large targets
+    Mat img_gray; // grayscale version of the frame, shared by the translation and the scale features
+    Mat scaled_Patch; // the patch resized to the template size when the target scale is not 1
+    std::vector<KCFDftJob> dft_jobs;
+
+    // state of the dense gauss kernel between the stages
+    double normX, normY;
+    bool autoCorrelation; // the kernel of x with itself, the transform of x is reused
+
+    // storage for the extracted features, compressed features, KRLS model, KRLS compressed model
+    Mat X[2],Xc[2],Z[2],Zc[2];
+
+    // storage of the extracted features
+    std::vector<Mat> features_pca;
+    std::vector<Mat> features_npca;
+    std::vector<MODE> descriptors_pca;
+    std::vector<MODE> descriptors_npca;
+
+    // optimization variables for updateProjectionMatrix
+    Mat data_pca, new_covar,w_data,u_data,vt_data,proj_vars_data,proj_covar;
+
+    // custom feature extractor
+    bool use_custom_extractor_pca;
+    bool use_custom_extractor_npca;
+    std::vector<void(*)(const Mat img, const Rect roi, Mat& output)> extractor_pca;
+    std::vector<void(*)(const Mat img, const Rect roi, Mat& output)> extractor_npca;
+
+    bool resizeImage; // resize the image whenever needed and the patch size is large
+
+    // DSST-style scale filter: one feature vector per scale, one 1D transform over the scales per feature
+    double currentScale, minScaleFactor, maxScaleFactor;
+    std::vector<double> scaleFactors, scaleWindow;
+    Size2d baseTargetSize; // target size at the initial scale
+    Size scaleModelSize; // the scale samples are resized to this size
+    Mat ysf; // FFT of the desired scale response, repeated for every feature
+    Mat sf_num, sf_den; // scale filter numerator and denominator
+    Mat scale_samples, scale_samplesf, scale_spec, scale_respf, scale_response;
+    Mat scale_Patch, scale_Patch_resized;
+
+    int frame;
+  };
+
+} /* namespace cv */
+
+#endif
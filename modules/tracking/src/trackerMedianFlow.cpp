@@ -40,6 +40,7 @@
  //M*/
 
 #include "precomp.hpp"
+#include "trackerMedianFlow.hpp"
 #include "opencv2/video/tracking.hpp"
 #include "opencv2/imgproc.hpp"
 #include <algorithm>
@@ -74,43 +75,24 @@ namespace cv
  *       bring "out" all the parameters to TrackerMedianFlow::Param
  */
 
-class TrackerMedianFlowImpl : public TrackerMedianFlow{
- public:
-     TrackerMedianFlowImpl(TrackerMedianFlow::Params paramsIn):termcrit(TermCriteria::COUNT|TermCriteria::EPS,20,0.3){params=paramsIn;isInit=false;}
-     void read( const FileNode& fn );
-     void write( FileStorage& fs ) const;
- private:
-     bool initImpl( const Mat& image, const Rect2d& boundingBox );
-     bool updateImpl( const Mat& image, Rect2d& boundingBox );
-     bool medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& oldBox);
-     Rect2d vote(const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,const Rect2d& oldRect,Point2f& mD);
-     //FIXME: this can be optimized: current method uses sort->select approach, there are O(n) selection algo for median; besides
-          //it makes copy all the time
-     template<typename T>
-     T getMedian( std::vector<T>& values,int size=-1);
-     float dist(Point2f p1,Point2f p2);
-     std::string type2str(int type);
-     void computeStatistics(std::vector<float>& data,int size=-1);
-     void check_FB(const Mat& oldImage,const Mat& newImage,
-             const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,std::vector<bool>& status);
-     void check_NCC(const Mat& oldImage,const Mat& newImage,
-             const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,std::vector<bool>& status);
-     inline double l2distance(Point2f p1,Point2f p2);
-
-     TrackerMedianFlow::Params params;
-     TermCriteria termcrit;
-};
+// the window and the levels of the pyramidal Lucas-Kanade flow
+static const Size LK_WIN_SIZE(3,3);
+static const int LK_MAX_LEVEL=5;
+
+static TermCriteria LKTermCriteria(){
+    return TermCriteria(TermCriteria::COUNT|TermCriteria::EPS,20,0.3);
+}
 
 class TrackerMedianFlowModel : public TrackerModel{
  public:
   TrackerMedianFlowModel(TrackerMedianFlow::Params /*params*/){}
   Rect2d getBoundingBox(){return boundingBox_;}
   void setBoudingBox(Rect2d boundingBox){boundingBox_=boundingBox;}
-  Mat getImage(){return image_;}
-  void setImage(const Mat& image){image.copyTo(image_);}
+  const Ptr<MedianFlowFrame>& getFrame(){return frame_;}
+  void setFrame(const Ptr<MedianFlowFrame>& frame){frame_=frame;}
  protected:
   Rect2d boundingBox_;
-  Mat image_;
+  Ptr<MedianFlowFrame> frame_;
   void modelEstimationImpl( const std::vector<Mat>& /*responses*/ ){}
   void modelUpdateImpl(){}
 };
@@ -144,22 +126,80 @@ Ptr<TrackerMedianFlow> TrackerMedianFlow::createTracker(const TrackerMedianFlow:
     return Ptr<TrackerMedianFlowImpl>(new TrackerMedianFlowImpl(parameters));
 }
 
+TrackerMedianFlowImpl::TrackerMedianFlowImpl(TrackerMedianFlow::Params paramsIn){
+    params=paramsIn;
+    isInit=false;
+}
+
 bool TrackerMedianFlowImpl::initImpl( const Mat& image, const Rect2d& boundingBox ){
     model=Ptr<TrackerMedianFlowModel>(new TrackerMedianFlowModel(params));
-    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setImage(image);
+    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setFrame(prepareFrame(image));
     ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setBoudingBox(boundingBox);
     return true;
 }
 
 bool TrackerMedianFlowImpl::updateImpl( const Mat& image, Rect2d& boundingBox ){
-    Mat oldImage=((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getImage();
+    Ptr<MedianFlowFrame> oldFrame=getFrame();
+    Ptr<MedianFlowFrame> newFrame=prepareFrame(image);
+
+    std::vector<Point2f> pointsToTrackOld,pointsToTrackNew,pointsToTrackReprojection;
+    std::vector<uchar> status;
+    getGridPoints(pointsToTrackOld);
+    trackPoints(*oldFrame,*newFrame,pointsToTrackOld,pointsToTrackNew,status,pointsToTrackReprojection);
+    return finishUpdate(newFrame,pointsToTrackOld,pointsToTrackNew,status,pointsToTrackReprojection,boundingBox);
+}
+
+// the grayscale frame and its pyramid are computed once, the pyramid of the frame tracked to is reused
+// as the one of the frame tracked from at the next update
+Ptr<MedianFlowFrame> TrackerMedianFlowImpl::prepareFrame(const Mat& image){
+    Ptr<MedianFlowFrame> frame=makePtr<MedianFlowFrame>();
+    if (image.channels() != 1)
+        cvtColor( image, frame->gray, COLOR_BGR2GRAY );
+    else
+        image.copyTo(frame->gray);
+    // both frames are the previous image of one of the flows, so both need the derivatives
+    buildOpticalFlowPyramid(frame->gray,frame->pyramid,LK_WIN_SIZE,LK_MAX_LEVEL,true);
+    return frame;
+}
+
+const Ptr<MedianFlowFrame>& TrackerMedianFlowImpl::getFrame() const{
+    return ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getFrame();
+}
 
+void TrackerMedianFlowImpl::getGridPoints(std::vector<Point2f>& points) const{
     Rect2d oldBox=((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getBoundingBox();
-    if(!medianFlowImpl(oldImage,image,oldBox)){
+
+    //"open ended" grid
+    points.clear();
+    for(int i=0;i<params.pointsInGrid;i++){
+        for(int j=0;j<params.pointsInGrid;j++){
+                points.push_back(
+                        Point2f((float)(oldBox.x+((1.0*oldBox.width)/params.pointsInGrid)*j+.5*oldBox.width/params.pointsInGrid),
+                        (float)(oldBox.y+((1.0*oldBox.height)/params.pointsInGrid)*i+.5*oldBox.height/params.pointsInGrid)));
+        }
+    }
+}
+
+void TrackerMedianFlowImpl::trackPoints(const MedianFlowFrame& oldFrame, const MedianFlowFrame& newFrame,
+        const std::vector<Point2f>& oldPoints, std::vector<Point2f>& newPoints, std::vector<uchar>& status,
+        std::vector<Point2f>& reprojectedPoints){
+    status.resize(oldPoints.size());
+    std::vector<float> errors(oldPoints.size());
+    calcOpticalFlowPyrLK(oldFrame.pyramid,newFrame.pyramid,oldPoints,newPoints,status,errors,LK_WIN_SIZE,LK_MAX_LEVEL,LKTermCriteria(),0);
+
+    std::vector<uchar> LKstatus(oldPoints.size());
+    calcOpticalFlowPyrLK(newFrame.pyramid,oldFrame.pyramid,newPoints,reprojectedPoints,LKstatus,errors,LK_WIN_SIZE,LK_MAX_LEVEL,LKTermCriteria(),0);
+}
+
+bool TrackerMedianFlowImpl::finishUpdate(const Ptr<MedianFlowFrame>& newFrame, std::vector<Point2f> oldPoints,
+        std::vector<Point2f> newPoints, const std::vector<uchar>& status, const std::vector<Point2f>& reprojectedPoints,
+        Rect2d& boundingBox){
+    Rect2d oldBox=((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->getBoundingBox();
+    if(!medianFlowImpl(*getFrame(),*newFrame,oldPoints,newPoints,status,reprojectedPoints,oldBox)){
         return false;
     }
     boundingBox=oldBox;
-    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setImage(image);
+    ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setFrame(newFrame);
     ((TrackerMedianFlowModel*)static_cast<TrackerModel*>(model))->setBoudingBox(oldBox);
     return true;
 }
@@ -186,32 +226,9 @@ std::string TrackerMedianFlowImpl::type2str(int type) {
 
   return r;
 }
-bool TrackerMedianFlowImpl::medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& oldBox){
-    std::vector<Point2f> pointsToTrackOld,pointsToTrackNew;
-
-    Mat oldImage_gray,newImage_gray;
-    if (oldImage.channels() != 1)
-        cvtColor( oldImage, oldImage_gray, COLOR_BGR2GRAY );
-    else
-        oldImage.copyTo(oldImage_gray);
-
-    if (newImage.channels() != 1)
-        cvtColor( newImage, newImage_gray, COLOR_BGR2GRAY );
-    else
-        newImage.copyTo(newImage_gray);
-
-    //"open ended" grid
-    for(int i=0;i<params.pointsInGrid;i++){
-        for(int j=0;j<params.pointsInGrid;j++){
-                pointsToTrackOld.push_back(
-                        Point2f((float)(oldBox.x+((1.0*oldBox.width)/params.pointsInGrid)*j+.5*oldBox.width/params.pointsInGrid),
-                        (float)(oldBox.y+((1.0*oldBox.height)/params.pointsInGrid)*i+.5*oldBox.height/params.pointsInGrid)));
-        }
-    }
-
-    std::vector<uchar> status(pointsToTrackOld.size());
-    std::vector<float> errors(pointsToTrackOld.size());
-    calcOpticalFlowPyrLK(oldImage_gray, newImage_gray,pointsToTrackOld,pointsToTrackNew,status,errors,Size(3,3),5,termcrit,0);
+bool TrackerMedianFlowImpl::medianFlowImpl(const MedianFlowFrame& oldFrame,const MedianFlowFrame& newFrame,
+        std::vector<Point2f>& pointsToTrackOld,std::vector<Point2f>& pointsToTrackNew,
+        const std::vector<uchar>& status,const std::vector<Point2f>& pointsToTrackReprojection,Rect2d& oldBox){
     dprintf(("\t%d after LK forward\n",(int)pointsToTrackOld.size()));
 
     std::vector<Point2f> di;
@@ -222,8 +239,8 @@ bool TrackerMedianFlowImpl::medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& old
     }
 
     std::vector<bool> filter_status;
-    check_FB(oldImage_gray,newImage_gray,pointsToTrackOld,pointsToTrackNew,filter_status);
-    check_NCC(oldImage_gray,newImage_gray,pointsToTrackOld,pointsToTrackNew,filter_status);
+    check_FB(pointsToTrackOld,pointsToTrackReprojection,filter_status);
+    check_NCC(oldFrame.gray,newFrame.gray,pointsToTrackOld,pointsToTrackNew,filter_status);
 
     // filter
     for(int i=0;i<(int)pointsToTrackOld.size();i++){
@@ -255,7 +272,6 @@ bool TrackerMedianFlowImpl::medianFlowImpl(Mat oldImage,Mat newImage,Rect2d& old
 }
 
 Rect2d TrackerMedianFlowImpl::vote(const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,const Rect2d& oldRect,Point2f& mD){
-    static int iteration=0;//FIXME -- we don't want this static var in final release
     Rect2d newRect;
     Point2d newCenter(oldRect.x+oldRect.width/2.0,oldRect.y+oldRect.height/2.0);
     int n=(int)oldPoints.size();
@@ -297,7 +313,7 @@ Rect2d TrackerMedianFlowImpl::vote(const std::vector<Point2f>& oldPoints,const s
     }
 
     double scale=getMedian(buf,n*(n-1)/2);
-    dprintf(("iter %d %f %f %f\n",iteration,xshift,yshift,scale));
+    dprintf(("shift %f %f scale %f\n",xshift,yshift,scale));
     newRect.x=newCenter.x-scale*oldRect.width/2.0;
     newRect.y=newCenter.y-scale*oldRect.height/2.0;
     newRect.width=scale*oldRect.width;
@@ -308,7 +324,6 @@ Rect2d TrackerMedianFlowImpl::vote(const std::vector<Point2f>& oldPoints,const s
     dprintf(("rect old [%f %f %f %f]\n",oldRect.x,oldRect.y,oldRect.width,oldRect.height));
     dprintf(("rect [%f %f %f %f]\n",newRect.x,newRect.y,newRect.width,newRect.height));
 
-    iteration++;
     return newRect;
 }
 
@@ -344,19 +359,14 @@ double TrackerMedianFlowImpl::l2distance(Point2f p1,Point2f p2){
     double dx=p1.x-p2.x, dy=p1.y-p2.y;
     return sqrt(dx*dx+dy*dy);
 }
-void TrackerMedianFlowImpl::check_FB(const Mat& oldImage,const Mat& newImage,
-        const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,std::vector<bool>& status){
+void TrackerMedianFlowImpl::check_FB(const std::vector<Point2f>& oldPoints,
+        const std::vector<Point2f>& pointsToTrackReprojection,std::vector<bool>& status){
 
     if(status.size()==0){
         status=std::vector<bool>(oldPoints.size(),true);
     }
 
-    std::vector<uchar> LKstatus(oldPoints.size());
-    std::vector<float> errors(oldPoints.size());
     std::vector<double> FBerror(oldPoints.size());
-    std::vector<Point2f> pointsToTrackReprojection;
-    calcOpticalFlowPyrLK(newImage, oldImage,newPoints,pointsToTrackReprojection,LKstatus,errors,Size(3,3),5,termcrit,0);
-
     for(int i=0;i<(int)oldPoints.size();i++){
         FBerror[i]=l2distance(oldPoints[i],pointsToTrackReprojection[i]);
     }
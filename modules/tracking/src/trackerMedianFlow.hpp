@@ -0,0 +1,108 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+
+#ifndef OPENCV_TRACKER_MEDIANFLOW
+#define OPENCV_TRACKER_MEDIANFLOW
+
+#include "precomp.hpp"
+
+namespace cv{
+
+  /*
+   * Grayscale frame and its pyramid for the Lucas-Kanade flow, with the derivatives.
+   * The frame tracked to is kept as the frame tracked from at the next update,
+   * and it is shared by the targets of a MultiTrackerMedianFlow.
+   */
+  struct MedianFlowFrame{
+    Mat gray;
+    std::vector<Mat> pyramid;
+  };
+
+  /*
+ * Prototype
+ */
+  class TrackerMedianFlowImpl : public TrackerMedianFlow{
+  public:
+    TrackerMedianFlowImpl(TrackerMedianFlow::Params paramsIn);
+    void read( const FileNode& fn );
+    void write( FileStorage& fs ) const;
+
+    /*
+    * Staged update. updateImpl runs the stages for a single target,
+    * MultiTrackerMedianFlow prepares the frame once and tracks the grid points of all the targets
+    * sharing their previous frame with the same calls:
+    *   prepareFrame, getGridPoints, trackPoints, finishUpdate
+    */
+    static Ptr<MedianFlowFrame> prepareFrame(const Mat& image);
+    const Ptr<MedianFlowFrame>& getFrame() const;
+    void getGridPoints(std::vector<Point2f>& points) const;
+    // forward flow of oldPoints and backward flow of the result, status is the one of the forward flow
+    static void trackPoints(const MedianFlowFrame& oldFrame, const MedianFlowFrame& newFrame,
+            const std::vector<Point2f>& oldPoints, std::vector<Point2f>& newPoints, std::vector<uchar>& status,
+            std::vector<Point2f>& reprojectedPoints);
+    // oldPoints are the grid points and the frame is kept on success only, as in updateImpl
+    bool finishUpdate(const Ptr<MedianFlowFrame>& newFrame, std::vector<Point2f> oldPoints, std::vector<Point2f> newPoints,
+            const std::vector<uchar>& status, const std::vector<Point2f>& reprojectedPoints, Rect2d& boundingBox);
+
+  private:
+    bool initImpl( const Mat& image, const Rect2d& boundingBox );
+    bool updateImpl( const Mat& image, Rect2d& boundingBox );
+    bool medianFlowImpl(const MedianFlowFrame& oldFrame,const MedianFlowFrame& newFrame,
+            std::vector<Point2f>& pointsToTrackOld,std::vector<Point2f>& pointsToTrackNew,
+            const std::vector<uchar>& status,const std::vector<Point2f>& pointsToTrackReprojection,Rect2d& oldBox);
+    Rect2d vote(const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,const Rect2d& oldRect,Point2f& mD);
+    //FIXME: this can be optimized: current method uses sort->select approach, there are O(n) selection algo for median; besides
+         //it makes copy all the time
+    template<typename T>
+    T getMedian( std::vector<T>& values,int size=-1);
+    float dist(Point2f p1,Point2f p2);
+    std::string type2str(int type);
+    void computeStatistics(std::vector<float>& data,int size=-1);
+    void check_FB(const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& pointsToTrackReprojection,std::vector<bool>& status);
+    void check_NCC(const Mat& oldImage,const Mat& newImage,
+            const std::vector<Point2f>& oldPoints,const std::vector<Point2f>& newPoints,std::vector<bool>& status);
+    inline double l2distance(Point2f p1,Point2f p2);
+
+    TrackerMedianFlow::Params params;
+  };
+
+} /* namespace cv */
+
+#endif
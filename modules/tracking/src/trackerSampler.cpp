@@ -75,11 +75,10 @@ void TrackerSampler::sampling( const Mat& image, Rect boundingBox )
     samplers[i].second->sampling( image, boundingBox, current_samples );
 
     //push in samples all current_samples
-    for ( size_t j = 0; j < current_samples.size(); j++ )
-    {
-      std::vector<Mat>::iterator it = samples.end();
-      samples.insert( it, current_samples.at( j ) );
-    }
+    if( samples.empty() )
+      samples.swap( current_samples );
+    else
+      samples.insert( samples.end(), current_samples.begin(), current_samples.end() );
   }
 
   if( !blockAddTrackerSampler )
@@ -186,24 +186,27 @@ std::vector<Mat> TrackerSamplerCSC::sampleImage( const Mat& img, int x, int y, i
 
   //fprintf(stderr,"inrad=%f minrow=%d maxrow=%d mincol=%d maxcol=%d\n",inrad,minrow,maxrow,mincol,maxcol);
 
-  std::vector<Mat> samples;
-  samples.resize( ( maxrow - minrow + 1 ) * ( maxcol - mincol + 1 ) );
-  int i = 0;
+  // the windows are kept as rectangles and only the maxnum first accepted ones become samples, which are
+  // headers over img, the generator is still drawn for every position so the samples don't change
+  size_t numPositions = (size_t) ( maxrow - minrow + 1 ) * ( maxcol - mincol + 1 );
+  std::vector<Rect> windows;
+  windows.reserve( min( numPositions, (size_t) max( maxnum, 0 ) ) );
 
-  float prob = ( (float) ( maxnum ) ) / samples.size();
+  float prob = ( (float) ( maxnum ) ) / numPositions;
 
   for ( int r = minrow; r <= int( maxrow ); r++ )
     for ( int c = mincol; c <= int( maxcol ); c++ )
     {
       dist = ( y - r ) * ( y - r ) + ( x - c ) * ( x - c );
-      if( float( rng.uniform( 0.f, 1.f ) ) < prob && dist < inradsq && dist >= outradsq )
+      if( float( rng.uniform( 0.f, 1.f ) ) < prob && dist < inradsq && dist >= outradsq && (int) windows.size() < maxnum )
       {
-        samples[i] = img( Rect( c, r, w, h ) );
-        i++;
+        windows.push_back( Rect( c, r, w, h ) );
       }
     }
 
-  samples.resize( min( i, maxnum ) );
+  std::vector<Mat> samples( windows.size() );
+  for ( size_t i = 0; i < windows.size(); i++ )
+    samples[i] = img( windows[i] );
   return samples;
 }
 ;
@@ -41,53 +41,41 @@
 
 #include "precomp.hpp"
 #include "opencv2/tracking/kalman_filters.hpp"
+#include "unscented_kalman_common.hpp"
 
 namespace cv
 {
 namespace tracking
 {
 
-/* Cholesky decomposition
- The function performs Cholesky decomposition <https://en.wikipedia.org/wiki/Cholesky_decomposition>.
- A - the Hermitian, positive-definite matrix,
- astep - size of row in A,
- asize - number of cols and rows in A,
- L - the lower triangular matrix, A = L*Lt.
-*/
-template<typename _Tp> bool
-inline choleskyDecomposition( const _Tp* A, size_t astep, const int asize, _Tp* L )
+void UkfSystemModel::stateConversionFunctionBatch( const Mat& x_k, const Mat& u_k, const Mat& v_k, Mat& x_kplus1 )
 {
-    int i, j, k;
-    double s;
-    astep /= sizeof(A[0]);
-    for( i = 0; i < asize; i++ )
+    CV_Assert( x_kplus1.cols == x_k.cols );
+    CV_Assert( u_k.cols <= 1 || u_k.cols == x_k.cols );
+    CV_Assert( v_k.cols <= 1 || v_k.cols == x_k.cols );
 
+    Mat u, v, fx;
+    for ( int i = 0; i < x_k.cols; i++ )
     {
-        for( j = 0; j < i; j++ )
-        {
-            s = A[i*astep + j];
-            for( k = 0; k < j; k++ )
-                s -= L[i*astep + k]*L[j*astep + k];
-            L[i*astep + j] = (_Tp)(s/L[j*astep + j]);
-        }
-        s = A[i*astep + i];
-        for( k = 0; k < i; k++ )
-        {
-            double t = L[i*astep + k];
-            s -= t*t;
-        }
-        if( s < std::numeric_limits<_Tp>::epsilon() )
-            return false;
-        L[i*astep + i] = (_Tp)(std::sqrt(s));
+        u = u_k.cols > 1 ? u_k.col(i) : u_k;
+        v = v_k.cols > 1 ? v_k.col(i) : v_k;
+        fx = x_kplus1.col(i);
+        stateConversionFunction( x_k.col(i), u, v, fx );
     }
+}
 
-   for( i = 0; i < asize; i++ )
-       for( j = i+1; j < asize; j++ )
-       {
-           L[i*astep + j] = 0.0;
-       }
+void UkfSystemModel::measurementFunctionBatch( const Mat& x_k, const Mat& n_k, Mat& z_k )
+{
+    CV_Assert( z_k.cols == x_k.cols );
+    CV_Assert( n_k.cols <= 1 || n_k.cols == x_k.cols );
 
-    return true;
+    Mat n, hx;
+    for ( int i = 0; i < x_k.cols; i++ )
+    {
+        n = n_k.cols > 1 ? n_k.col(i) : n_k;
+        hx = z_k.col(i);
+        measurementFunction( x_k.col(i), n, hx );
+    }
 }
 
 void UnscentedKalmanFilterParams::
@@ -157,7 +145,13 @@ class UnscentedKalmanFilterImpl: public UnscentedKalmanFilter
     Mat measurementSPFuncValsCenter;            // set of measurement function values at sigma points minus estimate of measurement ( hc_i, i = 1..2*DP+1 ), MP x 2*DP+1
 
     Mat Wm;                                     // vector of weights for estimate mean, 2*DP+1 x 1
-    Mat Wc;                                     // matrix of weights for estimate covariance, 2*DP+1 x 2*DP+1
+    Mat WcState;                                // weights for estimate covariance repeated in each row, DP x 2*DP+1
+    Mat WcMeasurement;                          // weights for estimate covariance repeated in each row, MP x 2*DP+1
+    Mat onesRow;                                // row of ones, 1 x 2*DP+1
+
+    Mat covMatrixL;                             // Cholesky factor of P, DP x DP
+    Mat weightedState;                          // fc_i multiplied by the weights Wc[i], DP x 2*DP+1
+    Mat weightedMeasurement;                    // hc_i multiplied by the weights Wc[i], MP x 2*DP+1
 
     Mat gain;                                   // Kalman gain matrix (K), DP x MP
     Mat xyCov;                                  // estimate of the covariance between x* and y* (Sxy), DP x MP
@@ -167,12 +161,6 @@ class UnscentedKalmanFilterImpl: public UnscentedKalmanFilter
     Mat q;                                      // zero vector of measurement noise for getting measurementSPFuncVals
 
 
-//get sigma points
-    template <typename T>
-    Mat getSigmaPoints( const Mat& mean, const Mat& covMatrix, double coef );
-
-    Mat getSigmaPoints( const Mat& mean, const Mat& covMatrix, double coef );
-
 public:
 
     UnscentedKalmanFilterImpl( const UnscentedKalmanFilterParams& params );
@@ -227,30 +215,26 @@ UnscentedKalmanFilterImpl::UnscentedKalmanFilterImpl(const UnscentedKalmanFilter
 
     gain = Mat::zeros( DP, DP, dataType );
 
+    sigmaPoints = Mat::zeros( DP, 2*DP+1, dataType );
+    covMatrixL = Mat::zeros( DP, DP, dataType );
+
     transitionSPFuncVals = Mat::zeros( DP, 2*DP+1, dataType );
     measurementSPFuncVals = Mat::zeros( MP, 2*DP+1, dataType );
 
     transitionSPFuncValsCenter = Mat::zeros( DP, 2*DP+1, dataType );
     measurementSPFuncValsCenter = Mat::zeros( MP, 2*DP+1, dataType );
 
+    weightedState = Mat::zeros( DP, 2*DP+1, dataType );
+    weightedMeasurement = Mat::zeros( MP, 2*DP+1, dataType );
+
     lambda = alpha*alpha*( DP + k ) - DP;
     tmpLambda = lambda + DP;
 
-    double tmp2Lambda = 0.5/tmpLambda;
-
-    Wm = tmp2Lambda * Mat::ones( 2*DP+1, 1, dataType );
-    Wc = tmp2Lambda * Mat::eye( 2*DP+1, 2*DP+1, dataType );
-
-    if ( dataType == CV_64F )
-    {
-        Wm.at<double>(0,0) = lambda/tmpLambda;
-        Wc.at<double>(0,0) = lambda/tmpLambda + 1.0 - alpha*alpha + beta;
-    }
-    else
-    {
-        Wm.at<float>(0,0) = (float)(lambda/tmpLambda);
-        Wc.at<float>(0,0) = (float)(lambda/tmpLambda + 1.0 - alpha*alpha + beta);
-    }
+    Mat WcRow;
+    computeSigmaPointWeights( DP, alpha, beta, lambda, dataType, Wm, WcRow );
+    WcState = repeat( WcRow, DP, 1 );
+    WcMeasurement = repeat( WcRow, MP, 1 );
+    onesRow = Mat::ones( 1, 2*DP+1, dataType );
 }
 
 UnscentedKalmanFilterImpl::~UnscentedKalmanFilterImpl()
@@ -272,7 +256,13 @@ UnscentedKalmanFilterImpl::~UnscentedKalmanFilterImpl()
     measurementSPFuncValsCenter.release();
 
     Wm.release();
-    Wc.release();
+    WcState.release();
+    WcMeasurement.release();
+    onesRow.release();
+
+    covMatrixL.release();
+    weightedState.release();
+    weightedMeasurement.release();
 
     gain.release();
     xyCov.release();
@@ -282,65 +272,25 @@ UnscentedKalmanFilterImpl::~UnscentedKalmanFilterImpl()
     q.release();
 }
 
-template <typename T>
-Mat UnscentedKalmanFilterImpl::getSigmaPoints(const Mat &mean, const Mat &covMatrix, double coef)
-{
-// x_0 = mean
-// x_i = mean + coef * cholesky( covMatrix ), i = 1..n
-// x_(i+n) = mean - coef * cholesky( covMatrix ), i = 1..n
-
-    int n = mean.rows;
-    Mat points = repeat(mean, 1, 2*n+1);
-
-    Mat covMatrixL = covMatrix.clone();
-    covMatrixL.setTo(0);
-
-// covMatrixL = cholesky( covMatrix )
-    choleskyDecomposition<T>( covMatrix.ptr<T>(), covMatrix.step, covMatrix.rows, covMatrixL.ptr<T>() );
-    covMatrixL = coef * covMatrixL;
-
-    Mat p_plus = points( Rect( 1, 0, n, n ) );
-    Mat p_minus = points( Rect( n+1, 0, n, n ) );
-
-    add(p_plus, covMatrixL, p_plus);
-    subtract(p_minus, covMatrixL, p_minus);
-
-    return points;
-}
-
-Mat UnscentedKalmanFilterImpl::getSigmaPoints(const Mat &mean, const Mat &covMatrix, double coef)
-{
-    if ( dataType == CV_64F ) return getSigmaPoints<double>(mean, covMatrix, coef);
-    if ( dataType == CV_32F ) return getSigmaPoints<float>(mean, covMatrix, coef);
-
-    return Mat();
-}
-
 Mat UnscentedKalmanFilterImpl::predict(const Mat& control)
 {
 // get sigma points from x* and P
-    sigmaPoints = getSigmaPoints( state, errorCov, sqrt( tmpLambda ) );
+    computeSigmaPoints( state, errorCov, sqrt( tmpLambda ), covMatrixL, sigmaPoints );
 
-// compute f-function values at sigma points
+// compute f-function values at all the sigma points at once
 // f_i = f(x_i, control, 0), i = 0..2*DP
-    Mat x, fx;
-    for ( int i = 0; i<2*DP+1; i++)
-    {
-        x = sigmaPoints( Rect( i, 0, 1, DP) );
-        fx = transitionSPFuncVals( Rect( i, 0, 1, DP) );
-        model->stateConversionFunction( x, control, q, fx );
-    }
+    model->stateConversionFunctionBatch( sigmaPoints, control, q, transitionSPFuncVals );
+
 // compute the estimate of state as mean f-function value at sigma point
 // x* = SUM_{i=0}^{2*DP}( Wm[i]*f_i )
-    state = transitionSPFuncVals * Wm;
-
-// compute f-function values at sigma points minus estimate of state
+// and f-function values at sigma points minus estimate of state
 // fc_i = f_i - x*, i = 0..2*DP
-    subtract(transitionSPFuncVals, repeat( state, 1, 2*DP+1 ), transitionSPFuncValsCenter);
+    centerSigmaPointValues( transitionSPFuncVals, Wm, onesRow, state, transitionSPFuncValsCenter );
 
 // compute the estimate of the state cross-covariance matrix
 // P = SUM_{i=0}^{2*DP}( Wc[i]*fc_i*fc_i.t ) + Q
-    errorCov = transitionSPFuncValsCenter * Wc * transitionSPFuncValsCenter.t() + processNoiseCov;
+    weightedSigmaPointCovariance( transitionSPFuncValsCenter, transitionSPFuncValsCenter, WcState, processNoiseCov,
+                                  weightedState, errorCov );
 
     return state.clone();
 }
@@ -348,33 +298,27 @@ Mat UnscentedKalmanFilterImpl::predict(const Mat& control)
 Mat UnscentedKalmanFilterImpl::correct(const Mat& measurement)
 {
 // get sigma points from x* and P
-    sigmaPoints = getSigmaPoints( state, errorCov, sqrt( tmpLambda ) );
+    computeSigmaPoints( state, errorCov, sqrt( tmpLambda ), covMatrixL, sigmaPoints );
 
-// compute h-function values at sigma points
+// compute h-function values at all the sigma points at once
 // h_i = h(x_i, 0), i = 0..2*DP
-    Mat x, hx;
-    for ( int i = 0; i<2*DP+1; i++)
-    {
-        x = sigmaPoints( Rect( i, 0, 1, DP) );
-        hx = measurementSPFuncVals( Rect( i, 0, 1, MP) );
-        model->measurementFunction( x, r, hx );
-    }
+    model->measurementFunctionBatch( sigmaPoints, r, measurementSPFuncVals );
 
 // compute the estimate of measurement as mean h-function value at sigma point
 // y* = SUM_{i=0}^{2*DP}( Wm[i]*h_i )
-    measurementEstimate = measurementSPFuncVals * Wm;
-
-// compute h-function values at sigma points minus estimate of state
+// and h-function values at sigma points minus estimate of state
 // hc_i = h_i - y*, i = 0..2*DP
-    subtract(measurementSPFuncVals, repeat( measurementEstimate, 1, 2*DP+1 ), measurementSPFuncValsCenter);
+    centerSigmaPointValues( measurementSPFuncVals, Wm, onesRow, measurementEstimate, measurementSPFuncValsCenter );
 
 // compute the estimate of the y* cross-covariance matrix
 // Syy = SUM_{i=0}^{2*DP}( Wc[i]*hc_i*hc_i.t ) + R
-    yyCov = measurementSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t() + measurementNoiseCov;
+    weightedSigmaPointCovariance( measurementSPFuncValsCenter, measurementSPFuncValsCenter, WcMeasurement,
+                                  measurementNoiseCov, weightedMeasurement, yyCov );
 
 // compute the estimate of the covariance between x* and y*
 // Sxy = SUM_{i=0}^{2*DP}( Wc[i]*fc_i*hc_i.t )
-    xyCov = transitionSPFuncValsCenter * Wc * measurementSPFuncValsCenter.t();
+    weightedSigmaPointCovariance( transitionSPFuncValsCenter, measurementSPFuncValsCenter, WcState,
+                                  Mat(), weightedState, xyCov );
 
 // compute the Kalman gain matrix
 // K = Sxy * Syy^(-1)
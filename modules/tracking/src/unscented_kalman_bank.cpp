@@ -0,0 +1,305 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "precomp.hpp"
+#include "opencv2/tracking/kalman_filters.hpp"
+#include "unscented_kalman_common.hpp"
+
+namespace cv
+{
+namespace tracking
+{
+
+/* A bank of N Unscented Kalman filters sharing the parameters and the model.
+ The states are the columns of one DP x N matrix and the covariances the rows of one N x DP*DP matrix.
+ The sigma points of filter i are the columns i*(2*DP+1)..(i+1)*(2*DP+1)-1 of one DP x N*(2*DP+1) matrix,
+ so the model is called once for all of them, while the decompositions and the updates run in parallel.
+*/
+class UnscentedKalmanFilterBankImpl: public UnscentedKalmanFilterBank
+{
+    int DP;                                     // dimensionality of the state vector
+    int MP;                                     // dimensionality of the measurement vector
+    int CP;                                     // dimensionality of the control vector
+    int N;                                      // number of filters
+    int L;                                      // number of sigma points of a filter, 2*DP+1
+    int dataType;                               // type of elements of vectors and matrices
+
+    Mat states;                                 // estimates of the system states (x*), DP x N
+    Mat errorCovs;                              // estimates of the state cross-covariance matrices (P), N x DP*DP
+
+    Mat processNoiseCov;                        // process noise cross-covariance matrix (Q), DP x DP
+    Mat measurementNoiseCov;                    // measurement noise cross-covariance matrix (R), MP x MP
+
+    Ptr<UkfSystemModel> model;                  // object of the class containing functions for computing the next state and the measurement.
+
+    double tmpLambda;                           // internal parameter, tmpLambda = alpha*alpha*( DP + k );
+
+    Mat sigmaPoints;                            // sigma points of all the filters, DP x N*L
+    Mat transitionSPFuncVals;                   // state function values at the sigma points, DP x N*L
+    Mat measurementSPFuncVals;                  // measurement function values at the sigma points, MP x N*L
+    Mat transitionSPFuncValsCenter;             // state function values minus the estimates of the states, DP x N*L
+    Mat controls;                               // controls of the filters repeated for each sigma point, CP x N*L
+
+    Mat Wm;                                     // vector of weights for estimate mean, L x 1
+    Mat WcState;                                // weights for estimate covariance repeated in each row, DP x L
+    Mat WcMeasurement;                          // weights for estimate covariance repeated in each row, MP x L
+    Mat onesRow;                                // row of ones, 1 x L
+
+    Mat r;                                      // zero vector of measurement noise for getting measurementSPFuncVals
+    Mat q;                                      // zero vector of process noise for getting transitionSPFuncVals
+
+    void computeSigmaPoints();
+
+public:
+
+    UnscentedKalmanFilterBankImpl( const UnscentedKalmanFilterParams& params, const Mat& initialStates );
+
+    Mat predict( const Mat& control = Mat() );
+    Mat correct( const Mat& measurements );
+
+    int getNumberOfFilters() const;
+    Mat getErrorCov( int index ) const;
+    Mat getStates() const;
+};
+
+// Sigma points of the filters of the range
+class BankSigmaPointsInvoker : public ParallelLoopBody
+{
+public:
+    BankSigmaPointsInvoker( const Mat& _states, const Mat& _errorCovs, double _coef, Mat& _sigmaPoints )
+        : states(_states), errorCovs(_errorCovs), coef(_coef), sigmaPoints(_sigmaPoints)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        const int DP = states.rows, L = 2*DP+1;
+        Mat covMatrixL( DP, DP, states.type() );
+        for ( int i = range.start; i < range.end; i++ )
+        {
+            Mat points = sigmaPoints.colRange( i*L, (i+1)*L );
+            tracking::computeSigmaPoints( states.col(i), errorCovs.row(i).reshape(1, DP), coef, covMatrixL, points );
+        }
+    }
+
+private:
+    const Mat& states;
+    const Mat& errorCovs;
+    double coef;
+    Mat& sigmaPoints;
+
+    BankSigmaPointsInvoker& operator=(const BankSigmaPointsInvoker&); // to quiet MSVC
+};
+
+// Predicted states and covariances of the filters of the range
+class BankPredictInvoker : public ParallelLoopBody
+{
+public:
+    BankPredictInvoker( const Mat& _funcVals, const Mat& _Wm, const Mat& _WcState, const Mat& _onesRow,
+                        const Mat& _processNoiseCov, Mat& _center, Mat& _states, Mat& _errorCovs )
+        : funcVals(_funcVals), Wm(_Wm), WcState(_WcState), onesRow(_onesRow), processNoiseCov(_processNoiseCov),
+          center(_center), states(_states), errorCovs(_errorCovs)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        const int DP = states.rows, L = 2*DP+1;
+        Mat weighted( DP, L, states.type() );
+        for ( int i = range.start; i < range.end; i++ )
+        {
+            Mat state = states.col(i);
+            Mat errorCov = errorCovs.row(i).reshape(1, DP);
+            Mat fc = center.colRange( i*L, (i+1)*L );
+
+            centerSigmaPointValues( funcVals.colRange( i*L, (i+1)*L ), Wm, onesRow, state, fc );
+            weightedSigmaPointCovariance( fc, fc, WcState, processNoiseCov, weighted, errorCov );
+        }
+    }
+
+private:
+    const Mat& funcVals;
+    const Mat& Wm;
+    const Mat& WcState;
+    const Mat& onesRow;
+    const Mat& processNoiseCov;
+    Mat& center;
+    Mat& states;
+    Mat& errorCovs;
+
+    BankPredictInvoker& operator=(const BankPredictInvoker&); // to quiet MSVC
+};
+
+// Corrected states and covariances of the filters of the range
+class BankCorrectInvoker : public ParallelLoopBody
+{
+public:
+    BankCorrectInvoker( const Mat& _funcVals, const Mat& _transitionCenter, const Mat& _measurements,
+                        const Mat& _Wm, const Mat& _WcState, const Mat& _WcMeasurement, const Mat& _onesRow,
+                        const Mat& _measurementNoiseCov, Mat& _states, Mat& _errorCovs )
+        : funcVals(_funcVals), transitionCenter(_transitionCenter), measurements(_measurements),
+          Wm(_Wm), WcState(_WcState), WcMeasurement(_WcMeasurement), onesRow(_onesRow),
+          measurementNoiseCov(_measurementNoiseCov), states(_states), errorCovs(_errorCovs)
+    {
+    }
+
+    void operator()( const Range& range ) const
+    {
+        const int DP = states.rows, MP = funcVals.rows, L = 2*DP+1, type = states.type();
+        Mat measurementEstimate( MP, 1, type ), hc( MP, L, type );
+        Mat weightedState( DP, L, type ), weightedMeasurement( MP, L, type );
+        Mat yyCov, xyCov, gain;
+        for ( int i = range.start; i < range.end; i++ )
+        {
+            Mat state = states.col(i);
+            Mat errorCov = errorCovs.row(i).reshape(1, DP);
+            Mat fc = transitionCenter.colRange( i*L, (i+1)*L );
+
+            centerSigmaPointValues( funcVals.colRange( i*L, (i+1)*L ), Wm, onesRow, measurementEstimate, hc );
+            weightedSigmaPointCovariance( hc, hc, WcMeasurement, measurementNoiseCov, weightedMeasurement, yyCov );
+            weightedSigmaPointCovariance( fc, hc, WcState, Mat(), weightedState, xyCov );
+
+            gain = xyCov * yyCov.inv(DECOMP_SVD);
+            state += gain * ( measurements.col(i) - measurementEstimate );
+            errorCov -= gain * xyCov.t();
+        }
+    }
+
+private:
+    const Mat& funcVals;
+    const Mat& transitionCenter;
+    const Mat& measurements;
+    const Mat& Wm;
+    const Mat& WcState;
+    const Mat& WcMeasurement;
+    const Mat& onesRow;
+    const Mat& measurementNoiseCov;
+    Mat& states;
+    Mat& errorCovs;
+
+    BankCorrectInvoker& operator=(const BankCorrectInvoker&); // to quiet MSVC
+};
+
+UnscentedKalmanFilterBankImpl::UnscentedKalmanFilterBankImpl( const UnscentedKalmanFilterParams& params,
+                                                              const Mat& initialStates )
+{
+    CV_Assert( params.DP > 0 && params.MP > 0 );
+    CV_Assert( params.dataType == CV_32F || params.dataType == CV_64F );
+    DP = params.DP;
+    MP = params.MP;
+    CP = std::max( params.CP, 0 );
+    dataType = params.dataType;
+    L = 2*DP+1;
+
+    model = params.model;
+
+    CV_Assert( initialStates.rows == DP && initialStates.cols > 0 && initialStates.type() == dataType );
+    N = initialStates.cols;
+    states = initialStates.clone();
+
+    CV_Assert( params.errorCovInit.cols == DP && params.errorCovInit.rows == DP );
+    errorCovs = repeat( params.errorCovInit.clone().reshape(1, 1), N, 1 );
+
+    CV_Assert( params.processNoiseCov.cols == DP && params.processNoiseCov.rows == DP );
+    CV_Assert( params.measurementNoiseCov.cols == MP && params.measurementNoiseCov.rows == MP );
+    processNoiseCov = params.processNoiseCov.clone();
+    measurementNoiseCov = params.measurementNoiseCov.clone();
+
+    q = Mat::zeros( DP, 1, dataType );
+    r = Mat::zeros( MP, 1, dataType );
+
+    sigmaPoints = Mat::zeros( DP, N*L, dataType );
+    transitionSPFuncVals = Mat::zeros( DP, N*L, dataType );
+    measurementSPFuncVals = Mat::zeros( MP, N*L, dataType );
+    transitionSPFuncValsCenter = Mat::zeros( DP, N*L, dataType );
+
+    double lambda = params.alpha*params.alpha*( DP + params.k ) - DP;
+    tmpLambda = lambda + DP;
+
+    Mat WcRow;
+    computeSigmaPointWeights( DP, params.alpha, params.beta, lambda, dataType, Wm, WcRow );
+    WcState = repeat( WcRow, DP, 1 );
+    WcMeasurement = repeat( WcRow, MP, 1 );
+    onesRow = Mat::ones( 1, L, dataType );
+}
+
+void UnscentedKalmanFilterBankImpl::computeSigmaPoints()
+{
+    parallel_for_( Range( 0, N ), BankSigmaPointsInvoker( states, errorCovs, sqrt( tmpLambda ), sigmaPoints ) );
+}
+
+Mat UnscentedKalmanFilterBankImpl::predict( const Mat& control )
+{
+// get sigma points from x* and P of each filter
+    computeSigmaPoints();
+
+// the control of a filter is passed with each of its sigma points
+    Mat u = control;
+    if ( control.cols > 1 )
+    {
+        CV_Assert( control.cols == N && control.type() == dataType );
+        controls.create( control.rows, N*L, dataType );
+        for ( int i = 0; i < N; i++ )
+        {
+            Mat dst = controls.colRange( i*L, (i+1)*L );
+            repeat( control.col(i), 1, L, dst );
+        }
+        u = controls;
+    }
+
+// compute f-function values at the sigma points of all the filters at once
+// f_i = f(x_i, control, 0)
+    model->stateConversionFunctionBatch( sigmaPoints, u, q, transitionSPFuncVals );
+
+// x* = SUM( Wm[i]*f_i ), fc_i = f_i - x*, P = SUM( Wc[i]*fc_i*fc_i.t ) + Q for each filter
+    parallel_for_( Range( 0, N ), BankPredictInvoker( transitionSPFuncVals, Wm, WcState, onesRow, processNoiseCov,
+                                                      transitionSPFuncValsCenter, states, errorCovs ) );
+
+    return states.clone();
+}
+
+Mat UnscentedKalmanFilterBankImpl::correct( const Mat& measurements )
+{
+    CV_Assert( measurements.rows == MP && measurements.cols == N && measurements.type() == dataType );
+
+// get sigma points from x* and P of each filter
+    computeSigmaPoints();
+
+// compute h-function values at the sigma points of all the filters at once
+// h_i = h(x_i, 0)
+    model->measurementFunctionBatch( sigmaPoints, r, measurementSPFuncVals );
+
+// y* = SUM( Wm[i]*h_i ), K = Sxy * Syy^(-1), x* = x* + K*(y - y*), P = P - K*Sxy.t for each filter
+    parallel_for_( Range( 0, N ), BankCorrectInvoker( measurementSPFuncVals, transitionSPFuncValsCenter, measurements,
+                                                      Wm, WcState, WcMeasurement, onesRow, measurementNoiseCov,
+                                                      states, errorCovs ) );
+
+    return states.clone();
+}
+
+int UnscentedKalmanFilterBankImpl::getNumberOfFilters() const
+{
+    return N;
+}
+
+Mat UnscentedKalmanFilterBankImpl::getErrorCov( int index ) const
+{
+    CV_Assert( 0 <= index && index < N );
+    return errorCovs.row(index).reshape(1, DP).clone();
+}
+
+Mat UnscentedKalmanFilterBankImpl::getStates() const
+{
+    return states.clone();
+}
+
+Ptr<UnscentedKalmanFilterBank> createUnscentedKalmanFilterBank( const UnscentedKalmanFilterParams &params,
+                                                                const Mat& initialStates )
+{
+    Ptr<UnscentedKalmanFilterBank> kfb( new UnscentedKalmanFilterBankImpl( params, initialStates ) );
+    return kfb;
+}
+
+}
+}
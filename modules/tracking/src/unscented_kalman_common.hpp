@@ -0,0 +1,135 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#ifndef OPENCV_TRACKING_UNSCENTED_KALMAN_COMMON_HPP
+#define OPENCV_TRACKING_UNSCENTED_KALMAN_COMMON_HPP
+
+#include "precomp.hpp"
+
+namespace cv
+{
+namespace tracking
+{
+
+/* Cholesky decomposition
+ The function performs Cholesky decomposition <https://en.wikipedia.org/wiki/Cholesky_decomposition>.
+ A - the Hermitian, positive-definite matrix,
+ astep - size of row in A,
+ asize - number of cols and rows in A,
+ L - the lower triangular matrix, A = L*Lt.
+*/
+template<typename _Tp> bool
+inline choleskyDecomposition( const _Tp* A, size_t astep, const int asize, _Tp* L )
+{
+    int i, j, k;
+    double s;
+    astep /= sizeof(A[0]);
+    for( i = 0; i < asize; i++ )
+
+    {
+        for( j = 0; j < i; j++ )
+        {
+            s = A[i*astep + j];
+            for( k = 0; k < j; k++ )
+                s -= L[i*astep + k]*L[j*astep + k];
+            L[i*astep + j] = (_Tp)(s/L[j*astep + j]);
+        }
+        s = A[i*astep + i];
+        for( k = 0; k < i; k++ )
+        {
+            double t = L[i*astep + k];
+            s -= t*t;
+        }
+        if( s < std::numeric_limits<_Tp>::epsilon() )
+            return false;
+        L[i*astep + i] = (_Tp)(std::sqrt(s));
+    }
+
+   for( i = 0; i < asize; i++ )
+       for( j = i+1; j < asize; j++ )
+       {
+           L[i*astep + j] = 0.0;
+       }
+
+    return true;
+}
+
+/* Sigma points
+ The function writes the sigma points of the distribution ( mean, covMatrix ) to the preallocated points, n x 2*n+1:
+ x_0 = mean
+ x_i = mean + coef * cholesky( covMatrix ), i = 1..n
+ x_(i+n) = mean - coef * cholesky( covMatrix ), i = 1..n
+ covMatrix must be continuous, covMatrixL is a continuous work buffer of its size and type.
+*/
+inline void computeSigmaPoints( const Mat& mean, const Mat& covMatrix, double coef, Mat& covMatrixL, Mat& points )
+{
+    int n = mean.rows;
+    CV_Assert( covMatrix.isContinuous() && covMatrixL.isContinuous() && covMatrixL.size() == covMatrix.size() );
+    CV_Assert( points.rows == n && points.cols == 2*n+1 && points.type() == mean.type() );
+
+// covMatrixL = cholesky( covMatrix )
+    covMatrixL.setTo(0);
+    if ( covMatrix.depth() == CV_64F )
+        choleskyDecomposition<double>( covMatrix.ptr<double>(), covMatrix.step, covMatrix.rows, covMatrixL.ptr<double>() );
+    else
+        choleskyDecomposition<float>( covMatrix.ptr<float>(), covMatrix.step, covMatrix.rows, covMatrixL.ptr<float>() );
+
+    repeat( mean, 1, 2*n+1, points );
+
+    Mat p_plus = points( Rect( 1, 0, n, n ) );
+    Mat p_minus = points( Rect( n+1, 0, n, n ) );
+
+    scaleAdd( covMatrixL, coef, p_plus, p_plus );
+    scaleAdd( covMatrixL, -coef, p_minus, p_minus );
+}
+
+/* Weighted mean of function values at sigma points
+ mean = SUM_i( Wm[i]*vals_i ),
+ center_i = vals_i - mean,
+ onesRow - row of ones, 1 x vals.cols.
+*/
+inline void centerSigmaPointValues( const Mat& vals, const Mat& Wm, const Mat& onesRow, Mat& mean, Mat& center )
+{
+    gemm( vals, Wm, 1.0, noArray(), 0.0, mean );
+    gemm( mean, onesRow, -1.0, vals, 1.0, center );
+}
+
+/* Weighted covariance of function values at sigma points
+ cov = SUM_i( Wc[i]*a_i*b_i.t ) + noise, the diagonal of Wc is not expanded to a matrix:
+ WcRows - rows each holding the weights Wc[i], of the size of centerA,
+ weighted - work buffer of the size of centerA,
+ noise - the added covariance or an empty matrix.
+*/
+inline void weightedSigmaPointCovariance( const Mat& centerA, const Mat& centerB, const Mat& WcRows,
+                                          const Mat& noise, Mat& weighted, Mat& cov )
+{
+    multiply( centerA, WcRows, weighted );
+    if ( noise.empty() )
+        gemm( weighted, centerB, 1.0, noArray(), 0.0, cov, GEMM_2_T );
+    else
+        gemm( weighted, centerB, 1.0, noise, 1.0, cov, GEMM_2_T );
+}
+
+/* Weights of the unscented transform of an n-dimensional distribution
+ Wm - weights for estimate mean, 2*n+1 x 1,
+ WcRow - weights for estimate covariance, 1 x 2*n+1.
+*/
+inline void computeSigmaPointWeights( int n, double alpha, double beta, double lambda, int type, Mat& Wm, Mat& WcRow )
+{
+    double tmpLambda = lambda + n;
+    double tmp2Lambda = 0.5/tmpLambda;
+
+    Mat wm( 2*n+1, 1, CV_64F, Scalar( tmp2Lambda ) );
+    Mat wc( 1, 2*n+1, CV_64F, Scalar( tmp2Lambda ) );
+    wm.at<double>(0, 0) = lambda/tmpLambda;
+    wc.at<double>(0, 0) = lambda/tmpLambda + 1.0 - alpha*alpha + beta;
+
+    wm.convertTo( Wm, type );
+    wc.convertTo( WcRow, type );
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,155 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+
+// textured targets moving over a textured background
+static void renderFrame(const Mat& background, const std::vector<Mat>& targets, const std::vector<Point>& positions, Mat& frame)
+{
+  background.copyTo(frame);
+  for(size_t i = 0; i < targets.size(); i++)
+  {
+    Mat roi = frame(Rect(positions[i], targets[i].size()));
+    targets[i].copyTo(roi);
+  }
+}
+
+TEST(MultiTrackerKCF, update_opt_sameAsSequential)
+{
+  RNG rng(0);
+  Mat background(240, 320, CV_8UC3), frame;
+  rng.fill(background, RNG::UNIFORM, 0, 80);
+
+  // two targets with the same template size and a larger one tracked on the downscaled frame
+  std::vector<Mat> targets;
+  std::vector<Point> positions;
+  const Size sizes[] = { Size(30, 40), Size(30, 40), Size(100, 80) };
+  const Point starts[] = { Point(40, 40), Point(180, 50), Point(90, 120) };
+  for(int i = 0; i < 3; i++)
+  {
+    Mat target(sizes[i], CV_8UC3);
+    rng.fill(target, RNG::UNIFORM, 100, 256);
+    targets.push_back(target);
+    positions.push_back(starts[i]);
+  }
+
+  renderFrame(background, targets, positions, frame);
+
+  MultiTracker_Alt sequential;
+  MultiTrackerKCF batched;
+  for(int i = 0; i < 3; i++)
+  {
+    Rect2d bb(positions[i], sizes[i]);
+    ASSERT_TRUE(sequential.addTarget(frame, bb, "KCF"));
+    ASSERT_TRUE(batched.addTarget(frame, bb, "KCF"));
+  }
+
+  for(int t = 0; t < 10; t++)
+  {
+    for(size_t i = 0; i < positions.size(); i++)
+      positions[i] += Point(2, 1);
+    renderFrame(background, targets, positions, frame);
+
+    ASSERT_TRUE(sequential.update(frame));
+    ASSERT_TRUE(batched.update_opt(frame));
+
+    for(int i = 0; i < 3; i++)
+    {
+      EXPECT_NEAR(sequential.boundingBoxes[i].x, batched.boundingBoxes[i].x, 1e-6);
+      EXPECT_NEAR(sequential.boundingBoxes[i].y, batched.boundingBoxes[i].y, 1e-6);
+      EXPECT_NEAR(sequential.boundingBoxes[i].width, batched.boundingBoxes[i].width, 1e-6);
+      EXPECT_NEAR(sequential.boundingBoxes[i].height, batched.boundingBoxes[i].height, 1e-6);
+    }
+  }
+}
+
+TEST(MultiTrackerMedianFlow, update_opt_sameAsSequential)
+{
+  RNG rng(0);
+  Mat background(240, 320, CV_8UC3), frame;
+  rng.fill(background, RNG::UNIFORM, 0, 80);
+
+  std::vector<Mat> targets;
+  std::vector<Point> positions;
+  const Size sizes[] = { Size(40, 40), Size(50, 30), Size(60, 60) };
+  const Point starts[] = { Point(30, 40), Point(180, 50), Point(90, 130) };
+  for(int i = 0; i < 3; i++)
+  {
+    Mat target(sizes[i], CV_8UC3);
+    rng.fill(target, RNG::UNIFORM, 100, 256);
+    GaussianBlur(target, target, Size(5, 5), 0);
+    targets.push_back(target);
+    positions.push_back(starts[i]);
+  }
+
+  renderFrame(background, targets, positions, frame);
+
+  MultiTracker_Alt sequential;
+  MultiTrackerMedianFlow batched;
+  for(int i = 0; i < 3; i++)
+  {
+    Rect2d bb(positions[i], sizes[i]);
+    ASSERT_TRUE(sequential.addTarget(frame, bb, "MEDIANFLOW"));
+    ASSERT_TRUE(batched.addTarget(frame, bb, "MEDIANFLOW"));
+  }
+
+  for(int t = 0; t < 10; t++)
+  {
+    for(size_t i = 0; i < positions.size(); i++)
+      positions[i] += Point(2, 1);
+    renderFrame(background, targets, positions, frame);
+
+    bool sequentialResult = sequential.update(frame);
+    EXPECT_EQ(sequentialResult, batched.update_opt(frame));
+    if(!sequentialResult)
+      break;
+
+    for(int i = 0; i < 3; i++)
+    {
+      EXPECT_NEAR(sequential.boundingBoxes[i].x, batched.boundingBoxes[i].x, 1e-6);
+      EXPECT_NEAR(sequential.boundingBoxes[i].y, batched.boundingBoxes[i].y, 1e-6);
+      EXPECT_NEAR(sequential.boundingBoxes[i].width, batched.boundingBoxes[i].width, 1e-6);
+      EXPECT_NEAR(sequential.boundingBoxes[i].height, batched.boundingBoxes[i].height, 1e-6);
+    }
+  }
+}
@@ -0,0 +1,92 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+
+// samples are windows of one integral image, as produced by the samplers of MIL and Boosting
+static void checkHaarResponses(int depth)
+{
+  RNG rng(0);
+  Mat img(120, 160, CV_8UC1), intImage;
+  rng.fill(img, RNG::UNIFORM, 0, 256);
+  integral(img, intImage, depth);
+
+  TrackerFeatureHAAR::Params params;
+  params.numFeatures = 50;
+  params.rectSize = Size(40, 30);
+  params.isIntegral = true;
+  Ptr<TrackerFeatureHAAR> haar(new TrackerFeatureHAAR(params));
+
+  std::vector<Mat> samples;
+  for(int y = 0; y + params.rectSize.height <= img.rows; y += 17)
+    for(int x = 0; x + params.rectSize.width <= img.cols; x += 23)
+      samples.push_back(intImage(Rect(Point(x, y), params.rectSize)));
+
+  Mat response;
+  haar->compute(samples, response);
+  ASSERT_EQ(params.numFeatures, response.rows);
+  ASSERT_EQ((int)samples.size(), response.cols);
+
+  std::vector<int> selected;
+  selected.push_back(3);
+  selected.push_back(11);
+  selected.push_back(7);
+  Mat selResponse;
+  haar->extractSelected(selected, samples, selResponse);
+
+  for(int j = 0; j < params.numFeatures; j++)
+  {
+    bool isSelected = std::find(selected.begin(), selected.end(), j) != selected.end();
+    for(size_t i = 0; i < samples.size(); i++)
+    {
+      float expected = 0;
+      haar->getFeatureAt(j).eval(samples[i], Rect(0, 0, samples[i].cols, samples[i].rows), &expected);
+      EXPECT_EQ(expected, response.at<float>(j, (int)i));
+      EXPECT_EQ(isSelected ? expected : 0.f, selResponse.at<float>(j, (int)i));
+    }
+  }
+}
+
+TEST(TrackerFeatureHAAR, compute_integralFloat) { checkHaarResponses(CV_32F); }
+TEST(TrackerFeatureHAAR, compute_integralInt) { checkHaarResponses(CV_32S); }
@@ -0,0 +1,89 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+ //
+ //  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+ //
+ //  By downloading, copying, installing or using the software you agree to this license.
+ //  If you do not agree to this license, do not download, install,
+ //  copy or use the software.
+ //
+ //
+ //                           License Agreement
+ //                For Open Source Computer Vision Library
+ //
+ // Copyright (C) 2013, OpenCV Foundation, all rights reserved.
+ // Third party copyrights are property of their respective owners.
+ //
+ // Redistribution and use in source and binary forms, with or without modification,
+ // are permitted provided that the following conditions are met:
+ //
+ //   * Redistribution's of source code must retain the above copyright notice,
+ //     this list of conditions and the following disclaimer.
+ //
+ //   * Redistribution's in binary form must reproduce the above copyright notice,
+ //     this list of conditions and the following disclaimer in the documentation
+ //     and/or other materials provided with the distribution.
+ //
+ //   * The name of the copyright holders may not be used to endorse or promote products
+ //     derived from this software without specific prior written permission.
+ //
+ // This software is provided by the copyright holders and contributors "as is" and
+ // any express or implied warranties, including, but not limited to, the implied
+ // warranties of merchantability and fitness for a particular purpose are disclaimed.
+ // In no event shall the Intel Corporation or contributors be liable for any direct,
+ // indirect, incidental, special, exemplary, or consequential damages
+ // (including, but not limited to, procurement of substitute goods or services;
+ // loss of use, data, or profits; or business interruption) however caused
+ // and on any theory of liability, whether in contract, strict liability,
+ // or tort (including negligence or otherwise) arising in any way out of
+ // the use of this software, even if advised of the possibility of such damage.
+ //
+ //M*/
+
+
+#include "test_precomp.hpp"
+
+using namespace cv;
+
+// a textured target growing by 1% per frame in the middle of a flat frame
+static void renderScaledTarget(const Mat& texture, double scale, Mat& frame)
+{
+  frame.create(240, 320, CV_8UC3);
+  frame.setTo(Scalar::all(128));
+  Size size(cvRound(40 * scale), cvRound(40 * scale));
+  Mat target;
+  resize(texture, target, size, 0, 0, INTER_AREA);
+  target.copyTo(frame(Rect(Point(160 - size.width / 2, 120 - size.height / 2), size)));
+}
+
+TEST(TrackerKCF, scale_adaptive)
+{
+  RNG rng(0);
+  Mat texture(160, 160, CV_8UC3);
+  rng.fill(texture, RNG::UNIFORM, 0, 256);
+  GaussianBlur(texture, texture, Size(0, 0), 4.0);
+  normalize(texture, texture, 0, 255, NORM_MINMAX);
+
+  TrackerKCF::Params params;
+  params.scale_adaptive = true;
+  Ptr<TrackerKCF> tracker = TrackerKCF::createTracker(params);
+
+  Mat frame;
+  renderScaledTarget(texture, 1.0, frame);
+  Rect2d box(140, 100, 40, 40);
+  ASSERT_TRUE(tracker->init(frame, box));
+
+  double scale = 1.0;
+  for(int i = 0; i < 40; i++)
+  {
+    renderScaledTarget(texture, scale, frame);
+    ASSERT_TRUE(tracker->update(frame, box));
+    scale *= 1.01;
+  }
+
+  // the true scale is about 1.48
+  double estimated = box.width / 40.0;
+  EXPECT_GT(estimated, 1.2);
+  EXPECT_LT(estimated, 1.8);
+  EXPECT_NEAR(160.0, box.x + box.width / 2, 5.0);
+  EXPECT_NEAR(120.0, box.y + box.height / 2, 5.0);
+}
@@ -432,3 +432,85 @@ TEST(UKF, ungm_mean_squared_error)
 
     ASSERT_GE( mse_treshold, average_error );
 }
+
+TEST(UKF, bank_same_as_filters)
+{
+    const int nFilters = 4;
+    const int nIterations = 50;
+
+    int MP = 2;
+    int DP = 5;
+    int CP = 0;
+    int type = CV_64F;
+
+    Mat processNoiseCov = Mat::zeros( DP, DP, type );
+    processNoiseCov.at<double>(0, 0) = 1e-14;
+    processNoiseCov.at<double>(1, 1) = 1e-14;
+    processNoiseCov.at<double>(2, 2) = 2.4065 * 1e-5;
+    processNoiseCov.at<double>(3, 3) = 2.4065 * 1e-5;
+    processNoiseCov.at<double>(4, 4) = 1e-6;
+
+    Mat measurementNoiseCov = Mat::zeros( MP, MP, type );
+    measurementNoiseCov.at<double>(0, 0) = 1e-3*1e-3;
+    measurementNoiseCov.at<double>(1, 1) = 0.13*0.13;
+
+    Mat P = 1e-6 * Mat::eye( DP, DP, type );
+    P.at<double>(4, 4) = 1.0;
+
+    Ptr<BallisticModel> model( new BallisticModel() );
+    UnscentedKalmanFilterParams params( DP, MP, CP, 0, 0, model );
+    params.errorCovInit = P.clone();
+    params.measurementNoiseCov = measurementNoiseCov.clone();
+    params.processNoiseCov = processNoiseCov.clone();
+    params.alpha = 1;
+    params.beta = 2.0;
+    params.k = -2.0;
+
+    RNG rng( 117 );
+
+    Mat initStates( DP, nFilters, type ), states( DP, nFilters, type );
+    std::vector<Ptr<UnscentedKalmanFilter> > filters;
+    for (int j = 0; j<nFilters; j++)
+    {
+        Mat state = states.col(j);
+        state.at<double>(0, 0) = 6500.4 + rng.uniform(-10., 10.);
+        state.at<double>(1, 0) = 349.14 + rng.uniform(-10., 10.);
+        state.at<double>(2, 0) = -1.8093;
+        state.at<double>(3, 0) = -6.7967;
+        state.at<double>(4, 0) = 0.6932;
+
+        state.copyTo( initStates.col(j) );
+        initStates.at<double>(4, j) = 0.0;
+
+        params.stateInit = initStates.col(j).clone();
+        filters.push_back( createUnscentedKalmanFilter( params ) );
+    }
+    Ptr<UnscentedKalmanFilterBank> bank = createUnscentedKalmanFilterBank( params, initStates );
+    ASSERT_EQ( nFilters, bank->getNumberOfFilters() );
+
+    Mat u = Mat::zeros( DP, nFilters, type );
+    Mat zero = Mat::zeros( MP, 1, type );
+    Mat measurements( MP, nFilters, type );
+
+    for (int i = 0; i<nIterations; i++)
+    {
+        for (int j = 0; j<nFilters; j++)
+        {
+            Mat state = states.col(j), measurement = measurements.col(j);
+            model->stateConversionFunction( state.clone(), u.col(j), Mat::zeros( DP, 1, type ), state );
+            model->measurementFunction( state, zero, measurement );
+        }
+
+        Mat predicted = bank->predict( u );
+        Mat corrected = bank->correct( measurements );
+        for (int j = 0; j<nFilters; j++)
+        {
+            Mat expectedPredicted = filters[j]->predict( u.col(j) );
+            Mat expectedCorrected = filters[j]->correct( measurements.col(j) );
+
+            ASSERT_LE( cv::norm( predicted.col(j), expectedPredicted, NORM_INF | NORM_RELATIVE ), 1e-9 ) << "filter " << j;
+            ASSERT_LE( cv::norm( corrected.col(j), expectedCorrected, NORM_INF | NORM_RELATIVE ), 1e-9 ) << "filter " << j;
+            ASSERT_LE( cv::norm( bank->getErrorCov(j), filters[j]->getErrorCov(), NORM_INF | NORM_RELATIVE ), 1e-9 ) << "filter " << j;
+        }
+    }
+}
@@ -222,6 +222,42 @@ public:
      */
     virtual void compute( InputArray image, OutputArray descriptors ) = 0;
 
+    /** @brief Receives the dense descriptors of a band of rows, see computeDense.
+     */
+    class CV_EXPORTS DenseCallback
+    {
+    public:
+        virtual ~DenseCallback() {}
+
+        /**
+         * @param band image pixels of the band
+         * @param descriptors band.width*band.height descriptors, in the row-major order of the pixels;
+         * the buffer is reused for the next band
+         */
+        virtual void operator()( const Rect& band, const Mat& descriptors ) = 0;
+    };
+
+    /** @brief Computes the dense descriptors of the roi band by band.
+
+    The smoothed gradient layers are only computed for a band of rows and the margin its descriptors
+    need, so that the memory they take is bounded by the size of the band rather than of the image.
+    The descriptors are the same as the ones of compute( image, roi, descriptors ), up to rounding.
+     * @param image image to extract descriptors
+     * @param roi region of interest within image
+     * @param descriptors resulted descriptors array for roi image pixels
+     * @param band_rows number of roi rows computed at once
+     */
+    virtual void computeDense( InputArray image, Rect roi, OutputArray descriptors, int band_rows = 64 ) = 0;
+
+    /** @overload
+     * @param image image to extract descriptors
+     * @param roi region of interest within image
+     * @param callback receives the descriptors of each band, top to bottom, so that they don't need
+     * to be all kept in memory
+     * @param band_rows number of roi rows computed at once
+     */
+    virtual void computeDense( InputArray image, Rect roi, DenseCallback& callback, int band_rows = 64 ) = 0;
+
     /**
      * @param y position y on image
      * @param x position x on image
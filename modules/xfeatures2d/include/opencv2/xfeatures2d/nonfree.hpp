@@ -79,6 +79,22 @@ public:
     CV_WRAP static Ptr<SIFT> create( int nfeatures = 0, int nOctaveLayers = 3,
                                     double contrastThreshold = 0.04, double edgeThreshold = 10,
                                     double sigma = 1.6);
+
+    /** @brief Builds the Gaussian and DoG pyramids in 16-bit fixed point instead of floating point.
+
+    The fixed-point pyramids are faster to build and to scan, at the price of a coarser quantization
+    of the scale space. It is off by default.
+     */
+    CV_WRAP virtual void setFixedPointPyramid(bool fixedPointPyramid) = 0;
+    CV_WRAP virtual bool getFixedPointPyramid() const = 0;
+
+    /** @brief Doubles the size of the input image to build the first octave (the octave -1).
+
+    It is on by default, as in D. Lowe paper. Turning it off makes the detection about 4 times cheaper,
+    but finds fewer keypoints at the finest scales. It doesn't apply when the keypoints are provided.
+     */
+    CV_WRAP virtual void setUpsampleInput(bool upsampleInput) = 0;
+    CV_WRAP virtual bool getUpsampleInput() const = 0;
 };
 
 typedef SIFT SiftFeatureDetector;
@@ -143,6 +159,41 @@ public:
 
     CV_WRAP virtual void setUpright(bool upright) = 0;
     CV_WRAP virtual bool getUpright() const = 0;
+
+    //! rows of the keypoints kept in a UMat, one column per keypoint
+    enum KeypointLayout
+    {
+        X_ROW = 0,
+        Y_ROW,
+        LAPLACIAN_ROW,
+        OCTAVE_ROW,
+        SIZE_ROW,
+        ANGLE_ROW,
+        HESSIAN_ROW,
+        ROWS_COUNT
+    };
+
+    /** @brief Detects keypoints and computes their descriptors, keeping the keypoints on the device.
+
+    The keypoints are stored in a CV_32FC1 UMat of ROWS_COUNT rows and one column per keypoint, as
+    laid out by KeypointLayout, the laplacian and octave rows holding ints. With OpenCL, they are
+    neither downloaded between the detection and the description nor after it; otherwise they are
+    computed on the CPU and stored the same way. Passing a UMat as descriptors keeps them on the
+    device too, e.g. for BFMatcher::match, which runs on the device for UMat descriptors.
+    @param image Input 8-bit image.
+    @param mask Optional input mask.
+    @param keypoints The keypoints, that are input if useProvidedKeypoints is true.
+    @param descriptors Output descriptors, not computed when not needed.
+    @param useProvidedKeypoints Only computes the descriptors of the given keypoints.
+     */
+    virtual void detectAndCompute(InputArray image, InputArray mask, UMat& keypoints,
+                                  OutputArray descriptors, bool useProvidedKeypoints = false) = 0;
+    using Feature2D::detectAndCompute;
+
+    //! stores the keypoints in the KeypointLayout rows of a UMat
+    static void uploadKeypoints(const std::vector<KeyPoint>& keypoints, UMat& keypointsGPU);
+    //! reads the keypoints back from the KeypointLayout rows of a UMat
+    static void downloadKeypoints(const UMat& keypointsGPU, std::vector<KeyPoint>& keypoints);
 };
 
 typedef SURF SurfFeatureDetector;
@@ -0,0 +1,114 @@
+#include "perf_precomp.hpp"
+#include "opencv2/imgproc.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace cv::xfeatures2d;
+using namespace perf;
+using std::tr1::make_tuple;
+using std::tr1::get;
+
+// Every Feature2D of the module on the same frames, from VGA to 4K.
+// The number of processed keypoints is recorded with each test, the throughput in keypoints
+// per second is that number over the reported time.
+
+#define FEATURE2D_IMAGE "cv/detectors_descriptors_evaluation/images_datasets/leuven/img1.png"
+
+#define FEATURE2D_SIZES szVGA, sz720p, sz1080p, Size(3840, 2160)
+
+#define FEATURE2D_DETECTORS "SIFT", "SURF", "Star", "MSD"
+
+#define FEATURE2D_DESCRIPTORS "SIFT", "SURF", "FREAK", "BRIEF", "LUCID", "LATCH", "DAISY"
+
+#define FEATURE2D_KEYPOINT_BUDGETS 500, 2000
+
+typedef std::tr1::tuple<string, Size> Feature2D_Detect_t;
+typedef perf::TestBaseWithParam<Feature2D_Detect_t> feature2d_detect;
+
+typedef std::tr1::tuple<string, Size, int> Feature2D_Compute_t;
+typedef perf::TestBaseWithParam<Feature2D_Compute_t> feature2d_compute;
+
+static Ptr<Feature2D> createFeature2D(const string& name)
+{
+    if (name == "SIFT")
+        return SIFT::create();
+    if (name == "SURF")
+        return SURF::create();
+    if (name == "Star")
+        return StarDetector::create();
+    if (name == "MSD")
+        return MSDDetector::create();
+    if (name == "FREAK")
+        return FREAK::create();
+    if (name == "BRIEF")
+        return BriefDescriptorExtractor::create();
+    if (name == "LUCID")
+        return LUCID::create(1, 2);
+    if (name == "LATCH")
+        return LATCH::create();
+    if (name == "DAISY")
+        return DAISY::create();
+    CV_Error(Error::StsBadArg, "Unknown Feature2D " + name);
+    return Ptr<Feature2D>();
+}
+
+// The test frame resized to the requested resolution, in color for LUCID and in grayscale otherwise
+static Mat loadFrame(const string& name, Size size)
+{
+    string filename = getDataPath(FEATURE2D_IMAGE);
+    Mat frame = imread(filename, name == "LUCID" ? IMREAD_COLOR : IMREAD_GRAYSCALE);
+    if (frame.empty())
+        return frame;
+    resize(frame, frame, size, 0, 0, INTER_LINEAR);
+    return frame;
+}
+
+PERF_TEST_P(feature2d_detect, detect, testing::Combine(
+    testing::Values(FEATURE2D_DETECTORS),
+    testing::Values(FEATURE2D_SIZES)))
+{
+    string name = get<0>(GetParam());
+    Size size = get<1>(GetParam());
+    Mat frame = loadFrame(name, size);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << FEATURE2D_IMAGE;
+
+    declare.in(frame).time(name == "MSD" ? 600 : 90);
+    Ptr<Feature2D> detector = createFeature2D(name);
+    vector<KeyPoint> points;
+
+    TEST_CYCLE() detector->detect(frame, points);
+
+    RecordProperty("keypoints", (int)points.size());
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(feature2d_compute, compute, testing::Combine(
+    testing::Values(FEATURE2D_DESCRIPTORS),
+    testing::Values(FEATURE2D_SIZES),
+    testing::Values(FEATURE2D_KEYPOINT_BUDGETS)))
+{
+    string name = get<0>(GetParam());
+    Size size = get<1>(GetParam());
+    int budget = get<2>(GetParam());
+    Mat frame = loadFrame(name, size);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << FEATURE2D_IMAGE;
+
+    // The same keypoints for every descriptor: the strongest FAST corners of the frame
+    vector<KeyPoint> detected;
+    FastFeatureDetector::create()->detect(frame, detected);
+    KeyPointsFilter::retainBest(detected, budget);
+
+    declare.in(frame).time(90);
+    Ptr<Feature2D> extractor = createFeature2D(name);
+    vector<KeyPoint> points;
+    Mat descriptors;
+
+    TEST_CYCLE()
+    {
+        points = detected;
+        extractor->compute(frame, points, descriptors);
+    }
+
+    RecordProperty("keypoints", (int)points.size());
+    SANITY_CHECK_NOTHING();
+}
@@ -52,6 +52,9 @@ namespace cv
 namespace xfeatures2d
 {
 
+// computes the descriptors of a range of keypoints
+typedef void(*PixelTestFn)(const Mat&, const std::vector<KeyPoint>&, Mat&, bool use_orientation, const Range& );
+
 /*
  * BRIEF Descriptor
  */
@@ -73,8 +76,6 @@ public:
     virtual void compute(InputArray image, std::vector<KeyPoint>& keypoints, OutputArray descriptors);
 
 protected:
-    typedef void(*PixelTestFn)(InputArray, const std::vector<KeyPoint>&, OutputArray, bool use_orientation );
-
     int bytes_;
     bool use_orientation_;
     PixelTestFn test_fn_;
@@ -105,13 +106,12 @@ inline int smoothedSum(const Mat& sum, const KeyPoint& pt, int y, int x, bool us
            + sum.at<int>(img_y - HALF_KERNEL, img_x - HALF_KERNEL);
 }
 
-static void pixelTests16(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation )
+static void pixelTests16(const Mat& sum, const std::vector<KeyPoint>& keypoints, Mat& descriptors, bool use_orientation, const Range& range)
 {
     Matx21f R;
-    Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    for (int i = range.start; i < range.end; ++i)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
+        uchar* desc = descriptors.ptr(i);
         const KeyPoint& pt = keypoints[i];
         if ( use_orientation )
         {
@@ -125,13 +125,12 @@ static void pixelTests16(InputArray _sum, const std::vector<KeyPoint>& keypoints
     }
 }
 
-static void pixelTests32(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation)
+static void pixelTests32(const Mat& sum, const std::vector<KeyPoint>& keypoints, Mat& descriptors, bool use_orientation, const Range& range)
 {
     Matx21f R;
-    Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    for (int i = range.start; i < range.end; ++i)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
+        uchar* desc = descriptors.ptr(i);
         const KeyPoint& pt = keypoints[i];
         if ( use_orientation )
         {
@@ -145,13 +144,12 @@ static void pixelTests32(InputArray _sum, const std::vector<KeyPoint>& keypoints
     }
 }
 
-static void pixelTests64(InputArray _sum, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, bool use_orientation)
+static void pixelTests64(const Mat& sum, const std::vector<KeyPoint>& keypoints, Mat& descriptors, bool use_orientation, const Range& range)
 {
     Matx21f R;
-    Mat sum = _sum.getMat(), descriptors = _descriptors.getMat();
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    for (int i = range.start; i < range.end; ++i)
     {
-        uchar* desc = descriptors.ptr(static_cast<int>(i));
+        uchar* desc = descriptors.ptr(i);
         const KeyPoint& pt = keypoints[i];
         if ( use_orientation )
         {
@@ -165,6 +163,30 @@ static void pixelTests64(InputArray _sum, const std::vector<KeyPoint>& keypoints
     }
 }
 
+// runs the pixel tests of a range of keypoints, each of them writing its own descriptor row
+class BriefPixelTestsInvoker : public ParallelLoopBody
+{
+public:
+    BriefPixelTestsInvoker(PixelTestFn _test_fn, const Mat& _sum, const std::vector<KeyPoint>& _keypoints,
+                      Mat& _descriptors, bool _use_orientation)
+        : test_fn(_test_fn), sum(_sum), keypoints(_keypoints), descriptors(_descriptors),
+          use_orientation(_use_orientation) {}
+
+    void operator()(const Range& range) const
+    {
+        test_fn(sum, keypoints, descriptors, use_orientation, range);
+    }
+
+private:
+    PixelTestFn test_fn;
+    const Mat& sum;
+    const std::vector<KeyPoint>& keypoints;
+    Mat& descriptors;
+    bool use_orientation;
+
+    BriefPixelTestsInvoker& operator=(const BriefPixelTestsInvoker&); // to quiet MSVC
+};
+
 BriefDescriptorExtractorImpl::BriefDescriptorExtractorImpl(int bytes, bool use_orientation) :
     bytes_(bytes), test_fn_(NULL)
 {
@@ -248,7 +270,10 @@ void BriefDescriptorExtractorImpl::compute(InputArray image,
 
     descriptors.create((int)keypoints.size(), bytes_, CV_8U);
     descriptors.setTo(Scalar::all(0));
-    test_fn_(sum, keypoints, descriptors, use_orientation_);
+    Mat desc = descriptors.getMat();
+    parallel_for_(Range(0, (int)keypoints.size()),
+                  BriefPixelTestsInvoker(test_fn_, sum, keypoints, desc, use_orientation_),
+                  keypoints.size()/256.);
 }
 
 }
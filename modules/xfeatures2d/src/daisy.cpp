@@ -135,6 +135,22 @@ public:
      */
     virtual void compute( InputArray image, OutputArray descriptors );
 
+    /** @overload
+     * @param image image to extract descriptors
+     * @param roi region of interest within image
+     * @param descriptors resulted descriptors array
+     * @param band_rows number of roi rows computed at once
+     */
+    virtual void computeDense( InputArray image, Rect roi, OutputArray descriptors, int band_rows );
+
+    /** @overload
+     * @param image image to extract descriptors
+     * @param roi region of interest within image
+     * @param callback receives the descriptors of each band
+     * @param band_rows number of roi rows computed at once
+     */
+    virtual void computeDense( InputArray image, Rect roi, DenseCallback& callback, int band_rows );
+
     /**
      * @param y position y on image
      * @param x position x on image
@@ -320,6 +336,14 @@ private:
     // applies one of the normalizations (partial,full,sift) to the desciptors.
     inline void normalize_descriptors( Mat* m_dense_descriptors );
 
+    // number of rows around a band that its descriptors depend on; the layers
+    // of these rows are the same as the ones computed for the whole image.
+    inline int band_margin() const;
+
+    // computes the dense descriptors of the roi band by band, into descriptors
+    // when given, else into a band buffer that is handed to the callback.
+    void compute_dense_bands( Rect roi, int band_rows, Mat* descriptors, DenseCallback* callback );
+
     inline void update_selected_cubes();
 
 }; // END DAISY_Impl CLASS
@@ -993,6 +1017,7 @@ struct ComputeDescriptorsInvoker : ParallelLoopBody
     {
       x_off = _roi->x;
       x_end = _roi->x + _roi->width;
+      y_off = _roi->y;
       image = _image;
       layers = _layers;
       th_q_no = _th_q_no;
@@ -1010,7 +1035,7 @@ struct ComputeDescriptorsInvoker : ParallelLoopBody
       {
         for( int x = x_off; x < x_end; x++ )
         {
-          index = y*image->cols + x;
+          index = (y - y_off)*(x_end - x_off) + (x - x_off);
           orientation = 0;
           if( !orientation_map->empty() )
               orientation = (int) orientation_map->at<ushort>( y, x );
@@ -1024,7 +1049,7 @@ struct ComputeDescriptorsInvoker : ParallelLoopBody
     }
 
     int th_q_no;
-    int x_off, x_end;
+    int x_off, x_end, y_off;
     std::vector<Mat>* layers;
     Mat *descriptors;
     Mat *orientation_map;
@@ -1090,6 +1115,61 @@ inline void DAISY_Impl::normalize_descriptors( Mat* m_dense_descriptors )
     );
 }
 
+inline int DAISY_Impl::band_margin() const
+{
+    // layered_gradient: 5x5 gaussian and 3-taps sobel
+    int margin = 2 + 1;
+    // smooth_layers up to the initial sigma
+    margin += filter_size( sqrt(g_sigma_init*g_sigma_init-0.25f), 5.0f ) / 2;
+    // incremental smoothing of compute_smoothed_gradient_layers
+    for( int r=0; r<m_rad_q_no; r++ )
+    {
+      double sigma = m_cube_sigmas.at<double>(r);
+      if( r > 0 )
+        sigma = sqrt( sigma * sigma - m_cube_sigmas.at<double>(r-1) * m_cube_sigmas.at<double>(r-1) );
+      margin += filter_size( sigma, 5.0f ) / 2;
+    }
+    // grid radius, with the rounding and the bilinear interpolation of the samples
+    return margin + cvCeil( m_rad ) + 2;
+}
+
+void DAISY_Impl::compute_dense_bands( Rect roi, int band_rows, Mat* descriptors, DenseCallback* callback )
+{
+    CV_Assert( band_rows > 0 );
+    CV_Assert( 0 <= roi.x && 0 <= roi.width && roi.x + roi.width <= m_image.cols &&
+               0 <= roi.y && 0 <= roi.height && roi.y + roi.height <= m_image.rows );
+
+    const int margin = band_margin();
+    Mat image = m_image, band_descriptors;
+
+    for( int y0 = roi.y; y0 < roi.y + roi.height; y0 += band_rows )
+    {
+      const int y1 = std::min( y0 + band_rows, roi.y + roi.height );
+      const int top = std::max( y0 - margin, 0 );
+      const int bottom = std::min( y1 + margin, image.rows );
+
+      // the layers are computed for the rows of the band and its margin only
+      reset();
+      m_image = image.rowRange( top, bottom );
+      m_roi = Rect( roi.x, y0 - top, roi.width, y1 - y0 );
+      initialize_single_descriptor_mode();
+
+      if( descriptors )
+        band_descriptors = descriptors->rowRange( (y0 - roi.y)*roi.width, (y1 - roi.y)*roi.width );
+      else
+        band_descriptors.create( (y1 - y0)*roi.width, m_descriptor_size, CV_32F );
+      compute_descriptors( &band_descriptors );
+      normalize_descriptors( &band_descriptors );
+
+      if( callback )
+        (*callback)( Rect( roi.x, y0, roi.width, y1 - y0 ), band_descriptors );
+    }
+
+    reset();
+    m_image = image;
+    m_roi = roi;
+}
+
 inline void DAISY_Impl::initialize()
 {
     // no image ?
@@ -1588,6 +1668,40 @@ void DAISY_Impl::compute( InputArray _image, OutputArray _descriptors )
     normalize_descriptors( &descriptors );
 }
 
+// full scope with roi, band by band
+void DAISY_Impl::computeDense( InputArray _image, Rect roi, OutputArray _descriptors, int band_rows )
+{
+    // do nothing if no image
+    if( _image.getMat().empty() )
+      return;
+
+    CV_Assert( m_h_matrix.empty() );
+    CV_Assert( ! m_use_orientation );
+
+    set_image( _image );
+    set_parameters();
+
+    _descriptors.create( roi.width*roi.height, m_descriptor_size, CV_32F );
+    Mat descriptors = _descriptors.getMat();
+    compute_dense_bands( roi, band_rows, &descriptors, NULL );
+}
+
+// full scope with roi, band by band into a callback
+void DAISY_Impl::computeDense( InputArray _image, Rect roi, DenseCallback& callback, int band_rows )
+{
+    // do nothing if no image
+    if( _image.getMat().empty() )
+      return;
+
+    CV_Assert( m_h_matrix.empty() );
+    CV_Assert( ! m_use_orientation );
+
+    set_image( _image );
+    set_parameters();
+
+    compute_dense_bands( roi, band_rows, NULL, &callback );
+}
+
 // constructor
 DAISY_Impl::DAISY_Impl( float _radius, int _q_radius, int _q_theta, int _q_hist,
              int _norm, InputArray _H, bool _interpolation, bool _use_orientation )
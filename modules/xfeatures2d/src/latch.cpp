@@ -44,6 +44,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <algorithm>
 #include <vector>
 
@@ -55,6 +56,9 @@ namespace cv
     namespace xfeatures2d
     {
 
+        // computes the descriptors of a range of keypoints
+        typedef void(*PixelTestFn)(const Mat& input_image, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range);
+
         /*
         * LATCH Descriptor
         */
@@ -75,7 +79,6 @@ namespace cv
             virtual void compute(InputArray image, std::vector<KeyPoint>& keypoints, OutputArray descriptors);
 
         protected:
-            typedef void(*PixelTestFn)(const Mat& input_image, const std::vector<KeyPoint>& keypoints, OutputArray, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size);
             void setSamplingPoints();
             int bytes_;
             PixelTestFn test_fn_;
@@ -93,10 +96,9 @@ namespace cv
         void CalcuateSums(int count, const std::vector<int> &points, bool rotationInvariance, const Mat &grayImage, const KeyPoint &pt, int &suma, int &sumc, float cos_theta, float sin_theta, int half_ssd_size);
 
 
-        static void pixelTests1(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests1(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -124,10 +126,9 @@ namespace cv
         }
 
 
-        static void pixelTests2(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests2(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -155,10 +156,9 @@ namespace cv
         }
 
 
-        static void pixelTests4(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests4(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -187,10 +187,9 @@ namespace cv
 
 
 
-        static void pixelTests8(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests8(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -218,10 +217,9 @@ namespace cv
         }
 
 
-        static void pixelTests16(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests16(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -249,10 +247,9 @@ namespace cv
         }
 
 
-        static void pixelTests32(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests32(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -279,10 +276,9 @@ namespace cv
         }
 
 
-        static void pixelTests64(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, OutputArray _descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size)
+        static void pixelTests64(const Mat& grayImage, const std::vector<KeyPoint>& keypoints, Mat& descriptors, const std::vector<int> &points, bool rotationInvariance, int half_ssd_size, const Range& range)
         {
-            Mat descriptors = _descriptors.getMat();
-            for (int i = 0; i < (int)keypoints.size(); ++i)
+            for (int i = range.start; i < range.end; ++i)
             {
                 uchar* desc = descriptors.ptr(i);
                 const KeyPoint& pt = keypoints[i];
@@ -385,17 +381,32 @@ namespace cv
             int K = half_ssd_size;
             for (int iy = -K; iy <= K; iy++)
             {
-                const uchar * Mi_a = grayImage.ptr<uchar>(ay2 + iy);
-                const uchar * Mi_b = grayImage.ptr<uchar>(by2 + iy);
-                const uchar * Mi_c = grayImage.ptr<uchar>(cy2 + iy);
-
-                for (int ix = -K; ix <= K; ix++)
+                const uchar * Mi_a = grayImage.ptr<uchar>(ay2 + iy) + ax2;
+                const uchar * Mi_b = grayImage.ptr<uchar>(by2 + iy) + bx2;
+                const uchar * Mi_c = grayImage.ptr<uchar>(cy2 + iy) + cx2;
+
+                int ix = -K;
+#if CV_SIMD128
+                // 8 pixels of both squared differences at a time
+                v_int32x4 v_suma = v_setzero_s32(), v_sumc = v_setzero_s32();
+                for (; ix + 8 <= K + 1; ix += 8)
+                {
+                    v_int16x8 b = v_reinterpret_as_s16(v_load_expand(Mi_b + ix));
+                    v_int16x8 difa = v_reinterpret_as_s16(v_load_expand(Mi_a + ix)) - b;
+                    v_int16x8 difc = v_reinterpret_as_s16(v_load_expand(Mi_c + ix)) - b;
+                    v_suma += v_dotprod(difa, difa);
+                    v_sumc += v_dotprod(difc, difc);
+                }
+                suma += v_reduce_sum(v_suma);
+                sumc += v_reduce_sum(v_sumc);
+#endif
+                for (; ix <= K; ix++)
                 {
-                    double difa = Mi_a[ax2 + ix] - Mi_b[bx2 + ix];
-                    suma += (int)((difa)*(difa));
+                    int difa = Mi_a[ix] - Mi_b[ix];
+                    suma += difa*difa;
 
-                    double difc = Mi_c[cx2 + ix] - Mi_b[bx2 + ix];
-                    sumc += (int)((difc)*(difc));
+                    int difc = Mi_c[ix] - Mi_b[ix];
+                    sumc += difc*difc;
                 }
             }
 
@@ -403,6 +414,32 @@ namespace cv
 
 
 
+        // runs the pixel tests of a range of keypoints, each of them writing its own descriptor row
+        class LATCHPixelTestsInvoker : public ParallelLoopBody
+        {
+        public:
+            LATCHPixelTestsInvoker(PixelTestFn _test_fn, const Mat& _grayImage, const std::vector<KeyPoint>& _keypoints,
+                              Mat& _descriptors, const std::vector<int>& _points, bool _rotationInvariance, int _half_ssd_size)
+                : test_fn(_test_fn), grayImage(_grayImage), keypoints(_keypoints), descriptors(_descriptors),
+                  points(_points), rotationInvariance(_rotationInvariance), half_ssd_size(_half_ssd_size) {}
+
+            void operator()(const Range& range) const
+            {
+                test_fn(grayImage, keypoints, descriptors, points, rotationInvariance, half_ssd_size, range);
+            }
+
+        private:
+            PixelTestFn test_fn;
+            const Mat& grayImage;
+            const std::vector<KeyPoint>& keypoints;
+            Mat& descriptors;
+            const std::vector<int>& points;
+            bool rotationInvariance;
+            int half_ssd_size;
+
+            LATCHPixelTestsInvoker& operator=(const LATCHPixelTestsInvoker&); // to quiet MSVC
+        };
+
         LATCHDescriptorExtractorImpl::LATCHDescriptorExtractorImpl(int bytes, bool rotationInvariance, int half_ssd_size) :
             bytes_(bytes), test_fn_(NULL), rotationInvariance_(rotationInvariance), half_ssd_size_(half_ssd_size)
         {
@@ -531,7 +568,10 @@ namespace cv
             //Mat descriptors = _descriptors.getMat();
 
 
-            test_fn_(grayImage, keypoints, descriptors, sampling_points_, rotationInvariance_, half_ssd_size_);
+            parallel_for_(Range(0, (int)keypoints.size()),
+                          LATCHPixelTestsInvoker(test_fn_, grayImage, keypoints, descriptors, sampling_points_,
+                                                 rotationInvariance_, half_ssd_size_),
+                          keypoints.size()/256.);
         }
 
 
@@ -47,6 +47,7 @@ the use of this software, even if advised of the possibility of such damage.
 */
 
 #include "precomp.hpp"
+#include <algorithm>
 
 namespace cv {
     namespace xfeatures2d {
@@ -97,44 +98,66 @@ namespace cv {
             return NORM_HAMMING;
         }
 
+        // gathers the wrapped-around patch of a range of keypoints and sorts it, one descriptor row each
+        class LUCIDInvoker : public ParallelLoopBody {
+            public:
+                LUCIDInvoker(const Mat_<Vec3b> &_src, const std::vector<KeyPoint> &_keypoints, int _l_kernel, Mat &_desc)
+                    : src(_src), keypoints(_keypoints), l_kernel(_l_kernel), desc(_desc) {}
+
+                void operator()(const Range &range) const {
+                    const int width = src.cols, height = src.rows;
+
+                    for (int i = range.start; i < range.end; ++i) {
+                        int x = static_cast<int>(keypoints[i].pt.x)-l_kernel, y = static_cast<int>(keypoints[i].pt.y)-l_kernel, d = x+2*l_kernel, p = y+2*l_kernel, j = x, c = 0;
+                        uchar *row = desc.ptr<uchar>(i);
+
+                        while (x <= d) {
+                            const Vec3b &pix = src((y < 0 ? height+y : y >= height ? y-height : y), (x < 0 ? width+x : x >= width ? x-width : x));
+
+                            row[c++] = pix[0];
+                            row[c++] = pix[1];
+                            row[c++] = pix[2];
+
+                            ++x;
+                            if (x > d) {
+                                if (y < p) {
+                                    ++y;
+                                    x = j;
+                                }
+                                else
+                                    break;
+                            }
+                        }
+
+                        // same as sort(..., SORT_EVERY_ROW | SORT_ASCENDING) of the row
+                        std::sort(row, row+c);
+                    }
+                }
+
+            private:
+                const Mat_<Vec3b> &src;
+                const std::vector<KeyPoint> &keypoints;
+                int l_kernel;
+                Mat &desc;
+
+                LUCIDInvoker& operator=(const LUCIDInvoker&); // to quiet MSVC
+        };
+
         // gliese581h suggested filling a cv::Mat with descriptors to enable BFmatcher compatibility
         // speed-ups and enhancements by gliese581h
         void LUCIDImpl::compute(InputArray _src, std::vector<KeyPoint> &keypoints, OutputArray _desc) {
-            if (_src.getMat().empty())
+            if (_src.getMat().empty() || !_desc.needed())
                 return;
 
             Mat_<Vec3b> src;
 
             blur(_src.getMat(), src, cv::Size(b_kernel, b_kernel));
 
-            int x, y, j, d, p, m = (l_kernel*2+1)*(l_kernel*2+1)*3, width = src.cols, height = src.rows, r, c;
-
-            Mat_<uchar> desc(static_cast<int>(keypoints.size()), m);
-
-            for (std::size_t i = 0; i < keypoints.size(); ++i) {
-                x = static_cast<int>(keypoints[i].pt.x)-l_kernel, y = static_cast<int>(keypoints[i].pt.y)-l_kernel, d = x+2*l_kernel, p = y+2*l_kernel, j = x, r = static_cast<int>(i), c = 0;
-
-                while (x <= d) {
-                    Vec3b &pix = src((y < 0 ? height+y : y >= height ? y-height : y), (x < 0 ? width+x : x >= width ? x-width : x));
-
-                    desc(r, c++) = pix[0];
-                    desc(r, c++) = pix[1];
-                    desc(r, c++) = pix[2];
-
-                    ++x;
-                    if (x > d) {
-                        if (y < p) {
-                            ++y;
-                            x = j;
-                        }
-                        else
-                            break;
-                    }
-                }
-            }
+            _desc.create(static_cast<int>(keypoints.size()), descriptorSize(), CV_8UC1);
+            Mat desc = _desc.getMat();
 
-            if (_desc.needed())
-                sort(desc, _desc, SORT_EVERY_ROW | SORT_ASCENDING);
+            parallel_for_(Range(0, static_cast<int>(keypoints.size())), LUCIDInvoker(src, keypoints, l_kernel, desc),
+                          keypoints.size()/256.);
         }
     }
 } // END NAMESPACE CV
@@ -55,6 +55,7 @@ University of Bologna, Open Perception
  */
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <limits>
 
 namespace cv
@@ -135,34 +136,26 @@ namespace cv
         {
         public:
 
-            // Multi-threaded contextualSelfDissimilarity method
+            // Multi-threaded contextualSelfDissimilarity method, over bands of rows
             struct MSDSelfDissimilarityScan : ParallelLoopBody
             {
 
-                MSDSelfDissimilarityScan(MSDDetector_Impl& _detector, std::vector< std::vector<float> >* _saliency, cv::Mat& _img, int _level, int _border, int _split)
+                MSDSelfDissimilarityScan(MSDDetector_Impl& _detector, std::vector< std::vector<float> >* _saliency, cv::Mat& _img, int _level, int _border, int _bandRows)
                 {
                     detector = &_detector;
                     saliency = _saliency;
                     img = &_img;
-                    split = _split;
                     level = _level;
                     border = _border;
-                    int w = img->cols - border * 2;
-                    chunkSize = w / split;
-                    remains = w - chunkSize*split;
+                    bandRows = _bandRows;
                 }
 
                 void operator()(const Range& range) const
                 {
                     for (int i = range.start; i < range.end; i++)
                     {
-                        int start = border + i*chunkSize;
-                        int end = border + (i + 1) * chunkSize;
-                        if (remains > 0)
-                            if (i == split - 1)
-                            {
-                                end = img->cols - border;
-                            }
+                        int start = border + i * bandRows;
+                        int end = std::min(start + bandRows, img->rows - border);
                         detector->contextualSelfDissimilarity(*img, start, end, &saliency->at(level)[0]);
                     }
                 }
@@ -171,10 +164,8 @@ namespace cv
                 std::vector< std::vector<float> >* saliency;
                 cv::Mat* img;
                 int level;
-                int split;
                 int border;
-                int chunkSize;
-                int remains;
+                int bandRows;
             };
 
             /**
@@ -230,10 +221,15 @@ namespace cv
                     fill(saliency[r].begin(), saliency[r].end(), 0.0f);
                 }
 
+                // Rows per band: the column sums of each band are initialized once per search offset
+                const int bandRows = 32;
                 for (int r = 0; r < m_cur_n_scales; r++)
                 {
-                    int steps = cv::getNumThreads();
-                    parallel_for_(Range(0, steps), MSDSelfDissimilarityScan((*this), &saliency, m_scaleSpace[r], r, border, steps));
+                    int rows = m_scaleSpace[r].rows - 2 * border;
+                    if (rows <= 0)
+                        continue;
+                    int bands = (rows + bandRows - 1) / bandRows;
+                    parallel_for_(Range(0, bands), MSDSelfDissimilarityScan((*this), &saliency, m_scaleSpace[r], r, border, bandRows));
                 }
 
                 nonMaximaSuppression(saliency, keypoints);
@@ -279,15 +275,16 @@ namespace cv
             cv::Mat m_mask;
 
             /**
-             * Computes the normalized average value of input vector
-             * @param minVals input vector
-             * @param den normalization factor (pre-multiplied by the number of elements of the input vector, assumed constant)
+             * Computes the normalized average value of input array
+             * @param minVals input array
+             * @param n number of elements of the input array
+             * @param den normalization factor (pre-multiplied by the number of elements of the input array, assumed constant)
              * @return normalized average value
              */
-            inline float computeAvgDistance(std::vector<int> &minVals, int den)
+            inline float computeAvgDistance(const int* minVals, int n, int den)
             {
                 float avg_dist = 0.0f;
-                for (unsigned int i = 0; i < minVals.size(); i++)
+                for (int i = 0; i < n; i++)
                     avg_dist += minVals[i];
 
                 avg_dist /= den;
@@ -295,13 +292,13 @@ namespace cv
             }
 
             /**
-             * Computer the Contextual Self-Dissimilarity (CSD, [1]) for a specific range of image pixels (row-wise)
+             * Computer the Contextual Self-Dissimilarity (CSD, [1]) for a band of image rows
              * @param img input image
-             * @param xmin left-most range limit for the image pixels being processed
-             * @param xmax right-most range limit for the image pixels being processed
+             * @param ymin top-most row of the band being processed
+             * @param ymax row following the bottom-most one of the band being processed
              * @param saliency output array being filled with the CSD value computed at each input pixel
              */
-            void contextualSelfDissimilarity(cv::Mat &img, int xmin, int xmax, float* saliency);
+            void contextualSelfDissimilarity(const cv::Mat &img, int ymin, int ymax, float* saliency);
 
             /**
              * Associates a canonical orientation (computed as in [1]) to each extracted key-point
@@ -383,206 +380,120 @@ namespace cv
             return true;
         }
 
-        void MSDDetector_Impl::contextualSelfDissimilarity(cv::Mat &img, int xmin, int xmax, float* saliency)
+        /*
+         * Adds (or subtracts) the squared differences between two image rows to the column sums
+         */
+        static void accumulateSquaredDiffs(const uchar* shifted, const uchar* ref, int* sums, int n, bool add)
+        {
+            int i = 0;
+#if CV_SIMD128
+            for (; i <= n - 8; i += 8)
+            {
+                v_int16x8 d = v_reinterpret_as_s16(v_load_expand(shifted + i)) - v_reinterpret_as_s16(v_load_expand(ref + i));
+                v_int32x4 d0, d1;
+                v_mul_expand(d, d, d0, d1);
+                v_int32x4 s0 = v_load(sums + i), s1 = v_load(sums + i + 4);
+                if (add)
+                {
+                    s0 += d0;
+                    s1 += d1;
+                }
+                else
+                {
+                    s0 -= d0;
+                    s1 -= d1;
+                }
+                v_store(sums + i, s0);
+                v_store(sums + i + 4, s1);
+            }
+#endif
+            for (; i < n; i++)
+            {
+                int d = shifted[i] - ref[i];
+                sums[i] += add ? d * d : -d * d;
+            }
+        }
+
+        void MSDDetector_Impl::contextualSelfDissimilarity(const cv::Mat &img, int ymin, int ymax, float* saliency)
         {
             int r_s = m_patch_radius;
             int r_b = m_search_area_radius;
             int k = m_kNN;
 
             int w = img.cols;
-            int h = img.rows;
 
             int side_s = 2 * r_s + 1;
-            int side_b = 2 * r_b + 1;
             int border = r_s + r_b;
-            int temp;
             int den = side_s * side_s * k;
 
-            std::vector<int> minVals(k);
-            int *acc = new int[side_b * side_b];
-            int **vCol = new int *[w];
-            for (int i = 0; i < w; i++)
-                vCol[i] = new int[side_b * side_b];
-
-            //first position
-            int x = xmin;
-            int y = border;
-
-            int ctrInd = 0;
-            for (int kk = 0; kk < k; kk++)
-                minVals[kk] = std::numeric_limits<int>::max();
-
-            for (int j = y - r_b; j <= y + r_b; j++)
+            int xmin = border, xmax = w - border;
+            int wc = xmax - xmin;
+            if (wc <= 0 || ymax <= ymin)
+                return;
+
+            // Columns whose vertical sums make up the patches of the band
+            int cmin = xmin - r_s;
+            int nc = wc + 2 * r_s;
+            std::vector<int> colSums(nc);
+            // k smallest patch SSDs of each pixel of the band, in ascending order
+            std::vector<int> minVals((ymax - ymin) * wc * k, std::numeric_limits<int>::max());
+
+            // One search offset at a time, the patch SSDs of the whole band are box filters of the squared
+            // differences between the image and its shifted copy: the column sums slide down the band and
+            // the patch sums slide along each row
+            for (int dy = -r_b; dy <= r_b; dy++)
             {
-
-                for (int i = x - r_b; i <= x + r_b; i++)
+                for (int dx = -r_b; dx <= r_b; dx++)
                 {
-                    if (j == y && i == x)
+                    if (dy == 0 && dx == 0)
                         continue;
 
-                    acc[ctrInd] = 0;
-                    for (int u = -r_s; u <= r_s; u++)
-                    {
-                        vCol[x + u][ctrInd] = 0;
-                        for (int v = -r_s; v <= r_s; v++)
-                        {
-
-                            temp = img.at<unsigned char>(j + v, i + u) - img.at<unsigned char>(y + v, x + u);
-                            vCol[x + u][ctrInd] += (temp * temp);
-                        }
-                        acc[ctrInd] += vCol[x + u][ctrInd];
-                    }
+                    std::fill(colSums.begin(), colSums.end(), 0);
+                    for (int v = -r_s; v <= r_s; v++)
+                        accumulateSquaredDiffs(img.ptr<uchar>(ymin + v + dy) + cmin + dx, img.ptr<uchar>(ymin + v) + cmin, &colSums[0], nc, true);
 
-                    if (acc[ctrInd] < minVals[k - 1])
+                    for (int y = ymin; y < ymax; y++)
                     {
-                        minVals[k - 1] = acc[ctrInd];
-
-                        for (int kk = k - 2; kk >= 0; kk--)
+                        if (y > ymin)
                         {
-                            if (minVals[kk] > minVals[kk + 1])
-                            {
-                                std::swap(minVals[kk], minVals[kk + 1]);
-                            } else
-                                break;
+                            accumulateSquaredDiffs(img.ptr<uchar>(y + r_s + dy) + cmin + dx, img.ptr<uchar>(y + r_s) + cmin, &colSums[0], nc, true);
+                            accumulateSquaredDiffs(img.ptr<uchar>(y - r_s - 1 + dy) + cmin + dx, img.ptr<uchar>(y - r_s - 1) + cmin, &colSums[0], nc, false);
                         }
-                    }
 
-                    ctrInd++;
-                }
-            }
-            saliency[y * w + x] = computeAvgDistance(minVals, den);
+                        int acc = 0;
+                        for (int u = 0; u < side_s; u++)
+                            acc += colSums[u];
 
-            for (x = xmin + 1; x < xmax; x++)
-            {
-                ctrInd = 0;
-                for (int kk = 0; kk < k; kk++)
-                    minVals[kk] = std::numeric_limits<int>::max();
-
-                for (int j = y - r_b; j <= y + r_b; j++)
-                {
-                    for (int i = x - r_b; i <= x + r_b; i++)
-                    {
-                        if (j == y && i == x)
-                            continue;
-
-                        vCol[x + r_s][ctrInd] = 0;
-                        for (int v = -r_s; v <= r_s; v++)
+                        int* best = &minVals[(y - ymin) * wc * k];
+                        for (int x = 0; x < wc; x++, best += k)
                         {
-                            temp = img.at<unsigned char>(j + v, i + r_s) - img.at<unsigned char>(y + v, x + r_s);
-                            vCol[x + r_s][ctrInd] += (temp * temp);
-                        }
-
-                        acc[ctrInd] = acc[ctrInd] + vCol[x + r_s][ctrInd] - vCol[x - r_s - 1][ctrInd];
+                            if (x > 0)
+                                acc += colSums[x + side_s - 1] - colSums[x - 1];
 
-                        if (acc[ctrInd] < minVals[k - 1])
-                        {
-                            minVals[k - 1] = acc[ctrInd];
-                            for (int kk = k - 2; kk >= 0; kk--)
+                            // most offsets are rejected by the current k-th smallest distance
+                            if (acc < best[k - 1])
                             {
-                                if (minVals[kk] > minVals[kk + 1])
-                                {
-                                    std::swap(minVals[kk], minVals[kk + 1]);
-                                } else
-                                    break;
-                            }
-                        }
-
-                        ctrInd++;
-                    }
-                }
-                saliency[y * w + x] = computeAvgDistance(minVals, den);
-            }
-
-            for (y = border + 1; y < h - border; y++)
-            {
-                ctrInd = 0;
-                for (int kk = 0; kk < k; kk++)
-                    minVals[kk] = std::numeric_limits<int>::max();
-                x = xmin;
-
-                for (int j = y - r_b; j <= y + r_b; j++)
-                {
-                    for (int i = x - r_b; i <= x + r_b; i++)
-                    {
-                        if (j == y && i == x)
-                            continue;
-
-                        acc[ctrInd] = 0;
-                        for (int u = -r_s; u <= r_s; u++)
-                        {
-                            temp = img.at<unsigned char>(j + r_s, i + u) - img.at<unsigned char>(y + r_s, x + u);
-                            vCol[x + u][ctrInd] += (temp * temp);
-
-                            temp = img.at<unsigned char>(j - r_s - 1, i + u) - img.at<unsigned char>(y - r_s - 1, x + u);
-                            vCol[x + u][ctrInd] -= (temp * temp);
-
-                            acc[ctrInd] += vCol[x + u][ctrInd];
-                        }
-
-                        if (acc[ctrInd] < minVals[k - 1])
-                        {
-                            minVals[k - 1] = acc[ctrInd];
-
-                            for (int kk = k - 2; kk >= 0; kk--)
-                            {
-                                if (minVals[kk] > minVals[kk + 1])
-                                {
-                                    std::swap(minVals[kk], minVals[kk + 1]);
-                                } else
-                                    break;
-                            }
-                        }
-
-                        ctrInd++;
-                    }
-                }
-                saliency[y * w + x] = computeAvgDistance(minVals, den);
-
-                for (x = xmin + 1; x < xmax; x++)
-                {
-                    ctrInd = 0;
-                    for (int kk = 0; kk < k; kk++)
-                        minVals[kk] = std::numeric_limits<int>::max();
-
-                    for (int j = y - r_b; j <= y + r_b; j++)
-                    {
-                        for (int i = x - r_b; i <= x + r_b; i++)
-                        {
-                            if (j == y && i == x)
-                                continue;
-
-                            temp = img.at<unsigned char>(j + r_s, i + r_s) - img.at<unsigned char>(y + r_s, x + r_s);
-                            vCol[x + r_s][ctrInd] += (temp * temp);
-
-                            temp = img.at<unsigned char>(j - r_s - 1, i + r_s) - img.at<unsigned char>(y - r_s - 1, x + r_s);
-                            vCol[x + r_s][ctrInd] -= (temp * temp);
-
-                            acc[ctrInd] = acc[ctrInd] + vCol[x + r_s][ctrInd] - vCol[x - r_s - 1][ctrInd];
-
-                            if (acc[ctrInd] < minVals[k - 1])
-                            {
-                                minVals[k - 1] = acc[ctrInd];
-
+                                best[k - 1] = acc;
                                 for (int kk = k - 2; kk >= 0; kk--)
                                 {
-                                    if (minVals[kk] > minVals[kk + 1])
+                                    if (best[kk] > best[kk + 1])
                                     {
-                                        std::swap(minVals[kk], minVals[kk + 1]);
+                                        std::swap(best[kk], best[kk + 1]);
                                     } else
                                         break;
                                 }
                             }
-                            ctrInd++;
                         }
                     }
-                    saliency[y * w + x] = computeAvgDistance(minVals, den);
                 }
             }
 
-            for (int i = 0; i < w; i++)
-                delete[] vCol[i];
-            delete[] vCol;
-            delete[] acc;
+            for (int y = ymin; y < ymax; y++)
+            {
+                const int* best = &minVals[(y - ymin) * wc * k];
+                for (int x = xmin; x < xmax; x++, best += k)
+                    saliency[y * w + x] = computeAvgDistance(best, k, den);
+            }
         }
 
         float MSDDetector_Impl::computeOrientation(cv::Mat &img, int x, int y, std::vector<cv::Point2f> circle)
@@ -463,9 +463,15 @@ void SURF_interpolateKeypoint(
     int img_cols,
     int c_octave,
     int c_layer_rows,
-    int c_max_features
+    int c_max_features,
+    int counter_offset,
+    int c_max_candidates
 )
 {
+    // the candidates are counted on the device, so the extra work-groups have nothing to do
+    if (get_group_id(0) >= min(featureCounter[counter_offset], c_max_candidates))
+        return;
+
     det_step /= sizeof(*det);
     keypoints_step /= sizeof(*keypoints);
     __global float * featureX       = keypoints + X_ROW * keypoints_step;
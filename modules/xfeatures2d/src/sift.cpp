@@ -106,6 +106,7 @@
 #include <iostream>
 #include <stdarg.h>
 #include <opencv2/core/hal/hal.hpp>
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv
 {
@@ -140,6 +141,12 @@ public:
                     OutputArray descriptors,
                     bool useProvidedKeypoints = false);
 
+    void setFixedPointPyramid(bool _fixedPointPyramid) { fixedPointPyramid = _fixedPointPyramid; }
+    bool getFixedPointPyramid() const { return fixedPointPyramid; }
+
+    void setUpsampleInput(bool _upsampleInput) { upsampleInput = _upsampleInput; }
+    bool getUpsampleInput() const { return upsampleInput; }
+
     void buildGaussianPyramid( const Mat& base, std::vector<Mat>& pyr, int nOctaves ) const;
     void buildDoGPyramid( const std::vector<Mat>& pyr, std::vector<Mat>& dogpyr ) const;
     void findScaleSpaceExtrema( const std::vector<Mat>& gauss_pyr, const std::vector<Mat>& dog_pyr,
@@ -151,6 +158,12 @@ protected:
     CV_PROP_RW double contrastThreshold;
     CV_PROP_RW double edgeThreshold;
     CV_PROP_RW double sigma;
+    bool fixedPointPyramid;
+    bool upsampleInput;
+
+    // the pyramids of the last image, reused by the next one of the same size
+    Mat base;
+    std::vector<Mat> gpyr, dogpyr;
 };
 
 Ptr<SIFT> SIFT::create( int _nfeatures, int _nOctaveLayers,
@@ -197,15 +210,15 @@ static const float SIFT_DESCR_MAG_THR = 0.2f;
 // factor used to convert floating-point descriptor to unsigned char
 static const float SIFT_INT_DESCR_FCTR = 512.f;
 
-#if 0
-// intermediate type used for DoG pyramids
-typedef short sift_wt;
-static const int SIFT_FIXPT_SCALE = 48;
-#else
-// intermediate type used for DoG pyramids
-typedef float sift_wt;
-static const int SIFT_FIXPT_SCALE = 1;
-#endif
+// intermediate types used for the pyramids: float, or short in the fixed-point mode,
+// where the image values are scaled by FIXPT_SCALE
+template<typename sift_wt> struct SIFTPyramidTraits { enum { FIXPT_SCALE = 1 }; };
+template<> struct SIFTPyramidTraits<short> { enum { FIXPT_SCALE = 48 }; };
+
+static inline int pyramidFixptScale( int depth )
+{
+    return depth == CV_16S ? (int)SIFTPyramidTraits<short>::FIXPT_SCALE : (int)SIFTPyramidTraits<float>::FIXPT_SCALE;
+}
 
 static inline void
 unpackOctave(const KeyPoint& kpt, int& octave, int& layer, float& scale)
@@ -216,31 +229,31 @@ unpackOctave(const KeyPoint& kpt, int& octave, int& layer, float& scale)
     scale = octave >= 0 ? 1.f/(1 << octave) : (float)(1 << -octave);
 }
 
-static Mat createInitialImage( const Mat& img, bool doubleImageSize, float sigma )
+// Computes the base of the pyramid of the given depth (CV_32F or CV_16S) into dst,
+// which is reused when it already has the right size and type
+static void createInitialImage( const Mat& img, bool doubleImageSize, float sigma, int depth, Mat& dst )
 {
-    Mat gray, gray_fpt;
+    Mat gray;
     if( img.channels() == 3 || img.channels() == 4 )
         cvtColor(img, gray, COLOR_BGR2GRAY);
     else
-        img.copyTo(gray);
-    gray.convertTo(gray_fpt, DataType<sift_wt>::type, SIFT_FIXPT_SCALE, 0);
+        gray = img;
 
     float sig_diff;
 
     if( doubleImageSize )
     {
         sig_diff = sqrtf( std::max(sigma * sigma - SIFT_INIT_SIGMA * SIFT_INIT_SIGMA * 4, 0.01f) );
-        Mat dbl;
-        resize(gray_fpt, dbl, Size(gray.cols*2, gray.rows*2), 0, 0, INTER_LINEAR);
-        GaussianBlur(dbl, dbl, Size(), sig_diff, sig_diff);
-        return dbl;
+        Mat gray_fpt;
+        gray.convertTo(gray_fpt, depth, pyramidFixptScale(depth), 0);
+        resize(gray_fpt, dst, Size(gray.cols*2, gray.rows*2), 0, 0, INTER_LINEAR);
     }
     else
     {
         sig_diff = sqrtf( std::max(sigma * sigma - SIFT_INIT_SIGMA * SIFT_INIT_SIGMA, 0.01f) );
-        GaussianBlur(gray_fpt, gray_fpt, Size(), sig_diff, sig_diff);
-        return gray_fpt;
+        gray.convertTo(dst, depth, pyramidFixptScale(depth), 0);
     }
+    GaussianBlur(dst, dst, Size(), sig_diff, sig_diff);
 }
 
 
@@ -284,25 +297,46 @@ void SIFT_Impl::buildGaussianPyramid( const Mat& base, std::vector<Mat>& pyr, in
 }
 
 
-void SIFT_Impl::buildDoGPyramid( const std::vector<Mat>& gpyr, std::vector<Mat>& dogpyr ) const
+// Computes the differences of a range of (octave, layer) pairs of the Gaussian pyramid
+struct SIFTBuildDoGInvoker : ParallelLoopBody
 {
-    int nOctaves = (int)gpyr.size()/(nOctaveLayers + 3);
-    dogpyr.resize( nOctaves*(nOctaveLayers + 2) );
+    SIFTBuildDoGInvoker( int _nOctaveLayers, const std::vector<Mat>& _gpyr, std::vector<Mat>& _dogpyr )
+    {
+        nOctaveLayers = _nOctaveLayers;
+        gpyr = &_gpyr;
+        dogpyr = &_dogpyr;
+    }
 
-    for( int o = 0; o < nOctaves; o++ )
+    void operator()(const Range& range) const
     {
-        for( int i = 0; i < nOctaveLayers + 2; i++ )
+        for( int a = range.start; a < range.end; a++ )
         {
-            const Mat& src1 = gpyr[o*(nOctaveLayers + 3) + i];
-            const Mat& src2 = gpyr[o*(nOctaveLayers + 3) + i + 1];
-            Mat& dst = dogpyr[o*(nOctaveLayers + 2) + i];
-            subtract(src2, src1, dst, noArray(), DataType<sift_wt>::type);
+            int o = a / (nOctaveLayers + 2);
+            int i = a % (nOctaveLayers + 2);
+
+            const Mat& src1 = (*gpyr)[o*(nOctaveLayers + 3) + i];
+            const Mat& src2 = (*gpyr)[o*(nOctaveLayers + 3) + i + 1];
+            Mat& dst = (*dogpyr)[o*(nOctaveLayers + 2) + i];
+            subtract(src2, src1, dst, noArray(), src1.type());
         }
     }
+
+    int nOctaveLayers;
+    const std::vector<Mat>* gpyr;
+    std::vector<Mat>* dogpyr;
+};
+
+void SIFT_Impl::buildDoGPyramid( const std::vector<Mat>& gpyr, std::vector<Mat>& dogpyr ) const
+{
+    int nOctaves = (int)gpyr.size()/(nOctaveLayers + 3);
+    dogpyr.resize( nOctaves*(nOctaveLayers + 2) );
+
+    parallel_for_(Range(0, nOctaves*(nOctaveLayers + 2)), SIFTBuildDoGInvoker(nOctaveLayers, gpyr, dogpyr));
 }
 
 
 // Computes a gradient orientation histogram at a specified pixel
+template<typename sift_wt>
 static float calcOrientationHist( const Mat& img, Point pt, int radius,
                                   float sigma, float* hist, int n )
 {
@@ -376,11 +410,12 @@ static float calcOrientationHist( const Mat& img, Point pt, int radius,
 // Interpolates a scale-space extremum's location and scale to subpixel
 // accuracy to form an image feature. Rejects features with low contrast.
 // Based on Section 4 of Lowe's paper.
+template<typename sift_wt>
 static bool adjustLocalExtrema( const std::vector<Mat>& dog_pyr, KeyPoint& kpt, int octv,
                                 int& layer, int& r, int& c, int nOctaveLayers,
                                 float contrastThreshold, float edgeThreshold, float sigma )
 {
-    const float img_scale = 1.f/(255*SIFT_FIXPT_SCALE);
+    const float img_scale = 1.f/(255*SIFTPyramidTraits<sift_wt>::FIXPT_SCALE);
     const float deriv_scale = img_scale*0.5f;
     const float second_deriv_scale = img_scale;
     const float cross_deriv_scale = img_scale*0.25f;
@@ -479,6 +514,115 @@ static bool adjustLocalExtrema( const std::vector<Mat>& dog_pyr, KeyPoint& kpt,
 }
 
 
+// Finds the extrema of a range of rows of one DoG layer. The keypoints of every row
+// go to their own vector, so that they can be gathered in the order of a serial scan.
+template<typename sift_wt>
+struct SIFTFindExtremaInvoker : ParallelLoopBody
+{
+    SIFTFindExtremaInvoker( const std::vector<Mat>& _gauss_pyr, const std::vector<Mat>& _dog_pyr,
+                            int _o, int _i, int _threshold, int _nOctaveLayers, float _contrastThreshold,
+                            float _edgeThreshold, float _sigma, std::vector<std::vector<KeyPoint> >& _rowKeypoints )
+    {
+        gauss_pyr = &_gauss_pyr;
+        dog_pyr = &_dog_pyr;
+        o = _o;
+        i = _i;
+        threshold = _threshold;
+        nOctaveLayers = _nOctaveLayers;
+        contrastThreshold = _contrastThreshold;
+        edgeThreshold = _edgeThreshold;
+        sigma = _sigma;
+        rowKeypoints = &_rowKeypoints;
+    }
+
+    void operator()(const Range& range) const
+    {
+        const int n = SIFT_ORI_HIST_BINS;
+        float hist[n];
+        KeyPoint kpt;
+
+        int idx = o*(nOctaveLayers+2)+i;
+        const Mat& img = (*dog_pyr)[idx];
+        const Mat& prev = (*dog_pyr)[idx-1];
+        const Mat& next = (*dog_pyr)[idx+1];
+        int step = (int)img.step1();
+        int cols = img.cols;
+
+        for( int r = range.start; r < range.end; r++)
+        {
+            const sift_wt* currptr = img.ptr<sift_wt>(r);
+            const sift_wt* prevptr = prev.ptr<sift_wt>(r);
+            const sift_wt* nextptr = next.ptr<sift_wt>(r);
+            std::vector<KeyPoint>& keypoints = (*rowKeypoints)[r];
+
+            for( int c = SIFT_IMG_BORDER; c < cols-SIFT_IMG_BORDER; c++)
+            {
+                sift_wt val = currptr[c];
+
+                // find local extrema with pixel accuracy
+                if( std::abs(val) > threshold &&
+                   ((val > 0 && val >= currptr[c-1] && val >= currptr[c+1] &&
+                     val >= currptr[c-step-1] && val >= currptr[c-step] && val >= currptr[c-step+1] &&
+                     val >= currptr[c+step-1] && val >= currptr[c+step] && val >= currptr[c+step+1] &&
+                     val >= nextptr[c] && val >= nextptr[c-1] && val >= nextptr[c+1] &&
+                     val >= nextptr[c-step-1] && val >= nextptr[c-step] && val >= nextptr[c-step+1] &&
+                     val >= nextptr[c+step-1] && val >= nextptr[c+step] && val >= nextptr[c+step+1] &&
+                     val >= prevptr[c] && val >= prevptr[c-1] && val >= prevptr[c+1] &&
+                     val >= prevptr[c-step-1] && val >= prevptr[c-step] && val >= prevptr[c-step+1] &&
+                     val >= prevptr[c+step-1] && val >= prevptr[c+step] && val >= prevptr[c+step+1]) ||
+                    (val < 0 && val <= currptr[c-1] && val <= currptr[c+1] &&
+                     val <= currptr[c-step-1] && val <= currptr[c-step] && val <= currptr[c-step+1] &&
+                     val <= currptr[c+step-1] && val <= currptr[c+step] && val <= currptr[c+step+1] &&
+                     val <= nextptr[c] && val <= nextptr[c-1] && val <= nextptr[c+1] &&
+                     val <= nextptr[c-step-1] && val <= nextptr[c-step] && val <= nextptr[c-step+1] &&
+                     val <= nextptr[c+step-1] && val <= nextptr[c+step] && val <= nextptr[c+step+1] &&
+                     val <= prevptr[c] && val <= prevptr[c-1] && val <= prevptr[c+1] &&
+                     val <= prevptr[c-step-1] && val <= prevptr[c-step] && val <= prevptr[c-step+1] &&
+                     val <= prevptr[c+step-1] && val <= prevptr[c+step] && val <= prevptr[c+step+1])))
+                {
+                    int r1 = r, c1 = c, layer = i;
+                    if( !adjustLocalExtrema<sift_wt>(*dog_pyr, kpt, o, layer, r1, c1,
+                                            nOctaveLayers, contrastThreshold,
+                                            edgeThreshold, sigma) )
+                        continue;
+                    float scl_octv = kpt.size*0.5f/(1 << o);
+                    float omax = calcOrientationHist<sift_wt>((*gauss_pyr)[o*(nOctaveLayers+3) + layer],
+                                                     Point(c1, r1),
+                                                     cvRound(SIFT_ORI_RADIUS * scl_octv),
+                                                     SIFT_ORI_SIG_FCTR * scl_octv,
+                                                     hist, n);
+                    float mag_thr = (float)(omax * SIFT_ORI_PEAK_RATIO);
+                    for( int j = 0; j < n; j++ )
+                    {
+                        int l = j > 0 ? j - 1 : n - 1;
+                        int r2 = j < n-1 ? j + 1 : 0;
+
+                        if( hist[j] > hist[l]  &&  hist[j] > hist[r2]  &&  hist[j] >= mag_thr )
+                        {
+                            float bin = j + 0.5f * (hist[l]-hist[r2]) / (hist[l] - 2*hist[j] + hist[r2]);
+                            bin = bin < 0 ? n + bin : bin >= n ? bin - n : bin;
+                            kpt.angle = 360.f - (float)((360.f/n) * bin);
+                            if(std::abs(kpt.angle - 360.f) < FLT_EPSILON)
+                                kpt.angle = 0.f;
+                            keypoints.push_back(kpt);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    const std::vector<Mat>* gauss_pyr;
+    const std::vector<Mat>* dog_pyr;
+    int o, i;
+    int threshold;
+    int nOctaveLayers;
+    float contrastThreshold;
+    float edgeThreshold;
+    float sigma;
+    std::vector<std::vector<KeyPoint> >* rowKeypoints;
+};
+
 //
 // Detects features at extrema in DoG scale space.  Bad features are discarded
 // based on contrast and ratio of principal curvatures.
@@ -486,88 +630,43 @@ void SIFT_Impl::findScaleSpaceExtrema( const std::vector<Mat>& gauss_pyr, const
                                   std::vector<KeyPoint>& keypoints ) const
 {
     int nOctaves = (int)gauss_pyr.size()/(nOctaveLayers + 3);
-    int threshold = cvFloor(0.5 * contrastThreshold / nOctaveLayers * 255 * SIFT_FIXPT_SCALE);
-    const int n = SIFT_ORI_HIST_BINS;
-    float hist[n];
-    KeyPoint kpt;
+    std::vector<std::vector<KeyPoint> > rowKeypoints;
 
     keypoints.clear();
+    if( dog_pyr.empty() )
+        return;
+
+    bool fixedPoint = dog_pyr[0].depth() == CV_16S;
+    int threshold = cvFloor(0.5 * contrastThreshold / nOctaveLayers * 255 * pyramidFixptScale(dog_pyr[0].depth()));
 
     for( int o = 0; o < nOctaves; o++ )
         for( int i = 1; i <= nOctaveLayers; i++ )
         {
-            int idx = o*(nOctaveLayers+2)+i;
-            const Mat& img = dog_pyr[idx];
-            const Mat& prev = dog_pyr[idx-1];
-            const Mat& next = dog_pyr[idx+1];
-            int step = (int)img.step1();
-            int rows = img.rows, cols = img.cols;
-
-            for( int r = SIFT_IMG_BORDER; r < rows-SIFT_IMG_BORDER; r++)
-            {
-                const sift_wt* currptr = img.ptr<sift_wt>(r);
-                const sift_wt* prevptr = prev.ptr<sift_wt>(r);
-                const sift_wt* nextptr = next.ptr<sift_wt>(r);
+            int rows = dog_pyr[o*(nOctaveLayers+2)+i].rows;
+            if( rows <= 2*SIFT_IMG_BORDER )
+                continue;
 
-                for( int c = SIFT_IMG_BORDER; c < cols-SIFT_IMG_BORDER; c++)
-                {
-                    sift_wt val = currptr[c];
-
-                    // find local extrema with pixel accuracy
-                    if( std::abs(val) > threshold &&
-                       ((val > 0 && val >= currptr[c-1] && val >= currptr[c+1] &&
-                         val >= currptr[c-step-1] && val >= currptr[c-step] && val >= currptr[c-step+1] &&
-                         val >= currptr[c+step-1] && val >= currptr[c+step] && val >= currptr[c+step+1] &&
-                         val >= nextptr[c] && val >= nextptr[c-1] && val >= nextptr[c+1] &&
-                         val >= nextptr[c-step-1] && val >= nextptr[c-step] && val >= nextptr[c-step+1] &&
-                         val >= nextptr[c+step-1] && val >= nextptr[c+step] && val >= nextptr[c+step+1] &&
-                         val >= prevptr[c] && val >= prevptr[c-1] && val >= prevptr[c+1] &&
-                         val >= prevptr[c-step-1] && val >= prevptr[c-step] && val >= prevptr[c-step+1] &&
-                         val >= prevptr[c+step-1] && val >= prevptr[c+step] && val >= prevptr[c+step+1]) ||
-                        (val < 0 && val <= currptr[c-1] && val <= currptr[c+1] &&
-                         val <= currptr[c-step-1] && val <= currptr[c-step] && val <= currptr[c-step+1] &&
-                         val <= currptr[c+step-1] && val <= currptr[c+step] && val <= currptr[c+step+1] &&
-                         val <= nextptr[c] && val <= nextptr[c-1] && val <= nextptr[c+1] &&
-                         val <= nextptr[c-step-1] && val <= nextptr[c-step] && val <= nextptr[c-step+1] &&
-                         val <= nextptr[c+step-1] && val <= nextptr[c+step] && val <= nextptr[c+step+1] &&
-                         val <= prevptr[c] && val <= prevptr[c-1] && val <= prevptr[c+1] &&
-                         val <= prevptr[c-step-1] && val <= prevptr[c-step] && val <= prevptr[c-step+1] &&
-                         val <= prevptr[c+step-1] && val <= prevptr[c+step] && val <= prevptr[c+step+1])))
-                    {
-                        int r1 = r, c1 = c, layer = i;
-                        if( !adjustLocalExtrema(dog_pyr, kpt, o, layer, r1, c1,
-                                                nOctaveLayers, (float)contrastThreshold,
-                                                (float)edgeThreshold, (float)sigma) )
-                            continue;
-                        float scl_octv = kpt.size*0.5f/(1 << o);
-                        float omax = calcOrientationHist(gauss_pyr[o*(nOctaveLayers+3) + layer],
-                                                         Point(c1, r1),
-                                                         cvRound(SIFT_ORI_RADIUS * scl_octv),
-                                                         SIFT_ORI_SIG_FCTR * scl_octv,
-                                                         hist, n);
-                        float mag_thr = (float)(omax * SIFT_ORI_PEAK_RATIO);
-                        for( int j = 0; j < n; j++ )
-                        {
-                            int l = j > 0 ? j - 1 : n - 1;
-                            int r2 = j < n-1 ? j + 1 : 0;
-
-                            if( hist[j] > hist[l]  &&  hist[j] > hist[r2]  &&  hist[j] >= mag_thr )
-                            {
-                                float bin = j + 0.5f * (hist[l]-hist[r2]) / (hist[l] - 2*hist[j] + hist[r2]);
-                                bin = bin < 0 ? n + bin : bin >= n ? bin - n : bin;
-                                kpt.angle = 360.f - (float)((360.f/n) * bin);
-                                if(std::abs(kpt.angle - 360.f) < FLT_EPSILON)
-                                    kpt.angle = 0.f;
-                                keypoints.push_back(kpt);
-                            }
-                        }
-                    }
-                }
+            rowKeypoints.resize(rows);
+            Range range(SIFT_IMG_BORDER, rows-SIFT_IMG_BORDER);
+            if( fixedPoint )
+                parallel_for_(range, SIFTFindExtremaInvoker<short>(gauss_pyr, dog_pyr, o, i, threshold, nOctaveLayers,
+                                                                   (float)contrastThreshold, (float)edgeThreshold,
+                                                                   (float)sigma, rowKeypoints));
+            else
+                parallel_for_(range, SIFTFindExtremaInvoker<float>(gauss_pyr, dog_pyr, o, i, threshold, nOctaveLayers,
+                                                                   (float)contrastThreshold, (float)edgeThreshold,
+                                                                   (float)sigma, rowKeypoints));
+
+            for( int r = SIFT_IMG_BORDER; r < rows-SIFT_IMG_BORDER; r++ )
+            {
+                keypoints.insert(keypoints.end(), rowKeypoints[r].begin(), rowKeypoints[r].end());
+                rowKeypoints[r].clear();
             }
         }
 }
 
 
+template<typename sift_wt>
 static void calcSIFTDescriptor( const Mat& img, Point2f ptf, float ori, float scl,
                                int d, int n, float* dst )
 {
@@ -625,7 +724,68 @@ static void calcSIFTDescriptor( const Mat& img, Point2f ptf, float ori, float sc
     cv::hal::magnitude32f(X, Y, Mag, len);
     cv::hal::exp32f(W, W, len);
 
-    for( k = 0; k < len; k++ )
+    k = 0;
+#if CV_SIMD128
+    {
+        // the bins and the tri-linear weights of 4 samples at a time,
+        // the histogram is then updated sample by sample
+        int CV_DECL_ALIGNED(16) r0_buf[4];
+        int CV_DECL_ALIGNED(16) c0_buf[4];
+        int CV_DECL_ALIGNED(16) o0_buf[4];
+        float CV_DECL_ALIGNED(16) w_buf[8][4];
+        const v_float32x4 v_ori = v_setall_f32(ori), v_bins_per_rad = v_setall_f32(bins_per_rad);
+        const v_int32x4 v_n = v_setall_s32(n), v_zero = v_setzero_s32();
+
+        for( ; k <= len - 4; k += 4 )
+        {
+            v_float32x4 rbin = v_load(RBin + k), cbin = v_load(CBin + k);
+            v_float32x4 obin = (v_load(Ori + k) - v_ori)*v_bins_per_rad;
+            v_float32x4 mag = v_load(Mag + k)*v_load(W + k);
+
+            v_int32x4 r0 = v_floor(rbin), c0 = v_floor(cbin), o0 = v_floor(obin);
+            rbin -= v_cvt_f32(r0);
+            cbin -= v_cvt_f32(c0);
+            obin -= v_cvt_f32(o0);
+
+            o0 += v_n & (o0 < v_zero);
+            o0 -= v_n & (o0 >= v_n);
+
+            v_store_aligned(r0_buf, r0);
+            v_store_aligned(c0_buf, c0);
+            v_store_aligned(o0_buf, o0);
+
+            v_float32x4 v_r1 = mag*rbin, v_r0 = mag - v_r1;
+            v_float32x4 v_rc11 = v_r1*cbin, v_rc10 = v_r1 - v_rc11;
+            v_float32x4 v_rc01 = v_r0*cbin, v_rc00 = v_r0 - v_rc01;
+            v_float32x4 v_rco111 = v_rc11*obin, v_rco110 = v_rc11 - v_rco111;
+            v_float32x4 v_rco101 = v_rc10*obin, v_rco100 = v_rc10 - v_rco101;
+            v_float32x4 v_rco011 = v_rc01*obin, v_rco010 = v_rc01 - v_rco011;
+            v_float32x4 v_rco001 = v_rc00*obin, v_rco000 = v_rc00 - v_rco001;
+            v_store_aligned(w_buf[0], v_rco000);
+            v_store_aligned(w_buf[1], v_rco001);
+            v_store_aligned(w_buf[2], v_rco010);
+            v_store_aligned(w_buf[3], v_rco011);
+            v_store_aligned(w_buf[4], v_rco100);
+            v_store_aligned(w_buf[5], v_rco101);
+            v_store_aligned(w_buf[6], v_rco110);
+            v_store_aligned(w_buf[7], v_rco111);
+
+            for( int l = 0; l < 4; l++ )
+            {
+                int idx_l = ((r0_buf[l]+1)*(d+2) + c0_buf[l]+1)*(n+2) + o0_buf[l];
+                hist[idx_l] += w_buf[0][l];
+                hist[idx_l+1] += w_buf[1][l];
+                hist[idx_l+(n+2)] += w_buf[2][l];
+                hist[idx_l+(n+3)] += w_buf[3][l];
+                hist[idx_l+(d+2)*(n+2)] += w_buf[4][l];
+                hist[idx_l+(d+2)*(n+2)+1] += w_buf[5][l];
+                hist[idx_l+(d+3)*(n+2)] += w_buf[6][l];
+                hist[idx_l+(d+3)*(n+2)+1] += w_buf[7][l];
+            }
+        }
+    }
+#endif
+    for( ; k < len; k++ )
     {
         float rbin = RBin[k], cbin = CBin[k];
         float obin = (Ori[k] - ori)*bins_per_rad;
@@ -710,27 +870,60 @@ static void calcSIFTDescriptor( const Mat& img, Point2f ptf, float ori, float sc
 #endif
 }
 
-static void calcDescriptors(const std::vector<Mat>& gpyr, const std::vector<KeyPoint>& keypoints,
-                            Mat& descriptors, int nOctaveLayers, int firstOctave )
+// Computes the descriptors of a range of keypoints, each of them in its own row
+template<typename sift_wt>
+struct SIFTCalcDescriptorsInvoker : ParallelLoopBody
 {
-    int d = SIFT_DESCR_WIDTH, n = SIFT_DESCR_HIST_BINS;
+    SIFTCalcDescriptorsInvoker( const std::vector<Mat>& _gpyr, const std::vector<KeyPoint>& _keypoints,
+                                Mat& _descriptors, int _nOctaveLayers, int _firstOctave )
+    {
+        gpyr = &_gpyr;
+        keypoints = &_keypoints;
+        descriptors = &_descriptors;
+        nOctaveLayers = _nOctaveLayers;
+        firstOctave = _firstOctave;
+    }
 
-    for( size_t i = 0; i < keypoints.size(); i++ )
+    void operator()(const Range& range) const
     {
-        KeyPoint kpt = keypoints[i];
-        int octave, layer;
-        float scale;
-        unpackOctave(kpt, octave, layer, scale);
-        CV_Assert(octave >= firstOctave && layer <= nOctaveLayers+2);
-        float size=kpt.size*scale;
-        Point2f ptf(kpt.pt.x*scale, kpt.pt.y*scale);
-        const Mat& img = gpyr[(octave - firstOctave)*(nOctaveLayers + 3) + layer];
-
-        float angle = 360.f - kpt.angle;
-        if(std::abs(angle - 360.f) < FLT_EPSILON)
-            angle = 0.f;
-        calcSIFTDescriptor(img, ptf, angle, size*0.5f, d, n, descriptors.ptr<float>((int)i));
+        int d = SIFT_DESCR_WIDTH, n = SIFT_DESCR_HIST_BINS;
+
+        for( int i = range.start; i < range.end; i++ )
+        {
+            KeyPoint kpt = (*keypoints)[i];
+            int octave, layer;
+            float scale;
+            unpackOctave(kpt, octave, layer, scale);
+            CV_Assert(octave >= firstOctave && layer <= nOctaveLayers+2);
+            float size=kpt.size*scale;
+            Point2f ptf(kpt.pt.x*scale, kpt.pt.y*scale);
+            const Mat& img = (*gpyr)[(octave - firstOctave)*(nOctaveLayers + 3) + layer];
+
+            float angle = 360.f - kpt.angle;
+            if(std::abs(angle - 360.f) < FLT_EPSILON)
+                angle = 0.f;
+            calcSIFTDescriptor<sift_wt>(img, ptf, angle, size*0.5f, d, n, descriptors->ptr<float>(i));
+        }
     }
+
+    const std::vector<Mat>* gpyr;
+    const std::vector<KeyPoint>* keypoints;
+    Mat* descriptors;
+    int nOctaveLayers;
+    int firstOctave;
+};
+
+static void calcDescriptors(const std::vector<Mat>& gpyr, const std::vector<KeyPoint>& keypoints,
+                            Mat& descriptors, int nOctaveLayers, int firstOctave )
+{
+    if( keypoints.empty() )
+        return;
+
+    Range range(0, (int)keypoints.size());
+    if( gpyr[0].depth() == CV_16S )
+        parallel_for_(range, SIFTCalcDescriptorsInvoker<short>(gpyr, keypoints, descriptors, nOctaveLayers, firstOctave));
+    else
+        parallel_for_(range, SIFTCalcDescriptorsInvoker<float>(gpyr, keypoints, descriptors, nOctaveLayers, firstOctave));
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -738,7 +931,8 @@ static void calcDescriptors(const std::vector<Mat>& gpyr, const std::vector<KeyP
 SIFT_Impl::SIFT_Impl( int _nfeatures, int _nOctaveLayers,
            double _contrastThreshold, double _edgeThreshold, double _sigma )
     : nfeatures(_nfeatures), nOctaveLayers(_nOctaveLayers),
-    contrastThreshold(_contrastThreshold), edgeThreshold(_edgeThreshold), sigma(_sigma)
+    contrastThreshold(_contrastThreshold), edgeThreshold(_edgeThreshold), sigma(_sigma),
+    fixedPointPyramid(false), upsampleInput(true)
 {
 }
 
@@ -790,9 +984,10 @@ void SIFT_Impl::detectAndCompute(InputArray _image, InputArray _mask,
         CV_Assert( firstOctave >= -1 && actualNLayers <= nOctaveLayers );
         actualNOctaves = maxOctave - firstOctave + 1;
     }
+    else if( !upsampleInput )
+        firstOctave = 0;
 
-    Mat base = createInitialImage(image, firstOctave < 0, (float)sigma);
-    std::vector<Mat> gpyr, dogpyr;
+    createInitialImage(image, firstOctave < 0, (float)sigma, fixedPointPyramid ? CV_16S : CV_32F, base);
     int nOctaves = actualNOctaves > 0 ? actualNOctaves : cvRound(std::log( (double)std::min( base.cols, base.rows ) ) / std::log(2.) - 2) - firstOctave;
 
     //double t, tf = getTickFrequency();
@@ -1000,6 +1000,103 @@ void SURF_Impl::detectAndCompute(InputArray _img, InputArray _mask,
     }
 }
 
+void SURF_Impl::detectAndCompute(InputArray _img, InputArray _mask, UMat& keypoints,
+                                 OutputArray _descriptors, bool useProvidedKeypoints)
+{
+    CV_Assert(_descriptors.needed() || !useProvidedKeypoints);
+
+#ifdef HAVE_OPENCL
+    if( ocl::useOpenCL() )
+    {
+        SURF_OCL ocl_surf;
+        bool ok = ocl_surf.init(this);
+
+        if( ok )
+        {
+            if( !_descriptors.needed() )
+                ok = ocl_surf.detect(_img, _mask, keypoints);
+            else
+                ok = ocl_surf.detectAndCompute(_img, _mask, keypoints, _descriptors, useProvidedKeypoints);
+        }
+        if( ok )
+            return;
+    }
+#endif // HAVE_OPENCL
+
+    std::vector<KeyPoint> cpu_keypoints;
+    if( useProvidedKeypoints )
+        downloadKeypoints(keypoints, cpu_keypoints);
+    detectAndCompute(_img, _mask, cpu_keypoints, _descriptors, useProvidedKeypoints);
+    uploadKeypoints(cpu_keypoints, keypoints);
+}
+
+void SURF::uploadKeypoints(const std::vector<KeyPoint>& keypoints, UMat& keypointsGPU)
+{
+    if (keypoints.empty())
+        keypointsGPU.release();
+    else
+    {
+        Mat keypointsCPU(ROWS_COUNT, static_cast<int>(keypoints.size()), CV_32FC1);
+
+        float *kp_x = keypointsCPU.ptr<float>(X_ROW);
+        float *kp_y = keypointsCPU.ptr<float>(Y_ROW);
+        int *kp_laplacian = keypointsCPU.ptr<int>(LAPLACIAN_ROW);
+        int *kp_octave = keypointsCPU.ptr<int>(OCTAVE_ROW);
+        float *kp_size = keypointsCPU.ptr<float>(SIZE_ROW);
+        float *kp_dir = keypointsCPU.ptr<float>(ANGLE_ROW);
+        float *kp_hessian = keypointsCPU.ptr<float>(HESSIAN_ROW);
+
+        for (size_t i = 0, size = keypoints.size(); i < size; ++i)
+        {
+            const KeyPoint &kp = keypoints[i];
+            kp_x[i] = kp.pt.x;
+            kp_y[i] = kp.pt.y;
+            kp_octave[i] = kp.octave;
+            kp_size[i] = kp.size;
+            kp_dir[i] = kp.angle;
+            kp_hessian[i] = kp.response;
+            kp_laplacian[i] = kp.class_id; // the sign of the laplacian for SURF keypoints
+        }
+
+        keypointsCPU.copyTo(keypointsGPU);
+    }
+}
+
+void SURF::downloadKeypoints(const UMat& keypointsGPU, std::vector<KeyPoint>& keypoints)
+{
+    const int nFeatures = keypointsGPU.cols;
+
+    if (nFeatures == 0)
+        keypoints.clear();
+    else
+    {
+        CV_Assert(keypointsGPU.type() == CV_32FC1 && keypointsGPU.rows == ROWS_COUNT);
+
+        Mat keypointsCPU = keypointsGPU.getMat(ACCESS_READ);
+        keypoints.resize(nFeatures);
+
+        const float *kp_x = keypointsCPU.ptr<float>(X_ROW);
+        const float *kp_y = keypointsCPU.ptr<float>(Y_ROW);
+        const int *kp_laplacian = keypointsCPU.ptr<int>(LAPLACIAN_ROW);
+        const int *kp_octave = keypointsCPU.ptr<int>(OCTAVE_ROW);
+        const float *kp_size = keypointsCPU.ptr<float>(SIZE_ROW);
+        const float *kp_dir = keypointsCPU.ptr<float>(ANGLE_ROW);
+        const float *kp_hessian = keypointsCPU.ptr<float>(HESSIAN_ROW);
+
+        for (int i = 0; i < nFeatures; ++i)
+        {
+            KeyPoint &kp = keypoints[i];
+            kp.pt.x = kp_x[i];
+            kp.pt.y = kp_y[i];
+            kp.class_id = kp_laplacian[i];
+            kp.octave = kp_octave[i];
+            kp.size = kp_size[i];
+            kp.angle = kp_dir[i];
+            kp.response = kp_hessian[i];
+        }
+    }
+}
+
 Ptr<SURF> SURF::create(double _threshold, int _nOctaves, int _nOctaveLayers, bool _extended, bool _upright)
 {
     return makePtr<SURF_Impl>(_threshold, _nOctaves, _nOctaveLayers, _extended, _upright);
@@ -42,6 +42,10 @@ public:
                           OutputArray descriptors,
                           bool useProvidedKeypoints = false);
 
+    //! the same, with the keypoints in the SURF::KeypointLayout rows of a UMat
+    void detectAndCompute(InputArray img, InputArray mask, UMat& keypoints,
+                          OutputArray descriptors, bool useProvidedKeypoints = false);
+
     void setHessianThreshold(double hessianThreshold_) { hessianThreshold = hessianThreshold_; }
     double getHessianThreshold() const { return hessianThreshold; }
 
@@ -68,18 +72,6 @@ public:
 class SURF_OCL
 {
 public:
-    enum KeypointLayout
-    {
-        X_ROW = 0,
-        Y_ROW,
-        LAPLACIAN_ROW,
-        OCTAVE_ROW,
-        SIZE_ROW,
-        ANGLE_ROW,
-        HESSIAN_ROW,
-        ROWS_COUNT
-    };
-
     //! the full constructor taking all the necessary parameters
     SURF_OCL();
 
@@ -93,7 +85,7 @@ public:
 
     //! finds the keypoints using fast hessian detector used in SURF
     //! supports CV_8UC1 images
-    //! keypoints will have nFeature cols and 6 rows
+    //! keypoints will have nFeature cols and SURF::ROWS_COUNT rows
     //! keypoints.ptr<float>(X_ROW)[i] will contain x coordinate of i'th feature
     //! keypoints.ptr<float>(Y_ROW)[i] will contain y coordinate of i'th feature
     //! keypoints.ptr<float>(LAPLACIAN_ROW)[i] will contain laplacian sign of i'th feature
@@ -115,7 +107,7 @@ protected:
 
     bool findMaximaInLayer(int counterOffset, int octave, int layer_rows, int layer_cols);
 
-    bool interpolateKeypoint(int maxCounter, UMat &keypoints, int octave, int layer_rows, int maxFeatures);
+    bool interpolateKeypoint(int counterOffset, UMat &keypoints, int octave, int layer_rows, int maxFeatures);
 
     bool calcOrientation(UMat &keypoints);
 
@@ -160,10 +160,11 @@ bool SURF_OCL::detectKeypoints(UMat &keypoints)
     trace.create(img_rows * (params->nOctaveLayers + 2), img_cols, CV_32FC1);
 
     maxPosBuffer.create(1, maxCandidates, CV_32SC4);
-    keypoints.create(SURF_OCL::ROWS_COUNT, maxFeatures, CV_32F);
+    keypoints.create(SURF::ROWS_COUNT, maxFeatures, CV_32F);
     keypoints.setTo(Scalar::all(0));
-    Mat cpuCounters;
 
+    // the kernels are queued without waiting for each other: the number of candidates of each
+    // octave stays on the device, and only the final number of features is read back
     for (int octave = 0; octave < params->nOctaves; ++octave)
     {
         const int layer_rows = img_rows >> octave;
@@ -175,19 +176,11 @@ bool SURF_OCL::detectKeypoints(UMat &keypoints)
         if(!findMaximaInLayer(1 + octave, octave, layer_rows, layer_cols))
             return false;
 
-        cpuCounters = counters.getMat(ACCESS_READ);
-        int maxCounter = cpuCounters.at<int>(1 + octave);
-        maxCounter = std::min(maxCounter, maxCandidates);
-        cpuCounters.release();
-
-        if (maxCounter > 0)
-        {
-            if(!interpolateKeypoint(maxCounter, keypoints, octave, layer_rows, maxFeatures))
-                return false;
-        }
+        if(!interpolateKeypoint(1 + octave, keypoints, octave, layer_rows, maxFeatures))
+            return false;
     }
 
-    cpuCounters = counters.getMat(ACCESS_READ);
+    Mat cpuCounters = counters.getMat(ACCESS_READ);
     int featureCounter = cpuCounters.at<int>(0);
     featureCounter = std::min(featureCounter, maxFeatures);
     cpuCounters.release();
@@ -209,7 +202,7 @@ bool SURF_OCL::setUpRight(UMat &keypoints)
 
     size_t globalThreads[3] = {(size_t)nFeatures, 1};
     ocl::Kernel kerUpRight("SURF_setUpRight", ocl::xfeatures2d::surf_oclsrc, kerOpts);
-    return kerUpRight.args(ocl::KernelArg::ReadWrite(keypoints)).run(2, globalThreads, 0, true);
+    return kerUpRight.args(ocl::KernelArg::ReadWrite(keypoints)).run(2, globalThreads, 0, false);
 }
 
 bool SURF_OCL::computeDescriptors(const UMat &keypoints, OutputArray _descriptors)
@@ -260,7 +253,7 @@ bool SURF_OCL::computeDescriptors(const UMat &keypoints, OutputArray _descriptor
                          ocl::KernelArg::WriteOnlyNoSize(descriptors));
     }
 
-    if(!kerCalcDesc.run(2, globalThreads, localThreads, true))
+    if(!kerCalcDesc.run(2, globalThreads, localThreads, false))
         return false;
 
     size_t localThreads_n[] = {(size_t)dsize, 1};
@@ -269,7 +262,7 @@ bool SURF_OCL::computeDescriptors(const UMat &keypoints, OutputArray _descriptor
     globalThreads[0] = nFeatures * localThreads[0];
     globalThreads[1] = localThreads[1];
     bool ok = kerNormDesc.args(ocl::KernelArg::ReadWriteNoSize(descriptors)).
-                        run(2, globalThreads_n, localThreads_n, true);
+                        run(2, globalThreads_n, localThreads_n, false);
     if(ok && !_descriptors.isUMat())
         descriptors.copyTo(_descriptors);
     return ok;
@@ -278,69 +271,12 @@ bool SURF_OCL::computeDescriptors(const UMat &keypoints, OutputArray _descriptor
 
 void SURF_OCL::uploadKeypoints(const std::vector<KeyPoint> &keypoints, UMat &keypointsGPU)
 {
-    if (keypoints.empty())
-        keypointsGPU.release();
-    else
-    {
-        Mat keypointsCPU(SURF_OCL::ROWS_COUNT, static_cast<int>(keypoints.size()), CV_32FC1);
-
-        float *kp_x = keypointsCPU.ptr<float>(SURF_OCL::X_ROW);
-        float *kp_y = keypointsCPU.ptr<float>(SURF_OCL::Y_ROW);
-        int *kp_laplacian = keypointsCPU.ptr<int>(SURF_OCL::LAPLACIAN_ROW);
-        int *kp_octave = keypointsCPU.ptr<int>(SURF_OCL::OCTAVE_ROW);
-        float *kp_size = keypointsCPU.ptr<float>(SURF_OCL::SIZE_ROW);
-        float *kp_dir = keypointsCPU.ptr<float>(SURF_OCL::ANGLE_ROW);
-        float *kp_hessian = keypointsCPU.ptr<float>(SURF_OCL::HESSIAN_ROW);
-
-        for (size_t i = 0, size = keypoints.size(); i < size; ++i)
-        {
-            const KeyPoint &kp = keypoints[i];
-            kp_x[i] = kp.pt.x;
-            kp_y[i] = kp.pt.y;
-            kp_octave[i] = kp.octave;
-            kp_size[i] = kp.size;
-            kp_dir[i] = kp.angle;
-            kp_hessian[i] = kp.response;
-            kp_laplacian[i] = 1;
-        }
-
-        keypointsCPU.copyTo(keypointsGPU);
-    }
+    SURF::uploadKeypoints(keypoints, keypointsGPU);
 }
 
 void SURF_OCL::downloadKeypoints(const UMat &keypointsGPU, std::vector<KeyPoint> &keypoints)
 {
-    const int nFeatures = keypointsGPU.cols;
-
-    if (nFeatures == 0)
-        keypoints.clear();
-    else
-    {
-        CV_Assert(keypointsGPU.type() == CV_32FC1 && keypointsGPU.rows == ROWS_COUNT);
-
-        Mat keypointsCPU = keypointsGPU.getMat(ACCESS_READ);
-        keypoints.resize(nFeatures);
-
-        float *kp_x = keypointsCPU.ptr<float>(SURF_OCL::X_ROW);
-        float *kp_y = keypointsCPU.ptr<float>(SURF_OCL::Y_ROW);
-        int *kp_laplacian = keypointsCPU.ptr<int>(SURF_OCL::LAPLACIAN_ROW);
-        int *kp_octave = keypointsCPU.ptr<int>(SURF_OCL::OCTAVE_ROW);
-        float *kp_size = keypointsCPU.ptr<float>(SURF_OCL::SIZE_ROW);
-        float *kp_dir = keypointsCPU.ptr<float>(SURF_OCL::ANGLE_ROW);
-        float *kp_hessian = keypointsCPU.ptr<float>(SURF_OCL::HESSIAN_ROW);
-
-        for (int i = 0; i < nFeatures; ++i)
-        {
-            KeyPoint &kp = keypoints[i];
-            kp.pt.x = kp_x[i];
-            kp.pt.y = kp_y[i];
-            kp.class_id = kp_laplacian[i];
-            kp.octave = kp_octave[i];
-            kp.size = kp_size[i];
-            kp.angle = kp_dir[i];
-            kp.response = kp_hessian[i];
-        }
-    }
+    SURF::downloadKeypoints(keypointsGPU, keypoints);
 }
 
 bool SURF_OCL::detect(InputArray _img, InputArray _mask, UMat& keypoints)
@@ -398,7 +334,7 @@ bool SURF_OCL::calcLayerDetAndTrace(int octave, int c_layer_rows)
                              ocl::KernelArg::WriteOnlyNoSize(det),
                              ocl::KernelArg::WriteOnlyNoSize(trace));
     }
-    return kerCalcDetTrace.run(2, globalThreads, localThreads, true);
+    return kerCalcDetTrace.run(2, globalThreads, localThreads, false);
 }
 
 bool SURF_OCL::findMaximaInLayer(int counterOffset, int octave,
@@ -423,13 +359,14 @@ bool SURF_OCL::findMaximaInLayer(int counterOffset, int octave,
                               octave, nOctaveLayers,
                               layer_rows, layer_cols,
                               maxCandidates,
-                              (float)params->hessianThreshold).run(2, globalThreads, localThreads, true);
+                              (float)params->hessianThreshold).run(2, globalThreads, localThreads, false);
 }
 
-bool SURF_OCL::interpolateKeypoint(int maxCounter, UMat &keypoints, int octave, int layer_rows, int max_features)
+bool SURF_OCL::interpolateKeypoint(int counterOffset, UMat &keypoints, int octave, int layer_rows, int max_features)
 {
+    // one work-group per possible candidate, those beyond the counter of the layer return at once
     size_t localThreads[3]  = {3, 3, 3};
-    size_t globalThreads[3] = {maxCounter*localThreads[0], localThreads[1], 3};
+    size_t globalThreads[3] = {maxCandidates*localThreads[0], localThreads[1], 3};
 
     ocl::Kernel kerInterp("SURF_interpolateKeypoint", ocl::xfeatures2d::surf_oclsrc, kerOpts);
 
@@ -437,8 +374,9 @@ bool SURF_OCL::interpolateKeypoint(int maxCounter, UMat &keypoints, int octave,
                    ocl::KernelArg::PtrReadOnly(maxPosBuffer),
                    ocl::KernelArg::ReadWriteNoSize(keypoints),
                    ocl::KernelArg::PtrReadWrite(counters),
-                   img_rows, img_cols, octave, layer_rows, max_features).
-        run(3, globalThreads, localThreads, true);
+                   img_rows, img_cols, octave, layer_rows, max_features,
+                   counterOffset, maxCandidates).
+        run(3, globalThreads, localThreads, false);
 }
 
 bool SURF_OCL::calcOrientation(UMat &keypoints)
@@ -458,7 +396,7 @@ bool SURF_OCL::calcOrientation(UMat &keypoints)
 
     size_t localThreads[3]  = {ORI_LOCAL_SIZE, 1};
     size_t globalThreads[3] = {nFeatures * localThreads[0], 1};
-    return kerOri.run(2, globalThreads, localThreads, true);
+    return kerOri.run(2, globalThreads, localThreads, false);
 }
 
 }
@@ -1286,3 +1286,261 @@ TEST( XFeatures2d_DescriptorExtractor, batch )
         EXPECT_GT(descriptors[i].rows, 100);
     }
 }
+
+TEST( Features2d_SIFT, thread_count_invariance )
+{
+    string path = string(cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    Mat img = imread(path, 0);
+    ASSERT_FALSE(img.empty());
+    Ptr<SIFT> sift = SIFT::create();
+
+    vector<KeyPoint> keypoints, keypoints_serial;
+    Mat descriptors, descriptors_serial;
+    sift->detectAndCompute(img, noArray(), keypoints, descriptors);
+
+    // the keypoints are gathered in the order of a serial scan
+    int threads = getNumThreads();
+    setNumThreads(1);
+    sift->detectAndCompute(img, noArray(), keypoints_serial, descriptors_serial);
+    setNumThreads(threads);
+
+    ASSERT_EQ(keypoints_serial.size(), keypoints.size());
+    for( size_t i = 0; i < keypoints.size(); i++ )
+    {
+        EXPECT_EQ(keypoints_serial[i].pt, keypoints[i].pt);
+        EXPECT_EQ(keypoints_serial[i].angle, keypoints[i].angle);
+        EXPECT_EQ(keypoints_serial[i].octave, keypoints[i].octave);
+    }
+    EXPECT_EQ(0, cvtest::norm(descriptors_serial, descriptors, NORM_INF));
+}
+
+TEST( Features2d_SIFT, fast_modes )
+{
+    string path = string(cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    Mat img = imread(path, 0);
+    ASSERT_FALSE(img.empty());
+
+    Ptr<SIFT> sift = SIFT::create();
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+    sift->detectAndCompute(img, noArray(), keypoints, descriptors);
+
+    Ptr<SIFT> fast = SIFT::create();
+    fast->setFixedPointPyramid(true);
+    EXPECT_TRUE(fast->getFixedPointPyramid());
+    vector<KeyPoint> keypoints_fast;
+    Mat descriptors_fast;
+    // twice, so that the second call reuses the pyramids of the first one
+    for( int i = 0; i < 2; i++ )
+        fast->detectAndCompute(img, noArray(), keypoints_fast, descriptors_fast);
+
+    // most of the fixed-point features have a floating-point twin
+    ASSERT_GT(keypoints_fast.size(), keypoints.size() / 2);
+    BFMatcher matcher(NORM_L2);
+    vector<DMatch> matches;
+    matcher.match(descriptors_fast, descriptors, matches);
+    int found = 0;
+    for( size_t i = 0; i < matches.size(); i++ )
+        if( norm(keypoints_fast[matches[i].queryIdx].pt - keypoints[matches[i].trainIdx].pt) < 2 )
+            found++;
+    EXPECT_GT(found, (int)matches.size() / 2);
+
+    // without the upsampled octave, no keypoint comes from the octave -1
+    fast->setUpsampleInput(false);
+    fast->detectAndCompute(img, noArray(), keypoints_fast, descriptors_fast);
+    ASSERT_FALSE(keypoints_fast.empty());
+    EXPECT_EQ((int)keypoints_fast.size(), descriptors_fast.rows);
+    for( size_t i = 0; i < keypoints_fast.size(); i++ )
+        EXPECT_EQ(0, (keypoints_fast[i].octave & 255) >> 7);
+}
+
+TEST( Features2d_BinaryDescriptors, thread_count_invariance )
+{
+    string path = string(cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    Mat img = imread(path);
+    ASSERT_FALSE(img.empty());
+    Mat gray;
+    cvtColor(img, gray, COLOR_BGR2GRAY);
+
+    vector<KeyPoint> detected;
+    FAST(gray, detected, 20);
+    ASSERT_GT(detected.size(), (size_t)1000);
+    // oriented keypoints, so that the rotated patterns are evaluated too
+    for( size_t i = 0; i < detected.size(); i++ )
+        detected[i].angle = (float)((i * 37) % 360);
+
+    vector<Ptr<DescriptorExtractor> > extractors;
+    vector<Mat> images;
+    extractors.push_back(BriefDescriptorExtractor::create(32, true)); images.push_back(gray);
+    extractors.push_back(FREAK::create());                            images.push_back(gray);
+    extractors.push_back(LATCH::create(32, true, 3));                 images.push_back(gray);
+    extractors.push_back(LATCH::create(8, true, 5));                  images.push_back(gray);
+    extractors.push_back(LUCID::create(1, 2));                        images.push_back(img);
+
+    int threads = getNumThreads();
+    for( size_t i = 0; i < extractors.size(); i++ )
+    {
+        vector<KeyPoint> keypoints = detected, keypoints_serial = detected;
+        Mat descriptors, descriptors_serial;
+        extractors[i]->compute(images[i], keypoints, descriptors);
+        setNumThreads(1);
+        extractors[i]->compute(images[i], keypoints_serial, descriptors_serial);
+        setNumThreads(threads);
+
+        ASSERT_EQ(keypoints_serial.size(), keypoints.size()) << "extractor " << i;
+        ASSERT_EQ((int)keypoints.size(), descriptors.rows) << "extractor " << i;
+        for( size_t j = 0; j < keypoints.size(); j++ )
+            EXPECT_EQ(keypoints_serial[j].angle, keypoints[j].angle) << "extractor " << i;
+        EXPECT_EQ(0, cvtest::norm(descriptors_serial, descriptors, NORM_INF)) << "extractor " << i;
+    }
+}
+
+TEST( Features2d_SURF, device_keypoints )
+{
+    string path = string(cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    Mat img = imread(path, 0);
+    ASSERT_FALSE(img.empty());
+    Ptr<SURF> surf = SURF::create();
+
+    vector<KeyPoint> keypoints;
+    Mat descriptors;
+    surf->detectAndCompute(img, noArray(), keypoints, descriptors);
+
+    UMat uimg, ukeypoints, udescriptors;
+    img.copyTo(uimg);
+    surf->detectAndCompute(uimg, noArray(), ukeypoints, udescriptors);
+    ASSERT_EQ(SURF::ROWS_COUNT, ukeypoints.rows);
+    ASSERT_EQ(ukeypoints.cols, udescriptors.rows);
+
+    vector<KeyPoint> keypoints_device;
+    SURF::downloadKeypoints(ukeypoints, keypoints_device);
+    ASSERT_GT(keypoints_device.size(), keypoints.size() * 9 / 10);
+
+    // the descriptors of the device keypoints are recomputed from the same buffer
+    UMat udescriptors2;
+    surf->detectAndCompute(uimg, noArray(), ukeypoints, udescriptors2, true);
+    EXPECT_LT(cvtest::norm(udescriptors, udescriptors2, NORM_INF), 1e-3);
+
+    // and matched against the host ones without downloading them
+    BFMatcher matcher(NORM_L2);
+    vector<DMatch> matches;
+    matcher.match(udescriptors, descriptors, matches);
+    int found = 0;
+    for( size_t i = 0; i < matches.size(); i++ )
+        if( norm(keypoints_device[matches[i].queryIdx].pt - keypoints[matches[i].trainIdx].pt) < 1 )
+            found++;
+    EXPECT_GT(found, (int)matches.size() * 9 / 10);
+
+    // upload and download keep the keypoints as they are
+    UMat ukeypoints2;
+    vector<KeyPoint> keypoints2;
+    SURF::uploadKeypoints(keypoints, ukeypoints2);
+    SURF::downloadKeypoints(ukeypoints2, keypoints2);
+    ASSERT_EQ(keypoints.size(), keypoints2.size());
+    for( size_t i = 0; i < keypoints.size(); i++ )
+    {
+        EXPECT_EQ(keypoints[i].pt, keypoints2[i].pt);
+        EXPECT_EQ(keypoints[i].class_id, keypoints2[i].class_id);
+        EXPECT_EQ(keypoints[i].octave, keypoints2[i].octave);
+    }
+}
+
+// gathers the band descriptors in the order of the dense ones
+struct DaisyBandsCollector : public DAISY::DenseCallback
+{
+    DaisyBandsCollector( Rect _roi ) : roi(_roi), next_row(_roi.y) {}
+
+    virtual void operator()( const Rect& band, const Mat& descriptors )
+    {
+        EXPECT_EQ(roi.x, band.x);
+        EXPECT_EQ(roi.width, band.width);
+        EXPECT_EQ(next_row, band.y);
+        EXPECT_EQ(band.width*band.height, descriptors.rows);
+        next_row = band.y + band.height;
+        all.push_back(descriptors);
+    }
+
+    Rect roi;
+    int next_row;
+    Mat all;
+};
+
+TEST( Features2d_DAISY, dense_bands )
+{
+    string path = string(cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    Mat img = imread(path, 0);
+    ASSERT_FALSE(img.empty());
+    resize(img, img, Size(160, 120));
+    Ptr<DAISY> daisy = DAISY::create();
+
+    Rect roi(10, 5, 130, 100);
+    Mat descriptors;
+    daisy->compute(img, roi, descriptors);
+    ASSERT_EQ(roi.area(), descriptors.rows);
+    double maxval = cvtest::norm(descriptors, NORM_INF);
+
+    // bands smaller than the margin of their layers
+    Mat descriptors_bands;
+    daisy->computeDense(img, roi, descriptors_bands, 7);
+    ASSERT_EQ(descriptors.size(), descriptors_bands.size());
+    EXPECT_LE(cvtest::norm(descriptors, descriptors_bands, NORM_INF), 1e-4 * maxval);
+
+    DaisyBandsCollector collector(roi);
+    daisy->computeDense(img, roi, collector, 32);
+    EXPECT_EQ(roi.y + roi.height, collector.next_row);
+    ASSERT_EQ(descriptors.size(), collector.all.size());
+    EXPECT_LE(cvtest::norm(descriptors, collector.all, NORM_INF), 1e-4 * maxval);
+}
+
+TEST( Features2d_StarDetector, thread_count_invariance )
+{
+    string path = string(cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    Mat img = imread(path, 0);
+    ASSERT_FALSE(img.empty());
+    Ptr<StarDetector> star = StarDetector::create();
+
+    vector<KeyPoint> keypoints, keypoints_serial;
+    star->detect(img, keypoints);
+
+    // the keypoints are gathered in the order of a serial scan
+    int threads = getNumThreads();
+    setNumThreads(1);
+    star->detect(img, keypoints_serial);
+    setNumThreads(threads);
+
+    ASSERT_FALSE(keypoints.empty());
+    ASSERT_EQ(keypoints_serial.size(), keypoints.size());
+    for( size_t i = 0; i < keypoints.size(); i++ )
+    {
+        EXPECT_EQ(keypoints_serial[i].pt, keypoints[i].pt);
+        EXPECT_EQ(keypoints_serial[i].size, keypoints[i].size);
+        EXPECT_EQ(keypoints_serial[i].response, keypoints[i].response);
+    }
+}
+
+TEST( Features2d_MSDDetector, thread_count_invariance )
+{
+    string path = string(cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    Mat img = imread(path, 0);
+    ASSERT_FALSE(img.empty());
+    resize(img, img, Size(), 0.5, 0.5, INTER_AREA);
+    Ptr<MSDDetector> msd = MSDDetector::create();
+
+    vector<KeyPoint> keypoints, keypoints_serial;
+    msd->detect(img, keypoints);
+
+    // the saliency of each band of rows doesn't depend on how the bands are spread over threads
+    int threads = getNumThreads();
+    setNumThreads(1);
+    msd->detect(img, keypoints_serial);
+    setNumThreads(threads);
+
+    ASSERT_FALSE(keypoints.empty());
+    ASSERT_EQ(keypoints_serial.size(), keypoints.size());
+    for( size_t i = 0; i < keypoints.size(); i++ )
+    {
+        EXPECT_EQ(keypoints_serial[i].pt, keypoints[i].pt);
+        EXPECT_EQ(keypoints_serial[i].size, keypoints[i].size);
+        EXPECT_EQ(keypoints_serial[i].response, keypoints[i].response);
+    }
+}
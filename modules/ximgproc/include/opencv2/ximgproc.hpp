@@ -74,6 +74,20 @@ namespace ximgproc
 //! @addtogroup ximgproc
 //! @{
 
+enum ThinningTypes{
+    THINNING_ZHANGSUEN    = 0, //!< Thinning technique of Zhang-Suen
+    THINNING_GUOHALL      = 1  //!< Thinning technique of Guo-Hall
+};
+
+/**
+* @brief Specifies the binarization method to use in cv::ximgproc::niBlackThreshold
+*/
+enum LocalBinarizationMethods{
+    BINARIZATION_NIBLACK = 0, //!< Classic Niblack binarization.
+    BINARIZATION_SAUVOLA = 1, //!< Sauvola's technique, Niblack's with the deviation normalized by its dynamic range.
+    BINARIZATION_WOLF    = 2  //!< Wolf's technique, Sauvola's normalized by the contrast and the minimum of the image.
+};
+
 /** @brief Applies Niblack thresholding to input image.
 
 The function transforms a grayscale image to a binary image according to the formulae:
@@ -81,10 +95,17 @@ The function transforms a grayscale image to a binary image according to the for
     \f[dst(x,y) =  \fork{\texttt{maxValue}}{if \(src(x,y) > T(x,y)\)}{0}{otherwise}\f]
 -   **THRESH_BINARY_INV**
     \f[dst(x,y) =  \fork{0}{if \(src(x,y) > T(x,y)\)}{\texttt{maxValue}}{otherwise}\f]
-where \f$T(x,y)\f$ is a threshold calculated individually for each pixel.
-
-The threshold value \f$T(x, y)\f$ is the mean minus \f$ delta \f$ times standard deviation
-of \f$\texttt{blockSize} \times\texttt{blockSize}\f$ neighborhood of \f$(x, y)\f$.
+where \f$T(x,y)\f$ is a threshold calculated individually for each pixel from the mean \f$m\f$ and the
+standard deviation \f$s\f$ of the \f$\texttt{blockSize} \times\texttt{blockSize}\f$ neighborhood of
+\f$(x, y)\f$:
+-   **BINARIZATION_NIBLACK**: \f$T = m + \texttt{delta} \cdot s\f$
+-   **BINARIZATION_SAUVOLA**: \f$T = m \cdot (1 + \texttt{delta} \cdot (s / r - 1))\f$
+-   **BINARIZATION_WOLF**: \f$T = m - \texttt{delta} \cdot (1 - s / R) \cdot (m - M)\f$, where \f$M\f$ is the
+    minimum of the image and \f$R\f$ the maximum of \f$s\f$ over the image.
+
+The means and standard deviations are computed from the integral images of the source with replicated
+borders, in a single row-parallel pass with the thresholding (two passes for BINARIZATION_WOLF, which
+needs \f$R\f$ first).
 
 The function can't process the image in-place.
 
@@ -95,23 +116,30 @@ used with the THRESH_BINARY and THRESH_BINARY_INV thresholding types.
 @param type Thresholding type, see cv::ThresholdTypes.
 @param blockSize Size of a pixel neighborhood that is used to calculate a threshold value
 for the pixel: 3, 5, 7, and so on.
-@param delta Constant multiplied with the standard deviation and subtracted from the mean.
-Normally, it is taken to be a real number between 0 and 1.
+@param delta Constant multiplied with the standard deviation term of the chosen binarization method.
+Normally, it is taken to be a real number between 0 and 1 (negative for BINARIZATION_NIBLACK on dark text).
+@param binarizationMethod Binarization method to use, see cv::ximgproc::LocalBinarizationMethods.
+@param r The dynamic range of the standard deviation used by BINARIZATION_SAUVOLA.
 
 @sa  threshold, adaptiveThreshold
  */
 CV_EXPORTS_W void niBlackThreshold( InputArray _src, OutputArray _dst,
                                     double maxValue, int type,
-                                    int blockSize, double delta );
+                                    int blockSize, double delta,
+                                    int binarizationMethod = BINARIZATION_NIBLACK,
+                                    double r = 128 );
 
 /** @brief Applies a binary blob thinning operation, to achieve a skeletization of the input image.
 
-The function transforms a binary blob image into a skeletized form using the technique of Zhang-Suen.
+The function transforms a binary blob image into a skeletized form using the technique of Zhang-Suen
+or Guo-Hall. The rows of each sub-iteration are processed in parallel, and only the rows next to the
+pixels removed by the two previous sub-iterations are visited again.
 
 @param src Source 8-bit single-channel image, containing binary blobs, with blobs having 255 pixel values.
 @param dst Destination image of the same size and the same type as src. The function can work in-place.
+@param thinningType Value that defines which thinning algorithm should be used. See cv::ximgproc::ThinningTypes
  */
-CV_EXPORTS_W void thinning( InputArray src, OutputArray dst);
+CV_EXPORTS_W void thinning( InputArray src, OutputArray dst, int thinningType = THINNING_ZHANGSUEN);
 
 
 //! @}
@@ -77,6 +77,30 @@ public:
     to src.depth().
      */
     CV_WRAP virtual void filter(InputArray src, OutputArray dst, int dDepth = -1) = 0;
+
+    /** @brief Produce domain transform filtering operation on several source images at once.
+
+    The channels of all the source images are filtered together, up to 4 of them in each pass over the
+    domain transform of the guide.
+
+    @param src vector of filtering images with unsigned 8-bit or floating-point 32-bit depth and any
+    number of channels.
+
+    @param dst vector of destination images.
+
+    @param dDepth optional depth of the output images. dDepth can be set to -1, which will be equivalent
+    to the depth of each source image.
+     */
+    CV_WRAP virtual void filterArrays(InputArrayOfArrays src, OutputArrayOfArrays dst, int dDepth = -1) = 0;
+
+    /** @brief Replaces the guided image keeping the filter parameters, e.g. with the next frame of a video.
+
+    When the new guided image has the same size as the previous one, its transformed distances and the
+    filtering workspace reuse the previous buffers, so that no memory is allocated for the next frames.
+
+    @param guide new guided image.
+     */
+    CV_WRAP virtual void setGuide(InputArray guide) = 0;
 };
 
 /** @brief Factory method, create instance of DTFilter and produce initialization routines.
@@ -153,9 +177,17 @@ channels then only first 3 channels will be used.
 @param eps regularization term of Guided Filter. \f${eps}^2\f$ is similar to the sigma in the color
 space into bilateralFilter.
 
+@param scale subsampling factor of the fast Guided Filter. If it is greater than 1, the filter
+coefficients are computed on the guide and the filtering image subsampled by scale, with a radius
+divided by scale, and then upsampled to be applied to the full resolution guide. This is much faster
+on large images, for a small loss of accuracy.
+
 For more details about Guided Filter parameters, see the original article @cite Kaiming10 .
+
+Buffers are kept between the calls of GuidedFilter::filter on images of the same size, so an
+instance shouldn't be used from several threads at once.
  */
-CV_EXPORTS_W Ptr<GuidedFilter> createGuidedFilter(InputArray guide, int radius, double eps);
+CV_EXPORTS_W Ptr<GuidedFilter> createGuidedFilter(InputArray guide, int radius, double eps, int scale = 1);
 
 /** @brief Simple one-line Guided Filter call.
 
@@ -176,8 +208,10 @@ space into bilateralFilter.
 
 @param dDepth optional depth of the output image.
 
+@param scale subsampling factor of the fast Guided Filter, see createGuidedFilter.
+
 @sa bilateralFilter, dtFilter, amFilter */
-CV_EXPORTS_W void guidedFilter(InputArray guide, InputArray src, OutputArray dst, int radius, double eps, int dDepth = -1);
+CV_EXPORTS_W void guidedFilter(InputArray guide, InputArray src, OutputArray dst, int radius, double eps, int dDepth = -1, int scale = 1);
 
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
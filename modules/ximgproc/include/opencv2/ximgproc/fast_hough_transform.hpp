@@ -137,6 +137,25 @@ CV_EXPORTS void FastHoughTransform( InputArray  src,
                                     int         op = FHT_ADD,
                                     int         makeSkew = HDO_DESKEW );
 
+/**
+* @brief   Calculates 2D Fast Hough transforms of several images.
+* @param   src         The source (input) images.
+* @param   dst         The destination images, results of transformation.
+* @param   dstMatDepth The depth of destination images
+* @param   op          The operation to be applied, see cv::HoughOp
+* @param   angleRange  The part of Hough space to calculate, see cv::AngleRangeOption
+* @param   makeSkew    Specifies to do or not to do image skewing, see cv::HoughDeskewOption
+*
+* The function gives the same results as FastHoughTransform applied to each image.
+* The images of the same size share the index tables of their transforms.
+*/
+CV_EXPORTS void FastHoughTransformBatch( InputArrayOfArrays  src,
+                                         OutputArrayOfArrays dst,
+                                         int                 dstMatDepth,
+                                         int                 angleRange = ARO_315_135,
+                                         int                 op = FHT_ADD,
+                                         int                 makeSkew = HDO_DESKEW );
+
 /**
 * @brief   Calculates coordinates of line segment corresponded by point in Hough space.
 * @param   houghPoint  Point in Hough space.
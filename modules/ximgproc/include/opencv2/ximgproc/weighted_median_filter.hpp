@@ -84,10 +84,12 @@ enum WMFWeightType
 * @param   weightType  weightType The type of weight definition, see WMFWeightType
 * @param   mask        A 0-1 mask that has the same size with I. This mask is used to ignore the effect of some pixels. If the pixel value on mask is 0,
 *                           the pixel will be ignored when maintaining the joint-histogram. This is useful for applications like optical flow occlusion handling.
+* @param   featureLevels Number of levels the joint image is quantized to, at most 256. Fewer levels make the joint-histogram smaller
+*                           and the filtering faster, at the cost of coarser weights, e.g. for the interactive refinement of disparity maps.
 *
 * @sa medianBlur, jointBilateralFilter
 */
-CV_EXPORTS void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int r, double sigma=25.5, WMFWeightType weightType=WMF_EXP, Mat mask=Mat());
+CV_EXPORTS void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int r, double sigma=25.5, WMFWeightType weightType=WMF_EXP, Mat mask=Mat(), int featureLevels=256);
 }
 }
 
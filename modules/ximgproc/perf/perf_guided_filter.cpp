@@ -78,4 +78,30 @@ PERF_TEST_P( GuidedFilterPerfTest, perf, Combine(GuideTypes::all(), SrcTypes::al
     SANITY_CHECK_NOTHING();
 }
 
+typedef tuple<GuideTypes, int, Size> GFFastParams;
+typedef TestBaseWithParam<GFFastParams> GuidedFilterFastPerfTest;
+
+PERF_TEST_P( GuidedFilterFastPerfTest, perf, Combine(Values(CV_8UC1, CV_8UC3), Values(1, 2, 4), Values(sz1080p, Size(3840, 2160))) )
+{
+    GFFastParams params = GetParam();
+    int type    = get<0>(params);
+    int scale   = get<1>(params);
+    Size sz     = get<2>(params);
+
+    Mat guide(sz, type);
+    Mat src(sz, type);
+    Mat dst(sz, type);
+
+    declare.in(guide, src, WARMUP_RNG).out(dst).tbb_threads(cv::getNumberOfCPUs());
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    Ptr<GuidedFilter> gf = createGuidedFilter(guide, 16, 1e3, scale);
+    TEST_CYCLE_N(3)
+    {
+        gf->filter(src, dst);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }
@@ -38,7 +38,9 @@
 //M*/
 
 #include "precomp.hpp"
+#include "joint_bilateral_filter.hpp"
 #include <opencv2/ximgproc.hpp>
+#include <cstring>
 #include <vector>
 
 namespace cv
@@ -47,8 +49,6 @@ namespace ximgproc
 {
   void compute_mRTV(const Mat& L, Mat& mRTV, int fr);
   void compute_G(const Mat& B, const Mat& mRTV, Mat& G, Mat& alpha, int fr);
-  void joint_bilateral_filter(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg);
-  void joint_bilateral_filter3(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg);
 
   void bilateralTextureFilter(InputArray src_, OutputArray dst_, int fr,
                               int numIter, double sigmaAlpha, double sigmaAvg)
@@ -113,12 +113,10 @@ namespace ximgproc
         Gtildei[i] = Gi[i].mul(alpha) + Bi[i].mul(alphainv);
       merge(&Gtildei[0], B.channels(), Gtilde);
 
-      // joint bilateral filter
+      // joint bilateral filter: square kernel of radius and spatial sigma 2*fr, range weights on the
+      // squared L2 distance of the guide
       cv::Mat J;
-      if (I.channels() == 1)
-        joint_bilateral_filter(I, Gtilde, J, fr * 2, sigmaAvg);
-      else if (I.channels() == 3)
-        joint_bilateral_filter3(I, Gtilde, J, fr * 2, sigmaAvg);
+      JointBilateralFilterBackend(I, fr * 2, sigmaAvg, fr * 2, BORDER_REFLECT, true, false).filter(Gtilde, J);
       I = J;
     }
     if (src.type() == CV_8UC1) {
@@ -211,146 +209,63 @@ namespace ximgproc
       mRTV = mRTV / 3;
   }
 
-  void compute_G(const Mat& B, const Mat& mRTV, Mat& G, Mat& alpha, int fr)
+  // For every pixel, the blurred value at the smallest mRTV of its window, the first one met in the
+  // row-major order of the offsets. The rows are independent of each other.
+  class ComputeGInvoker : public ParallelLoopBody
   {
-    B.copyTo(G);
-    alpha = Mat::ones(B.size(), CV_32FC1);
-    for (int y = -fr; y <= fr; y++)
+  public:
+    ComputeGInvoker(const Mat& B_, const Mat& mRTV_, Mat& G_, Mat& alpha_, int fr_)
+      : B(B_), mRTV(mRTV_), G(G_), alpha(alpha_), fr(fr_)
+    {
+    }
+
+    void operator () (const Range& range) const
     {
-      for (int x = -fr; x <= fr; x++)
+      size_t elemSize = B.elemSize();
+      for (int py = range.start; py < range.end; py++)
       {
-        Point pb;
-        Point pt;
-        for (pb.y = 0; pb.y < B.rows; pb.y++)
+        float* alphaRow = alpha.ptr<float>(py);
+        uchar* GRow = G.ptr(py);
+        for (int px = 0; px < B.cols; px++)
         {
-          for (pb.x = 0; pb.x < B.cols; pb.x++)
+          float minAlpha = 1.f;
+          int bestY = py, bestX = px;
+          for (int y = -fr; y <= fr; y++)
           {
-            pt.x = min(max(pb.x + x, 0), B.cols - 1);
-            pt.y = min(max(pb.y + y, 0), B.rows - 1);
-            if (alpha.at<float>(pb) > mRTV.at<float>(pt))
+            int ty = std::min(std::max(py + y, 0), B.rows - 1);
+            const float* mRTVRow = mRTV.ptr<float>(ty);
+            for (int x = -fr; x <= fr; x++)
             {
-              alpha.at<float>(pb) = mRTV.at<float>(pt);
-              if (B.channels() == 3)
-                G.at<Vec3f>(pb) = B.at<Vec3f>(pt);
-              else if (B.channels() == 1)
-                G.at<float>(pb) = B.at<float>(pt);
+              int tx = std::min(std::max(px + x, 0), B.cols - 1);
+              if (minAlpha > mRTVRow[tx])
+              {
+                minAlpha = mRTVRow[tx];
+                bestY = ty;
+                bestX = tx;
+              }
             }
           }
+          alphaRow[px] = minAlpha;
+          memcpy(GRow + px * elemSize, B.ptr(bestY) + bestX * elemSize, elemSize);
         }
       }
     }
-  }
 
-  void joint_bilateral_filter(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg)
-  {
-    Mat p_G;
-    copyMakeBorder(G, p_G, fr2, fr2, fr2, fr2, BORDER_REFLECT);
+  private:
+    const Mat& B;
+    const Mat& mRTV;
+    Mat& G;
+    Mat& alpha;
+    int fr;
 
-    Mat p_img;
-    copyMakeBorder(img, p_img, fr2, fr2, fr2, fr2, BORDER_REFLECT);
+    ComputeGInvoker& operator=(const ComputeGInvoker&); // to quiet MSVC
+  };
 
-    Mat SW;
-    if (SW.empty()) {
-      SW = Mat(2*fr2+1, 2*fr2+1, CV_32FC1);
-      int r, c;
-      float y, x;
-      for (r = 0, y = (float)-fr2; r < SW.rows; r++, y += 1.0) {
-        for(c = 0, x = (float)-fr2; c < SW.cols; c++, x += 1.0) {
-          SW.at<float>(r,c) = exp(-(x*x + y*y) / (2*fr2*fr2));
-        }
-      }
-    }
-
-    r_img = Mat::zeros(img.size(), CV_32FC1);
-    {
-      Mat sum_d_W = Mat::zeros(img.size(), CV_32FC1);
-      Mat d_W = Mat::zeros(G.size(), CV_32FC1);
-
-      for (int x = -fr2; x <= fr2; x++) {
-        for (int y = -fr2; y <= fr2; y++) {
-          d_W = p_G(Rect(fr2+x, fr2+y, img.cols, img.rows)) - G;
-          multiply(d_W, d_W, d_W);
-          exp(-0.5 * d_W / (sigma_avg*sigma_avg), d_W);
-
-          d_W = d_W * SW.at<float>(fr2+y, fr2+x); //Gaussian weight
-
-          sum_d_W = sum_d_W + d_W;
-          multiply(d_W, p_img(Rect(fr2+x, fr2+y, img.cols, img.rows)), d_W);
-          r_img = r_img + d_W;
-        }
-      }
-      max(1e-5f, sum_d_W, sum_d_W);
-      divide(r_img, sum_d_W, r_img);
-    }
-  }
-
-  void joint_bilateral_filter3(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg)
+  void compute_G(const Mat& B, const Mat& mRTV, Mat& G, Mat& alpha, int fr)
   {
-    Mat p_G;
-    copyMakeBorder(G, p_G, fr2, fr2, fr2, fr2, BORDER_REFLECT);
-
-    Mat p_img;
-    copyMakeBorder(img, p_img, fr2, fr2, fr2, fr2, BORDER_REFLECT);
-
-    Mat SW;
-    if (SW.empty()) {
-      SW = Mat(2*fr2+1, 2*fr2+1, CV_32FC1);
-      int r, c;
-      float y, x;
-      for (r = 0, y = (float)-fr2; r < SW.rows; r++, y += 1.0) {
-        for(c = 0, x = (float)-fr2; c < SW.cols; c++, x += 1.0) {
-          SW.at<float>(r,c) = exp(-(x*x + y*y) / (2*fr2*fr2));
-        }
-      }
-    }
-
-    std::vector<Mat> G_channels(3);
-    split(G, G_channels);
-    std::vector<Mat> p_G_channels(3);
-    split(p_G, p_G_channels);
-    std::vector<Mat> p_img_channels(3);
-    split(p_img, p_img_channels);
-
-    Mat sum_d_W = Mat::zeros(img.size(), CV_32FC1);
-    std::vector<Mat> d_W_channels(3);
-    for (int ch = 0; ch < 3; ch++) {
-      d_W_channels[ch] = Mat::zeros(G.size(), CV_32FC1);
-    }
-    Mat d_W = Mat::zeros(G.size(), CV_32FC1);
-
-    std::vector<Mat> r_img_channels(3);
-    for (int ch = 0; ch < 3; ch++) {
-      r_img_channels[ch] = Mat::zeros(G.size(), CV_32FC1);
-    }
-
-    for (int x = -fr2; x <= fr2; x++) {
-      for (int y = -fr2; y <= fr2; y++) {
-        d_W.setTo(0);
-        for (int ch = 0; ch < 3; ch++) {
-          subtract(p_G_channels[ch](Rect(fr2+x, fr2+y, img.cols, img.rows)), G_channels[ch], d_W_channels[ch]);
-          multiply(d_W_channels[ch], d_W_channels[ch], d_W_channels[ch]);
-        }
-        for (int ch = 0; ch < 3; ch++) {
-          add(d_W, d_W_channels[ch], d_W);
-        }
-        exp(-0.5 * d_W / (sigma_avg*sigma_avg), d_W);
-
-        d_W = d_W * SW.at<float>(fr2+y, fr2+x); //Gaussian weight
-
-        add(sum_d_W, d_W, sum_d_W);
-
-        for (int ch = 0; ch < 3; ch++) {
-          Mat n_p_img = p_img_channels[ch](Rect(fr2+x, fr2+y, img.cols, img.rows));
-          accumulateProduct(d_W, n_p_img, r_img_channels[ch]);
-        }
-      }
-    }
-
-    max(1e-5f, sum_d_W, sum_d_W);
-    for (int ch = 0; ch < 3; ch++) {
-      divide(r_img_channels[ch], sum_d_W, r_img_channels[ch]);
-    }
-    merge(r_img_channels, r_img);
+    G.create(B.size(), B.type());
+    alpha.create(B.size(), CV_32FC1);
+    parallel_for_(Range(0, B.rows), ComputeGInvoker(B, mRTV, G, alpha, fr));
   }
 
 }
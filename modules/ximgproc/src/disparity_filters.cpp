@@ -250,12 +250,23 @@ void DisparityWLSFilterImpl::filter(InputArray disparity_map_left, InputArray le
         disp = Mat(disp_full_size,ROI);
         src  = Mat(src_full_size ,ROI);
         filtered_disparity_map.create(disp_full_size.size(), disp_full_size.type());
-        Mat& dst_full_size = filtered_disparity_map.getMatRef();
+        Mat dst_full_size = filtered_disparity_map.getMat();
         dst_full_size = Scalar(16*(min_disp-1));
         dst = Mat(dst_full_size,ROI);
-        Mat filtered_disp;
-        fastGlobalSmootherFilter(src,disp,filtered_disp,lambda,sigma_color);
-        filtered_disp.copyTo(dst);
+        if(filtered_disparity_map.isUMat())
+        {
+            // the solver runs on the OpenCL device when there is one
+            UMat disp_ocl,filtered_disp;
+            disp.copyTo(disp_ocl);
+            fastGlobalSmootherFilter(src,disp_ocl,filtered_disp,lambda,sigma_color);
+            filtered_disp.copyTo(dst);
+        }
+        else
+        {
+            Mat filtered_disp;
+            fastGlobalSmootherFilter(src,disp,filtered_disp,lambda,sigma_color);
+            filtered_disp.copyTo(dst);
+        }
     }
     else
     {
@@ -280,7 +291,7 @@ void DisparityWLSFilterImpl::filter(InputArray disparity_map_left, InputArray le
         disp = Mat(disp_full_size,ROI);
         src  = Mat(src_full_size ,ROI);
         filtered_disparity_map.create(disp_full_size.size(), disp_full_size.type());
-        Mat& dst_full_size = filtered_disparity_map.getMatRef();
+        Mat dst_full_size = filtered_disparity_map.getMat();
         dst_full_size = Scalar(16*(min_disp-1));
         dst = Mat(dst_full_size,ROI);
         Mat conf(confidence_map,ROI);
@@ -288,12 +299,27 @@ void DisparityWLSFilterImpl::filter(InputArray disparity_map_left, InputArray le
         Mat disp_mul_conf;
         disp.convertTo(disp_mul_conf,CV_32F);
         disp_mul_conf = conf.mul(disp_mul_conf);
-        Mat conf_filtered;
         Ptr<FastGlobalSmootherFilter> wls = createFastGlobalSmootherFilter(src,lambda,sigma_color);
-        wls->filter(disp_mul_conf,disp_mul_conf);
-        wls->filter(conf,conf_filtered);
-        disp_mul_conf = disp_mul_conf.mul(1/(conf_filtered+EPS));
-        disp_mul_conf.convertTo(dst,CV_16S);
+        if(filtered_disparity_map.isUMat())
+        {
+            // both solves share the weights sent to the OpenCL device by the first one
+            UMat disp_mul_conf_ocl,conf_ocl,conf_filtered;
+            disp_mul_conf.copyTo(disp_mul_conf_ocl);
+            conf.copyTo(conf_ocl);
+            wls->filter(disp_mul_conf_ocl,disp_mul_conf_ocl);
+            wls->filter(conf_ocl,conf_filtered);
+            add(conf_filtered,Scalar::all(EPS),conf_filtered);
+            divide(disp_mul_conf_ocl,conf_filtered,disp_mul_conf_ocl);
+            disp_mul_conf_ocl.convertTo(dst,CV_16S);
+        }
+        else
+        {
+            Mat conf_filtered;
+            wls->filter(disp_mul_conf,disp_mul_conf);
+            wls->filter(conf,conf_filtered);
+            disp_mul_conf = disp_mul_conf.mul(1/(conf_filtered+EPS));
+            disp_mul_conf.convertTo(dst,CV_16S);
+        }
     }
 }
 
@@ -160,6 +160,63 @@ void DTFilterCPU::filter(InputArray src_, OutputArray dst_, int dDepth)
     }
 }
 
+void DTFilterCPU::filterArrays(InputArrayOfArrays src_, OutputArrayOfArrays dst_, int dDepth)
+{
+    std::vector<Mat> src;
+    src_.getMatVector(src);
+    CV_Assert(!src.empty());
+
+    //the channels of all the sources at the working depth
+    std::vector<Mat> channels;
+    std::vector<int> firstChannel(src.size() + 1, 0);
+    for (size_t i = 0; i < src.size(); i++)
+    {
+        CV_Assert(src[i].depth() == CV_8U || src[i].depth() == CV_32F);
+        if (src[i].cols != w || src[i].rows != h)
+            CV_Error(Error::StsBadSize, "Size of filtering image must be equal to size of guide image");
+
+        std::vector<Mat> cn;
+        split(src[i], cn);
+        for (size_t c = 0; c < cn.size(); c++)
+        {
+            channels.push_back(Mat());
+            cn[c].convertTo(channels.back(), CV_32F);
+        }
+        firstChannel[i + 1] = (int)channels.size();
+    }
+
+    //up to four channels are filtered in one pass over the domain transform
+    std::vector<Mat> filtered(channels.size());
+    for (int c = 0; c < (int)channels.size(); c += 4)
+    {
+        int n = std::min(4, (int)channels.size() - c);
+        Mat group, groupRes;
+        merge(&channels[c], n, group);
+        filter(group, groupRes, CV_32F);
+        split(groupRes, &filtered[c]);
+    }
+
+    dst_.create((int)src.size(), 1, CV_32F);
+    for (int i = 0; i < (int)src.size(); i++)
+    {
+        int depth = (dDepth == -1) ? src[i].depth() : dDepth;
+        int cn = firstChannel[i + 1] - firstChannel[i];
+        dst_.create(h, w, CV_MAKETYPE(depth, cn), i);
+        Mat dst = dst_.getMat(i);
+
+        Mat res;
+        merge(&filtered[firstChannel[i]], cn, res);
+        res.convertTo(dst, depth);
+    }
+}
+
+void DTFilterCPU::setGuide(InputArray guide)
+{
+    CV_Assert(mode != -1);
+    init(guide, sigmaSpatial, sigmaColor, mode, numIters);
+    numFilterCalls = 0;
+}
+
 void DTFilterCPU::setSingleFilterCall(bool value)
 {
     singleFilterCall = value;
@@ -180,6 +237,12 @@ void DTFilterCPU::release()
 
     adistHor.release();
     adistVert.release();
+
+    guideT.release();
+    workRes.release();
+    workResT.release();
+    workIsrc.release();
+    workIsrcT.release();
 }
 
 Mat DTFilterCPU::getWExtendedMat(int h, int w, int type, int brdleft /*= 0*/, int brdRight /*= 0*/, int cacheAlign /*= 0*/)
@@ -61,6 +61,10 @@ public: /*Non-template methods*/
 
     void filter(InputArray src, OutputArray dst, int dDepth = -1);
 
+    void filterArrays(InputArrayOfArrays src, OutputArrayOfArrays dst, int dDepth = -1);
+
+    void setGuide(InputArray guide);
+
     void setSingleFilterCall(bool value);
 
 public: /*Template methods*/
@@ -103,6 +107,11 @@ public: /*Members declarations*/
     Mat adistHor, adistVert;
     int numIters;
 
+    /*workspace kept between the calls on images of the same size*/
+    Mat guideT;
+    Mat workRes, workResT;
+    Mat workIsrc, workIsrcT;
+
 protected: /*Functions declarations*/
 
     DTFilterCPU() : mode(-1), singleFilterCall(false), numFilterCalls(0) {}
@@ -147,10 +156,10 @@ protected: /*Wrappers for parallelization*/
     template <typename WorkVec>
     struct FilterIC_horPass : public ParallelLoopBody
     {
-        Mat &src, &idist, &dist, &dst, isrcBuf;
+        Mat &src, &idist, &dist, &dst, &isrcBuf;
         float radius;
 
-        FilterIC_horPass(Mat& src_, Mat& idist_, Mat& dist_, Mat& dst_);
+        FilterIC_horPass(Mat& src_, Mat& idist_, Mat& dist_, Mat& dst_, Mat& isrcBuf_);
         void operator() (const Range& range) const;
     };
 
@@ -235,7 +244,7 @@ protected: /*Auxiliary implementation functions*/
     static Range getWorkRangeByThread(int items, const Range& rangeThread, int maxThreads = 0);
 
     template<typename SrcVec>
-    static void prepareSrcImg_IC(const Mat& src, Mat& inner, Mat& outer);
+    static void prepareSrcImg_IC(const Mat& src, Mat& inner, Mat& innerT, Mat& outer, Mat& outerT);
 
     static Mat getWExtendedMat(int h, int w, int type, int brdleft = 0, int brdRight = 0, int cacheAlign = 0);
 
@@ -71,7 +71,9 @@ void DTFilterCPU::init_(Mat& guide, double sigmaSpatial_, double sigmaColor_, in
 {
     CV_Assert(guide.type() == cv::DataType<GuideVec>::type);
 
-    this->release();
+    //the buffers of the previous guide are reused when only its content changes
+    if (mode_ != mode || guide.rows != h || guide.cols != w)
+        this->release();
 
     h = guide.rows;
     w = guide.cols;
@@ -89,7 +91,7 @@ void DTFilterCPU::init_(Mat& guide, double sigmaSpatial_, double sigmaColor_, in
             parallel_for_(horBody.getRange(), horBody);
         }
         {
-            Mat guideT = guide.t();
+            transpose(guide, guideT);
             ComputeIDTHor_ParBody<GuideVec> horBody(*this, guideT, idistVert);
             parallel_for_(horBody.getRange(), horBody);
         }
@@ -101,7 +103,7 @@ void DTFilterCPU::init_(Mat& guide, double sigmaSpatial_, double sigmaColor_, in
             parallel_for_(horBody.getRange(), horBody);
         }
         {
-            Mat guideT = guide.t();
+            transpose(guide, guideT);
             ComputeDTandIDTHor_ParBody<GuideVec> horBody(*this, guideT, distVert, idistVert);
             parallel_for_(horBody.getRange(), horBody);
         }
@@ -145,10 +147,16 @@ void DTFilterCPU::filter_(const Mat& src, Mat& dst, int dDepth)
         dst.create(h, w, WorkVec::type);
         res = dst;
     }
+    else if (mode == DTF_NC || mode == DTF_RF)
+    {
+        workRes.create(h, w, WorkVec::type);
+        res = workRes;
+    }
 
     if (mode == DTF_NC)
     {
-        Mat resT(src.cols, src.rows, WorkVec::type);
+        workResT.create(src.cols, src.rows, WorkVec::type);
+        Mat& resT = workResT;
         src.convertTo(res, WorkVec::type);
 
         FilterNC_horPass<WorkVec> horParBody(res, idistHor, resT);
@@ -165,10 +173,10 @@ void DTFilterCPU::filter_(const Mat& src, Mat& dst, int dDepth)
     else if (mode == DTF_IC)
     {
         Mat resT;
-        prepareSrcImg_IC<WorkVec>(src, res, resT);
+        prepareSrcImg_IC<WorkVec>(src, res, resT, workRes, workResT);
 
-        FilterIC_horPass<WorkVec> horParBody(res, idistHor, distHor, resT);
-        FilterIC_horPass<WorkVec> vertParBody(resT, idistVert, distVert, res);
+        FilterIC_horPass<WorkVec> horParBody(res, idistHor, distHor, resT, workIsrc);
+        FilterIC_horPass<WorkVec> vertParBody(resT, idistVert, distVert, res, workIsrcT);
 
         for (int iter = 1; iter <= numIters; iter++)
         {
@@ -235,10 +243,10 @@ void DTFilterCPU::integrateSparseRow(const SrcVec *src, const float *dist, SrcWo
 }
 
 template<typename WorkVec>
-void DTFilterCPU::prepareSrcImg_IC(const Mat& src, Mat& dst, Mat& dstT)
+void DTFilterCPU::prepareSrcImg_IC(const Mat& src, Mat& dst, Mat& dstT, Mat& dstOut, Mat& dstOutT)
 {
-    Mat dstOut(src.rows, src.cols + 2, WorkVec::type);
-    Mat dstOutT(src.cols, src.rows + 2, WorkVec::type);
+    dstOut.create(src.rows, src.cols + 2, WorkVec::type);
+    dstOutT.create(src.cols, src.rows + 2, WorkVec::type);
 
     dst = dstOut(Range::all(), Range(1, src.cols+1));
     dstT = dstOutT(Range::all(), Range(1, src.rows+1));
@@ -321,8 +329,8 @@ void DTFilterCPU::FilterNC_horPass<WorkVec>::operator()(const Range& range) cons
 }
 
 template <typename WorkVec>
-DTFilterCPU::FilterIC_horPass<WorkVec>::FilterIC_horPass(Mat& src_, Mat& idist_, Mat& dist_, Mat& dst_)
-: src(src_), idist(idist_), dist(dist_), dst(dst_), radius(1.0f)
+DTFilterCPU::FilterIC_horPass<WorkVec>::FilterIC_horPass(Mat& src_, Mat& idist_, Mat& dist_, Mat& dst_, Mat& isrcBuf_)
+: src(src_), idist(idist_), dist(dist_), dst(dst_), isrcBuf(isrcBuf_), radius(1.0f)
 {
     CV_DbgAssert(src.type() == WorkVec::type && dst.type() == WorkVec::type && dst.rows == src.cols && dst.cols == src.rows);
 
@@ -497,8 +505,11 @@ template <typename GuideVec>
 DTFilterCPU::ComputeDTandIDTHor_ParBody<GuideVec>::ComputeDTandIDTHor_ParBody(DTFilterCPU& dtf_, Mat& guide_, Mat& dist_, Mat& idist_)
 : dtf(dtf_), guide(guide_), dist(dist_), idist(idist_)
 {
-    dist = getWExtendedMat(guide.rows, guide.cols, IDistVec::type, 1, 1);
-    idist = getWExtendedMat(guide.rows, guide.cols + 1, IDistVec::type);
+    //both are views into wider buffers, only reallocated when the guide size changes
+    if (dist.rows != guide.rows || dist.cols != guide.cols || dist.type() != IDistVec::type)
+        dist = getWExtendedMat(guide.rows, guide.cols, IDistVec::type, 1, 1);
+    if (idist.rows != guide.rows || idist.cols != guide.cols + 1 || idist.type() != IDistVec::type)
+        idist = getWExtendedMat(guide.rows, guide.cols + 1, IDistVec::type);
     maxRadius = dtf.getIterRadius(1);
 }
 
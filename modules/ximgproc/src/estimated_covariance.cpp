@@ -46,6 +46,9 @@ Algorithmic details of this algorithm can be found at:
 A previous and less efficient version of the algorithm can be found:
  * O. Green, L. David, A. Galperin, Y. Birk, "Efficient parallel computation of the estimated covariance matrix", arXiv, 2013
 
+As in these papers, the elements of the matrix which multiply the pixels of the same shift between two window
+positions are computed together. Here, the sums over the window positions of such a shift are box sums read from
+the integral image of the product of the image and its shifted copy.
 
 */
 
@@ -58,290 +61,75 @@ using namespace std;
 namespace cv{
 namespace ximgproc{
 
-class EstimateCovariance{
-
-public:
-    EstimateCovariance(int pr_, int pc_);
-    ~EstimateCovariance();
-
-    void computeEstimateCovariance(Mat inputData,Mat outputData);
-    int combinationCount();
-
-private:
-    typedef struct {
-        int mult1r;
-        int mult1c;
-        int mult2r;
-        int mult2c;
-        int type2; // 0 - for the first P*P. 1 - for the next (P-1)(P-1)
-        int id;
-    } Combination;
-
-    void initInternalDataStructures();
-    void buildCombinationsTable();
-
-    void iterateCombinations(Mat inputData,Mat outputData);
-    void computeOneCombination(int comb_id, Mat inputData , Mat outputData,
-        Mat outputVector,std::vector<int> finalMatPosR, std::vector<int> finalMatPosC);
-
-    inline void complexSubtract(std::complex<float>& src, std::complex<float>& dst){dst-=src;}
-    inline void complexAdd(std::complex<float>& src, std::complex<float>& dst){dst+=src;}
-    inline void complexConjMulAndAdd(std::complex<float>& a, std::complex<float>& b,
-            std::complex<float>& dst){dst += a*b;}
-    inline void complexConjMul(std::complex<float>& a, std::complex<float>& b,
-            std::complex<float>& dst){dst = a*b;}
-
-private:
-    int nr;
-    int nc;
-    int pr;
-    int pc;
-
-    std::vector<Combination> combinationsTable;
-};
-
-
-
-EstimateCovariance::EstimateCovariance(int pr_, int pc_){
-    pr=pr_; pc=pc_;
-}
-
-EstimateCovariance::~EstimateCovariance(){
-
-}
-
-void EstimateCovariance::initInternalDataStructures(){
-    int combCount = combinationCount();
-    combinationsTable.resize(combCount);
-    buildCombinationsTable();
-}
-
-int EstimateCovariance::combinationCount(){
-    return  (pr*pc+(pr-1)*(pc-1));
-}
-
-void EstimateCovariance::buildCombinationsTable()
-{
-    int idx_row,idx_col;
-    int comb_idx = 0;
-    Combination comb;
-
-    // The first element of the product is [0,0] and the second is to down and to the right of it.
-    for (idx_col=0; idx_col<pc; ++idx_col)  {
-        for (idx_row=0; idx_row<pr; ++idx_row)      {
-            comb.mult1r=0;
-            comb.mult1c=0;
-            comb.mult2r=idx_row;
-            comb.mult2c=idx_col;
-            comb.type2 = 0;
-            comb.id = comb_idx;
-            memcpy(&combinationsTable[comb_idx++], &comb, sizeof(Combination));
-        }
-    }
-
-    // The first element is on the top right, and the second element is to the left and down of it.
-    for (idx_row=1; idx_row<pr; ++idx_row)  {
-        for (idx_col=1; idx_col<pc; ++idx_col)      {
-            comb.mult1r=idx_row;
-            comb.mult1c=0;
-            comb.mult2r=0;
-            comb.mult2c=idx_col;
-
-            comb.type2 = 1;
-            comb.id = comb_idx;
-            memcpy(&combinationsTable[comb_idx++], &comb, sizeof(Combination));
-        }
-    }
-}
-
-void EstimateCovariance::computeEstimateCovariance(Mat inputData,Mat outputData){
-    initInternalDataStructures();
-    nr=inputData.rows;
-    nc=inputData.cols;
-
-    iterateCombinations(inputData,outputData);
-}
-
-
-void EstimateCovariance::iterateCombinations(Mat inputData,Mat outputData)
-{
-    Mat outputVector(pr*pc,1,  DataType<std::complex<float> >::type);
-
-    std::vector<int> finalMatPosR(pr*pc,0);
-    std::vector<int> finalMatPosC(pr*pc,0);
-    int combs=combinationCount();
-    for (int idx=0; idx<combs; idx++){
-        outputVector.setTo(Scalar(0,0));
-        for (unsigned x=0; x<finalMatPosR.size(); x++)
-            finalMatPosR[x]=0;
-        for (unsigned x=0; x<finalMatPosC.size(); x++)
-            finalMatPosC[x]=0;
-        computeOneCombination(idx++, inputData, outputData,
-                outputVector,finalMatPosR, finalMatPosC);
-    }
-}
-
-void EstimateCovariance::computeOneCombination(int comb_id,Mat inputData, Mat outputData,
-            Mat outputVector,std::vector<int> finalMatPosR, std::vector<int> finalMatPosC)
+/*
+ * The element (a, b) of the estimated covariance matrix, a = ra + windowRows*ca being the index of the pixel
+ * (ra, ca) of the window, is the sum over all the window positions (i, j) of I(i+ra, j+ca)*I(i+rb, j+cb).
+ * For a shift (dr, dc) = (rb-ra, cb-ca), it is the box sum at (ra, ca) of the product image
+ * P(y, x) = I(y, x)*I(y+dr, x+dc), of the size of the window positions. One shift gives all the elements of
+ * the matrix between the pixels of the window at this shift, and the symmetric ones.
+ */
+class EstimateCovarianceInvoker : public ParallelLoopBody
 {
-    Combination* comb = &combinationsTable[comb_id];
-    int type2 = comb->type2;
-    int deltaR = (int)abs((int)(comb->mult1r-comb->mult2r));
-    int deltaC = (int)abs((int)(comb->mult1c-comb->mult2c));
-    int numElementsInBlock = pr-abs(deltaR);
-    int numBlocks = pc-deltaC;
-    const int DR= nr-pr;
-    const int DC= nc-pc;
-
-    int elementC=0;
-    std::complex<float> temp_res = std::complex<float>(0,0);
-    int i,j,r,c;
-
-    if (!type2) {
-        // Computing the first index of the combination.
-        // This index is made up
-        for(i=0; i<=( DR); i++) {
-            int iPdr=i+deltaR;
-            for(j=0; j<= (DC); j++) {
-                int jPdc = j+deltaC;
-                complexConjMulAndAdd(inputData.at<std::complex<float> >(i,j), inputData.at<std::complex<float> >(iPdr,jPdc), temp_res);
-            }
-        }
-    }else{
-        // Computing the first index of the combination.
-        for(i=0; i<=( DR); i++) {
-            int iPdr=i+deltaR;
-            for(j=0; j<= (DC); j++) {
-                int jPdc = j+deltaC;
-                complexConjMulAndAdd(inputData.at<std::complex<float> >(iPdr,j), inputData.at<std::complex<float> >(i,jPdc), temp_res);
-            }
-        }
-    }
-    outputVector.at<std::complex<float> >(0,0) = temp_res;
-
-    // Checking if the first element belongs to the first set of combinatons.
-    // The combination that the first element is above the second.
-    if (!type2) {
-        finalMatPosR[0]=0;
-        finalMatPosC[0]=pr*deltaC+deltaR;
-        elementC++;
-    }else{
-        finalMatPosR[0]=deltaR;
-        finalMatPosC[0]=pr*deltaC;
-        elementC++;
+public:
+    EstimateCovarianceInvoker(const Mat& _input, int _pr, int _pc, Mat& _output)
+        : input(_input), pr(_pr), pc(_pc), output(_output)
+    {
     }
 
-    for(r=1;r<(pr-deltaR);r++){
-        std::complex<float> newRowSum = std::complex<float>(0,0),oldRowSum = std::complex<float>(0,0);
-        std::complex<float> addRows  = std::complex<float>(0,0);
-
-        int rM1 = r-1;
-        int k = DR+1 + rM1;
-        int kPdr = k+deltaR;
-        int rM1Pdr = rM1 + deltaR;
-        int cPdc;
-
-        if (!type2) {
-            for(c=0;c<=(DC); c++){
-                cPdc = c+deltaC;
-                complexConjMulAndAdd(inputData.at<std::complex<float> >(k,c),inputData.at<std::complex<float> >(kPdr,cPdc),newRowSum);
-                complexConjMulAndAdd(inputData.at<std::complex<float> >(rM1,c),inputData.at<std::complex<float> >(rM1Pdr,cPdc),oldRowSum);
+    // the shifts with dc > 0, or dc == 0 and dr >= 0, the other ones give the symmetric elements
+    static int shiftCount(int pr, int pc) { return pc*(2*pr - 1) - (pr - 1); }
+
+    void operator()(const Range& range) const
+    {
+        const int DR = input.rows - pr, DC = input.cols - pc;
+        // the buffers are reused by the shifts of the range
+        Mat product, sums;
+
+        for (int s = range.start; s < range.end; s++)
+        {
+            int dr, dc;
+            if (s < pr)
+            {
+                dr = s;
+                dc = 0;
             }
-        }else{
-            for(c=0;c<=(DC); c++){
-                cPdc = c+deltaC;
-                complexConjMulAndAdd(inputData.at<std::complex<float> >(kPdr,c),inputData.at<std::complex<float> >(k,cPdc),newRowSum);
-                complexConjMulAndAdd(inputData.at<std::complex<float> >(rM1Pdr,c),inputData.at<std::complex<float> >(rM1,cPdc),oldRowSum);
+            else
+            {
+                dr = (s - pr) % (2*pr - 1) - (pr - 1);
+                dc = (s - pr) / (2*pr - 1) + 1;
             }
-        }
-        complexAdd(newRowSum,addRows);
-        complexSubtract(oldRowSum,addRows);
-        complexAdd(outputVector.at<std::complex<float> >(rM1,0),outputVector.at<std::complex<float> >(r,0));
-        complexAdd(addRows,outputVector.at<std::complex<float> >(r,0));
-
-        finalMatPosR[elementC]=finalMatPosR[elementC-1]+1;;
-        finalMatPosC[elementC]=finalMatPosC[elementC-1]+1;
-        elementC++;
-    }
 
-    for(c=1; c<numBlocks; c++)  {
-        std::complex<float> newColSum = std::complex<float>(0,0),oldColSum = std::complex<float>(0,0);
-        std::complex<float> addCols  = std::complex<float>(0,0);
-
-        // Index arithmetic
-        int cM1 = c-1;
-        int dcPc = DC+c;
-        int q = DC+1 + cM1;
-        int cM1PdeltaC = cM1 + deltaC;
-        int dcPcPdeltaC = dcPc+deltaC;
-
-        if (!type2) {
-            for(r=0;r<=(DR); r++){
-                int rPdr = r+deltaR;
-                complexConjMulAndAdd(inputData.at<std::complex<float> >(r,q),inputData.at<std::complex<float> >(rPdr,q+deltaC),newColSum);
-                complexConjMulAndAdd(inputData.at<std::complex<float> >(r,cM1),inputData.at<std::complex<float> >(rPdr,cM1+deltaC),oldColSum);
-            }
-        }else{
-            for(r=0;r<=(DR); r++){
-                int rPdr = r+deltaR;
-                complexConjMulAndAdd(inputData.at<std::complex<float> >(rPdr,q),inputData.at<std::complex<float> >(r,q+deltaC),newColSum);
-                complexConjMulAndAdd(inputData.at<std::complex<float> >(rPdr,cM1),inputData.at<std::complex<float> >(r,cM1+deltaC),oldColSum);
-            }
-        }
-        complexAdd(newColSum,addCols);
-        complexSubtract(oldColSum,addCols);
-        complexAdd(outputVector.at<std::complex<float> >((c-1)*numElementsInBlock,0),outputVector.at<std::complex<float> >(c*numElementsInBlock,0));
-        complexAdd(addCols,outputVector.at<std::complex<float> >(c*numElementsInBlock,0));
-
-        finalMatPosR[elementC]=finalMatPosR[elementC-numElementsInBlock]+pr;
-        finalMatPosC[elementC]=finalMatPosC[elementC-numElementsInBlock]+pr;
-        elementC++;
-
-        for(r=1; r<numElementsInBlock; r++) {
-            std::complex<float> w = std::complex<float>(0,0),x = std::complex<float>(0,0),
-                y = std::complex<float>(0,0),z = std::complex<float>(0,0),deltaRowSum = std::complex<float>(0,0);
-            std::complex<float> tempRes = std::complex<float>(0,0);
-            // Index arithmetic
-            int rM1 = r-1;
-            int drPr = DR+r;
-            int rM1PdeltaR = rM1 + deltaR;
-            int drPrPdeltaR = drPr+deltaR;
-
-            if (!type2) {
-                complexConjMul(inputData.at<std::complex<float> >(rM1,cM1),inputData.at<std::complex<float> >(rM1PdeltaR,cM1PdeltaC),w);
-                complexConjMul(inputData.at<std::complex<float> >(rM1,dcPc),inputData.at<std::complex<float> >(rM1PdeltaR,dcPcPdeltaC),x);
-                complexConjMul(inputData.at<std::complex<float> >(drPr,cM1),inputData.at<std::complex<float> >(drPrPdeltaR,cM1PdeltaC),y);
-                complexConjMul(inputData.at<std::complex<float> >(drPr,dcPc),inputData.at<std::complex<float> >(drPrPdeltaR,dcPcPdeltaC),z);
-            }else{
-                complexConjMul(inputData.at<std::complex<float> >(rM1PdeltaR,cM1),inputData.at<std::complex<float> >(rM1,cM1PdeltaC),w);
-                complexConjMul(inputData.at<std::complex<float> >(rM1PdeltaR,dcPc),inputData.at<std::complex<float> >(rM1,dcPcPdeltaC),x);
-                complexConjMul(inputData.at<std::complex<float> >(drPrPdeltaR,cM1),inputData.at<std::complex<float> >(drPr,cM1PdeltaC),y);
-                complexConjMul(inputData.at<std::complex<float> >(drPrPdeltaR,dcPc),inputData.at<std::complex<float> >(drPr,dcPcPdeltaC),z);
+            // the first pixels of the pairs are the rows y0..nr-1-max(dr,0) and the columns 0..nc-1-dc
+            int y0 = std::max(-dr, 0);
+            int h = input.rows - std::abs(dr), w = input.cols - dc;
+            mulSpectrums(input(Rect(0, y0, w, h)), input(Rect(dc, y0 + dr, w, h)), product, 0);
+            integral(product, sums, CV_64F);
+
+            for (int ca = 0; ca < pc - dc; ca++)
+            {
+                for (int ra = y0; ra < pr - std::max(dr, 0); ra++)
+                {
+                    int y = ra - y0;
+                    const Vec2d* top = sums.ptr<Vec2d>(y) + ca;
+                    const Vec2d* bottom = sums.ptr<Vec2d>(y + DR + 1) + ca;
+                    Vec2d sum = bottom[DC + 1] - bottom[0] - top[DC + 1] + top[0];
+
+                    int a = ra + pr*ca, b = ra + dr + pr*(ca + dc);
+                    Vec2f value((float)sum[0], (float)sum[1]);
+                    output.at<Vec2f>(a, b) = value;
+                    output.at<Vec2f>(b, a) = value;
+                }
             }
-            complexAdd(w,tempRes);
-            complexSubtract(x,tempRes);
-            complexSubtract(y,tempRes);
-            complexAdd(z,tempRes);
-
-            complexAdd(outputVector.at<std::complex<float> >((c-1)*numElementsInBlock + r,0),deltaRowSum);
-            complexSubtract(outputVector.at<std::complex<float> >((c-1)*numElementsInBlock+ rM1,0),deltaRowSum);
-
-            complexAdd(deltaRowSum,tempRes);
-            complexAdd(outputVector.at<std::complex<float> >(c*numElementsInBlock+rM1,0),tempRes);
-            complexAdd(tempRes,outputVector.at<std::complex<float> >(c*numElementsInBlock+r,0));
-
-            finalMatPosR[elementC]=finalMatPosR[elementC-1]+1;
-            finalMatPosC[elementC]=finalMatPosC[elementC-1]+1;
-            elementC++;
         }
     }
 
-    for(i=0; i<numElementsInBlock*numBlocks; i++){
-        outputData.at<std::complex<float> >(finalMatPosR[i],finalMatPosC[i])=outputVector.at<std::complex<float> >(i,0);
-    }
-}
-
+private:
+    const Mat& input;
+    int pr, pc;
+    Mat& output;
 
+    EstimateCovarianceInvoker& operator=(const EstimateCovarianceInvoker&); // to quiet MSVC
+};
 
 void covarianceEstimation(InputArray input_, OutputArray output_,int windowRows, int windowCols){
 
@@ -350,8 +138,9 @@ void covarianceEstimation(InputArray input_, OutputArray output_,int windowRows,
     Mat input;
 
     Mat temp=input_.getMat();
+    CV_Assert( 0 < windowRows && windowRows <= temp.rows && 0 < windowCols && windowCols <= temp.cols );
     if(temp.channels() == 1){
-        temp.convertTo(temp,CV_32FC2);
+        temp.convertTo(temp,CV_32F);
         Mat zmat = Mat::zeros(temp.size(), CV_32F);
         Mat twoChannelsbefore[] = {temp,zmat};
         cv::merge(twoChannelsbefore,2,input);
@@ -360,15 +149,13 @@ void covarianceEstimation(InputArray input_, OutputArray output_,int windowRows,
 
     }
 
-    EstimateCovariance estCov(windowRows,windowCols);
-
-    //input_.getMat().convertTo(input, CV_32FC2);
-
     output_.create(windowRows*windowCols,windowRows*windowCols,  DataType<std::complex<float> >::type);
 
     Mat output = output_.getMat();
 
-    estCov.computeEstimateCovariance(input,output);
+    // the shifts write distinct elements of the matrix
+    parallel_for_(Range(0, EstimateCovarianceInvoker::shiftCount(windowRows, windowCols)),
+                  EstimateCovarianceInvoker(input, windowRows, windowCols, output));
 }
 
 } // namespace ximgproc
@@ -42,6 +42,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv { namespace ximgproc {
 
@@ -49,39 +50,149 @@ namespace cv { namespace ximgproc {
     typedef __int32 int32_t;
 #endif
 
+// Vectorized part of the binary operations, returns the number of processed elements
+template<typename T, HoughOp Op>
+struct HoughVecOperator {
+    static int operate(T *, const T *, const T *, int) { return 0; }
+};
+#if CV_SIMD128
+#define SPECIALIZE_HOUGHVECOP(T, VT, TOp, expr)                               \
+    template<>                                                                \
+    struct HoughVecOperator<T, TOp> {                                         \
+        static int operate(T *pDst, const T *pSrc0, const T *pSrc1, int len) {\
+            const int nlanes = (int)(16 / sizeof(T));                         \
+            int i = 0;                                                        \
+            for (; i <= len - nlanes; i += nlanes) {                          \
+                VT a = v_load(pSrc0 + i), b = v_load(pSrc1 + i);              \
+                v_store(pDst + i, expr);                                      \
+            }                                                                 \
+            return i;                                                         \
+        }                                                                     \
+    };
+#define SPECIALIZE_HOUGHVECOPS(T, VT)                                         \
+    SPECIALIZE_HOUGHVECOP(T, VT, FHT_ADD, a + b)                              \
+    SPECIALIZE_HOUGHVECOP(T, VT, FHT_MIN, v_min(a, b))                        \
+    SPECIALIZE_HOUGHVECOP(T, VT, FHT_MAX, v_max(a, b))
+// the additions of 8-bit and 16-bit lanes saturate, as add() does
+SPECIALIZE_HOUGHVECOPS(uchar, v_uint8x16)
+SPECIALIZE_HOUGHVECOPS(schar, v_int8x16)
+SPECIALIZE_HOUGHVECOPS(ushort, v_uint16x8)
+SPECIALIZE_HOUGHVECOPS(short, v_int16x8)
+SPECIALIZE_HOUGHVECOPS(int, v_int32x4)
+SPECIALIZE_HOUGHVECOPS(float, v_float32x4)
+#if CV_SIMD128_64F
+SPECIALIZE_HOUGHVECOPS(double, v_float64x2)
+#endif
+#undef SPECIALIZE_HOUGHVECOPS
+#undef SPECIALIZE_HOUGHVECOP
+#endif
+
 template<typename T, int D, HoughOp Op>
 struct HoughOperator { };
 #define SPECIALIZE_HOUGHOP(TOp, body)                                         \
     template<typename T, int D>                                               \
     struct HoughOperator<T, D, TOp> {                                         \
         static void operate(T *pDst, T *pSrc0, T* pSrc1, int len) {           \
-            Mat dst (Size(1, len), D, pDst);                                  \
-            Mat src0(Size(1, len), D, pSrc0);                                 \
-            Mat src1(Size(1, len), D, pSrc1);                                 \
-            body;                                                             \
+            int i = HoughVecOperator<T, TOp>::operate(pDst, pSrc0, pSrc1, len);\
+            for (; i < len; i++)                                              \
+                pDst[i] = body;                                               \
         }                                                                     \
     };
-SPECIALIZE_HOUGHOP(FHT_ADD, add(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MIN, min(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MAX, max(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_AVE, addWeighted(src0, 0.5, src1, 0.5, 0.0, dst));
+SPECIALIZE_HOUGHOP(FHT_ADD, saturate_cast<T>(pSrc0[i] + pSrc1[i]));
+SPECIALIZE_HOUGHOP(FHT_MIN, std::min(pSrc0[i], pSrc1[i]));
+SPECIALIZE_HOUGHOP(FHT_MAX, std::max(pSrc0[i], pSrc1[i]));
 #undef SPECIALIZE_HOUGHOP
+// keeps the rounding of addWeighted
+template<typename T, int D>
+struct HoughOperator<T, D, FHT_AVE> {
+    static void operate(T *pDst, T *pSrc0, T* pSrc1, int len) {
+        Mat dst (Size(1, len), D, pDst);
+        Mat src0(Size(1, len), D, pSrc0);
+        Mat src1(Size(1, len), D, pSrc1);
+        addWeighted(src0, 0.5, src1, 0.5, 0.0, dst);
+    }
+};
 
 //----------------------fht----------------------------------------------------
 
+// A range of rows merged at a level of the transform, from the two halves
+// computed at the level below
+struct FHTNode
+{
+    int32_t y0;
+    int32_t h;
+    int     level;
+};
+
+// The nodes of the transform of images with a given number of rows, by depth.
+// The rows of the nodes of a depth don't overlap, so they are computed in
+// parallel once the depth below is done.
+struct FHTPlan
+{
+    int rows;
+    int depths;
+    std::vector<FHTNode> nodes;
+    std::vector<int> nodeOfRow; //[depth * rows + y] node covering y, or -1
+
+    explicit FHTPlan(int rows_) : rows(rows_)
+    {
+        int level = 0;
+        for (int thres = 1; rows > thres; thres <<= 1)
+            level++;
+        depths = level + 1;
+        nodeOfRow.assign(depths * rows, -1);
+        addNode(0, rows, level, 0);
+    }
+
+private:
+    void addNode(int32_t y0, int32_t h, int level, int depth)
+    {
+        if (level <= 0)
+            return;
+
+        CV_Assert(h > 0);
+        FHTNode node = { y0, h, level };
+        nodes.push_back(node);
+        std::fill(&nodeOfRow[depth * rows + y0],
+                  &nodeOfRow[depth * rows + y0] + h, (int)nodes.size() - 1);
+        if (h == 1)
+            return;
+
+        const int32_t k = h >> 1;
+        addNode(y0, k, level - 1, depth + 1);
+        addNode(y0 + k, h - k, level - 1, depth + 1);
+    }
+};
+
+// The plans shared by the transforms of several images
+class FHTPlans
+{
+public:
+    const FHTPlan &get(int rows)
+    {
+        std::map<int, FHTPlan>::iterator it = plans.find(rows);
+        if (it == plans.end())
+            it = plans.insert(std::make_pair(rows, FHTPlan(rows))).first;
+        return it->second;
+    }
+
+private:
+    std::map<int, FHTPlan> plans;
+};
+
+// Computes the row s of a node in img0, from the rows of its halves in img1
 template <typename T, int D, HoughOp OP>
-void fhtCore(Mat     &img0,
-             Mat     &img1,
-             int32_t  y0,
-             int32_t  h,
-             bool     isPositiveShift,
-             int      level,
-             double   aspl)
+void fhtRow(Mat           &img0,
+            Mat           &img1,
+            const FHTNode &node,
+            int32_t        s,
+            bool           isPositiveShift,
+            double         aspl)
 {
-    if (level <= 0)
-        return;
+    const int32_t y0 = node.y0;
+    const int32_t h = node.h;
+    const int level = node.level;
 
-    CV_Assert(h > 0);
     if (h == 1)
     {
         if ((aspl != 0.0) && (level == 1))
@@ -105,10 +216,6 @@ void fhtCore(Mat     &img0,
         return;
     }
     const int32_t k = h >> 1;
-    fhtCore<T, D, OP>(img1, img0, y0, k,
-                      isPositiveShift, level - 1, aspl);
-    fhtCore<T, D, OP>(img1, img0, y0 + k, h - k,
-                      isPositiveShift, level - 1, aspl);
 
     int au = 2 * k - 2;
     int ad = 2 * h - 2 * k - 2;
@@ -117,7 +224,6 @@ void fhtCore(Mat     &img0,
     int w = img0.cols;
     int wm = (h / w + 1) * w;
 
-    for (int32_t s = 0; s < h; s++)
     {
         int su = (s * au + b) / d;
         int sd = (s * ad + b) / d;
@@ -203,39 +309,79 @@ void fhtCore(Mat     &img0,
     }
 }
 
+// Computes the rows of the nodes of a depth
+template <typename T, int D, HoughOp OP>
+class FHTDepthInvoker : public ParallelLoopBody
+{
+public:
+    FHTDepthInvoker(Mat &_img0, Mat &_img1, const FHTPlan &_plan, int _depth,
+                    bool _isPositiveShift, double _aspl)
+        : img0(_img0), img1(_img1), plan(_plan), depth(_depth),
+          isPositiveShift(_isPositiveShift), aspl(_aspl) { }
+
+    void operator()(const Range &range) const
+    {
+        const int *nodeOfRow = &plan.nodeOfRow[depth * plan.rows];
+        for (int y = range.start; y < range.end; y++)
+        {
+            if (nodeOfRow[y] < 0)
+                continue;
+            const FHTNode &node = plan.nodes[nodeOfRow[y]];
+            fhtRow<T, D, OP>(img0, img1, node, y - node.y0, isPositiveShift, aspl);
+        }
+    }
+
+private:
+    Mat &img0;
+    Mat &img1;
+    const FHTPlan &plan;
+    int depth;
+    bool isPositiveShift;
+    double aspl;
+
+    FHTDepthInvoker& operator=(const FHTDepthInvoker&); // to quiet MSVC
+};
+
 template <typename T, int D, HoughOp Op>
-void fhtVoT(Mat    &img0,
-            Mat    &img1,
-            bool    isPositiveShift,
-            double  aspl)
+void fhtVoT(Mat           &img0,
+            Mat           &img1,
+            bool           isPositiveShift,
+            double         aspl,
+            const FHTPlan &plan)
 {
-    int level = 0;
-    for (int thres = 1; img0.rows > thres; thres <<= 1)
-        level++;
+    CV_Assert(plan.rows == img0.rows);
 
-    fhtCore<T, D, Op>(img0, img1, 0, img0.rows, isPositiveShift, level, aspl);
+    // bottom-up, the nodes of even depths write to img0 and the others to img1
+    for (int depth = plan.depths - 1; depth >= 0; depth--)
+    {
+        Mat &dst = (depth & 1) ? img1 : img0;
+        Mat &src = (depth & 1) ? img0 : img1;
+        parallel_for_(Range(0, plan.rows),
+                      FHTDepthInvoker<T, D, Op>(dst, src, plan, depth, isPositiveShift, aspl));
+    }
 }
 
 template <typename T, int D>
-void fhtVo(Mat    &img0,
-           Mat    &img1,
-           bool    isPositiveShift,
-           int     operation,
-           double  aspl)
+void fhtVo(Mat           &img0,
+           Mat           &img1,
+           bool           isPositiveShift,
+           int            operation,
+           double         aspl,
+           const FHTPlan &plan)
 {
     switch (operation)
     {
     case FHT_ADD:
-        fhtVoT<T, D, FHT_ADD>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, D, FHT_ADD>(img0, img1, isPositiveShift, aspl, plan);
         break;
     case FHT_AVE:
-        fhtVoT<T, D, FHT_AVE>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, D, FHT_AVE>(img0, img1, isPositiveShift, aspl, plan);
         break;
     case FHT_MAX:
-        fhtVoT<T, D, FHT_MAX>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, D, FHT_MAX>(img0, img1, isPositiveShift, aspl, plan);
         break;
     case FHT_MIN:
-        fhtVoT<T, D, FHT_MIN>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, D, FHT_MIN>(img0, img1, isPositiveShift, aspl, plan);
         break;
     default:
         CV_Error_(CV_StsNotImplemented, ("Unknown operation %d", operation));
@@ -243,35 +389,36 @@ void fhtVo(Mat    &img0,
     }
 }
 
-static void fhtVo(Mat    &img0,
-                  Mat    &img1,
-                  bool    isPositiveShift,
-                  int     operation,
-                  double  aspl)
+static void fhtVo(Mat           &img0,
+                  Mat           &img1,
+                  bool           isPositiveShift,
+                  int            operation,
+                  double         aspl,
+                  const FHTPlan &plan)
 {
     int const depth = img0.depth();
     switch (depth)
     {
     case CV_8U:
-        fhtVo<uchar, CV_8UC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<uchar, CV_8UC1>(img0, img1, isPositiveShift, operation, aspl, plan);
         break;
     case CV_8S:
-        fhtVo<schar, CV_8SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<schar, CV_8SC1>(img0, img1, isPositiveShift, operation, aspl, plan);
         break;
     case CV_16U:
-        fhtVo<ushort, CV_16UC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<ushort, CV_16UC1>(img0, img1, isPositiveShift, operation, aspl, plan);
         break;
     case CV_16S:
-        fhtVo<short, CV_16SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<short, CV_16SC1>(img0, img1, isPositiveShift, operation, aspl, plan);
         break;
     case CV_32S:
-        fhtVo<int, CV_32SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<int, CV_32SC1>(img0, img1, isPositiveShift, operation, aspl, plan);
         break;
     case CV_32F:
-        fhtVo<float, CV_32FC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<float, CV_32FC1>(img0, img1, isPositiveShift, operation, aspl, plan);
         break;
     case CV_64F:
-        fhtVo<double, CV_64FC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<double, CV_64FC1>(img0, img1, isPositiveShift, operation, aspl, plan);
         break;
     default:
         CV_Error_(CV_StsNotImplemented, ("Unknown depth %d", depth));
@@ -279,12 +426,13 @@ static void fhtVo(Mat    &img0,
     }
 }
 
-static void FHT(Mat       &dst,
-                const Mat &src,
-                int        operation,
-                bool       isVertical,
-                bool       isClockwise,
-                double     aspl)
+static void FHT(Mat           &dst,
+                const Mat     &src,
+                int            operation,
+                bool           isVertical,
+                bool           isClockwise,
+                double         aspl,
+                const FHTPlan &plan)
 {
     CV_Assert(dst.cols > 0 && dst.rows > 0);
     CV_Assert(src.channels() == dst.channels());
@@ -293,10 +441,6 @@ static void FHT(Mat       &dst,
     else
         CV_Assert(src.cols == dst.rows && src.rows == dst.cols);
 
-    int level = 0;
-    for (int thres = 1; dst.rows > thres; thres <<= 1)
-        level++;
-
     Mat tmp;
     src.convertTo(tmp, dst.type());
     if (!isVertical)
@@ -305,13 +449,14 @@ static void FHT(Mat       &dst,
 
     fhtVo(dst, tmp,
           isVertical ? isClockwise : !isClockwise,
-          operation, aspl);
+          operation, aspl, plan);
 }
 
 static void calculateFHTQuadrant(Mat       &dst,
                                  const Mat &src,
                                  int        operation,
-                                 int        quadrant)
+                                 int        quadrant,
+                                 FHTPlans  &plans)
 {
     bool bVert = true;
     bool bClock = true;
@@ -348,13 +493,14 @@ static void calculateFHTQuadrant(Mat       &dst,
         CV_Error_(CV_StsNotImplemented, ("Unknown quadrant %d", quadrant));
     }
 
-  FHT(dst, src, operation, bVert, bClock, aspl);
+  FHT(dst, src, operation, bVert, bClock, aspl, plans.get(dst.rows));
 }
 
 static void createDstFhtMat(OutputArray dst,
-                            InputArray  src,
+                            const Mat  &src,
                             int         depth,
-                            int         angleRange)
+                            int         angleRange,
+                            int         i = -1)
 {
     int const rows = src.size().height;
     int const cols = src.size().width;
@@ -388,7 +534,7 @@ static void createDstFhtMat(OutputArray dst,
         CV_Error_(CV_StsNotImplemented, ("Unknown angleRange %d", angleRange));
     }
 
-    dst.create(ht, wd, CV_MAKETYPE(depth, channels));
+    dst.create(ht, wd, CV_MAKETYPE(depth, channels), i);
 }
 
 static void createFHTSrc(Mat       &srcFull,
@@ -545,20 +691,22 @@ static void skewQuadrant(Mat         &quad,
     }
 }
 
-void FastHoughTransform(InputArray  src,
-                        OutputArray dst,
-                        int         dstMatDepth,
-                        int         angleRange,
-                        int         operation,
-                        int         makeSkew)
+static void fastHoughTransform(const Mat  &src,
+                               OutputArray dst,
+                               int         dstMatDepth,
+                               int         angleRange,
+                               int         operation,
+                               int         makeSkew,
+                               FHTPlans   &plans,
+                               int         i = -1)
 {
-    Mat srcMat = src.getMat();
+    Mat srcMat = src;
     if (!srcMat.isContinuous())
         srcMat = srcMat.clone();
     CV_Assert(srcMat.cols > 0 && srcMat.rows > 0);
 
-    createDstFhtMat(dst, src, dstMatDepth, angleRange);
-    Mat dstMat = dst.getMat();
+    createDstFhtMat(dst, srcMat, dstMatDepth, angleRange, i);
+    Mat dstMat = dst.getMat(i);
 
     Mat imgRegDst;
     const int len = dstMat.cols * static_cast<int>(dstMat.elemSize());
@@ -573,13 +721,13 @@ void FastHoughTransform(InputArray  src,
             createFHTSrc(imgSrc, srcMat, ARO_315_45);
 
             setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
+            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0, plans);
             flip(imgRegDst, imgRegDst, 0);
             if (HDO_DESKEW == makeSkew)
                 skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
 
             setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
+            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45, plans);
             if (HDO_DESKEW == makeSkew)
                 skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
         }
@@ -588,13 +736,13 @@ void FastHoughTransform(InputArray  src,
             createFHTSrc(imgSrc, srcMat, ARO_45_135);
 
             setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
+            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90, plans);
             flip(imgRegDst, imgRegDst, 0);
             if (HDO_DESKEW == makeSkew)
                 skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
 
             setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
+            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135, plans);
             if (HDO_DESKEW == makeSkew)
                 skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
         }
@@ -607,59 +755,59 @@ void FastHoughTransform(InputArray  src,
     switch (angleRange)
     {
     case ARO_315_0:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
+        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange, plans);
         flip(dstMat, dstMat, 0);
         if (HDO_DESKEW == makeSkew)
             skewQuadrant(dstMat, imgSrc, buf, angleRange);
         return;
     case ARO_0_45:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
+        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange, plans);
         if (HDO_DESKEW == makeSkew)
             skewQuadrant(dstMat, imgSrc, buf, angleRange);
         return;
     case ARO_45_90:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
+        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange, plans);
         flip(dstMat, dstMat, 0);
         if (HDO_DESKEW == makeSkew)
             skewQuadrant(dstMat, imgSrc, buf, angleRange);
         return;
     case ARO_90_135:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
+        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange, plans);
         if (HDO_DESKEW == makeSkew)
             skewQuadrant(dstMat, imgSrc, buf, angleRange);
         return;
     case ARO_315_45:
         setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
+        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0, plans);
         flip(imgRegDst, imgRegDst, 0);
         if (HDO_DESKEW == makeSkew)
             skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
 
         setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
+        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45, plans);
         if (HDO_DESKEW == makeSkew)
             skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
         return;
     case ARO_45_135:
         setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
+        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90, plans);
         flip(imgRegDst, imgRegDst, 0);
         if (HDO_DESKEW == makeSkew)
             skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
 
         setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
+        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135, plans);
         if (HDO_DESKEW == makeSkew)
             skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
         return;
     case ARO_CTR_VER:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
+        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange, plans);
         flip(dstMat, dstMat, 0);
         if (HDO_DESKEW == makeSkew)
             skewQuadrant(dstMat, imgSrc, buf, angleRange);
         return;
     case ARO_CTR_HOR:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
+        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange, plans);
         if (HDO_DESKEW == makeSkew)
             skewQuadrant(dstMat, imgSrc, buf, angleRange);
         return;
@@ -668,6 +816,36 @@ void FastHoughTransform(InputArray  src,
     }
 }
 
+void FastHoughTransform(InputArray  src,
+                        OutputArray dst,
+                        int         dstMatDepth,
+                        int         angleRange,
+                        int         operation,
+                        int         makeSkew)
+{
+    FHTPlans plans;
+    fastHoughTransform(src.getMat(), dst, dstMatDepth, angleRange, operation,
+                       makeSkew, plans);
+}
+
+void FastHoughTransformBatch(InputArrayOfArrays  src,
+                             OutputArrayOfArrays dst,
+                             int                 dstMatDepth,
+                             int                 angleRange,
+                             int                 operation,
+                             int                 makeSkew)
+{
+    std::vector<Mat> srcMats;
+    src.getMatVector(srcMats);
+
+    // the images of the same size share the nodes of their transforms
+    FHTPlans plans;
+    dst.create((int)srcMats.size(), 1, CV_MAKETYPE(dstMatDepth, 1));
+    for (int i = 0; i < (int)srcMats.size(); i++)
+        fastHoughTransform(srcMats[i], dst, dstMatDepth, angleRange, operation,
+                           makeSkew, plans, i);
+}
+
 //-----------------------------------------------------------------------------
 
 //----------------------fht point2line-----------------------------------------
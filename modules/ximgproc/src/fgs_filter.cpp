@@ -36,6 +36,7 @@
 
 #include "precomp.hpp"
 #include "opencv2/core/hal/intrin.hpp"
+#include "opencl_kernels_ximgproc.hpp"
 #include <vector>
 
 namespace cv {
@@ -73,9 +74,15 @@ protected:
     Mat weights_LUT;
     Mat Chor, Cvert;
     Mat interD;
+    UMat Chor_ocl, Cvert_ocl;
+    UMat interD_ocl;
     void init(InputArray guide,double _lambda,double _sigmaColor,int _num_iter,double _lambda_attenuation);
+    void initWeightsLUT(int num_levels);
     void horizontalPass(Mat& cur);
     void verticalPass(Mat& cur);
+#ifdef HAVE_OPENCL
+    bool ocl_filter(InputArray src, OutputArray dst);
+#endif
 protected:
     struct HorizontalPass_ParBody : public ParallelLoopBody
     {
@@ -147,11 +154,8 @@ void FastGlobalSmootherFilterImpl::init(InputArray guide,double _lambda,double _
     lambda_attenuation = (float)_lambda_attenuation;
     num_iter = _num_iter;
     num_stripes = getNumThreads();
-    int num_levels = 3*256*256;
-    weights_LUT.create(1,num_levels,WorkVec::type);
-
-    WorkType* LUT = (WorkType*)weights_LUT.ptr(0);
-    parallel_for_(Range(0,num_stripes),ComputeLUT_ParBody(*this,LUT,num_stripes,num_levels));
+    // the LUT is indexed by the squared color distance of two guide pixels
+    initWeightsLUT(guide.channels()*255*255+1);
 
     w = guide.cols();
     h = guide.rows();
@@ -172,6 +176,26 @@ void FastGlobalSmootherFilterImpl::init(InputArray guide,double _lambda,double _
     }
 }
 
+// The LUT only depends on sigmaColor, it is kept for the next filters, e.g. the ones created for each frame of a video
+static Mutex weights_LUT_mutex;
+static Mat cached_weights_LUT;
+static float cached_weights_LUT_sigma = -1.0f;
+
+void FastGlobalSmootherFilterImpl::initWeightsLUT(int num_levels)
+{
+    AutoLock lock(weights_LUT_mutex);
+    if(cached_weights_LUT_sigma != sigmaColor || cached_weights_LUT.cols < num_levels)
+    {
+        // a new matrix, the previous one may still be used by other filters
+        Mat LUT_mat(1,num_levels,WorkVec::type);
+        WorkType* LUT = (WorkType*)LUT_mat.ptr(0);
+        parallel_for_(Range(0,num_stripes),ComputeLUT_ParBody(*this,LUT,num_stripes,num_levels));
+        cached_weights_LUT = LUT_mat;
+        cached_weights_LUT_sigma = sigmaColor;
+    }
+    weights_LUT = cached_weights_LUT;
+}
+
 Ptr<FastGlobalSmootherFilterImpl> FastGlobalSmootherFilterImpl::create(InputArray guide, double lambda, double sigma_color, int num_iter, double lambda_attenuation)
 {
     FastGlobalSmootherFilterImpl *fgs = new FastGlobalSmootherFilterImpl();
@@ -188,6 +212,8 @@ void FastGlobalSmootherFilterImpl::filter(InputArray src, OutputArray dst)
         return;
     }
 
+    CV_OCL_RUN(dst.isUMat(), ocl_filter(src, dst))
+
     vector<Mat> src_channels;
     vector<Mat> dst_channels;
     if(src.channels()==1)
@@ -200,9 +226,14 @@ void FastGlobalSmootherFilterImpl::filter(InputArray src, OutputArray dst)
     for(int i=0;i<src.channels();i++)
     {
         lambda = lambda_ref;
-        Mat cur_res = src_channels[i].clone();
+        // the split channels are already copies, they are filtered in place, sharing the weights of the guide
+        Mat cur_res;
         if(src.depth()!=WorkVec::type)
-            cur_res.convertTo(cur_res,WorkVec::type);
+            src_channels[i].convertTo(cur_res,WorkVec::type);
+        else if(src.channels()==1)
+            cur_res = src_channels[i].clone();
+        else
+            cur_res = src_channels[i];
 
         for(int n=0;n<num_iter;n++)
         {
@@ -232,6 +263,57 @@ void FastGlobalSmootherFilterImpl::filter(InputArray src, OutputArray dst)
         merge(dst_channels,dst);
 }
 
+#ifdef HAVE_OPENCL
+bool FastGlobalSmootherFilterImpl::ocl_filter(InputArray src, OutputArray dst)
+{
+    ocl::Kernel horizontal("fgs_horizontal_pass", ocl::ximgproc::fgs_filter_oclsrc);
+    ocl::Kernel vertical  ("fgs_vertical_pass",   ocl::ximgproc::fgs_filter_oclsrc);
+    if (horizontal.empty() || vertical.empty())
+        return false;
+
+    // the weights stay computed on the CPU, they are sent to the device with the first filtered image
+    if (Chor_ocl.empty())
+    {
+        Chor. copyTo(Chor_ocl);
+        Cvert.copyTo(Cvert_ocl);
+    }
+    interD_ocl.create(h,w,WorkVec::type);
+
+    vector<UMat> src_channels;
+    vector<UMat> dst_channels;
+    split(src,src_channels);
+
+    size_t rows_size[1] = { (size_t)h };
+    size_t cols_size[1] = { (size_t)w };
+    for(size_t i=0;i<src_channels.size();i++)
+    {
+        UMat cur_res;
+        src_channels[i].convertTo(cur_res,WorkVec::type);
+
+        float cur_lambda = lambda;
+        for(int n=0;n<num_iter;n++)
+        {
+            horizontal.args(ocl::KernelArg::ReadOnlyNoSize(Chor_ocl), ocl::KernelArg::ReadWriteNoSize(interD_ocl),
+                            ocl::KernelArg::ReadWrite(cur_res), cur_lambda);
+            if (!horizontal.run(1, rows_size, NULL, false))
+                return false;
+            vertical.args(ocl::KernelArg::ReadOnlyNoSize(Cvert_ocl), ocl::KernelArg::ReadWriteNoSize(interD_ocl),
+                          ocl::KernelArg::ReadWrite(cur_res), cur_lambda);
+            if (!vertical.run(1, cols_size, NULL, false))
+                return false;
+            cur_lambda*=lambda_attenuation;
+        }
+
+        UMat dst_channel;
+        cur_res.convertTo(dst_channel,src.depth());
+        dst_channels.push_back(dst_channel);
+    }
+
+    merge(dst_channels,dst);
+    return true;
+}
+#endif
+
 void FastGlobalSmootherFilterImpl::horizontalPass(Mat& cur)
 {
     parallel_for_(Range(0,num_stripes),HorizontalPass_ParBody(*this,cur,num_stripes,h));
@@ -42,6 +42,8 @@ the use of this software, even if advised of the possibility of such damage.
 #include "opencv2/ximgproc/segmentation.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 
 namespace cv {
     namespace ximgproc {
@@ -79,7 +81,6 @@ namespace cv {
             class PointSet {
                 public:
                     PointSet(int nb_elements_);
-                    ~PointSet();
 
                     int nb_elements;
 
@@ -93,10 +94,109 @@ namespace cv {
                     int size(unsigned int p) { return mapping[p].size; }
 
                 private:
-                    PointSetElement* mapping;
+                    std::vector<PointSetElement> mapping;
 
             };
 
+            // Sort the edges by increasing weight. The weights are positive floats, whose bits sort as
+            // unsigned integers, so a stable radix sort over three digits of 11 bits gives the same order
+            // than a comparison sort in linear time.
+            static void sortEdges(std::vector<Edge>& edges, std::vector<Edge>& buffer) {
+
+                const int digit_bits = 11;
+                const int nb_buckets = 1 << digit_bits;
+
+                buffer.resize(edges.size());
+                std::vector<int> counts(nb_buckets);
+
+                for (int shift = 0; shift < 32; shift += digit_bits) {
+
+                    std::fill(counts.begin(), counts.end(), 0);
+
+                    for (size_t i = 0; i < edges.size(); i++) {
+                        unsigned int key;
+                        memcpy(&key, &edges[i].weight, sizeof(key));
+                        counts[(key >> shift) & (nb_buckets - 1)]++;
+                    }
+
+                    // Nothing to do when every edge has the same digit
+                    if (edges.empty())
+                        return;
+
+                    unsigned int first_key;
+                    memcpy(&first_key, &edges[0].weight, sizeof(first_key));
+                    if (counts[(first_key >> shift) & (nb_buckets - 1)] == (int)edges.size())
+                        continue;
+
+                    int start = 0;
+                    for (int b = 0; b < nb_buckets; b++) {
+                        int count = counts[b];
+                        counts[b] = start;
+                        start += count;
+                    }
+
+                    for (size_t i = 0; i < edges.size(); i++) {
+                        unsigned int key;
+                        memcpy(&key, &edges[i].weight, sizeof(key));
+                        buffer[counts[(key >> shift) & (nb_buckets - 1)]++] = edges[i];
+                    }
+
+                    edges.swap(buffer);
+                }
+            }
+
+            // Compute the edges of a range of rows, at fixed positions in the list of edges: the right
+            // neighbour of every pixel of the row, then the bottom ones.
+            class BuildGraphInvoker : public ParallelLoopBody {
+                public:
+                    BuildGraphInvoker(const Mat& _img_filtered, std::vector<Edge>& _edges)
+                        : img_filtered(_img_filtered), edges(_edges) {}
+
+                    void operator()(const Range& range) const {
+
+                        int cols = img_filtered.cols;
+                        int nb_channels = img_filtered.channels();
+
+                        for (int i = range.start; i < range.end; i++) {
+                            const float* p = img_filtered.ptr<float>(i);
+                            Edge* e = &edges[0] + (size_t)i * (2 * cols - 1);
+
+                            for (int j = 0; j < cols - 1; j++, e++) {
+                                e->weight = distance(p + j * nb_channels, p + (j + 1) * nb_channels, nb_channels);
+                                e->from = i * cols + j;
+                                e->to = i * cols + j + 1;
+                            }
+
+                            if (i + 1 < img_filtered.rows) {
+                                const float* p2 = img_filtered.ptr<float>(i + 1);
+
+                                for (int j = 0; j < cols; j++, e++) {
+                                    e->weight = distance(p + j * nb_channels, p2 + j * nb_channels, nb_channels);
+                                    e->from = i * cols + j;
+                                    e->to = (i + 1) * cols + j;
+                                }
+                            }
+                        }
+                    }
+
+                private:
+                    const Mat& img_filtered;
+                    std::vector<Edge>& edges;
+
+                    static float distance(const float* a, const float* b, int nb_channels) {
+                        float tmp_total = 0;
+
+                        for (int channel = 0; channel < nb_channels; channel++) {
+                            float d = a[channel] - b[channel];
+                            tmp_total += d * d;
+                        }
+
+                        return std::sqrt(tmp_total);
+                    }
+
+                    BuildGraphInvoker& operator=(const BuildGraphInvoker&); // to quiet MSVC
+            };
+
             class GraphSegmentationImpl : public GraphSegmentation {
                 public:
                     GraphSegmentationImpl() {
@@ -145,16 +245,16 @@ namespace cv {
                     void filter(const Mat &img, Mat &img_filtered);
 
                     // Build the graph between each pixels
-                    void buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered);
+                    void buildGraph(std::vector<Edge> &edges, const Mat &img_filtered);
 
                     // Segment the graph
-                    void segmentGraph(Edge * edges, const int &nb_edges, const Mat & img_filtered, PointSet **es);
+                    void segmentGraph(std::vector<Edge> &edges, const Mat & img_filtered, PointSet &es);
 
                     // Remove areas too small
-                    void filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es);
+                    void filterSmallAreas(const std::vector<Edge> &edges, PointSet &es);
 
                     // Map the segemented graph to a Mat with uniques, sequentials ids
-                    void finalMapping(PointSet *es, Mat &output);
+                    void finalMapping(PointSet &es, Mat &output);
             };
 
             void GraphSegmentationImpl::filter(const Mat &img, Mat &img_filtered) {
@@ -168,96 +268,61 @@ namespace cv {
                 GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
             }
 
-            void GraphSegmentationImpl::buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered) {
-
-                *edges = new Edge[img_filtered.rows * img_filtered.cols * 4];
-
-                nb_edges = 0;
-
-                int nb_channels = img_filtered.channels();
-
-                for (int i = 0; i < (int)img_filtered.rows; i++) {
-                    const float* p = img_filtered.ptr<float>(i);
-
-                    for (int j = 0; j < (int)img_filtered.cols; j++) {
-
-                        //Take the right, left, top and down pixel
-                        for (int delta = -1; delta <= 1; delta += 2) {
-                            for (int delta_j = 0, delta_i = 1; delta_j <= 1; delta_j++ || delta_i--) {
-
-                                int i2 = i + delta * delta_i;
-                                int j2 = j + delta * delta_j;
-
-                                if (i2 >= 0 && i2 < img_filtered.rows && j2 >= 0 && j2 < img_filtered.cols) {
-                                    const float* p2 = img_filtered.ptr<float>(i2);
-
-                                    float tmp_total = 0;
+            void GraphSegmentationImpl::buildGraph(std::vector<Edge> &edges, const Mat &img_filtered) {
 
-                                    for ( int channel = 0; channel < nb_channels; channel++) {
-                                        tmp_total += pow(p[j * nb_channels + channel] - p2[j2 * nb_channels + channel], 2);
-                                    }
+                int rows = img_filtered.rows;
+                int cols = img_filtered.cols;
 
-                                    float diff = 0;
-                                    diff = sqrt(tmp_total);
+                // Each pixel is linked to its right and bottom neighbours, the other links being the same edges
+                edges.clear();
+                if (rows == 0 || cols == 0)
+                    return;
 
-                                    (*edges)[nb_edges].weight = diff;
-                                    (*edges)[nb_edges].from = i * img_filtered.cols +  j;
-                                    (*edges)[nb_edges].to = i2 * img_filtered.cols + j2;
+                edges.resize((size_t)(rows - 1) * (2 * cols - 1) + (cols - 1));
 
-                                    nb_edges++;
-                                }
-                            }
-                        }
-                    }
-                }
+                if (!edges.empty())
+                    parallel_for_(Range(0, rows), BuildGraphInvoker(img_filtered, edges));
             }
 
-            void GraphSegmentationImpl::segmentGraph(Edge *edges, const int &nb_edges, const Mat &img_filtered, PointSet **es) {
+            void GraphSegmentationImpl::segmentGraph(std::vector<Edge> &edges, const Mat &img_filtered, PointSet &es) {
 
                 int total_points = ( int)(img_filtered.rows * img_filtered.cols);
 
                 // Sort edges
-                std::sort(edges, edges + nb_edges);
-
-                // Create a set with all point (by default mapped to themselfs)
-                *es = new PointSet(img_filtered.cols * img_filtered.rows);
+                std::vector<Edge> buffer;
+                sortEdges(edges, buffer);
 
                 // Thresholds
-                float* thresholds = new float[total_points];
+                std::vector<float> thresholds(total_points, k);
 
-                for (int i = 0; i < total_points; i++)
-                    thresholds[i] = k;
+                for (size_t i = 0; i < edges.size(); i++) {
 
-                for ( int i = 0; i < nb_edges; i++) {
-
-                    int p_a = (*es)->getBasePoint(edges[i].from);
-                    int p_b = (*es)->getBasePoint(edges[i].to);
+                    int p_a = es.getBasePoint(edges[i].from);
+                    int p_b = es.getBasePoint(edges[i].to);
 
                     if (p_a != p_b) {
                         if (edges[i].weight <= thresholds[p_a] && edges[i].weight <= thresholds[p_b]) {
-                            (*es)->joinPoints(p_a, p_b);
-                            p_a = (*es)->getBasePoint(p_a);
-                            thresholds[p_a] = edges[i].weight + k / (*es)->size(p_a);
+                            es.joinPoints(p_a, p_b);
+                            p_a = es.getBasePoint(p_a);
+                            thresholds[p_a] = edges[i].weight + k / es.size(p_a);
 
                             edges[i].weight = 0;
                         }
                     }
                 }
-
-                delete [] thresholds;
             }
 
-            void GraphSegmentationImpl::filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es) {
+            void GraphSegmentationImpl::filterSmallAreas(const std::vector<Edge> &edges, PointSet &es) {
 
-                for ( int i = 0; i < nb_edges; i++) {
+                for (size_t i = 0; i < edges.size(); i++) {
 
                     if (edges[i].weight > 0) {
 
-                        int p_a = es->getBasePoint(edges[i].from);
-                        int p_b = es->getBasePoint(edges[i].to);
+                        int p_a = es.getBasePoint(edges[i].from);
+                        int p_b = es.getBasePoint(edges[i].to);
 
-                        if (p_a != p_b && (es->size(p_a) < min_size || es->size(p_b) < min_size)) {
-                            es->joinPoints(p_a, p_b);
+                        if (p_a != p_b && (es.size(p_a) < min_size || es.size(p_b) < min_size)) {
+                            es.joinPoints(p_a, p_b);
 
                         }
                     }
@@ -265,15 +330,12 @@ namespace cv {
 
             }
 
-            void GraphSegmentationImpl::finalMapping(PointSet *es, Mat &output) {
+            void GraphSegmentationImpl::finalMapping(PointSet &es, Mat &output) {
 
                 int maximum_size = ( int)(output.rows * output.cols);
 
                 int last_id = 0;
-                int * mapped_id = new int[maximum_size];
-
-                for ( int i = 0; i < maximum_size; i++)
-                    mapped_id[i] = -1;
+                std::vector<int> mapped_id(maximum_size, -1);
 
                 int rows = output.rows;
                 int cols = output.cols;
@@ -289,7 +351,7 @@ namespace cv {
 
                     for (int j = 0; j < cols; j++) {
 
-                        int point = es->getBasePoint(i * cols + j);
+                        int point = es.getBasePoint(i * cols + j);
 
                         if (mapped_id[point] == -1) {
                             mapped_id[point] = last_id;
@@ -299,8 +361,6 @@ namespace cv {
                         p[j] = mapped_id[point];
                     }
                 }
-
-                delete [] mapped_id;
             }
 
             void GraphSegmentationImpl::processImage(InputArray src, OutputArray dst) {
@@ -316,25 +376,21 @@ namespace cv {
                 filter(img, img_filtered);
 
                 // Build graph
-                Edge *edges;
-                int nb_edges;
+                std::vector<Edge> edges;
 
-                buildGraph(&edges, nb_edges, img_filtered);
+                buildGraph(edges, img_filtered);
 
                 // Segment graph
-                PointSet *es;
+                PointSet es(img_filtered.cols * img_filtered.rows);
 
-                segmentGraph(edges, nb_edges, img_filtered, &es);
+                segmentGraph(edges, img_filtered, es);
 
                 // Remove small areas
-                filterSmallAreas(edges, nb_edges, es);
+                filterSmallAreas(edges, es);
 
                 // Map to final output
                 finalMapping(es, output);
 
-                delete [] edges;
-                delete es;
-
             }
 
             Ptr<GraphSegmentation> createGraphSegmentation(double sigma, float k, int min_size) {
@@ -351,36 +407,29 @@ namespace cv {
             PointSet::PointSet(int nb_elements_) {
                 nb_elements = nb_elements_;
 
-                mapping = new PointSetElement[nb_elements];
+                mapping.resize(nb_elements);
 
                 for ( int i = 0; i < nb_elements; i++) {
                     mapping[i] = PointSetElement(i);
                 }
             }
 
-            PointSet::~PointSet() {
-                delete [] mapping;
-            }
-
             int PointSet::getBasePoint( int p) {
 
-                 int base_p = p;
-
-                while (base_p != mapping[base_p].p) {
-                    base_p = mapping[base_p].p;
+                // Path halving: every visited point is mapped to its grandparent
+                while (p != mapping[p].p) {
+                    mapping[p].p = mapping[mapping[p].p].p;
+                    p = mapping[p].p;
                 }
 
-                // Save mapping for faster acces later
-                mapping[p].p = base_p;
-
-                return base_p;
+                return p;
             }
 
             void PointSet::joinPoints(int p_a, int p_b) {
 
                 // Always target smaller set, to avoid redirection in getBasePoint
                 if (mapping[p_a].size < mapping[p_b].size)
-                    swap(p_a, p_b);
+                    std::swap(p_a, p_b);
 
                 mapping[p_b].p = p_a;
                 mapping[p_a].size += mapping[p_b].size;
@@ -128,7 +128,7 @@ class GuidedFilterImpl : public GuidedFilter
 {
 public:
     
-    static Ptr<GuidedFilterImpl> create(InputArray guide, int radius, double eps);
+    static Ptr<GuidedFilterImpl> create(InputArray guide, int radius, double eps, int scale = 1);
 
     void filter(InputArray src, OutputArray dst, int dDepth = -1);
 
@@ -136,20 +136,31 @@ protected:
 
     int radius;
     double eps;
+    /* size of the images the coefficients are computed on, subsampled by scale */
     int h, w;
+    int scale;
+    int fullH, fullW;
 
     vector<Mat> guideCn;
     vector<Mat> guideCnMean;
+    /* full resolution guide, only needed when the coefficients are subsampled */
+    vector<Mat> guideCnFull;
 
     SymArray2D<Mat> covarsInv;
 
     int gCnNum;
 
+    /* buffers kept between the calls of filter on images of the same size */
+    vector<Mat> srcCnRaw, srcCnBuf;
+    vector<vector<Mat> > covSrcGuideBuf, alphaBuf, alphaFullBuf;
+    vector<Mat> betaFullBuf;
+    Mat mergedBuf;
+
 protected:
 
     GuidedFilterImpl() {}
     
-    void init(InputArray guide, int radius, double eps);
+    void init(InputArray guide, int radius, double eps, int scale);
 
     void computeCovGuide(SymArray2D<Mat>& covars);
 
@@ -167,6 +178,19 @@ protected:
         src.convertTo(dst, CV_32F);
     }
 
+    inline void downscaleToWorkType(Mat& src, Mat& dst)
+    {
+        Mat src32f = src;
+        if (src.depth() != CV_32F)
+            src.convertTo(src32f, CV_32F);
+        resize(src32f, dst, Size(w, h), 0, 0, INTER_AREA);
+    }
+
+    inline void upscale(Mat& src, Mat& dst)
+    {
+        resize(src, dst, Size(fullW, fullH), 0, 0, INTER_LINEAR);
+    }
+
 private: /*Routines to parallelize boxFilter and convertTo*/
     
     typedef void (GuidedFilterImpl::*TransformFunc)(Mat& src, Mat& dst);
@@ -203,6 +227,20 @@ private: /*Routines to parallelize boxFilter and convertTo*/
         parallel_for_(pb.getRange(), pb);
     }
 
+    template<typename V>
+    void parDownscaleToWorkType(V &src, V &dst)
+    {
+        GFTransform_ParBody pb(*this, src, dst, &GuidedFilterImpl::downscaleToWorkType);
+        parallel_for_(pb.getRange(), pb);
+    }
+
+    template<typename V>
+    void parUpscale(V &src, V &dst)
+    {
+        GFTransform_ParBody pb(*this, src, dst, &GuidedFilterImpl::upscale);
+        parallel_for_(pb.getRange(), pb);
+    }
+
 private: /*Parallel body classes*/
 
     inline void runParBody(const ParallelLoopBody& pb)
@@ -295,11 +333,12 @@ private: /*Parallel body classes*/
     struct ApplyTransform_ParBody : public ParallelLoopBody
     {
         GuidedFilterImpl &gf;
+        vector<Mat> &guide;
         vector<vector<Mat> > &alpha;
         vector<Mat> &beta;
 
-        ApplyTransform_ParBody(GuidedFilterImpl& gf_, vector<vector<Mat> >& alpha_, vector<Mat>& beta_)
-            : gf(gf_),  alpha(alpha_), beta(beta_) {}
+        ApplyTransform_ParBody(GuidedFilterImpl& gf_, vector<Mat>& guide_, vector<vector<Mat> >& alpha_, vector<Mat>& beta_)
+            : gf(gf_), guide(guide_), alpha(alpha_), beta(beta_) {}
 
         void operator () (const Range& range) const;
     };
@@ -577,12 +616,13 @@ void GuidedFilterImpl::ComputeBeta_ParBody::operator()(const Range& range) const
 void GuidedFilterImpl::ApplyTransform_ParBody::operator()(const Range& range) const
 {
     int srcCnNum = (int)alpha.size();
+    int width = guide[0].cols;
 
     for (int i = range.start; i < range.end; i++)
     {
         float *_g[4];
         for (int gi = 0; gi < gf.gCnNum; gi++)
-            _g[gi] = gf.guideCn[gi].ptr<float>(i);
+            _g[gi] = guide[gi].ptr<float>(i);
 
         float *betaDst, *g, *a;
         for (int si = 0; si < srcCnNum; si++)
@@ -593,7 +633,7 @@ void GuidedFilterImpl::ApplyTransform_ParBody::operator()(const Range& range) co
                 a = alpha[si][gi].ptr<float>(i);
                 g = _g[gi];
 
-                add_mul(betaDst, a, g, gf.w);
+                add_mul(betaDst, a, g, width);
             }
         }
     }
@@ -666,28 +706,45 @@ void GuidedFilterImpl::getWalkPattern(int eid, int &cn1, int &cn2)
     cn2 = wdata[6 * 2 * (gCnNum-1) + 6 + eid];
 }
 
-Ptr<GuidedFilterImpl> GuidedFilterImpl::create(InputArray guide, int radius, double eps)
+Ptr<GuidedFilterImpl> GuidedFilterImpl::create(InputArray guide, int radius, double eps, int scale)
 {
     GuidedFilterImpl *gf = new GuidedFilterImpl();
-    gf->init(guide, radius, eps);
+    gf->init(guide, radius, eps, scale);
     return Ptr<GuidedFilterImpl>(gf);
 }
 
-void GuidedFilterImpl::init(InputArray guide, int radius_, double eps_)
+void GuidedFilterImpl::init(InputArray guide, int radius_, double eps_, int scale_)
 {
-    CV_Assert( !guide.empty() && radius_ >= 0 && eps_ >= 0 );
+    CV_Assert( !guide.empty() && radius_ >= 0 && eps_ >= 0 && scale_ >= 1 );
     CV_Assert( (guide.depth() == CV_32F || guide.depth() == CV_8U || guide.depth() == CV_16U) && (guide.channels() <= 3) );
 
-    radius = radius_;
     eps = eps_;
+    scale = scale_;
 
     splitFirstNChannels(guide, guideCn, 3);
     gCnNum = (int)guideCn.size();
-    h = guideCn[0].rows;
-    w = guideCn[0].cols;
+    fullH = guideCn[0].rows;
+    fullW = guideCn[0].cols;
+
+    if (scale == 1)
+    {
+        radius = radius_;
+        h = fullH;
+        w = fullW;
+        parConvertToWorkType(guideCn, guideCn);
+    }
+    else
+    {
+        //the coefficients are computed on the subsampled guide, the output on the full one
+        radius = cvRound(radius_ / (double)scale);
+        h = std::max(1, cvRound(fullH / (double)scale));
+        w = std::max(1, cvRound(fullW / (double)scale));
+        guideCnFull.resize(gCnNum);
+        parConvertToWorkType(guideCn, guideCnFull);
+        parDownscaleToWorkType(guideCnFull, guideCn);
+    }
 
     guideCnMean.resize(gCnNum);
-    parConvertToWorkType(guideCn, guideCn);
     parMeanFilter(guideCn, guideCnMean);
     
     SymArray2D<Mat> covars;
@@ -712,7 +769,7 @@ void GuidedFilterImpl::computeCovGuide(SymArray2D<Mat>& covars)
 void GuidedFilterImpl::filter(InputArray src, OutputArray dst, int dDepth /*= -1*/)
 {
     CV_Assert( !src.empty() && (src.depth() == CV_32F || src.depth() == CV_8U) );
-    if (src.rows() != h || src.cols() != w)
+    if (src.rows() != fullH || src.cols() != fullW)
     {
         CV_Error(Error::StsBadSize, "Size of filtering image must be equal to size of guide image");
         return;
@@ -721,19 +778,28 @@ void GuidedFilterImpl::filter(InputArray src, OutputArray dst, int dDepth /*= -1
     if (dDepth == -1) dDepth = src.depth();
     int srcCnNum = src.channels();
 
-    vector<Mat> srcCn(srcCnNum);
+    vector<Mat>& srcCn = srcCnBuf;
     vector<Mat>& srcCnMean = srcCn;
-    split(src, srcCn);
+    srcCn.resize(srcCnNum);
 
-    if (src.depth() != CV_32F)
+    if (scale == 1 && src.depth() == CV_32F)
     {
-        parConvertToWorkType(srcCn, srcCn);
+        split(src, srcCn);
+    }
+    else
+    {
+        split(src, srcCnRaw);
+        if (scale == 1)
+            parConvertToWorkType(srcCnRaw, srcCn);
+        else
+            parDownscaleToWorkType(srcCnRaw, srcCn);
     }
 
-    vector<vector<Mat> > covSrcGuide(srcCnNum);
+    vector<vector<Mat> >& covSrcGuide = covSrcGuideBuf;
     computeCovGuideAndSrc(srcCn, srcCnMean, covSrcGuide);
 
-    vector<vector<Mat> > alpha(srcCnNum);
+    vector<vector<Mat> >& alpha = alphaBuf;
+    alpha.resize(srcCnNum);
     for (int si = 0; si < srcCnNum; si++)
     {
         alpha[si].resize(gCnNum);
@@ -741,7 +807,6 @@ void GuidedFilterImpl::filter(InputArray src, OutputArray dst, int dDepth /*= -1
             alpha[si][gi].create(h, w, CV_32FC1);
     }
     runParBody(ComputeAlpha_ParBody(*this, alpha, covSrcGuide));
-    covSrcGuide.clear();
 
     vector<Mat>& beta = srcCnMean;
     runParBody(ComputeBeta_ParBody(*this, alpha, srcCnMean, beta));
@@ -749,13 +814,34 @@ void GuidedFilterImpl::filter(InputArray src, OutputArray dst, int dDepth /*= -1
     parMeanFilter(beta, beta);
     parMeanFilter(alpha, alpha);
 
-    runParBody(ApplyTransform_ParBody(*this, alpha, beta));
-    if (dDepth != CV_32F)
+    vector<Mat>* res = &beta;
+    if (scale == 1)
+    {
+        runParBody(ApplyTransform_ParBody(*this, guideCn, alpha, beta));
+    }
+    else
+    {
+        //the averaged coefficients are smooth, so they are upsampled before being applied to the full guide
+        alphaFullBuf.resize(srcCnNum);
+        for (int si = 0; si < srcCnNum; si++)
+            alphaFullBuf[si].resize(gCnNum);
+        betaFullBuf.resize(srcCnNum);
+        parUpscale(alpha, alphaFullBuf);
+        parUpscale(beta, betaFullBuf);
+
+        parallel_for_(Range(0, fullH), ApplyTransform_ParBody(*this, guideCnFull, alphaFullBuf, betaFullBuf));
+        res = &betaFullBuf;
+    }
+
+    if (dDepth == CV_32F)
+    {
+        merge(*res, dst);
+    }
+    else
     {
-        for (int i = 0; i < srcCnNum; i++)
-            beta[i].convertTo(beta[i], dDepth);
+        merge(*res, mergedBuf);
+        mergedBuf.convertTo(dst, dDepth);
     }
-    merge(beta, dst);
 }
 
 void GuidedFilterImpl::computeCovGuideAndSrc(vector<Mat>& srcCn, vector<Mat>& srcCnMean, vector<vector<Mat> >& cov)
@@ -782,15 +868,15 @@ void GuidedFilterImpl::computeCovGuideAndSrc(vector<Mat>& srcCn, vector<Mat>& sr
 //////////////////////////////////////////////////////////////////////////
 
 CV_EXPORTS_W
-Ptr<GuidedFilter> createGuidedFilter(InputArray guide, int radius, double eps)
+Ptr<GuidedFilter> createGuidedFilter(InputArray guide, int radius, double eps, int scale)
 {
-    return Ptr<GuidedFilter>(GuidedFilterImpl::create(guide, radius, eps));
+    return Ptr<GuidedFilter>(GuidedFilterImpl::create(guide, radius, eps, scale));
 }
 
 CV_EXPORTS_W
-void guidedFilter(InputArray guide, InputArray src, OutputArray dst, int radius, double eps, int dDepth)
+void guidedFilter(InputArray guide, InputArray src, OutputArray dst, int radius, double eps, int dDepth, int scale)
 {
-    Ptr<GuidedFilter> gf = createGuidedFilter(guide, radius, eps);
+    Ptr<GuidedFilter> gf = createGuidedFilter(guide, radius, eps, scale);
     gf->filter(src, dst, dDepth);
 }
 
@@ -35,6 +35,7 @@
  */
 
 #include "precomp.hpp"
+#include "joint_bilateral_filter.hpp"
 #include <climits>
 #include <iostream>
 using namespace std;
@@ -55,26 +56,22 @@ typedef Vec<uchar, 1> Vec1b;
 #define SQR(a) ((a)*(a))
 #endif
 
-void jointBilateralFilter_32f(Mat& joint, Mat& src, Mat& dst, int radius, double sigmaColor, double sigmaSpace, int borderType);
-
-void jointBilateralFilter_8u(Mat& joint, Mat& src, Mat& dst, int radius, double sigmaColor, double sigmaSpace, int borderType);
-
-template<typename JointVec, typename SrcVec>
+template<typename JointVec, typename SrcVec, bool ColorL2>
 class JointBilateralFilter_32f : public ParallelLoopBody
 {
     Mat &joint, &src;
     Mat &dst;
     int radius, maxk;
     float scaleIndex;
-    int *spaceOfs;
-    float *spaceWeights, *expLUT;
+    const int *spaceOfs;
+    const float *spaceWeights, *expLUT;
 
 public:
 
     JointBilateralFilter_32f(Mat& joint_, Mat& src_, Mat& dst_, int radius_,
-        int maxk_, float scaleIndex_, int *spaceOfs_, float *spaceWeights_, float *expLUT_)
+        int maxk_, float scaleIndex_, const int *spaceOfs_, const float *spaceWeights_, const float *expLUT_)
         :
-        joint(joint_), src(src_), dst(dst_), radius(radius_), maxk(maxk_), 
+        joint(joint_), src(src_), dst(dst_), radius(radius_), maxk(maxk_),
         scaleIndex(scaleIndex_), spaceOfs(spaceOfs_), spaceWeights(spaceWeights_), expLUT(expLUT_)
     {
         CV_DbgAssert(joint.type() == JointVec::type && src.type() == dst.type() && src.type() == SrcVec::type);
@@ -86,10 +83,14 @@ public:
     {
         for (int i = radius + range.start; i < radius + range.end; i++)
         {
+            const JointVec *jointRow = joint.ptr<JointVec>(i);
+            const SrcVec *srcRow = src.ptr<SrcVec>(i);
+            SrcVec *dstRow = dst.ptr<SrcVec>(i - radius);
+
             for (int j = radius; j < src.cols - radius; j++)
             {
-                JointVec *jointCenterPixPtr = joint.ptr<JointVec>(i) + j;
-                SrcVec *srcCenterPixPtr = src.ptr<SrcVec>(i) + j;
+                const JointVec *jointCenterPixPtr = jointRow + j;
+                const SrcVec *srcCenterPixPtr = srcRow + j;
 
                 JointVec jointPix0 = *jointCenterPixPtr;
                 SrcVec srcSum = SrcVec::all(0.0f);
@@ -97,111 +98,50 @@ public:
 
                 for (int k = 0; k < maxk; k++)
                 {
-                    float *jointPix = reinterpret_cast<float*>(jointCenterPixPtr + spaceOfs[k]);
+                    const float *jointPix = reinterpret_cast<const float*>(jointCenterPixPtr + spaceOfs[k]);
                     float alpha = 0.0f;
 
                     for (int cn = 0; cn < JointVec::channels; cn++)
-                        alpha += std::abs(jointPix0[cn] - jointPix[cn]);
+                    {
+                        float diff = jointPix0[cn] - jointPix[cn];
+                        alpha += ColorL2 ? diff*diff : std::abs(diff);
+                    }
                     alpha *= scaleIndex;
                     int idx = (int)(alpha);
                     alpha -= idx;
                     float weight = spaceWeights[k] * (expLUT[idx] + alpha*(expLUT[idx + 1] - expLUT[idx]));
 
-                    float *srcPix = reinterpret_cast<float*>(srcCenterPixPtr + spaceOfs[k]);
+                    const float *srcPix = reinterpret_cast<const float*>(srcCenterPixPtr + spaceOfs[k]);
                     for (int cn = 0; cn < SrcVec::channels; cn++)
                         srcSum[cn] += weight*srcPix[cn];
                     wSum += weight;
                 }
 
-                dst.at<SrcVec>(i - radius, j - radius) = srcSum / wSum;
+                dstRow[j - radius] = srcSum / wSum;
             }
         }
     }
 };
 
-void jointBilateralFilter_32f(Mat& joint, Mat& src, Mat& dst, int radius, double sigmaColor, double sigmaSpace, int borderType)
+template<bool ColorL2>
+static void runJointBilateralFilter_32f(Mat& jointTemp, Mat& srcTemp, Mat& dst, int radius, int maxk, float scaleIndex,
+                                        const int *spaceOfs, const float *spaceWeights, const float *expLUT)
 {
-    CV_DbgAssert(joint.depth() == CV_32F && src.depth() == CV_32F);
-    
-    int d = 2*radius + 1;
-    int jCn = joint.channels();
-    const int kExpNumBinsPerChannel = 1 << 12;
-    double minValJoint, maxValJoint;
-
-    minMaxLoc(joint, &minValJoint, &maxValJoint);
-    if (abs(maxValJoint - minValJoint) < FLT_EPSILON)
-    {
-        //TODO: make circle pattern instead of square
-        GaussianBlur(src, dst, Size(d, d), sigmaSpace, 0, borderType);
-        return;
-    }
-    float colorRange = (float)(maxValJoint - minValJoint) * jCn;
-    colorRange = std::max(0.01f, colorRange);
-
-    int kExpNumBins = kExpNumBinsPerChannel * jCn;
-    vector<float> expLUTv(kExpNumBins + 2);
-    float *expLUT = &expLUTv[0];
-    float scaleIndex = kExpNumBins/colorRange;
-
-    double gaussColorCoeff = -0.5 / (sigmaColor*sigmaColor);
-    double gaussSpaceCoeff = -0.5 / (sigmaSpace*sigmaSpace);
-
-    for (int i = 0; i < kExpNumBins + 2; i++)
-    {
-        double val = i / scaleIndex;
-        expLUT[i] = (float) std::exp(val * val * gaussColorCoeff);
-    }
-
-    Mat jointTemp, srcTemp;
-    copyMakeBorder(joint, jointTemp, radius, radius, radius, radius, borderType);
-    copyMakeBorder(src, srcTemp, radius, radius, radius, radius, borderType);
-    size_t srcElemStep = srcTemp.step / srcTemp.elemSize();
-    size_t jElemStep = jointTemp.step / jointTemp.elemSize();
-    CV_Assert(srcElemStep == jElemStep);
-
-    vector<float> spaceWeightsv(d*d);
-    vector<int> spaceOfsJointv(d*d);
-    float *spaceWeights = &spaceWeightsv[0];
-    int *spaceOfsJoint = &spaceOfsJointv[0];
-
-    int maxk = 0;
-    for (int i = -radius; i <= radius; i++)
+    Range range(0, dst.rows);
+    if (jointTemp.channels() == 1)
     {
-        for (int j = -radius; j <= radius; j++)
-        {
-            double r2 = i*i + j*j;
-            if (r2 > SQR(radius))
-                continue;
-
-            spaceWeights[maxk] = (float) std::exp(r2 * gaussSpaceCoeff);
-            spaceOfsJoint[maxk] = (int) (i*jElemStep + j);
-            maxk++;
-        }
+        if (srcTemp.channels() == 1)
+            parallel_for_(range, JointBilateralFilter_32f<Vec1f, Vec1f, ColorL2>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfs, spaceWeights, expLUT));
+        if (srcTemp.channels() == 3)
+            parallel_for_(range, JointBilateralFilter_32f<Vec1f, Vec3f, ColorL2>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfs, spaceWeights, expLUT));
     }
 
-    Range range(0, joint.rows);
-    if (joint.type() == CV_32FC1)
+    if (jointTemp.channels() == 3)
     {
-        if (src.type() == CV_32FC1)
-        {
-            parallel_for_(range, JointBilateralFilter_32f<Vec1f, Vec1f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfsJoint, spaceWeights, expLUT));
-        }
-        if (src.type() == CV_32FC3)
-        {
-            parallel_for_(range, JointBilateralFilter_32f<Vec1f, Vec3f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfsJoint, spaceWeights, expLUT));
-        }
-    }
-
-    if (joint.type() == CV_32FC3)
-    {
-        if (src.type() == CV_32FC1)
-        {
-            parallel_for_(range, JointBilateralFilter_32f<Vec3f, Vec1f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfsJoint, spaceWeights, expLUT));
-        }
-        if (src.type() == CV_32FC3)
-        {
-            parallel_for_(range, JointBilateralFilter_32f<Vec3f, Vec3f>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfsJoint, spaceWeights, expLUT));
-        }
+        if (srcTemp.channels() == 1)
+            parallel_for_(range, JointBilateralFilter_32f<Vec3f, Vec1f, ColorL2>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfs, spaceWeights, expLUT));
+        if (srcTemp.channels() == 3)
+            parallel_for_(range, JointBilateralFilter_32f<Vec3f, Vec3f, ColorL2>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, spaceOfs, spaceWeights, expLUT));
     }
 }
 
@@ -211,14 +151,13 @@ class JointBilateralFilter_8u : public ParallelLoopBody
     Mat &joint, &src;
     Mat &dst;
     int radius, maxk;
-    float scaleIndex;
-    int *spaceOfs;
-    float *spaceWeights, *expLUT;
+    const int *spaceOfs;
+    const float *spaceWeights, *expLUT;
 
 public:
 
     JointBilateralFilter_8u(Mat& joint_, Mat& src_, Mat& dst_, int radius_,
-        int maxk_, int *spaceOfs_, float *spaceWeights_, float *expLUT_)
+        int maxk_, const int *spaceOfs_, const float *spaceWeights_, const float *expLUT_)
         :
         joint(joint_), src(src_), dst(dst_), radius(radius_), maxk(maxk_),
         spaceOfs(spaceOfs_), spaceWeights(spaceWeights_), expLUT(expLUT_)
@@ -235,10 +174,14 @@ public:
 
         for (int i = radius + range.start; i < radius + range.end; i++)
         {
+            const JointVec *jointRow = joint.ptr<JointVec>(i);
+            const SrcVec *srcRow = src.ptr<SrcVec>(i);
+            SrcVec *dstRow = dst.ptr<SrcVec>(i - radius);
+
             for (int j = radius; j < src.cols - radius; j++)
             {
-                JointVec *jointCenterPixPtr = joint.ptr<JointVec>(i) + j;
-                SrcVec *srcCenterPixPtr = src.ptr<SrcVec>(i) + j;
+                const JointVec *jointCenterPixPtr = jointRow + j;
+                const SrcVec *srcCenterPixPtr = srcRow + j;
 
                 JointVeci jointPix0 = JointVeci(*jointCenterPixPtr);
                 SrcVecf srcSum = SrcVecf::all(0.0f);
@@ -246,93 +189,144 @@ public:
 
                 for (int k = 0; k < maxk; k++)
                 {
-                    uchar *jointPix = reinterpret_cast<uchar*>(jointCenterPixPtr + spaceOfs[k]);
+                    const uchar *jointPix = reinterpret_cast<const uchar*>(jointCenterPixPtr + spaceOfs[k]);
                     int alpha = 0;
                     for (int cn = 0; cn < JointVec::channels; cn++)
                         alpha += std::abs(jointPix0[cn] - (int)jointPix[cn]);
-                    
+
                     float weight = spaceWeights[k] * expLUT[alpha];
 
-                    uchar *srcPix = reinterpret_cast<uchar*>(srcCenterPixPtr + spaceOfs[k]);
+                    const uchar *srcPix = reinterpret_cast<const uchar*>(srcCenterPixPtr + spaceOfs[k]);
                     for (int cn = 0; cn < SrcVec::channels; cn++)
                         srcSum[cn] += weight*srcPix[cn];
                     wSum += weight;
                 }
 
-                dst.at<SrcVec>(i - radius, j - radius) = SrcVec(srcSum / wSum);
+                dstRow[j - radius] = SrcVec(srcSum / wSum);
             }
         }
     }
 };
 
-void jointBilateralFilter_8u(Mat& joint, Mat& src, Mat& dst, int radius, double sigmaColor, double sigmaSpace, int borderType)
+JointBilateralFilterBackend::JointBilateralFilterBackend(const Mat& src_, int radius_, double sigmaColor_, double sigmaSpace_,
+                                                         int borderType_, bool colorL2_, bool circularKernel)
+    : src(src_), radius(radius_), borderType(borderType_), sigmaColor(sigmaColor_), sigmaSpace(sigmaSpace_),
+      colorL2(colorL2_), expLUTChannels(0)
 {
-    CV_DbgAssert(joint.depth() == CV_8U && src.depth() == CV_8U);
-
-    int d = 2 * radius + 1;
-    int jCn = joint.channels();
-
-    double gaussColorCoeff = -0.5 / (sigmaColor*sigmaColor);
-    double gaussSpaceCoeff = -0.5 / (sigmaSpace*sigmaSpace);
-
-    vector<float> expLUTv(jCn*256);
-    float *expLUT = &expLUTv[0];
+    CV_Assert(src.depth() == CV_8U || src.depth() == CV_32F);
+    CV_Assert(src.channels() == 1 || src.channels() == 3);
+    CV_Assert(!colorL2 || src.depth() == CV_32F);
+    CV_Assert(radius >= 1);
 
-    for (int i = 0; i < (int)expLUTv.size(); i++)
-    {
-        expLUT[i] = (float)std::exp(i * i * gaussColorCoeff);
-    }
-
-    Mat jointTemp, srcTemp;
-    copyMakeBorder(joint, jointTemp, radius, radius, radius, radius, borderType);
     copyMakeBorder(src, srcTemp, radius, radius, radius, radius, borderType);
-    size_t srcElemStep = srcTemp.step / srcTemp.elemSize();
-    size_t jElemStep = jointTemp.step / jointTemp.elemSize();
-    CV_Assert(srcElemStep == jElemStep);
 
-    vector<float> spaceWeightsv(d*d);
-    vector<int> spaceOfsJointv(d*d);
-    float *spaceWeights = &spaceWeightsv[0];
-    int *spaceOfsJoint = &spaceOfsJointv[0];
+    // the bordered guides are allocated like srcTemp, so the offsets in elements are the same for both
+    int d = 2*radius + 1;
+    size_t srcElemStep = srcTemp.step / srcTemp.elemSize();
+    double gaussSpaceCoeff = -0.5 / (sigmaSpace*sigmaSpace);
 
-    int maxk = 0;
+    spaceWeights.resize(d*d);
+    spaceOfs.resize(d*d);
+    maxk = 0;
     for (int i = -radius; i <= radius; i++)
     {
         for (int j = -radius; j <= radius; j++)
         {
             double r2 = i*i + j*j;
-            if (r2 > SQR(radius))
+            if (circularKernel && r2 > SQR(radius))
                 continue;
 
-            spaceWeights[maxk] = (float)std::exp(r2 * gaussSpaceCoeff);
-            spaceOfsJoint[maxk] = (int)(i*jElemStep + j);
+            spaceWeights[maxk] = (float) std::exp(r2 * gaussSpaceCoeff);
+            spaceOfs[maxk] = (int) (i*srcElemStep + j);
             maxk++;
         }
     }
+}
+
+void JointBilateralFilterBackend::filter(const Mat& joint, Mat& dst)
+{
+    CV_Assert(joint.size() == src.size() && joint.depth() == src.depth());
+    CV_Assert(joint.channels() == 1 || joint.channels() == 3);
+
+    copyMakeBorder(joint, jointTemp, radius, radius, radius, radius, borderType);
+    CV_Assert(jointTemp.step / jointTemp.elemSize() == srcTemp.step / srcTemp.elemSize());
+
+    dst.create(src.size(), src.type());
+    if (src.depth() == CV_8U)
+        filter_8u(dst);
+    else
+        filter_32f(joint, dst);
+}
+
+void JointBilateralFilterBackend::filter_32f(const Mat& joint, Mat& dst)
+{
+    int jCn = joint.channels();
+    const int kExpNumBinsPerChannel = 1 << 12;
+    double minValJoint, maxValJoint;
+
+    minMaxLoc(joint, &minValJoint, &maxValJoint);
+    if (!colorL2 && abs(maxValJoint - minValJoint) < FLT_EPSILON)
+    {
+        //TODO: make circle pattern instead of square
+        int d = 2*radius + 1;
+        GaussianBlur(src, dst, Size(d, d), sigmaSpace, 0, borderType);
+        return;
+    }
+    // the LUT spans the largest color distance of the guide
+    float colorRange = (float)(maxValJoint - minValJoint);
+    colorRange = colorL2 ? colorRange*colorRange*jCn : colorRange*jCn;
+    colorRange = std::max(colorL2 ? 1e-4f : 0.01f, colorRange);
+
+    int kExpNumBins = kExpNumBinsPerChannel * jCn;
+    expLUT.resize(kExpNumBins + 2);
+    expLUTChannels = 0;
+    float scaleIndex = kExpNumBins/colorRange;
+
+    double gaussColorCoeff = -0.5 / (sigmaColor*sigmaColor);
+
+    for (int i = 0; i < kExpNumBins + 2; i++)
+    {
+        double val = i / scaleIndex;
+        expLUT[i] = (float) std::exp((colorL2 ? val : val * val) * gaussColorCoeff);
+    }
+
+    if (colorL2)
+        runJointBilateralFilter_32f<true>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, &spaceOfs[0], &spaceWeights[0], &expLUT[0]);
+    else
+        runJointBilateralFilter_32f<false>(jointTemp, srcTemp, dst, radius, maxk, scaleIndex, &spaceOfs[0], &spaceWeights[0], &expLUT[0]);
+}
+
+void JointBilateralFilterBackend::filter_8u(Mat& dst)
+{
+    int jCn = jointTemp.channels();
+
+    // the LUT of the 8-bit guides only depends on their number of channels
+    if (expLUTChannels != jCn)
+    {
+        double gaussColorCoeff = -0.5 / (sigmaColor*sigmaColor);
+        expLUT.resize(jCn*256);
+        for (int i = 0; i < (int)expLUT.size(); i++)
+            expLUT[i] = (float)std::exp(i * i * gaussColorCoeff);
+        expLUTChannels = jCn;
+    }
 
     Range range(0, src.rows);
-    if (joint.type() == CV_8UC1)
+    const int *ofs = &spaceOfs[0];
+    const float *sw = &spaceWeights[0], *lut = &expLUT[0];
+    if (jCn == 1)
     {
-        if (src.type() == CV_8UC1)
-        {
-            parallel_for_(range, JointBilateralFilter_8u<Vec1b, Vec1b>(jointTemp, srcTemp, dst, radius, maxk, spaceOfsJoint, spaceWeights, expLUT));
-        }
-        if (src.type() == CV_8UC3)
-        {
-            parallel_for_(range, JointBilateralFilter_8u<Vec1b, Vec3b>(jointTemp, srcTemp, dst, radius, maxk, spaceOfsJoint, spaceWeights, expLUT));
-        }
+        if (src.channels() == 1)
+            parallel_for_(range, JointBilateralFilter_8u<Vec1b, Vec1b>(jointTemp, srcTemp, dst, radius, maxk, ofs, sw, lut));
+        if (src.channels() == 3)
+            parallel_for_(range, JointBilateralFilter_8u<Vec1b, Vec3b>(jointTemp, srcTemp, dst, radius, maxk, ofs, sw, lut));
     }
 
-    if (joint.type() == CV_8UC3)
+    if (jCn == 3)
     {
-        if (src.type() == CV_8UC1)
-        {
-            parallel_for_(range, JointBilateralFilter_8u<Vec3b, Vec1b>(jointTemp, srcTemp, dst, radius, maxk, spaceOfsJoint, spaceWeights, expLUT));
-        }
-        if (src.type() == CV_8UC3)
-        {
-            parallel_for_(range, JointBilateralFilter_8u<Vec3b, Vec3b>(jointTemp, srcTemp, dst, radius, maxk, spaceOfsJoint, spaceWeights, expLUT));
-        }
+        if (src.channels() == 1)
+            parallel_for_(range, JointBilateralFilter_8u<Vec3b, Vec1b>(jointTemp, srcTemp, dst, radius, maxk, ofs, sw, lut));
+        if (src.channels() == 3)
+            parallel_for_(range, JointBilateralFilter_8u<Vec3b, Vec3b>(jointTemp, srcTemp, dst, radius, maxk, ofs, sw, lut));
     }
 }
 
@@ -373,24 +367,13 @@ void jointBilateralFilter(InputArray joint_, InputArray src_, OutputArray dst_,
     dst_.create(src.size(), src.type());
     Mat dst = dst_.getMat();
 
-    if (dst.data == joint.data)
-        joint = joint.clone();
-    if (dst.data == src.data)
-        src = src.clone();
-
     int jointCnNum = joint.channels();
     int srcCnNum = src.channels();
 
     if ( (srcCnNum == 1 || srcCnNum == 3) && (jointCnNum == 1 || jointCnNum == 3) )
     {
-        if (joint.depth() == CV_8U)
-        {
-            jointBilateralFilter_8u(joint, src, dst, radius, sigmaColor, sigmaSpace, borderType);
-        }
-        else
-        {
-            jointBilateralFilter_32f(joint, src, dst, radius, sigmaColor, sigmaSpace, borderType);
-        }
+        // the source and the guide are bordered into buffers of their own, so either may be dst
+        JointBilateralFilterBackend(src, radius, sigmaColor, sigmaSpace, borderType).filter(joint, dst);
     }
     else
     {
@@ -399,4 +382,4 @@ void jointBilateralFilter(InputArray joint_, InputArray src_, OutputArray dst_,
 }
 
 }
-}
\ No newline at end of file
+}
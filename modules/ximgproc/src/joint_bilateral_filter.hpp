@@ -0,0 +1,90 @@
+/*
+ *  By downloading, copying, installing or using the software you agree to this license.
+ *  If you do not agree to this license, do not download, install,
+ *  copy or use the software.
+ *
+ *
+ *  License Agreement
+ *  For Open Source Computer Vision Library
+ *  (3 - clause BSD License)
+ *
+ *  Redistribution and use in source and binary forms, with or without modification,
+ *  are permitted provided that the following conditions are met :
+ *
+ *  *Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and / or other materials provided with the distribution.
+ *
+ *  * Neither the names of the copyright holders nor the names of the contributors
+ *  may be used to endorse or promote products derived from this software
+ *  without specific prior written permission.
+ *
+ *  This software is provided by the copyright holders and contributors "as is" and
+ *  any express or implied warranties, including, but not limited to, the implied
+ *  warranties of merchantability and fitness for a particular purpose are disclaimed.
+ *  In no event shall copyright holders or contributors be liable for any direct,
+ *  indirect, incidental, special, exemplary, or consequential damages
+ *  (including, but not limited to, procurement of substitute goods or services;
+ *  loss of use, data, or profits; or business interruption) however caused
+ *  and on any theory of liability, whether in contract, strict liability,
+ *  or tort(including negligence or otherwise) arising in any way out of
+ *  the use of this software, even if advised of the possibility of such damage.
+ */
+
+#ifndef __OPENCV_JOINT_BILATERAL_FILTER_HPP__
+#define __OPENCV_JOINT_BILATERAL_FILTER_HPP__
+#ifdef __cplusplus
+
+#include <vector>
+
+namespace cv
+{
+namespace ximgproc
+{
+
+/* Joint bilateral filtering of one source image by guides that may change from call to call, the
+ * backend of jointBilateralFilter, rollingGuidanceFilter and bilateralTextureFilter.
+ * The bordered source and the spatial kernel are built once by the constructor, each filter() call
+ * only borders the new guide (and, for floating point guides, rescales the color LUT to its range).
+ * The rows of the output are filtered in parallel.
+ */
+class JointBilateralFilterBackend
+{
+public:
+
+    /* src: 8-bit or 32-bit float image with 1 or 3 channels.
+     * colorL2: the color distance is the squared L2 norm, weighted by exp(-0.5*dist/sigmaColor^2),
+     * instead of the L1 norm weighted by exp(-0.5*dist^2/sigmaColor^2) of jointBilateralFilter (32-bit only).
+     * circularKernel: the kernel is the disc of the given radius instead of the whole square.
+     */
+    JointBilateralFilterBackend(const Mat& src, int radius, double sigmaColor, double sigmaSpace, int borderType,
+                                bool colorL2 = false, bool circularKernel = true);
+
+    /* joint: guide of the size and depth of the source, with 1 or 3 channels. It may be dst. */
+    void filter(const Mat& joint, Mat& dst);
+
+private:
+
+    Mat src, srcTemp, jointTemp;
+    int radius, borderType;
+    double sigmaColor, sigmaSpace;
+    bool colorL2;
+
+    int maxk;
+    std::vector<int> spaceOfs;
+    std::vector<float> spaceWeights;
+    std::vector<float> expLUT;
+    int expLUTChannels;
+
+    void filter_8u(Mat& dst);
+    void filter_32f(const Mat& joint, Mat& dst);
+};
+
+}
+}
+
+#endif
+#endif
@@ -238,6 +238,27 @@ namespace
 
         return mag;
     }
+
+    // |F(dx)|^2 + |F(dy)|^2 of the gradient operators only depends on the image size,
+    // it is kept for the next calls, e.g. on the frames of a video
+    Mutex gradientDenomMutex;
+    Mat cachedGradientDenom;
+
+    Mat gradientDenom(int rows, int cols)
+    {
+        AutoLock lock(gradientDenomMutex);
+        if(cachedGradientDenom.rows != rows || cachedGradientDenom.cols != cols)
+        {
+            Mat otfFx, otfFy;
+            float kernel_inv[2] = {1,-1};
+            psf2otf(Mat(1,2,CV_32FC1, kernel_inv), otfFx, rows, cols);
+            psf2otf(Mat(2,1,CV_32FC1, kernel_inv), otfFy, rows, cols);
+
+            // a new matrix, the previous one may still be used by another call
+            cachedGradientDenom = pow2absComplex(otfFx) + pow2absComplex(otfFy);
+        }
+        return cachedGradientDenom;
+    }
 }
 
 namespace cv
@@ -276,19 +297,9 @@ namespace cv
             const double betaMax = 100000;
 
             // gradient operators in frequency domain
-            Mat otfFx, otfFy;
             float kernel[2] = {-1, 1};
             float kernel_inv[2] = {1,-1};
-            psf2otf(Mat(1,2,CV_32FC1, kernel_inv), otfFx, S.rows, S.cols);
-            psf2otf(Mat(2,1,CV_32FC1, kernel_inv), otfFy, S.rows, S.cols);
-
-            vector<Mat> denomConst;
-            Mat tmp = pow2absComplex(otfFx) + pow2absComplex(otfFy);
-
-            for(int i = 0; i < S.channels(); i++)
-            {
-                denomConst.push_back(tmp);
-            }
+            Mat denomConst = gradientDenom(S.rows, S.cols);
 
             // input image in frequency domain
             vector<Mat> numerConst;
@@ -333,12 +344,9 @@ namespace cv
                 h = h.mul(mask);
                 v = v.mul(mask);
 
-                // S subproblem
-                vector<Mat> denom(S.channels());
-                for(int i = 0; i < S.channels(); i++)
-                {
-                    denom[i] = beta * denomConst[i] + 1;
-                }
+                // S subproblem, the denominator is shared by the channels
+                Mat denomShared = beta * denomConst + 1;
+                vector<Mat> denom(S.channels(), denomShared);
 
                 Mat hGrad, vGrad;
                 filter2D(h, hGrad, -1, Mat(1, 2, CV_32FC1, kernel_inv));
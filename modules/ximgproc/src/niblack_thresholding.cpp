@@ -46,29 +46,146 @@
 namespace cv {
 namespace ximgproc {
 
+// Mean and standard deviation of the blockSize x blockSize window starting at column x of the
+// integral rows sum0/sum1 and sqsum0/sqsum1, blockSize rows apart
+static inline void windowStats(const double* sum0, const double* sum1, const double* sqsum0, const double* sqsum1,
+                               int x, int blockSize, double invArea, double& mean, double& stddev)
+{
+    int x1 = x + blockSize;
+    mean = (sum1[x1] - sum1[x] - sum0[x1] + sum0[x]) * invArea;
+    double sqmean = (sqsum1[x1] - sqsum1[x] - sqsum0[x1] + sqsum0[x]) * invArea;
+    stddev = std::sqrt(std::max(sqmean - mean * mean, 0.));
+}
+
+// Standard deviations of all the windows, only needed for the maximum used by BINARIZATION_WOLF
+class NiBlackStddevInvoker : public ParallelLoopBody
+{
+public:
+    NiBlackStddevInvoker(const Mat& sum, const Mat& sqsum, Mat& stddev, int blockSize)
+        : sum_(sum), sqsum_(sqsum), stddev_(stddev), blockSize_(blockSize)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        double invArea = 1. / (blockSize_ * blockSize_);
+        for (int y = range.start; y < range.end; y++)
+        {
+            const double* sum0 = sum_.ptr<double>(y);
+            const double* sum1 = sum_.ptr<double>(y + blockSize_);
+            const double* sqsum0 = sqsum_.ptr<double>(y);
+            const double* sqsum1 = sqsum_.ptr<double>(y + blockSize_);
+            float* dst = stddev_.ptr<float>(y);
+            for (int x = 0; x < stddev_.cols; x++)
+            {
+                double mean, stddev;
+                windowStats(sum0, sum1, sqsum0, sqsum1, x, blockSize_, invArea, mean, stddev);
+                dst[x] = (float)stddev;
+            }
+        }
+    }
+
+private:
+    const Mat& sum_;
+    const Mat& sqsum_;
+    Mat& stddev_;
+    int blockSize_;
+
+    NiBlackStddevInvoker& operator=(const NiBlackStddevInvoker&); // to quiet MSVC
+};
+
+// Computes the local threshold of every pixel and applies it, a range of rows at a time
+template<typename T>
+class NiBlackThresholdInvoker : public ParallelLoopBody
+{
+public:
+    NiBlackThresholdInvoker(const Mat& src, const Mat& sum, const Mat& sqsum, Mat& dst, int blockSize,
+                            int type, double maxValue, double k, int method, double r,
+                            double srcMin, double maxStddev)
+        : src_(src), sum_(sum), sqsum_(sqsum), dst_(dst), blockSize_(blockSize), type_(type),
+          maxValue_(saturate_cast<T>(maxValue)), k_(k), method_(method), r_(r), srcMin_(srcMin),
+          maxStddev_(maxStddev)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        double invArea = 1. / (blockSize_ * blockSize_);
+        for (int y = range.start; y < range.end; y++)
+        {
+            const double* sum0 = sum_.ptr<double>(y);
+            const double* sum1 = sum_.ptr<double>(y + blockSize_);
+            const double* sqsum0 = sqsum_.ptr<double>(y);
+            const double* sqsum1 = sqsum_.ptr<double>(y + blockSize_);
+            const T* src = src_.ptr<T>(y);
+            T* dst = dst_.ptr<T>(y);
+            for (int x = 0; x < src_.cols; x++)
+            {
+                double mean, stddev, thresh;
+                windowStats(sum0, sum1, sqsum0, sqsum1, x, blockSize_, invArea, mean, stddev);
+                switch (method_)
+                {
+                case BINARIZATION_SAUVOLA:
+                    thresh = mean * (1. + k_ * (stddev / r_ - 1.));
+                    break;
+                case BINARIZATION_WOLF:
+                    thresh = mean - k_ * (1. - (maxStddev_ > 0 ? stddev / maxStddev_ : 0.)) * (mean - srcMin_);
+                    break;
+                default:
+                    thresh = mean + k_ * stddev;
+                    break;
+                }
+                // the threshold has the depth of the image, as the comparisons are done in it
+                T t = saturate_cast<T>((float)thresh);
+                T v = src[x];
+                switch (type_)
+                {
+                case THRESH_BINARY:     dst[x] = v > t ? maxValue_ : T(0); break;
+                case THRESH_BINARY_INV: dst[x] = v > t ? T(0) : maxValue_; break;
+                case THRESH_TRUNC:      dst[x] = v > t ? t : v; break;
+                case THRESH_TOZERO:     dst[x] = v > t ? v : T(0); break;
+                default:                dst[x] = v > t ? T(0) : v; break;
+                }
+            }
+        }
+    }
+
+private:
+    const Mat& src_;
+    const Mat& sum_;
+    const Mat& sqsum_;
+    Mat& dst_;
+    int blockSize_, type_;
+    T maxValue_;
+    double k_;
+    int method_;
+    double r_, srcMin_, maxStddev_;
+
+    NiBlackThresholdInvoker& operator=(const NiBlackThresholdInvoker&); // to quiet MSVC
+};
+
 void niBlackThreshold( InputArray _src, OutputArray _dst, double maxValue,
-        int type, int blockSize, double delta )
+        int type, int blockSize, double delta, int binarizationMethod, double r )
 {
     // Input grayscale image
     Mat src = _src.getMat();
     CV_Assert(src.channels() == 1);
     CV_Assert(blockSize % 2 == 1 && blockSize > 1);
+    CV_Assert(binarizationMethod == BINARIZATION_NIBLACK || binarizationMethod == BINARIZATION_SAUVOLA ||
+              binarizationMethod == BINARIZATION_WOLF);
     type &= THRESH_MASK;
+    if (type != THRESH_BINARY && type != THRESH_BINARY_INV && type != THRESH_TRUNC &&
+        type != THRESH_TOZERO && type != THRESH_TOZERO_INV)
+        CV_Error( CV_StsBadArg, "Unknown threshold type" );
 
-    // Compute local threshold (T = mean + k * stddev)
-    // using mean and standard deviation in the neighborhood of each pixel
-    // (intermediate calculations are done with floating-point precision)
-    Mat thresh;
+    // Local means and standard deviations (Var[X] = E[X^2] - E[X]^2) from the integral images of
+    // the source bordered like the box filters they replace
+    Mat sum, sqsum;
     {
-        // note that: Var[X] = E[X^2] - E[X]^2
-        Mat mean, sqmean, stddev;
-        boxFilter(src, mean, CV_32F, Size(blockSize, blockSize),
-                Point(-1,-1), true, BORDER_REPLICATE);
-        sqrBoxFilter(src, sqmean, CV_32F, Size(blockSize, blockSize),
-                Point(-1,-1), true, BORDER_REPLICATE);
-        sqrt(sqmean - mean.mul(mean), stddev);
-        thresh = mean + stddev * static_cast<float>(delta);
-        thresh.convertTo(thresh, src.depth());
+        Mat padded;
+        int radius = blockSize / 2;
+        copyMakeBorder(src, padded, radius, radius, radius, radius, BORDER_REPLICATE);
+        integral(padded, sum, sqsum, CV_64F, CV_64F);
     }
 
     // Prepare output image
@@ -76,29 +193,38 @@ void niBlackThreshold( InputArray _src, OutputArray _dst, double maxValue,
     Mat dst = _dst.getMat();
     CV_Assert(src.data != dst.data);  // no inplace processing
 
+    // Wolf's threshold needs the contrast of the whole image first
+    double srcMin = 0, maxStddev = 0;
+    if (binarizationMethod == BINARIZATION_WOLF)
+    {
+        Mat stddev(src.size(), CV_32F);
+        parallel_for_(Range(0, src.rows), NiBlackStddevInvoker(sum, sqsum, stddev, blockSize));
+        minMaxLoc(src, &srcMin);
+        minMaxLoc(stddev, 0, &maxStddev);
+    }
+
     // Apply thresholding: ( pixel > threshold ) ? foreground : background
-    Mat mask;
-    switch (type)
+    Range rows(0, src.rows);
+    switch (src.depth())
     {
-    case THRESH_BINARY:      // dst = (src > thresh) ? maxval : 0
-    case THRESH_BINARY_INV:  // dst = (src > thresh) ? 0 : maxval
-        compare(src, thresh, mask, (type == THRESH_BINARY ? CMP_GT : CMP_LE));
-        dst.setTo(0);
-        dst.setTo(maxValue, mask);
+    case CV_8U:
+        parallel_for_(rows, NiBlackThresholdInvoker<uchar>(src, sum, sqsum, dst, blockSize, type, maxValue, delta,
+                                                           binarizationMethod, r, srcMin, maxStddev));
+        break;
+    case CV_16U:
+        parallel_for_(rows, NiBlackThresholdInvoker<ushort>(src, sum, sqsum, dst, blockSize, type, maxValue, delta,
+                                                            binarizationMethod, r, srcMin, maxStddev));
         break;
-    case THRESH_TRUNC:       // dst = (src > thresh) ? thresh : src
-        compare(src, thresh, mask, CMP_GT);
-        src.copyTo(dst);
-        thresh.copyTo(dst, mask);
+    case CV_16S:
+        parallel_for_(rows, NiBlackThresholdInvoker<short>(src, sum, sqsum, dst, blockSize, type, maxValue, delta,
+                                                           binarizationMethod, r, srcMin, maxStddev));
         break;
-    case THRESH_TOZERO:      // dst = (src > thresh) ? src : 0
-    case THRESH_TOZERO_INV:  // dst = (src > thresh) ? 0 : src
-        compare(src, thresh, mask, (type == THRESH_TOZERO ? CMP_GT : CMP_LE));
-        dst.setTo(0);
-        src.copyTo(dst, mask);
+    case CV_32F:
+        parallel_for_(rows, NiBlackThresholdInvoker<float>(src, sum, sqsum, dst, blockSize, type, maxValue, delta,
+                                                           binarizationMethod, r, srcMin, maxStddev));
         break;
     default:
-        CV_Error( CV_StsBadArg, "Unknown threshold type" );
+        CV_Error( CV_StsUnsupportedFormat, "Unsupported image depth" );
         break;
     }
 }
@@ -0,0 +1,89 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+// One pass of the Fast Global Smoother: each work-item solves the tridiagonal system of a row
+// (horizontal pass) or of a column (vertical pass) in place with the Thomas algorithm, the same
+// recurrences as the CPU passes of fgs_filter.cpp.
+// The weights are given as float images, w[k] being the weight between pixels k and k+1.
+
+__kernel void fgs_horizontal_pass(__global const uchar * wptr, int w_step, int w_offset,
+                                  __global uchar * dptr, int d_step, int d_offset,
+                                  __global uchar * curptr, int cur_step, int cur_offset, int rows, int cols,
+                                  float lambda)
+{
+    int y = get_global_id(0);
+    if (y >= rows)
+        return;
+
+    __global const float * weights = (__global const float *)(wptr + mad24(y, w_step, w_offset));
+    __global float * interD = (__global float *)(dptr + mad24(y, d_step, d_offset));
+    __global float * cur = (__global float *)(curptr + mad24(y, cur_step, cur_offset));
+
+    // forward pass:
+    float coef_prev = lambda * weights[0];
+    float interD_prev = coef_prev / (1 - coef_prev);
+    float cur_prev = cur[0] / (1 - coef_prev);
+    interD[0] = interD_prev;
+    cur[0] = cur_prev;
+    for (int x = 1; x < cols; x++)
+    {
+        float coef_cur = lambda * weights[x];
+        float denom = (1 - coef_prev - coef_cur) - interD_prev * coef_prev;
+        interD_prev = coef_cur / denom;
+        cur_prev = (cur[x] - cur_prev * coef_prev) / denom;
+        interD[x] = interD_prev;
+        cur[x] = cur_prev;
+        coef_prev = coef_cur;
+    }
+
+    // backward pass:
+    float cur_next = cur_prev;
+    for (int x = cols - 2; x >= 0; x--)
+    {
+        cur_next = cur[x] - interD[x] * cur_next;
+        cur[x] = cur_next;
+    }
+}
+
+// The columns being next to each other in memory, neighbouring work-items read neighbouring floats.
+__kernel void fgs_vertical_pass(__global const uchar * wptr, int w_step, int w_offset,
+                                __global uchar * dptr, int d_step, int d_offset,
+                                __global uchar * curptr, int cur_step, int cur_offset, int rows, int cols,
+                                float lambda)
+{
+    int x = get_global_id(0);
+    if (x >= cols)
+        return;
+
+    wptr += w_offset + x * (int)sizeof(float);
+    dptr += d_offset + x * (int)sizeof(float);
+    curptr += cur_offset + x * (int)sizeof(float);
+
+    // forward pass:
+    float coef_prev = lambda * *(__global const float *)wptr;
+    float interD_prev = coef_prev / (1 - coef_prev);
+    float cur_prev = *(__global float *)curptr / (1 - coef_prev);
+    *(__global float *)dptr = interD_prev;
+    *(__global float *)curptr = cur_prev;
+    for (int y = 1; y < rows; y++)
+    {
+        float coef_cur = lambda * *(__global const float *)(wptr + y * w_step);
+        float denom = (1 - coef_prev - coef_cur) - interD_prev * coef_prev;
+        __global float * cur = (__global float *)(curptr + y * cur_step);
+        interD_prev = coef_cur / denom;
+        cur_prev = (*cur - cur_prev * coef_prev) / denom;
+        *(__global float *)(dptr + y * d_step) = interD_prev;
+        *cur = cur_prev;
+        coef_prev = coef_cur;
+    }
+
+    // backward pass:
+    float cur_next = cur_prev;
+    for (int y = rows - 2; y >= 0; y--)
+    {
+        __global float * cur = (__global float *)(curptr + y * cur_step);
+        cur_next = *cur - *(__global const float *)(dptr + y * d_step) * cur_next;
+        *cur = cur_next;
+    }
+}
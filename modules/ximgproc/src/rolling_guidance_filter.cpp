@@ -35,6 +35,7 @@
  */
 
 #include "precomp.hpp"
+#include "joint_bilateral_filter.hpp"
 #include <opencv2/ximgproc.hpp>
 #include <opencv2/highgui.hpp>
 
@@ -58,20 +59,23 @@ namespace ximgproc
         if (sigmaSpace <= 0)
             sigmaSpace = 1;
 
-        dst_.create(src.size(), src.type());
-        Mat dst = dst_.getMat();
-
-        if (src.data == guidance.data)
-            guidance = guidance.clone();
-        if (dst.data == src.data)
-            src = src.clone();
+        // the same kernel as jointBilateralFilter
+        int radius;
+        if (d <= 0)
+            radius = cvRound(sigmaSpace*1.5);
+        else
+            radius = d / 2;
+        radius = std::max(radius, 1);
 
         int srcCnNum = src.channels();
 
         if (srcCnNum == 1 || srcCnNum == 3)
         {
+            // every iteration filters the same source, only the guidance changes
+            JointBilateralFilterBackend jbf(src, radius, sigmaColor, sigmaSpace, borderType);
+            guidance = guidance.clone();
             while(numOfIter--){
-                jointBilateralFilter(guidance, src, guidance, d, sigmaColor, sigmaSpace, borderType);
+                jbf.filter(guidance, guidance);
             }
             guidance.copyTo(dst_);
         }
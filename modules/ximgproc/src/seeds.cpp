@@ -109,6 +109,41 @@ private:
     inline void updateLabels();
     // main loop for pixel updating
     void updatePixels();
+    // pixel updates of the rows [y_begin, y_end), along the rows or the columns
+    void updatePixelsHorizontal(int y_begin, int y_end);
+    void updatePixelsVertical(int y_begin, int y_end);
+    // true if no superpixel can reach two stripes of rows of the same parity during an update
+    bool labelsFitInStripes(int stripe_height);
+
+    // Updates the pixels of every other stripe of rows. The stripes of a phase are separated by a
+    // stripe higher than any superpixel, so they update different labels and histograms.
+    class UpdatePixelsInvoker : public ParallelLoopBody
+    {
+    public:
+        UpdatePixelsInvoker(SuperpixelSEEDSImpl& _seeds, bool _vertical, int _phase, int _stripe_height)
+            : seeds(_seeds), vertical(_vertical), phase(_phase), stripe_height(_stripe_height) {}
+
+        void operator()(const Range& range) const
+        {
+            for (int i = range.start; i < range.end; i++)
+            {
+                int y_begin = (2 * i + phase) * stripe_height;
+                int y_end = std::min(y_begin + stripe_height, seeds.height);
+                if( vertical )
+                    seeds.updatePixelsVertical(y_begin, y_end);
+                else
+                    seeds.updatePixelsHorizontal(y_begin, y_end);
+            }
+        }
+
+    private:
+        SuperpixelSEEDSImpl& seeds;
+        bool vertical;
+        int phase;
+        int stripe_height;
+
+        UpdatePixelsInvoker& operator=(const UpdatePixelsInvoker&); // to quiet MSVC
+    };
 
 
     /* block operations */
@@ -636,13 +671,91 @@ int SuperpixelSEEDSImpl::goDownOneLevel()
 }
 
 void SuperpixelSEEDSImpl::updatePixels()
+{
+    int labelA;
+    int labelB;
+
+    // The rows are updated by stripes a few superpixels high, first the even stripes and then the
+    // odd ones. The stripes of a phase run in parallel when no superpixel can reach two of them.
+    int superpixel_height = height / nr_wh[2 * seeds_top_level + 1];
+    int stripe_height = std::max(3 * superpixel_height, 16);
+    int nr_stripes = (height + stripe_height - 1) / stripe_height;
+    bool parallel = nr_stripes > 2 && labelsFitInStripes(stripe_height);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        bool vertical = pass == 1;
+        for (int phase = 0; phase < 2; phase++)
+        {
+            int nr_phase_stripes = (nr_stripes - phase + 1) / 2;
+            UpdatePixelsInvoker invoker(*this, vertical, phase, stripe_height);
+            if( parallel )
+                parallel_for_(Range(0, nr_phase_stripes), invoker);
+            else
+                invoker(Range(0, nr_phase_stripes));
+        }
+    }
+    forwardbackward = !forwardbackward;
+
+    // update border pixels
+    for (int x = 0; x < width; x++)
+    {
+        labelA = labels[x];
+        labelB = labels[width + x];
+        if( labelA != labelB )
+            update(labelB, x, labelA);
+        labelA = labels[(height - 1) * width + x];
+        labelB = labels[(height - 2) * width + x];
+        if( labelA != labelB )
+            update(labelB, (height - 1) * width + x, labelA);
+    }
+    for (int y = 0; y < height; y++)
+    {
+        labelA = labels[y * width];
+        labelB = labels[y * width + 1];
+        if( labelA != labelB )
+            update(labelB, y * width, labelA);
+        labelA = labels[y * width + width - 1];
+        labelB = labels[y * width + width - 2];
+        if( labelA != labelB )
+            update(labelB, y * width + width - 1, labelA);
+    }
+}
+
+bool SuperpixelSEEDSImpl::labelsFitInStripes(int stripe_height)
+{
+    int nr_labels = nrLabels(seeds_top_level);
+    vector<int> min_y(nr_labels, height), max_y(nr_labels, -1);
+
+    for (int y = 0; y < height; y++)
+    {
+        const int* row = labels + y * width;
+        for (int x = 0; x < width; x++)
+        {
+            int label = row[x];
+            min_y[label] = std::min(min_y[label], y);
+            max_y[label] = std::max(max_y[label], y);
+        }
+    }
+
+    // A stripe reads and writes a row above and two rows below itself, and a superpixel grows by
+    // at most one row on each side during the horizontal and the vertical updates.
+    for (int label = 0; label < nr_labels; label++)
+    {
+        if( max_y[label] >= 0 && max_y[label] - min_y[label] + 1 + 8 >= stripe_height )
+            return false;
+    }
+    return true;
+}
+
+void SuperpixelSEEDSImpl::updatePixelsHorizontal(int y_begin, int y_end)
 {
     int labelA;
     int labelB;
     int priorA = 0;
     int priorB = 0;
 
-    for (int y = 1; y < height - 1; y++)
+    for (int y = std::max(y_begin, 1); y < std::min(y_end, height - 1); y++)
     {
         for (int x = 1; x < width - 2; x++)
         {
@@ -733,10 +846,18 @@ void SuperpixelSEEDSImpl::updatePixels()
             } // labelA != labelB
         } // for x
     } // for y
+}
+
+void SuperpixelSEEDSImpl::updatePixelsVertical(int y_begin, int y_end)
+{
+    int labelA;
+    int labelB;
+    int priorA = 0;
+    int priorB = 0;
 
     for (int x = 1; x < width - 1; x++)
     {
-        for (int y = 1; y < height - 2; y++)
+        for (int y = std::max(y_begin, 1); y < std::min(y_end, height - 2); y++)
         {
 
             labelA = labels[(y) * width + (x)];
@@ -825,31 +946,6 @@ void SuperpixelSEEDSImpl::updatePixels()
             } // labelA != labelB
         } // for y
     } // for x
-    forwardbackward = !forwardbackward;
-
-    // update border pixels
-    for (int x = 0; x < width; x++)
-    {
-        labelA = labels[x];
-        labelB = labels[width + x];
-        if( labelA != labelB )
-            update(labelB, x, labelA);
-        labelA = labels[(height - 1) * width + x];
-        labelB = labels[(height - 2) * width + x];
-        if( labelA != labelB )
-            update(labelB, (height - 1) * width + x, labelA);
-    }
-    for (int y = 0; y < height; y++)
-    {
-        labelA = labels[y * width];
-        labelB = labels[y * width + 1];
-        if( labelA != labelB )
-            update(labelB, y * width, labelA);
-        labelA = labels[y * width + width - 1];
-        labelB = labels[y * width + width - 2];
-        if( labelA != labelB )
-            update(labelB, y * width + width - 1, labelA);
-    }
 }
 
 void SuperpixelSEEDSImpl::update(int label_new, int image_idx, int label_old)
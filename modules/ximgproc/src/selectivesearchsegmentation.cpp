@@ -43,6 +43,8 @@ the use of this software, even if advised of the possibility of such damage.
 #include "opencv2/ximgproc/segmentation.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <map>
 
 namespace cv {
     namespace ximgproc {
@@ -264,6 +266,9 @@ namespace cv {
                     virtual void addStrategy(Ptr<SelectiveSearchSegmentationStrategy> g, float weight);
                     virtual void clearStrategies();
 
+                    const std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& getStrategies() const { return strategies; }
+                    const std::vector<float>& getWeights() const { return weights; }
+
                 private:
                     String name_;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
@@ -684,6 +689,75 @@ namespace cv {
                 return s;
             }
 
+            /****************************************
+             * Parallel runs
+             ***************************************/
+
+            // Creates independent copies of the built-in strategies, so that the groupings of several base
+            // segmentations can run concurrently. A strategy shared by several others stays shared between
+            // their copies, so that its cache for the image is reused as without the copies.
+            class StrategyCloner {
+                public:
+                    bool clone(const std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& src, std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& dst) {
+                        dst.clear();
+                        for (size_t i = 0; i < src.size(); i++) {
+                            Ptr<SelectiveSearchSegmentationStrategy> c = clone(src[i]);
+                            if (c.empty())
+                                return false;
+                            dst.push_back(c);
+                        }
+                        return true;
+                    }
+
+                private:
+                    std::map<const SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> > clones;
+
+                    // Returns an empty pointer for the strategies implemented outside of this file
+                    Ptr<SelectiveSearchSegmentationStrategy> clone(const Ptr<SelectiveSearchSegmentationStrategy>& s) {
+                        std::map<const SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> >::iterator it = clones.find(s.get());
+                        if (it != clones.end())
+                            return it->second;
+
+                        Ptr<SelectiveSearchSegmentationStrategy> c;
+                        const SelectiveSearchSegmentationStrategyMultipleImpl* multiple = dynamic_cast<const SelectiveSearchSegmentationStrategyMultipleImpl*>(s.get());
+
+                        if (multiple) {
+                            Ptr<SelectiveSearchSegmentationStrategyMultipleImpl> m = makePtr<SelectiveSearchSegmentationStrategyMultipleImpl>();
+                            for (size_t i = 0; i < multiple->getStrategies().size(); i++) {
+                                Ptr<SelectiveSearchSegmentationStrategy> sub = clone(multiple->getStrategies()[i]);
+                                if (sub.empty())
+                                    return sub;
+                                m->addStrategy(sub, multiple->getWeights()[i]);
+                            }
+                            c = m;
+                        } else if (dynamic_cast<const SelectiveSearchSegmentationStrategyColorImpl*>(s.get())) {
+                            c = makePtr<SelectiveSearchSegmentationStrategyColorImpl>();
+                        } else if (dynamic_cast<const SelectiveSearchSegmentationStrategySizeImpl*>(s.get())) {
+                            c = makePtr<SelectiveSearchSegmentationStrategySizeImpl>();
+                        } else if (dynamic_cast<const SelectiveSearchSegmentationStrategyFillImpl*>(s.get())) {
+                            c = makePtr<SelectiveSearchSegmentationStrategyFillImpl>();
+                        } else if (dynamic_cast<const SelectiveSearchSegmentationStrategyTextureImpl*>(s.get())) {
+                            c = makePtr<SelectiveSearchSegmentationStrategyTextureImpl>();
+                        } else {
+                            return c;
+                        }
+
+                        clones[s.get()] = c;
+                        return c;
+                    }
+            };
+
+            // A base segmentation of an image, with its regions' sizes, bounding rects and pairs of neighbours
+            struct BaseSegmentation {
+                Mat img_regions;
+                Mat_<int> sizes;
+                int nb_segs;
+                std::vector<Rect> bounding_rects;
+                // neighbours[neighbours_start[i]..neighbours_start[i+1]) are the neighbours of i greater than i
+                std::vector<int> neighbours_start;
+                std::vector<int> neighbours;
+            };
+
             // Core
 
             class SelectiveSearchSegmentationImpl : public SelectiveSearchSegmentation {
@@ -729,7 +803,55 @@ namespace cv {
                     std::vector<Ptr<GraphSegmentation> > segmentations;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
 
-                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int region_id);
+                    static void computeBaseSegmentation(const Mat& img, const Ptr<GraphSegmentation>& gs, BaseSegmentation& base);
+                    static void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const BaseSegmentation& base, std::vector<Region>& regions, int image_id);
+
+                    // Computes the base segmentations of a range of (image, graph segmentation) runs
+                    class BaseSegmentationInvoker : public ParallelLoopBody {
+                        public:
+                            BaseSegmentationInvoker(const std::vector<Mat>& _images, const std::vector<Ptr<GraphSegmentation> >& _segmentations, std::vector<BaseSegmentation>& _bases)
+                                : images(_images), segmentations(_segmentations), bases(_bases) {}
+
+                            void operator()(const Range& range) const {
+                                for (int run = range.start; run < range.end; run++) {
+                                    int nb_gs = (int)segmentations.size();
+                                    computeBaseSegmentation(images[run / nb_gs], segmentations[run % nb_gs], bases[run]);
+                                }
+                            }
+
+                        private:
+                            const std::vector<Mat>& images;
+                            const std::vector<Ptr<GraphSegmentation> >& segmentations;
+                            std::vector<BaseSegmentation>& bases;
+
+                            BaseSegmentationInvoker& operator=(const BaseSegmentationInvoker&); // to quiet MSVC
+                    };
+
+                    // Groups the regions of a range of base segmentations, each run with its own copies of the strategies
+                    class GroupingInvoker : public ParallelLoopBody {
+                        public:
+                            GroupingInvoker(const std::vector<Mat>& _images, int _nb_gs, const std::vector<BaseSegmentation>& _bases,
+                                std::vector<std::vector<Ptr<SelectiveSearchSegmentationStrategy> > >& _strategies, std::vector<std::vector<std::vector<Region> > >& _regions)
+                                : images(_images), nb_gs(_nb_gs), bases(_bases), strategies(_strategies), regions(_regions) {}
+
+                            void operator()(const Range& range) const {
+                                for (int run = range.start; run < range.end; run++) {
+                                    regions[run].resize(strategies[run].size());
+                                    for (size_t st = 0; st < strategies[run].size(); st++) {
+                                        hierarchicalGrouping(images[run / nb_gs], strategies[run][st], bases[run], regions[run][st], run);
+                                    }
+                                }
+                            }
+
+                        private:
+                            const std::vector<Mat>& images;
+                            int nb_gs;
+                            const std::vector<BaseSegmentation>& bases;
+                            std::vector<std::vector<Ptr<SelectiveSearchSegmentationStrategy> > >& strategies;
+                            std::vector<std::vector<std::vector<Region> > >& regions;
+
+                            GroupingInvoker& operator=(const GroupingInvoker&); // to quiet MSVC
+                    };
             };
 
             void SelectiveSearchSegmentationImpl::setBaseImage(InputArray img) {
@@ -885,76 +1007,111 @@ namespace cv {
                 addStrategy(size3);
             }
 
-            void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
+            void SelectiveSearchSegmentationImpl::computeBaseSegmentation(const Mat& img, const Ptr<GraphSegmentation>& gs, BaseSegmentation& base) {
 
-                std::vector<Region> all_regions;
+                Mat& img_regions = base.img_regions;
 
-                int image_id = 0;
+                // Compute initial segmentation
+                gs->processImage(img, img_regions);
 
-                for(std::vector<Mat>::iterator image = images.begin(); image != images.end(); ++image) {
-                    for(std::vector<Ptr<GraphSegmentation> >::iterator gs = segmentations.begin(); gs != segmentations.end(); ++gs) {
+                // Get number of regions
+                double min, max;
+                minMaxLoc(img_regions, &min, &max);
+                int nb_segs = (int)max + 1;
+                base.nb_segs = nb_segs;
 
-                        Mat img_regions;
-                        Mat_<char> is_neighbour;
-                        Mat_<int> sizes;
+                // Compute bouding rects, sizes and neighbours
+                std::vector<Point> tl(nb_segs, Point(img_regions.cols, img_regions.rows)), br(nb_segs, Point(-1, -1));
+                base.sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
 
-                        // Compute initial segmentation
-                        (*gs)->processImage(*image, img_regions);
+                std::vector<std::pair<int, int> > pairs;
+                const int* previous_p = NULL;
 
-                        // Get number of regions
-                        double min, max;
-                        minMaxLoc(img_regions, &min, &max);
-                        int nb_segs = (int)max + 1;
+                for (int i = 0; i < (int)img_regions.rows; i++) {
+                    const int* p = img_regions.ptr<int>(i);
 
-                        // Compute bouding rects and neighbours
-                        std::vector<Rect> bounding_rects;
-                        bounding_rects.resize(nb_segs);
+                    for (int j = 0; j < (int)img_regions.cols; j++) {
+                        int r = p[j];
 
-                        std::vector<std::vector<cv::Point> > points;
+                        tl[r].x = std::min(tl[r].x, j);
+                        tl[r].y = std::min(tl[r].y, i);
+                        br[r].x = std::max(br[r].x, j);
+                        br[r].y = std::max(br[r].y, i);
+                        base.sizes(r, 0)++;
 
-                        points.resize(nb_segs);
+                        if (i > 0 && j > 0) {
+                            int others[3] = { p[j - 1], previous_p[j], previous_p[j - 1] };
 
-                        is_neighbour = Mat::zeros(nb_segs, nb_segs, CV_8UC1);
-                        sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
+                            for (int o = 0; o < 3; o++) {
+                                if (others[o] != r) {
+                                    pairs.push_back(std::make_pair(std::min(r, others[o]), std::max(r, others[o])));
+                                }
+                            }
+                        }
+                    }
+                    previous_p = p;
+                }
 
-                        const int* previous_p = NULL;
+                base.bounding_rects.resize(nb_segs);
+                for (int seg = 0; seg < nb_segs; seg++) {
+                    base.bounding_rects[seg] = br[seg].x < 0 ? Rect() : Rect(tl[seg], br[seg] + Point(1, 1));
+                }
 
-                        for (int i = 0; i < (int)img_regions.rows; i++) {
-                            const int* p = img_regions.ptr<int>(i);
+                std::sort(pairs.begin(), pairs.end());
+                pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
 
-                            for (int j = 0; j < (int)img_regions.cols; j++) {
+                base.neighbours_start.assign(nb_segs + 1, 0);
+                base.neighbours.resize(pairs.size());
+                for (size_t k = 0; k < pairs.size(); k++) {
+                    base.neighbours_start[pairs[k].first + 1]++;
+                    base.neighbours[k] = pairs[k].second;
+                }
+                for (int seg = 0; seg < nb_segs; seg++) {
+                    base.neighbours_start[seg + 1] += base.neighbours_start[seg];
+                }
+            }
 
-                                points[p[j]].push_back(cv::Point(j, i));
-                                sizes.at<int>(p[j], 0) = sizes.at<int>(p[j], 0) + 1;
+            void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
 
-                                if (i > 0 && j > 0) {
+                int nb_gs = (int)segmentations.size();
+                int nb_runs = (int)images.size() * nb_gs;
 
-                                    is_neighbour.at<char>(p[j], p[j - 1]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j - 1]) = 1;
+                // Base segmentations of every (image, graph segmentation) run, image_id being the index of the run
+                std::vector<BaseSegmentation> bases(nb_runs);
+                parallel_for_(Range(0, nb_runs), BaseSegmentationInvoker(images, segmentations, bases));
 
-                                    is_neighbour.at<char>(p[j - 1], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j - 1], p[j]) = 1;
-                                }
-                            }
-                            previous_p = p;
-                        }
+                // The groupings run concurrently when each of them can have its own strategies
+                std::vector<std::vector<Ptr<SelectiveSearchSegmentationStrategy> > > run_strategies(nb_runs);
+                bool concurrent = true;
+                for (int run = 0; run < nb_runs && concurrent; run++) {
+                    StrategyCloner cloner;
+                    concurrent = cloner.clone(strategies, run_strategies[run]);
+                }
 
-                        for(int seg = 0; seg < nb_segs; seg++) {
-                            bounding_rects[seg] = cv::boundingRect(points[seg]);
+                std::vector<std::vector<std::vector<Region> > > run_regions(nb_runs);
+                if (concurrent) {
+                    parallel_for_(Range(0, nb_runs), GroupingInvoker(images, nb_gs, bases, run_strategies, run_regions));
+                } else {
+                    for (int run = 0; run < nb_runs; run++) {
+                        run_regions[run].resize(strategies.size());
+                        for (size_t st = 0; st < strategies.size(); st++) {
+                            hierarchicalGrouping(images[run / nb_gs], strategies[st], bases[run], run_regions[run][st], run);
                         }
+                    }
+                }
 
-                        for(std::vector<Ptr<SelectiveSearchSegmentationStrategy> >::iterator strategy = strategies.begin(); strategy != strategies.end(); ++strategy) {
-                            std::vector<Region> regions;
-                            hierarchicalGrouping(*image, *strategy, img_regions, is_neighbour, sizes, nb_segs, bounding_rects, regions, image_id);
+                // Compute regions' rank, in the same order as the runs
+                std::vector<Region> all_regions;
 
-                            for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                                all_regions.push_back(*region);
-                            }
-                        }
+                for (int run = 0; run < nb_runs; run++) {
+                    for (size_t st = 0; st < run_regions[run].size(); st++) {
+                        std::vector<Region>& regions = run_regions[run][st];
 
-                        image_id++;
+                        for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
+                            // Note: this is inverted from the paper, but we keep the lover region first so it's works
+                            (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
+                            all_regions.push_back(*region);
+                        }
                     }
                 }
 
@@ -974,16 +1131,24 @@ namespace cv {
 
             }
 
-            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes_, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
+            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const BaseSegmentation& base, std::vector<Region>& regions, int image_id) {
 
-                Mat sizes = sizes_.clone();
+                int nb_segs = base.nb_segs;
+                Mat sizes = base.sizes.clone();
 
-                std::vector<Neighbour> similarities;
                 regions.clear();
+                regions.reserve(2 * nb_segs);
 
                 /////////////////////////////////////////
 
-                s->setImage(img, img_regions, sizes, image_id);
+                s->setImage(img, base.img_regions, sizes, image_id);
+
+                // Neighbours of each region, including the merged ones that are skipped
+                std::vector<std::vector<int> > neighbours(nb_segs);
+                neighbours.reserve(2 * nb_segs);
+
+                // Max-heap of similarities, the ones of merged regions are dropped when they reach the top
+                std::vector<Neighbour> similarities;
 
                 // Compute initial similarities
                 for (int i = 0; i < nb_segs; i++) {
@@ -992,33 +1157,38 @@ namespace cv {
                     r.id = i;
                     r.level = 1;
                     r.merged_to = -1;
-                    r.bounding_box = bounding_rects[i];
+                    r.bounding_box = base.bounding_rects[i];
 
                     regions.push_back(r);
 
-                    for (int j = i + 1; j < nb_segs; j++) {
-                        if (is_neighbour.at<char>(i, j)) {
-                            Neighbour n;
-                            n.from = i;
-                            n.to = j;
-                            n.similarity = s->get(i, j);
+                    for (int k = base.neighbours_start[i]; k < base.neighbours_start[i + 1]; k++) {
+                        Neighbour n;
+                        n.from = i;
+                        n.to = base.neighbours[k];
+                        n.similarity = s->get(i, n.to);
 
-                            similarities.push_back(n);
-                        }
+                        similarities.push_back(n);
+                        neighbours[n.from].push_back(n.to);
+                        neighbours[n.to].push_back(n.from);
                     }
                 }
 
-                while(similarities.size() > 0) {
+                std::make_heap(similarities.begin(), similarities.end());
 
-                    std::sort(similarities.begin(), similarities.end());
+                // Last merged region which listed a region as a neighbour
+                std::vector<int> listed_by(2 * nb_segs, -1);
+                std::vector<int> local_neighbours;
 
-                    // for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end(); ++similarity) {
-                    //     std::cout << *similarity << std::endl;
-                    // }
+                while(similarities.size() > 0) {
 
+                    std::pop_heap(similarities.begin(), similarities.end());
                     Neighbour p = similarities.back();
                     similarities.pop_back();
 
+                    if (regions[p.from].merged_to != -1 || regions[p.to].merged_to != -1) {
+                        continue;
+                    }
+
                     Region region_from = regions[p.from];
                     Region region_to = regions[p.to];
 
@@ -1030,8 +1200,9 @@ namespace cv {
 
                     regions.push_back(new_r);
 
-                    regions[p.from].merged_to = (int)regions.size() - 1;
-                    regions[p.to].merged_to = (int)regions.size() - 1;
+                    int new_region = (int)regions.size() - 1;
+                    regions[p.from].merged_to = new_region;
+                    regions[p.to].merged_to = new_region;
 
                     // Merge
                     s->merge(region_from.id, region_to.id);
@@ -1040,53 +1211,39 @@ namespace cv {
                     sizes.at<int>(region_from.id, 0) += sizes.at<int>(region_to.id, 0);
                     sizes.at<int>(region_to.id, 0) = sizes.at<int>(region_from.id, 0);
 
-                    std::vector<int> local_neighbours;
+                    // The neighbours of the new region are the remaining ones of the two merged regions
+                    local_neighbours.clear();
+                    int merged[2] = { p.from, p.to };
 
-                    for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end();) {
-                        if ((*similarity).from == p.from || (*similarity).to == p.from || (*similarity).from == p.to || (*similarity).to == p.to) {
-                            int from = 0;
+                    for (int m = 0; m < 2; m++) {
+                        const std::vector<int>& merged_neighbours = neighbours[merged[m]];
 
-                            if ((*similarity).from == p.from || (*similarity).from == p.to) {
-                                from = (*similarity).to;
-                            } else {
-                                from = (*similarity).from;
-                            }
+                        for (size_t k = 0; k < merged_neighbours.size(); k++) {
+                            int other = merged_neighbours[k];
 
-                            bool already_neighboor = false;
-
-                            for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
-                                if (*local_neighbour == from) {
-                                    already_neighboor = true;
-                                }
+                            if (regions[other].merged_to == -1 && listed_by[other] != new_region) {
+                                listed_by[other] = new_region;
+                                local_neighbours.push_back(other);
                             }
-
-                            if (!already_neighboor) {
-                                local_neighbours.push_back(from);
-                            }
-
-                            similarity = similarities.erase(similarity);
-                        } else {
-                            similarity++;
                         }
+                        std::vector<int>().swap(neighbours[merged[m]]);
                     }
 
+                    neighbours.push_back(local_neighbours);
+
                     for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
 
                         Neighbour n;
-                        n.from = (int)regions.size() - 1;
+                        n.from = new_region;
                         n.to = *local_neighbour;
                         n.similarity = s->get(regions[n.from].id, regions[n.to].id);
 
                         similarities.push_back(n);
+                        std::push_heap(similarities.begin(), similarities.end());
+                        neighbours[n.to].push_back(n.from);
                     }
                 }
 
-                // Compute regions' rank
-                for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                    // Note: this is inverted from the paper, but we keep the lover region first so it's works
-                    (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
-                }
-
             }
 
             Ptr<SelectiveSearchSegmentation> createSelectiveSearchSegmentation() {
@@ -79,11 +79,14 @@ protected:
     int w,h;
     int match_num;
 
-    //internal buffers:
-    vector<node>* g;
+    //internal buffers, kept between the calls on images of the same size:
+    vector< vector<node> > g;
     Mat labels;
     Mat NNlabels;
     Mat NNdistances;
+    Mat distances;
+    Mat cost_map;
+    vector<Mat> transforms;
 
     //tunable parameters:
     float lambda;
@@ -99,11 +102,15 @@ protected:
     float regularization_coef;
     static const int ransac_num_stripes = 4;
     RNG rngs[ransac_num_stripes];
+    // tiles of the geodesic distance transform, in rows and in diagonals of the image
+    static const int distance_transform_tile_rows      = 32;
+    static const int distance_transform_tile_diagonals = 128;
 
     void init();
     void preprocessData(Mat& src, vector<SparseMatch>& matches);
     void computeGradientMagnitude(Mat& src, Mat& dst);
     void geodesicDistanceTransform(Mat& distances, Mat& cost_map);
+    void geodesicDistanceTransformTile(Mat& distances, Mat& cost_map, bool backward, int row_start, int row_end, int diag_start, int diag_end);
     void buildGraph(Mat& distances, Mat& cost_map);
     void ransacInterpolation(vector<SparseMatch>& matches, Mat& dst_dense_flow);
 
@@ -118,6 +125,27 @@ protected:
         void operator () (const Range& range) const;
     };
 
+    struct GeodesicDistanceTransform_ParBody : public ParallelLoopBody
+    {
+        EdgeAwareInterpolatorImpl* inst;
+        Mat* distances;
+        Mat* cost_map;
+        bool backward;
+        int wave;
+
+        GeodesicDistanceTransform_ParBody(EdgeAwareInterpolatorImpl& _inst, Mat& _distances, Mat& _cost_map, bool _backward, int _wave);
+        void operator () (const Range& range) const;
+    };
+
+    struct PiecewiseAffineFlow_ParBody : public ParallelLoopBody
+    {
+        EdgeAwareInterpolatorImpl* inst;
+        Mat* dst_dense_flow;
+
+        PiecewiseAffineFlow_ParBody(EdgeAwareInterpolatorImpl& _inst, Mat& _dst_dense_flow);
+        void operator () (const Range& range) const;
+    };
+
     struct RansacInterpolation_ParBody : public ParallelLoopBody
     {
         EdgeAwareInterpolatorImpl* inst;
@@ -186,13 +214,16 @@ void EdgeAwareInterpolatorImpl::interpolate(InputArray from_image, InputArray fr
     CV_Assert(match_num<SHRT_MAX);
 
     Mat src = from_image.getMat();
-    labels = Mat(h,w,CV_16S);
+    labels.create(h,w,CV_16S);
     labels = Scalar(-1);
-    NNlabels = Mat(match_num,k,CV_16S);
+    NNlabels.create(match_num,k,CV_16S);
     NNlabels = Scalar(-1);
-    NNdistances = Mat(match_num,k,CV_32F);
+    NNdistances.create(match_num,k,CV_32F);
     NNdistances = Scalar(0.0f);
-    g = new vector<node>[match_num];
+    // the neighbor lists keep their capacity from the previous calls
+    g.resize(match_num);
+    for(int i=0;i<match_num;i++)
+        g[i].clear();
 
     preprocessData(src,matches_vector);
 
@@ -201,14 +232,12 @@ void EdgeAwareInterpolatorImpl::interpolate(InputArray from_image, InputArray fr
     ransacInterpolation(matches_vector,dst);
     if(use_post_proc)
         fastGlobalSmootherFilter(src,dst,dst,fgs_lambda,fgs_sigma);
-
-    delete[] g;
 }
 
 void EdgeAwareInterpolatorImpl::preprocessData(Mat& src, vector<SparseMatch>& matches)
 {
-    Mat distances(h,w,CV_32F);
-    Mat cost_map (h,w,CV_32F);
+    distances.create(h,w,CV_32F);
+    cost_map .create(h,w,CV_32F);
     distances = Scalar(INF);
 
     int x,y;
@@ -264,93 +293,91 @@ void EdgeAwareInterpolatorImpl::computeGradientMagnitude(Mat& src, Mat& dst)
     }
 }
 
+/* Both passes of the distance transform are raster scans, where a pixel (i,j) depends on (i,j-1) and on
+ * (i-1,j-1), (i-1,j), (i-1,j+1) (mirrored in the backward pass). All of them lie on a smaller diagonal 2*i+j,
+ * so the image is cut into tiles of rows and diagonals, and the tiles of the same wave band+diagonal_block
+ * are computed in parallel after the previous waves. Every pixel sees the same neighbor values as in the
+ * raster scan, so the result is identical.
+ */
 void EdgeAwareInterpolatorImpl::geodesicDistanceTransform(Mat& distances, Mat& cost_map)
 {
-    float c1 = 1.0f/2.0f;
-    float c2 = sqrt(2.0f)/2.0f;
-    float d = 0.0f;
-    int i,j;
-    float *dist_row,      *cost_row;
-    float *dist_row_prev, *cost_row_prev;
-    short *label_row;
-    short *label_row_prev;
-
-#define CHECK(cur_dist,cur_label,cur_cost,prev_dist,prev_label,prev_cost,coef)\
-{\
-    d = prev_dist + coef*(cur_cost+prev_cost);\
-    if(cur_dist>d){\
-        cur_dist=d;\
-        cur_label = prev_label;}\
-}
+    int num_bands = (h + distance_transform_tile_rows - 1)/distance_transform_tile_rows;
+    int num_diagonals = 2*(h-1) + w;
+    int num_diagonal_blocks = (num_diagonals + distance_transform_tile_diagonals - 1)/distance_transform_tile_diagonals;
 
     for(int it=0;it<distance_transform_num_iter;it++)
     {
-        //first pass (left-to-right, top-to-bottom):
-        dist_row  = distances.ptr<float>(0);
-        label_row = labels.ptr<short>(0);
-        cost_row  = cost_map.ptr<float>(0);
-        for(j=1;j<w;j++)
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-1],label_row[j-1],cost_row[j-1],c1);
-
-        for(i=1;i<h;i++)
+        for(int pass=0;pass<2;pass++)
         {
-            dist_row       = distances.ptr<float>(i);
-            dist_row_prev  = distances.ptr<float>(i-1);
-
-            label_row      = labels.ptr<short>(i);
-            label_row_prev = labels.ptr<short>(i-1);
-
-            cost_row      = cost_map.ptr<float>(i);
-            cost_row_prev = cost_map.ptr<float>(i-1);
-
-            j=0;
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
-            j++;
-            for(;j<w-1;j++)
+            bool backward = (pass==1);
+            for(int wave=0;wave<num_bands+num_diagonal_blocks-1;wave++)
             {
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-1]     ,label_row[j-1]     ,cost_row[j-1]     ,c1);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-1],label_row_prev[j-1],cost_row_prev[j-1],c2);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
+                int first_band = max(0,wave-num_diagonal_blocks+1);
+                int last_band  = min(num_bands-1,wave);
+                parallel_for_(Range(first_band,last_band+1),GeodesicDistanceTransform_ParBody(*this,distances,cost_map,backward,wave));
             }
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j-1]     ,label_row[j-1]     ,cost_row[j-1]     ,c1);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-1],label_row_prev[j-1],cost_row_prev[j-1],c2);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
         }
+    }
+}
 
-        //second pass (right-to-left, bottom-to-top):
-        dist_row  = distances.ptr<float>(h-1);
-        label_row = labels.ptr<short>(h-1);
-        cost_row  = cost_map.ptr<float>(h-1);
-        for(j=w-2;j>=0;j--)
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j+1],label_row[j+1],cost_row[j+1],c1);
+EdgeAwareInterpolatorImpl::GeodesicDistanceTransform_ParBody::GeodesicDistanceTransform_ParBody(EdgeAwareInterpolatorImpl& _inst, Mat& _distances, Mat& _cost_map, bool _backward, int _wave):
+inst(&_inst), distances(&_distances), cost_map(&_cost_map), backward(_backward), wave(_wave)
+{}
 
-        for(i=h-2;i>=0;i--)
-        {
-            dist_row       = distances.ptr<float>(i);
-            dist_row_prev  = distances.ptr<float>(i+1);
+void EdgeAwareInterpolatorImpl::GeodesicDistanceTransform_ParBody::operator() (const Range& range) const
+{
+    for(int band=range.start;band<range.end;band++)
+    {
+        int diagonal_block = wave - band;
+        inst->geodesicDistanceTransformTile(*distances,*cost_map,backward,
+                                            band*distance_transform_tile_rows,
+                                            min((band+1)*distance_transform_tile_rows,inst->h),
+                                            diagonal_block*distance_transform_tile_diagonals,
+                                            (diagonal_block+1)*distance_transform_tile_diagonals);
+    }
+}
 
-            label_row      = labels.ptr<short>(i);
-            label_row_prev = labels.ptr<short>(i+1);
+void EdgeAwareInterpolatorImpl::geodesicDistanceTransformTile(Mat& distances, Mat& cost_map, bool backward, int row_start, int row_end, int diag_start, int diag_end)
+{
+    const float c1 = 1.0f/2.0f;
+    const float c2 = sqrt(2.0f)/2.0f;
+    float d;
 
-            cost_row      = cost_map.ptr<float>(i);
-            cost_row_prev = cost_map.ptr<float>(i+1);
+#define CHECK(cur_dist,cur_label,cur_cost,prev_dist,prev_label,prev_cost,coef)\
+{\
+    d = prev_dist + coef*(cur_cost+prev_cost);\
+    if(cur_dist>d){\
+        cur_dist=d;\
+        cur_label = prev_label;}\
+}
 
-            j=w-1;
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-1],label_row_prev[j-1],cost_row_prev[j-1],c2);
-            j--;
-            for(;j>0;j--)
+    // (i,j) are the coordinates in the order of the scan, the backward pass scans the flipped image
+    const int dir = backward ? -1 : 1;
+    for(int i=row_start;i<row_end;i++)
+    {
+        int y = backward ? h-1-i : i;
+        float* dist_row  = distances.ptr<float>(y);
+        short* label_row = labels.ptr<short>(y);
+        float* cost_row  = cost_map.ptr<float>(y);
+        float* dist_row_prev  = i>0 ? distances.ptr<float>(y-dir) : 0;
+        short* label_row_prev = i>0 ? labels.ptr<short>(y-dir)    : 0;
+        float* cost_row_prev  = i>0 ? cost_map.ptr<float>(y-dir)  : 0;
+
+        int j_start = max(diag_start-2*i,0);
+        int j_end   = min(diag_end-2*i,w);
+        for(int j=j_start;j<j_end;j++)
+        {
+            int x = backward ? w-1-j : j;
+            if(j>0)
+                CHECK(dist_row[x],label_row[x],cost_row[x],dist_row[x-dir],label_row[x-dir],cost_row[x-dir],c1);
+            if(i>0)
             {
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j+1]     ,label_row[j+1]     ,cost_row[j+1]     ,c1);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
-                CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j-1],label_row_prev[j-1],cost_row_prev[j-1],c2);
+                if(j>0)
+                    CHECK(dist_row[x],label_row[x],cost_row[x],dist_row_prev[x-dir],label_row_prev[x-dir],cost_row_prev[x-dir],c2);
+                CHECK(dist_row[x],label_row[x],cost_row[x],dist_row_prev[x],label_row_prev[x],cost_row_prev[x],c1);
+                if(j<w-1)
+                    CHECK(dist_row[x],label_row[x],cost_row[x],dist_row_prev[x+dir],label_row_prev[x+dir],cost_row_prev[x+dir],c2);
             }
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row[j+1]     ,label_row[j+1]     ,cost_row[j+1]     ,c1);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j+1],label_row_prev[j+1],cost_row_prev[j+1],c2);
-            CHECK(dist_row[j],label_row[j],cost_row[j],dist_row_prev[j]  ,label_row_prev[j]  ,cost_row_prev[j]  ,c1);
         }
     }
 #undef CHECK
@@ -827,11 +854,31 @@ void EdgeAwareInterpolatorImpl::RansacInterpolation_ParBody::operator() (const R
     delete[] is_used;
 }
 
+EdgeAwareInterpolatorImpl::PiecewiseAffineFlow_ParBody::PiecewiseAffineFlow_ParBody(EdgeAwareInterpolatorImpl& _inst, Mat& _dst_dense_flow):
+inst(&_inst), dst_dense_flow(&_dst_dense_flow)
+{}
+
+void EdgeAwareInterpolatorImpl::PiecewiseAffineFlow_ParBody::operator() (const Range& range) const
+{
+    short* label_row;
+    float* tr;
+    for(int i=range.start;i<range.end;i++)
+    {
+        label_row = inst->labels.ptr<short>(i);
+        Point2f* dst_row = dst_dense_flow->ptr<Point2f>(i);
+        for(int j=0;j<inst->w;j++)
+        {
+            tr = inst->transforms[label_row[j]].ptr<float>(0);
+            dst_row[j] = Point2f(tr[0]*j+tr[1]*i+tr[2],tr[3]*j+tr[4]*i+tr[5]) - Point2f((float)j,(float)i);
+        }
+    }
+}
+
 void EdgeAwareInterpolatorImpl::ransacInterpolation(vector<SparseMatch>& matches, Mat& dst_dense_flow)
 {
     NNdistances *= (-sigma*sigma);
 
-    Mat* transforms = new Mat[match_num];
+    transforms.resize(match_num);
     float* weighted_inlier_nums = new float[match_num];
     float* eps = new float[match_num];
     for(int i=0;i<match_num;i++)
@@ -841,25 +888,13 @@ void EdgeAwareInterpolatorImpl::ransacInterpolation(vector<SparseMatch>& matches
         rngs[i] = RNG(0);
 
     //forward pass:
-    parallel_for_(Range(0,ransac_num_stripes),RansacInterpolation_ParBody(*this,transforms,weighted_inlier_nums,eps,&matches.front(),ransac_num_stripes,1));
+    parallel_for_(Range(0,ransac_num_stripes),RansacInterpolation_ParBody(*this,&transforms.front(),weighted_inlier_nums,eps,&matches.front(),ransac_num_stripes,1));
     //backward pass:
-    parallel_for_(Range(0,ransac_num_stripes),RansacInterpolation_ParBody(*this,transforms,weighted_inlier_nums,eps,&matches.front(),ransac_num_stripes,-1));
+    parallel_for_(Range(0,ransac_num_stripes),RansacInterpolation_ParBody(*this,&transforms.front(),weighted_inlier_nums,eps,&matches.front(),ransac_num_stripes,-1));
 
     //construct the final piecewise-affine interpolation:
-    short* label_row;
-    float* tr;
-    for(int i=0;i<h;i++)
-    {
-        label_row = labels.ptr<short>(i);
-        Point2f* dst_row = dst_dense_flow.ptr<Point2f>(i);
-        for(int j=0;j<w;j++)
-        {
-            tr = transforms[label_row[j]].ptr<float>(0);
-            dst_row[j] = Point2f(tr[0]*j+tr[1]*i+tr[2],tr[3]*j+tr[4]*i+tr[5]) - Point2f((float)j,(float)i);
-        }
-    }
+    parallel_for_(Range(0,h),PiecewiseAffineFlow_ParBody(*this,dst_dense_flow));
 
-    delete[] transforms;
     delete[] weighted_inlier_nums;
     delete[] eps;
 }
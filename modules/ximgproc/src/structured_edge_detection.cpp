@@ -380,17 +380,22 @@ public:
             2*(__rf.options.numberOfGradientOrientations + 1) + 3;
         //--------------------------------------------
 
+        modelStride = __rf.options.stride;
+        modelNumberOfTreesToEvaluate = __rf.options.numberOfTreesToEvaluate;
+        //--------------------------------------------
+
         cv::FileNode childs = modelFile["childs"];
         cv::FileNode featureIds = modelFile["featureIds"];
 
         std::vector <int> currentTree;
+        std::vector <int> allChilds, allFeatureIds;
 
         for(cv::FileNodeIterator it = childs.begin();
             it != childs.end(); ++it)
         {
             (*it) >> currentTree;
             std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.childs));
+                std::back_inserter(allChilds));
         }
 
         for(cv::FileNodeIterator it = featureIds.begin();
@@ -398,18 +403,32 @@ public:
         {
             (*it) >> currentTree;
             std::copy(currentTree.begin(), currentTree.end(),
-                std::back_inserter(__rf.featureIds));
+                std::back_inserter(allFeatureIds));
         }
 
         cv::FileNode thresholds = modelFile["thresholds"];
         std::vector <float> fcurrentTree;
+        std::vector <float> allThresholds;
 
         for(cv::FileNodeIterator it = thresholds.begin();
             it != thresholds.end(); ++it)
         {
             (*it) >> fcurrentTree;
             std::copy(fcurrentTree.begin(), fcurrentTree.end(),
-                std::back_inserter(__rf.thresholds));
+                std::back_inserter(allThresholds));
+        }
+
+        CV_Assert( allChilds.size() == allFeatureIds.size()
+            && allChilds.size() == allThresholds.size() );
+
+        // a tree descent reads only the flattened nodes
+        __rf.nodes.resize(allChilds.size());
+        for (size_t i = 0; i < allChilds.size(); ++i)
+        {
+            __rf.nodes[i].child = allChilds[i];
+            __rf.nodes[i].featureId = allFeatureIds[i];
+            __rf.nodes[i].threshold = allThresholds[i];
+            __rf.nodes[i].reserved = 0;
         }
 
         cv::FileNode edgeBoundaries = modelFile["edgeBoundaries"];
@@ -431,7 +450,33 @@ public:
                 std::back_inserter(__rf.edgeBins));
         }
 
-        __rf.numberOfTreeNodes = int( __rf.childs.size() ) / __rf.options.numberOfTrees;
+        __rf.numberOfTreeNodes = int( __rf.nodes.size() ) / __rf.options.numberOfTrees;
+    }
+
+    /*!
+     * The function trades accuracy for speed, see StructuredEdgeDetection::setSpeedPreset
+     *
+     * \param preset : one of SED_PRESET_ACCURATE, SED_PRESET_FAST and SED_PRESET_FASTEST
+     */
+    void setSpeedPreset(int preset)
+    {
+        switch (preset)
+        {
+        case SED_PRESET_ACCURATE:
+            __rf.options.stride = modelStride;
+            __rf.options.numberOfTreesToEvaluate = modelNumberOfTreesToEvaluate;
+            break;
+        case SED_PRESET_FAST:
+            __rf.options.stride = modelStride;
+            __rf.options.numberOfTreesToEvaluate = 1;
+            break;
+        case SED_PRESET_FASTEST:
+            __rf.options.stride = 2*modelStride;
+            __rf.options.numberOfTreesToEvaluate = 1;
+            break;
+        default:
+            CV_Error(Error::StsBadArg, "Unknown speed preset");
+        }
     }
 
     /*!
@@ -479,8 +524,6 @@ protected:
         int sfs = __rf.options.ssFeatureSmoothingRadius;
 
         int nTreesEval = __rf.options.numberOfTreesToEvaluate;
-        int nTrees = __rf.options.numberOfTrees;
-        int nTreesNodes = __rf.numberOfTreeNodes;
 
         const int nchannels = features.channels();
         int pSize  = __rf.options.patchSize;
@@ -549,86 +592,169 @@ protected:
                 offsetY[n] = x2*features.cols*nchannels + y2*nchannels + z;
             }
             // lookup tables for mapping linear index to offset pairs
-        #ifdef _OPENMP
-        #pragma omp parallel for
-        #endif
-        for (int i = 0; i < height; ++i)
+        PredictIndexesInvoker predictBody(__rf, regFeatures, ssFeatures, indexes,
+            offsetI, offsetX, offsetY, nFeatures, nchannels, width);
+        parallel_for_(Range(0, height), predictBody);
+
+        NChannelsMat dstM(dst.size(),
+            CV_MAKETYPE(DataType<float>::type, outNum));
+        dstM.setTo(0);
+
+        // The patches of stripeRows consecutive rows cover at most the rows of the
+        // next stripe, so that the stripes of the same parity never overlap and are
+        // accumulated in place. All the increments are equal, so the result doesn't
+        // depend on the order in which the stripes are processed.
+        int stripeRows = (ipSize + stride - 1)/stride;
+        int nStripes = (height + stripeRows - 1)/stripeRows;
+        float step = 2.0f * CV_SQR(stride) / CV_SQR(ipSize) / nTreesEval;
+        for (int phase = 0; phase < 2; ++phase)
         {
-            float *regFeaturesPtr = regFeatures.ptr<float>(i*stride/shrink);
-            float  *ssFeaturesPtr = ssFeatures.ptr<float>(i*stride/shrink);
+            AccumulateEdgesInvoker accumulateBody(__rf, indexes, dstM, offsetE,
+                step, width, height, stripeRows, phase);
+            parallel_for_(Range(0, (nStripes + 1 - phase)/2), accumulateBody);
+        }
+
+        cv::reduce( dstM.reshape(1, int( dstM.total() ) ), dstM, 2, CV_REDUCE_SUM);
+        imsmooth( dstM.reshape(1, dst.rows), 1 ).copyTo(dst);
+    }
 
-            int *indexPtr = indexes.ptr<int>(i);
+    struct RandomForest;
 
-            for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
-                // for j,k in [0;width)x[0;nTreesEval)
+    /*!
+     * Finds the leaves reached by the evaluated trees, for a range of patch rows
+     */
+    struct PredictIndexesInvoker : public ParallelLoopBody
+    {
+        PredictIndexesInvoker(const RandomForest &_rf, const NChannelsMat &_regFeatures,
+            const NChannelsMat &_ssFeatures, NChannelsMat &_indexes,
+            const std::vector <int> &_offsetI, const std::vector <int> &_offsetX,
+            const std::vector <int> &_offsetY, int _nFeatures, int _nchannels, int _width)
+            : rf(_rf), regFeatures(_regFeatures), ssFeatures(_ssFeatures), indexes(_indexes),
+              offsetI(_offsetI), offsetX(_offsetX), offsetY(_offsetY),
+              nFeatures(_nFeatures), nchannels(_nchannels), width(_width) {}
+
+        void operator()(const Range &range) const
+        {
+            int shrink = rf.options.shrinkNumber;
+            int stride = rf.options.stride;
+            int nTreesEval = rf.options.numberOfTreesToEvaluate;
+            int nTrees = rf.options.numberOfTrees;
+            int nTreesNodes = rf.numberOfTreeNodes;
+            const RandomForestNode *nodes = &rf.nodes[0];
+
+            for (int i = range.start; i < range.end; ++i)
             {
-                int baseNode = ( ((i + j)%(2*nTreesEval) + k)%nTrees )*nTreesNodes;
-                int currentNode = baseNode;
-                // select root node of the tree to evaluate
+                const float *regFeaturesPtr = regFeatures.ptr<float>(i*stride/shrink);
+                const float  *ssFeaturesPtr = ssFeatures.ptr<float>(i*stride/shrink);
 
-                int offset = (j*stride/shrink)*nchannels;
-                while ( __rf.childs[currentNode] != 0 )
+                int *indexPtr = indexes.ptr<int>(i);
+
+                for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
+                    // for j,k in [0;width)x[0;nTreesEval)
                 {
-                    int currentId = __rf.featureIds[currentNode];
-                    float currentFeature;
+                    int baseNode = ( ((i + j)%(2*nTreesEval) + k)%nTrees )*nTreesNodes;
+                    int currentNode = baseNode;
+                    // select root node of the tree to evaluate
 
-                    if (currentId >= nFeatures)
+                    int offset = (j*stride/shrink)*nchannels;
+                    while ( nodes[currentNode].child != 0 )
                     {
-                        int xIndex = offsetX[currentId - nFeatures];
-                        float A = ssFeaturesPtr[offset + xIndex];
-
-                        int yIndex = offsetY[currentId - nFeatures];
-                        float B = ssFeaturesPtr[offset + yIndex];
-
-                        currentFeature = A - B;
+                        const RandomForestNode &node = nodes[currentNode];
+                        int currentId = node.featureId;
+                        float currentFeature;
+
+                        if (currentId >= nFeatures)
+                        {
+                            int xIndex = offsetX[currentId - nFeatures];
+                            float A = ssFeaturesPtr[offset + xIndex];
+
+                            int yIndex = offsetY[currentId - nFeatures];
+                            float B = ssFeaturesPtr[offset + yIndex];
+
+                            currentFeature = A - B;
+                        }
+                        else
+                            currentFeature = regFeaturesPtr[offset + offsetI[currentId]];
+
+                        // compare feature to threshold and move left or right accordingly
+                        if (currentFeature < node.threshold)
+                            currentNode = baseNode + node.child - 1;
+                        else
+                            currentNode = baseNode + node.child;
                     }
-                    else
-                        currentFeature = regFeaturesPtr[offset + offsetI[currentId]];
-
-                    // compare feature to threshold and move left or right accordingly
-                    if (currentFeature < __rf.thresholds[currentNode])
-                        currentNode = baseNode + __rf.childs[currentNode] - 1;
-                    else
-                        currentNode = baseNode + __rf.childs[currentNode];
-                }
 
-                indexPtr[j*nTreesEval + k] = currentNode;
+                    indexPtr[j*nTreesEval + k] = currentNode;
+                }
             }
         }
 
-        NChannelsMat dstM(dst.size(),
-            CV_MAKETYPE(DataType<float>::type, outNum));
-        dstM.setTo(0);
+        const RandomForest &rf;
+        const NChannelsMat &regFeatures, &ssFeatures;
+        NChannelsMat &indexes;
+        const std::vector <int> &offsetI, &offsetX, &offsetY;
+        int nFeatures, nchannels, width;
 
-        float step = 2.0f * CV_SQR(stride) / CV_SQR(ipSize) / nTreesEval;
-        #ifdef _OPENMP
-        #pragma omp parallel for
-        #endif
-        for (int i = 0; i < height; ++i)
+    private:
+        PredictIndexesInvoker& operator=(const PredictIndexesInvoker&); // to quiet MSVC
+    };
+
+    /*!
+     * Accumulates the edge patches of the leaves, for the stripes of patch rows
+     * of the given parity
+     */
+    struct AccumulateEdgesInvoker : public ParallelLoopBody
+    {
+        AccumulateEdgesInvoker(const RandomForest &_rf, const NChannelsMat &_indexes,
+            NChannelsMat &_dstM, const std::vector <int> &_offsetE, float _step,
+            int _width, int _height, int _stripeRows, int _phase)
+            : rf(_rf), indexes(_indexes), dstM(_dstM), offsetE(_offsetE), step(_step),
+              width(_width), height(_height), stripeRows(_stripeRows), phase(_phase) {}
+
+        void operator()(const Range &range) const
         {
-            int *pIndex = indexes.ptr<int>(i);
-            float *pDst = dstM.ptr<float>(i*stride);
+            int stride = rf.options.stride;
+            int nTreesEval = rf.options.numberOfTreesToEvaluate;
+            int outNum = rf.options.numberOfOutputChannels;
 
-                for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
-                {// for j,k in [0;width)x[0;nTreesEval)
+            for (int s = range.start; s < range.end; ++s)
+            {
+                int first = (2*s + phase)*stripeRows;
+                int last = std::min(first + stripeRows, height);
+
+                for (int i = first; i < last; ++i)
+                {
+                    const int *pIndex = indexes.ptr<int>(i);
+                    float *pDst = dstM.ptr<float>(i*stride);
 
-                    int currentNode = pIndex[j*nTreesEval + k];
+                    for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
+                    {// for j,k in [0;width)x[0;nTreesEval)
 
-                    int start  = __rf.edgeBoundaries[currentNode];
-                    int finish = __rf.edgeBoundaries[currentNode + 1];
+                        int currentNode = pIndex[j*nTreesEval + k];
 
-                    if (start == finish)
-                        continue;
+                        int start  = rf.edgeBoundaries[currentNode];
+                        int finish = rf.edgeBoundaries[currentNode + 1];
 
-                    int offset = j*stride*outNum;
-                    for (int p = start; p < finish; ++p)
-                        pDst[offset + offsetE[__rf.edgeBins[p]]] += step;
+                        if (start == finish)
+                            continue;
+
+                        int offset = j*stride*outNum;
+                        for (int p = start; p < finish; ++p)
+                            pDst[offset + offsetE[rf.edgeBins[p]]] += step;
+                    }
                 }
+            }
         }
 
-        cv::reduce( dstM.reshape(1, int( dstM.total() ) ), dstM, 2, CV_REDUCE_SUM);
-        imsmooth( dstM.reshape(1, dst.rows), 1 ).copyTo(dst);
-    }
+        const RandomForest &rf;
+        const NChannelsMat &indexes;
+        NChannelsMat &dstM;
+        const std::vector <int> &offsetE;
+        float step;
+        int width, height, stripeRows, phase;
+
+    private:
+        AccumulateEdgesInvoker& operator=(const AccumulateEdgesInvoker&); // to quiet MSVC
+    };
 
 /********************* Members *********************/
 protected:
@@ -638,6 +764,18 @@ protected:
     /*! optional feature getter (getFeatures method) */
     Ptr<const RFFeatureGetter> howToGetFeatures;
 
+    /*! stride and number of trees to evaluate given by the model */
+    int modelStride, modelNumberOfTreesToEvaluate;
+
+    /*! node of a tree, all the trees are stored in one array */
+    struct RandomForestNode
+    {
+        int child;       /*!< the children are child - 1 and child, 0 for a leaf */
+        int featureId;   /*!< feature coordinate thresholded at the node */
+        float threshold; /*!< threshold applied to the feature */
+        int reserved;    /*!< pads the node to 16 bytes, 4 nodes per cache line */
+    };
+
     /*! random forest used to detect edges */
     struct RandomForest
     {
@@ -679,9 +817,7 @@ protected:
 
         int numberOfTreeNodes;
 
-        std::vector <int> featureIds;     /*!< feature coordinate thresholded at k-th node */
-        std::vector <float> thresholds;   /*!< threshold applied to featureIds[k] at k-th node */
-        std::vector <int> childs;         /*!< k --> child[k] - 1, child[k] */
+        std::vector <RandomForestNode> nodes; /*!< nodes of all the trees */
 
         std::vector <int> edgeBoundaries; /*!< ... */
         std::vector <int> edgeBins;       /*!< ... */
@@ -5,54 +5,173 @@ using namespace std;
 namespace cv {
 namespace ximgproc {
 
-// Applies a thinning iteration to a binary image
-static void thinningIteration(Mat img, int iter){
-    Mat marker = Mat::zeros(img.size(), CV_8UC1);
-    for (int i = 1; i < img.rows-1; i++)
+// The 8 neighbours of a pixel as the bits of a byte, from p2 (bit 0) to p9 (bit 7):
+//   p9 p2 p3
+//   p8 p1 p4
+//   p7 p6 p5
+// lut[iter][code] is 1 when a foreground pixel with the neighbourhood code has to be removed by the
+// sub-iteration iter of the thinning technique.
+static void buildThinningLUT(int thinningType, uchar lut[2][256])
+{
+    for (int iter = 0; iter < 2; iter++)
     {
-        for (int j = 1; j < img.cols-1; j++)
+        for (int code = 0; code < 256; code++)
         {
-            uchar p2 = img.at<uchar>(i-1, j);
-            uchar p3 = img.at<uchar>(i-1, j+1);
-            uchar p4 = img.at<uchar>(i, j+1);
-            uchar p5 = img.at<uchar>(i+1, j+1);
-            uchar p6 = img.at<uchar>(i+1, j);
-            uchar p7 = img.at<uchar>(i+1, j-1);
-            uchar p8 = img.at<uchar>(i, j-1);
-            uchar p9 = img.at<uchar>(i-1, j-1);
-
-            int A  = (p2 == 0 && p3 == 1) + (p3 == 0 && p4 == 1) +
-                     (p4 == 0 && p5 == 1) + (p5 == 0 && p6 == 1) +
-                     (p6 == 0 && p7 == 1) + (p7 == 0 && p8 == 1) +
-                     (p8 == 0 && p9 == 1) + (p9 == 0 && p2 == 1);
-            int B  = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
-            int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
-            int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
-
-            if (A == 1 && (B >= 2 && B <= 6) && m1 == 0 && m2 == 0)
-                marker.at<uchar>(i,j) = 1;
+            int p2 = code & 1, p3 = (code >> 1) & 1, p4 = (code >> 2) & 1, p5 = (code >> 3) & 1;
+            int p6 = (code >> 4) & 1, p7 = (code >> 5) & 1, p8 = (code >> 6) & 1, p9 = (code >> 7) & 1;
+            bool removed;
+            if (thinningType == THINNING_ZHANGSUEN)
+            {
+                int A  = (p2 == 0 && p3 == 1) + (p3 == 0 && p4 == 1) +
+                         (p4 == 0 && p5 == 1) + (p5 == 0 && p6 == 1) +
+                         (p6 == 0 && p7 == 1) + (p7 == 0 && p8 == 1) +
+                         (p8 == 0 && p9 == 1) + (p9 == 0 && p2 == 1);
+                int B  = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
+                int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
+                int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
+                removed = A == 1 && (B >= 2 && B <= 6) && m1 == 0 && m2 == 0;
+            }
+            else
+            {
+                int C  = ((!p2) & (p3 | p4)) + ((!p4) & (p5 | p6)) +
+                         ((!p6) & (p7 | p8)) + ((!p8) & (p9 | p2));
+                int N1 = (p9 | p2) + (p3 | p4) + (p5 | p6) + (p7 | p8);
+                int N2 = (p2 | p3) + (p4 | p5) + (p6 | p7) + (p8 | p9);
+                int N  = N1 < N2 ? N1 : N2;
+                int m  = iter == 0 ? ((p6 | p7 | (!p9)) & p8) : ((p2 | p3 | (!p5)) & p4);
+                removed = C == 1 && (N >= 2 && N <= 3) && m == 0;
+            }
+            lut[iter][code] = removed ? 1 : 0;
         }
     }
-
-    img &= ~marker;
 }
 
+// Marks the pixels removed by a sub-iteration, for the rows whose neighbourhood changed since they were
+// last visited by the same sub-iteration. The image is only read, so the rows are independent.
+class ThinningMarkInvoker : public ParallelLoopBody
+{
+public:
+    ThinningMarkInvoker(const Mat& img, Mat& marker, const uchar* lut, const vector<uchar>& visit,
+                        vector<uchar>& changed)
+        : img_(img), marker_(marker), lut_(lut), visit_(visit), changed_(changed)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        int cols = img_.cols;
+        for (int i = range.start; i < range.end; i++)
+        {
+            changed_[i] = 0;
+            if (!visit_[i])
+                continue;
+
+            const uchar* prev = img_.ptr<uchar>(i-1);
+            const uchar* cur  = img_.ptr<uchar>(i);
+            const uchar* next = img_.ptr<uchar>(i+1);
+            uchar* marker = marker_.ptr<uchar>(i);
+            uchar any = 0;
+            for (int j = 1; j < cols-1; j++)
+            {
+                if (!cur[j])
+                {
+                    marker[j] = 0;
+                    continue;
+                }
+                int code = prev[j]        | (prev[j+1] << 1) | (cur[j+1] << 2) | (next[j+1] << 3) |
+                           (next[j] << 4) | (next[j-1] << 5) | (cur[j-1] << 6) | (prev[j-1] << 7);
+                marker[j] = lut_[code];
+                any |= marker[j];
+            }
+            changed_[i] = any;
+        }
+    }
+
+private:
+    const Mat& img_;
+    Mat& marker_;
+    const uchar* lut_;
+    const vector<uchar>& visit_;
+    vector<uchar>& changed_;
+
+    ThinningMarkInvoker& operator=(const ThinningMarkInvoker&); // to quiet MSVC
+};
+
+// Removes the marked pixels of the rows that have some
+class ThinningRemoveInvoker : public ParallelLoopBody
+{
+public:
+    ThinningRemoveInvoker(Mat& img, const Mat& marker, const vector<uchar>& changed)
+        : img_(img), marker_(marker), changed_(changed)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        int cols = img_.cols;
+        for (int i = range.start; i < range.end; i++)
+        {
+            if (!changed_[i])
+                continue;
+            uchar* row = img_.ptr<uchar>(i);
+            const uchar* marker = marker_.ptr<uchar>(i);
+            for (int j = 1; j < cols-1; j++)
+                row[j] &= ~marker[j];
+        }
+    }
+
+private:
+    Mat& img_;
+    const Mat& marker_;
+    const vector<uchar>& changed_;
+
+    ThinningRemoveInvoker& operator=(const ThinningRemoveInvoker&); // to quiet MSVC
+};
+
 // Apply the thinning procedure to a given image
-void thinning(InputArray input, OutputArray output){
+void thinning(InputArray input, OutputArray output, int thinningType){
+    CV_Assert(input.type() == CV_8UC1);
+    CV_Assert(thinningType == THINNING_ZHANGSUEN || thinningType == THINNING_GUOHALL);
+
     Mat processed = input.getMat().clone();
     // Enforce the range of the input image to be in between 0 - 255
     processed /= 255;
 
-    Mat prev = Mat::zeros(processed.size(), CV_8UC1);
-    Mat diff;
+    if (processed.rows > 2 && processed.cols > 2)
+    {
+        uchar lut[2][256];
+        buildThinningLUT(thinningType, lut);
+
+        // Rows changed by the last two sub-iterations, a pixel whose 3x3 neighbourhood is the same
+        // as the last time the same sub-iteration saw it keeps its previous verdict.
+        // The image stops changing once two sub-iterations in a row removed nothing.
+        int rows = processed.rows;
+        vector<uchar> changed_prev(rows, 1), changed_prev2(rows, 1), changed(rows, 0), visit(rows, 0);
+        // the border rows are never thinned
+        changed_prev[0] = changed_prev[rows-1] = changed_prev2[0] = changed_prev2[rows-1] = 0;
+        Mat marker = Mat::zeros(processed.size(), CV_8UC1);
+        Range inner(1, rows-1);
 
-    do {
-        thinningIteration(processed, 0);
-        thinningIteration(processed, 1);
-        absdiff(processed, prev, diff);
-        processed.copyTo(prev);
+        for (int iter = 0; ; iter ^= 1)
+        {
+            for (int i = 1; i < rows-1; i++)
+            {
+                visit[i] = 0;
+                for (int k = i-1; k <= i+1; k++)
+                    visit[i] |= changed_prev[k] | changed_prev2[k];
+            }
+
+            parallel_for_(inner, ThinningMarkInvoker(processed, marker, lut[iter], visit, changed));
+            parallel_for_(inner, ThinningRemoveInvoker(processed, marker, changed));
+
+            bool any = std::find(changed.begin(), changed.end(), 1) != changed.end();
+            bool any_prev = std::find(changed_prev.begin(), changed_prev.end(), 1) != changed_prev.end();
+            if (!any && !any_prev)
+                break;
+            changed_prev2.swap(changed_prev);
+            changed_prev.swap(changed);
+        }
     }
-    while (countNonZero(diff) > 0);
 
     processed *= 255;
 
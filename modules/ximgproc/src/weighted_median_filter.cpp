@@ -201,7 +201,7 @@ void int2D_release(int **p)
  ***************************************************************/
 inline void updateBCB(int &num,int *f,int *b,int i,int v)
 {
-    static int p1,p2;
+    int p1,p2;
 
     if(i)
     {
@@ -229,7 +229,8 @@ inline void updateBCB(int &num,int *f,int *b,int i,int v)
  * Function: featureIndexing
  * Description: convert uchar feature image "F" to CV_32SC1 type.
  *                If F is 3-channel, perform k-means clustering
- *                If F is 1-channel, only perform type-casting
+ *                If F is 1-channel, only perform type-casting, or a uniform quantization
+ *                when less than 256 feature levels are requested
  ***************************************************************/
 void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType weightType){
     // Configuration and Declaration
@@ -241,10 +242,22 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType
     /* For 1 channel feature image (uchar)*/
     if(F.channels() == 1)
     {
-        nF = 256;
+        nF = min(nF, 256);
 
-        // Type-casting
-        F.convertTo(FNew, CV_32S);
+        // Type-casting, each feature index covering 256/nF gray levels
+        if(nF == 256)
+            F.convertTo(FNew, CV_32S);
+        else
+        {
+            Mat lut(1, 256, CV_8U);
+            for(int i=0;i<256;i++)lut.ptr<uchar>()[i] = (uchar)(i*nF/256);
+            LUT(F, lut, FNew);
+            FNew.convertTo(FNew, CV_32S);
+        }
+
+        // The gray level at the middle of the range of each feature index
+        vector<float> level(nF);
+        for(int i=0;i<nF;i++)level[i] = (i+0.5f)*256.0f/nF-0.5f;
 
         // Compute weight map (weight between each pair of feature index)
         wMap = float2D(nF,nF);
@@ -255,7 +268,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType
         {
             for(int j=i;j<nF;j++)
             {
-                float diff = fabs((float)(i-j));
+                float diff = fabs(level[i]-level[j]);
                 float val;
 
                 switch(weightType)
@@ -264,7 +277,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType
                     case WMF_IV1: val = 1.0f/(diff+nSigmaI); break;
                     case WMF_IV2: val = 1.0f / (diff*diff+nSigmaI*nSigmaI); break;
                     case WMF_COS: val = 1.0f; break;
-                    case WMF_JAC: val = (float)(min(i,j)*1.0/max(i,j)); break;
+                    case WMF_JAC: val = (float)(min(level[i],level[j])*1.0/max(level[i],level[j])); break;
                     case WMF_OFF: val = 1.0f; break;
                     default: val = exp(-(diff*diff)*divider);
                 }
@@ -279,9 +292,9 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType
     {
         const int shift = 2; // 256(8-bit)->64(6-bit)
         const int LOW_NUM = 256>>shift;
-        static int hash[LOW_NUM][LOW_NUM][LOW_NUM]={{{0}}};
-
-        memset(hash,0,sizeof(hash));
+        // per call, so that several images can be filtered concurrently
+        vector<int> hashBuf(LOW_NUM*LOW_NUM*LOW_NUM, 0);
+        int (*hash)[LOW_NUM][LOW_NUM] = (int (*)[LOW_NUM][LOW_NUM])&hashBuf[0];
 
         // throw pixels into a 2D histogram
         int candCnt = 0;
@@ -394,6 +407,30 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType
     F = FNew;
 }
 
+/***************************************************************
+ * Class: FilterColumnsInvoker
+ * Description: filter a range of columns. Each column is scanned with its own joint-histogram,
+ *                so every range of columns holds its own joint-histogram and BCB.
+ ***************************************************************/
+class FilterColumnsInvoker : public ParallelLoopBody
+{
+public:
+    FilterColumnsInvoker(const Mat &_I, const Mat &_F, const Mat &_mask, float **_wMap, int _r, int _nF, int _nI, Mat &_outImg)
+        : I(_I), F(_F), mask(_mask), wMap(_wMap), r(_r), nF(_nF), nI(_nI), outImg(_outImg) {}
+
+    void operator()(const Range &range) const;
+
+private:
+    const Mat &I;
+    const Mat &F;
+    const Mat &mask;
+    float **wMap;
+    int r, nF, nI;
+    Mat &outImg;
+
+    FilterColumnsInvoker& operator=(const FilterColumnsInvoker&); // to quiet MSVC
+};
+
 Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
 {
     // Check validation
@@ -401,7 +438,7 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
     assert(F.depth() == CV_32S && F.channels()==1);//feature image: 32SC1
 
     // Configuration and declaration
-    int rows = I.rows, cols = I.cols;
+    int cols = I.cols;
     Mat outImg = I.clone();
 
     // Handle Mask
@@ -411,6 +448,17 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
         mask = Scalar(1);
     }
 
+    // Stripes of a few dozens of columns, to amortize the allocation of the joint-histograms
+    parallel_for_(Range(0, cols), FilterColumnsInvoker(I, F, mask, wMap, r, nF, nI, outImg), (cols + 31)/32);
+
+    // end of the function
+    return outImg;
+}
+
+void FilterColumnsInvoker::operator()(const Range &range) const
+{
+    int rows = I.rows, cols = I.cols;
+
     // Allocate memory for joint-histogram and BCB
     int **H = int2D(nI,nF);
     int *BCB = new int[nF];
@@ -422,7 +470,7 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
     int *BCBb = new int[nF];//backward link
 
     // Column Scanning
-    for(int x=0;x<cols;x++)
+    for(int x=range.start;x<range.end;x++)
     {
         // Reset histogram and BCB for each column
         memset(BCB, 0, sizeof(int)*nF);
@@ -441,9 +489,9 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
         int upY = min(rows-1,r);
         for(int i=0;i<=upY;i++)
         {
-            int *IPtr = I.ptr<int>(i);
-            int *FPtr = F.ptr<int>(i);
-            uchar *maskPtr = mask.ptr<uchar>(i);
+            const int *IPtr = I.ptr<int>(i);
+            const int *FPtr = F.ptr<int>(i);
+            const uchar *maskPtr = mask.ptr<uchar>(i);
 
             for(int j=downX;j<=upX;j++)
             {
@@ -476,7 +524,7 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
         {
             // Find weighted median with help of BCB and joint-histogram
             float balanceWeight = 0;
-            int curIndex = F.ptr<int>(y,x)[0];
+            int curIndex = F.ptr<int>(y)[x];
             float *fPtr = wMap[curIndex];
             int &curMedianVal = medianVal;
 
@@ -539,8 +587,8 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
             }
 
             // Weighted median is found and written to the output image
-            if(balanceWeight<0)outImg.ptr<int>(y,x)[0] = curMedianVal+1;
-            else outImg.ptr<int>(y,x)[0] = curMedianVal;
+            if(balanceWeight<0)outImg.ptr<int>(y)[x] = curMedianVal+1;
+            else outImg.ptr<int>(y)[x] = curMedianVal;
 
             // Update joint-histogram and BCB when local window is shifted.
             int fval,gval,*curHist;
@@ -549,9 +597,9 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
             int rownum = y + r + 1;
             if(rownum < rows)
             {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
+                    const int *inputImgPtr = I.ptr<int>(rownum);
+                    const int *guideImgPtr = F.ptr<int>(rownum);
+                    const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
                     for(int j=downX;j<=upX;j++)
                     {
@@ -585,9 +633,9 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                 rownum = y - r;
                 if(rownum >= 0)
                 {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
+                    const int *inputImgPtr = I.ptr<int>(rownum);
+                    const int *guideImgPtr = F.ptr<int>(rownum);
+                    const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
                     for(int j=downX;j<=upX;j++)
                     {
@@ -626,9 +674,6 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
         int2D_release(Hf);
         int2D_release(Hb);
     }
-
-    // end of the function
-    return outImg;
 }
 }
 
@@ -636,13 +681,14 @@ namespace cv
 {
 namespace ximgproc
 {
-void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int r, double sigma, WMFWeightType weightType, Mat mask)
+void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int r, double sigma, WMFWeightType weightType, Mat mask, int featureLevels)
 {
     CV_Assert(!src.empty());
     CV_Assert(r > 0 && sigma > 0);
+    CV_Assert(featureLevels > 0 && featureLevels <= 256);
 
     int nI = 256;
-    int nF = 256;
+    int nF = featureLevels;
 
     Mat I = src.getMat();
     Mat F = joint.getMat();
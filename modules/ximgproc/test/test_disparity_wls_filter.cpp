@@ -150,5 +150,38 @@ TEST_P(DisparityWLSFilterTest, MultiThreadReproducibility)
         EXPECT_LE(cv::norm(resSingleThread, resMultiThread, NORM_L1), MAX_MEAN_DIF*left.total());
     }
 }
+
+TEST(DisparityWLSFilterTest, UMatOutput)
+{
+    Size size(320, 240);
+    Mat left(size, CV_8UC3);
+    randu(left, 0, 255);
+    GaussianBlur(left, left, Size(0, 0), 2);
+    int max_disp = 32;
+    Mat left_disp(size, CV_16S), right_disp(size, CV_16S);
+    randu(left_disp, 0, 16*max_disp);
+    randu(right_disp, -16*max_disp, 0);
+    Rect ROI(max_disp, 0, size.width-max_disp, size.height);
+
+    for (int use_conf = 0; use_conf <= 1; use_conf++)
+    {
+        Ptr<DisparityWLSFilter> wls_filter = createDisparityWLSFilterGeneric(use_conf != 0);
+        Mat res;
+        wls_filter->filter(left_disp, left, res, right_disp, ROI);
+
+        // the solver runs on the OpenCL device when the output is an UMat
+        UMat left_ocl, left_disp_ocl, right_disp_ocl, res_ocl;
+        left.copyTo(left_ocl);
+        left_disp.copyTo(left_disp_ocl);
+        right_disp.copyTo(right_disp_ocl);
+        wls_filter->filter(left_disp_ocl, left_ocl, res_ocl, right_disp_ocl, ROI);
+        Mat res_ocl_mat = res_ocl.getMat(ACCESS_READ).clone();
+        ASSERT_EQ(res.type(), res_ocl_mat.type());
+        ASSERT_EQ(res.size(), res_ocl_mat.size());
+        EXPECT_LE(cv::norm(res, res_ocl_mat, NORM_INF), 16);
+        EXPECT_LE(cv::norm(res, res_ocl_mat, NORM_L1), 1.0/16*res.total());
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(FullSet,DisparityWLSFilterTest,Combine(Values(szODD, szQVGA), SrcTypes::all(), GuideTypes::all(),Values(true,false),Values(true,false)));
 }
@@ -253,4 +253,47 @@ TEST(DomainTransformTest, AuthorReferenceAccuracy)
     EXPECT_LE(cvtest::norm(res_IC, ref_IC, NORM_INF), 1);
 }
 
+TEST(DomainTransformTest, StreamingAndArrays)
+{
+    static int dtModes[] = {DTF_NC, DTF_IC, DTF_RF};
+
+    Mat original = imread(getOpenCVExtraDir() + "cv/edgefilter/statue.png");
+    ASSERT_FALSE(original.empty());
+    Mat frame1 = convertTypeAndSize(original, CV_8UC3, szQVGA);
+    Mat frame2;
+    flip(frame1, frame2, 1);
+
+    Mat srcGray = convertTypeAndSize(original, CV_32FC1, szQVGA);
+    std::vector<Mat> srcs;
+    srcs.push_back(frame2);
+    srcs.push_back(srcGray);
+
+    for (int i = 0; i < 3; i++)
+    {
+        int mode = dtModes[i];
+        Ptr<DTFilter> dtf = createDTFilter(frame1, 30, 20, mode);
+        Mat res1;
+        dtf->filter(frame1, res1);
+
+        //the next frame reuses the domain transform buffers of the first one
+        dtf->setGuide(frame2);
+        Mat res2, res2Ref;
+        dtf->filter(frame2, res2);
+        dtFilter(frame2, frame2, res2Ref, 30, 20, mode);
+        EXPECT_EQ(0, cvtest::norm(res2, res2Ref, NORM_INF));
+
+        //the channels of several sources are filtered together
+        std::vector<Mat> res;
+        dtf->filterArrays(srcs, res);
+        ASSERT_EQ(srcs.size(), res.size());
+        for (size_t k = 0; k < srcs.size(); k++)
+        {
+            Mat resRef;
+            dtf->filter(srcs[k], resRef);
+            ASSERT_EQ(resRef.type(), res[k].type());
+            EXPECT_EQ(0, cvtest::norm(res[k], resRef, NORM_INF));
+        }
+    }
+}
+
 }
@@ -0,0 +1,66 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::ximgproc;
+
+// The sum over the window positions of the products of the pixels a and b of the window
+static Mat referenceCovariance(const Mat& input, int pr, int pc)
+{
+    int n = pr*pc;
+    Mat cov(n, n, CV_64FC2);
+    for (int a = 0; a < n; a++)
+    {
+        for (int b = 0; b < n; b++)
+        {
+            double re = 0, im = 0;
+            for (int i = 0; i <= input.rows - pr; i++)
+            {
+                for (int j = 0; j <= input.cols - pc; j++)
+                {
+                    Vec2f p = input.at<Vec2f>(i + a % pr, j + a / pr);
+                    Vec2f q = input.at<Vec2f>(i + b % pr, j + b / pr);
+                    re += (double)p[0]*q[0] - (double)p[1]*q[1];
+                    im += (double)p[0]*q[1] + (double)p[1]*q[0];
+                }
+            }
+            cov.at<Vec2d>(a, b) = Vec2d(re, im);
+        }
+    }
+    return cov;
+}
+
+TEST(EstimatedCovarianceTest, SameAsDefinition)
+{
+    RNG rng(0);
+    Mat complexImage(23, 31, CV_32FC2), grayImage(19, 17, CV_8UC1);
+    rng.fill(complexImage, RNG::UNIFORM, -1, 1);
+    rng.fill(grayImage, RNG::UNIFORM, 0, 256);
+
+    const Size windows[] = { Size(1, 1), Size(3, 4), Size(5, 2), Size(17, 19) };
+    for (int k = 0; k < 4; k++)
+    {
+        int pr = windows[k].height, pc = windows[k].width;
+
+        Mat cov, expected;
+        covarianceEstimation(complexImage, cov, pr, pc);
+        ASSERT_EQ(CV_32FC2, cov.type());
+        referenceCovariance(complexImage, pr, pc).convertTo(expected, CV_32F);
+        EXPECT_LE(cvtest::norm(cov, expected, NORM_INF), 1e-3) << "window " << windows[k];
+
+        Mat grayComplex, planes[] = { Mat(), Mat::zeros(grayImage.size(), CV_32F) };
+        grayImage.convertTo(planes[0], CV_32F);
+        merge(planes, 2, grayComplex);
+        covarianceEstimation(grayImage, cov, pr, pc);
+        referenceCovariance(grayComplex, pr, pc).convertTo(expected, CV_32F);
+        EXPECT_LE(cvtest::norm(cov, expected, NORM_INF) / cvtest::norm(expected, NORM_INF), 1e-6) << "window " << windows[k];
+    }
+}
+
+}
@@ -467,4 +467,33 @@ INSTANTIATE_TEST_CASE_P(FullSet, FastHoughTransformTest,
 #undef FHT_ALL_DEPTHS
 #undef FHT_ALL_CHANNELS
 
+TEST(FastHoughTransformTest, batchAndThreads)
+{
+    RNG rng(0);
+    vector<Mat> src(3);
+    for (size_t i = 0; i < src.size(); ++i)
+    {
+        src[i].create(37, 64, CV_8UC1);
+        rng.fill(src[i], RNG::UNIFORM, 0, 255);
+    }
+
+    int const ops[] = { FHT_ADD, FHT_MIN, FHT_MAX, FHT_AVE };
+    for (int o = 0; o < 4; ++o)
+    {
+        vector<Mat> dst;
+        FastHoughTransformBatch(src, dst, CV_32S, ARO_315_135, ops[o]);
+        ASSERT_EQ(src.size(), dst.size());
+
+        int const threads = getNumThreads();
+        setNumThreads(1);
+        for (size_t i = 0; i < src.size(); ++i)
+        {
+            Mat expected;
+            FastHoughTransform(src[i], expected, CV_32S, ARO_315_135, ops[o]);
+            EXPECT_EQ(0, cvtest::norm(dst[i], expected, NORM_INF));
+        }
+        setNumThreads(threads);
+    }
+}
+
 } // namespace cvtest
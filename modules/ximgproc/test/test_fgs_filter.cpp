@@ -106,6 +106,24 @@ TEST(FastGlobalSmootherTest, ReferenceAccuracy)
     EXPECT_LE(cvtest::norm(res, ref, NORM_INF), 1);
 }
 
+TEST(FastGlobalSmootherTest, ReusedWeightsLUT)
+{
+    RNG rnd(0);
+    Size sz(123, 97);
+    Mat grayGuide(sz, CV_8UC1), colorGuide(sz, CV_8UC3), src(sz, CV_8UC3);
+    randu(grayGuide, 0, 255);
+    randu(colorGuide, 0, 255);
+    randu(src, 0, 255);
+
+    // the LUT of a gray guide is shorter, it must be extended for a color guide of the same sigma
+    Mat ref, res;
+    fastGlobalSmootherFilter(colorGuide, src, ref, 1000.0, 10.0);
+    fastGlobalSmootherFilter(grayGuide, src, res, 1000.0, 30.0);
+    fastGlobalSmootherFilter(grayGuide, src, res, 1000.0, 10.0);
+    fastGlobalSmootherFilter(colorGuide, src, res, 1000.0, 10.0);
+    EXPECT_EQ(0, cvtest::norm(ref, res, NORM_INF));
+}
+
 TEST_P(FastGlobalSmootherTest, MultiThreadReproducibility)
 {
     if (cv::getNumberOfCPUs() == 1)
@@ -0,0 +1,44 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::ximgproc::segmentation;
+
+TEST(GraphSegmentationTest, flatAreas)
+{
+    // four flat quadrants with some noise, the blurred borders being smaller than min_size
+    Mat img(240, 320, CV_8UC3);
+    img(Rect(0, 0, 160, 120)).setTo(Scalar(20, 20, 200));
+    img(Rect(160, 0, 160, 120)).setTo(Scalar(20, 200, 20));
+    img(Rect(0, 120, 160, 120)).setTo(Scalar(200, 20, 20));
+    img(Rect(160, 120, 160, 120)).setTo(Scalar(200, 200, 200));
+    Mat noise(img.size(), img.type());
+    RNG rng(0);
+    rng.fill(noise, RNG::UNIFORM, 0, 4);
+    img += noise;
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.5, 300, 500);
+    Mat segments;
+    gs->processImage(img, segments);
+    ASSERT_EQ(CV_32SC1, segments.type());
+
+    double min, max;
+    minMaxLoc(segments, &min, &max);
+    EXPECT_EQ(0, min);
+    EXPECT_EQ(3, max);
+    EXPECT_NE(segments.at<int>(0, 0), segments.at<int>(0, 319));
+    EXPECT_NE(segments.at<int>(0, 0), segments.at<int>(239, 0));
+    EXPECT_NE(segments.at<int>(239, 319), segments.at<int>(0, 319));
+
+    // the segments don't depend on the number of threads
+    int threads = getNumThreads();
+    setNumThreads(1);
+    Mat segmentsSerial;
+    gs->processImage(img, segmentsSerial);
+    setNumThreads(threads);
+    EXPECT_EQ(0, cvtest::norm(segments, segmentsSerial, NORM_INF));
+}
+
+}
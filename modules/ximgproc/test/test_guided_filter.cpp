@@ -428,6 +428,40 @@ TEST_P(GuidedFilterTest, smallParamsIssue)
     EXPECT_LE(whiteRate, 0.1);
 }
 
+TEST(GuidedFilterTest, fastSubsampled)
+{
+    Mat guide = imread(getOpenCVExtraDir() + "cv/shared/lena.png");
+    Mat src = imread(getOpenCVExtraDir() + "cv/shared/baboon.png");
+    ASSERT_TRUE(!guide.empty() && !src.empty());
+    src = convertTypeAndSize(src, src.type(), guide.size());
+
+    int radius = 16;
+    double eps = SQR(0.1*255.0);
+
+    Mat res, resFast;
+    guidedFilter(guide, src, res, radius, eps);
+    Ptr<GuidedFilter> gf = createGuidedFilter(guide, radius, eps, 4);
+    gf->filter(src, resFast);
+    ASSERT_EQ(res.size(), resFast.size());
+    ASSERT_EQ(res.type(), resFast.type());
+
+    //the subsampled coefficients are close to the full resolution ones
+    double meanAbsDiff = cv::norm(res, resFast, NORM_L1) / (double)res.total() / res.channels();
+    EXPECT_LE(meanAbsDiff, 3.0);
+
+    //the buffers kept by the filter don't leak between the calls
+    Mat srcFlipped, resFlipped, resFlippedRef;
+    flip(src, srcFlipped, 1);
+    gf->filter(srcFlipped, resFlipped);
+    createGuidedFilter(guide, radius, eps, 4)->filter(srcFlipped, resFlippedRef);
+    EXPECT_EQ(0, cv::norm(resFlipped, resFlippedRef, NORM_INF));
+
+    Mat resFastAgain;
+    gf->filter(src, resFastAgain, CV_32F);
+    resFastAgain.convertTo(resFastAgain, resFast.type());
+    EXPECT_EQ(0, cv::norm(resFast, resFastAgain, NORM_INF));
+}
+
 INSTANTIATE_TEST_CASE_P(TypicalSet, GuidedFilterTest,
     Combine(
     Values(1, 3),
@@ -75,6 +75,20 @@ TEST(L0SmoothTest, SplatSurfaceAccuracy)
     }
 }
 
+TEST(L0SmoothTest, ReusedGradientOperators)
+{
+    Mat src(97, 123, CV_8UC3), other(64, 80, CV_8UC1);
+    randu(src, 0, 255);
+    randu(other, 0, 255);
+
+    // the operators kept for the size of another image must not be used
+    Mat ref, res;
+    l0Smooth(src, ref);
+    l0Smooth(other, res);
+    l0Smooth(src, res);
+    EXPECT_EQ(0, cvtest::norm(ref, res, NORM_INF));
+}
+
 TEST_P(L0SmoothTest, MultiThreadReproducibility)
 {
     if (cv::getNumberOfCPUs() == 1)
@@ -0,0 +1,48 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::ximgproc;
+
+TEST(NiBlackThresholdTest, boxFilterReference)
+{
+    Mat src(240, 320, CV_8UC1);
+    RNG rng(0);
+    rng.fill(src, RNG::UNIFORM, 0, 255);
+    GaussianBlur(src, src, Size(0, 0), 3);
+    int blockSize = 15;
+    double k = -0.2;
+
+    // the thresholds of the box filters the integral images replace
+    Mat mean, sqmean, stddev, thresh;
+    boxFilter(src, mean, CV_32F, Size(blockSize, blockSize), Point(-1,-1), true, BORDER_REPLICATE);
+    sqrBoxFilter(src, sqmean, CV_32F, Size(blockSize, blockSize), Point(-1,-1), true, BORDER_REPLICATE);
+    sqrt(max(sqmean - mean.mul(mean), 0), stddev);
+
+    thresh = mean + stddev * k;
+    thresh.convertTo(thresh, CV_8U);
+    Mat ref, dst;
+    compare(src, thresh, ref, CMP_GT);
+    niBlackThreshold(src, dst, 255, THRESH_BINARY, blockSize, k);
+    // a few thresholds may round the other way
+    EXPECT_LE(countNonZero(ref != dst), (int)src.total() / 500);
+
+    Mat sauvola = mean.mul(1 + 0.3 * (stddev / 128 - 1));
+    sauvola.convertTo(thresh, CV_8U);
+    compare(src, thresh, ref, CMP_LE);
+    niBlackThreshold(src, dst, 255, THRESH_BINARY_INV, blockSize, 0.3, BINARIZATION_SAUVOLA, 128);
+    EXPECT_LE(countNonZero(ref != dst), (int)src.total() / 500);
+
+    double srcMin, maxStddev;
+    minMaxLoc(src, &srcMin);
+    minMaxLoc(stddev, 0, &maxStddev);
+    Mat wolf = mean - 0.5 * (1 - stddev / maxStddev).mul(mean - srcMin);
+    wolf.convertTo(thresh, CV_8U);
+    compare(src, thresh, ref, CMP_GT);
+    niBlackThreshold(src, dst, 255, THRESH_BINARY, blockSize, 0.5, BINARIZATION_WOLF);
+    EXPECT_LE(countNonZero(ref != dst), (int)src.total() / 500);
+}
+
+}
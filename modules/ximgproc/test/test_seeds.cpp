@@ -0,0 +1,38 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::ximgproc;
+
+TEST(SuperpixelSEEDSTest, threadCountInvariance)
+{
+    Mat img(480, 640, CV_8UC3);
+    RNG rng(0);
+    rng.fill(img, RNG::UNIFORM, 0, 255);
+    GaussianBlur(img, img, Size(0, 0), 4);
+
+    Mat labels, labelsSerial;
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(), 400, 4);
+    seeds->iterate(img, 4);
+    seeds->getLabels(labels);
+    ASSERT_EQ(CV_32SC1, labels.type());
+    ASSERT_EQ(img.size(), labels.size());
+
+    double min, max;
+    minMaxLoc(labels, &min, &max);
+    EXPECT_GE(min, 0);
+    EXPECT_LT(max, seeds->getNumberOfSuperpixels());
+
+    // the stripes of rows don't depend on the number of threads
+    int threads = getNumThreads();
+    setNumThreads(1);
+    Ptr<SuperpixelSEEDS> seedsSerial = createSuperpixelSEEDS(img.cols, img.rows, img.channels(), 400, 4);
+    seedsSerial->iterate(img, 4);
+    seedsSerial->getLabels(labelsSerial);
+    setNumThreads(threads);
+    EXPECT_EQ(0, cvtest::norm(labels, labelsSerial, NORM_INF));
+}
+
+}
@@ -37,4 +37,43 @@ TEST(ximpgroc_StructuredEdgeDetection, regression)
     }
 }
 
+TEST(ximpgroc_StructuredEdgeDetection, speedPresetsAndThreads)
+{
+    cv::String dir = cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/";
+    cv::Ptr<cv::ximgproc::StructuredEdgeDetection> pDollar =
+        cv::ximgproc::createStructuredEdgeDetection(dir + "model.yml.gz");
+
+    cv::Mat src = cv::imread( dir + "sources/01.png", 1 );
+    ASSERT_TRUE(!src.empty());
+    src.convertTo( src, cv::DataType<float>::type, 1/255.0 );
+
+    cv::Mat accurate, accurateSerial;
+    pDollar->detectEdges( src, accurate );
+
+    // the edges don't depend on the number of threads
+    int threads = cv::getNumThreads();
+    cv::setNumThreads(1);
+    pDollar->detectEdges( src, accurateSerial );
+    cv::setNumThreads(threads);
+    EXPECT_EQ( 0, cvtest::norm(accurate, accurateSerial, cv::NORM_INF) );
+
+    int presets[] = { cv::ximgproc::SED_PRESET_FAST, cv::ximgproc::SED_PRESET_FASTEST };
+    for (int i = 0; i < 2; ++i)
+    {
+        cv::Mat fast;
+        pDollar->setSpeedPreset( presets[i] );
+        pDollar->detectEdges( src, fast );
+        ASSERT_EQ( accurate.size(), fast.size() );
+
+        cv::Mat sqrError = ( fast - accurate ).mul( fast - accurate );
+        cv::Scalar mse = cv::sum(sqrError) / cv::Scalar::all( double( sqrError.total() ) );
+        EXPECT_LE( mse[0], 0.01 );
+    }
+
+    cv::Mat accurateAgain;
+    pDollar->setSpeedPreset( cv::ximgproc::SED_PRESET_ACCURATE );
+    pDollar->detectEdges( src, accurateAgain );
+    EXPECT_EQ( 0, cvtest::norm(accurate, accurateAgain, cv::NORM_INF) );
+}
+
 }
\ No newline at end of file
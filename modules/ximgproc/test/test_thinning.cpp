@@ -0,0 +1,39 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::ximgproc;
+
+TEST(ThinningTest, skeletonOfBars)
+{
+    for (int thinningType = THINNING_ZHANGSUEN; thinningType <= THINNING_GUOHALL; thinningType++)
+    {
+        Mat img = Mat::zeros(120, 160, CV_8UC1);
+        rectangle(img, Rect(20, 20, 120, 9), Scalar(255), -1);
+        rectangle(img, Rect(70, 40, 9, 60), Scalar(255), -1);
+
+        Mat skeleton;
+        thinning(img, skeleton, thinningType);
+        ASSERT_EQ(CV_8UC1, skeleton.type());
+
+        // the skeleton is made of input pixels only, and each bar is reduced to a line of its length
+        Mat outside;
+        bitwise_and(skeleton, ~img, outside);
+        EXPECT_EQ(0, countNonZero(outside));
+        EXPECT_EQ(1, countNonZero(skeleton(Rect(80, 20, 1, 9))));
+        EXPECT_EQ(1, countNonZero(skeleton(Rect(70, 70, 9, 1))));
+        EXPECT_GE(countNonZero(skeleton(Rect(20, 20, 120, 9))), 100);
+
+        // the rows visited by each sub-iteration don't depend on the number of threads
+        int threads = getNumThreads();
+        setNumThreads(1);
+        Mat skeletonSerial;
+        thinning(img, skeletonSerial, thinningType);
+        setNumThreads(threads);
+        EXPECT_EQ(0, cvtest::norm(skeleton, skeletonSerial, NORM_INF));
+    }
+}
+
+}
@@ -102,6 +102,32 @@ TEST(WeightedMedianFilterTest, ReferenceAccuracy)
     EXPECT_LE(cvtest::norm(res, ref, NORM_L2), totalMaxError);
 }
 
+TEST(WeightedMedianFilterTest, ThreadsAndFeatureLevels)
+{
+    string dir = getDataDir() + "cv/edgefilter";
+
+    Mat src = imread(dir + "/kodim23.png");
+    ASSERT_FALSE(src.empty());
+    Mat gray;
+    cvtColor(src, gray, COLOR_BGR2GRAY);
+
+    Mat res, resSerial;
+    weightedMedianFilter(gray, src, res, 7);
+
+    // the column stripes don't change the result
+    int threads = cv::getNumThreads();
+    cv::setNumThreads(1);
+    weightedMedianFilter(gray, src, resSerial, 7);
+    cv::setNumThreads(threads);
+    EXPECT_EQ(0, cvtest::norm(res, resSerial, NORM_INF));
+
+    // a coarser joint-histogram stays close to the full one
+    Mat resFast;
+    weightedMedianFilter(gray, src, resFast, 7, 25.5, WMF_EXP, Mat(), 64);
+    double normL1 = cvtest::norm(res, resFast, NORM_L1)/src.total()/src.channels();
+    EXPECT_LE(normL1, 2.0);
+}
+
 INSTANTIATE_TEST_CASE_P(TypicalSET, WeightedMedianFilterTest, Combine(Values(szODD, szQVGA),  Values(WMF_EXP, WMF_IV2, WMF_OFF)));
 
 }
@@ -89,6 +89,35 @@ public:
         std::vector<Rect> &bboxes,
         std::vector<double> &confidences) = 0;
 
+    /** @brief Shift the rejection thresholds of all the cascade stages
+
+    A trained detector can run at several speed and recall operating points without retraining. A
+    positive shift rejects the windows at earlier stages, which is faster and finds fewer objects. A
+    negative shift keeps more windows. The shift is not saved with the detector.
+    @param shift Value added to the trained threshold of every stage, 0 by default
+    */
+    virtual void setThresholdShift(float shift) = 0;
+
+    /** @brief Returns the shift of the stage thresholds, see setThresholdShift
+    */
+    virtual float getThresholdShift() const = 0;
+
+    /** @brief Cascade statistics of the windows evaluated by detect since the last resetStatistics
+
+    @param rejectionRates For each stage, the fraction of the windows reaching the stage that are
+    rejected by it
+    @param meanStages Average number of stages evaluated per window
+    @param windows Number of evaluated windows
+    */
+    virtual void getStatistics(
+        std::vector<double> &rejectionRates,
+        double &meanStages,
+        int64 &windows) const = 0;
+
+    /** @brief Restart the statistics returned by getStatistics
+    */
+    virtual void resetStatistics() = 0;
+
     /** @brief Create instance of WBDetector
     */
     static Ptr<WBDetector> create();
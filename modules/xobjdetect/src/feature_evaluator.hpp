@@ -128,6 +128,12 @@ public:
     virtual void setWindow(const cv::Point& p) = 0;
     virtual void writeFeatures( cv::FileStorage &fs, const cv::Mat& featureMap ) const = 0;
     virtual float operator()(int featureIdx) = 0;
+    // value of a feature in the window at p of the current image, the current window is
+    // not changed, so that the windows of an image can be evaluated concurrently
+    virtual float calcAt(const cv::Point& p, int featureIdx) const = 0;
+    // values of all the features for an image of the window size, into column col of the
+    // numFeatures x N data, for the training; images can also be evaluated concurrently
+    virtual void calcAll(const cv::Mat& img, cv::Mat& data, int col) const = 0;
     static cv::Ptr<CvFeatureEvaluator> create();
 
     int getNumFeatures() const { return numFeatures; }
@@ -66,6 +66,11 @@ void CvLBPEvaluator::setImage(const Mat &img, uchar clsLabel, int idx,
 {
     CV_DbgAssert( !sum.empty() );
     CvFeatureEvaluator::setImage( img, clsLabel, idx, feature_ind );
+    // the buffer only grows, the scales of a multi-scale detection are computed without reallocation
+    Size sumSize( img.cols + 1, img.rows + 1 );
+    if( sumBuf.rows < sumSize.height || sumBuf.cols < sumSize.width )
+        sumBuf.create( std::max(sumBuf.rows, sumSize.height), std::max(sumBuf.cols, sumSize.width), CV_32SC1 );
+    sum = sumBuf( Rect(Point(), sumSize) );
     integral( img, sum );
     cur_sum = sum;
     offset_ = int(sum.ptr<int>(1) - sum.ptr<int>());
@@ -74,6 +79,18 @@ void CvLBPEvaluator::setImage(const Mat &img, uchar clsLabel, int idx,
     }
 }
 
+void CvLBPEvaluator::calcAll(const Mat &img, Mat &data, int col) const
+{
+    CV_Assert( img.cols >= winSize.width && img.rows >= winSize.height );
+    CV_Assert( data.rows == numFeatures && data.type() == CV_8UC1 );
+    // continuous, so that its step is the one of the window points of the features
+    Mat windowSum( winSize.height + 1, winSize.width + 1, CV_32SC1 );
+    integral( img(Rect(Point(), winSize)), windowSum );
+    const int* psum = windowSum.ptr<int>();
+    for( int fi = 0; fi < numFeatures; fi++ )
+        data.at<uchar>(fi, col) = features[fi].calcWindow( psum );
+}
+
 void CvLBPEvaluator::writeFeatures( FileStorage &fs, const Mat& featureMap ) const
 {
     _writeFeatures( features, fs, featureMap );
@@ -104,6 +121,7 @@ CvLBPEvaluator::Feature::Feature( int offset, int x, int y, int _blockWidth, int
     block_h_ = _blockHeight;
     offset_ = offset;
     calcPoints(offset);
+    std::copy( p, p + 16, wp );
 }
 
 void CvLBPEvaluator::Feature::calcPoints(int offset)
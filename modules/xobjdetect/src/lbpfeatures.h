@@ -59,6 +59,9 @@ struct CvLBPFeatureParams : CvFeatureParams
 
 };
 
+// the MB-LBP code of the 3x3 blocks at the points p of an integral image
+inline uchar calcLBP(const int* psum, const int* p);
+
 class CvLBPEvaluator : public CvFeatureEvaluator
 {
 public:
@@ -70,6 +73,9 @@ public:
     { cur_sum = sum.rowRange(p.y, p.y + winSize.height).colRange(p.x, p.x + winSize.width); }
     virtual float operator()(int featureIdx)
     { return (float)features[featureIdx].calc( cur_sum ); }
+    virtual float calcAt(const cv::Point& p, int featureIdx) const
+    { return (float)features[featureIdx].calc( sum.ptr<int>(p.y) + p.x ); }
+    virtual void calcAll(const cv::Mat& img, cv::Mat& data, int col) const;
     virtual void writeFeatures( cv::FileStorage &fs, const cv::Mat& featureMap ) const;
 protected:
     virtual void generateFeatures();
@@ -79,25 +85,44 @@ protected:
     public:
         Feature();
         Feature( int offset, int x, int y, int _block_w, int _block_h  );
-        uchar calc( const cv::Mat& _sum );
+        uchar calc( const cv::Mat& _sum ) const;
+        uchar calc( const int* psum ) const;
+        // value in an integral image of the window size, whatever the current image
+        uchar calcWindow( const int* psum ) const;
         void write( cv::FileStorage &fs ) const;
 
         cv::Rect rect;
         int p[16];
+        // the points in an integral image of the window size
+        int wp[16];
 
         int x_, y_, block_w_, block_h_, offset_;
         void calcPoints(int offset);
     };
     std::vector<Feature> features;
 
-    cv::Mat sum, cur_sum;
+    // the integral images are computed in sumBuf, reused by the next images
+    cv::Mat sumBuf, sum, cur_sum;
     int offset_;
 };
 
-inline uchar CvLBPEvaluator::Feature::calc(const cv::Mat &_sum)
+inline uchar CvLBPEvaluator::Feature::calc(const cv::Mat &_sum) const
 {
-    const int* psum = _sum.ptr<int>();
+    return calc( _sum.ptr<int>() );
+}
+
+inline uchar CvLBPEvaluator::Feature::calc(const int* psum) const
+{
+    return calcLBP( psum, p );
+}
 
+inline uchar CvLBPEvaluator::Feature::calcWindow(const int* psum) const
+{
+    return calcLBP( psum, wp );
+}
+
+inline uchar calcLBP(const int* psum, const int* p)
+{
     int cval = psum[p[5]] - psum[p[6]] - psum[p[9]] + psum[p[10]];
 
     return (uchar)((psum[p[0]] - psum[p[1]] - psum[p[4]] + psum[p[5]] >= cval ? 128 : 0) |   // 0
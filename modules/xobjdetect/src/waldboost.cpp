@@ -87,23 +87,120 @@ static void compute_min_step(const Mat &data_pos, const Mat &data_neg, size_t n_
     data_step = (data_max - data_min) / (double)(n_bins - 1);
 }
 
-static void quantize_data(Mat &data, Mat1f &data_min, Mat1f &data_step)
+class QuantizeInvoker : public ParallelLoopBody
 {
-//#pragma omp parallel for
-    for (int col = 0; col < data.cols; ++col) {
-        data.col(col) -= data_min;
-        data.col(col) /= data_step;
+public:
+    QuantizeInvoker(Mat &_data, const Mat1f &_data_min, const Mat1f &_data_step)
+        : data(_data), data_min(_data_min), data_step(_data_step)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        for (int col = range.start; col < range.end; ++col) {
+            data.col(col) -= data_min;
+            data.col(col) /= data_step;
+        }
     }
+
+private:
+    Mat &data;
+    const Mat1f &data_min, &data_step;
+
+    QuantizeInvoker& operator=(const QuantizeInvoker&); // to quiet MSVC
+};
+
+static void quantize_data(Mat &data, Mat1f &data_min, Mat1f &data_step)
+{
+    parallel_for_(Range(0, data.cols), QuantizeInvoker(data, data_min, data_step));
     data.convertTo(data, CV_8U);
 }
 
+struct WeakLearner
+{
+    double err;
+    int feature_ind;
+    int polarity;
+    int threshold_q;
+};
+
+// the best weak learner of each block of features, the blocks are reduced
+// in their order so that the choice is the same as with a serial search
+class WeakLearnerSearchInvoker : public ParallelLoopBody
+{
+public:
+    WeakLearnerSearchInvoker(const Mat &_data_pos, const Mat &_data_neg,
+                             const Mat1f &_pos_weights, const Mat1f &_neg_weights,
+                             const std::vector<bool> &_feature_ignore, int _n_bins,
+                             int _block_size, std::vector<WeakLearner> &_best)
+        : data_pos(_data_pos), data_neg(_data_neg), pos_weights(_pos_weights),
+          neg_weights(_neg_weights), feature_ignore(_feature_ignore), n_bins(_n_bins),
+          block_size(_block_size), best(_best)
+    {
+        neg_total = (float)sum(neg_weights)[0];
+    }
+
+    void operator()(const Range& range) const
+    {
+        Mat1f pos_cdf(1, n_bins), neg_cdf(1, n_bins);
+        Mat1f err_direct(1, n_bins), err_backward(1, n_bins);
+        for (int block = range.start; block < range.end; ++block) {
+            WeakLearner &b = best[block];
+            b.err = DBL_MAX;
+            b.feature_ind = -1;
+            b.polarity = 0;
+            b.threshold_q = 0;
+            int end = std::min((block + 1) * block_size, data_pos.rows);
+            for (int feat_i = block * block_size; feat_i < end; ++feat_i) {
+                if (feature_ignore[feat_i])
+                    continue;
+
+                // Construct cdf
+                compute_cdf(data_pos.row(feat_i), pos_weights, pos_cdf);
+                compute_cdf(data_neg.row(feat_i), neg_weights, neg_cdf);
+
+                err_direct = pos_cdf + neg_total - neg_cdf;
+                err_backward = 1.0f - err_direct;
+
+                int idx1[2], idx2[2];
+                double err1, err2;
+                minMaxIdx(err_direct, &err1, NULL, idx1);
+                minMaxIdx(err_backward, &err2, NULL, idx2);
+                if (min(err1, err2) < b.err) {
+                    if (err1 < err2) {
+                        b.err = err1;
+                        b.polarity = +1;
+                        b.threshold_q = idx1[1];
+                    } else {
+                        b.err = err2;
+                        b.polarity = -1;
+                        b.threshold_q = idx2[1];
+                    }
+                    b.feature_ind = feat_i;
+                }
+            }
+        }
+    }
+
+private:
+    const Mat &data_pos, &data_neg;
+    const Mat1f &pos_weights, &neg_weights;
+    const std::vector<bool> &feature_ignore;
+    int n_bins, block_size;
+    float neg_total;
+    std::vector<WeakLearner> &best;
+
+    WeakLearnerSearchInvoker& operator=(const WeakLearnerSearchInvoker&); // to quiet MSVC
+};
+
 WaldBoost::WaldBoost(int weak_count):
     weak_count_(weak_count),
     thresholds_(),
     alphas_(),
     feature_indices_(),
     polarities_(),
-    cascade_thresholds_() {}
+    cascade_thresholds_(),
+    threshold_shift_(0) {}
 
 WaldBoost::WaldBoost():
     weak_count_(),
@@ -111,73 +208,135 @@ WaldBoost::WaldBoost():
     alphas_(),
     feature_indices_(),
     polarities_(),
-    cascade_thresholds_() {}
+    cascade_thresholds_(),
+    threshold_shift_(0) {}
 
 std::vector<int> WaldBoost::get_feature_indices()
 {
     return feature_indices_;
 }
 
-void WaldBoost::detect(Ptr<CvFeatureEvaluator> eval,
-            const Mat& img, const std::vector<float>& scales,
-            std::vector<Rect>& bboxes, Mat1f& confidences)
+// the rows of windows of a scale are evaluated in parallel, each into its own lists
+class DetectRowsInvoker : public ParallelLoopBody
 {
-    bboxes.clear();
-    confidences.release();
+public:
+    DetectRowsInvoker(const WaldBoost& _boost, const CvFeatureEvaluator& _eval,
+                      float _scale, int _step, int _cols,
+                      std::vector<std::vector<Rect> >& _rowBboxes,
+                      std::vector<std::vector<float> >& _rowConfidences,
+                      WaldBoostStatistics& _statistics, Mutex& _statistics_mutex)
+        : boost(_boost), eval(_eval), scale(_scale), step(_step), cols(_cols),
+          rowBboxes(_rowBboxes), rowConfidences(_rowConfidences),
+          statistics(_statistics), statistics_mutex(_statistics_mutex)
+    {
+    }
 
-    Mat resized_img;
-    int step = 4;
-    float h;
-    for (size_t i = 0; i < scales.size(); ++i) {
-        float scale = scales[i];
-        resize(img, resized_img, Size(), scale, scale);
-        eval->setImage(resized_img, 0, 0, feature_indices_);
+    void operator()(const Range& range) const
+    {
         int n_rows = (int)(24 / scale);
         int n_cols = (int)(24 / scale);
-        for (int r = 0; r + 24 < resized_img.rows; r += step) {
-            for (int c = 0; c + 24 < resized_img.cols; c += step) {
-                //eval->setImage(resized_img(Rect(c, r, 24, 24)), 0, 0);
-                eval->setWindow(Point(c, r));
-                if (predict(eval, &h) == +1) {
+        float h;
+        // counted locally, then added to the shared statistics once per stripe
+        std::vector<int64> rejections(statistics.rejections.size(), 0);
+        int64 windows = 0, evaluations = 0;
+        int last = (int)rejections.size() - 1;
+        for (int i = range.start; i < range.end; ++i) {
+            int r = i * step;
+            for (int c = 0; c + 24 < cols; c += step) {
+                int stages = 0;
+                int label = boost.predict(eval, Point(c, r), &h, &stages);
+                windows += 1;
+                evaluations += stages;
+                if (label == +1) {
                     int row = (int)(r / scale);
                     int col = (int)(c / scale);
-                    bboxes.push_back(Rect(col, row, n_cols, n_rows));
-                    confidences.push_back(h);
+                    rowBboxes[i].push_back(Rect(col, row, n_cols, n_rows));
+                    rowConfidences[i].push_back(h);
+                    rejections[last] += 1;
+                } else {
+                    rejections[std::max(stages - 1, 0)] += 1;
                 }
             }
         }
+
+        AutoLock lock(statistics_mutex);
+        for (size_t k = 0; k < rejections.size(); ++k)
+            statistics.rejections[k] += rejections[k];
+        statistics.windows += windows;
+        statistics.evaluations += evaluations;
     }
-    groupRectangles(bboxes, 3, 0.7);
-}
 
-void WaldBoost::detect(Ptr<CvFeatureEvaluator> eval,
+private:
+    const WaldBoost& boost;
+    const CvFeatureEvaluator& eval;
+    float scale;
+    int step, cols;
+    std::vector<std::vector<Rect> >& rowBboxes;
+    std::vector<std::vector<float> >& rowConfidences;
+    WaldBoostStatistics& statistics;
+    Mutex& statistics_mutex;
+
+    DetectRowsInvoker& operator=(const DetectRowsInvoker&); // to quiet MSVC
+};
+
+void WaldBoost::detectWindows(Ptr<CvFeatureEvaluator> eval,
             const Mat& img, const std::vector<float>& scales,
-            std::vector<Rect>& bboxes, std::vector<double>& confidences)
+            std::vector<Rect>& bboxes, std::vector<float>& confidences)
 {
     bboxes.clear();
     confidences.clear();
 
     Mat resized_img;
     int step = 4;
-    float h;
+    std::vector<std::vector<Rect> > rowBboxes;
+    std::vector<std::vector<float> > rowConfidences;
+    {
+        AutoLock lock(statistics_mutex_);
+        // restarted when the cascade has another length
+        if (statistics_.rejections.size() != size_t(weak_count_ + 1)) {
+            statistics_ = WaldBoostStatistics();
+            statistics_.rejections.resize(weak_count_ + 1, 0);
+        }
+    }
     for (size_t i = 0; i < scales.size(); ++i) {
         float scale = scales[i];
         resize(img, resized_img, Size(), scale, scale);
+        // the integral image of the scale is computed once, then only read by the windows
         eval->setImage(resized_img, 0, 0, feature_indices_);
-        int n_rows = (int)(24 / scale);
-        int n_cols = (int)(24 / scale);
-        for (int r = 0; r + 24 < resized_img.rows; r += step) {
-            for (int c = 0; c + 24 < resized_img.cols; c += step) {
-                eval->setWindow(Point(c, r));
-                if (predict(eval, &h) == +1) {
-                    int row = (int)(r / scale);
-                    int col = (int)(c / scale);
-                    bboxes.push_back(Rect(col, row, n_cols, n_rows));
-                    confidences.push_back(h);
-                }
-            }
+        int n_window_rows = resized_img.rows > 24 ? (resized_img.rows - 24 + step - 1) / step : 0;
+        rowBboxes.assign(n_window_rows, std::vector<Rect>());
+        rowConfidences.assign(n_window_rows, std::vector<float>());
+        parallel_for_(Range(0, n_window_rows),
+                      DetectRowsInvoker(*this, *eval, scale, step, resized_img.cols,
+                                        rowBboxes, rowConfidences,
+                                        statistics_, statistics_mutex_));
+        // in the order of the serial scan
+        for (int r = 0; r < n_window_rows; ++r) {
+            bboxes.insert(bboxes.end(), rowBboxes[r].begin(), rowBboxes[r].end());
+            confidences.insert(confidences.end(), rowConfidences[r].begin(), rowConfidences[r].end());
         }
     }
+}
+
+void WaldBoost::detect(Ptr<CvFeatureEvaluator> eval,
+            const Mat& img, const std::vector<float>& scales,
+            std::vector<Rect>& bboxes, Mat1f& confidences)
+{
+    std::vector<float> windowConfidences;
+    detectWindows(eval, img, scales, bboxes, windowConfidences);
+    confidences.release();
+    if (!windowConfidences.empty())
+        Mat1f(windowConfidences, true).copyTo(confidences);
+    groupRectangles(bboxes, 3, 0.7);
+}
+
+void WaldBoost::detect(Ptr<CvFeatureEvaluator> eval,
+            const Mat& img, const std::vector<float>& scales,
+            std::vector<Rect>& bboxes, std::vector<double>& confidences)
+{
+    std::vector<float> windowConfidences;
+    detectWindows(eval, img, scales, bboxes, windowConfidences);
+    confidences.assign(windowConfidences.begin(), windowConfidences.end());
     std::vector<int> levels(bboxes.size(), 0);
     groupRectangles(bboxes, levels, confidences, 3, 0.7);
 }
@@ -218,51 +377,31 @@ void WaldBoost::fit(Mat& data_pos, Mat& data_neg)
     std::cerr << "pos=" << data_pos.cols << " neg=" << data_neg.cols << std::endl;
     for (int i = 0; i < weak_count_; ++i) {
         // Train weak learner with lowest error using weights
+        const int block_size = 64;
+        std::vector<WeakLearner> best((data_pos.rows + block_size - 1) / block_size);
+        parallel_for_(Range(0, (int)best.size()),
+                      WeakLearnerSearchInvoker(data_pos, data_neg, pos_weights, neg_weights,
+                                               feature_ignore, n_bins, block_size, best));
+
         double min_err = DBL_MAX;
         int min_feature_ind = -1;
         int min_polarity = 0;
         int threshold_q = 0;
         float min_threshold = 0;
-//#pragma omp parallel for
-        for (int feat_i = 0; feat_i < data_pos.rows; ++feat_i) {
-            if (feature_ignore[feat_i])
-                continue;
-
-            // Construct cdf
-            Mat1f pos_cdf(1, n_bins), neg_cdf(1, n_bins);
-            compute_cdf(data_pos.row(feat_i), pos_weights, pos_cdf);
-            compute_cdf(data_neg.row(feat_i), neg_weights, neg_cdf);
-
-            float neg_total = (float)sum(neg_weights)[0];
-            Mat1f err_direct = pos_cdf + neg_total - neg_cdf;
-            Mat1f err_backward = 1.0f - err_direct;
-
-            int idx1[2], idx2[2];
-            double err1, err2;
-            minMaxIdx(err_direct, &err1, NULL, idx1);
-            minMaxIdx(err_backward, &err2, NULL, idx2);
-//#pragma omp critical
-            {
-            if (min(err1, err2) < min_err) {
-                if (err1 < err2) {
-                    min_err = err1;
-                    min_polarity = +1;
-                    threshold_q = idx1[1];
-                } else {
-                    min_err = err2;
-                    min_polarity = -1;
-                    threshold_q = idx2[1];
-                }
-                min_feature_ind = feat_i;
-                if (quantize) {
-                    min_threshold = data_min(feat_i, 0) + data_step(feat_i, 0) *
-                        (threshold_q + .5f);
-                } else {
-                    min_threshold = threshold_q + .5f;
-                }
-            }
+        for (size_t block = 0; block < best.size(); ++block) {
+            if (best[block].feature_ind >= 0 && best[block].err < min_err) {
+                min_err = best[block].err;
+                min_feature_ind = best[block].feature_ind;
+                min_polarity = best[block].polarity;
+                threshold_q = best[block].threshold_q;
             }
         }
+        if (quantize) {
+            min_threshold = data_min(min_feature_ind, 0) + data_step(min_feature_ind, 0) *
+                (threshold_q + .5f);
+        } else {
+            min_threshold = threshold_q + .5f;
+        }
 
 
         float alpha = .5f * (float)log((1 - min_err) / min_err);
@@ -345,6 +484,26 @@ void WaldBoost::fit(Mat& data_pos, Mat& data_neg)
     }
 }
 
+int WaldBoost::predict(const CvFeatureEvaluator& eval, const Point& p, float *h, int *stages) const
+{
+    assert(feature_indices_.size() == size_t(weak_count_));
+    assert(cascade_thresholds_.size() == size_t(weak_count_));
+    float res = 0;
+    int count = weak_count_;
+    for (int i = 0; i < count; ++i) {
+        float val = eval.calcAt(p, feature_indices_[i]);
+        int label = polarities_[i] * (val - thresholds_[i]) > 0 ? +1: -1;
+        res += alphas_[i] * label;
+        if (res < cascade_thresholds_[i] + threshold_shift_) {
+            *stages = i + 1;
+            return -1;
+        }
+    }
+    *h = res;
+    *stages = count;
+    return res > cascade_thresholds_[count - 1] + threshold_shift_ ? +1 : -1;
+}
+
 int WaldBoost::predict(Ptr<CvFeatureEvaluator> eval, float *h) const
 {
     assert(feature_indices_.size() == size_t(weak_count_));
@@ -355,12 +514,12 @@ int WaldBoost::predict(Ptr<CvFeatureEvaluator> eval, float *h) const
         float val = (*eval)(feature_indices_[i]);
         int label = polarities_[i] * (val - thresholds_[i]) > 0 ? +1: -1;
         res += alphas_[i] * label;
-        if (res < cascade_thresholds_[i]) {
+        if (res < cascade_thresholds_[i] + threshold_shift_) {
             return -1;
         }
     }
     *h = res;
-    return res > cascade_thresholds_[count - 1] ? +1 : -1;
+    return res > cascade_thresholds_[count - 1] + threshold_shift_ ? +1 : -1;
 }
 
 void WaldBoost::write(FileStorage &fs) const
@@ -439,6 +598,18 @@ void WaldBoost::reset(int weak_count)
     cascade_thresholds_.clear();
 }
 
+WaldBoostStatistics WaldBoost::get_statistics() const
+{
+    AutoLock lock(statistics_mutex_);
+    return statistics_;
+}
+
+void WaldBoost::reset_statistics()
+{
+    AutoLock lock(statistics_mutex_);
+    statistics_ = WaldBoostStatistics();
+}
+
 WaldBoost::~WaldBoost()
 {
 }
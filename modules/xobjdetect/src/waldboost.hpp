@@ -50,6 +50,16 @@ the use of this software, even if advised of the possibility of such damage.
 namespace cv {
 namespace xobjdetect {
 
+// cascade statistics of the windows evaluated by WaldBoost::detect
+struct WaldBoostStatistics {
+    WaldBoostStatistics() : windows(0), evaluations(0) {}
+    // windows rejected by each stage, the last element counts the accepted windows
+    std::vector<int64> rejections;
+    int64 windows;
+    // weak classifiers evaluated for all the windows
+    int64 evaluations;
+};
+
 class WaldBoost {
 public:
     WaldBoost(int weak_count);
@@ -70,6 +80,9 @@ public:
 
     void fit(Mat& data_pos, Mat& data_neg);
     int predict(Ptr<CvFeatureEvaluator> eval, float *h) const;
+    // predict for the window at p of the current image of eval, see CvFeatureEvaluator::calcAt,
+    // *stages is set to the number of weak classifiers evaluated
+    int predict(const CvFeatureEvaluator& eval, const Point& p, float *h, int *stages) const;
     void save(const std::string& filename);
     void load(const std::string& filename);
 
@@ -79,13 +92,32 @@ public:
     void reset(int weak_count);
     ~WaldBoost();
 
+    // value added to all the stage thresholds when predicting, not saved with the model
+    void set_threshold_shift(float shift) { threshold_shift_ = shift; }
+    float get_threshold_shift() const { return threshold_shift_; }
+
+    // statistics of the windows evaluated by detect since the last reset
+    WaldBoostStatistics get_statistics() const;
+    void reset_statistics();
+
 private:
+    // the windows of all the scales that pass the cascade, before their grouping
+    void detectWindows(Ptr<CvFeatureEvaluator> eval,
+                       const Mat& img,
+                       const std::vector<float>& scales,
+                       std::vector<Rect>& bboxes,
+                       std::vector<float>& confidences);
+
     int weak_count_;
     std::vector<float> thresholds_;
     std::vector<float> alphas_;
     std::vector<int> feature_indices_;
     std::vector<int> polarities_;
     std::vector<float> cascade_thresholds_;
+
+    float threshold_shift_;
+    WaldBoostStatistics statistics_;
+    mutable Mutex statistics_mutex_;
 };
 
 }
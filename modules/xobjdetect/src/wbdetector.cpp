@@ -89,6 +89,47 @@ static vector<Mat> read_imgs(const string& path)
     return imgs;
 }
 
+// the feature values of the samples, one column per sample
+class ComputeFeaturesInvoker : public ParallelLoopBody
+{
+public:
+    ComputeFeaturesInvoker(const CvFeatureEvaluator& _eval, const vector<Mat>& _imgs, Mat& _data)
+        : eval(_eval), imgs(_imgs), data(_data)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        for (int k = range.start; k < range.end; ++k) {
+            eval.calcAll(imgs[k], data, k);
+        }
+    }
+
+private:
+    const CvFeatureEvaluator& eval;
+    const vector<Mat>& imgs;
+    Mat& data;
+
+    ComputeFeaturesInvoker& operator=(const ComputeFeaturesInvoker&); // to quiet MSVC
+};
+
+// computes the features of the samples from the first one without features,
+// the columns of the previous samples are kept
+static void compute_features(const CvFeatureEvaluator& eval, const vector<Mat>& imgs, Mat& data)
+{
+    int first = data.cols;
+    if (first == (int)imgs.size()) {
+        return;
+    }
+    Mat grown(eval.getNumFeatures(), (int)imgs.size(), CV_8UC1);
+    if (first > 0) {
+        data.copyTo(grown.colRange(0, first));
+    }
+    data = grown;
+    parallel_for_(Range(first, (int)imgs.size()),
+                  ComputeFeaturesInvoker(eval, imgs, data));
+}
+
 void WBDetectorImpl::read(const FileNode& node)
 {
     boost_.read(node);
@@ -111,12 +152,11 @@ void WBDetectorImpl::train(
     assert(pos_imgs.size());
     assert(neg_imgs.size());
 
-    int n_features;
     Mat pos_data, neg_data;
 
+    Ptr<CvFeatureParams> params = CvFeatureParams::create();
     Ptr<CvFeatureEvaluator> eval = CvFeatureEvaluator::create();
-    eval->init(CvFeatureParams::create(), 1, Size(24, 24));
-    n_features = eval->getNumFeatures();
+    eval->init(params, 1, Size(24, 24));
 
     const int stages[] = {64, 128, 256, 512, 1024};
     const int stage_count = sizeof(stages) / sizeof(*stages);
@@ -135,22 +175,10 @@ void WBDetectorImpl::train(
 
         cerr << "compute features" << endl;
 
-        pos_data = Mat1b(n_features, (int)pos_imgs.size());
-        neg_data = Mat1b(n_features, (int)neg_imgs.size());
-
-        for (size_t k = 0; k < pos_imgs.size(); ++k) {
-            eval->setImage(pos_imgs[k], +1, 0, boost_.get_feature_indices());
-            for (int j = 0; j < n_features; ++j) {
-                pos_data.at<uchar>(j, (int)k) = (uchar)(*eval)(j);
-            }
-        }
-
-        for (size_t k = 0; k < neg_imgs.size(); ++k) {
-            eval->setImage(neg_imgs[k], 0, 0, boost_.get_feature_indices());
-            for (int j = 0; j < n_features; ++j) {
-                neg_data.at<uchar>(j, (int)k) = (uchar)(*eval)(j);
-            }
-        }
+        // the samples of the previous stages keep their features, only the
+        // bootstrapped negatives are computed
+        compute_features(*eval, pos_imgs, pos_data);
+        compute_features(*eval, neg_imgs, neg_data);
 
 
         boost_.reset(stages[i]);
@@ -198,20 +226,58 @@ void WBDetectorImpl::detect(
     vector<Rect> &bboxes,
     vector<double> &confidences)
 {
-    Mat test_img = img.clone();
     bboxes.clear();
     confidences.clear();
     vector<float> scales;
     for (float scale = 0.2f; scale < 1.2f; scale *= 1.1f) {
         scales.push_back(scale);
     }
-    Ptr<CvFeatureParams> params = CvFeatureParams::create();
-    Ptr<CvFeatureEvaluator> eval = CvFeatureEvaluator::create();
-    eval->init(params, 1, Size(24, 24));
-    boost_.detect(eval, img, scales, bboxes, confidences);
+    // the features and the integral image buffer are kept for the next frames
+    if (!eval_) {
+        eval_params_ = CvFeatureParams::create();
+        eval_ = CvFeatureEvaluator::create();
+        eval_->init(eval_params_, 1, Size(24, 24));
+    }
+    boost_.detect(eval_, img, scales, bboxes, confidences);
     assert(confidences.size() == bboxes.size());
 }
 
+void WBDetectorImpl::setThresholdShift(float shift)
+{
+    boost_.set_threshold_shift(shift);
+}
+
+float WBDetectorImpl::getThresholdShift() const
+{
+    return boost_.get_threshold_shift();
+}
+
+void WBDetectorImpl::getStatistics(
+    vector<double> &rejectionRates,
+    double &meanStages,
+    int64 &windows) const
+{
+    WaldBoostStatistics statistics = boost_.get_statistics();
+    windows = statistics.windows;
+    meanStages = windows > 0 ? (double)statistics.evaluations / windows : 0;
+
+    // the last element counts the accepted windows
+    int stage_count = std::max((int)statistics.rejections.size() - 1, 0);
+    rejectionRates.assign(stage_count, 0);
+    int64 reaching = windows;
+    for (int i = 0; i < stage_count; ++i) {
+        if (reaching > 0) {
+            rejectionRates[i] = (double)statistics.rejections[i] / reaching;
+        }
+        reaching -= statistics.rejections[i];
+    }
+}
+
+void WBDetectorImpl::resetStatistics()
+{
+    boost_.reset_statistics();
+}
+
 Ptr<WBDetector>
 WBDetector::create()
 {
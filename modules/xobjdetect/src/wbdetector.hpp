@@ -67,8 +67,19 @@ public:
         std::vector<Rect> &bboxes,
         std::vector<double> &confidences);
 
+    virtual void setThresholdShift(float shift);
+    virtual float getThresholdShift() const;
+
+    virtual void getStatistics(
+        std::vector<double> &rejectionRates,
+        double &meanStages,
+        int64 &windows) const;
+    virtual void resetStatistics();
+
 private:
     WaldBoost boost_;
+    Ptr<CvFeatureParams> eval_params_;
+    Ptr<CvFeatureEvaluator> eval_;
 };
 
 } /* namespace xobjdetect */
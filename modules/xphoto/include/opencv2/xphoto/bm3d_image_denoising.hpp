@@ -179,6 +179,49 @@ namespace cv
             int normType = cv::NORM_L2,
             int step = cv::xphoto::BM3D_STEPALL,
             int transformType = cv::xphoto::HAAR);
+
+        /** @brief Block-Matching and 3D-filtering denoiser for sequences of images of the same size, e.g.
+        bursts or video frames.
+
+        The results are the same as those of bm3dDenoising called with the same parameters, but the
+        block-matching tables and 3D group buffers of each thread are kept between the calls instead of
+        being allocated again for every image.
+
+        @sa bm3dDenoising, createBm3dDenoiser
+        */
+        class CV_EXPORTS_W Bm3dDenoiser : public Algorithm
+        {
+        public:
+            /** @brief Denoises an image, see bm3dDenoising.
+
+            @param src Input 8-bit or 16-bit 1-channel image.
+            @param dstStep1 Output image of the first step of BM3D with the same size and type as src.
+            @param dstStep2 Output image of the second step of BM3D with the same size and type as src.
+            */
+            CV_WRAP virtual void denoise(InputArray src, InputOutputArray dstStep1, OutputArray dstStep2) = 0;
+
+            /** @brief Denoises an image, see bm3dDenoising.
+
+            @param src Input 8-bit or 16-bit 1-channel image.
+            @param dst Output image with the same size and type as src.
+            */
+            CV_WRAP virtual void denoise(InputArray src, OutputArray dst) = 0;
+        };
+
+        /** @brief Creates a Bm3dDenoiser, the parameters are the ones of bm3dDenoising.
+        */
+        CV_EXPORTS_W Ptr<Bm3dDenoiser> createBm3dDenoiser(
+            float h = 1,
+            int templateWindowSize = 4,
+            int searchWindowSize = 16,
+            int blockMatchingStep1 = 2500,
+            int blockMatchingStep2 = 400,
+            int groupSize = 8,
+            int slidingStep = 1,
+            float beta = 2.0f,
+            int normType = cv::NORM_L2,
+            int step = cv::xphoto::BM3D_STEPALL,
+            int transformType = cv::xphoto::HAAR);
         //! @}
     }
 }
@@ -145,6 +145,21 @@ class CV_EXPORTS_W GrayworldWB : public WhiteBalancer
     CV_WRAP virtual float getSaturationThreshold() const = 0;
     /** @copybrief getSaturationThreshold @see getSaturationThreshold */
     CV_WRAP virtual void setSaturationThreshold(float val) = 0;
+
+    /** @brief Step between the rows used to compute the channel averages,
+        1 (default) uses all the rows
+    @see setStatisticsStep */
+    CV_WRAP virtual int getStatisticsStep() const = 0;
+    /** @copybrief getStatisticsStep @see getStatisticsStep */
+    CV_WRAP virtual void setStatisticsStep(int val) = 0;
+
+    /** @brief Weight in [0, 1) of the gains of the previous call in the gains
+        of the current one, to smooth the gains over the frames of a video.
+        0 (default) balances every image independently
+    @see setTemporalSmoothing */
+    CV_WRAP virtual float getTemporalSmoothing() const = 0;
+    /** @copybrief getTemporalSmoothing @see getTemporalSmoothing */
+    CV_WRAP virtual void setTemporalSmoothing(float val) = 0;
 };
 
 /** @brief Creates an instance of GrayworldWB
@@ -0,0 +1,68 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "perf_precomp.hpp"
+
+using namespace std;
+using namespace cv;
+using namespace perf;
+
+#ifdef OPENCV_ENABLE_NONFREE
+
+// BM3D of a noisy smooth image, by the function and by a denoiser that keeps its buffers between the calls
+
+typedef std::tr1::tuple<Size, MatDepth> BM3D_t;
+typedef perf::TestBaseWithParam<BM3D_t> bm3d;
+
+static Mat makeNoisyImage(Size size, int depth)
+{
+    RNG rng(0);
+    Mat image(size, CV_32FC1), noise(size, CV_32FC1);
+    rng.fill(image, RNG::UNIFORM, 0, 200);
+    GaussianBlur(image, image, Size(0, 0), 4);
+    rng.fill(noise, RNG::NORMAL, 0, 10);
+    image += noise;
+    Mat noisy;
+    image.convertTo(noisy, depth);
+    return noisy;
+}
+
+PERF_TEST_P(bm3d, bm3dDenoising,
+            testing::Combine(
+                testing::Values(szQVGA, szVGA),
+                testing::Values((MatDepth)CV_8U, (MatDepth)CV_16U)))
+{
+    Size size = std::tr1::get<0>(GetParam());
+    int depth = std::tr1::get<1>(GetParam());
+
+    Mat src = makeNoisyImage(size, depth), dst;
+    float h = depth == CV_8U ? 10.f : 2560.f;
+    int normType = depth == CV_8U ? NORM_L2 : NORM_L1;
+    declare.in(src).time(60);
+
+    TEST_CYCLE() xphoto::bm3dDenoising(src, dst, h, 4, 16, 2500, 400, 8, 1, 2.f, normType);
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(bm3d, Bm3dDenoiser,
+            testing::Combine(
+                testing::Values(szQVGA, szVGA),
+                testing::Values((MatDepth)CV_8U, (MatDepth)CV_16U)))
+{
+    Size size = std::tr1::get<0>(GetParam());
+    int depth = std::tr1::get<1>(GetParam());
+
+    Mat src = makeNoisyImage(size, depth), dst;
+    float h = depth == CV_8U ? 10.f : 2560.f;
+    int normType = depth == CV_8U ? NORM_L2 : NORM_L1;
+    Ptr<xphoto::Bm3dDenoiser> denoiser = xphoto::createBm3dDenoiser(h, 4, 16, 2500, 400, 8, 1, 2.f, normType);
+    declare.in(src).time(60);
+
+    TEST_CYCLE() denoiser->denoise(src, dst);
+
+    SANITY_CHECK_NOTHING();
+}
+
+#endif // OPENCV_ENABLE_NONFREE
@@ -76,8 +76,8 @@ private:
     public:
         bool operator () (const int &x, const int &y) const
         {
-            cv::Vec <Tp, cn> u = main->data[main->idx[x]];
-            cv::Vec <Tp, cn> v = main->data[main->idx[y]];
+            const cv::Vec <Tp, cn> &u = main->data[x];
+            const cv::Vec <Tp, cn> &v = main->data[y];
 
             return  u[dimIdx] < v[dimIdx];
         }
@@ -90,15 +90,19 @@ private:
     const int leafNumber; // maximum number of point per leaf
     const int zeroThresh; // radius of prohibited shifts
 
+    // The points are stored in the order of the leaves once the tree is built,
+    // so that the points of a leaf are contiguous in memory
     std::vector <cv::Vec <Tp, cn> > data;
-    std::vector <int> idx;
-    std::vector <cv::Point2i> nodes;
+    std::vector <cv::Point2i> coords; // image coordinates of data[k]
+    std::vector <int> idx; // image index of data[k]
+    std::vector <int> pos; // position in data of an image index
+    std::vector <cv::Point2i> nodes; // range of the leaf of an image index
 
     int getMaxSpreadN(const int left, const int right) const;
     void operator =(const KDTree <Tp, cn> &) const {};
 
 public:
-    void updateDist(const int leaf, const int &idx0, int &bestIdx, double &dist);
+    void updateDist(const int leaf, const int &idx0, int &bestIdx, double &dist) const;
 
     KDTree(const cv::Mat &data, const int leafNumber = 8, const int zeroThresh = 16);
     ~KDTree(){};
@@ -167,15 +171,31 @@ KDTree(const cv::Mat &img, const int _leafNumber, const int _zeroThresh)
           left.push(_left); right.push(nth + 1);
         left.push(nth + 1);  right.push(_right);
     }
+
+    /** Leaf-ordered layout **/
+
+    std::vector <cv::Vec <Tp, cn> > sorted( data.size() );
+    coords.resize( data.size() );
+    pos.resize( data.size() );
+    for (int k = 0; k < int(idx.size()); ++k)
+    {
+        sorted[k] = data[idx[k]];
+        coords[k] = cv::Point2i(idx[k]%width, idx[k]/width);
+        pos[idx[k]] = k;
+    }
+    data.swap(sorted);
 }
 
 template <typename Tp, int cn> void KDTree <Tp, cn>::
-updateDist(const int leaf, const int &idx0, int &bestIdx, double &dist)
+updateDist(const int leaf, const int &idx0, int &bestIdx, double &dist) const
 {
+    const int y = idx0/width, x = idx0%width;
+    const cv::Vec <Tp, cn> &query = data[pos[idx0]];
+
     for (int k = nodes[leaf].x; k < nodes[leaf].y; ++k)
     {
-        int y = idx0/width, ny = idx[k]/width;
-        int x = idx0%width, nx = idx[k]%width;
+        int ny = coords[k].y;
+        int nx = coords[k].x;
 
         if (abs(ny - y) < zeroThresh &&
             abs(nx - x) < zeroThresh)
@@ -184,7 +204,7 @@ updateDist(const int leaf, const int &idx0, int &bestIdx, double &dist)
             ny >= height - 1 || ny < 1 )
             continue;
 
-        double ndist = norm2(data[idx0], data[idx[k]]);
+        double ndist = norm2(query, data[k]);
 
         if (ndist < dist)
         {
@@ -196,6 +216,53 @@ updateDist(const int leaf, const int &idx0, int &bestIdx, double &dist)
 
 /************************** ANNF search **************************/
 
+static const int ANNF_TILE_SIZE = 32;
+
+// Searches the tiles (i, d - i) of the tile anti-diagonal d for i in the range
+template <typename Tp, int cn> class ANNFSearchInvoker : public cv::ParallelLoopBody
+{
+public:
+    ANNFSearchInvoker(const KDTree <Tp, cn> &_kdTree, const cv::Size _size, const int _d, std::vector <int> &_annf)
+        : kdTree(_kdTree), size(_size), d(_d), annf(_annf) {}
+
+    void operator () (const cv::Range &range) const
+    {
+        int dy[] = {0, 1, 0}, dx[] = {0, 0, 1};
+
+        for (int t = range.start; t < range.end; ++t)
+        {
+            const int y0 = t*ANNF_TILE_SIZE, x0 = (d - t)*ANNF_TILE_SIZE;
+            const int y1 = std::min(y0 + ANNF_TILE_SIZE, size.height);
+            const int x1 = std::min(x0 + ANNF_TILE_SIZE, size.width);
+
+            for (int i = y0; i < y1; ++i)
+                for (int j = x0; j < x1; ++j)
+                {
+                    double dist = std::numeric_limits <double>::max();
+                    int current = i*size.width + j;
+
+                    for (int k = 0; k < int( sizeof(dy)/sizeof(int) ); ++k)
+                        if ( i - dy[k] >= 0 && j - dx[k] >= 0 )
+                        {
+                            int neighbor = (i - dy[k])*size.width + (j - dx[k]);
+                            int leafIdx = (dx[k] == 0 && dy[k] == 0)
+                                ? neighbor : annf[neighbor] + dy[k]*size.width + dx[k];
+                            kdTree.updateDist(leafIdx, current,
+                                        annf[current], dist);
+                        }
+                }
+        }
+    }
+
+private:
+    const KDTree <Tp, cn> &kdTree;
+    const cv::Size size;
+    const int d;
+    std::vector <int> &annf;
+
+    ANNFSearchInvoker& operator=(const ANNFSearchInvoker&); // to quiet MSVC
+};
+
 static void dominantTransforms(const cv::Mat &img, std::vector <cv::Point2i> &transforms,
                                const int nTransform, const int psize)
 {
@@ -224,23 +291,16 @@ static void dominantTransforms(const cv::Mat &img, std::vector <cv::Point2i> &tr
 
     /** Propagation-assisted kd-tree search **/
 
-    for (int i = 0; i < whs.rows; ++i)
-        for (int j = 0; j < whs.cols; ++j)
-        {
-            double dist = std::numeric_limits <double>::max();
-            int current = i*whs.cols + j;
-
-            int dy[] = {0, 1, 0}, dx[] = {0, 0, 1};
-            for (int k = 0; k < int( sizeof(dy)/sizeof(int) ); ++k)
-                if ( i - dy[k] >= 0 && j - dx[k] >= 0 )
-                {
-                    int neighbor = (i - dy[k])*whs.cols + (j - dx[k]);
-                    int leafIdx = (dx[k] == 0 && dy[k] == 0)
-                        ? neighbor : annf[neighbor] + dy[k]*whs.cols + dx[k];
-                    kdTree.updateDist(leafIdx, current,
-                                annf[i*whs.cols + j], dist);
-                }
-        }
+    // A pixel only depends on its upper and left neighbors, the tiles of
+    // an anti-diagonal are independent and searched in parallel
+    const int ny = (whs.rows + ANNF_TILE_SIZE - 1)/ANNF_TILE_SIZE;
+    const int nx = (whs.cols + ANNF_TILE_SIZE - 1)/ANNF_TILE_SIZE;
+    for (int d = 0; d < ny + nx - 1; ++d)
+    {
+        int first = std::max(0, d - nx + 1), last = std::min(d, ny - 1);
+        cv::parallel_for_( cv::Range(first, last + 1),
+            ANNFSearchInvoker<float, 24>(kdTree, whs.size(), d, annf) );
+    }
 
     /** Local maxima extraction **/
 
@@ -65,7 +65,8 @@ public:
         const int &hBM,
         const int &groupSize,
         const int &slidingStep,
-        const float &beta);
+        const float &beta,
+        TLSData<Bm3dWorkspace<WT, TT> > *workspace = NULL);
 
     virtual ~Bm3dDenoisingInvokerStep2();
     void operator() (const Range& range) const;
@@ -128,6 +129,9 @@ private:
 
     // Kaiser window
     float *kaiser_;
+
+    // Per-thread buffers kept by the caller, NULL to allocate them for each stripe
+    TLSData<Bm3dWorkspace<WT, TT> > *workspace_;
 };
 
 template <typename T, typename D, typename WT, typename TT, typename TC>
@@ -141,8 +145,10 @@ Bm3dDenoisingInvokerStep2<T, D, WT, TT, TC>::Bm3dDenoisingInvokerStep2(
     const int &hBM,
     const int &groupSize,
     const int &slidingStep,
-    const float &beta) :
-    src_(src), basic_(basic), dst_(dst), groupSize_(groupSize), slidingStep_(slidingStep), thrMap_(NULL), kaiser_(NULL)
+    const float &beta,
+    TLSData<Bm3dWorkspace<WT, TT> > *workspace) :
+    src_(src), basic_(basic), dst_(dst), groupSize_(groupSize), slidingStep_(slidingStep), thrMap_(NULL), kaiser_(NULL),
+    workspace_(workspace)
 {
     groupSize_ = getLargestPowerOf2SmallerThan(groupSize);
     CV_Assert(groupSize > 0);
@@ -183,8 +189,11 @@ template <typename T, typename D, typename WT, typename TT, typename TC>
 void Bm3dDenoisingInvokerStep2<T, D, WT, TT, TC>::operator() (const Range& range) const
 {
     const int size = (range.size() + 2 * borderSize_) * srcExtended_.cols;
-    std::vector<WT> weightedSum(size, 0.0);
-    std::vector<WT> weights(size, 0.0);
+    Bm3dWorkspace<WT, TT> localWorkspace;
+    Bm3dWorkspace<WT, TT> &workspace = workspace_ ? workspace_->getRef() : localWorkspace;
+    workspace.create(size, templateWindowSize_, searchWindowSize_, src_.cols, 2);
+    std::vector<WT> &weightedSum = workspace.weightedSum;
+    std::vector<WT> &weights = workspace.weights;
     int row_from = range.start;
     int row_to = range.end - 1;
 
@@ -205,26 +214,21 @@ void Bm3dDenoisingInvokerStep2<T, D, WT, TT, TC>::operator() (const Range& range
     const int weicstep = weiStep - blockSize;
 
     // Buffer to store 3D group
-    BlockMatch<TT, int, TT> *bmBasic = new BlockMatch<TT, int, TT>[searchWindowSizeSq];
-    BlockMatch<TT, int, TT> *bmSrc = new BlockMatch<TT, int, TT>[searchWindowSizeSq];
-    for (int i = 0; i < searchWindowSizeSq; ++i)
-    {
-        bmBasic[i].init(blockSizeSq);
-        bmSrc[i].init(blockSizeSq);
-    }
+    BlockMatch<TT, int, TT> *bmBasic = &workspace.bm[0];
+    BlockMatch<TT, int, TT> *bmSrc = &workspace.bm[searchWindowSizeSq];
 
     // First element in a group is always the reference patch. Hence distance is 0.
     bmBasic[0](0, halfSearchWindowSize, halfSearchWindowSize);
     bmSrc[0](0, halfSearchWindowSize, halfSearchWindowSize);
 
     // Sums of columns and rows for current pixel
-    Array2d<int> distSums(searchWindowSize, searchWindowSize);
+    Array2d<int> distSums(&workspace.distSums[0], searchWindowSize, searchWindowSize);
 
     // Sums of columns for current pixel (for lazy calc optimization)
-    Array3d<int> colDistSums(blockSize, searchWindowSize, searchWindowSize);
+    Array3d<int> colDistSums(&workspace.colDistSums[0], blockSize, searchWindowSize, searchWindowSize);
 
     // Last elements of column sum (for each element in a row)
-    Array3d<int> lastColDistSums(src_.cols, searchWindowSize, searchWindowSize);
+    Array3d<int> lastColDistSums(&workspace.lastColDistSums[0], src_.cols, searchWindowSize, searchWindowSize);
 
     int firstColNum = -1;
     for (int j = row_from, jj = 0; j <= row_to; j += slidingStep_, jj += slidingStep_)
@@ -408,16 +412,6 @@ void Bm3dDenoisingInvokerStep2<T, D, WT, TT, TC>::operator() (const Range& range
         } // i
     } // j
 
-    // Cleanup
-    for (int i = 0; i < searchWindowSizeSq; ++i)
-    {
-        bmBasic[i].release();
-        bmSrc[i].release();
-    }
-
-    delete[] bmSrc;
-    delete[] bmBasic;
-
     // Divide accumulation buffer by the corresponding weights
     for (int i = row_from, ii = 0; i <= row_to; ++i, ++ii)
     {
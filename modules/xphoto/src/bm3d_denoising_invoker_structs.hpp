@@ -51,6 +51,10 @@ template <typename T, typename DT, typename CT>
 class BlockMatch
 {
 public:
+    BlockMatch() : data_(NULL)
+    {
+    }
+
     // Data accessor
     T* data()
     {
@@ -75,6 +79,12 @@ public:
         delete[] data_;
     }
 
+    // Use an external buffer of blockSizeSq elements for data
+    void attach(T *data)
+    {
+        data_ = data;
+    }
+
     // Overloaded operator for convenient assignment
     void operator()(const DT &_dist, const CT &_coord_x, const CT &_coord_y)
     {
@@ -360,6 +370,41 @@ struct Array3d
     }
 };
 
+// Buffers of the block-matching tables and of the 3D groups used by the invokers
+// to process a stripe of rows. A Bm3dDenoiser keeps one per thread between the calls.
+template <typename WT, typename TT>
+struct Bm3dWorkspace
+{
+    std::vector<WT> weightedSum;
+    std::vector<WT> weights;
+    std::vector<TT> blockData;
+    std::vector<BlockMatch<TT, int, TT> > bm;
+    std::vector<int> distSums;
+    std::vector<int> colDistSums;
+    std::vector<int> lastColDistSums;
+
+    // Prepares the buffers for nGroups groups of blocks, the memory is only
+    // reallocated when it grows. The accumulation buffers are reset to zero.
+    void create(int accSize, int blockSize, int searchWindowSize, int cols, int nGroups)
+    {
+        const int blockSizeSq = blockSize * blockSize;
+        const int searchWindowSizeSq = searchWindowSize * searchWindowSize;
+        const int nBlocks = nGroups * searchWindowSizeSq;
+
+        weightedSum.assign(accSize, (WT)0);
+        weights.assign(accSize, (WT)0);
+
+        blockData.resize((size_t)nBlocks * blockSizeSq);
+        bm.resize(nBlocks);
+        for (int i = 0; i < nBlocks; ++i)
+            bm[i].attach(&blockData[(size_t)i * blockSizeSq]);
+
+        distSums.resize(searchWindowSizeSq);
+        colDistSums.resize((size_t)blockSize * searchWindowSizeSq);
+        lastColDistSums.resize((size_t)cols * searchWindowSizeSq);
+    }
+};
+
 }  // namespace xphoto
 }  // namespace cv
 
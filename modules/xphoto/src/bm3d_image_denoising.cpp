@@ -57,6 +57,23 @@ namespace xphoto
 
 #ifdef OPENCV_ENABLE_NONFREE
 
+// Per-thread workspaces of a Bm3dDenoiser for each supported transform type
+struct Bm3dWorkspaces
+{
+    TLSData<Bm3dWorkspace<float, short> > workspace16s;
+    TLSData<Bm3dWorkspace<float, int> > workspace32s;
+};
+
+static inline TLSData<Bm3dWorkspace<float, short> > *getWorkspace(Bm3dWorkspaces *workspaces, short)
+{
+    return workspaces ? &workspaces->workspace16s : NULL;
+}
+
+static inline TLSData<Bm3dWorkspace<float, int> > *getWorkspace(Bm3dWorkspaces *workspaces, int)
+{
+    return workspaces ? &workspaces->workspace32s : NULL;
+}
+
 template<typename ST, typename D, typename TT>
 static void bm3dDenoising_(
     const Mat& src,
@@ -70,9 +87,11 @@ static void bm3dDenoising_(
     const int &groupSize,
     const int &slidingStep,
     const float &beta,
-    const int &step)
+    const int &step,
+    Bm3dWorkspaces *workspaces)
 {
     double granularity = (double)std::max(1., (double)src.total() / (1 << 16));
+    TLSData<Bm3dWorkspace<float, TT> > *workspace = getWorkspace(workspaces, TT());
 
     switch (CV_MAT_CN(src.type())) {
     case 1:
@@ -88,7 +107,8 @@ static void bm3dDenoising_(
                     hBMStep1,
                     groupSize,
                     slidingStep,
-                    beta),
+                    beta,
+                    workspace),
                 granularity);
         }
         if (step == BM3D_STEP2 || step == BM3D_STEPALL)
@@ -104,7 +124,8 @@ static void bm3dDenoising_(
                     hBMStep2,
                     groupSize,
                     slidingStep,
-                    beta),
+                    beta,
+                    workspace),
                 granularity);
         }
         break;
@@ -114,7 +135,7 @@ static void bm3dDenoising_(
     }
 }
 
-void bm3dDenoising(
+static void bm3dDenoisingImpl(
     InputArray _src,
     InputOutputArray _basic,
     OutputArray _dst,
@@ -128,7 +149,8 @@ void bm3dDenoising(
     float beta,
     int normType,
     int step,
-    int transformType)
+    int transformType,
+    Bm3dWorkspaces *workspaces)
 {
     int type = _src.type(), depth = CV_MAT_DEPTH(type), cn = CV_MAT_CN(type);
     CV_Assert(1 == cn);
@@ -174,7 +196,8 @@ void bm3dDenoising(
                 groupSize,
                 slidingStep,
                 beta,
-                step);
+                step,
+                workspaces);
             break;
         default:
             CV_Error(Error::StsBadArg,
@@ -196,7 +219,8 @@ void bm3dDenoising(
                 groupSize,
                 slidingStep,
                 beta,
-                step);
+                step,
+                workspaces);
             break;
         case CV_16U:
             bm3dDenoising_<ushort, DistAbs, int>(
@@ -211,7 +235,8 @@ void bm3dDenoising(
                 groupSize,
                 slidingStep,
                 beta,
-                step);
+                step,
+                workspaces);
             break;
         default:
             CV_Error(Error::StsBadArg,
@@ -224,6 +249,40 @@ void bm3dDenoising(
     }
 }
 
+void bm3dDenoising(
+    InputArray _src,
+    InputOutputArray _basic,
+    OutputArray _dst,
+    float h,
+    int templateWindowSize,
+    int searchWindowSize,
+    int blockMatchingStep1,
+    int blockMatchingStep2,
+    int groupSize,
+    int slidingStep,
+    float beta,
+    int normType,
+    int step,
+    int transformType)
+{
+    bm3dDenoisingImpl(
+        _src,
+        _basic,
+        _dst,
+        h,
+        templateWindowSize,
+        searchWindowSize,
+        blockMatchingStep1,
+        blockMatchingStep2,
+        groupSize,
+        slidingStep,
+        beta,
+        normType,
+        step,
+        transformType,
+        NULL);
+}
+
 void bm3dDenoising(
     InputArray _src,
     OutputArray _dst,
@@ -265,6 +324,109 @@ void bm3dDenoising(
         _dst.assign(basic);
 }
 
+class Bm3dDenoiserImpl : public Bm3dDenoiser
+{
+public:
+    Bm3dDenoiserImpl(
+        float h,
+        int templateWindowSize,
+        int searchWindowSize,
+        int blockMatchingStep1,
+        int blockMatchingStep2,
+        int groupSize,
+        int slidingStep,
+        float beta,
+        int normType,
+        int step,
+        int transformType) :
+        h_(h), templateWindowSize_(templateWindowSize), searchWindowSize_(searchWindowSize),
+        blockMatchingStep1_(blockMatchingStep1), blockMatchingStep2_(blockMatchingStep2),
+        groupSize_(groupSize), slidingStep_(slidingStep), beta_(beta), normType_(normType),
+        step_(step), transformType_(transformType)
+    {
+        CV_Assert(HAAR == transformType);
+        CV_Assert(searchWindowSize > templateWindowSize);
+        CV_Assert(slidingStep > 0 && slidingStep < templateWindowSize);
+    }
+
+    void denoise(InputArray src, InputOutputArray dstStep1, OutputArray dstStep2)
+    {
+        bm3dDenoisingImpl(
+            src,
+            dstStep1,
+            dstStep2,
+            h_,
+            templateWindowSize_,
+            searchWindowSize_,
+            blockMatchingStep1_,
+            blockMatchingStep2_,
+            groupSize_,
+            slidingStep_,
+            beta_,
+            normType_,
+            step_,
+            transformType_,
+            &workspaces_);
+    }
+
+    void denoise(InputArray src, OutputArray dst)
+    {
+        if (step_ == BM3D_STEP2)
+            CV_Error(Error::StsBadArg,
+                "Unsupported step type! To use BM3D_STEP2 one need to provide basic image.");
+
+        // The basic estimate is kept between the calls as well
+        basic_.create(src.size(), src.type());
+        denoise(src, basic_, dst);
+
+        if (step_ == BM3D_STEP1)
+            basic_.copyTo(dst);
+    }
+
+private:
+    float h_;
+    int templateWindowSize_;
+    int searchWindowSize_;
+    int blockMatchingStep1_;
+    int blockMatchingStep2_;
+    int groupSize_;
+    int slidingStep_;
+    float beta_;
+    int normType_;
+    int step_;
+    int transformType_;
+
+    Mat basic_;
+    Bm3dWorkspaces workspaces_;
+};
+
+Ptr<Bm3dDenoiser> createBm3dDenoiser(
+    float h,
+    int templateWindowSize,
+    int searchWindowSize,
+    int blockMatchingStep1,
+    int blockMatchingStep2,
+    int groupSize,
+    int slidingStep,
+    float beta,
+    int normType,
+    int step,
+    int transformType)
+{
+    return Ptr<Bm3dDenoiser>(new Bm3dDenoiserImpl(
+        h,
+        templateWindowSize,
+        searchWindowSize,
+        blockMatchingStep1,
+        blockMatchingStep2,
+        groupSize,
+        slidingStep,
+        beta,
+        normType,
+        step,
+        transformType));
+}
+
 #else
 
 void bm3dDenoising(
@@ -341,6 +503,39 @@ void bm3dDenoising(
         "Set OPENCV_ENABLE_NONFREE CMake option and rebuild the library");
 }
 
+Ptr<Bm3dDenoiser> createBm3dDenoiser(
+    float h,
+    int templateWindowSize,
+    int searchWindowSize,
+    int blockMatchingStep1,
+    int blockMatchingStep2,
+    int groupSize,
+    int slidingStep,
+    float beta,
+    int normType,
+    int step,
+    int transformType)
+{
+    // Empty implementation
+
+    CV_UNUSED(h);
+    CV_UNUSED(templateWindowSize);
+    CV_UNUSED(searchWindowSize);
+    CV_UNUSED(blockMatchingStep1);
+    CV_UNUSED(blockMatchingStep2);
+    CV_UNUSED(groupSize);
+    CV_UNUSED(slidingStep);
+    CV_UNUSED(beta);
+    CV_UNUSED(normType);
+    CV_UNUSED(step);
+    CV_UNUSED(transformType);
+
+    CV_Error(Error::StsNotImplemented,
+        "This algorithm is patented and is excluded in this configuration;"
+        "Set OPENCV_ENABLE_NONFREE CMake option and rebuild the library");
+    return Ptr<Bm3dDenoiser>();
+}
+
 #endif
 
 }  // namespace xphoto
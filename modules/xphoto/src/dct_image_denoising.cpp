@@ -48,6 +48,7 @@
 
 #include "opencv2/core.hpp"
 #include "opencv2/core/core_c.h"
+#include "opencv2/core/hal/intrin.hpp"
 
 #include "opencv2/core/types.hpp"
 #include "opencv2/core/types_c.h"
@@ -62,46 +63,147 @@ namespace xphoto
     void dctDenoising(const Mat &, Mat &, const double, const int);
 
 
+    // Number of patch rows processed by a stripe, fixed to keep the sums independent of the number of threads
+    static const int DCT_DENOISING_STRIPE_SIZE = 32;
+
+    // dst = a * M, or dst += a * M, for a row vector a and a n x n matrix M.
+    // Zeros of a are skipped, most of the coefficients being zero after thresholding.
+    static inline void vecMat(const float *a, const float *M, float *dst, const int n, const bool add)
+    {
+        int u = 0;
+#if CV_SIMD128
+        for (; u <= n - 8; u += 8)
+        {
+            v_float32x4 s0 = add ? v_load(dst + u) : v_setzero_f32();
+            v_float32x4 s1 = add ? v_load(dst + u + 4) : v_setzero_f32();
+            for (int j = 0; j < n; ++j)
+            {
+                if (a[j] == 0.0f)
+                    continue;
+                v_float32x4 aj = v_setall_f32(a[j]);
+                s0 = v_muladd(aj, v_load(M + j*n + u), s0);
+                s1 = v_muladd(aj, v_load(M + j*n + u + 4), s1);
+            }
+            v_store(dst + u, s0);
+            v_store(dst + u + 4, s1);
+        }
+        for (; u <= n - 4; u += 4)
+        {
+            v_float32x4 s0 = add ? v_load(dst + u) : v_setzero_f32();
+            for (int j = 0; j < n; ++j)
+                if (a[j] != 0.0f)
+                    s0 = v_muladd(v_setall_f32(a[j]), v_load(M + j*n + u), s0);
+            v_store(dst + u, s0);
+        }
+#endif
+        for (; u < n; ++u)
+        {
+            float sum = add ? dst[u] : 0.0f;
+            for (int j = 0; j < n; ++j)
+                sum += a[j] * M[j*n + u];
+            dst[u] = sum;
+        }
+    }
+
+    // dst[0..n) += a * src[0..n)
+    static inline void mulAdd(const float *src, const float a, float *dst, const int n)
+    {
+        int i = 0;
+#if CV_SIMD128
+        v_float32x4 va = v_setall_f32(a);
+        for (; i <= n - 4; i += 4)
+            v_store(dst + i, v_muladd(va, v_load(src + i), v_load(dst + i)));
+#endif
+        for (; i < n; ++i)
+            dst[i] += a * src[i];
+    }
+
     struct grayDctDenoisingInvoker : public ParallelLoopBody
     {
     public:
-        grayDctDenoisingInvoker(const Mat &src, std::vector <Mat> &patches, const double sigma, const int psize);
+        grayDctDenoisingInvoker(const Mat &src, std::vector <Mat> &stripes, const double sigma, const int psize);
         ~grayDctDenoisingInvoker(){};
 
         void operator() (const Range &range) const;
 
     protected:
         const Mat &src;
-        std::vector <Mat> &patches; // image decomposition into sliding patches
+        std::vector <Mat> &stripes; // sums of the denoised patches of each stripe of patch rows
 
         const int psize; // size of block to compute dct
         const double sigma; // expected noise standard deviation
         const double thresh; // thresholding estimate
 
+        std::vector <float> dctMat; // orthonormal DCT-II matrix, the one of cv::dct
+        std::vector <float> dctMatT; // its transposition
+
         void operator =(const grayDctDenoisingInvoker&) const {};
     };
 
-    grayDctDenoisingInvoker::grayDctDenoisingInvoker(const Mat &_src, std::vector <Mat> &_patches,
+    grayDctDenoisingInvoker::grayDctDenoisingInvoker(const Mat &_src, std::vector <Mat> &_stripes,
                                                      const double _sigma, const int _psize)
-        : src(_src), patches(_patches), psize(_psize), sigma(_sigma), thresh(3*_sigma) {}
-
-    void grayDctDenoisingInvoker::operator() (const Range &range) const
+        : src(_src), stripes(_stripes), psize(_psize), sigma(_sigma), thresh(3*_sigma),
+          dctMat(_psize*_psize), dctMatT(_psize*_psize)
     {
-        for (int i = range.start; i <= range.end - 1; ++i)
+        for (int u = 0; u < psize; ++u)
         {
-            int y = i / (src.cols - psize);
-            int x = i % (src.cols - psize);
+            double a = u == 0 ? std::sqrt(1.0/psize) : std::sqrt(2.0/psize);
+            for (int j = 0; j < psize; ++j)
+            {
+                float c = (float)(a*std::cos(CV_PI*(2*j + 1)*u/(2*psize)));
+                dctMat[u*psize + j] = c;
+                dctMatT[j*psize + u] = c;
+            }
+        }
+    }
 
-            Rect patchNum( x, y, psize, psize );
+    // The 2D DCT of a patch is C * X * C^T. The vertical part C * X is computed once per patch row for all
+    // the columns of the image and shared by the overlapping patches of the row, then each patch gets its
+    // horizontal DCT, thresholding and inverse DCT C^T * D * C added to the sums of its stripe.
+    void grayDctDenoisingInvoker::operator() (const Range &range) const
+    {
+        const int cols = src.cols;
+        const int nrows = src.rows - psize, ncols = src.cols - psize; // patch positions
+        const float *C = &dctMat[0], *CT = &dctMatT[0];
+        const float thr = (float)thresh;
 
-            Mat patch(psize, psize, CV_32FC1);
-            src(patchNum).copyTo( patch );
+        std::vector <float> colDct(psize*cols), coeffs(psize*psize), tmp(psize*psize);
 
-            dct(patch, patch);
-            float *data = (float *) patch.data;
-            for (int k = 0; k < psize*psize; ++k)
-                data[k] *= fabs(data[k]) > thresh;
-            idct(patch, patches[i]);
+        for (int s = range.start; s < range.end; ++s)
+        {
+            const int y0 = s*DCT_DENOISING_STRIPE_SIZE;
+            const int y1 = std::min(y0 + DCT_DENOISING_STRIPE_SIZE, nrows);
+
+            Mat &acc = stripes[s];
+            acc.create(y1 - y0 + psize - 1, cols, CV_32FC1);
+            acc.setTo(0.0f);
+
+            for (int y = y0; y < y1; ++y)
+            {
+                // vertical DCT of the rows [y, y + psize) of every column
+                std::fill(colDct.begin(), colDct.end(), 0.0f);
+                for (int k = 0; k < psize; ++k)
+                    for (int i = 0; i < psize; ++i)
+                        mulAdd(src.ptr<float>(y + i), C[k*psize + i], &colDct[k*cols], cols);
+
+                for (int x = 0; x < ncols; ++x)
+                {
+                    // horizontal DCT and hard thresholding
+                    for (int k = 0; k < psize; ++k)
+                    {
+                        float *d = &coeffs[k*psize];
+                        vecMat(&colDct[k*cols + x], CT, d, psize, false);
+                        for (int u = 0; u < psize; ++u)
+                            d[u] *= fabs(d[u]) > thr;
+                    }
+
+                    // inverse horizontal and vertical DCT, accumulated in the stripe
+                    for (int k = 0; k < psize; ++k)
+                        vecMat(&coeffs[k*psize], C, &tmp[k*psize], psize, false);
+                    for (int i = 0; i < psize; ++i)
+                        vecMat(&CT[i*psize], &tmp[0], acc.ptr<float>(y - y0 + i) + x, psize, true);
+                }
+            }
         }
     }
 
@@ -109,24 +211,33 @@ namespace xphoto
     {
         CV_Assert( src.type() == CV_MAKE_TYPE(CV_32F, 1) );
 
-        int npixels = (src.rows - psize)*(src.cols - psize);
+        int nrows = src.rows - psize, ncols = src.cols - psize;
+        CV_Assert( nrows > 0 && ncols > 0 );
 
-        std::vector <Mat> patches;
-        for (int i = 0; i < npixels; ++i)
-            patches.push_back( Mat(psize, psize, CV_32FC1) );
-        parallel_for_( cv::Range(0, npixels),
-            grayDctDenoisingInvoker(src, patches, sigma, psize) );
+        int nstripes = (nrows + DCT_DENOISING_STRIPE_SIZE - 1) / DCT_DENOISING_STRIPE_SIZE;
+        std::vector <Mat> stripes(nstripes);
+        parallel_for_( cv::Range(0, nstripes),
+            grayDctDenoisingInvoker(src, stripes, sigma, psize) );
 
         Mat res( src.size(), CV_32FC1, 0.0f ),
-            num( src.size(), CV_32FC1, 0.0f );
+            num( src.size(), CV_32FC1 );
 
-        for (int k = 0; k < npixels; ++k)
+        for (int s = 0; s < nstripes; ++s)
         {
-            int i = k / (src.cols - psize);
-            int j = k % (src.cols - psize);
+            Mat resStripe = res.rowRange(s*DCT_DENOISING_STRIPE_SIZE, s*DCT_DENOISING_STRIPE_SIZE + stripes[s].rows);
+            resStripe += stripes[s];
+        }
 
-            res( Rect(j, i, psize, psize) ) += patches[k];
-            num( Rect(j, i, psize, psize) ) += Mat::ones(psize, psize, CV_32FC1);
+        // number of patches covering each pixel
+        std::vector <float> numCols(src.cols);
+        for (int j = 0; j < src.cols; ++j)
+            numCols[j] = (float)std::max(0, std::min(j, ncols - 1) - std::max(0, j - psize + 1) + 1);
+        for (int i = 0; i < src.rows; ++i)
+        {
+            float numRow = (float)std::max(0, std::min(i, nrows - 1) - std::max(0, i - psize + 1) + 1);
+            float *n = num.ptr<float>(i);
+            for (int j = 0; j < src.cols; ++j)
+                n[j] = numRow*numCols[j];
         }
         res /= num;
 
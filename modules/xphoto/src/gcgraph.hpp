@@ -77,6 +77,7 @@ private:
 
     ::std::vector<Vtx> vtcs;
     ::std::vector<Edge> edges;
+    ::std::vector<Vtx*> orphans;
     TWeight flow;
 };
 
@@ -97,6 +98,9 @@ GCGraph<TWeight>::~GCGraph()
 template <class TWeight>
 void GCGraph<TWeight>::create( unsigned int vtxCount, unsigned int edgeCount )
 {
+    // the graph is emptied but keeps its memory, so that it can be reused
+    vtcs.clear();
+    edges.clear();
     vtcs.reserve( vtxCount );
     edges.reserve( edgeCount + 2 );
     flow = 0;
@@ -160,7 +164,7 @@ TWeight GCGraph<TWeight>::maxFlow()
     Vtx *vtxPtr = &vtcs[0];
     Edge *edgePtr = &edges[0];
 
-    ::std::vector<Vtx*> orphans;
+    orphans.clear();
 
     // initialize the active queue and the graph vertices
     for( int i = 0; i < (int)vtcs.size(); i++ )
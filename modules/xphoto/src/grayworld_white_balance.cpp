@@ -53,11 +53,39 @@ class GrayworldWBImpl : public GrayworldWB
 {
   private:
     float thresh;
+    int statisticsStep;
+    float temporalSmoothing;
+
+    // gains of the previous call, normalized by their maximum
+    bool hasPrevGains;
+    int prevType;
+    float prevGainB, prevGainG, prevGainR;
 
   public:
-    GrayworldWBImpl() { thresh = 0.9f; }
+    GrayworldWBImpl()
+    {
+        thresh = 0.9f;
+        statisticsStep = 1;
+        temporalSmoothing = 0.f;
+        hasPrevGains = false;
+        prevType = -1;
+        prevGainB = prevGainG = prevGainR = 0.f;
+    }
     float getSaturationThreshold() const { return thresh; }
     void setSaturationThreshold(float val) { thresh = val; }
+    int getStatisticsStep() const { return statisticsStep; }
+    void setStatisticsStep(int val)
+    {
+        CV_Assert(val >= 1);
+        statisticsStep = val;
+    }
+    float getTemporalSmoothing() const { return temporalSmoothing; }
+    void setTemporalSmoothing(float val)
+    {
+        CV_Assert(val >= 0.f && val < 1.f);
+        temporalSmoothing = val;
+        hasPrevGains = false;
+    }
     void balanceWhite(InputArray _src, OutputArray _dst)
     {
         CV_Assert(!_src.empty());
@@ -71,7 +99,20 @@ class GrayworldWBImpl : public GrayworldWB
         if (src.type() == CV_8UC3)
         {
             uint sumB = 0, sumG = 0, sumR = 0;
-            calculateChannelSums(sumB, sumG, sumR, src.ptr<uchar>(), N3, thresh);
+            if (statisticsStep == 1)
+                calculateChannelSums(sumB, sumG, sumR, src.ptr<uchar>(), N3, thresh);
+            else
+            {
+                // only every statisticsStep-th row is read
+                for (int y = 0; y < src.rows; y += statisticsStep)
+                {
+                    uint rowB, rowG, rowR;
+                    calculateChannelSums(rowB, rowG, rowR, src.ptr<uchar>(y), 3 * src.cols, thresh);
+                    sumB += rowB;
+                    sumG += rowG;
+                    sumR += rowR;
+                }
+            }
             dsumB = (double)sumB;
             dsumG = (double)sumG;
             dsumR = (double)sumR;
@@ -79,7 +120,19 @@ class GrayworldWBImpl : public GrayworldWB
         else if (src.type() == CV_16UC3)
         {
             uint64 sumB = 0, sumG = 0, sumR = 0;
-            calculateChannelSums(sumB, sumG, sumR, src.ptr<ushort>(), N3, thresh);
+            if (statisticsStep == 1)
+                calculateChannelSums(sumB, sumG, sumR, src.ptr<ushort>(), N3, thresh);
+            else
+            {
+                for (int y = 0; y < src.rows; y += statisticsStep)
+                {
+                    uint64 rowB, rowG, rowR;
+                    calculateChannelSums(rowB, rowG, rowR, src.ptr<ushort>(y), 3 * src.cols, thresh);
+                    sumB += rowB;
+                    sumG += rowG;
+                    sumR += rowR;
+                }
+            }
             dsumB = (double)sumB;
             dsumG = (double)sumG;
             dsumR = (double)sumR;
@@ -92,6 +145,29 @@ class GrayworldWBImpl : public GrayworldWB
               dinvG = dsumG < eps ? 0.f : (float)(max_sum / dsumG),
               dinvR = dsumR < eps ? 0.f : (float)(max_sum / dsumR);
 
+        if (temporalSmoothing > 0.f)
+        {
+            // Blend with the gains of the previous frame, the gains being only defined up to a scale
+            float dinv_max = max(dinvB, max(dinvG, dinvR));
+            if (dinv_max > 0)
+            {
+                dinvB /= dinv_max;
+                dinvG /= dinv_max;
+                dinvR /= dinv_max;
+            }
+            if (hasPrevGains && prevType == src.type())
+            {
+                dinvB = temporalSmoothing * prevGainB + (1.f - temporalSmoothing) * dinvB;
+                dinvG = temporalSmoothing * prevGainG + (1.f - temporalSmoothing) * dinvG;
+                dinvR = temporalSmoothing * prevGainR + (1.f - temporalSmoothing) * dinvR;
+            }
+            hasPrevGains = true;
+            prevType = src.type();
+            prevGainB = dinvB;
+            prevGainG = dinvG;
+            prevGainR = dinvR;
+        }
+
         // Use the inverse of averages as channel gains:
         applyChannelGains(src, _dst, dinvB, dinvG, dinvR);
     }
@@ -83,11 +83,14 @@ private:
 
     const std::vector <std::vector <int> > &linkIdx;   // vector of neighbors for pointSeq
 
-    std::vector <std::vector <labelTp> > labelings;    // vector of labelings
+    std::vector <std::vector <labelTp> > labelings;    // labelings[alpha] is the result of the expansion of alpha
     std::vector <TWeight>  distances;                  // vector of max-flow costs for different labeling
 
     std::vector <labelTp> &labelSeq;                   // current best labeling
 
+    int vtxCount, edgeCount;                           // upper bounds of the graph sizes
+    cv::TLSData <GCGraph <TWeight> > graphs;           // graph of each thread, reused by the expansions
+
     TWeight singleExpansion(const int alpha);          // single neighbor computing
 
     class ParallelExpansion : public cv::ParallelLoopBody
@@ -163,7 +166,8 @@ setWeights(GCGraph <TWeight> &graph, const int idx1, const int idx2,
 template <typename Tp> TWeight Photomontage <Tp>::
 singleExpansion(const int alpha)
 {
-    GCGraph <TWeight> graph( 3*int(pointSeq.size()), 4*int(pointSeq.size()) );
+    GCGraph <TWeight> &graph = graphs.getRef();
+    graph.create( vtxCount, edgeCount );
 
     /** Terminal links **/
     for (size_t i = 0; i < maskSeq.size(); ++i)
@@ -182,7 +186,7 @@ singleExpansion(const int alpha)
 
     /** Writing results **/
     for (size_t i = 0; i < pointSeq.size(); ++i)
-        labelings[i][alpha] = graph.inSourceSegment(int(i)) ? labelSeq[i] : alpha;
+        labelings[alpha][i] = graph.inSourceSegment(int(i)) ? labelSeq[i] : alpha;
 
     return result;
 }
@@ -206,8 +210,7 @@ gradientDescent()
         if (num == -1)
             break;
 
-        for (size_t i = 0; i < labelSeq.size(); ++i)
-            labelSeq[i] = labelings[i][num];
+        labelSeq = labelings[num];
     }
 }
 
@@ -221,8 +224,16 @@ Photomontage( const std::vector <std::vector <Tp> > &_pointSeq,
     distances(pointSeq[0].size()), labelSeq(_labelSeq), parallelExpansion(this)
 {
     size_t lsize = pointSeq[0].size();
-    labelings.assign( pointSeq.size(),
-      std::vector <labelTp>( lsize ) );
+    labelings.assign( lsize,
+      std::vector <labelTp>( pointSeq.size() ) );
+
+    // every link adds at most one vertex and two pairs of edges
+    int nLinks = 0;
+    for (size_t i = 0; i < linkIdx.size(); ++i)
+        for (size_t j = 0; j < linkIdx[i].size(); ++j)
+            nLinks += linkIdx[i][j] != -1;
+    vtxCount = int(pointSeq.size()) + nLinks;
+    edgeCount = 4*nLinks;
 }
 
 }
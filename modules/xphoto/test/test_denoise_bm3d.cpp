@@ -158,6 +158,35 @@ namespace cvtest
         ASSERT_LT(cvtest::norm(result, expected, cv::NORM_L2), 200);
     }
 
+    TEST(xphoto_DenoisingBm3dGrayscale, denoiser_sequence)
+    {
+        std::string folder = std::string(cvtest::TS::ptr()->get_data_path()) + "cv/xphoto/bm3d_image_denoising/";
+        std::string original_path = folder + "lena_noised_gaussian_sigma=10.png";
+
+        cv::Mat original = cv::imread(original_path, cv::IMREAD_GRAYSCALE);
+        ASSERT_FALSE(original.empty()) << "Could not load input image " << original_path;
+
+        // The workspaces kept between the frames don't change the results
+        cv::Ptr<cv::xphoto::Bm3dDenoiser> denoiser = cv::xphoto::createBm3dDenoiser(10, 4, 16, 2500, 400, 8, 1, 0.0f, cv::NORM_L2, cv::xphoto::BM3D_STEPALL);
+        for (int i = 0; i < 3; ++i)
+        {
+            cv::Mat frame = original(cv::Rect(i * 16, i * 8, original.cols / 2, original.rows / 2)).clone();
+            cv::Mat expected, result;
+            cv::xphoto::bm3dDenoising(frame, expected, 10, 4, 16, 2500, 400, 8, 1, 0.0f, cv::NORM_L2, cv::xphoto::BM3D_STEPALL);
+            denoiser->denoise(frame, result);
+            ASSERT_EQ(cvtest::norm(result, expected, cv::NORM_INF), 0);
+        }
+
+        cv::Ptr<cv::xphoto::Bm3dDenoiser> denoiserL1 = cv::xphoto::createBm3dDenoiser(10, 4, 16, 2500, -1, 8, 1, 0.0f, cv::NORM_L1, cv::xphoto::BM3D_STEP1);
+        for (int i = 0; i < 2; ++i)
+        {
+            cv::Mat expected, result;
+            cv::xphoto::bm3dDenoising(original, expected, 10, 4, 16, 2500, -1, 8, 1, 0.0f, cv::NORM_L1, cv::xphoto::BM3D_STEP1);
+            denoiserL1->denoise(original, result);
+            ASSERT_EQ(cvtest::norm(result, expected, cv::NORM_INF), 0);
+        }
+    }
+
 #ifdef TEST_TRANSFORMS
 
     TEST(xphoto_DenoisingBm3dKaiserWindow, regression_4)
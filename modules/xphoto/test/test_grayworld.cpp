@@ -94,4 +94,34 @@ namespace cvtest {
         }
     }
 
+    TEST(xphoto_grayworld_white_balance, video_mode)
+    {
+        Mat src(240, 320, CV_8UC3);
+        RNG rng(0);
+        rng.fill(src, RNG::UNIFORM, Scalar(40, 80, 120), Scalar(80, 120, 160));
+
+        Ptr<xphoto::GrayworldWB> wb = xphoto::createGrayworldWB();
+        Mat reference, result;
+        wb->balanceWhite(src, reference);
+
+        // the averages of a uniform noise barely change when half of the rows are used
+        wb->setStatisticsStep(2);
+        wb->balanceWhite(src, result);
+        EXPECT_LE(cv::norm(result, reference, NORM_INF), 2);
+
+        // a smoothed sequence converges to the gains of a static scene
+        Mat other = src * 0.5 + Scalar(60, 0, 0);
+        wb->setStatisticsStep(1);
+        wb->setTemporalSmoothing(0.5f);
+        wb->balanceWhite(other, result);
+        for (int i = 0; i < 20; ++i)
+            wb->balanceWhite(src, result);
+        EXPECT_LE(cv::norm(result, reference, NORM_INF), 1);
+
+        // the first frame isn't smoothed
+        wb->setTemporalSmoothing(0.9f);
+        wb->balanceWhite(src, result);
+        EXPECT_LE(cv::norm(result, reference, NORM_INF), 1);
+    }
+
 }